@@ -0,0 +1,897 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Benchmark of the scan path using TPC-H queries.
+//
+// This tool loads the TPC-H lineitem table and its orders and part dimension
+// tables, generated at the configured scale factor, through the columnar
+// write API. It then runs a set of queries through columnar parallel scans,
+// pushing down all the predicates Kudu can evaluate, and reports the time,
+// the rows and the bytes returned by the scans of each query.
+//
+// The queries are:
+//  - Q1, the pricing summary report: a scan of almost all of lineitem,
+//    aggregated by return flag and line status.
+//  - Q6, the forecasting revenue change: a selective scan of lineitem on
+//    ranges of three columns.
+//  - Q12, the shipping modes and order priority: an IN list and a range on
+//    lineitem, joined with orders.
+//  - Q14, the promotion effect: a range on lineitem joined with part.
+//
+// The aggregations and joins are evaluated by this tool on the columnar
+// batches, as is any predicate comparing two columns.
+//
+// The data follows the distributions of TPC-H's dbgen closely enough for the
+// selectivity of the queries to be representative, but isn't byte-for-byte
+// what dbgen generates: the order keys are dense and the text columns are
+// drawn from smaller vocabularies.
+//
+// Usage:
+//   tpch_scans -tpch_scale_factor=1 -tpch_num_query_iterations=3
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/benchmarks/tpch/tpch-schemas.h"
+#include "kudu/client/client.h"
+#include "kudu/client/columnar_scan_batch.h"
+#include "kudu/client/schema.h"
+#include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/value.h"
+#include "kudu/client/write_op.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/master/mini_master.h"
+#include "kudu/mini-cluster/internal_mini_cluster.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flags.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/random.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+DEFINE_bool(tpch_use_mini_cluster, true,
+            "Create a mini cluster for the work to be performed against");
+DEFINE_string(tpch_mini_cluster_base_dir, "/tmp/tpch_scans",
+              "If using a mini cluster, directory for master/ts data");
+DEFINE_int32(tpch_num_tablet_servers, 1,
+             "If using a mini cluster, the number of tablet servers to start");
+DEFINE_string(tpch_master_addresses, "localhost",
+              "Addresses of masters for the cluster to operate on if not using a mini cluster");
+DEFINE_string(tpch_table_prefix, "tpch_",
+              "Prefix of the names of the lineitem, orders and part tables");
+DEFINE_double(tpch_scale_factor, 0.1,
+              "TPC-H scale factor of the generated data. A scale factor of 1 has 1.5 million "
+              "orders with 6 million line items on average, and 200 thousand parts");
+DEFINE_int32(tpch_num_tablets, 4,
+             "Number of hash partitions of each table when creating the tables");
+DEFINE_bool(tpch_load_data, true,
+            "Generate and load the data, unless the tables already exist");
+DEFINE_int32(tpch_load_batch_rows, 10000,
+             "Number of rows of each columnar batch written while loading");
+DEFINE_string(tpch_queries, "1,6,12,14",
+              "Comma-separated list of the TPC-H queries to run. Supported queries are "
+              "1, 6, 12 and 14");
+DEFINE_int32(tpch_num_query_iterations, 1,
+             "Number of times each query is run");
+DEFINE_int32(tpch_scan_concurrency, 4,
+             "Number of tablets scanned at the same time by each scan");
+DEFINE_int32(tpch_scan_batch_size_bytes, 0,
+             "Batch size of the scans in bytes. The default of the client is used if 0");
+DEFINE_int32(tpch_timeout_ms, 60000,
+             "Timeout that will be used for all operations and RPCs");
+
+using kudu::client::KuduClient;
+using kudu::client::KuduClientBuilder;
+using kudu::client::KuduColumnSchema;
+using kudu::client::KuduColumnarScanBatch;
+using kudu::client::KuduColumnarWriteBatch;
+using kudu::client::KuduParallelScanner;
+using kudu::client::KuduPredicate;
+using kudu::client::KuduScanTokenBuilder;
+using kudu::client::KuduSchema;
+using kudu::client::KuduSession;
+using kudu::client::KuduTable;
+using kudu::client::KuduTableCreator;
+using kudu::client::KuduValue;
+using kudu::client::KuduWriteOperation;
+using kudu::client::sp::shared_ptr;
+using kudu::cluster::InternalMiniCluster;
+using kudu::cluster::InternalMiniClusterOptions;
+using std::cout;
+using std::endl;
+using std::map;
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tpch {
+
+namespace {
+
+// The dates of the data set, from 1992-01-01 to 1998-12-31, in the
+// 'YYYY-MM-DD' format of the date columns. Being in this format, the dates
+// sort like their strings.
+const vector<string>& Dates() {
+  static const vector<string>* dates = [] {
+    auto* d = new vector<string>();
+    for (int y = 1992; y <= 1998; y++) {
+      for (int m = 1; m <= 12; m++) {
+        static const int kDaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int days = kDaysInMonth[m - 1] + (m == 2 && y % 4 == 0 ? 1 : 0);
+        for (int day = 1; day <= days; day++) {
+          d->emplace_back(StringPrintf("%04d-%02d-%02d", y, m, day));
+        }
+      }
+    }
+    return d;
+  }();
+  return *dates;
+}
+
+int DateIndex(const string& date) {
+  const auto& dates = Dates();
+  auto it = std::lower_bound(dates.begin(), dates.end(), date);
+  CHECK(it != dates.end() && *it == date) << date;
+  return it - dates.begin();
+}
+
+const char* const kPriorities[] = {
+  "1-URGENT", "2-HIGH", "3-MEDIUM", "4-NOT SPECIFIED", "5-LOW"
+};
+const char* const kShipInstructions[] = {
+  "DELIVER IN PERSON", "COLLECT COD", "NONE", "TAKE BACK RETURN"
+};
+const char* const kShipModes[] = {
+  "REG AIR", "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB"
+};
+const char* const kTypeSyllables1[] = {
+  "STANDARD", "SMALL", "MEDIUM", "LARGE", "ECONOMY", "PROMO"
+};
+const char* const kTypeSyllables2[] = {
+  "ANODIZED", "BURNISHED", "PLATED", "POLISHED", "BRUSHED"
+};
+const char* const kTypeSyllables3[] = {
+  "TIN", "NICKEL", "BRASS", "STEEL", "COPPER"
+};
+const char* const kContainerSyllables1[] = {
+  "SM", "LG", "MED", "JUMBO", "WRAP"
+};
+const char* const kContainerSyllables2[] = {
+  "CASE", "BOX", "BAG", "JAR", "PKG", "PACK", "CAN", "DRUM"
+};
+const char* const kColors[] = {
+  "almond", "antique", "aquamarine", "azure", "beige", "bisque", "black", "blanched",
+  "blue", "blush", "brown", "burlywood", "burnished", "chartreuse", "chiffon", "chocolate",
+  "coral", "cornflower", "cornsilk", "cream", "cyan", "dark", "deep", "dim", "dodger"
+};
+const char* const kWords[] = {
+  "furiously", "sly", "careful", "blithely", "quickly", "fluffily", "slyly", "ironic",
+  "final", "regular", "express", "pending", "special", "bold", "even", "silent",
+  "deposits", "requests", "accounts", "packages", "instructions", "theodolites",
+  "foxes", "ideas", "dependencies", "pinto", "beans", "platelets", "asymptotes",
+  "sleep", "wake", "haggle", "nag", "use", "boost", "affix", "detect", "integrate",
+  "cajole", "along", "across", "among", "above", "according", "to", "the"
+};
+
+template<typename T, size_t N>
+const T& Pick(Random* rng, const T (&choices)[N]) {
+  return choices[rng->Uniform(N)];
+}
+
+// Returns random text of about 'min_len' to 'max_len' characters.
+string RandomText(Random* rng, int min_len, int max_len) {
+  int len = min_len + rng->Uniform(max_len - min_len + 1);
+  string text;
+  while (static_cast<int>(text.size()) < len) {
+    if (!text.empty()) text.push_back(' ');
+    text.append(Pick(rng, kWords));
+  }
+  text.resize(len);
+  return text;
+}
+
+// The retail price of a part, as defined by the TPC-H specification.
+double RetailPrice(int64_t partkey) {
+  return (90000 + ((partkey / 10) % 20001) + 100 * (partkey % 1000)) / 100.0;
+}
+
+// Accumulates the rows of a table column by column, in the layout expected
+// by KuduColumnarWriteBatch.
+class ColumnarRows {
+ public:
+  explicit ColumnarRows(const KuduSchema& schema)
+      : columns_(schema.num_columns()),
+        num_rows_(0) {
+    for (int i = 0; i < columns_.size(); i++) {
+      auto type = schema.Column(i).type();
+      columns_[i].var_length = type == KuduColumnSchema::STRING ||
+                               type == KuduColumnSchema::BINARY ||
+                               type == KuduColumnSchema::VARCHAR;
+    }
+    Clear();
+  }
+
+  template<typename T>
+  void AppendFixed(int idx, T val) {
+    DCHECK(!columns_[idx].var_length);
+    columns_[idx].data.append(reinterpret_cast<const char*>(&val), sizeof(val));
+  }
+
+  void AppendString(int idx, const string& val) {
+    Column& col = columns_[idx];
+    DCHECK(col.var_length);
+    col.data.append(val);
+    col.offsets.push_back(col.data.size());
+  }
+
+  // Must be called once all the columns of a row have been appended.
+  void FinishRow() {
+    num_rows_++;
+  }
+
+  int num_rows() const { return num_rows_; }
+
+  // Applies the accumulated rows as insertions to 'session', and clears them.
+  Status ApplyTo(const shared_ptr<KuduTable>& table, KuduSession* session) {
+    KuduColumnarWriteBatch batch(table, KuduWriteOperation::INSERT, num_rows_);
+    for (int i = 0; i < columns_.size(); i++) {
+      const Column& col = columns_[i];
+      if (col.var_length) {
+        RETURN_NOT_OK(batch.SetVariableLengthColumn(
+            i,
+            Slice(reinterpret_cast<const uint8_t*>(col.offsets.data()),
+                  col.offsets.size() * sizeof(uint32_t)),
+            col.data));
+      } else {
+        RETURN_NOT_OK(batch.SetFixedLengthColumn(i, col.data));
+      }
+    }
+    RETURN_NOT_OK(session->ApplyColumnar(batch));
+    Clear();
+    return Status::OK();
+  }
+
+ private:
+  struct Column {
+    bool var_length;
+    string data;
+    // Only used by variable-length columns.
+    vector<uint32_t> offsets;
+  };
+
+  void Clear() {
+    for (auto& col : columns_) {
+      col.data.clear();
+      col.offsets.assign(col.var_length ? 1 : 0, 0);
+    }
+    num_rows_ = 0;
+  }
+
+  vector<Column> columns_;
+  int num_rows_;
+};
+
+// Accessors to the cells of the columns of a KuduColumnarScanBatch, which
+// makes no alignment guarantees.
+template<typename T>
+class FixedColumn {
+ public:
+  FixedColumn(const KuduColumnarScanBatch& batch, int idx) {
+    CHECK_OK(batch.GetFixedLengthColumn(idx, &data_));
+  }
+  T operator[](int i) const {
+    return UnalignedLoad<T>(data_.data() + i * sizeof(T));
+  }
+ private:
+  Slice data_;
+};
+
+class StringColumn {
+ public:
+  StringColumn(const KuduColumnarScanBatch& batch, int idx) {
+    CHECK_OK(batch.GetVariableLengthColumn(idx, &offsets_, &data_));
+  }
+  Slice operator[](int i) const {
+    uint32_t start = UnalignedLoad<uint32_t>(offsets_.data() + i * sizeof(uint32_t));
+    uint32_t end = UnalignedLoad<uint32_t>(offsets_.data() + (i + 1) * sizeof(uint32_t));
+    return Slice(data_.data() + start, end - start);
+  }
+ private:
+  Slice offsets_;
+  Slice data_;
+};
+
+// The rows and bytes returned by the scans of a query.
+struct ScanStats {
+  int64_t rows = 0;
+  int64_t bytes = 0;
+};
+
+class TpchScans {
+ public:
+  Status Init();
+  Status LoadIfNeeded();
+  Status RunQuery(int query, ScanStats* stats);
+  void Shutdown();
+
+ private:
+  // Opens the table 'name' with 'schema', creating it if it doesn't exist.
+  // Sets 'created' if it was created.
+  Status OpenOrCreateTable(const string& name, const KuduSchema& schema,
+                           const string& hash_column, shared_ptr<KuduTable>* table,
+                           bool* created);
+
+  Status LoadParts(int64_t num_parts, KuduSession* session);
+  Status LoadOrdersAndLineItems(int64_t num_orders, int64_t num_parts, KuduSession* session);
+
+  // Scans the 'columns' of 'table' matching all the 'predicates', which
+  // are owned by the scan, calling 'visit' on each batch. The batches hold
+  // the columns in the order of 'columns'.
+  Status Scan(const shared_ptr<KuduTable>& table,
+              const vector<string>& columns,
+              vector<KuduPredicate*> predicates,
+              const std::function<void(const KuduColumnarScanBatch&)>& visit,
+              ScanStats* stats);
+
+  Status Q1(ScanStats* stats);
+  Status Q6(ScanStats* stats);
+  Status Q12(ScanStats* stats);
+  Status Q14(ScanStats* stats);
+
+  KuduPredicate* StringPredicate(const shared_ptr<KuduTable>& table, const string& column,
+                                 KuduPredicate::ComparisonOp op, const string& val) {
+    return table->NewComparisonPredicate(column, op, KuduValue::CopyString(val));
+  }
+
+  unique_ptr<InternalMiniCluster> cluster_;
+  shared_ptr<KuduClient> client_;
+  shared_ptr<KuduTable> lineitem_;
+  shared_ptr<KuduTable> orders_;
+  shared_ptr<KuduTable> part_;
+  bool needs_loading_ = false;
+};
+
+Status TpchScans::Init() {
+  vector<string> master_addresses;
+  if (FLAGS_tpch_use_mini_cluster) {
+    Env* env = Env::Default();
+    Status s = env->CreateDir(FLAGS_tpch_mini_cluster_base_dir);
+    if (!s.ok() && !s.IsAlreadyPresent()) {
+      return s;
+    }
+    InternalMiniClusterOptions options;
+    options.cluster_root = FLAGS_tpch_mini_cluster_base_dir;
+    options.num_tablet_servers = FLAGS_tpch_num_tablet_servers;
+    cluster_.reset(new InternalMiniCluster(env, options));
+    RETURN_NOT_OK(cluster_->StartSync());
+    master_addresses.emplace_back(cluster_->mini_master()->bound_rpc_addr_str());
+  } else {
+    master_addresses = strings::Split(FLAGS_tpch_master_addresses, ",");
+  }
+
+  RETURN_NOT_OK(KuduClientBuilder()
+                .master_server_addrs(master_addresses)
+                .default_admin_operation_timeout(
+                    MonoDelta::FromMilliseconds(FLAGS_tpch_timeout_ms))
+                .default_rpc_timeout(MonoDelta::FromMilliseconds(FLAGS_tpch_timeout_ms))
+                .Build(&client_));
+
+  bool lineitem_created;
+  bool orders_created;
+  bool part_created;
+  RETURN_NOT_OK(OpenOrCreateTable(FLAGS_tpch_table_prefix + "lineitem", CreateLineItemSchema(),
+                                  kOrderKeyColName, &lineitem_, &lineitem_created));
+  RETURN_NOT_OK(OpenOrCreateTable(FLAGS_tpch_table_prefix + "orders", CreateOrdersSchema(),
+                                  kOOrderKeyColName, &orders_, &orders_created));
+  RETURN_NOT_OK(OpenOrCreateTable(FLAGS_tpch_table_prefix + "part", CreatePartSchema(),
+                                  kPPartKeyColName, &part_, &part_created));
+  if (lineitem_created != orders_created || orders_created != part_created) {
+    return Status::IllegalState("only some of the TPC-H tables existed; drop them to reload");
+  }
+  needs_loading_ = lineitem_created;
+  return Status::OK();
+}
+
+Status TpchScans::OpenOrCreateTable(const string& name, const KuduSchema& schema,
+                                    const string& hash_column, shared_ptr<KuduTable>* table,
+                                    bool* created) {
+  Status s = client_->OpenTable(name, table);
+  if (s.ok()) {
+    *created = false;
+    return Status::OK();
+  }
+  if (!s.IsNotFound()) {
+    return s;
+  }
+  unique_ptr<KuduTableCreator> table_creator(client_->NewTableCreator());
+  RETURN_NOT_OK_PREPEND(table_creator->table_name(name)
+                        .schema(&schema)
+                        .add_hash_partitions({ hash_column }, FLAGS_tpch_num_tablets)
+                        .num_replicas(1)
+                        .Create(),
+                        Substitute("unable to create table $0", name));
+  *created = true;
+  return client_->OpenTable(name, table);
+}
+
+Status TpchScans::LoadIfNeeded() {
+  if (!needs_loading_) {
+    LOG(INFO) << "Data already in place";
+    return Status::OK();
+  }
+  if (!FLAGS_tpch_load_data) {
+    LOG(WARNING) << "Created empty tables without loading them";
+    return Status::OK();
+  }
+  const int64_t num_orders = std::max<int64_t>(1, 1500000 * FLAGS_tpch_scale_factor);
+  const int64_t num_parts = std::max<int64_t>(1, 200000 * FLAGS_tpch_scale_factor);
+
+  shared_ptr<KuduSession> session = client_->NewSession();
+  session->SetTimeoutMillis(FLAGS_tpch_timeout_ms);
+  RETURN_NOT_OK(session->SetMutationBufferSpace(64 * 1024 * 1024));
+  RETURN_NOT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+
+  MonoTime start = MonoTime::Now();
+  RETURN_NOT_OK(LoadParts(num_parts, session.get()));
+  RETURN_NOT_OK(LoadOrdersAndLineItems(num_orders, num_parts, session.get()));
+  Status s = session->Flush();
+  if (session->CountPendingErrors() > 0) {
+    vector<client::KuduError*> errors;
+    bool overflowed;
+    session->GetPendingErrors(&errors, &overflowed);
+    Status first_error = errors[0]->status();
+    for (auto* e : errors) delete e;
+    return first_error.CloneAndPrepend(
+        Substitute("$0 rows failed to load", errors.size()));
+  }
+  RETURN_NOT_OK(s);
+  LOG(INFO) << Substitute("Loaded $0 orders and $1 parts in $2",
+                          num_orders, num_parts, (MonoTime::Now() - start).ToString());
+  return Status::OK();
+}
+
+Status TpchScans::LoadParts(int64_t num_parts, KuduSession* session) {
+  Random rng(1);
+  ColumnarRows rows(part_->schema());
+  for (int64_t partkey = 1; partkey <= num_parts; partkey++) {
+    int mfgr = 1 + rng.Uniform(5);
+    rows.AppendFixed<int32_t>(kPPartKeyColIdx, partkey);
+    rows.AppendString(kPNameColIdx, Substitute("$0 $1 $2", Pick(&rng, kColors),
+                                               Pick(&rng, kColors), Pick(&rng, kColors)));
+    rows.AppendString(kPMfgrColIdx, Substitute("Manufacturer#$0", mfgr));
+    rows.AppendString(kPBrandColIdx, Substitute("Brand#$0$1", mfgr, 1 + rng.Uniform(5)));
+    rows.AppendString(kPTypeColIdx, Substitute("$0 $1 $2", Pick(&rng, kTypeSyllables1),
+                                               Pick(&rng, kTypeSyllables2),
+                                               Pick(&rng, kTypeSyllables3)));
+    rows.AppendFixed<int32_t>(kPSizeColIdx, 1 + rng.Uniform(50));
+    rows.AppendString(kPContainerColIdx, Substitute("$0 $1", Pick(&rng, kContainerSyllables1),
+                                                    Pick(&rng, kContainerSyllables2)));
+    rows.AppendFixed<double>(kPRetailPriceColIdx, RetailPrice(partkey));
+    rows.AppendString(kPCommentColIdx, RandomText(&rng, 5, 22));
+    rows.FinishRow();
+    if (rows.num_rows() == FLAGS_tpch_load_batch_rows) {
+      RETURN_NOT_OK(rows.ApplyTo(part_, session));
+    }
+  }
+  return rows.ApplyTo(part_, session);
+}
+
+Status TpchScans::LoadOrdersAndLineItems(int64_t num_orders, int64_t num_parts,
+                                         KuduSession* session) {
+  static const int kNumOrderDates = Dates().size() - 151;
+  static const int kCurrentDate = DateIndex("1995-06-17");
+  const int64_t num_customers = std::max<int64_t>(1, 150000 * FLAGS_tpch_scale_factor);
+  const int64_t num_suppliers = std::max<int64_t>(1, 10000 * FLAGS_tpch_scale_factor);
+
+  Random rng(2);
+  ColumnarRows orders(orders_->schema());
+  ColumnarRows lines(lineitem_->schema());
+  for (int64_t orderkey = 1; orderkey <= num_orders; orderkey++) {
+    int orderdate = rng.Uniform(kNumOrderDates);
+    int num_lines = 1 + rng.Uniform(7);
+    double totalprice = 0;
+    int num_shipped = 0;
+    for (int linenumber = 1; linenumber <= num_lines; linenumber++) {
+      int64_t partkey = 1 + rng.Uniform64(num_parts);
+      int quantity = 1 + rng.Uniform(50);
+      double extendedprice = quantity * RetailPrice(partkey);
+      double discount = rng.Uniform(11) / 100.0;
+      double tax = rng.Uniform(9) / 100.0;
+      int shipdate = orderdate + 1 + rng.Uniform(121);
+      int commitdate = orderdate + 30 + rng.Uniform(61);
+      int receiptdate = shipdate + 1 + rng.Uniform(30);
+      bool shipped = shipdate <= kCurrentDate;
+      num_shipped += shipped;
+      totalprice += extendedprice * (1 + tax) * (1 - discount);
+
+      lines.AppendFixed<int64_t>(kOrderKeyColIdx, orderkey);
+      lines.AppendFixed<int32_t>(kLineNumberColIdx, linenumber);
+      lines.AppendFixed<int32_t>(kPartKeyColIdx, partkey);
+      lines.AppendFixed<int32_t>(kSuppKeyColIdx, 1 + rng.Uniform64(num_suppliers));
+      lines.AppendFixed<int32_t>(kQuantityColIdx, quantity);
+      lines.AppendFixed<double>(kExtendedPriceColIdx, extendedprice);
+      lines.AppendFixed<double>(kDiscountColIdx, discount);
+      lines.AppendFixed<double>(kTaxColIdx, tax);
+      lines.AppendString(kReturnFlagColIdx,
+                         receiptdate > kCurrentDate ? "N" : (rng.OneIn(2) ? "R" : "A"));
+      lines.AppendString(kLineStatusColIdx, shipped ? "F" : "O");
+      lines.AppendString(kShipDateColIdx, Dates()[shipdate]);
+      lines.AppendString(kCommitDateColIdx, Dates()[commitdate]);
+      lines.AppendString(kReceiptDateColIdx, Dates()[receiptdate]);
+      lines.AppendString(kShipInstructColIdx, Pick(&rng, kShipInstructions));
+      lines.AppendString(kShipModeColIdx, Pick(&rng, kShipModes));
+      lines.AppendString(kCommentColIdx, RandomText(&rng, 10, 43));
+      lines.FinishRow();
+      if (lines.num_rows() == FLAGS_tpch_load_batch_rows) {
+        RETURN_NOT_OK(lines.ApplyTo(lineitem_, session));
+      }
+    }
+
+    orders.AppendFixed<int64_t>(kOOrderKeyColIdx, orderkey);
+    orders.AppendFixed<int32_t>(kOCustKeyColIdx, 1 + rng.Uniform64(num_customers));
+    orders.AppendString(kOOrderStatusColIdx,
+                        num_shipped == num_lines ? "F" : (num_shipped == 0 ? "O" : "P"));
+    orders.AppendFixed<double>(kOTotalPriceColIdx, totalprice);
+    orders.AppendString(kOOrderDateColIdx, Dates()[orderdate]);
+    orders.AppendString(kOOrderPriorityColIdx, Pick(&rng, kPriorities));
+    orders.AppendString(kOClerkColIdx,
+                        StringPrintf("Clerk#%09d", 1 + rng.Uniform(
+                            std::max<int>(1, 1000 * FLAGS_tpch_scale_factor))));
+    orders.AppendFixed<int32_t>(kOShipPriorityColIdx, 0);
+    orders.AppendString(kOCommentColIdx, RandomText(&rng, 19, 78));
+    orders.FinishRow();
+    if (orders.num_rows() == FLAGS_tpch_load_batch_rows) {
+      RETURN_NOT_OK(orders.ApplyTo(orders_, session));
+    }
+  }
+  RETURN_NOT_OK(lines.ApplyTo(lineitem_, session));
+  return orders.ApplyTo(orders_, session);
+}
+
+Status TpchScans::Scan(const shared_ptr<KuduTable>& table,
+                       const vector<string>& columns,
+                       vector<KuduPredicate*> predicates,
+                       const std::function<void(const KuduColumnarScanBatch&)>& visit,
+                       ScanStats* stats) {
+  KuduScanTokenBuilder builder(table.get());
+  // The builder takes ownership of the predicates as they are added.
+  Status s;
+  for (int i = 0; i < predicates.size(); i++) {
+    s = builder.AddConjunctPredicate(predicates[i]);
+    if (!s.ok()) {
+      for (int j = i + 1; j < predicates.size(); j++) delete predicates[j];
+      return s;
+    }
+  }
+  RETURN_NOT_OK(builder.SetProjectedColumnNames(columns));
+  RETURN_NOT_OK(builder.SetTimeoutMillis(FLAGS_tpch_timeout_ms));
+  if (FLAGS_tpch_scan_batch_size_bytes > 0) {
+    RETURN_NOT_OK(builder.SetBatchSizeBytes(FLAGS_tpch_scan_batch_size_bytes));
+  }
+
+  vector<bool> var_length;
+  for (const auto& name : columns) {
+    // KuduColumnSchema has no default constructor.
+    KuduColumnSchema col = table->schema().Column(0);
+    CHECK(table->schema().HasColumn(name, &col)) << name;
+    var_length.push_back(col.type() == KuduColumnSchema::STRING ||
+                         col.type() == KuduColumnSchema::BINARY ||
+                         col.type() == KuduColumnSchema::VARCHAR);
+  }
+
+  KuduParallelScanner scanner(&builder);
+  RETURN_NOT_OK(scanner.SetConcurrency(FLAGS_tpch_scan_concurrency));
+  RETURN_NOT_OK(scanner.Open());
+  KuduColumnarScanBatch batch;
+  while (scanner.HasMoreBatches()) {
+    RETURN_NOT_OK(scanner.NextBatch(&batch));
+    stats->rows += batch.NumRows();
+    for (int i = 0; i < var_length.size(); i++) {
+      Slice data;
+      if (var_length[i]) {
+        Slice offsets;
+        RETURN_NOT_OK(batch.GetVariableLengthColumn(i, &offsets, &data));
+        stats->bytes += offsets.size();
+      } else {
+        RETURN_NOT_OK(batch.GetFixedLengthColumn(i, &data));
+      }
+      stats->bytes += data.size();
+    }
+    visit(batch);
+  }
+  return Status::OK();
+}
+
+// select l_returnflag, l_linestatus, sum(l_quantity), sum(l_extendedprice),
+//   sum(l_extendedprice * (1 - l_discount)),
+//   sum(l_extendedprice * (1 - l_discount) * (1 + l_tax)),
+//   avg(l_quantity), avg(l_extendedprice), avg(l_discount), count(*)
+// from lineitem
+// where l_shipdate <= date '1998-09-02'
+// group by l_returnflag, l_linestatus
+Status TpchScans::Q1(ScanStats* stats) {
+  struct Group {
+    int64_t sum_qty = 0;
+    double sum_base_price = 0;
+    double sum_disc_price = 0;
+    double sum_charge = 0;
+    double sum_disc = 0;
+    int64_t count = 0;
+  };
+  map<pair<char, char>, Group> groups;
+  RETURN_NOT_OK(Scan(
+      lineitem_,
+      { kReturnFlagColName, kLineStatusColName, kQuantityColName, kExtendedPriceColName,
+        kDiscountColName, kTaxColName },
+      { StringPredicate(lineitem_, kShipDateColName, KuduPredicate::LESS_EQUAL, "1998-09-02") },
+      [&](const KuduColumnarScanBatch& batch) {
+        StringColumn returnflag(batch, 0);
+        StringColumn linestatus(batch, 1);
+        FixedColumn<int32_t> quantity(batch, 2);
+        FixedColumn<double> extendedprice(batch, 3);
+        FixedColumn<double> discount(batch, 4);
+        FixedColumn<double> tax(batch, 5);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          Group& g = groups[{ returnflag[i][0], linestatus[i][0] }];
+          double disc_price = extendedprice[i] * (1 - discount[i]);
+          g.sum_qty += quantity[i];
+          g.sum_base_price += extendedprice[i];
+          g.sum_disc_price += disc_price;
+          g.sum_charge += disc_price * (1 + tax[i]);
+          g.sum_disc += discount[i];
+          g.count++;
+        }
+      },
+      stats));
+  for (const auto& e : groups) {
+    const Group& g = e.second;
+    LOG(INFO) << StringPrintf("Q1: %c, %c, %" PRId64 ", %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, "
+                              "%" PRId64,
+                              e.first.first, e.first.second, g.sum_qty, g.sum_base_price,
+                              g.sum_disc_price, g.sum_charge,
+                              static_cast<double>(g.sum_qty) / g.count,
+                              g.sum_base_price / g.count, g.sum_disc / g.count, g.count);
+  }
+  return Status::OK();
+}
+
+// select sum(l_extendedprice * l_discount)
+// from lineitem
+// where l_shipdate >= date '1994-01-01' and l_shipdate < date '1995-01-01'
+//   and l_discount between 0.05 and 0.07 and l_quantity < 24
+Status TpchScans::Q6(ScanStats* stats) {
+  double revenue = 0;
+  RETURN_NOT_OK(Scan(
+      lineitem_,
+      { kExtendedPriceColName, kDiscountColName },
+      { StringPredicate(lineitem_, kShipDateColName, KuduPredicate::GREATER_EQUAL, "1994-01-01"),
+        StringPredicate(lineitem_, kShipDateColName, KuduPredicate::LESS, "1995-01-01"),
+        lineitem_->NewComparisonPredicate(kDiscountColName, KuduPredicate::GREATER_EQUAL,
+                                          KuduValue::FromDouble(0.05)),
+        lineitem_->NewComparisonPredicate(kDiscountColName, KuduPredicate::LESS_EQUAL,
+                                          KuduValue::FromDouble(0.07)),
+        lineitem_->NewComparisonPredicate(kQuantityColName, KuduPredicate::LESS,
+                                          KuduValue::FromInt(24)) },
+      [&](const KuduColumnarScanBatch& batch) {
+        FixedColumn<double> extendedprice(batch, 0);
+        FixedColumn<double> discount(batch, 1);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          revenue += extendedprice[i] * discount[i];
+        }
+      },
+      stats));
+  LOG(INFO) << StringPrintf("Q6: %.2f", revenue);
+  return Status::OK();
+}
+
+// select l_shipmode,
+//   sum(case when o_orderpriority in ('1-URGENT', '2-HIGH') then 1 else 0 end),
+//   sum(case when o_orderpriority not in ('1-URGENT', '2-HIGH') then 1 else 0 end)
+// from orders, lineitem
+// where o_orderkey = l_orderkey and l_shipmode in ('MAIL', 'SHIP')
+//   and l_commitdate < l_receiptdate and l_shipdate < l_commitdate
+//   and l_receiptdate >= date '1994-01-01' and l_receiptdate < date '1995-01-01'
+// group by l_shipmode
+Status TpchScans::Q12(ScanStats* stats) {
+  // Indexed by order key.
+  vector<bool> high_priority;
+  RETURN_NOT_OK(Scan(
+      orders_, { kOOrderKeyColName, kOOrderPriorityColName }, {},
+      [&](const KuduColumnarScanBatch& batch) {
+        FixedColumn<int64_t> orderkey(batch, 0);
+        StringColumn priority(batch, 1);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          int64_t key = orderkey[i];
+          if (key >= high_priority.size()) {
+            high_priority.resize(key + 1);
+          }
+          high_priority[key] = priority[i].starts_with("1-") || priority[i].starts_with("2-");
+        }
+      },
+      stats));
+
+  map<string, pair<int64_t, int64_t>> counts;
+  vector<KuduValue*> shipmodes = { KuduValue::CopyString("MAIL"), KuduValue::CopyString("SHIP") };
+  RETURN_NOT_OK(Scan(
+      lineitem_,
+      { kOrderKeyColName, kShipModeColName, kShipDateColName, kCommitDateColName,
+        kReceiptDateColName },
+      { lineitem_->NewInListPredicate(kShipModeColName, &shipmodes),
+        StringPredicate(lineitem_, kReceiptDateColName, KuduPredicate::GREATER_EQUAL,
+                        "1994-01-01"),
+        StringPredicate(lineitem_, kReceiptDateColName, KuduPredicate::LESS, "1995-01-01") },
+      [&](const KuduColumnarScanBatch& batch) {
+        FixedColumn<int64_t> orderkey(batch, 0);
+        StringColumn shipmode(batch, 1);
+        StringColumn shipdate(batch, 2);
+        StringColumn commitdate(batch, 3);
+        StringColumn receiptdate(batch, 4);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          // Kudu can't push down predicates comparing two columns.
+          if (commitdate[i].compare(receiptdate[i]) >= 0 ||
+              shipdate[i].compare(commitdate[i]) >= 0) {
+            continue;
+          }
+          auto& c = counts[shipmode[i].ToString()];
+          int64_t key = orderkey[i];
+          if (key < high_priority.size() && high_priority[key]) {
+            c.first++;
+          } else {
+            c.second++;
+          }
+        }
+      },
+      stats));
+  for (const auto& e : counts) {
+    LOG(INFO) << Substitute("Q12: $0, $1, $2", e.first, e.second.first, e.second.second);
+  }
+  return Status::OK();
+}
+
+// select 100.00 * sum(case when p_type like 'PROMO%'
+//                     then l_extendedprice * (1 - l_discount) else 0 end)
+//   / sum(l_extendedprice * (1 - l_discount))
+// from lineitem, part
+// where l_partkey = p_partkey
+//   and l_shipdate >= date '1995-09-01' and l_shipdate < date '1995-10-01'
+Status TpchScans::Q14(ScanStats* stats) {
+  // Indexed by part key.
+  vector<bool> promo;
+  RETURN_NOT_OK(Scan(
+      part_, { kPPartKeyColName, kPTypeColName }, {},
+      [&](const KuduColumnarScanBatch& batch) {
+        FixedColumn<int32_t> partkey(batch, 0);
+        StringColumn type(batch, 1);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          int32_t key = partkey[i];
+          if (key >= promo.size()) {
+            promo.resize(key + 1);
+          }
+          promo[key] = type[i].starts_with("PROMO");
+        }
+      },
+      stats));
+
+  double promo_revenue = 0;
+  double revenue = 0;
+  RETURN_NOT_OK(Scan(
+      lineitem_,
+      { kPartKeyColName, kExtendedPriceColName, kDiscountColName },
+      { StringPredicate(lineitem_, kShipDateColName, KuduPredicate::GREATER_EQUAL, "1995-09-01"),
+        StringPredicate(lineitem_, kShipDateColName, KuduPredicate::LESS, "1995-10-01") },
+      [&](const KuduColumnarScanBatch& batch) {
+        FixedColumn<int32_t> partkey(batch, 0);
+        FixedColumn<double> extendedprice(batch, 1);
+        FixedColumn<double> discount(batch, 2);
+        for (int i = 0; i < batch.NumRows(); i++) {
+          double r = extendedprice[i] * (1 - discount[i]);
+          revenue += r;
+          int32_t key = partkey[i];
+          if (key < promo.size() && promo[key]) {
+            promo_revenue += r;
+          }
+        }
+      },
+      stats));
+  LOG(INFO) << StringPrintf("Q14: %.2f", revenue > 0 ? 100 * promo_revenue / revenue : 0);
+  return Status::OK();
+}
+
+Status TpchScans::RunQuery(int query, ScanStats* stats) {
+  switch (query) {
+    case 1: return Q1(stats);
+    case 6: return Q6(stats);
+    case 12: return Q12(stats);
+    case 14: return Q14(stats);
+    default:
+      return Status::InvalidArgument(Substitute("unsupported TPC-H query: $0", query));
+  }
+}
+
+void TpchScans::Shutdown() {
+  client_.reset();
+  if (cluster_) {
+    cluster_->Shutdown();
+  }
+}
+
+} // anonymous namespace
+
+Status RunBenchmark() {
+  vector<int> queries;
+  for (const auto& q : strings::Split(FLAGS_tpch_queries, ",", strings::SkipEmpty())) {
+    int query;
+    if (!safe_strto32(q.data(), q.size(), &query)) {
+      return Status::InvalidArgument("invalid query number", q);
+    }
+    queries.push_back(query);
+  }
+
+  TpchScans bench;
+  RETURN_NOT_OK(bench.Init());
+  RETURN_NOT_OK(bench.LoadIfNeeded());
+
+  cout << "query\titeration\tseconds\trows\trows/s\tGB\tGB/s" << endl;
+  for (int query : queries) {
+    for (int i = 0; i < FLAGS_tpch_num_query_iterations; i++) {
+      ScanStats stats;
+      MonoTime start = MonoTime::Now();
+      RETURN_NOT_OK_PREPEND(bench.RunQuery(query, &stats), Substitute("Q$0 failed", query));
+      double secs = (MonoTime::Now() - start).ToSeconds();
+      double gb = stats.bytes / 1e9;
+      cout << StringPrintf("Q%d\t%d\t%.3f\t%" PRId64 "\t%.0f\t%.3f\t%.3f",
+                           query, i, secs, stats.rows, stats.rows / secs, gb, gb / secs)
+           << endl;
+    }
+  }
+  bench.Shutdown();
+  return Status::OK();
+}
+
+} // namespace tpch
+} // namespace kudu
+
+int main(int argc, char** argv) {
+  kudu::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+
+  kudu::Status s = kudu::tpch::RunBenchmark();
+  if (!s.ok()) {
+    LOG(ERROR) << s.ToString();
+    return 1;
+  }
+  return 0;
+}
@@ -258,10 +258,6 @@ Status BinaryDictBlockDecoder::SeekAtOrAfterValue(const void* value_void, bool*
   }
 }
 
-// TODO: implement CopyNextAndEval for more blocks. Eg. other blocks can
-// store their min/max values. CopyNextAndEval in these blocks could
-// short-circuit if the query can does not search for values within the
-// min/max range, or copy all and evaluate otherwise.
 Status BinaryDictBlockDecoder::CopyNextAndEval(size_t* n,
                                                ColumnMaterializationContext* ctx,
                                                SelectionVectorView* sel,
@@ -75,7 +75,10 @@ enum DictEncodingMode {
   DictEncodingMode_min = 1,
   kCodeWordMode = 1,
   kPlainBinaryMode = 2,
-  DictEncodingMode_max = 2
+  // Used by the numeric dictionary blocks (see numeric_dict_block.h) once
+  // the dictionary is full.
+  kBitShuffleMode = 3,
+  DictEncodingMode_max = 3
 };
 
 class BinaryDictBlockBuilder final : public BlockBuilder {
@@ -88,6 +91,10 @@ class BinaryDictBlockBuilder final : public BlockBuilder {
   // accordingly.
   Status AppendExtraInfo(CFileWriter* c_writer, CFileFooterPB* footer) OVERRIDE;
 
+  size_t EstimateExtraInfoSize() const override {
+    return dict_block_.EstimatedSize();
+  }
+
   int Add(const uint8_t* vals, size_t count) OVERRIDE;
 
   void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) OVERRIDE;
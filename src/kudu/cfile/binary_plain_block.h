@@ -69,6 +69,11 @@ class BinaryPlainBlockBuilder final : public BlockBuilder {
 
   size_t Count() const OVERRIDE;
 
+  // Return an estimate of the size of the encoded block.
+  size_t EstimatedSize() const {
+    return size_estimate_;
+  }
+
   // Return the key at index idx.
   // key should be a Slice*
   Status GetKeyAtIdx(void* key_void, int idx) const;
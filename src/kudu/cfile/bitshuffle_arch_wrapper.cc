@@ -34,6 +34,21 @@
 #undef bshuf_compress_lz4
 #undef bshuf_decompress_lz4
 
+// And once more for the AVX-512 symbols. Those are only present if the
+// thirdparty library was built by a compiler supporting AVX-512, so they are
+// declared weak and checked for at runtime.
+#undef BITSHUFFLE_H
+#define bshuf_compress_lz4_bound bshuf_compress_lz4_bound_avx512
+#define bshuf_compress_lz4 bshuf_compress_lz4_avx512
+#define bshuf_decompress_lz4 bshuf_decompress_lz4_avx512
+#include <bitshuffle.h> // NOLINT(*) IWYU pragma: keep
+#undef bshuf_compress_lz4_bound
+#undef bshuf_compress_lz4
+#undef bshuf_decompress_lz4
+#pragma weak bshuf_compress_lz4_bound_avx512
+#pragma weak bshuf_compress_lz4_avx512
+#pragma weak bshuf_decompress_lz4_avx512
+
 #include "kudu/gutil/cpu.h"
 
 using base::CPU;
@@ -58,7 +73,13 @@ decltype(&bshuf_decompress_lz4) g_bshuf_decompress_lz4;
 __attribute__((constructor))
 void SelectBitshuffleFunctions() {
 #ifndef __APPLE__
-  if (CPU().has_avx2()) {
+  CPU cpu;
+  if (cpu.has_avx512bw() && bshuf_compress_lz4_bound_avx512 != nullptr &&
+      bshuf_compress_lz4_avx512 != nullptr && bshuf_decompress_lz4_avx512 != nullptr) {
+    g_bshuf_compress_lz4_bound = bshuf_compress_lz4_bound_avx512;
+    g_bshuf_compress_lz4 = bshuf_compress_lz4_avx512;
+    g_bshuf_decompress_lz4 = bshuf_decompress_lz4_avx512;
+  } else if (cpu.has_avx2()) {
     g_bshuf_compress_lz4_bound = bshuf_compress_lz4_bound_avx2;
     g_bshuf_compress_lz4 = bshuf_compress_lz4_avx2;
     g_bshuf_decompress_lz4 = bshuf_decompress_lz4_avx2;
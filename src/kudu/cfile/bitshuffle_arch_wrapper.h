@@ -20,7 +20,8 @@
 #include <stdint.h>
 
 // This namespace has wrappers for the Bitshuffle library which do runtime dispatch to
-// either AVX2-accelerated or regular SSE2 implementations based on the available CPU.
+// either AVX-512, AVX2-accelerated or regular SSE2 implementations based on the available
+// CPU.
 namespace kudu {
 namespace bitshuffle {
 
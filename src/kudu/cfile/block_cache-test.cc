@@ -20,14 +20,19 @@
 #include <cstring>
 #include <memory>
 #include <ostream>
+#include <string>
 
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/fs/block_id.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/env.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
 
 DECLARE_double(cache_memtracker_approximation_ratio);
 
@@ -85,6 +90,77 @@ TEST(TestBlockCache, TestBasics) {
   ASSERT_FALSE(cache.Lookup(key1, Cache::EXPECT_IN_CACHE, &retrieved_handle));
 }
 
+TEST(TestBlockCache, TestCompressedTier) {
+  const size_t data_size = strlen(DATA_TO_CACHE) + 1;
+  BlockCache::FileId id(1234);
+  BlockCache::CacheKey key(id, 1);
+
+  // Without a compressed tier, compressed blocks can't be cached.
+  {
+    BlockCache cache(1024 * 1024);
+    ASSERT_FALSE(cache.has_compressed_tier());
+    ASSERT_FALSE(cache.AllocateCompressed(key, data_size).valid());
+    BlockCacheHandle handle;
+    ASSERT_FALSE(cache.LookupCompressed(key, Cache::EXPECT_IN_CACHE, &handle));
+  }
+
+  BlockCache cache(1024 * 1024, 1024 * 1024);
+  ASSERT_TRUE(cache.has_compressed_tier());
+  BlockCache::PendingEntry data = cache.AllocateCompressed(key, data_size);
+  ASSERT_TRUE(data.valid());
+  memcpy(data.val_ptr(), DATA_TO_CACHE, data_size);
+  BlockCacheHandle inserted_handle;
+  cache.InsertCompressed(&data, &inserted_handle);
+  ASSERT_TRUE(inserted_handle.valid());
+
+  // The compressed tier and the main cache are separate.
+  BlockCacheHandle handle;
+  ASSERT_FALSE(cache.Lookup(key, Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_TRUE(cache.LookupCompressed(key, Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_EQ(0, memcmp(handle.data().data(), DATA_TO_CACHE, data_size));
+}
+
+class BlockCacheTest : public KuduTest {};
+
+TEST_F(BlockCacheTest, TestSaveAndLoad) {
+  const size_t data_size = strlen(DATA_TO_CACHE) + 1;
+  const BlockCache::FileId live_id(1234);
+  const BlockCache::FileId deleted_id(5678);
+  const std::string path = GetTestPath("block_cache");
+
+  {
+    BlockCache cache(1024 * 1024);
+    for (const auto& id : { live_id, deleted_id }) {
+      BlockCache::PendingEntry data = cache.Allocate(BlockCache::CacheKey(id, 1), data_size);
+      memcpy(data.val_ptr(), DATA_TO_CACHE, data_size);
+      BlockCacheHandle inserted_handle;
+      cache.Insert(&data, &inserted_handle);
+    }
+    int64_t num_saved;
+    ASSERT_OK(cache.SaveToFile(env_, path, &num_saved));
+    ASSERT_EQ(2, num_saved);
+  }
+
+  // Only the blocks of the files which still exist are loaded.
+  BlockCache cache(1024 * 1024);
+  int64_t num_loaded;
+  ASSERT_OK(cache.LoadFromFile(env_, path,
+                               [&](const BlockId& id) { return id == live_id; },
+                               &num_loaded));
+  ASSERT_EQ(1, num_loaded);
+  BlockCacheHandle handle;
+  ASSERT_FALSE(cache.Lookup(BlockCache::CacheKey(deleted_id, 1),
+                            Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_TRUE(cache.Lookup(BlockCache::CacheKey(live_id, 1),
+                           Cache::EXPECT_IN_CACHE, &handle));
+  ASSERT_EQ(0, memcmp(handle.data().data(), DATA_TO_CACHE, data_size));
+
+  // Blocks which are already cached aren't loaded again.
+  ASSERT_OK(cache.LoadFromFile(env_, path,
+                               [](const BlockId& /* id */) { return true; },
+                               &num_loaded));
+  ASSERT_EQ(1, num_loaded);
+}
 
 } // namespace cfile
 } // namespace kudu
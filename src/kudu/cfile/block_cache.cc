@@ -19,22 +19,31 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/cfile/cfile.pb.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/block_cache_metrics.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/cache_metrics.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/pb_util.h"
 #include "kudu/util/process_memory.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/string_case.h"
 
 DEFINE_int64(block_cache_capacity_mb, 512, "block cache capacity in MB");
@@ -57,9 +66,43 @@ DEFINE_string(block_cache_type, "DRAM",
               "libmemkind 1.8.0 or newer must be available on the system; "
               "otherwise Kudu will crash.");
 
-using strings::Substitute;
+DEFINE_string(block_cache_eviction_policy, "LRU",
+              "The eviction policy of the block cache. Valid choices are "
+              "'LRU' or 'SLRU'. 'SLRU' (segmented LRU) keeps the blocks which "
+              "are read repeatedly in a protected segment, so large scans "
+              "don't evict them. Only 'LRU' is supported with the 'NVM' "
+              "block cache type.");
+TAG_FLAG(block_cache_eviction_policy, advanced);
+TAG_FLAG(block_cache_eviction_policy, experimental);
+
+DEFINE_int64(block_cache_compressed_capacity_mb, 0,
+             "Capacity in MB of the compressed tier of the block cache, which "
+             "keeps the blocks of compressed CFiles as they're stored on disk. "
+             "A block which is evicted from the block cache but is still in "
+             "the compressed tier is decompressed instead of being read again. "
+             "The compressed tier is always kept in DRAM. If 0, there is no "
+             "compressed tier.");
+TAG_FLAG(block_cache_compressed_capacity_mb, advanced);
+TAG_FLAG(block_cache_compressed_capacity_mb, experimental);
 
-template <class T> class scoped_refptr;
+METRIC_DEFINE_counter(server, block_cache_compressed_tier_hits,
+                      "Block Cache Compressed Tier Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found a compressed block in the "
+                      "compressed tier of the block cache",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_compressed_tier_inserts,
+                      "Block Cache Compressed Tier Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of compressed blocks inserted in the compressed tier "
+                      "of the block cache",
+                      kudu::MetricLevel::kDebug);
+
+using kudu::pb_util::ReadablePBContainerFile;
+using kudu::pb_util::WritablePBContainerFile;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 
@@ -69,8 +112,31 @@ namespace cfile {
 
 namespace {
 
+Cache::EvictionPolicy GetConfiguredEvictionPolicyOrDie() {
+  ToUpperCase(FLAGS_block_cache_eviction_policy,
+              &FLAGS_block_cache_eviction_policy);
+  if (FLAGS_block_cache_eviction_policy == "LRU") {
+    return Cache::EvictionPolicy::LRU;
+  }
+  if (FLAGS_block_cache_eviction_policy == "SLRU") {
+    return Cache::EvictionPolicy::SLRU;
+  }
+  LOG(FATAL) << "Unknown block cache eviction policy: '"
+             << FLAGS_block_cache_eviction_policy
+             << "' (expected 'LRU' or 'SLRU')";
+  __builtin_unreachable();
+}
+
 Cache* CreateCache(int64_t capacity) {
   const auto mem_type = BlockCache::GetConfiguredCacheMemoryTypeOrDie();
+  const auto policy = GetConfiguredEvictionPolicyOrDie();
+  if (policy == Cache::EvictionPolicy::SLRU) {
+    if (mem_type != Cache::MemoryType::DRAM) {
+      LOG(FATAL) << "unsupported SLRU cache memory type: " << mem_type;
+    }
+    return NewCache<Cache::EvictionPolicy::SLRU, Cache::MemoryType::DRAM>(
+        capacity, "block_cache");
+  }
   switch (mem_type) {
     case Cache::MemoryType::DRAM:
       return NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::DRAM>(
@@ -133,11 +199,19 @@ Cache::MemoryType BlockCache::GetConfiguredCacheMemoryTypeOrDie() {
 }
 
 BlockCache::BlockCache()
-    : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024) {
+    : BlockCache(FLAGS_block_cache_capacity_mb * 1024 * 1024,
+                 FLAGS_block_cache_compressed_capacity_mb * 1024 * 1024) {
 }
 
-BlockCache::BlockCache(size_t capacity)
+BlockCache::BlockCache(size_t capacity, size_t compressed_capacity)
     : cache_(CreateCache(capacity)) {
+  if (compressed_capacity > 0) {
+    compressed_cache_.reset(NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::DRAM>(
+        compressed_capacity, "block_cache_compressed"));
+  }
+}
+
+BlockCache::~BlockCache() {
 }
 
 BlockCache::PendingEntry BlockCache::Allocate(const CacheKey& key, size_t block_size) {
@@ -162,9 +236,130 @@ void BlockCache::Insert(BlockCache::PendingEntry* entry, BlockCacheHandle* inser
   inserted->SetHandle(std::move(h));
 }
 
+bool BlockCache::LookupCompressed(const CacheKey& key, Cache::CacheBehavior behavior,
+                                  BlockCacheHandle* handle) {
+  if (!compressed_cache_) {
+    return false;
+  }
+  auto h(compressed_cache_->Lookup(
+      Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)), behavior));
+  if (!h) {
+    return false;
+  }
+  if (compressed_tier_hits_) {
+    compressed_tier_hits_->Increment();
+  }
+  handle->SetHandle(std::move(h));
+  return true;
+}
+
+BlockCache::PendingEntry BlockCache::AllocateCompressed(const CacheKey& key,
+                                                        size_t block_size) {
+  if (!compressed_cache_) {
+    return PendingEntry();
+  }
+  Slice key_slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key));
+  return PendingEntry(compressed_cache_->Allocate(key_slice, block_size));
+}
+
+void BlockCache::InsertCompressed(BlockCache::PendingEntry* entry,
+                                  BlockCacheHandle* inserted) {
+  DCHECK(compressed_cache_);
+  auto h(compressed_cache_->Insert(std::move(entry->handle_),
+                                   /* eviction_callback= */ nullptr));
+  if (compressed_tier_inserts_) {
+    compressed_tier_inserts_->Increment();
+  }
+  inserted->SetHandle(std::move(h));
+}
+
+Status BlockCache::SaveToFile(Env* env, const string& path, int64_t* num_saved) {
+  // Collect the keys first rather than writing the blocks while iterating:
+  // the iteration holds the locks of the cache's shards.
+  vector<string> keys;
+  cache_->Invalidate({
+      [&keys](Slice key, Slice /* value */) {
+        keys.emplace_back(key.ToString());
+        return true;
+      }
+  });
+
+  // Write to a temporary file first so that an incomplete file is never
+  // loaded.
+  const string tmp_path = path + kTmpInfix;
+  unique_ptr<RWFile> file;
+  RWFileOptions opts;
+  opts.mode = Env::CREATE_OR_OPEN_WITH_TRUNCATE;
+  RETURN_NOT_OK(env->NewRWFile(opts, tmp_path, &file));
+  WritablePBContainerFile writer(shared_ptr<RWFile>(file.release()));
+  BlockCacheEntryPB entry;
+  RETURN_NOT_OK(writer.CreateNew(entry));
+  int64_t saved = 0;
+  for (const auto& key : keys) {
+    // The block may have been evicted since the keys were collected.
+    auto h(cache_->Lookup(key, Cache::NO_EXPECT_IN_CACHE));
+    if (!h) {
+      continue;
+    }
+    CacheKey cache_key(FileId(0), 0);
+    DCHECK_EQ(sizeof(cache_key), key.size());
+    memcpy(&cache_key, key.data(), sizeof(cache_key));
+    entry.set_file_id(cache_key.file_id_);
+    entry.set_offset(cache_key.offset_);
+    entry.set_data(cache_->Value(h).ToString());
+    RETURN_NOT_OK(writer.Append(entry));
+    saved++;
+  }
+  RETURN_NOT_OK(writer.Sync());
+  RETURN_NOT_OK(writer.Close());
+  RETURN_NOT_OK(env->RenameFile(tmp_path, path));
+  *num_saved = saved;
+  return Status::OK();
+}
+
+Status BlockCache::LoadFromFile(Env* env, const string& path,
+                                const std::function<bool(const FileId&)>& file_exists,
+                                int64_t* num_loaded) {
+  unique_ptr<RandomAccessFile> file;
+  RETURN_NOT_OK(env->NewRandomAccessFile(path, &file));
+  ReadablePBContainerFile reader(shared_ptr<RandomAccessFile>(file.release()));
+  RETURN_NOT_OK(reader.Open());
+  int64_t loaded = 0;
+  BlockCacheEntryPB entry;
+  while (true) {
+    Status s = reader.ReadNextPB(&entry);
+    if (s.IsEndOfFile()) {
+      break;
+    }
+    RETURN_NOT_OK_PREPEND(s, Substitute("unable to read saved block cache $0", path));
+    const FileId file_id(entry.file_id());
+    if (!file_exists(file_id)) {
+      continue;
+    }
+    CacheKey key(file_id, entry.offset());
+    BlockCacheHandle handle;
+    if (Lookup(key, Cache::NO_EXPECT_IN_CACHE, &handle)) {
+      continue;
+    }
+    PendingEntry pending = Allocate(key, entry.data().size());
+    if (!pending.valid()) {
+      continue;
+    }
+    memcpy(pending.val_ptr(), entry.data().data(), entry.data().size());
+    Insert(&pending, &handle);
+    loaded++;
+  }
+  RETURN_NOT_OK(reader.Close());
+  *num_loaded = loaded;
+  return Status::OK();
+}
+
 void BlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
   std::unique_ptr<BlockCacheMetrics> metrics(new BlockCacheMetrics(metric_entity));
   cache_->SetMetrics(std::move(metrics));
+  compressed_tier_hits_ = METRIC_block_cache_compressed_tier_hits.Instantiate(metric_entity);
+  compressed_tier_inserts_ =
+      METRIC_block_cache_compressed_tier_inserts.Instantiate(metric_entity);
 }
 
 } // namespace cfile
@@ -18,20 +18,24 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 
 #include "kudu/fs/block_id.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/slice.h"
-
-template <class T> class scoped_refptr;
+#include "kudu/util/status.h"
 
 namespace kudu {
 
+class Counter;
+class Env;
 class MetricEntity;
 
 namespace cfile {
@@ -40,6 +44,13 @@ class BlockCacheHandle;
 
 // Wrapper around kudu::Cache specifically for caching blocks of CFiles.
 // Provides a singleton and LRU cache for CFile blocks.
+//
+// If --block_cache_compressed_capacity_mb is positive, the block cache also
+// has a compressed tier: a separate cache holding the blocks of compressed
+// CFiles as they're stored on disk. Since compressed blocks are several times
+// smaller, this tier keeps many more blocks than the main one, which holds
+// decompressed blocks. A block which is evicted from the main cache but is
+// still in the compressed tier only needs to be decompressed, not read again.
 class BlockCache {
  public:
   // Parse the gflag which configures the block cache. FATALs if the flag is
@@ -117,7 +128,10 @@ class BlockCache {
     return Singleton<BlockCache>::get();
   }
 
-  explicit BlockCache(size_t capacity);
+  // Creates a block cache of 'capacity' bytes, with a compressed tier of
+  // 'compressed_capacity' bytes if it's positive.
+  explicit BlockCache(size_t capacity, size_t compressed_capacity = 0);
+  ~BlockCache();
 
   // Lookup the given block in the cache.
   //
@@ -160,6 +174,45 @@ class BlockCache {
   // entry in the cache.
   void Insert(PendingEntry* entry, BlockCacheHandle* inserted);
 
+  // Compressed tier
+  // --------------------
+  // The compressed tier has the same insertion path as the main cache, but
+  // its entries hold compressed blocks. If there is no compressed tier,
+  // lookups always miss and allocations always fail.
+
+  bool has_compressed_tier() const {
+    return compressed_cache_ != nullptr;
+  }
+
+  // Lookup the compressed form of the given block in the compressed tier.
+  bool LookupCompressed(const CacheKey& key, Cache::CacheBehavior behavior,
+                        BlockCacheHandle* handle);
+
+  // Allocate a new entry of 'block_size' bytes to be inserted into the
+  // compressed tier.
+  PendingEntry AllocateCompressed(const CacheKey& key, size_t block_size);
+
+  // Insert the given compressed block into the compressed tier.
+  void InsertCompressed(PendingEntry* entry, BlockCacheHandle* inserted);
+
+  // Persistence
+  // --------------------
+  // The blocks of the (main) cache can be saved to a file when the server
+  // shuts down, and loaded back when it restarts, so that the cache doesn't
+  // have to be warmed up again by reading the blocks from disk.
+
+  // Saves the blocks in the cache to a new file at 'path', replacing any
+  // existing file. Sets 'num_saved' to the number of saved blocks.
+  Status SaveToFile(Env* env, const std::string& path, int64_t* num_saved);
+
+  // Inserts the blocks saved to the file at 'path' into the cache, skipping
+  // the blocks of the CFiles for which 'file_exists' returns false and the
+  // blocks which are already cached. Sets 'num_loaded' to the number of
+  // inserted blocks.
+  Status LoadFromFile(Env* env, const std::string& path,
+                      const std::function<bool(const FileId&)>& file_exists,
+                      int64_t* num_loaded);
+
  private:
   friend class Singleton<BlockCache>;
   BlockCache();
@@ -167,6 +220,13 @@ class BlockCache {
   DISALLOW_COPY_AND_ASSIGN(BlockCache);
 
   std::unique_ptr<Cache> cache_;
+
+  // Null if there is no compressed tier.
+  std::unique_ptr<Cache> compressed_cache_;
+
+  // Set once StartInstrumentation() is called.
+  scoped_refptr<Counter> compressed_tier_hits_;
+  scoped_refptr<Counter> compressed_tier_inserts_;
 };
 
 // Scoped reference to a block from the block cache.
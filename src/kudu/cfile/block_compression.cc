@@ -80,8 +80,14 @@ Status CompressedBlockBuilder::Compress(const vector<Slice>& data_slices, vector
 
   // Compress
   size_t compressed_size;
-  RETURN_NOT_OK(codec_->Compress(data_slices,
-                                 buffer_.data() + kHeaderLength, &compressed_size));
+  if (dict_.empty()) {
+    RETURN_NOT_OK(codec_->Compress(data_slices,
+                                   buffer_.data() + kHeaderLength, &compressed_size));
+  } else {
+    RETURN_NOT_OK(codec_->CompressWithDictionary(data_slices, dict_,
+                                                 buffer_.data() + kHeaderLength,
+                                                 &compressed_size));
+  }
 
   // If the compression was not effective, then store the uncompressed data, so
   // that at read time we don't need to waste CPU executing the codec.
@@ -109,12 +115,19 @@ Status CompressedBlockBuilder::Compress(const vector<Slice>& data_slices, vector
   return Status::OK();
 }
 
+void CompressedBlockBuilder::SetDictionary(const Slice& dict) {
+  DCHECK(codec_->SupportsDictionary());
+  dict_ = dict;
+}
+
 CompressedBlockDecoder::CompressedBlockDecoder(const CompressionCodec* codec,
                                                int cfile_version,
-                                               const Slice& block_data)
+                                               const Slice& block_data,
+                                               const Slice& dict)
     : codec_(DCHECK_NOTNULL(codec)),
       cfile_version_(cfile_version),
-      data_(block_data) {
+      data_(block_data),
+      dict_(dict) {
 }
 
 Status CompressedBlockDecoder::Init() {
@@ -186,8 +199,10 @@ Status CompressedBlockDecoder::UncompressIntoBuffer(uint8_t* dst) {
     // is simple to implement and at least several times faster than
     // executing a codec, so this optimization is still worthwhile.
     memcpy(dst, compressed.data(), uncompressed_size_);
-  } else {
+  } else if (dict_.empty()) {
     RETURN_NOT_OK(codec_->Uncompress(compressed, dst, uncompressed_size_));
+  } else {
+    RETURN_NOT_OK(codec_->UncompressWithDictionary(compressed, dict_, dst, uncompressed_size_));
   }
 
   return Status::OK();
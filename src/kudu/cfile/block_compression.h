@@ -55,6 +55,10 @@ namespace cfile {
 //    then the block is assumed to be uncompressed, and the codec should
 //    not be executed.
 // <compressed data>
+//
+// In either version, the data may have been compressed using a dictionary
+// shared by several blocks of the file (see the CFile footer). The block
+// header does not record it: the reader must pass the same dictionary.
 
 // Builder for writing compressed blocks.
 // Always writes v2 format.
@@ -76,12 +80,20 @@ class CompressedBlockBuilder {
   Status Compress(const std::vector<Slice>& data_slices,
                   std::vector<Slice>* result);
 
+  // Compress the blocks passed to subsequent calls to Compress() using the
+  // given dictionary. The data referred to by 'dict' must remain valid for
+  // the lifetime of this object.
+  //
+  // REQUIRES: the codec supports dictionaries.
+  void SetDictionary(const Slice& dict);
+
   // See format information above.
   static const size_t kHeaderLength = 4;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(CompressedBlockBuilder);
   const CompressionCodec* codec_;
+  Slice dict_;
   faststring buffer_;
 };
 
@@ -90,9 +102,14 @@ class CompressedBlockBuilder {
 class CompressedBlockDecoder {
  public:
   // 'codec' is expected to remain alive for the lifetime of this object.
+  //
+  // If the block was compressed using a dictionary, it must be passed as
+  // 'dict', and remain valid for the lifetime of this object. Otherwise,
+  // 'dict' should be empty.
   CompressedBlockDecoder(const CompressionCodec* codec,
                          int cfile_version,
-                         const Slice& block_data);
+                         const Slice& block_data,
+                         const Slice& dict);
 
   // Parses and validates the header in the data block.
   // After calling this, the accessors below as well as UncompressIntoBuffer()
@@ -127,6 +144,7 @@ class CompressedBlockDecoder {
   const CompressionCodec* const codec_;
   const int cfile_version_;
   const Slice data_;
+  const Slice dict_;
 
   int uncompressed_size_ = -1;
 };
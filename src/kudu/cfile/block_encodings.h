@@ -48,6 +48,12 @@ class BlockBuilder {
     return Status::OK();
   }
 
+  // Return an estimate of the size of the extra information which
+  // AppendExtraInfo() would append, given the values added so far.
+  virtual size_t EstimateExtraInfoSize() const {
+    return 0;
+  }
+
   // Used by the cfile writer to determine whether the current block is full.
   // A block is full if it its estimated size is larger than the configured
   // WriterOptions' cfile_block_size.
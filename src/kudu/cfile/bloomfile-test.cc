@@ -22,6 +22,7 @@
 #include <memory>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
@@ -44,11 +45,13 @@ DECLARE_double(fp_rate);
 
 DECLARE_int64(benchmark_queries);
 DECLARE_bool(benchmark_should_hit);
+DECLARE_bool(bloomfile_use_block_bloom_filter);
 
 using kudu::fs::CountingReadableBlock;
 using kudu::fs::ReadableBlock;
 using std::shared_ptr;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 namespace cfile {
@@ -85,6 +88,32 @@ class BloomFileTest : public BloomFileTestBase {
     ASSERT_LT(fp_rate, FLAGS_fp_rate + FLAGS_fp_rate * 0.20f)
       << "Should be no more than 1.2x the expected FP rate";
   }
+
+  // Verify that checking sorted keys in a batch gives the same results as
+  // checking them one at a time.
+  void VerifyCheckKeysPresent() {
+    // Every other key was inserted; the others were not.
+    const int kNumKeys = FLAGS_n_keys * 2;
+    vector<uint64_t> key_bufs(kNumKeys);
+    vector<BloomKeyProbe> probes(kNumKeys);
+    vector<const BloomKeyProbe*> probe_ptrs(kNumKeys);
+    for (int i = 0; i < kNumKeys; i++) {
+      key_bufs[i] = BigEndian::FromHost64((static_cast<uint64_t>(i / 2) << kKeyShift) | (i % 2));
+      probes[i] = BloomKeyProbe(Slice(reinterpret_cast<const uint8_t*>(&key_bufs[i]),
+                                      sizeof(uint64_t)));
+      probe_ptrs[i] = &probes[i];
+    }
+    unique_ptr<bool[]> present(new bool[kNumKeys]);
+    ASSERT_OK(bfr()->CheckKeysPresent(probe_ptrs.data(), kNumKeys, nullptr, present.get()));
+    for (int i = 0; i < kNumKeys; i++) {
+      bool expected;
+      ASSERT_OK(bfr()->CheckKeyPresent(probes[i], nullptr, &expected));
+      ASSERT_EQ(expected, present[i]) << i;
+      if (i % 2 == 0) {
+        ASSERT_TRUE(present[i]) << i;
+      }
+    }
+  }
 };
 
 
@@ -94,6 +123,22 @@ TEST_F(BloomFileTest, TestWriteAndRead) {
   VerifyBloomFile();
 }
 
+// Test that checking sorted keys in a batch gives the same results as
+// checking them one at a time.
+TEST_F(BloomFileTest, TestCheckKeysPresent) {
+  NO_FATALS(WriteTestBloomFile());
+  ASSERT_OK(OpenBloomFile());
+  NO_FATALS(VerifyCheckKeysPresent());
+}
+
+TEST_F(BloomFileTest, TestBlockBloomFilter) {
+  FLAGS_bloomfile_use_block_bloom_filter = true;
+  NO_FATALS(WriteTestBloomFile());
+  ASSERT_OK(OpenBloomFile());
+  NO_FATALS(VerifyBloomFile());
+  NO_FATALS(VerifyCheckKeysPresent());
+}
+
 #ifdef NDEBUG
 TEST_F(BloomFileTest, Benchmark) {
   NO_FATALS(WriteTestBloomFile());
@@ -33,6 +33,8 @@
 
 namespace kudu {
 
+class BlockBloomFilter;
+
 namespace fs {
 class BlockCreationTransaction;
 struct IOContext;
@@ -42,15 +44,27 @@ class WritableBlock;
 
 namespace cfile {
 
+class BlockHandle;
+class BlockPointer;
 class BloomBlockHeaderPB;
 struct ReaderOptions;
 
+// Writer for a bloom file.
+//
+// The keys are added to a sequence of bloom filters, each of which is written
+// as a block of the file once it holds the number of keys it's sized for. If
+// --bloomfile_use_block_bloom_filter is set, the blocks hold cache-line
+// blocked BlockBloomFilters rather than BloomFilters.
 class BloomFileWriter {
  public:
   BloomFileWriter(std::unique_ptr<fs::WritableBlock> block,
                   const BloomFilterSizing &sizing);
+  ~BloomFileWriter();
 
   Status Start();
+
+  // Add the 'n_keys' given keys, which must be sorted, to the file. Adding
+  // many keys at once is cheaper than adding them one at a time.
   Status AppendKeys(const Slice *keys, size_t n_keys);
 
   // Close the bloom's CFile, closing the underlying writable block.
@@ -70,7 +84,17 @@ class BloomFileWriter {
 
   std::unique_ptr<cfile::CFileWriter> writer_;
 
-  BloomFilterBuilder bloom_builder_;
+  // The bloom filter of the current block: exactly one of these is set.
+  std::unique_ptr<BloomFilterBuilder> bloom_builder_;
+  std::unique_ptr<BlockBloomFilter> block_bloom_;
+
+  // The log2 of the size of the block bloom filters, in bytes.
+  int block_bloom_log_space_bytes_;
+
+  // The number of keys in the current block, and the number of keys a block
+  // is finished at.
+  size_t count_;
+  size_t max_count_;
 
   // first key inserted in the current block.
   faststring first_key_;
@@ -117,6 +141,17 @@ class BloomFileReader {
                          const fs::IOContext* io_context,
                          bool* maybe_present);
 
+  // Check if each of the 'n' given keys, which must be sorted, may be
+  // present in the file, setting 'maybe_present[i]' like CheckKeyPresent()
+  // for 'probes[i]'.
+  //
+  // The keys which fall into the same bloom block are checked together, and
+  // their bits are prefetched before any of them is tested.
+  Status CheckKeysPresent(const BloomKeyProbe* const* probes,
+                          size_t n,
+                          const fs::IOContext* io_context,
+                          bool* maybe_present);
+
   // Can be called before Init().
   uint64_t FileSize() const {
     return reader_->file_size();
@@ -136,6 +171,14 @@ class BloomFileReader {
                           BloomBlockHeaderPB* hdr,
                           Slice* bloom_data) const;
 
+  // Read the bloom block pointed to by 'ptr' into 'handle', returning its
+  // parsed header in 'hdr' and its filter data in 'bloom_data'.
+  Status ReadBloomBlock(const fs::IOContext* io_context,
+                        const BlockPointer& ptr,
+                        BlockHandle* handle,
+                        BloomBlockHeaderPB* hdr,
+                        Slice* bloom_data);
+
   // Callback used in 'init_once_' to initialize this bloom file.
   Status InitOnce(const fs::IOContext* io_context);
 
@@ -92,6 +92,7 @@ void BShufBlockBuilder<UINT32>::Finish(rowid_t ordinal_pos, vector<Slice>* slice
 // Template specialization for UINT32.
 template<>
 Status BShufBlockDecoder<UINT32>::SeekAtOrAfterValue(const void* value_void, bool* exact) {
+  RETURN_NOT_OK(ExpandIfNeeded());
   uint32_t target = *reinterpret_cast<const uint32_t*>(value_void);
   int32_t left = 0;
   int32_t right = num_elems_;
@@ -137,7 +138,8 @@ Status BShufBlockDecoder<UINT32>::SeekAtOrAfterValue(const void* value_void, boo
 
 // Template specialization for UINT32, expand blocks of UINT8 or UINT16 to UINT32.
 template<>
-Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* array) {
+Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* array,
+                                                       size_t capacity) {
   DCHECK(parsed_);
   if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
     *n = 0;
@@ -146,7 +148,7 @@ Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* arra
 
   // First, copy it to the destination array without any "expansion".
   size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
-  memcpy(array, &decoded_[cur_idx_ * size_of_elem_], max_fetch * size_of_elem_);
+  RETURN_NOT_OK(CopyElements(max_fetch, array, capacity));
 
   *n = max_fetch;
   cur_idx_ += max_fetch;
@@ -36,8 +36,11 @@
 #include "kudu/cfile/bitshuffle_arch_wrapper.h"
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
@@ -238,7 +241,8 @@ class BShufBlockDecoder final : public BlockDecoder {
         compressed_size_(0),
         num_elems_after_padding_(0),
         size_of_elem_(0),
-        cur_idx_(0) {
+        cur_idx_(0),
+        expanded_(false) {
   }
 
   Status ParseHeader() OVERRIDE {
@@ -282,8 +286,9 @@ class BShufBlockDecoder final : public BlockDecoder {
                                                     size_of_elem_, size_of_type));
     }
 
-    RETURN_NOT_OK(Expand());
-
+    // The block is only unshuffled once its values are needed, so that it
+    // can be unshuffled straight into the destination if the first read
+    // covers the whole block.
     parsed_ = true;
     return Status::OK();
   }
@@ -300,6 +305,7 @@ class BShufBlockDecoder final : public BlockDecoder {
   }
 
   Status SeekAtOrAfterValue(const void* value_void, bool* exact) OVERRIDE {
+    RETURN_NOT_OK(ExpandIfNeeded());
     CppType target = UnalignedLoad<CppType>(value_void);
     int32_t left = 0;
     int32_t right = num_elems_;
@@ -328,7 +334,20 @@ class BShufBlockDecoder final : public BlockDecoder {
 
   Status CopyNextValues(size_t* n, ColumnDataView* dst) OVERRIDE {
     DCHECK_EQ(dst->stride(), sizeof(CppType));
-    return CopyNextValuesToArray(n, dst->data());
+    return CopyNextValuesToArray(n, dst->data(), dst->nrows());
+  }
+
+  // The whole block is unshuffled by ParseHeader(), so the values are copied
+  // out and the predicate is evaluated on them while they're still hot in the
+  // cache, rather than in a separate pass over the materialized column.
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override {
+    ctx->SetDecoderEvalSupported();
+    RETURN_NOT_OK(CopyNextValues(n, dst));
+    ctx->pred()->EvaluateNonNullCells<Type>(dst->data(), *n, sel);
+    return Status::OK();
   }
 
   // Copy the codewords to a temporary buffer.
@@ -337,19 +356,7 @@ class BShufBlockDecoder final : public BlockDecoder {
   // instead of CopyNextValues(), we do not need to create ColumnDataView and ColumnBlock
   // object to wrap around the uint8_t pointer.
   Status CopyNextValuesToArray(size_t* n, uint8_t* array) {
-    DCHECK(parsed_);
-    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
-      *n = 0;
-      return Status::OK();
-    }
-
-    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
-    memcpy(array, &decoded_[cur_idx_ * size_of_type], max_fetch * size_of_type);
-
-    *n = max_fetch;
-    cur_idx_ += max_fetch;
-
-    return Status::OK();
+    return CopyNextValuesToArray(n, array, *n);
   }
 
   size_t GetCurrentIndex() const OVERRIDE {
@@ -370,6 +377,40 @@ class BShufBlockDecoder final : public BlockDecoder {
   }
 
  private:
+  // Same as above, but 'array' has room for 'capacity' values, which may be
+  // more than '*n'. The values past the copied ones may be overwritten.
+  Status CopyNextValuesToArray(size_t* n, uint8_t* array, size_t capacity) {
+    DCHECK(parsed_);
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    RETURN_NOT_OK(CopyElements(max_fetch, array, capacity));
+
+    *n = max_fetch;
+    cur_idx_ += max_fetch;
+
+    return Status::OK();
+  }
+
+  // Copies the 'count' elements of 'size_of_elem_' bytes at the current
+  // position into 'array', which has room for 'capacity' values.
+  //
+  // If these are all of the elements of a block which hasn't been unshuffled
+  // yet, and 'array' can also hold the padding, the block is unshuffled
+  // straight into 'array' rather than into 'decoded_' and then copied.
+  Status CopyElements(size_t count, uint8_t* array, size_t capacity) {
+    if (!expanded_ && cur_idx_ == 0 && count == num_elems_ &&
+        capacity >= num_elems_after_padding_) {
+      return Unshuffle(array);
+    }
+    RETURN_NOT_OK(ExpandIfNeeded());
+    memcpy(array, &decoded_[cur_idx_ * size_of_elem_], count * size_of_elem_);
+    return Status::OK();
+  }
+
   template<typename T>
   static T Decode(const uint8_t* ptr) {
     T result;
@@ -377,13 +418,25 @@ class BShufBlockDecoder final : public BlockDecoder {
     return result;
   }
 
-  Status Expand() {
+  // Unshuffles the block into 'decoded_', unless already done.
+  Status ExpandIfNeeded() {
+    DCHECK(parsed_);
+    if (PREDICT_TRUE(expanded_)) {
+      return Status::OK();
+    }
+    decoded_.resize(num_elems_after_padding_ * size_of_elem_);
+    RETURN_NOT_OK(Unshuffle(decoded_.data()));
+    expanded_ = true;
+    return Status::OK();
+  }
+
+  // Unshuffles the block into 'out', which must have room for
+  // 'num_elems_after_padding_' elements.
+  Status Unshuffle(uint8_t* out) {
     if (num_elems_ > 0) {
-      int64_t bytes;
-      decoded_.resize(num_elems_after_padding_ * size_of_elem_);
       uint8_t* in = const_cast<uint8_t*>(&data_[kHeaderSize]);
-      bytes = bitshuffle::decompress_lz4(in, decoded_.data(), num_elems_after_padding_,
-                                         size_of_elem_, 0);
+      int64_t bytes = bitshuffle::decompress_lz4(in, out, num_elems_after_padding_,
+                                                 size_of_elem_, 0);
       if (PREDICT_FALSE(bytes < 0)) {
         // Ideally, this should not happen.
         AbortWithBitShuffleError(bytes);
@@ -414,13 +467,17 @@ class BShufBlockDecoder final : public BlockDecoder {
   int size_of_elem_;
 
   size_t cur_idx_;
+
+  // The unshuffled block, once 'expanded_' is set.
   faststring decoded_;
+  bool expanded_;
 };
 
 template<>
 Status BShufBlockDecoder<UINT32>::SeekAtOrAfterValue(const void* value_void, bool* exact);
 template<>
-Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* array);
+Status BShufBlockDecoder<UINT32>::CopyNextValuesToArray(size_t* n, uint8_t* array,
+                                                       size_t capacity);
 
 
 } // namespace cfile
@@ -0,0 +1,375 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks the throughput of writing, scanning, seeking in and evaluating
+// predicates on CFiles for every supported combination of data type,
+// encoding and compression codec, on data of several distributions.
+//
+// Besides being logged, the results may be appended to a file as one JSON
+// object per line with --encoding_bench_results_file, so that they can be
+// compared across builds to track regressions.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/cfile/cfile-test-base.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/cfile/cfile_writer.h"
+#include "kudu/cfile/type_encodings.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/int128.h"
+#include "kudu/util/jsonwriter.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/random.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DEFINE_int32(encoding_bench_num_rows, 100000,
+             "Number of values written to the file of each combination.");
+DEFINE_int32(encoding_bench_num_seeks, 1000,
+             "Number of random seeks run on the file of each combination.");
+DEFINE_string(encoding_bench_results_file, "",
+              "If set, the results of each combination are appended to this "
+              "file as a JSON object per line.");
+
+using kudu::fs::ReadableBlock;
+using kudu::fs::WritableBlock;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// Number of rows appended to or read from a file at a time.
+const size_t kBatchSize = 1000;
+
+// The distributions of the generated values.
+enum class Distribution {
+  // Consecutive values, like those of identifiers or timestamps.
+  SEQUENTIAL,
+  // Uniformly random values.
+  RANDOM,
+  // Values drawn from a set of 16 random values.
+  LOW_CARDINALITY,
+  // Runs of 1 to 128 repetitions of random values, like those of columns
+  // clustered by another column.
+  RUNS
+};
+
+const char* DistributionToString(Distribution dist) {
+  switch (dist) {
+    case Distribution::SEQUENTIAL: return "SEQUENTIAL";
+    case Distribution::RANDOM: return "RANDOM";
+    case Distribution::LOW_CARDINALITY: return "LOW_CARDINALITY";
+    case Distribution::RUNS: return "RUNS";
+  }
+  return "UNKNOWN";
+}
+
+// Converts the generated integer 'v' to a cell value, storing the data of
+// binary values in 'storage', whose capacity must not be exceeded.
+template<typename T>
+T MakeValue(int64_t v, vector<string>* /*storage*/) {
+  return static_cast<T>(v);
+}
+
+template<>
+float MakeValue<float>(int64_t v, vector<string>* /*storage*/) {
+  return static_cast<float>(v) / 100;
+}
+
+template<>
+double MakeValue<double>(int64_t v, vector<string>* /*storage*/) {
+  return static_cast<double>(v) / 100;
+}
+
+template<>
+Slice MakeValue<Slice>(int64_t v, vector<string>* storage) {
+  DCHECK_LT(storage->size(), storage->capacity());
+  storage->emplace_back(StringPrintf("%016" PRIx64, v));
+  return Slice(storage->back());
+}
+
+// The results of the benchmark of a combination.
+struct BenchResult {
+  double bytes_per_row;
+  double encode_rows_per_sec;
+  double decode_rows_per_sec;
+  double seeks_per_sec;
+  double predicate_rows_per_sec;
+  double selectivity;
+};
+
+double PerSec(size_t n, const MonoDelta& elapsed) {
+  return n / std::max(elapsed.ToSeconds(), 1e-9);
+}
+
+} // anonymous namespace
+
+class CFileEncodingBench : public CFileTestBase {
+ protected:
+  template<DataType TYPE>
+  void RunBenchmarks() {
+    const TypeInfo* type_info = GetTypeInfo(TYPE);
+    for (Distribution dist : { Distribution::SEQUENTIAL, Distribution::RANDOM,
+                               Distribution::LOW_CARDINALITY, Distribution::RUNS }) {
+      typedef typename DataTypeTraits<TYPE>::cpp_type cpp_type;
+      vector<string> storage;
+      storage.reserve(FLAGS_encoding_bench_num_rows);
+      vector<cpp_type> values;
+      NO_FATALS(GenerateValues<TYPE>(dist, &values, &storage));
+
+      for (EncodingType encoding : TypeEncodingInfo::GetSupportedEncodings(type_info)) {
+        for (CompressionType codec : { NO_COMPRESSION, SNAPPY, LZ4, ZLIB }) {
+          BenchResult result;
+          NO_FATALS(BenchCombination<TYPE>(values, encoding, codec, &result));
+          NO_FATALS(ReportResult(TYPE, encoding, codec, dist, result));
+        }
+      }
+    }
+  }
+
+ private:
+  template<DataType TYPE>
+  void GenerateValues(Distribution dist,
+                      vector<typename DataTypeTraits<TYPE>::cpp_type>* values,
+                      vector<string>* storage) {
+    typedef typename DataTypeTraits<TYPE>::cpp_type cpp_type;
+    Random rng(SeedRandom());
+    vector<int64_t> dict(16);
+    for (auto& v : dict) {
+      v = rng.Next64();
+    }
+    int64_t run_value = 0;
+    int run_left = 0;
+    values->reserve(FLAGS_encoding_bench_num_rows);
+    for (int i = 0; i < FLAGS_encoding_bench_num_rows; i++) {
+      int64_t v = 0;
+      switch (dist) {
+        case Distribution::SEQUENTIAL:
+          v = i;
+          break;
+        case Distribution::RANDOM:
+          v = rng.Next64();
+          break;
+        case Distribution::LOW_CARDINALITY:
+          v = dict[rng.Uniform(dict.size())];
+          break;
+        case Distribution::RUNS:
+          if (run_left == 0) {
+            run_value = rng.Next64();
+            run_left = 1 + rng.Uniform(128);
+          }
+          run_left--;
+          v = run_value;
+          break;
+      }
+      values->push_back(MakeValue<cpp_type>(v, storage));
+    }
+  }
+
+  template<DataType TYPE>
+  void BenchCombination(const vector<typename DataTypeTraits<TYPE>::cpp_type>& values,
+                        EncodingType encoding,
+                        CompressionType codec,
+                        BenchResult* result) {
+    typedef typename DataTypeTraits<TYPE>::cpp_type cpp_type;
+    const size_t num_rows = values.size();
+
+    // Encode the values into a new file.
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    const BlockId block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.storage_attributes.encoding = encoding;
+    opts.storage_attributes.compression = codec;
+    MonoTime start = MonoTime::Now();
+    {
+      CFileWriter w(opts, GetTypeInfo(TYPE), false, std::move(sink));
+      ASSERT_OK(w.Start());
+      for (size_t i = 0; i < num_rows; i += kBatchSize) {
+        ASSERT_OK_FAST(w.AppendEntries(&values[i], std::min(kBatchSize, num_rows - i)));
+      }
+      ASSERT_OK(w.Finish());
+    }
+    result->encode_rows_per_sec = PerSec(num_rows, MonoTime::Now() - start);
+
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    result->bytes_per_row = static_cast<double>(reader->file_size()) / num_rows;
+
+    // Blocks aren't cached, so that every read decompresses and decodes them.
+    unique_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::DONT_CACHE_BLOCK, nullptr));
+    ScopedColumnBlock<TYPE> cb(kBatchSize, /*allow_nulls=*/false);
+    SelectionVector sel(kBatchSize);
+
+    // Decode all the values.
+    {
+      ColumnMaterializationContext ctx(0, nullptr, &cb, &sel);
+      ctx.SetDecoderEvalNotSupported();
+      start = MonoTime::Now();
+      ASSERT_OK(iter->SeekToOrdinal(0));
+      while (iter->HasNext()) {
+        size_t n = kBatchSize;
+        ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+        cb.arena()->Reset();
+      }
+      result->decode_rows_per_sec = PerSec(num_rows, MonoTime::Now() - start);
+    }
+
+    // Seek to random rows and read them.
+    {
+      ColumnMaterializationContext ctx(0, nullptr, &cb, &sel);
+      ctx.SetDecoderEvalNotSupported();
+      Random rng(SeedRandom());
+      start = MonoTime::Now();
+      for (int i = 0; i < FLAGS_encoding_bench_num_seeks; i++) {
+        ASSERT_OK_FAST(iter->SeekToOrdinal(rng.Uniform(num_rows)));
+        size_t n = 1;
+        ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+        cb.arena()->Reset();
+      }
+      result->seeks_per_sec = PerSec(FLAGS_encoding_bench_num_seeks, MonoTime::Now() - start);
+    }
+
+    // Evaluate a range predicate selecting about a tenth of the values,
+    // within the decoders when they support it.
+    {
+      const TypeInfo* type_info = GetTypeInfo(TYPE);
+      vector<cpp_type> sorted(values);
+      std::sort(sorted.begin(), sorted.end(), [&](const cpp_type& a, const cpp_type& b) {
+        return type_info->Compare(&a, &b) < 0;
+      });
+      const cpp_type lower = sorted[num_rows * 45 / 100];
+      const cpp_type upper = sorted[num_rows * 55 / 100];
+      const ColumnSchema col("c", TYPE);
+      const ColumnPredicate pred = type_info->Compare(&lower, &upper) == 0 ?
+          ColumnPredicate::Equality(col, &lower) : ColumnPredicate::Range(col, &lower, &upper);
+      ColumnMaterializationContext ctx(0, &pred, &cb, &sel);
+      size_t num_selected = 0;
+      start = MonoTime::Now();
+      ASSERT_OK(iter->SeekToOrdinal(0));
+      while (iter->HasNext()) {
+        size_t n = kBatchSize;
+        sel.SetAllTrue();
+        ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+        if (ctx.DecoderEvalNotSupported()) {
+          pred.Evaluate(cb, &sel);
+        }
+        sel.ClearToSelectAtMost(n);
+        num_selected += sel.CountSelected();
+        cb.arena()->Reset();
+      }
+      result->predicate_rows_per_sec = PerSec(num_rows, MonoTime::Now() - start);
+      result->selectivity = static_cast<double>(num_selected) / num_rows;
+    }
+  }
+
+  void ReportResult(DataType type, EncodingType encoding, CompressionType codec,
+                    Distribution dist, const BenchResult& result) {
+    LOG(INFO) << Substitute(
+        "$0 $1 $2 $3: $4 bytes/row, encode $5 Mrows/s, decode $6 Mrows/s, "
+        "$7 seeks/s, predicate $8 Mrows/s ($9 selected)",
+        DataType_Name(type), EncodingType_Name(encoding), CompressionType_Name(codec),
+        DistributionToString(dist), StringPrintf("%.2f", result.bytes_per_row),
+        StringPrintf("%.1f", result.encode_rows_per_sec / 1e6),
+        StringPrintf("%.1f", result.decode_rows_per_sec / 1e6),
+        StringPrintf("%.0f", result.seeks_per_sec),
+        StringPrintf("%.1f", result.predicate_rows_per_sec / 1e6),
+        StringPrintf("%.3f", result.selectivity));
+
+    if (FLAGS_encoding_bench_results_file.empty()) {
+      return;
+    }
+    std::ostringstream json;
+    JsonWriter jw(&json, JsonWriter::COMPACT);
+    jw.StartObject();
+    jw.String("type");
+    jw.String(DataType_Name(type));
+    jw.String("encoding");
+    jw.String(EncodingType_Name(encoding));
+    jw.String("compression");
+    jw.String(CompressionType_Name(codec));
+    jw.String("distribution");
+    jw.String(DistributionToString(dist));
+    jw.String("num_rows");
+    jw.Int(FLAGS_encoding_bench_num_rows);
+    jw.String("bytes_per_row");
+    jw.Double(result.bytes_per_row);
+    jw.String("encode_rows_per_sec");
+    jw.Double(result.encode_rows_per_sec);
+    jw.String("decode_rows_per_sec");
+    jw.Double(result.decode_rows_per_sec);
+    jw.String("seeks_per_sec");
+    jw.Double(result.seeks_per_sec);
+    jw.String("predicate_rows_per_sec");
+    jw.Double(result.predicate_rows_per_sec);
+    jw.String("selectivity");
+    jw.Double(result.selectivity);
+    jw.EndObject();
+    std::ofstream out(FLAGS_encoding_bench_results_file, std::ios::app);
+    out << json.str() << std::endl;
+    ASSERT_TRUE(out.good()) << "unable to write to " << FLAGS_encoding_bench_results_file;
+  }
+};
+
+TEST_F(CFileEncodingBench, Int8) { NO_FATALS(RunBenchmarks<INT8>()); }
+TEST_F(CFileEncodingBench, Int16) { NO_FATALS(RunBenchmarks<INT16>()); }
+TEST_F(CFileEncodingBench, Int32) { NO_FATALS(RunBenchmarks<INT32>()); }
+TEST_F(CFileEncodingBench, Int64) { NO_FATALS(RunBenchmarks<INT64>()); }
+TEST_F(CFileEncodingBench, Int128) { NO_FATALS(RunBenchmarks<INT128>()); }
+TEST_F(CFileEncodingBench, Float) { NO_FATALS(RunBenchmarks<FLOAT>()); }
+TEST_F(CFileEncodingBench, Double) { NO_FATALS(RunBenchmarks<DOUBLE>()); }
+TEST_F(CFileEncodingBench, String) { NO_FATALS(RunBenchmarks<STRING>()); }
+TEST_F(CFileEncodingBench, Binary) { NO_FATALS(RunBenchmarks<BINARY>()); }
+
+} // namespace cfile
+} // namespace kudu
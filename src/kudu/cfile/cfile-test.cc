@@ -42,6 +42,7 @@
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
@@ -70,20 +71,29 @@
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/nvm_cache.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(cfile_adaptive_block_size);
+DECLARE_int32(cfile_adaptive_max_block_size);
+DECLARE_int32(cfile_auto_encoding_sample_rows);
+DECLARE_int32(cfile_checksum_threads);
 DECLARE_bool(cfile_write_checksums);
+DECLARE_int32(cfile_compression_dict_sample_blocks);
 DECLARE_bool(cfile_verify_checksums);
+DECLARE_int32(cfile_uncached_readahead_blocks);
 DECLARE_string(block_cache_type);
 DECLARE_bool(force_block_cache_capacity);
 DECLARE_int64(block_cache_capacity_mb);
+DECLARE_int64(block_cache_compressed_capacity_mb);
 DECLARE_string(nvm_cache_path);
 DECLARE_bool(nvm_cache_simulate_allocation_failure);
 
+METRIC_DECLARE_counter(block_cache_compressed_tier_hits);
 METRIC_DECLARE_counter(block_cache_hits_caching);
 
 METRIC_DECLARE_entity(server);
@@ -254,6 +264,59 @@ class TestCFile : public CFileTestBase {
     TimeSeekAndReadFileWithNulls(generator, block_id, n);
   }
 
+  // Test reading only the selected rows of a file: the cells of the rows
+  // which are selected must be the same as when reading every row.
+  template <class DataGeneratorType>
+  void TestMaterializeSelectedRowsOnly(DataGeneratorType* generator, EncodingType encoding) {
+    const int kNumEntries = 10000;
+    BlockId block_id;
+    WriteTestFile(generator, encoding, NO_COMPRESSION, kNumEntries, SMALL_BLOCKSIZE, &block_id);
+
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    unique_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+
+    // Select long runs of rows, with a few rows scattered in between, so that
+    // both whole blocks and parts of blocks are skipped.
+    const auto is_selected = [](size_t idx) {
+      return (idx / 700) % 3 == 0 || idx % 97 == 0;
+    };
+    const size_t kBatchSize = 1000;
+    ScopedColumnBlock<DataGeneratorType::kDataType> cb(kBatchSize);
+    SelectionVector sel(kBatchSize);
+    size_t read_offset = 0;
+    while (iter->HasNext()) {
+      size_t n = kBatchSize;
+      for (size_t j = 0; j < n; j++) {
+        BitmapChange(sel.mutable_bitmap(), j, is_selected(read_offset + j));
+      }
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&cb, &sel);
+      ctx.SetMaterializeSelectedRowsOnly();
+      ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+
+      generator->Build(read_offset, n);
+      for (size_t j = 0; j < n; j++) {
+        SCOPED_TRACE(read_offset + j);
+        ASSERT_EQ(is_selected(read_offset + j), sel.IsRowSelected(j));
+        if (!sel.IsRowSelected(j)) {
+          continue;
+        }
+        bool expected_null = generator->TestValueShouldBeNull(read_offset + j);
+        ASSERT_EQ(expected_null, cb.is_null(j));
+        if (!expected_null) {
+          ASSERT_EQ((*generator)[j], cb[j]);
+        }
+      }
+      cb.arena()->Reset();
+      read_offset += n;
+    }
+    ASSERT_EQ(kNumEntries, read_offset);
+  }
+
   void TestReadWriteRawBlocks(CompressionType compression, int num_entries) {
     // Test Write
     unique_ptr<WritableBlock> sink;
@@ -536,28 +599,28 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestWrite1MLowCardinalityStringsDictEncodi
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteUInt32) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, DICT_ENCODING }) {
     TestReadWriteFixedSizeTypes<UInt32DataGenerator<false>>(enc);
   }
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteInt32) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, DICT_ENCODING }) {
     TestReadWriteFixedSizeTypes<Int32DataGenerator<false>>(enc);
   }
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteUInt64) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE, DICT_ENCODING }) {
     TestReadWriteFixedSizeTypes<UInt64DataGenerator<false>>(enc);
   }
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestReadWriteInt64) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
-  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE }) {
+  for (auto enc : { PLAIN_ENCODING, RLE, BIT_SHUFFLE, DICT_ENCODING }) {
     TestReadWriteFixedSizeTypes<Int64DataGenerator<false>>(enc);
   }
 }
@@ -576,6 +639,12 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestFixedSizeReadWritePlainEncodingDouble)
   TestReadWriteFixedSizeTypes<FPDataGenerator<DOUBLE, false>>(PLAIN_ENCODING);
 }
 
+TEST_P(TestCFileBothCacheMemoryTypes, TestFixedSizeReadWriteDictEncodingFP) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  TestReadWriteFixedSizeTypes<FPDataGenerator<FLOAT, false>>(DICT_ENCODING);
+  TestReadWriteFixedSizeTypes<FPDataGenerator<DOUBLE, false>>(DICT_ENCODING);
+}
+
 // Test for BitShuffle builder for UINT8, INT8, UINT16, INT16, UINT32, INT32,
 // UINT64, INT64, INT128, FLOAT, DOUBLE
 template <typename T>
@@ -858,6 +927,51 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestDefaultColumnIter) {
   }
 }
 
+// Test that the default values fill the whole block for batch sizes which
+// aren't powers of two, and for batches larger than the first doubling copies.
+TEST_P(TestCFileBothCacheMemoryTypes, TestDefaultColumnIterBatchSizes) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+
+  for (int num_items : { 1, 2, 3, 7, 63, 64, 65, 1000, 1023, 4097 }) {
+    SCOPED_TRACE(num_items);
+    vector<uint8_t> non_null_bitmap(BitmapSize(num_items));
+    SelectionVector sel(num_items);
+
+    // Fixed-width default, with and without a null bitmap.
+    vector<uint64_t> data(num_items);
+    uint64_t int_value = 0x0123456789abcdefULL;
+    for (uint8_t* bitmap : { static_cast<uint8_t*>(nullptr), non_null_bitmap.data() }) {
+      DefaultColumnValueIterator iter(GetTypeInfo(UINT64), &int_value);
+      ColumnBlock col(GetTypeInfo(UINT64), bitmap, data.data(), num_items, nullptr);
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&col, &sel);
+      ASSERT_OK(iter.Scan(&ctx));
+      for (size_t i = 0; i < col.nrows(); ++i) {
+        if (bitmap) {
+          ASSERT_FALSE(col.is_null(i));
+        }
+        ASSERT_EQ(int_value, *reinterpret_cast<const uint64_t*>(col.cell_ptr(i)));
+      }
+    }
+
+    // BINARY default, with and without a null bitmap.
+    vector<Slice> str_data(num_items);
+    Slice str_value("a default value which is copied into the arena");
+    for (uint8_t* bitmap : { static_cast<uint8_t*>(nullptr), non_null_bitmap.data() }) {
+      Arena arena(1024);
+      DefaultColumnValueIterator iter(GetTypeInfo(STRING), &str_value);
+      ColumnBlock col(GetTypeInfo(STRING), bitmap, str_data.data(), num_items, &arena);
+      ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&col, &sel);
+      ASSERT_OK(iter.Scan(&ctx));
+      for (size_t i = 0; i < col.nrows(); ++i) {
+        if (bitmap) {
+          ASSERT_FALSE(col.is_null(i));
+        }
+        ASSERT_EQ(str_value, *reinterpret_cast<const Slice*>(col.cell_ptr(i)));
+      }
+    }
+  }
+}
+
 TEST_P(TestCFileBothCacheMemoryTypes, TestAppendRaw) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
   TestReadWriteRawBlocks(NO_COMPRESSION, 1000);
@@ -926,6 +1040,8 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestNullInts) {
   TestNullTypes(&generator, BIT_SHUFFLE, LZ4);
   TestNullTypes(&generator, RLE, NO_COMPRESSION);
   TestNullTypes(&generator, RLE, LZ4);
+  TestNullTypes(&generator, DICT_ENCODING, NO_COMPRESSION);
+  TestNullTypes(&generator, DICT_ENCODING, LZ4);
 }
 
 TEST_P(TestCFileBothCacheMemoryTypes, TestNullFloats) {
@@ -961,6 +1077,23 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestNullDictStrings) {
   TestNullTypes(&generator, DICT_ENCODING, LZ4);
 }
 
+TEST_P(TestCFileBothCacheMemoryTypes, TestMaterializeSelectedRowsOnly) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+
+  for (auto encoding : { PLAIN_ENCODING, BIT_SHUFFLE, RLE }) {
+    SCOPED_TRACE(encoding);
+    UInt32DataGenerator<true> nullable_generator;
+    TestMaterializeSelectedRowsOnly(&nullable_generator, encoding);
+    UInt32DataGenerator<false> generator;
+    TestMaterializeSelectedRowsOnly(&generator, encoding);
+  }
+  for (auto encoding : { PLAIN_ENCODING, PREFIX_ENCODING, DICT_ENCODING }) {
+    SCOPED_TRACE(encoding);
+    StringDataGenerator<true> generator("hello %zu");
+    TestMaterializeSelectedRowsOnly(&generator, encoding);
+  }
+}
+
 TEST_P(TestCFileBothCacheMemoryTypes, TestReleaseBlock) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
 
@@ -976,6 +1109,185 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestReleaseBlock) {
   ASSERT_OK(transaction->CommitCreatedBlocks());
 }
 
+TEST_P(TestCFileBothCacheMemoryTypes, TestZoneMaps) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+
+  // Write increasing values, with a run of nulls in the middle.
+  const int kNumRows = 4000;
+  const int kFirstNull = 1000;
+  const int kLastNull = 1999;
+  vector<int32_t> values(kNumRows);
+  unique_ptr<uint8_t[]> non_null_bitmap(new uint8_t[BitmapSize(kNumRows)]);
+  for (int i = 0; i < kNumRows; i++) {
+    values[i] = i;
+    BitmapChange(non_null_bitmap.get(), i, i < kFirstNull || i > kLastNull);
+  }
+
+  BlockId block_id;
+  for (bool write_zone_maps : { false, true }) {
+    unique_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+    block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.write_zone_maps = write_zone_maps;
+    opts.storage_attributes.cfile_block_size = 1024;
+    opts.storage_attributes.encoding = BIT_SHUFFLE;
+    CFileWriter w(opts, GetTypeInfo(INT32), true, std::move(sink));
+    ASSERT_OK(w.Start());
+    ASSERT_OK(w.AppendNullableEntries(non_null_bitmap.get(), values.data(), kNumRows));
+    ASSERT_OK(w.Finish());
+
+    unique_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    ASSERT_EQ(write_zone_maps, reader->has_zone_maps());
+  }
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  unique_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+
+  ColumnSchema col("c", INT32, true);
+  auto may_match = [&](rowid_t start, size_t nrows, const ColumnPredicate& pred) {
+    bool ret;
+    CHECK_OK(iter->MayHaveMatches(start, nrows, pred, &ret));
+    return ret;
+  };
+
+  int32_t lower = 500;
+  int32_t upper = 600;
+  ColumnPredicate range = ColumnPredicate::Range(col, &lower, &upper);
+  ASSERT_FALSE(may_match(0, 100, range));
+  ASSERT_TRUE(may_match(450, 100, range));
+  ASSERT_FALSE(may_match(kNumRows - 100, 100, range));
+
+  int32_t past_end = kNumRows;
+  ColumnPredicate eq_past_end = ColumnPredicate::Equality(col, &past_end);
+  ASSERT_FALSE(may_match(0, kNumRows, eq_past_end));
+  // Rows past the end of the file aren't covered by any statistics.
+  ASSERT_TRUE(may_match(0, kNumRows + 1, eq_past_end));
+
+  ColumnPredicate is_null = ColumnPredicate::IsNull(col);
+  ASSERT_FALSE(may_match(0, 100, is_null));
+  ASSERT_TRUE(may_match(0, kNumRows, is_null));
+  ASSERT_FALSE(may_match(kNumRows - 100, 100, is_null));
+
+  ColumnPredicate is_not_null = ColumnPredicate::IsNotNull(col);
+  ASSERT_TRUE(may_match(0, kNumRows, is_not_null));
+}
+
+// Test that scans which don't cache blocks read correctly while issuing
+// readahead hints, both sequentially and after reseeking backwards.
+TEST_P(TestCFileBothCacheMemoryTypes, TestUncachedReadAhead) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+  FLAGS_cfile_uncached_readahead_blocks = 4;
+
+  const int kNumRows = 20000;
+  vector<int32_t> values(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    values[i] = i;
+  }
+
+  unique_ptr<WritableBlock> sink;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+  BlockId block_id = sink->id();
+  WriterOptions opts;
+  opts.write_posidx = true;
+  opts.storage_attributes.cfile_block_size = 256;
+  opts.storage_attributes.encoding = PLAIN_ENCODING;
+  CFileWriter w(opts, GetTypeInfo(INT32), false, std::move(sink));
+  ASSERT_OK(w.Start());
+  ASSERT_OK(w.AppendEntries(values.data(), kNumRows));
+  ASSERT_OK(w.Finish());
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  unique_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::DONT_CACHE_BLOCK, nullptr));
+
+  ScopedColumnBlock<INT32> cb(1000);
+  SelectionVector sel(cb.nrows());
+  ColumnMaterializationContext ctx = CreateNonDecoderEvalContext(&cb, &sel);
+  for (int start : { 0, kNumRows / 2, 0 }) {
+    SCOPED_TRACE(start);
+    ASSERT_OK(iter->SeekToOrdinal(start));
+    int row = start;
+    while (iter->HasNext()) {
+      size_t n = cb.nrows();
+      ASSERT_OK_FAST(iter->CopyNextValues(&n, &ctx));
+      for (size_t j = 0; j < n; j++) {
+        ASSERT_EQ(static_cast<int32_t>(row + j), cb[j]);
+      }
+      row += n;
+    }
+    ASSERT_EQ(kNumRows, row);
+  }
+}
+
+// Test that low-cardinality numeric columns stay dictionary-coded and that
+// predicates are evaluated against the dictionary.
+TEST_P(TestCFileBothCacheMemoryTypes, TestNumericDictPredicate) {
+  RETURN_IF_NO_NVM_CACHE(GetParam());
+
+  const int kNumRows = 10000;
+  const int kCardinality = 10;
+  vector<int64_t> values(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    values[i] = (i % kCardinality) * 1000000007L;
+  }
+
+  unique_ptr<WritableBlock> sink;
+  ASSERT_OK(fs_manager_->CreateNewBlock({}, &sink));
+  BlockId block_id = sink->id();
+  WriterOptions opts;
+  opts.write_posidx = true;
+  opts.storage_attributes.encoding = DICT_ENCODING;
+  CFileWriter w(opts, GetTypeInfo(INT64), false, std::move(sink));
+  ASSERT_OK(w.Start());
+  ASSERT_OK(w.AppendEntries(values.data(), kNumRows));
+  ASSERT_OK(w.Finish());
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  ASSERT_EQ(DICT_ENCODING, reader->footer().encoding());
+  ASSERT_TRUE(reader->footer().has_dict_block_ptr());
+
+  ColumnSchema col("c", INT64);
+  for (int match : { 3, kCardinality }) {
+    unique_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, nullptr));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+
+    int64_t target = match * 1000000007L;
+    ColumnPredicate pred = ColumnPredicate::Equality(col, &target);
+    ScopedColumnBlock<INT64> out(kNumRows);
+    SelectionVector sel(kNumRows);
+    sel.SetAllTrue();
+    ColumnMaterializationContext ctx(0, &pred, &out, &sel);
+    size_t n = kNumRows;
+    ASSERT_OK(iter->CopyNextValues(&n, &ctx));
+    ASSERT_EQ(kNumRows, n);
+    ASSERT_FALSE(ctx.DecoderEvalNotSupported());
+
+    size_t expected_matches = match < kCardinality ? kNumRows / kCardinality : 0;
+    ASSERT_EQ(expected_matches, sel.CountSelected());
+    for (int i = 0; i < kNumRows; i++) {
+      if (sel.IsRowSelected(i)) {
+        ASSERT_EQ(target, out[i]);
+      }
+    }
+  }
+}
+
 TEST_P(TestCFileBothCacheMemoryTypes, TestLazyInit) {
   RETURN_IF_NO_NVM_CACHE(GetParam());
 
@@ -1100,6 +1412,76 @@ TEST_P(TestCFileBothCacheMemoryTypes, TestValidateBlockCacheCapacity) {
 
 class TestCFileDifferentCodecs : public TestCFile,
                                  public testing::WithParamInterface<CompressionType> {
+ protected:
+  void CountDataBlocks(const BlockId& block_id, size_t* num_blocks) {
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+
+    unique_ptr<IndexTreeIterator> iter;
+    iter.reset(IndexTreeIterator::Create(nullptr, reader.get(), reader->posidx_root()));
+    ASSERT_OK(iter->SeekToFirst());
+    size_t count = 1;
+    while (iter->HasNext()) {
+      ASSERT_OK(iter->Next());
+      count++;
+    }
+    *num_blocks = count;
+  }
+
+  void GetEncoding(const BlockId& block_id, EncodingType* encoding) {
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    *encoding = reader->footer().encoding();
+  }
+
+  // Write a file with AUTO_ENCODING, check its encoding and read it back.
+  template<class DataGeneratorType>
+  void TestAutoEncoding(DataGeneratorType* generator,
+                        const std::function<void(EncodingType)>& check_encoding) {
+    const int kNumRows = 10000;
+    BlockId block_id;
+    WriteTestFile(generator, AUTO_ENCODING, GetParam(), kNumRows, SMALL_BLOCKSIZE, &block_id);
+
+    EncodingType encoding;
+    NO_FATALS(GetEncoding(block_id, &encoding));
+    SCOPED_TRACE(EncodingType_Name(encoding));
+    check_encoding(encoding);
+
+    size_t n;
+    TimeReadFile(fs_manager_.get(), block_id, &n);
+    ASSERT_EQ(kNumRows, n);
+    generator->Reset();
+    NO_FATALS(TimeSeekAndReadFileWithNulls(generator, block_id, n));
+  }
+};
+
+template<bool HAS_NULLS>
+class ConstantUInt32DataGenerator : public DataGenerator<UINT32, HAS_NULLS> {
+ public:
+  uint32_t BuildTestValue(size_t /*block_index*/, size_t /*value*/) override {
+    return 12345;
+  }
+};
+
+// Generates reproducible, hardly compressible values.
+class HashedUInt32DataGenerator : public DataGenerator<UINT32, false> {
+ public:
+  ATTRIBUTE_NO_SANITIZE_INTEGER
+  uint32_t BuildTestValue(size_t /*block_index*/, size_t value) override {
+    return static_cast<uint32_t>(value) * 2654435761U;
+  }
+};
+
+// Generates runs of 64 equal values.
+class UInt32RunsDataGenerator : public DataGenerator<UINT32, false> {
+ public:
+  uint32_t BuildTestValue(size_t /*block_index*/, size_t value) override {
+    return value / 64;
+  }
 };
 
 INSTANTIATE_TEST_CASE_P(Codecs, TestCFileDifferentCodecs,
@@ -1124,5 +1506,210 @@ TEST_P(TestCFileDifferentCodecs, TestUncompressible) {
   }
 }
 
+// Test that checksums verified concurrently with decompression still catch
+// corrupt blocks.
+TEST_P(TestCFileDifferentCodecs, TestConcurrentChecksums) {
+  auto codec = GetParam();
+  FLAGS_cfile_write_checksums = true;
+  FLAGS_cfile_verify_checksums = true;
+  FLAGS_cfile_checksum_threads = 2;
+  const size_t nrows = 200000;
+  BlockId block_id;
+  size_t rdrows;
+  RandomInt32DataGenerator int_gen;
+  WriteTestFile(&int_gen, PLAIN_ENCODING, codec, nrows, NO_FLAGS, &block_id);
+  TimeReadFile(fs_manager_.get(), block_id, &rdrows);
+  ASSERT_EQ(nrows, rdrows);
+
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  uint64_t file_size;
+  ASSERT_OK(source->Size(&file_size));
+  for (uint64_t offset : { file_size / 4, file_size / 2 }) {
+    Status s = CorruptAndReadBlock(block_id, offset, 3);
+    ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+  }
+}
+
+// Read/write a file whose blocks are compressed with a dictionary trained on
+// its first data blocks.
+TEST_P(TestCFileDifferentCodecs, TestCompressionDictionary) {
+  auto codec = GetParam();
+  if (codec == NO_COMPRESSION) {
+    return;
+  }
+  FLAGS_cfile_compression_dict_sample_blocks = 4;
+
+  StringDataGenerator<true> generator([](size_t idx) {
+    return StringPrintf("value %zu of a compressible column", idx % 100);
+  });
+  BlockId block_id;
+  WriteTestFile(&generator, PLAIN_ENCODING, codec, 10000, SMALL_BLOCKSIZE, &block_id);
+
+  {
+    unique_ptr<ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    unique_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    // Snappy does not support dictionaries, so none should have been trained.
+    bool expect_dict = codec != SNAPPY;
+    ASSERT_EQ(expect_dict, reader->footer().has_compression_dict_block_ptr());
+    ASSERT_EQ(expect_dict, static_cast<bool>(reader->footer().incompatible_features() &
+                                             IncompatibleFeatures::COMPRESSION_DICT));
+  }
+
+  size_t n;
+  TimeReadFile(fs_manager_.get(), block_id, &n);
+  ASSERT_EQ(10000, n);
+
+  generator.Reset();
+  NO_FATALS(TimeSeekAndReadFileWithNulls(&generator, block_id, n));
+}
+
+// Check that the size of data blocks adapts to the compression ratio of the
+// column when adaptive block sizing is enabled, while the number of cells per
+// block stays bounded.
+TEST_P(TestCFileDifferentCodecs, TestAdaptiveBlockSize) {
+  auto codec = GetParam();
+  const int kNumRows = 100000;
+  const int kMaxBlockSize = 16 * 1024;
+  const size_t kMinBlocks = kNumRows * sizeof(uint32_t) / kMaxBlockSize;
+
+  for (auto encoding : { PLAIN_ENCODING, RLE }) {
+    SCOPED_TRACE(encoding);
+    FLAGS_cfile_adaptive_block_size = false;
+    UInt32RunsDataGenerator generator;
+    BlockId fixed_id;
+    WriteTestFile(&generator, encoding, codec, kNumRows, SMALL_BLOCKSIZE, &fixed_id);
+
+    FLAGS_cfile_adaptive_block_size = true;
+    FLAGS_cfile_adaptive_max_block_size = kMaxBlockSize;
+    generator.Reset();
+    BlockId adaptive_id;
+    WriteTestFile(&generator, encoding, codec, kNumRows, SMALL_BLOCKSIZE, &adaptive_id);
+
+    size_t fixed_blocks;
+    size_t adaptive_blocks;
+    NO_FATALS(CountDataBlocks(fixed_id, &fixed_blocks));
+    NO_FATALS(CountDataBlocks(adaptive_id, &adaptive_blocks));
+    ASSERT_GE(adaptive_blocks, kMinBlocks);
+    if (encoding == RLE) {
+      // Runs compress so well with RLE that the limit on the number of cells
+      // per block is what determines the size of blocks.
+      ASSERT_LT(fixed_blocks, kMinBlocks);
+    } else if (codec == NO_COMPRESSION) {
+      ASSERT_EQ(fixed_blocks, adaptive_blocks);
+    } else {
+      // Compressed blocks grow to make up for the compression ratio.
+      ASSERT_LT(adaptive_blocks, fixed_blocks);
+    }
+
+    size_t n;
+    TimeReadFile(fs_manager_.get(), adaptive_id, &n);
+    ASSERT_EQ(kNumRows, n);
+    generator.Reset();
+    NO_FATALS(TimeSeekAndReadFileWithNulls(&generator, adaptive_id, n));
+  }
+}
+
+// Check that the encoding of files with AUTO_ENCODING is chosen by encoding
+// a sample of their first rows.
+TEST_P(TestCFileDifferentCodecs, TestAutoEncodingFromSample) {
+  // The sample ends in the middle of a batch of appended rows.
+  FLAGS_cfile_auto_encoding_sample_rows = 1050;
+
+  // Random-looking values are encoded about as compactly by every encoding,
+  // in which case the default encoding is kept.
+  {
+    HashedUInt32DataGenerator generator;
+    NO_FATALS(TestAutoEncoding(&generator, [](EncodingType encoding) {
+      ASSERT_EQ(BIT_SHUFFLE, encoding);
+    }));
+  }
+
+  // A constant column takes a few bytes with run-length encoding, while every
+  // small block has some overhead with the default bitshuffle encoding.
+  {
+    ConstantUInt32DataGenerator<false> generator;
+    NO_FATALS(TestAutoEncoding(&generator, [](EncodingType encoding) {
+      ASSERT_NE(BIT_SHUFFLE, encoding);
+    }));
+  }
+  {
+    ConstantUInt32DataGenerator<true> generator;
+    NO_FATALS(TestAutoEncoding(&generator, [](EncodingType encoding) {
+      ASSERT_NE(BIT_SHUFFLE, encoding);
+    }));
+  }
+
+  // Strings are copied while they are being sampled.
+  {
+    StringDataGenerator<true> generator("a long common prefix for the value %08d");
+    NO_FATALS(TestAutoEncoding(&generator, [](EncodingType /*encoding*/) {}));
+  }
+}
+
+// Check that compressed blocks evicted from the block cache are served from
+// its compressed tier rather than being read again.
+TEST_P(TestCFileDifferentCodecs, TestCompressedTier) {
+  const auto codec = GetParam();
+  // With no capacity, the decompressed blocks are evicted as soon as their
+  // handles are released.
+  FLAGS_block_cache_capacity_mb = 0;
+  FLAGS_block_cache_compressed_capacity_mb = 16;
+  Singleton<BlockCache>::UnsafeReset();
+  SCOPED_CLEANUP({
+    Singleton<BlockCache>::UnsafeReset();
+  });
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockCache::GetSingleton()->StartInstrumentation(entity);
+
+  BlockId block_id;
+  {
+    StringDataGenerator<false> generator("hello %04d");
+    WriteTestFile(&generator, PLAIN_ENCODING, codec, 10000, SMALL_BLOCKSIZE, &block_id);
+  }
+  unique_ptr<ReadableBlock> source;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+  unique_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+
+  // Read every data block twice: the second pass must see the same data.
+  vector<string> first_pass;
+  for (int pass = 0; pass < 2; pass++) {
+    unique_ptr<IndexTreeIterator> iter(
+        IndexTreeIterator::Create(nullptr, reader.get(), reader->posidx_root()));
+    ASSERT_OK(iter->SeekToFirst());
+    size_t i = 0;
+    while (true) {
+      BlockHandle bh;
+      ASSERT_OK(reader->ReadBlock(nullptr, iter->GetCurrentBlockPointer(),
+                                  CFileReader::CACHE_BLOCK, &bh));
+      if (pass == 0) {
+        first_pass.emplace_back(bh.data().ToString());
+      } else {
+        ASSERT_EQ(first_pass[i], bh.data().ToString());
+      }
+      i++;
+      if (!iter->HasNext()) {
+        break;
+      }
+      ASSERT_OK(iter->Next());
+    }
+    ASSERT_EQ(first_pass.size(), i);
+  }
+
+  // The index blocks read by the iterators may be served from the compressed
+  // tier as well.
+  const int64_t compressed_hits = down_cast<Counter*>(
+      entity->FindOrNull(METRIC_block_cache_compressed_tier_hits).get())->value();
+  if (codec == NO_COMPRESSION) {
+    ASSERT_EQ(0, compressed_hits);
+  } else {
+    ASSERT_GE(compressed_hits, static_cast<int64_t>(first_pass.size()));
+  }
+}
+
 } // namespace cfile
 } // namespace kudu
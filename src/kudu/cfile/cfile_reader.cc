@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <ostream>
 #include <utility>
@@ -36,17 +37,20 @@
 #include "kudu/cfile/cfile_writer.h" // for kMagicString
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/column_materialization_context.h"
 #include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
+#include "kudu/common/iterator_stats.h"
 #include "kudu/common/key_encoder.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/types.h"
 #include "kudu/fs/error_manager.h"
 #include "kudu/fs/io_context.h"
 #include "kudu/gutil/basictypes.h"
+#include "kudu/gutil/once.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/array_view.h"
@@ -54,7 +58,9 @@
 #include "kudu/util/cache.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/crc.h"
+#include "kudu/util/debug/leakcheck_disabler.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
@@ -67,6 +73,7 @@
 #include "kudu/util/rle-encoding.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
 DEFINE_bool(cfile_lazy_open, true,
@@ -82,6 +89,21 @@ DEFINE_double(cfile_inject_corruption, 0,
               "with a corruption status");
 TAG_FLAG(cfile_inject_corruption, hidden);
 
+DEFINE_int32(cfile_uncached_readahead_blocks, 0,
+             "Number of data blocks per column which scans that don't cache the "
+             "blocks they read (e.g. large batch scans) ask the operating system "
+             "to read ahead of the block they're reading. This lets such scans "
+             "avoid both the block cache and waiting on a read for every block. "
+             "0 disables read-ahead.");
+TAG_FLAG(cfile_uncached_readahead_blocks, experimental);
+TAG_FLAG(cfile_uncached_readahead_blocks, runtime);
+
+DEFINE_int32(cfile_checksum_threads, 0,
+             "Number of threads used to verify the checksums of compressed "
+             "CFile blocks concurrently with their decompression. 0 verifies "
+             "checksums on the reading thread before decompressing.");
+TAG_FLAG(cfile_checksum_threads, experimental);
+
 using kudu::fault_injection::MaybeTrue;
 using kudu::fs::ErrorHandlerType;
 using kudu::fs::IOContext;
@@ -102,6 +124,32 @@ const char* CFILE_CACHE_HIT_BYTES_METRIC_NAME = "cfile_cache_hit_bytes";
 static const size_t kMagicAndLengthSize = 12;
 static const size_t kMaxHeaderFooterPBSize = 64*1024;
 
+// Compressed blocks smaller than this are verified on the reading thread, as
+// handing them off would cost about as much as checksumming them.
+static const size_t kMinConcurrentChecksumSize = 32*1024;
+
+static GoogleOnceType checksum_pool_once = GOOGLE_ONCE_INIT;
+static ThreadPool* checksum_pool = nullptr;
+
+static void InitChecksumPool() {
+  debug::ScopedLeakCheckDisabler disabler; // The pool is never destroyed.
+  unique_ptr<ThreadPool> pool;
+  CHECK_OK(ThreadPoolBuilder("cfile-checksum")
+           .set_max_threads(FLAGS_cfile_checksum_threads)
+           .Build(&pool));
+  checksum_pool = pool.release();
+}
+
+// Returns the pool used to verify the checksums of compressed blocks while
+// they're decompressed, or nullptr if there isn't one.
+static ThreadPool* GetChecksumPool() {
+  if (FLAGS_cfile_checksum_threads <= 0) {
+    return nullptr;
+  }
+  GoogleOnceInit(&checksum_pool_once, &InitChecksumPool);
+  return checksum_pool;
+}
+
 static Status ParseMagicAndLength(const Slice &data,
                                   uint8_t* cfile_version,
                                   uint32_t *parsed_len) {
@@ -192,6 +240,10 @@ Status CFileReader::InitOnce(const IOContext* io_context) {
                                       footer_->encoding(),
                                       &type_encoding_info_));
 
+  if (footer_->has_compression_dict_block_ptr()) {
+    RETURN_NOT_OK_HANDLE_CORRUPTION(ReadCompressionDict(), HandleCorruption(io_context));
+  }
+
   VLOG(2) << "Initialized CFile reader. "
           << "Header: " << SecureDebugString(*header_)
           << " Footer: " << SecureDebugString(*footer_)
@@ -323,6 +375,42 @@ Status CFileReader::ReadAndParseFooter() {
   return Status::OK();
 }
 
+Status CFileReader::ReadCompressionDict() {
+  TRACE_EVENT1("io", "CFileReader::ReadCompressionDict",
+               "cfile", ToString());
+  if (PREDICT_FALSE(codec_ == nullptr || !codec_->SupportsDictionary())) {
+    return Status::Corruption(Substitute(
+        "cfile has a compression dictionary, but codec $0 does not support dictionaries",
+        CompressionType_Name(footer_->compression())));
+  }
+
+  BlockPointer ptr(footer_->compression_dict_block_ptr());
+  uint32_t dict_size = ptr.size();
+  if (has_checksums()) {
+    if (PREDICT_FALSE(kChecksumSize > dict_size)) {
+      return Status::Corruption("invalid data size for compression dictionary pointer",
+                                ptr.ToString());
+    }
+    dict_size -= kChecksumSize;
+  }
+
+  compression_dict_.resize(dict_size);
+  Slice dict(compression_dict_.data(), dict_size);
+  uint8_t checksum_scratch[kChecksumSize];
+  Slice checksum(checksum_scratch, kChecksumSize);
+
+  Slice results_backing[] = { dict, checksum };
+  bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
+  ArrayView<Slice> results(results_backing, read_checksum ? 2 : 1);
+  RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
+                        "failed to read CFile compression dictionary");
+  if (read_checksum) {
+    RETURN_NOT_OK_PREPEND(VerifyChecksum(ArrayView<const Slice>(&dict, 1), checksum),
+                          "checksum error on CFile compression dictionary");
+  }
+  return Status::OK();
+}
+
 bool CFileReader::has_checksums() const {
   return footer_->incompatible_features() & IncompatibleFeatures::CHECKSUM;
 }
@@ -427,8 +515,36 @@ class ScratchMemory {
   int size_;
   DISALLOW_COPY_AND_ASSIGN(ScratchMemory);
 };
+
+// Decompresses the CFile block 'compressed' into 'out', setting 'uncompressed'
+// to the decompressed data. If 'cache' isn't null, the memory of 'out' is
+// allocated from it for the entry with key 'key'.
+Status UncompressBlock(const CompressionCodec* codec, int cfile_version,
+                       const Slice& compressed, const Slice& dict,
+                       BlockCache* cache, const BlockCache::CacheKey& key,
+                       ScratchMemory* out, Slice* uncompressed) {
+  SCOPED_SCAN_STAGE_TIMER(ScanStage::kDecompress);
+  CompressedBlockDecoder uncompressor(codec, cfile_version, compressed, dict);
+  RETURN_NOT_OK(uncompressor.Init());
+  int uncompressed_size = uncompressor.uncompressed_size();
+
+  // If we plan to put the uncompressed block in the cache, we should
+  // decompress directly into the cache's memory (to avoid a memcpy for NVM).
+  if (cache) {
+    out->TryAllocateFromCache(cache, key, uncompressed_size);
+  } else {
+    out->AllocateFromHeap(uncompressed_size);
+  }
+  RETURN_NOT_OK(uncompressor.UncompressIntoBuffer(out->get()));
+  *uncompressed = Slice(out->get(), uncompressed_size);
+  return Status::OK();
+}
 } // anonymous namespace
 
+void CFileReader::ReadAhead(uint64_t offset, size_t length) const {
+  block_->ReadAhead(offset, length);
+}
+
 Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &ptr,
                               CacheControl cache_control, BlockHandle *ret) const {
   DCHECK(init_once_.init_succeeded());
@@ -458,6 +574,42 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
   TRACE_COUNTER_INCREMENT("cfile_cache_miss", 1);
   TRACE_COUNTER_INCREMENT(CFILE_CACHE_MISS_BYTES_METRIC_NAME, ptr.size());
 
+  // Only the blocks written after the compression dictionary was trained
+  // use it.
+  Slice dict;
+  if (codec_ != nullptr && footer_->has_compression_dict_block_ptr() &&
+      ptr.offset() >= footer_->compression_dict_start_offset()) {
+    dict = Slice(compression_dict_);
+  }
+
+  // The compressed tier of the block cache may still have the block as it
+  // was read from disk. It was only inserted once its checksum (if any) was
+  // verified and it was decompressed successfully.
+  const bool use_compressed_tier = codec_ != nullptr && cache_control == CACHE_BLOCK &&
+      cache->has_compressed_tier();
+  BlockCacheHandle compressed_handle;
+  if (use_compressed_tier &&
+      cache->LookupCompressed(key, cache_behavior, &compressed_handle)) {
+    TRACE_COUNTER_INCREMENT("cfile_compressed_cache_hit", 1);
+    ScratchMemory decompressed_scratch;
+    Slice decompressed;
+    Status s = UncompressBlock(codec_, cfile_version_, compressed_handle.data(), dict,
+                               cache, key, &decompressed_scratch, &decompressed);
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to uncompress cached block " << block_id().ToString()
+                   << " at " << ptr.offset() << ": " << s.ToString();
+      return s;
+    }
+    if (decompressed_scratch.IsFromCache()) {
+      cache->Insert(decompressed_scratch.mutable_pending_entry(), &bc_handle);
+      *ret = BlockHandle::WithDataFromCache(&bc_handle);
+    } else {
+      *ret = BlockHandle::WithOwnedData(decompressed_scratch.as_slice());
+    }
+    ignore_result(decompressed_scratch.release());
+    return Status::OK();
+  }
+
   uint32_t data_size = ptr.size();
   if (has_checksums()) {
     if (PREDICT_FALSE(kChecksumSize > data_size)) {
@@ -485,42 +637,61 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
   Slice results_backing[] = { block, checksum };
   bool read_checksum = has_checksums() && FLAGS_cfile_verify_checksums;
   ArrayView<Slice> results(results_backing, read_checksum ? 2 : 1);
-  RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
-                        Substitute("failed to read CFile block $0 at $1",
-                                   block_id().ToString(), ptr.ToString()));
+  if (io_context && io_context->is_background) {
+    block_->ThrottleBackgroundRead(ptr.size());
+  }
+  {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kCacheMissWait);
+    RETURN_NOT_OK_PREPEND(block_->ReadV(ptr.offset(), results),
+                          Substitute("failed to read CFile block $0 at $1",
+                                     block_id().ToString(), ptr.ToString()));
+  }
 
-  if (has_checksums() && FLAGS_cfile_verify_checksums) {
-    Status s = VerifyChecksum(ArrayView<const Slice>(&block, 1), checksum);
-    if (!s.ok()) {
+  // Verify the checksum. A large compressed block is verified by the checksum
+  // pool while this thread decompresses it; the decompressed data is only
+  // used once the checksum has matched.
+  Status checksum_status;
+  CountDownLatch checksum_verified(1);
+  if (read_checksum) {
+    const Slice data = block;
+    auto verify = [this, data, &checksum, &checksum_status, &checksum_verified]() {
+      checksum_status = VerifyChecksum(ArrayView<const Slice>(&data, 1), checksum);
+      checksum_verified.CountDown();
+    };
+    ThreadPool* pool = codec_ != nullptr && data_size >= kMinConcurrentChecksumSize ?
+        GetChecksumPool() : nullptr;
+    if (pool == nullptr || !pool->Submit(verify).ok()) {
+      verify();
+    }
+  } else {
+    checksum_verified.CountDown();
+  }
+  // Waits for the checksum to be verified. Must be called before returning,
+  // and before the read buffer is released.
+  auto wait_for_checksum = [&]() -> Status {
+    {
+      SCOPED_SCAN_STAGE_TIMER(ScanStage::kCacheMissWait);
+      checksum_verified.Wait();
+    }
+    if (!checksum_status.ok()) {
       RETURN_NOT_OK_HANDLE_CORRUPTION(
-          s.CloneAndPrepend(Substitute("checksum error on CFile block $0 at $1",
-                                       block_id().ToString(), ptr.ToString())),
+          checksum_status.CloneAndPrepend(Substitute("checksum error on CFile block $0 at $1",
+                                                     block_id().ToString(), ptr.ToString())),
           HandleCorruption(io_context));
     }
-  }
+    return Status::OK();
+  };
 
   // Decompress the block
-  if (codec_ != nullptr) {
-    // Init the decompressor and get the size required for the uncompressed buffer.
-    CompressedBlockDecoder uncompressor(codec_, cfile_version_, block);
-    Status s = uncompressor.Init();
-    if (!s.ok()) {
-      LOG(WARNING) << "Unable to validate compressed block " << block_id().ToString()
-                   << " at " << ptr.offset() << " of size " << block.size() << ": "
-                   << s.ToString();
-      return s;
-    }
-    int uncompressed_size = uncompressor.uncompressed_size();
-
-    // If we plan to put the uncompressed block in the cache, we should
-    // decompress directly into the cache's memory (to avoid a memcpy for NVM).
+  if (codec_ == nullptr) {
+    RETURN_NOT_OK(wait_for_checksum());
+  } else {
     ScratchMemory decompressed_scratch;
-    if (cache_control == CACHE_BLOCK) {
-      decompressed_scratch.TryAllocateFromCache(cache, key, uncompressed_size);
-    } else {
-      decompressed_scratch.AllocateFromHeap(uncompressed_size);
-    }
-    s = uncompressor.UncompressIntoBuffer(decompressed_scratch.get());
+    Slice decompressed;
+    Status s = UncompressBlock(codec_, cfile_version_, block, dict,
+                               cache_control == CACHE_BLOCK ? cache : nullptr, key,
+                               &decompressed_scratch, &decompressed);
+    RETURN_NOT_OK(wait_for_checksum());
     if (!s.ok()) {
       LOG(WARNING) << "Unable to uncompress block " << block_id().ToString()
                    << " at " << ptr.offset()
@@ -528,13 +699,23 @@ Status CFileReader::ReadBlock(const IOContext* io_context, const BlockPointer &p
       return s;
     }
 
+    // Keep the verified compressed block in the compressed tier, so it doesn't
+    // need to be read again once the decompressed block is evicted.
+    if (use_compressed_tier) {
+      BlockCache::PendingEntry entry = cache->AllocateCompressed(key, block.size());
+      if (entry.valid()) {
+        memcpy(entry.val_ptr(), block.data(), block.size());
+        cache->InsertCompressed(&entry, &compressed_handle);
+      }
+    }
+
     // Now that we've decompressed, we don't need to keep holding onto the original
     // scratch buffer. Instead, we have to start holding onto our decompression
     // output buffer.
     scratch.Swap(&decompressed_scratch);
 
     // Set the result block to our decompressed data.
-    block = Slice(buf, uncompressed_size);
+    block = Slice(buf, decompressed.size());
   }
 
   // It's possible that one of the TryAllocateFromCache() calls above
@@ -610,6 +791,7 @@ size_t CFileReader::memory_footprint() const {
   if (footer_) {
     size += footer_->SpaceUsed();
   }
+  size += compression_dict_.capacity();
   return size;
 }
 
@@ -617,6 +799,29 @@ size_t CFileReader::memory_footprint() const {
 // Default Column Value Iterator
 ////////////////////////////////////////////////////////////
 
+namespace {
+
+// Sets all the cells of 'dst' to 'value'. Rather than copying the value into
+// each cell, the cells that are already set are copied over the following
+// ones, doubling the number of set cells with each memcpy().
+void FillCells(ColumnBlock* dst, const void* value) {
+  const size_t nrows = dst->nrows();
+  if (nrows == 0) {
+    return;
+  }
+  const size_t stride = dst->stride();
+  uint8_t* data = dst->data();
+  memcpy(data, value, stride);
+  size_t filled = 1;
+  while (filled < nrows) {
+    const size_t n = std::min(filled, nrows - filled);
+    memcpy(data + filled * stride, data, n * stride);
+    filled += n;
+  }
+}
+
+} // anonymous namespace
+
 Status DefaultColumnValueIterator::SeekToOrdinal(rowid_t ord_idx) {
   ordinal_ = ord_idx;
   return Status::OK();
@@ -649,13 +854,9 @@ Status DefaultColumnValueIterator::Scan(ColumnMaterializationContext* ctx) {
       if (PREDICT_FALSE(!dst->arena()->RelocateSlice(*src_slice, &dst_slice))) {
         return Status::IOError("out of memory copying slice", src_slice->ToString());
       }
-      for (size_t i = 0; i < dst->nrows(); ++i) {
-        dst->SetCellValue(i, &dst_slice);
-      }
+      FillCells(dst, &dst_slice);
     } else {
-      for (size_t i = 0; i < dst->nrows(); ++i) {
-        dst->SetCellValue(i, value_);
-      }
+      FillCells(dst, value_);
     }
   } else {
     if (ctx->DecoderEvalNotDisabled() && !ctx->EvaluatingIsNull()) {
@@ -678,12 +879,15 @@ CFileIterator::CFileIterator(CFileReader* reader,
                              CFileReader::CacheControl cache_control,
                              const IOContext* io_context)
   : reader_(reader),
+    numeric_dict_loaded_(false),
     seeked_(nullptr),
     prepared_(false),
     cache_control_(cache_control),
     last_prepare_idx_(-1),
     last_prepare_count_(-1),
-    io_context_(io_context) {
+    io_context_(io_context),
+    readahead_trigger_offset_(0),
+    readahead_end_offset_(0) {
 }
 
 CFileIterator::~CFileIterator() {
@@ -882,7 +1086,11 @@ Status CFileIterator::PrepareForNewSeek() {
 
   // Initialize the decoder for the dictionary block
   // in dictionary encoding mode.
-  if (!dict_decoder_ && reader_->footer().has_dict_block_ptr()) {
+  if (reader_->type_info()->physical_type() != BINARY) {
+    if (!numeric_dict_loaded_ && reader_->footer().has_dict_block_ptr()) {
+      RETURN_NOT_OK(ReadNumericDict());
+    }
+  } else if (!dict_decoder_ && reader_->footer().has_dict_block_ptr()) {
     BlockPointer bp(reader_->footer().dict_block_ptr());
 
     // Cache the dictionary for performance
@@ -902,7 +1110,33 @@ Status CFileIterator::PrepareForNewSeek() {
     prepared_block_pool_.Destroy(pb);
   }
   prepared_blocks_.clear();
+  readahead_trigger_offset_ = 0;
+  readahead_end_offset_ = 0;
+
+  return Status::OK();
+}
 
+Status CFileIterator::ReadNumericDict() {
+  BlockPointer bp(reader_->footer().dict_block_ptr());
+
+  // Cache the dictionary for performance
+  RETURN_NOT_OK_PREPEND(
+      reader_->ReadBlock(io_context_, bp, CFileReader::CACHE_BLOCK, &dict_block_handle_),
+      "couldn't read dictionary block");
+
+  Slice data = dict_block_handle_.data();
+  size_t value_size = reader_->type_info()->size();
+  if (PREDICT_FALSE(data.size() < sizeof(uint32_t) ||
+                    data.size() != sizeof(uint32_t) +
+                                   DecodeFixed32(data.data()) * value_size)) {
+    return Status::Corruption(Substitute("bad dictionary block size $0 in block $1 ($2)",
+                                         data.size(),
+                                         reader_->block_id().ToString(),
+                                         bp.ToString()));
+  }
+  data.remove_prefix(sizeof(uint32_t));
+  numeric_dict_ = data;
+  numeric_dict_loaded_ = true;
   return Status::OK();
 }
 
@@ -980,10 +1214,132 @@ Status CFileIterator::QueueCurrentDataBlock(const IndexTreeIterator &idx_iter) {
   pblock_pool_scoped_ptr b = prepared_block_pool_.make_scoped_ptr(
     prepared_block_pool_.Construct());
   RETURN_NOT_OK(ReadCurrentDataBlock(idx_iter, b.get()));
+  RETURN_NOT_OK(MaybeReadAhead(*b));
   prepared_blocks_.push_back(b.release());
   return Status::OK();
 }
 
+Status CFileIterator::MaybeReadAhead(const PreparedBlock& b) {
+  const int32_t num_blocks = FLAGS_cfile_uncached_readahead_blocks;
+  if (num_blocks <= 0 || cache_control_ != CFileReader::DONT_CACHE_BLOCK ||
+      !reader_->has_posidx()) {
+    return Status::OK();
+  }
+  // Data blocks are laid out in the order of their rows, so offsets tell how
+  // far the scan has gotten into the range hinted last.
+  const uint64_t offset = b.dblk_ptr_.offset();
+  if (offset < readahead_trigger_offset_) {
+    return Status::OK();
+  }
+  if (!readahead_iter_) {
+    readahead_iter_.reset(
+        IndexTreeIterator::Create(io_context_, reader_, reader_->posidx_root()));
+  }
+  if (offset >= readahead_end_offset_) {
+    // Nothing ahead of this block has been hinted, e.g. since the iterator
+    // was just seeked: start from this block.
+    faststring enc_idx;
+    KeyEncoderTraits<UINT32, faststring>::Encode(b.first_row_idx(), &enc_idx);
+    RETURN_NOT_OK(readahead_iter_->SeekAtOrBefore(Slice(enc_idx)));
+  }
+
+  uint64_t start = std::numeric_limits<uint64_t>::max();
+  uint64_t end = 0;
+  for (int i = 0; i < num_blocks; i++) {
+    Status s = readahead_iter_->Next();
+    if (s.IsNotFound()) {
+      break;
+    }
+    RETURN_NOT_OK(s);
+    const BlockPointer ptr = readahead_iter_->GetCurrentBlockPointer();
+    start = std::min(start, ptr.offset());
+    end = std::max(end, ptr.offset() + ptr.size());
+    // Hint the next range once the scan is halfway through this one, so that
+    // the reads stay ahead of it.
+    if (i == num_blocks / 2) {
+      readahead_trigger_offset_ = ptr.offset();
+    }
+  }
+  if (end == 0) {
+    // There are no more blocks to hint until the next seek.
+    readahead_trigger_offset_ = std::numeric_limits<uint64_t>::max();
+    return Status::OK();
+  }
+  readahead_end_offset_ = end;
+  reader_->ReadAhead(start, end - start);
+  return Status::OK();
+}
+
+Status CFileIterator::MayHaveMatches(rowid_t ord_idx,
+                                     size_t nrows,
+                                     const ColumnPredicate& pred,
+                                     bool* may_match) {
+  *may_match = true;
+  RETURN_NOT_OK(reader_->Init(io_context_));
+  if (!reader_->has_zone_maps()) {
+    return Status::OK();
+  }
+
+  if (!zone_map_reader_) {
+    BlockPointer bp = reader_->zone_map_block_ptr();
+    RETURN_NOT_OK_PREPEND(
+        reader_->ReadBlock(io_context_, bp, CFileReader::CACHE_BLOCK, &zone_map_block_handle_),
+        "couldn't read zone map block");
+
+    unique_ptr<ZoneMapReader> zone_map_reader(new ZoneMapReader(reader_->type_info()));
+    RETURN_NOT_OK_PREPEND(zone_map_reader->Parse(zone_map_block_handle_.data()),
+                          Substitute("couldn't parse zone map block in block $0 ($1)",
+                                     reader_->block_id().ToString(),
+                                     bp.ToString()));
+    zone_map_reader_ = std::move(zone_map_reader);
+  }
+
+  *may_match = zone_map_reader_->MayMatch(ord_idx, nrows, pred);
+  return Status::OK();
+}
+
+Status CFileIterator::ReadBlocksIntoCache(rowid_t ord_idx,
+                                          size_t nrows,
+                                          rowid_t* last_row_idx) {
+  DCHECK_GT(nrows, 0);
+  const rowid_t end_idx = ord_idx + nrows;
+  RETURN_NOT_OK(reader_->Init(io_context_));
+  if (cache_control_ != CFileReader::CACHE_BLOCK || !reader_->has_posidx()) {
+    *last_row_idx = end_idx - 1;
+    return Status::OK();
+  }
+
+  // Use a separate index iterator, leaving 'posidx_iter_' where it is.
+  unique_ptr<IndexTreeIterator> idx_iter(
+      IndexTreeIterator::Create(io_context_, reader_, reader_->posidx_root()));
+  faststring enc_idx;
+  KeyEncoderTraits<UINT32, faststring>::Encode(ord_idx, &enc_idx);
+  RETURN_NOT_OK(idx_iter->SeekAtOrBefore(Slice(enc_idx)));
+  while (true) {
+    BlockHandle handle;
+    RETURN_NOT_OK(reader_->ReadBlock(io_context_, idx_iter->GetCurrentBlockPointer(),
+                                     CFileReader::CACHE_BLOCK, &handle));
+    Status s = idx_iter->Next();
+    if (s.IsNotFound()) {
+      // The last block of the file holds all of the remaining rows.
+      *last_row_idx = std::numeric_limits<rowid_t>::max();
+      return Status::OK();
+    }
+    RETURN_NOT_OK(s);
+
+    // The positional index is keyed by the first row of each block.
+    Slice key = idx_iter->GetCurrentKey();
+    rowid_t next_first_row_idx;
+    RETURN_NOT_OK(KeyEncoderTraits<UINT32, faststring>::DecodeKeyPortion(
+        &key, /*is_last=*/true, /*arena=*/nullptr,
+        reinterpret_cast<uint8_t*>(&next_first_row_idx)));
+    if (next_first_row_idx >= end_idx) {
+      *last_row_idx = next_first_row_idx - 1;
+      return Status::OK();
+    }
+  }
+}
+
 bool CFileIterator::HasNext() const {
   CHECK(seeked_) << "not seeked";
   CHECK(!prepared_) << "Cannot call HasNext() mid-batch";
@@ -1086,6 +1442,7 @@ Status CFileIterator::FinishBatch() {
 
 Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   CHECK(seeked_) << "not seeked";
+  SCOPED_SCAN_STAGE_TIMER(ScanStage::kDecode);
 
   // Use views to advance the block and selection vector as we read into them.
   ColumnDataView remaining_dst(ctx->block());
@@ -1096,6 +1453,7 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   // Determine the matching codewords for dictionary encoding if they haven't
   // yet been determined for this CFile.
   if (dict_decoder_ && ctx->DecoderEvalNotDisabled() && !codewords_matching_pred_) {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kPredicateEval);
     size_t nwords = dict_decoder_->Count();
     if (nwords > 0) {
       codewords_matching_pred_.reset(new SelectionVector(nwords));
@@ -1107,6 +1465,25 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
         }
       }
     }
+  } else if (numeric_dict_loaded_ && ctx->DecoderEvalNotDisabled() &&
+             !codewords_matching_pred_) {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kPredicateEval);
+    const TypeInfo* type_info = reader_->type_info();
+    size_t value_size = type_info->size();
+    size_t nwords = numeric_dict_.size() / value_size;
+    if (nwords > 0) {
+      codewords_matching_pred_.reset(new SelectionVector(nwords));
+      codewords_matching_pred_->SetAllFalse();
+      // The dictionary values may not be suitably aligned within the block.
+      alignas(16) uint8_t cell[16];
+      DCHECK_LE(value_size, sizeof(cell));
+      for (size_t i = 0; i < nwords; i++) {
+        memcpy(cell, numeric_dict_.data() + i * value_size, value_size);
+        if (ctx->pred()->EvaluateCell(type_info->physical_type(), cell)) {
+          BitmapSet(codewords_matching_pred_->mutable_bitmap(), i);
+        }
+      }
+    }
   }
   for (PreparedBlock *pb : prepared_blocks_) {
     if (pb->needs_rewind_) {
@@ -1133,15 +1510,8 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
         }
         size_t this_batch = nblock;
         if (not_null) {
-          if (ctx->DecoderEvalNotDisabled()) {
-            RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch,
-                                                     ctx,
-                                                     &remaining_sel,
-                                                     &remaining_dst));
-          } else {
-            RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-          }
-          DCHECK_EQ(nblock, this_batch);
+          RETURN_NOT_OK(CopyNextValuesFromBlock(pb, this_batch, ctx,
+                                                &remaining_sel, &remaining_dst));
           pb->needs_rewind_ = true;
         } else {
 #ifndef NDEBUG
@@ -1165,15 +1535,9 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
       }
     } else {
       // Fetch as many as we can from the current datablock.
-      size_t this_batch = rem;
-
-      if (ctx->DecoderEvalNotDisabled()) {
-        RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&this_batch, ctx, &remaining_sel, &remaining_dst));
-      } else {
-        RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-      }
+      size_t this_batch = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+      RETURN_NOT_OK(CopyNextValuesFromBlock(pb, this_batch, ctx, &remaining_sel, &remaining_dst));
       pb->needs_rewind_ = true;
-      DCHECK_LE(this_batch, rem);
 
       // If the column is nullable, set all bits to true
       if (ctx->block()->is_nullable()) {
@@ -1200,6 +1564,69 @@ Status CFileIterator::Scan(ColumnMaterializationContext* ctx) {
   return Status::OK();
 }
 
+Status CFileIterator::CopyNextValuesFromBlock(PreparedBlock* pb, size_t n,
+                                              ColumnMaterializationContext* ctx,
+                                              SelectionVectorView* sel,
+                                              ColumnDataView* dst) {
+  // Runs of unselected rows shorter than this are decoded along with the
+  // surrounding selected rows: seeking within the block isn't free, and
+  // decoding many short runs would defeat the batching done by the decoders.
+  static constexpr size_t kMinUnselectedRowsToSkip = 64;
+
+  const auto copy = [&](size_t nrows, SelectionVectorView* sel_view, ColumnDataView* dst_view) {
+    size_t count = nrows;
+    if (ctx->DecoderEvalNotDisabled()) {
+      RETURN_NOT_OK(pb->dblk_->CopyNextAndEval(&count, ctx, sel_view, dst_view));
+    } else {
+      RETURN_NOT_OK(pb->dblk_->CopyNextValues(&count, dst_view));
+    }
+    DCHECK_EQ(nrows, count);
+    return Status::OK();
+  };
+
+  if (!ctx->MaterializeSelectedRowsOnly()) {
+    return copy(n, sel, dst);
+  }
+
+  SelectionVectorView sel_view(*sel);
+  ColumnDataView dst_view(*dst);
+  size_t pos = 0;
+  while (pos < n) {
+    // Find the next run of unselected rows worth skipping, if any. The rows
+    // in [pos, copy_end) are decoded and the rows in [copy_end, skip_end)
+    // are skipped.
+    size_t copy_end = pos;
+    size_t skip_end;
+    while (true) {
+      copy_end = sel->FindFirstUnsetBit(copy_end, n);
+      skip_end = sel->FindFirstSetBit(copy_end, n);
+      if (skip_end - copy_end >= kMinUnselectedRowsToSkip || skip_end == n) {
+        break;
+      }
+      copy_end = skip_end;
+    }
+
+    if (copy_end > pos) {
+      RETURN_NOT_OK(copy(copy_end - pos, &sel_view, &dst_view));
+      sel_view.Advance(copy_end - pos);
+      dst_view.Advance(copy_end - pos);
+    }
+    if (skip_end > copy_end) {
+      size_t nskip = skip_end - copy_end;
+      pb->dblk_->SeekToPositionInBlock(pb->dblk_->GetCurrentIndex() + nskip);
+#ifndef NDEBUG
+      kudu::OverwriteWithPattern(reinterpret_cast<char *>(dst_view.data()),
+                                 dst_view.stride() * nskip,
+                                 "UNSELECTEDUNSELECTED");
+#endif
+      sel_view.Advance(nskip);
+      dst_view.Advance(nskip);
+    }
+    pos = skip_end;
+  }
+  return Status::OK();
+}
+
 Status CFileIterator::CopyNextValues(size_t* n, ColumnMaterializationContext* ctx) {
   RETURN_NOT_OK(PrepareBatch(n));
   RETURN_NOT_OK(Scan(ctx));
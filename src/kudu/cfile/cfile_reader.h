@@ -46,6 +46,7 @@
 namespace kudu {
 
 class ColumnMaterializationContext;
+class ColumnPredicate;
 class CompressionCodec;
 class EncodedKey;
 class SelectionVector;
@@ -63,6 +64,7 @@ class BinaryPlainBlockDecoder;
 class CFileIterator;
 class IndexTreeIterator;
 class TypeEncodingInfo;
+class ZoneMapReader;
 struct ReaderOptions;
 
 class CFileReader {
@@ -106,6 +108,9 @@ class CFileReader {
   Status ReadBlock(const fs::IOContext* io_context, const BlockPointer& ptr,
                    CacheControl cache_control, BlockHandle* ret) const;
 
+  // Hints that the given range of the file will be read soon.
+  void ReadAhead(uint64_t offset, size_t length) const;
+
   // Return the number of rows in this cfile.
   // This is assumed to be reasonably fast (i.e does not scan
   // the data)
@@ -174,6 +179,13 @@ class CFileReader {
     return BlockPointer(footer().validx_info().root_block());
   }
 
+  // Return true if the file has per-data-block statistics.
+  bool has_zone_maps() const { return footer().has_zone_map_block_ptr(); }
+  BlockPointer zone_map_block_ptr() const {
+    DCHECK(has_zone_maps());
+    return BlockPointer(footer().zone_map_block_ptr());
+  }
+
   // Returns true if the file has checksums on the header, footer, and data blocks.
   bool has_checksums() const;
 
@@ -196,6 +208,9 @@ class CFileReader {
 
   Status ReadAndParseHeader();
   Status ReadAndParseFooter();
+
+  // Reads the dictionary used to compress the blocks of the file.
+  Status ReadCompressionDict();
   Status VerifyChecksum(ArrayView<const Slice> data, const Slice& checksum) const;
 
   // Returns the memory usage of the object including the object itself.
@@ -212,6 +227,8 @@ class CFileReader {
   std::unique_ptr<CFileHeaderPB> header_;
   std::unique_ptr<CFileFooterPB> footer_;
   const CompressionCodec* codec_;
+  // The dictionary used to compress the blocks of the file, if any.
+  faststring compression_dict_;
   const TypeInfo *type_info_;
   const TypeEncodingInfo *type_encoding_info_;
 
@@ -273,6 +290,20 @@ class ColumnIterator {
   // batch left off.
   virtual Status FinishBatch() = 0;
 
+  // Sets '*may_match' to false if the column's statistics prove that none of
+  // the 'nrows' rows starting at 'ord_idx' can satisfy 'pred', in which case
+  // the caller may skip reading them altogether. Otherwise, including when no
+  // such statistics are available, sets it to true.
+  //
+  // This does not change the position of the iterator.
+  virtual Status MayHaveMatches(rowid_t /*ord_idx*/,
+                                size_t /*nrows*/,
+                                const ColumnPredicate& /*pred*/,
+                                bool* may_match) {
+    *may_match = true;
+    return Status::OK();
+  }
+
   virtual const IteratorStats& io_statistics() const = 0;
 };
 
@@ -377,6 +408,26 @@ class CFileIterator : public ColumnIterator {
   // batch left off.
   Status FinishBatch() OVERRIDE;
 
+  // Uses the zone maps of the file, if any, to determine whether any of the
+  // given rows may satisfy 'pred'.
+  Status MayHaveMatches(rowid_t ord_idx,
+                        size_t nrows,
+                        const ColumnPredicate& pred,
+                        bool* may_match) override;
+
+  // Reads the data blocks holding the 'nrows' rows starting at 'ord_idx' into
+  // the block cache, so that preparing a batch of those rows later on doesn't
+  // have to wait for the disk. Sets '*last_row_idx' to the last row held by
+  // the blocks that were read.
+  //
+  // Does nothing, other than setting '*last_row_idx' to the last requested row,
+  // if the iterator doesn't cache blocks or the file has no positional index.
+  //
+  // This does not change the position of the iterator, and may be called from
+  // a thread other than the one using the iterator, as long as the iterator
+  // isn't used concurrently.
+  Status ReadBlocksIntoCache(rowid_t ord_idx, size_t nrows, rowid_t* last_row_idx);
+
   // Return true if the next call to PrepareBatch will return at least one row.
   bool HasNext() const;
 
@@ -392,6 +443,11 @@ class CFileIterator : public ColumnIterator {
   // BinaryDictBlockDecoder.
   BinaryPlainBlockDecoder* GetDictDecoder() { return dict_decoder_.get(); }
 
+  // If the column is a dictionary-coded fixed-width column, returns its
+  // dictionary: the values, back to back, in codeword order. This is called
+  // by the NumericDictBlockDecoder.
+  Slice GetNumericDict() const { return numeric_dict_; }
+
   // If the column is dictionary-coded and a predicate on the column exists,
   // returns the set of codewords that pass the predicate. Since a vocabulary
   // is shared among the multiple BinaryDictBlockDecoders in a single cfile,
@@ -445,6 +501,17 @@ class CFileIterator : public ColumnIterator {
   // Seek the given PreparedBlock to the given index within it.
   void SeekToPositionInBlock(PreparedBlock *pb, uint32_t idx_in_block);
 
+  // Copy the next 'n' non-null values of 'pb' into 'dst', evaluating the
+  // predicate of 'ctx' if decoder-level evaluation is enabled. If 'ctx' only
+  // requires the selected rows to be materialized, values of long enough runs
+  // of rows which are not selected in 'sel' are skipped rather than decoded.
+  //
+  // The block must have at least 'n' values left.
+  Status CopyNextValuesFromBlock(PreparedBlock* pb, size_t n,
+                                 ColumnMaterializationContext* ctx,
+                                 SelectionVectorView* sel,
+                                 ColumnDataView* dst);
+
   // Read the data block currently pointed to by idx_iter_
   // into the given PreparedBlock structure.
   //
@@ -456,10 +523,19 @@ class CFileIterator : public ColumnIterator {
   // it onto the end of the prepared_blocks_ deque.
   Status QueueCurrentDataBlock(const IndexTreeIterator &idx_iter);
 
+  // If the iterator doesn't cache blocks, hints that the data blocks following
+  // 'b' will be read soon, as configured by --cfile_uncached_readahead_blocks.
+  // Scans which don't cache blocks are typically large and sequential, and
+  // otherwise pay for a synchronous read of every block.
+  Status MaybeReadAhead(const PreparedBlock& b);
+
   // Fully initialize the underlying cfile reader if needed, and clear any
   // seek-related state.
   Status PrepareForNewSeek();
 
+  // Read the dictionary block of a dictionary-coded fixed-width column.
+  Status ReadNumericDict();
+
   CFileReader* reader_;
 
   std::unique_ptr<IndexTreeIterator> posidx_iter_;
@@ -469,9 +545,18 @@ class CFileIterator : public ColumnIterator {
   std::unique_ptr<BinaryPlainBlockDecoder> dict_decoder_;
   BlockHandle dict_block_handle_;
 
+  // Dictionary values for fixed-width columns, pointing into
+  // dict_block_handle_.
+  Slice numeric_dict_;
+  bool numeric_dict_loaded_;
+
   // Set containing the codewords that match the predicate in a dictionary.
   std::unique_ptr<SelectionVector> codewords_matching_pred_;
 
+  // Reader for the per-data-block statistics, loaded on first use.
+  std::unique_ptr<ZoneMapReader> zone_map_reader_;
+  BlockHandle zone_map_block_handle_;
+
   // The currently in-use index iterator. This is equal to either
   // posidx_iter_.get(), validx_iter_.get(), or NULL if not seeked.
   IndexTreeIterator *seeked_;
@@ -504,6 +589,15 @@ class CFileIterator : public ColumnIterator {
 
   // a temporary buffer for encoding
   faststring tmp_buf_;
+
+  // Positioned at the last data block hinted by MaybeReadAhead(). Created on
+  // first use.
+  std::unique_ptr<IndexTreeIterator> readahead_iter_;
+
+  // Offset of the data block at which MaybeReadAhead() hints the next range,
+  // and the end of the range hinted last. Both are reset by seeks.
+  uint64_t readahead_trigger_offset_;
+  uint64_t readahead_end_offset_;
 };
 
 } // namespace cfile
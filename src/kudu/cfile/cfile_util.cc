@@ -46,8 +46,10 @@ WriterOptions::WriterOptions()
     block_restart_interval(16),
     write_posidx(false),
     write_validx(false),
+    write_zone_maps(false),
     optimize_index_keys(true),
-    validx_key_encoder(boost::none) {
+    validx_key_encoder(boost::none),
+    incompatible_features(IncompatibleFeatures::NONE) {
 }
 
 Status DumpIterator(const CFileReader& reader,
@@ -18,6 +18,7 @@
 #define CFILE_UTIL_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -49,7 +50,13 @@ enum IncompatibleFeatures {
   // Write a crc32 checksum at the end of each cfile block
   CHECKSUM = 1 << 0,
 
-  SUPPORTED = NONE | CHECKSUM
+  // Compress blocks using a dictionary trained on the first data blocks
+  COMPRESSION_DICT = 1 << 1,
+
+  // The blocks of a bloom file hold BlockBloomFilters
+  BLOCK_BLOOM = 1 << 2,
+
+  SUPPORTED = NONE | CHECKSUM | COMPRESSION_DICT | BLOCK_BLOOM
 };
 
 typedef std::function<void(const void*, faststring*)> ValidxKeyEncoder;
@@ -75,6 +82,12 @@ struct WriterOptions {
   // Whether the file needs a value index
   bool write_validx;
 
+  // Whether to record per-data-block statistics (min/max/null count) which
+  // allow readers to skip blocks that can't satisfy a predicate. Only takes
+  // effect for files with a positional index and for column types supported
+  // by ZoneMapBuilder.
+  bool write_zone_maps;
+
   // Whether to optimize index keys by storing shortest separating prefixes
   // instead of entire keys.
   bool optimize_index_keys;
@@ -89,6 +102,12 @@ struct WriterOptions {
   // encodes the entire value.
   boost::optional<ValidxKeyEncoder> validx_key_encoder;
 
+  // Incompatible features (see IncompatibleFeatures) of the contents of the
+  // raw blocks appended to the file, which the writer can't infer itself.
+  //
+  // Default: NONE
+  uint32_t incompatible_features;
+
   WriterOptions();
 };
 
@@ -17,8 +17,10 @@
 
 #include "kudu/cfile/cfile_writer.h"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <ostream>
 #include <utility>
@@ -34,6 +36,7 @@
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/key_encoder.h"
 #include "kudu/common/schema.h"
@@ -48,6 +51,7 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/hexdump.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/pb_util.h"
 
 DEFINE_int32(cfile_default_block_size, 256*1024, "The default block size to use in cfiles");
@@ -61,6 +65,51 @@ DEFINE_bool(cfile_write_checksums, true,
             "Write CRC32 checksums for each block");
 TAG_FLAG(cfile_write_checksums, evolving);
 
+DEFINE_bool(cfile_write_zone_maps, false,
+            "Write per-data-block min/max/null count statistics into column "
+            "cfiles, allowing scans to skip blocks which can't satisfy a predicate");
+TAG_FLAG(cfile_write_zone_maps, experimental);
+
+DEFINE_int32(cfile_compression_dict_sample_blocks, 0,
+             "Number of data blocks at the start of a compressed cfile which are "
+             "sampled to train a dictionary used to compress the rest of the file. "
+             "Only used with codecs which support dictionaries (LZ4 and ZLIB). "
+             "If 0, blocks are compressed without a dictionary.");
+TAG_FLAG(cfile_compression_dict_sample_blocks, experimental);
+
+DEFINE_int32(cfile_compression_dict_max_size, 16 * 1024,
+             "The maximum size in bytes of a cfile compression dictionary.");
+TAG_FLAG(cfile_compression_dict_max_size, experimental);
+
+DEFINE_bool(cfile_adaptive_block_size, false,
+            "Whether to adapt the size of data blocks to the compressibility of "
+            "their column. If true, the configured block size is the size targeted "
+            "for compressed data blocks: data blocks grow until they are expected "
+            "to compress to that size, up to --cfile_adaptive_max_block_size bytes "
+            "before compression. That limit also bounds the number of cells in each "
+            "data block, so blocks of highly compressible encodings do not decode "
+            "to an unbounded amount of memory.");
+TAG_FLAG(cfile_adaptive_block_size, experimental);
+
+DEFINE_int32(cfile_adaptive_max_block_size, 1024 * 1024,
+             "The maximum size in bytes of a data block before compression, and "
+             "of the cells it decodes to, when --cfile_adaptive_block_size is enabled.");
+TAG_FLAG(cfile_adaptive_max_block_size, experimental);
+
+DEFINE_int32(cfile_auto_encoding_sample_rows, 0,
+             "Number of rows at the start of a cfile whose column uses AUTO_ENCODING "
+             "which are buffered and trial-encoded with every encoding supported for "
+             "the column type, in order to choose the encoding of the file. If 0, "
+             "the default encoding of the type is used.");
+TAG_FLAG(cfile_auto_encoding_sample_rows, experimental);
+
+DEFINE_double(cfile_auto_encoding_min_size_ratio, 0.9,
+              "When choosing the encoding of a cfile from a sample, another encoding "
+              "is only preferred over the default encoding of the type, which is "
+              "chosen for its decoding speed, if it encodes the sample to at most "
+              "this fraction of the size achieved by the default encoding.");
+TAG_FLAG(cfile_auto_encoding_min_size_ratio, experimental);
+
 using google::protobuf::RepeatedPtrField;
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::BlockManager;
@@ -81,6 +130,10 @@ const size_t kChecksumSize = sizeof(uint32_t);
 
 static const size_t kMinBlockSize = 512;
 
+// Sampling for a compression dictionary stops early once this many times the
+// maximum dictionary size has been sampled, to bound the memory used.
+static const size_t kMaxCompressionDictSampleRatio = 64;
+
 ////////////////////////////////////////////////////////////
 // CFileWriter
 ////////////////////////////////////////////////////////////
@@ -96,6 +149,16 @@ CFileWriter::CFileWriter(WriterOptions options,
     options_(std::move(options)),
     is_nullable_(is_nullable),
     typeinfo_(typeinfo),
+    sample_for_compression_dict_(false),
+    compression_dict_sampled_blocks_(0),
+    compression_dict_start_offset_(0),
+    target_block_size_(0),
+    max_block_size_(0),
+    max_values_per_block_(0),
+    data_blocks_raw_size_(0),
+    data_blocks_written_size_(0),
+    encoding_sample_max_rows_(0),
+    encoding_sample_rows_(0),
     state_(kWriterInitialized) {
   EncodingType encoding = options_.storage_attributes.encoding;
   Status s = TypeEncodingInfo::Get(typeinfo_, encoding, &type_encoding_info_);
@@ -108,6 +171,12 @@ CFileWriter::CFileWriter(WriterOptions options,
                               &type_encoding_info_);
     CHECK_OK(s);
   }
+  if (encoding == AUTO_ENCODING && FLAGS_cfile_auto_encoding_sample_rows > 0) {
+    encoding_sample_max_rows_ = FLAGS_cfile_auto_encoding_sample_rows;
+    if (typeinfo_->physical_type() == BINARY) {
+      encoding_sample_arena_.reset(new Arena(16 * 1024));
+    }
+  }
 
   compression_ = options_.storage_attributes.compression;
   if (compression_ == DEFAULT_COMPRESSION) {
@@ -124,10 +193,21 @@ CFileWriter::CFileWriter(WriterOptions options,
     options_.storage_attributes.cfile_block_size = kMinBlockSize;
   }
 
+  if (FLAGS_cfile_adaptive_block_size) {
+    target_block_size_ = options_.storage_attributes.cfile_block_size;
+    max_block_size_ = std::max(target_block_size_, FLAGS_cfile_adaptive_max_block_size);
+    max_values_per_block_ = std::max<size_t>(max_block_size_ / typeinfo_->size(), 1);
+  }
+
   if (options_.write_posidx) {
     posidx_builder_.reset(new IndexTreeBuilder(&options_, this));
   }
 
+  if (options_.write_posidx && options_.write_zone_maps &&
+      ZoneMapBuilder::IsTypeSupported(typeinfo_)) {
+    zone_map_builder_.reset(new ZoneMapBuilder(typeinfo_));
+  }
+
   if (options_.write_validx) {
     if (!options_.validx_key_encoder) {
       auto key_encoder = &GetKeyEncoder<faststring>(typeinfo_);
@@ -152,6 +232,9 @@ Status CFileWriter::Start() {
     const CompressionCodec* codec;
     RETURN_NOT_OK(GetCompressionCodec(compression_, &codec));
     block_compressor_.reset(new CompressedBlockBuilder(codec));
+    sample_for_compression_dict_ = FLAGS_cfile_compression_dict_sample_blocks > 0 &&
+                                   FLAGS_cfile_compression_dict_max_size > 0 &&
+                                   codec->SupportsDictionary();
   }
 
   CFileHeaderPB header;
@@ -205,12 +288,17 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   CHECK(state_ == kWriterWriting) <<
     "Bad state for Finish(): " << state_;
 
+  // If the encoding is yet to be chosen, choose it from the rows written so far.
+  if (encoding_sample_max_rows_ > 0) {
+    RETURN_NOT_OK(ChooseEncodingFromSample());
+  }
+
   // Write out any pending values as the last data block.
   RETURN_NOT_OK(FinishCurDataBlock());
 
   state_ = kWriterFinished;
 
-  uint32_t incompatible_features = 0;
+  uint32_t incompatible_features = options_.incompatible_features;
   if (FLAGS_cfile_write_checksums) {
     incompatible_features |= IncompatibleFeatures::CHECKSUM;
   }
@@ -232,6 +320,14 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
     footer.mutable_posidx_info()->CopyFrom(posidx_info);
   }
 
+  if (zone_map_builder_ != nullptr && zone_map_builder_->num_blocks() > 0) {
+    BlockPointer zone_map_ptr;
+    RETURN_NOT_OK_PREPEND(AddBlock({ zone_map_builder_->Finish() }, &zone_map_ptr,
+                                   "zone map block"),
+                          "Couldn't write zone maps");
+    zone_map_ptr.CopyToPB(footer.mutable_zone_map_block_ptr());
+  }
+
   if (options_.write_validx) {
     BTreeInfoPB validx_info;
     RETURN_NOT_OK_PREPEND(validx_builder_->Finish(&validx_info), "Couldn't write value index");
@@ -242,6 +338,19 @@ Status CFileWriter::FinishAndReleaseBlock(BlockCreationTransaction* transaction)
   // Example: dictionary block for dictionary encoding
   RETURN_NOT_OK(data_block_->AppendExtraInfo(this, &footer));
 
+  // The compression dictionary goes last, since every block written before
+  // it may depend on it.
+  if (compression_dict_.size() > 0) {
+    BlockPointer dict_ptr;
+    RETURN_NOT_OK_PREPEND(WriteBlock({ Slice(compression_dict_) }, &dict_ptr,
+                                     "compression dictionary block"),
+                          "Couldn't write compression dictionary");
+    dict_ptr.CopyToPB(footer.mutable_compression_dict_block_ptr());
+    footer.set_compression_dict_start_offset(compression_dict_start_offset_);
+    footer.set_incompatible_features(footer.incompatible_features() |
+                                     IncompatibleFeatures::COMPRESSION_DICT);
+  }
+
   // Flush metadata.
   FlushMetadataToPB(footer.mutable_metadata());
 
@@ -298,19 +407,33 @@ void CFileWriter::FlushMetadataToPB(RepeatedPtrField<FileMetadataPairPB> *field)
 Status CFileWriter::AppendEntries(const void *entries, size_t count) {
   DCHECK(!is_nullable_);
 
-  int rem = count;
-
   const uint8_t *ptr = reinterpret_cast<const uint8_t *>(entries);
 
+  if (PREDICT_FALSE(encoding_sample_max_rows_ > 0)) {
+    size_t n = std::min(count, encoding_sample_max_rows_ - encoding_sample_rows_);
+    AddToEncodingSample(nullptr, ptr, n);
+    if (encoding_sample_rows_ < encoding_sample_max_rows_) {
+      return Status::OK();
+    }
+    RETURN_NOT_OK(ChooseEncodingFromSample());
+    ptr += typeinfo_->size() * n;
+    count -= n;
+  }
+
+  int rem = count;
+
   while (rem > 0) {
-    int n = data_block_->Add(ptr, rem);
+    int n = data_block_->Add(ptr, std::min<size_t>(rem, CurDataBlockValueCapacity()));
     DCHECK_GE(n, 0);
+    if (zone_map_builder_ != nullptr) {
+      zone_map_builder_->AddValues(ptr, n);
+    }
 
     ptr += typeinfo_->size() * n;
     rem -= n;
     value_count_ += n;
 
-    if (data_block_->IsBlockFull()) {
+    if (IsCurDataBlockFull()) {
       RETURN_NOT_OK(FinishCurDataBlock());
     }
   }
@@ -326,6 +449,23 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
 
   const uint8_t *ptr = reinterpret_cast<const uint8_t *>(entries);
 
+  if (PREDICT_FALSE(encoding_sample_max_rows_ > 0)) {
+    size_t n = std::min(count, encoding_sample_max_rows_ - encoding_sample_rows_);
+    AddToEncodingSample(bitmap, ptr, n);
+    if (encoding_sample_rows_ < encoding_sample_max_rows_) {
+      return Status::OK();
+    }
+    RETURN_NOT_OK(ChooseEncodingFromSample());
+    if (n == count) {
+      return Status::OK();
+    }
+    // The null bitmap of the remaining rows doesn't start on a byte boundary.
+    faststring rem_bitmap;
+    rem_bitmap.resize(BitmapSize(count - n));
+    BitmapCopy(rem_bitmap.data(), 0, bitmap, n, count - n);
+    return AppendNullableEntries(rem_bitmap.data(), ptr + typeinfo_->size() * n, count - n);
+  }
+
   size_t nitems;
   bool is_non_null = false;
   BitmapIterator bmap_iter(bitmap, count);
@@ -333,21 +473,27 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
     if (is_non_null) {
       size_t rem = nitems;
       do {
-        int n = data_block_->Add(ptr, rem);
+        int n = data_block_->Add(ptr, std::min(rem, CurDataBlockValueCapacity()));
         DCHECK_GE(n, 0);
+        if (zone_map_builder_ != nullptr) {
+          zone_map_builder_->AddValues(ptr, n);
+        }
 
         non_null_bitmap_builder_->AddRun(true, n);
         ptr += n * typeinfo_->size();
         value_count_ += n;
         rem -= n;
 
-        if (data_block_->IsBlockFull()) {
+        if (IsCurDataBlockFull()) {
           RETURN_NOT_OK(FinishCurDataBlock());
         }
 
       } while (rem > 0);
     } else {
       non_null_bitmap_builder_->AddRun(false, nitems);
+      if (zone_map_builder_ != nullptr) {
+        zone_map_builder_->AddNulls(nitems);
+      }
       ptr += nitems * typeinfo_->size();
       value_count_ += nitems;
     }
@@ -356,12 +502,175 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
   return Status::OK();
 }
 
-Status CFileWriter::FinishCurDataBlock() {
-  uint32_t num_elems_in_block = data_block_->Count();
+void CFileWriter::AddToEncodingSample(const uint8_t* bitmap,
+                                      const uint8_t* entries,
+                                      size_t count) {
+  const size_t first_row = encoding_sample_rows_;
+  encoding_sample_cells_.append(entries, count * typeinfo_->size());
+  if (bitmap != nullptr) {
+    encoding_sample_non_null_bitmap_.resize(BitmapSize(first_row + count));
+    BitmapCopy(encoding_sample_non_null_bitmap_.data(), first_row, bitmap, 0, count);
+  }
+  if (encoding_sample_arena_) {
+    // The cells point to data owned by the caller: make copies which outlive
+    // this call.
+    Slice* cells = reinterpret_cast<Slice*>(encoding_sample_cells_.data()) + first_row;
+    for (size_t i = 0; i < count; i++) {
+      if (bitmap == nullptr || BitmapTest(bitmap, i)) {
+        CHECK(encoding_sample_arena_->RelocateSlice(cells[i], &cells[i]));
+      }
+    }
+  }
+  encoding_sample_rows_ += count;
+}
+
+Status CFileWriter::TrialEncode(const TypeEncodingInfo* type_encoding_info,
+                                const uint8_t* values,
+                                size_t count,
+                                uint64_t* encoded_size) {
+  unique_ptr<BlockBuilder> builder;
+  RETURN_NOT_OK(type_encoding_info->CreateBlockBuilder(&builder, &options_));
+
+  uint64_t total_size = 0;
+  vector<Slice> slices;
+  vector<Slice> compressed_slices;
+  while (count > 0) {
+    int n = builder->Add(values, count);
+    DCHECK_GE(n, 0);
+    values += typeinfo_->size() * n;
+    count -= n;
+    if (count > 0 && !builder->IsBlockFull()) {
+      continue;
+    }
+    slices.clear();
+    builder->Finish(0, &slices);
+    if (block_compressor_) {
+      RETURN_NOT_OK(block_compressor_->Compress(slices, &compressed_slices));
+      slices.swap(compressed_slices);
+    }
+    for (const Slice& slice : slices) {
+      total_size += slice.size();
+    }
+    builder->Reset();
+  }
+  *encoded_size = total_size + builder->EstimateExtraInfoSize();
+  return Status::OK();
+}
+
+Status CFileWriter::ChooseEncodingFromSample() {
+  encoding_sample_max_rows_ = 0;
+  const faststring& cells = encoding_sample_cells_;
+  const faststring& non_null_bitmap = encoding_sample_non_null_bitmap_;
+  const size_t num_rows = encoding_sample_rows_;
+  encoding_sample_rows_ = 0;
+
+  // Gather the non-null values of the sample.
+  const uint8_t* values = cells.data();
+  size_t num_values = num_rows;
+  faststring non_null_values;
   if (is_nullable_) {
-    num_elems_in_block = non_null_bitmap_builder_->nitems();
+    num_values = 0;
+    size_t nitems;
+    bool is_non_null = false;
+    BitmapIterator bmap_iter(non_null_bitmap.data(), num_rows);
+    const uint8_t* ptr = cells.data();
+    while ((nitems = bmap_iter.Next(&is_non_null)) > 0) {
+      if (is_non_null) {
+        non_null_values.append(ptr, nitems * typeinfo_->size());
+        num_values += nitems;
+      }
+      ptr += nitems * typeinfo_->size();
+    }
+    values = non_null_values.data();
   }
 
+  if (num_values > 0) {
+    const TypeEncodingInfo* best = type_encoding_info_;
+    uint64_t default_size;
+    RETURN_NOT_OK(TrialEncode(type_encoding_info_, values, num_values, &default_size));
+    uint64_t best_size = default_size;
+    for (EncodingType encoding : TypeEncodingInfo::GetSupportedEncodings(typeinfo_)) {
+      if (encoding == type_encoding_info_->encoding_type()) {
+        continue;
+      }
+      const TypeEncodingInfo* candidate;
+      RETURN_NOT_OK(TypeEncodingInfo::Get(typeinfo_, encoding, &candidate));
+      uint64_t size;
+      RETURN_NOT_OK(TrialEncode(candidate, values, num_values, &size));
+      VLOG(2) << "Sample of " << num_values << " values takes " << size << " bytes with "
+              << EncodingType_Name(encoding);
+      if (size < best_size) {
+        best = candidate;
+        best_size = size;
+      }
+    }
+    if (best_size > default_size * FLAGS_cfile_auto_encoding_min_size_ratio) {
+      best = type_encoding_info_;
+    }
+    if (best != type_encoding_info_) {
+      VLOG(1) << "Using " << EncodingType_Name(best->encoding_type()) << " instead of "
+              << EncodingType_Name(type_encoding_info_->encoding_type())
+              << ", which takes " << default_size << " bytes rather than " << best_size
+              << " for a sample of " << num_values << " values";
+      type_encoding_info_ = best;
+      RETURN_NOT_OK(type_encoding_info_->CreateBlockBuilder(&data_block_, &options_));
+    }
+  }
+
+  // Write the buffered rows with the chosen encoding. The copies of the
+  // sampled cells may be discarded afterwards: the block builders copy the
+  // values they are given.
+  Status s = is_nullable_ ? AppendNullableEntries(non_null_bitmap.data(), cells.data(), num_rows)
+                          : AppendEntries(cells.data(), num_rows);
+  encoding_sample_cells_.clear();
+  encoding_sample_cells_.shrink_to_fit();
+  encoding_sample_non_null_bitmap_.clear();
+  encoding_sample_non_null_bitmap_.shrink_to_fit();
+  encoding_sample_arena_.reset();
+  return s;
+}
+
+size_t CFileWriter::CurDataBlockNumRows() const {
+  return is_nullable_ ? non_null_bitmap_builder_->nitems() : data_block_->Count();
+}
+
+size_t CFileWriter::CurDataBlockValueCapacity() const {
+  if (max_values_per_block_ == 0) {
+    return std::numeric_limits<size_t>::max();
+  }
+  // Runs of nulls may take the block past the limit: still let the next
+  // value in, so that the block fills up and gets finished.
+  size_t num_rows = CurDataBlockNumRows();
+  return num_rows < max_values_per_block_ ? max_values_per_block_ - num_rows : 1;
+}
+
+bool CFileWriter::IsCurDataBlockFull() const {
+  return data_block_->IsBlockFull() ||
+      (max_values_per_block_ > 0 && CurDataBlockNumRows() >= max_values_per_block_);
+}
+
+void CFileWriter::AdaptBlockSize(size_t raw_size, size_t written_size) {
+  data_blocks_raw_size_ += raw_size;
+  data_blocks_written_size_ += written_size;
+  if (block_compressor_ == nullptr || data_blocks_written_size_ == 0) {
+    return;
+  }
+  // Size the next blocks so that, at the compression ratio observed on the
+  // blocks written so far, they compress to about the target size.
+  uint64_t ratio_block_size =
+      target_block_size_ * data_blocks_raw_size_ / data_blocks_written_size_;
+  int32_t block_size = static_cast<int32_t>(std::min<uint64_t>(
+      std::max<uint64_t>(ratio_block_size, target_block_size_), max_block_size_));
+  if (block_size != options_.storage_attributes.cfile_block_size) {
+    VLOG(2) << "Adjusting data block size from " << options_.storage_attributes.cfile_block_size
+            << " to " << block_size << " bytes";
+    options_.storage_attributes.cfile_block_size = block_size;
+  }
+}
+
+Status CFileWriter::FinishCurDataBlock() {
+  uint32_t num_elems_in_block = CurDataBlockNumRows();
+
   if (PREDICT_FALSE(num_elems_in_block == 0)) {
     return Status::OK();
   }
@@ -370,6 +679,10 @@ Status CFileWriter::FinishCurDataBlock() {
   VLOG(1) << "Appending data block for values " <<
     first_elem_ord << "-" << value_count_;
 
+  if (zone_map_builder_ != nullptr) {
+    zone_map_builder_->FinishBlock(first_elem_ord, num_elems_in_block);
+  }
+
   // The current data block is full, need to push it
   // into the file, and add to index
   vector<Slice> data_slices;
@@ -394,10 +707,22 @@ Status CFileWriter::FinishCurDataBlock() {
     v.push_back(non_null_bitmap);
   }
   std::move(data_slices.begin(), data_slices.end(), std::back_inserter(v));
+  BlockPointer block_ptr;
   Status s = AppendRawBlock(v, first_elem_ord,
                             reinterpret_cast<const void *>(key_tmp_space),
                             Slice(last_key_),
-                            "data block");
+                            "data block",
+                            &block_ptr);
+  if (s.ok() && sample_for_compression_dict_) {
+    SampleForCompressionDict(v);
+  }
+  if (s.ok() && target_block_size_ > 0) {
+    size_t raw_size = accumulate(v.begin(), v.end(), static_cast<size_t>(0),
+                                 [](size_t sum, const Slice& curr) {
+                                   return sum + curr.size();
+                                 });
+    AdaptBlockSize(raw_size, block_ptr.size());
+  }
 
   if (is_nullable_) {
     non_null_bitmap_builder_->Reset();
@@ -416,7 +741,8 @@ Status CFileWriter::AppendRawBlock(const vector<Slice>& data_slices,
                                    size_t ordinal_pos,
                                    const void *validx_curr,
                                    const Slice& validx_prev,
-                                   const char *name_for_log) {
+                                   const char *name_for_log,
+                                   BlockPointer *block_ptr) {
   CHECK_EQ(state_, kWriterWriting);
 
   BlockPointer ptr;
@@ -425,6 +751,9 @@ Status CFileWriter::AppendRawBlock(const vector<Slice>& data_slices,
     LOG(WARNING) << "Unable to append block to file: " << s.ToString();
     return s;
   }
+  if (block_ptr != nullptr) {
+    *block_ptr = ptr;
+  }
 
   // Now add to the index blocks
   if (posidx_builder_ != nullptr) {
@@ -454,23 +783,53 @@ Status CFileWriter::AppendRawBlock(const vector<Slice>& data_slices,
   return s;
 }
 
+void CFileWriter::SampleForCompressionDict(const vector<Slice>& data_slices) {
+  for (const Slice& data : data_slices) {
+    compression_dict_samples_.append(data.data(), data.size());
+  }
+  compression_dict_sampled_blocks_++;
+  size_t max_dict_size = FLAGS_cfile_compression_dict_max_size;
+  if (compression_dict_sampled_blocks_ < FLAGS_cfile_compression_dict_sample_blocks &&
+      compression_dict_samples_.size() < kMaxCompressionDictSampleRatio * max_dict_size) {
+    return;
+  }
+
+  TrainCompressionDictionary({ Slice(compression_dict_samples_) }, max_dict_size,
+                             &compression_dict_);
+  if (compression_dict_.size() > 0) {
+    VLOG(1) << "Trained a " << compression_dict_.size() << "-byte compression dictionary from "
+            << compression_dict_samples_.size() << " bytes of " << compression_dict_sampled_blocks_
+            << " data blocks";
+    block_compressor_->SetDictionary(Slice(compression_dict_));
+    compression_dict_start_offset_ = off_;
+  }
+  sample_for_compression_dict_ = false;
+  compression_dict_samples_.clear();
+  compression_dict_samples_.shrink_to_fit();
+}
+
 Status CFileWriter::AddBlock(const vector<Slice> &data_slices,
                              BlockPointer *block_ptr,
                              const char *name_for_log) {
-  uint64_t start_offset = off_;
-  vector<Slice> out_slices;
+  if (block_compressor_ == nullptr) {
+    return WriteBlock(data_slices, block_ptr, name_for_log);
+  }
 
-  if (block_compressor_ != nullptr) {
-    // Write compressed block
-    Status s = block_compressor_->Compress(data_slices, &out_slices);
-    if (!s.ok()) {
-      LOG(WARNING) << "Unable to compress block at offset " << off_
-                   << ": " << s.ToString();
-      return s;
-    }
-  } else {
-    out_slices = data_slices;
+  // Write compressed block
+  vector<Slice> out_slices;
+  Status s = block_compressor_->Compress(data_slices, &out_slices);
+  if (!s.ok()) {
+    LOG(WARNING) << "Unable to compress block at offset " << off_
+                 << ": " << s.ToString();
+    return s;
   }
+  return WriteBlock(std::move(out_slices), block_ptr, name_for_log);
+}
+
+Status CFileWriter::WriteBlock(vector<Slice> out_slices,
+                               BlockPointer *block_ptr,
+                               const char *name_for_log) {
+  uint64_t start_offset = off_;
 
   // Calculate and append a data checksum.
   uint8_t checksum_buf[kChecksumSize];
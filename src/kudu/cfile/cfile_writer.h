@@ -37,6 +37,7 @@
 
 namespace kudu {
 
+class Arena;
 class TypeInfo;
 
 namespace cfile {
@@ -47,6 +48,7 @@ class CompressedBlockBuilder;
 class FileMetadataPairPB;
 class IndexTreeBuilder;
 class TypeEncodingInfo;
+class ZoneMapBuilder;
 
 // Magic used in header/footer
 extern const char kMagicStringV1[];
@@ -141,11 +143,14 @@ class CFileWriter {
   //
   // validx_prev should be a Slice pointing to the last key of the previous block.
   // It will be used to optimize the value index entry for the block.
+  //
+  // If block_ptr is not NULL, it is set to the location of the appended block.
   Status AppendRawBlock(const std::vector<Slice> &data_slices,
                         size_t ordinal_pos,
                         const void *validx_curr,
                         const Slice &validx_prev,
-                        const char *name_for_log);
+                        const char *name_for_log,
+                        BlockPointer *block_ptr = nullptr);
 
 
   // Return the amount of data written so far to this CFile.
@@ -161,7 +166,7 @@ class CFileWriter {
   // This includes NULL cells, but does not include any "raw" blocks
   // appended.
   int written_value_count() const {
-    return value_count_;
+    return value_count_ + encoding_sample_rows_;
   }
 
   std::string ToString() const { return block_->id().ToString(); }
@@ -187,10 +192,53 @@ class CFileWriter {
                   BlockPointer *block_ptr,
                   const char *name_for_log);
 
+  // Append the given data into the file as a block, without compressing it.
+  //
+  // Sets *block_ptr to correspond to the newly inserted block.
+  Status WriteBlock(std::vector<Slice> out_slices,
+                    BlockPointer *block_ptr,
+                    const char *name_for_log);
+
+  // Accumulate the given data block into the samples for the compression
+  // dictionary, and train the dictionary once enough data has been sampled.
+  void SampleForCompressionDict(const std::vector<Slice>& data_slices);
+
   Status WriteRawData(const std::vector<Slice>& data);
 
   Status FinishCurDataBlock();
 
+  // Buffer 'count' rows, and their null bitmap if the column is nullable,
+  // into the sample used to choose the encoding of the file.
+  void AddToEncodingSample(const uint8_t* bitmap, const uint8_t* entries, size_t count);
+
+  // Encode the 'count' non-null 'values' with the given encoding, setting
+  // 'encoded_size' to the number of bytes the resulting blocks take once
+  // compressed, including any extra information (e.g. a dictionary).
+  Status TrialEncode(const TypeEncodingInfo* type_encoding_info,
+                     const uint8_t* values,
+                     size_t count,
+                     uint64_t* encoded_size);
+
+  // Choose the encoding of the file by trial-encoding the sampled rows with
+  // each encoding supported for the type, and append the sampled rows.
+  Status ChooseEncodingFromSample();
+
+  // Return the number of rows, including nulls, in the current data block.
+  size_t CurDataBlockNumRows() const;
+
+  // Return the number of rows which may still be added to the current data
+  // block before it holds the maximum number of values per block. This is
+  // at least 1.
+  size_t CurDataBlockValueCapacity() const;
+
+  // Return true if the current data block should be finished.
+  bool IsCurDataBlockFull() const;
+
+  // Account for a data block of 'raw_size' bytes which took 'written_size'
+  // bytes in the file, and adjust the size of the next data blocks to the
+  // compression ratio observed so far.
+  void AdaptBlockSize(size_t raw_size, size_t written_size);
+
   // Flush the current unflushed_metadata_ entries into the given protobuf
   // field, clearing the buffer.
   void FlushMetadataToPB(google::protobuf::RepeatedPtrField<FileMetadataPairPB> *field);
@@ -228,6 +276,42 @@ class CFileWriter {
   std::unique_ptr<NullBitmapBuilder> non_null_bitmap_builder_;
   std::unique_ptr<CompressedBlockBuilder> block_compressor_;
 
+  // Per-data-block statistics. Only set if zone maps are being written.
+  std::unique_ptr<ZoneMapBuilder> zone_map_builder_;
+
+  // Data sampled from the first data blocks, while a compression dictionary
+  // is yet to be trained.
+  bool sample_for_compression_dict_;
+  int compression_dict_sampled_blocks_;
+  faststring compression_dict_samples_;
+
+  // The trained compression dictionary, if any, and the offset of the first
+  // block compressed with it.
+  faststring compression_dict_;
+  uint64_t compression_dict_start_offset_;
+
+  // Only set if the size of data blocks adapts to the compressibility of the
+  // column: the targeted size of compressed data blocks, the maximum size of
+  // data blocks before compression and the maximum number of rows per block.
+  int32_t target_block_size_;
+  int32_t max_block_size_;
+  size_t max_values_per_block_;
+
+  // The total size of the data blocks written so far, before and after
+  // compression.
+  uint64_t data_blocks_raw_size_;
+  uint64_t data_blocks_written_size_;
+
+  // Rows buffered until the encoding of the file is chosen, if the column
+  // uses AUTO_ENCODING and encodings are chosen from a sample. Once the
+  // encoding is chosen, 'encoding_sample_max_rows_' is 0.
+  size_t encoding_sample_max_rows_;
+  size_t encoding_sample_rows_;
+  faststring encoding_sample_cells_;
+  faststring encoding_sample_non_null_bitmap_;
+  // Holds copies of the data of sampled BINARY cells.
+  std::unique_ptr<Arena> encoding_sample_arena_;
+
   enum State {
     kWriterInitialized,
     kWriterWriting,
@@ -29,6 +29,7 @@
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -39,8 +40,11 @@
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/port.h"
@@ -494,6 +498,52 @@ class TestEncoding : public KuduTest {
     }
   }
 
+  // Test evaluating a range predicate in the decoder while copying the
+  // values of an integer block out.
+  template <DataType IntType>
+  void TestCopyNextAndEval(EncodingType encoding) {
+    typedef typename TypeTraits<IntType>::cpp_type CppType;
+    const int kSize = 10000;
+    vector<CppType> src(kSize);
+    for (int i = 0; i < kSize; i++) {
+      src[i] = i % 100;
+    }
+    auto bb = CreateBlockBuilderOrDie(IntType, encoding);
+    bb->Add(reinterpret_cast<const uint8_t*>(src.data()), kSize);
+    Slice s = FinishAndMakeContiguous(bb.get(), 0);
+
+    for (const auto& bounds : vector<std::pair<CppType, CppType>>{ {10, 20}, {0, 100},
+                                                                   {100, 120} }) {
+      SCOPED_TRACE(bounds.first);
+      auto bd = CreateBlockDecoderOrDie(IntType, encoding, s);
+      ASSERT_OK(bd->ParseHeader());
+      ColumnSchema col("c", IntType);
+      ColumnPredicate pred = ColumnPredicate::Range(col, &bounds.first, &bounds.second);
+
+      vector<CppType> decoded(kSize);
+      ColumnBlock dst_block(GetTypeInfo(IntType), nullptr, decoded.data(), kSize, &arena_);
+      SelectionVector sel(kSize);
+      sel.SetAllTrue();
+      ColumnMaterializationContext ctx(0, &pred, &dst_block, &sel);
+      ColumnDataView dst(&dst_block);
+      SelectionVectorView sel_view(&sel);
+      while (bd->HasNext()) {
+        size_t n = std::min<size_t>((random() % 30) + 1, dst.nrows());
+        ASSERT_OK(bd->CopyNextAndEval(&n, &ctx, &sel_view, &dst));
+        dst.Advance(n);
+        sel_view.Advance(n);
+      }
+      ASSERT_FALSE(ctx.DecoderEvalNotSupported());
+      for (int i = 0; i < kSize; i++) {
+        bool expected = src[i] >= bounds.first && src[i] < bounds.second;
+        ASSERT_EQ(expected, sel.IsRowSelected(i)) << "at index " << i;
+        if (expected) {
+          ASSERT_EQ(src[i], decoded[i]) << "at index " << i;
+        }
+      }
+    }
+  }
+
   // Test truncation of blocks
   template<class DecoderType>
   void TestBinaryBlockTruncation(EncodingType encoding) {
@@ -729,6 +779,46 @@ TEST_F(TestEncoding, TestBShufInt32BlockEncoder) {
   }
 }
 
+// Test reading a whole bitshuffle block at once, which unshuffles it straight
+// into the destination, and then accessing the block again.
+TEST_F(TestEncoding, TestBShufCopyWholeBlock) {
+  // The number of values isn't a multiple of 8, so that the block is padded.
+  const size_t kSize = 1001;
+  for (uint32_t max_value : { 200U, 60000U, 4000000000U }) {
+    SCOPED_TRACE(max_value);
+    vector<uint32_t> src(kSize);
+    for (size_t i = 0; i < kSize; i++) {
+      src[i] = static_cast<uint64_t>(i) * max_value / kSize;
+    }
+    auto bb = CreateBlockBuilderOrDie(UINT32, BIT_SHUFFLE);
+    bb->Add(reinterpret_cast<const uint8_t*>(src.data()), kSize);
+    Slice s = FinishAndMakeContiguous(bb.get(), 0);
+
+    auto bd = CreateBlockDecoderOrDie(UINT32, BIT_SHUFFLE, s);
+    ASSERT_OK(bd->ParseHeader());
+    ScopedColumnBlock<UINT32> cb(kSize + 7);
+    ColumnDataView dst(&cb);
+    size_t n = kSize;
+    ASSERT_OK(bd->CopyNextValues(&n, &dst));
+    ASSERT_EQ(kSize, n);
+    ASSERT_FALSE(bd->HasNext());
+    for (size_t i = 0; i < kSize; i++) {
+      ASSERT_EQ(src[i], cb[i]) << "at index " << i;
+    }
+
+    // Seeking back requires the block to be unshuffled again.
+    bd->SeekToPositionInBlock(kSize / 2);
+    uint32_t ret;
+    CopyOne<UINT32>(bd.get(), &ret);
+    ASSERT_EQ(src[kSize / 2], ret);
+    bool exact;
+    ASSERT_OK(bd->SeekAtOrAfterValue(&src[10], &exact));
+    ASSERT_TRUE(exact);
+    CopyOne<UINT32>(bd.get(), &ret);
+    ASSERT_EQ(src[10], ret);
+  }
+}
+
 TEST_F(TestEncoding, TestBShufInt64BlockEncoder) {
   using limits = std::numeric_limits<int64_t>;
   Random rng(SeedRandom());
@@ -780,6 +870,76 @@ TEST_F(TestEncoding, TestBShufDoubleBlockEncoder) {
   TestEncodeDecodeTemplateBlockEncoder<DOUBLE>(doubles.get(), kSize, BIT_SHUFFLE);
 }
 
+// Test for frame-of-reference block, for INT32 and INT64.
+TEST_F(TestEncoding, TestForInt32BlockEncoder) {
+  using limits = std::numeric_limits<int32_t>;
+  Random rng(SeedRandom());
+  auto sequences = {
+      CreateRandomIntegersInRange<int32_t>(10000, 1000, 2000, &rng),
+      CreateRandomIntegersInRange<int32_t>(10000, 0, limits::max(), &rng),
+      CreateRandomIntegersInRange<int32_t>(10000, limits::min(), limits::max(), &rng)
+  };
+  for (const auto& ints : sequences) {
+    TestEncodeDecodeTemplateBlockEncoder<INT32>(ints.data(), ints.size(), FOR_BITPACK);
+  }
+}
+
+TEST_F(TestEncoding, TestForInt64BlockEncoder) {
+  using limits = std::numeric_limits<int64_t>;
+  Random rng(SeedRandom());
+  auto sequences = {
+      CreateRandomIntegersInRange<int64_t>(10000, 1000, 2000, &rng),
+      CreateRandomIntegersInRange<int64_t>(10000, 0, limits::max(), &rng),
+      CreateRandomIntegersInRange<int64_t>(10000, limits::min(), limits::max(), &rng)
+  };
+  for (const auto& ints : sequences) {
+    TestEncodeDecodeTemplateBlockEncoder<INT64>(ints.data(), ints.size(), FOR_BITPACK);
+  }
+}
+
+// Test that monotonically increasing values are packed at the minimal width,
+// and that a block of identical values takes no space beyond its header.
+TEST_F(TestEncoding, TestForBlockBitWidth) {
+  const int kSize = 10000;
+  vector<int64_t> ints(kSize);
+  for (int i = 0; i < kSize; i++) {
+    ints[i] = 1600000000000000L + i;
+  }
+  auto bb = CreateBlockBuilderOrDie(INT64, FOR_BITPACK);
+  bb->Add(reinterpret_cast<const uint8_t*>(ints.data()), kSize);
+  Slice s = FinishAndMakeContiguous(bb.get(), 0);
+  // 10000 values only need 14 bits each.
+  ASSERT_GT(s.size(), kSize * 14 / 8);
+  ASSERT_LT(s.size(), kSize * 14 / 8 + 64);
+  TestEncodeDecodeTemplateBlockEncoder<INT64>(ints.data(), ints.size(), FOR_BITPACK);
+
+  std::fill(ints.begin(), ints.end(), -12345);
+  bb->Reset();
+  bb->Add(reinterpret_cast<const uint8_t*>(ints.data()), kSize);
+  s = FinishAndMakeContiguous(bb.get(), 0);
+  ASSERT_LT(s.size(), 64);
+  TestEncodeDecodeTemplateBlockEncoder<INT64>(ints.data(), ints.size(), FOR_BITPACK);
+}
+
+TEST_F(TestEncoding, TestBShufCopyNextAndEval) {
+  TestCopyNextAndEval<INT32>(BIT_SHUFFLE);
+  TestCopyNextAndEval<INT64>(BIT_SHUFFLE);
+  TestCopyNextAndEval<DOUBLE>(BIT_SHUFFLE);
+}
+
+TEST_F(TestEncoding, TestForCopyNextAndEval) {
+  TestCopyNextAndEval<INT32>(FOR_BITPACK);
+  TestCopyNextAndEval<UINT64>(FOR_BITPACK);
+}
+
+TEST_F(TestEncoding, TestRleCopyNextAndEval) {
+  TestCopyNextAndEval<INT16>(RLE);
+}
+
+TEST_F(TestEncoding, TestForEmptyBlockEncodeDecode) {
+  TestEmptyBlockEncodeDecode(INT32, FOR_BITPACK);
+}
+
 TEST_F(TestEncoding, TestRleIntBlockEncoder) {
   auto ibb = CreateBlockBuilderOrDie(UINT32, RLE);
   Random rand(SeedRandom());
@@ -819,6 +979,10 @@ TEST_F(TestEncoding, TestBinaryPlainBlockBuilderSeekByValueSmallBlock) {
   TestBinarySeekByValueSmallBlock(PLAIN_ENCODING);
 }
 
+TEST_F(TestEncoding, TestFsstBlockBuilderSeekByValueSmallBlock) {
+  TestBinarySeekByValueSmallBlock(FSST_ENCODING);
+}
+
 // Test seeking to a value in a large block which contains
 // many 'restarts'
 TEST_F(TestEncoding, TestBinaryPrefixBlockBuilderSeekByValueLargeBlock) {
@@ -829,6 +993,10 @@ TEST_F(TestEncoding, TestBinaryPlainBlockBuilderSeekByValueLargeBlock) {
   TestStringSeekByValueLargeBlock(PLAIN_ENCODING);
 }
 
+TEST_F(TestEncoding, TestFsstBlockBuilderSeekByValueLargeBlock) {
+  TestStringSeekByValueLargeBlock(FSST_ENCODING);
+}
+
 // Test round-trip encode/decode of a binary block.
 TEST_F(TestEncoding, TestBinaryPrefixBlockBuilderRoundTrip) {
   TestBinaryBlockRoundTrip(PREFIX_ENCODING);
@@ -838,6 +1006,10 @@ TEST_F(TestEncoding, TestBinaryPlainBlockBuilderRoundTrip) {
   TestBinaryBlockRoundTrip(PLAIN_ENCODING);
 }
 
+TEST_F(TestEncoding, TestFsstBlockBuilderRoundTrip) {
+  TestBinaryBlockRoundTrip(FSST_ENCODING);
+}
+
 // Test empty block encode/decode
 TEST_F(TestEncoding, TestBinaryPlainEmptyBlockEncodeDecode) {
   TestEmptyBlockEncodeDecode(BINARY, PLAIN_ENCODING);
@@ -847,6 +1019,72 @@ TEST_F(TestEncoding, TestBinaryPrefixEmptyBlockEncodeDecode) {
   TestEmptyBlockEncodeDecode(BINARY, PREFIX_ENCODING);
 }
 
+TEST_F(TestEncoding, TestFsstEmptyBlockEncodeDecode) {
+  TestEmptyBlockEncodeDecode(BINARY, FSST_ENCODING);
+}
+
+// Test that values which repeat a few substrings are compressed, and that
+// predicates are evaluated on FSST blocks whether or not they can be
+// evaluated on the compressed values.
+TEST_F(TestEncoding, TestFsstCopyNextAndEval) {
+  const int kCount = 2000;
+  const auto& GenTestString = [](int i) {
+    return StringPrintf("http://www.example.com/item/%d?lang=%s", i % 50, i % 3 ? "en" : "fr");
+  };
+  auto bb = CreateBlockBuilderOrDie(BINARY, FSST_ENCODING);
+  size_t raw_size = 0;
+  for (int i = 0; i < kCount; i++) {
+    raw_size += GenTestString(i).size();
+  }
+  Slice s = CreateBinaryBlock(bb.get(), kCount, GenTestString);
+  LOG(INFO) << "Encoded size for " << raw_size << " bytes of values: " << s.size();
+  ASSERT_LT(s.size(), raw_size / 2);
+
+  const string kValue = GenTestString(7);
+  const string kOtherValue = GenTestString(12);
+  const string kMissingValue = "http://www.example.com/item/7?lang=de";
+  Slice value(kValue);
+  Slice other_value(kOtherValue);
+  Slice missing_value(kMissingValue);
+  Slice upper("http://www.example.com/item/2");
+  ColumnSchema col("c", BINARY);
+  vector<const void*> in_list = { &value, &other_value, &missing_value };
+  const vector<ColumnPredicate> preds = {
+    ColumnPredicate::Equality(col, &value),
+    ColumnPredicate::Equality(col, &missing_value),
+    ColumnPredicate::InList(col, &in_list),
+    ColumnPredicate::Range(col, nullptr, &upper),
+  };
+  for (const auto& pred : preds) {
+    SCOPED_TRACE(pred.ToString());
+    auto bd = CreateBlockDecoderOrDie(BINARY, FSST_ENCODING, s);
+    ASSERT_OK(bd->ParseHeader());
+
+    ScopedColumnBlock<BINARY> cb(kCount);
+    SelectionVector sel(kCount);
+    sel.SetAllTrue();
+    ColumnMaterializationContext ctx(0, &pred, &cb, &sel);
+    ColumnDataView dst(&cb);
+    SelectionVectorView sel_view(&sel);
+    while (bd->HasNext()) {
+      size_t n = std::min<size_t>((random() % 100) + 1, dst.nrows());
+      ASSERT_OK(bd->CopyNextAndEval(&n, &ctx, &sel_view, &dst));
+      dst.Advance(n);
+      sel_view.Advance(n);
+    }
+    ASSERT_FALSE(ctx.DecoderEvalNotSupported());
+    for (int i = 0; i < kCount; i++) {
+      const string expected = GenTestString(i);
+      Slice expected_slice(expected);
+      ASSERT_EQ(pred.EvaluateCell<BINARY>(&expected_slice), sel.IsRowSelected(i))
+          << "at index " << i;
+      if (sel.IsRowSelected(i)) {
+        ASSERT_EQ(expected, cb[i].ToString()) << "at index " << i;
+      }
+    }
+  }
+}
+
 // Test encode/decode of a binary block with various-sized truncations.
 TEST_F(TestEncoding, TestBinaryPlainBlockBuilderTruncation) {
   TestBinaryBlockTruncation<BinaryPlainBlockDecoder>(PLAIN_ENCODING);
@@ -876,7 +1114,7 @@ class IntEncodingTest : public TestEncoding, public ::testing::WithParamInterfac
   }
 };
 INSTANTIATE_TEST_CASE_P(Encodings, IntEncodingTest,
-                        ::testing::Values(RLE, PLAIN_ENCODING, BIT_SHUFFLE));
+                        ::testing::Values(RLE, PLAIN_ENCODING, BIT_SHUFFLE, FOR_BITPACK));
 
 TEST_P(IntEncodingTest, TestSeekAllTypes) {
   this->template DoIntSeekTest<UINT8>(100, 1000, true);
@@ -0,0 +1,438 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Frame-of-reference encoding with bit-packing for integer types.
+//
+// Each block stores the minimum value of the block, and every value is stored
+// as its (unsigned) difference from that minimum using the smallest bit width
+// that can represent the largest difference in the block. This works well for
+// monotonically increasing columns such as timestamps and sequence IDs, where
+// the values within a block span a small range.
+//
+// Since all the packed values have the same width, any value in the block can
+// be decoded without decoding the values before it, so seeking is O(1) and
+// only the requested range of values is ever unpacked. The block minimum and
+// maximum are kept in the header so that predicates may be checked against
+// them without unpacking anything.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowid.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bit-stream-utils.h"
+#include "kudu/util/bit-stream-utils.inline.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace cfile {
+
+struct WriterOptions;
+
+namespace for_internal {
+
+// Number of zero bytes appended after the packed values so that the decoder
+// may always perform a full 8-byte load followed by a single extra byte load,
+// regardless of the position of a value within the block.
+constexpr int kPaddingBytes = 9;
+
+// Returns the number of bits required to represent 'v'.
+inline int NumBits(uint64_t v) {
+  return v == 0 ? 0 : 64 - __builtin_clzll(v);
+}
+
+// Returns the 'width'-bit value at index 'idx' of the bit-packed buffer 'buf'.
+// Values are packed LSB-first as written by BitWriter::PutValue(). 'width' must
+// be in the range [1, 64], and 'buf' must be padded by at least kPaddingBytes.
+inline uint64_t UnpackOne(const uint8_t* buf, int width, uint64_t mask, size_t idx) {
+  const uint64_t bit = static_cast<uint64_t>(idx) * width;
+  const uint8_t* p = buf + (bit >> 3);
+  const int shift = bit & 7;
+  uint64_t v = UnalignedLoad<uint64_t>(p) >> shift;
+  if (PREDICT_FALSE(width + shift > 64)) {
+    v |= static_cast<uint64_t>(p[8]) << (64 - shift);
+  }
+  return v & mask;
+}
+
+} // namespace for_internal
+
+// Block format:
+//
+// 1. Header: (12 + 2 * sizeof(CppType) bytes total)
+//
+//    <first_ordinal> [32-bit]
+//      The ordinal offset of the first element in the block.
+//
+//    <num_elements> [32-bit]
+//      The number of elements encoded in the block.
+//
+//    <bit_width> [32-bit]
+//      The number of bits used to store each element, between 0 and
+//      8 * sizeof(CppType). A width of 0 means all of the values in the
+//      block are equal to <min_value>, and no element data follows.
+//
+//    <min_value> [sizeof(CppType)]
+//    <max_value> [sizeof(CppType)]
+//      The minimum and maximum values in the block.
+//
+//   NOTE: all on-disk ints are encoded little-endian
+//
+// 2. Element data
+//
+//    (value - min_value) for each element, packed LSB-first using
+//    <bit_width> bits each, followed by zero padding.
+//
+template<DataType Type>
+class ForBlockBuilder final : public BlockBuilder {
+ public:
+  explicit ForBlockBuilder(const WriterOptions* options)
+      : options_(options) {
+    Reset();
+  }
+
+  void Reset() override {
+    count_ = 0;
+    values_.clear();
+    buffer_.clear();
+    min_ = std::numeric_limits<CppType>::max();
+    max_ = std::numeric_limits<CppType>::min();
+    finished_ = false;
+  }
+
+  bool IsBlockFull() const override {
+    // Bound the number of values as well as the packed size: a block of
+    // identical values packs to nothing, but still has to be buffered.
+    return count_ >= kMaxElemsPerBlock ||
+        EstimateEncodedSize() > options_->storage_attributes.cfile_block_size;
+  }
+
+  int Add(const uint8_t* vals_void, size_t count) override {
+    DCHECK(!finished_);
+    const CppType* vals = reinterpret_cast<const CppType*>(vals_void);
+    values_.reserve(count_ + count);
+    for (size_t i = 0; i < count; i++) {
+      const CppType v = vals[i];
+      min_ = std::min(min_, v);
+      max_ = std::max(max_, v);
+      values_.push_back(v);
+    }
+    count_ += count;
+    return count;
+  }
+
+  size_t Count() const override {
+    return count_;
+  }
+
+  Status GetFirstKey(void* key) const override {
+    if (PREDICT_FALSE(count_ == 0)) {
+      return Status::NotFound("no keys in data block");
+    }
+    UnalignedStore<CppType>(key, values_.front());
+    return Status::OK();
+  }
+
+  Status GetLastKey(void* key) const override {
+    if (PREDICT_FALSE(count_ == 0)) {
+      return Status::NotFound("no keys in data block");
+    }
+    UnalignedStore<CppType>(key, values_.back());
+    return Status::OK();
+  }
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override {
+    const CppType min_val = count_ > 0 ? min_ : 0;
+    const CppType max_val = count_ > 0 ? max_ : 0;
+    const int width = for_internal::NumBits(Delta(max_val, min_val));
+
+    buffer_.resize(kHeaderSize);
+    InlineEncodeFixed32(&buffer_[0], ordinal_pos);
+    InlineEncodeFixed32(&buffer_[4], count_);
+    InlineEncodeFixed32(&buffer_[8], width);
+    UnalignedStore<CppType>(&buffer_[12], min_val);
+    UnalignedStore<CppType>(&buffer_[12 + sizeof(CppType)], max_val);
+
+    packed_.clear();
+    if (width > 0) {
+      BitWriter writer(&packed_);
+      for (const CppType v : values_) {
+        writer.PutValue(Delta(v, min_val), width);
+      }
+      writer.Flush();
+    }
+    buffer_.append(packed_.data(), packed_.size());
+    buffer_.resize(buffer_.size() + for_internal::kPaddingBytes);
+    memset(&buffer_[buffer_.size() - for_internal::kPaddingBytes], 0,
+           for_internal::kPaddingBytes);
+
+    finished_ = true;
+    *slices = { Slice(buffer_) };
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename std::make_unsigned<CppType>::type UnsignedCppType;
+
+  static const size_t kHeaderSize = sizeof(uint32_t) * 3 + sizeof(CppType) * 2;
+  static const size_t kMaxElemsPerBlock = 64 * 1024;
+
+  // Returns 'v - base' as an unsigned value, which is well-defined even if
+  // the subtraction would overflow the signed type.
+  static uint64_t Delta(CppType v, CppType base) {
+    return static_cast<UnsignedCppType>(static_cast<UnsignedCppType>(v) -
+                                        static_cast<UnsignedCppType>(base));
+  }
+
+  size_t EstimateEncodedSize() const {
+    if (count_ == 0) {
+      return kHeaderSize;
+    }
+    const int width = for_internal::NumBits(Delta(max_, min_));
+    return kHeaderSize + (count_ * width + 7) / 8;
+  }
+
+  std::vector<CppType> values_;
+  faststring packed_;
+  faststring buffer_;
+  size_t count_;
+  CppType min_;
+  CppType max_;
+  bool finished_;
+  const WriterOptions* const options_;
+};
+
+template<DataType Type>
+class ForBlockDecoder final : public BlockDecoder {
+ public:
+  explicit ForBlockDecoder(Slice slice)
+      : data_(slice),
+        parsed_(false),
+        ordinal_pos_base_(0),
+        num_elems_(0),
+        width_(0),
+        mask_(0),
+        min_(0),
+        max_(0),
+        packed_(nullptr),
+        cur_idx_(0) {
+  }
+
+  Status ParseHeader() override {
+    CHECK(!parsed_);
+    if (data_.size() < kHeaderSize) {
+      return Status::Corruption(
+          strings::Substitute("not enough bytes for header: frame-of-reference block "
+                              "size ($0) less than expected header length ($1)",
+                              data_.size(), kHeaderSize));
+    }
+
+    ordinal_pos_base_ = DecodeFixed32(&data_[0]);
+    num_elems_ = DecodeFixed32(&data_[4]);
+    width_ = DecodeFixed32(&data_[8]);
+    if (PREDICT_FALSE(width_ > sizeof(CppType) * 8)) {
+      return Status::Corruption(strings::Substitute("invalid bit width: $0", width_));
+    }
+    min_ = UnalignedLoad<CppType>(&data_[12]);
+    max_ = UnalignedLoad<CppType>(&data_[12 + sizeof(CppType)]);
+
+    const size_t packed_size = (static_cast<uint64_t>(num_elems_) * width_ + 7) / 8;
+    if (PREDICT_FALSE(data_.size() < kHeaderSize + packed_size + for_internal::kPaddingBytes)) {
+      return Status::Corruption(
+          strings::Substitute("frame-of-reference block size ($0) too small for $1 "
+                              "elements of $2 bits", data_.size(), num_elems_, width_));
+    }
+    packed_ = &data_[kHeaderSize];
+    mask_ = width_ == 64 ? ~0ULL : (1ULL << width_) - 1;
+
+    parsed_ = true;
+    return Status::OK();
+  }
+
+  void SeekToPositionInBlock(uint pos) override {
+    CHECK(parsed_) << "Must call ParseHeader()";
+    if (PREDICT_FALSE(num_elems_ == 0)) {
+      DCHECK_EQ(0, pos);
+      return;
+    }
+    DCHECK_LE(pos, num_elems_);
+    cur_idx_ = pos;
+  }
+
+  Status SeekAtOrAfterValue(const void* value_void, bool* exact) override {
+    DCHECK(parsed_);
+    const CppType target = UnalignedLoad<CppType>(value_void);
+    uint32_t left = 0;
+    uint32_t right = num_elems_;
+    while (left != right) {
+      const uint32_t mid = left + (right - left) / 2;
+      const CppType mid_key = ValueAt(mid);
+      if (mid_key == target) {
+        cur_idx_ = mid;
+        *exact = true;
+        return Status::OK();
+      }
+      if (mid_key > target) {
+        right = mid;
+      } else {
+        left = mid + 1;
+      }
+    }
+
+    *exact = false;
+    cur_idx_ = left;
+    if (cur_idx_ == num_elems_) {
+      return Status::NotFound("after last key in block");
+    }
+    return Status::OK();
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    const size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    Unpack(cur_idx_, to_fetch, reinterpret_cast<CppType*>(dst->data()));
+    cur_idx_ += to_fetch;
+    *n = to_fetch;
+    return Status::OK();
+  }
+
+  // Uses the block's minimum and maximum to skip the unpacking of blocks whose
+  // values either all fail or all pass the predicate. Otherwise, unpacks the
+  // values and evaluates the predicate on each of the selected ones.
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+
+    ctx->SetDecoderEvalSupported();
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+    const size_t to_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    const ColumnPredicate* pred = ctx->pred();
+
+    if (!pred->MayMatchRange(&min_, &max_)) {
+      // None of the rows can match: there's no need to unpack anything.
+      sel->ClearBits(to_fetch);
+    } else {
+      Unpack(cur_idx_, to_fetch, reinterpret_cast<CppType*>(dst->data()));
+      if (!pred->MatchesAllInRange(&min_, &max_)) {
+        pred->EvaluateNonNullCells<Type>(dst->data(), to_fetch, sel);
+      }
+    }
+
+    cur_idx_ += to_fetch;
+    *n = to_fetch;
+    return Status::OK();
+  }
+
+  size_t GetCurrentIndex() const override {
+    DCHECK(parsed_) << "must parse header first";
+    return cur_idx_;
+  }
+
+  rowid_t GetFirstRowId() const override {
+    return ordinal_pos_base_;
+  }
+
+  size_t Count() const override {
+    return num_elems_;
+  }
+
+  bool HasNext() const override {
+    return cur_idx_ < num_elems_;
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  typedef typename std::make_unsigned<CppType>::type UnsignedCppType;
+
+  static const size_t kHeaderSize = sizeof(uint32_t) * 3 + sizeof(CppType) * 2;
+
+  CppType Rebase(uint64_t delta) const {
+    return static_cast<CppType>(static_cast<UnsignedCppType>(min_) +
+                                static_cast<UnsignedCppType>(delta));
+  }
+
+  CppType ValueAt(size_t idx) const {
+    if (width_ == 0) {
+      return min_;
+    }
+    return Rebase(for_internal::UnpackOne(packed_, width_, mask_, idx));
+  }
+
+  // Unpack 'count' values starting at index 'start' into 'out'.
+  //
+  // The loop is kept free of cross-iteration dependencies so that the
+  // compiler is able to vectorize it.
+  void Unpack(size_t start, size_t count, CppType* out) const {
+    if (width_ == 0) {
+      std::fill(out, out + count, min_);
+      return;
+    }
+    const uint8_t* packed = packed_;
+    const int width = width_;
+    const uint64_t mask = mask_;
+    for (size_t i = 0; i < count; i++) {
+      out[i] = Rebase(for_internal::UnpackOne(packed, width, mask, start + i));
+    }
+  }
+
+  Slice data_;
+  bool parsed_;
+
+  rowid_t ordinal_pos_base_;
+  uint32_t num_elems_;
+  uint32_t width_;
+  uint64_t mask_;
+  CppType min_;
+  CppType max_;
+  const uint8_t* packed_;
+
+  size_t cur_idx_;
+};
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,656 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/fsst_block.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/memory/arena.h"
+
+#ifndef IS_LITTLE_ENDIAN
+#error "FsstSymbolTable compares symbols as little-endian words"
+#endif
+
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// The symbol table is learned from at most this many bytes of the values.
+constexpr size_t kMaxTrainingSampleSize = 16 * 1024;
+
+// Number of rounds of compressing the sample and picking the best symbols.
+constexpr int kTrainingGenerations = 5;
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////
+// Symbol table
+////////////////////////////////////////////////////////////
+
+FsstSymbolTable::FsstSymbolTable() {
+  SetSymbols({});
+}
+
+void FsstSymbolTable::SetSymbols(const vector<string>& symbols) {
+  DCHECK_LE(symbols.size(), kMaxSymbols);
+  memset(symbols_, 0, sizeof(symbols_));
+  memset(lengths_, 0, sizeof(lengths_));
+  num_symbols_ = symbols.size();
+  for (size_t i = 0; i < num_symbols_; i++) {
+    DCHECK_GE(symbols[i].size(), 1);
+    DCHECK_LE(symbols[i].size(), kMaxSymbolLength);
+    memcpy(&symbols_[i], symbols[i].data(), symbols[i].size());
+    lengths_[i] = symbols[i].size();
+  }
+  BuildIndex();
+}
+
+void FsstSymbolTable::BuildIndex() {
+  const auto first_byte = [this](uint8_t code) {
+    return reinterpret_cast<const uint8_t*>(&symbols_[code])[0];
+  };
+  std::iota(codes_by_first_byte_, codes_by_first_byte_ + num_symbols_, 0);
+  std::sort(codes_by_first_byte_, codes_by_first_byte_ + num_symbols_,
+            [&](uint8_t a, uint8_t b) {
+              if (first_byte(a) != first_byte(b)) return first_byte(a) < first_byte(b);
+              return lengths_[a] > lengths_[b];
+            });
+  size_t idx = 0;
+  for (int b = 0; b < 256; b++) {
+    codes_by_first_byte_start_[b] = idx;
+    while (idx < num_symbols_ && first_byte(codes_by_first_byte_[idx]) == b) {
+      idx++;
+    }
+  }
+  codes_by_first_byte_start_[256] = idx;
+}
+
+uint8_t FsstSymbolTable::FindLongestSymbol(const uint8_t* data, size_t len) const {
+  DCHECK_GT(len, 0);
+  uint64_t word = 0;
+  memcpy(&word, data, std::min(len, kMaxSymbolLength));
+  const uint8_t first = data[0];
+  for (size_t i = codes_by_first_byte_start_[first];
+       i < codes_by_first_byte_start_[first + 1];
+       i++) {
+    const uint8_t code = codes_by_first_byte_[i];
+    const size_t sym_len = lengths_[code];
+    if (sym_len > len) {
+      continue;
+    }
+    const uint64_t mask = sym_len == kMaxSymbolLength ? ~0ULL : (1ULL << (8 * sym_len)) - 1;
+    if ((word & mask) == symbols_[code]) {
+      return code;
+    }
+  }
+  return kEscapeCode;
+}
+
+void FsstSymbolTable::Train(const vector<Slice>& values) {
+  // Learn from an evenly spread sample of the values to bound the cost.
+  size_t total_size = 0;
+  for (const Slice& v : values) {
+    total_size += v.size();
+  }
+  const size_t stride = std::max<size_t>(1, total_size / kMaxTrainingSampleSize);
+  vector<Slice> sample;
+  for (size_t i = 0; i < values.size(); i += stride) {
+    sample.push_back(values[i]);
+  }
+
+  uint8_t literals[256];
+  std::iota(literals, literals + 256, 0);
+
+  SetSymbols({});
+  for (int gen = 0; gen < kTrainingGenerations; gen++) {
+    // Compress the sample with the current table, counting how often each
+    // code and each pair of consecutive codes occurs. Codes in [0, 256) stand
+    // for escaped bytes, and codes in [256, 256 + num_symbols_) for symbols.
+    // The first byte of every symbol is counted too, so that single bytes
+    // keep competing for a place in the table.
+    vector<uint64_t> counts(256 + kMaxSymbols);
+    unordered_map<uint32_t, uint64_t> pair_counts;
+    for (const Slice& v : sample) {
+      const uint8_t* p = v.data();
+      const uint8_t* end = p + v.size();
+      int prev = -1;
+      while (p < end) {
+        const uint8_t code = FindLongestSymbol(p, end - p);
+        int cur;
+        if (code == kEscapeCode) {
+          cur = *p++;
+        } else {
+          if (lengths_[code] > 1) {
+            counts[*p]++;
+          }
+          cur = 256 + code;
+          p += lengths_[code];
+        }
+        counts[cur]++;
+        if (prev >= 0) {
+          pair_counts[(prev << 16) | cur]++;
+        }
+        prev = cur;
+      }
+    }
+
+    // Every symbol and concatenation of two consecutive symbols is a
+    // candidate for the next table, gaining the number of bytes it would
+    // replace by a single code.
+    const auto text = [&](int code) {
+      return code < 256 ? Slice(&literals[code], 1)
+                        : Slice(reinterpret_cast<const uint8_t*>(&symbols_[code - 256]),
+                                lengths_[code - 256]);
+    };
+    unordered_map<string, uint64_t> gains;
+    for (size_t code = 0; code < counts.size(); code++) {
+      if (counts[code] > 0) {
+        Slice s = text(code);
+        gains[s.ToString()] += counts[code] * s.size();
+      }
+    }
+    for (const auto& e : pair_counts) {
+      Slice a = text(e.first >> 16);
+      Slice b = text(e.first & 0xffff);
+      if (a.size() + b.size() <= kMaxSymbolLength) {
+        string s = a.ToString();
+        s.append(reinterpret_cast<const char*>(b.data()), b.size());
+        gains[s] += e.second * s.size();
+      }
+    }
+
+    vector<pair<uint64_t, string>> ranked;
+    ranked.reserve(gains.size());
+    for (auto& e : gains) {
+      ranked.emplace_back(e.second, e.first);
+    }
+    const size_t num_symbols = std::min(kMaxSymbols, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + num_symbols, ranked.end(),
+                      [](const pair<uint64_t, string>& a, const pair<uint64_t, string>& b) {
+                        if (a.first != b.first) return a.first > b.first;
+                        return a.second < b.second;
+                      });
+    vector<string> symbols;
+    symbols.reserve(num_symbols);
+    for (size_t i = 0; i < num_symbols; i++) {
+      symbols.emplace_back(std::move(ranked[i].second));
+    }
+    SetSymbols(symbols);
+  }
+}
+
+void FsstSymbolTable::AppendTo(faststring* dst) const {
+  dst->push_back(static_cast<char>(num_symbols_));
+  dst->append(lengths_, num_symbols_);
+  for (size_t i = 0; i < num_symbols_; i++) {
+    dst->append(&symbols_[i], lengths_[i]);
+  }
+}
+
+Status FsstSymbolTable::ParseFrom(Slice* data) {
+  if (PREDICT_FALSE(data->empty())) {
+    return Status::Corruption("not enough bytes for FSST symbol table");
+  }
+  const size_t num_symbols = (*data)[0];
+  if (PREDICT_FALSE(data->size() < 1 + num_symbols)) {
+    return Status::Corruption(Substitute(
+        "not enough bytes for the lengths of $0 FSST symbols", num_symbols));
+  }
+  const uint8_t* lengths = data->data() + 1;
+  size_t total_size = 0;
+  for (size_t i = 0; i < num_symbols; i++) {
+    if (PREDICT_FALSE(lengths[i] == 0 || lengths[i] > kMaxSymbolLength)) {
+      return Status::Corruption(Substitute("invalid FSST symbol length $0", lengths[i]));
+    }
+    total_size += lengths[i];
+  }
+  if (PREDICT_FALSE(data->size() < 1 + num_symbols + total_size)) {
+    return Status::Corruption(Substitute(
+        "not enough bytes for $0 FSST symbols of $1 bytes", num_symbols, total_size));
+  }
+
+  memset(symbols_, 0, sizeof(symbols_));
+  memset(lengths_, 0, sizeof(lengths_));
+  num_symbols_ = num_symbols;
+  const uint8_t* p = lengths + num_symbols;
+  for (size_t i = 0; i < num_symbols; i++) {
+    memcpy(&symbols_[i], p, lengths[i]);
+    lengths_[i] = lengths[i];
+    p += lengths[i];
+  }
+  BuildIndex();
+  data->remove_prefix(1 + num_symbols + total_size);
+  return Status::OK();
+}
+
+void FsstSymbolTable::Compress(const Slice& value, faststring* dst) const {
+  // Every byte takes at most two bytes of codes.
+  const size_t old_size = dst->size();
+  dst->resize(old_size + 2 * value.size());
+  uint8_t* out = dst->data() + old_size;
+
+  const uint8_t* p = value.data();
+  const uint8_t* end = p + value.size();
+  while (p < end) {
+    const uint8_t code = FindLongestSymbol(p, end - p);
+    *out++ = code;
+    if (code == kEscapeCode) {
+      *out++ = *p++;
+    } else {
+      p += lengths_[code];
+    }
+  }
+  dst->resize(out - dst->data());
+}
+
+size_t FsstSymbolTable::DecompressedLength(const Slice& codes) const {
+  size_t len = 0;
+  const uint8_t* p = codes.data();
+  const uint8_t* end = p + codes.size();
+  while (p < end) {
+    const uint8_t code = *p++;
+    if (PREDICT_TRUE(code != kEscapeCode)) {
+      len += lengths_[code];
+    } else if (PREDICT_TRUE(p < end)) {
+      len++;
+      p++;
+    }
+  }
+  return len;
+}
+
+void FsstSymbolTable::Decompress(const Slice& codes, uint8_t* dst) const {
+  const uint8_t* p = codes.data();
+  const uint8_t* end = p + codes.size();
+  uint8_t* out = dst;
+  // Unless close to the end of the destination, symbols are copied as whole
+  // words, whatever their length.
+  const size_t len = DecompressedLength(codes);
+  uint8_t* const out_fast_end = dst + len - std::min(len, kMaxSymbolLength);
+  while (p < end) {
+    const uint8_t code = *p++;
+    if (PREDICT_TRUE(code != kEscapeCode)) {
+      if (PREDICT_TRUE(out <= out_fast_end)) {
+        memcpy(out, &symbols_[code], kMaxSymbolLength);
+      } else {
+        memcpy(out, &symbols_[code], lengths_[code]);
+      }
+      out += lengths_[code];
+    } else if (PREDICT_TRUE(p < end)) {
+      *out++ = *p++;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////
+// Encoding
+////////////////////////////////////////////////////////////
+
+FsstBlockBuilder::FsstBlockBuilder(const WriterOptions* options)
+    : options_(options) {
+  Reset();
+}
+
+void FsstBlockBuilder::Reset() {
+  values_buf_.clear();
+  value_offsets_.clear();
+  buffer_.clear();
+  finished_ = false;
+}
+
+bool FsstBlockBuilder::IsBlockFull() const {
+  // The block size is estimated from the uncompressed values, so blocks end
+  // up smaller than the configured size once compressed.
+  return values_buf_.size() + value_offsets_.size() * sizeof(uint32_t) >
+      options_->storage_attributes.cfile_block_size;
+}
+
+int FsstBlockBuilder::Add(const uint8_t* vals, size_t count) {
+  DCHECK(!finished_);
+  DCHECK_GT(count, 0);
+  size_t i = 0;
+
+  // If the block is full, should stop adding more items.
+  while (!IsBlockFull() && i < count) {
+    const Slice* src = reinterpret_cast<const Slice*>(vals) + i;
+    value_offsets_.push_back(values_buf_.size());
+    values_buf_.append(src->data(), src->size());
+    i++;
+  }
+  return i;
+}
+
+void FsstBlockBuilder::Finish(rowid_t ordinal_pos, vector<Slice>* slices) {
+  finished_ = true;
+
+  const size_t num_elems = value_offsets_.size();
+  vector<Slice> values;
+  values.reserve(num_elems);
+  for (size_t i = 0; i < num_elems; i++) {
+    values.emplace_back(value_at_index(i));
+  }
+  table_.Train(values);
+
+  buffer_.clear();
+  buffer_.resize(kHeaderSize);
+  table_.AppendTo(&buffer_);
+
+  vector<uint32_t> code_offsets(num_elems);
+  for (size_t i = 0; i < num_elems; i++) {
+    code_offsets[i] = buffer_.size();
+    table_.Compress(values[i], &buffer_);
+  }
+
+  const size_t offsets_pos = buffer_.size();
+  for (uint32_t off : code_offsets) {
+    PutFixed32(&buffer_, off);
+  }
+
+  // Set up the header
+  InlineEncodeFixed32(&buffer_[0], ordinal_pos);
+  InlineEncodeFixed32(&buffer_[4], num_elems);
+  InlineEncodeFixed32(&buffer_[8], offsets_pos);
+
+  *slices = { Slice(buffer_) };
+}
+
+size_t FsstBlockBuilder::Count() const {
+  return value_offsets_.size();
+}
+
+Slice FsstBlockBuilder::value_at_index(size_t idx) const {
+  DCHECK_LT(idx, value_offsets_.size());
+  const size_t start = value_offsets_[idx];
+  const size_t end = idx + 1 < value_offsets_.size() ? value_offsets_[idx + 1]
+                                                     : values_buf_.size();
+  return Slice(values_buf_.data() + start, end - start);
+}
+
+Status FsstBlockBuilder::GetFirstKey(void* key_void) const {
+  CHECK(finished_);
+  if (value_offsets_.empty()) {
+    return Status::NotFound("no keys in data block");
+  }
+  *reinterpret_cast<Slice*>(key_void) = value_at_index(0);
+  return Status::OK();
+}
+
+Status FsstBlockBuilder::GetLastKey(void* key_void) const {
+  CHECK(finished_);
+  if (value_offsets_.empty()) {
+    return Status::NotFound("no keys in data block");
+  }
+  *reinterpret_cast<Slice*>(key_void) = value_at_index(value_offsets_.size() - 1);
+  return Status::OK();
+}
+
+////////////////////////////////////////////////////////////
+// Decoding
+////////////////////////////////////////////////////////////
+
+FsstBlockDecoder::FsstBlockDecoder(Slice slice)
+    : data_(slice),
+      parsed_(false),
+      offsets_(nullptr),
+      offsets_pos_(0),
+      num_elems_(0),
+      ordinal_pos_base_(0),
+      cur_idx_(0),
+      compressed_pred_(nullptr) {
+}
+
+Status FsstBlockDecoder::ParseHeader() {
+  CHECK(!parsed_);
+
+  if (data_.size() < kMinHeaderSize) {
+    return Status::Corruption(
+      Substitute("not enough bytes for header: FSST block header "
+                 "size ($0) less than minimum possible header length ($1)",
+                 data_.size(), kMinHeaderSize));
+  }
+
+  // Decode header.
+  ordinal_pos_base_ = DecodeFixed32(&data_[0]);
+  num_elems_        = DecodeFixed32(&data_[4]);
+  offsets_pos_      = DecodeFixed32(&data_[8]);
+
+  Slice rest(data_.data() + FsstBlockBuilder::kHeaderSize,
+             data_.size() - FsstBlockBuilder::kHeaderSize);
+  RETURN_NOT_OK(table_.ParseFrom(&rest));
+  const size_t codes_pos = rest.data() - data_.data();
+
+  // Sanity check.
+  if (offsets_pos_ < codes_pos || offsets_pos_ > data_.size() ||
+      data_.size() - offsets_pos_ != static_cast<uint64_t>(num_elems_) * sizeof(uint32_t)) {
+    return Status::Corruption(
+      Substitute("invalid offsets_pos $0 for $1 elements in FSST block of size $2",
+                 offsets_pos_, num_elems_, data_.size()));
+  }
+  offsets_ = data_.data() + offsets_pos_;
+
+  // Make sure that the codes of every value lie within the block.
+  uint32_t prev = codes_pos;
+  for (size_t i = 0; i < num_elems_; i++) {
+    uint32_t off = offset(i);
+    if (PREDICT_FALSE(off < prev || off > offsets_pos_)) {
+      return Status::Corruption(
+        Substitute("invalid offset $0 of element $1 in FSST block", off, i));
+    }
+    prev = off;
+  }
+
+  parsed_ = true;
+  return Status::OK();
+}
+
+void FsstBlockDecoder::SeekToPositionInBlock(uint pos) {
+  if (PREDICT_FALSE(num_elems_ == 0)) {
+    DCHECK_EQ(0, pos);
+    return;
+  }
+
+  DCHECK_LE(pos, num_elems_);
+  cur_idx_ = pos;
+}
+
+Slice FsstBlockDecoder::DecodeToScratch(const Slice& codes) {
+  const size_t len = table_.DecompressedLength(codes);
+  scratch_.resize(len);
+  table_.Decompress(codes, scratch_.data());
+  return Slice(scratch_.data(), len);
+}
+
+Status FsstBlockDecoder::SeekAtOrAfterValue(const void* value_void, bool* exact) {
+  DCHECK(value_void != nullptr);
+
+  const Slice& target = *reinterpret_cast<const Slice*>(value_void);
+
+  // Binary search for the first value >= target, decoding only the values
+  // which are compared.
+  int32_t left = 0;
+  int32_t right = num_elems_;
+  while (left != right) {
+    uint32_t mid = (left + right) / 2;
+    int c = DecodeToScratch(codes_at_index(mid)).compare(target);
+    if (c < 0) {
+      left = mid + 1;
+    } else if (c > 0) {
+      right = mid;
+    } else {
+      cur_idx_ = mid;
+      *exact = true;
+      return Status::OK();
+    }
+  }
+  *exact = false;
+  cur_idx_ = left;
+  if (cur_idx_ == num_elems_) {
+    return Status::NotFound("after last key in block");
+  }
+
+  return Status::OK();
+}
+
+Status FsstBlockDecoder::CopyNextValues(size_t* n, ColumnDataView* dst) {
+  DCHECK(parsed_);
+  CHECK_EQ(dst->type_info()->physical_type(), BINARY);
+  DCHECK_LE(*n, dst->nrows());
+  DCHECK_EQ(dst->stride(), sizeof(Slice));
+  if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+    *n = 0;
+    return Status::OK();
+  }
+  const size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+
+  // Decode the whole batch into a single allocation: first compute the
+  // length of every value, then decode them one after the other.
+  Slice* out = reinterpret_cast<Slice*>(dst->data());
+  size_t total_len = 0;
+  for (size_t i = 0; i < max_fetch; i++) {
+    const size_t len = table_.DecompressedLength(codes_at_index(cur_idx_ + i));
+    out[i] = Slice(static_cast<const uint8_t*>(nullptr), len);
+    total_len += len;
+  }
+  uint8_t* buf = nullptr;
+  if (total_len > 0) {
+    buf = reinterpret_cast<uint8_t*>(dst->arena()->AllocateBytes(total_len));
+    CHECK(buf != nullptr);
+  }
+  for (size_t i = 0; i < max_fetch; i++, cur_idx_++) {
+    table_.Decompress(codes_at_index(cur_idx_), buf);
+    out[i] = Slice(buf, out[i].size());
+    buf += out[i].size();
+  }
+  *n = max_fetch;
+  return Status::OK();
+}
+
+void FsstBlockDecoder::CompressPredicateValues(const ColumnPredicate* pred) {
+  vector<const Slice*> values;
+  if (pred->predicate_type() == PredicateType::Equality) {
+    values.push_back(static_cast<const Slice*>(pred->raw_lower()));
+  } else {
+    DCHECK(pred->predicate_type() == PredicateType::InList);
+    for (const void* v : pred->raw_values()) {
+      values.push_back(static_cast<const Slice*>(v));
+    }
+  }
+
+  compressed_pred_buf_.clear();
+  vector<size_t> ends;
+  ends.reserve(values.size());
+  for (const Slice* v : values) {
+    table_.Compress(*v, &compressed_pred_buf_);
+    ends.push_back(compressed_pred_buf_.size());
+  }
+
+  // The slices are only set up once the buffer is not going to move anymore.
+  compressed_pred_values_.clear();
+  size_t start = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    compressed_pred_values_.emplace_back(
+        Slice(compressed_pred_buf_.data() + start, ends[i] - start), *values[i]);
+    start = ends[i];
+  }
+  std::sort(compressed_pred_values_.begin(), compressed_pred_values_.end(),
+            [](const pair<Slice, Slice>& a, const pair<Slice, Slice>& b) {
+              return a.first.compare(b.first) < 0;
+            });
+  compressed_pred_ = pred;
+}
+
+Status FsstBlockDecoder::CopyNextAndEval(size_t* n,
+                                         ColumnMaterializationContext* ctx,
+                                         SelectionVectorView* sel,
+                                         ColumnDataView* dst) {
+  DCHECK(parsed_);
+  CHECK_EQ(dst->type_info()->physical_type(), BINARY);
+  DCHECK_LE(*n, dst->nrows());
+  DCHECK_EQ(dst->stride(), sizeof(Slice));
+  ctx->SetDecoderEvalSupported();
+  if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+    *n = 0;
+    return Status::OK();
+  }
+  const size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+
+  const ColumnPredicate* pred = ctx->pred();
+  const bool eval_on_codes = pred->predicate_type() == PredicateType::Equality ||
+                             pred->predicate_type() == PredicateType::InList;
+  if (eval_on_codes && compressed_pred_ != pred) {
+    CompressPredicateValues(pred);
+  }
+
+  Arena* out_arena = dst->arena();
+  Slice* out = reinterpret_cast<Slice*>(dst->data());
+  for (size_t i = 0; i < max_fetch; i++, out++, cur_idx_++) {
+    if (!sel->TestBit(i)) {
+      continue;
+    }
+    if (eval_on_codes) {
+      // A matching value is equal to a value of the predicate, which can be
+      // copied instead of decoding the cell.
+      const Slice codes = codes_at_index(cur_idx_);
+      auto it = std::lower_bound(compressed_pred_values_.begin(), compressed_pred_values_.end(),
+                                 codes,
+                                 [](const pair<Slice, Slice>& a, const Slice& b) {
+                                   return a.first.compare(b) < 0;
+                                 });
+      if (it != compressed_pred_values_.end() && it->first == codes) {
+        CHECK(out_arena->RelocateSlice(it->second, out));
+      } else {
+        sel->ClearBit(i);
+      }
+    } else {
+      // Other predicates need the decoded value, but only the matching ones
+      // are copied to the arena.
+      Slice elem = DecodeToScratch(codes_at_index(cur_idx_));
+      if (pred->EvaluateCell<BINARY>(static_cast<const void*>(&elem))) {
+        CHECK(out_arena->RelocateSlice(elem, out));
+      } else {
+        sel->ClearBit(i);
+      }
+    }
+  }
+  *n = max_fetch;
+  return Status::OK();
+}
+
+} // namespace cfile
+} // namespace kudu
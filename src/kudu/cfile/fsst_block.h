@@ -0,0 +1,261 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Encoding for strings based on a symbol table learned from the values of
+// each block, following FSST ("FSST: Fast Random Access String Compression",
+// Boncz et al., VLDB 2020).
+//
+// Up to 255 symbols of 1 to 8 bytes are chosen such that replacing their
+// occurrences by one-byte codes compresses the values of the block best.
+// Bytes not covered by any symbol are stored after an escape code. Since
+// every value is compressed on its own, values can be decoded individually,
+// and two values are equal if and only if their codes are equal: equality
+// and IN-list predicates are evaluated on the compressed data, and only the
+// matching values are materialized.
+//
+// The block consists of:
+// Header:
+//   ordinal_pos (32-bit fixed)
+//   num_elems (32-bit fixed)
+//   offsets_pos (32-bit fixed): position of the first offset, relative to block start
+// Symbol table:
+//   num_symbols (8-bit)
+//   length of each symbol (8-bit each)
+//   the bytes of the symbols, concatenated
+// Codes:
+//   the codes of each value
+// Offsets:  [pointed to by offsets_pos]
+//   32-bit fixed offsets pointing to the beginning of the codes of each value
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnDataView;
+class ColumnMaterializationContext;
+class ColumnPredicate;
+class SelectionVectorView;
+
+namespace cfile {
+
+struct WriterOptions;
+
+// A table of up to 255 symbols, each mapped to a one-byte code.
+class FsstSymbolTable {
+ public:
+  static constexpr size_t kMaxSymbols = 255;
+  static constexpr size_t kMaxSymbolLength = 8;
+
+  // Code preceding a byte which isn't covered by any symbol.
+  static constexpr uint8_t kEscapeCode = 255;
+
+  FsstSymbolTable();
+
+  // Learns the symbols which compress the given values best.
+  void Train(const std::vector<Slice>& values);
+
+  // Appends the encoded table to 'dst'.
+  void AppendTo(faststring* dst) const;
+
+  // Decodes a table from the beginning of 'data', and advances 'data' past it.
+  Status ParseFrom(Slice* data);
+
+  // Appends the codes of 'value' to 'dst'.
+  void Compress(const Slice& value, faststring* dst) const;
+
+  // Returns the length of the value represented by 'codes'.
+  size_t DecompressedLength(const Slice& codes) const;
+
+  // Decodes 'codes' into 'dst', which must have room for
+  // DecompressedLength(codes) bytes.
+  void Decompress(const Slice& codes, uint8_t* dst) const;
+
+  size_t num_symbols() const {
+    return num_symbols_;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(FsstSymbolTable);
+
+  // Replaces the symbols of the table. Codes are assigned in order.
+  void SetSymbols(const std::vector<std::string>& symbols);
+
+  // Sets up the lookup structures used by FindLongestSymbol() once the
+  // symbols have been set.
+  void BuildIndex();
+
+  // Returns the code of the longest symbol which is a prefix of the 'len'
+  // bytes at 'data', or kEscapeCode if there is none.
+  uint8_t FindLongestSymbol(const uint8_t* data, size_t len) const;
+
+  size_t num_symbols_;
+
+  // The bytes of each symbol, zero-padded to 8 bytes, and its length. The
+  // entries past 'num_symbols_' have a zero length, which keeps decoding of
+  // corrupt codes within bounds.
+  uint64_t symbols_[kMaxSymbols + 1];
+  uint8_t lengths_[kMaxSymbols + 1];
+
+  // The codes of the symbols ordered by first byte, and longest first among
+  // symbols which have the same first byte. The codes of the symbols starting
+  // with byte 'b' are in [codes_by_first_byte_start_[b], codes_by_first_byte_start_[b + 1]).
+  uint8_t codes_by_first_byte_[kMaxSymbols];
+  uint16_t codes_by_first_byte_start_[257];
+};
+
+class FsstBlockBuilder final : public BlockBuilder {
+ public:
+  explicit FsstBlockBuilder(const WriterOptions* options);
+
+  bool IsBlockFull() const override;
+
+  int Add(const uint8_t* vals, size_t count) override;
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override;
+
+  void Reset() override;
+
+  size_t Count() const override;
+
+  // Return the first added key.
+  // key should be a Slice*
+  Status GetFirstKey(void* key) const override;
+
+  // Return the last added key.
+  // key should be a Slice*
+  Status GetLastKey(void* key) const override;
+
+  // Length of a header.
+  static constexpr size_t kHeaderSize = sizeof(uint32_t) * 3;
+
+ private:
+  Slice value_at_index(size_t idx) const;
+
+  // The values added to the block, which are only compressed by Finish(),
+  // once the symbol table has been learned from all of them.
+  faststring values_buf_;
+  std::vector<uint32_t> value_offsets_;
+
+  faststring buffer_;
+  FsstSymbolTable table_;
+
+  bool finished_;
+
+  const WriterOptions* options_;
+};
+
+class FsstBlockDecoder final : public BlockDecoder {
+ public:
+  explicit FsstBlockDecoder(Slice slice);
+
+  Status ParseHeader() override;
+  void SeekToPositionInBlock(uint pos) override;
+  Status SeekAtOrAfterValue(const void* value,
+                            bool* exact_match) override;
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override;
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override;
+
+  bool HasNext() const override {
+    DCHECK(parsed_);
+    return cur_idx_ < num_elems_;
+  }
+
+  size_t Count() const override {
+    DCHECK(parsed_);
+    return num_elems_;
+  }
+
+  size_t GetCurrentIndex() const override {
+    DCHECK(parsed_);
+    return cur_idx_;
+  }
+
+  rowid_t GetFirstRowId() const override {
+    return ordinal_pos_base_;
+  }
+
+  // Minimum length of a header: the fixed fields and an empty symbol table.
+  static const size_t kMinHeaderSize = sizeof(uint32_t) * 3 + 1;
+
+ private:
+  // Return the offset within 'data_' where the codes of the value with
+  // index 'idx' start. The codes of the last value end at 'offsets_pos_'.
+  uint32_t offset(size_t idx) const {
+    return idx < num_elems_ ? DecodeFixed32(offsets_ + idx * sizeof(uint32_t)) : offsets_pos_;
+  }
+
+  Slice codes_at_index(size_t idx) const {
+    const uint32_t start = offset(idx);
+    return Slice(&data_[start], offset(idx + 1) - start);
+  }
+
+  // Decodes the value represented by 'codes' into 'scratch_'. The returned
+  // slice is valid until the next call.
+  Slice DecodeToScratch(const Slice& codes);
+
+  // Compresses the values of 'pred', which must be an equality or IN-list
+  // predicate, with the symbol table of this block.
+  void CompressPredicateValues(const ColumnPredicate* pred);
+
+  Slice data_;
+  bool parsed_;
+
+  FsstSymbolTable table_;
+
+  // The fixed32 offsets of the codes of each value.
+  const uint8_t* offsets_;
+  uint32_t offsets_pos_;
+
+  uint32_t num_elems_;
+  rowid_t ordinal_pos_base_;
+
+  // Index of the currently seeked element in the block.
+  uint32_t cur_idx_;
+
+  faststring scratch_;
+
+  // The predicate whose values have been compressed with the symbol table
+  // of this block, and the pairs of compressed and original values, sorted
+  // by compressed value. The compressed values point into
+  // 'compressed_pred_buf_'.
+  const ColumnPredicate* compressed_pred_;
+  faststring compressed_pred_buf_;
+  std::vector<std::pair<Slice, Slice>> compressed_pred_values_;
+};
+
+} // namespace cfile
+} // namespace kudu
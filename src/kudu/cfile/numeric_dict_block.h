@@ -0,0 +1,487 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Dictionary encoding for fixed-width numeric types. Like the string
+// dictionary encoding (see binary_dict_block.h), there is only one dictionary
+// block for all the data blocks within a cfile.
+//
+// layout for dictionary encoded block:
+// Either header + bitshuffled codeword block, when mode_ = kCodeWordMode.
+// Or     header + bitshuffled value block, when mode_ = kBitShuffleMode.
+// Data blocks start with mode_ = kCodeWordMode. When the size of the
+// dictionary goes beyond the cfile block size, the subsequent data blocks
+// switch to bitshuffle encoding of the values themselves.
+//
+// layout for the dictionary block:
+//   num_entries: fixed32
+//   values:      num_entries * sizeof(CppType), in codeword order
+//
+// Values are stored in the dictionary by their bit pattern, so that distinct
+// floating point values which compare equal (e.g. 0.0 and -0.0) are preserved.
+#pragma once
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/binary_dict_block.h"
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/bshuf_block.h"
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/cfile/cfile_writer.h"
+#include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/rowid.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/casts.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/alignment.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace cfile {
+
+template<DataType Type>
+class NumericDictBlockBuilder final : public BlockBuilder {
+ public:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+
+  explicit NumericDictBlockBuilder(const WriterOptions* options)
+      : finished_(false),
+        options_(options),
+        data_builder_(new BShufBlockBuilder<UINT32>(options)),
+        mode_(kCodeWordMode) {
+    Reset();
+  }
+
+  // The current block is considered full when the size of data block
+  // exceeds limit or when the size of the dictionary exceeds the CFile
+  // block size.
+  //
+  // If it is the latter case, all the subsequent data blocks will switch to
+  // bitshuffle encoding automatically.
+  bool IsBlockFull() const override {
+    if (data_builder_->IsBlockFull()) return true;
+    if (mode_ == kCodeWordMode && IsDictFull()) return true;
+    return false;
+  }
+
+  // Append the dictionary block for the current cfile to the end of the
+  // cfile and set the footer accordingly.
+  Status AppendExtraInfo(CFileWriter* c_writer, CFileFooterPB* footer) override {
+    faststring header;
+    PutFixed32(&header, dict_values_.size());
+    std::vector<Slice> dict_v;
+    dict_v.emplace_back(header);
+    dict_v.emplace_back(reinterpret_cast<const uint8_t*>(dict_values_.data()),
+                        dict_values_.size() * sizeof(CppType));
+
+    BlockPointer ptr;
+    Status s = c_writer->AppendDictBlock(dict_v, &ptr, "Append dictionary block");
+    if (!s.ok()) {
+      LOG(WARNING) << "Unable to append block to file: " << s.ToString();
+      return s;
+    }
+    ptr.CopyToPB(footer->mutable_dict_block_ptr());
+    return Status::OK();
+  }
+
+  size_t EstimateExtraInfoSize() const override {
+    return sizeof(uint32_t) + dict_values_.size() * sizeof(CppType);
+  }
+
+  int Add(const uint8_t* vals, size_t count) override {
+    if (mode_ == kCodeWordMode) {
+      return AddCodeWords(vals, count);
+    }
+    DCHECK_EQ(mode_, kBitShuffleMode);
+    return data_builder_->Add(vals, count);
+  }
+
+  void Finish(rowid_t ordinal_pos, std::vector<Slice>* slices) override {
+    finished_ = true;
+
+    header_buffer_.resize(sizeof(int32_t));
+    InlineEncodeFixed32(&header_buffer_[0], mode_);
+
+    std::vector<Slice> data_slices;
+    data_builder_->Finish(ordinal_pos, &data_slices);
+    data_slices.insert(data_slices.begin(), Slice(header_buffer_));
+    *slices = std::move(data_slices);
+  }
+
+  void Reset() override {
+    if (mode_ == kCodeWordMode && IsDictFull()) {
+      mode_ = kBitShuffleMode;
+      data_builder_.reset(new BShufBlockBuilder<Type>(options_));
+    } else {
+      data_builder_->Reset();
+    }
+    finished_ = false;
+  }
+
+  size_t Count() const override {
+    return data_builder_->Count();
+  }
+
+  Status GetFirstKey(void* key) const override {
+    if (mode_ == kCodeWordMode) {
+      CHECK(finished_);
+      if (Count() == 0) {
+        return Status::NotFound("no keys in data block");
+      }
+      *reinterpret_cast<CppType*>(key) = first_key_;
+      return Status::OK();
+    }
+    DCHECK_EQ(mode_, kBitShuffleMode);
+    return data_builder_->GetFirstKey(key);
+  }
+
+  Status GetLastKey(void* key) const override {
+    if (mode_ == kCodeWordMode) {
+      CHECK(finished_);
+      uint32_t last_codeword;
+      RETURN_NOT_OK(data_builder_->GetLastKey(&last_codeword));
+      *reinterpret_cast<CppType*>(key) = dict_values_[last_codeword];
+      return Status::OK();
+    }
+    DCHECK_EQ(mode_, kBitShuffleMode);
+    return data_builder_->GetLastKey(key);
+  }
+
+ private:
+  // An unsigned integer type with the same size as CppType, used to key the
+  // dictionary by bit pattern.
+  typedef typename std::conditional<sizeof(CppType) == sizeof(uint32_t),
+                                    uint32_t, uint64_t>::type BitsType;
+  static_assert(sizeof(BitsType) == sizeof(CppType),
+                "numeric dictionary encoding requires 32 or 64-bit values");
+
+  static constexpr size_t kMaxCodeWordBatch = 1024;
+
+  bool IsDictFull() const {
+    return dict_values_.size() * sizeof(CppType) >=
+        options_->storage_attributes.cfile_block_size;
+  }
+
+  int AddCodeWords(const uint8_t* vals, size_t count) {
+    DCHECK(!finished_);
+    DCHECK_GT(count, 0);
+
+    // Look up or assign the codewords of as many values as the dictionary
+    // allows, then hand them to the codeword block all at once. The batch is
+    // bounded so that values the codeword block can't take aren't looked up
+    // over and over again: the caller simply calls Add() again.
+    count = std::min(count, kMaxCodeWordBatch);
+    codeword_buf_.resize(count * sizeof(uint32_t));
+    uint32_t* codewords = reinterpret_cast<uint32_t*>(codeword_buf_.data());
+    size_t i;
+    for (i = 0; i < count; i++) {
+      BitsType bits;
+      memcpy(&bits, vals + i * sizeof(CppType), sizeof(CppType));
+      auto it = dictionary_.find(bits);
+      if (PREDICT_TRUE(it != dictionary_.end())) {
+        codewords[i] = it->second;
+        continue;
+      }
+      // Not already in dictionary, try to add it if there is space.
+      if (PREDICT_FALSE(IsDictFull())) {
+        break;
+      }
+      codewords[i] = dict_values_.size();
+      dictionary_.emplace(bits, codewords[i]);
+      dict_values_.emplace_back();
+      memcpy(&dict_values_.back(), &bits, sizeof(CppType));
+    }
+    if (i == 0) {
+      return 0;
+    }
+
+    if (data_builder_->Count() == 0) {
+      memcpy(&first_key_, vals, sizeof(CppType));
+    }
+    return data_builder_->Add(codeword_buf_.data(), i);
+  }
+
+  // Buffer used in Finish() for holding the encoded header.
+  faststring header_buffer_;
+  bool finished_;
+  const WriterOptions* options_;
+
+  std::unique_ptr<BlockBuilder> data_builder_;
+
+  // dictionary_ and dict_values_ are related to the dictionary block (one
+  // per cfile). They should NOT be cleared in the Reset() method.
+  std::unordered_map<BitsType, uint32_t> dictionary_;
+  std::vector<CppType> dict_values_;
+
+  DictEncodingMode mode_;
+
+  // First key when mode_ = kCodeWordMode
+  CppType first_key_;
+
+  // Buffer to hold the codewords of the values being added.
+  faststring codeword_buf_;
+
+  DISALLOW_COPY_AND_ASSIGN(NumericDictBlockBuilder);
+};
+
+template<DataType Type>
+class NumericDictBlockDecoder final : public BlockDecoder {
+ public:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+
+  NumericDictBlockDecoder(Slice slice, CFileIterator* iter)
+      : data_(slice),
+        parsed_(false),
+        dict_(iter->GetNumericDict()),
+        num_dict_values_(dict_.size() / sizeof(CppType)),
+        parent_cfile_iter_(iter) {
+  }
+
+  Status ParseHeader() override {
+    CHECK(!parsed_);
+
+    if (data_.size() < kMinHeaderSize) {
+      return Status::Corruption(
+          strings::Substitute("not enough bytes for header: dictionary block header "
+                              "size ($0) less than minimum possible header length ($1)",
+                              data_.size(), kMinHeaderSize));
+    }
+
+    bool valid = tight_enum_test_cast<DictEncodingMode>(DecodeFixed32(&data_[0]), &mode_);
+    if (PREDICT_FALSE(!valid)) {
+      return Status::Corruption("header Mode information corrupted");
+    }
+    Slice content(data_.data() + 4, data_.size() - 4);
+
+    if (mode_ == kCodeWordMode) {
+      data_decoder_.reset(new BShufBlockDecoder<UINT32>(content));
+    } else {
+      if (mode_ != kBitShuffleMode) {
+        return Status::Corruption("Unrecognized Dictionary encoded data block header");
+      }
+      data_decoder_.reset(new BShufBlockDecoder<Type>(content));
+    }
+
+    RETURN_NOT_OK(data_decoder_->ParseHeader());
+    parsed_ = true;
+    return Status::OK();
+  }
+
+  void SeekToPositionInBlock(uint pos) override {
+    data_decoder_->SeekToPositionInBlock(pos);
+  }
+
+  // In codeword mode, this requires the dictionary to be sorted, which is
+  // the case for the key columns for which a value index is written.
+  Status SeekAtOrAfterValue(const void* value_void, bool* exact) override {
+    if (mode_ != kCodeWordMode) {
+      DCHECK_EQ(mode_, kBitShuffleMode);
+      return data_decoder_->SeekAtOrAfterValue(value_void, exact);
+    }
+    DCHECK(value_void != nullptr);
+    const CppType target = UnalignedLoad<CppType>(value_void);
+
+    // Binary search the dictionary for the first value >= target.
+    uint32_t lo = 0;
+    uint32_t hi = num_dict_values_;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      const CppType cur = UnalignedLoad<CppType>(dict_value_ptr(mid));
+      if (TypeTraits<Type>::Compare(&target, &cur) > 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == num_dict_values_) {
+      // This case means the value is larger than the largest key in the
+      // dictionary. Therefore, it is impossible to be in the current data
+      // block, and we adjust the index to be the end of the block.
+      data_decoder_->SeekToPositionInBlock(data_decoder_->Count() - 1);
+      return Status::NotFound("after last key in block");
+    }
+
+    const CppType found = UnalignedLoad<CppType>(dict_value_ptr(lo));
+    bool found_match = TypeTraits<Type>::Compare(&target, &found) == 0;
+    uint32_t codeword = lo;
+    bool exact_codeword;
+    RETURN_NOT_OK(data_decoder_->SeekAtOrAfterValue(&codeword, &exact_codeword));
+    *exact = found_match && exact_codeword;
+    return Status::OK();
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) override {
+    if (mode_ == kCodeWordMode) {
+      return CopyNextDecodeValues(n, dst);
+    }
+    DCHECK_EQ(mode_, kBitShuffleMode);
+    return data_decoder_->CopyNextValues(n, dst);
+  }
+
+  Status CopyNextAndEval(size_t* n,
+                         ColumnMaterializationContext* ctx,
+                         SelectionVectorView* sel,
+                         ColumnDataView* dst) override {
+    if (mode_ == kBitShuffleMode) {
+      // Copy the values and evaluate them directly.
+      return data_decoder_->CopyNextAndEval(n, ctx, sel, dst);
+    }
+    ctx->SetDecoderEvalSupported();
+
+    // Predicates that have no matching words should return no data.
+    SelectionVector* codewords_matching_pred =
+        parent_cfile_iter_->GetCodeWordsMatchingPredicate();
+    CHECK(codewords_matching_pred != nullptr);
+    if (!codewords_matching_pred->AnySelected()) {
+      // If nothing is selected, move the data_decoder_ pointer forward and
+      // clear the corresponding bits in the selection vector.
+      int skip = static_cast<int>(*n);
+      data_decoder_->SeekForward(&skip);
+      *n = static_cast<size_t>(skip);
+      sel->ClearBits(*n);
+      return Status::OK();
+    }
+
+    // IsNotNull predicates should return all data.
+    if (ctx->pred()->predicate_type() == PredicateType::IsNotNull) {
+      return CopyNextDecodeValues(n, dst);
+    }
+
+    const uint32_t* codewords;
+    RETURN_NOT_OK(CopyNextCodeWords(n, &codewords));
+    uint8_t* out = dst->data();
+    for (size_t i = 0; i < *n; i++, out += sizeof(CppType)) {
+      // Check with the SelectionVectorView to see whether the row has already
+      // been cleared, in which case we can skip evaluation.
+      if (!sel->TestBit(i)) {
+        continue;
+      }
+      if (BitmapTest(codewords_matching_pred->bitmap(), codewords[i])) {
+        memcpy(out, dict_value_ptr(codewords[i]), sizeof(CppType));
+      } else {
+        sel->ClearBit(i);
+      }
+    }
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return data_decoder_->HasNext();
+  }
+
+  size_t Count() const override {
+    return data_decoder_->Count();
+  }
+
+  size_t GetCurrentIndex() const override {
+    return data_decoder_->GetCurrentIndex();
+  }
+
+  rowid_t GetFirstRowId() const override {
+    return data_decoder_->GetFirstRowId();
+  }
+
+  static const size_t kMinHeaderSize = sizeof(uint32_t) * 1;
+
+ private:
+  const uint8_t* dict_value_ptr(uint32_t codeword) const {
+    DCHECK_LT(codeword, num_dict_values_);
+    return dict_.data() + codeword * sizeof(CppType);
+  }
+
+  // Copies the next codewords into codeword_buf_, validating them against
+  // the size of the dictionary.
+  Status CopyNextCodeWords(size_t* n, const uint32_t** codewords) {
+    DCHECK(parsed_);
+    codeword_buf_.resize(*n * sizeof(uint32_t));
+    BShufBlockDecoder<UINT32>* d_bptr =
+        down_cast<BShufBlockDecoder<UINT32>*>(data_decoder_.get());
+    RETURN_NOT_OK(d_bptr->CopyNextValuesToArray(n, codeword_buf_.data()));
+    *codewords = reinterpret_cast<const uint32_t*>(codeword_buf_.data());
+
+    uint32_t max_codeword = 0;
+    for (size_t i = 0; i < *n; i++) {
+      max_codeword = std::max(max_codeword, (*codewords)[i]);
+    }
+    if (PREDICT_FALSE(*n > 0 && max_codeword >= num_dict_values_)) {
+      return Status::Corruption(
+          strings::Substitute("codeword $0 out of range for dictionary of size $1",
+                              max_codeword, num_dict_values_));
+    }
+    return Status::OK();
+  }
+
+  Status CopyNextDecodeValues(size_t* n, ColumnDataView* dst) {
+    DCHECK_LE(*n, dst->nrows());
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+
+    const uint32_t* codewords;
+    RETURN_NOT_OK(CopyNextCodeWords(n, &codewords));
+    uint8_t* out = dst->data();
+    for (size_t i = 0; i < *n; i++, out += sizeof(CppType)) {
+      memcpy(out, dict_value_ptr(codewords[i]), sizeof(CppType));
+    }
+    return Status::OK();
+  }
+
+  Slice data_;
+  bool parsed_;
+
+  // The values of the dictionary, in codeword order. Shared by all the
+  // decoders of the same cfile iterator.
+  const Slice dict_;
+  const uint32_t num_dict_values_;
+
+  std::unique_ptr<BlockDecoder> data_decoder_;
+
+  // Parent CFileIterator, each dictionary decoder in the same CFile will share
+  // the same dictionary, and thus, the same set of matching codewords.
+  CFileIterator* parent_cfile_iter_;
+
+  DictEncodingMode mode_;
+
+  // Buffer to hold the codewords of the values being decoded.
+  faststring codeword_buf_;
+
+  DISALLOW_COPY_AND_ASSIGN(NumericDictBlockDecoder);
+};
+
+} // namespace cfile
+} // namespace kudu
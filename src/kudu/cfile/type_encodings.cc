@@ -20,12 +20,16 @@
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "kudu/cfile/binary_dict_block.h" // IWYU pragma: keep
 #include "kudu/cfile/binary_plain_block.h" // IWYU pragma: keep
 #include "kudu/cfile/binary_prefix_block.h" // IWYU pragma: keep
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/bshuf_block.h" // IWYU pragma: keep
+#include "kudu/cfile/for_block.h" // IWYU pragma: keep
+#include "kudu/cfile/fsst_block.h" // IWYU pragma: keep
+#include "kudu/cfile/numeric_dict_block.h" // IWYU pragma: keep
 #include "kudu/cfile/plain_bitmap_block.h" // IWYU pragma: keep
 #include "kudu/cfile/plain_block.h" // IWYU pragma: keep
 #include "kudu/cfile/rle_block.h" // IWYU pragma: keep
@@ -39,6 +43,7 @@ using std::make_pair;
 using std::pair;
 using std::unique_ptr;
 using std::unordered_map;
+using std::vector;
 
 namespace kudu {
 namespace cfile {
@@ -114,10 +119,32 @@ struct DataTypeEncodingTraits<BINARY, DICT_ENCODING>
   }
 };
 
+// Template specialization for FSST encoded strings.
+template<>
+struct DataTypeEncodingTraits<BINARY, FSST_ENCODING>
+    : public EncodingTraits<FsstBlockBuilder, FsstBlockDecoder> {};
+
+// Generic, fallback, partial specialization for dictionary encoding of
+// fixed size types. Only 32 and 64-bit types are supported.
+template<DataType Type>
+struct DataTypeEncodingTraits<Type, DICT_ENCODING>
+    : public EncodingTraits<NumericDictBlockBuilder<Type>, NumericDictBlockDecoder<Type>> {
+  static Status CreateBlockDecoder(unique_ptr<BlockDecoder>* bd, const Slice& slice,
+                                   CFileIterator* parent_cfile_iter) {
+    bd->reset(new NumericDictBlockDecoder<Type>(slice, parent_cfile_iter));
+    return Status::OK();
+  }
+};
+
 template<DataType IntType>
 struct DataTypeEncodingTraits<IntType, RLE>
     : public EncodingTraits<RleIntBlockBuilder<IntType>, RleIntBlockDecoder<IntType>> {};
 
+// Frame-of-reference encoding for integer types.
+template<DataType IntType>
+struct DataTypeEncodingTraits<IntType, FOR_BITPACK>
+    : public EncodingTraits<ForBlockBuilder<IntType>, ForBlockDecoder<IntType>> {};
+
 template<typename TypeEncodingTraitsClass>
 TypeEncodingInfo::TypeEncodingInfo(TypeEncodingTraitsClass /*t*/)
     : encoding_type_(TypeEncodingTraitsClass::kEncodingType),
@@ -167,6 +194,12 @@ class TypeEncodingResolver {
     return default_mapping_[t];
   }
 
+  const vector<EncodingType>& GetSupportedEncodings(DataType t) {
+    static const vector<EncodingType> kNoEncodings;
+    auto it = supported_encodings_.find(t);
+    return it == supported_encodings_.end() ? kNoEncodings : it->second;
+  }
+
   // Add the encoding mappings
   // the first encoder/decoder to be
   // added to the mapping becomes the default
@@ -175,34 +208,49 @@ class TypeEncodingResolver {
     AddMapping<UINT8, BIT_SHUFFLE>();
     AddMapping<UINT8, PLAIN_ENCODING>();
     AddMapping<UINT8, RLE>();
+    AddMapping<UINT8, FOR_BITPACK>();
     AddMapping<INT8, BIT_SHUFFLE>();
     AddMapping<INT8, PLAIN_ENCODING>();
     AddMapping<INT8, RLE>();
+    AddMapping<INT8, FOR_BITPACK>();
     AddMapping<UINT16, BIT_SHUFFLE>();
     AddMapping<UINT16, PLAIN_ENCODING>();
     AddMapping<UINT16, RLE>();
+    AddMapping<UINT16, FOR_BITPACK>();
     AddMapping<INT16, BIT_SHUFFLE>();
     AddMapping<INT16, PLAIN_ENCODING>();
     AddMapping<INT16, RLE>();
+    AddMapping<INT16, FOR_BITPACK>();
     AddMapping<UINT32, BIT_SHUFFLE>();
     AddMapping<UINT32, RLE>();
     AddMapping<UINT32, PLAIN_ENCODING>();
+    AddMapping<UINT32, FOR_BITPACK>();
+    AddMapping<UINT32, DICT_ENCODING>();
     AddMapping<INT32, BIT_SHUFFLE>();
     AddMapping<INT32, PLAIN_ENCODING>();
     AddMapping<INT32, RLE>();
+    AddMapping<INT32, FOR_BITPACK>();
+    AddMapping<INT32, DICT_ENCODING>();
     AddMapping<UINT64, BIT_SHUFFLE>();
     AddMapping<UINT64, PLAIN_ENCODING>();
     AddMapping<UINT64, RLE>();
+    AddMapping<UINT64, FOR_BITPACK>();
+    AddMapping<UINT64, DICT_ENCODING>();
     AddMapping<INT64, BIT_SHUFFLE>();
     AddMapping<INT64, PLAIN_ENCODING>();
     AddMapping<INT64, RLE>();
+    AddMapping<INT64, FOR_BITPACK>();
+    AddMapping<INT64, DICT_ENCODING>();
     AddMapping<FLOAT, BIT_SHUFFLE>();
     AddMapping<FLOAT, PLAIN_ENCODING>();
+    AddMapping<FLOAT, DICT_ENCODING>();
     AddMapping<DOUBLE, BIT_SHUFFLE>();
     AddMapping<DOUBLE, PLAIN_ENCODING>();
+    AddMapping<DOUBLE, DICT_ENCODING>();
     AddMapping<BINARY, DICT_ENCODING>();
     AddMapping<BINARY, PLAIN_ENCODING>();
     AddMapping<BINARY, PREFIX_ENCODING>();
+    AddMapping<BINARY, FSST_ENCODING>();
     AddMapping<BOOL, RLE>();
     AddMapping<BOOL, PLAIN_ENCODING>();
     AddMapping<INT128, BIT_SHUFFLE>();
@@ -217,6 +265,7 @@ class TypeEncodingResolver {
     // emplace() will no-op if the data-type is already present, so we can blindly
     // call emplace() here(i.e. no need to call find() to check before inserting)
     default_mapping_.emplace(type, encoding);
+    supported_encodings_[type].push_back(encoding);
     mapping_.emplace(make_pair(type, encoding),
                      unique_ptr<TypeEncodingInfo>(new TypeEncodingInfo(traits)));
   }
@@ -227,6 +276,8 @@ class TypeEncodingResolver {
 
   unordered_map<DataType, EncodingType, std::hash<size_t> > default_mapping_;
 
+  unordered_map<DataType, vector<EncodingType>, std::hash<size_t> > supported_encodings_;
+
   friend class Singleton<TypeEncodingResolver>;
   DISALLOW_COPY_AND_ASSIGN(TypeEncodingResolver);
 };
@@ -243,6 +294,11 @@ const EncodingType TypeEncodingInfo::GetDefaultEncoding(const TypeInfo* typeinfo
   return Singleton<TypeEncodingResolver>::get()->GetDefaultEncoding(typeinfo->physical_type());
 }
 
+const vector<EncodingType>& TypeEncodingInfo::GetSupportedEncodings(const TypeInfo* typeinfo) {
+  return Singleton<TypeEncodingResolver>::get()->GetSupportedEncodings(
+      typeinfo->physical_type());
+}
+
 }  // namespace cfile
 }  // namespace kudu
 
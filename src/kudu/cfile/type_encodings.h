@@ -18,6 +18,7 @@
 #define KUDU_CFILE_TYPE_ENCODINGS_H_
 
 #include <memory>
+#include <vector>
 
 #include "kudu/common/common.pb.h"
 #include "kudu/gutil/macros.h"
@@ -43,6 +44,10 @@ class TypeEncodingInfo {
 
   static const EncodingType GetDefaultEncoding(const TypeInfo* typeinfo);
 
+  // Return all of the encodings supported for the given type, starting with
+  // its default encoding.
+  static const std::vector<EncodingType>& GetSupportedEncodings(const TypeInfo* typeinfo);
+
   EncodingType encoding_type() const { return encoding_type_; }
 
   Status CreateBlockBuilder(std::unique_ptr<BlockBuilder>* bb, const WriterOptions* options) const;
@@ -0,0 +1,236 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/zone_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glog/logging.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+// Size of the encoded header: the number of entries and the value size.
+constexpr size_t kHeaderSize = 2 * sizeof(uint32_t);
+
+// Size of the fixed32 fields of each entry: first ordinal, number of rows
+// and null count.
+constexpr size_t kEntryFixedSize = 3 * sizeof(uint32_t);
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////
+// ZoneMapBuilder
+////////////////////////////////////////////////////////////
+
+ZoneMapBuilder::ZoneMapBuilder(const TypeInfo* type_info)
+    : type_info_(type_info),
+      value_size_(type_info->size()),
+      cur_null_count_(0),
+      cur_has_values_(false),
+      num_blocks_(0) {
+  DCHECK(IsTypeSupported(type_info_));
+  cur_min_.resize(value_size_);
+  cur_max_.resize(value_size_);
+  buffer_.resize(kHeaderSize);
+}
+
+bool ZoneMapBuilder::IsTypeSupported(const TypeInfo* type_info) {
+  switch (type_info->physical_type()) {
+    case BOOL:
+    case INT8:
+    case INT16:
+    case INT32:
+    case INT64:
+    case INT128:
+    case UINT8:
+    case UINT16:
+    case UINT32:
+    case UINT64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ZoneMapBuilder::AddValues(const void* cells, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  const uint8_t* cell = reinterpret_cast<const uint8_t*>(cells);
+  const uint8_t* end = cell + count * value_size_;
+  if (!cur_has_values_) {
+    memcpy(cur_min_.data(), cell, value_size_);
+    memcpy(cur_max_.data(), cell, value_size_);
+    cur_has_values_ = true;
+    cell += value_size_;
+  }
+  for (; cell != end; cell += value_size_) {
+    if (type_info_->Compare(cell, cur_min_.data()) < 0) {
+      memcpy(cur_min_.data(), cell, value_size_);
+    } else if (type_info_->Compare(cell, cur_max_.data()) > 0) {
+      memcpy(cur_max_.data(), cell, value_size_);
+    }
+  }
+}
+
+void ZoneMapBuilder::FinishBlock(rowid_t first_ordinal, uint32_t num_rows) {
+  DCHECK_LE(cur_null_count_, num_rows);
+  PutFixed32(&buffer_, first_ordinal);
+  PutFixed32(&buffer_, num_rows);
+  PutFixed32(&buffer_, cur_null_count_);
+  if (cur_has_values_) {
+    buffer_.append(cur_min_.data(), value_size_);
+    buffer_.append(cur_max_.data(), value_size_);
+  } else {
+    DCHECK_EQ(cur_null_count_, num_rows);
+    size_t old_size = buffer_.size();
+    buffer_.resize(old_size + 2 * value_size_);
+    memset(buffer_.data() + old_size, 0, 2 * value_size_);
+  }
+  num_blocks_++;
+
+  cur_null_count_ = 0;
+  cur_has_values_ = false;
+}
+
+Slice ZoneMapBuilder::Finish() {
+  InlineEncodeFixed32(buffer_.data(), num_blocks_);
+  InlineEncodeFixed32(buffer_.data() + sizeof(uint32_t), value_size_);
+  return Slice(buffer_);
+}
+
+////////////////////////////////////////////////////////////
+// ZoneMapReader
+////////////////////////////////////////////////////////////
+
+ZoneMapReader::ZoneMapReader(const TypeInfo* type_info)
+    : value_size_(type_info->size()),
+      entry_size_(kEntryFixedSize + 2 * value_size_),
+      entries_(nullptr),
+      num_blocks_(0) {
+}
+
+Status ZoneMapReader::Parse(const Slice& data) {
+  if (PREDICT_FALSE(data.size() < kHeaderSize)) {
+    return Status::Corruption(
+        Substitute("zone map block too short: $0 bytes", data.size()));
+  }
+  uint32_t num_entries = DecodeFixed32(data.data());
+  uint32_t value_size = DecodeFixed32(data.data() + sizeof(uint32_t));
+  if (PREDICT_FALSE(value_size != value_size_)) {
+    return Status::Corruption(
+        Substitute("zone map value size $0 does not match column type size $1",
+                   value_size, value_size_));
+  }
+  if (PREDICT_FALSE(data.size() != kHeaderSize + num_entries * entry_size_)) {
+    return Status::Corruption(
+        Substitute("zone map block has size $0, expected $1 for $2 entries",
+                   data.size(), kHeaderSize + num_entries * entry_size_, num_entries));
+  }
+  entries_ = data.data() + kHeaderSize;
+  num_blocks_ = num_entries;
+  return Status::OK();
+}
+
+rowid_t ZoneMapReader::first_ordinal(const uint8_t* entry) {
+  return DecodeFixed32(entry);
+}
+
+uint32_t ZoneMapReader::num_rows(const uint8_t* entry) {
+  return DecodeFixed32(entry + sizeof(uint32_t));
+}
+
+uint32_t ZoneMapReader::null_count(const uint8_t* entry) {
+  return DecodeFixed32(entry + 2 * sizeof(uint32_t));
+}
+
+const uint8_t* ZoneMapReader::min_value(const uint8_t* entry) const {
+  return entry + kEntryFixedSize;
+}
+
+const uint8_t* ZoneMapReader::max_value(const uint8_t* entry) const {
+  return entry + kEntryFixedSize + value_size_;
+}
+
+bool ZoneMapReader::BlockMayMatch(const uint8_t* entry, const ColumnPredicate& pred) const {
+  uint32_t nulls = null_count(entry);
+  bool has_values = nulls < num_rows(entry);
+  switch (pred.predicate_type()) {
+    case PredicateType::IsNull:
+      return nulls > 0;
+    case PredicateType::IsNotNull:
+      return has_values;
+    default:
+      // The remaining predicate types never match a null; the bounds are
+      // only meaningful if there is at least one non-null value.
+      return has_values && pred.MayMatchRange(min_value(entry), max_value(entry));
+  }
+}
+
+bool ZoneMapReader::MayMatch(rowid_t start_idx,
+                             size_t nrows,
+                             const ColumnPredicate& pred) const {
+  if (nrows == 0) {
+    return false;
+  }
+  // Find the first block which ends past 'start_idx'. Blocks are recorded in
+  // increasing ordinal order, so a binary search works.
+  size_t lo = 0;
+  size_t hi = num_blocks_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const uint8_t* e = entry(mid);
+    if (static_cast<uint64_t>(first_ordinal(e)) + num_rows(e) <= start_idx) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Check every block overlapping the requested range, making sure the
+  // blocks fully cover it.
+  uint64_t covered_until = start_idx;
+  uint64_t end_idx = static_cast<uint64_t>(start_idx) + nrows;
+  for (size_t i = lo; i < num_blocks_ && covered_until < end_idx; i++) {
+    const uint8_t* e = entry(i);
+    if (PREDICT_FALSE(first_ordinal(e) > covered_until)) {
+      // A gap in the statistics: be conservative.
+      return true;
+    }
+    if (BlockMayMatch(e, pred)) {
+      return true;
+    }
+    covered_until = static_cast<uint64_t>(first_ordinal(e)) + num_rows(e);
+  }
+  return covered_until < end_idx;
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnPredicate;
+class TypeInfo;
+
+namespace cfile {
+
+// Zone maps are per-data-block statistics of a CFile: for each data block,
+// the range of ordinals it covers, the number of null cells and the minimum
+// and maximum non-null values. They are written into a single block at the
+// end of the file, in the same order as the entries of the positional index,
+// and allow a reader to skip data blocks which cannot contain any row
+// matching a predicate.
+//
+// The encoded format is a fixed-size header followed by fixed-size entries:
+//
+//   header:
+//     num_entries: fixed32
+//     value_size:  fixed32 (the size of the column's physical type)
+//   entry:
+//     first_ordinal: fixed32
+//     num_rows:      fixed32 (including nulls)
+//     null_count:    fixed32
+//     min_value:     value_size bytes
+//     max_value:     value_size bytes
+//
+// If all of the cells in a block are null, the minimum and maximum are
+// zero-filled and should not be interpreted.
+//
+// Zone maps are only maintained for fixed-width integer types: the variable
+// length of BINARY cells and the lack of a total order among floating point
+// values (NaN) would make them either costly or unreliable.
+class ZoneMapBuilder {
+ public:
+  explicit ZoneMapBuilder(const TypeInfo* type_info);
+
+  // Returns true if zone maps can be kept for columns of the given type.
+  static bool IsTypeSupported(const TypeInfo* type_info);
+
+  // Updates the statistics of the current data block with 'count'
+  // contiguous non-null cells.
+  void AddValues(const void* cells, size_t count);
+
+  // Updates the statistics of the current data block with 'count' nulls.
+  void AddNulls(size_t count) {
+    cur_null_count_ += count;
+  }
+
+  // Records the statistics of the current data block, which starts at
+  // 'first_ordinal' and holds 'num_rows' rows, and resets them so the
+  // next data block can be tracked.
+  void FinishBlock(rowid_t first_ordinal, uint32_t num_rows);
+
+  // Returns the number of data blocks recorded so far.
+  size_t num_blocks() const {
+    return num_blocks_;
+  }
+
+  // Returns the encoded zone maps of every recorded data block.
+  // The returned Slice is only valid until the builder is destroyed or
+  // more blocks are recorded.
+  Slice Finish();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ZoneMapBuilder);
+
+  const TypeInfo* type_info_;
+  const size_t value_size_;
+
+  // Statistics of the data block currently being written.
+  uint32_t cur_null_count_;
+  bool cur_has_values_;
+  faststring cur_min_;
+  faststring cur_max_;
+
+  size_t num_blocks_;
+
+  // The encoded entries, preceded by space reserved for the header.
+  faststring buffer_;
+};
+
+// Reader for zone maps written by ZoneMapBuilder.
+class ZoneMapReader {
+ public:
+  explicit ZoneMapReader(const TypeInfo* type_info);
+
+  // Parses the given encoded zone maps.
+  //
+  // This does not copy the data, so the slice must remain valid for the
+  // lifetime of the reader.
+  Status Parse(const Slice& data);
+
+  size_t num_blocks() const {
+    return num_blocks_;
+  }
+
+  // Returns false if no row in the range ['start_idx', 'start_idx' + 'nrows')
+  // can satisfy 'pred', according to the statistics of the data blocks which
+  // overlap that range. May conservatively return true, e.g. if the range is
+  // not covered by any block.
+  bool MayMatch(rowid_t start_idx, size_t nrows, const ColumnPredicate& pred) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ZoneMapReader);
+
+  const uint8_t* entry(size_t idx) const {
+    return entries_ + idx * entry_size_;
+  }
+  static rowid_t first_ordinal(const uint8_t* entry);
+  static uint32_t num_rows(const uint8_t* entry);
+  static uint32_t null_count(const uint8_t* entry);
+  const uint8_t* min_value(const uint8_t* entry) const;
+  const uint8_t* max_value(const uint8_t* entry) const;
+
+  // Returns true if some row of the block described by 'entry' may satisfy
+  // 'pred'.
+  bool BlockMayMatch(const uint8_t* entry, const ColumnPredicate& pred) const;
+
+  const size_t value_size_;
+  const size_t entry_size_;
+
+  const uint8_t* entries_;
+  size_t num_blocks_;
+};
+
+} // namespace cfile
+} // namespace kudu
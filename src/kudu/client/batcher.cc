@@ -17,15 +17,18 @@
 
 #include "kudu/client/batcher.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/client/callbacks.h"
@@ -59,9 +62,18 @@
 #include "kudu/security/token.pb.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_service.proxy.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/pb_util.h"
 
+DEFINE_bool(client_multi_tablet_writes, false,
+            "Whether to send the operations destined to different tablets led by the "
+            "same tablet server in a single MultiWrite RPC, rather than in one Write RPC "
+            "per tablet. Tablet servers which don't support MultiWrite are written to "
+            "with one Write RPC per tablet.");
+TAG_FLAG(client_multi_tablet_writes, experimental);
+
 namespace kudu {
 namespace rpc {
 class Messenger;
@@ -78,13 +90,18 @@ using kudu::rpc::ResponseCallback;
 using kudu::rpc::RetriableRpc;
 using kudu::rpc::RetriableRpcStatus;
 using kudu::security::SignedTokenPB;
+using kudu::tserver::MultiWriteRequestPB;
+using kudu::tserver::MultiWriteResponsePB;
+using kudu::tserver::TabletServerFeatures;
 using kudu::tserver::WriteRequestPB;
 using kudu::tserver::WriteResponsePB;
 using kudu::tserver::WriteResponsePB_PerRowErrorPB;
 using std::shared_ptr;
+using std::pair;
 using std::string;
 using std::unique_ptr;
 using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 using strings::Substitute;
 
@@ -230,6 +247,14 @@ class WriteRpc : public RetriableRpc<RemoteTabletServer, WriteRequestPB, WriteRe
   const WriteResponsePB& resp() const { return resp_; }
   const string& tablet_id() const { return tablet_id_; }
 
+  // Fills in 'req' with the given ops, all of which belong to the tablet with
+  // the given ID. Doesn't set the authz token of the request.
+  static void EncodeRequest(const scoped_refptr<Batcher>& batcher,
+                            const vector<InFlightOp*>& ops,
+                            const string& tablet_id,
+                            uint64_t propagated_timestamp,
+                            WriteRequestPB* req);
+
  protected:
   void Try(RemoteTabletServer* replica, const ResponseCallback& callback) override;
   RetriableRpcStatus AnalyzeResponse(const Status& rpc_cb_status) override;
@@ -278,15 +303,26 @@ WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
       batcher_(batcher),
       ops_(std::move(ops)),
       tablet_id_(tablet_id) {
-  const Schema* schema = table()->schema().schema_;
+  EncodeRequest(batcher_, ops_, tablet_id_, propagated_timestamp, &req_);
+  // Pick up the authz token for the table.
+  FetchCachedAuthzToken();
+}
 
-  req_.set_tablet_id(tablet_id_);
+void WriteRpc::EncodeRequest(const scoped_refptr<Batcher>& batcher,
+                             const vector<InFlightOp*>& ops,
+                             const string& tablet_id,
+                             uint64_t propagated_timestamp,
+                             WriteRequestPB* req) {
+  const KuduTable* table = ops[0]->write_op->table();
+  const Schema* schema = table->schema().schema_;
+
+  req->set_tablet_id(tablet_id);
   switch (batcher->external_consistency_mode()) {
     case kudu::client::KuduSession::CLIENT_PROPAGATED:
-      req_.set_external_consistency_mode(kudu::CLIENT_PROPAGATED);
+      req->set_external_consistency_mode(kudu::CLIENT_PROPAGATED);
       break;
     case kudu::client::KuduSession::COMMIT_WAIT:
-      req_.set_external_consistency_mode(kudu::COMMIT_WAIT);
+      req->set_external_consistency_mode(kudu::COMMIT_WAIT);
       break;
     default:
       LOG(FATAL) << "Unsupported consistency mode: " << batcher->external_consistency_mode();
@@ -294,26 +330,24 @@ WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
   }
   // If set, propagate the latest observed timestamp.
   if (PREDICT_TRUE(propagated_timestamp != KuduClient::kNoTimestamp)) {
-    req_.set_propagated_timestamp(propagated_timestamp);
+    req->set_propagated_timestamp(propagated_timestamp);
   }
 
   // Set up schema
-  CHECK_OK(SchemaToPB(*schema, req_.mutable_schema(),
+  CHECK_OK(SchemaToPB(*schema, req->mutable_schema(),
                       SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES |
                       SCHEMA_PB_WITHOUT_IDS |
                       SCHEMA_PB_WITHOUT_COMMENT));
 
-  // Pick up the authz token for the table.
-  FetchCachedAuthzToken();
-  RowOperationsPB* requested = req_.mutable_row_operations();
+  RowOperationsPB* requested = req->mutable_row_operations();
 
   // Add the rows
   int ctr = 0;
   RowOperationsPBEncoder enc(requested);
-  for (InFlightOp* op : ops_) {
+  for (InFlightOp* op : ops) {
 #ifndef NDEBUG
     const Partition& partition = op->tablet->partition();
-    const PartitionSchema& partition_schema = table()->partition_schema();
+    const PartitionSchema& partition_schema = table->partition_schema();
     const KuduPartialRow& row = op->write_op->row();
     bool partition_contains_row;
     CHECK(partition_schema.PartitionContainsRow(partition, row, &partition_contains_row).ok());
@@ -333,7 +367,7 @@ WriteRpc::WriteRpc(const scoped_refptr<Batcher>& batcher,
   }
 
   VLOG(3) << Substitute("Created batch for $0:\n$1",
-                        tablet_id, SecureShortDebugString(req_));
+                        tablet_id, SecureShortDebugString(*req));
 }
 
 WriteRpc::~WriteRpc() {
@@ -434,7 +468,7 @@ void WriteRpc::Finish(const Status& status) {
                    ops_.size(), tablet_id_, num_attempts()));
     KLOG_EVERY_N_SECS(WARNING, 1) << final_status.ToString();
   }
-  batcher_->ProcessWriteResponse(*this, final_status);
+  batcher_->ProcessWriteResponse(ops_, resp_, tablet_id_, final_status);
 }
 
 RetriableRpcStatus WriteRpc::AnalyzeResponse(const Status& rpc_cb_status) {
@@ -578,6 +612,282 @@ void WriteRpc::GotNewAuthzTokenRetryCb(const Status& status) {
   RetriableRpc::GotNewAuthzTokenRetryCb(status);
 }
 
+// Picks the same tablet server every time: the one which led all of the
+// tablets of a MultiWriteRpc when the RPC was created.
+class FixedServerPicker : public rpc::ServerPicker<RemoteTabletServer> {
+ public:
+  FixedServerPicker(KuduClient* client, RemoteTabletServer* server)
+      : client_(client),
+        server_(server) {
+  }
+
+  void PickLeader(const ServerPickedCallback& callback, const MonoTime& /*deadline*/) override {
+    RemoteTabletServer* server = server_;
+    server_->InitProxy(client_, [callback, server](const Status& s) {
+      callback(s, s.ok() ? server : nullptr);
+    });
+  }
+
+  // A MultiWriteRpc is never failed over to another server: the tablets it
+  // writes to may not share any other replica.
+  void MarkServerFailed(RemoteTabletServer* /*server*/, const Status& /*status*/) override {}
+  void MarkReplicaNotLeader(RemoteTabletServer* /*replica*/) override {}
+  void MarkResourceNotFound(RemoteTabletServer* /*replica*/) override {}
+
+ private:
+  KuduClient* const client_;
+  RemoteTabletServer* const server_;
+};
+
+// A MultiWrite RPC which carries the ops for several tablets led by the same
+// tablet server. The server applies the write to each tablet separately.
+//
+// Exactly-once semantics are tracked for the RPC as a whole, so the RPC is
+// only ever retried against the same server. The write to any tablet which
+// the server couldn't apply (e.g. because it's no longer the tablet's leader)
+// is resent in a per-tablet WriteRpc, which takes care of finding the new
+// leader, refreshing the authz token, etc. The same goes for all of the
+// tablets if the server doesn't support MultiWrite or couldn't be reached.
+//
+// Keeps a reference on the owning batcher while alive.
+class MultiWriteRpc : public RetriableRpc<RemoteTabletServer,
+                                          MultiWriteRequestPB,
+                                          MultiWriteResponsePB> {
+ public:
+  typedef vector<pair<RemoteTablet*, vector<InFlightOp*>>> TabletOps;
+
+  MultiWriteRpc(const scoped_refptr<Batcher>& batcher,
+                RemoteTabletServer* server,
+                const scoped_refptr<RequestTracker>& request_tracker,
+                TabletOps tablet_ops,
+                const MonoTime& deadline,
+                shared_ptr<Messenger> messenger,
+                uint64_t propagated_timestamp);
+  virtual ~MultiWriteRpc();
+  string ToString() const override;
+
+ protected:
+  void Try(RemoteTabletServer* replica, const ResponseCallback& callback) override;
+  RetriableRpcStatus AnalyzeResponse(const Status& rpc_cb_status) override;
+  void Finish(const Status& status) override;
+  bool GetNewAuthnTokenAndRetry() override;
+
+ private:
+  // Pointer back to the batcher. Processes the write responses when the RPC
+  // completes, regardless of success or failure.
+  scoped_refptr<Batcher> batcher_;
+
+  // The tablet server all of the tablets were led by.
+  RemoteTabletServer* server_;
+
+  // The ops which were batched into this RPC, grouped by tablet, in the same
+  // order as the writes of the request. These operations are in kRequestSent
+  // state.
+  TabletOps tablet_ops_;
+
+  // Total number of ops across all tablets.
+  int num_ops_;
+
+  // Whether the writes should be resent in per-tablet WriteRpcs. Only set
+  // when it's certain that the server didn't apply any of them.
+  bool fall_back_to_per_tablet_writes_;
+};
+
+MultiWriteRpc::MultiWriteRpc(const scoped_refptr<Batcher>& batcher,
+                             RemoteTabletServer* server,
+                             const scoped_refptr<RequestTracker>& request_tracker,
+                             TabletOps tablet_ops,
+                             const MonoTime& deadline,
+                             shared_ptr<Messenger> messenger,
+                             uint64_t propagated_timestamp)
+    : RetriableRpc(make_scoped_refptr(new FixedServerPicker(batcher->client_, server)),
+                   request_tracker, deadline, std::move(messenger)),
+      batcher_(batcher),
+      server_(server),
+      tablet_ops_(std::move(tablet_ops)),
+      num_ops_(0),
+      fall_back_to_per_tablet_writes_(false) {
+  for (const auto& e : tablet_ops_) {
+    WriteRequestPB* write_req = req_.add_requests();
+    WriteRpc::EncodeRequest(batcher_, e.second, e.first->tablet_id(),
+                            propagated_timestamp, write_req);
+    SignedTokenPB signed_token;
+    const KuduTable* table = e.second[0]->write_op->table();
+    if (batcher_->client_->data_->FetchCachedAuthzToken(table->id(), &signed_token)) {
+      *write_req->mutable_authz_token() = std::move(signed_token);
+    }
+    num_ops_ += e.second.size();
+  }
+}
+
+MultiWriteRpc::~MultiWriteRpc() {
+  // Ops which were handed over to a WriteRpc are deleted by that RPC.
+  for (const auto& e : tablet_ops_) {
+    for (InFlightOp* op : e.second) {
+      delete op;
+    }
+  }
+}
+
+string MultiWriteRpc::ToString() const {
+  return Substitute("MultiWrite(tablet server: $0, num_tablets: $1, num_ops: $2, "
+                    "num_attempts: $3)",
+                    server_->ToString(), tablet_ops_.size(), num_ops_, num_attempts());
+}
+
+void MultiWriteRpc::Try(RemoteTabletServer* replica, const ResponseCallback& callback) {
+  VLOG(2) << "Writing batch for " << tablet_ops_.size() << " tablets to tablet server "
+          << replica->ToString();
+  mutable_retrier()->mutable_controller()->RequireServerFeature(
+      TabletServerFeatures::MULTI_WRITE_FEATURE);
+  replica->proxy()->MultiWriteAsync(req_, &resp_,
+                                    mutable_retrier()->mutable_controller(),
+                                    callback);
+}
+
+RetriableRpcStatus MultiWriteRpc::AnalyzeResponse(const Status& rpc_cb_status) {
+  RetriableRpcStatus result;
+  result.status = rpc_cb_status;
+  if (rpc_cb_status.ok()) {
+    result.status = mutable_retrier()->controller().status();
+  } else if (!rpc_cb_status.IsTimedOut() && num_attempts() == 0) {
+    // We couldn't even set up the proxy to the server, and nothing was sent
+    // by any previous attempt.
+    fall_back_to_per_tablet_writes_ = true;
+    result.result = RetriableRpcStatus::NON_RETRIABLE_ERROR;
+    return result;
+  }
+
+  if (result.status.IsRemoteError()) {
+    const ErrorStatusPB* err = mutable_retrier()->controller().error_response();
+    if (err && err->has_code() &&
+        (err->code() == ErrorStatusPB::ERROR_SERVER_TOO_BUSY ||
+         err->code() == ErrorStatusPB::ERROR_UNAVAILABLE)) {
+      result.result = RetriableRpcStatus::SERVICE_UNAVAILABLE;
+      return result;
+    }
+    if (err && (err->unsupported_feature_flags_size() > 0 ||
+                (err->has_code() && err->code() == ErrorStatusPB::ERROR_NO_SUCH_METHOD))) {
+      // The server doesn't know about MultiWrite, so it didn't apply anything.
+      fall_back_to_per_tablet_writes_ = true;
+      result.status = Status::NotSupported("tablet server does not support MultiWrite");
+      result.result = RetriableRpcStatus::NON_RETRIABLE_ERROR;
+      return result;
+    }
+  }
+
+  if (result.status.IsServiceUnavailable()) {
+    result.result = RetriableRpcStatus::SERVICE_UNAVAILABLE;
+    return result;
+  }
+
+  if (result.status.IsNotAuthorized()) {
+    const ErrorStatusPB* err = mutable_retrier()->controller().error_response();
+    if (err && err->has_code() &&
+        err->code() == ErrorStatusPB::FATAL_INVALID_AUTHENTICATION_TOKEN) {
+      result.result = RetriableRpcStatus::INVALID_AUTHENTICATION_TOKEN;
+      return result;
+    }
+  }
+
+  // If connection negotiation failed on the only attempt so far, the request
+  // never reached the server.
+  if (!rpc_cb_status.IsTimedOut() && !result.status.ok() &&
+      mutable_retrier()->controller().negotiation_failed() && num_attempts() <= 1) {
+    fall_back_to_per_tablet_writes_ = true;
+    result.result = RetriableRpcStatus::NON_RETRIABLE_ERROR;
+    return result;
+  }
+
+  // Any other network error leaves it unknown whether the writes were
+  // applied: retry against the same server, relying on the server's result
+  // tracking to apply them at most once.
+  if (result.status.IsNetworkError()) {
+    result.result = RetriableRpcStatus::SERVER_NOT_ACCESSIBLE;
+    return result;
+  }
+
+  if (result.status.ok() && resp_.responses_size() != static_cast<int>(tablet_ops_.size())) {
+    result.status = Status::IllegalState(
+        Substitute("MultiWrite response has $0 writes, expected $1",
+                   resp_.responses_size(), tablet_ops_.size()));
+  }
+
+  if (result.status.ok()) {
+    result.result = RetriableRpcStatus::OK;
+  } else {
+    result.result = RetriableRpcStatus::NON_RETRIABLE_ERROR;
+  }
+  return result;
+}
+
+void MultiWriteRpc::Finish(const Status& status) {
+  unique_ptr<MultiWriteRpc> this_instance(this);
+  if (fall_back_to_per_tablet_writes_) {
+    VLOG(1) << Substitute("Resending $0 as per-tablet writes: $1",
+                          ToString(), status.ToString());
+    for (auto& e : tablet_ops_) {
+      batcher_->FlushBuffer(e.first, e.second);
+      e.second.clear();
+    }
+    return;
+  }
+
+  if (!status.ok()) {
+    Status final_status = status.CloneAndPrepend(
+        Substitute("Failed to write batch of $0 ops to $1 tablets at tablet server $2 "
+                   "after $3 attempt(s)",
+                   num_ops_, tablet_ops_.size(), server_->ToString(), num_attempts()));
+    KLOG_EVERY_N_SECS(WARNING, 1) << final_status.ToString();
+    for (const auto& e : tablet_ops_) {
+      batcher_->ProcessWriteResponse(e.second, WriteResponsePB(), e.first->tablet_id(),
+                                     final_status);
+    }
+    return;
+  }
+
+  const unordered_set<int> unsubmitted_writes(resp_.unsubmitted_writes().begin(),
+                                              resp_.unsubmitted_writes().end());
+  for (int i = 0; i < resp_.responses_size(); i++) {
+    RemoteTablet* tablet = tablet_ops_[i].first;
+    vector<InFlightOp*>& ops = tablet_ops_[i].second;
+    const WriteResponsePB& write_resp = resp_.responses(i);
+    if (!write_resp.has_error()) {
+      batcher_->ProcessWriteResponse(ops, write_resp, tablet->tablet_id(), Status::OK());
+      continue;
+    }
+    if (ContainsKey(unsubmitted_writes, i)) {
+      // The server rejected the write before submitting it, so it wasn't
+      // applied and can go through the per-tablet write path, which handles
+      // leader changes and throttling.
+      VLOG(2) << Substitute("Resending write to tablet $0 from $1 as a per-tablet write: $2",
+                            tablet->tablet_id(), ToString(),
+                            SecureShortDebugString(write_resp.error()));
+      batcher_->FlushBuffer(tablet, ops);
+      ops.clear();
+      continue;
+    }
+    // The write failed after it was submitted. It may still be applied, e.g. if
+    // it was replicated before the leader stepped down, and it isn't tracked
+    // by the server's result tracker, so resending it could apply it twice.
+    Status s = StatusFromPB(write_resp.error().status()).CloneAndPrepend(
+        Substitute("Failed to write batch of $0 ops to tablet $1 at tablet server $2",
+                   ops.size(), tablet->tablet_id(), server_->ToString()));
+    batcher_->ProcessWriteResponse(ops, write_resp, tablet->tablet_id(), s);
+  }
+}
+
+bool MultiWriteRpc::GetNewAuthnTokenAndRetry() {
+  // Since we know we may retry, clear the existing response.
+  resp_.Clear();
+  KuduClient* c = batcher_->client_;
+  VLOG(1) << "Retrieving new authn token from master";
+  c->data_->ConnectToClusterAsync(c, retrier().deadline(),
+      [this](const Status& s) { this->GotNewAuthnTokenRetryCb(s); },
+      CredentialsPolicy::PRIMARY_CREDENTIALS);
+  return true;
+}
+
 Batcher::Batcher(KuduClient* client,
                  scoped_refptr<ErrorCollector> error_collector,
                  sp::weak_ptr<KuduSession> session,
@@ -690,6 +1000,7 @@ void Batcher::FlushAsync(KuduStatusCallback* cb) {
     CHECK_EQ(state_, kGatheringOps);
     state_ = kFlushing;
     flush_callback_ = cb;
+    flush_start_time_ = MonoTime::Now();
     deadline_ = ComputeDeadlineUnlocked();
   }
 
@@ -868,6 +1179,47 @@ void Batcher::FlushBuffersIfReady() {
     ops_copy.swap(per_tablet_ops_);
   }
 
+  if (FLAGS_client_multi_tablet_writes) {
+    // Group the tablets by the tablet server leading them, sending the ops for
+    // all of a server's tablets in one RPC.
+    unordered_map<RemoteTabletServer*, MultiWriteRpc::TabletOps> ops_by_server;
+    for (OpsMap::value_type& e : ops_copy) {
+      RemoteTablet* tablet = e.first;
+      RemoteTabletServer* leader = tablet->LeaderTServer();
+      if (leader == nullptr) {
+        // Let the per-tablet write find the leader.
+        VLOG(3) << "FlushBuffersIfReady: no known leader, immediately flushing to "
+                << tablet->tablet_id();
+        FlushBuffer(tablet, e.second);
+        continue;
+      }
+      ops_by_server[leader].emplace_back(tablet, std::move(e.second));
+    }
+    for (auto& e : ops_by_server) {
+      MultiWriteRpc::TabletOps& tablet_ops = e.second;
+      if (tablet_ops.size() == 1) {
+        FlushBuffer(tablet_ops[0].first, tablet_ops[0].second);
+        continue;
+      }
+      VLOG(3) << "FlushBuffersIfReady: already in flushing state, immediately flushing "
+              << tablet_ops.size() << " tablets to " << e.first->ToString();
+      // Honor the longest of the delays the server suggested for the tablets.
+      MonoDelta delay = MonoDelta::FromNanoseconds(0);
+      for (const auto& t : tablet_ops) {
+        delay = std::max(delay, t.first->WriteDelay());
+      }
+      MultiWriteRpc* rpc = new MultiWriteRpc(this,
+                                             e.first,
+                                             client_->data_->request_tracker_,
+                                             std::move(tablet_ops),
+                                             deadline_,
+                                             client_->data_->messenger_,
+                                             client_->data_->GetLatestObservedTimestamp());
+      SendWriteRpc(rpc, delay);
+    }
+    return;
+  }
+
   // Now flush the ops for each tablet.
   for (const OpsMap::value_type& e : ops_copy) {
     RemoteTablet* tablet = e.first;
@@ -902,10 +1254,22 @@ void Batcher::FlushBuffer(RemoteTablet* tablet, const vector<InFlightOp*>& ops)
                                client_->data_->messenger_,
                                tablet->tablet_id(),
                                client_->data_->GetLatestObservedTimestamp());
-  rpc->SendRpc();
+  SendWriteRpc(rpc, tablet->WriteDelay());
+}
+
+void Batcher::SendWriteRpc(rpc::Rpc* rpc, const MonoDelta& delay) {
+  if (delay.ToNanoseconds() > 0) {
+    VLOG(3) << "Delaying " << rpc->ToString() << " by " << delay.ToString()
+            << " as suggested by the tablet server";
+    rpc->SendRpcAfter(delay);
+  } else {
+    rpc->SendRpc();
+  }
 }
 
-void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
+void Batcher::ProcessWriteResponse(const vector<InFlightOp*>& ops,
+                                   const WriteResponsePB& resp,
+                                   const string& tablet_id,
                                    const Status& s) {
   // TODO: there is a potential race here -- if the Batcher gets destructed while
   // RPCs are in-flight, then accessing state_ will crash. We probably need to keep
@@ -914,12 +1278,15 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   CHECK_EQ(state_, kFlushing);
 
   if (s.ok()) {
-    if (rpc.resp().has_timestamp()) {
-      client_->data_->UpdateLatestObservedTimestamp(rpc.resp().timestamp());
+    if (resp.has_timestamp()) {
+      client_->data_->UpdateLatestObservedTimestamp(resp.timestamp());
+    }
+    if (resp.has_suggested_delay_ms() && !ops.empty()) {
+      ops[0]->tablet->DelayWrites(MonoDelta::FromMilliseconds(resp.suggested_delay_ms()));
     }
   } else {
     // Mark each of the rows in the write op as failed, since the whole RPC failed.
-    for (InFlightOp* op : rpc.ops()) {
+    for (InFlightOp* op : ops) {
       unique_ptr<KuduError> error(new KuduError(op->write_op.release(), s));
       error_collector_->AddError(std::move(error));
     }
@@ -928,19 +1295,19 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   }
 
   // Check individual row errors.
-  for (const WriteResponsePB_PerRowErrorPB& err_pb : rpc.resp().per_row_errors()) {
+  for (const WriteResponsePB_PerRowErrorPB& err_pb : resp.per_row_errors()) {
     // TODO(todd): handle case where we get one of the more specific TS errors
     // like the tablet not being hosted?
 
-    if (err_pb.row_index() >= rpc.ops().size()) {
+    if (err_pb.row_index() >= ops.size()) {
       LOG(ERROR) << "Received a per_row_error for an out-of-bound op index "
                  << err_pb.row_index() << " (sent only "
-                 << rpc.ops().size() << " ops)";
-      LOG(ERROR) << "Response from tablet " << rpc.tablet_id() << ":\n"
-                 << SecureDebugString(rpc.resp());
+                 << ops.size() << " ops)";
+      LOG(ERROR) << "Response from tablet " << tablet_id << ":\n"
+                 << SecureDebugString(resp);
       continue;
     }
-    unique_ptr<KuduWriteOperation> op = std::move(rpc.ops()[err_pb.row_index()]->write_op);
+    unique_ptr<KuduWriteOperation> op = std::move(ops[err_pb.row_index()]->write_op);
     VLOG(2) << "Error on op " << op->ToString() << ": "
             << SecureShortDebugString(err_pb.error());
     Status op_status = StatusFromPB(err_pb.error());
@@ -970,7 +1337,7 @@ void Batcher::ProcessWriteResponse(const WriteRpc& rpc,
   //     from which the Flush() is being called.
   {
     std::lock_guard<simple_spinlock> l(lock_);
-    for (InFlightOp* op : rpc.ops()) {
+    for (InFlightOp* op : ops) {
       CHECK_EQ(1, ops_.erase(op))
             << "Could not remove op " << op->ToString()
             << " from in-flight list";
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -37,6 +38,15 @@
 #include "kudu/util/status.h"
 
 namespace kudu {
+
+namespace rpc {
+class Rpc;
+} // namespace rpc
+
+namespace tserver {
+class WriteResponsePB;
+} // namespace tserver
+
 namespace client {
 
 class KuduStatusCallback;
@@ -44,6 +54,7 @@ class KuduStatusCallback;
 namespace internal {
 
 class ErrorCollector;
+class MultiWriteRpc;
 class RemoteTablet;
 class WriteRpc;
 struct InFlightOp;
@@ -118,6 +129,13 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
     return first_op_time_;
   }
 
+  // Get the time FlushAsync() was called. If the batch hasn't been flushed
+  // yet, the returned MonoTime object is not initialized.
+  const MonoTime& flush_start_time() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return flush_start_time_;
+  }
+
   // Return the total size (number of bytes) of all pending write operations
   // accumulated by the batcher.
   int64_t buffer_bytes_used() const {
@@ -131,6 +149,7 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
 
  private:
   friend class RefCountedThreadSafe<Batcher>;
+  friend class MultiWriteRpc;
   friend class WriteRpc;
 
   ~Batcher();
@@ -158,9 +177,15 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   void FlushBuffersIfReady();
   void FlushBuffer(RemoteTablet* tablet, const std::vector<InFlightOp*>& ops);
 
-  // Cleans up an RPC response, scooping out any errors and passing them up
-  // to the batcher.
-  void ProcessWriteResponse(const WriteRpc& rpc, const Status& s);
+  // Sends 'rpc', after 'delay' if it's positive.
+  static void SendWriteRpc(rpc::Rpc* rpc, const MonoDelta& delay);
+
+  // Cleans up the response to a write of 'ops' to the given tablet, scooping
+  // out any errors and passing them up to the batcher.
+  void ProcessWriteResponse(const std::vector<InFlightOp*>& ops,
+                            const tserver::WriteResponsePB& resp,
+                            const std::string& tablet_id,
+                            const Status& s);
 
   // Async Callbacks.
   void TabletLookupFinished(InFlightOp* op, const Status& s);
@@ -192,6 +217,9 @@ class Batcher : public RefCountedThreadSafe<Batcher> {
   // The time when the very first operation was added into the batcher.
   MonoTime first_op_time_;
 
+  // The time when FlushAsync() was called.
+  MonoTime flush_start_time_;
+
   // Set to true if there was at least one error from this Batcher.
   // Protected by lock_
   bool had_errors_;
@@ -118,6 +118,16 @@ using internal::ConnectToClusterRpc;
 using internal::RemoteTablet;
 using internal::RemoteTabletServer;
 
+namespace {
+// The longest scan open latency tracked precisely; longer ones are recorded
+// as this.
+const int64_t kMaxScanOpenLatencyUs = 60 * 1000 * 1000;
+
+// The number of scan open latencies to record before their percentiles are
+// trusted for hedging.
+const int64_t kMinScanOpenLatencySamples = 20;
+} // anonymous namespace
+
 Status RetryFunc(const MonoTime& deadline,
                  const string& retry_msg,
                  const string& timeout_msg,
@@ -168,7 +178,8 @@ KuduClient::Data::Data()
           FLAGS_dns_resolver_cache_capacity_mb * 1024 * 1024,
           MonoDelta::FromSeconds(FLAGS_dns_resolver_cache_ttl_sec))),
       hive_metastore_sasl_enabled_(false),
-      latest_observed_timestamp_(KuduClient::kNoTimestamp) {
+      latest_observed_timestamp_(KuduClient::kNoTimestamp),
+      scan_open_latency_us_(kMaxScanOpenLatencyUs, 2) {
 }
 
 KuduClient::Data::~Data() {
@@ -201,7 +212,8 @@ RemoteTabletServer* KuduClient::Data::SelectTServer(
       break;
     }
     case CLOSEST_REPLICA:
-    case FIRST_REPLICA: {
+    case FIRST_REPLICA:
+    case LOWEST_LATENCY: {
       rt->GetRemoteTabletServers(candidates);
       // Exclude all the blacklisted candidates.
       vector<RemoteTabletServer*> filtered;
@@ -218,6 +230,26 @@ RemoteTabletServer* KuduClient::Data::SelectTServer(
         }
         break;
       }
+      if (selection == LOWEST_LATENCY) {
+        // Choose the replica with the lowest expected cost, breaking ties
+        // randomly so that unmeasured replicas are all sampled.
+        small_vector<RemoteTabletServer*, 3> cheapest;
+        double min_cost = 0;
+        for (RemoteTabletServer* rts : filtered) {
+          const double cost = rts->ExpectedRpcCost();
+          if (cheapest.empty() || cost < min_cost) {
+            cheapest.clear();
+            min_cost = cost;
+          }
+          if (cost == min_cost) {
+            cheapest.push_back(rts);
+          }
+        }
+        if (!cheapest.empty()) {
+          ret = cheapest[rand() % cheapest.size()];
+        }
+        break;
+      }
       // Choose a replica as follows:
       // 1. If there is a replica local to the client, pick it. If there are
       // multiple, pick a random one.
@@ -813,5 +845,17 @@ void KuduClient::Data::UpdateLatestObservedTimestamp(uint64_t timestamp) {
   latest_observed_timestamp_.StoreMax(timestamp);
 }
 
+void KuduClient::Data::RecordScanOpenLatency(const MonoDelta& latency) {
+  scan_open_latency_us_.Increment(
+      std::min(std::max<int64_t>(latency.ToMicroseconds(), 0), kMaxScanOpenLatencyUs));
+}
+
+MonoDelta KuduClient::Data::ScanOpenLatencyPercentile(double percentile) const {
+  if (scan_open_latency_us_.TotalCount() < kMinScanOpenLatencySamples) {
+    return MonoDelta();
+  }
+  return MonoDelta::FromMicroseconds(scan_open_latency_us_.ValueAtPercentile(percentile));
+}
+
 } // namespace client
 } // namespace kudu
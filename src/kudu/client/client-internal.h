@@ -33,6 +33,7 @@
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/rpc/user_credentials.h"
 #include "kudu/util/atomic.h"
+#include "kudu/util/hdr_histogram.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
@@ -240,6 +241,14 @@ class KuduClient::Data {
 
   void UpdateLatestObservedTimestamp(uint64_t timestamp);
 
+  // Records the latency of a successful RPC which opened the scan of a tablet.
+  void RecordScanOpenLatency(const MonoDelta& latency);
+
+  // Returns the latency at 'percentile' of those recorded with
+  // RecordScanOpenLatency(), or an uninitialized MonoDelta if too few
+  // latencies were recorded so far to tell.
+  MonoDelta ScanOpenLatencyPercentile(double percentile) const;
+
   // The unique id of this client.
   std::string client_id_;
 
@@ -309,6 +318,10 @@ class KuduClient::Data {
 
   AtomicInt<uint64_t> latest_observed_timestamp_;
 
+  // Latencies, in microseconds, of the successful RPCs which opened tablet
+  // scans, used to time hedged scan requests.
+  HdrHistogram scan_open_latency_us_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
@@ -106,6 +106,7 @@
 #include "kudu/util/array_view.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/barrier.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"  // IWYU pragma: keep
 #include "kudu/util/metrics.h"
@@ -125,6 +126,7 @@
 DECLARE_bool(allow_unsafe_replication_factor);
 DECLARE_bool(catalog_manager_support_live_row_count);
 DECLARE_bool(catalog_manager_support_on_disk_size);
+DECLARE_bool(client_multi_tablet_writes);
 DECLARE_bool(client_use_unix_domain_sockets);
 DECLARE_bool(fail_dns_resolution);
 DECLARE_bool(location_mapping_by_uuid);
@@ -166,7 +168,9 @@ METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetMasterRegi
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTableLocations);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTableSchema);
 METRIC_DECLARE_histogram(handler_latency_kudu_master_MasterService_GetTabletLocations);
+METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_MultiWrite);
 METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_Scan);
+METRIC_DECLARE_histogram(handler_latency_kudu_tserver_TabletServerService_Write);
 
 using base::subtle::Atomic32;
 using base::subtle::NoBarrier_AtomicIncrement;
@@ -1413,6 +1417,61 @@ TEST_F(ClientTest, TestScanCloseProxy) {
   }
 }
 
+// Scan with the next batch prefetched, holding on to each batch until the
+// following one has been fetched, and make sure every row comes back once.
+TEST_F(ClientTest, TestScanWithPrefetching) {
+  NO_FATALS(InsertTestRows(client_table_.get(), FLAGS_test_scan_num_rows));
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetPrefetching(true));
+  ASSERT_OK(scanner.SetBatchSizeBytes(100));
+  ASSERT_OK(scanner.SetProjectedColumnNames({ "key" }));
+  ASSERT_OK(scanner.Open());
+  ASSERT_TRUE(scanner.SetPrefetching(false).IsIllegalState());
+
+  KuduScanBatch batches[2];
+  vector<int32_t> prev_keys;
+  vector<int32_t> all_keys;
+  int num_batches = 0;
+  while (scanner.HasMoreRows()) {
+    KuduScanBatch* batch = &batches[num_batches % 2];
+    const KuduScanBatch* prev = &batches[(num_batches + 1) % 2];
+    ASSERT_OK(scanner.NextBatch(batch));
+    num_batches++;
+    // The previous batch must be unaffected by fetching this one.
+    vector<int32_t> keys;
+    for (const KuduScanBatch::RowPtr& row : *prev) {
+      int32_t key;
+      ASSERT_OK(row.GetInt32(0, &key));
+      keys.push_back(key);
+    }
+    ASSERT_EQ(prev_keys, keys);
+    prev_keys.clear();
+    for (const KuduScanBatch::RowPtr& row : *batch) {
+      int32_t key;
+      ASSERT_OK(row.GetInt32(0, &key));
+      prev_keys.push_back(key);
+      all_keys.push_back(key);
+    }
+  }
+  ASSERT_GT(num_batches, 2);
+  std::sort(all_keys.begin(), all_keys.end());
+  ASSERT_EQ(FLAGS_test_scan_num_rows, static_cast<int>(all_keys.size()));
+  for (int i = 0; i < FLAGS_test_scan_num_rows; i++) {
+    ASSERT_EQ(i, all_keys[i]);
+  }
+
+  // Closing a scanner with a prefetch outstanding is fine too.
+  KuduScanner partial(client_table_.get());
+  ASSERT_OK(partial.SetPrefetching(true));
+  ASSERT_OK(partial.SetBatchSizeBytes(100));
+  ASSERT_OK(partial.Open());
+  KuduScanBatch batch;
+  ASSERT_OK(partial.NextBatch(&batch));
+  ASSERT_OK(partial.NextBatch(&batch));
+  partial.Close();
+}
+
 // Check that the client scanner does not redact rows.
 TEST_F(ClientTest, TestRowPtrNoRedaction) {
   google::SetCommandLineOption("redact", "log");
@@ -2083,6 +2142,88 @@ TEST_F(ClientTest, TestMetaCacheExpiry) {
   ASSERT_FALSE(entry.stale());
 }
 
+// Test that prefetching the tablet locations of a table caches the locations
+// of all its tablets, so that subsequent writes don't need to ask the master.
+TEST_F(ClientTest, TestPrefetchTabletLocations) {
+  constexpr int kNumTablets = 32;
+  vector<unique_ptr<KuduPartialRow>> split_rows;
+  for (int i = 1; i < kNumTablets; i++) {
+    unique_ptr<KuduPartialRow> row(schema_.NewRow());
+    ASSERT_OK(row->SetInt32(0, i * 10));
+    split_rows.emplace_back(std::move(row));
+  }
+  shared_ptr<KuduTable> table;
+  NO_FATALS(CreateTable("prefetch", 1, std::move(split_rows), {}, &table));
+  client_->data_->meta_cache_->ClearCache();
+
+  // A single master round trip is enough to fetch all the locations.
+  int master_rpcs_before = CountMasterLookupRPCs();
+  ASSERT_OK(table->PrefetchTabletLocations());
+  ASSERT_EQ(1, CountMasterLookupRPCs() - master_rpcs_before);
+
+  // Prefetching again is a no-op while the cached locations are fresh, and
+  // writing to every tablet doesn't require any further lookups.
+  master_rpcs_before = CountMasterLookupRPCs();
+  ASSERT_OK(table->PrefetchTabletLocations());
+  NO_FATALS(InsertTestRows(table.get(), kNumTablets * 10));
+  ASSERT_EQ(0, CountMasterLookupRPCs() - master_rpcs_before);
+}
+
+TEST_F(ClientTest, TestMultiGet) {
+  constexpr int kNumRows = 100;
+  NO_FATALS(InsertTestRows(client_table_.get(), kNumRows));
+  // Null out the string of one of the rows.
+  {
+    shared_ptr<KuduSession> session = client_->NewSession();
+    unique_ptr<KuduUpdate> update(client_table_->NewUpdate());
+    ASSERT_OK(update->mutable_row()->SetInt32(0, 7));
+    ASSERT_OK(update->mutable_row()->SetNull(2));
+    ASSERT_OK(session->Apply(update.release()));
+  }
+
+  // Look up keys of both tablets, out of order, along with missing keys.
+  const vector<int> key_vals = { 50, kNumRows + 1, 3, 7, -1, 99 };
+  vector<unique_ptr<KuduPartialRow>> key_rows;
+  vector<const KuduPartialRow*> keys;
+  for (int val : key_vals) {
+    key_rows.emplace_back(client_table_->schema().NewRow());
+    ASSERT_OK(key_rows.back()->SetInt32(0, val));
+    keys.push_back(key_rows.back().get());
+  }
+  vector<KuduPartialRow*> rows;
+  ASSERT_OK(client_table_->MultiGet(keys, { "string_val", "int_val" }, &rows));
+  ElementDeleter deleter(&rows);
+  ASSERT_EQ(key_vals.size(), rows.size());
+  for (int i = 0; i < key_vals.size(); i++) {
+    SCOPED_TRACE(key_vals[i]);
+    if (key_vals[i] < 0 || key_vals[i] >= kNumRows) {
+      ASSERT_EQ(nullptr, rows[i]);
+      continue;
+    }
+    ASSERT_NE(nullptr, rows[i]);
+    int32_t int_val;
+    ASSERT_OK(rows[i]->GetInt32("int_val", &int_val));
+    ASSERT_EQ(key_vals[i] * 2, int_val);
+    if (key_vals[i] == 7) {
+      ASSERT_TRUE(rows[i]->IsNull("string_val"));
+    } else {
+      Slice string_val;
+      ASSERT_OK(rows[i]->GetString("string_val", &string_val));
+      ASSERT_EQ(StringPrintf("hello %d", key_vals[i]), string_val.ToString());
+    }
+    // Columns outside of the projection aren't set.
+    ASSERT_FALSE(rows[i]->IsColumnSet("key"));
+    ASSERT_FALSE(rows[i]->IsColumnSet("non_null_with_default"));
+  }
+
+  // Keys must have all the primary key columns set.
+  unique_ptr<KuduPartialRow> empty_key(client_table_->schema().NewRow());
+  vector<KuduPartialRow*> no_rows;
+  Status s = client_table_->MultiGet({ empty_key.get() }, { "int_val" }, &no_rows);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_TRUE(no_rows.empty());
+}
+
 TEST_F(ClientTest, TestGetTabletServerBlacklist) {
   shared_ptr<KuduTable> table;
   NO_FATALS(CreateTable("blacklist",
@@ -2136,11 +2277,12 @@ TEST_F(ClientTest, TestGetTabletServerBlacklist) {
   tservers.push_back(rts);
   blacklist.insert(rts->permanent_uuid());
 
-  // Make sure none of the three modes work when all nodes are blacklisted.
+  // Make sure none of the modes work when all nodes are blacklisted.
   vector<KuduClient::ReplicaSelection> selections;
   selections.push_back(KuduClient::LEADER_ONLY);
   selections.push_back(KuduClient::CLOSEST_REPLICA);
   selections.push_back(KuduClient::FIRST_REPLICA);
+  selections.push_back(KuduClient::LOWEST_LATENCY);
   for (KuduClient::ReplicaSelection selection : selections) {
     Status s = client_->data_->GetTabletServer(client_.get(), rt, selection,
                                                blacklist, &candidates, &rts);
@@ -2160,6 +2302,65 @@ TEST_F(ClientTest, TestGetTabletServerBlacklist) {
   }
 }
 
+// Test that once a client knows how long opening a scan usually takes, slower
+// snapshot scans are hedged on another replica, and return the right rows.
+TEST_F(ClientTest, TestHedgedScans) {
+  constexpr int kNumRows = 100;
+  shared_ptr<KuduTable> table;
+  NO_FATALS(CreateTable("hedged_scans", 3, {}, {}, &table));
+  NO_FATALS(InsertTestRows(table.get(), kNumRows));
+
+  const auto count_rows = [&](int* num_rows) {
+    KuduScanner scanner(table.get());
+    RETURN_NOT_OK(scanner.SetReadMode(KuduScanner::READ_AT_SNAPSHOT));
+    RETURN_NOT_OK(scanner.SetSelection(KuduClient::CLOSEST_REPLICA));
+    RETURN_NOT_OK(scanner.SetHedgingPercentile(50));
+    RETURN_NOT_OK(scanner.Open());
+    *num_rows = 0;
+    KuduScanBatch batch;
+    while (scanner.HasMoreRows()) {
+      RETURN_NOT_OK(scanner.NextBatch(&batch));
+      *num_rows += batch.NumRows();
+    }
+    return Status::OK();
+  };
+  const auto count_scan_rpcs = [&]() {
+    int64_t count = 0;
+    for (int i = 0; i < cluster_->num_tablet_servers(); i++) {
+      count += METRIC_handler_latency_kudu_tserver_TabletServerService_Scan.Instantiate(
+          cluster_->mini_tablet_server(i)->server()->metric_entity())->TotalCount();
+    }
+    return count;
+  };
+
+  // Let the client learn how long opening a scan takes.
+  int num_rows;
+  for (int i = 0; i < 30; i++) {
+    ASSERT_OK(count_rows(&num_rows));
+    ASSERT_EQ(kNumRows, num_rows);
+  }
+
+  // Once the scans slow down, each one is sent to two replicas.
+  google::FlagSaver saver;
+  FLAGS_scanner_inject_latency_on_each_batch_ms = 100;
+  constexpr int kNumSlowScans = 5;
+  const int64_t scan_rpcs_before = count_scan_rpcs();
+  for (int i = 0; i < kNumSlowScans; i++) {
+    ASSERT_OK(count_rows(&num_rows));
+    ASSERT_EQ(kNumRows, num_rows);
+  }
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(2 * kNumSlowScans, count_scan_rpcs() - scan_rpcs_before);
+  });
+
+  // Invalid percentiles are rejected.
+  KuduScanner scanner(table.get());
+  Status s = scanner.SetHedgingPercentile(100);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  s = scanner.SetHedgingPercentile(-1);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+}
+
 TEST_F(ClientTest, TestScanWithEncodedRangePredicate) {
   shared_ptr<KuduTable> table;
   NO_FATALS(CreateTable("split-table",
@@ -2484,6 +2685,69 @@ TEST_F(ClientTest, TestInsertSingleRowManualBatch) {
   FlushSessionOrDie(session);
 }
 
+TEST_F(ClientTest, TestApplyColumnar) {
+  const int kNumRows = 10;
+  vector<int32_t> keys;
+  vector<int32_t> int_vals;
+  vector<uint32_t> offsets = { 0 };
+  string strings;
+  uint8_t non_null[2] = { 0, 0 };
+  for (int i = 0; i < kNumRows; i++) {
+    keys.push_back(i);
+    int_vals.push_back(i * 2);
+    // Every third string is null.
+    if (i % 3 != 0) {
+      BitmapSet(non_null, i);
+      strings += Substitute("row $0", i);
+    }
+    offsets.push_back(strings.size());
+  }
+  Slice key_data(reinterpret_cast<const uint8_t*>(keys.data()), kNumRows * sizeof(int32_t));
+  Slice int_data(reinterpret_cast<const uint8_t*>(int_vals.data()), kNumRows * sizeof(int32_t));
+  Slice offset_data(reinterpret_cast<const uint8_t*>(offsets.data()),
+                    offsets.size() * sizeof(uint32_t));
+  Slice non_null_data(non_null, sizeof(non_null));
+
+  KuduColumnarWriteBatch batch(client_table_, KuduWriteOperation::INSERT, kNumRows);
+  ASSERT_EQ(kNumRows, batch.NumRows());
+
+  // Mismatched column kinds, sizes and nullability are rejected up front.
+  ASSERT_TRUE(batch.SetFixedLengthColumn(2, key_data).IsInvalidArgument());
+  ASSERT_TRUE(batch.SetVariableLengthColumn(0, offset_data, strings).IsInvalidArgument());
+  ASSERT_TRUE(batch.SetFixedLengthColumn(0, Slice(key_data.data(), 4)).IsInvalidArgument());
+  ASSERT_TRUE(batch.SetFixedLengthColumn(0, key_data, non_null_data).IsInvalidArgument());
+  ASSERT_TRUE(batch.SetFixedLengthColumn(4, key_data).IsInvalidArgument());
+
+  ASSERT_OK(batch.SetFixedLengthColumn(0, key_data));
+  ASSERT_OK(batch.SetFixedLengthColumn(1, int_data));
+  ASSERT_OK(batch.SetVariableLengthColumn(2, offset_data, strings, non_null_data));
+
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  ASSERT_OK(session->ApplyColumnar(batch));
+  ASSERT_EQ(kNumRows, session->CountBufferedOperations());
+  FlushSessionOrDie(session);
+
+  vector<string> rows;
+  ASSERT_OK(ScanTableToStrings(client_table_.get(), &rows, ScannedRowsOrder::kSorted));
+  ASSERT_EQ(kNumRows, rows.size());
+  ASSERT_EQ("(int32 key=0, int32 int_val=0, string string_val=NULL, "
+            "int32 non_null_with_default=12345)", rows[0]);
+  ASSERT_EQ(R"((int32 key=4, int32 int_val=8, string string_val="row 4", )"
+            "int32 non_null_with_default=12345)", rows[4]);
+
+  // Applying the same batch as updates leaves the rows unchanged, while
+  // inserting it again fails on the duplicate keys.
+  KuduColumnarWriteBatch updates(client_table_, KuduWriteOperation::UPDATE, kNumRows);
+  ASSERT_OK(updates.SetFixedLengthColumn(0, key_data));
+  ASSERT_OK(updates.SetFixedLengthColumn(1, int_data));
+  ASSERT_OK(session->ApplyColumnar(updates));
+  FlushSessionOrDie(session);
+  ASSERT_OK(session->ApplyColumnar(batch));
+  ASSERT_TRUE(session->Flush().IsIOError());
+  ASSERT_EQ(kNumRows, session->CountPendingErrors());
+}
+
 static void DoTestInsertIgnoreVerifyRows(const shared_ptr<KuduTable>& tbl, int num_rows) {
   vector<string> rows;
   KuduScanner scanner(tbl.get());
@@ -3527,6 +3791,41 @@ TEST_F(ClientTest, TestAutoFlushBackgroundSmallOps) {
   EXPECT_EQ(kRowNum, CountRowsFromClient(client_table_.get()));
 }
 
+// Test that a session with adaptive flushing writes all of its rows without
+// overrunning the mutation buffer.
+TEST_F(ClientTest, TestAutoFlushBackgroundAdaptiveFlush) {
+  const size_t kBufferSizeBytes = 4 * 1024;
+  const size_t kRowNum = kBufferSizeBytes * 10;
+  shared_ptr<KuduSession> session(client_->NewSession());
+  ASSERT_OK(session->SetMutationBufferSpace(kBufferSizeBytes));
+  ASSERT_OK(session->SetMutationBufferAdaptiveFlush(true));
+  ASSERT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+
+  int64_t monitor_max_buffer_size = 0;
+  CountDownLatch monitor_run_ctl(1);
+  thread monitor([&]() {
+    MonitorSessionBufferSize(session.get(),
+                             &monitor_run_ctl, &monitor_max_buffer_size);
+  });
+
+  for (size_t i = 0; i < kRowNum; ++i) {
+    ASSERT_OK(ApplyInsertToSession(session.get(), client_table_, i, i, "x"));
+  }
+  // The setting can't be changed while there are buffered writes.
+  Status s = session->SetMutationBufferAdaptiveFlush(false);
+  if (session->HasPendingOperations()) {
+    ASSERT_TRUE(s.IsIllegalState()) << s.ToString();
+  }
+  EXPECT_OK(session->Flush());
+  EXPECT_EQ(0, session->CountPendingErrors());
+  EXPECT_FALSE(session->HasPendingOperations());
+
+  monitor_run_ctl.CountDown();
+  monitor.join();
+  EXPECT_GE(kBufferSizeBytes, monitor_max_buffer_size);
+  EXPECT_EQ(kRowNum, CountRowsFromClient(client_table_.get()));
+}
+
 // A test scenario for AUTO_FLUSH_BACKGROUND mode:
 // applying a bunch of rows every one of which is so big in size that
 // a couple of those do not fit into the buffer. This should be OK:
@@ -6151,6 +6450,106 @@ TEST_F(ClientTest, TestPartitioner) {
   ASSERT_EQ(-1, part_index);
 }
 
+// Test that partitioning a columnar batch agrees with partitioning its rows
+// one at a time.
+TEST_F(ClientTest, TestPartitionRowsColumnar) {
+  const char* kTableName = "TestPartitionRowsColumnar";
+  unique_ptr<KuduTableCreator> table_creator(client_->NewTableCreator());
+  unique_ptr<KuduPartialRow> split(schema_.NewRow());
+  ASSERT_OK(split->SetInt32("key", 5000));
+  ASSERT_OK(table_creator->table_name(kTableName)
+            .schema(&schema_)
+            .num_replicas(1)
+            .add_hash_partitions({ "key" }, 3, /*seed=*/ 7)
+            .set_range_partition_columns({ "key" })
+            .add_range_partition_split(split.release())
+            .Create());
+  shared_ptr<KuduTable> table;
+  ASSERT_OK(client_->OpenTable(kTableName, &table));
+
+  unique_ptr<KuduPartitioner> part;
+  {
+    KuduPartitioner* part_raw;
+    ASSERT_OK(KuduPartitionerBuilder(table).Build(&part_raw));
+    part.reset(part_raw);
+  }
+  ASSERT_EQ(6, part->NumPartitions());
+
+  const int kNumRows = 10000;
+  vector<int32_t> keys(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    keys[i] = i;
+  }
+  Slice key_data(reinterpret_cast<const uint8_t*>(keys.data()), kNumRows * sizeof(int32_t));
+  KuduColumnarWriteBatch batch(table, KuduWriteOperation::INSERT, kNumRows);
+
+  // All of the partition key columns must be set.
+  vector<int> partitions;
+  Status s = part->PartitionRows(batch, &partitions);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "partition key column 'key' is not set");
+
+  ASSERT_OK(batch.SetFixedLengthColumn(0, key_data));
+  ASSERT_OK(part->PartitionRows(batch, &partitions));
+  ASSERT_EQ(kNumRows, partitions.size());
+  unique_ptr<KuduPartialRow> row(table->schema().NewRow());
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_OK(row->SetInt32(0, keys[i]));
+    int part_index;
+    ASSERT_OK(part->PartitionRow(*row, &part_index));
+    ASSERT_EQ(part_index, partitions[i]) << "row " << i;
+  }
+
+  // A batch for a different table is rejected.
+  KuduColumnarWriteBatch other(client_table_, KuduWriteOperation::INSERT, kNumRows);
+  ASSERT_OK(other.SetFixedLengthColumn(0, key_data));
+  ASSERT_TRUE(part->PartitionRows(other, &partitions).IsInvalidArgument());
+}
+
+// Test that, with multi-tablet writes enabled, the ops for all of the tablets
+// led by a tablet server are sent to it in a single RPC.
+TEST_F(ClientTest, TestMultiTabletWrites) {
+  FLAGS_client_multi_tablet_writes = true;
+  const char* kTableName = "TestMultiTabletWrites";
+  unique_ptr<KuduTableCreator> table_creator(client_->NewTableCreator());
+  ASSERT_OK(table_creator->table_name(kTableName)
+            .schema(&schema_)
+            .num_replicas(1)
+            .add_hash_partitions({ "key" }, 4)
+            .Create());
+  shared_ptr<KuduTable> table;
+  ASSERT_OK(client_->OpenTable(kTableName, &table));
+
+  const auto& metric_entity = cluster_->mini_tablet_server(0)->server()->metric_entity();
+  const auto& multi_write_rpcs =
+      METRIC_handler_latency_kudu_tserver_TabletServerService_MultiWrite.Instantiate(
+          metric_entity);
+  const auto& write_rpcs =
+      METRIC_handler_latency_kudu_tserver_TabletServerService_Write.Instantiate(metric_entity);
+  const int64_t num_write_rpcs = write_rpcs->TotalCount();
+
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  NO_FATALS(InsertTestRows(table.get(), session.get(), 1000));
+  ASSERT_OK(session->Flush());
+  ASSERT_EQ(1000, CountRowsFromClient(table.get()));
+  ASSERT_EQ(1, multi_write_rpcs->TotalCount());
+  ASSERT_EQ(num_write_rpcs, write_rpcs->TotalCount());
+
+  // Row errors are reported for the offending ops only.
+  NO_FATALS(InsertTestRows(table.get(), session.get(), 2, 999));
+  Status s = session->Flush();
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+  vector<KuduError*> errors;
+  ElementDeleter drop(&errors);
+  bool overflowed;
+  session->GetPendingErrors(&errors, &overflowed);
+  ASSERT_FALSE(overflowed);
+  ASSERT_EQ(1, errors.size());
+  ASSERT_TRUE(errors[0]->status().IsAlreadyPresent()) << errors[0]->status().ToString();
+  ASSERT_EQ(1001, CountRowsFromClient(table.get()));
+}
+
 TEST_F(ClientTest, TestInvalidPartitionerBuilder) {
   KuduPartitioner* part;
   Status s = KuduPartitionerBuilder(client_table_)
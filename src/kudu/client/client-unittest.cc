@@ -30,12 +30,15 @@
 
 #include "kudu/client/client-internal.h"
 #include "kudu/client/error_collector.h"
+#include "kudu/client/meta_cache.h"
 #include "kudu/client/schema.h"
+#include "kudu/client/session-internal.h"
 #include "kudu/client/value.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/master/master.pb.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
@@ -43,7 +46,9 @@
 using std::string;
 using std::vector;
 using strings::Substitute;
+using kudu::client::internal::AdaptiveFlushController;
 using kudu::client::internal::ErrorCollector;
+using kudu::client::internal::RemoteTabletServer;
 
 namespace kudu {
 namespace client {
@@ -239,6 +244,71 @@ TEST(ClientUnitTest, TestErrorCollector) {
   }
 }
 
+TEST(ClientUnitTest, TestAdaptiveFlushController) {
+  const int64_t kWatermark = 1600;
+  const MonoDelta kInterval = MonoDelta::FromSeconds(1);
+  AdaptiveFlushController controller;
+  ASSERT_EQ(kWatermark, controller.Watermark(kWatermark));
+  ASSERT_EQ(kInterval, controller.FlushInterval(kInterval));
+
+  // The time-based flushing follows the flush latency.
+  controller.BatchFlushed(kWatermark, kWatermark, MonoDelta::FromMilliseconds(10));
+  ASSERT_EQ(kWatermark, controller.Watermark(kWatermark));
+  ASSERT_EQ(MonoDelta::FromMilliseconds(20), controller.FlushInterval(kInterval));
+
+  // Once the latency goes up without any gain in throughput, the watermark is
+  // cut back, but no further than to a fraction of the configured one.
+  controller.BatchFlushed(kWatermark, kWatermark, MonoDelta::FromMilliseconds(100));
+  ASSERT_EQ(kWatermark / 2, controller.Watermark(kWatermark));
+  for (int i = 0; i < 10; i++) {
+    controller.BatchFlushed(controller.Watermark(kWatermark), controller.Watermark(kWatermark),
+                            MonoDelta::FromMilliseconds(1000));
+  }
+  ASSERT_EQ(kWatermark / 16, controller.Watermark(kWatermark));
+  ASSERT_EQ(kInterval, controller.FlushInterval(kInterval));
+
+  // Batches which don't fill up don't grow the watermark.
+  controller.BatchFlushed(1, kWatermark / 16, MonoDelta::FromMilliseconds(1));
+  ASSERT_EQ(kWatermark / 16, controller.Watermark(kWatermark));
+
+  // Once the tablet servers keep up again, the watermark grows back up to the
+  // configured one.
+  for (int i = 0; i < 20; i++) {
+    controller.BatchFlushed(controller.Watermark(kWatermark), controller.Watermark(kWatermark),
+                            MonoDelta::FromMilliseconds(1));
+  }
+  ASSERT_EQ(kWatermark, controller.Watermark(kWatermark));
+  ASSERT_GT(kInterval, controller.FlushInterval(kInterval));
+}
+
+TEST(ClientUnitTest, TestRemoteTabletServerExpectedRpcCost) {
+  master::TSInfoPB pb;
+  pb.set_permanent_uuid("ts");
+  RemoteTabletServer ts(pb);
+
+  // Servers without latency samples are the cheapest.
+  ASSERT_EQ(0, ts.ExpectedRpcCost());
+  ts.RpcStarted();
+  ts.RpcFinished(MonoDelta::FromMilliseconds(10), /*success=*/false);
+  ASSERT_EQ(0, ts.ExpectedRpcCost());
+
+  ts.RpcStarted();
+  ts.RpcFinished(MonoDelta::FromMilliseconds(10), /*success=*/true);
+  const double cost = ts.ExpectedRpcCost();
+  ASSERT_GT(cost, 0);
+  ASSERT_LE(cost, 10000);
+
+  // Outstanding RPCs make the server more expensive.
+  ts.RpcStarted();
+  ASSERT_GT(ts.ExpectedRpcCost(), cost);
+  ts.RpcFinished(MonoDelta::FromMilliseconds(100), /*success=*/true);
+
+  // A slower RPC moves the average up, but only part of the way.
+  const double slower_cost = ts.ExpectedRpcCost();
+  ASSERT_GT(slower_cost, cost);
+  ASSERT_LT(slower_cost, 100000);
+}
+
 TEST(ClientUnitTest, TestKuduSchemaToString) {
   // Test on unique PK.
   KuduSchema s1;
@@ -41,6 +41,8 @@
 #include "kudu/client/error_collector.h"
 #include "kudu/client/master_proxy_rpc.h"
 #include "kudu/client/meta_cache.h"
+#include "kudu/client/multi_get-internal.h"
+#include "kudu/client/parallel_scanner-internal.h"
 #include "kudu/client/partitioner-internal.h"
 #include "kudu/client/replica-internal.h"
 #include "kudu/client/row_result.h"
@@ -49,6 +51,7 @@
 #include "kudu/client/scan_predicate-internal.h"
 #include "kudu/client/scan_token-internal.h"
 #include "kudu/client/scanner-internal.h"
+#include "kudu/client/schema-internal.h"
 #include "kudu/client/session-internal.h"
 #include "kudu/client/table-internal.h"
 #include "kudu/client/table_alterer-internal.h"
@@ -58,6 +61,7 @@
 #include "kudu/client/tablet_server-internal.h"
 #include "kudu/client/value.h"
 #include "kudu/client/write_op.h"
+#include "kudu/client/write_op-internal.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/partial_row.h"
 #include "kudu/common/partition.h"
@@ -163,6 +167,7 @@ class ResourceMetrics;
 
 using internal::AsyncLeaderMasterRpc;
 using internal::MetaCache;
+using internal::MultiGetter;
 using sp::shared_ptr;
 
 const char* kVerboseEnvVar = "KUDU_CLIENT_VERBOSE";
@@ -1071,6 +1076,22 @@ KuduPredicate* KuduTable::NewIsNullPredicate(const Slice& col_name) {
   });
 }
 
+Status KuduTable::PrefetchTabletLocations() {
+  auto& client = data_->client_;
+  const auto deadline = MonoTime::Now() + client->default_admin_operation_timeout();
+  return client->data_->meta_cache_->PrefetchTableLocations(this, deadline);
+}
+
+Status KuduTable::MultiGet(const vector<const KuduPartialRow*>& keys,
+                           const vector<string>& projected_column_names,
+                           vector<KuduPartialRow*>* rows) {
+  DCHECK(rows);
+  rows->clear();
+  const auto deadline = MonoTime::Now() + data_->client_->default_rpc_timeout();
+  MultiGetter getter(this, deadline);
+  return getter.Run(keys, projected_column_names, rows);
+}
+
 // The strategy for retrieving the partitions from the metacache is adapted
 // from KuduScanTokenBuilder::Data::Build.
 Status KuduTable::ListPartitions(vector<Partition>* partitions) {
@@ -1186,6 +1207,10 @@ Status KuduSession::SetMutationBufferMaxNum(unsigned int max_num) {
   return data_->SetMaxBatchersNum(max_num);
 }
 
+Status KuduSession::SetMutationBufferAdaptiveFlush(bool enable) {
+  return data_->SetAdaptiveFlush(enable);
+}
+
 void KuduSession::SetTimeoutMillis(int timeout_ms) {
   data_->SetTimeoutMillis(timeout_ms);
 }
@@ -1213,6 +1238,16 @@ Status KuduSession::Apply(KuduWriteOperation* write_op) {
   return Status::OK();
 }
 
+Status KuduSession::ApplyColumnar(const KuduColumnarWriteBatch& batch) {
+  const int num_rows = batch.NumRows();
+  for (int i = 0; i < num_rows; i++) {
+    KuduWriteOperation* op;
+    RETURN_NOT_OK(batch.NewOperation(i, &op));
+    RETURN_NOT_OK(Apply(op));
+  }
+  return Status::OK();
+}
+
 int KuduSession::CountBufferedOperations() const {
   return data_->CountBufferedOperations();
 }
@@ -1566,6 +1601,7 @@ Status KuduScanner::SetRowFormatFlags(uint64_t flags) {
     case NO_FLAGS:
     case PAD_UNIXTIME_MICROS_TO_16_BYTES:
     case COLUMNAR_LAYOUT:
+    case COLUMNAR_LAYOUT | ARROW_LAYOUT:
       break;
     default:
       return Status::InvalidArgument(Substitute("Invalid row format flags: $0", flags));
@@ -1577,6 +1613,23 @@ Status KuduScanner::SetRowFormatFlags(uint64_t flags) {
   return data_->mutable_configuration()->SetRowFormatFlags(flags);
 }
 
+Status KuduScanner::SetColumnarCompression(
+    KuduColumnStorageAttributes::CompressionType compression) {
+  if (data_->open_) {
+    return Status::IllegalState("Columnar compression must be set before Open()");
+  }
+  if (compression != KuduColumnStorageAttributes::NO_COMPRESSION &&
+      !(data_->configuration().row_format_flags() & COLUMNAR_LAYOUT)) {
+    return Status::InvalidArgument("Compression requires the COLUMNAR_LAYOUT row format");
+  }
+  if (compression == KuduColumnStorageAttributes::DEFAULT_COMPRESSION) {
+    compression = KuduColumnStorageAttributes::LZ4;
+  }
+  data_->mutable_configuration()->SetColumnarCompression(
+      ToInternalCompressionType(compression));
+  return Status::OK();
+}
+
 Status KuduScanner::SetLimit(int64_t limit) {
   if (data_->open_) {
     return Status::IllegalState("Limit must be set before Open()");
@@ -1584,6 +1637,21 @@ Status KuduScanner::SetLimit(int64_t limit) {
   return data_->mutable_configuration()->SetLimit(limit);
 }
 
+Status KuduScanner::SetPrefetching(bool prefetching) {
+  if (data_->open_) {
+    return Status::IllegalState("Prefetching must be set before Open()");
+  }
+  data_->mutable_configuration()->SetPrefetching(prefetching);
+  return Status::OK();
+}
+
+Status KuduScanner::SetHedgingPercentile(double percentile) {
+  if (data_->open_) {
+    return Status::IllegalState("Hedging percentile must be set before Open()");
+  }
+  return data_->mutable_configuration()->SetHedgingPercentile(percentile);
+}
+
 const ResourceMetrics& KuduScanner::GetResourceMetrics() const {
   return data_->resource_metrics_;
 }
@@ -1667,6 +1735,12 @@ void KuduScanner::Close() {
 
   VLOG(2) << "Ending " << data_->DebugString();
 
+  // The prefetched batch is dropped, but the RPC must finish before the
+  // request is reused and before the scanner goes away.
+  if (data_->prefetch_in_flight_) {
+    data_->FinishPrefetch();
+  }
+
   // Close the scanner on the server-side, if necessary.
   //
   // If the scan did not match any rows, the tserver will not assign a scanner ID.
@@ -1693,6 +1767,7 @@ bool KuduScanner::HasMoreRows() const {
   CHECK(data_->open_);
   return !data_->short_circuit_ &&                 // The scan is not short circuited
       (data_->data_in_open_ ||                     // more data in hand
+       data_->prefetch_in_flight_ ||                // a batch is on its way
        data_->last_response_.has_more_results() || // more data in this tablet
        data_->MoreTablets());                      // more tablets to scan, possibly with more data
 }
@@ -1718,10 +1793,6 @@ Status KuduScanner::NextBatch(KuduColumnarScanBatch* batch) {
 
 Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
 
-  // TODO: do some double-buffering here -- when we return this batch
-  // we should already have fired off the RPC for the next batch, but
-  // need to do some swapping of the response objects around to avoid
-  // stomping on the memory the user is looking at.
   CHECK(data_->open_);
   CHECK(data_->proxy_);
 
@@ -1735,23 +1806,38 @@ Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
     // We have data from a previous scan.
     VLOG(2) << "Extracting data from " << data_->DebugString();
     data_->data_in_open_ = false;
-    return batch_data->Reset(&data_->controller_,
-                             data_->configuration().projection(),
-                             data_->configuration().client_projection(),
-                             data_->configuration().row_format_flags(),
-                             &data_->last_response_);
+    // Once the batch owns the response, the next one may be fetched into
+    // the scanner's controller and response.
+    RETURN_NOT_OK(batch_data->Reset(&data_->controller_,
+                                    data_->configuration().projection(),
+                                    data_->configuration().client_projection(),
+                                    data_->configuration().row_format_flags(),
+                                    &data_->last_response_));
+    data_->StartPrefetch();
+    return Status::OK();
   }
 
-  if (data_->last_response_.has_more_results()) {
+  // A prefetch is only in flight if the tablet had more results, and its
+  // response mustn't be looked at before it has arrived.
+  if (data_->prefetch_in_flight_ || data_->last_response_.has_more_results()) {
     // More data is available in this tablet.
     VLOG(2) << "Continuing " << data_->DebugString();
 
     MonoTime batch_deadline = MonoTime::Now() + data_->configuration().timeout();
-    data_->PrepareRequest(KuduScanner::Data::CONTINUE);
+    bool prefetched = data_->prefetch_in_flight_;
+    if (!prefetched) {
+      data_->PrepareRequest(KuduScanner::Data::CONTINUE);
+    }
 
     while (true) {
       bool allow_time_for_failover = data_->configuration().is_fault_tolerant();
-      ScanRpcStatus result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
+      ScanRpcStatus result;
+      if (prefetched) {
+        result = data_->FinishPrefetch();
+        prefetched = false;
+      } else {
+        result = data_->SendScanRpc(batch_deadline, allow_time_for_failover);
+      }
 
       // Success case.
       if (result.result == ScanRpcStatus::OK) {
@@ -1759,11 +1845,13 @@ Status KuduScanner::NextBatch(internal::ScanBatchDataInterface* batch_data) {
           data_->last_primary_key_ = data_->last_response_.last_primary_key();
         }
         data_->scan_attempts_ = 0;
-        return batch_data->Reset(&data_->controller_,
-                                 data_->configuration().projection(),
-                                 data_->configuration().client_projection(),
-                                 data_->configuration().row_format_flags(),
-                                 &data_->last_response_);
+        RETURN_NOT_OK(batch_data->Reset(&data_->controller_,
+                                        data_->configuration().projection(),
+                                        data_->configuration().client_projection(),
+                                        data_->configuration().row_format_flags(),
+                                        &data_->last_response_));
+        data_->StartPrefetch();
+        return Status::OK();
       }
 
       data_->scan_attempts_++;
@@ -2009,6 +2097,76 @@ const string& KuduTabletServer::location() const {
   return data_->location_;
 }
 
+////////////////////////////////////////////////////////////
+// KuduParallelScanner
+////////////////////////////////////////////////////////////
+KuduParallelScanner::KuduParallelScanner(KuduScanTokenBuilder* builder)
+    : data_(new Data(builder)) {
+}
+
+KuduParallelScanner::~KuduParallelScanner() {
+  Close();
+  delete data_;
+}
+
+Status KuduParallelScanner::SetConcurrency(int concurrency) {
+  if (data_->open_) {
+    return Status::IllegalState("Concurrency must be set before Open()");
+  }
+  if (concurrency <= 0) {
+    return Status::InvalidArgument("Concurrency must be positive");
+  }
+  data_->concurrency_ = concurrency;
+  return Status::OK();
+}
+
+Status KuduParallelScanner::SetMaxBufferedBatches(int max_batches) {
+  if (data_->open_) {
+    return Status::IllegalState("Maximum buffered batches must be set before Open()");
+  }
+  if (max_batches <= 0) {
+    return Status::InvalidArgument("Maximum buffered batches must be positive");
+  }
+  data_->max_buffered_batches_ = max_batches;
+  return Status::OK();
+}
+
+Status KuduParallelScanner::SetOrderedByTablet(bool ordered) {
+  if (data_->open_) {
+    return Status::IllegalState("Tablet ordering must be set before Open()");
+  }
+  data_->ordered_ = ordered;
+  return Status::OK();
+}
+
+Status KuduParallelScanner::Open() {
+  if (data_->open_) {
+    return Status::IllegalState("Scanner already open");
+  }
+  return data_->Open();
+}
+
+bool KuduParallelScanner::HasMoreBatches() {
+  CHECK(data_->open_);
+  return data_->HasMoreBatches();
+}
+
+Status KuduParallelScanner::NextBatch(KuduColumnarScanBatch* batch) {
+  CHECK(data_->open_);
+  unique_ptr<KuduColumnarScanBatch> next;
+  RETURN_NOT_OK(data_->NextBatch(&next));
+  if (next) {
+    std::swap(batch->data_, next->data_);
+  } else {
+    batch->data_->Clear();
+  }
+  return Status::OK();
+}
+
+void KuduParallelScanner::Close() {
+  data_->Close();
+}
+
 ////////////////////////////////////////////////////////////
 // KuduPartitionerBuilder
 ////////////////////////////////////////////////////////////
@@ -2048,5 +2206,10 @@ Status KuduPartitioner::PartitionRow(const KuduPartialRow& row, int* partition)
   return data_->PartitionRow(row, partition);
 }
 
+Status KuduPartitioner::PartitionRows(const KuduColumnarWriteBatch& batch,
+                                      vector<int>* partitions) {
+  return data_->PartitionRows(*batch.data_, partitions);
+}
+
 } // namespace client
 } // namespace kudu
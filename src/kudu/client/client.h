@@ -74,6 +74,7 @@ class RemoteKsckCluster;
 namespace client {
 
 class KuduColumnarScanBatch;
+class KuduColumnarWriteBatch;
 class KuduDelete;
 class KuduInsert;
 class KuduInsertIgnore;
@@ -99,6 +100,7 @@ class ErrorCollector;
 class GetTableSchemaRpc;
 class LookupRpc;
 class MetaCache;
+class MultiGetter;
 class RemoteTablet;
 class RemoteTabletServer;
 class ReplicaController;
@@ -497,7 +499,14 @@ class KUDU_EXPORT KuduClient : public sp::enable_shared_from_this<KuduClient> {
                       ///< client, followed by all other replicas. If there are
                       ///< multiple closest replicas, one is chosen randomly.
 
-    FIRST_REPLICA     ///< Select the first replica in the list.
+    FIRST_REPLICA,    ///< Select the first replica in the list.
+
+    LOWEST_LATENCY    ///< Select the replica expected to respond the fastest.
+                      ///< The expectation is based on the latency this
+                      ///< client measured in its recent RPCs to each replica
+                      ///< and the number of its RPCs currently outstanding
+                      ///< on each replica. Replicas without latency
+                      ///< measurements yet are tried first.
   };
 
   /// @return @c true iff client is configured to talk to multiple
@@ -612,6 +621,7 @@ class KUDU_EXPORT KuduClient : public sp::enable_shared_from_this<KuduClient> {
   friend class internal::GetTableSchemaRpc;
   friend class internal::LookupRpc;
   friend class internal::MetaCache;
+  friend class internal::MultiGetter;
   friend class internal::RemoteTablet;
   friend class internal::RemoteTabletServer;
   friend class internal::RetrieveAuthzTokenRpc;
@@ -1219,6 +1229,43 @@ class KUDU_EXPORT KuduTable : public sp::enable_shared_from_this<KuduTable> {
   /// @return The table's extra configuration properties.
   const std::map<std::string, std::string>& extra_configs() const;
 
+  /// Fetch the locations of all of the table's tablets into the client's
+  /// metadata cache.
+  ///
+  /// Otherwise, the locations are fetched lazily, a few tablets at a time,
+  /// as operations on the table need them. For tables with many tablets,
+  /// prefetching the locations saves the first writes from waiting on many
+  /// separate lookups. The locations are fetched in pages, each page in one
+  /// round trip to the leader master. This operation has a timeout equal to
+  /// the table's client instance's default admin operation timeout.
+  ///
+  /// @return Status object for the operation.
+  Status PrefetchTabletLocations();
+
+  /// Look up rows of the table by their primary keys.
+  ///
+  /// The keys of each tablet are sent to one of its replicas in a single
+  /// round trip, and the different tablets are looked up in parallel, so
+  /// this is much cheaper than opening a scanner per key. The rows are read
+  /// as of the latest state of the replicas, as with the READ_LATEST read
+  /// mode. This operation has a timeout equal to the table's client
+  /// instance's default RPC timeout.
+  ///
+  /// @param [in] keys
+  ///   The rows with the primary keys to look up. All the primary key
+  ///   columns must be set. The other columns are ignored.
+  /// @param [in] projected_column_names
+  ///   The names of the columns to fetch.
+  /// @param [out] rows
+  ///   One entry per key, in the order of @c keys: the found row, with only
+  ///   the projected columns set, or @c NULL if the table has no row with
+  ///   the key. The caller takes ownership of the rows, which must not
+  ///   outlive the table. On error, the vector is left empty.
+  /// @return Status object for the operation.
+  Status MultiGet(const std::vector<const KuduPartialRow*>& keys,
+                  const std::vector<std::string>& projected_column_names,
+                  std::vector<KuduPartialRow*>* rows) WARN_UNUSED_RESULT;
+
   /// @cond PRIVATE_API
 
   /// List the partitions of this table in 'partitions'. This operation may
@@ -1802,6 +1849,27 @@ class KUDU_EXPORT KuduSession : public sp::enable_shared_from_this<KuduSession>
   /// @return Operation result status.
   Status SetMutationBufferMaxNum(unsigned int max_num) WARN_UNUSED_RESULT;
 
+  /// Enable or disable adaptive flushing of the mutation buffer.
+  ///
+  /// With adaptive flushing, the session tunes the flush watermark and the
+  /// interval of the time-based flushing from the observed latency of the
+  /// flushed operations. It grows the batches as long as doing so increases
+  /// the write throughput, and shrinks them once the tablet servers start
+  /// queueing or throttling the writes. The settings made with
+  /// SetMutationBufferFlushWatermark() and SetMutationBufferFlushInterval()
+  /// act as the upper bounds for the tuned values. Adaptive flushing is
+  /// disabled by default.
+  ///
+  /// @note This setting is applicable only for AUTO_FLUSH_BACKGROUND sessions.
+  ///   I.e., calling this method in other flush modes is safe, but
+  ///   the parameter has no effect until the session is switched into
+  ///   AUTO_FLUSH_BACKGROUND mode.
+  ///
+  /// @param [in] enable
+  ///   Whether to enable adaptive flushing.
+  /// @return Operation result status.
+  Status SetMutationBufferAdaptiveFlush(bool enable) WARN_UNUSED_RESULT;
+
   /// Set the timeout for writes made in this session.
   ///
   /// @param [in] millis
@@ -1838,6 +1906,24 @@ class KUDU_EXPORT KuduSession : public sp::enable_shared_from_this<KuduSession>
   /// @return Operation result status.
   Status Apply(KuduWriteOperation* write_op) WARN_UNUSED_RESULT;
 
+  /// Apply a write operation for every row of a columnar batch.
+  ///
+  /// This behaves as if a write operation had been built for each row of
+  /// the batch and passed to Apply() in turn, but avoids setting the cells
+  /// one by one through the KuduPartialRow API: the column types and sizes
+  /// are validated once per column and the cells are copied directly into
+  /// the operations.
+  ///
+  /// If applying one of the rows fails, the remaining rows are not applied
+  /// and the error is returned. As with Apply(), the failed operation is
+  /// stored in the session's error collector.
+  ///
+  /// @param [in] batch
+  ///   The rows to apply. The batch is not modified and may be destroyed
+  ///   once this method returns.
+  /// @return Operation result status.
+  Status ApplyColumnar(const KuduColumnarWriteBatch& batch) WARN_UNUSED_RESULT;
+
   /// Flush any pending writes.
   ///
   /// This method initiates flushing of the current batch of buffered
@@ -2416,6 +2502,16 @@ class KUDU_EXPORT KuduScanner {
   /// code path.
   static const uint64_t COLUMNAR_LAYOUT = 1 << 1;
 
+  /// Together with COLUMNAR_LAYOUT, makes the server lay out the columns the
+  /// way Arrow arrays are laid out, so that the buffers returned by
+  /// KuduColumnarScanBatch can be wrapped as Arrow arrays without copying
+  /// them. The cells of BOOL columns are then returned by
+  /// KuduColumnarScanBatch::GetFixedLengthColumn() as a bitmap with a set bit
+  /// for each true cell, rather than as a byte per cell.
+  ///
+  /// NOTE: older versions of the Kudu server do not support this feature.
+  static const uint64_t ARROW_LAYOUT = 1 << 2;
+
   /// Optionally set row format modifier flags.
   ///
   /// If flags is RowFormatFlags::NO_FLAGS, then no modifications will be made to the row
@@ -2444,6 +2540,22 @@ class KUDU_EXPORT KuduScanner {
   ///   Row format modifier flags to set.
   /// @return Operation result status.
   Status SetRowFormatFlags(uint64_t flags);
+
+  /// Ask the server to compress the results of a columnar scan. This trades
+  /// CPU time on the server and the client for less network traffic, so it
+  /// mostly helps when the client is far from the tablet servers. The server
+  /// still sends any buffer that the codec can't shrink uncompressed.
+  ///
+  /// Must be called after enabling the COLUMNAR_LAYOUT row format flag.
+  ///
+  /// NOTE: older versions of the Kudu server do not support this feature.
+  /// Open() and NextBatch() return a NotSupported status against them.
+  ///
+  /// @param [in] compression
+  ///   The codec to compress results with. DEFAULT_COMPRESSION selects LZ4,
+  ///   and NO_COMPRESSION turns compression off.
+  /// @return Operation result status.
+  Status SetColumnarCompression(KuduColumnStorageAttributes::CompressionType compression);
   ///@}
 
   /// Set the maximum number of rows the scanner should return.
@@ -2453,6 +2565,40 @@ class KUDU_EXPORT KuduScanner {
   /// @return Operation result status.
   Status SetLimit(int64_t limit) WARN_UNUSED_RESULT;
 
+  /// Fetch the next batch of a tablet while the caller processes the current one.
+  ///
+  /// When enabled, NextBatch() sends the request for the following batch
+  /// before returning the current one, so the network round trip overlaps
+  /// with the caller's processing instead of following it. The tablet server
+  /// hands out the batches of a scan strictly in order, so at most one such
+  /// request is outstanding at a time. Batches returned earlier remain valid.
+  /// Close() waits for an outstanding request to complete. Default is
+  /// @c false.
+  ///
+  /// @param [in] prefetching
+  ///   Whether to fetch the next batch ahead of time.
+  /// @return Operation result status.
+  Status SetPrefetching(bool prefetching) WARN_UNUSED_RESULT;
+
+  /// Hedge the requests which open the scan of each tablet.
+  ///
+  /// When enabled for a @c READ_AT_SNAPSHOT scan whose replica selection
+  /// isn't @c LEADER_ONLY, if the replica chosen to scan a tablet doesn't
+  /// respond within the given percentile of the latencies this client has
+  /// observed opening tablet scans, the same request is also sent to another
+  /// replica of the tablet. The scan then goes on with whichever replica
+  /// answers successfully first, and the other request is cancelled. This
+  /// keeps a single slow tablet server from stalling point lookups and small
+  /// scans, at the cost of extra requests to the cluster. Hedging only kicks
+  /// in once the client has observed enough scans to estimate the
+  /// percentile. Default is @c 0, i.e. no hedging.
+  ///
+  /// @param [in] percentile
+  ///   The percentile of the observed latencies after which to send the
+  ///   hedged request, in the range (0, 100), or @c 0 to disable hedging.
+  /// @return Operation result status.
+  Status SetHedgingPercentile(double percentile) WARN_UNUSED_RESULT;
+
   /// @return String representation of this scan.
   ///
   /// @internal
@@ -2667,6 +2813,101 @@ class KUDU_EXPORT KuduScanTokenBuilder {
   DISALLOW_COPY_AND_ASSIGN(KuduScanTokenBuilder);
 };
 
+/// @brief Scans all the tablets of a set of scan tokens concurrently.
+///
+/// The scanner builds the tokens of a KuduScanTokenBuilder, scans up to
+/// SetConcurrency() of them at a time from background threads, and hands
+/// their results to the caller as columnar batches. At most
+/// SetMaxBufferedBatches() batches are held waiting for the caller, so
+/// together with KuduScanTokenBuilder::SetBatchSizeBytes() this bounds the
+/// memory used for results.
+///
+/// Typical usage:
+/// @code
+///   KuduScanTokenBuilder builder(table);
+///   // ... set projection, predicates, etc. on the builder ...
+///   KuduParallelScanner scanner(&builder);
+///   KUDU_RETURN_NOT_OK(scanner.SetConcurrency(8));
+///   KUDU_RETURN_NOT_OK(scanner.Open());
+///   KuduColumnarScanBatch batch;
+///   while (scanner.HasMoreBatches()) {
+///     KUDU_RETURN_NOT_OK(scanner.NextBatch(&batch));
+///     // ... process the batch ...
+///   }
+/// @endcode
+///
+/// @note This class is not thread-safe: only one thread may call its methods.
+class KUDU_EXPORT KuduParallelScanner {
+ public:
+  /// Construct an instance of the class.
+  ///
+  /// @param [in] builder
+  ///   The builder of the tokens to scan. It must remain valid until Open()
+  ///   returns, and any later changes to it are not picked up.
+  explicit KuduParallelScanner(KuduScanTokenBuilder* builder);
+  ~KuduParallelScanner();
+
+  /// Set the number of tablets scanned at the same time. Default is 4.
+  ///
+  /// @param [in] concurrency
+  ///   The number of scan threads; must be positive.
+  /// @return Operation result status.
+  Status SetConcurrency(int concurrency) WARN_UNUSED_RESULT;
+
+  /// Set the maximum number of batches held for the caller. Scan threads
+  /// wait for the caller to take batches once this many are buffered.
+  /// Default is 16.
+  ///
+  /// @param [in] max_batches
+  ///   The maximum number of buffered batches; must be positive.
+  /// @return Operation result status.
+  Status SetMaxBufferedBatches(int max_batches) WARN_UNUSED_RESULT;
+
+  /// Deliver the batches one tablet at a time, in the order the tokens were
+  /// built. Tablets are still scanned concurrently, but the batches of a
+  /// tablet are only handed out once those of every earlier tablet have
+  /// been. Regardless of this setting, the batches of any one tablet are
+  /// always delivered in the order they were scanned. Default is @c false.
+  ///
+  /// @param [in] ordered
+  ///   Whether to deliver the batches tablet by tablet.
+  /// @return Operation result status.
+  Status SetOrderedByTablet(bool ordered) WARN_UNUSED_RESULT;
+
+  /// Build the scan tokens and start scanning them.
+  ///
+  /// @return Operation result status.
+  Status Open() WARN_UNUSED_RESULT;
+
+  /// Check whether there may be more batches to fetch. This waits until a
+  /// batch is available, a scan has failed, or all the tablets have been
+  /// scanned.
+  ///
+  /// @return @c true if NextBatch() will return a batch or an error.
+  bool HasMoreBatches();
+
+  /// Fetch the next batch of results, waiting for one if necessary.
+  ///
+  /// @param [out] batch
+  ///   Placeholder for the result. Any batch previously fetched into it is
+  ///   released.
+  /// @return Operation result status. If scanning any of the tablets failed,
+  ///   the first such error is returned and the scan stops.
+  Status NextBatch(KuduColumnarScanBatch* batch) WARN_UNUSED_RESULT;
+
+  /// Stop the scan threads, closing the scanners they have open, and
+  /// release any buffered batches. Called by the destructor as well.
+  void Close();
+
+ private:
+  class KUDU_NO_EXPORT Data;
+
+  // Owned.
+  Data* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(KuduParallelScanner);
+};
+
 /// @brief Builder for Partitioner instances.
 class KUDU_EXPORT KuduPartitionerBuilder {
  public:
@@ -2743,6 +2984,23 @@ class KUDU_EXPORT KuduPartitioner {
   ///   provided row does not have all columns of the partition key
   ///   set.
   Status PartitionRow(const KuduPartialRow& row, int* partition);
+
+  /// Determine the partition index of every row of a columnar batch.
+  ///
+  /// This gives the same results as calling @c PartitionRow() for each row,
+  /// but resolves the partition key columns once for the whole batch and
+  /// computes the hash buckets column by column.
+  ///
+  /// @param [in] batch
+  ///   The rows to be partitioned. The batch must be for the same table
+  ///   as this partitioner.
+  /// @param [out] partitions
+  ///   The resulting partition indices, one per row of the batch, with -1
+  ///   for rows which fall into a non-covered range.
+  ///
+  /// @return Status::OK if successful. May return a bad Status if the
+  ///   batch does not have all columns of the partition key set.
+  Status PartitionRows(const KuduColumnarWriteBatch& batch, std::vector<int>* partitions);
  private:
   class KUDU_NO_EXPORT Data;
 
@@ -62,6 +62,10 @@ class KUDU_EXPORT KuduColumnarScanBatch {
   /// Space is reserved for all cells regardless of whether they might be null.
   /// The data stored in a null cell may or may not be zeroed.
   ///
+  /// If the scan was opened with the ARROW_LAYOUT row format flag, the cells of
+  /// a BOOL column are packed into a bitmap with a set bit for each true cell,
+  /// and the bits of null cells are cleared.
+  ///
   /// For variable-length (e.g. STRING, BINARY, VARCHAR) columns, use
   /// GetVariableLengthColumn instead.
   ///
@@ -92,6 +96,7 @@ class KUDU_EXPORT KuduColumnarScanBatch {
  private:
   class KUDU_NO_EXPORT Data;
 
+  friend class KuduParallelScanner;
   friend class KuduScanner;
 
   Data* data_;
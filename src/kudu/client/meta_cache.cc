@@ -17,8 +17,11 @@
 
 #include "kudu/client/meta_cache.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -49,6 +52,7 @@
 #include "kudu/rpc/rpc.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/tserver/tserver_service.proxy.h"
+#include "kudu/util/async_util.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/net/dns_resolver.h"
@@ -84,12 +88,20 @@ DEFINE_bool(client_use_unix_domain_sockets, false,
             "on such a socket and the client is running on the same host.");
 TAG_FLAG(client_use_unix_domain_sockets, experimental);
 
+DEFINE_int32(client_replica_latency_half_life_ms, 10000,
+             "Half-life, in milliseconds, with which a tablet server's measured RPC "
+             "latency decays while no new latency samples are taken for the server. "
+             "This lets the LOWEST_LATENCY replica selection eventually retry servers "
+             "which were slow in the past.");
+TAG_FLAG(client_replica_latency_half_life_ms, advanced);
+
 namespace kudu {
 namespace client {
 namespace internal {
 
 RemoteTabletServer::RemoteTabletServer(const master::TSInfoPB& pb)
-  : uuid_(pb.permanent_uuid()) {
+  : uuid_(pb.permanent_uuid()),
+    outstanding_rpcs_(0) {
   Update(pb);
 }
 
@@ -192,6 +204,45 @@ string RemoteTabletServer::location() const {
   return location_;
 }
 
+void RemoteTabletServer::RpcStarted() {
+  outstanding_rpcs_++;
+}
+
+void RemoteTabletServer::RpcFinished(const MonoDelta& latency, bool success) {
+  // The weight of the newest sample in the moving average.
+  static constexpr double kSampleWeight = 0.2;
+
+  DCHECK_GT(outstanding_rpcs_, 0);
+  outstanding_rpcs_--;
+  if (!success) {
+    return;
+  }
+  const double latency_us = latency.ToMicroseconds();
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (!last_latency_sample_.Initialized()) {
+    ewma_latency_us_ = latency_us;
+  } else {
+    ewma_latency_us_ += kSampleWeight * (latency_us - ewma_latency_us_);
+  }
+  last_latency_sample_ = MonoTime::Now();
+}
+
+double RemoteTabletServer::ExpectedRpcCost() const {
+  double latency_us;
+  MonoTime last_sample;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    latency_us = ewma_latency_us_;
+    last_sample = last_latency_sample_;
+  }
+  if (!last_sample.Initialized()) {
+    return 0;
+  }
+  const double half_lives = (MonoTime::Now() - last_sample).ToMilliseconds() /
+      static_cast<double>(std::max(1, FLAGS_client_replica_latency_half_life_ms));
+  return std::exp2(-half_lives) * latency_us * (1 + outstanding_rpcs_);
+}
+
 shared_ptr<TabletServerServiceProxy> RemoteTabletServer::proxy() const {
   std::lock_guard<simple_spinlock> l(lock_);
   CHECK(proxy_);
@@ -296,6 +347,26 @@ bool RemoteTablet::HasLeader() const {
   return LeaderTServer() != nullptr;
 }
 
+void RemoteTablet::DelayWrites(const MonoDelta& delay) {
+  MonoTime until = MonoTime::Now() + delay;
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (!delay_writes_until_.Initialized() || until > delay_writes_until_) {
+    delay_writes_until_ = until;
+  }
+}
+
+MonoDelta RemoteTablet::WriteDelay() const {
+  MonoTime until;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    until = delay_writes_until_;
+  }
+  if (!until.Initialized()) {
+    return MonoDelta::FromNanoseconds(0);
+  }
+  return until - MonoTime::Now();
+}
+
 void RemoteTablet::GetRemoteTabletServers(vector<RemoteTabletServer*>* servers) const {
   servers->clear();
   std::lock_guard<simple_spinlock> l(lock_);
@@ -393,6 +464,44 @@ string MetaCacheEntry::DebugString(const KuduTable* table) const {
   }
 }
 
+const MetaCacheEntry* MetaCacheEntries::FindFloor(const string& partition_key) const {
+  // The first entry starting after 'partition_key'.
+  const auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), partition_key,
+      [](const string& key, const MetaCacheEntry& e) {
+        return key < e.lower_bound_partition_key();
+      });
+  return it == entries_.begin() ? nullptr : &*std::prev(it);
+}
+
+void MetaCacheEntries::Replace(const string& lower_bound,
+                               const string& upper_bound,
+                               vector<MetaCacheEntry> entries) {
+  DCHECK(upper_bound.empty() || lower_bound < upper_bound);
+  const auto first = entries_.begin() + LowerBound(lower_bound);
+  const auto last = upper_bound.empty() ? entries_.end()
+                                        : entries_.begin() + LowerBound(upper_bound);
+  const auto pos = entries_.erase(first, last);
+  entries_.insert(pos,
+                  std::make_move_iterator(entries.begin()),
+                  std::make_move_iterator(entries.end()));
+}
+
+void MetaCacheEntries::EraseNonCoveredRanges() {
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [](const MetaCacheEntry& e) {
+                                  return e.is_non_covered_range();
+                                }),
+                 entries_.end());
+}
+
+size_t MetaCacheEntries::LowerBound(const string& partition_key) const {
+  return std::lower_bound(entries_.begin(), entries_.end(), partition_key,
+                          [](const MetaCacheEntry& e, const string& key) {
+                            return e.lower_bound_partition_key() < key;
+                          }) - entries_.begin();
+}
+
 MetaCacheServerPicker::MetaCacheServerPicker(KuduClient* client,
                                              scoped_refptr<MetaCache> meta_cache,
                                              const KuduTable* table,
@@ -810,8 +919,8 @@ Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
       MonoDelta::FromMilliseconds(rpc.resp().ttl_millis());
 
   std::lock_guard<percpu_rwlock> l(lock_);
-  TabletMap& tablets_by_key = LookupOrInsert(&tablets_by_table_and_key_,
-                                             rpc.table_id(), TabletMap());
+  MetaCacheEntries& tablets_by_key = LookupOrInsert(&tablets_by_table_and_key_,
+                                                    rpc.table_id(), MetaCacheEntries());
 
   const auto& tablet_locations = rpc.resp().tablet_locations();
 
@@ -823,10 +932,9 @@ Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
     // bound partition key on the request.
     DCHECK(!rpc.req().has_partition_key_end());
 
-    tablets_by_key.clear();
     MetaCacheEntry entry(expiration_time, "", "");
     VLOG(3) << "Caching '" << rpc.table_name() << "' entry " << entry.DebugString(rpc.table());
-    InsertOrDie(&tablets_by_key, "", entry);
+    tablets_by_key.Replace("", "", { std::move(entry) });
   } else {
     // First, update the tserver cache, needed for the Refresh calls below.
     // It's used for backward compatibility.
@@ -856,17 +964,21 @@ Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
     // key falls in A, B, or C, although the existence of A as an initial
     // non-covered range can only be inferred if the lookup partition key falls
     // in A.
+    //
+    // The discovered entries replace any existing entries in the range of
+    // the partition key space which the response covers.
+    vector<MetaCacheEntry> entries;
+    entries.reserve(tablet_locations.size() * 2 + 1);
 
     const auto& first_lower_bound = tablet_locations.Get(0).partition().partition_key_start();
+    string range_lower_bound = first_lower_bound;
     if (rpc.partition_key() < first_lower_bound) {
       // If the first tablet is past the requested partition key, then the
       // partition key falls in an initial non-covered range, such as A.
-
-      // Clear any existing entries which overlap with the discovered non-covered range.
-      tablets_by_key.erase(tablets_by_key.begin(), tablets_by_key.lower_bound(first_lower_bound));
-      MetaCacheEntry entry(expiration_time, "", first_lower_bound);
-      VLOG(3) << "Caching '" << rpc.table_name() << "' entry " << entry.DebugString(rpc.table());
-      InsertOrDie(&tablets_by_key, "", entry);
+      range_lower_bound.clear();
+      entries.emplace_back(expiration_time, "", first_lower_bound);
+      VLOG(3) << "Caching '" << rpc.table_name() << "' entry "
+              << entries.back().DebugString(rpc.table());
     }
 
     // last_upper_bound tracks the upper bound of the previously processed
@@ -879,21 +991,16 @@ Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
       if (last_upper_bound < tablet_lower_bound) {
         // There is a non-covered range between the previous tablet and this tablet.
         // This will discover C while processing the tablet location for D.
-
-        // Clear any existing entries which overlap with the discovered non-covered range.
-        tablets_by_key.erase(tablets_by_key.lower_bound(last_upper_bound),
-                             tablets_by_key.lower_bound(tablet_lower_bound));
-
-        MetaCacheEntry entry(expiration_time, last_upper_bound, tablet_lower_bound);
-        VLOG(3) << "Caching '" << rpc.table_name() << "' entry " << entry.DebugString(rpc.table());
-        InsertOrDie(&tablets_by_key, last_upper_bound, entry);
+        entries.emplace_back(expiration_time, last_upper_bound, tablet_lower_bound);
+        VLOG(3) << "Caching '" << rpc.table_name() << "' entry "
+                << entries.back().DebugString(rpc.table());
       }
       last_upper_bound = tablet_upper_bound;
 
       // Now process the tablet itself (such as B, D, or E). If we already know
-      // about the tablet, then we only need to refresh it's replica locations
-      // and the entry TTL. If the tablet is unknown, then we need to create a
-      // new RemoteTablet for it.
+      // about the tablet, then we only need to refresh it's replica locations.
+      // If the tablet is unknown, then we need to create a new RemoteTablet
+      // for it.
 
       const string& tablet_id = tablet.tablet_id();
       scoped_refptr<RemoteTablet> remote = FindPtrOrNull(tablets_by_id_, tablet_id);
@@ -907,52 +1014,40 @@ Status MetaCache::ProcessLookupResponse(const LookupRpc& rpc,
         RETURN_NOT_OK_PREPEND(remote->Refresh(ts_cache_, tablet, ts_infos),
                               Substitute("failed to refresh locations for tablet $0",
                                          tablet_id));
-        // Update the entry TTL.
-        auto& entry = FindOrDie(tablets_by_key, tablet_lower_bound);
-        DCHECK(!entry.is_non_covered_range() &&
-               entry.upper_bound_partition_key() == tablet_upper_bound);
-        entry.refresh_expiration_time(expiration_time);
-        continue;
+      } else {
+        Partition partition;
+        Partition::FromPB(tablet.partition(), &partition);
+        remote = new RemoteTablet(tablet_id, partition);
+        RETURN_NOT_OK_PREPEND(remote->Refresh(ts_cache_, tablet, ts_infos),
+                              Substitute("failed to refresh locations for tablet $0",
+                                         tablet_id));
+        InsertOrDie(&tablets_by_id_, tablet_id, remote);
       }
 
-      // Clear any existing entries which overlap with the discovered tablet.
-      tablets_by_key.erase(tablets_by_key.lower_bound(tablet_lower_bound),
-                           tablet_upper_bound.empty() ? tablets_by_key.end() :
-                             tablets_by_key.lower_bound(tablet_upper_bound));
-
-      Partition partition;
-      Partition::FromPB(tablet.partition(), &partition);
-      remote = new RemoteTablet(tablet_id, partition);
-      RETURN_NOT_OK_PREPEND(remote->Refresh(ts_cache_, tablet, ts_infos),
-                            Substitute("failed to refresh locations for tablet $0",
-                                       tablet_id));
-
-      MetaCacheEntry entry(expiration_time, remote);
-      VLOG(3) << "Caching '" << rpc.table_name() << "' entry " << entry.DebugString(rpc.table());
-
-      InsertOrDie(&tablets_by_id_, tablet_id, remote);
-      InsertOrDie(&tablets_by_key, tablet_lower_bound, entry);
+      entries.emplace_back(expiration_time, std::move(remote));
+      VLOG(3) << "Caching '" << rpc.table_name() << "' entry "
+              << entries.back().DebugString(rpc.table());
     }
 
+    string range_upper_bound = last_upper_bound;
     if (!last_upper_bound.empty() && tablet_locations.size() < max_returned_locations) {
       // There is a non-covered range between the last tablet and the end of the
       // partition key space, such as F.
-
-      // Clear existing entries which overlap with the discovered non-covered range.
-      tablets_by_key.erase(tablets_by_key.lower_bound(last_upper_bound),
-                           tablets_by_key.end());
-
-      MetaCacheEntry entry(expiration_time, last_upper_bound, "");
-      VLOG(3) << "Caching '" << rpc.table_name() << "' entry " << entry.DebugString(rpc.table());
-      InsertOrDie(&tablets_by_key, last_upper_bound, entry);
+      range_upper_bound.clear();
+      entries.emplace_back(expiration_time, last_upper_bound, "");
+      VLOG(3) << "Caching '" << rpc.table_name() << "' entry "
+              << entries.back().DebugString(rpc.table());
     }
+
+    tablets_by_key.Replace(range_lower_bound, range_upper_bound, std::move(entries));
   }
 
   // Finally, lookup the discovered entry and return it to the requestor.
-  *cache_entry = FindFloorOrDie(tablets_by_key, rpc.partition_key());
+  *cache_entry = *CHECK_NOTNULL(tablets_by_key.FindFloor(rpc.partition_key()));
   if (!rpc.is_exact_lookup() && cache_entry->is_non_covered_range() &&
       !cache_entry->upper_bound_partition_key().empty()) {
-    *cache_entry = FindFloorOrDie(tablets_by_key, cache_entry->upper_bound_partition_key());
+    *cache_entry = *CHECK_NOTNULL(
+        tablets_by_key.FindFloor(cache_entry->upper_bound_partition_key()));
     DCHECK(!cache_entry->is_non_covered_range());
   }
   return Status::OK();
@@ -962,13 +1057,13 @@ bool MetaCache::LookupEntryByKeyFastPath(const KuduTable* table,
                                          const string& partition_key,
                                          MetaCacheEntry* entry) {
   shared_lock<rw_spinlock> l(lock_.get_lock());
-  const TabletMap* tablets = FindOrNull(tablets_by_table_and_key_, table->id());
+  const MetaCacheEntries* tablets = FindOrNull(tablets_by_table_and_key_, table->id());
   if (PREDICT_FALSE(!tablets)) {
     // No cache available for this table.
     return false;
   }
 
-  const MetaCacheEntry* e = FindFloorOrNull(*tablets, partition_key);
+  const MetaCacheEntry* e = tablets->FindFloor(partition_key);
   if (PREDICT_FALSE(!e)) {
     // No tablets with a start partition key lower than 'partition_key'.
     return false;
@@ -1011,23 +1106,53 @@ Status MetaCache::DoFastPathLookup(const KuduTable* table,
   return Status::Incomplete("");
 }
 
+bool MetaCache::NextUncachedPartitionKey(const KuduTable* table, string* partition_key) {
+  shared_lock<rw_spinlock> l(lock_.get_lock());
+  const MetaCacheEntries* tablets = FindOrNull(tablets_by_table_and_key_, table->id());
+  if (!tablets) {
+    return true;
+  }
+  while (true) {
+    const MetaCacheEntry* e = tablets->FindFloor(*partition_key);
+    if (!e || e->stale() || !e->Contains(*partition_key)) {
+      return true;
+    }
+    if (e->upper_bound_partition_key().empty()) {
+      return false;
+    }
+    *partition_key = e->upper_bound_partition_key();
+  }
+}
+
+Status MetaCache::PrefetchTableLocations(const KuduTable* table, const MonoTime& deadline) {
+  string partition_key;
+  while (NextUncachedPartitionKey(table, &partition_key)) {
+    // A lower bound lookup fetches a full page of locations starting from
+    // the key, rather than the few around it a point lookup would.
+    Synchronizer sync;
+    LookupTabletByKey(table, partition_key, deadline, LookupType::kLowerBound,
+                      /*remote_tablet=*/nullptr, sync.AsStatusCallback());
+    Status s = sync.Wait();
+    // NotFound means the rest of the partition key space isn't covered by any
+    // tablet; that's cached too.
+    if (!s.ok() && !s.IsNotFound()) {
+      return s.CloneAndPrepend(Substitute("failed to prefetch locations of table $0",
+                                          table->name()));
+    }
+  }
+  return Status::OK();
+}
+
 void MetaCache::ClearNonCoveredRangeEntries(const std::string& table_id) {
   VLOG(3) << "Clearing non-covered range entries of table " << table_id;
   std::lock_guard<percpu_rwlock> l(lock_);
 
-  TabletMap* tablets = FindOrNull(tablets_by_table_and_key_, table_id);
+  MetaCacheEntries* tablets = FindOrNull(tablets_by_table_and_key_, table_id);
   if (PREDICT_FALSE(!tablets)) {
     // No cache available for this table.
     return;
   }
-
-  for (auto it = tablets->begin(); it != tablets->end();) {
-    if (it->second.is_non_covered_range()) {
-      it = tablets->erase(it);
-    } else {
-      it++;
-    }
-  }
+  tablets->EraseNonCoveredRanges();
 }
 
 void MetaCache::ClearCache() {
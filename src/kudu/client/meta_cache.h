@@ -20,7 +20,8 @@
 #define KUDU_CLIENT_META_CACHE_H
 
 #include <atomic>
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -111,6 +112,20 @@ class RemoteTabletServer {
   // If no location is assigned, the returned string will be empty.
   std::string location() const;
 
+  // Record the start of an RPC to this tablet server.
+  void RpcStarted();
+
+  // Record the end of an RPC to this tablet server which was started with
+  // RpcStarted(). If the RPC succeeded, its 'latency' is folded into the
+  // server's moving average latency.
+  void RpcFinished(const MonoDelta& latency, bool success);
+
+  // Return the expected cost, in microseconds, of sending an RPC to this
+  // tablet server: its moving average latency scaled by the number of RPCs
+  // from this client currently outstanding on it. Returns 0 if no latency
+  // has been measured yet, so that unmeasured servers get sampled first.
+  double ExpectedRpcCost() const;
+
  private:
   // Internal callback for DNS resolution.
   void DnsResolutionFinished(const HostPort& hp,
@@ -133,6 +148,14 @@ class RemoteTabletServer {
 
   std::shared_ptr<tserver::TabletServerServiceProxy> proxy_;
 
+  // Exponentially weighted moving average of the latency of successful RPCs
+  // to this server, and the time of the last sample. Protected by lock_.
+  double ewma_latency_us_ = 0;
+  MonoTime last_latency_sample_;
+
+  // The number of RPCs from this client currently outstanding on the server.
+  std::atomic<int32_t> outstanding_rpcs_;
+
   DISALLOW_COPY_AND_ASSIGN(RemoteTabletServer);
 };
 
@@ -265,6 +288,14 @@ class RemoteTablet : public RefCountedThreadSafe<RemoteTablet> {
   // Return stringified representation of the list of replicas for this tablet.
   std::string ReplicasAsString() const;
 
+  // Delays the writes to this tablet by 'delay' from now, as suggested by the
+  // leader when it is under memory pressure.
+  void DelayWrites(const MonoDelta& delay);
+
+  // Returns how much longer the writes to this tablet should be delayed, or
+  // a non-positive delta if they needn't be.
+  MonoDelta WriteDelay() const;
+
  private:
   // Same as ReplicasAsString(), except that the caller must hold lock_.
   std::string ReplicasAsStringUnlocked() const;
@@ -274,8 +305,9 @@ class RemoteTablet : public RefCountedThreadSafe<RemoteTablet> {
 
   std::atomic<bool> stale_;
 
-  mutable simple_spinlock lock_; // Protects replicas_.
+  mutable simple_spinlock lock_; // Protects replicas_ and delay_writes_until_.
   std::vector<RemoteReplica> replicas_;
+  MonoTime delay_writes_until_;
 
   DISALLOW_COPY_AND_ASSIGN(RemoteTablet);
 };
@@ -378,6 +410,39 @@ class MetaCacheEntry {
   std::string upper_bound_partition_key_;
 };
 
+// The cached tablets and non-covered ranges of a table, sorted by their lower
+// bound partition keys.
+//
+// The entries are kept in a vector rather than in a map keyed by partition
+// key. That saves a tree node and a copy of the partition key per entry,
+// which adds up for tables with tens of thousands of tablets, and lookups
+// binary search contiguous memory. Since the master returns the locations of
+// consecutive tablets, updates replace a whole run of entries at once.
+class MetaCacheEntries {
+ public:
+  // Returns the entry with the greatest lower bound partition key which is
+  // less than or equal to 'partition_key', or nullptr if there isn't one.
+  const MetaCacheEntry* FindFloor(const std::string& partition_key) const;
+
+  // Replaces the entries whose lower bound partition keys fall in the range
+  // ['lower_bound', 'upper_bound') with 'entries', which must be sorted and
+  // fall in the same range. An empty 'upper_bound' stands for the end of the
+  // partition key space.
+  void Replace(const std::string& lower_bound,
+               const std::string& upper_bound,
+               std::vector<MetaCacheEntry> entries);
+
+  // Removes all of the non-covered range entries.
+  void EraseNonCoveredRanges();
+
+ private:
+  // Returns the index of the first entry whose lower bound partition key is
+  // not less than 'partition_key'.
+  size_t LowerBound(const std::string& partition_key) const;
+
+  std::vector<MetaCacheEntry> entries_;
+};
+
 // Manager of RemoteTablets and RemoteTabletServers. The client consults
 // this class to look up a given tablet or server.
 //
@@ -415,6 +480,13 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
                          scoped_refptr<RemoteTablet>* remote_tablet,
                          const StatusCallback& callback);
 
+  // Looks up the locations of all of the tablets of 'table' which aren't
+  // already cached, kFetchTabletsPerRangeLookup tablets per master round trip.
+  //
+  // NOTE: the memory referenced by 'table' must remain valid until this
+  // method returns.
+  Status PrefetchTableLocations(const KuduTable* table, const MonoTime& deadline);
+
   // Clears the non-covered range entries from a table's meta cache.
   void ClearNonCoveredRangeEntries(const std::string& table_id);
 
@@ -466,6 +538,11 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
                           LookupType lookup_type,
                           scoped_refptr<RemoteTablet>* remote_tablet);
 
+  // Advances 'partition_key' past the cached, non-stale entries of 'table'
+  // which follow one another from it. Returns false if they reach the end of
+  // the partition key space, i.e. there is nothing left to look up.
+  bool NextUncachedPartitionKey(const KuduTable* table, std::string* partition_key);
+
   // Update our information about the given tablet server.
   //
   // This is called when we get some response from the master which contains
@@ -487,15 +564,10 @@ class MetaCache : public RefCountedThreadSafe<MetaCache> {
   // Protected by lock_.
   TabletServerMap ts_cache_;
 
-  // Cache of tablets, keyed by partition key.
-  //
-  // Protected by lock_.
-  typedef std::map<std::string, MetaCacheEntry> TabletMap;
-
   // Cache of tablets and non-covered ranges, keyed by table id.
   //
   // Protected by lock_.
-  std::unordered_map<std::string, TabletMap> tablets_by_table_and_key_;
+  std::unordered_map<std::string, MetaCacheEntries> tablets_by_table_and_key_;
 
   // Cache of tablets, keyed by tablet ID.
   //
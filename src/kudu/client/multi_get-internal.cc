@@ -0,0 +1,349 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/client/multi_get-internal.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "kudu/client/client-internal.h"
+#include "kudu/client/client.h"
+#include "kudu/client/meta_cache.h"
+#include "kudu/client/schema.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/common/partition.h"
+#include "kudu/common/row.h"
+#include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/stringpiece.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/rpc.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/security/token.pb.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/tserver/tserver_service.proxy.h"
+#include "kudu/util/async_util.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/slice.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+using rpc::ComputeExponentialBackoff;
+using rpc::RpcController;
+using security::SignedTokenPB;
+using tserver::LookupRequestPB;
+using tserver::LookupResponsePB;
+using tserver::TabletServerErrorPB;
+using tserver::TabletServerFeatures;
+
+namespace client {
+namespace internal {
+
+// The state of the lookup of the keys of a single tablet.
+struct MultiGetter::TabletLookup {
+  scoped_refptr<RemoteTablet> tablet;
+
+  // For each key in 'req', the index of the key in the caller's keys.
+  vector<int> key_idxs;
+
+  LookupRequestPB req;
+  LookupResponsePB resp;
+  RpcController controller;
+
+  // The replica the last attempt was sent to, or nullptr if no replica could
+  // be selected, in which case 'status' has the reason.
+  RemoteTabletServer* ts = nullptr;
+  Status status;
+  MonoTime rpc_deadline;
+
+  // The replicas which failed the lookup and shouldn't be retried.
+  set<string> blacklist;
+};
+
+MultiGetter::MultiGetter(KuduTable* table, const MonoTime& deadline)
+    : table_(DCHECK_NOTNULL(table)),
+      deadline_(deadline) {
+}
+
+MultiGetter::~MultiGetter() {
+}
+
+Status MultiGetter::Run(const vector<const KuduPartialRow*>& keys,
+                        const vector<string>& projected_column_names,
+                        vector<KuduPartialRow*>* rows) {
+  DCHECK(rows);
+  const Schema& schema = *table_->schema().schema_;
+  vector<StringPiece> col_names(projected_column_names.begin(),
+                                projected_column_names.end());
+  RETURN_NOT_OK(schema.CreateProjectionByNames(col_names, &projection_));
+  projected_col_idxs_.clear();
+  for (const auto& name : projected_column_names) {
+    projected_col_idxs_.push_back(schema.find_column(name));
+  }
+
+  // Group the keys by the tablet they belong to.
+  KuduClient* client = table_->client();
+  map<string, unique_ptr<TabletLookup>> lookups_by_tablet_id;
+  for (int i = 0; i < keys.size(); i++) {
+    const KuduPartialRow& key = *DCHECK_NOTNULL(keys[i]);
+    if (!key.IsKeySet()) {
+      return Status::InvalidArgument(
+          Substitute("key at index $0 doesn't have all the primary key columns set", i),
+          key.ToString());
+    }
+    string encoded_key;
+    RETURN_NOT_OK(key.EncodeRowKey(&encoded_key));
+    string partition_key;
+    RETURN_NOT_OK(table_->partition_schema().EncodeKey(key, &partition_key));
+
+    scoped_refptr<RemoteTablet> tablet;
+    Synchronizer sync;
+    client->data_->meta_cache_->LookupTabletByKey(
+        table_, std::move(partition_key), deadline_, MetaCache::LookupType::kPoint,
+        &tablet, sync.AsStatusCallback());
+    Status s = sync.Wait();
+    if (s.IsNotFound()) {
+      // The key falls in a non-covered range, so it has no row.
+      continue;
+    }
+    RETURN_NOT_OK(s);
+
+    auto& lookup = lookups_by_tablet_id[tablet->tablet_id()];
+    if (!lookup) {
+      lookup.reset(new TabletLookup);
+      lookup->tablet = tablet;
+      lookup->req.set_tablet_id(tablet->tablet_id());
+      RETURN_NOT_OK(SchemaToColumnPBs(
+          projection_, lookup->req.mutable_projected_columns(),
+          SCHEMA_PB_WITHOUT_STORAGE_ATTRIBUTES | SCHEMA_PB_WITHOUT_IDS));
+    }
+    lookup->key_idxs.push_back(i);
+    lookup->req.add_encoded_keys(std::move(encoded_key));
+  }
+
+  // Send the lookups of all the tablets at once, and retry the ones which
+  // failed together, until they all succeed.
+  vector<unique_ptr<KuduPartialRow>> found(keys.size());
+  vector<TabletLookup*> pending;
+  for (const auto& e : lookups_by_tablet_id) {
+    pending.push_back(e.second.get());
+  }
+  for (int attempt = 1; !pending.empty(); attempt++) {
+    if (attempt > 1) {
+      MonoTime now = MonoTime::Now();
+      if (now >= deadline_) {
+        return Status::TimedOut(Substitute(
+            "$0 tablets still to look up after $1 attempts", pending.size(), attempt - 1),
+            pending.front()->status.ToString());
+      }
+      SleepFor(std::min(ComputeExponentialBackoff(attempt - 1), deadline_ - now));
+    }
+    CountDownLatch latch(pending.size());
+    for (auto* lookup : pending) {
+      SendLookup(lookup, &latch);
+    }
+    latch.Wait();
+
+    vector<TabletLookup*> retries;
+    for (auto* lookup : pending) {
+      bool needs_retry;
+      RETURN_NOT_OK(ProcessResponse(lookup, &found, &needs_retry));
+      if (needs_retry) {
+        retries.push_back(lookup);
+      }
+    }
+    pending.swap(retries);
+  }
+
+  rows->reserve(rows->size() + found.size());
+  for (auto& row : found) {
+    rows->push_back(row.release());
+  }
+  return Status::OK();
+}
+
+void MultiGetter::SendLookup(TabletLookup* lookup, CountDownLatch* latch) {
+  KuduClient* client = table_->client();
+  lookup->ts = nullptr;
+  if (lookup->tablet->stale()) {
+    // Refresh the locations of the tablet's replicas.
+    scoped_refptr<RemoteTablet> tablet;
+    Synchronizer sync;
+    client->data_->meta_cache_->LookupTabletByKey(
+        table_, lookup->tablet->partition().partition_key_start(), deadline_,
+        MetaCache::LookupType::kPoint, &tablet, sync.AsStatusCallback());
+    lookup->status = sync.Wait();
+    if (!lookup->status.ok()) {
+      latch->CountDown();
+      return;
+    }
+  }
+  vector<RemoteTabletServer*> candidates;
+  RemoteTabletServer* ts;
+  lookup->status = client->data_->GetTabletServer(
+      client, lookup->tablet, KuduClient::CLOSEST_REPLICA, lookup->blacklist,
+      &candidates, &ts);
+  if (!lookup->status.ok()) {
+    latch->CountDown();
+    return;
+  }
+  lookup->ts = ts;
+
+  SignedTokenPB authz_token;
+  if (client->data_->FetchCachedAuthzToken(table_->id(), &authz_token)) {
+    *lookup->req.mutable_authz_token() = std::move(authz_token);
+  } else {
+    // Send the request without an authz token rather than failing, in case
+    // the tablet server doesn't enforce fine-grained access control.
+    lookup->req.clear_authz_token();
+  }
+  lookup->resp.Clear();
+  lookup->controller.Reset();
+  lookup->rpc_deadline = std::min(
+      deadline_, MonoTime::Now() + client->default_rpc_timeout());
+  lookup->controller.set_deadline(lookup->rpc_deadline);
+  lookup->controller.RequireServerFeature(TabletServerFeatures::LOOKUP_FEATURE);
+  ts->proxy()->LookupAsync(lookup->req, &lookup->resp, &lookup->controller,
+                           [latch]() { latch->CountDown(); });
+}
+
+Status MultiGetter::ProcessResponse(TabletLookup* lookup,
+                                    vector<unique_ptr<KuduPartialRow>>* found,
+                                    bool* needs_retry) {
+  *needs_retry = false;
+  KuduClient* client = table_->client();
+  if (!lookup->ts) {
+    // ServiceUnavailable means that all the replicas are blacklisted or that
+    // there's no leader yet: cycle through them all again.
+    if (lookup->status.IsServiceUnavailable()) {
+      lookup->blacklist.clear();
+      *needs_retry = true;
+      return Status::OK();
+    }
+    return lookup->status;
+  }
+
+  const Status& rpc_status = lookup->controller.status();
+  if (!rpc_status.ok()) {
+    lookup->status = rpc_status;
+    if (rpc_status.IsRemoteError()) {
+      DCHECK(lookup->controller.error_response());
+      switch (lookup->controller.error_response()->code()) {
+        case rpc::ErrorStatusPB::ERROR_SERVER_TOO_BUSY: // fall-through
+        case rpc::ErrorStatusPB::ERROR_UNAVAILABLE:
+          *needs_retry = true;
+          return Status::OK();
+        case rpc::ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN:
+          // Usually this happens if the authz token expired. Retrying with a
+          // new authz token should help.
+          RETURN_NOT_OK(client->data_->RetrieveAuthzToken(table_, deadline_));
+          *needs_retry = true;
+          return Status::OK();
+        case rpc::ErrorStatusPB::ERROR_INVALID_REQUEST: // fall-through
+        case rpc::ErrorStatusPB::FATAL_UNAUTHORIZED:
+          return rpc_status;
+        default:
+          break;
+      }
+    } else if (rpc_status.IsNotAuthorized() ||
+               (rpc_status.IsTimedOut() && lookup->rpc_deadline == deadline_)) {
+      return rpc_status;
+    }
+    // The replica is unreachable or misbehaving: try another one.
+    client->data_->meta_cache_->MarkTSFailed(lookup->ts, rpc_status);
+    lookup->blacklist.insert(lookup->ts->permanent_uuid());
+    *needs_retry = true;
+    return Status::OK();
+  }
+
+  if (lookup->resp.has_error()) {
+    lookup->status = StatusFromPB(lookup->resp.error().status());
+    switch (lookup->resp.error().code()) {
+      case TabletServerErrorPB::TABLET_FAILED: // fall-through
+      case TabletServerErrorPB::TABLET_NOT_FOUND:
+        lookup->tablet->MarkStale();
+        FALLTHROUGH_INTENDED;
+      case TabletServerErrorPB::TABLET_NOT_RUNNING:
+        lookup->blacklist.insert(lookup->ts->permanent_uuid());
+        *needs_retry = true;
+        return Status::OK();
+      default:
+        return lookup->status;
+    }
+  }
+
+  if (lookup->resp.has_propagated_timestamp()) {
+    client->data_->UpdateLatestObservedTimestamp(lookup->resp.propagated_timestamp());
+  }
+
+  const auto& data = lookup->resp.data();
+  Slice direct_data;
+  Slice indirect_data;
+  RETURN_NOT_OK(lookup->controller.GetInboundSidecar(data.rows_sidecar(), &direct_data));
+  if (data.has_indirect_data_sidecar()) {
+    RETURN_NOT_OK(lookup->controller.GetInboundSidecar(data.indirect_data_sidecar(),
+                                                       &indirect_data));
+  }
+  vector<const uint8_t*> row_ptrs;
+  RETURN_NOT_OK(ExtractRowsFromRowBlockPB(projection_, data, indirect_data,
+                                          &direct_data, &row_ptrs));
+  if (row_ptrs.size() != lookup->resp.key_indexes_size()) {
+    return Status::Corruption(Substitute("got $0 rows for $1 key indexes",
+                                         row_ptrs.size(), lookup->resp.key_indexes_size()));
+  }
+
+  const Schema* schema = table_->schema().schema_;
+  for (int i = 0; i < row_ptrs.size(); i++) {
+    const int key_idx = lookup->resp.key_indexes(i);
+    if (key_idx < 0 || key_idx >= lookup->key_idxs.size()) {
+      return Status::Corruption(Substitute("invalid key index $0", key_idx));
+    }
+    ConstContiguousRow src(&projection_, row_ptrs[i]);
+    unique_ptr<KuduPartialRow> row(new KuduPartialRow(schema));
+    for (int col = 0; col < projection_.num_columns(); col++) {
+      const int dst_col = projected_col_idxs_[col];
+      if (projection_.column(col).is_nullable() && src.is_null(col)) {
+        RETURN_NOT_OK(row->SetNull(dst_col));
+      } else {
+        RETURN_NOT_OK(row->Set(dst_col, src.cell_ptr(col)));
+      }
+    }
+    (*found)[lookup->key_idxs[key_idx]] = std::move(row);
+  }
+  return Status::OK();
+}
+
+} // namespace internal
+} // namespace client
+} // namespace kudu
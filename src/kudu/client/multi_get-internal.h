@@ -0,0 +1,85 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/common/schema.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class CountDownLatch;
+class KuduPartialRow;
+
+namespace client {
+
+class KuduTable;
+
+namespace internal {
+
+// Looks up rows of a table by their primary keys. The keys are grouped by
+// tablet, the keys of each tablet are sent to one of its replicas in a single
+// Lookup RPC, and the RPCs to the different tablets are sent in parallel.
+//
+// Failed tablets are retried on other replicas until the deadline, the same
+// way scans fail over.
+class MultiGetter {
+ public:
+  MultiGetter(KuduTable* table, const MonoTime& deadline);
+  ~MultiGetter();
+
+  // Looks up the rows with the primary keys of 'keys', appending one entry
+  // per key to 'rows': the found row with the 'projected_column_names'
+  // columns set, or nullptr if there's no row with the key. The caller takes
+  // ownership of the rows. On error, nothing is appended to 'rows'.
+  Status Run(const std::vector<const KuduPartialRow*>& keys,
+             const std::vector<std::string>& projected_column_names,
+             std::vector<KuduPartialRow*>* rows);
+
+ private:
+  struct TabletLookup;
+
+  // Sends the Lookup RPC of 'lookup' to a replica of its tablet, counting
+  // down 'latch' once the RPC completes.
+  void SendLookup(TabletLookup* lookup, CountDownLatch* latch);
+
+  // Processes the response of the Lookup RPC of 'lookup', moving the found
+  // rows into their key's slot of 'found'. Sets 'needs_retry' if the lookup
+  // failed in a way which may succeed on another attempt.
+  Status ProcessResponse(TabletLookup* lookup,
+                         std::vector<std::unique_ptr<KuduPartialRow>>* found,
+                         bool* needs_retry);
+
+  KuduTable* const table_;
+  const MonoTime deadline_;
+
+  // The projection of the looked up rows, and the index in the table's
+  // schema of each of its columns.
+  Schema projection_;
+  std::vector<int> projected_col_idxs_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiGetter);
+};
+
+} // namespace internal
+} // namespace client
+} // namespace kudu
@@ -0,0 +1,213 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/client/parallel_scanner-internal.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/client/columnar_scan_batch.h"
+#include "kudu/util/thread.h"
+
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace client {
+
+KuduParallelScanner::Data::Data(KuduScanTokenBuilder* builder)
+    : builder_(DCHECK_NOTNULL(builder)),
+      concurrency_(4),
+      max_buffered_batches_(16),
+      ordered_(false),
+      open_(false),
+      batch_cond_(&lock_),
+      space_cond_(&lock_),
+      next_token_(0),
+      num_tokens_done_(0),
+      head_token_(0),
+      closing_(false) {
+}
+
+KuduParallelScanner::Data::~Data() {
+  Close();
+}
+
+Status KuduParallelScanner::Data::Open() {
+  vector<KuduScanToken*> tokens;
+  RETURN_NOT_OK(builder_->Build(&tokens));
+  for (KuduScanToken* token : tokens) {
+    tokens_.emplace_back(token);
+  }
+  token_done_.assign(tokens_.size(), false);
+  open_ = true;
+
+  const int num_threads = std::min<int>(concurrency_, tokens_.size());
+  for (int i = 0; i < num_threads; i++) {
+    scoped_refptr<Thread> thread;
+    Status s = Thread::Create("client", "parallel-scanner",
+                              [this]() { this->ScanThread(); }, &thread);
+    if (!s.ok()) {
+      Close();
+      return s;
+    }
+    threads_.emplace_back(std::move(thread));
+  }
+  return Status::OK();
+}
+
+bool KuduParallelScanner::Data::HasMoreBatches() {
+  MutexLock l(lock_);
+  while (MustWaitLocked()) {
+    batch_cond_.Wait();
+  }
+  return !error_.ok() || FindDeliverableLocked() >= 0;
+}
+
+Status KuduParallelScanner::Data::NextBatch(unique_ptr<KuduColumnarScanBatch>* batch) {
+  MutexLock l(lock_);
+  while (MustWaitLocked()) {
+    batch_cond_.Wait();
+  }
+  RETURN_NOT_OK(error_);
+  int pos = FindDeliverableLocked();
+  if (pos < 0) {
+    batch->reset();
+    return Status::OK();
+  }
+  *batch = std::move(buffered_[pos].batch);
+  buffered_.erase(buffered_.begin() + pos);
+  AdvanceHeadLocked();
+  space_cond_.Broadcast();
+  return Status::OK();
+}
+
+void KuduParallelScanner::Data::Close() {
+  if (!open_) {
+    return;
+  }
+  {
+    MutexLock l(lock_);
+    closing_ = true;
+    space_cond_.Broadcast();
+  }
+  // A thread in the middle of fetching a batch finishes that RPC first.
+  for (const auto& thread : threads_) {
+    thread->Join();
+  }
+  threads_.clear();
+  buffered_.clear();
+  open_ = false;
+}
+
+void KuduParallelScanner::Data::ScanThread() {
+  while (true) {
+    int idx;
+    {
+      MutexLock l(lock_);
+      if (closing_ || !error_.ok() || next_token_ >= static_cast<int>(tokens_.size())) {
+        return;
+      }
+      idx = next_token_++;
+    }
+    Status s = ScanToken(idx);
+
+    MutexLock l(lock_);
+    if (!s.ok() && error_.ok() && !closing_) {
+      LOG(WARNING) << "parallel scan of tablet " << tokens_[idx]->tablet().id()
+                   << " failed: " << s.ToString();
+      error_ = s;
+    }
+    token_done_[idx] = true;
+    num_tokens_done_++;
+    AdvanceHeadLocked();
+    batch_cond_.Signal();
+  }
+}
+
+Status KuduParallelScanner::Data::ScanToken(int idx) {
+  KuduScanner* scanner_raw;
+  RETURN_NOT_OK(tokens_[idx]->IntoKuduScanner(&scanner_raw));
+  unique_ptr<KuduScanner> scanner(scanner_raw);
+  RETURN_NOT_OK(scanner->SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  RETURN_NOT_OK(scanner->SetPrefetching(true));
+  RETURN_NOT_OK(scanner->Open());
+
+  while (scanner->HasMoreRows()) {
+    unique_ptr<KuduColumnarScanBatch> batch(new KuduColumnarScanBatch);
+    RETURN_NOT_OK(scanner->NextBatch(batch.get()));
+    if (batch->NumRows() == 0) {
+      continue;
+    }
+    MutexLock l(lock_);
+    // Batches of the tablet being delivered are never held back: the caller
+    // may be waiting for them while batches of later tablets fill the buffer.
+    while (!closing_ && error_.ok() &&
+           static_cast<int>(buffered_.size()) >= max_buffered_batches_ &&
+           !(ordered_ && idx == head_token_)) {
+      space_cond_.Wait();
+    }
+    if (closing_ || !error_.ok()) {
+      return Status::OK();
+    }
+    buffered_.push_back({ idx, std::move(batch) });
+    batch_cond_.Signal();
+  }
+  return Status::OK();
+}
+
+int KuduParallelScanner::Data::FindDeliverableLocked() const {
+  lock_.AssertAcquired();
+  if (!ordered_) {
+    return buffered_.empty() ? -1 : 0;
+  }
+  for (int i = 0; i < static_cast<int>(buffered_.size()); i++) {
+    if (buffered_[i].token_idx == head_token_) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool KuduParallelScanner::Data::MustWaitLocked() const {
+  lock_.AssertAcquired();
+  return error_.ok() &&
+      FindDeliverableLocked() < 0 &&
+      num_tokens_done_ < static_cast<int>(tokens_.size());
+}
+
+void KuduParallelScanner::Data::AdvanceHeadLocked() {
+  lock_.AssertAcquired();
+  if (!ordered_) {
+    return;
+  }
+  const int prev_head = head_token_;
+  while (head_token_ < static_cast<int>(tokens_.size()) &&
+         token_done_[head_token_] &&
+         FindDeliverableLocked() < 0) {
+    head_token_++;
+  }
+  if (head_token_ != prev_head) {
+    // The new head's scan thread may be waiting for buffer space.
+    space_cond_.Broadcast();
+  }
+}
+
+} // namespace client
+} // namespace kudu
@@ -0,0 +1,125 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Thread;
+
+namespace client {
+
+class KuduColumnarScanBatch;
+
+class KuduParallelScanner::Data {
+ public:
+  explicit Data(KuduScanTokenBuilder* builder);
+  ~Data();
+
+  Status Open();
+
+  bool HasMoreBatches();
+
+  // Takes the next batch to deliver, or sets 'batch' to null if all the
+  // tablets have been scanned. Returns the scan error, if any.
+  Status NextBatch(std::unique_ptr<KuduColumnarScanBatch>* batch);
+
+  void Close();
+
+  // Configuration, set before Open().
+  KuduScanTokenBuilder* builder_;
+  int concurrency_;
+  int max_buffered_batches_;
+  bool ordered_;
+
+  bool open_;
+
+ private:
+  struct BufferedBatch {
+    int token_idx;
+    std::unique_ptr<KuduColumnarScanBatch> batch;
+  };
+
+  // Body of the scan threads: takes tokens until none are left.
+  void ScanThread();
+
+  // Scans the token at 'idx' into 'buffered_'.
+  Status ScanToken(int idx);
+
+  // Returns the position in 'buffered_' of the batch to deliver next, or -1
+  // if there is none yet.
+  //
+  // REQUIRES: lock_ is held.
+  int FindDeliverableLocked() const;
+
+  // Returns true if the caller has to wait for the scan threads, i.e. there
+  // is no batch to deliver, no error, and tablets left to scan.
+  //
+  // REQUIRES: lock_ is held.
+  bool MustWaitLocked() const;
+
+  // When ordered by tablet, moves 'head_token_' past the tablets that are
+  // done and have no batches left to deliver.
+  //
+  // REQUIRES: lock_ is held.
+  void AdvanceHeadLocked();
+
+  std::vector<std::unique_ptr<KuduScanToken>> tokens_;
+  std::vector<scoped_refptr<Thread>> threads_;
+
+  // Protects the members below.
+  Mutex lock_;
+
+  // Signaled when a batch is buffered, a tablet is done or a scan fails.
+  ConditionVariable batch_cond_;
+
+  // Signaled when a batch is taken, the head tablet advances or the scan is
+  // closing.
+  ConditionVariable space_cond_;
+
+  std::deque<BufferedBatch> buffered_;
+
+  // The next token for a scan thread to pick up.
+  int next_token_;
+
+  // Whether the scan of each token has finished.
+  std::vector<bool> token_done_;
+  int num_tokens_done_;
+
+  // When ordered by tablet, the token whose batches are delivered now.
+  int head_token_;
+
+  // The first scan error.
+  Status error_;
+
+  bool closing_;
+
+  DISALLOW_COPY_AND_ASSIGN(Data);
+};
+
+} // namespace client
+} // namespace kudu
@@ -17,21 +17,39 @@
 
 #include "kudu/client/partitioner-internal.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
+
+#include <glog/logging.h>
 
 #include "kudu/client/client-internal.h"
 #include "kudu/client/client.h"
 #include "kudu/client/meta_cache.h"
+#include "kudu/client/schema.h"
 #include "kudu/client/table-internal.h"
+#include "kudu/client/write_op-internal.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/key_encoder.h"
 #include "kudu/common/partition.h"
-#include "kudu/gutil/map-util.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/async_util.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
+using std::map;
 using std::string;
 using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace client {
@@ -46,7 +64,8 @@ Status KuduPartitionerBuilder::Data::Build(KuduPartitioner** partitioner) {
 
   // Insert a sentinel for the beginning of the table, in case they
   // query for any row which falls before the first partition.
-  ret_data->partitions_by_start_key_[""] =  -1;
+  map<string, int> partitions_by_start_key;
+  partitions_by_start_key[""] =  -1;
   string next_part_key = "";
   int i = 0;
   while (true) {
@@ -63,11 +82,16 @@ Status KuduPartitionerBuilder::Data::Build(KuduPartitioner** partitioner) {
     RETURN_NOT_OK(s);
     const auto& start_key = tablet->partition().partition_key_start();
     const auto& end_key = tablet->partition().partition_key_end();
-    ret_data->partitions_by_start_key_[start_key] = i++;
+    partitions_by_start_key[start_key] = i++;
     if (end_key.empty()) break;
-    ret_data->partitions_by_start_key_[end_key] = -1;
+    partitions_by_start_key[end_key] = -1;
     next_part_key = end_key;
   }
+  // Flatten the map into sorted arrays, which are cheaper to search.
+  for (const auto& e : partitions_by_start_key) {
+    ret_data->start_keys_.push_back(e.first);
+    ret_data->partition_indexes_.push_back(e.second);
+  }
   ret_data->num_partitions_ = i;
   ret_data->table_ = table_;
   *partitioner = new KuduPartitioner(ret_data.release());
@@ -78,9 +102,99 @@ Status KuduPartitioner::Data::PartitionRow(
     const KuduPartialRow& row, int* partition) {
   tmp_buf_.clear();
   RETURN_NOT_OK(table_->data_->partition_schema_.EncodeKey(row, &tmp_buf_));
-  *partition = FindFloorOrDie(partitions_by_start_key_, tmp_buf_);
+  *partition = FindPartition(tmp_buf_);
+  return Status::OK();
+}
+
+Status KuduPartitioner::Data::ResolveKeyColumns(const KuduColumnarWriteBatch::Data& batch,
+                                                const vector<ColumnId>& column_ids,
+                                                vector<KeyColumn>* key_columns) {
+  const Schema* schema = batch.table_->schema().schema_;
+  for (ColumnId id : column_ids) {
+    int idx = schema->find_column_by_id(id);
+    DCHECK_NE(Schema::kColumnNotFound, idx);
+    const ColumnSchema& col = schema->column(idx);
+    const KuduColumnarWriteBatch::Data::Column& column = batch.columns_[idx];
+    if (PREDICT_FALSE(!column.is_set)) {
+      return Status::InvalidArgument(
+          Substitute("partition key column '$0' is not set", col.name()));
+    }
+    const TypeInfo* type_info = col.type_info();
+    bool var_length = type_info->physical_type() == BINARY;
+    key_columns->push_back({ &column, &GetKeyEncoder<string>(type_info),
+                             var_length ? 0 : type_info->size() });
+  }
   return Status::OK();
 }
 
+void KuduPartitioner::Data::EncodeKeyColumns(const vector<KeyColumn>& key_columns,
+                                             int row_idx, string* buf) {
+  const int num_columns = key_columns.size();
+  for (int i = 0; i < num_columns; i++) {
+    const KeyColumn& c = key_columns[i];
+    bool is_last = i + 1 == num_columns;
+    if (c.cell_size == 0) {
+      Slice cell = c.column->VariableLengthCell(row_idx);
+      c.encoder->Encode(&cell, is_last, buf);
+    } else {
+      c.encoder->Encode(c.column->FixedLengthCell(row_idx, c.cell_size), is_last, buf);
+    }
+  }
+}
+
+Status KuduPartitioner::Data::PartitionRows(const KuduColumnarWriteBatch::Data& batch,
+                                            vector<int>* partitions) {
+  if (PREDICT_FALSE(batch.table_->id() != table_->id())) {
+    return Status::InvalidArgument(
+        Substitute("batch is for table $0, not $1", batch.table_->name(), table_->name()));
+  }
+  const PartitionSchema& partition_schema = table_->data_->partition_schema_;
+  const auto& hash_schemas = partition_schema.hash_partition_schemas();
+  const int num_rows = batch.num_rows_;
+
+  // Compute the hash buckets one dimension at a time, so that each pass
+  // only touches the columns of that dimension.
+  vector<vector<int32_t>> buckets(hash_schemas.size());
+  vector<KeyColumn> key_columns;
+  string buf;
+  const int num_hash_schemas = hash_schemas.size();
+  for (int h = 0; h < num_hash_schemas; h++) {
+    const PartitionSchema::HashBucketSchema& hash_schema = hash_schemas[h];
+    key_columns.clear();
+    RETURN_NOT_OK(ResolveKeyColumns(batch, hash_schema.column_ids, &key_columns));
+    vector<int32_t>* dim_buckets = &buckets[h];
+    dim_buckets->resize(num_rows);
+    for (int row = 0; row < num_rows; row++) {
+      buf.clear();
+      EncodeKeyColumns(key_columns, row, &buf);
+      uint64_t hash = HashUtil::MurmurHash2_64(buf.data(), buf.length(), hash_schema.seed);
+      (*dim_buckets)[row] = hash % static_cast<uint64_t>(hash_schema.num_buckets);
+    }
+  }
+
+  // Then assemble the full partition key of each row and look it up.
+  key_columns.clear();
+  RETURN_NOT_OK(ResolveKeyColumns(batch, partition_schema.range_schema().column_ids,
+                                  &key_columns));
+  const KeyEncoder<string>& bucket_encoder = GetKeyEncoder<string>(GetTypeInfo(UINT32));
+  partitions->resize(num_rows);
+  for (int row = 0; row < num_rows; row++) {
+    buf.clear();
+    for (const auto& dim_buckets : buckets) {
+      bucket_encoder.Encode(&dim_buckets[row], &buf);
+    }
+    EncodeKeyColumns(key_columns, row, &buf);
+    (*partitions)[row] = FindPartition(buf);
+  }
+  return Status::OK();
+}
+
+int KuduPartitioner::Data::FindPartition(const string& partition_key) const {
+  // 'start_keys_' begins with the empty key, so there is always a floor entry.
+  auto it = std::upper_bound(start_keys_.begin(), start_keys_.end(), partition_key);
+  DCHECK(it != start_keys_.begin());
+  return partition_indexes_[it - start_keys_.begin() - 1];
+}
+
 } // namespace client
 } // namespace kudu
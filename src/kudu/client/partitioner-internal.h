@@ -16,18 +16,22 @@
 // under the License.
 #pragma once
 
-#include <map>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "kudu/client/client.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/client/write_op-internal.h"
+#include "kudu/common/schema.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
+template<typename Buffer> class KeyEncoder;
 class KuduPartialRow;
 
 namespace client {
@@ -68,10 +72,42 @@ class KuduPartitioner::Data {
  public:
   Status PartitionRow(const KuduPartialRow& row, int* partition);
 
+  Status PartitionRows(const KuduColumnarWriteBatch::Data& batch,
+                       std::vector<int>* partitions);
+
+  // Returns the index of the partition containing the encoded partition key,
+  // or -1 if the key falls into a non-covered range.
+  int FindPartition(const std::string& partition_key) const;
+
   sp::shared_ptr<KuduTable> table_;
-  std::map<std::string, int> partitions_by_start_key_;
+
+  // The sorted start keys of the partitions and of the non-covered ranges
+  // between them. The first key is always the empty key.
+  std::vector<std::string> start_keys_;
+  // The partition index of the range beginning at the corresponding entry
+  // of 'start_keys_', or -1 for a non-covered range.
+  std::vector<int> partition_indexes_;
   int num_partitions_ = 0;
   std::string tmp_buf_;
+
+ private:
+  // A partition key column of a columnar batch, resolved for encoding.
+  struct KeyColumn {
+    const KuduColumnarWriteBatch::Data::Column* column;
+    const KeyEncoder<std::string>* encoder;
+    // Zero for variable-length columns.
+    size_t cell_size;
+  };
+
+  // Looks up the columns with the given IDs in 'batch', failing if any of
+  // them is not set.
+  static Status ResolveKeyColumns(const KuduColumnarWriteBatch::Data& batch,
+                                  const std::vector<ColumnId>& column_ids,
+                                  std::vector<KeyColumn>* key_columns);
+
+  // Appends the encoded cells of 'key_columns' at 'row_idx' to 'buf'.
+  static void EncodeKeyColumns(const std::vector<KeyColumn>& key_columns,
+                               int row_idx, std::string* buf);
 };
 
 
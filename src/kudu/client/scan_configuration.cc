@@ -58,7 +58,10 @@ ScanConfiguration::ScanConfiguration(KuduTable* table)
       lower_bound_propagation_timestamp_(kNoTimestamp),
       timeout_(MonoDelta::FromMilliseconds(KuduScanner::kScanTimeoutMillis)),
       arena_(256),
-      row_format_flags_(KuduScanner::NO_FLAGS) {
+      row_format_flags_(KuduScanner::NO_FLAGS),
+      columnar_compression_(NO_COMPRESSION),
+      prefetching_(false),
+      hedging_percentile_(0) {
 }
 
 Status ScanConfiguration::SetProjectedColumnNames(const vector<string>& col_names) {
@@ -207,6 +210,10 @@ Status ScanConfiguration::SetRowFormatFlags(uint64_t flags) {
   return Status::OK();
 }
 
+void ScanConfiguration::SetColumnarCompression(CompressionType compression) {
+  columnar_compression_ = compression;
+}
+
 Status ScanConfiguration::SetLimit(int64_t limit) {
   if (limit < 0) {
     return Status::InvalidArgument("Limit must be non-negative");
@@ -215,6 +222,19 @@ Status ScanConfiguration::SetLimit(int64_t limit) {
   return Status::OK();
 }
 
+void ScanConfiguration::SetPrefetching(bool prefetching) {
+  prefetching_ = prefetching;
+}
+
+Status ScanConfiguration::SetHedgingPercentile(double percentile) {
+  if (!(percentile >= 0 && percentile < 100)) {
+    return Status::InvalidArgument(
+        strings::Substitute("Hedging percentile must be in the range [0, 100): $0", percentile));
+  }
+  hedging_percentile_ = percentile;
+  return Status::OK();
+}
+
 Status ScanConfiguration::AddIsDeletedColumn() {
   CHECK(has_start_timestamp());
   CHECK(has_snapshot_timestamp());
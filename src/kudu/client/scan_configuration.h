@@ -28,6 +28,7 @@
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/auto_release_pool.h"
+#include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/slice.h"
@@ -97,8 +98,14 @@ class ScanConfiguration {
 
   Status SetRowFormatFlags(uint64_t flags);
 
+  void SetColumnarCompression(CompressionType compression);
+
   Status SetLimit(int64_t limit);
 
+  void SetPrefetching(bool prefetching);
+
+  Status SetHedgingPercentile(double percentile) WARN_UNUSED_RESULT;
+
   // Adds an IS_DELETED virtual column to the projection.
   //
   // Can only be used with diff scans.
@@ -184,6 +191,18 @@ class ScanConfiguration {
     return row_format_flags_;
   }
 
+  CompressionType columnar_compression() const {
+    return columnar_compression_;
+  }
+
+  bool prefetching() const {
+    return prefetching_;
+  }
+
+  double hedging_percentile() const {
+    return hedging_percentile_;
+  }
+
   Arena* arena() {
     return &arena_;
   }
@@ -236,6 +255,14 @@ class ScanConfiguration {
   AutoReleasePool pool_;
 
   uint64_t row_format_flags_;
+
+  CompressionType columnar_compression_;
+
+  bool prefetching_;
+
+  // The percentile of the observed latencies after which to hedge the
+  // request opening the scan of a tablet, or 0 if hedging is disabled.
+  double hedging_percentile_;
 };
 
 } // namespace client
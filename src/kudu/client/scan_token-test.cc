@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -31,6 +32,7 @@
 #include "kudu/client/client-test-util.h"
 #include "kudu/client/client.h"
 #include "kudu/client/client.pb.h"
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/scan_batch.h"
 #include "kudu/client/scan_configuration.h"
 #include "kudu/client/scan_predicate.h"
@@ -49,6 +51,7 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -465,6 +468,101 @@ TEST_F(ScanTokenTest, TestScanTokensWithNonCoveringRange) {
   }
 }
 
+// Scan a table with KuduParallelScanner, both unordered and ordered by tablet,
+// with a buffer small enough that the scan threads have to wait for it.
+TEST_F(ScanTokenTest, TestParallelScanner) {
+  KuduSchema schema;
+  {
+    KuduSchemaBuilder builder;
+    builder.AddColumn("col")->NotNull()->Type(KuduColumnSchema::INT64)->PrimaryKey();
+    ASSERT_OK(builder.Build(&schema));
+  }
+  shared_ptr<KuduTable> table;
+  {
+    unique_ptr<client::KuduTableCreator> table_creator(client_->NewTableCreator());
+    ASSERT_OK(table_creator->table_name("table")
+                            .schema(&schema)
+                            .add_hash_partitions({ "col" }, 8)
+                            .num_replicas(1)
+                            .Create());
+    ASSERT_OK(client_->OpenTable("table", &table));
+  }
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  constexpr int kNumRows = 2000;
+  for (int i = 0; i < kNumRows; i++) {
+    unique_ptr<KuduInsert> insert(table->NewInsert());
+    ASSERT_OK(insert->mutable_row()->SetInt64("col", i));
+    ASSERT_OK(session->Apply(insert.release()));
+  }
+  ASSERT_OK(session->Flush());
+
+  const auto append_keys = [](const KuduColumnarScanBatch& batch, vector<int64_t>* keys) {
+    Slice data;
+    ASSERT_OK(batch.GetFixedLengthColumn(0, &data));
+    const int64_t* vals = reinterpret_cast<const int64_t*>(data.data());
+    keys->insert(keys->end(), vals, vals + batch.NumRows());
+  };
+
+  // The tablets scanned one after another, in token order.
+  KuduScanTokenBuilder builder(table.get());
+  ASSERT_OK(builder.SetBatchSizeBytes(256));
+  vector<int64_t> sequential_keys;
+  {
+    vector<KuduScanToken*> tokens;
+    ElementDeleter deleter(&tokens);
+    ASSERT_OK(builder.Build(&tokens));
+    ASSERT_EQ(8, tokens.size());
+    for (KuduScanToken* token : tokens) {
+      KuduScanner* scanner_ptr;
+      ASSERT_OK(token->IntoKuduScanner(&scanner_ptr));
+      unique_ptr<KuduScanner> scanner(scanner_ptr);
+      ASSERT_OK(scanner->SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+      ASSERT_OK(scanner->Open());
+      KuduColumnarScanBatch batch;
+      while (scanner->HasMoreRows()) {
+        ASSERT_OK(scanner->NextBatch(&batch));
+        NO_FATALS(append_keys(batch, &sequential_keys));
+      }
+    }
+  }
+  ASSERT_EQ(kNumRows, sequential_keys.size());
+
+  for (bool ordered : { false, true }) {
+    SCOPED_TRACE(ordered);
+    KuduParallelScanner scanner(&builder);
+    ASSERT_OK(scanner.SetConcurrency(4));
+    ASSERT_OK(scanner.SetMaxBufferedBatches(2));
+    ASSERT_OK(scanner.SetOrderedByTablet(ordered));
+    ASSERT_OK(scanner.Open());
+    ASSERT_TRUE(scanner.SetConcurrency(2).IsIllegalState());
+    vector<int64_t> keys;
+    KuduColumnarScanBatch batch;
+    while (scanner.HasMoreBatches()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
+      NO_FATALS(append_keys(batch, &keys));
+    }
+    if (ordered) {
+      ASSERT_EQ(sequential_keys, keys);
+    } else {
+      std::sort(keys.begin(), keys.end());
+      vector<int64_t> expected(sequential_keys);
+      std::sort(expected.begin(), expected.end());
+      ASSERT_EQ(expected, keys);
+    }
+  }
+
+  // Closing in the middle of a scan stops the scan threads.
+  KuduParallelScanner scanner(&builder);
+  ASSERT_OK(scanner.SetMaxBufferedBatches(1));
+  ASSERT_OK(scanner.Open());
+  ASSERT_TRUE(scanner.HasMoreBatches());
+  KuduColumnarScanBatch batch;
+  ASSERT_OK(scanner.NextBatch(&batch));
+  ASSERT_GT(batch.NumRows(), 0);
+  scanner.Close();
+}
+
 const kudu::ReadMode read_modes[] = {
     kudu::READ_LATEST,
     kudu::READ_AT_SNAPSHOT,
@@ -18,7 +18,10 @@
 #include "kudu/client/scanner-internal.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
@@ -36,10 +39,12 @@
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/partition.h"
+#include "kudu/common/partition_pruner.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/stringpiece.h"
@@ -52,7 +57,12 @@
 #include "kudu/tserver/tserver_service.proxy.h"
 #include "kudu/util/async_util.h"
 #include "kudu/util/bitmap.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/hexdump.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/monotime.h"
 
@@ -85,11 +95,17 @@ KuduScanner::Data::Data(KuduTable* table)
     data_in_open_(false),
     short_circuit_(false),
     table_(DCHECK_NOTNULL(table)->shared_from_this()),
+    prefetch_in_flight_(false),
+    prefetch_latch_(0),
     scan_attempts_(0),
     num_rows_returned_(0) {
 }
 
 KuduScanner::Data::~Data() {
+  // The RPC callback refers to this object.
+  if (prefetch_in_flight_) {
+    prefetch_latch_.Wait();
+  }
 }
 
 Status KuduScanner::Data::EnrichStatusMessage(Status s) const {
@@ -339,6 +355,282 @@ Status KuduScanner::Data::ReopenCurrentTablet(const MonoTime& deadline,
 
 ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
                                              bool allow_time_for_failover) {
+  MonoTime rpc_deadline = PrepareScanRpc(overall_deadline, allow_time_for_failover);
+  ts_->RpcStarted();
+  const MonoTime start = MonoTime::Now();
+  Status s = proxy_->Scan(next_req_, &last_response_, &controller_);
+  ts_->RpcFinished(MonoTime::Now() - start, s.ok() && !last_response_.has_error());
+  return FinishScanRpc(s, rpc_deadline, overall_deadline);
+}
+
+namespace {
+
+// Closes the server-side scanner 'scanner_id' without waiting for the result.
+void CloseScannerAsync(const std::shared_ptr<tserver::TabletServerServiceProxy>& proxy,
+                       const string& scanner_id,
+                       const MonoDelta& timeout) {
+  struct Closer {
+    tserver::ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController controller;
+  };
+  Closer* closer = new Closer;
+  closer->req.set_scanner_id(scanner_id);
+  closer->req.set_batch_size_bytes(0);
+  closer->req.set_close_scanner(true);
+  closer->controller.set_timeout(timeout);
+  proxy->ScanAsync(closer->req, &closer->resp, &closer->controller, [closer, scanner_id]() {
+    if (!closer->controller.status().ok()) {
+      VLOG(1) << "Couldn't close hedged scanner " << scanner_id << ": "
+              << closer->controller.status().ToString();
+    }
+    delete closer;
+  });
+}
+
+// The hedged request opening the scan of a tablet. It's shared with the RPC
+// callback, since a losing request may complete after the scanner moved on.
+class HedgedScanRequest {
+ public:
+  HedgedScanRequest(RemoteTabletServer* ts, const MonoDelta& close_timeout)
+      : ts_(ts),
+        close_timeout_(close_timeout),
+        done_(1),
+        finished_(false),
+        abandoned_(false),
+        succeeded_(false) {
+  }
+
+  // Sends 'req' to the replica. 'any_done' is counted down if it succeeds.
+  void Send(const tserver::ScanRequestPB& req,
+            const RpcController& primary_controller,
+            const MonoTime& deadline,
+            const std::shared_ptr<HedgedScanRequest>& self,
+            const std::shared_ptr<CountDownLatch>& any_done) {
+    req_ = req;
+    controller_.set_deadline(deadline);
+    for (uint32_t feature : primary_controller.required_server_features()) {
+      controller_.RequireServerFeature(feature);
+    }
+    ts_->RpcStarted();
+    const MonoTime start = MonoTime::Now();
+    ts_->proxy()->ScanAsync(req_, &resp_, &controller_, [self, any_done, start]() {
+      self->Finished(MonoTime::Now() - start, any_done.get());
+    });
+  }
+
+  // Gives up on the request: cancels it if it's still in flight, and closes
+  // the scanner it opened, if any, once it completes.
+  void Abandon() {
+    bool finished;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      abandoned_ = true;
+      finished = finished_;
+    }
+    if (finished) {
+      CloseScanner();
+    } else {
+      controller_.Cancel();
+    }
+  }
+
+  // Waits for the request to complete.
+  void Wait() const {
+    done_.Wait();
+  }
+
+  // Whether the request succeeded. Must be called once it has completed.
+  bool succeeded() const {
+    return succeeded_;
+  }
+
+  RemoteTabletServer* ts() const {
+    return ts_;
+  }
+
+  ScanResponsePB* mutable_resp() {
+    return &resp_;
+  }
+
+ private:
+  void Finished(const MonoDelta& latency, CountDownLatch* any_done) {
+    const bool ok = controller_.status().ok() && !resp_.has_error();
+    ts_->RpcFinished(latency, ok);
+    bool abandoned;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      finished_ = true;
+      abandoned = abandoned_;
+    }
+    succeeded_ = ok;
+    if (abandoned) {
+      CloseScanner();
+    }
+    done_.CountDown();
+    if (ok) {
+      any_done->CountDown();
+    }
+  }
+
+  void CloseScanner() {
+    if (succeeded_ && resp_.has_scanner_id()) {
+      CloseScannerAsync(ts_->proxy(), resp_.scanner_id(), close_timeout_);
+    }
+  }
+
+  RemoteTabletServer* const ts_;
+  const MonoDelta close_timeout_;
+  tserver::ScanRequestPB req_;
+  ScanResponsePB resp_;
+  RpcController controller_;
+  CountDownLatch done_;
+
+  simple_spinlock lock_;
+  bool finished_;
+  bool abandoned_;
+
+  std::atomic<bool> succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(HedgedScanRequest);
+};
+
+} // anonymous namespace
+
+ScanRpcStatus KuduScanner::Data::SendOpenScanRpc(const MonoTime& overall_deadline,
+                                                 bool allow_time_for_failover,
+                                                 const vector<RemoteTabletServer*>& candidates,
+                                                 const set<string>& blacklist) {
+  KuduClient* client = table_->client();
+
+  // Hedging only applies to snapshot reads, which any replica can serve.
+  MonoDelta hedge_delay;
+  RemoteTabletServer* hedge_ts = nullptr;
+  if (configuration_.hedging_percentile() > 0 &&
+      configuration_.read_mode() == KuduScanner::READ_AT_SNAPSHOT &&
+      configuration_.selection() != KuduClient::LEADER_ONLY) {
+    hedge_delay = client->data_->ScanOpenLatencyPercentile(configuration_.hedging_percentile());
+    // Hedge with the cheapest of the other replicas.
+    double min_cost = 0;
+    for (RemoteTabletServer* candidate : candidates) {
+      if (candidate == ts_ || ContainsKey(blacklist, candidate->permanent_uuid())) {
+        continue;
+      }
+      const double cost = candidate->ExpectedRpcCost();
+      if (!hedge_ts || cost < min_cost) {
+        hedge_ts = candidate;
+        min_cost = cost;
+      }
+    }
+  }
+
+  const MonoTime start = MonoTime::Now();
+  if (!hedge_delay.Initialized() || !hedge_ts) {
+    ScanRpcStatus scan_status = SendScanRpc(overall_deadline, allow_time_for_failover);
+    if (scan_status.result == ScanRpcStatus::OK) {
+      client->data_->RecordScanOpenLatency(MonoTime::Now() - start);
+    }
+    return scan_status;
+  }
+
+  // Counted down once the primary request completes or the hedged one
+  // succeeds, whichever comes first.
+  auto any_done = std::make_shared<CountDownLatch>(1);
+  CountDownLatch primary_done(1);
+  MonoTime rpc_deadline = PrepareScanRpc(overall_deadline, allow_time_for_failover);
+  RemoteTabletServer* primary_ts = ts_;
+  primary_ts->RpcStarted();
+  proxy_->ScanAsync(next_req_, &last_response_, &controller_,
+                    [&, primary_ts, any_done, start]() {
+                      primary_ts->RpcFinished(MonoTime::Now() - start,
+                                              controller_.status().ok() &&
+                                              !last_response_.has_error());
+                      primary_done.CountDown();
+                      any_done->CountDown();
+                    });
+
+  std::shared_ptr<HedgedScanRequest> hedge;
+  if (!any_done->WaitFor(hedge_delay)) {
+    Synchronizer sync;
+    hedge_ts->InitProxy(client, sync.AsStatusCallback());
+    Status s = sync.Wait();
+    if (s.ok()) {
+      VLOG(1) << "Hedging the scan of tablet " << remote_->tablet_id() << " on "
+              << primary_ts->ToString() << " with " << hedge_ts->ToString();
+      hedge = std::make_shared<HedgedScanRequest>(hedge_ts, configuration_.timeout());
+      hedge->Send(next_req_, controller_, rpc_deadline, hedge, any_done);
+    } else {
+      VLOG(1) << "Couldn't hedge the scan of tablet " << remote_->tablet_id() << " with "
+              << hedge_ts->ToString() << ": " << s.ToString();
+    }
+    any_done->Wait();
+  }
+
+  // If the primary request failed, give the hedged one its chance.
+  bool primary_ok = primary_done.count() == 0 &&
+      controller_.status().ok() && !last_response_.has_error();
+  if (hedge && primary_done.count() == 0 && !primary_ok) {
+    hedge->Wait();
+  }
+  if (!hedge || primary_ok || !hedge->succeeded()) {
+    primary_done.Wait();
+    if (hedge) {
+      hedge->Abandon();
+    }
+    if (controller_.status().ok() && !last_response_.has_error()) {
+      client->data_->RecordScanOpenLatency(MonoTime::Now() - start);
+    }
+    return FinishScanRpc(controller_.status(), rpc_deadline, overall_deadline);
+  }
+
+  // The hedged request won. The primary one must complete before its
+  // response buffer is reused, and the scanner it opened closed, if any.
+  controller_.Cancel();
+  primary_done.Wait();
+  if (controller_.status().ok() && !last_response_.has_error() &&
+      last_response_.has_scanner_id()) {
+    CloseScannerAsync(proxy_, last_response_.scanner_id(), configuration_.timeout());
+  }
+  client->data_->RecordScanOpenLatency(MonoTime::Now() - start);
+  last_response_.Swap(hedge->mutable_resp());
+  ts_ = hedge->ts();
+  proxy_ = ts_->proxy();
+  return FinishScanRpc(Status::OK(), rpc_deadline, overall_deadline);
+}
+
+void KuduScanner::Data::StartPrefetch() {
+  DCHECK(!prefetch_in_flight_);
+  if (!configuration_.prefetching() || !last_response_.has_more_results()) {
+    return;
+  }
+  VLOG(2) << "Prefetching " << DebugString();
+  PrepareRequest(KuduScanner::Data::CONTINUE);
+  prefetch_deadline_ = MonoTime::Now() + configuration_.timeout();
+  prefetch_rpc_deadline_ = PrepareScanRpc(prefetch_deadline_,
+                                          configuration_.is_fault_tolerant());
+  prefetch_latch_.Reset(1);
+  prefetch_in_flight_ = true;
+  RemoteTabletServer* ts = ts_;
+  ts->RpcStarted();
+  const MonoTime start = MonoTime::Now();
+  proxy_->ScanAsync(next_req_, &last_response_, &controller_,
+                    [this, ts, start]() {
+                      ts->RpcFinished(MonoTime::Now() - start,
+                                      controller_.status().ok() &&
+                                      !last_response_.has_error());
+                      prefetch_latch_.CountDown();
+                    });
+}
+
+ScanRpcStatus KuduScanner::Data::FinishPrefetch() {
+  DCHECK(prefetch_in_flight_);
+  prefetch_latch_.Wait();
+  prefetch_in_flight_ = false;
+  return FinishScanRpc(controller_.status(), prefetch_rpc_deadline_, prefetch_deadline_);
+}
+
+MonoTime KuduScanner::Data::PrepareScanRpc(const MonoTime& overall_deadline,
+                                           bool allow_time_for_failover) {
   // The user has specified a timeout which should apply to the total time for each call
   // to NextBatch(). However, for fault-tolerant scans, or for when we are first opening
   // a scanner, it's preferable to set a shorter timeout (the "default RPC timeout") for
@@ -373,6 +665,12 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
   if (configuration().row_format_flags() & KuduScanner::COLUMNAR_LAYOUT) {
     controller_.RequireServerFeature(TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE);
   }
+  if (configuration().row_format_flags() & KuduScanner::ARROW_LAYOUT) {
+    controller_.RequireServerFeature(TabletServerFeatures::ARROW_LAYOUT_FEATURE);
+  }
+  if (configuration().columnar_compression() != NO_COMPRESSION) {
+    controller_.RequireServerFeature(TabletServerFeatures::COLUMNAR_COMPRESSION_FEATURE);
+  }
 
   if (next_req_.has_new_scan_request()) {
     // Only new scan requests require authz tokens. Scan continuations rely on
@@ -386,11 +684,13 @@ ScanRpcStatus KuduScanner::Data::SendScanRpc(const MonoTime& overall_deadline,
       VLOG(1) << "no authz token for table " << table_->id();
     }
   }
-  ScanRpcStatus scan_status = AnalyzeResponse(
-      proxy_->Scan(next_req_,
-                   &last_response_,
-                   &controller_),
-      rpc_deadline, overall_deadline);
+  return rpc_deadline;
+}
+
+ScanRpcStatus KuduScanner::Data::FinishScanRpc(const Status& rpc_status,
+                                               const MonoTime& rpc_deadline,
+                                               const MonoTime& overall_deadline) {
+  ScanRpcStatus scan_status = AnalyzeResponse(rpc_status, rpc_deadline, overall_deadline);
   if (scan_status.result == ScanRpcStatus::OK) {
     UpdateResourceMetrics();
     num_rows_returned_ += last_response_.has_data() ? last_response_.data().num_rows() : 0;
@@ -408,6 +708,9 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
   next_req_.clear_scanner_id();
   NewScanRequestPB* scan = next_req_.mutable_new_scan_request();
   scan->set_row_format_flags(configuration_.row_format_flags());
+  if (configuration_.columnar_compression() != NO_COMPRESSION) {
+    scan->set_columnar_compression(configuration_.columnar_compression());
+  }
   const KuduScanner::ReadMode read_mode = configuration_.read_mode();
   switch (read_mode) {
     case KuduScanner::READ_LATEST:
@@ -474,12 +777,6 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
     scan->set_propagated_timestamp(ts);
   }
 
-  // Set up the predicates.
-  scan->clear_column_predicates();
-  for (const auto& col_pred : configuration_.spec().predicates()) {
-    ColumnPredicateToPB(col_pred.second, scan->add_column_predicates());
-  }
-
   if (configuration_.spec().lower_bound_key()) {
     scan->mutable_start_primary_key()->assign(
       reinterpret_cast<const char*>(configuration_.spec().lower_bound_key()->encoded_key().data()),
@@ -525,6 +822,17 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
 
     scan->set_tablet_id(remote_->tablet_id());
 
+    // Set up the predicates. The IN-lists on hash columns only need the
+    // values which hash to the tablet.
+    scan->clear_column_predicates();
+    for (const auto& col_pred : configuration_.spec().predicates()) {
+      ColumnPredicateToPB(PartitionPruner::TrimInListPredicate(*table_->schema().schema_,
+                                                               table_->partition_schema(),
+                                                               remote_->partition(),
+                                                               col_pred.second),
+                          scan->add_column_predicates());
+    }
+
     RemoteTabletServer *ts;
     vector<RemoteTabletServer*> candidates;
     Status lookup_status = table_->client()->data_->GetTabletServer(
@@ -557,7 +865,8 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
     proxy_ = ts_->proxy();
 
     bool allow_time_for_failover = candidates.size() > blacklist->size() + 1;
-    ScanRpcStatus scan_status = SendScanRpc(deadline, allow_time_for_failover);
+    ScanRpcStatus scan_status = SendOpenScanRpc(deadline, allow_time_for_failover,
+                                                candidates, *blacklist);
     if (scan_status.result == ScanRpcStatus::OK) {
       last_error_ = Status::OK();
       scan_attempts_ = 0;
@@ -618,6 +927,10 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
 
 Status KuduScanner::Data::KeepAlive() {
   if (!open_) return Status::IllegalState("Scanner was not open.");
+  // An outstanding prefetch keeps the scanner alive by itself.
+  if (prefetch_in_flight_) {
+    return Status::OK();
+  }
   // If there is no scanner to keep alive, we still return Status::OK().
   if (!last_response_.IsInitialized() || !last_response_.has_more_results() ||
       !next_req_.has_scanner_id()) {
@@ -784,6 +1097,7 @@ Status KuduColumnarScanBatch::Data::Reset(
   controller_.Swap(controller);
   projection_ = projection;
   client_projection_ = client_projection;
+  row_format_flags_ = row_format_flags;
 
   unique_ptr<ColumnarRowBlockPB> resp_data(response->release_columnar_data());
   if (!resp_data) {
@@ -792,11 +1106,59 @@ Status KuduColumnarScanBatch::Data::Reset(
     return Status::OK();
   }
   resp_data_ = std::move(*resp_data);
+  uncompressed_sidecars_.clear();
+  if (!resp_data_.has_compression() || resp_data_.compression() == NO_COMPRESSION) {
+    return Status::OK();
+  }
+  const CompressionCodec* codec;
+  RETURN_NOT_OK_PREPEND(GetCompressionCodec(resp_data_.compression(), &codec),
+                        "server sent columnar data with an unsupported compression codec");
+  for (const auto& col : resp_data_.columns()) {
+    if (col.has_data_uncompressed_size()) {
+      RETURN_NOT_OK(DecompressSidecar(*codec, col.data_sidecar(),
+                                      col.data_uncompressed_size()));
+    }
+    if (col.has_varlen_data_uncompressed_size()) {
+      RETURN_NOT_OK(DecompressSidecar(*codec, col.varlen_data_sidecar(),
+                                      col.varlen_data_uncompressed_size()));
+    }
+    if (col.has_non_null_bitmap_uncompressed_size()) {
+      RETURN_NOT_OK(DecompressSidecar(*codec, col.non_null_bitmap_sidecar(),
+                                      col.non_null_bitmap_uncompressed_size()));
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::DecompressSidecar(const CompressionCodec& codec,
+                                                       int idx,
+                                                       int64_t uncompressed_size) {
+  if (PREDICT_FALSE(uncompressed_size < 0)) {
+    return Status::Corruption(Substitute("invalid uncompressed size $0 for sidecar $1",
+                                         uncompressed_size, idx));
+  }
+  Slice compressed;
+  RETURN_NOT_OK(controller_.GetInboundSidecar(idx, &compressed));
+  faststring uncompressed;
+  uncompressed.resize(uncompressed_size);
+  RETURN_NOT_OK_PREPEND(codec.Uncompress(compressed, uncompressed.data(), uncompressed_size),
+                        Substitute("unable to decompress sidecar $0", idx));
+  uncompressed_sidecars_[idx] = std::move(uncompressed);
   return Status::OK();
 }
 
+Status KuduColumnarScanBatch::Data::GetSidecar(int idx, Slice* data) const {
+  const faststring* uncompressed = FindOrNull(uncompressed_sidecars_, idx);
+  if (uncompressed) {
+    *data = Slice(*uncompressed);
+    return Status::OK();
+  }
+  return controller_.GetInboundSidecar(idx, data);
+}
+
 void KuduColumnarScanBatch::Data::Clear() {
   resp_data_.Clear();
+  uncompressed_sidecars_.clear();
   controller_.Reset();
 }
 
@@ -819,11 +1181,13 @@ Status KuduColumnarScanBatch::Data::GetFixedLengthColumn(int idx, Slice* data) c
   if (PREDICT_FALSE(!resp_data_.columns(idx).has_data_sidecar())) {
     return Status::Corruption("server did not send data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_data_.columns(idx).data_sidecar(),
-      data));
+  RETURN_NOT_OK(GetSidecar(resp_data_.columns(idx).data_sidecar(), data));
 
   size_t expected_size = resp_data_.num_rows() * col.type_info()->size();
+  if (col.type_info()->physical_type() == BOOL &&
+      (row_format_flags_ & KuduScanner::ARROW_LAYOUT)) {
+    expected_size = BitmapSize(resp_data_.num_rows());
+  }
   if (PREDICT_FALSE(data->size() != expected_size)) {
     return Status::Corruption(Substitute(
         "server sent unexpected data length $0 for column $1 (expected $2)",
@@ -846,18 +1210,14 @@ Status KuduColumnarScanBatch::Data::GetVariableLengthColumn(
   if (PREDICT_FALSE(!resp_col.has_data_sidecar())) {
     return Status::Corruption("server did not send offset data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_col.data_sidecar(),
-      &offsets_tmp));
+  RETURN_NOT_OK(GetSidecar(resp_col.data_sidecar(), &offsets_tmp));
 
   // Get the varlen data.
   Slice data_tmp;
   if (PREDICT_FALSE(!resp_col.has_varlen_data_sidecar())) {
     return Status::Corruption("server did not send varlen data for column", col.ToString());
   }
-  RETURN_NOT_OK(controller_.GetInboundSidecar(
-      resp_col.varlen_data_sidecar(),
-      &data_tmp));
+  RETURN_NOT_OK(GetSidecar(resp_col.varlen_data_sidecar(), &data_tmp));
 
   // Validate the offsets.
   auto expected_num_offsets = resp_data_.num_rows() == 0 ? 0 : (resp_data_.num_rows() + 1);
@@ -889,7 +1249,7 @@ Status KuduColumnarScanBatch::Data::GetNonNullBitmapForColumn(int idx, Slice* da
     return Status::Corruption(Substitute("server did not send null bitmap for column $0",
                                          projection_->column(idx).ToString()));
   }
-  return controller_.GetInboundSidecar(col.non_null_bitmap_sidecar(), data);
+  return GetSidecar(col.non_null_bitmap_sidecar(), data);
 }
 
 
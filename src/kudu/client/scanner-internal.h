@@ -23,6 +23,7 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -40,11 +41,15 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
+class CompressionCodec;
 class MonoTime;
 class Schema;
 
@@ -133,6 +138,26 @@ class KuduScanner::Data {
   // The RPC and TS proxy should already have been prepared in next_req_, proxy_, etc.
   ScanRpcStatus SendScanRpc(const MonoTime& overall_deadline, bool allow_time_for_failover);
 
+  // Like SendScanRpc(), for the request opening the scan of a tablet. If
+  // hedging is enabled and 'ts_' doesn't respond in time, the request is also
+  // sent to one of the other 'candidates' which aren't in 'blacklist'. The
+  // scan then goes on with whichever replica answers successfully first, and
+  // 'ts_' and 'proxy_' are updated accordingly.
+  ScanRpcStatus SendOpenScanRpc(const MonoTime& overall_deadline,
+                                bool allow_time_for_failover,
+                                const std::vector<internal::RemoteTabletServer*>& candidates,
+                                const std::set<std::string>& blacklist);
+
+  // If prefetching is enabled and the current tablet has more results, sends
+  // the continuation of the scan asynchronously into 'controller_' and
+  // 'last_response_'. Must be called only once the previous response has been
+  // handed to a batch.
+  void StartPrefetch();
+
+  // Waits for the RPC sent by StartPrefetch() and analyzes its response the
+  // way SendScanRpc() does.
+  ScanRpcStatus FinishPrefetch();
+
   // Called when KuduScanner::NextBatch or KuduScanner::Data::OpenTablet result in an RPC or
   // server error.
   //
@@ -193,6 +218,17 @@ class KuduScanner::Data {
   // Modifies fields in 'next_req_' in preparation for a new request.
   void PrepareRequest(RequestType state);
 
+  // Resets 'controller_' for the next scan RPC, attaching the required server
+  // features and, for new scans, the authz token. Returns the deadline of the
+  // RPC, computed as described for SendScanRpc().
+  MonoTime PrepareScanRpc(const MonoTime& overall_deadline, bool allow_time_for_failover);
+
+  // Analyzes the outcome of the scan RPC that was prepared by PrepareScanRpc(),
+  // accounting for the rows and resource metrics of a successful response.
+  ScanRpcStatus FinishScanRpc(const Status& rpc_status,
+                              const MonoTime& rpc_deadline,
+                              const MonoTime& overall_deadline);
+
   // Update 'last_error_' if need be. Should be invoked whenever a
   // non-fatal (i.e. retriable) scan error is encountered.
   void UpdateLastError(const Status& error);
@@ -234,6 +270,18 @@ class KuduScanner::Data {
   // RPC controller for the last in-flight RPC.
   rpc::RpcController controller_;
 
+  // Whether a prefetch sent by StartPrefetch() hasn't been collected by
+  // FinishPrefetch() yet. While it is set, the reactor may be writing into
+  // 'controller_' and 'last_response_'.
+  bool prefetch_in_flight_;
+
+  // Counted down when the prefetch RPC completes.
+  CountDownLatch prefetch_latch_;
+
+  // The deadlines of the prefetch RPC and of the batch it fetches.
+  MonoTime prefetch_rpc_deadline_;
+  MonoTime prefetch_deadline_;
+
   // The table we're scanning.
   sp::shared_ptr<KuduTable> table_;
 
@@ -384,6 +432,13 @@ class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
  private:
   Status CheckColumnIndex(int idx) const;
 
+  // Decompresses sidecar 'idx' of the response into 'uncompressed_sidecars_'.
+  Status DecompressSidecar(const CompressionCodec& codec, int idx, int64_t uncompressed_size);
+
+  // Returns the data of sidecar 'idx' of the response, decompressed if the
+  // server compressed it.
+  Status GetSidecar(int idx, Slice* data) const;
+
   friend class KuduColumnarScanBatch;
 
   // The RPC controller for the RPC which returned this batch.
@@ -394,10 +449,17 @@ class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
   // The PB which contains the "direct data" slice.
   ColumnarRowBlockPB resp_data_;
 
+  // The decompressed contents of the sidecars the server compressed, keyed
+  // by sidecar index.
+  std::unordered_map<int, faststring> uncompressed_sidecars_;
+
   // The projection being scanned.
   const Schema* projection_;
   // The KuduSchema version of 'projection_'
   const KuduSchema* client_projection_;
+
+  // The row format flags the batch was requested with.
+  uint64_t row_format_flags_ = 0;
 };
 
 
@@ -77,6 +77,8 @@ kudu::EncodingType ToInternalEncodingType(KuduColumnStorageAttributes::EncodingT
     case KuduColumnStorageAttributes::GROUP_VARINT: return kudu::GROUP_VARINT;
     case KuduColumnStorageAttributes::RLE: return kudu::RLE;
     case KuduColumnStorageAttributes::BIT_SHUFFLE: return kudu::BIT_SHUFFLE;
+    case KuduColumnStorageAttributes::FOR_BITPACK: return kudu::FOR_BITPACK;
+    case KuduColumnStorageAttributes::FSST_ENCODING: return kudu::FSST_ENCODING;
     default: LOG(FATAL) << "Unexpected encoding type: " << type;
   }
 }
@@ -90,6 +92,8 @@ KuduColumnStorageAttributes::EncodingType FromInternalEncodingType(kudu::Encodin
     case kudu::GROUP_VARINT: return KuduColumnStorageAttributes::GROUP_VARINT;
     case kudu::RLE: return KuduColumnStorageAttributes::RLE;
     case kudu::BIT_SHUFFLE: return KuduColumnStorageAttributes::BIT_SHUFFLE;
+    case kudu::FOR_BITPACK: return KuduColumnStorageAttributes::FOR_BITPACK;
+    case kudu::FSST_ENCODING: return KuduColumnStorageAttributes::FSST_ENCODING;
     default: LOG(FATAL) << "Unexpected internal encoding type: " << type;
   }
 }
@@ -239,6 +243,10 @@ Status KuduColumnStorageAttributes::StringToEncodingType(
     *type = KuduColumnStorageAttributes::DICT_ENCODING;
   } else if (encoding_uc == "BIT_SHUFFLE") {
     *type = KuduColumnStorageAttributes::BIT_SHUFFLE;
+  } else if (encoding_uc == "FOR_BITPACK") {
+    *type = KuduColumnStorageAttributes::FOR_BITPACK;
+  } else if (encoding_uc == "FSST_ENCODING") {
+    *type = KuduColumnStorageAttributes::FSST_ENCODING;
   } else if (encoding_uc == "GROUP_VARINT") {
     *type = KuduColumnStorageAttributes::GROUP_VARINT;
   } else {
@@ -57,9 +57,11 @@ class GetTableSchemaRpc;
 class LookupRpc;
 class MetaCache;
 class MetaCacheEntry;
+class MultiGetter;
 class WriteRpc;
 } // namespace internal
 
+class KuduColumnarWriteBatch;
 class KuduSchema;
 class KuduValue;
 
@@ -133,6 +135,8 @@ class KUDU_EXPORT KuduColumnStorageAttributes {
     RLE = 4,
     DICT_ENCODING = 5,
     BIT_SHUFFLE = 6,
+    FOR_BITPACK = 7,
+    FSST_ENCODING = 8,
 
     /// @deprecated GROUP_VARINT is not supported for valid types, and
     /// will fall back to another encoding on the server side.
@@ -709,6 +713,7 @@ class KUDU_EXPORT KuduSchema {
   friend class internal::LookupRpc;
   friend class internal::MetaCache;
   friend class internal::MetaCacheEntry;
+  friend class internal::MultiGetter;
   friend class internal::WriteRpc;
   friend class tools::RemoteKsckCluster;
   friend class tools::ReplicaDumper;
@@ -17,6 +17,7 @@
 
 #include "kudu/client/session-internal.h"
 
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <utility>
@@ -44,12 +45,86 @@ using rpc::Messenger;
 
 namespace client {
 
+using internal::AdaptiveFlushController;
 using internal::Batcher;
 using internal::ErrorCollector;
 
 using sp::shared_ptr;
 using sp::weak_ptr;
 
+namespace internal {
+
+namespace {
+// Weight of the latest flush in the moving averages of latency and throughput.
+constexpr double kAdaptiveFlushAveragingWeight = 0.2;
+
+// The smallest the tuned watermark gets, as a fraction of the configured one.
+constexpr double kAdaptiveFlushMinWatermarkFraction = 1.0 / 16;
+
+// Flush latency above this multiple of the lowest one seen so far is taken
+// as a sign of the writes queueing up at the tablet servers.
+constexpr double kAdaptiveFlushLatencyThreshold = 2.0;
+
+// The lowest seen latency drifts up by this factor on every flush, so that it
+// follows lasting changes in the workload, e.g. wider rows.
+constexpr double kAdaptiveFlushMinLatencyDrift = 1.02;
+} // anonymous namespace
+
+AdaptiveFlushController::AdaptiveFlushController()
+    : watermark_fraction_(1.0),
+      latency_ms_(-1.0),
+      min_latency_ms_(0.0),
+      throughput_(0.0) {
+}
+
+void AdaptiveFlushController::BatchFlushed(int64_t bytes,
+                                           int64_t watermark,
+                                           const MonoDelta& latency) {
+  if (bytes <= 0) {
+    return;
+  }
+  const double latency_ms = std::max(latency.ToSeconds() * 1000, 0.001);
+  const double throughput = bytes / latency_ms;
+  if (latency_ms_ < 0) {
+    latency_ms_ = latency_ms;
+    min_latency_ms_ = latency_ms;
+    throughput_ = throughput;
+    return;
+  }
+  min_latency_ms_ = std::min(latency_ms, min_latency_ms_ * kAdaptiveFlushMinLatencyDrift);
+
+  if (latency_ms > kAdaptiveFlushLatencyThreshold * min_latency_ms_ &&
+      throughput < 0.9 * throughput_) {
+    // The writes waited longer without getting through any faster: back off.
+    watermark_fraction_ = std::max(watermark_fraction_ / 2,
+                                   kAdaptiveFlushMinWatermarkFraction);
+  } else if (bytes >= watermark) {
+    // The batch filled up and the tablet servers kept up with it: try larger
+    // batches.
+    watermark_fraction_ = std::min(watermark_fraction_ * 1.25, 1.0);
+  }
+  latency_ms_ += kAdaptiveFlushAveragingWeight * (latency_ms - latency_ms_);
+  throughput_ += kAdaptiveFlushAveragingWeight * (throughput - throughput_);
+}
+
+int64_t AdaptiveFlushController::Watermark(int64_t max_watermark) const {
+  return static_cast<int64_t>(max_watermark * watermark_fraction_);
+}
+
+MonoDelta AdaptiveFlushController::FlushInterval(const MonoDelta& max_interval) const {
+  if (latency_ms_ < 0) {
+    return max_interval;
+  }
+  // Holding back a partially filled batch for longer than a couple of flush
+  // round trips only adds latency: a batch flushed earlier would have
+  // completed by then.
+  const MonoDelta interval = MonoDelta::FromMicroseconds(
+      std::max<int64_t>(2 * latency_ms_ * 1000, 1000));
+  return std::min(interval, max_interval);
+}
+
+} // namespace internal
+
 
 KuduSession::Data::Data(shared_ptr<KuduClient> client,
                         std::weak_ptr<rpc::Messenger> messenger)
@@ -76,8 +151,13 @@ void KuduSession::Data::Init(weak_ptr<KuduSession> session) {
 
 void KuduSession::Data::FlushFinished(Batcher* batcher) {
   const int64_t bytes_flushed = batcher->buffer_bytes_used();
+  const MonoTime flush_start_time = batcher->flush_start_time();
   {
     std::lock_guard<Mutex> l(mutex_);
+    if (adaptive_flush_ && flush_start_time.Initialized()) {
+      adaptive_flush_->BatchFlushed(bytes_flushed, FlushWatermarkUnlocked(),
+                                    MonoTime::Now() - flush_start_time);
+    }
     buffer_bytes_used_ -= bytes_flushed;
     --batchers_num_;
     // The logic of KuduSession::ApplyWriteOp() needs to know
@@ -221,6 +301,24 @@ Status KuduSession::Data::SetMaxBatchersNum(unsigned int max_num) {
   return Status::OK();
 }
 
+Status KuduSession::Data::SetAdaptiveFlush(bool enable) {
+  std::lock_guard<Mutex> l(mutex_);
+  if (HasPendingOperationsUnlocked()) {
+    // NOTE: this is an artificial restriction.
+    return Status::IllegalState(
+        "Cannot change adaptive flushing when writes are buffered.");
+  }
+  // Thread-safety note: the adaptive_flush_ is accessed from the background
+  // flush thread and upon completion of flushed batchers, so it should be
+  // modified under protection.
+  if (!enable) {
+    adaptive_flush_.reset();
+  } else if (!adaptive_flush_) {
+    adaptive_flush_.reset(new AdaptiveFlushController());
+  }
+  return Status::OK();
+}
+
 void KuduSession::Data::SetTimeoutMillis(int timeout_ms) {
   if (timeout_ms < 0) {
     timeout_ms = 0;
@@ -441,6 +539,7 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
       FlushCurrentBatcher(max_size - required_size + 1, nullptr);
     }
   }
+  int64_t flush_watermark;
   {
     std::lock_guard<Mutex> l(mutex_);
     if (flush_mode == AUTO_FLUSH_BACKGROUND) {
@@ -490,11 +589,10 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
     }
     // Finally, update the buffer space usage.
     buffer_bytes_used_ += required_size;
+    flush_watermark = FlushWatermarkUnlocked();
   }
 
   if (flush_mode == AUTO_FLUSH_BACKGROUND) {
-    const size_t flush_watermark =
-        buffer_bytes_limit_ * buffer_watermark_pct_ / 100;
     // In AUTO_FLUSH_BACKGROUND mode it's necessary to flush the newly added
     // operations if the flush watermark is reached. The current batcher is
     // the exclusive and the only container for the newly added operations.
@@ -506,6 +604,12 @@ Status KuduSession::Data::ApplyWriteOp(KuduWriteOperation* write_op) {
   return Status::OK();
 }
 
+int64_t KuduSession::Data::FlushWatermarkUnlocked() const {
+  mutex_.AssertAcquired();
+  const int64_t watermark = buffer_bytes_limit_ * buffer_watermark_pct_ / 100;
+  return adaptive_flush_ ? adaptive_flush_->Watermark(watermark) : watermark;
+}
+
 void KuduSession::Data::TimeBasedFlushInit() {
   KuduSession::Data::TimeBasedFlushTask(
       Status::OK(), messenger_, session_, true);
@@ -541,7 +645,9 @@ void KuduSession::Data::TimeBasedFlushTask(
       data->flush_task_active_ = false;
       return;
     }
-    max_batcher_age = data->flush_interval_;
+    max_batcher_age = data->adaptive_flush_
+        ? data->adaptive_flush_->FlushInterval(data->flush_interval_)
+        : data->flush_interval_;
   }
 
   // Let's measure the age of a batcher as the time elapsed from the moment
@@ -45,6 +45,56 @@ namespace client {
 class KuduStatusCallback;
 class KuduWriteOperation;
 
+namespace internal {
+
+// Tunes the flush watermark and the time-based flush interval of an
+// AUTO_FLUSH_BACKGROUND session from the observed latency of its flushes.
+//
+// By Little's law, the amount of data in flight is the write throughput times
+// the flush latency. As long as larger batches come with a proportionally
+// higher throughput, the tablet servers keep up with them and the watermark
+// is grown. Once the latency climbs well above the best seen so far without
+// any gain in throughput, the writes are queueing up at the tablet servers
+// (or being rejected under memory pressure and retried), so the watermark is
+// cut back.
+//
+// The controller works in terms of fractions of the configured watermark
+// and interval, so that it stays valid if those are changed.
+//
+// This class is not thread-safe.
+class AdaptiveFlushController {
+ public:
+  AdaptiveFlushController();
+
+  // Records that a batch of 'bytes' took 'latency' to flush, having been
+  // accumulated up to the given watermark.
+  void BatchFlushed(int64_t bytes, int64_t watermark, const MonoDelta& latency);
+
+  // Returns the watermark to flush at, given the configured one.
+  int64_t Watermark(int64_t max_watermark) const;
+
+  // Returns the interval of the time-based flushing, given the configured one.
+  MonoDelta FlushInterval(const MonoDelta& max_interval) const;
+
+ private:
+  // The tuned watermark, as a fraction of the configured one.
+  double watermark_fraction_;
+
+  // Moving average of the flush latency, in milliseconds. Negative until the
+  // first batch has been flushed.
+  double latency_ms_;
+
+  // The lowest flush latency seen so far, in milliseconds.
+  double min_latency_ms_;
+
+  // Moving average of the flush throughput, in bytes per millisecond.
+  double throughput_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdaptiveFlushController);
+};
+
+} // namespace internal
+
 // This class contains the code to do the heavy-lifting for the
 // kudu::KuduSession-related operations. Its interface does not assume
 // thread-safety in general, but it's thread-safe regarding the following
@@ -93,6 +143,9 @@ class KuduSession::Data {
   // Set the limit on maximum number of batchers with pending operations.
   Status SetMaxBatchersNum(unsigned int period_ms);
 
+  // Enable or disable adaptive tuning of the flush watermark and interval.
+  Status SetAdaptiveFlush(bool enable);
+
   // Set timeout for write operations, in milliseconds.
   void SetTimeoutMillis(int timeout_ms);
 
@@ -133,6 +186,10 @@ class KuduSession::Data {
   // Apply a write operation, i.e. push it through the batcher chain.
   Status ApplyWriteOp(KuduWriteOperation* write_op);
 
+  // Get the watermark at which to flush the current batcher in
+  // AUTO_FLUSH_BACKGROUND mode, in bytes.
+  int64_t FlushWatermarkUnlocked() const;
+
   // Check and start the time-based flush task in background, if necessary.
   void TimeBasedFlushInit();
 
@@ -241,6 +298,10 @@ class KuduSession::Data {
   // The total number of bytes used by buffered write operations.
   int64_t buffer_bytes_used_;  // protected by mutex_
 
+  // Tunes the flush watermark and interval if adaptive flushing is enabled;
+  // null otherwise.
+  std::unique_ptr<internal::AdaptiveFlushController> adaptive_flush_; // protected by mutex_
+
  private:
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundApplyBlocks);
   FRIEND_TEST(ClientTest, TestAutoFlushBackgroundAndErrorCollector);
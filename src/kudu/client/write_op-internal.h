@@ -17,8 +17,19 @@
 #ifndef KUDU_CLIENT_WRITE_OP_INTERNAL_H
 #define KUDU_CLIENT_WRITE_OP_INTERNAL_H
 
+#include <stdint.h>
+
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/client/schema.h"
+#include "kudu/client/shared_ptr.h" // IWYU pragma: keep
 #include "kudu/client/write_op.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 
 namespace kudu {
 
@@ -26,6 +37,55 @@ namespace client {
 
 RowOperationsPB_Type ToInternalWriteType(KuduWriteOperation::Type type);
 
+class KuduColumnarWriteBatch::Data {
+ public:
+  struct Column {
+    Column() : is_set(false) {}
+
+    // Returns true if the cell at 'row_idx' is null.
+    bool IsNull(int row_idx) const {
+      return !non_null_bitmap.empty() && !BitmapTest(non_null_bitmap.data(), row_idx);
+    }
+
+    // Returns a pointer to the cell at 'row_idx' of a fixed-length column
+    // whose cells are 'cell_size' bytes each.
+    const uint8_t* FixedLengthCell(int row_idx, size_t cell_size) const {
+      return data.data() + row_idx * cell_size;
+    }
+
+    // Returns the cell at 'row_idx' of a variable-length column.
+    Slice VariableLengthCell(int row_idx) const {
+      const uint8_t* cell_offsets = offsets.data() + row_idx * sizeof(uint32_t);
+      uint32_t start = UNALIGNED_LOAD32(cell_offsets);
+      uint32_t end = UNALIGNED_LOAD32(cell_offsets + sizeof(uint32_t));
+      return Slice(data.data() + start, end - start);
+    }
+
+    bool is_set;
+    Slice data;
+    // Only used for variable-length columns.
+    Slice offsets;
+    // Empty if all of the cells are non-null.
+    Slice non_null_bitmap;
+  };
+
+  Data(const sp::shared_ptr<KuduTable>& table, KuduWriteOperation::Type type, int num_rows)
+      : table_(table),
+        type_(type),
+        num_rows_(num_rows),
+        columns_(table->schema().num_columns()) {
+  }
+
+  // Check that 'idx' refers to a column of the expected kind and that
+  // 'non_null_bitmap' is valid for it.
+  Status CheckColumn(int idx, bool var_length, const Slice& non_null_bitmap) const;
+
+  const sp::shared_ptr<KuduTable> table_;
+  const KuduWriteOperation::Type type_;
+  const int num_rows_;
+  std::vector<Column> columns_;
+};
+
 } // namespace client
 } // namespace kudu
 
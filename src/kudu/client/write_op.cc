@@ -17,29 +17,36 @@
 
 #include "kudu/client/write_op.h"
 
+#include <cstring>
 #include <ostream>
+#include <vector>
 
 #include <glog/logging.h>
 
 #include "kudu/client/client.h"
 #include "kudu/client/schema.h"
+#include "kudu/client/write_op-internal.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/row.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/slice.h"
 
 using kudu::client::sp::shared_ptr;
 using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace client {
 
 RowOperationsPB_Type ToInternalWriteType(KuduWriteOperation::Type type) {
-  switch (type) {
+  switch (data_->type_) {
     case KuduWriteOperation::INSERT: return RowOperationsPB_Type_INSERT;
     case KuduWriteOperation::UPDATE: return RowOperationsPB_Type_UPDATE;
     case KuduWriteOperation::DELETE: return RowOperationsPB_Type_DELETE;
@@ -138,6 +145,154 @@ KuduUpsert::KuduUpsert(const shared_ptr<KuduTable>& table)
 
 KuduUpsert::~KuduUpsert() {}
 
+// ColumnarWriteBatch -----------------------------------------------------------
+
+Status KuduColumnarWriteBatch::Data::CheckColumn(int idx, bool var_length,
+                                                const Slice& non_null_bitmap) const {
+  const Schema* schema = table_->schema().schema_;
+  if (PREDICT_FALSE(idx < 0 || idx >= schema->num_columns())) {
+    return Status::InvalidArgument(Substitute("invalid column index $0", idx));
+  }
+  const ColumnSchema& col = schema->column(idx);
+  if (PREDICT_FALSE((col.type_info()->physical_type() == BINARY) != var_length)) {
+    return Status::InvalidArgument(
+        Substitute("column '$0' is $1-length", col.name(), var_length ? "fixed" : "variable"));
+  }
+  if (non_null_bitmap.empty()) {
+    return Status::OK();
+  }
+  if (PREDICT_FALSE(!col.is_nullable())) {
+    return Status::InvalidArgument("column not nullable", col.ToString());
+  }
+  if (PREDICT_FALSE(non_null_bitmap.size() < BitmapSize(num_rows_))) {
+    return Status::InvalidArgument(
+        Substitute("non-null bitmap for column '$0' is too short: $1 bytes for $2 rows",
+                   col.name(), non_null_bitmap.size(), num_rows_));
+  }
+  return Status::OK();
+}
+
+KuduColumnarWriteBatch::KuduColumnarWriteBatch(const shared_ptr<KuduTable>& table,
+                                               KuduWriteOperation::Type type,
+                                               int num_rows)
+    : data_(new Data(table, type, num_rows)) {
+  CHECK_GE(num_rows, 0);
+}
+
+KuduColumnarWriteBatch::~KuduColumnarWriteBatch() {
+  delete data_;
+}
+
+int KuduColumnarWriteBatch::NumRows() const {
+  return data_->num_rows_;
+}
+
+Status KuduColumnarWriteBatch::SetFixedLengthColumn(int idx, const Slice& data,
+                                                    const Slice& non_null_bitmap) {
+  RETURN_NOT_OK(data_->CheckColumn(idx, false, non_null_bitmap));
+  const ColumnSchema& col = data_->table_->schema().schema_->column(idx);
+  size_t expected_size = static_cast<size_t>(data_->num_rows_) * col.type_info()->size();
+  if (PREDICT_FALSE(data.size() != expected_size)) {
+    return Status::InvalidArgument(
+        Substitute("data for column '$0' has unexpected size: $1 bytes (expected $2)",
+                   col.name(), data.size(), expected_size));
+  }
+  Data::Column* c = &data_->columns_[idx];
+  c->is_set = true;
+  c->data = data;
+  c->offsets = Slice();
+  c->non_null_bitmap = non_null_bitmap;
+  return Status::OK();
+}
+
+Status KuduColumnarWriteBatch::SetVariableLengthColumn(int idx, const Slice& offsets,
+                                                       const Slice& data,
+                                                       const Slice& non_null_bitmap) {
+  RETURN_NOT_OK(data_->CheckColumn(idx, true, non_null_bitmap));
+  const ColumnSchema& col = data_->table_->schema().schema_->column(idx);
+  const int num_rows = data_->num_rows_;
+  if (num_rows > 0) {
+    size_t expected_size = (static_cast<size_t>(num_rows) + 1) * sizeof(uint32_t);
+    if (PREDICT_FALSE(offsets.size() != expected_size)) {
+      return Status::InvalidArgument(
+          Substitute("offsets for column '$0' have unexpected size: $1 bytes (expected $2)",
+                     col.name(), offsets.size(), expected_size));
+    }
+    // Validate the offsets once here so that building the rows doesn't need to.
+    uint32_t prev = UNALIGNED_LOAD32(offsets.data());
+    for (int i = 1; i <= num_rows; i++) {
+      uint32_t cur = UNALIGNED_LOAD32(offsets.data() + i * sizeof(uint32_t));
+      if (PREDICT_FALSE(cur < prev)) {
+        return Status::InvalidArgument(
+            Substitute("offsets for column '$0' are not monotonic at row $1", col.name(), i - 1));
+      }
+      prev = cur;
+    }
+    if (PREDICT_FALSE(prev > data.size())) {
+      return Status::InvalidArgument(
+          Substitute("offsets for column '$0' point past the end of its data: $1 > $2",
+                     col.name(), prev, data.size()));
+    }
+  }
+  Data::Column* c = &data_->columns_[idx];
+  c->is_set = true;
+  c->data = data;
+  c->offsets = offsets;
+  c->non_null_bitmap = non_null_bitmap;
+  return Status::OK();
+}
+
+Status KuduColumnarWriteBatch::NewOperation(int row_idx, KuduWriteOperation** op) const {
+  DCHECK_GE(row_idx, 0);
+  DCHECK_LT(row_idx, data_->num_rows_);
+  KuduTable* table = data_->table_.get();
+  unique_ptr<KuduWriteOperation> new_op;
+  switch (type) {
+    case KuduWriteOperation::INSERT: new_op.reset(table->NewInsert()); break;
+    case KuduWriteOperation::UPDATE: new_op.reset(table->NewUpdate()); break;
+    case KuduWriteOperation::DELETE: new_op.reset(table->NewDelete()); break;
+    case KuduWriteOperation::UPSERT: new_op.reset(table->NewUpsert()); break;
+    case KuduWriteOperation::INSERT_IGNORE: new_op.reset(table->NewInsertIgnore()); break;
+    default:
+      return Status::InvalidArgument(Substitute("unexpected write operation type: $0", data_->type_));
+  }
+
+  // Since the column types and sizes were validated when the columns were
+  // set, copy the cells straight into the row's storage rather than going
+  // through the per-cell type checks of the KuduPartialRow setters.
+  KuduPartialRow* row = new_op->mutable_row();
+  const Schema* schema = row->schema();
+  ContiguousRow dst(schema, row->row_data_);
+  const int num_columns = data_->columns_.size();
+  for (int i = 0; i < num_columns; i++) {
+    const Data::Column& c = data_->columns_[i];
+    if (!c.is_set) {
+      continue;
+    }
+    const ColumnSchema& col = schema->column(i);
+    BitmapSet(row->isset_bitmap_, i);
+    if (c.IsNull(row_idx)) {
+      dst.set_null(i, true);
+      continue;
+    }
+    if (col.is_nullable()) {
+      dst.set_null(i, false);
+    }
+    if (c.offsets.empty()) {
+      size_t size = col.type_info()->size();
+      memcpy(dst.mutable_cell_ptr(i), c.FixedLengthCell(row_idx, size), size);
+    } else {
+      Slice cell = c.VariableLengthCell(row_idx);
+      uint8_t* copy = new uint8_t[cell.size()];
+      memcpy(copy, cell.data(), cell.size());
+      *reinterpret_cast<Slice*>(dst.mutable_cell_ptr(i)) = Slice(copy, cell.size());
+      BitmapSet(row->owned_strings_bitmap_, i);
+    }
+  }
+  *op = new_op.release();
+  return Status::OK();
+}
+
 
 } // namespace client
 } // namespace kudu
@@ -25,6 +25,8 @@
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
 #include "kudu/common/partial_row.h"
 #include "kudu/util/kudu_export.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 
 #ifdef KUDU_HEADERS_NO_STUBS
 #include "kudu/gutil/macros.h"
@@ -270,6 +272,92 @@ class KUDU_EXPORT KuduDelete : public KuduWriteOperation {
   explicit KuduDelete(const sp::shared_ptr<KuduTable>& table);
 };
 
+/// @brief A batch of rows to be written, given column by column.
+///
+/// The column data uses the same layout as KuduColumnarScanBatch: each
+/// fixed-length column is a little-endian packed array of cells, and each
+/// variable-length column is an array of NumRows() + 1 uint32_t offsets into
+/// a separate data array. Optionally, a column may come with a bitmap in
+/// which a set bit indicates a non-null cell.
+///
+/// The batch does not copy the column data: the memory referenced by the
+/// Slices passed to the setters must stay valid until the batch has been
+/// passed to KuduSession::ApplyColumnar(). Columns which are not set are
+/// left unset in every row, as with KuduPartialRow.
+///
+/// Typical usage example:
+/// @code
+///   KuduColumnarWriteBatch batch(table, KuduWriteOperation::INSERT, num_rows);
+///   KUDU_CHECK_OK(batch.SetFixedLengthColumn(0, Slice(keys, num_rows * 4)));
+///   KUDU_CHECK_OK(batch.SetVariableLengthColumn(1, offsets, strings));
+///   KUDU_CHECK_OK(session->ApplyColumnar(batch));
+/// @endcode
+///
+/// NOTE: this class is not thread-safe.
+class KUDU_EXPORT KuduColumnarWriteBatch {
+ public:
+  /// Create a batch of rows for the given table.
+  ///
+  /// @param [in] table
+  ///   The table to write the rows into.
+  /// @param [in] type
+  ///   The type of write operation to apply to every row of the batch.
+  /// @param [in] num_rows
+  ///   The number of rows in the batch.
+  KuduColumnarWriteBatch(const sp::shared_ptr<KuduTable>& table,
+                         KuduWriteOperation::Type type,
+                         int num_rows);
+  ~KuduColumnarWriteBatch();
+
+  /// @return The number of rows in this batch.
+  int NumRows() const;
+
+  /// Set the data for the fixed-length column with index 'idx'.
+  ///
+  /// @param [in] idx
+  ///   Index of the column in the table's schema.
+  /// @param [in] data
+  ///   NumRows() cells of the column's type, packed back to back. The
+  ///   contents of null cells are ignored.
+  /// @param [in] non_null_bitmap
+  ///   Optional bitmap of NumRows() bits in which a set bit marks a non-null
+  ///   cell. It may only be specified for nullable columns.
+  /// @return Operation result status.
+  Status SetFixedLengthColumn(int idx, const Slice& data,
+                              const Slice& non_null_bitmap = Slice()) WARN_UNUSED_RESULT;
+
+  /// Set the data for the variable-length (STRING, BINARY or VARCHAR) column
+  /// with index 'idx'. The cell values are copied into the rows.
+  ///
+  /// @param [in] idx
+  ///   Index of the column in the table's schema.
+  /// @param [in] offsets
+  ///   NumRows() + 1 uint32_t offsets into 'data'. The cell with index 'n'
+  ///   spans [offsets[n], offsets[n+1]).
+  /// @param [in] data
+  ///   The concatenated cell values.
+  /// @param [in] non_null_bitmap
+  ///   Optional bitmap of NumRows() bits in which a set bit marks a non-null
+  ///   cell. It may only be specified for nullable columns.
+  /// @return Operation result status.
+  Status SetVariableLengthColumn(int idx, const Slice& offsets, const Slice& data,
+                                 const Slice& non_null_bitmap = Slice()) WARN_UNUSED_RESULT;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+
+  friend class KuduPartitioner;
+  friend class KuduSession;
+
+  // Create a new write operation for row 'row_idx'.
+  //
+  // Caller takes ownership of the allocated memory.
+  Status NewOperation(int row_idx, KuduWriteOperation** op) const;
+
+  Data* data_;
+  DISALLOW_COPY_AND_ASSIGN(KuduColumnarWriteBatch);
+};
+
 } // namespace client
 } // namespace kudu
 
@@ -182,6 +182,45 @@ TEST_F(HybridClockTest, NowValuesIncreaseMonotonically) {
   ASSERT_LT(now1.value(), now2.value());
 }
 
+// Test that reserved timestamps are consecutive, and that they're all lower
+// than the ones generated afterwards.
+TEST_F(HybridClockTest, ReserveTimestamps) {
+  const int kNumTimestamps = 100;
+  const Timestamp before = clock_.Now();
+  Timestamp first;
+  uint64_t error;
+  ASSERT_OK(clock_.ReserveTimestamps(kNumTimestamps, &first, &error));
+  ASSERT_LT(before.value(), first.value());
+  const Timestamp after = clock_.Now();
+  ASSERT_LE(first.value() + kNumTimestamps, after.value());
+}
+
+// Test that the timestamps generated by concurrent threads are unique.
+TEST_F(HybridClockTest, ConcurrentTimestampsAreUnique) {
+  const int kNumThreads = 8;
+  const int kNumTimestampsPerThread = 10000;
+  vector<vector<uint64_t>> timestamps(kNumThreads);
+  vector<thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kNumTimestampsPerThread; j++) {
+        timestamps[i].push_back(clock_.Now().value());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  vector<uint64_t> all;
+  for (const auto& thread_timestamps : timestamps) {
+    // Each thread sees its timestamps increase.
+    ASSERT_TRUE(std::is_sorted(thread_timestamps.begin(), thread_timestamps.end()));
+    all.insert(all.end(), thread_timestamps.begin(), thread_timestamps.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+}
+
 // Tests the clock updates with the incoming value if it is higher.
 TEST_F(HybridClockTest, UpdateLogicalValueIncreasesByAmount) {
   Timestamp now = clock_.Now();
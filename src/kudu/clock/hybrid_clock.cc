@@ -18,6 +18,7 @@
 #include "kudu/clock/hybrid_clock.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -272,15 +273,13 @@ Status HybridClock::GetGlobalLatest(Timestamp* t) {
 }
 
 Status HybridClock::NowWithError(Timestamp* timestamp, uint64_t* max_error_usec) {
-  std::lock_guard<decltype(lock_)> lock(lock_);
-  return NowWithErrorUnlocked(timestamp, max_error_usec);
+  return ReserveTimestamps(1, timestamp, max_error_usec);
 }
 
 Status HybridClock::Update(const Timestamp& to_update) {
   Timestamp now;
   uint64_t error_ignored;
-  std::lock_guard<decltype(lock_)> lock(lock_);
-  RETURN_NOT_OK(NowWithErrorUnlocked(&now, &error_ignored));
+  RETURN_NOT_OK(NowWithError(&now, &error_ignored));
 
   // If the incoming message is in the past relative to our current
   // physical clock, there's nothing to do.
@@ -304,7 +303,11 @@ Status HybridClock::Update(const Timestamp& to_update) {
   }
 
   // Our next timestamp must be higher than the one that we are updating from.
-  next_timestamp_ = to_update.value() + 1;
+  // Other threads may have moved it even further meanwhile.
+  uint64_t next = next_timestamp_.load(std::memory_order_relaxed);
+  while (next <= to_update.value() &&
+         !next_timestamp_.compare_exchange_weak(next, to_update.value() + 1)) {
+  }
   return Status::OK();
 }
 
@@ -380,36 +383,30 @@ bool HybridClock::IsAfter(Timestamp t) {
     CHECK_OK_PREPEND(s, "unable to get current time with error bound");
   }
 
-  Timestamp now;
-  {
-    std::lock_guard<decltype(lock_)> lock(lock_);
-    now = Timestamp(std::max(next_timestamp_, now_usec << kBitsToShift));
-  }
+  Timestamp now(std::max(next_timestamp_.load(), now_usec << kBitsToShift));
   return t.value() < now.value();
 }
 
-Status HybridClock::NowWithErrorUnlocked(Timestamp *timestamp,
-                                         uint64_t *max_error_usec) {
-  DCHECK(lock_.is_locked());
-  DCHECK_EQ(state_, kInitialized) << "Clock not initialized. Must call Init() first.";
+Status HybridClock::ReserveTimestamps(int num_timestamps,
+                                      Timestamp* first_timestamp,
+                                      uint64_t* max_error_usec) {
+  DCHECK_EQ(state_.load(), kInitialized) << "Clock not initialized. Must call Init() first.";
+  DCHECK_GT(num_timestamps, 0);
 
   uint64_t now_usec;
   uint64_t error_usec;
   RETURN_NOT_OK(WalltimeWithError(&now_usec, &error_usec));
 
   // If the physical time from the system clock is higher than our last-returned
-  // time, we should use the physical timestamp.
-  uint64_t candidate_phys_timestamp = now_usec << kBitsToShift;
-  if (PREDICT_TRUE(candidate_phys_timestamp > next_timestamp_)) {
-    next_timestamp_ = candidate_phys_timestamp;
-    *timestamp = Timestamp(next_timestamp_++);
-    *max_error_usec = error_usec;
-    VLOG(2) << Substitute("Current clock is higher than the last one. "
-                          "Resetting logical values. Physical Value: $0 usec "
-                          "Logical Value: 0  Error: $1",
-                          now_usec, error_usec);
-    return Status::OK();
-  }
+  // time, we should use the physical timestamp. Otherwise, the timestamps
+  // follow the last-returned one, with increasing logical values.
+  const uint64_t candidate_phys_timestamp = now_usec << kBitsToShift;
+  uint64_t next = next_timestamp_.load(std::memory_order_relaxed);
+  uint64_t first;
+  do {
+    first = std::max(next, candidate_phys_timestamp);
+  } while (!next_timestamp_.compare_exchange_weak(next, first + num_timestamps));
+  *first_timestamp = Timestamp(first);
 
   // We don't have the last time read max error since it might have originated
   // in another machine, but we can put a bound on the maximum error of the
@@ -427,14 +424,11 @@ Status HybridClock::NowWithErrorUnlocked(Timestamp *timestamp,
   // Assuming, in the worst case, that the "true" time is now - error we need to
   // always return: last - (now - e) as the new maximum error.
   // This broadens the error interval for both cases but always returns
-  // a correct error interval.
-
-  *max_error_usec = (next_timestamp_ >> kBitsToShift) - (now_usec - error_usec);
-  *timestamp = Timestamp(next_timestamp_++);
-  VLOG(2) << Substitute("Current clock is lower than the last one. Returning "
-                        "last read and incrementing logical values. "
-                        "Clock: $0 Error: $1",
-                        Stringify(*timestamp), *max_error_usec);
+  // a correct error interval. When the physical timestamp is used, this is
+  // just the error of the clock reading.
+  *max_error_usec = (first >> kBitsToShift) - (now_usec - error_usec);
+  VLOG(2) << Substitute("Reserved $0 timestamp(s) from $1, error: $2",
+                        num_timestamps, Stringify(*first_timestamp), *max_error_usec);
   return Status::OK();
 }
 
@@ -520,7 +514,7 @@ Status HybridClock::SelectTimeSource(const string& time_source_str,
 
 Status HybridClock::InitWithTimeSource(TimeSource time_source,
                                        vector<HostPort> builtin_ntp_servers) {
-  DCHECK_EQ(kNotInitialized, state_);
+  DCHECK_EQ(kNotInitialized, state_.load());
 
   switch (time_source) {
     case TimeSource::NTP_SYNC_BUILTIN:
@@ -590,14 +584,11 @@ Status HybridClock::InitWithTimeSource(TimeSource time_source,
   LOG(INFO) << Substitute("HybridClock initialized: "
                           "now $0 us; error $1 us; skew $2 ppm",
                           now_usec, error_usec, time_service_->skew_ppm());
-  {
-    // We typically don't expect other threads to access an object until after
-    // its Init() is called, but there is nothing preventing some other thread
-    // accessing clock-related metrics via the metrics registry before Init()
-    // is called.
-    std::lock_guard<decltype(lock_)> lock(lock_);
-    state_ = kInitialized;
-  }
+  // We typically don't expect other threads to access an object until after
+  // its Init() is called, but there is nothing preventing some other thread
+  // accessing clock-related metrics via the metrics registry before Init()
+  // is called.
+  state_ = kInitialized;
 
   // Once the hybrid clock is initialized, it's safe to register/instantiate
   // function gauges. Otherwise, there might be an attempt to read the gauges'
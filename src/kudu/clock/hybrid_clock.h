@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -138,6 +139,14 @@ class HybridClock : public Clock {
   Status NowWithError(Timestamp* timestamp, uint64_t* max_error_usec)
       WARN_UNUSED_RESULT;
 
+  // Like NowWithError(), but reserves 'num_timestamps' consecutive timestamps
+  // at once, the first of which is set in 'first_timestamp'. All of them share
+  // the error bound set in 'max_error_usec'. This costs a single read of the
+  // underlying clock.
+  Status ReserveTimestamps(int num_timestamps,
+                           Timestamp* first_timestamp,
+                           uint64_t* max_error_usec) WARN_UNUSED_RESULT;
+
   // Static encoding/decoding methods for timestamps. Public mostly
   // for testing/debugging purposes.
 
@@ -212,9 +221,6 @@ class HybridClock : public Clock {
   Status InitWithTimeSource(TimeSource time_source,
                             std::vector<HostPort> builtin_ntp_servers);
 
-  // Variant of NowWithError() that requires 'lock_' to be held already.
-  Status NowWithErrorUnlocked(Timestamp* timestamp, uint64_t* max_error_usec);
-
   // Variant of NowWithError() that calls LOG(FATAL) if the clock is
   // unsynchronized or synchronized but the error is too high.
   void NowWithErrorOrDie(Timestamp* timestamp, uint64_t* max_error_usec);
@@ -235,13 +241,12 @@ class HybridClock : public Clock {
   // service.
   std::unique_ptr<clock::TimeService> time_service_;
 
-  // Guards access to 'state_' and 'next_timestamp_'.
-  simple_spinlock lock_;
-
   // The next timestamp to be generated from this clock, assuming that
   // the physical clock hasn't advanced beyond the value stored here.
-  // Protected by 'lock_'.
-  uint64_t next_timestamp_;
+  //
+  // Timestamps are allocated by compare-and-swap on this value, so that
+  // concurrent callers don't serialize on a lock.
+  std::atomic<uint64_t> next_timestamp_;
 
   // The last valid clock reading we got from the time source, along
   // with the monotime that we took that reading. The 'is_extrapolating' field
@@ -253,12 +258,12 @@ class HybridClock : public Clock {
   uint64_t last_clock_read_error_;
   bool is_extrapolating_ = false;
 
-  // The state of the object. Guarded by 'lock_'.
+  // The state of the object.
   enum State {
     kNotInitialized,
     kInitialized
   };
-  State state_;
+  std::atomic<State> state_;
 
   // Metric entity.
   scoped_refptr<MetricEntity> metric_entity_;
@@ -24,6 +24,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -40,6 +41,8 @@
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Target/TargetMachine.h>
 
+#include "kudu/codegen/insert_row_decoder.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/once.h"
@@ -79,6 +82,7 @@ using llvm::TargetMachine;
 using llvm::Triple;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 
@@ -227,5 +231,46 @@ Status CodeGenerator::CompileRowProjector(const Schema& base, const Schema& proj
   return Status::OK();
 }
 
+Status CodeGenerator::CompilePredicateEvaluator(const vector<ColumnPredicate>& predicates,
+                                                scoped_refptr<PredicateEvaluatorFunctions>* out) {
+  RETURN_NOT_OK(CheckCodegenEnabled());
+
+  TargetMachine* tm;
+  RETURN_NOT_OK(PredicateEvaluatorFunctions::Create(predicates, out, &tm));
+
+  if (FLAGS_codegen_dump_mc) {
+    static const int kInstrMax = 1500;
+    std::ostringstream sstr;
+    sstr << "Printing predicate evaluator function:\n";
+    int instrs = DumpAsm((*out)->eval(), *tm, &sstr, kInstrMax);
+    sstr << "Printed " << instrs << " instructions.";
+    LOG(INFO) << sstr.str();
+  }
+
+  return Status::OK();
+}
+
+Status CodeGenerator::CompileInsertRowDecoder(const Schema& client_schema,
+                                              const Schema& tablet_schema,
+                                              const vector<size_t>& client_to_tablet,
+                                              scoped_refptr<InsertRowDecoderFunctions>* out) {
+  RETURN_NOT_OK(CheckCodegenEnabled());
+
+  TargetMachine* tm;
+  RETURN_NOT_OK(InsertRowDecoderFunctions::Create(client_schema, tablet_schema,
+                                                  client_to_tablet, out, &tm));
+
+  if (FLAGS_codegen_dump_mc) {
+    static const int kInstrMax = 1500;
+    std::ostringstream sstr;
+    sstr << "Printing insert row decoder function:\n";
+    int instrs = DumpAsm((*out)->decode(), *tm, &sstr, kInstrMax);
+    sstr << "Printed " << instrs << " instructions.";
+    LOG(INFO) << sstr.str();
+  }
+
+  return Status::OK();
+}
+
 } // namespace codegen
 } // namespace kudu
@@ -18,6 +18,9 @@
 #ifndef KUDU_CODEGEN_CODE_GENERATOR_H
 #define KUDU_CODEGEN_CODE_GENERATOR_H
 
+#include <cstddef>
+#include <vector>
+
 #include "kudu/gutil/macros.h"
 #include "kudu/util/status.h"
 
@@ -26,10 +29,13 @@ class scoped_refptr;
 
 namespace kudu {
 
+class ColumnPredicate;
 class Schema;
 
 namespace codegen {
 
+class InsertRowDecoderFunctions;
+class PredicateEvaluatorFunctions;
 class RowProjectorFunctions;
 
 // CodeGenerator is a top-level class that manages a per-module
@@ -67,6 +73,20 @@ class CodeGenerator {
   Status CompileRowProjector(const Schema& base, const Schema& proj,
                              scoped_refptr<RowProjectorFunctions>* out);
 
+  // Attempts to initialize predicate evaluator functions by compiling code
+  // for the conjunction of the parameter predicates. Writes to 'out' upon
+  // success.
+  Status CompilePredicateEvaluator(const std::vector<ColumnPredicate>& predicates,
+                                   scoped_refptr<PredicateEvaluatorFunctions>* out);
+
+  // Attempts to initialize insert row decoder functions by compiling code
+  // for the parameter schemas and the mapping between them. Writes to 'out'
+  // upon success.
+  Status CompileInsertRowDecoder(const Schema& client_schema,
+                                 const Schema& tablet_schema,
+                                 const std::vector<size_t>& client_to_tablet,
+                                 scoped_refptr<InsertRowDecoderFunctions>* out);
+
  private:
   static void GlobalInit();
 
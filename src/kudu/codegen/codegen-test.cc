@@ -31,17 +31,30 @@
 
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/insert_row_decoder.h"
+#include "kudu/codegen/module_builder.h"
+#include "kudu/codegen/persistent_code_cache.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
+#include "kudu/common/partial_row.h"
 #include "kudu/common/row.h"
+#include "kudu/common/row_operations.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/wire_protocol.pb.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/singleton.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/env.h"
 #include "kudu/util/logging_test_util.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
@@ -53,6 +66,7 @@ using std::vector;
 
 DECLARE_bool(codegen_dump_mc);
 DECLARE_int32(codegen_cache_capacity);
+DECLARE_bool(codegen_row_operations_decoding);
 
 namespace kudu {
 
@@ -425,4 +439,196 @@ TEST_F(CodegenTest, TestCodeCache) {
   }
 }
 
+// Compares the selection of rows by a compiled predicate evaluator with the
+// selection by the predicates' own evaluation, over random data.
+TEST_F(CodegenTest, TestPredicateEvaluator) {
+  const int kNumRows = 1003; // not a multiple of 8, to exercise the tail
+  Schema schema({ ColumnSchema("i32", INT32, false),
+                  ColumnSchema("i64-null", INT64, true),
+                  ColumnSchema("u8", UINT8, false),
+                  ColumnSchema("dbl-null", DOUBLE, true) }, 1);
+  Arena arena(1024);
+  RowBlock block(&schema, kNumRows, &arena);
+  for (int col = 0; col < schema.num_columns(); col++) {
+    ColumnBlock cblock = block.column_block(col);
+    for (int row = 0; row < kNumRows; row++) {
+      // Draw from small ranges so that the predicates select some of the rows.
+      int32_t small = random_.Uniform(8);
+      switch (schema.column(col).type_info()->physical_type()) {
+        case INT32: {
+          int32_t v = small - 4;
+          cblock.SetCellValue(row, &v);
+          break;
+        }
+        case INT64: {
+          int64_t v = small - 4;
+          cblock.SetCellValue(row, &v);
+          break;
+        }
+        case UINT8: {
+          uint8_t v = small;
+          cblock.SetCellValue(row, &v);
+          break;
+        }
+        default: {
+          double v = small - 4;
+          cblock.SetCellValue(row, &v);
+          break;
+        }
+      }
+      if (cblock.is_nullable()) {
+        cblock.SetCellIsNull(row, random_.OneIn(4));
+      }
+    }
+  }
+
+  int32_t i32_lower = -2;
+  int64_t i64_value = 1;
+  uint8_t u8_upper = 6;
+  double dbl_lower = -3;
+  double dbl_upper = 2.5;
+  vector<vector<ColumnPredicate>> conjunctions = {
+    { ColumnPredicate::Range(schema.column(0), &i32_lower, nullptr) },
+    { ColumnPredicate::Equality(schema.column(1), &i64_value) },
+    { ColumnPredicate::IsNull(schema.column(1)),
+      ColumnPredicate::Range(schema.column(2), nullptr, &u8_upper) },
+    { ColumnPredicate::IsNotNull(schema.column(3)),
+      ColumnPredicate::Range(schema.column(0), &i32_lower, nullptr),
+      ColumnPredicate::Range(schema.column(3), &dbl_lower, &dbl_upper) },
+    { ColumnPredicate::None(schema.column(2)) },
+  };
+  for (const auto& predicates : conjunctions) {
+    SCOPED_TRACE(predicates.front().ToString());
+    scoped_refptr<codegen::PredicateEvaluatorFunctions> functions;
+    ASSERT_OK(generator_.CompilePredicateEvaluator(predicates, &functions));
+    codegen::PredicateEvaluator evaluator(schema, predicates, functions);
+
+    SelectionVector expected(kNumRows);
+    expected.SetAllTrue();
+    for (const auto& pred : predicates) {
+      pred.Evaluate(block.column_block(schema.find_column(pred.column().name())), &expected);
+    }
+
+    block.selection_vector()->SetAllTrue();
+    evaluator.Evaluate(&block);
+    for (int row = 0; row < kNumRows; row++) {
+      ASSERT_EQ(expected.IsRowSelected(row), block.selection_vector()->IsRowSelected(row))
+          << "row " << row;
+    }
+  }
+
+  // Predicates on columns of variable-length types aren't compiled.
+  Slice str("a");
+  ColumnSchema str_col("str", STRING, false);
+  faststring key;
+  Status s = codegen::PredicateEvaluatorFunctions::EncodeKey(
+      { ColumnPredicate::Equality(str_col, &str) }, &key);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+}
+
+// Compares the inserted rows decoded with a compiled insert row decoder with
+// the rows decoded by the interpreter, for a client schema which orders the
+// columns differently and leaves out some of them.
+TEST_F(CodegenTest, TestInsertRowDecoder) {
+  const int kNumRows = 100;
+  Singleton<CompilationManager>::UnsafeReset();
+  CompilationManager* cm = CompilationManager::GetSingleton();
+  const int32_t kDefault = 7;
+  Schema tablet_schema({ ColumnSchema("key", INT64, false),
+                         ColumnSchema("int32", INT32, false),
+                         ColumnSchema("int32-null", INT32, true),
+                         ColumnSchema("str", STRING, false),
+                         ColumnSchema("str-null", STRING, true),
+                         ColumnSchema("int32-default", INT32, false, &kDefault, &kDefault) }, 1);
+  tablet_schema = SchemaBuilder(tablet_schema).Build(); // add IDs
+  Schema client_schema({ ColumnSchema("key", INT64, false),
+                         ColumnSchema("str", STRING, false),
+                         ColumnSchema("int32-null", INT32, true),
+                         ColumnSchema("int32", INT32, false),
+                         ColumnSchema("int32-default", INT32, false) }, 1);
+  vector<size_t> client_to_tablet;
+  for (int i = 0; i < client_schema.num_columns(); i++) {
+    client_to_tablet.push_back(tablet_schema.find_column(client_schema.column(i).name()));
+  }
+
+  RowOperationsPB pb;
+  RowOperationsPBEncoder enc(&pb);
+  for (int i = 0; i < kNumRows; i++) {
+    KuduPartialRow row(&client_schema);
+    ASSERT_OK(row.SetInt64(0, i));
+    ASSERT_OK(row.SetStringCopy(1, std::to_string(random_.Next32())));
+    if (random_.OneIn(3)) {
+      ASSERT_OK(row.SetNull(2));
+    } else if (!random_.OneIn(3)) {
+      ASSERT_OK(row.SetInt32(2, random_.Next32()));
+    }
+    // Leave out the required column of some rows, which fails them.
+    if (!random_.OneIn(10)) {
+      ASSERT_OK(row.SetInt32(3, random_.Next32()));
+    }
+    if (random_.OneIn(2)) {
+      ASSERT_OK(row.SetInt32(4, random_.Next32()));
+    }
+    enc.Add(i % 2 == 0 ? RowOperationsPB::INSERT : RowOperationsPB::UPSERT, row);
+  }
+
+  const auto decode = [&](vector<string>* rows) {
+    Arena arena(1024);
+    vector<DecodedRowOperation> ops;
+    RowOperationsPBDecoder dec(&pb, &client_schema, &tablet_schema, &arena);
+    ASSERT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops));
+    rows->clear();
+    for (const auto& op : ops) {
+      rows->emplace_back(op.ToString(tablet_schema) + " " + op.result.ToString());
+    }
+  };
+  vector<string> expected;
+  NO_FATALS(decode(&expected));
+  ASSERT_EQ(kNumRows, expected.size());
+
+  // The first decoding with codegen enabled requests the decoder and falls
+  // back to the interpreter; the second one uses the compiled decoder.
+  FLAGS_codegen_row_operations_decoding = true;
+  for (int pass = 0; pass < 2; pass++) {
+    vector<string> actual;
+    NO_FATALS(decode(&actual));
+    ASSERT_EQ(expected, actual);
+    cm->Wait();
+  }
+  unique_ptr<codegen::InsertRowDecoder> decoder;
+  ASSERT_TRUE(cm->RequestInsertRowDecoder(client_schema, tablet_schema, client_to_tablet,
+                                          &decoder));
+}
+
+// Tests that the object code of the compiled modules is kept by a persistent
+// code cache and reused through another one over the same directory, as after
+// a restart, and that modules which refer to addresses in the process aren't
+// kept.
+TEST_F(CodegenTest, TestPersistentCodeCache) {
+  const string dir = GetTestPath("codegen-cache");
+  Schema ints;
+  ASSERT_OK(CreatePartialSchema({ kI32Col, kI32NullValCol, kI32NullCol }, &ints));
+  Schema pure_defaults;
+  ASSERT_OK(CreatePartialSchema({ kI32RCol, kStrRCol }, &pure_defaults));
+  const auto count_objects = [&]() {
+    vector<string> children;
+    CHECK_OK(env_->GetChildren(dir, &children));
+    return std::count_if(children.begin(), children.end(),
+                         [](const string& c) { return HasSuffixString(c, ".o"); });
+  };
+
+  for (int pass = 0; pass < 2; pass++) {
+    SCOPED_TRACE(pass);
+    codegen::PersistentCodeCache cache(env_, dir, 10);
+    ASSERT_OK(cache.Init(pass));
+    codegen::ModuleBuilder::SetPersistentCodeCache(&cache);
+    SCOPED_CLEANUP({ codegen::ModuleBuilder::SetPersistentCodeCache(nullptr); });
+
+    NO_FATALS(TestProjection<true>(&ints));
+    NO_FATALS(TestProjection<true>(&pure_defaults));
+    ASSERT_EQ(pass, cache.hits());
+    ASSERT_EQ(1, count_objects());
+  }
+}
+
 } // namespace kudu
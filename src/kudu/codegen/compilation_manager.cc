@@ -18,23 +18,36 @@
 #include "kudu/codegen/compilation_manager.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/codegen/code_cache.h"
 #include "kudu/codegen/code_generator.h"
+#include "kudu/codegen/insert_row_decoder.h"
 #include "kudu/codegen/jit_wrapper.h"
+#include "kudu/codegen/module_builder.h"
+#include "kudu/codegen/persistent_code_cache.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/generic_iterators.h"
+#include "kudu/common/row_operations.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/types.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/slice.h"
@@ -44,7 +57,9 @@
 
 using std::make_shared;
 using std::shared_ptr;
+using std::string;
 using std::unique_ptr;
+using std::vector;
 
 DEFINE_bool(codegen_time_compilation, false, "Whether to print time that each code "
             "generation request took.");
@@ -55,6 +70,32 @@ DEFINE_int32(codegen_cache_capacity, 100, "Number of entries which may be stored
              "code generation cache.");
 TAG_FLAG(codegen_cache_capacity, experimental);
 
+DEFINE_bool(codegen_predicate_evaluation, false, "Whether to evaluate the predicates "
+            "which aren't pushed down to the storage layer with code generated for "
+            "them, which checks all of them in a single pass over each row block.");
+TAG_FLAG(codegen_predicate_evaluation, experimental);
+TAG_FLAG(codegen_predicate_evaluation, runtime);
+
+DEFINE_bool(codegen_row_operations_decoding, false, "Whether to decode the cells of "
+            "inserted and upserted rows with code generated for the client and tablet "
+            "schemas.");
+TAG_FLAG(codegen_row_operations_decoding, experimental);
+TAG_FLAG(codegen_row_operations_decoding, runtime);
+
+DEFINE_bool(codegen_persistent_cache_enabled, false, "Whether to keep the object code of "
+            "the compiled modules in the server's metadata directory, so that it's reused "
+            "rather than compiled again after the server restarts.");
+TAG_FLAG(codegen_persistent_cache_enabled, experimental);
+
+DEFINE_int32(codegen_persistent_cache_capacity, 1000, "Number of compiled modules which "
+             "may be stored in the persistent code generation cache.");
+TAG_FLAG(codegen_persistent_cache_capacity, experimental);
+
+DEFINE_int32(codegen_persistent_cache_warm_entries, 100, "Number of the most recently "
+             "compiled modules which are loaded from the persistent code generation cache "
+             "into memory at startup.");
+TAG_FLAG(codegen_persistent_cache_warm_entries, experimental);
+
 METRIC_DEFINE_gauge_int64(server, code_cache_hits, "Codegen Cache Hits",
                           kudu::MetricUnit::kCacheHits,
                           "Number of codegen cache hits since start",
@@ -123,6 +164,163 @@ class CompilationTask {
   DISALLOW_COPY_AND_ASSIGN(CompilationTask);
 };
 
+// A PredicateCompilationTask is the analogue of a CompilationTask for a
+// conjunction of predicates. Since predicates don't own their bounds, the task
+// copies them so it may outlive the requester.
+class PredicateCompilationTask {
+ public:
+  // Requires that the cache and generator are valid for the lifetime
+  // of this object.
+  PredicateCompilationTask(const vector<ColumnPredicate>& predicates, CodeCache* cache,
+                           CodeGenerator* generator)
+    : arena_(1024),
+      cache_(cache),
+      generator_(generator) {
+    predicates_.reserve(predicates.size());
+    for (const ColumnPredicate& pred : predicates) {
+      predicates_.emplace_back(CopyPredicate(pred));
+    }
+  }
+
+  // Can only be run once.
+  void Run() {
+    WARN_NOT_OK(RunWithStatus(), "Failed compilation of predicate evaluator");
+  }
+
+ private:
+  Status RunWithStatus() {
+    faststring key;
+    RETURN_NOT_OK(PredicateEvaluatorFunctions::EncodeKey(predicates_, &key));
+
+    // Check again to make sure we didn't compile it already.
+    if (cache_->Lookup(key)) return Status::OK();
+
+    scoped_refptr<PredicateEvaluatorFunctions> functions;
+    LOG_TIMING_IF(INFO, FLAGS_codegen_time_compilation, "code-generating predicate evaluator") {
+      RETURN_NOT_OK(generator_->CompilePredicateEvaluator(predicates_, &functions));
+    }
+
+    RETURN_NOT_OK(cache_->AddEntry(functions));
+    return Status::OK();
+  }
+
+  // Returns a copy of 'pred' whose bounds are allocated from 'arena_'. Only
+  // the predicate types which may be compiled are supported.
+  ColumnPredicate CopyPredicate(const ColumnPredicate& pred) {
+    const ColumnSchema& col = pred.column();
+    switch (pred.predicate_type()) {
+      case PredicateType::Equality:
+        return ColumnPredicate::Equality(col, CopyBound(col, pred.raw_lower()));
+      case PredicateType::Range:
+        return ColumnPredicate::Range(col, CopyBound(col, pred.raw_lower()),
+                                      CopyBound(col, pred.raw_upper()));
+      case PredicateType::IsNotNull:
+        return ColumnPredicate::IsNotNull(col);
+      case PredicateType::IsNull:
+        return ColumnPredicate::IsNull(col);
+      default:
+        return ColumnPredicate::None(col);
+    }
+  }
+
+  const void* CopyBound(const ColumnSchema& col, const void* bound) {
+    if (bound == nullptr) return nullptr;
+    size_t size = col.type_info()->size();
+    void* copy = arena_.AllocateBytes(size);
+    CHECK(copy);
+    memcpy(copy, bound, size);
+    return copy;
+  }
+
+  Arena arena_;
+  vector<ColumnPredicate> predicates_;
+  CodeCache* const cache_;
+  CodeGenerator* const generator_;
+
+  DISALLOW_COPY_AND_ASSIGN(PredicateCompilationTask);
+};
+
+// An InsertRowDecoderCompilationTask is the analogue of a CompilationTask for
+// a decoder of INSERT-like rows.
+class InsertRowDecoderCompilationTask {
+ public:
+  // Requires that the cache and generator are valid for the lifetime
+  // of this object.
+  InsertRowDecoderCompilationTask(const Schema& client_schema, const Schema& tablet_schema,
+                                  vector<size_t> client_to_tablet, CodeCache* cache,
+                                  CodeGenerator* generator)
+    : client_schema_(client_schema),
+      tablet_schema_(tablet_schema),
+      client_to_tablet_(std::move(client_to_tablet)),
+      cache_(cache),
+      generator_(generator) {}
+
+  // Can only be run once.
+  void Run() {
+    WARN_NOT_OK(RunWithStatus(),
+                "Failed compilation of insert row decoder from client schema " +
+                client_schema_.ToString() + " to tablet schema " +
+                tablet_schema_.ToString());
+  }
+
+ private:
+  Status RunWithStatus() {
+    faststring key;
+    RETURN_NOT_OK(InsertRowDecoderFunctions::EncodeKey(client_schema_, tablet_schema_,
+                                                       client_to_tablet_, &key));
+
+    // Check again to make sure we didn't compile it already.
+    if (cache_->Lookup(key)) return Status::OK();
+
+    scoped_refptr<InsertRowDecoderFunctions> functions;
+    LOG_TIMING_IF(INFO, FLAGS_codegen_time_compilation, "code-generating insert row decoder") {
+      RETURN_NOT_OK(generator_->CompileInsertRowDecoder(client_schema_, tablet_schema_,
+                                                        client_to_tablet_, &functions));
+    }
+
+    RETURN_NOT_OK(cache_->AddEntry(functions));
+    return Status::OK();
+  }
+
+  Schema client_schema_;
+  Schema tablet_schema_;
+  vector<size_t> client_to_tablet_;
+  CodeCache* const cache_;
+  CodeGenerator* const generator_;
+
+  DISALLOW_COPY_AND_ASSIGN(InsertRowDecoderCompilationTask);
+};
+
+// The factory of the PredicateEvaluatingIterator's evaluators.
+unique_ptr<RowBlockPredicateEvaluator> NewCompiledPredicateEvaluator(
+    const Schema& schema, const vector<ColumnPredicate>& predicates) {
+  if (!FLAGS_codegen_predicate_evaluation) return nullptr;
+  for (const ColumnPredicate& pred : predicates) {
+    if (schema.find_column(pred.column().name()) == Schema::kColumnNotFound) {
+      return nullptr;
+    }
+  }
+  unique_ptr<PredicateEvaluator> evaluator;
+  if (!CompilationManager::GetSingleton()->RequestPredicateEvaluator(
+          schema, predicates, &evaluator)) {
+    return nullptr;
+  }
+  return unique_ptr<RowBlockPredicateEvaluator>(evaluator.release());
+}
+
+// The factory of the RowOperationsPBDecoder's decoders of INSERT-like rows.
+unique_ptr<kudu::InsertRowDecoder> NewCompiledInsertRowDecoder(
+    const Schema& client_schema, const Schema& tablet_schema,
+    const vector<size_t>& client_to_tablet) {
+  if (!FLAGS_codegen_row_operations_decoding) return nullptr;
+  unique_ptr<InsertRowDecoder> decoder;
+  if (!CompilationManager::GetSingleton()->RequestInsertRowDecoder(
+          client_schema, tablet_schema, client_to_tablet, &decoder)) {
+    return nullptr;
+  }
+  return unique_ptr<kudu::InsertRowDecoder>(decoder.release());
+}
+
 } // anonymous namespace
 
 CompilationManager::CompilationManager()
@@ -141,9 +339,31 @@ CompilationManager::CompilationManager()
   CHECK(std::atexit(&CompilationManager::Shutdown) == 0)
     << "Compilation manager shutdown must be registered successfully with "
     << "std::atexit to be used.";
+  SetRowBlockPredicateEvaluatorFactory(&NewCompiledPredicateEvaluator);
+  SetInsertRowDecoderFactory(&NewCompiledInsertRowDecoder);
+}
+
+CompilationManager::~CompilationManager() {
+  std::lock_guard<std::mutex> l(persistent_cache_lock_);
+  if (persistent_cache_) {
+    ModuleBuilder::SetPersistentCodeCache(nullptr);
+  }
 }
 
-CompilationManager::~CompilationManager() {}
+Status CompilationManager::EnablePersistentCache(Env* env, const string& dir) {
+  if (!FLAGS_codegen_persistent_cache_enabled) return Status::OK();
+  std::lock_guard<std::mutex> l(persistent_cache_lock_);
+  if (persistent_cache_) return Status::OK();
+
+  unique_ptr<PersistentCodeCache> cache(
+      new PersistentCodeCache(env, dir, FLAGS_codegen_persistent_cache_capacity));
+  RETURN_NOT_OK_PREPEND(cache->Init(FLAGS_codegen_persistent_cache_warm_entries),
+                        "could not initialize the persistent code cache");
+  persistent_cache_ = std::move(cache);
+  ModuleBuilder::SetPersistentCodeCache(persistent_cache_.get());
+  LOG(INFO) << "Using persistent code generation cache in " << dir;
+  return Status::OK();
+}
 
 void CompilationManager::Wait() {
   pool_->Wait();
@@ -196,5 +416,61 @@ bool CompilationManager::RequestRowProjector(const Schema* base_schema,
   return true;
 }
 
+bool CompilationManager::RequestPredicateEvaluator(const Schema& schema,
+                                                   const vector<ColumnPredicate>& predicates,
+                                                   unique_ptr<PredicateEvaluator>* out) {
+  faststring key;
+  // Most predicate types can't be compiled, so this isn't worth a warning.
+  if (!PredicateEvaluatorFunctions::EncodeKey(predicates, &key).ok()) return false;
+  query_counter_.Increment();
+
+  scoped_refptr<PredicateEvaluatorFunctions> cached(
+    down_cast<PredicateEvaluatorFunctions*>(cache_.Lookup(key).get()));
+
+  // If not cached, add a request to compilation pool
+  if (!cached) {
+    shared_ptr<PredicateCompilationTask> task(make_shared<PredicateCompilationTask>(
+        predicates, &cache_, &generator_));
+    WARN_NOT_OK(pool_->Submit([task]() { task->Run(); }),
+                "PredicateEvaluator compilation request failed");
+    return false;
+  }
+
+  hit_counter_.Increment();
+
+  out->reset(new PredicateEvaluator(schema, predicates, std::move(cached)));
+  return true;
+}
+
+bool CompilationManager::RequestInsertRowDecoder(const Schema& client_schema,
+                                                 const Schema& tablet_schema,
+                                                 const vector<size_t>& client_to_tablet,
+                                                 unique_ptr<InsertRowDecoder>* out) {
+  faststring key;
+  Status s = InsertRowDecoderFunctions::EncodeKey(client_schema, tablet_schema,
+                                                  client_to_tablet, &key);
+  WARN_NOT_OK(s, "InsertRowDecoder compilation request failed");
+  if (!s.ok()) return false;
+  query_counter_.Increment();
+
+  scoped_refptr<InsertRowDecoderFunctions> cached(
+    down_cast<InsertRowDecoderFunctions*>(cache_.Lookup(key).get()));
+
+  // If not cached, add a request to compilation pool
+  if (!cached) {
+    shared_ptr<InsertRowDecoderCompilationTask> task(
+        make_shared<InsertRowDecoderCompilationTask>(
+            client_schema, tablet_schema, client_to_tablet, &cache_, &generator_));
+    WARN_NOT_OK(pool_->Submit([task]() { task->Run(); }),
+                "InsertRowDecoder compilation request failed");
+    return false;
+  }
+
+  hit_counter_.Increment();
+
+  out->reset(new InsertRowDecoder(std::move(cached)));
+  return true;
+}
+
 } // namespace codegen
 } // namespace kudu
@@ -16,8 +16,12 @@
 // under the License.
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/code_cache.h"
@@ -29,12 +33,17 @@
 
 namespace kudu {
 
+class ColumnPredicate;
+class Env;
 class MetricEntity;
 class Schema;
 class ThreadPool;
 
 namespace codegen {
 
+class InsertRowDecoder;
+class PersistentCodeCache;
+class PredicateEvaluator;
 class RowProjector;
 
 // The compilation manager is a top-level class which manages the actual
@@ -76,9 +85,39 @@ class CompilationManager {
                            const Schema* projection,
                            std::unique_ptr<RowProjector>* out);
 
+  // If a codegenned evaluator for the conjunction of 'predicates' (see
+  // PredicateEvaluatorFunctions::EncodeKey) is ready, then an evaluator of
+  // them over row blocks of 'schema' is written to 'out' and true is
+  // returned. Otherwise, if the predicates can be compiled, this enqueues a
+  // compilation task for them and returns false. Upon any failure, false is
+  // returned. Does not write to 'out' if false is returned.
+  //
+  // The predicates are copied by the compilation task, so they need not
+  // outlive the call.
+  bool RequestPredicateEvaluator(const Schema& schema,
+                                 const std::vector<ColumnPredicate>& predicates,
+                                 std::unique_ptr<PredicateEvaluator>* out);
+
+  // If a codegenned decoder of INSERT-like rows for the parameter schemas and
+  // the mapping between them is ready, then it is written to 'out' and true
+  // is returned. Otherwise, this enqueues a compilation task for them and
+  // returns false. Upon any failure, false is returned.
+  // Does not write to 'out' if false is returned.
+  bool RequestInsertRowDecoder(const Schema& client_schema,
+                               const Schema& tablet_schema,
+                               const std::vector<size_t>& client_to_tablet,
+                               std::unique_ptr<InsertRowDecoder>* out);
+
   // Waits for all asynchronous compilation tasks to finish.
   void Wait();
 
+  // If --codegen_persistent_cache_enabled is set, keeps the object code of
+  // the compiled modules in 'dir' from now on, and reuses the object code
+  // kept there by previous processes, warming up with the most recently
+  // compiled modules. Does nothing if a directory was already enabled, as
+  // when several servers share the process.
+  Status EnablePersistentCache(Env* env, const std::string& dir);
+
   // Sets up a metric registry to observe the compilation manager's metrics.
   // This method is used instead of registering a counter with a given
   // registry because the CompilationManager is a singleton and there would
@@ -93,6 +132,13 @@ class CompilationManager {
 
   CodeGenerator generator_;
   CodeCache cache_;
+
+  // Protects 'persistent_cache_' from concurrent enabling.
+  std::mutex persistent_cache_lock_;
+  std::unique_ptr<PersistentCodeCache> persistent_cache_;
+
+  // Declared after the caches, so that it's destructed, and the compilation
+  // tasks are complete, before them.
   std::unique_ptr<ThreadPool> pool_;
 
   AtomicInt<int64_t> hit_counter_;
@@ -0,0 +1,343 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/insert_row_decoder.h"
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <glog/logging.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "kudu/codegen/module_builder.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/row.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/strcat.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
+
+namespace llvm {
+class LLVMContext;
+} // namespace llvm
+
+using llvm::Argument;
+using llvm::BasicBlock;
+using llvm::Function;
+using llvm::FunctionType;
+using llvm::LLVMContext;
+using llvm::PointerType;
+using llvm::Type;
+using llvm::Value;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+DECLARE_bool(codegen_dump_functions);
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+// Returns a value which is true if bit 'idx' of 'bitmap' is set.
+Value* MakeBitTest(ModuleBuilder::LLVMBuilder* builder, Value* bitmap, size_t idx) {
+  Value* byte = builder->CreateLoad(builder->getInt8Ty(),
+                                    builder->CreateConstGEP1_64(builder->getInt8Ty(),
+                                                                bitmap, idx / 8));
+  Value* bit = builder->CreateAnd(byte, builder->getInt8(1 << (idx % 8)));
+  return builder->CreateICmpNE(bit, builder->getInt8(0));
+}
+
+// Sets bit 'idx' of 'bitmap' to 'value', which is an i1.
+void MakeBitChange(ModuleBuilder::LLVMBuilder* builder, Value* bitmap, size_t idx,
+                   Value* value) {
+  Value* byte_ptr = builder->CreateConstGEP1_64(builder->getInt8Ty(), bitmap, idx / 8);
+  Value* byte = builder->CreateLoad(builder->getInt8Ty(), byte_ptr);
+  uint8_t mask = 1 << (idx % 8);
+  Value* cleared = builder->CreateAnd(byte, builder->getInt8(static_cast<uint8_t>(~mask)));
+  Value* bit = builder->CreateSelect(value, builder->getInt8(mask), builder->getInt8(0));
+  builder->CreateStore(builder->CreateOr(cleared, bit), byte_ptr);
+}
+
+// Generates a function which decodes the cells of a row written with
+// 'client_schema' into a row of 'tablet_schema', of the form
+// InsertRowDecoderFunctions::DecodeFunction. It mirrors
+// RowOperationsPBDecoder::DecodeInsertOrUpsert(), except that it returns -1
+// instead of handling any invalid row.
+//
+// The layout of the columns is known at JIT time, so only the isset and null
+// bits of the row remain to be tested, and each cell is copied with a single
+// load and store of its size (two for a binary cell's Slice), at constant
+// offsets from the row.
+Function* MakeDecoder(const string& name,
+                      ModuleBuilder* mbuilder,
+                      const Schema& client_schema,
+                      const Schema& tablet_schema,
+                      const vector<size_t>& client_to_tablet) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+
+  Type* i8_ptr_ty = Type::getInt8PtrTy(context);
+  Type* i64_ty = Type::getInt64Ty(context);
+  vector<Type*> argtypes = { i8_ptr_ty, i64_ty, i8_ptr_ty, i8_ptr_ty, i8_ptr_ty, i64_ty,
+                             i64_ty, i8_ptr_ty, i8_ptr_ty };
+  FunctionType* fty = FunctionType::get(i64_ty, argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* src = &*it++;
+  Argument* src_len = &*it++;
+  Argument* isset = &*it++;
+  Argument* nulls = &*it++;
+  Argument* indirect = &*it++;
+  Argument* indirect_len = &*it++;
+  Argument* max_cell_size = &*it++;
+  Argument* row = &*it++;
+  Argument* row_isset = &*it++;
+  DCHECK(it == f->arg_end());
+
+  src->setName("src");
+  src_len->setName("src_len");
+  isset->setName("isset");
+  nulls->setName("nulls");
+  indirect->setName("indirect");
+  indirect_len->setName("indirect_len");
+  max_cell_size->setName("max_cell_size");
+  row->setName("row");
+  row_isset->setName("row_isset");
+
+  // The position in 'src' of the next cell. It's promoted to a register by
+  // the optimization passes.
+  builder->SetInsertPoint(BasicBlock::Create(context, "entry", f));
+  Value* pos_ptr = builder->CreateAlloca(i64_ty, nullptr, "pos_ptr");
+  builder->CreateStore(builder->getInt64(0), pos_ptr);
+  Value* row_nulls = builder->CreateConstGEP1_64(builder->getInt8Ty(), row,
+                                                 tablet_schema.byte_size(), "row_nulls");
+
+  BasicBlock* fail = BasicBlock::Create(context, "fail", f);
+
+  for (size_t client_idx = 0; client_idx < client_schema.num_columns(); client_idx++) {
+    size_t tablet_idx = client_to_tablet[client_idx];
+    const ColumnSchema& col = tablet_schema.column(tablet_idx);
+    BasicBlock* set = BasicBlock::Create(context, StrCat("set", client_idx), f);
+    BasicBlock* next = BasicBlock::Create(context, StrCat("next", client_idx), f);
+
+    // Copy whether the client set the cell. If it didn't, the prototype row
+    // already holds the cell's default, unless it's required.
+    Value* cell_isset = MakeBitTest(builder, isset, client_idx);
+    MakeBitChange(builder, row_isset, tablet_idx, cell_isset);
+    BasicBlock* unset = col.is_nullable() || col.has_write_default() ? next : fail;
+    builder->CreateCondBr(cell_isset, set, unset);
+
+    // Copy whether the cell is null. Null cells aren't encoded, unless the
+    // column isn't nullable, which is an error.
+    builder->SetInsertPoint(set);
+    if (client_schema.has_nullables()) {
+      BasicBlock* null_cell = BasicBlock::Create(context, StrCat("null", client_idx), f);
+      BasicBlock* non_null_cell = BasicBlock::Create(context, StrCat("non_null", client_idx), f);
+      builder->CreateCondBr(MakeBitTest(builder, nulls, client_idx), null_cell, non_null_cell);
+      builder->SetInsertPoint(null_cell);
+      if (col.is_nullable()) {
+        MakeBitChange(builder, row_nulls, tablet_idx, builder->getTrue());
+        builder->CreateBr(next);
+      } else {
+        builder->CreateBr(fail);
+      }
+      builder->SetInsertPoint(non_null_cell);
+    }
+    if (col.is_nullable()) {
+      MakeBitChange(builder, row_nulls, tablet_idx, builder->getFalse());
+    }
+
+    // Copy the cell.
+    size_t size = col.type_info()->size();
+    Value* pos = builder->CreateLoad(i64_ty, pos_ptr);
+    Value* end = builder->CreateAdd(pos, builder->getInt64(size));
+    BasicBlock* copy = BasicBlock::Create(context, StrCat("copy", client_idx), f);
+    builder->CreateCondBr(builder->CreateICmpULE(end, src_len), copy, fail);
+    builder->SetInsertPoint(copy);
+    Value* cell_src = builder->CreateGEP(builder->getInt8Ty(), src, pos);
+    Value* cell_dst = builder->CreateConstGEP1_64(builder->getInt8Ty(), row,
+                                                  tablet_schema.column_offset(tablet_idx));
+    if (col.type_info()->physical_type() == BINARY) {
+      // The client's Slice points at an offset in the indirect data, which
+      // must be within it, and the cell's size must be within the limit.
+      static_assert(sizeof(Slice) == 2 * sizeof(int64_t), "unexpected Slice layout");
+      Value* i64_ptr_src = builder->CreateBitCast(cell_src, PointerType::getUnqual(i64_ty));
+      Value* offset = builder->CreateAlignedLoad(i64_ty, i64_ptr_src, 1);
+      Value* len = builder->CreateAlignedLoad(
+          i64_ty, builder->CreateConstGEP1_64(i64_ty, i64_ptr_src, 1), 1);
+      Value* valid = builder->CreateAnd(
+          builder->CreateICmpULE(offset, indirect_len),
+          builder->CreateICmpULE(len, builder->CreateSub(indirect_len, offset)));
+      valid = builder->CreateAnd(valid, builder->CreateICmpULE(len, max_cell_size));
+      BasicBlock* copy_binary = BasicBlock::Create(context, StrCat("copy_binary", client_idx), f);
+      builder->CreateCondBr(valid, copy_binary, fail);
+      builder->SetInsertPoint(copy_binary);
+      Value* data = builder->CreatePtrToInt(builder->CreateGEP(builder->getInt8Ty(), indirect,
+                                                               offset), i64_ty);
+      Value* i64_ptr_dst = builder->CreateBitCast(cell_dst, PointerType::getUnqual(i64_ty));
+      builder->CreateStore(data, i64_ptr_dst);
+      builder->CreateStore(len, builder->CreateConstGEP1_64(i64_ty, i64_ptr_dst, 1));
+    } else {
+      Type* cell_ty = builder->getIntNTy(size * 8);
+      Value* cell = builder->CreateAlignedLoad(
+          cell_ty, builder->CreateBitCast(cell_src, PointerType::getUnqual(cell_ty)), 1);
+      builder->CreateStore(cell, builder->CreateBitCast(cell_dst,
+                                                        PointerType::getUnqual(cell_ty)));
+    }
+    builder->CreateStore(end, pos_ptr);
+    builder->CreateBr(next);
+
+    builder->SetInsertPoint(next);
+  }
+  builder->CreateRet(builder->CreateLoad(i64_ty, pos_ptr));
+
+  builder->SetInsertPoint(fail);
+  builder->CreateRet(builder->getInt64(-1));
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping insert row decoder:";
+    f->print(llvm::errs(), nullptr);
+  }
+
+  return f;
+}
+
+// Convenience method which appends to a faststring
+template<typename T>
+void AddNext(faststring* fs, const T& val) {
+  fs->append(&val, sizeof(T));
+}
+
+} // anonymous namespace
+
+InsertRowDecoderFunctions::InsertRowDecoderFunctions(const Schema& client_schema,
+                                                     const Schema& tablet_schema,
+                                                     vector<size_t> client_to_tablet,
+                                                     DecodeFunction decode_f,
+                                                     unique_ptr<JITCodeOwner> owner)
+  : JITWrapper(std::move(owner)),
+    client_schema_(client_schema),
+    tablet_schema_(tablet_schema),
+    client_to_tablet_(std::move(client_to_tablet)),
+    decode_f_(decode_f) {
+  CHECK(decode_f != nullptr)
+    << "Promise to compile insert row decoder not fulfilled by ModuleBuilder";
+}
+
+Status InsertRowDecoderFunctions::Create(const Schema& client_schema,
+                                         const Schema& tablet_schema,
+                                         const vector<size_t>& client_to_tablet,
+                                         scoped_refptr<InsertRowDecoderFunctions>* out,
+                                         llvm::TargetMachine** tm) {
+  // Check the mapping.
+  faststring key;
+  RETURN_NOT_OK(EncodeKey(client_schema, tablet_schema, client_to_tablet, &key));
+
+  ModuleBuilder builder;
+  RETURN_NOT_OK(builder.Init());
+
+  Function* decode = MakeDecoder("DecodeInsertRow", &builder, client_schema, tablet_schema,
+                                 client_to_tablet);
+  DecodeFunction decode_f;
+  builder.AddJITPromise(decode, &decode_f);
+
+  unique_ptr<JITCodeOwner> owner;
+  RETURN_NOT_OK(builder.Compile(&owner));
+
+  if (tm) {
+    *tm = builder.GetTargetMachine();
+  }
+  out->reset(new InsertRowDecoderFunctions(client_schema, tablet_schema, client_to_tablet,
+                                           decode_f, std::move(owner)));
+  return Status::OK();
+}
+
+// Generates a key for a pair of schemas and the mapping between them which is
+// unique according to the criteria defined in the CodeCache class' block
+// comment. It encodes, in sequence:
+//
+// (1 byte) unique type identifier for InsertRowDecoderFunctions
+// (1 byte) whether the client schema has nullable columns
+// (8 bytes) byte size of the tablet schema, which is the offset of its null
+//   bitmap in a row
+// (8 bytes) number, as unsigned long, of client columns
+// for each client column, in order:
+//   8 bytes for the index of the tablet column
+//   8 bytes for the offset of the tablet column in a row
+//   4 bytes for the physical type of the tablet column
+//   1 byte for the tablet column's nullability
+//   1 byte for whether the tablet column has a write default
+//
+// Writes to 'out' upon success.
+Status InsertRowDecoderFunctions::EncodeKey(const Schema& client_schema,
+                                            const Schema& tablet_schema,
+                                            const vector<size_t>& client_to_tablet,
+                                            faststring* out) {
+  if (client_to_tablet.size() != client_schema.num_columns()) {
+    return Status::InvalidArgument("mapping doesn't cover the client schema");
+  }
+  AddNext(out, JITWrapper::INSERT_ROW_DECODER);
+  AddNext(out, client_schema.has_nullables());
+  AddNext(out, tablet_schema.byte_size());
+  AddNext(out, client_to_tablet.size());
+  for (size_t tablet_idx : client_to_tablet) {
+    if (tablet_idx >= tablet_schema.num_columns()) {
+      return Status::InvalidArgument("mapping to a column missing from the tablet schema");
+    }
+    const ColumnSchema& col = tablet_schema.column(tablet_idx);
+    AddNext(out, tablet_idx);
+    AddNext(out, tablet_schema.column_offset(tablet_idx));
+    AddNext(out, col.type_info()->physical_type());
+    AddNext(out, col.is_nullable());
+    AddNext(out, col.has_write_default());
+  }
+  return Status::OK();
+}
+
+InsertRowDecoder::InsertRowDecoder(scoped_refptr<InsertRowDecoderFunctions> functions)
+  : functions_(std::move(functions)) {}
+
+int64_t InsertRowDecoder::DecodeCells(const uint8_t* src,
+                                      int64_t src_len,
+                                      const uint8_t* client_isset_bitmap,
+                                      const uint8_t* client_null_bitmap,
+                                      const Slice& indirect_data,
+                                      int64_t max_cell_size,
+                                      uint8_t* tablet_row,
+                                      uint8_t* tablet_isset_bitmap) const {
+  return functions_->decode()(src, src_len, client_isset_bitmap, client_null_bitmap,
+                              indirect_data.data(), indirect_data.size(), max_cell_size,
+                              tablet_row, tablet_isset_bitmap);
+}
+
+} // namespace codegen
+} // namespace kudu
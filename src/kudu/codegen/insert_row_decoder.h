@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/common/row_operations.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class TargetMachine;
+} // namespace llvm
+
+namespace kudu {
+
+class Slice;
+class faststring;
+
+namespace codegen {
+
+// The JITWrapper for codegen::InsertRowDecoder functions. Contains the
+// compiled function, which decodes the cells of an INSERT-like row written
+// with a client schema into a row of a tablet schema with straight-line code
+// for the columns, as well as the schemas and the mapping between them.
+class InsertRowDecoderFunctions : public JITWrapper {
+ public:
+  // Compiles the decoder of rows of 'client_schema' into rows of
+  // 'tablet_schema', where the i-th client column is the
+  // 'client_to_tablet[i]'-th tablet column.
+  // Writes the llvm::TargetMachine* used to 'tm' (if not NULL) and the
+  // functions to 'out' upon success.
+  static Status Create(const Schema& client_schema,
+                       const Schema& tablet_schema,
+                       const std::vector<size_t>& client_to_tablet,
+                       scoped_refptr<InsertRowDecoderFunctions>* out,
+                       llvm::TargetMachine** tm = NULL);
+
+  // The arguments and result are those of kudu::InsertRowDecoder::DecodeCells(),
+  // with the indirect data split into its data and size.
+  typedef int64_t(*DecodeFunction)(const uint8_t* src,
+                                   int64_t src_len,
+                                   const uint8_t* client_isset_bitmap,
+                                   const uint8_t* client_null_bitmap,
+                                   const uint8_t* indirect_data,
+                                   int64_t indirect_data_len,
+                                   int64_t max_cell_size,
+                                   uint8_t* tablet_row,
+                                   uint8_t* tablet_isset_bitmap);
+  DecodeFunction decode() const { return decode_f_; }
+
+  Status EncodeOwnKey(faststring* out) OVERRIDE {
+    return EncodeKey(client_schema_, tablet_schema_, client_to_tablet_, out);
+  }
+
+  static Status EncodeKey(const Schema& client_schema,
+                          const Schema& tablet_schema,
+                          const std::vector<size_t>& client_to_tablet,
+                          faststring* out);
+
+ private:
+  InsertRowDecoderFunctions(const Schema& client_schema,
+                            const Schema& tablet_schema,
+                            std::vector<size_t> client_to_tablet,
+                            DecodeFunction decode_f,
+                            std::unique_ptr<JITCodeOwner> owner);
+
+  const Schema client_schema_;
+  const Schema tablet_schema_;
+  const std::vector<size_t> client_to_tablet_;
+  const DecodeFunction decode_f_;
+};
+
+// Decodes INSERT-like rows with a compiled InsertRowDecoderFunctions.
+class InsertRowDecoder : public kudu::InsertRowDecoder {
+ public:
+  explicit InsertRowDecoder(scoped_refptr<InsertRowDecoderFunctions> functions);
+
+  int64_t DecodeCells(const uint8_t* src,
+                      int64_t src_len,
+                      const uint8_t* client_isset_bitmap,
+                      const uint8_t* client_null_bitmap,
+                      const Slice& indirect_data,
+                      int64_t max_cell_size,
+                      uint8_t* tablet_row,
+                      uint8_t* tablet_isset_bitmap) const OVERRIDE;
+
+ private:
+  scoped_refptr<InsertRowDecoderFunctions> functions_;
+
+  DISALLOW_COPY_AND_ASSIGN(InsertRowDecoder);
+};
+
+} // namespace codegen
+} // namespace kudu
@@ -17,6 +17,7 @@
 
 #include "kudu/codegen/module_builder.h"
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <sstream>
@@ -55,6 +56,7 @@
 #include <llvm/Transforms/IPO/AlwaysInliner.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 
+#include "kudu/codegen/persistent_code_cache.h"
 #include "kudu/codegen/precompiled.ll.h"
 #include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/map-util.h"
@@ -105,6 +107,9 @@ namespace codegen {
 
 namespace {
 
+// The cache of the object code of compiled modules, if any.
+std::atomic<PersistentCodeCache*> persistent_code_cache(nullptr);
+
 string ToString(const SMDiagnostic& err) {
   ostringstream sstr;
   raw_os_ostream os(sstr);
@@ -139,6 +144,7 @@ bool ModuleContains(const Module& m, const Function* fptr) {
 
 ModuleBuilder::ModuleBuilder()
   : state_(kUninitialized),
+    refers_to_addresses_(false),
     context_(new LLVMContext()),
     builder_(*context_) {}
 
@@ -198,8 +204,9 @@ Type* ModuleBuilder::GetType(const string& name) {
   return CHECK_NOTNULL(module_->getTypeByName(name));
 }
 
-Value* ModuleBuilder::GetPointerValue(void* ptr) const {
+Value* ModuleBuilder::GetPointerValue(void* ptr) {
   CHECK_EQ(state_, kBuilding);
+  refers_to_addresses_ = true;
   // No direct way of creating constant pointer values in LLVM, so
   // first a constant int has to be created and then casted to a pointer
   IntegerType* llvm_uintptr_t = Type::getIntNTy(*context_, 8 * sizeof(ptr));
@@ -331,8 +338,10 @@ Status ModuleBuilder::Compile(unique_ptr<ExecutionEngine>* out) {
   EngineBuilder ebuilder(move(module_));
   ebuilder.setErrorStr(&str);
   ebuilder.setOptLevel(opt_level);
-  ebuilder.setMCPU(llvm::sys::getHostCPUName());
-  ebuilder.setMAttrs(GetHostCPUAttrs());
+  const string cpu = llvm::sys::getHostCPUName().str();
+  const vector<string> cpu_attrs = GetHostCPUAttrs();
+  ebuilder.setMCPU(cpu);
+  ebuilder.setMAttrs(cpu_attrs);
   target_ = ebuilder.selectTarget();
   unique_ptr<ExecutionEngine> local_engine(ebuilder.create(target_));
   if (!local_engine) {
@@ -345,6 +354,14 @@ Status ModuleBuilder::Compile(unique_ptr<ExecutionEngine>* out) {
   DoOptimizations(module, GetFunctionNames());
   SetFunctionAttributes(module);
 
+  // The object code of modules which refer to addresses in this process is
+  // of no use to other processes, so it isn't cached.
+  PersistentCodeCache* cache = persistent_code_cache.load();
+  if (cache != nullptr && !refers_to_addresses_) {
+    module->setModuleIdentifier(PersistentCodeCache::Fingerprint(*module, cpu, cpu_attrs));
+    local_engine->setObjectCache(cache);
+  }
+
   // Compile the module
   local_engine->finalizeObject();
 
@@ -371,6 +388,10 @@ Status ModuleBuilder::Compile(unique_ptr<ExecutionEngine>* out) {
   return Status::OK();
 }
 
+void ModuleBuilder::SetPersistentCodeCache(PersistentCodeCache* cache) {
+  persistent_code_cache.store(cache);
+}
+
 TargetMachine* ModuleBuilder::GetTargetMachine() const {
   CHECK_EQ(state_, kCompiled);
   return CHECK_NOTNULL(target_);
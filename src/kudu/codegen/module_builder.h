@@ -44,6 +44,8 @@ class Value;
 namespace kudu {
 namespace codegen {
 
+class PersistentCodeCache;
+
 // A ModuleBuilder provides an interface to generate code for procedures
 // given a CodeGenerator to refer to. Builder can be used to create multiple
 // functions. It is intended to make building functions easier than using
@@ -84,8 +86,9 @@ class ModuleBuilder {
   llvm::Type* GetType(const std::string& name);
   // Retrieve a precompiled function
   llvm::Function* GetFunction(const std::string& name);
-  // Get the LLVM wrapper for a constant pointer value of type i8*
-  llvm::Value* GetPointerValue(void* ptr) const;
+  // Get the LLVM wrapper for a constant pointer value of type i8*.
+  // Modules which refer to such values aren't persistently cached.
+  llvm::Value* GetPointerValue(void* ptr);
 
   LLVMBuilder* builder() { return &builder_; }
 
@@ -117,6 +120,12 @@ class ModuleBuilder {
   // Pointer is valid while Compile()'s ExecutionEngine is.
   llvm::TargetMachine* GetTargetMachine() const;
 
+  // Sets the cache through which all modules compiled afterwards reuse the
+  // object code of identical modules compiled before, possibly by previous
+  // processes, or NULL for no such cache. The cache must remain valid until
+  // it's unset and all the compilations which started with it are complete.
+  static void SetPersistentCodeCache(PersistentCodeCache* cache);
+
  private:
   // The different states a ModuleBuilder can be in.
   enum MBState {
@@ -137,6 +146,8 @@ class ModuleBuilder {
   std::unordered_set<std::string> GetFunctionNames() const;
 
   MBState state_;
+  // Whether the module refers to addresses in this process.
+  bool refers_to_addresses_;
   std::vector<JITFuture> futures_;
   std::unique_ptr<llvm::LLVMContext> context_;
   std::unique_ptr<llvm::Module> module_;
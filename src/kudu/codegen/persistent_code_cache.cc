@@ -0,0 +1,215 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/persistent_code_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <glog/logging.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "kudu/gutil/hash/city.h"
+#include "kudu/gutil/int128.h"
+#include "kudu/gutil/strings/stringpiece.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/util/crc.h"
+#include "kudu/util/env.h"
+#include "kudu/util/env_util.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/version_info.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+const char* const kObjectSuffix = ".o";
+const char* const kTmpSuffix = ".tmp";
+
+} // anonymous namespace
+
+PersistentCodeCache::PersistentCodeCache(Env* env, string dir, int capacity)
+  : env_(env),
+    dir_(std::move(dir)),
+    capacity_(capacity),
+    num_entries_(0),
+    hits_(0) {
+}
+
+PersistentCodeCache::~PersistentCodeCache() {}
+
+Status PersistentCodeCache::Init(int num_warm_entries) {
+  RETURN_NOT_OK_PREPEND(env_util::CreateDirIfMissing(env_, dir_),
+                        "could not create the code cache directory");
+  vector<string> children;
+  RETURN_NOT_OK(env_->GetChildren(dir_, &children));
+
+  // The fingerprints of the objects, from the most recently written one.
+  vector<std::pair<int64_t, string>> objects;
+  for (const string& child : children) {
+    if (HasSuffixString(child, kTmpSuffix)) {
+      // Left over by a crash while writing an object.
+      WARN_NOT_OK(env_->DeleteFile(JoinPathSegments(dir_, child)),
+                  "could not delete temporary code cache file");
+      continue;
+    }
+    if (!HasSuffixString(child, kObjectSuffix)) {
+      continue;
+    }
+    int64_t mtime;
+    RETURN_NOT_OK(env_->GetFileModifiedTime(JoinPathSegments(dir_, child), &mtime));
+    objects.emplace_back(-mtime, child.substr(0, child.size() - strlen(kObjectSuffix)));
+  }
+  std::sort(objects.begin(), objects.end());
+
+  std::unordered_map<string, string> warm_objects;
+  int num_entries = 0;
+  for (const auto& object : objects) {
+    const string& fingerprint = object.second;
+    if (num_entries >= capacity_) {
+      WARN_NOT_OK(env_->DeleteFile(PathOf(fingerprint)),
+                  "could not delete code cache file");
+      continue;
+    }
+    num_entries++;
+    if (static_cast<int>(warm_objects.size()) < num_warm_entries) {
+      string obj;
+      if (ReadObject(fingerprint, &obj).ok()) {
+        warm_objects.emplace(fingerprint, std::move(obj));
+      } else {
+        num_entries--;
+      }
+    }
+  }
+
+  std::lock_guard<simple_spinlock> l(lock_);
+  warm_objects_ = std::move(warm_objects);
+  num_entries_ = num_entries;
+  return Status::OK();
+}
+
+string PersistentCodeCache::Fingerprint(const llvm::Module& module,
+                                        const string& cpu,
+                                        const vector<string>& cpu_attrs) {
+  string key;
+  llvm::raw_string_ostream os(key);
+  os << VersionInfo::GetAllVersionInfo() << '\n' << cpu << '\n';
+  for (const string& attr : cpu_attrs) {
+    os << attr << ',';
+  }
+  os << '\n';
+  module.print(os, nullptr);
+  os.flush();
+  uint128 hash = util_hash::CityHash128(key.data(), key.size());
+  return StringPrintf("%016llx%016llx",
+                      static_cast<unsigned long long>(Uint128High64(hash)), // NOLINT(*)
+                      static_cast<unsigned long long>(Uint128Low64(hash))); // NOLINT(*)
+}
+
+void PersistentCodeCache::notifyObjectCompiled(const llvm::Module* module,
+                                               llvm::MemoryBufferRef obj) {
+  const string fingerprint = module->getModuleIdentifier();
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (num_entries_ >= capacity_) {
+      return;
+    }
+    num_entries_++;
+  }
+
+  faststring contents;
+  uint32_t crc = crc::Crc32c(obj.getBufferStart(), obj.getBufferSize());
+  contents.append(&crc, sizeof(crc));
+  contents.append(obj.getBufferStart(), obj.getBufferSize());
+
+  // Write the object to a temporary file first, so that a crash never leaves
+  // a partially written object behind.
+  const string path = PathOf(fingerprint);
+  const string tmp_path = path + kTmpSuffix;
+  Status s = WriteStringToFile(env_, Slice(contents), tmp_path);
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    WARN_NOT_OK(s, "could not write to the code cache");
+    WARN_NOT_OK(env_->DeleteFile(tmp_path), "could not delete temporary code cache file");
+    std::lock_guard<simple_spinlock> l(lock_);
+    num_entries_--;
+  }
+}
+
+unique_ptr<llvm::MemoryBuffer> PersistentCodeCache::getObject(const llvm::Module* module) {
+  const string fingerprint = module->getModuleIdentifier();
+  string obj;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    auto it = warm_objects_.find(fingerprint);
+    if (it != warm_objects_.end()) {
+      // The object is now going to be in the in-memory code cache.
+      obj = std::move(it->second);
+      warm_objects_.erase(it);
+    }
+  }
+  if (obj.empty()) {
+    if (!env_->FileExists(PathOf(fingerprint)) || !ReadObject(fingerprint, &obj).ok()) {
+      return nullptr;
+    }
+  }
+  hits_.Increment();
+  return llvm::MemoryBuffer::getMemBufferCopy(obj, fingerprint);
+}
+
+string PersistentCodeCache::PathOf(const string& fingerprint) const {
+  return JoinPathSegments(dir_, fingerprint + kObjectSuffix);
+}
+
+Status PersistentCodeCache::ReadObject(const string& fingerprint, string* obj) {
+  const string path = PathOf(fingerprint);
+  faststring contents;
+  RETURN_NOT_OK(ReadFileToString(env_, path, &contents));
+  uint32_t crc;
+  if (contents.size() > sizeof(crc)) {
+    memcpy(&crc, contents.data(), sizeof(crc));
+    Slice data(contents.data() + sizeof(crc), contents.size() - sizeof(crc));
+    if (crc::Crc32c(data.data(), data.size()) == crc) {
+      *obj = data.ToString();
+      return Status::OK();
+    }
+  }
+  LOG(WARNING) << "Removing corrupt code cache file " << path;
+  WARN_NOT_OK(env_->DeleteFile(path), "could not delete code cache file");
+  std::lock_guard<simple_spinlock> l(lock_);
+  num_entries_--;
+  return Status::Corruption("corrupt code cache file", path);
+}
+
+} // namespace codegen
+} // namespace kudu
@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/atomic.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class MemoryBuffer;
+class MemoryBufferRef;
+class Module;
+} // namespace llvm
+
+namespace kudu {
+
+class Env;
+
+namespace codegen {
+
+// An object cache which keeps the object code of compiled modules in files
+// of a directory, so that it survives restarts of the process.
+//
+// The object code of a module is looked up by the module's identifier, which
+// the ModuleBuilder sets to the module's Fingerprint() before compiling it.
+// Each file holds the CRC32C checksum of the object code followed by the
+// object code itself; files which fail the checksum are ignored and removed.
+//
+// This class is thread-safe.
+class PersistentCodeCache : public llvm::ObjectCache {
+ public:
+  // Keeps at most 'capacity' objects in 'dir'.
+  PersistentCodeCache(Env* env, std::string dir, int capacity);
+  ~PersistentCodeCache();
+
+  // Creates the directory if it's missing, removes the least recently
+  // written objects beyond the capacity and loads the 'num_warm_entries' most
+  // recently written ones into memory, so that they're not read from disk
+  // when they are first looked up.
+  Status Init(int num_warm_entries);
+
+  // Returns the fingerprint of the (fully optimized) 'module' compiled for
+  // the host CPU 'cpu' with the attributes 'cpu_attrs' by this build of Kudu.
+  static std::string Fingerprint(const llvm::Module& module,
+                                 const std::string& cpu,
+                                 const std::vector<std::string>& cpu_attrs);
+
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef obj) OVERRIDE;
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) OVERRIDE;
+
+  // The number of objects which were found in the cache.
+  int64_t hits() const { return hits_.Load(kMemOrderNoBarrier); }
+
+ private:
+  std::string PathOf(const std::string& fingerprint) const;
+
+  // Reads and verifies the object with the given fingerprint from its file,
+  // removing the file if it's corrupt.
+  Status ReadObject(const std::string& fingerprint, std::string* obj);
+
+  Env* const env_;
+  const std::string dir_;
+  const int capacity_;
+
+  // Protects the members below.
+  simple_spinlock lock_;
+  // The objects loaded by Init(), by fingerprint.
+  std::unordered_map<std::string, std::string> warm_objects_;
+  // The number of objects in 'dir_'.
+  int num_entries_;
+
+  AtomicInt<int64_t> hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(PersistentCodeCache);
+};
+
+} // namespace codegen
+} // namespace kudu
@@ -0,0 +1,496 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/predicate_evaluator.h"
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <glog/logging.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/Attributes.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "kudu/codegen/module_builder.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/strcat.h"
+
+namespace llvm {
+class LLVMContext;
+} // namespace llvm
+
+using llvm::Argument;
+using llvm::BasicBlock;
+using llvm::ConstantFP;
+using llvm::Function;
+using llvm::FunctionType;
+using llvm::LLVMContext;
+using llvm::PHINode;
+using llvm::PointerType;
+using llvm::Type;
+using llvm::Value;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+DECLARE_bool(codegen_dump_functions);
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+// How the cells of a physical type are compared in the generated code. These
+// match DataTypeTraits<>::Compare(), which considers a NaN to be equal to
+// every other value.
+enum class CompareKind {
+  SIGNED,
+  UNSIGNED,
+  FLOAT
+};
+
+// Returns whether cells of 'type' can be compared by the generated code,
+// setting 'kind' accordingly if so.
+bool GetCompareKind(DataType type, CompareKind* kind) {
+  switch (type) {
+    case INT8:
+    case INT16:
+    case INT32:
+    case INT64:
+      *kind = CompareKind::SIGNED;
+      return true;
+    case BOOL:
+    case UINT8:
+    case UINT16:
+    case UINT32:
+    case UINT64:
+      *kind = CompareKind::UNSIGNED;
+      return true;
+    case FLOAT:
+    case DOUBLE:
+      *kind = CompareKind::FLOAT;
+      return true;
+    default:
+      return false;
+  }
+}
+
+Status CheckCompilable(const ColumnPredicate& pred) {
+  CompareKind kind;
+  switch (pred.predicate_type()) {
+    case PredicateType::None:
+    case PredicateType::IsNull:
+    case PredicateType::IsNotNull:
+      return Status::OK();
+    case PredicateType::Equality:
+    case PredicateType::Range:
+      if (!GetCompareKind(pred.column().type_info()->physical_type(), &kind)) {
+        return Status::NotSupported("cannot compile predicate on column type",
+                                    pred.ToString());
+      }
+      return Status::OK();
+    default:
+      return Status::NotSupported("cannot compile predicate type", pred.ToString());
+  }
+}
+
+// Returns the constant 'value' of the given physical type as an LLVM value.
+Value* MakeConstant(ModuleBuilder::LLVMBuilder* builder, DataType type,
+                    const void* value) {
+  switch (type) {
+    case FLOAT:
+      return ConstantFP::get(builder->getFloatTy(),
+                             UnalignedLoad<float>(value));
+    case DOUBLE:
+      return ConstantFP::get(builder->getDoubleTy(),
+                             UnalignedLoad<double>(value));
+    default: {
+      // Integers are built from their bit pattern, regardless of signedness.
+      size_t size = GetTypeInfo(type)->size();
+      uint64_t bits = 0;
+      memcpy(&bits, value, size);
+      return builder->getIntN(size * 8, bits);
+    }
+  }
+}
+
+// The values of a predicate's column which the generated code loads once,
+// before the loop over the rows.
+struct ColumnValues {
+  // The type of the column's cells.
+  Type* cell_type;
+  // The cells of the column, as a pointer to 'cell_type'.
+  Value* data;
+  // The non-null bitmap of the column, or nullptr if it isn't nullable.
+  Value* non_null_bitmap;
+};
+
+// Returns a value which is true if the row at 'row_idx' isn't null in
+// 'non_null_bitmap'.
+Value* MakeIsNotNull(ModuleBuilder::LLVMBuilder* builder,
+                     Value* non_null_bitmap, Value* row_idx) {
+  Value* byte_ptr = builder->CreateGEP(builder->getInt8Ty(), non_null_bitmap,
+                                       builder->CreateLShr(row_idx, 3));
+  Value* byte = builder->CreateLoad(builder->getInt8Ty(), byte_ptr);
+  Value* shift = builder->CreateTrunc(builder->CreateAnd(row_idx, 7),
+                                      builder->getInt8Ty());
+  Value* bit = builder->CreateAnd(builder->CreateLShr(byte, shift), 1);
+  return builder->CreateICmpNE(bit, builder->getInt8(0));
+}
+
+// Returns a value which is true if the row at 'row_idx' satisfies 'pred'.
+// The value is computed without branches, so cells are loaded even if they're
+// null; the result for such rows is then masked by the non-null bitmap.
+Value* MakeRowPasses(ModuleBuilder::LLVMBuilder* builder,
+                     const ColumnPredicate& pred,
+                     const ColumnValues& col,
+                     Value* row_idx) {
+  const bool nullable = col.non_null_bitmap != nullptr;
+  switch (pred.predicate_type()) {
+    case PredicateType::None:
+      return builder->getFalse();
+    case PredicateType::IsNull:
+      if (!nullable) return builder->getFalse();
+      return builder->CreateNot(MakeIsNotNull(builder, col.non_null_bitmap, row_idx));
+    case PredicateType::IsNotNull:
+      if (!nullable) return builder->getTrue();
+      return MakeIsNotNull(builder, col.non_null_bitmap, row_idx);
+    case PredicateType::Equality:
+    case PredicateType::Range:
+      break;
+    default:
+      LOG(FATAL) << "unexpected predicate: " << pred.ToString();
+  }
+
+  DataType type = pred.column().type_info()->physical_type();
+  CompareKind kind;
+  CHECK(GetCompareKind(type, &kind));
+  Value* cell = builder->CreateLoad(col.cell_type,
+                                    builder->CreateGEP(col.cell_type, col.data, row_idx));
+
+  Value* passes = builder->getTrue();
+  if (pred.predicate_type() == PredicateType::Equality) {
+    Value* value = MakeConstant(builder, type, pred.raw_lower());
+    passes = kind == CompareKind::FLOAT ? builder->CreateFCmpUEQ(cell, value)
+                                        : builder->CreateICmpEQ(cell, value);
+  } else {
+    if (pred.raw_lower() != nullptr) {
+      Value* lower = MakeConstant(builder, type, pred.raw_lower());
+      Value* ge = nullptr;
+      switch (kind) {
+        case CompareKind::SIGNED: ge = builder->CreateICmpSGE(cell, lower); break;
+        case CompareKind::UNSIGNED: ge = builder->CreateICmpUGE(cell, lower); break;
+        case CompareKind::FLOAT: ge = builder->CreateFCmpUGE(cell, lower); break;
+      }
+      passes = builder->CreateAnd(passes, ge);
+    }
+    if (pred.raw_upper() != nullptr) {
+      Value* upper = MakeConstant(builder, type, pred.raw_upper());
+      Value* lt = nullptr;
+      switch (kind) {
+        case CompareKind::SIGNED: lt = builder->CreateICmpSLT(cell, upper); break;
+        case CompareKind::UNSIGNED: lt = builder->CreateICmpULT(cell, upper); break;
+        case CompareKind::FLOAT: lt = builder->CreateFCmpOLT(cell, upper); break;
+      }
+      passes = builder->CreateAnd(passes, lt);
+    }
+  }
+  if (nullable) {
+    passes = builder->CreateAnd(passes, MakeIsNotNull(builder, col.non_null_bitmap, row_idx));
+  }
+  return passes;
+}
+
+// Returns a value which is true if the row at 'row_idx' satisfies all of
+// 'preds'.
+Value* MakeRowPassesAll(ModuleBuilder::LLVMBuilder* builder,
+                        const vector<ColumnPredicate>& preds,
+                        const vector<ColumnValues>& cols,
+                        Value* row_idx) {
+  Value* passes = builder->getTrue();
+  for (size_t i = 0; i < preds.size(); i++) {
+    passes = builder->CreateAnd(passes, MakeRowPasses(builder, preds[i], cols[i], row_idx));
+  }
+  return passes;
+}
+
+// Generates a function which evaluates the conjunction of 'preds' of the form:
+// void(const uint8_t* const* col_data, const uint8_t* const* non_null_bitmaps,
+//      uint8_t* selection, int64_t nrows)
+//
+// Like the precompiled ColumnPredicate::Evaluate(), the main loop processes
+// eight rows at a time and evaluates every one of them regardless of whether
+// it's already deselected, so that it's free of branches. The constant bounds
+// of the predicates are baked into the comparisons.
+Function* MakeEvaluator(const string& name,
+                        ModuleBuilder* mbuilder,
+                        const vector<ColumnPredicate>& preds) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+
+  Type* byte_ptr_ty = Type::getInt8PtrTy(context);
+  vector<Type*> argtypes = { PointerType::getUnqual(byte_ptr_ty),
+                             PointerType::getUnqual(byte_ptr_ty),
+                             byte_ptr_ty,
+                             Type::getInt64Ty(context) };
+  FunctionType* fty = FunctionType::get(Type::getVoidTy(context), argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* col_data = &*it++;
+  Argument* non_null_bitmaps = &*it++;
+  Argument* selection = &*it++;
+  Argument* nrows = &*it++;
+  DCHECK(it == f->arg_end());
+
+  col_data->setName("col_data");
+  non_null_bitmaps->setName("non_null_bitmaps");
+  selection->setName("selection");
+  nrows->setName("nrows");
+
+  // The selection vector never aliases the column data or bitmaps, which lets
+  // LLVM keep the loaded cells and bitmap bytes in registers. Note that these
+  // arguments are 0-based indexes.
+  f->addParamAttr(0, llvm::Attribute::NoAlias);
+  f->addParamAttr(1, llvm::Attribute::NoAlias);
+  f->addParamAttr(2, llvm::Attribute::NoAlias);
+
+  BasicBlock* entry = BasicBlock::Create(context, "entry", f);
+  BasicBlock* chunk_header = BasicBlock::Create(context, "chunk_header", f);
+  BasicBlock* chunk_body = BasicBlock::Create(context, "chunk_body", f);
+  BasicBlock* tail_header = BasicBlock::Create(context, "tail_header", f);
+  BasicBlock* tail_body = BasicBlock::Create(context, "tail_body", f);
+  BasicBlock* exit = BasicBlock::Create(context, "exit", f);
+
+  // Load the column pointers once.
+  builder->SetInsertPoint(entry);
+  vector<ColumnValues> cols;
+  cols.reserve(preds.size());
+  for (size_t i = 0; i < preds.size(); i++) {
+    const ColumnPredicate& pred = preds[i];
+    ColumnValues col = { nullptr, nullptr, nullptr };
+    switch (pred.predicate_type()) {
+      case PredicateType::Equality:
+      case PredicateType::Range: {
+        Value* data = builder->CreateLoad(byte_ptr_ty,
+                                          builder->CreateConstGEP1_64(byte_ptr_ty, col_data, i));
+        DataType type = pred.column().type_info()->physical_type();
+        switch (type) {
+          case FLOAT: col.cell_type = builder->getFloatTy(); break;
+          case DOUBLE: col.cell_type = builder->getDoubleTy(); break;
+          default: col.cell_type = builder->getIntNTy(GetTypeInfo(type)->size() * 8); break;
+        }
+        col.data = builder->CreateBitCast(data, PointerType::getUnqual(col.cell_type),
+                                          StrCat("data", i));
+        break;
+      }
+      default:
+        break;
+    }
+    if (pred.column().is_nullable()) {
+      col.non_null_bitmap = builder->CreateLoad(
+          byte_ptr_ty, builder->CreateConstGEP1_64(byte_ptr_ty, non_null_bitmaps, i),
+          StrCat("non_null_bitmap", i));
+    }
+    cols.push_back(col);
+  }
+  Value* nchunks = builder->CreateLShr(nrows, 3, "nchunks");
+  Value* tail_start = builder->CreateShl(nchunks, 3, "tail_start");
+  builder->CreateBr(chunk_header);
+
+  // for (chunk = 0; chunk < nchunks; chunk++)
+  builder->SetInsertPoint(chunk_header);
+  PHINode* chunk = builder->CreatePHI(builder->getInt64Ty(), 2, "chunk");
+  chunk->addIncoming(builder->getInt64(0), entry);
+  builder->CreateCondBr(builder->CreateICmpULT(chunk, nchunks), chunk_body, tail_header);
+
+  //   selection[chunk] &= <bitmap of the eight rows which pass>
+  builder->SetInsertPoint(chunk_body);
+  Value* base_row = builder->CreateShl(chunk, 3);
+  Value* result = builder->getInt8(0);
+  for (int j = 0; j < 8; j++) {
+    Value* row_idx = builder->CreateAdd(base_row, builder->getInt64(j));
+    Value* passes = MakeRowPassesAll(builder, preds, cols, row_idx);
+    Value* bit = builder->CreateShl(builder->CreateZExt(passes, builder->getInt8Ty()), j);
+    result = builder->CreateOr(result, bit);
+  }
+  Value* sel_byte_ptr = builder->CreateGEP(builder->getInt8Ty(), selection, chunk);
+  Value* sel_byte = builder->CreateLoad(builder->getInt8Ty(), sel_byte_ptr);
+  builder->CreateStore(builder->CreateAnd(sel_byte, result), sel_byte_ptr);
+  Value* next_chunk = builder->CreateAdd(chunk, builder->getInt64(1));
+  chunk->addIncoming(next_chunk, chunk_body);
+  builder->CreateBr(chunk_header);
+
+  // for (row = nchunks * 8; row < nrows; row++)
+  builder->SetInsertPoint(tail_header);
+  PHINode* row = builder->CreatePHI(builder->getInt64Ty(), 2, "row");
+  row->addIncoming(tail_start, chunk_header);
+  builder->CreateCondBr(builder->CreateICmpULT(row, nrows), tail_body, exit);
+
+  //   if (!passes) selection[row / 8] &= ~(1 << (row % 8))
+  builder->SetInsertPoint(tail_body);
+  Value* passes = MakeRowPassesAll(builder, preds, cols, row);
+  Value* shift = builder->CreateTrunc(builder->CreateAnd(row, 7), builder->getInt8Ty());
+  Value* fails = builder->CreateZExt(builder->CreateNot(passes), builder->getInt8Ty());
+  Value* tail_sel_ptr = builder->CreateGEP(builder->getInt8Ty(), selection,
+                                           builder->CreateLShr(row, 3));
+  Value* tail_sel_byte = builder->CreateLoad(builder->getInt8Ty(), tail_sel_ptr);
+  Value* mask = builder->CreateNot(builder->CreateShl(fails, shift));
+  builder->CreateStore(builder->CreateAnd(tail_sel_byte, mask), tail_sel_ptr);
+  Value* next_row = builder->CreateAdd(row, builder->getInt64(1));
+  row->addIncoming(next_row, tail_body);
+  builder->CreateBr(tail_header);
+
+  builder->SetInsertPoint(exit);
+  builder->CreateRetVoid();
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping predicate evaluator:";
+    f->print(llvm::errs(), nullptr);
+  }
+
+  return f;
+}
+
+// Convenience method which appends to a faststring
+template<typename T>
+void AddNext(faststring* fs, const T& val) {
+  fs->append(&val, sizeof(T));
+}
+
+} // anonymous namespace
+
+PredicateEvaluatorFunctions::PredicateEvaluatorFunctions(faststring key,
+                                                         EvalFunction eval_f,
+                                                         unique_ptr<JITCodeOwner> owner)
+  : JITWrapper(std::move(owner)),
+    key_(std::move(key)),
+    eval_f_(eval_f) {
+  CHECK(eval_f != nullptr)
+    << "Promise to compile predicate evaluator not fulfilled by ModuleBuilder";
+}
+
+Status PredicateEvaluatorFunctions::Create(const vector<ColumnPredicate>& predicates,
+                                           scoped_refptr<PredicateEvaluatorFunctions>* out,
+                                           llvm::TargetMachine** tm) {
+  faststring key;
+  RETURN_NOT_OK(EncodeKey(predicates, &key));
+
+  ModuleBuilder builder;
+  RETURN_NOT_OK(builder.Init());
+
+  Function* eval = MakeEvaluator("PredEval", &builder, predicates);
+  EvalFunction eval_f;
+  builder.AddJITPromise(eval, &eval_f);
+
+  unique_ptr<JITCodeOwner> owner;
+  RETURN_NOT_OK(builder.Compile(&owner));
+
+  if (tm) {
+    *tm = builder.GetTargetMachine();
+  }
+  out->reset(new PredicateEvaluatorFunctions(std::move(key), eval_f, std::move(owner)));
+  return Status::OK();
+}
+
+// Generates a key for a conjunction of predicates which is unique according
+// to the criteria defined in the CodeCache class' block comment. It encodes,
+// in sequence:
+//
+// (1 byte) unique type identifier for PredicateEvaluatorFunctions
+// (8 bytes) number, as unsigned long, of predicates
+// for each predicate, in order:
+//   4 bytes for the physical type of the column
+//   1 byte for nullability
+//   4 bytes for the predicate type
+//   1 byte for the presence of a lower bound (or equality value), then the
+//     value's cell bytes if present
+//   1 byte for the presence of an upper bound, then the value's cell bytes if
+//     present
+//
+// Writes to 'out' upon success.
+Status PredicateEvaluatorFunctions::EncodeKey(const vector<ColumnPredicate>& predicates,
+                                              faststring* out) {
+  for (const ColumnPredicate& pred : predicates) {
+    RETURN_NOT_OK(CheckCompilable(pred));
+  }
+
+  AddNext(out, JITWrapper::PREDICATE_EVALUATOR);
+  AddNext(out, predicates.size());
+  for (const ColumnPredicate& pred : predicates) {
+    const TypeInfo* type_info = pred.column().type_info();
+    AddNext(out, type_info->physical_type());
+    AddNext(out, pred.column().is_nullable());
+    AddNext(out, pred.predicate_type());
+    bool has_bounds = pred.predicate_type() == PredicateType::Equality ||
+                      pred.predicate_type() == PredicateType::Range;
+    for (const void* bound : { pred.raw_lower(), pred.raw_upper() }) {
+      bool has_bound = has_bounds && bound != nullptr;
+      AddNext(out, has_bound);
+      if (has_bound) {
+        out->append(bound, type_info->size());
+      }
+    }
+  }
+  return Status::OK();
+}
+
+PredicateEvaluator::PredicateEvaluator(const Schema& schema,
+                                       const vector<ColumnPredicate>& predicates,
+                                       scoped_refptr<PredicateEvaluatorFunctions> functions)
+  : functions_(std::move(functions)) {
+  col_idxs_.reserve(predicates.size());
+  for (const ColumnPredicate& pred : predicates) {
+    int idx = schema.find_column(pred.column().name());
+    CHECK_NE(idx, Schema::kColumnNotFound) << "unknown column in predicate: "
+                                           << pred.ToString();
+    col_idxs_.push_back(idx);
+  }
+}
+
+void PredicateEvaluator::Evaluate(RowBlock* block) const {
+  vector<const uint8_t*> col_data(col_idxs_.size());
+  vector<const uint8_t*> non_null_bitmaps(col_idxs_.size());
+  for (size_t i = 0; i < col_idxs_.size(); i++) {
+    ColumnBlock cblock = block->column_block(col_idxs_[i]);
+    col_data[i] = cblock.data();
+    non_null_bitmaps[i] = cblock.non_null_bitmap();
+  }
+  functions_->eval()(col_data.data(), non_null_bitmaps.data(),
+                     block->selection_vector()->mutable_bitmap(), block->nrows());
+}
+
+} // namespace codegen
+} // namespace kudu
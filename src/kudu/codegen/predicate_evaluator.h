@@ -0,0 +1,111 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/generic_iterators.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class TargetMachine;
+} // namespace llvm
+
+namespace kudu {
+
+class RowBlock;
+class Schema;
+
+namespace codegen {
+
+// The JITWrapper for codegen::PredicateEvaluator functions. Contains the
+// compiled function, which evaluates a conjunction of column predicates over
+// a block of rows in a single loop, specialized for the types and nullability
+// of the columns and the constant bounds of the predicates.
+//
+// Only Equality, Range, IsNull, IsNotNull and None predicates over columns of
+// fixed-size types, other than INT128, can be compiled.
+class PredicateEvaluatorFunctions : public JITWrapper {
+ public:
+  // Compiles the evaluator of the conjunction of 'predicates', in order.
+  // Writes the llvm::TargetMachine* used to 'tm' (if not NULL) and the
+  // functions to 'out' upon success.
+  static Status Create(const std::vector<ColumnPredicate>& predicates,
+                       scoped_refptr<PredicateEvaluatorFunctions>* out,
+                       llvm::TargetMachine** tm = NULL);
+
+  // Evaluates the predicates over the first 'nrows' rows, clearing the bits
+  // of 'selection' for the rows which don't satisfy all of them. Element i of
+  // 'col_data' and 'non_null_bitmaps' are the data and the non-null bitmap of
+  // the column of the i-th predicate; the bitmap may be null if the column
+  // isn't nullable.
+  typedef void(*EvalFunction)(const uint8_t* const* col_data,
+                              const uint8_t* const* non_null_bitmaps,
+                              uint8_t* selection,
+                              int64_t nrows);
+  EvalFunction eval() const { return eval_f_; }
+
+  Status EncodeOwnKey(faststring* out) OVERRIDE {
+    out->append(key_.data(), key_.size());
+    return Status::OK();
+  }
+
+  // Returns NotSupported if 'predicates' can't be compiled.
+  static Status EncodeKey(const std::vector<ColumnPredicate>& predicates,
+                          faststring* out);
+
+ private:
+  PredicateEvaluatorFunctions(faststring key,
+                              EvalFunction eval_f,
+                              std::unique_ptr<JITCodeOwner> owner);
+
+  // The key of the predicates the function was compiled for. The predicates
+  // themselves don't own their bounds, so they can't be kept around.
+  const faststring key_;
+  const EvalFunction eval_f_;
+};
+
+// Evaluates a conjunction of predicates over row blocks of a given schema
+// with a compiled PredicateEvaluatorFunctions.
+class PredicateEvaluator : public RowBlockPredicateEvaluator {
+ public:
+  // Requires that 'functions' were compiled for predicates with the same
+  // types, nullability and bounds as 'predicates', in the same order.
+  PredicateEvaluator(const Schema& schema,
+                     const std::vector<ColumnPredicate>& predicates,
+                     scoped_refptr<PredicateEvaluatorFunctions> functions);
+
+  void Evaluate(RowBlock* block) const OVERRIDE;
+
+ private:
+  // The index in the schema of the column of each predicate.
+  std::vector<int> col_idxs_;
+  scoped_refptr<PredicateEvaluatorFunctions> functions_;
+
+  DISALLOW_COPY_AND_ASSIGN(PredicateEvaluator);
+};
+
+} // namespace codegen
+} // namespace kudu
@@ -38,7 +38,8 @@ class ColumnMaterializationContext {
       pred_(pred),
       block_(block),
       sel_(sel),
-      decoder_eval_status_(kNotSet) {
+      decoder_eval_status_(kNotSet),
+      selected_rows_only_(false) {
       if (!pred_ || !sel || !block) {
         decoder_eval_status_ = kDecoderEvalNotSupported;
       }
@@ -79,6 +80,21 @@ class ColumnMaterializationContext {
     return pred_ && pred_->predicate_type() == PredicateType::IsNull;
   }
 
+  // Checked by CFileIterator::Scan() to determine whether the cells of rows
+  // whose bit is already cleared in sel() may be left unmaterialized (on true).
+  // The contents of such cells are then undefined.
+  bool MaterializeSelectedRowsOnly() const {
+    return selected_rows_only_;
+  }
+
+  // Should be called before materializing a column if none of the consumers
+  // of the block looks at the cells of unselected rows, so that the column
+  // iterator can skip decoding them.
+  void SetMaterializeSelectedRowsOnly() {
+    DCHECK(sel_ != nullptr);
+    selected_rows_only_ = true;
+  }
+
   // A context should not switch from supporting decoder-level eval to not
   // supporting it, or vice versa.
   //
@@ -138,6 +154,8 @@ class ColumnMaterializationContext {
   SelectionVector* const sel_;
 
   DecoderEvalStatus decoder_eval_status_;
+
+  bool selected_rows_only_;
 };
 
 } // namespace kudu
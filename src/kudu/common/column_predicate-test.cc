@@ -1466,6 +1466,46 @@ TEST_F(TestColumnPredicate, TestEquals) {
   ASSERT_NE(ColumnPredicate::None(c1), ColumnPredicate::None(c1dflt));
 }
 
+// Test checking predicates against the bounds of a range of values.
+TEST_F(TestColumnPredicate, TestRangeBounds) {
+  ColumnSchema column("c", INT32, true);
+  const int32_t kMin = 10;
+  const int32_t kMax = 20;
+  int32_t five = 5;
+  int32_t ten = 10;
+  int32_t fifteen = 15;
+  int32_t twenty = 20;
+  int32_t twenty_one = 21;
+
+  ASSERT_FALSE(ColumnPredicate::None(column).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::IsNull(column).MayMatchRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::IsNotNull(column).MayMatchRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::IsNotNull(column).MatchesAllInRange(&kMin, &kMax));
+
+  ASSERT_TRUE(ColumnPredicate::Equality(column, &ten).MayMatchRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Equality(column, &twenty).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Equality(column, &five).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Equality(column, &twenty_one).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Equality(column, &ten).MatchesAllInRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Equality(column, &ten).MatchesAllInRange(&kMin, &kMin));
+
+  // Ranges have an exclusive upper bound.
+  ASSERT_FALSE(ColumnPredicate::Range(column, &five, &ten).MayMatchRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Range(column, &five, &twenty_one).MayMatchRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Range(column, &five, &twenty_one).MatchesAllInRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Range(column, &fifteen, nullptr).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Range(column, &fifteen, nullptr).MatchesAllInRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Range(column, &twenty_one, nullptr).MayMatchRange(&kMin, &kMax));
+  ASSERT_FALSE(ColumnPredicate::Range(column, nullptr, &twenty).MatchesAllInRange(&kMin, &kMax));
+  ASSERT_TRUE(ColumnPredicate::Range(column, nullptr, &twenty_one).MatchesAllInRange(&kMin,
+                                                                                     &kMax));
+
+  vector<const void*> outside = { &five, &twenty_one };
+  ASSERT_FALSE(ColumnPredicate::InList(column, &outside).MayMatchRange(&kMin, &kMax));
+  vector<const void*> inside = { &five, &fifteen, &twenty_one };
+  ASSERT_TRUE(ColumnPredicate::InList(column, &inside).MayMatchRange(&kMin, &kMax));
+}
+
 using TestColumnPredicateDeathTest = TestColumnPredicate;
 
 // Ensure that ColumnPredicate::Merge(other) requires the 'other' predicate to
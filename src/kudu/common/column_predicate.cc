@@ -718,6 +718,75 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
   }
 }
 
+// The maximum number of cells whose results are accumulated into a bitmap on
+// the stack by ApplyPredicateToCellsPrimitive() before being applied to the
+// selection vector.
+constexpr size_t kMaxCellsPerBatch = 1024;
+
+// Evaluates 'p' on 'nrows' contiguous primitive cells, and ANDs the result
+// into 'sel'. Like ApplyPredicatePrimitive(), this evaluates every cell
+// regardless of whether it's already deselected so that the inner loop is
+// branch-free and may be vectorized by the compiler.
+template <DataType PhysicalType, typename P>
+ATTRIBUTE_NOINLINE
+void ApplyPredicateToCellsPrimitive(const void* cells, size_t nrows,
+                                    SelectionVectorView* sel, P p) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  const cpp_type* data = reinterpret_cast<const cpp_type*>(cells);
+  uint8_t result[kMaxCellsPerBatch / 8];
+  size_t done = 0;
+  while (done < nrows) {
+    const size_t batch = std::min(nrows - done, kMaxCellsPerBatch);
+    const size_t n_chunks = batch / 8;
+    for (size_t i = 0; i < n_chunks; i++) {
+      uint8_t res_8 = 0;
+      for (int j = 0; j < 8; j++) {
+        res_8 |= p(data + i * 8 + j) << j;
+      }
+      result[i] = res_8;
+    }
+    // Don't read past the end of the cells for the last partial chunk.
+    if (batch % 8 != 0) {
+      uint8_t res_8 = 0;
+      for (size_t j = 0; j < batch % 8; j++) {
+        res_8 |= p(data + n_chunks * 8 + j) << j;
+      }
+      result[n_chunks] = res_8;
+    }
+    sel->AndBitmap(result, batch);
+    sel->Advance(batch);
+    data += batch;
+    done += batch;
+  }
+}
+
+// Slow path for ApplyPredicateToCells() for predicates which can't be
+// evaluated branch-free, or for non-primitive types: only evaluates 'p' on
+// cells that are still selected.
+template <DataType PhysicalType, typename P>
+void ApplyPredicateToCellsSlow(const void* cells, size_t nrows,
+                               SelectionVectorView* sel, P p) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  const cpp_type* data = reinterpret_cast<const cpp_type*>(cells);
+  for (size_t i = 0; i < nrows; i++) {
+    if (sel->TestBit(i) && !p(&data[i])) {
+      sel->ClearBit(i);
+    }
+  }
+}
+
+template <DataType PhysicalType, typename P>
+void ApplyPredicateToCells(const void* cells, size_t nrows, SelectionVectorView* sel, P p) {
+  using cpp_type = typename DataTypeTraits<PhysicalType>::cpp_type;
+  if (std::is_fundamental<cpp_type>::value) {
+    // Work on a copy of the view, since the primitive path advances it.
+    SelectionVectorView view = *sel;
+    ApplyPredicateToCellsPrimitive<PhysicalType>(cells, nrows, &view, p);
+  } else {
+    ApplyPredicateToCellsSlow<PhysicalType>(cells, nrows, sel, p);
+  }
+}
+
 template<bool IS_NOT_NULL>
 void ApplyNullPredicate(const ColumnBlock& block, uint8_t* __restrict__ sel_vec) {
   int n_bytes = KUDU_ALIGN_UP(block.nrows(), 8) / 8;
@@ -796,6 +865,78 @@ void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
   LOG(FATAL) << "unknown predicate type";
 }
 
+template <DataType PhysicalType>
+void ColumnPredicate::EvaluateNonNullCells(const void* cells, size_t nrows,
+                                           SelectionVectorView* sel) const {
+  using traits = DataTypeTraits<PhysicalType>;
+  using cpp_type = typename traits::cpp_type;
+
+  switch (predicate_type()) {
+    case PredicateType::Range: {
+      cpp_type local_lower = lower_ ? *static_cast<const cpp_type*>(lower_) : cpp_type();
+      cpp_type local_upper = upper_ ? *static_cast<const cpp_type*>(upper_) : cpp_type();
+
+      if (lower_ == nullptr) {
+        ApplyPredicateToCells<PhysicalType>(cells, nrows, sel, [local_upper] (const void* cell) {
+            return traits::Compare(cell, &local_upper) < 0;
+        });
+      } else if (upper_ == nullptr) {
+        ApplyPredicateToCells<PhysicalType>(cells, nrows, sel, [local_lower] (const void* cell) {
+            return traits::Compare(cell, &local_lower) >= 0;
+        });
+      } else {
+        ApplyPredicateToCells<PhysicalType>(cells, nrows, sel,
+                                            [local_lower, local_upper] (const void* cell) {
+            return traits::Compare(cell, &local_upper) < 0 &&
+                   traits::Compare(cell, &local_lower) >= 0;
+        });
+      }
+      return;
+    };
+    case PredicateType::Equality: {
+      cpp_type local_lower = lower_ ? *static_cast<const cpp_type*>(lower_) : cpp_type();
+      ApplyPredicateToCells<PhysicalType>(cells, nrows, sel, [local_lower] (const void* cell) {
+            return traits::Compare(cell, &local_lower) == 0;
+      });
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::None:
+    case PredicateType::IsNull: {
+      sel->ClearBits(nrows);
+      return;
+    }
+    case PredicateType::InList:
+    case PredicateType::InBloomFilter: {
+      ApplyPredicateToCellsSlow<PhysicalType>(cells, nrows, sel, [this] (const void* cell) {
+          return EvaluateCell<PhysicalType>(cell);
+      });
+      return;
+    };
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+#define INSTANTIATE_EVALUATE_NON_NULL_CELLS(type) \
+  template void ColumnPredicate::EvaluateNonNullCells<type>( \
+      const void* cells, size_t nrows, SelectionVectorView* sel) const
+
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(BOOL);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(INT8);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(INT16);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(INT32);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(INT64);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(INT128);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(UINT8);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(UINT16);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(UINT32);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(UINT64);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(FLOAT);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(DOUBLE);
+INSTANTIATE_EVALUATE_NON_NULL_CELLS(BINARY);
+
+#undef INSTANTIATE_EVALUATE_NON_NULL_CELLS
+
 bool ColumnPredicate::EvaluateCell(DataType type, const void* cell) const {
   switch (type) {
     case BOOL: return EvaluateCell<BOOL>(cell);
@@ -937,6 +1078,53 @@ bool ColumnPredicate::CheckValueInBloomFilter(const void* value) const {
   return EvaluateCell(column_.type_info()->physical_type(), value);
 }
 
+bool ColumnPredicate::MayMatchRange(const void* min, const void* max) const {
+  const TypeInfo* type_info = column_.type_info();
+  switch (predicate_type_) {
+    case PredicateType::None:
+    case PredicateType::IsNull:
+      return false;
+    case PredicateType::IsNotNull:
+      return true;
+    case PredicateType::Equality:
+      return type_info->Compare(lower_, min) >= 0 && type_info->Compare(lower_, max) <= 0;
+    case PredicateType::Range:
+    case PredicateType::InBloomFilter:
+      // The bounds of a bloom filter predicate are optional, in which case
+      // they are unset and do not restrict the range.
+      return (lower_ == nullptr || type_info->Compare(lower_, max) <= 0) &&
+             (upper_ == nullptr || type_info->Compare(upper_, min) > 0);
+    case PredicateType::InList: {
+      // The values are sorted, so find the first one which is not below 'min'.
+      auto it = std::lower_bound(values_.begin(), values_.end(), min,
+                                 [type_info](const void* lhs, const void* rhs) {
+                                   return type_info->Compare(lhs, rhs) < 0;
+                                 });
+      return it != values_.end() && type_info->Compare(*it, max) <= 0;
+    }
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+bool ColumnPredicate::MatchesAllInRange(const void* min, const void* max) const {
+  const TypeInfo* type_info = column_.type_info();
+  switch (predicate_type_) {
+    case PredicateType::IsNotNull:
+      return true;
+    case PredicateType::Equality:
+      return type_info->Compare(lower_, min) == 0 && type_info->Compare(lower_, max) == 0;
+    case PredicateType::Range:
+      return (lower_ == nullptr || type_info->Compare(lower_, min) <= 0) &&
+             (upper_ == nullptr || type_info->Compare(upper_, max) > 0);
+    case PredicateType::None:
+    case PredicateType::IsNull:
+    case PredicateType::InList:
+    case PredicateType::InBloomFilter:
+      return false;
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
 namespace {
 int SelectivityRank(const ColumnPredicate& predicate) {
   int rank;
@@ -38,6 +38,7 @@ namespace kudu {
 class Arena;
 class ColumnBlock;
 class SelectionVector;
+class SelectionVectorView;
 
 enum class PredicateType {
   // A predicate which always evaluates to false.
@@ -180,6 +181,16 @@ class ColumnPredicate {
   // same vector as block->selection_vector().
   void Evaluate(const ColumnBlock& block, SelectionVector* sel) const;
 
+  // Evaluate the predicate on 'nrows' contiguous non-null cells of the given
+  // physical type, starting at 'cells'.
+  //
+  // This is evaluated as an 'AND' with the current contents of the first
+  // 'nrows' rows of '*sel', in the same way as Evaluate(). It's used by block
+  // decoders to evaluate predicates on values as they're decoded, without
+  // materializing them into a ColumnBlock first.
+  template <DataType PhysicalType>
+  void EvaluateNonNullCells(const void* cells, size_t nrows, SelectionVectorView* sel) const;
+
   // Evaluate the predicate on a single cell.
   template <DataType PhysicalType>
   bool EvaluateCell(const void* cell) const {
@@ -225,6 +236,18 @@ class ColumnPredicate {
   // Otherwise, use EvaluateCell<DataType>.
   bool EvaluateCell(DataType type, const void* cell) const;
 
+  // Returns false if no non-null value in the inclusive range ['min', 'max']
+  // can satisfy the predicate. May conservatively return true.
+  //
+  // This is used to skip over blocks of values for which the minimum and
+  // maximum are known, without having to decode the values themselves.
+  bool MayMatchRange(const void* min, const void* max) const;
+
+  // Returns true if every non-null value in the inclusive range
+  // ['min', 'max'] is known to satisfy the predicate. May conservatively
+  // return false.
+  bool MatchesAllInRange(const void* min, const void* max) const;
+
   // Print the predicate for debugging.
   std::string ToString() const;
 
@@ -20,6 +20,7 @@
 #include <emmintrin.h>
 #include <immintrin.h>
 
+#include <algorithm>
 #include <cstring>
 #include <ostream>
 #include <string>
@@ -467,6 +468,51 @@ size_t div_sizeof_type(size_t s, size_t divisor) {
   }
 }
 
+// Copy the selected cells of the BOOL column 'cblock' into 'dst' as bits of a
+// bitmap, along with their non-null-bitmap bits, according to the given 'sel_rows'.
+// 'dst' already holds 'initial_rows' rows.
+void CopySelectedBoolCellsAsBitmap(const ColumnBlock& cblock,
+                                   const SelectedRows& sel_rows,
+                                   size_t initial_rows,
+                                   ColumnarSerializedBatch::Column* dst) {
+  DCHECK_EQ(BOOL, cblock.type_info()->physical_type());
+  DCHECK(dst->packed_bools);
+  size_t n_rows = cblock.nrows();
+  size_t new_num_rows = initial_rows + sel_rows.num_selected();
+
+  // Pack all the cells of the block, clearing the bits of the null cells, and
+  // then extract the bits of the selected rows as for the non-null bitmap.
+  faststring packed;
+  packed.resize(BitmapSize(n_rows));
+  const uint8_t* cells = cblock.cell_ptr(0);
+  for (size_t i = 0; i < n_rows; i += 8) {
+    uint8_t byte = 0;
+    for (size_t j = 0; j < 8 && i + j < n_rows; j++) {
+      byte |= static_cast<uint8_t>(cells[i + j] != 0) << j;
+    }
+    packed[i / 8] = byte;
+  }
+  if (cblock.is_nullable()) {
+    const uint8_t* non_nulls = cblock.non_null_bitmap();
+    for (size_t i = 0; i < packed.size(); i++) {
+      packed[i] &= non_nulls[i];
+    }
+  }
+
+  DCHECK_EQ(dst->data.size(), BitmapSize(initial_rows));
+  dst->data.resize_with_extra_capacity(BitmapSize(new_num_rows));
+  CopyNonNullBitmap(packed.data(), sel_rows.bitmap(), initial_rows, n_rows, dst->data.data());
+
+  if (cblock.is_nullable()) {
+    DCHECK_EQ(dst->non_null_bitmap->size(), BitmapSize(initial_rows));
+    dst->non_null_bitmap->resize_with_extra_capacity(BitmapSize(new_num_rows));
+    CopyNonNullBitmap(cblock.non_null_bitmap(),
+                      sel_rows.bitmap(),
+                      initial_rows, n_rows,
+                      dst->non_null_bitmap->data());
+  }
+}
+
 // Copy the selected primitive cells (and non-null-bitmap bits) from 'cblock' into 'dst'
 // according to the given 'sel_rows'.
 void CopySelectedCellsFromColumn(const ColumnBlock& cblock,
@@ -504,14 +550,21 @@ void CopySelectedCellsFromColumn(const ColumnBlock& cblock,
 }
 
 
+// The minimum size of each buffer in the chain holding varlen data.
+constexpr size_t kVarlenChunkSize = 256 * 1024;
+
 // For each of the Slices in 'cells_buf', copy the pointed-to data into 'varlen' and
 // write the _end_ offset of the copied data into 'offsets_out'. This assumes (and
 // DCHECKs) that the _start_ offset of each cell was already previously written by a
 // previous invocation of this function.
+//
+// The data is appended to the last buffer of 'varlen' if it fits in that
+// buffer's capacity, and to a new buffer otherwise. Offsets are relative to
+// the start of the whole chain.
 void CopySlicesAndWriteEndOffsets(const Slice* __restrict__ cells_buf,
                                   const SelectedRows& sel_rows,
                                   uint32_t* __restrict__ offsets_out,
-                                  faststring* varlen) {
+                                  vector<faststring>* varlen) {
   const Slice* cell_slices = reinterpret_cast<const Slice*>(cells_buf);
   size_t total_added_size = 0;
   sel_rows.ForEachIndex(
@@ -521,12 +574,21 @@ void CopySlicesAndWriteEndOffsets(const Slice* __restrict__ cells_buf,
 
   // The output array should already have an entry for the start offset
   // of our first cell.
-  DCHECK_EQ(offsets_out[-1], varlen->size());
+  uint32_t start_offset = offsets_out[-1];
 
-  int old_size = varlen->size();
-  varlen->resize_with_extra_capacity(old_size + total_added_size);
-
-  uint8_t* dst_base = varlen->data();
+  if (varlen->empty() ||
+      varlen->back().capacity() - varlen->back().size() < total_added_size) {
+    varlen->emplace_back();
+    varlen->back().reserve(std::max(kVarlenChunkSize, total_added_size));
+  }
+  faststring* chunk = &varlen->back();
+  int old_size = chunk->size();
+  DCHECK_GE(start_offset, old_size);
+  chunk->resize(old_size + total_added_size);
+
+  // The offset of the start of the chunk within the chain.
+  uint32_t chunk_offset = start_offset - old_size;
+  uint8_t* dst_base = chunk->data();
   uint8_t* dst = dst_base + old_size;
 
   sel_rows.ForEachIndex(
@@ -536,7 +598,7 @@ void CopySlicesAndWriteEndOffsets(const Slice* __restrict__ cells_buf,
           strings::memcpy_inlined(dst, s->data(), s->size());
         }
         dst += s->size();
-        *offsets_out++ = dst - dst_base;
+        *offsets_out++ = chunk_offset + (dst - dst_base);
       });
 }
 
@@ -555,7 +617,7 @@ void CopySelectedVarlenCellsFromColumn(const ColumnBlock& cblock,
 
   // If this is the first call, append a '0' entry for the offset of the first string.
   if (dst->data.size() == 0) {
-    CHECK_EQ(dst->varlen_data->size(), 0);
+    CHECK(dst->varlen_data->empty());
     offset_type zero_offset = 0;
     dst->data.append(&zero_offset, sizeof(zero_offset));
   }
@@ -587,9 +649,20 @@ void CopySelectedVarlenCellsFromColumn(const ColumnBlock& cblock,
 } // anonymous namespace
 } // namespace internal
 
+size_t ColumnarSerializedBatch::Column::varlen_data_size() const {
+  size_t size = 0;
+  if (varlen_data) {
+    for (const auto& chunk : *varlen_data) {
+      size += chunk.size();
+    }
+  }
+  return size;
+}
+
 ColumnarSerializedBatch::ColumnarSerializedBatch(const Schema& rowblock_schema,
                                                  const Schema& client_schema,
-                                                 int expected_batch_size_bytes) {
+                                                 int expected_batch_size_bytes,
+                                                 bool pack_bools) {
   // Initialize buffers for the columns.
   int64_t row_bytes = client_schema.byte_size();
   columns_.reserve(client_schema.num_columns());
@@ -610,6 +683,7 @@ ColumnarSerializedBatch::ColumnarSerializedBatch(const Schema& rowblock_schema,
     if (schema_col.is_nullable()) {
       col.non_null_bitmap.emplace();
     }
+    col.packed_bools = pack_bools && schema_col.type_info()->physical_type() == BOOL;
   }
 }
 
@@ -629,6 +703,12 @@ int ColumnarSerializedBatch::AddRowBlock(const RowBlock& block) {
           column_block,
           sel,
           &columns_[col_idx]);
+    } else if (col.packed_bools) {
+      internal::CopySelectedBoolCellsAsBitmap(
+          column_block,
+          sel,
+          num_rows_,
+          &columns_[col_idx]);
     } else {
       internal::CopySelectedCellsFromColumn(
           column_block,
@@ -638,6 +718,7 @@ int ColumnarSerializedBatch::AddRowBlock(const RowBlock& block) {
     col_idx++;
   }
 
+  num_rows_ += sel.num_selected();
   return sel.num_selected();
 }
 
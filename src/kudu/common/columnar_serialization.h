@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -42,9 +43,14 @@ class ColumnarSerializedBatch {
   // 'expected_batch_size_bytes':
   //      the batch size at which the caller expects to stop adding new rows to
   //      this batch. This is is only a hint and does not affect correctness.
+  //
+  // 'pack_bools': if true, the cells of BOOL columns are packed into a bitmap
+  //               with a set bit for each true cell, as in Arrow's layout,
+  //               rather than taking a byte each.
   ColumnarSerializedBatch(const Schema& rowblock_schema,
                           const Schema& client_schema,
-                          int expected_batch_size_bytes);
+                          int expected_batch_size_bytes,
+                          bool pack_bools = false);
 
   // Append the data in 'block' into this columnar batch.
   //
@@ -58,11 +64,21 @@ class ColumnarSerializedBatch {
     // Underlying column data.
     faststring data;
 
-    // Data for varlen columns (those with BINARY physical type)
-    boost::optional<faststring> varlen_data;
+    // Data for varlen columns (those with BINARY physical type), as a chain of
+    // buffers to be sent back to back. Starting a new buffer when the last one
+    // is full avoids copying the data buffered so far, as growing a single
+    // buffer would.
+    boost::optional<std::vector<faststring>> varlen_data;
+
+    // Returns the total size of 'varlen_data'.
+    size_t varlen_data_size() const;
 
     // Each bit is set when a value is non-null
     boost::optional<faststring> non_null_bitmap;
+
+    // Whether 'data' holds a bitmap of the cells of a BOOL column rather than
+    // a byte per cell. The bits of null cells are cleared.
+    bool packed_bools = false;
   };
 
   const std::vector<Column>& columns() const {
@@ -76,6 +92,9 @@ class ColumnarSerializedBatch {
  private:
   friend class WireProtocolTest;
   std::vector<Column> columns_;
+
+  // The number of rows added to the batch so far.
+  int64_t num_rows_ = 0;
 };
 
 
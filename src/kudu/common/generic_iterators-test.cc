@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <ostream>
 #include <random>
 #include <string>
@@ -56,6 +57,7 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_int32(num_lists, 3, "Number of lists to merge");
 DEFINE_int32(num_rows, 1000, "Number of entries per list");
@@ -500,6 +502,26 @@ TEST(TestMergeIterator, TestDeDupGhostRows) {
                       /*include_deleted_rows=*/true));
 }
 
+// Merges many more inputs than the other tests, which exercises the hot
+// tournament tree at a depth where copying runs of rows from one input matters.
+// With --num_iters and --num_rows raised, this doubles as a merge benchmark.
+TEST(TestMergeIterator, TestMergeManyLists) {
+  google::FlagSaver saver;
+  FLAGS_num_lists = AllowSlowTests() ? 200 : 37;
+  TestIntRangePredicate predicate(0, MathLimits<int64_t>::kMax);
+  NO_FATALS(TestMerge(kIntSchema, predicate));
+  NO_FATALS(TestMerge(kIntSchema, predicate, /*overlapping_ranges=*/false));
+}
+
+TEST(TestMergeIterator, TestDeDupGhostRowsManyLists) {
+  google::FlagSaver saver;
+  FLAGS_num_lists = 37;
+  TestIntRangePredicate match_all_pred(0, MathLimits<int64_t>::kMax);
+  NO_FATALS(TestMerge(kIntSchemaWithVCol, match_all_pred,
+                      /*overlapping_ranges=*/true,
+                      /*include_deleted_rows=*/true));
+}
+
 // Test that the MaterializingIterator properly evaluates predicates when they apply
 // to single columns.
 TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
@@ -531,6 +553,53 @@ TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
   ASSERT_FALSE(dst.selection_vector()->IsRowSelected(30));
 }
 
+// Test that a ParallelUnionIterator yields exactly the selected rows of its
+// sub-iterators, reading them with several threads.
+TEST(TestParallelUnionIterator, TestUnion) {
+  const int kNumIters = 10;
+  const int kRowsPerIter = 1000;
+
+  unique_ptr<ThreadPool> pool;
+  ASSERT_OK(ThreadPoolBuilder("test").set_max_threads(4).Build(&pool));
+
+  vector<IterWithBounds> iters;
+  for (int i = 0; i < kNumIters; i++) {
+    vector<int64_t> ints(kRowsPerIter);
+    for (int j = 0; j < kRowsPerIter; j++) {
+      ints[j] = i * kRowsPerIter + j;
+    }
+    unique_ptr<VectorIterator> colwise(new VectorIterator(ints));
+    colwise->set_block_size(100);
+    IterWithBounds iwb;
+    iwb.iter = NewMaterializingIterator(std::move(colwise));
+    iters.emplace_back(std::move(iwb));
+  }
+  unique_ptr<RowwiseIterator> iter(NewParallelUnionIterator(std::move(iters), pool.get(), 4));
+
+  // Select the first half of the values.
+  ScanSpec spec;
+  TestIntRangePredicate pred(0, kNumIters * kRowsPerIter / 2);
+  spec.AddPredicate(pred.pred_);
+  ASSERT_OK(iter->Init(&spec));
+
+  vector<int64_t> results;
+  Arena arena(1024);
+  RowBlock dst(&kIntSchema, 100, &arena);
+  while (iter->HasNext()) {
+    ASSERT_OK(iter->NextBlock(&dst));
+    for (size_t i = 0; i < dst.nrows(); i++) {
+      if (dst.selection_vector()->IsRowSelected(i)) {
+        results.push_back(*kIntSchema.ExtractColumnFromRow<INT64>(dst.row(i), kValColIdx));
+      }
+    }
+  }
+  std::sort(results.begin(), results.end());
+  ASSERT_EQ(kNumIters * kRowsPerIter / 2, results.size());
+  for (int i = 0; i < results.size(); i++) {
+    ASSERT_EQ(i, results[i]);
+  }
+}
+
 // Test that PredicateEvaluatingIterator will properly evaluate predicates on its
 // input.
 TEST(TestPredicateEvaluatingIterator, TestPredicateEvaluation) {
@@ -595,6 +664,49 @@ TEST(TestPredicateEvaluatingIterator, TestDontWrapWhenNoPredicates) {
       << "InitAndMaybeWrap should not have wrapped iter";
 }
 
+// Test that PredicateEvaluatingIterator reorders its predicates as it goes, so
+// that those which filter out the most rows for the least work come first.
+TEST(TestPredicateEvaluatingIterator, TestAdaptivePredicateOrder) {
+  const int kNumRows = 1024;
+  const int kBlockSize = 64;
+  Schema schema({ ColumnSchema("a", INT64),
+                  ColumnSchema("b", INT64) }, 1);
+  vector<int64_t> ints(kNumRows);
+  std::iota(ints.begin(), ints.end(), 0);
+
+  // Both predicates are ranges, so the one on the first column is evaluated
+  // first at the start, even though it doesn't filter out any rows.
+  int64_t zero = 0;
+  int64_t ten = 10;
+  int64_t num_rows = kNumRows;
+  auto a_range = ColumnPredicate::Range(schema.column(0), &zero, &num_rows);
+  auto b_range = ColumnPredicate::Range(schema.column(1), &zero, &ten);
+  ScanSpec spec;
+  spec.AddPredicate(a_range);
+  spec.AddPredicate(b_range);
+
+  unique_ptr<VectorIterator> colwise(
+      new VectorIterator(ints, vector<uint8_t>(kNumRows), schema));
+  colwise->set_block_size(kBlockSize);
+  google::FlagSaver saver;
+  FLAGS_materializing_iterator_do_pushdown = false;
+  unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(std::move(colwise)));
+  ASSERT_OK(InitAndMaybeWrap(&iter, &spec));
+  ASSERT_EQ(GetIteratorPredicatesForTests(iter),
+            vector<ColumnPredicate>({ a_range, b_range }));
+
+  Arena arena(1024);
+  RowBlock dst(&schema, kBlockSize, &arena);
+  int selected = 0;
+  while (iter->HasNext()) {
+    ASSERT_OK(iter->NextBlock(&dst));
+    selected += dst.selection_vector()->CountSelected();
+  }
+  ASSERT_EQ(10, selected);
+  ASSERT_EQ(GetIteratorPredicatesForTests(iter),
+            vector<ColumnPredicate>({ b_range, a_range }));
+}
+
 // Test row-wise iterator which does nothing.
 class DummyIterator : public RowwiseIterator {
  public:
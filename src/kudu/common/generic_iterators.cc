@@ -20,6 +20,7 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
@@ -50,15 +51,23 @@
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/casts.h"
+#include "kudu/gutil/cycleclock-inl.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/object_pool.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/threadpool.h"
+#include "kudu/util/trace.h"
 
 namespace boost {
 namespace heap {
@@ -82,6 +91,16 @@ DEFINE_bool(materializing_iterator_decoder_eval, true,
             "Should MaterializingIterator do decoder-level evaluation");
 TAG_FLAG(materializing_iterator_decoder_eval, hidden);
 TAG_FLAG(materializing_iterator_decoder_eval, runtime);
+DEFINE_bool(materializing_iterator_skip_unselected_rows, true,
+            "Should MaterializingIterator skip decoding the cells of rows which "
+            "have been deleted or filtered out by a predicate");
+TAG_FLAG(materializing_iterator_skip_unselected_rows, hidden);
+TAG_FLAG(materializing_iterator_skip_unselected_rows, runtime);
+DEFINE_bool(adaptive_predicate_order, true,
+            "Should iterators which evaluate several predicates reorder them "
+            "by their measured cost and selectivity");
+TAG_FLAG(adaptive_predicate_order, hidden);
+TAG_FLAG(adaptive_predicate_order, runtime);
 
 namespace kudu {
 namespace {
@@ -94,6 +113,36 @@ void AddIterStats(const RowwiseIterator& iter,
     (*stats)[i] += iter_stats[i];
   }
 }
+
+// The number of batches after which the iterators which evaluate several
+// predicates reorder them by the statistics gathered meanwhile.
+constexpr int kPredicateReorderIntervalBatches = 16;
+
+// The factory of the PredicateEvaluatingIterator's evaluators, if any.
+std::atomic<RowBlockPredicateEvaluatorFactory> predicate_evaluator_factory(nullptr);
+
+// Stably sorts 'preds' by the rank of their statistics in 'stats', which are
+// reordered along with them and decayed.
+template<class T>
+void ReorderPredicates(vector<T>* preds, vector<PredicateStats>* stats) {
+  DCHECK_EQ(preds->size(), stats->size());
+  vector<size_t> order(preds->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right) {
+    return (*stats)[left].Rank() < (*stats)[right].Rank();
+  });
+  vector<T> sorted_preds;
+  vector<PredicateStats> sorted_stats;
+  sorted_preds.reserve(order.size());
+  sorted_stats.reserve(order.size());
+  for (size_t i : order) {
+    sorted_preds.emplace_back(std::move((*preds)[i]));
+    sorted_stats.emplace_back((*stats)[i]);
+    sorted_stats.back().Decay();
+  }
+  *preds = std::move(sorted_preds);
+  *stats = std::move(sorted_stats);
+}
 } // anonymous namespace
 
 ////////////////////////////////////////////////////////////
@@ -112,7 +161,9 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
   explicit MergeIterState(IterWithBounds iwb)
       : iwb_(std::move(iwb)),
         arena_(1024),
-        next_row_idx_(0)
+        next_row_idx_(0),
+        next_key_valid_(false),
+        slot_(-1)
   {}
 
   // Fetches the next row from the iterator's current block, or the iterator's
@@ -128,6 +179,19 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
     return decoded_bounds_->lower;
   }
 
+  // Returns the encoded primary key of the next row in the iterator's current
+  // block, which allows comparing next rows with memcmp().
+  //
+  // The key is encoded lazily, the first time it's needed for a given row.
+  const faststring& next_key() const {
+    DCHECK(read_block_);
+    if (!next_key_valid_) {
+      schema().EncodeComparableKey(next_row_, &next_key_);
+      next_key_valid_ = true;
+    }
+    return next_key_;
+  }
+
   // Fetches the last row from the iterator's current block, or the iterator's
   // absolute upper bound if a block has not yet been pulled.
   //
@@ -185,6 +249,35 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
     return read_block_->nrows() - next_row_idx_;
   }
 
+  // Returns the number of rows, starting at the next row and up to 'max_rows',
+  // that precede the first selected row whose key isn't less than 'limit'.
+  size_t CountRowsBefore(const RowBlockRow& limit, size_t max_rows) const {
+    DCHECK(read_block_);
+    DCHECK_LE(max_rows, remaining_in_block());
+    if (schema().Compare(last_row_, limit) < 0) {
+      return max_rows;
+    }
+    const SelectionVector* sel = read_block_->selection_vector();
+    size_t num_rows = 0;
+    for (; num_rows < max_rows; num_rows++) {
+      size_t row_idx = next_row_idx_ + num_rows;
+      if (sel->IsRowSelected(row_idx) &&
+          schema().Compare(read_block_->row(row_idx), limit) >= 0) {
+        break;
+      }
+    }
+    return num_rows;
+  }
+
+  // The index of this sub-iterator's leaf in the MergeIterator's tournament
+  // tree, assigned when the MergeIterator is initialized.
+  int slot() const {
+    return slot_;
+  }
+  void set_slot(int slot) {
+    slot_ = slot;
+  }
+
   // Returns the schema from the underlying iterator.
   const Schema& schema() const {
     return iwb_.iter->schema();
@@ -193,11 +286,12 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
   // Pulls the next block from the underlying iterator.
   Status PullNextBlock();
 
-  // Copies as many rows as possible from the current block of buffered rows to
-  // 'dst' (starting at 'dst_offset').
+  // Copies as many rows as possible (but no more than 'max_rows') from the
+  // current block of buffered rows to 'dst' (starting at 'dst_offset').
   //
   // If successful, 'num_rows_copied' will be set to the number of rows copied.
-  Status CopyBlock(RowBlock* dst, size_t dst_offset, size_t* num_rows_copied);
+  Status CopyBlock(RowBlock* dst, size_t dst_offset, size_t max_rows,
+                   size_t* num_rows_copied);
 
   // Returns true if the current block in the underlying iterator is exhausted.
   bool IsBlockExhausted() const {
@@ -249,6 +343,13 @@ class MergeIterState : public boost::intrusive::list_base_hook<> {
   // a selected row.
   size_t next_row_idx_;
 
+  // The encoded key of next_row_, if 'next_key_valid_' is true.
+  mutable faststring next_key_;
+  mutable bool next_key_valid_;
+
+  // See slot().
+  int slot_;
+
   DISALLOW_COPY_AND_ASSIGN(MergeIterState);
 };
 
@@ -263,6 +364,7 @@ Status MergeIterState::Advance(size_t num_rows, bool* pulled_new_block) {
       read_block_->selection_vector()->FindFirstRowSelected(next_row_idx_, &idx)) {
     next_row_idx_ = idx;
     next_row_.Reset(read_block_.get(), next_row_idx_);
+    next_key_valid_ = false;
     *pulled_new_block = false;
     return Status::OK();
   }
@@ -279,12 +381,17 @@ Status MergeIterState::Advance(size_t num_rows, bool* pulled_new_block) {
 Status MergeIterState::PullNextBlock() {
   CHECK(IsBlockExhausted())
       << "should not pull next block until current block is exhausted";
+  next_key_valid_ = false;
 
   if (!read_block_) {
     read_block_.reset(new RowBlock(&schema(), kMergeRowBuffer, &arena_));
   }
   while (iwb_.iter->HasNext()) {
-    RETURN_NOT_OK(iwb_.iter->NextBlock(read_block_.get()));
+    {
+      // The sub-iterator's time is attributed to its own stages.
+      SCOPED_SCAN_STAGE_TIMER(ScanStage::kNone);
+      RETURN_NOT_OK(iwb_.iter->NextBlock(read_block_.get()));
+    }
 
     SelectionVector *selection = read_block_->selection_vector();
     DCHECK_EQ(selection->nrows(), read_block_->nrows());
@@ -322,13 +429,14 @@ Status MergeIterState::PullNextBlock() {
   return Status::OK();
 }
 
-Status MergeIterState::CopyBlock(RowBlock* dst, size_t dst_offset,
+Status MergeIterState::CopyBlock(RowBlock* dst, size_t dst_offset, size_t max_rows,
                                  size_t* num_rows_copied) {
   DCHECK(read_block_);
   DCHECK(!IsBlockExhausted());
 
-  size_t num_rows_to_copy = std::min(remaining_in_block(),
-                                     dst->nrows() - dst_offset);
+  size_t num_rows_to_copy = std::min({ remaining_in_block(),
+                                       dst->nrows() - dst_offset,
+                                       max_rows });
   VLOG(3) << Substitute(
       "Copying $0 rows from RowBlock (s:$1,o:$2) to RowBlock (s:$3,o:$4): $5",
       num_rows_to_copy, read_block_->nrows(), next_row_idx_, dst->nrows(),
@@ -339,6 +447,131 @@ Status MergeIterState::CopyBlock(RowBlock* dst, size_t dst_offset,
   return Status::OK();
 }
 
+// A tournament tree over the sub-iterators of a MergeIterator, used to find
+// the hot sub-iterator whose next row has the smallest key.
+//
+// Every sub-iterator owns a fixed leaf (its slot), and every internal node
+// holds the winner of the match between its two children, so that the root
+// holds the overall winner. Empty leaves (i.e. cold or exhausted
+// sub-iterators) lose every match. Changing a leaf replays the matches on its
+// path to the root, which costs exactly log2(N) comparisons and no heap
+// restructuring, and matches compare encoded keys with memcmp() rather than
+// comparing rows column by column.
+//
+// A winner tree is used rather than a loser tree because sub-iterators join
+// and leave the hot set at arbitrary leaves, which a loser tree can't replay
+// without the winners of the sibling subtrees.
+class MergeTournamentTree {
+ public:
+  MergeTournamentTree()
+      : num_leaves_(0),
+        size_(0) {
+  }
+
+  // Resets the tree to have room for 'num_slots' sub-iterators, all absent.
+  void Reset(int num_slots) {
+    num_leaves_ = 1;
+    while (num_leaves_ < num_slots) {
+      num_leaves_ <<= 1;
+    }
+    nodes_.assign(2 * num_leaves_, nullptr);
+    size_ = 0;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  int size() const {
+    return size_;
+  }
+
+  // Returns the sub-iterator with the smallest next row, or nullptr if empty.
+  MergeIterState* top() const {
+    return nodes_[1];
+  }
+
+  // Adds 'state' to the tree.
+  void Push(MergeIterState* state) {
+    int leaf = LeafOf(state);
+    DCHECK(!nodes_[leaf]);
+    nodes_[leaf] = state;
+    size_++;
+    Replay(leaf);
+  }
+
+  // Removes 'state' from the tree.
+  void Remove(MergeIterState* state) {
+    int leaf = LeafOf(state);
+    DCHECK_EQ(state, nodes_[leaf]);
+    nodes_[leaf] = nullptr;
+    size_--;
+    Replay(leaf);
+  }
+
+  // Restores the tree's invariants after the next row of 'state' has changed.
+  void Update(MergeIterState* state) {
+    int leaf = LeafOf(state);
+    DCHECK_EQ(state, nodes_[leaf]);
+    Replay(leaf);
+  }
+
+  // Returns the sub-iterator with the smallest next row other than top(), or
+  // nullptr if there's none.
+  //
+  // Every other leaf belongs to a subtree hanging off the path from top() to
+  // the root, so the runner-up is the best of the winners of those subtrees.
+  MergeIterState* RunnerUp() const {
+    DCHECK(!empty());
+    MergeIterState* best = nullptr;
+    for (int node = LeafOf(top()); node > 1; node >>= 1) {
+      MergeIterState* sibling = nodes_[node ^ 1];
+      if (Less(sibling, best)) {
+        best = sibling;
+      }
+    }
+    return best;
+  }
+
+ private:
+  int LeafOf(const MergeIterState* state) const {
+    DCHECK_GE(state->slot(), 0);
+    DCHECK_LT(state->slot(), num_leaves_);
+    return num_leaves_ + state->slot();
+  }
+
+  // Returns true if 'a' should win a match against 'b'. Ties (only possible
+  // for deleted rows) are broken by slot so that the order is deterministic.
+  static bool Less(const MergeIterState* a, const MergeIterState* b) {
+    if (!a) return false;
+    if (!b) return true;
+    int cmp = Slice(a->next_key()).compare(Slice(b->next_key()));
+    return cmp < 0 || (cmp == 0 && a->slot() < b->slot());
+  }
+
+  // Replays the matches on the path from the leaf at 'node' to the root.
+  void Replay(int node) {
+    for (node >>= 1; node >= 1; node >>= 1) {
+      MergeIterState* left = nodes_[2 * node];
+      MergeIterState* right = nodes_[2 * node + 1];
+      nodes_[node] = Less(right, left) ? right : left;
+    }
+  }
+
+  // The number of leaves, rounded up to a power of two.
+  int num_leaves_;
+
+  // The tree, stored as an implicit binary tree: the root is at index 1, the
+  // children of node i are at 2i and 2i+1, and the leaves start at
+  // 'num_leaves_'.
+  vector<MergeIterState*> nodes_;
+
+  // The number of sub-iterators in the tree.
+  int size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MergeTournamentTree);
+};
+
 // An iterator which merges the results of other iterators, comparing
 // based on keys.
 //
@@ -446,6 +679,13 @@ Status MergeIterState::CopyBlock(RowBlock* dst, size_t dst_offset,
 // moves from COLD to HOT. After that, peeked memory must remain resident until
 // the sub-iterator is fully exhausted.
 //
+// Since HOT is consulted for every merged row while COLD and HOTMAXES are only
+// consulted at block boundaries, HOT is implemented as a tournament tree over
+// encoded keys (see MergeTournamentTree) rather than as a heap. Moreover, when
+// the same sub-iterator wins twice in a row, its following rows are likely to
+// win too: all of its rows that precede the next row of the runner-up are
+// then copied to the output in bulk, as if it were the only HOT sub-iterator.
+//
 // For another description of this algorithm including pseudocode, see
 // https://docs.google.com/document/d/1uP0ubjM6ulnKVCRrXtwT_dqrTWjF9tlFSRk0JN2e_O0/edit#
 class MergeIterator : public RowwiseIterator {
@@ -486,6 +726,15 @@ class MergeIterator : public RowwiseIterator {
   // On success, the selection vector in 'dst' and 'dst_row_idx' are both updated.
   Status MaterializeOneRow(RowBlock* dst, size_t* dst_row_idx);
 
+  // Materializes the run of rows of the top hot sub-iterator that precede the
+  // next row of every other hot sub-iterator into 'dst' at offset
+  // 'dst_row_idx', if the run is longer than one row. Only permitted when
+  // there are at least two sub-iterators in the hot tree.
+  //
+  // On success, 'materialized' is set to whether the run was materialized, in
+  // which case the selection vector in 'dst' and 'dst_row_idx' are updated.
+  Status MaybeMaterializeRun(RowBlock* dst, size_t* dst_row_idx, bool* materialized);
+
   // Calls Init() on all of sub-iterators, wrapping them in predicate evaluating
   // iterators if necessary and setting up additional per-iterator bookkeeping.
   Status InitSubIterators(ScanSpec *spec);
@@ -580,9 +829,16 @@ class MergeIterator : public RowwiseIterator {
   // do not offer ordered iteration.
   //
   // 1. https://www.boost.org/doc/libs/1_69_0/doc/html/heap/data_structures.html
-  MergeStateMinHeap hot_;
+  MergeTournamentTree hot_;
   MergeStateMinHeap cold_;
   RowMinHeap hotmaxes_;
+
+  // The sub-iterator which yielded the most recent row materialized by
+  // MaterializeOneRow(), if it still exists.
+  const MergeIterState* last_winner_;
+
+  // Scratch buffer for the encoded key of the row being deduplicated.
+  faststring dedup_key_;
 };
 
 MergeIterator::MergeIterator(MergeIteratorOptions opts,
@@ -591,7 +847,8 @@ MergeIterator::MergeIterator(MergeIteratorOptions opts,
       initted_(false),
       orig_iters_(std::move(iters)),
       num_orig_iters_(orig_iters_.size()),
-      decoded_bounds_arena_(1024) {
+      decoded_bounds_arena_(1024),
+      last_winner_(nullptr) {
   CHECK_GT(orig_iters_.size(), 0);
 }
 
@@ -640,9 +897,12 @@ Status MergeIterator::Init(ScanSpec *spec) {
       [](MergeIterState* s) { delete s; });
 
   // Establish the merge window and initialize the three heaps.
+  int slot = 0;
   for (auto& s : states_) {
+    s.set_slot(slot++);
     cold_.push(&s);
   }
+  hot_.Reset(slot);
   RETURN_NOT_OK(RefillHotHeap());
 
   initted_ = true;
@@ -675,15 +935,16 @@ Status MergeIterator::InitSubIterators(ScanSpec *spec) {
 
 Status MergeIterator::AdvanceAndReheap(MergeIterState* state,
                                        size_t num_rows_to_advance) {
+  DCHECK_EQ(state, hot_.top());
   bool pulled_new_block;
   RETURN_NOT_OK(state->Advance(num_rows_to_advance, &pulled_new_block));
-  hot_.pop();
 
   // Note that hotmaxes_ is not yet popped as it's not necessary to do so if the
   // merge window hasn't changed. Thus, we can avoid some work by deferring it
   // into the cases below.
 
   if (state->IsFullyExhausted()) {
+    hot_.Remove(state);
     hotmaxes_.pop();
     DestroySubIterator(state);
 
@@ -698,18 +959,19 @@ Status MergeIterator::AdvanceAndReheap(MergeIterState* state,
         schema_->Compare(hotmaxes_.top(), state->next_row()) < 0) {
       // The new block lies beyond the new end of the merge window.
       VLOG(2) << "Block finished, became cold: " << state->ToString();
+      hot_.Remove(state);
       cold_.push(state);
     } else {
       // The new block is still within the merge window.
       VLOG(2) << "Block finished, still hot: " << state->ToString();
-      hot_.push(state);
+      hot_.Update(state);
       hotmaxes_.push(state->last_row());
     }
     RETURN_NOT_OK(RefillHotHeap());
   } else {
     // The sub-iterator's block's upper bound remains the same; the merge window
     // has not changed.
-    hot_.push(state);
+    hot_.Update(state);
   }
   return Status::OK();
 }
@@ -744,7 +1006,7 @@ Status MergeIterator::RefillHotHeap() {
       continue;
     }
     VLOG(2) << "Became hot: " << warmest->ToString();
-    hot_.push(warmest);
+    hot_.Push(warmest);
     hotmaxes_.push(warmest->last_row());
   }
   if (VLOG_IS_ON(2)) {
@@ -759,6 +1021,9 @@ Status MergeIterator::RefillHotHeap() {
 void MergeIterator::DestroySubIterator(MergeIterState* state) {
   DCHECK(state->IsFullyExhausted());
 
+  if (last_winner_ == state) {
+    last_winner_ = nullptr;
+  }
   std::lock_guard<rw_spinlock> l(states_lock_);
   state->AddStats(&finished_iter_stats_by_col_);
   states_.erase_and_dispose(states_.iterator_to(*state),
@@ -769,6 +1034,7 @@ Status MergeIterator::NextBlock(RowBlock* dst) {
   VLOG(3) << "Called NextBlock (" << dst->nrows() << " rows) on " << ToString();
   CHECK(initted_);
   DCHECK_SCHEMA_EQ(*dst->schema(), schema());
+  SCOPED_SCAN_STAGE_TIMER(ScanStage::kMerge);
 
   if (dst->arena()) {
     dst->arena()->Reset();
@@ -791,9 +1057,20 @@ Status MergeIterator::NextBlock(RowBlock* dst) {
     //
     // TODO(adar): this can be further optimized by "attaching" data to 'dst'
     // rather than copying it.
-    if (hot_.size() == 1 && hot_.top()->remaining_in_block() > 1) {
+    //
+    // Otherwise, if the last row came from the same sub-iterator, it may have
+    // a run of rows preceding all other hot sub-iterators' rows; checking for
+    // one costs a comparison, so it's only done when it's likely to pay off.
+    const MergeIterState* top = hot_.top();
+    if (hot_.size() == 1 && top->remaining_in_block() > 1) {
       RETURN_NOT_OK(MaterializeBlock(dst, &dst_row_idx));
-    } else {
+      continue;
+    }
+    bool materialized = false;
+    if (hot_.size() > 1 && top == last_winner_) {
+      RETURN_NOT_OK(MaybeMaterializeRun(dst, &dst_row_idx, &materialized));
+    }
+    if (!materialized) {
       RETURN_NOT_OK(MaterializeOneRow(dst, &dst_row_idx));
     }
   }
@@ -810,11 +1087,39 @@ Status MergeIterator::MaterializeBlock(RowBlock* dst, size_t* dst_row_idx) {
 
   MergeIterState* state = hot_.top();
   size_t num_rows_copied;
-  RETURN_NOT_OK(state->CopyBlock(dst, *dst_row_idx, &num_rows_copied));
+  RETURN_NOT_OK(state->CopyBlock(dst, *dst_row_idx, state->remaining_in_block(),
+                                 &num_rows_copied));
+  RETURN_NOT_OK(AdvanceAndReheap(state, num_rows_copied));
+
+  // CopyBlock() already updated dst's SelectionVector.
+  *dst_row_idx += num_rows_copied;
+  return Status::OK();
+}
+
+Status MergeIterator::MaybeMaterializeRun(RowBlock* dst, size_t* dst_row_idx,
+                                          bool* materialized) {
+  DCHECK_GT(hot_.size(), 1);
+
+  // Rows preceding the runner-up's next row also precede the next rows of all
+  // cold sub-iterators, since those lie beyond the end of the merge window.
+  // They're also unique, so there's nothing to deduplicate.
+  MergeIterState* state = hot_.top();
+  const MergeIterState* runner_up = hot_.RunnerUp();
+  size_t max_rows = std::min(state->remaining_in_block(), dst->nrows() - *dst_row_idx);
+  size_t num_rows = state->CountRowsBefore(runner_up->next_row(), max_rows);
+  if (num_rows <= 1) {
+    *materialized = false;
+    return Status::OK();
+  }
+
+  size_t num_rows_copied;
+  RETURN_NOT_OK(state->CopyBlock(dst, *dst_row_idx, num_rows, &num_rows_copied));
+  DCHECK_EQ(num_rows, num_rows_copied);
   RETURN_NOT_OK(AdvanceAndReheap(state, num_rows_copied));
 
   // CopyBlock() already updated dst's SelectionVector.
   *dst_row_idx += num_rows_copied;
+  *materialized = true;
   return Status::OK();
 }
 
@@ -822,77 +1127,46 @@ Status MergeIterator::MaterializeBlock(RowBlock* dst, size_t* dst_row_idx) {
 // and such around the comparisons. A simple experiment indicated there's some
 // 2x to be gained.
 Status MergeIterator::MaterializeOneRow(RowBlock* dst, size_t* dst_row_idx) {
-  // We need a vector to track the iterators whose next_row() contains the
-  // smallest row key at a given moment during the merge because there may be
-  // multiple deleted rows with the same row key across multiple rowsets, and up
-  // to one live instance, that we have to deduplicate.
-  vector<MergeIterState*> smallest;
-  smallest.reserve(hot_.size());
-
-  // Find the set of sub-iterators whose matching next row keys are the smallest
-  // across all sub-iterators.
-  //
-  // Note: heap ordered iteration isn't the same as a total ordering. For
-  // example, the two absolute smallest keys might be in the same sub-iterator
-  // rather than in the first two sub-iterators yielded via ordered iteration.
-  // However, the goal here is to identify a group of matching keys for the
-  // purpose of deduplication, and we're guaranteed that such matching keys
-  // cannot exist in the same sub-iterator (i.e. the same rowset).
-  for (auto iter = hot_.ordered_begin(); iter != hot_.ordered_end(); ++iter) {
-    MergeIterState* state = *iter;
-    if (!smallest.empty() &&
-        schema_->Compare(state->next_row(), smallest[0]->next_row()) != 0) {
-      break;
-    }
-    smallest.emplace_back(state);
-  }
+  MergeIterState* smallest = hot_.top();
+  VLOG(3) << Substitute("Copying row $0 from $1",
+                        *dst_row_idx, smallest->ToString());
+  RowBlockRow dst_row = dst->row(*dst_row_idx);
+  RETURN_NOT_OK(CopyRow(smallest->next_row(), &dst_row, dst->arena()));
+  last_winner_ = smallest;
 
-  MergeIterState* row_to_return_iter = nullptr;
   if (!opts_.include_deleted_rows) {
     // Since deleted rows are not included here, there can only be a single
-    // instance of any given row key in 'smallest'.
-    CHECK_EQ(1, smallest.size()) << "expected only a single smallest row";
-    row_to_return_iter = smallest[0];
+    // instance of any given row key.
+    RETURN_NOT_OK(AdvanceAndReheap(smallest, /*num_rows_to_advance=*/1));
   } else {
-    // Deduplicate any deleted rows. Row instance de-duplication criteria:
+    // There may be multiple deleted rows with the same row key across multiple
+    // rowsets, and up to one live instance, that we have to deduplicate. Such
+    // instances can't exist in the same sub-iterator (i.e. the same rowset),
+    // and ties in the tournament tree are broken by slot, so they're yielded by
+    // the tree one after the other. Row instance de-duplication criteria:
     // 1. If there is a non-deleted instance, return that instance.
     // 2. If all rows are deleted, any instance will suffice because we
     //    don't guarantee that we will return valid field values for deleted
     //    rows.
-    int live_rows_found = 0;
-    for (const auto& s : smallest) {
+    const int is_deleted_idx = schema_->first_is_deleted_virtual_column_idx();
+    bool live_row_found =
+        !*schema_->ExtractColumnFromRow<IS_DELETED>(smallest->next_row(), is_deleted_idx);
+    const faststring& smallest_key = smallest->next_key();
+    dedup_key_.assign_copy(smallest_key.data(), smallest_key.size());
+    RETURN_NOT_OK(AdvanceAndReheap(smallest, /*num_rows_to_advance=*/1));
+
+    while (!hot_.empty() && Slice(hot_.top()->next_key()) == Slice(dedup_key_)) {
+      MergeIterState* dup = hot_.top();
       bool is_deleted =
-          *schema_->ExtractColumnFromRow<IS_DELETED>(
-              s->next_row(), schema_->first_is_deleted_virtual_column_idx());
+          *schema_->ExtractColumnFromRow<IS_DELETED>(dup->next_row(), is_deleted_idx);
       if (!is_deleted) {
+        DCHECK(!live_row_found) << "expected at most one live row";
         // We found the single live instance of the row.
-        row_to_return_iter = s;
-#ifndef NDEBUG
-        live_rows_found++; // In DEBUG mode, do a sanity-check count of the live rows.
-#else
-        break; // In RELEASE mode, short-circuit the loop.
-#endif
+        RETURN_NOT_OK(CopyRow(dup->next_row(), &dst_row, dst->arena()));
+        live_row_found = true;
       }
+      RETURN_NOT_OK(AdvanceAndReheap(dup, /*num_rows_to_advance=*/1));
     }
-    DCHECK_LE(live_rows_found, 1) << "expected at most one live row";
-
-    // If all instances of a given row are deleted then return an arbitrary
-    // deleted instance.
-    if (row_to_return_iter == nullptr) {
-      row_to_return_iter = smallest[0];
-      DCHECK(*schema_->ExtractColumnFromRow<IS_DELETED>(
-          row_to_return_iter->next_row(), schema_->first_is_deleted_virtual_column_idx()))
-          << "expected deleted row";
-    }
-  }
-  VLOG(3) << Substitute("Copying row $0 from $1",
-                        *dst_row_idx, row_to_return_iter->ToString());
-  RowBlockRow dst_row = dst->row(*dst_row_idx);
-  RETURN_NOT_OK(CopyRow(row_to_return_iter->next_row(), &dst_row, dst->arena()));
-
-  // Advance all matching sub-iterators and remove any that are exhausted.
-  for (auto& s : smallest) {
-    RETURN_NOT_OK(AdvanceAndReheap(s, /*num_rows_to_advance=*/1));
   }
 
   dst->selection_vector()->SetRowSelected(*dst_row_idx);
@@ -1111,6 +1385,305 @@ unique_ptr<RowwiseIterator> NewUnionIterator(vector<IterWithBounds> iters) {
   return unique_ptr<RowwiseIterator>(new UnionIterator(std::move(iters)));
 }
 
+////////////////////////////////////////////////////////////
+// ParallelUnionIterator
+////////////////////////////////////////////////////////////
+
+// An iterator which unions the results of other iterators like UnionIterator,
+// but reads from several of them at once using the threads of a thread pool.
+//
+// Each sub-iterator is read by at most one task at a time. A task reads a
+// single block into a buffer of its own and then returns its sub-iterator to
+// the set of idle ones, so a scanner whose client stops fetching results never
+// ties up a pool thread. NextBlock() hands out the buffered blocks in the
+// order in which they were read, copying them into the caller's block.
+class ParallelUnionIterator : public RowwiseIterator {
+ public:
+  // Constructs a ParallelUnionIterator of the given iterators, reading from
+  // at most 'parallelism' of them at a time using threads of 'pool'.
+  //
+  // The iterators must have matching schemas and should not yet be initialized.
+  // 'pool' must outlive this iterator.
+  ParallelUnionIterator(vector<IterWithBounds> iters, ThreadPool* pool, int parallelism);
+
+  ~ParallelUnionIterator();
+
+  Status Init(ScanSpec *spec) OVERRIDE;
+
+  bool HasNext() const OVERRIDE;
+
+  string ToString() const OVERRIDE;
+
+  const Schema &schema() const OVERRIDE {
+    CHECK(initted_);
+    return *CHECK_NOTNULL(schema_.get());
+  }
+
+  virtual void GetIteratorStats(vector<IteratorStats>* stats) const OVERRIDE;
+
+  virtual Status NextBlock(RowBlock* dst) OVERRIDE;
+
+ private:
+  // A block read by a task, along with the arena for its indirect data.
+  struct Batch {
+    Batch(const Schema* schema, size_t capacity)
+        : arena(32 * 1024),
+          block(schema, capacity, &arena) {
+    }
+    Arena arena;
+    RowBlock block;
+  };
+
+  // Submits tasks to read from idle sub-iterators as long as there is room
+  // for their results.
+  void ScheduleTasksUnlocked();
+
+  // Reads a block from the sub-iterator at 'idx' of 'iters_'.
+  void ReadBlockTask(size_t idx);
+
+  unique_ptr<Schema> schema_;
+
+  bool initted_;
+
+  ThreadPool* const pool_;
+  const int parallelism_;
+
+  // The sub-iterators. The vector itself is not modified after construction;
+  // each sub-iterator is accessed by at most one task at a time.
+  vector<IterWithBounds> iters_;
+
+  // Capacity of the blocks read by tasks, taken from the first block passed
+  // to NextBlock().
+  size_t block_capacity_;
+
+  // Protects all fields below.
+  mutable Mutex lock_;
+
+  // Signaled whenever a task finishes.
+  ConditionVariable task_finished_;
+
+  // Indexes into 'iters_' of the sub-iterators which have more rows and are
+  // not being read by a task.
+  deque<size_t> idle_iters_;
+
+  // Blocks read by tasks and not yet returned by NextBlock().
+  deque<unique_ptr<Batch>> ready_batches_;
+
+  // Blocks whose contents have been returned, available for reuse.
+  vector<unique_ptr<Batch>> free_batches_;
+
+  // The number of submitted tasks which haven't finished yet.
+  int num_running_tasks_;
+
+  // Set when the iterator is being destroyed; no more tasks are submitted.
+  bool stopped_;
+
+  // The first error encountered by a task, if any.
+  Status status_;
+
+  // Statistics (keyed by projection column index) accumulated so far by any
+  // fully-consumed sub-iterators.
+  vector<IteratorStats> finished_iter_stats_by_col_;
+
+  // See UnionIterator::scan_spec_copies_.
+  ObjectPool<ScanSpec> scan_spec_copies_;
+};
+
+ParallelUnionIterator::ParallelUnionIterator(vector<IterWithBounds> iters,
+                                             ThreadPool* pool,
+                                             int parallelism)
+    : initted_(false),
+      pool_(DCHECK_NOTNULL(pool)),
+      parallelism_(parallelism),
+      iters_(std::move(iters)),
+      block_capacity_(0),
+      task_finished_(&lock_),
+      num_running_tasks_(0),
+      stopped_(false) {
+  CHECK_GT(iters_.size(), 0);
+  CHECK_GT(parallelism_, 0);
+}
+
+ParallelUnionIterator::~ParallelUnionIterator() {
+  // Tasks refer to this iterator, so wait for the running ones to finish.
+  MutexLock l(lock_);
+  stopped_ = true;
+  while (num_running_tasks_ > 0) {
+    task_finished_.Wait();
+  }
+}
+
+Status ParallelUnionIterator::Init(ScanSpec *spec) {
+  CHECK(!initted_);
+
+  for (auto& i : iters_) {
+    ScanSpec *spec_copy = spec != nullptr ? scan_spec_copies_.Construct(*spec) : nullptr;
+    RETURN_NOT_OK(InitAndMaybeWrap(&i.iter, spec_copy));
+    i.encoded_bounds.reset();
+  }
+  if (spec != nullptr) {
+    spec->RemovePredicates();
+  }
+
+  schema_.reset(new Schema(iters_.front().iter->schema()));
+  finished_iter_stats_by_col_.resize(schema_->num_columns());
+#ifndef NDEBUG
+  for (const auto& i : iters_) {
+    if (!i.iter->schema().Equals(*schema_)) {
+      return Status::InvalidArgument(
+          Substitute("Schemas do not match: $0 vs. $1",
+                     schema_->ToString(), i.iter->schema().ToString()));
+    }
+  }
+#endif
+
+  MutexLock l(lock_);
+  for (size_t i = 0; i < iters_.size(); i++) {
+    if (iters_[i].iter->HasNext()) {
+      idle_iters_.push_back(i);
+    } else {
+      AddIterStats(*iters_[i].iter, &finished_iter_stats_by_col_);
+    }
+  }
+  initted_ = true;
+  return Status::OK();
+}
+
+bool ParallelUnionIterator::HasNext() const {
+  CHECK(initted_);
+  MutexLock l(lock_);
+  return !status_.ok() ||
+      !ready_batches_.empty() ||
+      !idle_iters_.empty() ||
+      num_running_tasks_ > 0;
+}
+
+Status ParallelUnionIterator::NextBlock(RowBlock* dst) {
+  CHECK(initted_);
+  unique_ptr<Batch> batch;
+  {
+    MutexLock l(lock_);
+    if (block_capacity_ == 0) {
+      block_capacity_ = dst->row_capacity();
+    }
+    ScheduleTasksUnlocked();
+    while (status_.ok() && ready_batches_.empty() && num_running_tasks_ > 0) {
+      task_finished_.Wait();
+    }
+    RETURN_NOT_OK(status_);
+    if (ready_batches_.empty()) {
+      dst->Resize(0);
+      return Status::OK();
+    }
+    batch = std::move(ready_batches_.front());
+    ready_batches_.pop_front();
+    ScheduleTasksUnlocked();
+  }
+
+  // Copy the block outside the lock so that tasks can make progress.
+  const RowBlock& src = batch->block;
+  DCHECK_LE(src.nrows(), dst->row_capacity());
+  dst->Resize(src.nrows());
+  Status s = src.CopyTo(dst, 0, 0, src.nrows());
+
+  batch->arena.Reset();
+  MutexLock l(lock_);
+  free_batches_.emplace_back(std::move(batch));
+  return s;
+}
+
+void ParallelUnionIterator::ScheduleTasksUnlocked() {
+  lock_.AssertAcquired();
+  // Bound the number of buffered blocks so that a slow client doesn't cause
+  // the whole tablet to be read into memory.
+  const size_t max_buffered = 2 * parallelism_;
+  while (!stopped_ &&
+         status_.ok() &&
+         !idle_iters_.empty() &&
+         num_running_tasks_ < parallelism_ &&
+         ready_batches_.size() + num_running_tasks_ < max_buffered) {
+    size_t idx = idle_iters_.front();
+    idle_iters_.pop_front();
+    // Attribute the task's work (e.g. bytes read) to the current RPC's trace.
+    scoped_refptr<Trace> trace(Trace::CurrentTrace());
+    Status s = pool_->Submit([this, idx, trace]() {
+      ADOPT_TRACE(trace.get());
+      this->ReadBlockTask(idx);
+    });
+    if (PREDICT_FALSE(!s.ok())) {
+      status_ = s.CloneAndPrepend("could not submit scan task");
+      return;
+    }
+    num_running_tasks_++;
+  }
+}
+
+void ParallelUnionIterator::ReadBlockTask(size_t idx) {
+  unique_ptr<Batch> batch;
+  {
+    MutexLock l(lock_);
+    if (!free_batches_.empty()) {
+      batch = std::move(free_batches_.back());
+      free_batches_.pop_back();
+    }
+  }
+  if (!batch) {
+    batch.reset(new Batch(schema_.get(), block_capacity_));
+  }
+
+  RowwiseIterator* iter = iters_[idx].iter.get();
+  Status s = iter->NextBlock(&batch->block);
+  bool has_next = s.ok() && iter->HasNext();
+
+  MutexLock l(lock_);
+  if (PREDICT_FALSE(!s.ok())) {
+    if (status_.ok()) {
+      status_ = s;
+    }
+  } else {
+    if (batch->block.nrows() > 0) {
+      ready_batches_.emplace_back(std::move(batch));
+    } else {
+      free_batches_.emplace_back(std::move(batch));
+    }
+    if (has_next) {
+      idle_iters_.push_back(idx);
+    } else {
+      AddIterStats(*iter, &finished_iter_stats_by_col_);
+    }
+  }
+  num_running_tasks_--;
+  ScheduleTasksUnlocked();
+  task_finished_.Broadcast();
+}
+
+string ParallelUnionIterator::ToString() const {
+  string s;
+  s.append(Substitute("ParallelUnion(parallelism=$0, ", parallelism_));
+  s += JoinMapped(iters_, [](const IterWithBounds& i) {
+      return i.iter->ToString();
+    }, ",");
+  s.append(")");
+  return s;
+}
+
+void ParallelUnionIterator::GetIteratorStats(vector<IteratorStats>* stats) const {
+  CHECK(initted_);
+  MutexLock l(lock_);
+  *stats = finished_iter_stats_by_col_;
+  // Sub-iterators being read by a task are skipped to avoid racing with it.
+  for (size_t idx : idle_iters_) {
+    AddIterStats(*iters_[idx].iter, stats);
+  }
+}
+
+unique_ptr<RowwiseIterator> NewParallelUnionIterator(vector<IterWithBounds> iters,
+                                                     ThreadPool* pool,
+                                                     int parallelism) {
+  return unique_ptr<RowwiseIterator>(
+      new ParallelUnionIterator(std::move(iters), pool, parallelism));
+}
+
 ////////////////////////////////////////////////////////////
 // MaterializingIterator
 ////////////////////////////////////////////////////////////
@@ -1147,22 +1720,37 @@ class MaterializingIterator : public RowwiseIterator {
 
   unique_ptr<ColumnwiseIterator> iter_;
 
+  // Gathers statistics about the predicates over the batches, and reorders
+  // them by those statistics every so often.
+  void MaybeReorderPredicates();
+
   // List of (column index, predicate) in order of most to least selective, with
-  // ties broken by the index.
+  // ties broken by the index. If 'adaptive_predicate_order_' is set, they're
+  // reordered by their measured cost and selectivity as the scan proceeds.
   vector<std::pair<int32_t, ColumnPredicate>> col_idx_predicates_;
 
+  // Statistics about each predicate of 'col_idx_predicates_', in the same
+  // order. Only gathered if there are several predicates to order.
+  vector<PredicateStats> predicate_stats_;
+  int batches_until_reorder_;
+
   // List of column indexes without predicates to materialize.
   vector<int32_t> non_predicate_column_indexes_;
 
   // Set only by test code to disallow pushdown.
   bool disallow_pushdown_for_tests_;
   bool disallow_decoder_eval_;
+  bool skip_unselected_rows_;
+  bool adaptive_predicate_order_;
 };
 
 MaterializingIterator::MaterializingIterator(unique_ptr<ColumnwiseIterator> iter)
     : iter_(std::move(iter)),
+      batches_until_reorder_(kPredicateReorderIntervalBatches),
       disallow_pushdown_for_tests_(!FLAGS_materializing_iterator_do_pushdown),
-      disallow_decoder_eval_(!FLAGS_materializing_iterator_decoder_eval) {
+      disallow_decoder_eval_(!FLAGS_materializing_iterator_decoder_eval),
+      skip_unselected_rows_(FLAGS_materializing_iterator_skip_unselected_rows),
+      adaptive_predicate_order_(FLAGS_adaptive_predicate_order) {
 }
 
 Status MaterializingIterator::Init(ScanSpec *spec) {
@@ -1210,6 +1798,8 @@ Status MaterializingIterator::Init(ScanSpec *spec) {
           int comp = SelectivityComparator(left.second, right.second);
           return comp ? comp < 0 : left.first < right.first;
        });
+  predicate_stats_.assign(col_idx_predicates_.size(), PredicateStats());
+  batches_until_reorder_ = kPredicateReorderIntervalBatches;
 
   return Status::OK();
 }
@@ -1228,10 +1818,22 @@ Status MaterializingIterator::NextBlock(RowBlock* dst) {
   dst->Resize(n);
   RETURN_NOT_OK(MaterializeBlock(dst));
   RETURN_NOT_OK(iter_->FinishBatch());
+  MaybeReorderPredicates();
 
   return Status::OK();
 }
 
+void MaterializingIterator::MaybeReorderPredicates() {
+  if (!adaptive_predicate_order_ || col_idx_predicates_.size() < 2) {
+    return;
+  }
+  if (--batches_until_reorder_ > 0) {
+    return;
+  }
+  ReorderPredicates(&col_idx_predicates_, &predicate_stats_);
+  batches_until_reorder_ = kPredicateReorderIntervalBatches;
+}
+
 Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
   // Initialize the selection vector indicating which rows have been
   // been deleted.
@@ -1244,7 +1846,16 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
     return Status::OK();
   }
 
-  for (const auto& col_pred : col_idx_predicates_) {
+  const bool measure_predicates = adaptive_predicate_order_ && col_idx_predicates_.size() > 1;
+  for (size_t i = 0; i < col_idx_predicates_.size(); i++) {
+    const auto& col_pred = col_idx_predicates_[i];
+    int64_t rows_before = 0;
+    int64_t start_cycles = 0;
+    if (measure_predicates) {
+      rows_before = dst->selection_vector()->CountSelected();
+      start_cycles = CycleClock::Now();
+    }
+
     // Materialize the column itself into the row block.
     ColumnBlock dst_col(dst->column_block(get<0>(col_pred)));
     ColumnMaterializationContext ctx(get<0>(col_pred),
@@ -1256,10 +1867,20 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
     if (disallow_decoder_eval_) {
       ctx.SetDecoderEvalNotSupported();
     }
+    // The rows which are already filtered out stay so whatever the values of
+    // their cells, so there's no need to decode them.
+    if (skip_unselected_rows_) {
+      ctx.SetMaterializeSelectedRowsOnly();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
     if (ctx.DecoderEvalNotSupported()) {
+      SCOPED_SCAN_STAGE_TIMER(ScanStage::kPredicateEval);
       get<1>(col_pred).Evaluate(dst_col, dst->selection_vector());
     }
+    if (measure_predicates) {
+      predicate_stats_[i].Add(rows_before, dst->selection_vector()->CountSelected(),
+                              CycleClock::Now() - start_cycles);
+    }
 
     // If after evaluating this predicate the entire row block has been filtered
     // out, we don't need to materialize other columns at all.
@@ -1276,6 +1897,10 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
                                      nullptr,
                                      &dst_col,
                                      dst->selection_vector());
+    // Only the cells of the rows which passed the predicates are returned.
+    if (skip_unselected_rows_) {
+      ctx.SetMaterializeSelectedRowsOnly();
+    }
     RETURN_NOT_OK(iter_->MaterializeColumn(&ctx));
   }
 
@@ -1330,15 +1955,43 @@ class PredicateEvaluatingIterator : public RowwiseIterator {
   const vector<ColumnPredicate>& col_predicates() const { return col_predicates_; }
 
  private:
+  // Asks the factory set by SetRowBlockPredicateEvaluatorFactory(), if any,
+  // for an evaluator of 'col_predicates_'.
+  void MaybeCreateEvaluator();
+
   unique_ptr<RowwiseIterator> base_iter_;
 
-  // List of predicates in order of most to least selective, with
-  // ties broken by the column index.
+  // List of predicates in order of most to least selective, with ties broken
+  // by the column index. If 'adaptive_predicate_order_' is set, they're
+  // reordered by their measured cost and selectivity as the scan proceeds.
   vector<ColumnPredicate> col_predicates_;
+
+  // Statistics about each predicate of 'col_predicates_', in the same order.
+  // Only gathered if there are several predicates to order.
+  vector<PredicateStats> predicate_stats_;
+  int batches_until_reorder_;
+  const bool adaptive_predicate_order_;
+
+  // If set, evaluates all of 'col_predicates_' in a single pass over each
+  // block. Since it may only become available some time after the scan
+  // starts (e.g. once its code is compiled), it's requested again every
+  // 'kPredicateReorderIntervalBatches' batches until it is.
+  unique_ptr<RowBlockPredicateEvaluator> evaluator_;
+  int batches_until_evaluator_request_;
 };
 
 PredicateEvaluatingIterator::PredicateEvaluatingIterator(unique_ptr<RowwiseIterator> base_iter)
-    : base_iter_(std::move(base_iter)) {
+    : base_iter_(std::move(base_iter)),
+      batches_until_reorder_(kPredicateReorderIntervalBatches),
+      adaptive_predicate_order_(FLAGS_adaptive_predicate_order),
+      batches_until_evaluator_request_(kPredicateReorderIntervalBatches) {
+}
+
+void PredicateEvaluatingIterator::MaybeCreateEvaluator() {
+  batches_until_evaluator_request_ = kPredicateReorderIntervalBatches;
+  RowBlockPredicateEvaluatorFactory factory = predicate_evaluator_factory.load();
+  if (factory == nullptr || col_predicates_.empty()) return;
+  evaluator_ = factory(schema(), col_predicates_);
 }
 
 Status PredicateEvaluatingIterator::Init(ScanSpec *spec) {
@@ -1363,6 +2016,10 @@ Status PredicateEvaluatingIterator::Init(ScanSpec *spec) {
           return schema().find_column(left.column().name())
                < schema().find_column(right.column().name());
        });
+  predicate_stats_.assign(col_predicates_.size(), PredicateStats());
+  batches_until_reorder_ = kPredicateReorderIntervalBatches;
+  evaluator_.reset();
+  MaybeCreateEvaluator();
 
   return Status::OK();
 }
@@ -1373,13 +2030,31 @@ bool PredicateEvaluatingIterator::HasNext() const {
 
 Status PredicateEvaluatingIterator::NextBlock(RowBlock *dst) {
   RETURN_NOT_OK(base_iter_->NextBlock(dst));
+  SCOPED_SCAN_STAGE_TIMER(ScanStage::kPredicateEval);
+
+  if (evaluator_) {
+    evaluator_->Evaluate(dst);
+    return Status::OK();
+  }
 
-  for (const auto& predicate : col_predicates_) {
+  const bool measure_predicates = adaptive_predicate_order_ && col_predicates_.size() > 1;
+  for (size_t i = 0; i < col_predicates_.size(); i++) {
+    const auto& predicate = col_predicates_[i];
     int32_t col_idx = dst->schema()->find_column(predicate.column().name());
     if (col_idx == Schema::kColumnNotFound) {
       return Status::InvalidArgument("Unknown column in predicate", predicate.ToString());
     }
+    int64_t rows_before = 0;
+    int64_t start_cycles = 0;
+    if (measure_predicates) {
+      rows_before = dst->selection_vector()->CountSelected();
+      start_cycles = CycleClock::Now();
+    }
     predicate.Evaluate(dst->column_block(col_idx), dst->selection_vector());
+    if (measure_predicates) {
+      predicate_stats_[i].Add(rows_before, dst->selection_vector()->CountSelected(),
+                              CycleClock::Now() - start_cycles);
+    }
 
     // If after evaluating this predicate, the entire row block has now been
     // filtered out, we don't need to evaluate any further predicates.
@@ -1388,6 +2063,13 @@ Status PredicateEvaluatingIterator::NextBlock(RowBlock *dst) {
     }
   }
 
+  if (measure_predicates && --batches_until_reorder_ == 0) {
+    ReorderPredicates(&col_predicates_, &predicate_stats_);
+    batches_until_reorder_ = kPredicateReorderIntervalBatches;
+  }
+  if (--batches_until_evaluator_request_ == 0) {
+    MaybeCreateEvaluator();
+  }
   return Status::OK();
 }
 
@@ -1408,6 +2090,10 @@ Status InitAndMaybeWrap(unique_ptr<RowwiseIterator>* base_iter,
   return Status::OK();
 }
 
+void SetRowBlockPredicateEvaluatorFactory(RowBlockPredicateEvaluatorFactory factory) {
+  predicate_evaluator_factory.store(factory);
+}
+
 const vector<ColumnPredicate>& GetIteratorPredicatesForTests(
     const unique_ptr<RowwiseIterator>& iter) {
   PredicateEvaluatingIterator* pred_eval =
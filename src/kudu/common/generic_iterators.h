@@ -29,7 +29,10 @@
 namespace kudu {
 
 class ColumnPredicate;
+class RowBlock;
 class ScanSpec;
+class Schema;
+class ThreadPool;
 
 // Encapsulates a rowwise-iterator along with the (encoded) lower and upper
 // bounds for the rowset that the iterator belongs to.
@@ -63,6 +66,16 @@ std::unique_ptr<RowwiseIterator> NewMergeIterator(
 // The iterators must have matching schemas and should not yet be initialized.
 std::unique_ptr<RowwiseIterator> NewUnionIterator(std::vector<IterWithBounds> iters);
 
+// Constructs a ParallelUnionIterator of the given iterators, which yields the
+// same rows as a UnionIterator (though in no particular order) but reads from
+// up to 'parallelism' of the iterators concurrently using threads of 'pool'.
+//
+// The iterators must have matching schemas and should not yet be initialized.
+// 'pool' must outlive the returned iterator.
+std::unique_ptr<RowwiseIterator> NewParallelUnionIterator(std::vector<IterWithBounds> iters,
+                                                          ThreadPool* pool,
+                                                          int parallelism);
+
 // Constructs a MaterializingIterator of the given ColumnwiseIterator.
 std::unique_ptr<RowwiseIterator> NewMaterializingIterator(
     std::unique_ptr<ColumnwiseIterator> iter);
@@ -78,6 +91,29 @@ std::unique_ptr<RowwiseIterator> NewMaterializingIterator(
 Status InitAndMaybeWrap(std::unique_ptr<RowwiseIterator>* base_iter,
                         ScanSpec* spec);
 
+// Evaluates a conjunction of column predicates over whole row blocks, e.g. with
+// a function generated for those particular predicates.
+class RowBlockPredicateEvaluator {
+ public:
+  virtual ~RowBlockPredicateEvaluator() {}
+
+  // Deselects the rows of 'block' which don't satisfy all of the predicates.
+  virtual void Evaluate(RowBlock* block) const = 0;
+};
+
+// Returns an evaluator of the conjunction of 'predicates', in order, over row
+// blocks of 'schema', or nullptr if none is available.
+typedef std::unique_ptr<RowBlockPredicateEvaluator> (*RowBlockPredicateEvaluatorFactory)(
+    const Schema& schema, const std::vector<ColumnPredicate>& predicates);
+
+// Sets the factory which a PredicateEvaluatingIterator asks for an evaluator
+// of its predicates. If it gets one, it's used instead of evaluating the
+// predicates one column at a time. By default there is no factory.
+//
+// This lets the codegen module, which depends on this one, provide compiled
+// evaluators.
+void SetRowBlockPredicateEvaluatorFactory(RowBlockPredicateEvaluatorFactory factory);
+
 // Gets the predicates associated with a PredicateEvaluatingIterator.
 //
 // Only for use by tests.
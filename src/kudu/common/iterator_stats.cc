@@ -17,15 +17,60 @@
 
 #include "kudu/common/iterator_stats.h"
 
+#include <algorithm>
+
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/trace.h"
+#include "kudu/util/trace_metrics.h"
+
+DEFINE_bool(scan_stage_timing, true,
+            "Whether to measure the time scans spend in each of their stages "
+            "(decoding, decompression, predicate evaluation, etc). The times "
+            "are returned in the scan responses and shown on the /scans page "
+            "of the tablet servers.");
+TAG_FLAG(scan_stage_timing, advanced);
+TAG_FLAG(scan_stage_timing, runtime);
 
 namespace kudu {
 
 using std::string;
 using strings::Substitute;
 
+namespace {
+
+// Indexed by ScanStage.
+const char* const kScanStageNames[] = {
+  "decode",
+  "decompress",
+  "predicate_eval",
+  "delta_apply",
+  "merge",
+  "serialize",
+  "cache_miss_wait",
+};
+static_assert(arraysize(kScanStageNames) == kNumScanStages, "missing scan stage name");
+
+// The trace counters of the stages. The counters are keyed by the address of
+// their names, so these must be the only instances of the names.
+const char* const kScanStageCounterNames[] = {
+  "scan_decode_nanos",
+  "scan_decompress_nanos",
+  "scan_predicate_eval_nanos",
+  "scan_delta_apply_nanos",
+  "scan_merge_nanos",
+  "scan_serialize_nanos",
+  "scan_cache_miss_wait_nanos",
+};
+static_assert(arraysize(kScanStageCounterNames) == kNumScanStages,
+              "missing scan stage counter name");
+
+} // anonymous namespace
+
 IteratorStats::IteratorStats()
     : cells_read(0),
       bytes_read(0),
@@ -70,4 +115,126 @@ void IteratorStats::DCheckNonNegative() const {
   DCHECK_GE(bytes_read, 0);
   DCHECK_GE(blocks_read, 0);
 }
+
+PredicateStats::PredicateStats()
+    : rows_evaluated(0),
+      rows_passed(0),
+      cycles(0) {
+}
+
+string PredicateStats::ToString() const {
+  return Substitute("rows_evaluated=$0 rows_passed=$1 cycles=$2",
+                    rows_evaluated, rows_passed, cycles);
+}
+
+void PredicateStats::Add(int64_t evaluated, int64_t passed, int64_t cycles_spent) {
+  DCHECK_GE(evaluated, passed);
+  rows_evaluated += evaluated;
+  rows_passed += passed;
+  cycles += std::max<int64_t>(cycles_spent, 0);
+}
+
+void PredicateStats::Decay() {
+  rows_evaluated /= 2;
+  rows_passed /= 2;
+  cycles /= 2;
+}
+
+double PredicateStats::Rank() const {
+  if (rows_evaluated == 0) {
+    return 0;
+  }
+  double cycles_per_row = static_cast<double>(cycles) / rows_evaluated;
+  // A predicate which filters out (almost) nothing is not worth evaluating
+  // early, however cheap it is.
+  double filtered_fraction = std::max(
+      1.0 - static_cast<double>(rows_passed) / rows_evaluated, 0.001);
+  return cycles_per_row / filtered_fraction;
+}
+
+const char* ScanStageToString(ScanStage stage) {
+  DCHECK_LT(static_cast<int>(stage), kNumScanStages);
+  return kScanStageNames[static_cast<int>(stage)];
+}
+
+ScanStageTimes::ScanStageTimes() {
+  std::fill(nanos_, nanos_ + kNumScanStages, 0);
+}
+
+ScanStageTimes ScanStageTimes::FromTraceMetrics(const TraceMetrics& metrics) {
+  ScanStageTimes times;
+  for (int i = 0; i < kNumScanStages; i++) {
+    times.nanos_[i] = metrics.GetMetric(kScanStageCounterNames[i]);
+  }
+  return times;
+}
+
+ScanStageTimes ScanStageTimes::FromCurrentTrace() {
+  Trace* trace = Trace::CurrentTrace();
+  return trace ? FromTraceMetrics(*trace->metrics()) : ScanStageTimes();
+}
+
+const char* ScanStageTimes::TraceCounterName(ScanStage stage) {
+  DCHECK_LT(static_cast<int>(stage), kNumScanStages);
+  return kScanStageCounterNames[static_cast<int>(stage)];
+}
+
+string ScanStageTimes::ToString() const {
+  string ret;
+  for (int i = 0; i < kNumScanStages; i++) {
+    if (i > 0) {
+      ret += " ";
+    }
+    ret += Substitute("$0_nanos=$1", kScanStageNames[i], nanos_[i]);
+  }
+  return ret;
+}
+
+ScanStageTimes& ScanStageTimes::operator+=(const ScanStageTimes& other) {
+  for (int i = 0; i < kNumScanStages; i++) {
+    nanos_[i] += other.nanos_[i];
+  }
+  return *this;
+}
+
+ScanStageTimes& ScanStageTimes::operator-=(const ScanStageTimes& other) {
+  for (int i = 0; i < kNumScanStages; i++) {
+    nanos_[i] -= other.nanos_[i];
+  }
+  return *this;
+}
+
+__thread ScopedScanStageTimer* ScopedScanStageTimer::current_;
+
+ScopedScanStageTimer::ScopedScanStageTimer(ScanStage stage)
+    : trace_(PREDICT_TRUE(FLAGS_scan_stage_timing) ? Trace::CurrentTrace() : nullptr),
+      stage_(stage),
+      parent_(nullptr),
+      elapsed_nanos_(0) {
+  if (!trace_) {
+    return;
+  }
+  start_ = MonoTime::Now();
+  parent_ = current_;
+  if (parent_) {
+    parent_->elapsed_nanos_ += (start_ - parent_->start_).ToNanoseconds();
+  }
+  current_ = this;
+}
+
+ScopedScanStageTimer::~ScopedScanStageTimer() {
+  if (!trace_) {
+    return;
+  }
+  MonoTime now = MonoTime::Now();
+  elapsed_nanos_ += (now - start_).ToNanoseconds();
+  if (stage_ != ScanStage::kNone) {
+    trace_->metrics()->Increment(ScanStageTimes::TraceCounterName(stage_), elapsed_nanos_);
+  }
+  DCHECK_EQ(this, current_);
+  current_ = parent_;
+  if (parent_) {
+    parent_->start_ = now;
+  }
+}
 } // namespace kudu
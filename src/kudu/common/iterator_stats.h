@@ -20,8 +20,14 @@
 #include <stdint.h>
 #include <string>
 
+#include "kudu/gutil/macros.h"
+#include "kudu/util/monotime.h"
+
 namespace kudu {
 
+class Trace;
+class TraceMetrics;
+
 struct IteratorStats {
   IteratorStats();
 
@@ -52,6 +58,124 @@ struct IteratorStats {
   void DCheckNonNegative() const;
 };
 
+// Statistics about the evaluation of a column predicate over the batches of a
+// scan. Iterators use them to evaluate the predicates which filter out the
+// most rows for the least work first.
+struct PredicateStats {
+  PredicateStats();
+
+  std::string ToString() const;
+
+  // Record that the predicate was evaluated over 'evaluated' rows, of which
+  // 'passed' passed it, in 'cycles_spent' CPU cycles.
+  void Add(int64_t evaluated, int64_t passed, int64_t cycles_spent);
+
+  // Halve the statistics, so that the older batches weigh less than the more
+  // recent ones.
+  void Decay();
+
+  // The expected number of cycles spent per row the predicate filters out.
+  // The lower the rank, the earlier the predicate should be evaluated.
+  // Predicates which haven't been evaluated yet have the lowest rank, so
+  // that they're measured.
+  double Rank() const;
+
+  // The number of rows the predicate was evaluated over.
+  int64_t rows_evaluated;
+
+  // The number of those rows which passed the predicate.
+  int64_t rows_passed;
+
+  // The CPU cycles spent materializing the predicate's column and evaluating
+  // the predicate.
+  int64_t cycles;
+};
+
+// The stages of a scan whose time is profiled by ScopedScanStageTimer.
+enum class ScanStage {
+  // Decoding the values of the CFile blocks.
+  kDecode,
+  // Decompressing the CFile blocks.
+  kDecompress,
+  // Evaluating the predicates which weren't pushed down to the decoders.
+  kPredicateEval,
+  // Reading and applying the deltas of the base data.
+  kDeltaApply,
+  // Merging the rows of the sub-iterators of an ordered scan.
+  kMerge,
+  // Serializing the rows into the response.
+  kSerialize,
+  // Reading and verifying the CFile blocks which missed the block cache.
+  kCacheMissWait,
+
+  // Not a stage: the time spent in its scope isn't attributed to the
+  // enclosing stage, e.g. the time a merge spends in its sub-iterators.
+  kNone,
+};
+constexpr int kNumScanStages = static_cast<int>(ScanStage::kNone);
+
+// Returns the name of 'stage', e.g. "decode".
+const char* ScanStageToString(ScanStage stage);
+
+// The time spent in each stage of a scan, in nanoseconds.
+struct ScanStageTimes {
+  ScanStageTimes();
+
+  // Returns the stage times accumulated in 'metrics' by ScopedScanStageTimer.
+  static ScanStageTimes FromTraceMetrics(const TraceMetrics& metrics);
+
+  // Returns the stage times accumulated in the current trace, or all zeros if
+  // there is no current trace.
+  static ScanStageTimes FromCurrentTrace();
+
+  // Returns the name of the trace counter accumulating the time of 'stage',
+  // e.g. "scan_decode_nanos".
+  static const char* TraceCounterName(ScanStage stage);
+
+  std::string ToString() const;
+
+  int64_t nanos(ScanStage stage) const {
+    return nanos_[static_cast<int>(stage)];
+  }
+
+  ScanStageTimes& operator+=(const ScanStageTimes& other);
+  ScanStageTimes& operator-=(const ScanStageTimes& other);
+
+ private:
+  int64_t nanos_[kNumScanStages];
+};
+
+// Adds the time spent in its scope to the trace counter of a scan stage in
+// the current trace, if any. Nothing is measured if there is no current trace
+// or if --scan_stage_timing is off.
+//
+// The time is exclusive: while a timer is in the scope of another one on the
+// same thread, the enclosing timer is paused, so nesting the stages of
+// stacked iterators doesn't count any time twice. Reading the clock costs
+// tens of nanoseconds, so timers should scope batches or blocks, not rows.
+class ScopedScanStageTimer {
+ public:
+  explicit ScopedScanStageTimer(ScanStage stage);
+  ~ScopedScanStageTimer();
+
+ private:
+  // The innermost timer of the thread.
+  static __thread ScopedScanStageTimer* current_;
+
+  Trace* const trace_;
+  const ScanStage stage_;
+  ScopedScanStageTimer* parent_;
+  // When the timer was last started or resumed.
+  MonoTime start_;
+  // The time accumulated until the timer was last paused.
+  int64_t elapsed_nanos_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedScanStageTimer);
+};
+
+#define SCOPED_SCAN_STAGE_TIMER(stage) \
+  ::kudu::ScopedScanStageTimer _scan_stage_timer(stage)
+
 } // namespace kudu
 
 #endif
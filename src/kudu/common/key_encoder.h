@@ -297,6 +297,29 @@ struct KeyEncoderTraits<BINARY, Buffer> {
 };
 
 // Forward declaration is necessary for friend declaration in KeyEncoder.
+// Encodes the integer key cell of type T at 'src' to the sizeof(T) bytes at
+// 'dst' the way KeyEncoderTraits does, but in place rather than appended to
+// a buffer: if 'is_signed', the sign bit is flipped so that the cell compares
+// as an unsigned integer, and the result is stored big-endian.
+//
+// T is the unsigned type of the cell's size, up to 8 bytes.
+template<typename T>
+inline void EncodeIntegerKeyCell(const void* src, bool is_signed, uint8_t* dst) {
+  static_assert(!MathLimits<T>::kIsSigned && sizeof(T) <= 8, "unsupported key cell type");
+  T val;
+  memcpy(&val, src, sizeof(T));
+  if (is_signed) {
+    val ^= static_cast<T>(1) << (sizeof(T) * CHAR_BIT - 1);
+  }
+  switch (sizeof(T)) {
+    case 2: val = BigEndian::FromHost16(val); break;
+    case 4: val = BigEndian::FromHost32(val); break;
+    case 8: val = BigEndian::FromHost64(val); break;
+    default: break;
+  }
+  memcpy(dst, &val, sizeof(T));
+}
+
 template<typename Buffer>
 class EncoderResolver;
 
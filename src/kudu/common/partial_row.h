@@ -43,8 +43,10 @@ namespace kudu {
 class ColumnSchema;
 namespace client {
 class ClientTest_TestProjectionPredicatesFuzz_Test;
+class KuduColumnarWriteBatch;
 class KuduWriteOperation;
 namespace internal {
+class MultiGetter;
 class WriteRpc;
 } // namespace internal
 template<typename KeyTypeWrapper> struct SliceKeysTestSetup;// IWYU pragma: keep
@@ -592,7 +594,9 @@ class KUDU_EXPORT KuduPartialRow {
   const Schema* schema() const { return schema_; }
 
  private:
+  friend class client::KuduColumnarWriteBatch; // for row_data_.
   friend class client::KuduWriteOperation;   // for row_data_.
+  friend class client::internal::MultiGetter; // for Set().
   friend class client::internal::WriteRpc;   // for row_data_.
   friend class KeyUtilTest;
   friend class PartitionSchema;
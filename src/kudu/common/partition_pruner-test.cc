@@ -20,7 +20,9 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,6 +39,7 @@
 #include "kudu/common/row.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/auto_release_pool.h"
 #include "kudu/util/memory/arena.h"
@@ -765,6 +768,73 @@ TEST_F(PartitionPrunerTest, TestInListHashPruning) {
         8, 8);
 }
 
+TEST_F(PartitionPrunerTest, TestTrimInListPredicates) {
+  // CREATE TABLE t
+  // (a INT8, b INT8, c INT8)
+  // PRIMARY KEY (a, b, c)
+  // DISTRIBUTE BY HASH(a) INTO 3 BUCKETS,
+  //               HASH(b, c) INTO 3 BUCKETS;
+  Schema schema({ ColumnSchema("a", INT8),
+                  ColumnSchema("b", INT8),
+                  ColumnSchema("c", INT8) },
+                { ColumnId(0), ColumnId(1), ColumnId(2) },
+                3);
+
+  PartitionSchema partition_schema;
+  auto pb = PartitionSchemaPB();
+  auto hash_component_1 = pb.add_hash_bucket_schemas();
+  hash_component_1->add_columns()->set_name("a");
+  hash_component_1->set_num_buckets(3);
+  hash_component_1->set_seed(0);
+  auto hash_component_2 = pb.add_hash_bucket_schemas();
+  hash_component_2->add_columns()->set_name("b");
+  hash_component_2->add_columns()->set_name("c");
+  hash_component_2->set_num_buckets(3);
+  hash_component_2->set_seed(0);
+  pb.mutable_range_schema()->clear_columns();
+
+  ASSERT_OK(PartitionSchema::FromPB(pb, schema, &partition_schema));
+
+  vector<Partition> partitions;
+  ASSERT_OK(partition_schema.CreatePartitions(vector<KuduPartialRow>(), {}, schema, &partitions));
+  ASSERT_EQ(9, partitions.size());
+
+  // zero, one, eight are in different buckets when bucket number is 3 and seed is 0.
+  int8_t zero = 0;
+  int8_t one = 1;
+  int8_t eight = 8;
+  vector<const void*> a_values = { &zero, &one, &eight };
+  vector<const void*> b_values = { &zero, &one, &eight };
+
+  std::map<int32_t, int8_t> a_value_by_bucket;
+  for (const auto& partition : partitions) {
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::InList(schema.column(0), &a_values));
+    spec.AddPredicate(ColumnPredicate::InList(schema.column(1), &b_values));
+    PartitionPruner::TrimInListPredicates(schema, partition_schema, partition, &spec);
+
+    // Only one of the values of 'a' hashes to the bucket of the partition, and
+    // it's the same for all the partitions of that bucket.
+    const ColumnPredicate& a_pred = FindOrDie(spec.predicates(), "a");
+    ASSERT_EQ(PredicateType::Equality, a_pred.predicate_type());
+    int8_t a_value = *static_cast<const int8_t*>(a_pred.raw_lower());
+    auto inserted = a_value_by_bucket.emplace(partition.hash_buckets()[0], a_value);
+    ASSERT_EQ(a_value, inserted.first->second);
+
+    // The bucket of the values of 'b' depends on those of 'c'.
+    const ColumnPredicate& b_pred = FindOrDie(spec.predicates(), "b");
+    ASSERT_EQ(PredicateType::InList, b_pred.predicate_type());
+    ASSERT_EQ(3, b_pred.raw_values().size());
+  }
+  // Each value of 'a' went to its own bucket.
+  ASSERT_EQ(3, a_value_by_bucket.size());
+  std::set<int8_t> a_values_kept;
+  for (const auto& e : a_value_by_bucket) {
+    a_values_kept.insert(e.second);
+  }
+  ASSERT_EQ(3, a_values_kept.size());
+}
+
 TEST_F(PartitionPrunerTest, TestMultiColumnInListHashPruning) {
   // CREATE TABLE t
   // (a INT8, b INT8, c INT8)
@@ -433,6 +433,65 @@ void PartitionPruner::Init(const Schema& schema,
   }
 }
 
+ColumnPredicate PartitionPruner::TrimInListPredicate(const Schema& schema,
+                                                     const PartitionSchema& partition_schema,
+                                                     const Partition& partition,
+                                                     const ColumnPredicate& predicate) {
+  if (predicate.predicate_type() != PredicateType::InList) {
+    return predicate;
+  }
+  const auto& hash_bucket_schemas = partition_schema.hash_bucket_schemas_;
+  DCHECK_EQ(hash_bucket_schemas.size(), partition.hash_buckets().size());
+  for (int hash_idx = 0; hash_idx < hash_bucket_schemas.size(); hash_idx++) {
+    const auto& hash_bucket_schema = hash_bucket_schemas[hash_idx];
+    // With several columns, the bucket of a value depends on the values of
+    // the other columns.
+    if (hash_bucket_schema.column_ids.size() != 1 ||
+        schema.column_by_id(hash_bucket_schema.column_ids[0]).name() !=
+            predicate.column().name()) {
+      continue;
+    }
+    const KeyEncoder<string>& encoder = GetKeyEncoder<string>(predicate.column().type_info());
+    const int32_t bucket = partition.hash_buckets()[hash_idx];
+    vector<const void*> values;
+    string encoded_value;
+    for (const void* value : predicate.raw_values()) {
+      encoded_value.clear();
+      encoder.Encode(value, /*is_last=*/true, &encoded_value);
+      if (PartitionSchema::BucketForEncodedColumns(encoded_value, hash_bucket_schema) == bucket) {
+        values.push_back(value);
+      }
+    }
+    if (values.size() == predicate.raw_values().size()) {
+      return predicate;
+    }
+    return ColumnPredicate::InList(predicate.column(), &values);
+  }
+  return predicate;
+}
+
+void PartitionPruner::TrimInListPredicates(const Schema& schema,
+                                           const PartitionSchema& partition_schema,
+                                           const Partition& partition,
+                                           ScanSpec* scan_spec) {
+  if (partition_schema.hash_bucket_schemas_.empty()) {
+    return;
+  }
+  vector<ColumnPredicate> trimmed;
+  for (const auto& col_pred : scan_spec->predicates()) {
+    if (col_pred.second.predicate_type() == PredicateType::InList) {
+      trimmed.emplace_back(TrimInListPredicate(schema, partition_schema, partition,
+                                               col_pred.second));
+    }
+  }
+  for (auto& predicate : trimmed) {
+    // The trimmed predicate is a subset of the original one, so it replaces it.
+    string column_name = predicate.column().name();
+    scan_spec->RemovePredicate(column_name);
+    scan_spec->AddPredicate(move(predicate));
+  }
+}
+
 bool PartitionPruner::HasMorePartitionKeyRanges() const {
   return !partition_key_ranges_.empty();
 }
@@ -22,6 +22,7 @@
 #include <tuple>
 #include <vector>
 
+#include "kudu/common/column_predicate.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/common/partition.h"
 
@@ -60,6 +61,23 @@ class PartitionPruner {
   // Returns true if the provided partition should be pruned.
   bool ShouldPrune(const Partition& partition) const;
 
+  // If 'predicate' is an IN-list predicate on the only column of a hash
+  // component of 'partition_schema', returns it with only the values which
+  // hash to the bucket of 'partition' in that component: the other values
+  // can't match any row of the partition. Otherwise returns 'predicate'.
+  //
+  // The values of the returned predicate point to those of 'predicate'.
+  static ColumnPredicate TrimInListPredicate(const Schema& schema,
+                                             const PartitionSchema& partition_schema,
+                                             const Partition& partition,
+                                             const ColumnPredicate& predicate);
+
+  // Trims all the IN-list predicates of 'scan_spec' with TrimInListPredicate().
+  static void TrimInListPredicates(const Schema& schema,
+                                   const PartitionSchema& partition_schema,
+                                   const Partition& partition,
+                                   ScanSpec* scan_spec);
+
   // Returns the number of partition key ranges remaining in the scan.
   size_t NumRangesRemainingForTests() const {
     return partition_key_ranges_.size();
@@ -156,6 +156,7 @@ class RowProjector {
     base_schema_ = base_schema;
     projection_ = projection;
     base_cols_mapping_.clear();
+    base_cols_copies_.clear();
     projection_defaults_.clear();
     is_identity_ = base_schema->Equals(*projection);
     return Init();
@@ -205,6 +206,9 @@ class RowProjector {
 
   Status ProjectBaseColumn(size_t proj_col_idx, size_t base_col_idx) {
     base_cols_mapping_.emplace_back(proj_col_idx, base_col_idx);
+    const ColumnSchema& col = base_schema_->column(base_col_idx);
+    base_cols_copies_.push_back({ proj_col_idx, base_col_idx,
+                                  CellCopyKindOf(*col.type_info()), col.is_nullable() });
     return Status::OK();
   }
 
@@ -221,6 +225,46 @@ class RowProjector {
   }
 
  private:
+  // How the data of the cells of a base column is copied. It's resolved once
+  // when the mapping is built, so that projecting a row copies the cells of
+  // fixed-size types with a copy of constant size rather than dispatching on
+  // their type info, as when the projection isn't code-generated.
+  enum class CellCopyKind {
+    kFixed1,
+    kFixed2,
+    kFixed4,
+    kFixed8,
+    kFixed16,
+    // Cells of BINARY physical type, or of any other size.
+    kGeneric,
+  };
+
+  struct BaseColumnCopy {
+    size_t proj_idx;
+    size_t base_idx;
+    CellCopyKind kind;
+    bool nullable;
+  };
+
+  static CellCopyKind CellCopyKindOf(const TypeInfo& type_info) {
+    if (type_info.physical_type() == BINARY) {
+      return CellCopyKind::kGeneric;
+    }
+    switch (type_info.size()) {
+      case 1: return CellCopyKind::kFixed1;
+      case 2: return CellCopyKind::kFixed2;
+      case 4: return CellCopyKind::kFixed4;
+      case 8: return CellCopyKind::kFixed8;
+      case 16: return CellCopyKind::kFixed16;
+      default: return CellCopyKind::kGeneric;
+    }
+  }
+
+  template<size_t SIZE>
+  static void CopyFixedCellData(const void* src, void* dst) {
+    memcpy(dst, src, SIZE);
+  }
+
   // Project a row from one schema into another, using the projection mapping.
   // Indirected data is copied into the provided dst arena.
   template<class RowType1, class RowType2, class ArenaType, bool FOR_READ>
@@ -229,10 +273,36 @@ class RowProjector {
     DCHECK_SCHEMA_EQ(*projection_, *dst_row->schema());
 
     // Copy directly from base Data
-    for (const auto& base_mapping : base_cols_mapping_) {
-      typename RowType1::Cell src_cell = src_row.cell(base_mapping.second);
-      typename RowType2::Cell dst_cell = dst_row->cell(base_mapping.first);
-      RETURN_NOT_OK(CopyCell(src_cell, &dst_cell, dst_arena));
+    for (const auto& copy : base_cols_copies_) {
+      typename RowType1::Cell src_cell = src_row.cell(copy.base_idx);
+      typename RowType2::Cell dst_cell = dst_row->cell(copy.proj_idx);
+      if (copy.nullable) {
+        bool is_null = src_cell.is_null();
+        dst_cell.set_null(is_null);
+        if (is_null) {
+          continue;
+        }
+      }
+      switch (copy.kind) {
+        case CellCopyKind::kFixed1:
+          CopyFixedCellData<1>(src_cell.ptr(), dst_cell.mutable_ptr());
+          break;
+        case CellCopyKind::kFixed2:
+          CopyFixedCellData<2>(src_cell.ptr(), dst_cell.mutable_ptr());
+          break;
+        case CellCopyKind::kFixed4:
+          CopyFixedCellData<4>(src_cell.ptr(), dst_cell.mutable_ptr());
+          break;
+        case CellCopyKind::kFixed8:
+          CopyFixedCellData<8>(src_cell.ptr(), dst_cell.mutable_ptr());
+          break;
+        case CellCopyKind::kFixed16:
+          CopyFixedCellData<16>(src_cell.ptr(), dst_cell.mutable_ptr());
+          break;
+        default:
+          RETURN_NOT_OK(CopyCellData(src_cell, &dst_cell, dst_arena));
+          break;
+      }
     }
 
     // Fill with Defaults
@@ -252,6 +322,8 @@ class RowProjector {
   DISALLOW_COPY_AND_ASSIGN(RowProjector);
 
   std::vector<ProjectionIdxMapping> base_cols_mapping_;
+  // The copies of the base columns, in the order of 'base_cols_mapping_'.
+  std::vector<BaseColumnCopy> base_cols_copies_;
   std::vector<size_t> projection_defaults_;
 
   const Schema* base_schema_;
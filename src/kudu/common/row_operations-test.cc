@@ -23,6 +23,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags_declare.h>
@@ -46,6 +47,7 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -448,6 +450,39 @@ TEST_F(RowOperationsTest, ProjectionTestWholeSchemaSpecified) {
   }
 }
 
+// Test decoding rows written with the tablet's own schema, some of which have
+// all of their cells set and are decoded by copying them at once.
+TEST_F(RowOperationsTest, ProjectionTestIdentitySchema) {
+  RowOperationsPB pb;
+  RowOperationsPBEncoder enc(&pb);
+  KuduPartialRow row(&schema_without_ids_);
+  ASSERT_OK(row.SetInt32("key", 1));
+  ASSERT_OK(row.SetInt32("int_val", 10));
+  ASSERT_OK(row.SetStringCopy("string_val", "a"));
+  enc.Add(RowOperationsPB::INSERT, row);
+  ASSERT_OK(row.SetInt32("key", 2));
+  ASSERT_OK(row.SetNull("string_val"));
+  enc.Add(RowOperationsPB::UPSERT, row);
+  ASSERT_OK(row.SetInt32("key", 3));
+  ASSERT_OK(row.SetStringCopy("string_val", "ccc"));
+  enc.Add(RowOperationsPB::INSERT, row);
+
+  vector<DecodedRowOperation> ops;
+  RowOperationsPBDecoder dec(&pb, &schema_without_ids_, &schema_, &arena_);
+  ASSERT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops));
+  ASSERT_EQ(3, ops.size());
+  EXPECT_EQ(R"(INSERT (int32 key=1, int32 int_val=10, string string_val="a"))",
+            ops[0].ToString(schema_));
+  EXPECT_EQ("UPSERT (int32 key=2, int32 int_val=10, string string_val=NULL)",
+            ops[1].ToString(schema_));
+  EXPECT_EQ(R"(INSERT (int32 key=3, int32 int_val=10, string string_val="ccc"))",
+            ops[2].ToString(schema_));
+  for (const auto& op : ops) {
+    ASSERT_OK(op.result);
+    ASSERT_TRUE(BitmapIsAllSet(op.isset_bitmap, 0, schema_.num_columns()));
+  }
+}
+
 TEST_F(RowOperationsTest, ProjectionTestWithDefaults) {
   int32_t nullable_default = 123;
   int32_t non_null_default = 456;
@@ -751,6 +786,69 @@ TEST_F(RowOperationsTest, TestProjectDeletes) {
   }
 }
 
+TEST_F(RowOperationsTest, TestDecodeDeleteRange) {
+  Schema client_schema({ ColumnSchema("key", INT32),
+                         ColumnSchema("int_val", INT32) },
+                       1);
+  Schema server_schema = SchemaBuilder(client_schema).Build();
+
+  KuduPartialRow lower_bound(&client_schema);
+  ASSERT_OK(lower_bound.SetInt32("key", 10));
+  KuduPartialRow upper_bound(&client_schema);
+  ASSERT_OK(upper_bound.SetInt32("key", 20));
+
+  RowOperationsPB pb;
+  Arena arena(1024);
+  const auto decode = [&](const vector<pair<RowOperationsPB::Type, const KuduPartialRow*>>& in,
+                          vector<DecodedRowOperation>* ops) {
+    pb.Clear();
+    RowOperationsPBEncoder enc(&pb);
+    for (const auto& type_and_row : in) {
+      enc.Add(type_and_row.first, *type_and_row.second);
+    }
+    RowOperationsPBDecoder dec(&pb, &client_schema, &server_schema, &arena);
+    return dec.DecodeOperations<DecoderMode::WRITE_OPS>(ops);
+  };
+
+  // The bounds are decoded as a single operation.
+  {
+    vector<DecodedRowOperation> ops;
+    ASSERT_OK(decode({ { RowOperationsPB::DELETE_RANGE, &lower_bound },
+                       { RowOperationsPB::DELETE_RANGE_UPPER_BOUND, &upper_bound },
+                       { RowOperationsPB::DELETE, &upper_bound } }, &ops));
+    ASSERT_EQ(2, ops.size());
+    EXPECT_EQ("DELETE_RANGE [(int32 key=10), (int32 key=20))",
+              ops[0].ToString(server_schema));
+    EXPECT_EQ("MUTATE (int32 key=20) DELETE", ops[1].ToString(server_schema));
+  }
+
+  // The upper bound is required.
+  {
+    vector<DecodedRowOperation> ops;
+    Status s = decode({ { RowOperationsPB::DELETE_RANGE, &lower_bound } }, &ops);
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "DELETE_RANGE without an upper bound");
+
+    s = decode({ { RowOperationsPB::DELETE_RANGE, &lower_bound },
+                 { RowOperationsPB::DELETE, &upper_bound } }, &ops);
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(),
+                        "DELETE_RANGE must be followed by DELETE_RANGE_UPPER_BOUND");
+  }
+
+  // Like deletes, the bounds may only set key columns.
+  {
+    ASSERT_OK(upper_bound.SetInt32("int_val", 1));
+    vector<DecodedRowOperation> ops;
+    ASSERT_OK(decode({ { RowOperationsPB::DELETE_RANGE, &lower_bound },
+                       { RowOperationsPB::DELETE_RANGE_UPPER_BOUND, &upper_bound } }, &ops));
+    ASSERT_EQ(1, ops.size());
+    EXPECT_EQ("row error: Invalid argument: DELETE_RANGE_UPPER_BOUND should not have a "
+              "value for column: int_val INT32 NOT NULL",
+              ops[0].ToString(server_schema));
+  }
+}
+
 TEST_F(RowOperationsTest, SplitKeyRoundTrip) {
   Schema client_schema = Schema({ ColumnSchema("int8", INT8),
                                   ColumnSchema("int16", INT16),
@@ -17,7 +17,9 @@
 
 #include "kudu/common/row_operations.h"
 
+#include <atomic>
 #include <cstring>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -42,6 +44,7 @@
 #include "kudu/util/slice.h"
 
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -74,6 +77,13 @@ string DecodedRowOperation::ToString(const Schema& schema) const {
       return Substitute("MUTATE $0 $1",
                         schema.DebugRowKey(ConstContiguousRow(&schema, row_data)),
                         changelist.ToString(schema));
+    case RowOperationsPB::DELETE_RANGE:
+      return Substitute("DELETE_RANGE [$0, $1)",
+                        schema.DebugRowKey(ConstContiguousRow(&schema, row_data)),
+                        schema.DebugRowKey(ConstContiguousRow(&schema,
+                                                              range_upper_bound_row_data)));
+    case RowOperationsPB::DELETE_RANGE_UPPER_BOUND:
+      return "DELETE_RANGE_UPPER_BOUND";
     case RowOperationsPB::SPLIT_ROW:
       return Substitute("SPLIT_ROW $0", KUDU_DISABLE_REDACTION(split_row->ToString()));
     case RowOperationsPB::RANGE_LOWER_BOUND:
@@ -205,6 +215,15 @@ size_t RowOperationsPBEncoder::GetRowsFieldSizeEstimate(
 // Decoder
 // ------------------------------------------------------------
 
+namespace {
+// The factory of the decoders of INSERT-like rows, if any.
+std::atomic<InsertRowDecoderFactory> insert_row_decoder_factory(nullptr);
+} // anonymous namespace
+
+void SetInsertRowDecoderFactory(InsertRowDecoderFactory factory) {
+  insert_row_decoder_factory.store(factory);
+}
+
 RowOperationsPBDecoder::RowOperationsPBDecoder(const RowOperationsPB* pb,
                                                const Schema* client_schema,
                                                const Schema* tablet_schema,
@@ -215,7 +234,8 @@ RowOperationsPBDecoder::RowOperationsPBDecoder(const RowOperationsPB* pb,
     dst_arena_(dst_arena),
     bm_size_(BitmapSize(client_schema_->num_columns())),
     tablet_row_size_(ContiguousRowHelper::row_size(*tablet_schema_)),
-    src_(pb->rows().data(), pb->rows().size()) {
+    src_(pb->rows().data(), pb->rows().size()),
+    identity_mapping_(false) {
 }
 
 RowOperationsPBDecoder::~RowOperationsPBDecoder() {
@@ -378,6 +398,28 @@ class ClientServerMapping {
     return client_to_tablet_.size();
   }
 
+  const vector<size_t>& client_to_tablet() const {
+    return client_to_tablet_;
+  }
+
+  // Returns whether every client column is the tablet column at the same
+  // index, with the same type and nullability.
+  bool IsIdentity() const {
+    if (client_schema_->num_columns() != tablet_schema_->num_columns()) {
+      return false;
+    }
+    for (size_t i = 0; i < client_to_tablet_.size(); i++) {
+      const ColumnSchema& client_col = client_schema_->column(i);
+      const ColumnSchema& tablet_col = tablet_schema_->column(i);
+      if (client_to_tablet_[i] != i ||
+          client_col.type_info()->type() != tablet_col.type_info()->type() ||
+          client_col.is_nullable() != tablet_col.is_nullable()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   // Ensure that any required (non-null, non-defaulted) columns from the
   // server side schema are found in the client-side schema. If not,
   // returns an InvalidArgument.
@@ -406,8 +448,44 @@ class ClientServerMapping {
   DISALLOW_COPY_AND_ASSIGN(ClientServerMapping);
 };
 
+Status RowOperationsPBDecoder::DecodeIdentityRow(uint8_t* tablet_row_storage,
+                                                 DecodedRowOperation* op) {
+  const size_t cells_size = tablet_schema_->byte_size();
+  if (PREDICT_FALSE(src_.size() < cells_size)) {
+    return Status::Corruption("Not enough data for row");
+  }
+  memcpy(tablet_row_storage, src_.data(), cells_size);
+  if (tablet_schema_->has_nullables()) {
+    memset(ContiguousRowHelper::non_null_bitmap_ptr(*tablet_schema_, tablet_row_storage),
+           0, ContiguousRowHelper::non_null_bitmap_size(*tablet_schema_));
+  }
+
+  // The slices in the protobuf have pointers relative to the indirect data,
+  // not real pointers. See GetColumnSlice().
+  for (size_t col_idx : binary_col_idxs_) {
+    auto cell = reinterpret_cast<Slice*>(
+        tablet_row_storage + tablet_schema_->column_offset(col_idx));
+    auto offset_in_indirect = reinterpret_cast<uintptr_t>(cell->data());
+    bool overflowed = false;
+    size_t max_offset = AddWithOverflowCheck(offset_in_indirect, cell->size(), &overflowed);
+    if (PREDICT_FALSE(overflowed || max_offset > pb_->indirect_data().size())) {
+      return Status::Corruption("Bad indirect slice");
+    }
+    if (PREDICT_FALSE(cell->size() > FLAGS_max_cell_size_bytes)) {
+      op->SetFailureStatusOnce(Status::InvalidArgument(Substitute(
+          "value too large for column '$0' ($1 bytes, maximum is $2 bytes)",
+          tablet_schema_->column(col_idx).name(), cell->size(),
+          FLAGS_max_cell_size_bytes)));
+    }
+    *cell = Slice(&pb_->indirect_data()[offset_in_indirect], cell->size());
+  }
+  src_.remove_prefix(cells_size);
+  return Status::OK();
+}
+
 Status RowOperationsPBDecoder::DecodeInsertOrUpsert(const uint8_t* prototype_row_storage,
                                                     const ClientServerMapping& mapping,
+                                                    const InsertRowDecoder* fast_decoder,
                                                     DecodedRowOperation* op) {
   const uint8_t* client_isset_map = nullptr;
   const uint8_t* client_null_map = nullptr;
@@ -427,6 +505,19 @@ Status RowOperationsPBDecoder::DecodeInsertOrUpsert(const uint8_t* prototype_row
     return Status::RuntimeError("Out of memory");
   }
 
+  // When the client wrote all the cells of a row of the tablet's schema, none
+  // of them null, they're encoded with the layout of the tablet's rows.
+  const size_t num_cols = client_schema_->num_columns();
+  if (identity_mapping_ &&
+      BitmapIsAllSet(client_isset_map, 0, num_cols) &&
+      (!client_null_map || BitmapIsAllZero(client_null_map, 0, num_cols))) {
+    RETURN_NOT_OK(DecodeIdentityRow(tablet_row_storage, op));
+    memcpy(tablet_isset_bitmap, client_isset_map, bm_size_);
+    op->row_data = tablet_row_storage;
+    op->isset_bitmap = tablet_isset_bitmap;
+    return Status::OK();
+  }
+
   // Initialize the new row from the 'prototype' row which has been set
   // with all of the server-side default values. This copy may be entirely
   // overwritten in the case that all columns are specified, but this is
@@ -435,6 +526,22 @@ Status RowOperationsPBDecoder::DecodeInsertOrUpsert(const uint8_t* prototype_row
   memcpy(tablet_row_storage, prototype_row_storage, tablet_row_size_);
   ContiguousRow tablet_row(tablet_schema_, tablet_row_storage);
 
+  // Valid rows can usually be decoded by the fast decoder. It leaves any
+  // others to be decoded below, so that their errors are reported as usual.
+  if (fast_decoder) {
+    int64_t consumed = fast_decoder->DecodeCells(
+        src_.data(), src_.size(), client_isset_map, client_null_map,
+        Slice(pb_->indirect_data()), FLAGS_max_cell_size_bytes,
+        tablet_row_storage, tablet_isset_bitmap);
+    if (PREDICT_TRUE(consumed >= 0)) {
+      src_.remove_prefix(consumed);
+      op->row_data = tablet_row_storage;
+      op->isset_bitmap = tablet_isset_bitmap;
+      return Status::OK();
+    }
+    memcpy(tablet_row_storage, prototype_row_storage, tablet_row_size_);
+  }
+
   // Now handle each of the columns passed by the user, replacing the defaults
   // from the prototype.
   Status row_status;
@@ -586,14 +693,18 @@ Status RowOperationsPBDecoder::DecodeUpdateOrDelete(const ClientServerMapping& m
       memcpy(rcl_in_arena, buf.data(), buf.size());
       op->changelist = RowChangeList(Slice(rcl_in_arena, buf.size()));
     }
-  } else if (op->type == RowOperationsPB::DELETE) {
+  } else if (op->type == RowOperationsPB::DELETE ||
+             op->type == RowOperationsPB::DELETE_RANGE ||
+             op->type == RowOperationsPB::DELETE_RANGE_UPPER_BOUND) {
     // Ensure that no other columns are set.
     for (; client_col_idx < client_schema_->num_columns(); client_col_idx++) {
       if (PREDICT_FALSE(BitmapTest(client_isset_map, client_col_idx))) {
         size_t tablet_col_idx = mapping.client_to_tablet_idx(client_col_idx);
         const ColumnSchema& col = tablet_schema_->column(tablet_col_idx);
         op->SetFailureStatusOnce(Status::InvalidArgument(
-            "DELETE should not have a value for column", col.ToString()));
+            Substitute("$0 should not have a value for column",
+                       RowOperationsPB_Type_Name(op->type)),
+            col.ToString()));
 
         bool client_set_to_null = client_schema_->has_nullables() &&
           BitmapTest(client_null_map, client_col_idx);
@@ -602,16 +713,41 @@ Status RowOperationsPBDecoder::DecodeUpdateOrDelete(const ClientServerMapping& m
         }
       }
     }
-    if (PREDICT_TRUE(op->result.ok())) {
+    if (PREDICT_TRUE(op->result.ok()) && op->type == RowOperationsPB::DELETE) {
       op->changelist = RowChangeList::CreateDelete();
     }
   } else {
-    LOG(FATAL) << "Should only call this method with UPDATE or DELETE";
+    LOG(FATAL) << "Should only call this method with UPDATE, DELETE or range bounds";
   }
 
   return Status::OK();
 }
 
+Status RowOperationsPBDecoder::DecodeDeleteRange(const ClientServerMapping& mapping,
+                                                 DecodedRowOperation* op) {
+  // Both bounds are decoded like the key of a DELETE.
+  RETURN_NOT_OK(DecodeUpdateOrDelete(mapping, op));
+
+  if (PREDICT_FALSE(!HasNext())) {
+    return Status::InvalidArgument("DELETE_RANGE without an upper bound");
+  }
+  RowOperationsPB::Type type = RowOperationsPB::UNKNOWN;
+  RETURN_NOT_OK(ReadOpType(&type));
+  if (PREDICT_FALSE(type != RowOperationsPB::DELETE_RANGE_UPPER_BOUND)) {
+    return Status::InvalidArgument(Substitute(
+        "DELETE_RANGE must be followed by DELETE_RANGE_UPPER_BOUND, got $0",
+        RowOperationsPB_Type_Name(type)));
+  }
+  DecodedRowOperation upper_bound;
+  upper_bound.type = type;
+  RETURN_NOT_OK(DecodeUpdateOrDelete(mapping, &upper_bound));
+  if (PREDICT_FALSE(!upper_bound.result.ok())) {
+    op->SetFailureStatusOnce(upper_bound.result);
+  }
+  op->range_upper_bound_row_data = upper_bound.row_data;
+  return Status::OK();
+}
+
 Status RowOperationsPBDecoder::DecodeSplitRow(const ClientServerMapping& mapping,
                                               DecodedRowOperation* op) {
   op->split_row.reset(new KuduPartialRow(tablet_schema_));
@@ -674,13 +810,30 @@ Status RowOperationsPBDecoder::DecodeOperations(vector<DecodedRowOperation>* ops
   ContiguousRow prototype_row(tablet_schema_, prototype_row_storage);
   SetupPrototypeRow(*tablet_schema_, &prototype_row);
 
+  identity_mapping_ = mode == DecoderMode::WRITE_OPS && mapping.IsIdentity();
+  binary_col_idxs_.clear();
+  if (identity_mapping_) {
+    for (size_t i = 0; i < tablet_schema_->num_columns(); i++) {
+      if (tablet_schema_->column(i).type_info()->physical_type() == BINARY) {
+        binary_col_idxs_.push_back(i);
+      }
+    }
+  }
+
+  unique_ptr<InsertRowDecoder> fast_decoder;
+  InsertRowDecoderFactory factory = insert_row_decoder_factory.load();
+  if (mode == DecoderMode::WRITE_OPS && factory != nullptr) {
+    fast_decoder = factory(*client_schema_, *tablet_schema_, mapping.client_to_tablet());
+  }
+
   while (HasNext()) {
     RowOperationsPB::Type type = RowOperationsPB::UNKNOWN;
     RETURN_NOT_OK(ReadOpType(&type));
     DecodedRowOperation op;
     op.type = type;
 
-    RETURN_NOT_OK(DecodeOp<mode>(type, prototype_row_storage, mapping, &op));
+    RETURN_NOT_OK(DecodeOp<mode>(type, prototype_row_storage, mapping, fast_decoder.get(),
+                                 &op));
     ops->push_back(op);
   }
 
@@ -690,19 +843,23 @@ Status RowOperationsPBDecoder::DecodeOperations(vector<DecodedRowOperation>* ops
 template<>
 Status RowOperationsPBDecoder::DecodeOp<DecoderMode::WRITE_OPS>(
     RowOperationsPB::Type type, const uint8_t* prototype_row_storage,
-    const ClientServerMapping& mapping, DecodedRowOperation* op) {
+    const ClientServerMapping& mapping, const InsertRowDecoder* fast_decoder,
+    DecodedRowOperation* op) {
   switch (type) {
     case RowOperationsPB::UNKNOWN:
       return Status::NotSupported("Unknown row operation type");
     case RowOperationsPB::INSERT:
     case RowOperationsPB::INSERT_IGNORE:
     case RowOperationsPB::UPSERT:
-      RETURN_NOT_OK(DecodeInsertOrUpsert(prototype_row_storage, mapping, op));
+      RETURN_NOT_OK(DecodeInsertOrUpsert(prototype_row_storage, mapping, fast_decoder, op));
       break;
     case RowOperationsPB::UPDATE:
     case RowOperationsPB::DELETE:
       RETURN_NOT_OK(DecodeUpdateOrDelete(mapping, op));
       break;
+    case RowOperationsPB::DELETE_RANGE:
+      RETURN_NOT_OK(DecodeDeleteRange(mapping, op));
+      break;
     default:
       return Status::InvalidArgument(Substitute("Invalid write operation type $0",
                                                 RowOperationsPB_Type_Name(type)));
@@ -713,7 +870,8 @@ Status RowOperationsPBDecoder::DecodeOp<DecoderMode::WRITE_OPS>(
 template<>
 Status RowOperationsPBDecoder::DecodeOp<DecoderMode::SPLIT_ROWS>(
     RowOperationsPB::Type type, const uint8_t* /*prototype_row_storage*/,
-    const ClientServerMapping& mapping, DecodedRowOperation* op) {
+    const ClientServerMapping& mapping, const InsertRowDecoder* /*fast_decoder*/,
+    DecodedRowOperation* op) {
   switch (type) {
     case RowOperationsPB::UNKNOWN:
       return Status::NotSupported("Unknown row operation type");
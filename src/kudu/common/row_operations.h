@@ -77,8 +77,13 @@ struct DecodedRowOperation {
 
   // For INSERT, INSERT_IGNORE, or UPSERT, the whole projected row.
   // For UPDATE or DELETE, the row key.
+  // For DELETE_RANGE, the inclusive lower bound key of the range.
   const uint8_t* row_data;
 
+  // For DELETE_RANGE, the exclusive upper bound key of the range, decoded
+  // from the DELETE_RANGE_UPPER_BOUND row following the DELETE_RANGE row.
+  const uint8_t* range_upper_bound_row_data = nullptr;
+
   // For INSERT or UPDATE, a bitmap indicating which of the cells were
   // explicitly set by the client, versus being filled-in defaults.
   // A set bit indicates that the client explicitly set the cell.
@@ -100,6 +105,44 @@ struct DecodedRowOperation {
   void SetFailureStatusOnce(Status s);
 };
 
+// Decodes the cells of INSERT, INSERT_IGNORE and UPSERT rows for a given pair
+// of client and tablet schemas, e.g. with code generated for the pair.
+class InsertRowDecoder {
+ public:
+  virtual ~InsertRowDecoder() {}
+
+  // Decodes the cells of a row, which start at 'src', into 'tablet_row' and
+  // 'tablet_isset_bitmap', given the client's isset and null bitmaps of the
+  // row. 'tablet_row' must already be initialized with the tablet's defaults.
+  //
+  // Returns the number of bytes of 'src' consumed, or -1 if the row can't be
+  // decoded this way (e.g. it's invalid), in which case the row must be
+  // decoded by the RowOperationsPBDecoder itself, from the start.
+  virtual int64_t DecodeCells(const uint8_t* src,
+                              int64_t src_len,
+                              const uint8_t* client_isset_bitmap,
+                              const uint8_t* client_null_bitmap,
+                              const Slice& indirect_data,
+                              int64_t max_cell_size,
+                              uint8_t* tablet_row,
+                              uint8_t* tablet_isset_bitmap) const = 0;
+};
+
+// Returns a decoder of rows written with 'client_schema' into rows of
+// 'tablet_schema', where the i-th client column is the 'client_to_tablet[i]'-th
+// tablet column, or nullptr if none is available.
+typedef std::unique_ptr<InsertRowDecoder> (*InsertRowDecoderFactory)(
+    const Schema& client_schema,
+    const Schema& tablet_schema,
+    const std::vector<size_t>& client_to_tablet);
+
+// Sets the factory which RowOperationsPBDecoder asks for a decoder of the
+// INSERT-like rows of write operations. By default there is no factory.
+//
+// This lets the codegen module, which depends on this one, provide decoders
+// specialized for the schemas.
+void SetInsertRowDecoderFactory(InsertRowDecoderFactory factory);
+
 enum DecoderMode {
   // Decode range split rows.
   SPLIT_ROWS,
@@ -138,8 +181,18 @@ class RowOperationsPBDecoder {
   Status ReadColumnAndDiscard(const ColumnSchema& col);
   bool HasNext() const;
 
+  // Decodes the cells of an INSERT-like row whose client and tablet schemas
+  // are identical, and whose cells are all set and non-null, by copying them
+  // straight into 'tablet_row_storage'.
+  Status DecodeIdentityRow(uint8_t* tablet_row_storage, DecodedRowOperation* op);
+
+  // Decodes the next encoded operation, which must be INSERT, INSERT_IGNORE
+  // or UPSERT. If the schemas are identical and the row has all of its cells
+  // set, it's decoded by DecodeIdentityRow(). Otherwise, if 'fast_decoder'
+  // isn't null, it's tried first.
   Status DecodeInsertOrUpsert(const uint8_t* prototype_row_storage,
                               const ClientServerMapping& mapping,
+                              const InsertRowDecoder* fast_decoder,
                               DecodedRowOperation* op);
   //------------------------------------------------------------
   // Serialization/deserialization support
@@ -148,6 +201,10 @@ class RowOperationsPBDecoder {
   // Decode the next encoded operation, which must be UPDATE or DELETE.
   Status DecodeUpdateOrDelete(const ClientServerMapping& mapping,
                               DecodedRowOperation* op);
+  // Decode a DELETE_RANGE row and the DELETE_RANGE_UPPER_BOUND row which
+  // must follow it into 'op'.
+  Status DecodeDeleteRange(const ClientServerMapping& mapping,
+                           DecodedRowOperation* op);
 
   // Decode the next encoded operation, which must be SPLIT_KEY.
   Status DecodeSplitRow(const ClientServerMapping& mapping,
@@ -157,7 +214,8 @@ class RowOperationsPBDecoder {
   // Returns an error if the type isn't allowed by the decoder mode.
   template <DecoderMode mode>
   Status DecodeOp(RowOperationsPB::Type type, const uint8_t* prototype_row_storage,
-                  const ClientServerMapping& mapping, DecodedRowOperation* op);
+                  const ClientServerMapping& mapping, const InsertRowDecoder* fast_decoder,
+                  DecodedRowOperation* op);
 
   const RowOperationsPB* const pb_;
   const Schema* const client_schema_;
@@ -168,6 +226,15 @@ class RowOperationsPBDecoder {
   const size_t tablet_row_size_;
   Slice src_;
 
+  // Whether the client schema has the same columns as the tablet schema, in
+  // the same order and with the same types and nullability, in which case the
+  // encoded cells of the complete rows have the layout of the tablet rows.
+  bool identity_mapping_;
+
+  // If 'identity_mapping_' is set, the indexes of the BINARY columns, whose
+  // cells point into the indirect data.
+  std::vector<size_t> binary_col_idxs_;
+
   DISALLOW_COPY_AND_ASSIGN(RowOperationsPBDecoder);
 };
 
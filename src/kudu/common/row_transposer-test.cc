@@ -0,0 +1,135 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/row_transposer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/row.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class RowTransposerTest : public KuduTest {
+ public:
+  RowTransposerTest()
+      : src_schema_({ ColumnSchema("key", INT32),
+                      ColumnSchema("i8", INT8, true),
+                      ColumnSchema("i16", INT16),
+                      ColumnSchema("str", STRING, true),
+                      ColumnSchema("i64", INT64, true),
+                      ColumnSchema("u64", UINT64),
+                      ColumnSchema("dbl", DOUBLE, true),
+                      ColumnSchema("bin", BINARY),
+                      ColumnSchema("i32", INT32, true) },
+                    1),
+        dst_schema_({ ColumnSchema("i32", INT32, true),
+                      ColumnSchema("bin", BINARY),
+                      ColumnSchema("dbl", DOUBLE, true),
+                      ColumnSchema("i64", INT64, true),
+                      ColumnSchema("str", STRING, true),
+                      ColumnSchema("i16", INT16),
+                      ColumnSchema("key", INT32),
+                      ColumnSchema("u64", UINT64),
+                      ColumnSchema("i8", INT8, true) },
+                    0),
+        arena_(1024) {
+  }
+
+ protected:
+  // Appends a row with random cells, a third of the nullable ones null.
+  void AddRandomRow(Random* rng) {
+    RowBuilder rb(&src_schema_);
+    for (size_t i = 0; i < src_schema_.num_columns(); i++) {
+      const ColumnSchema& col = src_schema_.column(i);
+      if (col.is_nullable() && rng->OneIn(3)) {
+        rb.AddNull();
+        continue;
+      }
+      switch (col.type_info()->type()) {
+        case INT8: rb.AddInt8(rng->Next()); break;
+        case INT16: rb.AddInt16(rng->Next()); break;
+        case INT32: rb.AddInt32(rng->Next()); break;
+        case INT64: rb.AddInt64(rng->Next64()); break;
+        case UINT64: rb.AddUint64(rng->Next64()); break;
+        case DOUBLE: rb.AddDouble(rng->Normal(0, 1)); break;
+        case STRING: rb.AddString(RandomString(rng->Uniform(20), rng)); break;
+        case BINARY: rb.AddBinary(Slice(RandomString(rng->Uniform(20), rng))); break;
+        default: LOG(FATAL) << "unexpected type";
+      }
+    }
+    uint8_t* row = static_cast<uint8_t*>(
+        arena_.AllocateBytes(ContiguousRowHelper::row_size(src_schema_)));
+    ContiguousRow dst_row(&src_schema_, row);
+    ASSERT_OK(CopyRow(ConstContiguousRow(&src_schema_, rb.data()), &dst_row, &arena_));
+    rows_.push_back(row);
+  }
+
+  const Schema src_schema_;
+  const Schema dst_schema_;
+  Arena arena_;
+  vector<const uint8_t*> rows_;
+};
+
+// Test that transposing batches of rows yields the same rows as projecting
+// them a row at a time, including for batches whose sizes aren't multiples
+// of 8.
+TEST_F(RowTransposerTest, TestTransposeMatchesProjection) {
+  Random rng(SeedRandom());
+  RowProjector projector(&src_schema_, &dst_schema_);
+  ASSERT_OK(projector.Init());
+  RowTransposer transposer(&src_schema_, &dst_schema_, projector.base_cols_mapping());
+
+  for (int nrows : { 1, 7, 8, 9, 63, 100 }) {
+    SCOPED_TRACE(Substitute("$0 rows", nrows));
+    rows_.clear();
+    for (int i = 0; i < nrows; i++) {
+      NO_FATALS(AddRandomRow(&rng));
+    }
+
+    Arena dst_arena(1024);
+    RowBlock block(&dst_schema_, nrows, &dst_arena);
+    ASSERT_OK(transposer.Transpose(rows_.data(), nrows, &block, &dst_arena));
+
+    for (int i = 0; i < nrows; i++) {
+      ContiguousRow expected(&dst_schema_, static_cast<uint8_t*>(
+          dst_arena.AllocateBytes(ContiguousRowHelper::row_size(dst_schema_))));
+      ASSERT_OK(projector.ProjectRowForRead(ConstContiguousRow(&src_schema_, rows_[i]),
+                                            &expected, &dst_arena));
+      ASSERT_EQ(dst_schema_.DebugRow(expected), dst_schema_.DebugRow(block.row(i)));
+    }
+  }
+}
+
+} // namespace kudu
@@ -0,0 +1,162 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/row_transposer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/common/zp7.h"
+#include "kudu/gutil/cpu.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+
+using std::vector;
+
+namespace kudu {
+
+namespace {
+
+typedef uint64_t (*PextFunction)(uint64_t val, uint64_t mask);
+
+PextFunction ChoosePext() {
+#ifdef __x86_64__
+  if (base::CPU().has_pclmulqdq()) {
+    return &zp7_pext_64_clmul;
+  }
+#endif
+  return &zp7_pext_64_simple;
+}
+
+const PextFunction kPext = ChoosePext();
+
+// Copies the SIZE-byte cells at 'offset' in the 'nrows' rows to the
+// consecutive cells at 'dst'.
+template<size_t SIZE>
+void GatherCells(const uint8_t* const* __restrict__ rows,
+                 size_t nrows,
+                 size_t offset,
+                 uint8_t* __restrict__ dst) {
+  for (size_t i = 0; i < nrows; i++) {
+    memcpy(dst + i * SIZE, rows[i] + offset, SIZE);
+  }
+}
+
+// Sets the bits of 'non_null_bitmap' for the 'nrows' rows whose bit 'bit'
+// of the byte at 'null_byte_offset' isn't set, and clears the others.
+//
+// The bytes of 8 rows are packed into a word, out of which the 8 bits of
+// the column are extracted at once.
+void GatherNonNullBits(const uint8_t* const* __restrict__ rows,
+                       size_t nrows,
+                       size_t null_byte_offset,
+                       int bit,
+                       uint8_t* __restrict__ non_null_bitmap) {
+  const uint64_t mask = 0x0101010101010101ULL << bit;
+  for (size_t i = 0; i < nrows; i += 8) {
+    const size_t n = std::min<size_t>(8, nrows - i);
+    uint64_t word = 0;
+    for (size_t j = 0; j < n; j++) {
+      word |= static_cast<uint64_t>(rows[i + j][null_byte_offset]) << (8 * j);
+    }
+    uint8_t non_nulls = ~static_cast<uint8_t>(kPext(word, mask));
+    if (PREDICT_TRUE(n == 8)) {
+      non_null_bitmap[i / 8] = non_nulls;
+    } else {
+      // Leave the bits of the rows past the batch as they are.
+      uint8_t tail_mask = (1 << n) - 1;
+      non_null_bitmap[i / 8] = (non_null_bitmap[i / 8] & ~tail_mask) | (non_nulls & tail_mask);
+    }
+  }
+}
+
+} // anonymous namespace
+
+RowTransposer::RowTransposer(const Schema* src_schema,
+                             const Schema* dst_schema,
+                             const vector<ColumnMapping>& mapping)
+    : src_schema_(src_schema),
+      dst_schema_(dst_schema) {
+  for (const auto& m : mapping) {
+    const ColumnSchema& src_col = src_schema_->column(m.second);
+    DCHECK(src_col.EqualsType(dst_schema_->column(m.first)));
+    const TypeInfo* type_info = src_col.type_info();
+    columns_.push_back({ m.second, m.first, src_schema_->column_offset(m.second),
+                         type_info->size(), type_info->physical_type() == BINARY,
+                         src_col.is_nullable() });
+  }
+}
+
+Status RowTransposer::Transpose(const uint8_t* const* rows,
+                                size_t nrows,
+                                RowBlock* dst,
+                                Arena* dst_arena) const {
+  DCHECK_LE(nrows, dst->nrows());
+  // In the contiguous row format, a set bit of the null bitmap, which
+  // follows the cells, means the cell is null.
+  const size_t null_bitmap_offset = src_schema_->byte_size();
+  for (const Column& col : columns_) {
+    ColumnBlock dst_col = dst->column_block(col.dst_idx);
+    if (col.is_nullable) {
+      GatherNonNullBits(rows, nrows, null_bitmap_offset + col.src_idx / 8, col.src_idx % 8,
+                        dst_col.non_null_bitmap());
+    }
+    uint8_t* dst_data = dst_col.data();
+    if (col.is_binary) {
+      Slice* dst_slices = reinterpret_cast<Slice*>(dst_data);
+      for (size_t i = 0; i < nrows; i++) {
+        if (col.is_nullable && dst_col.is_null(i)) {
+          continue;
+        }
+        const Slice* src_slice = reinterpret_cast<const Slice*>(rows[i] + col.src_offset);
+        if (dst_arena != nullptr) {
+          if (PREDICT_FALSE(!dst_arena->RelocateSlice(*src_slice, &dst_slices[i]))) {
+            return Status::IOError("out of memory copying slice", src_slice->ToString());
+          }
+        } else {
+          dst_slices[i] = *src_slice;
+        }
+      }
+      continue;
+    }
+    switch (col.size) {
+      case 1: GatherCells<1>(rows, nrows, col.src_offset, dst_data); break;
+      case 2: GatherCells<2>(rows, nrows, col.src_offset, dst_data); break;
+      case 4: GatherCells<4>(rows, nrows, col.src_offset, dst_data); break;
+      case 8: GatherCells<8>(rows, nrows, col.src_offset, dst_data); break;
+      case 16: GatherCells<16>(rows, nrows, col.src_offset, dst_data); break;
+      default:
+        for (size_t i = 0; i < nrows; i++) {
+          memcpy(dst_data + i * col.size, rows[i] + col.src_offset, col.size);
+        }
+        break;
+    }
+  }
+  return Status::OK();
+}
+
+} // namespace kudu
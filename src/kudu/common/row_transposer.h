@@ -0,0 +1,81 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Arena;
+class RowBlock;
+class Schema;
+
+// Transposes batches of rows in the contiguous row format of a schema, as
+// kept by the MemRowSet, into the column blocks of a RowBlock of another
+// schema.
+//
+// Unlike a RowProjector, which copies a row at a time, this copies a column
+// at a time for the whole batch: the cells of fixed-size columns are
+// gathered with copies of constant size, and the non-null bitmaps of
+// nullable columns are built 8 rows at a time by extracting the column's
+// bit from the rows' null bitmaps with PEXT.
+class RowTransposer {
+ public:
+  // The index of a column in the destination schema and the index of the
+  // column it's copied from in the source schema, as in
+  // RowProjector::base_cols_mapping().
+  typedef std::pair<size_t, size_t> ColumnMapping;
+
+  // The schemas must remain valid for the lifetime of this object, and the
+  // columns of each mapping must have the same type and nullability.
+  RowTransposer(const Schema* src_schema,
+                const Schema* dst_schema,
+                const std::vector<ColumnMapping>& mapping);
+
+  // Copies the mapped cells of the 'nrows' rows whose data are at 'rows'
+  // into the first 'nrows' rows of 'dst', leaving the other columns of 'dst'
+  // untouched. Indirect data is relocated into 'dst_arena', unless it's null.
+  Status Transpose(const uint8_t* const* rows,
+                   size_t nrows,
+                   RowBlock* dst,
+                   Arena* dst_arena) const;
+
+ private:
+  struct Column {
+    size_t src_idx;
+    size_t dst_idx;
+    // The offset of the column's cells in the source rows.
+    size_t src_offset;
+    size_t size;
+    bool is_binary;
+    bool is_nullable;
+  };
+
+  const Schema* src_schema_;
+  const Schema* dst_schema_;
+  std::vector<Column> columns_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowTransposer);
+};
+
+} // namespace kudu
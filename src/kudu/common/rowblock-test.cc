@@ -23,6 +23,8 @@
 
 #include <gtest/gtest.h>
 
+#include "kudu/util/bitmap.h"
+
 using std::vector;
 
 namespace kudu {
@@ -89,4 +91,28 @@ TEST(TestSelectionVector, TestGetSelectedRows) {
   ASSERT_EQ(expected, sel.indexes());
 }
 
+// Test ANDing a bitmap into selection vector views, both byte-aligned and not.
+TEST(TestSelectionVectorView, TestAndBitmap) {
+  // Every third bit is unset.
+  uint8_t bitmap[4];
+  for (int i = 0; i < 32; i++) {
+    BitmapChange(bitmap, i, i % 3 != 0);
+  }
+  for (size_t offset : { 0, 8, 3, 11 }) {
+    for (size_t nrows : { 0, 5, 8, 13, 20 }) {
+      SCOPED_TRACE(offset);
+      SCOPED_TRACE(nrows);
+      SelectionVector sv(40);
+      sv.SetAllTrue();
+      SelectionVectorView view(&sv);
+      view.Advance(offset);
+      view.AndBitmap(bitmap, nrows);
+      for (size_t i = 0; i < sv.nrows(); i++) {
+        bool in_view = i >= offset && i < offset + nrows;
+        ASSERT_EQ(!in_view || (i - offset) % 3 != 0, sv.IsRowSelected(i)) << i;
+      }
+    }
+  }
+}
+
 } // namespace kudu
@@ -146,6 +146,28 @@ bool SelectionVector::AnySelected() const {
   return false;
 }
 
+void SelectionVectorView::AndBitmap(const uint8_t* bitmap, size_t nrows) {
+  DCHECK_LE(nrows, sel_vec_->nrows() - row_offset_);
+  if (row_offset_ % 8 == 0) {
+    // The view is byte-aligned, so whole bytes can be combined at once.
+    uint8_t* dst = sel_vec_->mutable_bitmap() + row_offset_ / 8;
+    const size_t n_full_bytes = nrows / 8;
+    for (size_t i = 0; i < n_full_bytes; i++) {
+      dst[i] &= bitmap[i];
+    }
+    const size_t rem_bits = nrows % 8;
+    if (rem_bits > 0) {
+      // Only touch the bits which belong to the first 'nrows' rows.
+      const uint8_t keep_mask = ~((1 << rem_bits) - 1);
+      dst[n_full_bytes] &= bitmap[n_full_bytes] | keep_mask;
+    }
+    return;
+  }
+  ForEachUnsetBit(bitmap, nrows, [&](int idx) {
+    ClearBit(idx);
+  });
+}
+
 bool operator==(const SelectionVector& a, const SelectionVector& b) {
   if (a.nrows() != b.nrows()) {
     return false;
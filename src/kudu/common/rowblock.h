@@ -97,7 +97,7 @@ class SelectionVector {
   //
   // Returns true if at least one row is selected and writes its index to 'row';
   // returns false otherwise.
-  bool FindFirstRowSelected(size_t row_offset, size_t* row) {
+  bool FindFirstRowSelected(size_t row_offset, size_t* row) const {
     DCHECK_LT(row_offset, n_rows_);
     DCHECK(row);
     return BitmapFindFirstSet(&bitmap_[0], row_offset, n_rows_, row);
@@ -220,7 +220,28 @@ class SelectionVectorView {
     DCHECK_LE(offset + nrows, sel_vec_->nrows() - row_offset_);
     BitmapChangeBits(sel_vec_->mutable_bitmap(), row_offset_ + offset, nrows, false);
   }
+  // Clear each of the first "nrows" bits in the current view for which the
+  // corresponding bit in "bitmap" is unset, i.e. AND the view with "bitmap".
+  void AndBitmap(const uint8_t* bitmap, size_t nrows);
+  // Return the index of the first set (resp. unset) bit in ["offset", "end")
+  // of the current view, or "end" if there is none.
+  size_t FindFirstSetBit(size_t offset, size_t end) const {
+    return FindFirst(offset, end, true);
+  }
+  size_t FindFirstUnsetBit(size_t offset, size_t end) const {
+    return FindFirst(offset, end, false);
+  }
  private:
+  size_t FindFirst(size_t offset, size_t end, bool value) const {
+    DCHECK_LE(offset, end);
+    DCHECK_LE(end, sel_vec_->nrows() - row_offset_);
+    size_t idx;
+    if (BitmapFindFirst(sel_vec_->bitmap(), row_offset_ + offset, row_offset_ + end, value, &idx)) {
+      return idx - row_offset_;
+    }
+    return end;
+  }
+
   SelectionVector* sel_vec_;
   size_t row_offset_;
 };
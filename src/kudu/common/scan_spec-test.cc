@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -44,6 +45,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+using std::pair;
+using std::string;
 using std::unique_ptr;
 using std::vector;
 
@@ -133,6 +136,14 @@ class TestScanSpec : public KuduTest {
     pool_.Add(enc_key.release());
   }
 
+  // Returns the encoded primary key of the provided row.
+  static string EncodeKey(const KuduPartialRow& row) {
+    CHECK(row.IsKeySet());
+    ConstContiguousRow cont_row(row.schema(), row.row_data_);
+    unique_ptr<EncodedKey> enc_key(EncodedKey::FromContiguousRow(cont_row));
+    return enc_key->encoded_key().ToString();
+  }
+
  protected:
   Arena arena_;
   AutoReleasePool pool_;
@@ -876,4 +887,54 @@ TEST_F(SingleIntKeyTest, TestNoPredicates) {
   EXPECT_EQ("", spec.ToString(schema_));
 }
 
+// Test that key ranges are coalesced and bound the scan.
+TEST_F(SingleIntKeyTest, TestKeyRanges) {
+  const auto encode = [&](int8_t val) {
+    KuduPartialRow row(&schema_);
+    CHECK_OK(row.SetInt8("a", val));
+    return EncodeKey(row);
+  };
+
+  {
+    ScanSpec spec;
+    ASSERT_OK(spec.SetKeyRanges(schema_, &arena_, &pool_, {
+        { encode(40), encode(50) },
+        { encode(10), encode(20) },
+        { encode(50), encode(60) },
+        { encode(15), encode(30) },
+        { encode(35), encode(35) } }));
+    vector<pair<string, string>> expected = {
+        { encode(10), encode(30) },
+        { encode(40), encode(60) } };
+    EXPECT_EQ(expected, spec.key_ranges());
+    EXPECT_EQ("PK >= (int8 a=10) AND PK < (int8 a=60)", spec.ToString(schema_));
+  }
+  {
+    // Ranges overlapping an unbounded range are merged into it.
+    ScanSpec spec;
+    ASSERT_OK(spec.SetKeyRanges(schema_, &arena_, &pool_, {
+        { encode(20), "" },
+        { "", encode(5) },
+        { encode(10), encode(25) } }));
+    vector<pair<string, string>> expected = {
+        { "", encode(5) },
+        { encode(10), "" } };
+    EXPECT_EQ(expected, spec.key_ranges());
+    EXPECT_EQ("", spec.ToString(schema_));
+  }
+  {
+    // A scan over empty ranges only is short-circuited.
+    ScanSpec spec;
+    ASSERT_OK(spec.SetKeyRanges(schema_, &arena_, &pool_, {
+        { encode(20), encode(20) } }));
+    EXPECT_TRUE(spec.CanShortCircuit());
+  }
+  {
+    ScanSpec spec;
+    Status s = spec.SetKeyRanges(schema_, &arena_, &pool_, {
+        { encode(20), encode(10) } });
+    EXPECT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  }
+}
+
 } // namespace kudu
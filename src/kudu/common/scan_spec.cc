@@ -40,12 +40,15 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/auto_release_pool.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/sorted_disjoint_interval_list.h"
 
 using std::any_of;
 using std::max;
+using std::min;
 using std::move;
 using std::pair;
 using std::string;
+using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
@@ -108,6 +111,78 @@ void ScanSpec::SetExclusiveUpperBoundKey(const EncodedKey* key) {
   }
 }
 
+Status ScanSpec::SetKeyRanges(const Schema& schema,
+                              Arena* arena,
+                              AutoReleasePool* pool,
+                              vector<pair<string, string>> ranges) {
+  if (ranges.empty()) {
+    return Status::OK();
+  }
+  // Validate the ranges and split off the ones without an upper bound, which
+  // coalesce into the single range starting at the least of their lower bounds.
+  vector<pair<string, string>> bounded;
+  bool has_unbounded = false;
+  string unbounded_lower;
+  for (auto& range : ranges) {
+    for (const auto* key : { &range.first, &range.second }) {
+      if (!key->empty()) {
+        unique_ptr<EncodedKey> decoded;
+        RETURN_NOT_OK_PREPEND(EncodedKey::DecodeEncodedString(schema, arena, *key, &decoded),
+                              "Invalid scan key range bound");
+      }
+    }
+    if (range.second.empty()) {
+      if (!has_unbounded || range.first < unbounded_lower) {
+        unbounded_lower = std::move(range.first);
+      }
+      has_unbounded = true;
+      continue;
+    }
+    if (range.first > range.second) {
+      return Status::InvalidArgument("Inverted scan key range");
+    }
+    if (range.first < range.second) {
+      bounded.emplace_back(std::move(range));
+    }
+  }
+  RETURN_NOT_OK(CoalesceIntervals(&bounded));
+
+  vector<pair<string, string>> coalesced;
+  for (auto& range : bounded) {
+    if (has_unbounded && range.second >= unbounded_lower) {
+      unbounded_lower = min(unbounded_lower, range.first);
+      break;
+    }
+    coalesced.emplace_back(std::move(range));
+  }
+  if (has_unbounded) {
+    coalesced.emplace_back(std::move(unbounded_lower), "");
+  }
+
+  // Every range was empty, so no row falls in any of them: keep an empty
+  // envelope so the scan short-circuits.
+  if (coalesced.empty()) {
+    coalesced.emplace_back(ranges.front().first, ranges.front().first);
+  }
+
+  const string& lower = coalesced.front().first;
+  const string& upper = coalesced.back().second;
+  if (!lower.empty()) {
+    unique_ptr<EncodedKey> key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(schema, arena, lower, &key));
+    SetLowerBoundKey(key.get());
+    pool->Add(key.release());
+  }
+  if (!upper.empty()) {
+    unique_ptr<EncodedKey> key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(schema, arena, upper, &key));
+    SetExclusiveUpperBoundKey(key.get());
+    pool->Add(key.release());
+  }
+  key_ranges_ = std::move(coalesced);
+  return Status::OK();
+}
+
 void ScanSpec::SetLowerBoundPartitionKey(const Slice& partition_key) {
   if (partition_key.compare(lower_bound_partition_key_) > 0) {
     lower_bound_partition_key_ = partition_key.ToString();
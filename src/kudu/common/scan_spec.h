@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -26,6 +27,7 @@
 
 #include "kudu/common/column_predicate.h" // IWYU pragma: keep
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 
 namespace kudu {
 
@@ -86,6 +88,19 @@ class ScanSpec {
   // If called multiple times, the most restrictive key will be used.
   void SetExclusiveUpperBoundKey(const EncodedKey* key);
 
+  // Restricts the scan to the union of the primary key ranges in 'ranges',
+  // each a pair of an encoded inclusive lower bound and an encoded exclusive
+  // upper bound, where an empty bound is unbounded. The ranges are coalesced
+  // into a sorted list of disjoint ranges, and the lower and upper bound keys
+  // are narrowed to the envelope of the ranges. The keys of the envelope are
+  // allocated from 'arena' and owned by 'pool'.
+  //
+  // Returns an error if a bound fails to decode or a range is inverted.
+  Status SetKeyRanges(const Schema& schema,
+                      Arena* arena,
+                      AutoReleasePool* pool,
+                      std::vector<std::pair<std::string, std::string>> ranges);
+
   // Sets the lower bound (inclusive) partition key for the scan.
   //
   // The scan spec makes a copy of 'slice'; the caller may free it afterward.
@@ -113,6 +128,13 @@ class ScanSpec {
     return exclusive_upper_bound_key_;
   }
 
+  // Returns the sorted disjoint key ranges of the scan, or an empty list if
+  // the scan isn't restricted to key ranges beyond its bound keys. An empty
+  // upper bound is unbounded.
+  const std::vector<std::pair<std::string, std::string>>& key_ranges() const {
+    return key_ranges_;
+  }
+
   const std::string& lower_bound_partition_key() const {
     return lower_bound_partition_key_;
   }
@@ -168,6 +190,7 @@ class ScanSpec {
   std::unordered_map<std::string, ColumnPredicate> predicates_;
   const EncodedKey* lower_bound_key_;
   const EncodedKey* exclusive_upper_bound_key_;
+  std::vector<std::pair<std::string, std::string>> key_ranges_;
   std::string lower_bound_partition_key_;
   std::string exclusive_upper_bound_partition_key_;
   bool cache_blocks_;
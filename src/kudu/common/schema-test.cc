@@ -31,6 +31,7 @@
 #include "kudu/common/common.pb.h"
 #include "kudu/common/key_encoder.h"
 #include "kudu/common/row.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/types.h"
 #include "kudu/gutil/strings/stringpiece.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -439,6 +440,49 @@ TEST_F(TestSchema, TestProjectRename) {
   ASSERT_EQ(row_projector.projection_defaults()[0], 2);      // non_present schema2
 }
 
+// Test projecting rows with cells of each fixed size, nullable cells and
+// cells with indirect data.
+TEST_F(TestSchema, TestProjectRow) {
+  Schema schema1({ ColumnSchema("key", STRING),
+                   ColumnSchema("i8", INT8),
+                   ColumnSchema("i16", INT16, true),
+                   ColumnSchema("i32", INT32),
+                   ColumnSchema("i64", INT64, true),
+                   ColumnSchema("dbl", DOUBLE) },
+                 1);
+  int32_t default_value = 7;
+  Schema schema2({ ColumnSchema("dbl", DOUBLE),
+                   ColumnSchema("i64", INT64, true),
+                   ColumnSchema("key", STRING),
+                   ColumnSchema("i16", INT16, true),
+                   ColumnSchema("i8", INT8),
+                   ColumnSchema("i32", INT32),
+                   ColumnSchema("non_present", INT32, false, &default_value) },
+                 0);
+  RowProjector row_projector(&schema1, &schema2);
+  ASSERT_OK(row_projector.Init());
+
+  RowBuilder rb(&schema1);
+  rb.AddString(string("row_a"));
+  rb.AddInt8(-8);
+  rb.AddNull();
+  rb.AddInt32(-32);
+  rb.AddInt64(-64);
+  rb.AddDouble(1.5);
+  ConstContiguousRow src_row(&schema1, rb.data());
+
+  Arena arena(1024);
+  ContiguousRow dst_row(&schema2, static_cast<uint8_t*>(
+      arena.AllocateBytes(ContiguousRowHelper::row_size(schema2))));
+  ASSERT_OK(row_projector.ProjectRowForRead(src_row, &dst_row, &arena));
+  ASSERT_EQ(R"((double dbl=1.5, int64 i64=-64, string key="row_a", int16 i16=NULL, )"
+            R"(int8 i8=-8, int32 i32=-32, int32 non_present=7))",
+            schema2.DebugRow(dst_row));
+  // The indirect data is relocated into the arena.
+  ASSERT_NE(reinterpret_cast<const Slice*>(src_row.cell_ptr(0))->data(),
+            reinterpret_cast<const Slice*>(dst_row.cell_ptr(2))->data());
+}
+
 // Test that we can map a projection schema (no column ids) onto a tablet
 // schema (column ids).
 TEST_F(TestSchema, TestGetMappedReadProjection) {
@@ -671,6 +715,61 @@ TEST_F(TestSchema, TestFindColumn) {
   ASSERT_EQ(s.ToString(), "Not found: No such column: col3");
 }
 
+// Test that keys encoded in place, as integer keys are, and in batches match
+// the keys encoded a cell at a time by the key encoders.
+TEST_F(TestSchema, TestEncodeComparableKeys) {
+  const Schema int_schema({ ColumnSchema("i8", INT8),
+                            ColumnSchema("u16", UINT16),
+                            ColumnSchema("i32", INT32),
+                            ColumnSchema("i64", INT64),
+                            ColumnSchema("val", STRING) },
+                          4);
+  const Schema str_schema({ ColumnSchema("i32", INT32),
+                            ColumnSchema("str", STRING),
+                            ColumnSchema("val", STRING) },
+                          2);
+  const int kNumRows = 10;
+  for (const Schema* schema : { &int_schema, &str_schema }) {
+    SCOPED_TRACE(schema->ToString());
+    Arena arena(1024);
+    RowBlock block(schema, kNumRows, &arena);
+    for (int i = 0; i < kNumRows; i++) {
+      RowBlockRow row = block.row(i);
+      for (int c = 0; c < schema->num_columns(); c++) {
+        uint8_t* cell = row.mutable_cell_ptr(c);
+        switch (schema->column(c).type_info()->type()) {
+          case INT8: *reinterpret_cast<int8_t*>(cell) = i * 13 - 60; break;
+          case UINT16: *reinterpret_cast<uint16_t*>(cell) = i * 7001; break;
+          case INT32: *reinterpret_cast<int32_t*>(cell) = i * 100003 - 500000; break;
+          case INT64: *reinterpret_cast<int64_t*>(cell) = (i - 5) * 1000000007LL; break;
+          case STRING: {
+            Slice s(i % 2 ? string("a\0b", 3) : Substitute("row $0", i));
+            CHECK(arena.RelocateSlice(s, reinterpret_cast<Slice*>(cell)));
+            break;
+          }
+          default: LOG(FATAL) << "unexpected type";
+        }
+      }
+    }
+
+    faststring keys_buf;
+    vector<Slice> keys;
+    schema->EncodeComparableKeys(block, &keys_buf, &keys);
+    ASSERT_EQ(kNumRows, keys.size());
+    for (int i = 0; i < kNumRows; i++) {
+      RowBlockRow row = block.row(i);
+      faststring expected;
+      for (int c = 0; c < schema->num_key_columns(); c++) {
+        GetKeyEncoder<faststring>(schema->column(c).type_info()).Encode(
+            row.cell_ptr(c), c == schema->num_key_columns() - 1, &expected);
+      }
+      faststring key;
+      ASSERT_EQ(Slice(expected), schema->EncodeComparableKey(row, &key));
+      ASSERT_EQ(Slice(expected), keys[i]);
+    }
+  }
+}
+
 #ifdef NDEBUG
 TEST(TestKeyEncoder, BenchmarkSimpleKey) {
   faststring fs;
@@ -21,7 +21,7 @@
 #include <unordered_set>
 
 #include "kudu/common/row.h"
-#include "kudu/common/rowblock.h" // IWYU pragma: keep
+#include "kudu/common/rowblock.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/strcat.h"
@@ -222,6 +222,9 @@ void Schema::CopyFrom(const Schema& other) {
 
   first_is_deleted_virtual_column_idx_ = other.first_is_deleted_virtual_column_idx_;
   has_nullables_ = other.has_nullables_;
+  key_encoders_ = other.key_encoders_;
+  integer_key_columns_ = other.integer_key_columns_;
+  integer_key_size_ = other.integer_key_size_;
 }
 
 Schema::Schema(Schema&& other) noexcept
@@ -233,7 +236,10 @@ Schema::Schema(Schema&& other) noexcept
       name_to_index_(std::move(other.name_to_index_)),
       id_to_index_(std::move(other.id_to_index_)),
       first_is_deleted_virtual_column_idx_(other.first_is_deleted_virtual_column_idx_),
-      has_nullables_(other.has_nullables_) {
+      has_nullables_(other.has_nullables_),
+      key_encoders_(std::move(other.key_encoders_)),
+      integer_key_columns_(std::move(other.integer_key_columns_)),
+      integer_key_size_(other.integer_key_size_) {
 }
 
 Schema& Schema::operator=(Schema&& other) noexcept {
@@ -246,6 +252,9 @@ Schema& Schema::operator=(Schema&& other) noexcept {
     id_to_index_ = std::move(other.id_to_index_);
     first_is_deleted_virtual_column_idx_ = other.first_is_deleted_virtual_column_idx_;
     has_nullables_ = other.has_nullables_;
+    key_encoders_ = std::move(other.key_encoders_);
+    integer_key_columns_ = std::move(other.integer_key_columns_);
+    integer_key_size_ = other.integer_key_size_;
     name_to_index_ = std::move(other.name_to_index_);
   }
   return *this;
@@ -326,9 +335,115 @@ Status Schema::Reset(vector<ColumnSchema> cols,
     }
   }
 
+  // Resolve how the keys are encoded.
+  key_encoders_.clear();
+  integer_key_columns_.clear();
+  integer_key_size_ = 0;
+  bool integer_key = key_columns > 0;
+  for (int i = 0; i < key_columns; ++i) {
+    const TypeInfo* ti = cols_[i].type_info();
+    if (!IsTypeAllowableInKey(ti)) {
+      key_encoders_.push_back(nullptr);
+      integer_key = false;
+      continue;
+    }
+    key_encoders_.push_back(&GetKeyEncoder<faststring>(ti));
+    switch (ti->physical_type()) {
+      case INT8: case INT16: case INT32: case INT64:
+        integer_key_columns_.push_back({ static_cast<uint8_t>(ti->size()), true });
+        break;
+      case UINT8: case UINT16: case UINT32: case UINT64:
+        integer_key_columns_.push_back({ static_cast<uint8_t>(ti->size()), false });
+        break;
+      default:
+        integer_key = false;
+        break;
+    }
+  }
+  if (integer_key) {
+    for (const IntegerKeyColumn& col : integer_key_columns_) {
+      integer_key_size_ += col.size;
+    }
+  } else {
+    integer_key_columns_.clear();
+  }
+
   return Status::OK();
 }
 
+namespace {
+
+// Encodes the T cells of the integer key column 'src' of 'nrows' rows into
+// the keys laid out every 'stride' bytes from 'dst'.
+template<typename T>
+void EncodeIntegerKeyColumn(const uint8_t* src, size_t nrows, bool is_signed,
+                            size_t stride, uint8_t* dst) {
+  for (size_t i = 0; i < nrows; i++) {
+    EncodeIntegerKeyCell<T>(src + i * sizeof(T), is_signed, dst + i * stride);
+  }
+}
+
+} // anonymous namespace
+
+void Schema::EncodeComparableKeys(const RowBlock& block,
+                                  faststring* dst,
+                                  vector<Slice>* keys) const {
+  DCHECK_KEY_PROJECTION_SCHEMA_EQ(*this, *block.schema());
+  const size_t nrows = block.nrows();
+  keys->resize(nrows);
+
+  if (integer_key_size_ > 0) {
+    // The keys have a fixed size: encode them a column at a time, straight
+    // into their slots.
+    dst->resize(nrows * integer_key_size_);
+    size_t key_offset = 0;
+    for (size_t c = 0; c < num_key_columns_; c++) {
+      const IntegerKeyColumn& col = integer_key_columns_[c];
+      const uint8_t* src = block.column_block(c).data();
+      uint8_t* col_dst = dst->data() + key_offset;
+      switch (col.size) {
+        case 1:
+          EncodeIntegerKeyColumn<uint8_t>(src, nrows, col.is_signed, integer_key_size_, col_dst);
+          break;
+        case 2:
+          EncodeIntegerKeyColumn<uint16_t>(src, nrows, col.is_signed, integer_key_size_, col_dst);
+          break;
+        case 4:
+          EncodeIntegerKeyColumn<uint32_t>(src, nrows, col.is_signed, integer_key_size_, col_dst);
+          break;
+        case 8:
+          EncodeIntegerKeyColumn<uint64_t>(src, nrows, col.is_signed, integer_key_size_, col_dst);
+          break;
+        default:
+          LOG(FATAL) << "bad key cell size: " << col.size;
+      }
+      key_offset += col.size;
+    }
+    for (size_t i = 0; i < nrows; i++) {
+      (*keys)[i] = Slice(dst->data() + i * integer_key_size_, integer_key_size_);
+    }
+    return;
+  }
+
+  // Append the keys one after the other, only pointing into 'dst' once it's
+  // done growing: until then, the size of each key's slice is where it ends.
+  dst->clear();
+  for (size_t i = 0; i < nrows; i++) {
+    RowBlockRow row = block.row(i);
+    for (size_t c = 0; c < num_key_columns_; c++) {
+      DCHECK(key_encoders_[c]) << "no key encoder for " << cols_[c].ToString();
+      key_encoders_[c]->Encode(row.cell_ptr(c), c == num_key_columns_ - 1, dst);
+    }
+    (*keys)[i] = Slice(static_cast<const uint8_t*>(nullptr), dst->size());
+  }
+  size_t start = 0;
+  for (size_t i = 0; i < nrows; i++) {
+    size_t end = (*keys)[i].size();
+    (*keys)[i] = Slice(dst->data() + start, end - start);
+    start = end;
+  }
+}
+
 Status Schema::FindColumn(Slice col_name, int* idx) const {
   DCHECK(idx);
   StringPiece sp(reinterpret_cast<const char*>(col_name.data()), col_name.size());
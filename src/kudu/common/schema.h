@@ -70,6 +70,7 @@ template <class X> struct GoodFastHash;
 namespace kudu {
 
 class Arena;
+class RowBlock;
 
 // The ID of a column. Each column in a table has a unique ID.
 struct ColumnId {
@@ -462,7 +463,8 @@ class Schema {
       // the default (32).
       name_to_index_(1),
       first_is_deleted_virtual_column_idx_(kColumnNotFound),
-      has_nullables_(false) {
+      has_nullables_(false),
+      integer_key_size_(0) {
     name_to_index_.set_empty_key(StringPiece());
   }
 
@@ -765,16 +767,42 @@ class Schema {
   Slice EncodeComparableKey(const RowType& row, faststring *dst) const {
     DCHECK_KEY_PROJECTION_SCHEMA_EQ(*this, *row.schema());
 
+    if (integer_key_size_ > 0) {
+      // The key has a fixed size: encode its cells in place.
+      dst->resize(integer_key_size_);
+      uint8_t* p = dst->data();
+      for (size_t i = 0; i < num_key_columns_; i++) {
+        const IntegerKeyColumn& col = integer_key_columns_[i];
+        switch (col.size) {
+          case 1: EncodeIntegerKeyCell<uint8_t>(row.cell_ptr(i), col.is_signed, p); break;
+          case 2: EncodeIntegerKeyCell<uint16_t>(row.cell_ptr(i), col.is_signed, p); break;
+          case 4: EncodeIntegerKeyCell<uint32_t>(row.cell_ptr(i), col.is_signed, p); break;
+          case 8: EncodeIntegerKeyCell<uint64_t>(row.cell_ptr(i), col.is_signed, p); break;
+          default: LOG(FATAL) << "bad key cell size: " << col.size;
+        }
+        p += col.size;
+      }
+      return Slice(*dst);
+    }
+
     dst->clear();
     for (size_t i = 0; i < num_key_columns_; i++) {
       DCHECK(!cols_[i].is_nullable());
-      const TypeInfo* ti = cols_[i].type_info();
+      DCHECK(key_encoders_[i]) << "no key encoder for " << cols_[i].ToString();
       bool is_last = i == num_key_columns_ - 1;
-      GetKeyEncoder<faststring>(ti).Encode(row.cell_ptr(i), is_last, dst);
+      key_encoders_[i]->Encode(row.cell_ptr(i), is_last, dst);
     }
     return Slice(*dst);
   }
 
+  // Encodes the keys of all the rows of 'block', as EncodeComparableKey()
+  // would, one after the other into 'dst', replacing its current contents.
+  // 'keys' is resized to the number of rows and set to the encoded keys,
+  // which point into 'dst'.
+  void EncodeComparableKeys(const RowBlock& block,
+                            faststring* dst,
+                            std::vector<Slice>* keys) const;
+
   // Enum to configure how a Schema is stringified.
   enum ToStringMode {
     BASE_INFO = 0,
@@ -986,6 +1014,23 @@ class Schema {
   // Cached indicator whether any columns are nullable.
   bool has_nullables_;
 
+  // The encoders of the key columns, resolved once rather than for every
+  // encoded key. Null for the columns of types which can't be in a key.
+  std::vector<const KeyEncoder<faststring>*> key_encoders_;
+
+  // The size and signedness of an integer key column's cells.
+  struct IntegerKeyColumn {
+    uint8_t size;
+    bool is_signed;
+  };
+
+  // If all the key columns are integers of up to 8 bytes, their encoded keys
+  // have a fixed size, 'integer_key_size_', and are encoded in place, from
+  // the description of the columns in 'integer_key_columns_'. Otherwise,
+  // 'integer_key_size_' is 0 and 'integer_key_columns_' is empty.
+  std::vector<IntegerKeyColumn> integer_key_columns_;
+  size_t integer_key_size_;
+
   // NOTE: if you add more members, make sure to add the appropriate code to
   // CopyFrom() and the move constructor and assignment operator as well, to
   // prevent subtle bugs.
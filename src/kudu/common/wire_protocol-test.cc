@@ -293,6 +293,51 @@ TEST_F(WireProtocolTest, TestRowBlockToRowwisePB) {
   }
 }
 
+// Serialize several blocks of rows into separate buffers, as chained by the
+// tablet server, and ensure that the concatenated buffers convert back to the
+// original rows.
+TEST_F(WireProtocolTest, TestRowBlocksToChainedRowwisePB) {
+  static constexpr int kNumBlocks = 3;
+  Arena arena(1024);
+  std::list<RowBlock> blocks;
+  vector<faststring> direct_chain(kNumBlocks);
+  vector<faststring> indirect_chain(kNumBlocks);
+  int num_rows = 0;
+  size_t indirect_offset = 0;
+  for (int i = 0; i < kNumBlocks; i++) {
+    blocks.emplace_back(&schema_, 30, &arena);
+    FillRowBlockWithTestRows(&blocks.back());
+    num_rows += SerializeRowBlock(blocks.back(), nullptr, &direct_chain[i], &indirect_chain[i],
+                                  /*pad_unixtime_micros_to_16_bytes=*/false, indirect_offset);
+    indirect_offset += indirect_chain[i].size();
+  }
+  faststring direct, indirect;
+  for (int i = 0; i < kNumBlocks; i++) {
+    direct.append(direct_chain[i].data(), direct_chain[i].size());
+    indirect.append(indirect_chain[i].data(), indirect_chain[i].size());
+  }
+
+  RowwiseRowBlockPB pb;
+  pb.set_num_rows(num_rows);
+  vector<const uint8_t*> row_ptrs;
+  Slice direct_sidecar = direct;
+  ASSERT_OK(ExtractRowsFromRowBlockPB(schema_, pb, indirect,
+                                      &direct_sidecar, &row_ptrs));
+  ASSERT_EQ(num_rows, row_ptrs.size());
+  int dst_row_idx = 0;
+  for (const auto& block : blocks) {
+    for (int i = 0; i < block.nrows(); ++i) {
+      if (!block.selection_vector()->IsRowSelected(i)) {
+        continue;
+      }
+      ConstContiguousRow row_roundtripped(&schema_, row_ptrs[dst_row_idx]);
+      EXPECT_EQ(schema_.DebugRow(block.row(i)),
+                schema_.DebugRow(row_roundtripped));
+      dst_row_idx++;
+    }
+  }
+}
+
 // Create blocks of rows and ensure that they can be converted to the columnar serialized
 // layout.
 TEST_F(WireProtocolTest, TestRowBlockToColumnarPB) {
@@ -314,6 +359,18 @@ TEST_F(WireProtocolTest, TestRowBlockToColumnarPB) {
 
   // Verify that the resulting serialized data matches the concatenated original data blocks.
   ASSERT_EQ(5, batch.columns().size());
+
+  // Varlen data is chained across several buffers, sent back to back.
+  vector<faststring> varlen_data(batch.columns().size());
+  for (int c = 0; c < batch.columns().size(); c++) {
+    const auto& serialized_col = batch.columns()[c];
+    if (serialized_col.varlen_data) {
+      for (const auto& chunk : *serialized_col.varlen_data) {
+        varlen_data[c].append(chunk.data(), chunk.size());
+      }
+      ASSERT_EQ(serialized_col.varlen_data_size(), varlen_data[c].size());
+    }
+  }
   int dst_row_idx = 0;
   for (const auto& block : blocks) {
     for (int src_row_idx = 0; src_row_idx < block.nrows(); src_row_idx++) {
@@ -343,7 +400,7 @@ TEST_F(WireProtocolTest, TestRowBlockToColumnarPB) {
           uint32_t start_offset = UnalignedLoad<uint32_t>(offset_ptr);
           uint32_t end_offset = UnalignedLoad<uint32_t>(offset_ptr + sizeof(uint32_t));
           ASSERT_GE(end_offset, start_offset);
-          serialized_val = Slice(serialized_col.varlen_data->data() + start_offset,
+          serialized_val = Slice(varlen_data[c].data() + start_offset,
                                  end_offset - start_offset);
           memcpy(&orig_val, row.cell_ptr(c), type_size);
         } else {
@@ -359,6 +416,67 @@ TEST_F(WireProtocolTest, TestRowBlockToColumnarPB) {
 }
 
 
+// Ensure that BOOL columns are packed into bitmaps when converting blocks of
+// rows to the columnar layout with 'pack_bools' set, as for the Arrow layout.
+TEST_F(WireProtocolTest, TestRowBlockToColumnarPBWithPackedBools) {
+  static constexpr int kNumBlocks = 3;
+  static constexpr int kNumRowsPerBlock = 30;
+  static constexpr int kBatchSizeBytes = 8192 * 1024;
+  Schema schema({ ColumnSchema("b", BOOL),
+                  ColumnSchema("nullable_b", BOOL, /*is_nullable=*/true) }, 0);
+  Random rng(SeedRandom());
+  Arena arena(1024);
+  std::list<RowBlock> blocks;
+  for (int i = 0; i < kNumBlocks; i++) {
+    blocks.emplace_back(&schema, kNumRowsPerBlock, &arena);
+    RowBlock* block = &blocks.back();
+    block->selection_vector()->SetAllTrue();
+    for (int r = 0; r < block->nrows(); r++) {
+      if (rng.OneIn(5)) {
+        block->selection_vector()->SetRowUnselected(r);
+      }
+      RowBlockRow row = block->row(r);
+      *reinterpret_cast<bool*>(row.mutable_cell_ptr(0)) = rng.OneIn(2);
+      *reinterpret_cast<bool*>(row.mutable_cell_ptr(1)) = rng.OneIn(2);
+      row.cell(1).set_null(rng.OneIn(3));
+    }
+  }
+
+  ColumnarSerializedBatch batch(schema, schema, kBatchSizeBytes, /*pack_bools=*/true);
+  int num_rows = 0;
+  for (const auto& block : blocks) {
+    num_rows += batch.AddRowBlock(block);
+  }
+  ASSERT_EQ(2, batch.columns().size());
+  for (const auto& serialized_col : batch.columns()) {
+    ASSERT_TRUE(serialized_col.packed_bools);
+    ASSERT_EQ(BitmapSize(num_rows), serialized_col.data.size());
+  }
+
+  int dst_row_idx = 0;
+  for (const auto& block : blocks) {
+    for (int src_row_idx = 0; src_row_idx < block.nrows(); src_row_idx++) {
+      if (!block.selection_vector()->IsRowSelected(src_row_idx)) {
+        continue;
+      }
+      SCOPED_TRACE(dst_row_idx);
+      const auto& row = block.row(src_row_idx);
+      for (int c = 0; c < schema.num_columns(); c++) {
+        SCOPED_TRACE(c);
+        const auto& serialized_col = batch.columns()[c];
+        bool is_null = schema.column(c).is_nullable() && row.is_null(c);
+        if (schema.column(c).is_nullable()) {
+          EXPECT_EQ(!is_null, BitmapTest(serialized_col.non_null_bitmap->data(), dst_row_idx));
+        }
+        bool expected = !is_null && *reinterpret_cast<const bool*>(row.cell_ptr(c));
+        EXPECT_EQ(expected, BitmapTest(serialized_col.data.data(), dst_row_idx));
+      }
+      dst_row_idx++;
+    }
+  }
+  ASSERT_EQ(num_rows, dst_row_idx);
+}
+
 // Create a block of rows in columnar layout and ensure that it can be
 // converted to and from protobuf.
 TEST_F(WireProtocolTest, TestColumnarRowBlockToPBWithPadding) {
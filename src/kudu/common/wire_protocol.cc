@@ -43,7 +43,11 @@
 #include "kudu/gutil/fixedarray.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/fastmem.h"
+#include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/strip.h"
+#include "kudu/gutil/strings/stringpiece.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/bitmap.h"
@@ -552,7 +556,8 @@ void ColumnPredicateToPB(const ColumnPredicate& predicate,
 Status ColumnPredicateFromPB(const Schema& schema,
                              Arena* arena,
                              const ColumnPredicatePB& pb,
-                             boost::optional<ColumnPredicate>* predicate) {
+                             boost::optional<ColumnPredicate>* predicate,
+                             const vector<BlockBloomFilter*>& registered_bloom_filters) {
   if (!pb.has_column()) {
     return Status::InvalidArgument("Column predicate must include a column", SecureDebugString(pb));
   }
@@ -615,8 +620,14 @@ Status ColumnPredicateFromPB(const Schema& schema,
     };
     case ColumnPredicatePB::kInBloomFilter: {
       const auto& in_bloom_filter = pb.in_bloom_filter();
-      vector<BlockBloomFilter*> bloom_filters;
-      if (in_bloom_filter.bloom_filters_size() == 0) {
+      if (static_cast<size_t>(in_bloom_filter.registered_filter_ids_size()) !=
+          registered_bloom_filters.size()) {
+        return Status::InvalidArgument(
+            Substitute("Invalid bloom filter predicate on column: $0. "
+                       "Registered bloom filters not resolved", col.name()));
+      }
+      vector<BlockBloomFilter*> bloom_filters(registered_bloom_filters);
+      if (in_bloom_filter.bloom_filters_size() == 0 && bloom_filters.empty()) {
         return Status::InvalidArgument(
             Substitute("Invalid bloom filter predicate on column: $0. "
                        "No bloom filters supplied", col.name()));
@@ -649,6 +660,10 @@ Status ColumnPredicateFromPB(const Schema& schema,
 
 const char kTableHistoryMaxAgeSec[] = "kudu.table.history_max_age_sec";
 const char kTableMaintenancePriority[] = "kudu.table.maintenance_priority";
+const char kTableTtlColumn[] = "kudu.table.ttl_column";
+const char kTableTtlSec[] = "kudu.table.ttl_sec";
+const char kTableSecondaryIndexColumns[] = "kudu.table.secondary_index_columns";
+const char kTableRollupGroupByColumns[] = "kudu.table.rollup_group_by_columns";
 Status ExtraConfigPBToMap(const TableExtraConfigPB& pb, map<string, string>* configs) {
   Map<string, string> tmp;
   RETURN_NOT_OK(ExtraConfigPBToPBMap(pb, &tmp));
@@ -682,6 +697,28 @@ Status ExtraConfigPBFromPBMap(const Map<string, string>& configs, TableExtraConf
         RETURN_NOT_OK(ParseInt32Config(name, value, &maintenance_priority));
         result.set_maintenance_priority(maintenance_priority);
       }
+    } else if (name == kTableTtlColumn) {
+      if (!value.empty()) {
+        result.set_ttl_column(value);
+      }
+    } else if (name == kTableTtlSec) {
+      if (!value.empty()) {
+        int32_t ttl_sec;
+        RETURN_NOT_OK(ParseInt32Config(name, value, &ttl_sec));
+        result.set_ttl_sec(ttl_sec);
+      }
+    } else if (name == kTableSecondaryIndexColumns) {
+      // A comma-separated list of column names.
+      for (StringPiece column : strings::Split(value, ",", strings::SkipWhitespace())) {
+        StripWhiteSpace(&column);
+        result.add_secondary_index_columns(column.ToString());
+      }
+    } else if (name == kTableRollupGroupByColumns) {
+      if (!value.empty()) {
+        int32_t rollup_group_by_columns;
+        RETURN_NOT_OK(ParseInt32Config(name, value, &rollup_group_by_columns));
+        result.set_rollup_group_by_columns(rollup_group_by_columns);
+      }
     } else {
       LOG(WARNING) << "Unknown extra configuration property: " << name;
     }
@@ -698,6 +735,18 @@ Status ExtraConfigPBToPBMap(const TableExtraConfigPB& pb, Map<string, string>* c
   if (pb.has_maintenance_priority()) {
     result[kTableMaintenancePriority] = std::to_string(pb.maintenance_priority());
   }
+  if (pb.has_ttl_column()) {
+    result[kTableTtlColumn] = pb.ttl_column();
+  }
+  if (pb.has_ttl_sec()) {
+    result[kTableTtlSec] = std::to_string(pb.ttl_sec());
+  }
+  if (pb.secondary_index_columns_size() > 0) {
+    result[kTableSecondaryIndexColumns] = JoinStrings(pb.secondary_index_columns(), ",");
+  }
+  if (pb.has_rollup_group_by_columns()) {
+    result[kTableRollupGroupByColumns] = std::to_string(pb.rollup_group_by_columns());
+  }
   *configs = std::move(result);
   return Status::OK();
 }
@@ -891,8 +940,8 @@ void AppendRowToString<RowBlockRow>(const RowBlockRow& row, string* buf) {
 template<bool IS_NULLABLE, bool IS_VARLEN>
 static void CopyColumn(
     const ColumnBlock& column_block, int dst_col_idx, uint8_t* __restrict__ dst_base,
-    faststring* indirect_data, const Schema* dst_schema, size_t row_stride,
-    size_t schema_byte_size, size_t column_offset,
+    faststring* indirect_data, size_t indirect_data_offset, const Schema* dst_schema,
+    size_t row_stride, size_t schema_byte_size, size_t column_offset,
     const vector<uint16_t>& row_idx_select) {
   DCHECK(dst_schema);
   uint8_t* dst = dst_base + column_offset;
@@ -907,7 +956,7 @@ static void CopyColumn(
       BitmapChange(dst + offset_to_non_null_bitmap, dst_col_idx, true);
     } else if (IS_VARLEN) {
       const Slice* slice = reinterpret_cast<const Slice *>(src);
-      size_t offset_in_indirect = indirect_data->size();
+      size_t offset_in_indirect = indirect_data_offset + indirect_data->size();
       indirect_data->append(reinterpret_cast<const char*>(slice->data()), slice->size());
 
       Slice* dst_slice = reinterpret_cast<Slice *>(dst);
@@ -933,7 +982,8 @@ int SerializeRowBlock(const RowBlock& block,
                       const Schema* projection_schema,
                       faststring* data_buf,
                       faststring* indirect_data,
-                      bool pad_unixtime_micros_to_16_bytes) {
+                      bool pad_unixtime_micros_to_16_bytes,
+                      size_t indirect_data_offset) {
   DCHECK_GT(block.nrows(), 0);
 
   vector<uint16_t> selected_row_indexes =
@@ -998,16 +1048,20 @@ int SerializeRowBlock(const RowBlock& block,
     // even bigger gains, since we could inline the constant cell sizes and column
     // offsets.
     if (col.is_nullable() && col.type_info()->physical_type() == BINARY) {
-      CopyColumn<true, true>(column_block, p_schema_idx, base, indirect_data, projection_schema,
+      CopyColumn<true, true>(column_block, p_schema_idx, base, indirect_data,
+                             indirect_data_offset, projection_schema,
                              row_stride, schema_byte_size, column_offset, selected_row_indexes);
     } else if (col.is_nullable() && col.type_info()->physical_type() != BINARY) {
-      CopyColumn<true, false>(column_block, p_schema_idx, base, indirect_data, projection_schema,
+      CopyColumn<true, false>(column_block, p_schema_idx, base, indirect_data,
+                              indirect_data_offset, projection_schema,
                               row_stride, schema_byte_size, column_offset, selected_row_indexes);
     } else if (!col.is_nullable() && col.type_info()->physical_type() == BINARY) {
-      CopyColumn<false, true>(column_block, p_schema_idx, base, indirect_data, projection_schema,
+      CopyColumn<false, true>(column_block, p_schema_idx, base, indirect_data,
+                              indirect_data_offset, projection_schema,
                               row_stride, schema_byte_size, column_offset, selected_row_indexes);
     } else if (!col.is_nullable() && col.type_info()->physical_type() != BINARY) {
-      CopyColumn<false, false>(column_block, p_schema_idx, base, indirect_data, projection_schema,
+      CopyColumn<false, false>(column_block, p_schema_idx, base, indirect_data,
+                               indirect_data_offset, projection_schema,
                                row_stride, schema_byte_size, column_offset, selected_row_indexes);
     } else {
       LOG(FATAL) << "cannot reach here";
@@ -19,6 +19,7 @@
 #ifndef KUDU_COMMON_WIRE_PROTOCOL_H
 #define KUDU_COMMON_WIRE_PROTOCOL_H
 
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <string>
@@ -41,6 +42,7 @@ template <typename Key, typename T> class Map;
 namespace kudu {
 
 class Arena;
+class BlockBloomFilter;
 class ColumnPredicate;
 class ColumnSchema;
 class faststring;
@@ -138,10 +140,15 @@ void ColumnPredicateToPB(const ColumnPredicate& predicate, ColumnPredicatePB* pb
 // Convert a column predicate protobuf to a column predicate. The resulting
 // predicate is stored in the 'predicate' out parameter, if the result is
 // successful.
+//
+// If the protobuf is an InBloomFilter predicate which refers to registered
+// bloom filters by ID, 'registered_bloom_filters' must hold those filters, in
+// the same order. They must outlive the predicate.
 Status ColumnPredicateFromPB(const Schema& schema,
                              Arena* arena,
                              const ColumnPredicatePB& pb,
-                             boost::optional<ColumnPredicate>* predicate);
+                             boost::optional<ColumnPredicate>* predicate,
+                             const std::vector<BlockBloomFilter*>& registered_bloom_filters = {});
 
 // Convert a extra configuration properties protobuf to map.
 Status ExtraConfigPBToMap(const TableExtraConfigPB& pb,
@@ -171,13 +178,19 @@ Status ExtraConfigPBToPBMap(const TableExtraConfigPB& pb,
 // If 'pad_unixtime_micros_to_16_bytes' is true, UNIXTIME_MICROS slots in the projection
 // schema will be padded to the right by 8 (zero'd) bytes for a total of 16 bytes.
 //
+// 'indirect_data_offset' is added to the offsets of indirect data written to
+// 'data_buf'. It's used when 'indirect_data' is one of a chain of buffers that
+// will be sent back to back, in which case it's the total size of the buffers
+// preceding 'indirect_data'.
+//
 // Requires that block.nrows() > 0
 //
 // Returns the number of rows serialized.
 int SerializeRowBlock(const RowBlock& block,
                       const Schema* projection_schema,
                       faststring* data_buf, faststring* indirect_data,
-                      bool pad_unixtime_micros_to_16_bytes = false);
+                      bool pad_unixtime_micros_to_16_bytes = false,
+                      size_t indirect_data_offset = 0);
 
 // Rewrites the data pointed-to by row data slice 'row_data_slice' by replacing
 // relative indirect data pointers with absolute ones in 'indirect_data_slice'.
@@ -274,13 +274,14 @@ class MockedPeerProxy : public TestPeerProxy {
     vote_response_ = vote_response;
   }
 
-  void UpdateAsync(const ConsensusRequestPB& /*request*/,
+  void UpdateAsync(const ConsensusRequestPB& request,
                    ConsensusResponsePB* response,
                    rpc::RpcController* /*controller*/,
                    const rpc::ResponseCallback& callback) override {
     {
       std::lock_guard<simple_spinlock> l(lock_);
       update_count_++;
+      last_update_request_ = request;
       *response = update_response_;
     }
     return RegisterCallbackAndRespond(kUpdate, callback);
@@ -307,9 +308,17 @@ class MockedPeerProxy : public TestPeerProxy {
     return update_count_;
   }
 
+  // Return the request most recently passed to UpdateAsync().
+  ConsensusRequestPB last_update_request() const {
+    std::lock_guard<simple_spinlock> l(lock_);
+    return last_update_request_;
+  }
+
  protected:
   int update_count_;
 
+  ConsensusRequestPB last_update_request_;
+
   ConsensusResponsePB update_response_;
   VoteResponsePB vote_response_;
 };
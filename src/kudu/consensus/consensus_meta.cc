@@ -35,6 +35,7 @@
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status.h"
@@ -49,6 +50,12 @@ DEFINE_bool(cmeta_force_fsync, false,
             "Whether fsync() should be called when consensus metadata files are updated");
 TAG_FLAG(cmeta_force_fsync, advanced);
 
+DEFINE_int32(cmeta_inject_dir_sync_latency_ms, 0,
+             "Amount of latency in ms to inject into each grouped fsync of the "
+             "consensus metadata directory. (For testing only!)");
+TAG_FLAG(cmeta_inject_dir_sync_latency_ms, hidden);
+TAG_FLAG(cmeta_inject_dir_sync_latency_ms, unsafe);
+
 namespace kudu {
 namespace consensus {
 
@@ -56,6 +63,44 @@ using std::lock_guard;
 using std::string;
 using strings::Substitute;
 
+ConsensusMetadataDirSyncer::ConsensusMetadataDirSyncer(FsManager* fs_manager)
+    : fs_manager_(DCHECK_NOTNULL(fs_manager)),
+      sync_done_(&lock_),
+      last_requested_(0),
+      last_synced_(0),
+      sync_in_progress_(false),
+      num_syncs_(0) {
+}
+
+Status ConsensusMetadataDirSyncer::SyncDir() {
+  MutexLock l(lock_);
+  const int64_t seq = ++last_requested_;
+  // A sync in progress may have begun before the rename, so wait for it and
+  // sync again, unless another caller already did.
+  while (sync_in_progress_ && last_synced_ < seq) {
+    sync_done_.Wait();
+  }
+  if (last_synced_ >= seq) {
+    return last_status_;
+  }
+
+  // Sync on behalf of every caller so far.
+  const int64_t batch = last_requested_;
+  sync_in_progress_ = true;
+  l.Unlock();
+  if (PREDICT_FALSE(FLAGS_cmeta_inject_dir_sync_latency_ms > 0)) {
+    SleepFor(MonoDelta::FromMilliseconds(FLAGS_cmeta_inject_dir_sync_latency_ms));
+  }
+  Status s = fs_manager_->env()->SyncDir(fs_manager_->GetConsensusMetadataDir());
+  l.Lock();
+  sync_in_progress_ = false;
+  last_synced_ = batch;
+  last_status_ = s;
+  num_syncs_++;
+  sync_done_.Broadcast();
+  return s;
+}
+
 int64_t ConsensusMetadata::current_term() const {
   DFAKE_SCOPED_RECURSIVE_LOCK(fake_lock_);
   DCHECK(pb_.has_current_term());
@@ -237,32 +282,43 @@ Status ConsensusMetadata::Flush(FlushMode flush_mode) {
                           "Unable to fsync consensus parent dir " + parent_dir);
   }
 
+  // We use FLAGS_log_force_fsync_all here because the consensus metadata is
+  // essentially an extension of the primary durability mechanism of the
+  // consensus subsystem: the WAL. Using the same flag ensures that the WAL
+  // and the consensus metadata get the same durability guarantees.
+  // We add FLAGS_cmeta_force_fsync to support an override in certain
+  // cases. Some filesystems such as ext4 are more forgiving to omitting an
+  // fsync() due to periodic commit with default settings, whereas other
+  // filesystems such as XFS will not commit as often and need the fsync to
+  // avoid significant data loss when a crash happens.
+  pb_util::SyncMode sync_mode = pb_util::NO_SYNC;
+  if (FLAGS_log_force_fsync_all || FLAGS_cmeta_force_fsync) {
+    sync_mode = dir_syncer_ ? pb_util::SYNC_FILE_ONLY : pb_util::SYNC;
+  }
+
   string meta_file_path = fs_manager_->GetConsensusMetadataPath(tablet_id_);
   RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(
       fs_manager_->env(), meta_file_path, pb_,
       flush_mode == OVERWRITE ? pb_util::OVERWRITE : pb_util::NO_OVERWRITE,
-      // We use FLAGS_log_force_fsync_all here because the consensus metadata is
-      // essentially an extension of the primary durability mechanism of the
-      // consensus subsystem: the WAL. Using the same flag ensures that the WAL
-      // and the consensus metadata get the same durability guarantees.
-      // We add FLAGS_cmeta_force_fsync to support an override in certain
-      // cases. Some filesystems such as ext4 are more forgiving to omitting an
-      // fsync() due to periodic commit with default settings, whereas other
-      // filesystems such as XFS will not commit as often and need the fsync to
-      // avoid significant data loss when a crash happens.
-      FLAGS_log_force_fsync_all || FLAGS_cmeta_force_fsync ? pb_util::SYNC : pb_util::NO_SYNC),
+      sync_mode),
           Substitute("Unable to write consensus meta file for tablet $0 to path $1",
                      tablet_id_, meta_file_path));
+  if (sync_mode == pb_util::SYNC_FILE_ONLY) {
+    RETURN_NOT_OK_PREPEND(dir_syncer_->SyncDir(),
+                          "Unable to fsync consensus metadata dir " + dir);
+  }
   RETURN_NOT_OK(UpdateOnDiskSize());
   return Status::OK();
 }
 
 ConsensusMetadata::ConsensusMetadata(FsManager* fs_manager,
                                      std::string tablet_id,
-                                     std::string peer_uuid)
+                                     std::string peer_uuid,
+                                     scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer)
     : fs_manager_(CHECK_NOTNULL(fs_manager)),
       tablet_id_(std::move(tablet_id)),
       peer_uuid_(std::move(peer_uuid)),
+      dir_syncer_(std::move(dir_syncer)),
       has_pending_config_(false),
       flush_count_for_tests_(0),
       on_disk_size_(0) {
@@ -274,9 +330,11 @@ Status ConsensusMetadata::Create(FsManager* fs_manager,
                                  const RaftConfigPB& config,
                                  int64_t current_term,
                                  ConsensusMetadataCreateMode create_mode,
-                                 scoped_refptr<ConsensusMetadata>* cmeta_out) {
+                                 scoped_refptr<ConsensusMetadata>* cmeta_out,
+                                 scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer) {
 
-  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid));
+  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid,
+                                                               std::move(dir_syncer)));
   cmeta->set_committed_config(config);
   cmeta->set_current_term(current_term);
 
@@ -296,8 +354,10 @@ Status ConsensusMetadata::Create(FsManager* fs_manager,
 Status ConsensusMetadata::Load(FsManager* fs_manager,
                                const std::string& tablet_id,
                                const std::string& peer_uuid,
-                               scoped_refptr<ConsensusMetadata>* cmeta_out) {
-  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid));
+                               scoped_refptr<ConsensusMetadata>* cmeta_out,
+                               scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer) {
+  scoped_refptr<ConsensusMetadata> cmeta(new ConsensusMetadata(fs_manager, tablet_id, peer_uuid,
+                                                               std::move(dir_syncer)));
   RETURN_NOT_OK(pb_util::ReadPBContainerFromPath(fs_manager->env(),
                                                  fs_manager->GetConsensusMetadataPath(tablet_id),
                                                  &cmeta->pb_));
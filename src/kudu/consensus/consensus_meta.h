@@ -27,11 +27,13 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/threading/thread_collision_warner.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
 
 namespace kudu {
 
 class FsManager;
-class Status;
 
 namespace consensus {
 
@@ -43,6 +45,50 @@ enum class ConsensusMetadataCreateMode {
   NO_FLUSH_ON_CREATE,
 };
 
+// Makes the renames of the consensus metadata files into the consensus
+// metadata directory durable, sharing the fsync of the directory between the
+// concurrent flushes of the consensus metadata of different tablets: while
+// one flush syncs the directory, the others wait, and then a single sync
+// covers all of them. An election storm across many tablets thus costs a
+// directory fsync per batch of flushes rather than per flush.
+//
+// This class is thread-safe.
+class ConsensusMetadataDirSyncer : public RefCountedThreadSafe<ConsensusMetadataDirSyncer> {
+ public:
+  explicit ConsensusMetadataDirSyncer(FsManager* fs_manager);
+
+  // Makes durable the renames into the consensus metadata directory which
+  // completed before the call, either by syncing the directory or by waiting
+  // for a sync which began after the call.
+  Status SyncDir();
+
+  // The number of times the directory has been synced.
+  int64_t num_syncs_for_tests() const {
+    MutexLock l(lock_);
+    return num_syncs_;
+  }
+
+ private:
+  friend class RefCountedThreadSafe<ConsensusMetadataDirSyncer>;
+  ~ConsensusMetadataDirSyncer() = default;
+
+  FsManager* const fs_manager_;
+
+  mutable Mutex lock_;
+  ConditionVariable sync_done_;
+
+  // The sequence number of the last call to SyncDir().
+  int64_t last_requested_;
+  // The sequence number of the last call to SyncDir() covered by a sync.
+  int64_t last_synced_;
+  bool sync_in_progress_;
+  // The result of the last sync.
+  Status last_status_;
+  int64_t num_syncs_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsensusMetadataDirSyncer);
+};
+
 // Provides methods to read, write, and persist consensus-related metadata.
 // This partly corresponds to Raft Figure 2's "Persistent state on all servers".
 //
@@ -176,13 +222,17 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   FRIEND_TEST(ConsensusMetadataTest, TestMergeCommittedConsensusStatePB);
 
   ConsensusMetadata(FsManager* fs_manager, std::string tablet_id,
-                    std::string peer_uuid);
+                    std::string peer_uuid,
+                    scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer);
 
   // Create a ConsensusMetadata object with provided initial state.
   // If 'create_mode' is set to FLUSH_ON_CREATE, the encoded PB is flushed to
   // disk before returning. Otherwise, if 'create_mode' is set to
   // NO_FLUSH_ON_CREATE, the caller must explicitly call Flush() on the
   // returned object to get the bytes onto disk.
+  //
+  // If 'dir_syncer' is set, the fsyncs of the consensus metadata directory
+  // by the flushes of the object are shared through it.
   static Status Create(FsManager* fs_manager,
                        const std::string& tablet_id,
                        const std::string& peer_uuid,
@@ -190,7 +240,8 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
                        int64_t current_term,
                        ConsensusMetadataCreateMode create_mode =
                            ConsensusMetadataCreateMode::FLUSH_ON_CREATE,
-                       scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr);
+                       scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr,
+                       scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer = nullptr);
 
   // Load a ConsensusMetadata object from disk.
   // Returns Status::NotFound if the file could not be found. May return other
@@ -198,7 +249,8 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   static Status Load(FsManager* fs_manager,
                      const std::string& tablet_id,
                      const std::string& peer_uuid,
-                     scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr);
+                     scoped_refptr<ConsensusMetadata>* cmeta_out = nullptr,
+                     scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer = nullptr);
 
   // Delete the ConsensusMetadata file associated with the given tablet from
   // disk. Returns Status::NotFound if the on-disk data is not found.
@@ -219,6 +271,9 @@ class ConsensusMetadata : public RefCountedThreadSafe<ConsensusMetadata> {
   const std::string tablet_id_;
   const std::string peer_uuid_;
 
+  // Shares the directory fsyncs of Flush() with other tablets, if set.
+  const scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer_;
+
   // This fake mutex helps ensure that this ConsensusMetadata object stays
   // externally synchronized.
   DFAKE_MUTEX(fake_lock_);
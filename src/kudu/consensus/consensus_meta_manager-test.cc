@@ -20,7 +20,10 @@
 #include <cstdint>
 #include <initializer_list>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 
@@ -30,11 +33,18 @@
 #include "kudu/consensus/quorum_util.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(cmeta_force_fsync);
+DECLARE_int32(cmeta_inject_dir_sync_latency_ms);
+
 using google::protobuf::util::MessageDifferencer;
+using std::thread;
+using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 namespace consensus {
@@ -158,5 +168,47 @@ TEST_F(ConsensusMetadataManagerTest, TestNoClobber) {
   }
 }
 
+// Test that the concurrent flushes of different tablets share the fsyncs of
+// the consensus metadata directory.
+TEST_F(ConsensusMetadataManagerTest, TestGroupDirSyncs) {
+  FLAGS_cmeta_force_fsync = true;
+  // Hold each sync long enough for the other flushes to queue up behind it.
+  FLAGS_cmeta_inject_dir_sync_latency_ms = 500;
+  constexpr int kNumTablets = 16;
+  vector<scoped_refptr<ConsensusMetadata>> cmetas(kNumTablets);
+  for (int i = 0; i < kNumTablets; i++) {
+    ASSERT_OK(cmeta_manager_->Create(Substitute("$0-$1", kTabletId, i), config_, kInitialTerm,
+                                     ConsensusMetadataCreateMode::NO_FLUSH_ON_CREATE,
+                                     &cmetas[i]));
+  }
+
+  vector<Status> statuses(kNumTablets);
+  vector<thread> threads;
+  for (int i = 0; i < kNumTablets; i++) {
+    threads.emplace_back([&, i]() {
+      cmetas[i]->set_current_term(kInitialTerm + 1);
+      statuses[i] = cmetas[i]->Flush(ConsensusMetadata::NO_OVERWRITE);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (const auto& s : statuses) {
+    ASSERT_OK(s);
+  }
+  const int64_t num_syncs = cmeta_manager_->dir_syncer_->num_syncs_for_tests();
+  ASSERT_GE(num_syncs, 1);
+  ASSERT_LT(num_syncs, kNumTablets);
+
+  // Read the flushed files back, bypassing the cache of the manager.
+  scoped_refptr<ConsensusMetadataManager> cmeta_manager(
+      new ConsensusMetadataManager(&fs_manager_));
+  for (int i = 0; i < kNumTablets; i++) {
+    scoped_refptr<ConsensusMetadata> cmeta;
+    ASSERT_OK(cmeta_manager->Load(Substitute("$0-$1", kTabletId, i), &cmeta));
+    ASSERT_EQ(kInitialTerm + 1, cmeta->current_term());
+  }
+}
+
 } // namespace consensus
 } // namespace kudu
@@ -19,14 +19,23 @@
 #include <mutex>
 #include <utility>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/consensus/consensus_meta.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/status.h"
 
+DEFINE_bool(cmeta_group_dir_syncs, true,
+            "Whether the concurrent flushes of the consensus metadata of different "
+            "tablets share the fsync() of the consensus metadata directory, rather "
+            "than each syncing it. Only relevant if consensus metadata files are "
+            "fsynced.");
+TAG_FLAG(cmeta_group_dir_syncs, advanced);
+
 namespace kudu {
 namespace consensus {
 
@@ -36,6 +45,9 @@ using strings::Substitute;
 
 ConsensusMetadataManager::ConsensusMetadataManager(FsManager* fs_manager)
     : fs_manager_(DCHECK_NOTNULL(fs_manager)) {
+  if (FLAGS_cmeta_group_dir_syncs) {
+    dir_syncer_ = new ConsensusMetadataDirSyncer(fs_manager_);
+  }
 }
 
 Status ConsensusMetadataManager::Create(const string& tablet_id,
@@ -46,7 +58,7 @@ Status ConsensusMetadataManager::Create(const string& tablet_id,
   scoped_refptr<ConsensusMetadata> cmeta;
   RETURN_NOT_OK_PREPEND(ConsensusMetadata::Create(fs_manager_, tablet_id, fs_manager_->uuid(),
                                                   config, initial_term, create_mode,
-                                                  &cmeta),
+                                                  &cmeta, dir_syncer_),
                         Substitute("Unable to create consensus metadata for tablet $0", tablet_id));
 
   lock_guard<Mutex> l(lock_);
@@ -74,7 +86,7 @@ Status ConsensusMetadataManager::Load(const string& tablet_id,
   // If it's not yet cached, drop the lock before we load it.
   scoped_refptr<ConsensusMetadata> cmeta;
   RETURN_NOT_OK_PREPEND(ConsensusMetadata::Load(fs_manager_, tablet_id, fs_manager_->uuid(),
-                                                &cmeta),
+                                                &cmeta, dir_syncer_),
                         Substitute("Unable to load consensus metadata for tablet $0", tablet_id));
 
   // Cache and return the loaded ConsensusMetadata.
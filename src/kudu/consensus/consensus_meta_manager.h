@@ -20,6 +20,8 @@
 #include <string>
 #include <unordered_map>
 
+#include <gtest/gtest_prod.h>
+
 #include "kudu/consensus/consensus_meta.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -83,9 +85,14 @@ class ConsensusMetadataManager : public RefCountedThreadSafe<ConsensusMetadataMa
 
  private:
   friend class RefCountedThreadSafe<ConsensusMetadataManager>;
+  FRIEND_TEST(ConsensusMetadataManagerTest, TestGroupDirSyncs);
 
   FsManager* const fs_manager_;
 
+  // Shares the directory fsyncs of the flushes of the consensus metadata of
+  // the tablets, or nullptr if --cmeta_group_dir_syncs is false.
+  scoped_refptr<ConsensusMetadataDirSyncer> dir_syncer_;
+
   // Lock protecting the map below.
   Mutex lock_;
 
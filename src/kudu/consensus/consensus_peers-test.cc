@@ -21,7 +21,9 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -39,29 +41,40 @@
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/opid_util.h"
+#include "kudu/consensus/ref_counted_replicate.h"
 #include "kudu/consensus/time_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 #include "kudu/util/threadpool.h"
 
+DECLARE_int32(raft_heartbeat_interval_ms);
+DECLARE_int32(raft_quiesce_after_idle_secs);
+DECLARE_int32(raft_quiescent_heartbeat_interval_ms);
+DECLARE_int32(raft_safe_time_heartbeat_interval_ms);
+
 METRIC_DECLARE_entity(tablet);
 METRIC_DECLARE_entity(server);
 
 using kudu::log::Log;
 using kudu::log::LogOptions;
+using kudu::pb_util::SecureShortDebugString;
 using kudu::rpc::Messenger;
 using kudu::rpc::MessengerBuilder;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 namespace consensus {
@@ -366,6 +379,123 @@ TEST_F(ConsensusPeersTest, TestDontSendOneRpcPerWriteWhenPeerIsDown) {
   ASSERT_LT(mock_proxy->update_count(), 5);
 }
 
+// Test that a leader heartbeats an idle tablet less often, and lets the
+// follower know to expect that.
+TEST_F(ConsensusPeersTest, TestQuiescentHeartbeats) {
+  FLAGS_raft_heartbeat_interval_ms = 20;
+  FLAGS_raft_quiesce_after_idle_secs = 1;
+  FLAGS_raft_quiescent_heartbeat_interval_ms = 60 * 1000;
+  message_queue_->SetLeaderMode(kMinimumOpIdIndex,
+                                kMinimumTerm,
+                                BuildRaftConfigPBForTests(3));
+
+  auto mock_proxy = new MockedPeerProxy(raft_pool_.get());
+  shared_ptr<Peer> peer;
+  ASSERT_OK(Peer::NewRemotePeer(FakeRaftPeerPB(kFollowerUuid),
+                                kTabletId,
+                                kLeaderUuid,
+                                message_queue_.get(),
+                                raft_pool_token_.get(),
+                                unique_ptr<PeerProxy>(mock_proxy),
+                                messenger_,
+                                &peer));
+
+  ConsensusResponsePB resp;
+  resp.set_responder_uuid(kFollowerUuid);
+  resp.set_responder_term(0);
+  resp.mutable_status()->mutable_last_received()->CopyFrom(MakeOpId(1, 1));
+  resp.mutable_status()->mutable_last_received_current_leader()->CopyFrom(MakeOpId(1, 1));
+  resp.mutable_status()->set_last_committed_idx(1);
+  mock_proxy->set_update_response(resp);
+
+  AppendReplicateMessagesToQueue(message_queue_.get(), clock_.get(), 1, 1);
+  peer->SignalRequest(true);
+  WaitForCommitIndex(1);
+  ASSERT_FALSE(mock_proxy->last_update_request().has_quiescent_heartbeat_interval_ms());
+
+  // Once the tablet has been idle for long enough, the heartbeats say so, and
+  // they stop coming at the regular interval.
+  ASSERT_EVENTUALLY([&] {
+    ASSERT_EQ(FLAGS_raft_quiescent_heartbeat_interval_ms,
+              mock_proxy->last_update_request().quiescent_heartbeat_interval_ms());
+  });
+  const int num_updates = mock_proxy->update_count();
+  SleepFor(MonoDelta::FromMilliseconds(10 * FLAGS_raft_heartbeat_interval_ms));
+  ASSERT_EQ(num_updates, mock_proxy->update_count());
+  peer->Close();
+}
+
+// Test that a leader heartbeats a follower more often while the follower asks
+// for safe time, and goes back to the regular interval afterwards.
+TEST_F(ConsensusPeersTest, TestSafeTimeHeartbeats) {
+  FLAGS_raft_heartbeat_interval_ms = 60 * 1000;
+  FLAGS_raft_safe_time_heartbeat_interval_ms = 10;
+  message_queue_->SetLeaderMode(kMinimumOpIdIndex,
+                                kMinimumTerm,
+                                BuildRaftConfigPBForTests(3));
+
+  auto mock_proxy = new MockedPeerProxy(raft_pool_.get());
+  shared_ptr<Peer> peer;
+  ASSERT_OK(Peer::NewRemotePeer(FakeRaftPeerPB(kFollowerUuid),
+                                kTabletId,
+                                kLeaderUuid,
+                                message_queue_.get(),
+                                raft_pool_token_.get(),
+                                unique_ptr<PeerProxy>(mock_proxy),
+                                messenger_,
+                                &peer));
+
+  ConsensusResponsePB resp;
+  resp.set_responder_uuid(kFollowerUuid);
+  resp.set_responder_term(0);
+  resp.mutable_status()->mutable_last_received()->CopyFrom(MakeOpId(1, 1));
+  resp.mutable_status()->mutable_last_received_current_leader()->CopyFrom(MakeOpId(1, 1));
+  resp.mutable_status()->set_last_committed_idx(1);
+  resp.set_safe_time_requested(true);
+  mock_proxy->set_update_response(resp);
+
+  AppendReplicateMessagesToQueue(message_queue_.get(), clock_.get(), 1, 1);
+  peer->SignalRequest(true);
+  WaitForCommitIndex(1);
+
+  // Without any more ops, the peer is heartbeated well before the regular
+  // heartbeat interval.
+  ASSERT_EVENTUALLY([&] {
+    ASSERT_GE(mock_proxy->update_count(), 5);
+  });
+
+  // Once the follower stops asking, the heartbeats stop coming early.
+  resp.clear_safe_time_requested();
+  mock_proxy->set_update_response(resp);
+  SleepFor(MonoDelta::FromMilliseconds(10 * FLAGS_raft_safe_time_heartbeat_interval_ms));
+  const int num_updates = mock_proxy->update_count();
+  SleepFor(MonoDelta::FromMilliseconds(10 * FLAGS_raft_safe_time_heartbeat_interval_ms));
+  ASSERT_EQ(num_updates, mock_proxy->update_count());
+  peer->Close();
+}
+
+// Test that the ops a leader serializes for a sidecar are parsed back as sent.
+TEST_F(ConsensusPeersTest, TestParseOpsFromSidecar) {
+  vector<ReplicateRefPtr> msgs;
+  faststring sidecar;
+  for (int i = 1; i <= 3; i++) {
+    msgs.emplace_back(make_scoped_refptr_replicate(
+        CreateDummyReplicate(1, i, clock_->Now(), i * 100).release()));
+    sidecar.append(msgs.back()->SerializedWithLength());
+  }
+  google::protobuf::RepeatedPtrField<ReplicateMsg> ops;
+  ASSERT_OK(ParseOpsFromSidecar(Slice(sidecar), &ops));
+  ASSERT_EQ(msgs.size(), static_cast<size_t>(ops.size()));
+  for (int i = 0; i < ops.size(); i++) {
+    ASSERT_EQ(SecureShortDebugString(*msgs[i]->get()), SecureShortDebugString(ops.Get(i)));
+  }
+
+  // A truncated op is detected.
+  ops.Clear();
+  Status s = ParseOpsFromSidecar(Slice(sidecar.data(), sidecar.size() - 1), &ops);
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+}
+
 }  // namespace consensus
 }  // namespace kudu
 
@@ -18,12 +18,14 @@
 #include "kudu/consensus/consensus_peers.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -40,10 +42,14 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/messenger.h"
 #include "kudu/rpc/periodic.h"
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/coding.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
@@ -52,6 +58,7 @@
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/pb_util.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/threadpool.h"
 
@@ -59,6 +66,19 @@ DEFINE_int32(consensus_rpc_timeout_ms, 30000,
              "Timeout used for all consensus internal RPC communications.");
 TAG_FLAG(consensus_rpc_timeout_ms, advanced);
 
+DEFINE_int32(raft_heartbeat_batch_window_ms, 0,
+             "If positive, the UpdateConsensus requests without any ops that the "
+             "leaders of different tablets send to the same server within this many "
+             "milliseconds of each other are sent in a single RPC. Reduces the number "
+             "of RPCs between servers which host many tablets in common.");
+TAG_FLAG(raft_heartbeat_batch_window_ms, experimental);
+
+DEFINE_bool(raft_send_ops_in_sidecars, true,
+             "Whether a leader serializes each op it replicates once, and sends the "
+             "serialized ops to the peers which support it in an RPC sidecar, rather "
+             "than serializing them again in the request to each peer.");
+TAG_FLAG(raft_send_ops_in_sidecars, advanced);
+
 DEFINE_int32(raft_get_node_instance_timeout_ms, 30000,
              "Timeout for retrieving node instance data over RPC.");
 TAG_FLAG(raft_get_node_instance_timeout_ms, hidden);
@@ -83,11 +103,16 @@ DEFINE_bool(enable_tablet_copy, true,
 TAG_FLAG(enable_tablet_copy, unsafe);
 
 DECLARE_int32(raft_heartbeat_interval_ms);
+DECLARE_int32(raft_quiesce_after_idle_secs);
+DECLARE_int32(raft_quiescent_heartbeat_interval_ms);
+DECLARE_int32(raft_safe_time_heartbeat_interval_ms);
 
+using google::protobuf::RepeatedPtrField;
 using kudu::pb_util::SecureShortDebugString;
 using kudu::rpc::Messenger;
 using kudu::rpc::PeriodicTimer;
 using kudu::rpc::RpcController;
+using kudu::rpc::RpcSidecar;
 using kudu::tserver::TabletServerErrorPB;
 using std::shared_ptr;
 using std::string;
@@ -137,6 +162,7 @@ Peer::Peer(RaftPeerPB peer_pb,
       proxy_(std::move(proxy)),
       queue_(queue),
       failed_attempts_(0),
+      last_op_sent_time_(MonoTime::Now()),
       messenger_(std::move(messenger)),
       raft_pool_token_(raft_pool_token) {
 }
@@ -267,6 +293,17 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
   if (req_has_ops) {
     // If we're actually sending ops there's no need to heartbeat for a while.
     heartbeater_->Snooze();
+    last_op_sent_time_ = MonoTime::Now();
+    request_.clear_quiescent_heartbeat_interval_ms();
+  } else if (FLAGS_raft_quiesce_after_idle_secs > 0 && failed_attempts_ == 0 &&
+             !safe_time_requested_ &&
+             MonoTime::Now() - last_op_sent_time_ >
+                 MonoDelta::FromSeconds(FLAGS_raft_quiesce_after_idle_secs)) {
+    // The tablet is idle: let the peer know it won't hear from us for a while.
+    request_.set_quiescent_heartbeat_interval_ms(FLAGS_raft_quiescent_heartbeat_interval_ms);
+    heartbeater_->Snooze(MonoDelta::FromMilliseconds(FLAGS_raft_quiescent_heartbeat_interval_ms));
+  } else {
+    request_.clear_quiescent_heartbeat_interval_ms();
   }
 
   MAYBE_FAULT(FLAGS_fault_crash_on_leader_request_fraction);
@@ -275,6 +312,10 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Sending to peer " << peer_pb().permanent_uuid() << ": "
       << SecureShortDebugString(request_);
   controller_.Reset();
+  request_.clear_ops_sidecar_idx();
+  if (ops_sidecar_supported_ && FLAGS_raft_send_ops_in_sidecars && request_.ops_size() > 0) {
+    MoveOpsToSidecar();
+  }
 
   request_pending_ = true;
   l.unlock();
@@ -287,6 +328,41 @@ void Peer::SendNextRequest(bool even_if_queue_empty) {
                       });
 }
 
+void Peer::MoveOpsToSidecar() {
+  DCHECK_EQ(request_.ops_size(), static_cast<int>(replicate_msg_refs_.size()));
+  vector<Slice> ops;
+  ops.reserve(replicate_msg_refs_.size());
+  for (const auto& msg : replicate_msg_refs_) {
+    ops.emplace_back(msg->SerializedWithLength());
+  }
+  // The serialized ops live as long as 'replicate_msg_refs_', i.e. until the
+  // next request is prepared.
+  int idx;
+  Status s = controller_.AddOutboundSidecar(RpcSidecar::FromSlices(std::move(ops)), &idx);
+  if (PREDICT_FALSE(!s.ok())) {
+    // Send the ops in the request itself.
+    controller_.Reset();
+    return;
+  }
+  // We don't own the ops (the queue does).
+  request_.mutable_ops()->ExtractSubrange(0, request_.ops_size(), nullptr);
+  request_.set_ops_sidecar_idx(idx);
+}
+
+Status ParseOpsFromSidecar(Slice sidecar, RepeatedPtrField<ReplicateMsg>* ops) {
+  while (!sidecar.empty()) {
+    uint32_t size;
+    if (PREDICT_FALSE(!GetVarint32(&sidecar, &size) || size > sidecar.size())) {
+      return Status::Corruption("truncated op in sidecar");
+    }
+    if (PREDICT_FALSE(!ops->Add()->ParseFromArray(sidecar.data(), size))) {
+      return Status::Corruption("unable to parse op in sidecar");
+    }
+    sidecar.remove_prefix(size);
+  }
+  return Status::OK();
+}
+
 void Peer::StartElection() {
   // The async proxy contract is such that the response and RPC controller must
   // stay in scope until the callback is invoked. Unlike other Peer methods, we
@@ -370,6 +446,16 @@ void Peer::ProcessResponse() {
     return;
   }
 
+  ops_sidecar_supported_ = response_.ops_sidecar_supported();
+
+  // Send the peer its next safe time early if reads on it are waiting for it.
+  safe_time_requested_ = response_.safe_time_requested() &&
+      FLAGS_raft_safe_time_heartbeat_interval_ms > 0;
+  if (safe_time_requested_) {
+    heartbeater_->Snooze(MonoDelta::FromMilliseconds(
+        std::min(FLAGS_raft_safe_time_heartbeat_interval_ms, FLAGS_raft_heartbeat_interval_ms)));
+  }
+
   // The queue's handling of the peer response may generate IO (reads against
   // the WAL) and SendNextRequest() may do the same thing. So we run the rest
   // of the response handling logic on our thread pool and not on the reactor
@@ -455,6 +541,10 @@ void Peer::ProcessTabletCopyResponse() {
 
 void Peer::ProcessResponseError(const Status& status) {
   failed_attempts_++;
+  if (request_.has_quiescent_heartbeat_interval_ms()) {
+    // Retry at the regular heartbeat interval.
+    heartbeater_->Snooze();
+  }
   string resp_err_info;
   if (response_.has_error()) {
     resp_err_info = Substitute(" Error code: $0 ($1).",
@@ -509,15 +599,21 @@ Peer::~Peer() {
 }
 
 RpcPeerProxy::RpcPeerProxy(HostPort hostport,
-                           unique_ptr<ConsensusServiceProxy> consensus_proxy)
+                           unique_ptr<ConsensusServiceProxy> consensus_proxy,
+                           shared_ptr<ConsensusRequestBatcher> batcher)
     : hostport_(std::move(hostport)),
-      consensus_proxy_(std::move(DCHECK_NOTNULL(consensus_proxy))) {
+      consensus_proxy_(std::move(DCHECK_NOTNULL(consensus_proxy))),
+      batcher_(std::move(batcher)) {
 }
 
 void RpcPeerProxy::UpdateAsync(const ConsensusRequestPB& request,
                                ConsensusResponsePB* response,
                                rpc::RpcController* controller,
                                const rpc::ResponseCallback& callback) {
+  if (batcher_) {
+    batcher_->UpdateAsync(request, response, controller, callback);
+    return;
+  }
   controller->set_timeout(MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms));
   consensus_proxy_->UpdateConsensusAsync(request, response, controller, callback);
 }
@@ -569,6 +665,148 @@ Status CreateConsensusServiceProxyForHost(
 
 } // anonymous namespace
 
+struct ConsensusRequestBatcher::Batch {
+  // A request of the batch, and where its caller expects the outcome.
+  struct Call {
+    ConsensusResponsePB* response;
+    RpcController* controller;
+    rpc::ResponseCallback callback;
+  };
+
+  BatchConsensusRequestPB request;
+  BatchConsensusResponsePB response;
+  RpcController controller;
+  vector<Call> calls;
+};
+
+Status ConsensusRequestBatcher::FindOrCreate(const shared_ptr<Messenger>& messenger,
+                                             const HostPort& hostport,
+                                             DnsResolver* dns_resolver,
+                                             shared_ptr<ConsensusRequestBatcher>* batcher) {
+  // The batchers are kept by the proxies which use them. The messenger is
+  // part of the key since there may be several in a single process (e.g. in
+  // tests); a batcher's proxy keeps its messenger alive.
+  static simple_spinlock lock;
+  static auto* batchers = new std::unordered_map<string, weak_ptr<ConsensusRequestBatcher>>();
+
+  const string key = Substitute("$0/$1", reinterpret_cast<uintptr_t>(messenger.get()),
+                                hostport.ToString());
+  std::lock_guard<simple_spinlock> l(lock);
+  auto& found = (*batchers)[key];
+  if (auto existing = found.lock()) {
+    *batcher = std::move(existing);
+    return Status::OK();
+  }
+  unique_ptr<ConsensusServiceProxy> proxy;
+  RETURN_NOT_OK(CreateConsensusServiceProxyForHost(hostport, messenger, dns_resolver, &proxy));
+  auto new_batcher = std::make_shared<ConsensusRequestBatcher>(messenger, std::move(proxy));
+  found = new_batcher;
+  // Forget the batchers which aren't used anymore.
+  for (auto it = batchers->begin(); it != batchers->end();) {
+    if (it->second.expired()) {
+      it = batchers->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  *batcher = std::move(new_batcher);
+  return Status::OK();
+}
+
+ConsensusRequestBatcher::ConsensusRequestBatcher(shared_ptr<Messenger> messenger,
+                                                 unique_ptr<ConsensusServiceProxy> consensus_proxy)
+    : messenger_(std::move(messenger)),
+      consensus_proxy_(std::move(DCHECK_NOTNULL(consensus_proxy))),
+      batch_supported_(true) {
+}
+
+void ConsensusRequestBatcher::UpdateAsync(const ConsensusRequestPB& request,
+                                          ConsensusResponsePB* response,
+                                          RpcController* controller,
+                                          const rpc::ResponseCallback& callback) {
+  if (request.ops_size() > 0 || request.has_ops_sidecar_idx() || !batch_supported_) {
+    SendOne(request, response, controller, callback);
+    return;
+  }
+  bool first_in_batch = false;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    if (!pending_batch_) {
+      pending_batch_ = std::make_shared<Batch>();
+      first_in_batch = true;
+    }
+    *pending_batch_->request.add_requests() = request;
+    pending_batch_->calls.push_back({ response, controller, callback });
+  }
+  if (first_in_batch) {
+    shared_ptr<ConsensusRequestBatcher> s_this = shared_from_this();
+    // If the messenger is shutting down, the requests are sent right away and
+    // fail as they would have on their own.
+    messenger_->ScheduleOnReactor(
+        [s_this](const Status& /* s */) { s_this->SendBatch(); },
+        MonoDelta::FromMilliseconds(FLAGS_raft_heartbeat_batch_window_ms));
+  }
+}
+
+void ConsensusRequestBatcher::SendBatch() {
+  shared_ptr<Batch> batch;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    batch = std::move(pending_batch_);
+  }
+  DCHECK(batch);
+  if (batch->calls.size() == 1) {
+    const auto& call = batch->calls[0];
+    SendOne(batch->request.requests(0), call.response, call.controller, call.callback);
+    return;
+  }
+  batch->controller.set_timeout(MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms));
+  shared_ptr<ConsensusRequestBatcher> s_this = shared_from_this();
+  consensus_proxy_->BatchUpdateConsensusAsync(
+      batch->request, &batch->response, &batch->controller,
+      [s_this, batch]() { s_this->BatchFinished(batch.get()); });
+}
+
+void ConsensusRequestBatcher::BatchFinished(Batch* batch) {
+  // Note: This method runs on the reactor thread.
+  Status s = batch->controller.status();
+  const int num_calls = batch->calls.size();
+  if (s.ok() && batch->response.responses_size() != num_calls) {
+    s = Status::Corruption(Substitute("expected $0 responses, got $1",
+                                      num_calls, batch->response.responses_size()));
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    const auto* err = batch->controller.error_response();
+    if (err && err->code() == rpc::ErrorStatusPB::ERROR_NO_SUCH_METHOD) {
+      LOG(INFO) << Substitute("$0 doesn't support BatchUpdateConsensus; "
+                              "sending UpdateConsensus requests separately",
+                              consensus_proxy_->ToString());
+      batch_supported_ = false;
+    } else {
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute("BatchUpdateConsensus to $0 failed: $1",
+                                                  consensus_proxy_->ToString(), s.ToString());
+    }
+    for (int i = 0; i < num_calls; i++) {
+      const auto& call = batch->calls[i];
+      SendOne(batch->request.requests(i), call.response, call.controller, call.callback);
+    }
+    return;
+  }
+  for (int i = 0; i < num_calls; i++) {
+    const auto& call = batch->calls[i];
+    call.response->Swap(batch->response.mutable_responses(i));
+    call.callback();
+  }
+}
+
+void ConsensusRequestBatcher::SendOne(const ConsensusRequestPB& request,
+                                      ConsensusResponsePB* response,
+                                      RpcController* controller,
+                                      const rpc::ResponseCallback& callback) {
+  controller->set_timeout(MonoDelta::FromMilliseconds(FLAGS_consensus_rpc_timeout_ms));
+  consensus_proxy_->UpdateConsensusAsync(request, response, controller, callback);
+}
+
 RpcPeerProxyFactory::RpcPeerProxyFactory(shared_ptr<Messenger> messenger,
                                          DnsResolver* dns_resolver)
     : messenger_(std::move(messenger)),
@@ -581,7 +819,12 @@ Status RpcPeerProxyFactory::NewProxy(const RaftPeerPB& peer_pb,
   unique_ptr<ConsensusServiceProxy> new_proxy;
   RETURN_NOT_OK(CreateConsensusServiceProxyForHost(
       hostport, messenger_, dns_resolver_, &new_proxy));
-  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy)));
+  shared_ptr<ConsensusRequestBatcher> batcher;
+  if (FLAGS_raft_heartbeat_batch_window_ms > 0) {
+    RETURN_NOT_OK(ConsensusRequestBatcher::FindOrCreate(
+        messenger_, hostport, dns_resolver_, &batcher));
+  }
+  proxy->reset(new RpcPeerProxy(std::move(hostport), std::move(new_proxy), std::move(batcher)));
   return Status::OK();
 }
 
@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <ostream>
@@ -28,10 +29,13 @@
 #include "kudu/consensus/consensus.proxy.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/gutil/macros.h"
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -149,6 +153,10 @@ class Peer : public std::enable_shared_from_this<Peer> {
   // Signals there was an error sending the request to the peer.
   void ProcessResponseError(const Status& status);
 
+  // Moves the ops of 'request_' into a sidecar of 'controller_', serialized.
+  // See ConsensusRequestPB::ops_sidecar_idx.
+  void MoveOpsToSidecar();
+
   std::string LogPrefixUnlocked() const;
 
   const std::string& tablet_id() const { return tablet_id_; }
@@ -163,6 +171,17 @@ class Peer : public std::enable_shared_from_this<Peer> {
   PeerMessageQueue* queue_;
   uint64_t failed_attempts_;
 
+  // Whether the peer accepts ops in a sidecar, as of its last response.
+  bool ops_sidecar_supported_ = false;
+
+  // Whether the peer asked for safe time more often than it's heartbeated,
+  // as of its last response.
+  bool safe_time_requested_ = false;
+
+  // When the peer was last sent any operations. Used to decide when the
+  // tablet is idle enough to heartbeat it less often.
+  MonoTime last_op_sent_time_;
+
   // The latest consensus update request and response.
   ConsensusRequestPB request_;
   ConsensusResponsePB response_;
@@ -245,11 +264,71 @@ class PeerProxyFactory {
   virtual const std::shared_ptr<rpc::Messenger>& messenger() const = 0;
 };
 
+// Coalesces the UpdateConsensus requests without any ops (heartbeats and
+// commit index updates) that the leader replicas of different tablets send to
+// the same server, so that those sent within --raft_heartbeat_batch_window_ms
+// of each other go in a single BatchUpdateConsensus RPC.
+//
+// If the batch fails at the RPC layer, e.g. because the server doesn't support
+// BatchUpdateConsensus, its requests are resent separately, so each caller
+// sees the outcome of its own request.
+//
+// This class is thread-safe.
+class ConsensusRequestBatcher : public std::enable_shared_from_this<ConsensusRequestBatcher> {
+ public:
+  // Returns in 'batcher' the batcher for the server at 'hostport', creating it
+  // if there isn't one in use already.
+  static Status FindOrCreate(const std::shared_ptr<rpc::Messenger>& messenger,
+                             const HostPort& hostport,
+                             DnsResolver* dns_resolver,
+                             std::shared_ptr<ConsensusRequestBatcher>* batcher);
+
+  ConsensusRequestBatcher(std::shared_ptr<rpc::Messenger> messenger,
+                          std::unique_ptr<ConsensusServiceProxy> consensus_proxy);
+
+  // Same contract as PeerProxy::UpdateAsync(). Requests with ops are sent
+  // right away, on their own.
+  void UpdateAsync(const ConsensusRequestPB& request,
+                   ConsensusResponsePB* response,
+                   rpc::RpcController* controller,
+                   const rpc::ResponseCallback& callback);
+
+ private:
+  struct Batch;
+
+  // Sends the requests gathered so far.
+  void SendBatch();
+
+  // Hands the responses of 'batch' to its callers.
+  void BatchFinished(Batch* batch);
+
+  // Sends 'request' in its own UpdateConsensus RPC.
+  void SendOne(const ConsensusRequestPB& request,
+               ConsensusResponsePB* response,
+               rpc::RpcController* controller,
+               const rpc::ResponseCallback& callback);
+
+  const std::shared_ptr<rpc::Messenger> messenger_;
+  const std::unique_ptr<ConsensusServiceProxy> consensus_proxy_;
+
+  // Cleared once the server turns out not to support BatchUpdateConsensus.
+  std::atomic<bool> batch_supported_;
+
+  simple_spinlock lock_;
+
+  // The requests waiting to be sent, or null if there are none.
+  std::shared_ptr<Batch> pending_batch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsensusRequestBatcher);
+};
+
 // PeerProxy implementation that does RPC calls
 class RpcPeerProxy : public PeerProxy {
  public:
+  // If 'batcher' is set, requests without ops are sent through it.
   RpcPeerProxy(HostPort hostport,
-               std::unique_ptr<ConsensusServiceProxy> consensus_proxy);
+               std::unique_ptr<ConsensusServiceProxy> consensus_proxy,
+               std::shared_ptr<ConsensusRequestBatcher> batcher = nullptr);
 
   void UpdateAsync(const ConsensusRequestPB& request,
                    ConsensusResponsePB* response,
@@ -276,6 +355,7 @@ class RpcPeerProxy : public PeerProxy {
  private:
   const HostPort hostport_;
   std::unique_ptr<ConsensusServiceProxy> consensus_proxy_;
+  const std::shared_ptr<ConsensusRequestBatcher> batcher_;
 };
 
 // PeerProxyFactory implementation that generates RPCPeerProxies
@@ -297,6 +377,11 @@ class RpcPeerProxyFactory : public PeerProxyFactory {
   DnsResolver* dns_resolver_;
 };
 
+// Parses the ops sent in the sidecar of an UpdateConsensus request into 'ops'.
+// See ConsensusRequestPB::ops_sidecar_idx.
+Status ParseOpsFromSidecar(Slice sidecar,
+                           google::protobuf::RepeatedPtrField<ReplicateMsg>* ops);
+
 // Query the consensus service at last known host/port that is
 // specified in 'remote_peer' and set the 'permanent_uuid' field based
 // on the response.
@@ -1053,6 +1053,7 @@ TEST_F(ConsensusQueueTest, TestFollowerCommittedIndexAndMetrics) {
   queue_->UpdateLastIndexAppendedToLeader(10);
   AppendReplicateMessagesToQueue(queue_.get(), clock_.get(), 1, 10);
   WaitForLocalPeerToAckIndex(10);
+  ASSERT_GT(queue_->metrics_.local_append_latency->TotalCount(), 0);
 
   // The committed_index should be MinimumOpId() since UpdateFollowerWatermarks
   // has not been called.
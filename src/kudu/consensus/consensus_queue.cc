@@ -72,6 +72,7 @@ TAG_FLAG(consensus_inject_latency_ms_in_notifications, hidden);
 TAG_FLAG(consensus_inject_latency_ms_in_notifications, unsafe);
 
 DECLARE_bool(raft_prepare_replacement_before_eviction);
+DECLARE_bool(raft_send_ops_in_sidecars);
 DECLARE_bool(safe_time_advancement_without_writes);
 DECLARE_int32(consensus_rpc_timeout_ms);
 DECLARE_int64(rpc_max_message_size);
@@ -119,6 +120,13 @@ METRIC_DEFINE_gauge_int64(tablet, ops_behind_leader, "Operations Behind Leader",
                           MetricUnit::kOperations,
                           "Number of operations this server believes it is behind the leader.",
                           kudu::MetricLevel::kWarn);
+METRIC_DEFINE_histogram(tablet, raft_local_append_latency, "Raft Local Append Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds from operations being queued for replication to their "
+                        "being durable in the local WAL. A leader sends the operations to its "
+                        "peers in the meantime, and only counts its own ack once they're durable.",
+                        kudu::MetricLevel::kDebug,
+                        60000000LU, 2);
 
 const char* PeerStatusToString(PeerStatus p) {
   switch (p) {
@@ -165,7 +173,8 @@ std::string PeerMessageQueue::TrackedPeer::ToString() const {
 PeerMessageQueue::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
   : num_majority_done_ops(INSTANTIATE_METRIC(METRIC_majority_done_ops)),
     num_in_progress_ops(INSTANTIATE_METRIC(METRIC_in_progress_ops)),
-    num_ops_behind_leader(INSTANTIATE_METRIC(METRIC_ops_behind_leader)) {
+    num_ops_behind_leader(INSTANTIATE_METRIC(METRIC_ops_behind_leader)),
+    local_append_latency(METRIC_raft_local_append_latency.Instantiate(metric_entity)) {
 }
 #undef INSTANTIATE_METRIC
 
@@ -417,14 +426,28 @@ Status PeerMessageQueue::AppendOperations(const vector<ReplicateRefPtr>& msgs,
   if (queue_state_.mode == LEADER) {
     time_manager_->AdvanceSafeTimeWithMessage(*msgs.back()->get());
   }
+  const bool serialize_ops = queue_state_.mode == LEADER && FLAGS_raft_send_ops_in_sidecars;
 
   // Unlock ourselves during Append to prevent a deadlock: it's possible that
   // the log buffer is full, in which case AppendOperations would block. However,
   // for the log buffer to empty, it may need to call LocalPeerAppendFinished()
   // which also needs queue_lock_.
+  //
+  // The operations can be sent to the peers as soon as they're in the log
+  // cache, while they're still being appended to the local WAL.
   lock.unlock();
+  if (serialize_ops) {
+    // Serialize the ops once for all the peers, before they're added to the
+    // log cache so that it accounts for the serialized copies.
+    for (const auto& msg : msgs) {
+      msg->SerializedWithLength();
+    }
+  }
+  const MonoTime start = MonoTime::Now();
   RETURN_NOT_OK(log_cache_.AppendOperations(
-      msgs, [this, last_id, log_append_callback](const Status& s) {
+      msgs, [this, last_id, log_append_callback, start](const Status& s) {
+        metrics_.local_append_latency->Increment(
+            (MonoTime::Now() - start).ToMicroseconds());
         this->LocalPeerAppendFinished(last_id, log_append_callback, s);
       }));
   lock.lock();
@@ -355,6 +355,8 @@ class PeerMessageQueue {
     // Keeps track of the number of ops. behind the leader the peer is, measured as the difference
     // between the latest appended op index on this peer versus on the leader (0 if leader).
     scoped_refptr<AtomicGauge<int64_t> > num_ops_behind_leader;
+    // Time from ops. being appended to the queue to their being durable in the local WAL.
+    scoped_refptr<Histogram> local_append_latency;
 
     explicit Metrics(const scoped_refptr<MetricEntity>& metric_entity);
   };
@@ -64,6 +64,9 @@ DEFINE_int32(num_batches, 10000,
 
 DECLARE_int32(log_min_segments_to_retain);
 DECLARE_int32(log_max_segments_to_retain);
+DECLARE_int32(log_append_shared_threads);
+DECLARE_int32(log_group_sync_window_us);
+DECLARE_bool(log_sync_on_write);
 DECLARE_double(log_inject_io_error_on_preallocate_fraction);
 DECLARE_int64(fs_wal_dir_reserved_bytes);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
@@ -1168,6 +1171,90 @@ TEST_F(LogTest, TestAutoStopIdleAppendThread) {
   }
 }
 
+// Logs may append their entries using threads shared with other logs.
+TEST_F(LogTest, TestSharedAppendThreads) {
+  FLAGS_log_append_shared_threads = 2;
+  const int kNumBatches = 20;
+  ASSERT_OK(BuildLog());
+  ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kNumBatches));
+
+  // The log's task gives its shared thread back once there's nothing to append.
+  ASSERT_EVENTUALLY([&]() {
+      ASSERT_FALSE(log_->append_thread_active_for_tests());
+    });
+  ASSERT_OK(log_->Close());
+
+  shared_ptr<LogReader> reader;
+  ASSERT_OK(LogReader::Open(fs_manager_.get(),
+                            /*index*/nullptr,
+                            kTestTablet,
+                            metric_entity_tablet_,
+                            file_cache_.get(),
+                            &reader));
+  SegmentSequence segments;
+  reader->GetSegmentsSnapshot(&segments);
+  int num_entries = 0;
+  for (const auto& segment : segments) {
+    entries_.clear();
+    ASSERT_OK(segment->ReadEntries(&entries_));
+    num_entries += entries_.size();
+  }
+  ASSERT_EQ(kNumBatches * 2, num_entries);
+}
+
+// Logs may sync together with the other logs which need to sync at the same time.
+TEST_F(LogTest, TestGroupSync) {
+  FLAGS_log_group_sync_window_us = 1000;
+  const int kNumBatches = 20;
+  ASSERT_OK(BuildLog());
+  ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kNumBatches));
+  ASSERT_OK(log_->Close());
+
+  shared_ptr<LogReader> reader;
+  ASSERT_OK(LogReader::Open(fs_manager_.get(),
+                            /*index*/nullptr,
+                            kTestTablet,
+                            metric_entity_tablet_,
+                            file_cache_.get(),
+                            &reader));
+  SegmentSequence segments;
+  reader->GetSegmentsSnapshot(&segments);
+  int num_entries = 0;
+  for (const auto& segment : segments) {
+    entries_.clear();
+    ASSERT_OK(segment->ReadEntries(&entries_));
+    num_entries += entries_.size();
+  }
+  ASSERT_EQ(kNumBatches * 2, num_entries);
+}
+
+// Test that the entries written and synced with a single call can be read back.
+TEST_F(LogTest, TestSyncOnWrite) {
+  FLAGS_log_force_fsync_all = true;
+  FLAGS_log_sync_on_write = true;
+  const int kNumBatches = 20;
+  ASSERT_OK(BuildLog());
+  ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kNumBatches));
+  ASSERT_OK(log_->Close());
+
+  shared_ptr<LogReader> reader;
+  ASSERT_OK(LogReader::Open(fs_manager_.get(),
+                            /*index*/nullptr,
+                            kTestTablet,
+                            metric_entity_tablet_,
+                            file_cache_.get(),
+                            &reader));
+  SegmentSequence segments;
+  reader->GetSegmentsSnapshot(&segments);
+  int num_entries = 0;
+  for (const auto& segment : segments) {
+    entries_.clear();
+    ASSERT_OK(segment->ReadEntries(&entries_));
+    num_entries += entries_.size();
+  }
+  ASSERT_EQ(kNumBatches * 2, num_entries);
+}
+
 // Test that Log::TotalSize() captures creation, addition, and deletion of log segments.
 TEST_P(LogTestOptionalCompression, TestTotalSize) {
   // Build a log. There is an active segment, so on-disk size should be positive.
@@ -29,6 +29,7 @@
 #include <gflags/gflags.h>
 
 #include "kudu/common/wire_protocol.h"
+#include "kudu/consensus/log_group_syncer.h"
 #include "kudu/consensus/log_index.h"
 #include "kudu/consensus/log_metrics.h"
 #include "kudu/consensus/log_reader.h"
@@ -90,6 +91,34 @@ DEFINE_int32(log_thread_idle_threshold_ms, 1000,
 TAG_FLAG(log_thread_idle_threshold_ms, experimental);
 TAG_FLAG(log_thread_idle_threshold_ms, hidden);
 
+DEFINE_int32(log_append_shared_threads, 0,
+             "If positive, the logs of all tablets append their entries using a "
+             "pool of this many threads shared by the whole process, rather than "
+             "each log using a thread of its own. This bounds the number of "
+             "append threads on servers which host many tablets. Only takes "
+             "effect when the first log is opened.");
+TAG_FLAG(log_append_shared_threads, experimental);
+
+DEFINE_int32(log_group_sync_window_us, 0,
+             "If positive, the logs of different tablets which need to sync "
+             "within this many microseconds of each other sync together, in "
+             "parallel, and complete the callbacks of their entries at the "
+             "same time. The window and --log_group_sync_max_threads are read "
+             "when logs first sync this way.");
+TAG_FLAG(log_group_sync_window_us, experimental);
+
+DEFINE_int32(log_group_sync_max_threads, 32,
+             "Maximum number of logs which sync at the same time as part of a "
+             "group sync. See --log_group_sync_window_us.");
+TAG_FLAG(log_group_sync_max_threads, experimental);
+
+DEFINE_bool(log_sync_on_write, false,
+            "Whether a group of appends consisting of a single entry batch is "
+            "written and made durable with a single system call, rather than "
+            "being synced separately after it's written. Only relevant when "
+            "--log_force_fsync_all is set.");
+TAG_FLAG(log_sync_on_write, experimental);
+
 // Compression configuration.
 // -----------------------------
 DEFINE_string(log_compression_codec, "LZ4",
@@ -247,6 +276,14 @@ class Log::AppendThread {
   // a new task was enqueued just as we were trying to go idle.
   bool GoIdle();
 
+  // Like ProcessQueue(), but for a log which shares its append threads with
+  // other logs: appends whatever is queued, then yields the thread to the
+  // other logs rather than wait for more entries.
+  void ProcessQueueShared();
+
+  // Submits the task which processes the queue.
+  void SubmitTask();
+
   // Handle the actual appending of a group of entries. Responsible for deleting the
   // LogEntryBatch* pointers.
   void HandleBatches(vector<LogEntryBatch*> entry_batches);
@@ -266,18 +303,55 @@ class Log::AppendThread {
   Atomic32 thread_state_ = IDLE;
 
   // Pool with a single thread, which handles shutting down the thread
-  // when idle.
+  // when idle. Unset if the log shares its append threads with other logs.
   unique_ptr<ThreadPool> append_pool_;
+
+  // Token for the pool of append threads shared by all logs, set if
+  // --log_append_shared_threads is positive. The token is serial, so that
+  // the log's entries are still appended by one task at a time.
+  unique_ptr<ThreadPoolToken> append_token_;
 };
 
+// Returns the pool of append threads shared by all logs of the process,
+// creating it on first use. The pool is never destroyed, since logs may be
+// closed during the destruction of static objects.
+static ThreadPool* SharedAppendPool() {
+  static ThreadPool* pool = []() {
+    unique_ptr<ThreadPool> pool;
+    CHECK_OK(ThreadPoolBuilder("wal-append-shared")
+             .set_min_threads(0)
+             .set_max_threads(FLAGS_log_append_shared_threads)
+             .Build(&pool));
+    return pool.release();
+  }();
+  return pool;
+}
+
+// Returns the syncer shared by all logs of the process, creating it on first
+// use. Like the shared append pool, the syncer is never destroyed.
+static LogGroupSyncer* GroupSyncer() {
+  static LogGroupSyncer* syncer = []() {
+    unique_ptr<LogGroupSyncer> syncer(new LogGroupSyncer(
+        MonoDelta::FromMicroseconds(FLAGS_log_group_sync_window_us),
+        FLAGS_log_group_sync_max_threads));
+    CHECK_OK(syncer->Init());
+    return syncer.release();
+  }();
+  return syncer;
+}
+
 
 Log::AppendThread::AppendThread(Log *log)
   : log_(log) {
 }
 
 Status Log::AppendThread::Init() {
-  DCHECK(!append_pool_) << "Already initialized";
+  DCHECK(!append_pool_ && !append_token_) << "Already initialized";
   VLOG_WITH_PREFIX(1) << "Starting log append thread";
+  if (FLAGS_log_append_shared_threads > 0) {
+    append_token_ = SharedAppendPool()->NewToken(ThreadPool::ExecutionMode::SERIAL);
+    return Status::OK();
+  }
   RETURN_NOT_OK(ThreadPoolBuilder("wal-append")
                 .set_min_threads(0)
                 // Only need one thread since we'll only schedule one
@@ -291,10 +365,18 @@ Status Log::AppendThread::Init() {
 }
 
 void Log::AppendThread::Wake() {
-  DCHECK(append_pool_);
+  DCHECK(append_pool_ || append_token_);
   auto old_status = base::subtle::NoBarrier_CompareAndSwap(
       &thread_state_, IDLE, ACTIVE);
   if (old_status == IDLE) {
+    SubmitTask();
+  }
+}
+
+void Log::AppendThread::SubmitTask() {
+  if (append_token_) {
+    CHECK_OK(append_token_->Submit([this]() { this->ProcessQueueShared(); }));
+  } else {
     CHECK_OK(append_pool_->Submit([this]() { this->ProcessQueue(); }));
   }
 }
@@ -364,6 +446,27 @@ void Log::AppendThread::ProcessQueue() {
   VLOG_WITH_PREFIX(2) << "WAL Appender going idle";
 }
 
+void Log::AppendThread::ProcessQueueShared() {
+  DCHECK_EQ(ANNOTATE_UNPROTECTED_READ(thread_state_), ACTIVE);
+  // Don't wait for more entries: that would hold up one of the threads shared
+  // with the other logs.
+  vector<LogEntryBatch*> entry_batches;
+  Status s = log_->entry_queue()->BlockingDrainTo(&entry_batches, MonoTime::Now());
+  if (s.ok()) {
+    HandleBatches(std::move(entry_batches));
+    // Let the other logs' tasks run before appending anything else that was
+    // queued meanwhile.
+    SubmitTask();
+    return;
+  }
+  if (s.IsTimedOut() && !GoIdle()) {
+    SubmitTask();
+    return;
+  }
+  log_->SetActiveSegmentIdle();
+  VLOG_WITH_PREFIX(2) << "WAL Appender going idle";
+}
+
 void Log::AppendThread::HandleBatches(vector<LogEntryBatch*> entry_batches) {
   if (log_->ctx_.metrics) {
     log_->ctx_.metrics->entry_batches_per_group->Increment(entry_batches.size());
@@ -372,10 +475,15 @@ void Log::AppendThread::HandleBatches(vector<LogEntryBatch*> entry_batches) {
 
   SCOPED_LATENCY_METRIC(log_->ctx_.metrics, group_commit_latency);
 
+  // A lone batch which needs to be synced can be synced as it's written; the
+  // Sync() below then only has to run the hooks.
+  const bool sync_on_write = FLAGS_log_sync_on_write &&
+                             entry_batches.size() == 1 &&
+                             entry_batches[0]->type_ != COMMIT;
   bool is_all_commits = true;
   for (auto* entry_batch : entry_batches) {
     TRACE_EVENT_FLOW_END0("log", "Batch", entry_batch);
-    Status s = log_->WriteBatch(entry_batch);
+    Status s = log_->WriteBatch(entry_batch, sync_on_write);
     if (PREDICT_FALSE(!s.ok())) {
       LOG_WITH_PREFIX(ERROR) << "Error appending to the log: " << s.ToString();
       // TODO(af): If a single transaction fails to append, should we
@@ -391,7 +499,11 @@ void Log::AppendThread::HandleBatches(vector<LogEntryBatch*> entry_batches) {
 
   Status s;
   if (!is_all_commits) {
-    s = log_->Sync();
+    if (FLAGS_log_group_sync_window_us > 0) {
+      s = GroupSyncer()->Sync([this]() { return log_->Sync(); });
+    } else {
+      s = log_->Sync();
+    }
   }
   if (PREDICT_FALSE(!s.ok())) {
     LOG_WITH_PREFIX(ERROR) << "Error syncing log: " << s.ToString();
@@ -415,6 +527,11 @@ void Log::AppendThread::HandleBatches(vector<LogEntryBatch*> entry_batches) {
 
 void Log::AppendThread::Shutdown() {
   log_->entry_queue()->Shutdown();
+  if (append_token_) {
+    // Wait for the log's own tasks only: the pool is shared.
+    append_token_->Wait();
+    append_token_->Shutdown();
+  }
   if (append_pool_) {
     append_pool_->Wait();
     append_pool_->Shutdown();
@@ -883,7 +1000,7 @@ Status Log::AsyncAppendCommit(unique_ptr<consensus::CommitMsg> commit_msg,
   return Status::OK();
 }
 
-Status Log::WriteBatch(LogEntryBatch* entry_batch) {
+Status Log::WriteBatch(LogEntryBatch* entry_batch, bool sync) {
   size_t num_entries = entry_batch->count();
   DCHECK_GT(num_entries, 0) << "Cannot call WriteBatch() with zero entries reserved";
 
@@ -915,7 +1032,8 @@ Status Log::WriteBatch(LogEntryBatch* entry_batch) {
     SCOPED_LATENCY_METRIC(ctx_.metrics, append_latency);
     SCOPED_WATCH_STACK(500);
 
-    RETURN_NOT_OK(active_segment->WriteEntryBatch(entry_batch_data, segment_allocator_.codec_));
+    RETURN_NOT_OK(active_segment->WriteEntryBatch(entry_batch_data, segment_allocator_.codec_,
+                                                  sync && options_.force_fsync_all));
 
     // Update the reader on how far it can read the active segment.
     reader_->UpdateLastSegmentOffset(active_segment->written_offset());
@@ -941,15 +1059,17 @@ Status Log::UpdateIndexForBatch(const LogEntryBatch& batch,
     return Status::OK();
   }
 
+  vector<LogIndexEntry> index_entries;
+  index_entries.reserve(batch.entry_batch_pb_->entry_size());
   for (const LogEntryPB& entry_pb : batch.entry_batch_pb_->entry()) {
     LogIndexEntry index_entry;
 
     index_entry.op_id = entry_pb.replicate().id();
     index_entry.segment_sequence_number = segment_allocator_.active_segment_sequence_number();
     index_entry.offset_in_segment = start_offset;
-    RETURN_NOT_OK(log_index_->AddEntry(index_entry));
+    index_entries.emplace_back(std::move(index_entry));
   }
-  return Status::OK();
+  return log_index_->AddEntries(index_entries);
 }
 
 Status Log::AllocateSegmentAndRollOverForTests() {
@@ -454,7 +454,10 @@ class Log : public RefCountedThreadSafe<Log> {
   Status AsyncAppend(std::unique_ptr<LogEntryBatch> entry_batch);
 
   // Writes serialized contents of 'entry' to the log. This is not thread-safe.
-  Status WriteBatch(LogEntryBatch* entry_batch);
+  //
+  // If 'sync' is true and the log is configured to fsync, the batch is made
+  // durable as part of the write when nothing else is waiting to be synced.
+  Status WriteBatch(LogEntryBatch* entry_batch, bool sync = false);
 
   // Update footer_builder_ to reflect the log indexes seen in 'batch'.
   void UpdateFooterForBatch(LogEntryBatch* batch);
@@ -62,6 +62,7 @@ using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
+DECLARE_bool(log_cache_borrow_spare_capacity);
 DECLARE_int32(log_cache_size_limit_mb);
 DECLARE_int32(global_log_cache_size_limit_mb);
 
@@ -182,6 +183,10 @@ TEST_F(LogCacheTest, TestAppendAndGetMessages) {
   EXPECT_EQ(80, messages.size());
   EXPECT_EQ("2.20", OpIdToString(preceding));
   EXPECT_EQ("3.21", OpIdToString(messages[0]->get()->id()));
+
+  // The ops evicted above were read from disk, the rest from the cache.
+  EXPECT_EQ(180, cache_->metrics_.log_cache_hits->value());
+  EXPECT_EQ(30, cache_->metrics_.log_cache_misses->value());
 }
 
 
@@ -322,6 +327,34 @@ TEST_F(LogCacheTest, TestGlobalMemoryLimit) {
   ASSERT_LE(cache_->BytesUsed(), 1024 * 1024);
 }
 
+// Test that a cache over its own limit borrows the spare capacity of the
+// server-wide limit, and that the borrowed memory is reclaimed first once the
+// server-wide limit is reached.
+TEST_F(LogCacheTest, TestBorrowSpareCapacity) {
+  // Recreate the global tracker with the new limit; see TestGlobalMemoryLimit.
+  cache_.reset();
+
+  FLAGS_log_cache_borrow_spare_capacity = true;
+  FLAGS_log_cache_size_limit_mb = 1;
+  FLAGS_global_log_cache_size_limit_mb = 4;
+  CloseAndReopenCache(MinimumOpId());
+
+  // Exceed the per-tablet limit: nothing is evicted.
+  const int kPayloadSize = 400 * 1024;
+  ASSERT_OK(AppendReplicateMessagesToCache(1, 4, kPayloadSize));
+  log_->WaitUntilAllFlushed();
+  ASSERT_EQ(4, cache_->num_cached_ops());
+  ASSERT_GT(cache_->BytesUsed(), 1024 * 1024);
+
+  // Use up the rest of the global limit elsewhere. Appending more evicts the
+  // ops the cache borrowed memory for.
+  ScopedTrackedConsumption consumption(cache_->parent_tracker_, 3 * 1024 * 1024);
+  ASSERT_OK(AppendReplicateMessagesToCache(5, 1, kPayloadSize));
+  log_->WaitUntilAllFlushed();
+  ASSERT_LE(cache_->num_cached_ops(), 2);
+  ASSERT_LE(cache_->BytesUsed(), 1024 * 1024);
+}
+
 // Test that the log cache properly replaces messages when an index
 // is reused. This is a regression test for a bug where the memtracker's
 // consumption wasn't properly managed when messages were replaced.
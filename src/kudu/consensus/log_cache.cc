@@ -17,10 +17,12 @@
 
 #include "kudu/consensus/log_cache.h"
 
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <mutex>
 #include <ostream>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -59,6 +61,13 @@ DEFINE_int32(global_log_cache_size_limit_mb, 1024,
              "caching log entries across all tablets is kept under this threshold.");
 TAG_FLAG(global_log_cache_size_limit_mb, advanced);
 
+DEFINE_bool(log_cache_borrow_spare_capacity, false,
+            "Whether a tablet's log cache may grow past 'log_cache_size_limit_mb' "
+            "while the server-wide limit isn't reached, instead of evicting the "
+            "entries its lagging followers still need. The memory borrowed this way "
+            "is the first to be reclaimed once the server-wide limit is reached.");
+TAG_FLAG(log_cache_borrow_spare_capacity, experimental);
+
 using kudu::pb_util::SecureShortDebugString;
 using std::string;
 using std::vector;
@@ -75,9 +84,32 @@ METRIC_DEFINE_gauge_int64(tablet, log_cache_size, "Log Cache Memory Usage",
                           MetricUnit::kBytes,
                           "Amount of memory in use for caching the local log.",
                           kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(tablet, log_cache_hits, "Log Cache Hits",
+                      MetricUnit::kOperations,
+                      "Number of operations read from the log cache to be sent to peers.",
+                      kudu::MetricLevel::kInfo);
+METRIC_DEFINE_counter(tablet, log_cache_misses, "Log Cache Misses",
+                      MetricUnit::kOperations,
+                      "Number of operations read from the log on disk to be sent to peers "
+                      "because they had been evicted from the log cache.",
+                      kudu::MetricLevel::kInfo);
 
 static const char kParentMemTrackerId[] = "log_cache";
 
+namespace {
+// All the log caches in the server, so that one cache may reclaim the memory
+// other caches borrowed.
+struct LogCacheRegistry {
+  std::mutex lock;
+  std::set<LogCache*> caches;
+};
+
+LogCacheRegistry* GetLogCacheRegistry() {
+  static LogCacheRegistry* registry = new LogCacheRegistry();
+  return registry;
+}
+} // anonymous namespace
+
 typedef vector<const ReplicateMsg*>::const_iterator MsgIter;
 
 LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
@@ -111,9 +143,18 @@ LogCache::LogCache(const scoped_refptr<MetricEntity>& metric_entity,
   auto zero_op = new ReplicateMsg();
   *zero_op->mutable_id() = MinimumOpId();
   InsertOrDie(&cache_, 0, { make_scoped_refptr_replicate(zero_op), zero_op->SpaceUsed() });
+
+  LogCacheRegistry* registry = GetLogCacheRegistry();
+  std::lock_guard<std::mutex> l(registry->lock);
+  InsertOrDie(&registry->caches, this);
 }
 
 LogCache::~LogCache() {
+  {
+    LogCacheRegistry* registry = GetLogCacheRegistry();
+    std::lock_guard<std::mutex> l(registry->lock);
+    registry->caches.erase(this);
+  }
   tracker_->Release(tracker_->consumption());
   cache_.clear();
 }
@@ -158,7 +199,9 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
   vector<CacheEntry> entries_to_insert;
   entries_to_insert.reserve(msgs.size());
   for (const auto& msg : msgs) {
-    CacheEntry e = { msg, static_cast<int64_t>(msg->get()->SpaceUsedLong()) };
+    // Account for the serialized copy of the message too, if it was made.
+    CacheEntry e = { msg, static_cast<int64_t>(msg->get()->SpaceUsedLong() +
+                                               msg->serialized_size()) };
     mem_required += e.mem_usage;
     entries_to_insert.emplace_back(std::move(e));
   }
@@ -166,6 +209,15 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
   int64_t first_idx_in_batch = msgs.front()->get()->id().index();
   int64_t last_idx_in_batch = msgs.back()->get()->id().index();
 
+  // If the server-wide limit doesn't leave room for this batch, first take
+  // back the memory which caches borrowed beyond their own limits.
+  if (FLAGS_log_cache_borrow_spare_capacity) {
+    int64_t global_spare = parent_tracker_->SpareCapacity();
+    if (global_spare < mem_required) {
+      ReclaimBorrowedMemory(mem_required - std::max<int64_t>(global_spare, 0));
+    }
+  }
+
   std::unique_lock<simple_spinlock> l(lock_);
   // If we're not appending a consecutive op we're likely overwriting and
   // need to replace operations in the cache.
@@ -184,9 +236,13 @@ Status LogCache::AppendOperations(const vector<ReplicateRefPtr>& msgs,
                         << HumanReadableNumBytes::ToString(spare)
                         << "): attempting to evict some operations...";
 
-    // TODO: we should also try to evict from other tablets - probably better to
-    // evict really old ops from another tablet than evict recent ops from this one.
-    EvictSomeUnlocked(min_pinned_op_index_, need_to_free);
+    // If only this cache's own limit would be exceeded, it may borrow the
+    // capacity other caches don't use rather than evict ops its lagging
+    // peers still need.
+    if (!FLAGS_log_cache_borrow_spare_capacity ||
+        parent_tracker_->SpareCapacity() < mem_required) {
+      EvictSomeUnlocked(min_pinned_op_index_, need_to_free);
+    }
 
     // Force consuming, so that we don't refuse appending data. We might
     // blow past our limit a little bit (as much as the number of tablets times
@@ -231,15 +287,24 @@ void LogCache::LogCallback(int64_t last_idx_in_batch,
                            const StatusCallback& user_callback,
                            const Status& log_status) {
   if (log_status.ok()) {
-    std::lock_guard<simple_spinlock> l(lock_);
+    std::unique_lock<simple_spinlock> l(lock_);
     if (min_pinned_op_index_ <= last_idx_in_batch) {
       VLOG_WITH_PREFIX_UNLOCKED(1) << "Updating pinned index to " << (last_idx_in_batch + 1);
       min_pinned_op_index_ = last_idx_in_batch + 1;
     }
 
     // If we went over the global limit in order to log this batch, evict some to
-    // get back down under the limit.
+    // get back down under the limit, starting with the memory borrowed by caches
+    // over their own limits.
     if (borrowed_memory) {
+      if (FLAGS_log_cache_borrow_spare_capacity) {
+        l.unlock();
+        int64_t spare_capacity = parent_tracker_->SpareCapacity();
+        if (spare_capacity < 0) {
+          ReclaimBorrowedMemory(-spare_capacity);
+        }
+        l.lock();
+      }
       int64_t spare_capacity = parent_tracker_->SpareCapacity();
       if (spare_capacity < 0) {
         EvictSomeUnlocked(min_pinned_op_index_, -spare_capacity);
@@ -337,6 +402,7 @@ Status LogCache::ReadOps(int64_t after_op_index,
         remaining_space -= TotalByteSizeForMessage(*msg);
         if (remaining_space > 0 || messages->empty()) {
           messages->push_back(make_scoped_refptr_replicate(msg));
+          metrics_.log_cache_misses->Increment();
           next_index++;
         } else {
           delete msg;
@@ -358,6 +424,7 @@ Status LogCache::ReadOps(int64_t after_op_index,
         }
 
         messages->push_back(msg);
+        metrics_.log_cache_hits->Increment();
         next_index++;
       }
     }
@@ -372,7 +439,33 @@ void LogCache::EvictThroughOp(int64_t index) {
   EvictSomeUnlocked(index, MathLimits<int64_t>::kMax);
 }
 
-void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict) {
+void LogCache::ReclaimBorrowedMemory(int64_t bytes_to_evict) {
+  LogCacheRegistry* registry = GetLogCacheRegistry();
+  std::lock_guard<std::mutex> l(registry->lock);
+  for (LogCache* cache : registry->caches) {
+    if (bytes_to_evict <= 0) {
+      break;
+    }
+    bytes_to_evict -= cache->EvictBorrowedMemory(bytes_to_evict);
+  }
+}
+
+int64_t LogCache::EvictBorrowedMemory(int64_t bytes_to_evict) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (!tracker_->has_limit()) {
+    return 0;
+  }
+  int64_t borrowed = tracker_->consumption() - tracker_->limit();
+  if (borrowed <= 0) {
+    return 0;
+  }
+  VLOG_WITH_PREFIX_UNLOCKED(1) << "Reclaiming "
+                               << HumanReadableNumBytes::ToString(borrowed)
+                               << " of borrowed log cache memory";
+  return EvictSomeUnlocked(min_pinned_op_index_, std::min(borrowed, bytes_to_evict));
+}
+
+int64_t LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict) {
   DCHECK(lock_.is_locked());
   VLOG_WITH_PREFIX_UNLOCKED(2) << "Evicting log cache index <= "
                       << stop_after_index
@@ -412,6 +505,7 @@ void LogCache::EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evic
     }
   }
   VLOG_WITH_PREFIX_UNLOCKED(1) << "Evicting log cache: after state: " << ToStringUnlocked();
+  return bytes_evicted;
 }
 
 void LogCache::AccountForMessageRemovalUnlocked(const LogCache::CacheEntry& entry) {
@@ -499,7 +593,9 @@ void LogCache::DumpToHtml(std::ostream& out) const {
   x.Instantiate(metric_entity, 0)
 LogCache::Metrics::Metrics(const scoped_refptr<MetricEntity>& metric_entity)
   : log_cache_num_ops(INSTANTIATE_METRIC(METRIC_log_cache_num_ops)),
-    log_cache_size(INSTANTIATE_METRIC(METRIC_log_cache_size)) {
+    log_cache_size(INSTANTIATE_METRIC(METRIC_log_cache_size)),
+    log_cache_hits(INSTANTIATE_METRIC(METRIC_log_cache_hits)),
+    log_cache_misses(INSTANTIATE_METRIC(METRIC_log_cache_misses)) {
 }
 #undef INSTANTIATE_METRIC
 
@@ -144,6 +144,7 @@ class LogCache {
 
  private:
   FRIEND_TEST(LogCacheTest, TestAppendAndGetMessages);
+  FRIEND_TEST(LogCacheTest, TestBorrowSpareCapacity);
   FRIEND_TEST(LogCacheTest, TestGlobalMemoryLimit);
   FRIEND_TEST(LogCacheTest, TestReplaceMessages);
   FRIEND_TEST(LogCacheTest, TestTruncation);
@@ -159,8 +160,17 @@ class LogCache {
 
   // Try to evict the oldest operations from the queue, stopping either when
   // 'bytes_to_evict' bytes have been evicted, or the op with index
-  // 'stop_after_index' has been evicted, whichever comes first.
-  void EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict);
+  // 'stop_after_index' has been evicted, whichever comes first. Returns the
+  // number of bytes evicted.
+  int64_t EvictSomeUnlocked(int64_t stop_after_index, int64_t bytes_to_evict);
+
+  // Evicts up to 'bytes_to_evict' bytes from the caches of the server which
+  // are over their own limits, down to those limits.
+  static void ReclaimBorrowedMemory(int64_t bytes_to_evict);
+
+  // Evicts the oldest operations of this cache, up to 'bytes_to_evict' bytes,
+  // until it's no longer over its own limit. Returns the number of bytes evicted.
+  int64_t EvictBorrowedMemory(int64_t bytes_to_evict);
 
   // Update metrics and MemTracker to account for the removal of the
   // given message.
@@ -226,6 +236,10 @@ class LogCache {
 
     // Keeps track of the memory consumed by the cache, in bytes.
     scoped_refptr<AtomicGauge<int64_t> > log_cache_size;
+
+    // The number of operations read from the cache, and from the log on disk.
+    scoped_refptr<Counter> log_cache_hits;
+    scoped_refptr<Counter> log_cache_misses;
   };
   Metrics metrics_;
 
@@ -0,0 +1,113 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/consensus/log_group_syncer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/gutil/port.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/threadpool.h"
+
+using std::vector;
+
+namespace kudu {
+namespace log {
+
+struct LogGroupSyncer::Request {
+  explicit Request(std::function<Status()> sync)
+      : sync(std::move(sync)),
+        done(1) {
+  }
+
+  const std::function<Status()> sync;
+  Status result;
+  CountDownLatch done;
+};
+
+LogGroupSyncer::LogGroupSyncer(MonoDelta window, int max_threads)
+    : window_(window),
+      max_threads_(max_threads) {
+  DCHECK_GT(max_threads, 0);
+}
+
+LogGroupSyncer::~LogGroupSyncer() {
+  if (pool_) {
+    pool_->Shutdown();
+  }
+}
+
+Status LogGroupSyncer::Init() {
+  // The thread which starts a wave runs one of its syncs, so the pool needs
+  // one thread less.
+  return ThreadPoolBuilder("wal-sync")
+      .set_min_threads(0)
+      .set_max_threads(std::max(max_threads_ - 1, 1))
+      .Build(&pool_);
+}
+
+Status LogGroupSyncer::Sync(std::function<Status()> sync) {
+  Request req(std::move(sync));
+  bool starts_wave;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    starts_wave = pending_.empty();
+    pending_.push_back(&req);
+  }
+  if (starts_wave) {
+    SleepFor(window_);
+    vector<Request*> wave;
+    {
+      std::lock_guard<simple_spinlock> l(lock_);
+      wave.swap(pending_);
+    }
+    RunWave(std::move(wave));
+  }
+  req.done.Wait();
+  return req.result;
+}
+
+void LogGroupSyncer::RunWave(vector<Request*> wave) {
+  DCHECK(!wave.empty());
+  auto remaining = std::make_shared<std::atomic<size_t>>(wave.size());
+  auto run = [wave, remaining](Request* req) {
+    req->result = req->sync();
+    if (remaining->fetch_sub(1) == 1) {
+      // That was the wave's last sync: wake up all of its requesters. Each
+      // request may be destroyed as soon as it's done.
+      for (Request* r : wave) {
+        r->done.CountDown();
+      }
+    }
+  };
+  for (size_t i = 1; i < wave.size(); i++) {
+    Request* req = wave[i];
+    Status s = pool_->Submit([run, req]() { run(req); });
+    if (PREDICT_FALSE(!s.ok())) {
+      run(req);
+    }
+  }
+  run(wave[0]);
+}
+
+} // namespace log
+} // namespace kudu
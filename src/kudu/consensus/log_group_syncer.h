@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ThreadPool;
+
+namespace log {
+
+// Syncs the logs of several tablets together.
+//
+// A log which needs to sync its active segment asks the syncer to do so. The
+// first such request starts a wave: the syncer waits for a short window, for
+// other logs to request syncs too, then runs the syncs of the whole wave in
+// parallel. None of the requests of a wave returns until all of its syncs
+// completed, so the logs run the callbacks of their entries together.
+//
+// This class is thread-safe.
+class LogGroupSyncer {
+ public:
+  // 'window' is how long a wave collects sync requests for. Up to
+  // 'max_threads' syncs of a wave run at a time.
+  LogGroupSyncer(MonoDelta window, int max_threads);
+  ~LogGroupSyncer();
+
+  Status Init();
+
+  // Runs 'sync' as part of the next wave of syncs, and returns its result
+  // once every sync of the wave completed.
+  Status Sync(std::function<Status()> sync);
+
+ private:
+  struct Request;
+
+  // Runs the syncs of 'wave' in parallel, and wakes up their requesters once
+  // they all completed.
+  void RunWave(std::vector<Request*> wave);
+
+  const MonoDelta window_;
+  const int max_threads_;
+
+  std::unique_ptr<ThreadPool> pool_;
+
+  simple_spinlock lock_;
+
+  // The requests collected for the next wave so far. The requests are owned
+  // by the threads waiting for them.
+  std::vector<Request*> pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogGroupSyncer);
+};
+
+} // namespace log
+} // namespace kudu
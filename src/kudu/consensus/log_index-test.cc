@@ -17,6 +17,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -36,6 +37,7 @@ namespace log {
 
 using consensus::MakeOpId;
 using consensus::OpId;
+using std::vector;
 
 class LogIndexTest : public KuduTest {
  public:
@@ -125,5 +127,47 @@ TEST_F(LogIndexTest, TestMultiSegmentWithGC) {
   VerifyNotFound(2500000);
 }
 
+// Test adding and retrieving runs of entries, including across a chunk
+// boundary and up to an entry which was never written.
+TEST_F(LogIndexTest, TestBatchedEntries) {
+  vector<LogIndexEntry> entries;
+  for (int64_t index = 999998; index <= 1000002; index++) {
+    LogIndexEntry entry;
+    entry.op_id = MakeOpId(2, index);
+    entry.segment_sequence_number = 3;
+    entry.offset_in_segment = 100 + (index - 999998) / 2;
+    entries.push_back(entry);
+  }
+  // A gap, then another run.
+  LogIndexEntry entry;
+  entry.op_id = MakeOpId(2, 1000005);
+  entry.segment_sequence_number = 4;
+  entry.offset_in_segment = 200;
+  entries.push_back(entry);
+  ASSERT_OK(index_->AddEntries(entries));
+
+  for (const auto& e : entries) {
+    VerifyEntry(e.op_id, e.segment_sequence_number, e.offset_in_segment);
+  }
+  VerifyNotFound(1000003);
+
+  vector<LogIndexEntry> result;
+  ASSERT_OK(index_->GetEntries(999998, 1000010, &result));
+  ASSERT_EQ(5, result.size());
+  for (int i = 0; i < result.size(); i++) {
+    EXPECT_EQ(entries[i].op_id.term(), result[i].op_id.term());
+    EXPECT_EQ(entries[i].op_id.index(), result[i].op_id.index());
+    EXPECT_EQ(entries[i].segment_sequence_number, result[i].segment_sequence_number);
+    EXPECT_EQ(entries[i].offset_in_segment, result[i].offset_in_segment);
+  }
+
+  ASSERT_OK(index_->GetEntries(1000005, 1000005, &result));
+  ASSERT_EQ(1, result.size());
+  EXPECT_EQ(200, result[0].offset_in_segment);
+
+  Status s = index_->GetEntries(1000003, 1000005, &result);
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+}
+
 } // namespace log
 } // namespace kudu
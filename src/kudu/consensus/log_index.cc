@@ -25,9 +25,17 @@
 //
 // When the log is GCed, we remove any index chunks which are no longer needed,
 // and close them.
+//
+// The entries of a batch of log entries have consecutive indexes, so they are
+// written with one write per chunk they fall in, and ranges of entries are read
+// with one read per chunk. The chunk files are sparse, so opening a chunk is
+// cheap: the next chunk is opened ahead of time when the entries being written
+// get close to the end of the current one, so that the append path rarely has
+// to create a file.
 
 #include "kudu/consensus/log_index.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <memory>
@@ -75,6 +83,10 @@ struct PhysicalEntry {
 static const int64_t kEntriesPerIndexChunk = 1000000;
 static const int64_t kChunkFileSize = kEntriesPerIndexChunk * sizeof(PhysicalEntry);
 
+// Once an entry this close to the end of its chunk is written, the next chunk
+// is opened.
+static const int64_t kOpenNextChunkAheadEntries = kEntriesPerIndexChunk / 10;
+
 ////////////////////////////////////////////////////////////
 // LogIndex::IndexChunk implementation
 ////////////////////////////////////////////////////////////
@@ -91,6 +103,11 @@ class LogIndex::IndexChunk : public RefCountedThreadSafe<LogIndex::IndexChunk> {
   Status GetEntry(int entry_index, PhysicalEntry* ret) const;
   Status SetEntry(int entry_index, const PhysicalEntry& entry);
 
+  // Read or write the 'num_entries' consecutive entries starting at
+  // 'entry_index' with a single I/O.
+  Status GetEntries(int entry_index, int num_entries, PhysicalEntry* ret) const;
+  Status SetEntries(int entry_index, int num_entries, const PhysicalEntry* entries);
+
  private:
   Env* env_;
   const string path_;
@@ -116,18 +133,30 @@ Status LogIndex::IndexChunk::Open(FileCache* file_cache) {
 }
 
 Status LogIndex::IndexChunk::GetEntry(int entry_index, PhysicalEntry* ret) const {
+  return GetEntries(entry_index, 1, ret);
+}
+
+Status LogIndex::IndexChunk::SetEntry(int entry_index, const PhysicalEntry& entry) {
+  return SetEntries(entry_index, 1, &entry);
+}
+
+Status LogIndex::IndexChunk::GetEntries(int entry_index, int num_entries,
+                                        PhysicalEntry* ret) const {
   DCHECK(file_) << "Must Open() first";
-  DCHECK_LT(entry_index, kEntriesPerIndexChunk);
+  DCHECK_GT(num_entries, 0);
+  DCHECK_LE(entry_index + num_entries, kEntriesPerIndexChunk);
 
-  Slice s(reinterpret_cast<const uint8_t*>(ret), sizeof(PhysicalEntry));
+  Slice s(reinterpret_cast<const uint8_t*>(ret), sizeof(PhysicalEntry) * num_entries);
   return file_->Read(sizeof(PhysicalEntry) * entry_index, s);
 }
 
-Status LogIndex::IndexChunk::SetEntry(int entry_index, const PhysicalEntry& entry) {
+Status LogIndex::IndexChunk::SetEntries(int entry_index, int num_entries,
+                                        const PhysicalEntry* entries) {
   DCHECK(file_) << "Must Open() first";
-  DCHECK_LT(entry_index, kEntriesPerIndexChunk);
+  DCHECK_GT(num_entries, 0);
+  DCHECK_LE(entry_index + num_entries, kEntriesPerIndexChunk);
 
-  Slice s(reinterpret_cast<const uint8_t*>(&entry), sizeof(PhysicalEntry));
+  Slice s(reinterpret_cast<const uint8_t*>(entries), sizeof(PhysicalEntry) * num_entries);
   return file_->Write(sizeof(PhysicalEntry) * entry_index, s);
 }
 
@@ -191,19 +220,63 @@ Status LogIndex::GetChunkForIndex(int64_t log_index, bool create,
 }
 
 Status LogIndex::AddEntry(const LogIndexEntry& entry) {
+  return AddEntriesInChunk(&entry, 1);
+}
+
+Status LogIndex::AddEntries(const vector<LogIndexEntry>& entries) {
+  size_t run_start = 0;
+  while (run_start < entries.size()) {
+    // Find the run of entries with consecutive indexes in the same chunk.
+    const int64_t first_index = entries[run_start].op_id.index();
+    const int64_t chunk_idx = first_index / kEntriesPerIndexChunk;
+    size_t run_end = run_start + 1;
+    while (run_end < entries.size()) {
+      const int64_t index = entries[run_end].op_id.index();
+      if (index != first_index + static_cast<int64_t>(run_end - run_start) ||
+          index / kEntriesPerIndexChunk != chunk_idx) {
+        break;
+      }
+      run_end++;
+    }
+    RETURN_NOT_OK(AddEntriesInChunk(&entries[run_start], run_end - run_start));
+    run_start = run_end;
+  }
+  return Status::OK();
+}
+
+Status LogIndex::AddEntriesInChunk(const LogIndexEntry* entries, int num_entries) {
+  DCHECK_GT(num_entries, 0);
+  const int64_t first_index = entries[0].op_id.index();
   scoped_refptr<IndexChunk> chunk;
-  RETURN_NOT_OK(GetChunkForIndex(entry.op_id.index(),
+  RETURN_NOT_OK(GetChunkForIndex(first_index,
                                  true /* create if not found */,
                                  &chunk));
-  int index_in_chunk = entry.op_id.index() % kEntriesPerIndexChunk;
+  int index_in_chunk = first_index % kEntriesPerIndexChunk;
+
+  vector<PhysicalEntry> phys(num_entries);
+  for (int i = 0; i < num_entries; i++) {
+    const LogIndexEntry& entry = entries[i];
+    DCHECK_EQ(first_index + i, entry.op_id.index());
+    phys[i].term = entry.op_id.term();
+    phys[i].segment_sequence_number = entry.segment_sequence_number;
+    phys[i].offset_in_segment = entry.offset_in_segment;
+  }
 
-  PhysicalEntry phys;
-  phys.term = entry.op_id.term();
-  phys.segment_sequence_number = entry.segment_sequence_number;
-  phys.offset_in_segment = entry.offset_in_segment;
+  RETURN_NOT_OK(chunk->SetEntries(index_in_chunk, num_entries, phys.data()));
+  if (VLOG_IS_ON(3)) {
+    for (int i = 0; i < num_entries; i++) {
+      VLOG(3) << "Added log index entry " << entries[i].ToString();
+    }
+  }
 
-  RETURN_NOT_OK(chunk->SetEntry(index_in_chunk, phys));
-  VLOG(3) << "Added log index entry " << entry.ToString();
+  // Open the next chunk before the log gets to it.
+  if (index_in_chunk + num_entries >= kEntriesPerIndexChunk - kOpenNextChunkAheadEntries) {
+    const int64_t next_chunk_idx = first_index / kEntriesPerIndexChunk + 1;
+    scoped_refptr<IndexChunk> next_chunk;
+    RETURN_NOT_OK(GetChunkForIndex(next_chunk_idx * kEntriesPerIndexChunk,
+                                   true /* create if not found */,
+                                   &next_chunk));
+  }
 
   return Status::OK();
 }
@@ -228,6 +301,45 @@ Status LogIndex::GetEntry(int64_t index, LogIndexEntry* entry) {
   return Status::OK();
 }
 
+Status LogIndex::GetEntries(int64_t first_index, int64_t last_index,
+                            vector<LogIndexEntry>* entries) {
+  DCHECK_LE(first_index, last_index);
+  entries->clear();
+  vector<PhysicalEntry> phys;
+  int64_t index = first_index;
+  while (index <= last_index) {
+    scoped_refptr<IndexChunk> chunk;
+    Status s = GetChunkForIndex(index, false /* do not create */, &chunk);
+    if (s.IsNotFound() && !entries->empty()) {
+      break;
+    }
+    RETURN_NOT_OK(s);
+
+    // Read the entries up to 'last_index' or the end of the chunk, whichever
+    // comes first.
+    const int index_in_chunk = index % kEntriesPerIndexChunk;
+    const int num_entries = std::min<int64_t>(last_index - index + 1,
+                                              kEntriesPerIndexChunk - index_in_chunk);
+    phys.resize(num_entries);
+    RETURN_NOT_OK(chunk->GetEntries(index_in_chunk, num_entries, phys.data()));
+    for (const auto& p : phys) {
+      // See GetEntry() for why this indicates an entry that was never written.
+      if (p.offset_in_segment == 0) {
+        if (entries->empty()) {
+          return Status::NotFound("entry not found");
+        }
+        return Status::OK();
+      }
+      LogIndexEntry entry;
+      entry.op_id = consensus::MakeOpId(p.term, index++);
+      entry.segment_sequence_number = p.segment_sequence_number;
+      entry.offset_in_segment = p.offset_in_segment;
+      entries->emplace_back(std::move(entry));
+    }
+  }
+  return Status::OK();
+}
+
 void LogIndex::GC(int64_t min_index_to_retain) {
   int min_chunk_to_retain = min_index_to_retain / kEntriesPerIndexChunk;
 
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/gutil/macros.h"
@@ -68,10 +69,21 @@ class LogIndex : public RefCountedThreadSafe<LogIndex> {
   // Record an index entry in the index.
   Status AddEntry(const LogIndexEntry& entry);
 
+  // Record the index entries of a batch of log entries in the index. Entries
+  // with consecutive indexes are written together.
+  Status AddEntries(const std::vector<LogIndexEntry>& entries);
+
   // Retrieve an existing entry from the index.
   // Returns NotFound() if the given log entry was never written.
   Status GetEntry(int64_t index, LogIndexEntry* entry);
 
+  // Retrieve the existing entries from 'first_index' to 'last_index', both
+  // inclusive, into 'entries', stopping before the first entry which was
+  // never written. Returns NotFound() if the entry for 'first_index' was
+  // never written.
+  Status GetEntries(int64_t first_index, int64_t last_index,
+                    std::vector<LogIndexEntry>* entries);
+
   // Indicate that we no longer need to retain information about indexes lower than the
   // given index. Note that the implementation is conservative and _may_ choose to retain
   // earlier entries.
@@ -93,6 +105,10 @@ class LogIndex : public RefCountedThreadSafe<LogIndex> {
   Status GetChunkForIndex(int64_t log_index, bool create,
                           scoped_refptr<IndexChunk>* chunk);
 
+  // Record the 'num_entries' entries at 'entries', which must have consecutive
+  // indexes within the same index chunk, with a single write.
+  Status AddEntriesInChunk(const LogIndexEntry* entries, int num_entries);
+
   // Return the path of the given index chunk.
   std::string GetChunkPath(int64_t chunk_idx);
 
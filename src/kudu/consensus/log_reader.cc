@@ -21,7 +21,9 @@
 #include <memory>
 #include <mutex>
 #include <ostream>
+#include <utility>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/consensus/consensus.pb.h"
@@ -35,6 +37,7 @@
 #include "kudu/gutil/strings/util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
@@ -55,10 +58,19 @@ METRIC_DEFINE_histogram(tablet, log_reader_read_batch_latency, "Log Read Latency
                         kudu::MetricLevel::kInfo,
                         60000000LU, 2);
 
+DEFINE_int64(log_max_coalesced_read_bytes, 8 * 1024 * 1024,
+             "Maximum size of the byte range of a WAL segment read at once when "
+             "reading several log entry batches for replication. Batches further "
+             "apart are read separately. Setting this to 0 reads each batch "
+             "separately.");
+TAG_FLAG(log_max_coalesced_read_bytes, advanced);
+TAG_FLAG(log_max_coalesced_read_bytes, runtime);
+
 using kudu::consensus::OpId;
 using kudu::consensus::ReplicateMsg;
 using kudu::pb_util::SecureDebugString;
 using kudu::pb_util::SecureShortDebugString;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -69,6 +81,12 @@ namespace kudu {
 namespace log {
 
 namespace {
+// The number of ops whose index entries ReadReplicatesInRange() looks up at
+// once: the window starts small, since the size limit is often reached after
+// a few ops, and doubles up to the maximum.
+const int64_t kMinReadWindowOps = 8;
+const int64_t kMaxReadWindowOps = 256;
+
 struct LogSegmentSeqnoComparator {
   bool operator() (const scoped_refptr<ReadableLogSegment>& a,
                    const scoped_refptr<ReadableLogSegment>& b) {
@@ -276,6 +294,82 @@ Status LogReader::ReadBatchUsingIndexEntry(const LogIndexEntry& index_entry,
   return Status::OK();
 }
 
+Status LogReader::ReadBatchesUsingIndexEntries(
+    const vector<LogIndexEntry>& index_entries,
+    faststring* tmp_buf,
+    vector<unique_ptr<LogEntryBatchPB>>* batches) const {
+  batches->clear();
+  batches->resize(index_entries.size());
+  size_t run_start = 0;
+  while (run_start < index_entries.size()) {
+    // Find the run of batches in the same segment which are close enough to
+    // be read at once.
+    const LogIndexEntry& first = index_entries[run_start];
+    size_t run_end = run_start + 1;
+    while (run_end < index_entries.size()) {
+      const LogIndexEntry& next = index_entries[run_end];
+      if (next.segment_sequence_number != first.segment_sequence_number ||
+          next.offset_in_segment <= index_entries[run_end - 1].offset_in_segment ||
+          next.offset_in_segment - first.offset_in_segment >
+              FLAGS_log_max_coalesced_read_bytes) {
+        break;
+      }
+      run_end++;
+    }
+
+    // Where the last batch of the run ends isn't known, so the batches before
+    // it are read at once, and it is read on its own.
+    const size_t last = run_end - 1;
+    if (last > run_start) {
+      const LogIndexEntry& last_entry = index_entries[last];
+      scoped_refptr<ReadableLogSegment> segment = GetSegmentBySequenceNumber(
+          first.segment_sequence_number);
+      if (PREDICT_FALSE(!segment)) {
+        return Status::NotFound(Substitute("Segment $0 which contained index $1 has been GCed",
+                                           first.segment_sequence_number,
+                                           first.op_id.index()));
+      }
+
+      vector<pair<int64_t, unique_ptr<LogEntryBatchPB>>> read_batches;
+      {
+        ScopedLatencyMetric scoped(read_batch_latency_.get());
+        RETURN_NOT_OK_PREPEND(segment->ReadEntryBatchesInRange(first.offset_in_segment,
+                                                               last_entry.offset_in_segment,
+                                                               tmp_buf, &read_batches),
+                              Substitute("Failed to read LogEntries for indexes $0-$1 from "
+                                         "log segment $2 offsets $3-$4",
+                                         first.op_id.index(),
+                                         last_entry.op_id.index(),
+                                         first.segment_sequence_number,
+                                         first.offset_in_segment,
+                                         last_entry.offset_in_segment));
+      }
+
+      // The range may also hold batches without REPLICATE messages, which
+      // aren't indexed.
+      size_t idx = run_start;
+      for (auto& read_batch : read_batches) {
+        if (bytes_read_) {
+          entries_read_->IncrementBy(read_batch.second->entry_size());
+        }
+        if (idx < last && read_batch.first == index_entries[idx].offset_in_segment) {
+          (*batches)[idx++] = std::move(read_batch.second);
+        }
+      }
+      if (bytes_read_) {
+        bytes_read_->IncrementBy(last_entry.offset_in_segment - first.offset_in_segment);
+      }
+      if (PREDICT_FALSE(idx != last)) {
+        return Status::Corruption(Substitute("Log index entry doesn't point to a batch: $0",
+                                             index_entries[idx].ToString()));
+      }
+    }
+    RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entries[last], tmp_buf, &(*batches)[last]));
+    run_start = run_end;
+  }
+  return Status::OK();
+}
+
 Status LogReader::ReadReplicatesInRange(int64_t starting_at,
                                         int64_t up_to,
                                         int64_t max_bytes_to_read,
@@ -286,67 +380,91 @@ Status LogReader::ReadReplicatesInRange(int64_t starting_at,
 
   vector<ReplicateMsg*> replicates_tmp;
   ElementDeleter d(&replicates_tmp);
-  LogIndexEntry prev_index_entry;
 
   int64_t total_size = 0;
   bool limit_exceeded = false;
   faststring tmp_buf;
-  unique_ptr<LogEntryBatchPB> batch;
-  for (int64_t index = starting_at; index <= up_to && !limit_exceeded; index++) {
-    LogIndexEntry index_entry;
-    RETURN_NOT_OK_PREPEND(log_index_->GetEntry(index, &index_entry),
+  vector<LogIndexEntry> index_entries;
+  vector<LogIndexEntry> batch_index_entries;
+  vector<unique_ptr<LogEntryBatchPB>> batches;
+  int64_t window_ops = kMinReadWindowOps;
+  int64_t index = starting_at;
+  while (index <= up_to && !limit_exceeded) {
+    // Look up the index entries of a window of ops at once.
+    const int64_t window_end = std::min(up_to, index + window_ops - 1);
+    window_ops = std::min(window_ops * 2, kMaxReadWindowOps);
+    RETURN_NOT_OK_PREPEND(log_index_->GetEntries(index, window_end, &index_entries),
                           Substitute("Failed to read log index for op $0", index));
 
     // Since a given LogEntryBatchPB may contain multiple REPLICATE messages,
-    // it's likely that this index entry points to the same batch as the previous
-    // one. If that's the case, we've already read this REPLICATE and we can
-    // skip reading the batch again.
-    if (index == starting_at ||
-        index_entry.segment_sequence_number != prev_index_entry.segment_sequence_number ||
-        index_entry.offset_in_segment != prev_index_entry.offset_in_segment) {
-      RETURN_NOT_OK(ReadBatchUsingIndexEntry(index_entry, &tmp_buf, &batch));
+    // it's likely that an index entry points to the same batch as the previous
+    // one. Each batch is read only once.
+    batch_index_entries.clear();
+    for (const LogIndexEntry& index_entry : index_entries) {
+      if (batch_index_entries.empty() ||
+          index_entry.segment_sequence_number !=
+              batch_index_entries.back().segment_sequence_number ||
+          index_entry.offset_in_segment != batch_index_entries.back().offset_in_segment) {
+        batch_index_entries.push_back(index_entry);
+      }
+    }
+    RETURN_NOT_OK(ReadBatchesUsingIndexEntries(batch_index_entries, &tmp_buf, &batches));
 
+    for (size_t b = 0; b < batches.size(); b++) {
       // Sanity-check the property that a batch should only have increasing indexes.
+      const LogEntryBatchPB& batch = *batches[b];
       int64_t prev_index = 0;
-      for (int i = 0; i < batch->entry_size(); ++i) {
-        LogEntryPB* entry = batch->mutable_entry(i);
-        if (!entry->has_replicate()) continue;
-        int64_t this_index = entry->replicate().id().index();
+      for (int i = 0; i < batch.entry_size(); ++i) {
+        const LogEntryPB& entry = batch.entry(i);
+        if (!entry.has_replicate()) continue;
+        int64_t this_index = entry.replicate().id().index();
         CHECK_GT(this_index, prev_index)
           << "Expected that an entry batch should only include increasing log indexes: "
-          << index_entry.ToString()
-          << "\nBatch: " << SecureDebugString(*batch);
+          << batch_index_entries[b].ToString()
+          << "\nBatch: " << SecureDebugString(batch);
         prev_index = this_index;
       }
     }
 
-    bool found = false;
-    for (int i = 0; i < batch->entry_size(); ++i) {
-      LogEntryPB* entry = batch->mutable_entry(i);
-      if (!entry->has_replicate()) {
-        continue;
+    size_t batch_idx = 0;
+    for (const LogIndexEntry& index_entry : index_entries) {
+      if (index_entry.segment_sequence_number !=
+              batch_index_entries[batch_idx].segment_sequence_number ||
+          index_entry.offset_in_segment != batch_index_entries[batch_idx].offset_in_segment) {
+        batch_idx++;
       }
+      LogEntryBatchPB* batch = batches[batch_idx].get();
 
-      if (entry->replicate().id().index() != index) {
-        continue;
+      bool found = false;
+      for (int i = 0; i < batch->entry_size(); ++i) {
+        LogEntryPB* entry = batch->mutable_entry(i);
+        if (!entry->has_replicate()) {
+          continue;
+        }
+
+        if (entry->replicate().id().index() != index) {
+          continue;
+        }
+
+        int64_t space_required = entry->replicate().SpaceUsed();
+        if (replicates_tmp.empty() ||
+            max_bytes_to_read <= 0 ||
+            total_size + space_required < max_bytes_to_read) {
+          total_size += space_required;
+          replicates_tmp.push_back(entry->release_replicate());
+        } else {
+          limit_exceeded = true;
+        }
+        found = true;
+        break;
       }
-
-      int64_t space_required = entry->replicate().SpaceUsed();
-      if (replicates_tmp.empty() ||
-          max_bytes_to_read <= 0 ||
-          total_size + space_required < max_bytes_to_read) {
-        total_size += space_required;
-        replicates_tmp.push_back(entry->release_replicate());
-      } else {
-        limit_exceeded = true;
+      CHECK(found) << "Incorrect index entry didn't yield expected log entry: "
+                   << index_entry.ToString();
+      if (limit_exceeded) {
+        break;
       }
-      found = true;
-      break;
+      index++;
     }
-    CHECK(found) << "Incorrect index entry didn't yield expected log entry: "
-                 << index_entry.ToString();
-
-    prev_index_entry = index_entry;
   }
 
   replicates->swap(replicates_tmp);
@@ -183,6 +183,14 @@ class LogReader : public enable_make_shared<LogReader> {
                                   faststring* tmp_buf,
                                   std::unique_ptr<LogEntryBatchPB>* batch) const;
 
+  // Read the LogEntryBatchPBs pointed to by the provided index entries, which
+  // must point to distinct batches in log order, into 'batches'. Batches which
+  // lie close together in a segment are read with a single read.
+  Status ReadBatchesUsingIndexEntries(
+      const std::vector<LogIndexEntry>& index_entries,
+      faststring* tmp_buf,
+      std::vector<std::unique_ptr<LogEntryBatchPB>>* batches) const;
+
   // Reads the headers of all segments in 'tablet_wal_path'.
   Status Init(const std::string& tablet_wal_path);
 
@@ -21,6 +21,7 @@
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -68,6 +69,7 @@ TAG_FLAG(fault_crash_before_write_log_segment_header, unsafe);
 DECLARE_bool(fs_wal_use_file_cache);
 
 using kudu::consensus::OpId;
+using std::pair;
 using std::string;
 using std::shared_ptr;
 using std::vector;
@@ -732,44 +734,119 @@ Status ReadableLogSegment::ReadEntryBatch(int64_t* offset,
   if (!s.ok()) return Status::IOError(Substitute("Could not read entry. Cause: $0",
                                                  s.ToString()));
 
+  // We pre-reserved space for the decompression up above.
+  uint8_t* uncompress_buf = codec_ ? &(*tmp_buf)[header.msg_length_compressed] : nullptr;
+  RETURN_NOT_OK(DecodeEntryBatch(*offset, header, entry_batch_slice, uncompress_buf,
+                                 entry_batch));
+  *offset += header.msg_length_compressed;
+  return Status::OK();
+}
+
+Status ReadableLogSegment::DecodeEntryBatch(int64_t offset,
+                                            const EntryHeader& header,
+                                            const Slice& data,
+                                            uint8_t* uncompress_buf,
+                                            unique_ptr<LogEntryBatchPB>* entry_batch) const {
+  DCHECK_EQ(header.msg_length_compressed, data.size());
+  Slice entry_batch_slice = data;
+
   // Verify the CRC.
   uint32_t read_crc = crc::Crc32c(entry_batch_slice.data(), entry_batch_slice.size());
   if (PREDICT_FALSE(read_crc != header.msg_crc)) {
     return Status::Corruption(Substitute("Entry CRC mismatch in byte range $0-$1: "
                                          "expected CRC=$2, computed=$3",
-                                         *offset, *offset + header.msg_length,
+                                         offset, offset + header.msg_length,
                                          header.msg_crc, read_crc));
   }
 
   // If it was compressed, decompress it.
   if (codec_) {
-    // We pre-reserved space for the decompression up above.
-    uint8_t* uncompress_buf = &(*tmp_buf)[header.msg_length_compressed];
+    DCHECK(uncompress_buf);
     RETURN_NOT_OK_PREPEND(codec_->Uncompress(entry_batch_slice, uncompress_buf, header.msg_length),
                           "failed to uncompress entry");
     entry_batch_slice = Slice(uncompress_buf, header.msg_length);
   }
 
   unique_ptr<LogEntryBatchPB> read_entry_batch(new LogEntryBatchPB);
-  s = pb_util::ParseFromArray(read_entry_batch.get(),
-                              entry_batch_slice.data(),
-                              header.msg_length);
+  Status s = pb_util::ParseFromArray(read_entry_batch.get(),
+                                     entry_batch_slice.data(),
+                                     header.msg_length);
 
   if (!s.ok()) {
     return Status::Corruption(Substitute("Could not parse PB. Cause: $0", s.ToString()));
   }
 
-  *offset += header.msg_length_compressed;
   entry_batch->reset(read_entry_batch.release());
   return Status::OK();
 }
 
+Status ReadableLogSegment::ReadEntryBatchesInRange(
+    int64_t offset, int64_t end_offset, faststring* tmp_buf,
+    vector<pair<int64_t, unique_ptr<LogEntryBatchPB>>>* batches) const {
+  TRACE_EVENT2("log", "ReadableLogSegment::ReadEntryBatchesInRange",
+               "path", path_,
+               "range", Substitute("offset=$0 end_offset=$1", offset, end_offset));
+  DCHECK_LT(offset, end_offset);
+
+  int64_t limit = readable_up_to();
+  if (PREDICT_FALSE(end_offset > limit)) {
+    return Status::Corruption(
+        Substitute("Could not read log entries in byte range $0-$1 in $2: "
+                   "log only readable up to offset $3",
+                   offset, end_offset, path_, limit));
+  }
+
+  tmp_buf->clear();
+  tmp_buf->resize(end_offset - offset);
+  Slice data(tmp_buf->data(), tmp_buf->size());
+  Status s = file_->Read(offset, data);
+  if (!s.ok()) return Status::IOError(Substitute("Could not read entries. Cause: $0",
+                                                 s.ToString()));
+
+  faststring uncompress_buf;
+  const size_t header_size = entry_header_size();
+  int64_t cur_offset = offset;
+  while (cur_offset < end_offset) {
+    const uint8_t* entry_data = data.data() + (cur_offset - offset);
+    const int64_t remaining = end_offset - cur_offset;
+    EntryHeader header;
+    if (PREDICT_FALSE(remaining < static_cast<int64_t>(header_size) ||
+                      DecodeEntryHeader(Slice(entry_data, header_size), &header) !=
+                      EntryHeaderStatus::OK)) {
+      return Status::Corruption(Substitute("Could not decode log entry header at offset $0 in $1",
+                                           cur_offset, path_));
+    }
+    if (header.msg_length == 0) {
+      return Status::Corruption("Invalid 0 entry length");
+    }
+    if (PREDICT_FALSE(static_cast<int64_t>(header_size + header.msg_length_compressed) >
+                      remaining)) {
+      return Status::Corruption(
+          Substitute("$0-byte log entry at offset $1 in $2 extends past offset $3",
+                     header.msg_length_compressed, cur_offset, path_, end_offset));
+    }
+    if (codec_) {
+      uncompress_buf.resize(header.msg_length);
+    }
+    unique_ptr<LogEntryBatchPB> batch;
+    RETURN_NOT_OK(DecodeEntryBatch(cur_offset + header_size, header,
+                                   Slice(entry_data + header_size,
+                                         header.msg_length_compressed),
+                                   codec_ ? uncompress_buf.data() : nullptr,
+                                   &batch));
+    batches->emplace_back(cur_offset, std::move(batch));
+    cur_offset += header_size + header.msg_length_compressed;
+  }
+  return Status::OK();
+}
+
 WritableLogSegment::WritableLogSegment(string path,
                                        shared_ptr<RWFile> file)
     : path_(std::move(path)),
       file_(std::move(file)),
       is_header_written_(false),
       is_footer_written_(false),
+      needs_sync_(false),
       written_offset_(0) {}
 
 Status WritableLogSegment::WriteHeader(const LogSegmentHeaderPB& new_header) {
@@ -792,6 +869,7 @@ Status WritableLogSegment::WriteHeader(const LogSegmentHeaderPB& new_header) {
   first_entry_offset_ = buf.size();
   written_offset_ = first_entry_offset_;
   is_header_written_ = true;
+  needs_sync_ = true;
 
   return Status::OK();
 }
@@ -813,12 +891,14 @@ Status WritableLogSegment::WriteFooter(const LogSegmentFooterPB& footer) {
   footer_.CopyFrom(footer);
   written_offset_ += buf.size();
   is_footer_written_ = true;
+  needs_sync_ = true;
 
   return Status::OK();
 }
 
 Status WritableLogSegment::WriteEntryBatch(const Slice& data,
-                                           const CompressionCodec* codec) {
+                                           const CompressionCodec* codec,
+                                           bool sync) {
   DCHECK(is_header_written_);
   DCHECK(!is_footer_written_);
   uint8_t header_buf[kEntryHeaderSizeV2];
@@ -848,7 +928,14 @@ Status WritableLogSegment::WriteEntryBatch(const Slice& data,
   Slice slices[2] = {
     Slice(header_buf, arraysize(header_buf)),
     data_to_write };
-  RETURN_NOT_OK(file_->WriteV(written_offset_, slices));
+  if (sync && !needs_sync_) {
+    // Nothing else is pending, so syncing this write makes the whole segment
+    // durable.
+    RETURN_NOT_OK(file_->WriteVAndSync(written_offset_, slices));
+  } else {
+    RETURN_NOT_OK(file_->WriteV(written_offset_, slices));
+    needs_sync_ = true;
+  }
   written_offset_ += arraysize(header_buf) + data_to_write.size();
   return Status::OK();
 }
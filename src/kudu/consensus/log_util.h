@@ -21,6 +21,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <gflags/gflags_declare.h>
@@ -346,6 +347,14 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
                                  std::unique_ptr<LogEntryBatchPB>* batch,
                                  EntryHeaderStatus* status_detail) const;
 
+  // Reads all the entry batches in the byte range ['offset', 'end_offset') of
+  // the segment with a single read, appending them along with their offsets to
+  // 'batches'. 'offset' must be where a batch starts, and 'end_offset' where a
+  // batch ends. 'tmp_buf' is used as scratch space.
+  Status ReadEntryBatchesInRange(
+      int64_t offset, int64_t end_offset, faststring* tmp_buf,
+      std::vector<std::pair<int64_t, std::unique_ptr<LogEntryBatchPB>>>* batches) const;
+
   // Reads a log entry header from the segment.
   //
   // Also increments the passed offset* by the length of the entry on successful
@@ -368,6 +377,15 @@ class ReadableLogSegment : public RefCountedThreadSafe<ReadableLogSegment> {
                         faststring* tmp_buf,
                         std::unique_ptr<LogEntryBatchPB>* entry_batch) const;
 
+  // Verifies and decodes the log entry batch at 'offset' described by 'header'
+  // from 'data', which holds its 'msg_length_compressed' bytes. If the segment
+  // is compressed, 'uncompress_buf' must have room for 'msg_length' bytes.
+  Status DecodeEntryBatch(int64_t offset,
+                          const EntryHeader& header,
+                          const Slice& data,
+                          uint8_t* uncompress_buf,
+                          std::unique_ptr<LogEntryBatchPB>* entry_batch) const;
+
   void UpdateReadableToOffset(int64_t readable_to_offset);
 
   const std::string path_;
@@ -426,11 +444,22 @@ class WritableLogSegment {
   // and checksum. If 'codec' is not NULL, compresses the batch.
   // Makes sure that the log segment has not been closed.
   // Write a compressed entry to the log.
-  Status WriteEntryBatch(const Slice& data, const CompressionCodec* codec);
+  //
+  // If 'sync' is true, the batch is made durable along with the write, using a
+  // single system call where the platform allows it; the segment then needs no
+  // further Sync() unless something else was written since.
+  Status WriteEntryBatch(const Slice& data, const CompressionCodec* codec,
+                         bool sync = false);
 
   // Makes sure the I/O buffers belonging to the underlying file handle are flushed.
+  // Does nothing if everything written so far is already durable.
   Status Sync() {
-    return file_->Sync();
+    if (!needs_sync_) {
+      return Status::OK();
+    }
+    RETURN_NOT_OK(file_->Sync());
+    needs_sync_ = false;
+    return Status::OK();
   }
 
   // Indicate that the segment has not been written for some period of time.
@@ -486,6 +515,9 @@ class WritableLogSegment {
 
   bool is_footer_written_;
 
+  // Whether anything was written since the segment was last synced.
+  bool needs_sync_;
+
   LogSegmentHeaderPB header_;
 
   LogSegmentFooterPB footer_;
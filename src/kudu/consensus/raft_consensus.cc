@@ -84,6 +84,30 @@ DEFINE_double(leader_failure_max_missed_heartbeat_periods, 3.0,
              "The value passed to this flag may be fractional.");
 TAG_FLAG(leader_failure_max_missed_heartbeat_periods, advanced);
 
+DEFINE_int32(raft_quiesce_after_idle_secs, 0,
+             "If positive, a leader which hasn't sent any operations to a follower "
+             "for this many seconds heartbeats that follower only every "
+             "--raft_quiescent_heartbeat_interval_ms, and the follower waits "
+             "correspondingly longer before it considers the leader to have failed. "
+             "Saves the CPU spent on heartbeating idle tablets, at the cost of "
+             "detecting the failure of their leaders later, and of followers "
+             "advancing their safe time less often.");
+TAG_FLAG(raft_quiesce_after_idle_secs, experimental);
+
+DEFINE_int32(raft_quiescent_heartbeat_interval_ms, 10000,
+             "The heartbeat interval for Raft replication of idle tablets. "
+             "See --raft_quiesce_after_idle_secs.");
+TAG_FLAG(raft_quiescent_heartbeat_interval_ms, experimental);
+
+DEFINE_int32(raft_safe_time_heartbeat_interval_ms, 0,
+             "If positive, a follower on which reads have waited for safe time to "
+             "advance within the last few seconds asks its leader to heartbeat it "
+             "every this many milliseconds rather than every "
+             "--raft_heartbeat_interval_ms, so that its safe time advances sooner. "
+             "Makes snapshot scans on followers wait less, at the cost of more "
+             "heartbeats for the tablets which such scans read.");
+TAG_FLAG(raft_safe_time_heartbeat_interval_ms, experimental);
+
 DEFINE_int32(leader_failure_exp_backoff_max_delta_ms, 20 * 1000,
              "Maximum time to sleep in between leader election retries, in addition to the "
              "regular timeout. When leader election fails the interval in between retries "
@@ -159,6 +183,13 @@ METRIC_DEFINE_gauge_int64(tablet, time_since_last_leader_heartbeat,
                           "The time elapsed since the last heartbeat from the leader "
                           "in milliseconds. This metric is identically zero on a leader replica.",
                           kudu::MetricLevel::kDebug);
+METRIC_DEFINE_histogram(tablet, follower_durable_wait_latency,
+                        "Follower Durable Wait Latency",
+                        kudu::MetricUnit::kMicroseconds,
+                        "Microseconds a follower spends waiting for the operations it received "
+                        "from the leader to be durable in its WAL before acking them.",
+                        kudu::MetricLevel::kDebug,
+                        60000000LU, 2);
 
 
 using boost::optional;
@@ -241,6 +272,8 @@ Status RaftConsensus::Start(const ConsensusBootstrapInfo& info,
                                                   MergeType::kMax);
   follower_memory_pressure_rejections_ =
       metric_entity->FindOrCreateCounter(&METRIC_follower_memory_pressure_rejections);
+  follower_durable_wait_latency_ =
+      METRIC_follower_durable_wait_latency.Instantiate(metric_entity);
 
   num_failed_elections_metric_ =
       metric_entity->FindOrCreateGauge(&METRIC_failed_elections_since_stable_leader,
@@ -1441,8 +1474,17 @@ Status RaftConsensus::UpdateReplica(const ConsensusRequestPB* request,
     //   * prohibit voting for anyone for the minimum election timeout
     // We are guaranteed to be acting as a FOLLOWER at this point by the above
     // sanity check.
-    SnoozeFailureDetector();
-    WithholdVotes();
+    if (request->has_quiescent_heartbeat_interval_ms()) {
+      // The leader won't heartbeat again for a while.
+      const MonoDelta timeout = MonoDelta::FromMilliseconds(static_cast<int64_t>(
+          FLAGS_leader_failure_max_missed_heartbeat_periods *
+          request->quiescent_heartbeat_interval_ms()));
+      SnoozeFailureDetector(/*reason_for_log=*/boost::none, timeout);
+      WithholdVotes(timeout);
+    } else {
+      SnoozeFailureDetector();
+      WithholdVotes();
+    }
 
     last_leader_communication_time_micros_ = GetMonoTimeMicros();
 
@@ -1613,6 +1655,7 @@ Status RaftConsensus::UpdateReplica(const ConsensusRequestPB* request,
     // request at a time and this way we can allow commits to proceed while we wait.
     TRACE("Waiting on the replicates to finish logging");
     TRACE_EVENT0("consensus", "Wait for log");
+    const MonoTime wait_start = MonoTime::Now();
     Status s;
     do {
       s = log_synchronizer.WaitFor(
@@ -1627,6 +1670,8 @@ Status RaftConsensus::UpdateReplica(const ConsensusRequestPB* request,
       }
     } while (s.IsTimedOut());
     RETURN_NOT_OK(s);
+    follower_durable_wait_latency_->Increment(
+        (MonoTime::Now() - wait_start).ToMicroseconds());
 
     TRACE("finished");
   }
@@ -1651,6 +1696,13 @@ void RaftConsensus::FillConsensusResponseOKUnlocked(ConsensusResponsePB* respons
   if (PREDICT_TRUE(server_ctx_.quiescing) && server_ctx_.quiescing->load()) {
     response->set_server_quiescing(true);
   }
+  // How long after a read waited for safe time the leader is asked to keep
+  // sending safe time more often.
+  const MonoDelta kSafeTimeRequestWindow = MonoDelta::FromSeconds(5);
+  if (FLAGS_raft_safe_time_heartbeat_interval_ms > 0 &&
+      time_manager_->HasWaitedForSafeTimeSince(MonoTime::Now() - kSafeTimeRequestWindow)) {
+    response->set_safe_time_requested(true);
+  }
 }
 
 void RaftConsensus::FillConsensusResponseError(ConsensusResponsePB* response,
@@ -2926,16 +2978,19 @@ void RaftConsensus::SnoozeFailureDetector(boost::optional<string> reason_for_log
   }
 }
 
-void RaftConsensus::WithholdVotes() {
+void RaftConsensus::WithholdVotes(boost::optional<MonoDelta> delta) {
+  if (!delta) {
+    delta = MinimumElectionTimeout();
+  }
   MonoTime prev = withhold_votes_until_;
-  MonoTime next = MonoTime::Now() + MinimumElectionTimeout();
+  MonoTime next = MonoTime::Now() + *delta;
   do {
     if (prev == MonoTime::Max()) {
       // Maximum withholding time already. It might be the case if replica
       // has become a leader already.
       break;
     }
-    next = MonoTime::Now() + MinimumElectionTimeout();
+    next = MonoTime::Now() + *delta;
   } while (!withhold_votes_until_.compare_exchange_weak(prev, next));
 }
 
@@ -679,11 +679,12 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   void SnoozeFailureDetector(boost::optional<std::string> reason_for_log = boost::none,
                              boost::optional<MonoDelta> delta = boost::none);
 
-  // Update the voting withhold interval, bumping it up for the minimum
-  // election timeout interval, i.e. 'FLAGS_raft_heartbeat_interval_ms' *
+  // Update the voting withhold interval, bumping it up for 'delta', or if not
+  // specified, for the minimum election timeout interval, i.e.
+  // 'FLAGS_raft_heartbeat_interval_ms' *
   // 'FLAGS_leader_failure_max_missed_heartbeat_periods' milliseconds.
   // This method is safe to call even it's a leader replica.
-  void WithholdVotes();
+  void WithholdVotes(boost::optional<MonoDelta> delta = boost::none);
 
   // Calculates a snooze delta for leader election.
   //
@@ -922,6 +923,7 @@ class RaftConsensus : public std::enable_shared_from_this<RaftConsensus>,
   std::atomic<int64_t> last_leader_communication_time_micros_;
 
   scoped_refptr<Counter> follower_memory_pressure_rejections_;
+  scoped_refptr<Histogram> follower_durable_wait_latency_;
   scoped_refptr<AtomicGauge<int64_t>> term_metric_;
   scoped_refptr<AtomicGauge<int64_t>> num_failed_elections_metric_;
 
@@ -16,8 +16,16 @@
 // under the License.
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/slice.h"
 
 namespace kudu {
 namespace consensus {
@@ -25,14 +33,39 @@ namespace consensus {
 // A simple ref-counted wrapper around ReplicateMsg.
 class RefCountedReplicate : public RefCountedThreadSafe<RefCountedReplicate> {
  public:
-  explicit RefCountedReplicate(ReplicateMsg* msg) : msg_(msg) {}
+  explicit RefCountedReplicate(ReplicateMsg* msg) : msg_(msg), serialized_size_(0) {}
 
   ReplicateMsg* get() {
     return msg_.get();
   }
 
+  // Returns the message serialized and prefixed with its varint32-encoded
+  // length. The message is serialized once, when this is first called, so it
+  // must not be modified afterwards. Thread-safe.
+  Slice SerializedWithLength() {
+    std::call_once(serialize_once_, [this]() {
+      const size_t size = msg_->ByteSizeLong();
+      PutVarint32(&serialized_, size);
+      const size_t prefix_size = serialized_.size();
+      serialized_.resize(prefix_size + size);
+      msg_->SerializeWithCachedSizesToArray(serialized_.data() + prefix_size);
+      serialized_size_ = serialized_.size();
+    });
+    return Slice(serialized_);
+  }
+
+  // Returns the size of the buffer returned by SerializedWithLength(), or 0 if
+  // it hasn't been called yet.
+  size_t serialized_size() const {
+    return serialized_size_;
+  }
+
  private:
   std::unique_ptr<ReplicateMsg> msg_;
+
+  std::once_flag serialize_once_;
+  faststring serialized_;
+  std::atomic<size_t> serialized_size_;
 };
 
 typedef scoped_refptr<RefCountedReplicate> ReplicateRefPtr;
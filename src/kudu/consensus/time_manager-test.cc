@@ -116,8 +116,11 @@ TEST_F(TimeManagerTest, TestTimeManagerNonLeaderMode) {
   ASSERT_EQ(time_manager_->GetSafeTime(), init);
 
   // Waiting for safe time at this point should time out since we're not moving it.
+  MonoTime before_wait = MonoTime::Now();
+  ASSERT_FALSE(time_manager_->HasWaitedForSafeTimeSince(before_wait));
   MonoTime after_small = MonoTime::Now() + MonoDelta::FromMilliseconds(100);
   ASSERT_TRUE(time_manager_->WaitUntilSafe(after, after_small).IsTimedOut());
+  ASSERT_TRUE(time_manager_->HasWaitedForSafeTimeSince(before_wait));
 
   // Create a latch to wait on 'after' to be safe.
   CountDownLatch* after_latch = WaitForSafeTimeAsync(after);
@@ -157,8 +160,12 @@ TEST_F(TimeManagerTest, TestTimeManagerNonLeaderMode) {
 TEST_F(TimeManagerTest, TestTimeManagerLeaderMode) {
   Timestamp init = clock_.Now();
   InitTimeManager(init);
+  Timestamp leader_start;
+  ASSERT_FALSE(time_manager_->GetLeaderModeStartTimestamp(&leader_start));
   time_manager_->SetLeaderMode();
   Timestamp safe_before = time_manager_->GetSafeTime();
+  ASSERT_TRUE(time_manager_->GetLeaderModeStartTimestamp(&leader_start));
+  ASSERT_GT(leader_start, init);
 
   ReplicateMsg message;
   // In leader mode we should be able to assign timestamps and the timestamp should be higher
@@ -83,7 +83,8 @@ TimeManager::TimeManager(Clock* clock, Timestamp initial_safe_time)
 void TimeManager::SetLeaderMode() {
   Lock l(lock_);
   mode_ = LEADER;
-  AdvanceSafeTimeAndWakeUpWaitersUnlocked(clock_->Now());
+  leader_mode_start_ts_ = clock_->Now();
+  AdvanceSafeTimeAndWakeUpWaitersUnlocked(leader_mode_start_ts_);
 }
 
 void TimeManager::SetNonLeaderMode() {
@@ -91,6 +92,15 @@ void TimeManager::SetNonLeaderMode() {
   mode_ = NON_LEADER;
 }
 
+bool TimeManager::GetLeaderModeStartTimestamp(Timestamp* timestamp) {
+  Lock l(lock_);
+  if (mode_ != LEADER) {
+    return false;
+  }
+  *timestamp = leader_mode_start_ts_;
+  return true;
+}
+
 Status TimeManager::AssignTimestamp(ReplicateMsg* message) {
   Lock l(lock_);
   if (PREDICT_FALSE(mode_ == NON_LEADER)) {
@@ -199,6 +209,11 @@ void TimeManager::MakeWaiterTimeoutMessageUnlocked(Timestamp timestamp, string*
                               mode, clock_->Stringify(last_safe_ts_), clock_diff);
 }
 
+bool TimeManager::HasWaitedForSafeTimeSince(const MonoTime& time) {
+  Lock l(lock_);
+  return last_waited_time_.Initialized() && last_waited_time_ >= time;
+}
+
 Status TimeManager::WaitUntilSafe(Timestamp timestamp, const MonoTime& deadline) {
   string error_message;
 
@@ -238,6 +253,7 @@ Status TimeManager::WaitUntilSafe(Timestamp timestamp, const MonoTime& deadline)
     Lock l(lock_);
     if (IsTimestampSafeUnlocked(timestamp)) return Status::OK();
     waiters_.push_back(&waiter);
+    last_waited_time_ = MonoTime::Now();
   }
 
   // Wait until we get notified or 'deadline' elapses.
@@ -122,6 +122,10 @@ class TimeManager {
   // Returns Status::ServiceUnavailable() is the request should be retried somewhere else.
   Status WaitUntilSafe(Timestamp timestamp, const MonoTime& deadline);
 
+  // Returns whether any call to WaitUntilSafe() has had to wait for safe time
+  // to advance since 'time'.
+  bool HasWaitedForSafeTimeSince(const MonoTime& time);
+
   // Returns the current safe time.
   //
   // In leader mode returns clock_->Now() or some value close to it.
@@ -134,6 +138,12 @@ class TimeManager {
   // replica).
   Timestamp GetSerialTimestamp();
 
+  // If in leader mode, sets 'timestamp' to the time at which this TimeManager
+  // entered leader mode and returns true. That timestamp is higher than those
+  // of all the messages received from previous leaders. Returns false in
+  // non-leader mode.
+  bool GetLeaderModeStartTimestamp(Timestamp* timestamp);
+
  private:
   FRIEND_TEST(TimeManagerTest, TestTimeManagerNonLeaderMode);
   FRIEND_TEST(TimeManagerTest, TestTimeManagerLeaderMode);
@@ -206,9 +216,15 @@ class TimeManager {
   // Used in the decision of whether we should have waiters wait or try again.
   MonoTime last_advanced_safe_time_;
 
+  // The last time a caller of WaitUntilSafe() had to wait.
+  MonoTime last_waited_time_;
+
   // The current mode of the TimeManager.
   Mode mode_;
 
+  // The time at which this TimeManager last entered leader mode.
+  Timestamp leader_mode_start_ts_;
+
   clock::Clock* clock_;
   const std::string local_peer_uuid_;
 };
@@ -163,6 +163,17 @@ class ReadableBlock : public Block {
   // If an error was encountered, returns a non-OK status.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Waits until a read of 'bytes' bytes from the block on behalf of a
+  // background operation fits within the rate limit of background reads of
+  // the block's directory. Should be called before such reads so that they
+  // yield the disk to foreground reads.
+  virtual void ThrottleBackgroundRead(size_t /*bytes*/) const {}
+
+  // Hints that 'length' bytes of the block beginning at 'offset' will be read
+  // soon, so that they can be read from disk in the background. The range is
+  // clipped to the block.
+  virtual void ReadAhead(uint64_t /*offset*/, size_t /*length*/) const {}
+
   // Returns the memory usage of this object including the object itself.
   virtual size_t memory_footprint() const = 0;
 };
@@ -45,6 +45,7 @@
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
@@ -65,8 +66,10 @@ DECLARE_int32(fs_data_dirs_available_space_cache_seconds);
 DECLARE_int32(fs_target_data_dirs_per_tablet);
 DECLARE_int64(disk_reserved_bytes_free_for_testing);
 DECLARE_int64(fs_data_dirs_reserved_bytes);
+DECLARE_int64(fs_data_dirs_write_bytes_per_sec);
 DECLARE_string(env_inject_eio_globs);
 DECLARE_string(env_inject_full_globs);
+DECLARE_string(fs_cold_data_dirs);
 
 METRIC_DECLARE_gauge_uint64(data_dirs_failed);
 
@@ -454,6 +457,70 @@ TEST_F(DataDirsTest, TestLoadBalancingBias) {
   ASSERT_TRUE(some_added_to_skewed_dirs);
 }
 
+// Test that IO of a rate limited class is throttled to the rate limit of its
+// directory, and that IO of other classes isn't.
+TEST_F(DataDirsTest, TestThrottleIO) {
+  // Rate limits are set as directories are opened.
+  FLAGS_fs_data_dirs_write_bytes_per_sec = 1024 * 1024;
+  dd_manager_.reset();
+  DataDirManagerOptions opts;
+  opts.metric_entity = entity_;
+  ASSERT_OK(DataDirManager::OpenExistingForTests(
+      env_, GetDirNames(kNumDirs), opts, &dd_manager_));
+  Dir* dir = dd_manager_->dirs()[0].get();
+
+  // Background reads aren't rate limited.
+  MonoTime start = MonoTime::Now();
+  dir->ThrottleIO(Dir::IOClass::BACKGROUND_READ, 10 * 1024 * 1024);
+  ASSERT_LT(MonoTime::Now() - start, MonoDelta::FromSeconds(1));
+
+  // Writing 500KB at 1MB/s takes at least 400ms, since the first 100KB may be
+  // written right away.
+  start = MonoTime::Now();
+  dir->ThrottleIO(Dir::IOClass::WRITE, 500 * 1024);
+  ASSERT_GE(MonoTime::Now() - start, MonoDelta::FromMilliseconds(350));
+
+  // Other directories have their own rate limits.
+  start = MonoTime::Now();
+  dd_manager_->dirs()[1]->ThrottleIO(Dir::IOClass::WRITE, 100 * 1024);
+  ASSERT_LT(MonoTime::Now() - start, MonoDelta::FromMilliseconds(350));
+}
+
+// Test that blocks of cold tablets are placed in the cold directories of their
+// groups, and blocks of other tablets in the rest.
+TEST_F(DataDirsTest, TestColdTabletPlacement) {
+  // Directories are marked cold as they're opened.
+  const vector<string> dirs = GetDirNames(kNumDirs);
+  FLAGS_fs_cold_data_dirs = JoinStrings(
+      vector<string>(dirs.begin(), dirs.begin() + kNumDirs / 2), ",");
+  FLAGS_fs_target_data_dirs_per_tablet = 0;
+  dd_manager_.reset();
+  DataDirManagerOptions opts;
+  opts.metric_entity = entity_;
+  ASSERT_OK(DataDirManager::OpenExistingForTests(env_, dirs, opts, &dd_manager_));
+  int num_cold_dirs = 0;
+  for (const auto& dd : dd_manager_->dirs()) {
+    if (down_cast<DataDir*>(dd.get())->is_cold()) {
+      num_cold_dirs++;
+    }
+  }
+  ASSERT_EQ(kNumDirs / 2, num_cold_dirs);
+
+  ASSERT_OK(dd_manager_->CreateDataDirGroup(test_tablet_name_));
+  const auto check_placement = [&] (bool cold) {
+    for (int i = 0; i < 20; i++) {
+      Dir* dd;
+      ASSERT_OK(dd_manager_->GetDirAddIfNecessary(test_block_opts_, &dd));
+      ASSERT_EQ(cold, down_cast<DataDir*>(dd)->is_cold());
+    }
+  };
+  NO_FATALS(check_placement(false));
+  dd_manager_->SetTabletCold(test_tablet_name_, true);
+  NO_FATALS(check_placement(true));
+  dd_manager_->SetTabletCold(test_tablet_name_, false);
+  NO_FATALS(check_placement(false));
+}
+
 class DataDirManagerTest : public DataDirsTest {
  public:
   void SetUp() override {
@@ -41,17 +41,24 @@
 #include "kudu/fs/fs.pb.h"
 #include "kudu/gutil/integral_types.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_util_prod.h"
 #include "kudu/util/threadpool.h"
+#include "kudu/util/throttler.h"
+#include "kudu/util/trace.h"
 
 DEFINE_int32(fs_target_data_dirs_per_tablet, 3,
              "Indicates the target number of data dirs to spread each "
@@ -97,6 +104,35 @@ DEFINE_uint64(fs_max_thread_count_per_data_dir, 8,
               "Maximum work thread per data directory.");
 TAG_FLAG(fs_max_thread_count_per_data_dir, advanced);
 
+DEFINE_int64(fs_data_dirs_background_read_bytes_per_sec, 0,
+             "Maximum rate (byte/s) at which background operations, e.g. flushes "
+             "and compactions, may read from each data directory, leaving the rest "
+             "of the disk's bandwidth to scans. 0 means no limit.");
+TAG_FLAG(fs_data_dirs_background_read_bytes_per_sec, experimental);
+
+DEFINE_int64(fs_data_dirs_write_bytes_per_sec, 0,
+             "Maximum rate (byte/s) at which blocks may be written to each data "
+             "directory. Blocks are only written by background operations, e.g. "
+             "flushes, compactions and tablet copies. 0 means no limit.");
+TAG_FLAG(fs_data_dirs_write_bytes_per_sec, experimental);
+
+DEFINE_int64(fs_data_dirs_hole_punches_per_sec, 0,
+             "Maximum rate at which the space of deleted blocks may be freed by "
+             "punching holes in the files of each data directory, so that "
+             "deleting a large tablet doesn't monopolize the disk. Rates below "
+             "10 are raised to 10. 0 means no limit.");
+TAG_FLAG(fs_data_dirs_hole_punches_per_sec, experimental);
+
+DEFINE_string(fs_cold_data_dirs, "",
+              "Comma-separated list of the data directories, out of --fs_data_dirs "
+              "and --fs_wal_dir, which are on slower media. Blocks of tablets that "
+              "haven't been accessed for --tablet_cold_after_inactive_sec are placed "
+              "in these directories, and blocks of all other tablets in the rest. "
+              "A tablet's directory group must include directories of both kinds "
+              "for this to have an effect; consider raising "
+              "--fs_target_data_dirs_per_tablet accordingly.");
+TAG_FLAG(fs_cold_data_dirs, experimental);
+
 METRIC_DEFINE_gauge_uint64(server, data_dirs_failed,
                            "Data Directories Failed",
                            kudu::MetricUnit::kDataDirectories,
@@ -187,10 +223,49 @@ Status DataDirGroup::CopyToPB(const UuidByUuidIndexMap& uuid_by_uuid_idx,
 // DataDir
 ////////////////////////////////////////////////////////////
 
+namespace {
+
+// Returns whether 'dir' is within one of the roots in --fs_cold_data_dirs.
+bool IsInColdRoot(Env* env, const string& dir) {
+  if (FLAGS_fs_cold_data_dirs.empty()) {
+    return false;
+  }
+  const string root = DirName(dir);
+  const vector<string> cold_roots = strings::Split(FLAGS_fs_cold_data_dirs, ",",
+                                                   strings::SkipEmpty());
+  for (const auto& cold_root : cold_roots) {
+    string canonicalized;
+    if (!env->Canonicalize(cold_root, &canonicalized).ok()) {
+      canonicalized = cold_root;
+    }
+    if (canonicalized == root) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // anonymous namespace
+
 DataDir::DataDir(Env* env, DirMetrics* metrics, FsType fs_type, std::string dir,
                  std::unique_ptr<DirInstanceMetadataFile> metadata_file,
                  std::unique_ptr<ThreadPool> pool)
-    : Dir(env, metrics, fs_type, std::move(dir), std::move(metadata_file), std::move(pool)) {}
+    : Dir(env, metrics, fs_type, std::move(dir), std::move(metadata_file), std::move(pool)),
+      is_cold_(IsInColdRoot(env, this->dir())) {
+  if (FLAGS_fs_data_dirs_background_read_bytes_per_sec > 0) {
+    background_read_throttler_.reset(new Throttler(
+        MonoTime::Now(), 0, FLAGS_fs_data_dirs_background_read_bytes_per_sec, 1.0));
+  }
+  if (FLAGS_fs_data_dirs_write_bytes_per_sec > 0) {
+    write_throttler_.reset(new Throttler(
+        MonoTime::Now(), 0, FLAGS_fs_data_dirs_write_bytes_per_sec, 1.0));
+  }
+  if (FLAGS_fs_data_dirs_hole_punches_per_sec > 0) {
+    // The throttler refills in tenths of a second, so it can't limit lower rates.
+    hole_punch_throttler_.reset(new Throttler(
+        MonoTime::Now(), std::max<int64_t>(10, FLAGS_fs_data_dirs_hole_punches_per_sec), 0, 1.0));
+  }
+}
 
 std::unique_ptr<Dir> DataDirManager::CreateNewDir(
     Env* env, DirMetrics* metrics, FsType fs_type,
@@ -208,6 +283,47 @@ int DataDir::reserved_bytes() const {
   return FLAGS_fs_data_dirs_reserved_bytes;
 }
 
+void DataDir::ThrottleIO(IOClass io_class, int64_t bytes) {
+  const MonoDelta wait = MonoDelta::FromMicroseconds(Throttler::kRefillPeriodMicros / 10);
+  Throttler* throttler = nullptr;
+  int64_t bytes_per_sec = 0;
+  switch (io_class) {
+    case IOClass::BACKGROUND_READ:
+      throttler = background_read_throttler_.get();
+      bytes_per_sec = FLAGS_fs_data_dirs_background_read_bytes_per_sec;
+      break;
+    case IOClass::WRITE:
+      throttler = write_throttler_.get();
+      bytes_per_sec = FLAGS_fs_data_dirs_write_bytes_per_sec;
+      break;
+    case IOClass::HOLE_PUNCH:
+      if (hole_punch_throttler_) {
+        while (!hole_punch_throttler_->Take(MonoTime::Now(), 1, 0)) {
+          SleepFor(wait);
+          TRACE_COUNTER_INCREMENT("data_dir_throttled_us", wait.ToMicroseconds());
+        }
+      }
+      return;
+    default:
+      LOG(FATAL) << "unknown IO class";
+  }
+  if (!throttler) {
+    return;
+  }
+  // The throttler holds at most one refill period's worth of tokens, so
+  // larger IOs are throttled in chunks of that size.
+  const int64_t max_chunk = std::max<int64_t>(
+      1, bytes_per_sec / (MonoTime::kMicrosecondsPerSecond / Throttler::kRefillPeriodMicros));
+  while (bytes > 0) {
+    int64_t chunk = std::min(bytes, max_chunk);
+    while (!throttler->Take(MonoTime::Now(), 0, chunk)) {
+      SleepFor(wait);
+      TRACE_COUNTER_INCREMENT("data_dir_throttled_us", wait.ToMicroseconds());
+    }
+    bytes -= chunk;
+  }
+}
+
 ////////////////////////////////////////////////////////////
 // DataDirManager
 ////////////////////////////////////////////////////////////
@@ -463,6 +579,20 @@ Status DataDirManager::GetDirForBlock(const CreateBlockOptions& opts, Dir** dir,
                    opts.tablet_id, num_total, num_failed, num_full),
         "", ENOSPC);
   }
+  // Prefer the directories of the tier the tablet's blocks belong in. If the
+  // group has none with room, any directory in the group will do.
+  if (PREDICT_FALSE(!FLAGS_fs_cold_data_dirs.empty())) {
+    const bool want_cold = ContainsKey(cold_tablets_, opts.tablet_id);
+    vector<Dir*> tier_dirs;
+    for (auto* candidate : candidate_dirs) {
+      if (down_cast<DataDir*>(candidate)->is_cold() == want_cold) {
+        tier_dirs.emplace_back(candidate);
+      }
+    }
+    if (!tier_dirs.empty()) {
+      candidate_dirs.swap(tier_dirs);
+    }
+  }
   if (candidate_dirs.size() == 1) {
     *dir = candidate_dirs[0];
     return Status::OK();
@@ -487,6 +617,16 @@ void DataDirManager::DeleteDataDirGroup(const std::string& tablet_id) {
     FindOrDie(tablets_by_uuid_idx_map_, uuid_idx).erase(tablet_id);
   }
   group_by_tablet_map_.erase(tablet_id);
+  cold_tablets_.erase(tablet_id);
+}
+
+void DataDirManager::SetTabletCold(const string& tablet_id, bool cold) {
+  std::lock_guard<percpu_rwlock> lock(dir_group_lock_);
+  if (cold) {
+    cold_tablets_.insert(tablet_id);
+  } else {
+    cold_tablets_.erase(tablet_id);
+  }
 }
 
 Status DataDirManager::GetDataDirGroupPB(const string& tablet_id,
@@ -17,9 +17,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
@@ -28,6 +30,7 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/status.h"
+#include "kudu/util/throttler.h"
 
 namespace kudu {
 
@@ -98,6 +101,19 @@ class DataDir : public Dir {
 
   int available_space_cache_secs() const override;
   int reserved_bytes() const override;
+
+  void ThrottleIO(IOClass io_class, int64_t bytes) override;
+
+  // Whether the directory is on slower media, per --fs_cold_data_dirs.
+  bool is_cold() const { return is_cold_; }
+
+ private:
+  const bool is_cold_;
+
+  // Rate limits of the IO classes, or null if a class isn't rate limited.
+  std::unique_ptr<Throttler> background_read_throttler_;
+  std::unique_ptr<Throttler> write_throttler_;
+  std::unique_ptr<Throttler> hole_punch_throttler_;
 };
 
 struct DataDirManagerOptions : public DirManagerOptions {
@@ -172,6 +188,11 @@ class DataDirManager : public DirManager {
   // and data dir to tablet set are cleared of all references to the tablet.
   void DeleteDataDirGroup(const std::string& tablet_id);
 
+  // Sets whether new blocks of the specified tablet should be placed in the
+  // cold directories of its group (see --fs_cold_data_dirs) rather than in
+  // the others.
+  void SetTabletCold(const std::string& tablet_id, bool cold);
+
   // Returns a dir for block placement in the data dir group specified in
   // 'opts'. If none exists, adds a new dir to the group and returns the dir,
   // and if none can be added, returns an error.
@@ -249,6 +270,9 @@ class DataDirManager : public DirManager {
   typedef std::unordered_map<std::string, internal::DataDirGroup> TabletDataDirGroupMap;
   TabletDataDirGroupMap group_by_tablet_map_;
 
+  // Tablets whose new blocks are placed in cold directories.
+  std::unordered_set<std::string> cold_tablets_;
+
   DISALLOW_COPY_AND_ASSIGN(DataDirManager);
 };
 
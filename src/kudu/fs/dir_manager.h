@@ -156,6 +156,24 @@ class Dir {
   // value of -1 means 1% of the disk space in a directory will be reserved.
   virtual int reserved_bytes() const = 0;
 
+  // The classes of IO which may be rate limited in a directory.
+  enum class IOClass {
+    // Reads on behalf of background operations, e.g. flushes and compactions.
+    BACKGROUND_READ,
+
+    // Writes of blocks, which are only done by background operations.
+    WRITE,
+
+    // Hole punches freeing the space of deleted blocks. These are limited by
+    // count rather than by size.
+    HOLE_PUNCH,
+  };
+
+  // Waits until 'bytes' bytes of IO of class 'io_class' fit within the rate
+  // limit of this directory for that class. Returns immediately if the class
+  // isn't rate limited.
+  virtual void ThrottleIO(IOClass /*io_class*/, int64_t /*bytes*/) {}
+
  private:
   Env* env_;
   DirMetrics* metrics_;
@@ -340,16 +340,18 @@ Status FileWritableBlock::Append(const Slice& data) {
 
 Status FileWritableBlock::AppendV(ArrayView<const Slice> data) {
   DCHECK(state_ == CLEAN || state_ == DIRTY) << "Invalid state: " << state_;
-  RETURN_NOT_OK_HANDLE_ERROR(writer_->AppendV(data));
-  RETURN_NOT_OK_HANDLE_ERROR(location_.data_dir()->RefreshAvailableSpace(
-      Dir::RefreshMode::ALWAYS));
-  state_ = DIRTY;
 
-  // Calculate the amount of data written
+  // Calculate the amount of data to write
   size_t bytes_written = accumulate(data.begin(), data.end(), static_cast<size_t>(0),
                                     [&](int sum, const Slice& curr) {
                                       return sum + curr.size();
                                     });
+  location_.data_dir()->ThrottleIO(Dir::IOClass::WRITE, bytes_written);
+
+  RETURN_NOT_OK_HANDLE_ERROR(writer_->AppendV(data));
+  RETURN_NOT_OK_HANDLE_ERROR(location_.data_dir()->RefreshAvailableSpace(
+      Dir::RefreshMode::ALWAYS));
+  state_ = DIRTY;
   bytes_appended_ += bytes_written;
   return Status::OK();
 }
@@ -450,6 +452,8 @@ class FileReadableBlock : public ReadableBlock {
 
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const OVERRIDE;
 
+  virtual void ThrottleBackgroundRead(size_t bytes) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
   void HandleError(const Status& s) const;
@@ -543,6 +547,14 @@ Status FileReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
   return Status::OK();
 }
 
+void FileReadableBlock::ThrottleBackgroundRead(size_t bytes) const {
+  Dir* dir = block_manager_->dd_manager_->FindDirByUuidIndex(
+      internal::FileBlockLocation::GetDirIdx(block_id_));
+  if (dir) {
+    dir->ThrottleIO(Dir::IOClass::BACKGROUND_READ, bytes);
+  }
+}
+
 size_t FileReadableBlock::memory_footprint() const {
   DCHECK(reader_);
   return kudu_malloc_usable_size(this) + reader_->memory_footprint();
@@ -132,6 +132,7 @@ const char *FsManager::kTabletMetadataDirName = "tablet-meta";
 const char *FsManager::kDataDirName = "data";
 const char *FsManager::kInstanceMetadataFileName = "instance";
 const char *FsManager::kConsensusMetadataDirName = "consensus-meta";
+const char *FsManager::kCodegenCacheDirName = "codegen-cache";
 
 FsManagerOpts::FsManagerOpts()
   : wal_root(FLAGS_fs_wal_dir),
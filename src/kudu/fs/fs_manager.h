@@ -260,6 +260,12 @@ class FsManager {
     return JoinPathSegments(canonicalized_metadata_fs_root_.path, kConsensusMetadataDirName);
   }
 
+  // Return the directory where the code generator keeps compiled code.
+  std::string GetCodegenCacheDir() const {
+    DCHECK(initted_);
+    return JoinPathSegments(canonicalized_metadata_fs_root_.path, kCodegenCacheDirName);
+  }
+
   // Return the path where ConsensusMetadataPB is stored.
   std::string GetConsensusMetadataPath(const std::string& tablet_id) const {
     return JoinPathSegments(GetConsensusMetadataDir(), tablet_id);
@@ -369,6 +375,7 @@ class FsManager {
   static const char *kInstanceMetadataMagicNumber;
   static const char *kTabletSuperBlockMagicNumber;
   static const char *kConsensusMetadataDirName;
+  static const char *kCodegenCacheDirName;
 
   // The environment to be used for all filesystem operations.
   Env* env_;
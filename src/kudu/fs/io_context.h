@@ -43,6 +43,11 @@ namespace fs {
 struct IOContext {
   // The tablet id associated with this IO.
   std::string tablet_id;
+
+  // Whether this IO is done on behalf of a background operation, e.g. a flush
+  // or a compaction, rather than on behalf of a client. Background reads may
+  // be rate limited to leave disk bandwidth to foreground reads.
+  bool is_background;
 };
 
 }  // namespace fs
@@ -53,6 +53,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/strings/util.h"
 #include "kudu/util/atomic.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
 #include "kudu/util/file_cache.h"
 #include "kudu/util/metrics.h"
@@ -76,12 +77,15 @@ using std::vector;
 using strings::Substitute;
 
 DECLARE_bool(cache_force_single_shard);
+DECLARE_bool(log_container_compact_metadata_at_runtime);
+DECLARE_bool(log_container_compact_open_container_metadata);
 DECLARE_bool(crash_on_eio);
 DECLARE_double(env_inject_eio);
 DECLARE_double(log_container_excess_space_before_cleanup_fraction);
 DECLARE_double(log_container_live_metadata_before_compact_ratio);
 DECLARE_int32(fs_target_data_dirs_per_tablet);
 DECLARE_int64(log_container_max_blocks);
+DECLARE_uint64(fs_max_thread_count_per_data_dir);
 DECLARE_string(block_manager_preflush_control);
 DECLARE_string(env_inject_eio_globs);
 DECLARE_uint64(log_container_preallocate_bytes);
@@ -101,6 +105,7 @@ METRIC_DECLARE_counter(log_block_manager_holes_punched);
 METRIC_DECLARE_gauge_uint64(log_block_manager_containers);
 METRIC_DECLARE_gauge_uint64(log_block_manager_full_containers);
 METRIC_DECLARE_gauge_uint64(log_block_manager_dead_containers_deleted);
+METRIC_DECLARE_counter(log_block_manager_metadata_files_compacted);
 
 namespace kudu {
 namespace fs {
@@ -1603,6 +1608,166 @@ TEST_F(LogBlockManagerTest, TestCompactFullContainerMetadataAtStartup) {
   ASSERT_EQ(last_live_aligned_bytes, report.stats.live_block_bytes_aligned);
 }
 
+TEST_F(LogBlockManagerTest, TestCompactOpenContainerMetadataAtStartup) {
+  FLAGS_log_container_live_metadata_before_compact_ratio = 0.50;
+
+  // Create a container that isn't full, and delete most of its blocks.
+  vector<BlockId> block_ids;
+  for (int i = 0; i < 10; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append("a"));
+    ASSERT_OK(block->Close());
+    block_ids.emplace_back(block->id());
+  }
+  {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    for (int i = 0; i < 8; i++) {
+      deletion_transaction->AddDeletedBlock(block_ids[i]);
+    }
+    vector<BlockId> deleted;
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+  string metadata_file_name;
+  NO_FATALS(GetOnlyContainerMetadataFile(&metadata_file_name));
+  uint64_t pre_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &pre_compaction_file_size));
+
+  // By default, only full containers have their metadata compacted.
+  ASSERT_OK(ReopenBlockManager());
+  uint64_t post_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &post_compaction_file_size));
+  ASSERT_EQ(pre_compaction_file_size, post_compaction_file_size);
+
+  FLAGS_log_container_compact_open_container_metadata = true;
+  ASSERT_OK(ReopenBlockManager());
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &post_compaction_file_size));
+  ASSERT_LT(post_compaction_file_size, pre_compaction_file_size);
+
+  // The container should still accept new blocks, and the live ones should
+  // survive another restart.
+  unique_ptr<WritableBlock> block;
+  ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+  ASSERT_OK(block->Append("a"));
+  ASSERT_OK(block->Close());
+  NO_FATALS(GetOnlyContainerMetadataFile(&metadata_file_name));
+  FsReport report;
+  ASSERT_OK(ReopenBlockManager(nullptr, &report));
+  ASSERT_EQ(3, report.stats.live_block_count);
+  for (int i = 8; i < 10; i++) {
+    unique_ptr<ReadableBlock> read_block;
+    ASSERT_OK(bm_->OpenBlock(block_ids[i], &read_block));
+  }
+}
+
+TEST_F(LogBlockManagerTest, TestCompactContainerMetadataAtRuntime) {
+  FLAGS_log_container_compact_metadata_at_runtime = true;
+  FLAGS_log_container_live_metadata_before_compact_ratio = 0.50;
+  FLAGS_log_container_max_blocks = 10;
+
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(&registry, "test");
+  ASSERT_OK(ReopenBlockManager(entity));
+
+  // Create one full container.
+  vector<BlockId> block_ids;
+  for (int i = 0; i < FLAGS_log_container_max_blocks; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append("a"));
+    ASSERT_OK(block->Close());
+    block_ids.emplace_back(block->id());
+  }
+  string metadata_file_name;
+  NO_FATALS(GetOnlyContainerMetadataFile(&metadata_file_name));
+  uint64_t pre_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &pre_compaction_file_size));
+
+  // Delete blocks one at a time. The metadata file should be compacted in the
+  // background as soon as half of the blocks are gone.
+  const auto delete_block = [&](const BlockId& id) {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    deletion_transaction->AddDeletedBlock(id);
+    vector<BlockId> deleted;
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  };
+  for (int i = 0; i < 5; i++) {
+    for (const auto& data_dir : dd_manager_->dirs()) {
+      data_dir->WaitOnClosures();
+    }
+    NO_FATALS(CheckCounterMetric(entity, 0, &METRIC_log_block_manager_metadata_files_compacted));
+    NO_FATALS(delete_block(block_ids[i]));
+  }
+  for (const auto& data_dir : dd_manager_->dirs()) {
+    data_dir->WaitOnClosures();
+  }
+  NO_FATALS(CheckCounterMetric(entity, 1, &METRIC_log_block_manager_metadata_files_compacted));
+  uint64_t post_compaction_file_size;
+  ASSERT_OK(env_->GetFileSize(metadata_file_name, &post_compaction_file_size));
+  ASSERT_LT(post_compaction_file_size, pre_compaction_file_size);
+
+  // Deletions should be appended to the compacted metadata file, and the next
+  // compaction shouldn't happen until half of the remaining blocks are gone.
+  NO_FATALS(delete_block(block_ids[5]));
+  for (const auto& data_dir : dd_manager_->dirs()) {
+    data_dir->WaitOnClosures();
+  }
+  NO_FATALS(CheckCounterMetric(entity, 1, &METRIC_log_block_manager_metadata_files_compacted));
+  FsReport report;
+  ASSERT_OK(ReopenBlockManager(nullptr, &report));
+  ASSERT_FALSE(report.HasFatalErrors());
+  ASSERT_EQ(4, report.stats.live_block_count);
+  for (size_t i = 0; i < block_ids.size(); i++) {
+    unique_ptr<ReadableBlock> block;
+    if (i < 6) {
+      ASSERT_TRUE(bm_->OpenBlock(block_ids[i], &block).IsNotFound());
+    } else {
+      ASSERT_OK(bm_->OpenBlock(block_ids[i], &block));
+    }
+  }
+}
+
+// Test that holes of adjacent blocks deleted by different transactions are
+// coalesced if they're queued before the pending holes are punched.
+TEST_F(LogBlockManagerTest, TestCoalesceHolesAcrossTransactions) {
+  // With one thread per directory, blocking that thread holds back punching.
+  FLAGS_fs_max_thread_count_per_data_dir = 1;
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(&registry, "test");
+  ASSERT_OK(ReopenBlockManager(entity));
+
+  vector<BlockId> block_ids;
+  for (int i = 0; i < 4; i++) {
+    unique_ptr<WritableBlock> block;
+    ASSERT_OK(bm_->CreateBlock(test_block_opts_, &block));
+    ASSERT_OK(block->Append("a"));
+    ASSERT_OK(block->Close());
+    block_ids.emplace_back(block->id());
+  }
+  string data_file_name;
+  NO_FATALS(GetOnlyContainerDataFile(&data_file_name));
+
+  CountDownLatch latch(1);
+  for (const auto& data_dir : dd_manager_->dirs()) {
+    data_dir->ExecClosure([&latch]() { latch.Wait(); });
+  }
+  for (const auto& id : block_ids) {
+    shared_ptr<BlockDeletionTransaction> deletion_transaction =
+        bm_->NewDeletionTransaction();
+    deletion_transaction->AddDeletedBlock(id);
+    vector<BlockId> deleted;
+    ASSERT_OK(deletion_transaction->CommitDeletedBlocks(&deleted));
+  }
+  latch.CountDown();
+  for (const auto& data_dir : dd_manager_->dirs()) {
+    data_dir->WaitOnClosures();
+  }
+  NO_FATALS(CheckCounterMetric(entity, 1, &METRIC_log_block_manager_holes_punched));
+  NO_FATALS(CheckCounterMetric(entity, 4, &METRIC_block_manager_total_blocks_deleted));
+}
+
 // Regression test for a bug in which, after a metadata file was compacted,
 // we would not properly handle appending to the new (post-compaction) metadata.
 //
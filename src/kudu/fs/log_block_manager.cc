@@ -66,6 +66,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
+#include "kudu/util/rw_mutex.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/sorted_disjoint_interval_list.h"
@@ -104,6 +105,32 @@ DEFINE_double(log_container_live_metadata_before_compact_ratio, 0.50,
               "the container's metadata file will be compacted at startup.");
 TAG_FLAG(log_container_live_metadata_before_compact_ratio, experimental);
 
+DEFINE_bool(log_container_compact_open_container_metadata, false,
+            "Whether to also compact the metadata files of log containers which "
+            "aren't yet full at startup, if their live to total block ratio is "
+            "below --log_container_live_metadata_before_compact_ratio. This "
+            "shortens the replay of such metadata files at subsequent startups.");
+TAG_FLAG(log_container_compact_open_container_metadata, experimental);
+
+DEFINE_bool(log_container_compact_metadata_at_runtime, false,
+            "Whether to compact the metadata files of log containers in the "
+            "background once their live to total block ratio dips below "
+            "--log_container_live_metadata_before_compact_ratio, rather than "
+            "only at startup. This keeps metadata files from growing without "
+            "bound between restarts.");
+TAG_FLAG(log_container_compact_metadata_at_runtime, experimental);
+TAG_FLAG(log_container_compact_metadata_at_runtime, runtime);
+
+DEFINE_bool(log_block_manager_direct_reads, false,
+            "Whether to read block data with direct I/O, bypassing the operating "
+            "system's page cache. Data read from blocks is cached in the block "
+            "cache, so the page cache otherwise holds a second copy of it; when "
+            "enabling this, consider giving the memory to --block_cache_capacity_mb "
+            "instead. Falls back to buffered reads on filesystems which don't "
+            "support direct I/O.");
+TAG_FLAG(log_block_manager_direct_reads, experimental);
+TAG_FLAG(log_block_manager_direct_reads, runtime);
+
 DEFINE_bool(log_block_manager_test_hole_punching, true,
             "Ensure hole punching is supported by the underlying filesystem");
 TAG_FLAG(log_block_manager_test_hole_punching, advanced);
@@ -152,6 +179,13 @@ METRIC_DEFINE_counter(server, log_block_manager_dead_containers_deleted,
                       "Number of full (but dead) block containers that were deleted",
                       kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_counter(server, log_block_manager_metadata_files_compacted,
+                      "Number of Container Metadata Files Compacted",
+                      kudu::MetricUnit::kLogBlockContainers,
+                      "Number of block container metadata files that were compacted "
+                      "since service start",
+                      kudu::MetricLevel::kDebug);
+
 namespace kudu {
 
 namespace fs {
@@ -197,6 +231,7 @@ struct LogBlockManagerMetrics {
 
   scoped_refptr<Counter> holes_punched;
   scoped_refptr<Counter> dead_containers_deleted;
+  scoped_refptr<Counter> metadata_files_compacted;
 };
 
 #define MINIT(x) x(METRIC_log_block_manager_##x.Instantiate(metric_entity))
@@ -208,7 +243,8 @@ LogBlockManagerMetrics::LogBlockManagerMetrics(const scoped_refptr<MetricEntity>
     GINIT(containers),
     GINIT(full_containers),
     MINIT(holes_punched),
-    MINIT(dead_containers_deleted) {
+    MINIT(dead_containers_deleted),
+    MINIT(metadata_files_compacted) {
 }
 #undef GINIT
 
@@ -340,6 +376,29 @@ class LogWritableBlock : public WritableBlock {
 // LogBlockContainer
 ////////////////////////////////////////////////////////////
 
+// Sorts the live block records of a container such that their ordering
+// reflects the ordering in its metadata file.
+//
+// This is preferred to storing the records in an order-preserving container
+// (such as std::map) because while records are temporarily retained for every
+// container at startup, only some containers will actually undergo metadata
+// compaction.
+static void SortBlockRecords(vector<BlockRecordPB>* records) {
+  std::sort(records->begin(), records->end(),
+            [](const BlockRecordPB& a, const BlockRecordPB& b) {
+    // Sort by timestamp.
+    if (a.timestamp_us() != b.timestamp_us()) {
+      return a.timestamp_us() < b.timestamp_us();
+    }
+
+    // If the timestamps match, sort by offset.
+    //
+    // If the offsets also match (i.e. both blocks are of zero length),
+    // it doesn't matter which of the two records comes first.
+    return a.offset() < b.offset();
+  });
+}
+
 // A single block container belonging to the log-backed block manager.
 //
 // A container may only be used to write one WritableBlock at a given time.
@@ -399,6 +458,16 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // Executes a hole punching operation at 'offset' with the given 'length'.
   void ContainerDeletionAsync(int64_t offset, int64_t length);
 
+  // Queues the [start, end) ranges of deleted blocks in 'holes' to be punched
+  // out of the data file in the background. Ranges queued before the pending
+  // ones are punched are coalesced with them, so adjacent blocks deleted by
+  // different transactions are freed by a single hole punch.
+  void PunchHolesAsync(const vector<std::pair<int64_t, int64_t>>& holes);
+
+  // Punches the holes queued by PunchHolesAsync(), subject to the hole punch
+  // rate limit of the data directory.
+  void PunchPendingHoles();
+
   // Preallocate enough space to ensure that an append of 'next_append_length'
   // can be satisfied by this container. The offset of the beginning of this
   // block must be provided in 'block_start_offset' (since container
@@ -420,6 +489,9 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // See RWFile::ReadV().
   Status ReadVData(int64_t offset, ArrayView<Slice> results) const;
 
+  // See RWFile::ReadAhead(). Failures are ignored, since this is only a hint.
+  void ReadAheadData(int64_t offset, size_t length) const;
+
   // Appends 'pb' to this container's metadata file.
   //
   // The on-disk effects of this call are made durable only after SyncMetadata().
@@ -454,6 +526,29 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // file was changed.
   Status ReopenMetadataWriter();
 
+  // Returns whether enough of the blocks recorded in this container's metadata
+  // file have been deleted for the file to be worth compacting.
+  bool ShouldCompactMetadata() const;
+
+  // Rewrites this container's metadata file with only the records of its live
+  // blocks. Metadata appends to the container wait for the rewrite to finish.
+  //
+  // Failures are non-fatal, unless the rewritten file can't be reopened, in
+  // which case the container is made read-only.
+  void CompactMetadata();
+
+  // Tries to mark the container's metadata as being compacted, so that only
+  // one compaction is scheduled at a time. Returns true on success.
+  bool TrySetCompactingMetadata() {
+    return compacting_metadata_.CompareAndSet(false, true);
+  }
+
+  // Records that the container's metadata file was rewritten to contain
+  // 'num_blocks' CREATE records and no DELETE records.
+  void MetadataCompacted(int64_t num_blocks) {
+    metadata_blocks_.Store(num_blocks);
+  }
+
   // Truncates this container's data file to 'next_block_offset_' if it is
   // full. This effectively removes any preallocated but unused space.
   //
@@ -631,6 +726,16 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // This function is thread unsafe.
   void UpdateNextBlockOffset(int64_t block_offset, int64_t block_length);
 
+  // Reads the records of the container's live blocks from its metadata file
+  // into 'records', in the order in which they were written.
+  //
+  // Must be called with 'metadata_lock_' held for writing, so that the file
+  // doesn't change while it's read.
+  Status ReadLiveBlockRecords(vector<BlockRecordPB>* records) const;
+
+  // Like ReopenMetadataWriter(), but with 'metadata_lock_' held for writing.
+  Status ReopenMetadataWriterUnlocked();
+
   // The owning block manager. Must outlive the container itself.
   LogBlockManager* const block_manager_;
 
@@ -642,6 +747,10 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // Offset up to which we have preallocated bytes.
   int64_t preallocated_offset_ = 0;
 
+  // Protects 'metadata_file_'. Appends, flushes and syncs take it for reading;
+  // metadata compaction takes it for writing, as it replaces the file.
+  mutable RWMutex metadata_lock_;
+
   // Opened file handles to the container's files.
   unique_ptr<WritablePBContainerFile> metadata_file_;
   shared_ptr<RWFile> data_file_;
@@ -668,9 +777,22 @@ class LogBlockContainer: public RefCountedThreadSafe<LogBlockContainer> {
   // The number of LogWritableBlocks currently open for this container.
   AtomicInt<int32_t> blocks_being_written_;
 
+  // The number of blocks with CREATE records in the metadata file. Unlike
+  // 'total_blocks_', this shrinks when the metadata file is compacted.
+  AtomicInt<int64_t> metadata_blocks_;
+
+  // Whether or not a metadata compaction is scheduled or running.
+  AtomicBool compacting_metadata_;
+
   // Whether or not this container has been marked as dead.
   AtomicBool dead_;
 
+  // Holes queued by PunchHolesAsync() but not yet punched, and whether a task
+  // to punch them has been scheduled.
+  simple_spinlock pending_holes_lock_;
+  vector<std::pair<int64_t, int64_t>> pending_holes_;
+  bool punching_scheduled_;
+
   // The metrics. Not owned by the log container; it has the same lifespan
   // as the block manager.
   const LogBlockManagerMetrics* metrics_;
@@ -709,7 +831,10 @@ LogBlockContainer::LogBlockContainer(
       live_bytes_aligned_(0),
       live_blocks_(0),
       blocks_being_written_(0),
+      metadata_blocks_(0),
+      compacting_metadata_(false),
       dead_(false),
+      punching_scheduled_(false),
       metrics_(block_manager->metrics()) {
 }
 
@@ -1180,14 +1305,32 @@ Status LogBlockContainer::ReadData(int64_t offset, Slice result) const {
 }
 Status LogBlockContainer::ReadVData(int64_t offset, ArrayView<Slice> results) const {
   DCHECK_GE(offset, 0);
-  RETURN_NOT_OK_HANDLE_ERROR(data_file_->ReadV(offset, results));
+  if (FLAGS_log_block_manager_direct_reads) {
+    RETURN_NOT_OK_HANDLE_ERROR(data_file_->ReadVDirect(offset, results));
+  } else {
+    RETURN_NOT_OK_HANDLE_ERROR(data_file_->ReadV(offset, results));
+  }
   return Status::OK();
 }
 
+void LogBlockContainer::ReadAheadData(int64_t offset, size_t length) const {
+  DCHECK_GE(offset, 0);
+  // Direct reads bypass the page cache, so reading ahead into it is wasted.
+  if (FLAGS_log_block_manager_direct_reads) {
+    return;
+  }
+  Status s = data_file_->ReadAhead(offset, length);
+  if (PREDICT_FALSE(!s.ok())) {
+    VLOG(1) << Substitute("Could not read ahead $0 bytes at offset $1 of $2: $3",
+                          length, offset, ToString(), s.ToString());
+  }
+}
+
 Status LogBlockContainer::AppendMetadata(const BlockRecordPB& pb) {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   // Note: We don't check for sufficient disk space for metadata writes in
   // order to allow for block deletion on full disks.
+  shared_lock<RWMutex> l(metadata_lock_);
   RETURN_NOT_OK_HANDLE_ERROR(metadata_file_->Append(pb));
   return Status::OK();
 }
@@ -1202,6 +1345,7 @@ Status LogBlockContainer::FlushData(int64_t offset, int64_t length) {
 
 Status LogBlockContainer::FlushMetadata() {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
+  shared_lock<RWMutex> l(metadata_lock_);
   RETURN_NOT_OK_HANDLE_ERROR(metadata_file_->Flush());
   return Status::OK();
 }
@@ -1219,12 +1363,19 @@ Status LogBlockContainer::SyncMetadata() {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
   if (FLAGS_enable_data_block_fsync) {
     if (metrics_) metrics_->generic_metrics.total_disk_sync->Increment();
+    shared_lock<RWMutex> l(metadata_lock_);
     RETURN_NOT_OK_HANDLE_ERROR(metadata_file_->Sync());
   }
   return Status::OK();
 }
 
 Status LogBlockContainer::ReopenMetadataWriter() {
+  std::lock_guard<RWMutex> l(metadata_lock_);
+  return ReopenMetadataWriterUnlocked();
+}
+
+Status LogBlockContainer::ReopenMetadataWriterUnlocked() {
+  metadata_lock_.AssertAcquiredForWriting();
   shared_ptr<RWFile> f;
   if (PREDICT_TRUE(block_manager_->file_cache_)) {
     RETURN_NOT_OK_HANDLE_ERROR(block_manager_->file_cache_->OpenFile<Env::MUST_EXIST>(
@@ -1246,6 +1397,104 @@ Status LogBlockContainer::ReopenMetadataWriter() {
   return Status::OK();
 }
 
+bool LogBlockContainer::ShouldCompactMetadata() const {
+  if (!full() && !FLAGS_log_container_compact_open_container_metadata) {
+    return false;
+  }
+  int64_t metadata_blocks = metadata_blocks_.Load();
+  return metadata_blocks > 0 &&
+      static_cast<double>(live_blocks()) / metadata_blocks <=
+      FLAGS_log_container_live_metadata_before_compact_ratio;
+}
+
+void LogBlockContainer::CompactMetadata() {
+  SCOPED_CLEANUP({
+    compacting_metadata_.Store(false);
+  });
+  if (dead() || read_only()) {
+    return;
+  }
+
+  std::lock_guard<RWMutex> l(metadata_lock_);
+  vector<BlockRecordPB> records;
+  Status s = ReadLiveBlockRecords(&records);
+  if (!s.ok()) {
+    WARN_NOT_OK(s, Substitute("could not read metadata of container $0", ToString()));
+    return;
+  }
+  int64_t file_bytes_delta;
+  s = block_manager_->RewriteMetadataFile(*this, records, &file_bytes_delta);
+  if (!s.ok()) {
+    WARN_NOT_OK(s, Substitute("could not rewrite metadata of container $0", ToString()));
+    return;
+  }
+
+  // As at startup, the new metadata file must be durable before anything is
+  // appended to it, and it must be reopened before the next append; records
+  // appended to the old file would otherwise be lost.
+  s = block_manager_->env_->SyncDir(data_dir_->dir());
+  if (s.ok()) {
+    s = ReopenMetadataWriterUnlocked();
+  }
+  if (!s.ok()) {
+    HandleError(s);
+    SetReadOnly(s);
+    return;
+  }
+
+  MetadataCompacted(records.size());
+  if (metrics_) metrics_->metadata_files_compacted->Increment();
+  VLOG(1) << Substitute("Compacted metadata of container $0 (saved $1 bytes)",
+                        ToString(), file_bytes_delta);
+}
+
+Status LogBlockContainer::ReadLiveBlockRecords(vector<BlockRecordPB>* records) const {
+  metadata_lock_.AssertAcquiredForWriting();
+  unique_ptr<RandomAccessFile> metadata_reader;
+  RETURN_NOT_OK_HANDLE_ERROR(block_manager()->env()->NewRandomAccessFile(
+      metadata_file_->filename(), &metadata_reader));
+  ReadablePBContainerFile pb_reader(std::move(metadata_reader));
+  RETURN_NOT_OK_HANDLE_ERROR(pb_reader.Open());
+
+  // The records were already checked when the container was loaded, or were
+  // appended by this process since then.
+  LogBlockManager::BlockRecordMap live_block_records;
+  Status read_status;
+  while (true) {
+    BlockRecordPB record;
+    read_status = pb_reader.ReadNextPB(&record);
+    if (!read_status.ok()) {
+      break;
+    }
+    const BlockId block_id(BlockId::FromPB(record.block_id()));
+    switch (record.op_type()) {
+      case CREATE:
+        live_block_records[block_id].Swap(&record);
+        break;
+      case DELETE:
+        live_block_records.erase(block_id);
+        break;
+      default:
+        break;
+    }
+  }
+  // Unlike at startup, a partial trailing record isn't expected here.
+  if (PREDICT_FALSE(!read_status.IsEndOfFile())) {
+    HandleError(read_status);
+    return read_status;
+  }
+
+  records->clear();
+  records->resize(live_block_records.size());
+  int i = 0;
+  for (auto& e : live_block_records) {
+    (*records)[i].Swap(&e.second);
+    i++;
+  }
+  SortBlockRecords(records);
+  return Status::OK();
+}
+
 Status LogBlockContainer::EnsurePreallocated(int64_t block_start_offset,
                                              size_t next_append_length) {
   RETURN_NOT_OK_HANDLE_ERROR(read_only_status());
@@ -1322,6 +1571,7 @@ void LogBlockContainer::BlockCreated(const LogBlockRefPtr& block) {
 
   total_bytes_.IncrementBy(block->fs_aligned_length());
   total_blocks_.Increment();
+  metadata_blocks_.Increment();
   live_bytes_.IncrementBy(block->length());
   live_bytes_aligned_.IncrementBy(block->fs_aligned_length());
   live_blocks_.Increment();
@@ -1362,12 +1612,44 @@ void LogBlockContainer::ContainerDeletionAsync(int64_t offset, int64_t length) {
   }
 
   VLOG(3) << "Freeing space belonging to container " << ToString();
+  data_dir_->ThrottleIO(Dir::IOClass::HOLE_PUNCH, length);
   Status s = PunchHole(offset, length);
   if (s.ok() && metrics_) metrics_->holes_punched->Increment();
   WARN_NOT_OK(s, Substitute("could not delete blocks in container $0",
                             data_dir()->dir()));
 }
 
+void LogBlockContainer::PunchHolesAsync(const vector<std::pair<int64_t, int64_t>>& holes) {
+  bool schedule;
+  {
+    std::lock_guard<simple_spinlock> l(pending_holes_lock_);
+    pending_holes_.insert(pending_holes_.end(), holes.begin(), holes.end());
+    schedule = !punching_scheduled_;
+    punching_scheduled_ = true;
+  }
+  if (schedule) {
+    scoped_refptr<LogBlockContainer> self(this);
+    ExecClosure([self]() {
+      self->PunchPendingHoles();
+    });
+  }
+}
+
+void LogBlockContainer::PunchPendingHoles() {
+  vector<std::pair<int64_t, int64_t>> holes;
+  {
+    std::lock_guard<simple_spinlock> l(pending_holes_lock_);
+    holes.swap(pending_holes_);
+    punching_scheduled_ = false;
+  }
+  CHECK_OK_PREPEND(CoalesceIntervals<int64_t>(&holes),
+                   Substitute("could not coalesce hole punching for container: $0",
+                              ToString()));
+  for (const auto& hole : holes) {
+    ContainerDeletionAsync(hole.first, hole.second - hole.first);
+  }
+}
+
 ///////////////////////////////////////////////////////////
 // LogBlockCreationTransaction
 ////////////////////////////////////////////////////////////
@@ -1490,14 +1772,18 @@ LogBlockDeletionTransaction::~LogBlockDeletionTransaction() {
       continue;
     }
 
-    CHECK_OK_PREPEND(CoalesceIntervals<int64_t>(&entry.second),
-                     Substitute("could not coalesce hole punching for container: $0",
-                                container->ToString()));
+    container->PunchHolesAsync(entry.second);
 
     scoped_refptr<LogBlockContainer> self(container);
-    for (const auto& interval : entry.second) {
-      container->ExecClosure([self, interval]() {
-        self->ContainerDeletionAsync(interval.first, interval.second - interval.first);
+
+    // Compact the container's metadata file if enough of its blocks are gone,
+    // rather than leaving it to be done at the next startup.
+    if (FLAGS_log_container_compact_metadata_at_runtime &&
+        !lbm_->opts_.read_only &&
+        container->ShouldCompactMetadata() &&
+        container->TrySetCompactingMetadata()) {
+      container->ExecClosure([self]() {
+        self->CompactMetadata();
       });
     }
   }
@@ -1715,6 +2001,8 @@ Status LogWritableBlock::AppendV(ArrayView<const Slice> data) {
                                   return sum + curr.size();
                                 });
 
+  container_->data_dir()->ThrottleIO(Dir::IOClass::WRITE, data_size);
+
   // The metadata change is deferred to Close(). We can't do
   // it now because the block's length is still in flux.
   int64_t cur_block_offset = block_offset_ + block_length_;
@@ -1830,6 +2118,10 @@ class LogReadableBlock : public ReadableBlock {
 
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const OVERRIDE;
 
+  virtual void ThrottleBackgroundRead(size_t bytes) const OVERRIDE;
+
+  virtual void ReadAhead(uint64_t offset, size_t length) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
  private:
@@ -1921,6 +2213,20 @@ Status LogReadableBlock::ReadV(uint64_t offset, ArrayView<Slice> results) const
   return Status::OK();
 }
 
+void LogReadableBlock::ThrottleBackgroundRead(size_t bytes) const {
+  DCHECK(!closed_.Load());
+  log_block_->container()->data_dir()->ThrottleIO(Dir::IOClass::BACKGROUND_READ, bytes);
+}
+
+void LogReadableBlock::ReadAhead(uint64_t offset, size_t length) const {
+  DCHECK(!closed_.Load());
+  if (offset >= log_block_->length()) {
+    return;
+  }
+  length = std::min<uint64_t>(length, log_block_->length() - offset);
+  log_block_->container()->ReadAheadData(log_block_->offset() + offset, length);
+}
+
 size_t LogReadableBlock::memory_footprint() const {
   return kudu_malloc_usable_size(this);
 }
@@ -2611,6 +2917,16 @@ void LogBlockManager::LoadContainer(Dir* dir,
     }
   }
 
+  // Metadata files of containers with very few live blocks will be compacted.
+  //
+  // TODO(adar): this should be reported as an inconsistency once
+  // container metadata compaction is also done in realtime. Until then,
+  // it would be confusing to report it as such since it'll be a natural
+  // event at startup.
+  const bool low_live_ratio = container->total_blocks() > 0 &&
+      static_cast<double>(container->live_blocks()) / container->total_blocks() <=
+      FLAGS_log_container_live_metadata_before_compact_ratio;
+  bool compact_metadata = false;
   if (container->full()) {
     // Full containers without any live blocks can be deleted outright.
     //
@@ -2620,45 +2936,29 @@ void LogBlockManager::LoadContainer(Dir* dir,
     if (container->live_blocks() == 0) {
       DCHECK(live_blocks.empty());
       result->dead_containers.emplace_back(container);
-    } else if (static_cast<double>(container->live_blocks()) /
-        container->total_blocks() <= FLAGS_log_container_live_metadata_before_compact_ratio) {
-      // Metadata files of containers with very few live blocks will be compacted.
-      //
-      // TODO(adar): this should be reported as an inconsistency once
-      // container metadata compaction is also done in realtime. Until then,
-      // it would be confusing to report it as such since it'll be a natural
-      // event at startup.
-      vector<BlockRecordPB> records(live_block_records.size());
-      int i = 0;
-      for (auto& e : live_block_records) {
-        records[i].Swap(&e.second);
-        i++;
-      }
-
-      // Sort the records such that their ordering reflects the ordering in
-      // the pre-compacted metadata file.
-      //
-      // This is preferred to storing the records in an order-preserving
-      // container (such as std::map) because while records are temporarily
-      // retained for every container, only some containers will actually
-      // undergo metadata compaction.
-      std::sort(records.begin(), records.end(),
-                [](const BlockRecordPB& a, const BlockRecordPB& b) {
-        // Sort by timestamp.
-        if (a.timestamp_us() != b.timestamp_us()) {
-          return a.timestamp_us() < b.timestamp_us();
-        }
-
-        // If the timestamps match, sort by offset.
-        //
-        // If the offsets also match (i.e. both blocks are of zero length),
-        // it doesn't matter which of the two records comes first.
-        return a.offset() < b.offset();
-      });
-
-      result->low_live_block_containers[container->ToString()] = std::move(records);
+    } else {
+      compact_metadata = low_live_ratio;
+    }
+  } else {
+    // Containers that are still being written to may churn through many more
+    // blocks than they keep, and their metadata would otherwise be replayed
+    // in full at every startup until they fill up.
+    compact_metadata = FLAGS_log_container_compact_open_container_metadata && low_live_ratio;
+  }
+
+  if (compact_metadata) {
+    vector<BlockRecordPB> records(live_block_records.size());
+    int i = 0;
+    for (auto& e : live_block_records) {
+      records[i].Swap(&e.second);
+      i++;
     }
 
+    internal::SortBlockRecords(&records);
+    result->low_live_block_containers[container->ToString()] = std::move(records);
+  }
+
+  if (container->full()) {
     // Having processed the block records, let's check whether any full
     // containers have any extra space (left behind after a crash or from an
     // older version of Kudu).
@@ -2951,6 +3251,7 @@ Status LogBlockManager::Repair(
     // However, we're hosed if we can't open the new metadata file.
     RETURN_NOT_OK_PREPEND(container->ReopenMetadataWriter(),
                           "could not reopen new metadata file");
+    container->MetadataCompacted(e.second.size());
 
     metadata_files_compacted++;
     metadata_bytes_delta += file_bytes_delta;
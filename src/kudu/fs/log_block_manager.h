@@ -88,9 +88,10 @@ typedef scoped_refptr<internal::LogBlockContainer> LogBlockContainerRefPtr;
 // orphaned data can be reclaimed instantaneously via hole punching, or
 // later via garbage collection. The latter is used when hole punching is
 // not supported on the filesystem, or on next boot if there's a crash
-// after deletion but before hole punching. The metadata file itself is not
-// compacted, as it is expected to remain quite small even after a great
-// many create/delete cycles.
+// after deletion but before hole punching. The metadata file itself is
+// compacted at startup once most of the blocks it describes have been
+// deleted, and optionally at runtime as well (see
+// --log_container_compact_metadata_at_runtime).
 //
 // Data and metadata operations are carefully ordered to ensure the
 // correctness of the persistent representation at all times. During the
@@ -37,6 +37,8 @@ CPU::CPU()
     has_popcnt_(false),
     has_avx_(false),
     has_avx2_(false),
+    has_avx512f_(false),
+    has_avx512bw_(false),
     has_aesni_(false),
     has_bmi_(false),
     has_bmi2_(false),
@@ -245,6 +247,13 @@ void CPU::Initialize() {
         (_xgetbv(0) & 6) == 6 /* XSAVE enabled by kernel */;
     has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
     has_avx2_ = has_avx_ && (cpu_info7[1] & 0x00000020) != 0;
+    // AVX-512 additionally requires the kernel to save the opmask registers
+    // and the upper halves of the ZMM registers.
+    has_avx512f_ =
+        has_avx2_ &&
+        (cpu_info7[1] & 0x00010000) != 0 &&
+        (_xgetbv(0) & 0xe6) == 0xe6;
+    has_avx512bw_ = has_avx512f_ && (cpu_info7[1] & 0x40000000) != 0;
     has_bmi_ = cpu_info7[1] & (1 << 3);
     has_bmi2_ = cpu_info7[1] & (1 << 8);
   }
@@ -48,6 +48,8 @@ class CPU {
   bool has_popcnt() const { return has_popcnt_; }
   bool has_avx() const { return has_avx_; }
   bool has_avx2() const { return has_avx2_; }
+  bool has_avx512f() const { return has_avx512f_; }
+  bool has_avx512bw() const { return has_avx512bw_; }
   bool has_aesni() const { return has_aesni_; }
   bool has_bmi() const { return has_bmi_; }
   bool has_bmi2() const { return has_bmi2_; }
@@ -84,6 +86,8 @@ class CPU {
   bool has_popcnt_;
   bool has_avx_;
   bool has_avx2_;
+  bool has_avx512f_;
+  bool has_avx512bw_;
   bool has_aesni_;
   bool has_bmi_;
   bool has_bmi2_;
@@ -61,6 +61,7 @@
 #include "kudu/util/test_util.h"
 
 DECLARE_bool(raft_prepare_replacement_before_eviction);
+DECLARE_int32(master_follower_catalog_refresh_interval_ms);
 
 METRIC_DECLARE_counter(sys_catalog_oversized_write_requests);
 
@@ -78,6 +79,7 @@ using kudu::cluster::InternalMiniCluster;
 using kudu::cluster::InternalMiniClusterOptions;
 using kudu::consensus::ReplicaManagementInfoPB;
 using kudu::itest::GetInt64Metric;
+using kudu::pb_util::SecureShortDebugString;
 using std::string;
 using std::thread;
 using std::unique_ptr;
@@ -363,6 +365,43 @@ TEST_F(MasterReplicationTest, TestConnectToFollowerMasterOnly) {
   EXPECT_LE(successes, 1);
 }
 
+// Test that follower masters serve table locations to requests which allow
+// stale results, and only to those.
+TEST_F(MasterReplicationTest, TestFollowersServeStaleTableLocations) {
+  FLAGS_master_follower_catalog_refresh_interval_ms = 100;
+
+  shared_ptr<KuduClient> client;
+  ASSERT_OK(CreateClient(&client));
+  ASSERT_OK(CreateTable(client, kTableId1));
+
+  ASSERT_EVENTUALLY([&] {
+    int num_stale_responses = 0;
+    for (int i = 0; i < cluster_->num_masters(); i++) {
+      GetTableLocationsRequestPB req;
+      req.mutable_table()->set_table_name(kTableId1);
+      req.set_max_staleness_ms(60 * 1000);
+      GetTableLocationsResponsePB resp;
+      rpc::RpcController rpc;
+      ASSERT_OK(cluster_->master_proxy(i)->GetTableLocations(req, &resp, &rpc));
+      ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+      ASSERT_EQ(1, resp.tablet_locations_size());
+      if (resp.has_staleness_ms()) {
+        ASSERT_LE(resp.ttl_millis(), req.max_staleness_ms() - resp.staleness_ms());
+        num_stale_responses++;
+
+        // Without allowing stale results, only the leader serves the request.
+        req.clear_max_staleness_ms();
+        resp.Clear();
+        rpc.Reset();
+        ASSERT_OK(cluster_->master_proxy(i)->GetTableLocations(req, &resp, &rpc));
+        ASSERT_TRUE(resp.has_error());
+        ASSERT_EQ(MasterErrorPB::NOT_THE_LEADER, resp.error().code());
+      }
+    }
+    ASSERT_EQ(cluster_->num_masters() - 1, num_stale_responses);
+  });
+}
+
 // In this test, a Kudu master receives RPC under the maximum size limit,
 // however the corresponding update on the system tablet would be greater than.
 class MasterReplicationAndRpcSizeLimitTest : public KuduTest {
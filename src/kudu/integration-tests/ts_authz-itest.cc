@@ -430,6 +430,9 @@ class RangerITestHarness : public TSAuthzITestHarness {
   static constexpr int kSleepAfterNewPolicyMs = 1200;
   void SetUpExternalMiniServiceOpts(ExternalMiniClusterOptions* opts) override {
     opts->enable_ranger = true;
+    // The policies added by the tests must take effect without waiting for
+    // the cached decisions to expire.
+    opts->extra_master_flags.emplace_back("--ranger_authz_cache_capacity_mb=0");
   }
   Status SetUpExternalServiceClients(const unique_ptr<ExternalMiniCluster>& cluster) override {
     ranger_ = cluster->ranger();
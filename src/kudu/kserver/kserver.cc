@@ -31,11 +31,13 @@
 #include "kudu/gutil/integral_types.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/numa_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/threadpool.h"
 
@@ -147,9 +149,25 @@ Status KuduServer::Init() {
       METRIC_op_apply_queue_time.Instantiate(metric_entity_),
       METRIC_op_apply_run_time.Instantiate(metric_entity_)
   };
-  RETURN_NOT_OK(ThreadPoolBuilder("apply")
-                .set_metrics(std::move(metrics))
-                .Build(&tablet_apply_pool_));
+  // With NUMA pinning, each node has its own apply pool, sized for its CPUs,
+  // for the tablets whose home it is.
+  const int num_apply_pools = NumaNodeForThread(0) == -1 ? 1 : NumNumaNodes();
+  const int apply_pool_max_threads = std::max(1, base::NumCPUs() / num_apply_pools);
+  for (int node = 0; node < num_apply_pools; node++) {
+    std::unique_ptr<ThreadPool> pool;
+    ThreadPoolBuilder builder(num_apply_pools == 1 ? "apply" : Substitute("apply-$0", node));
+    builder.set_metrics(metrics);
+    if (num_apply_pools > 1) {
+      builder.set_numa_node(node)
+             .set_max_threads(apply_pool_max_threads);
+    }
+    RETURN_NOT_OK(builder.Build(&pool));
+    if (node == 0) {
+      tablet_apply_pool_ = std::move(pool);
+    } else {
+      numa_tablet_apply_pools_.emplace_back(std::move(pool));
+    }
+  }
 
   // These pools are shared by all replicas hosted by this server, and thus
   // are capped at a portion of the overall per-euid thread resource limit.
@@ -167,6 +185,14 @@ Status KuduServer::Init() {
   return Status::OK();
 }
 
+ThreadPool* KuduServer::TabletApplyPool(const string& tablet_id) const {
+  const int node = NumaNodeForTablet(tablet_id);
+  if (node <= 0 || node > static_cast<int>(numa_tablet_apply_pools_.size())) {
+    return tablet_apply_pool_.get();
+  }
+  return numa_tablet_apply_pools_[node - 1].get();
+}
+
 Status KuduServer::Start() {
   return ServerBase::Start();
 }
@@ -193,6 +219,9 @@ void KuduServer::Shutdown() {
   if (tablet_apply_pool_) {
     tablet_apply_pool_->Shutdown();
   }
+  for (const auto& pool : numa_tablet_apply_pools_) {
+    pool->Shutdown();
+  }
   if (tablet_prepare_pool_) {
     tablet_prepare_pool_->Shutdown();
   }
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -61,6 +62,9 @@ class KuduServer : public server::ServerBase {
 
   ThreadPool* tablet_prepare_pool() const { return tablet_prepare_pool_.get(); }
   ThreadPool* tablet_apply_pool() const { return tablet_apply_pool_.get(); }
+  // Returns the pool applying the transactions of the tablet 'tablet_id': the
+  // pool of its home NUMA node if --numa_pin_threads is set.
+  ThreadPool* TabletApplyPool(const std::string& tablet_id) const;
   ThreadPool* raft_pool() const { return raft_pool_.get(); }
   scoped_refptr<AtomicGauge<int32_t>> num_raft_leaders() const { return num_raft_leaders_; }
 
@@ -72,6 +76,10 @@ class KuduServer : public server::ServerBase {
   // Thread pool for applying transactions, shared between all tablets.
   std::unique_ptr<ThreadPool> tablet_apply_pool_;
 
+  // Thread pools for applying transactions pinned to each NUMA node but the
+  // first, whose pool is 'tablet_apply_pool_', if --numa_pin_threads is set.
+  std::vector<std::unique_ptr<ThreadPool>> numa_tablet_apply_pools_;
+
   // Thread pool for Raft-related operations, shared between all tablets.
   std::unique_ptr<ThreadPool> raft_pool_;
 
@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -38,6 +39,8 @@
 #include "kudu/master/ts_descriptor.h"
 #include "kudu/master/ts_manager.h"
 #include "kudu/mini-cluster/internal_mini_cluster.h"
+#include "kudu/rebalance/cluster_status.h"
+#include "kudu/rebalance/rebalancer.h"
 #include "kudu/tserver/mini_tablet_server.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/util/logging_test_util.h"
@@ -49,6 +52,13 @@
 
 using kudu::cluster::InternalMiniCluster;
 using kudu::cluster::InternalMiniClusterOptions;
+using kudu::cluster_summary::HealthCheckResult;
+using kudu::cluster_summary::ReplicaSummary;
+using kudu::cluster_summary::ServerHealthSummary;
+using kudu::cluster_summary::TabletSummary;
+using kudu::rebalance::ClusterRawInfo;
+using kudu::rebalance::Rebalancer;
+using std::map;
 using std::set;
 using std::string;
 using std::unique_ptr;
@@ -62,6 +72,7 @@ DECLARE_int32(raft_heartbeat_interval_ms);
 DECLARE_int32(tablet_copy_download_file_inject_latency_ms);
 DECLARE_int32(tserver_unresponsive_timeout_ms);
 DECLARE_uint32(auto_rebalancing_interval_seconds);
+DECLARE_uint32(auto_rebalancing_max_leader_transfers_per_server);
 DECLARE_uint32(auto_rebalancing_max_moves_per_server);
 DECLARE_uint32(auto_rebalancing_wait_for_replica_moves_seconds);
 
@@ -192,6 +203,36 @@ class AutoRebalancerTest : public KuduTest {
         auto_rebalancer()->moves_scheduled_this_round_for_test_;
   }
 
+  // Gets the leadership transfers the leader master's auto-rebalancer would
+  // make in the cluster described by 'raw_info', returning the resulting
+  // number of leaders per tablet server in 'num_leaders_by_ts_id'.
+  void GetLeaderTransfers(const ClusterRawInfo& raw_info,
+                          const vector<Rebalancer::ReplicaMove>& replica_moves,
+                          int* num_transfers,
+                          int* leader_skew,
+                          map<string, int>* num_leaders_by_ts_id) {
+    int leader_idx;
+    ASSERT_OK(cluster_->GetLeaderMasterIndex(&leader_idx));
+    auto* auto_rebalancer = cluster_->mini_master(leader_idx)->master()->
+        catalog_manager()->auto_rebalancer();
+    vector<AutoRebalancerTask::LeaderTransfer> transfers;
+    auto_rebalancer->GetLeaderTransfers(raw_info, replica_moves, &transfers, leader_skew);
+
+    num_leaders_by_ts_id->clear();
+    for (const auto& tablet : raw_info.tablet_summaries) {
+      for (const auto& replica : tablet.replicas) {
+        if (replica.is_leader) {
+          (*num_leaders_by_ts_id)[replica.ts_uuid]++;
+        }
+      }
+    }
+    for (const auto& transfer : transfers) {
+      (*num_leaders_by_ts_id)[transfer.leader_uuid]--;
+      (*num_leaders_by_ts_id)[transfer.new_leader_uuid]++;
+    }
+    *num_transfers = transfers.size();
+  }
+
   void SetupWorkLoad(int num_tablets, int num_replicas) {
     workload_.reset(new TestWorkload(cluster_.get()));
     workload_->set_num_tablets(num_tablets);
@@ -546,5 +587,76 @@ TEST_F(AutoRebalancerTest, TestHandlingFailedTservers) {
     ASSERT_STR_NOT_CONTAINS(str, "scheduled replica move failed to complete: Network error");
   }
 }
+
+// Leadership is transferred from the tablet servers leading the most tablets
+// to the ones leading the fewest, within the limit of transfers per server and
+// without crossing locations.
+TEST_F(AutoRebalancerTest, LeaderTransfersBalanceLeaders) {
+  cluster_opts_.num_tablet_servers = 0;
+  ASSERT_OK(CreateAndStartCluster());
+  // Keep the auto-rebalancing thread idle while the test uses the task.
+  FLAGS_auto_rebalancing_interval_seconds = 3600;
+
+  // Tablet servers 'ts0', 'ts1' and 'ts2' are in location 'L0' and 'ts3' is
+  // in location 'L1'. Each tablet has a replica on each tablet server, and
+  // all the tablets are led by 'ts0'.
+  const int kNumTablets = 6;
+  ClusterRawInfo raw_info;
+  for (int i = 0; i < 4; ++i) {
+    ServerHealthSummary summary;
+    summary.uuid = Substitute("ts$0", i);
+    summary.ts_location = i < 3 ? "L0" : "L1";
+    raw_info.tserver_summaries.push_back(std::move(summary));
+  }
+  for (int i = 0; i < kNumTablets; ++i) {
+    TabletSummary tablet;
+    tablet.id = Substitute("tablet$0", i);
+    tablet.result = HealthCheckResult::HEALTHY;
+    for (int j = 0; j < 4; ++j) {
+      ReplicaSummary replica;
+      replica.ts_uuid = Substitute("ts$0", j);
+      replica.is_leader = j == 0;
+      replica.is_voter = true;
+      tablet.replicas.push_back(std::move(replica));
+    }
+    raw_info.tablet_summaries.push_back(std::move(tablet));
+  }
+
+  int num_transfers;
+  int leader_skew;
+  map<string, int> num_leaders;
+
+  // Each tablet server takes part in a single transfer by default.
+  NO_FATALS(GetLeaderTransfers(raw_info, {}, &num_transfers, &leader_skew, &num_leaders));
+  ASSERT_EQ(6, leader_skew);
+  ASSERT_EQ(1, num_transfers);
+  ASSERT_EQ(5, num_leaders["ts0"]);
+  ASSERT_EQ(0, num_leaders["ts3"]);
+
+  // With enough transfers, the leaders are balanced within 'L0'.
+  FLAGS_auto_rebalancing_max_leader_transfers_per_server = 10;
+  NO_FATALS(GetLeaderTransfers(raw_info, {}, &num_transfers, &leader_skew, &num_leaders));
+  ASSERT_EQ(4, num_transfers);
+  ASSERT_EQ(2, num_leaders["ts0"]);
+  ASSERT_EQ(2, num_leaders["ts1"]);
+  ASSERT_EQ(2, num_leaders["ts2"]);
+  ASSERT_EQ(0, num_leaders["ts3"]);
+
+  // The tablets being moved keep their leaders.
+  vector<Rebalancer::ReplicaMove> replica_moves;
+  for (int i = 0; i < 3; ++i) {
+    Rebalancer::ReplicaMove move;
+    move.tablet_uuid = Substitute("tablet$0", i);
+    replica_moves.push_back(std::move(move));
+  }
+  NO_FATALS(GetLeaderTransfers(
+      raw_info, replica_moves, &num_transfers, &leader_skew, &num_leaders));
+  ASSERT_EQ(6, leader_skew);
+  ASSERT_EQ(3, num_transfers);
+  ASSERT_EQ(3, num_leaders["ts0"]);
+  ASSERT_EQ(2, num_leaders["ts1"]);
+  ASSERT_EQ(1, num_leaders["ts2"]);
+}
+
 } // namespace master
 } // namespace kudu
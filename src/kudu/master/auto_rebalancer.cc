@@ -17,6 +17,7 @@
 
 #include "kudu/master/auto_rebalancer.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <memory>
@@ -52,6 +53,8 @@
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/cow_object.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
@@ -130,12 +133,34 @@ DEFINE_uint32(auto_rebalancing_wait_for_replica_moves_seconds, 1,
               "How long to wait before checking to see if the scheduled replica movement "
               "in this iteration of auto-rebalancing has completed.");
 
+DEFINE_bool(auto_rebalancing_balance_leaders, true,
+            "Whether the auto-rebalancer also balances the number of leader "
+            "replicas among the tablet servers of each location, by "
+            "transferring the leadership of tablets to their followers.");
+TAG_FLAG(auto_rebalancing_balance_leaders, runtime);
+
+DEFINE_uint32(auto_rebalancing_max_leader_transfers_per_server, 1,
+              "Maximum number of leadership transfers per tablet server in one "
+              "iteration of auto-rebalancing: transferring leadership from and "
+              "to the tablet server are counted as separate transfers.");
+TAG_FLAG(auto_rebalancing_max_leader_transfers_per_server, runtime);
+
+METRIC_DEFINE_gauge_int64(server, auto_rebalancer_leader_skew,
+                          "Auto-Rebalancer Leader Skew",
+                          kudu::MetricUnit::kTablets,
+                          "The largest difference in the number of leader "
+                          "replicas between two tablet servers of the same "
+                          "location, as of the last iteration of "
+                          "auto-rebalancing",
+                          kudu::MetricLevel::kInfo);
+
 namespace kudu {
 
 namespace master {
 
 AutoRebalancerTask::AutoRebalancerTask(CatalogManager* catalog_manager,
-                                       TSManager* ts_manager)
+                                       TSManager* ts_manager,
+                                       MetricEntity* metric_entity)
     : catalog_manager_(catalog_manager),
       ts_manager_(ts_manager),
       shutdown_(1),
@@ -155,7 +180,12 @@ AutoRebalancerTask::AutoRebalancerTask(CatalogManager* catalog_manager,
       FLAGS_auto_rebalancing_load_imbalance_threshold))),
       random_generator_(random_device_()),
       number_of_loop_iterations_for_test_(0),
-      moves_scheduled_this_round_for_test_(0) {
+      moves_scheduled_this_round_for_test_(0),
+      leader_transfers_scheduled_this_round_for_test_(0) {
+  if (metric_entity) {
+    leader_skew_metric_ = metric_entity->FindOrCreateGauge(
+        &METRIC_auto_rebalancer_leader_skew, static_cast<int64_t>(0));
+  }
 }
 
 AutoRebalancerTask::~AutoRebalancerTask() {
@@ -195,6 +225,7 @@ void AutoRebalancerTask::RunLoop() {
       CatalogManager::ScopedLeaderSharedLock l(catalog_manager_);
       if (!l.first_failed_status().ok()) {
         moves_scheduled_this_round_for_test_ = 0;
+        leader_transfers_scheduled_this_round_for_test_ = 0;
         continue;
       }
     }
@@ -247,6 +278,25 @@ void AutoRebalancerTask::RunLoop() {
 
     moves_scheduled_this_round_for_test_ = replica_moves.size();
 
+    // Balance the leaders of the tablets which aren't being moved. A graceful
+    // leadership transfer completes within a few Raft heartbeats, so there's
+    // no need to wait for it: the next iteration works with the new leaders.
+    if (FLAGS_auto_rebalancing_balance_leaders) {
+      vector<LeaderTransfer> leader_transfers;
+      int leader_skew;
+      GetLeaderTransfers(raw_info, replica_moves, &leader_transfers, &leader_skew);
+      if (leader_skew_metric_) {
+        leader_skew_metric_->set_value(leader_skew);
+      }
+      for (const auto& transfer : leader_transfers) {
+        WARN_NOT_OK(TransferLeadership(transfer),
+                    Substitute("failed to transfer leadership of tablet $0 from $1 to $2",
+                               transfer.tablet_id, transfer.leader_uuid,
+                               transfer.new_leader_uuid));
+      }
+      leader_transfers_scheduled_this_round_for_test_ = leader_transfers.size();
+    }
+
     do {
       if (shutdown_.WaitFor(MonoDelta::FromSeconds(
             FLAGS_auto_rebalancing_wait_for_replica_moves_seconds))) {
@@ -368,6 +418,149 @@ Status AutoRebalancerTask::GetMovesUsingRebalancingAlgo(
   return Status::OK();
 }
 
+void AutoRebalancerTask::GetLeaderTransfers(
+    const ClusterRawInfo& raw_info,
+    const vector<Rebalancer::ReplicaMove>& replica_moves,
+    vector<LeaderTransfer>* leader_transfers,
+    int* leader_skew) {
+  DCHECK(leader_transfers);
+  DCHECK(leader_skew);
+  *leader_skew = 0;
+
+  unordered_map<string, string> location_by_ts_id;
+  unordered_map<string, vector<string>> ts_ids_by_location;
+  unordered_map<string, int> num_leaders_by_ts_id;
+  for (const auto& summary : raw_info.tserver_summaries) {
+    location_by_ts_id.emplace(summary.uuid, summary.ts_location);
+    ts_ids_by_location[summary.ts_location].push_back(summary.uuid);
+    num_leaders_by_ts_id.emplace(summary.uuid, 0);
+  }
+
+  unordered_set<string> moving_tablet_ids;
+  for (const auto& move : replica_moves) {
+    moving_tablet_ids.insert(move.tablet_uuid);
+  }
+
+  // The tablets whose leadership may be transferred, by leader, along with
+  // their followers in the same location as the leader.
+  typedef std::pair<string, vector<string>> TabletFollowers;
+  unordered_map<string, vector<TabletFollowers>> candidates_by_leader;
+  for (const auto& tablet : raw_info.tablet_summaries) {
+    const ReplicaSummary* leader = nullptr;
+    for (const auto& replica : tablet.replicas) {
+      if (replica.is_leader) {
+        leader = &replica;
+        break;
+      }
+    }
+    if (!leader || !ContainsKey(num_leaders_by_ts_id, leader->ts_uuid)) {
+      continue;
+    }
+    num_leaders_by_ts_id[leader->ts_uuid]++;
+    if (tablet.result != HealthCheckResult::HEALTHY ||
+        ContainsKey(moving_tablet_ids, tablet.id)) {
+      continue;
+    }
+    const auto& leader_location = FindOrDie(location_by_ts_id, leader->ts_uuid);
+    vector<string> followers;
+    for (const auto& replica : tablet.replicas) {
+      const string* location = FindOrNull(location_by_ts_id, replica.ts_uuid);
+      if (!replica.is_leader && replica.is_voter && location &&
+          *location == leader_location) {
+        followers.push_back(replica.ts_uuid);
+      }
+    }
+    if (!followers.empty()) {
+      candidates_by_leader[leader->ts_uuid].emplace_back(tablet.id, std::move(followers));
+    }
+  }
+  // Pick the tablets to transfer at random rather than always the same ones.
+  for (auto& elem : candidates_by_leader) {
+    std::shuffle(elem.second.begin(), elem.second.end(), random_generator_);
+  }
+
+  vector<LeaderTransfer> transfers;
+  unordered_map<string, int> num_transfers_by_ts_id;
+  const auto has_transfer_budget = [&](const string& ts_id) {
+    return FindWithDefault(num_transfers_by_ts_id, ts_id, 0) <
+        static_cast<int>(FLAGS_auto_rebalancing_max_leader_transfers_per_server);
+  };
+  for (const auto& elem : ts_ids_by_location) {
+    const auto& ts_ids = elem.second;
+    const auto by_num_leaders = [&](const string& lhs, const string& rhs) {
+      return num_leaders_by_ts_id[lhs] < num_leaders_by_ts_id[rhs];
+    };
+    const auto minmax = std::minmax_element(ts_ids.begin(), ts_ids.end(), by_num_leaders);
+    *leader_skew = std::max(*leader_skew, num_leaders_by_ts_id[*minmax.second] -
+                                          num_leaders_by_ts_id[*minmax.first]);
+
+    // Greedily transfer leadership from the tablet server leading the most
+    // tablets to its follower leading the fewest, as long as that reduces the
+    // skew between the two.
+    bool transferred = true;
+    while (transferred) {
+      transferred = false;
+      vector<string> sources(ts_ids);
+      std::sort(sources.begin(), sources.end(), by_num_leaders);
+      for (auto src = sources.rbegin(); src != sources.rend() && !transferred; ++src) {
+        if (!has_transfer_budget(*src)) {
+          continue;
+        }
+        auto* candidates = FindOrNull(candidates_by_leader, *src);
+        if (!candidates) {
+          continue;
+        }
+        for (auto it = candidates->begin(); it != candidates->end(); ++it) {
+          const string* dst = nullptr;
+          for (const auto& follower : it->second) {
+            if (has_transfer_budget(follower) &&
+                num_leaders_by_ts_id[follower] + 1 < num_leaders_by_ts_id[*src] &&
+                (!dst || num_leaders_by_ts_id[follower] < num_leaders_by_ts_id[*dst])) {
+              dst = &follower;
+            }
+          }
+          if (!dst) {
+            continue;
+          }
+          transfers.push_back({ it->first, *src, *dst });
+          num_leaders_by_ts_id[*src]--;
+          num_leaders_by_ts_id[*dst]++;
+          num_transfers_by_ts_id[*src]++;
+          num_transfers_by_ts_id[*dst]++;
+          candidates->erase(it);
+          transferred = true;
+          break;
+        }
+      }
+    }
+  }
+  *leader_transfers = std::move(transfers);
+}
+
+Status AutoRebalancerTask::TransferLeadership(const LeaderTransfer& transfer) {
+  shared_ptr<TSDescriptor> desc;
+  if (!ts_manager_->LookupTSByUUID(transfer.leader_uuid, &desc)) {
+    return Status::NotFound(
+        Substitute("Couldn't find leader replica's tserver $0", transfer.leader_uuid));
+  }
+  shared_ptr<ConsensusServiceProxy> proxy;
+  RETURN_NOT_OK(desc->GetConsensusProxy(messenger_, &proxy));
+
+  LeaderStepDownRequestPB req;
+  LeaderStepDownResponsePB resp;
+  RpcController rpc;
+  req.set_dest_uuid(transfer.leader_uuid);
+  req.set_tablet_id(transfer.tablet_id);
+  req.set_mode(LeaderStepDownMode::GRACEFUL);
+  req.set_new_leader_uuid(transfer.new_leader_uuid);
+  rpc.set_timeout(MonoDelta::FromSeconds(FLAGS_auto_rebalancing_rpc_timeout_seconds));
+  RETURN_NOT_OK(proxy->LeaderStepDown(req, &resp, &rpc));
+  if (resp.has_error()) {
+    return StatusFromPB(resp.error().status());
+  }
+  return Status::OK();
+}
+
 Status AutoRebalancerTask::GetTabletLeader(
     const string& tablet_id,
     string* leader_uuid,
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <random>
 #include <string>
@@ -34,7 +35,10 @@
 namespace kudu {
 
 class HostPort;
+class MetricEntity;
 class Thread;
+template<typename T>
+class AtomicGauge;
 
 namespace rebalance {
 class RebalancingAlgo;
@@ -63,10 +67,17 @@ enum CrossLocations {
 //
 // The auto-rebalancing task continuously wakes up according to its
 // configured poll period. It performs no work when the master is a follower.
+//
+// Alongside the replica moves, the task balances the number of leader replicas
+// among the tablet servers of each location by transferring the leadership of
+// tablets from the tablet servers leading the most tablets to their followers
+// leading the fewest.
 class AutoRebalancerTask {
  public:
 
-  AutoRebalancerTask(CatalogManager* catalog_manager, TSManager* ts_manager);
+  AutoRebalancerTask(CatalogManager* catalog_manager,
+                     TSManager* ts_manager,
+                     MetricEntity* metric_entity);
   ~AutoRebalancerTask();
 
   // Initializes the auto-rebalancer.
@@ -80,6 +91,13 @@ class AutoRebalancerTask {
 
   friend class AutoRebalancerTest;
 
+  // A transfer of the leadership of a tablet to one of its followers.
+  struct LeaderTransfer {
+    std::string tablet_id;
+    std::string leader_uuid;
+    std::string new_leader_uuid;
+  };
+
   // Runs the main loop of the auto-rebalancing thread.
   void RunLoop();
 
@@ -130,6 +148,24 @@ class AutoRebalancerTask {
       std::string* leader_uuid,
       HostPort* leader_hp) const;
 
+  // Gets the leadership transfers to balance the number of leader replicas
+  // among the tablet servers of each location in the cluster described by
+  // 'raw_info'. Only healthy tablets which aren't in 'replica_moves' are
+  // considered, leadership is only transferred to followers in the same
+  // location as the leader, and the number of transfers per tablet server is
+  // limited by a gflag. 'leader_skew' is set to the largest difference in the
+  // number of leader replicas between two tablet servers of the same location,
+  // before the transfers.
+  void GetLeaderTransfers(
+      const rebalance::ClusterRawInfo& raw_info,
+      const std::vector<rebalance::Rebalancer::ReplicaMove>& replica_moves,
+      std::vector<LeaderTransfer>* leader_transfers,
+      int* leader_skew);
+
+  // Asks the leader of the tablet of 'transfer' to gracefully step down in
+  // favor of the new leader.
+  Status TransferLeadership(const LeaderTransfer& transfer);
+
   // Finds replicas that are specified in 'replica_moves' and make requests
   // to have them moved in order to rebalance the cluster.
   // Returns a non-OK status if the replica or the replica's tserver
@@ -182,6 +218,10 @@ class AutoRebalancerTask {
 
   std::shared_ptr<rpc::Messenger> messenger_;
 
+  // The largest difference in the number of leader replicas between two
+  // tablet servers of the same location, as of the last rebalancing round.
+  scoped_refptr<AtomicGauge<int64_t>> leader_skew_metric_;
+
   // Random device and generator for selecting among multiple choices.
   std::random_device random_device_;
   std::mt19937 random_generator_;
@@ -189,6 +229,7 @@ class AutoRebalancerTask {
   // Variables for testing.
   std::atomic<int> number_of_loop_iterations_for_test_;
   std::atomic<int> moves_scheduled_this_round_for_test_;
+  std::atomic<int> leader_transfers_scheduled_this_round_for_test_;
 };
 
 } // namespace master
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -28,11 +29,17 @@
 #include "kudu/master/catalog_manager.h"
 #include "kudu/master/master.pb.h"
 #include "kudu/master/ts_descriptor.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/util/cow_object.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/pb_util.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int64(hot_tablet_live_row_count_growth_threshold);
+DECLARE_int64(hot_tablet_on_disk_size_threshold_mb);
+
+using kudu::pb_util::SecureShortDebugString;
 using std::string;
 using std::vector;
 using strings::Substitute;
@@ -95,6 +102,64 @@ TEST(TableInfoTest, TestAssignmentRanges) {
   }
 }
 
+// Test that cached locations responses are only served while they're up to
+// date with the table's tablets and the tablet servers' registrations.
+TEST(TableInfoTest, TestCachedLocations) {
+  scoped_refptr<TableInfo> table(new TableInfo(CURRENT_TEST_NAME()));
+  GetTableLocationsResponsePB resp;
+  resp.add_tablet_locations()->set_tablet_id("tablet");
+  resp.set_ttl_millis(1000);
+
+  const string kKey = "tablet:1:0:0";
+  GetTableLocationsResponsePB cached;
+  ASSERT_FALSE(table->GetCachedLocations(kKey, 0, &cached));
+  table->CacheLocations(kKey, table->locations_version(), 0, resp);
+  ASSERT_TRUE(table->GetCachedLocations(kKey, 0, &cached));
+  ASSERT_EQ(SecureShortDebugString(resp), SecureShortDebugString(cached));
+
+  // A tablet server has registered since the response was built.
+  ASSERT_FALSE(table->GetCachedLocations(kKey, 1, &cached));
+
+  // The tablets have changed since the response was built.
+  table->InvalidateCachedLocations();
+  ASSERT_FALSE(table->GetCachedLocations(kKey, 0, &cached));
+
+  // A response built before the tablets changed isn't cached.
+  const int64_t stale_version = table->locations_version() - 1;
+  table->CacheLocations(kKey, stale_version, 0, resp);
+  ASSERT_FALSE(table->GetCachedLocations(kKey, 0, &cached));
+}
+
+// Test that tablets are considered hot while their reported size or the growth
+// rate of their live row count exceed the thresholds.
+TEST(TabletInfoTest, TestHotTablet) {
+  scoped_refptr<TableInfo> table(new TableInfo(CURRENT_TEST_NAME()));
+  scoped_refptr<TabletInfo> tablet(new TabletInfo(table, "tablet"));
+  tablet::ReportedTabletStatsPB stats;
+  stats.set_on_disk_size(2 * 1024 * 1024);
+  stats.set_live_row_count(0);
+  tablet->UpdateStats(stats);
+  ASSERT_FALSE(tablet->is_hot());
+
+  FLAGS_hot_tablet_on_disk_size_threshold_mb = 1;
+  tablet->UpdateStats(stats);
+  ASSERT_TRUE(tablet->is_hot());
+  FLAGS_hot_tablet_on_disk_size_threshold_mb = 0;
+  tablet->UpdateStats(stats);
+  ASSERT_FALSE(tablet->is_hot());
+
+  // 1000 rows in at most a few seconds.
+  FLAGS_hot_tablet_live_row_count_growth_threshold = 100;
+  SleepFor(MonoDelta::FromMilliseconds(100));
+  stats.set_live_row_count(1000);
+  tablet->UpdateStats(stats);
+  ASSERT_TRUE(tablet->is_hot());
+
+  // The live row count didn't grow since the last update.
+  tablet->UpdateStats(stats);
+  ASSERT_FALSE(tablet->is_hot());
+}
+
 TEST(TestTSDescriptor, TestReplicaCreationsDecay) {
   TSDescriptor ts("test");
   ASSERT_EQ(0, ts.RecentReplicaCreations());
@@ -62,6 +62,7 @@
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
+#include <google/protobuf/repeated_field.h>
 #include <google/protobuf/stubs/common.h>
 
 #include "kudu/cfile/type_encodings.h"
@@ -87,6 +88,7 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/strings/escaping.h"
+#include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/sysinfo.h"
@@ -111,6 +113,7 @@
 #include "kudu/rpc/remote_user.h"
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/security/cert.h"
 #include "kudu/security/crypto.h"
 #include "kudu/security/openssl_util.h"
@@ -205,6 +208,13 @@ DEFINE_int32(max_create_tablets_per_ts, 60,
              "new table. If 0, no limit is enforced.");
 TAG_FLAG(max_create_tablets_per_ts, advanced);
 
+DEFINE_int32(max_create_tablets_per_rpc, 64,
+             "Maximum number of tablet replicas the master asks a tablet server "
+             "to create with a single CreateTablets RPC. If 1 or less, each "
+             "replica is created with its own CreateTablet RPC.");
+TAG_FLAG(max_create_tablets_per_rpc, advanced);
+TAG_FLAG(max_create_tablets_per_rpc, runtime);
+
 DEFINE_int32(master_failover_catchup_timeout_ms, 30 * 1000, // 30 sec
              "Amount of time to give a newly-elected leader master to load"
              " the previous master's metadata and become active. If this time"
@@ -234,6 +244,40 @@ DEFINE_int32(table_locations_ttl_ms, 5 * 60 * 1000, // 5 minutes
              "until after waiting for the ttl period.");
 TAG_FLAG(table_locations_ttl_ms, advanced);
 
+DEFINE_int32(table_locations_cache_max_entries_per_table, 1024,
+             "Maximum number of GetTableLocations responses the leader master "
+             "caches per table. The cached responses are dropped whenever the "
+             "tablets of the table or their replicas change. Set to 0 to "
+             "disable the cache.");
+TAG_FLAG(table_locations_cache_max_entries_per_table, advanced);
+TAG_FLAG(table_locations_cache_max_entries_per_table, runtime);
+
+DEFINE_int32(master_follower_catalog_refresh_interval_ms, 0,
+             "How often, in milliseconds, a follower master reloads its in-memory "
+             "catalog from its replica of the system catalog, allowing it to serve "
+             "GetTableLocations requests which tolerate stale results. Reloading "
+             "scans the whole system catalog. Set to 0 to only serve such "
+             "requests from the leader master.");
+TAG_FLAG(master_follower_catalog_refresh_interval_ms, experimental);
+TAG_FLAG(master_follower_catalog_refresh_interval_ms, runtime);
+
+DEFINE_int64(hot_tablet_on_disk_size_threshold_mb, 0,
+             "On-disk size, in MiB, of the leader replica of a tablet above which "
+             "the leader master considers the tablet hot. Hot tablets are logged "
+             "and counted by the 'hot_tablets' table metric. Set to 0 to not "
+             "consider the size of tablets.");
+TAG_FLAG(hot_tablet_on_disk_size_threshold_mb, advanced);
+TAG_FLAG(hot_tablet_on_disk_size_threshold_mb, runtime);
+
+DEFINE_int64(hot_tablet_live_row_count_growth_threshold, 0,
+             "Growth rate, in rows per second, of the live row count of a tablet "
+             "above which the leader master considers the tablet hot. The rate is "
+             "computed between the tablet statistics reported by the tablet "
+             "servers, so it only accounts for inserted rows. Set to 0 to not "
+             "consider the growth of tablets.");
+TAG_FLAG(hot_tablet_live_row_count_growth_threshold, advanced);
+TAG_FLAG(hot_tablet_live_row_count_growth_threshold, runtime);
+
 DEFINE_bool(catalog_manager_fail_ts_rpcs, false,
             "Whether all master->TS async calls should fail. Only for testing!");
 TAG_FLAG(catalog_manager_fail_ts_rpcs, hidden);
@@ -398,8 +442,9 @@ namespace master {
 
 class TableLoader : public TableVisitor {
  public:
-  explicit TableLoader(CatalogManager *catalog_manager)
-    : catalog_manager_(catalog_manager) {
+  TableLoader(CatalogManager *catalog_manager, bool log_loaded)
+    : catalog_manager_(catalog_manager),
+      log_loaded_(log_loaded) {
   }
 
   Status VisitTable(const string& table_id,
@@ -435,7 +480,8 @@ class TableLoader : public TableVisitor {
       // It's unnecessary to register metrics for the deleted tables.
       table->RegisterMetrics(catalog_manager_->master_->metric_registry(),
           CatalogManager::NormalizeTableName(metadata.name()));
-      LOG(INFO) << Substitute("Loaded metadata for table $0", table->ToString());
+      LOG_IF(INFO, log_loaded_ || VLOG_IS_ON(1))
+          << Substitute("Loaded metadata for table $0", table->ToString());
     }
     VLOG(2) << Substitute("Metadata for table $0: $1",
                           table->ToString(), SecureShortDebugString(metadata));
@@ -444,6 +490,7 @@ class TableLoader : public TableVisitor {
 
  private:
   CatalogManager *catalog_manager_;
+  const bool log_loaded_;
 
   DISALLOW_COPY_AND_ASSIGN(TableLoader);
 };
@@ -454,8 +501,9 @@ class TableLoader : public TableVisitor {
 
 class TabletLoader : public TabletVisitor {
  public:
-  explicit TabletLoader(CatalogManager *catalog_manager)
-    : catalog_manager_(catalog_manager) {
+  TabletLoader(CatalogManager *catalog_manager, bool log_loaded)
+    : catalog_manager_(catalog_manager),
+      log_loaded_(log_loaded) {
   }
 
   Status VisitTablet(const string& table_id,
@@ -478,8 +526,12 @@ class TabletLoader : public TabletVisitor {
     TabletMetadataLock l(tablet.get(), LockMode::WRITE);
     l.mutable_data()->pb.CopyFrom(metadata);
 
-    // Add the tablet to the tablet manager.
-    catalog_manager_->tablet_map_[tablet->id()] = tablet;
+    // Add the tablet to the tablet manager. The tablets are visited
+    // concurrently, so the tablet map must be updated under a lock.
+    {
+      std::lock_guard<simple_spinlock> map_lock(tablet_map_lock_);
+      catalog_manager_->tablet_map_[tablet->id()] = tablet;
+    }
 
     // Add the tablet to the table.
     bool is_deleted = l.mutable_data()->is_deleted();
@@ -489,8 +541,9 @@ class TabletLoader : public TabletVisitor {
       // from clean state, which is uninitialized for these brand new tablets.
       TabletMetadataLock l(tablet.get(), LockMode::READ);
       table->AddRemoveTablets({ tablet }, {});
-      LOG(INFO) << Substitute("Loaded metadata for tablet $0 (table $1)",
-                              tablet_id, table->ToString());
+      LOG_IF(INFO, log_loaded_ || VLOG_IS_ON(1))
+          << Substitute("Loaded metadata for tablet $0 (table $1)",
+                        tablet_id, table->ToString());
     }
 
     VLOG(2) << Substitute("Metadata for tablet $0: $1",
@@ -500,6 +553,10 @@ class TabletLoader : public TabletVisitor {
 
  private:
   CatalogManager *catalog_manager_;
+  const bool log_loaded_;
+
+  // Protects the catalog manager's tablet map while loading tablets.
+  simple_spinlock tablet_map_lock_;
 
   DISALLOW_COPY_AND_ASSIGN(TabletLoader);
 };
@@ -612,7 +669,9 @@ void CatalogManagerBgTasks::Shutdown() {
 
 void CatalogManagerBgTasks::Run() {
   MonoTime last_tspk_run;
+  MonoTime last_follower_catalog_refresh;
   while (!NoBarrier_Load(&closing_)) {
+    bool refresh_follower_catalog = false;
     {
       CatalogManager::ScopedLeaderSharedLock l(catalog_manager_);
       if (!l.catalog_status().ok()) {
@@ -678,6 +737,25 @@ void CatalogManagerBgTasks::Run() {
           LOG(WARNING) << s.ToString()
                        << ": failed to prepare follower catalog manager, will retry";
         }
+
+        // Check whether it's time to refresh the in-memory catalog used to
+        // serve lookups which allow stale results.
+        const int32_t refresh_interval_ms = FLAGS_master_follower_catalog_refresh_interval_ms;
+        refresh_follower_catalog = refresh_interval_ms > 0 &&
+            (!last_follower_catalog_refresh.Initialized() ||
+             last_follower_catalog_refresh +
+                 MonoDelta::FromMilliseconds(refresh_interval_ms) < MonoTime::Now());
+      }
+    }
+    // Refreshing the follower catalog requires leader_lock_ for writing, so
+    // it must be done once the shared lock above is released.
+    if (refresh_follower_catalog) {
+      Status s = catalog_manager_->RefreshFollowerCatalog();
+      if (s.ok()) {
+        last_follower_catalog_refresh = MonoTime::Now();
+      } else {
+        LOG(WARNING) << s.ToString()
+                     << ": failed to refresh follower catalog, will retry";
       }
     }
     // Wait for a notification or a timeout expiration.
@@ -820,7 +898,8 @@ Status CatalogManager::Init(bool is_first_run) {
 
   if (FLAGS_auto_rebalancing_enabled) {
     unique_ptr<AutoRebalancerTask> task(
-        new AutoRebalancerTask(this, master_->ts_manager()));
+        new AutoRebalancerTask(this, master_->ts_manager(),
+                               master_->metric_entity().get()));
     RETURN_NOT_OK_PREPEND(task->Init(), "failed to initialize auto-rebalancing task");
     auto_rebalancer_ = std::move(task);
   }
@@ -1056,7 +1135,7 @@ Status CatalogManager::InitTokenSigner() {
 void CatalogManager::PrepareForLeadershipTask() {
   {
     // Hack to block this function until InitSysCatalogAsync() is finished.
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
   }
   const RaftConsensus* consensus = sys_catalog_->tablet_replica()->consensus();
   const int64_t term_before_wait = consensus->CurrentTerm();
@@ -1143,7 +1222,7 @@ void CatalogManager::PrepareForLeadershipTask() {
         "Loading table and tablet metadata into memory";
     LOG(INFO) << kLoadMetaOpDescription << "...";
     LOG_SLOW_EXECUTION(WARNING, 1000, LogPrefix() + kLoadMetaOpDescription) {
-      if (!check([this]() { return this->VisitTablesAndTabletsUnlocked(); },
+      if (!check([this]() { return this->VisitTablesAndTabletsUnlocked(/*log_loaded=*/true); },
                  *consensus, term, kLoadMetaOpDescription).ok()) {
         return;
       }
@@ -1261,7 +1340,29 @@ Status CatalogManager::PrepareFollower(MonoTime* last_tspk_run) {
   return Status::OK();
 }
 
-Status CatalogManager::VisitTablesAndTabletsUnlocked() {
+Status CatalogManager::RefreshFollowerCatalog() {
+  // Block catalog lookups, and wait for the existing ones to finish.
+  std::lock_guard<RWMutex> leader_lock_guard(leader_lock_);
+
+  // This master may have been elected leader since the caller checked. The
+  // in-memory catalog of the leader is authoritative, so leave it be.
+  if (Role() == RaftPeerPB::LEADER) {
+    return Status::OK();
+  }
+  RETURN_NOT_OK(VisitTablesAndTabletsUnlocked(/*log_loaded=*/false));
+  follower_catalog_refresh_time_ = MonoTime::Now();
+  return Status::OK();
+}
+
+optional<MonoDelta> CatalogManager::FollowerCatalogStaleness() const {
+  leader_lock_.AssertAcquiredForReading();
+  if (!follower_catalog_refresh_time_.Initialized()) {
+    return none;
+  }
+  return MonoTime::Now() - follower_catalog_refresh_time_;
+}
+
+Status CatalogManager::VisitTablesAndTabletsUnlocked(bool log_loaded) {
   leader_lock_.AssertAcquiredForWriting();
 
   // This lock is held for the entirety of the function because the calls to
@@ -1279,12 +1380,13 @@ Status CatalogManager::VisitTablesAndTabletsUnlocked() {
   normalized_table_names_map_.clear();
   table_ids_map_.clear();
   tablet_map_.clear();
+  follower_catalog_refresh_time_ = MonoTime();
 
   // Visit tables and tablets, load them into memory.
-  TableLoader table_loader(this);
+  TableLoader table_loader(this, log_loaded);
   RETURN_NOT_OK_PREPEND(sys_catalog_->VisitTables(&table_loader),
                         "Failed while visiting tables in sys catalog");
-  TabletLoader tablet_loader(this);
+  TabletLoader tablet_loader(this, log_loaded);
   RETURN_NOT_OK_PREPEND(sys_catalog_->VisitTablets(&tablet_loader),
                         "Failed while visiting tablets in sys catalog");
   return Status::OK();
@@ -1294,7 +1396,7 @@ Status CatalogManager::VisitTablesAndTabletsUnlocked() {
 Status CatalogManager::VisitTablesAndTablets() {
   // Block new catalog operations, and wait for existing operations to finish.
   std::lock_guard<RWMutex> leader_lock_guard(leader_lock_);
-  return VisitTablesAndTabletsUnlocked();
+  return VisitTablesAndTabletsUnlocked(/*log_loaded=*/true);
 }
 
 Status CatalogManager::InitSysCatalogAsync(bool is_first_run) {
@@ -1362,7 +1464,7 @@ void CatalogManager::Shutdown() {
   // tasks for those entries.
   vector<scoped_refptr<TableInfo>> copy;
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     AppendValuesFromMap(table_ids_map_, &copy);
   }
   AbortAndWaitForAllTasks(copy);
@@ -1499,6 +1601,79 @@ Status ValidateClientSchema(const optional<string>& name,
   return Status::OK();
 }
 
+// Validate the TTL of a table, if it has one, against the table's schema.
+Status ValidateTableTtl(const Schema& schema, const TableExtraConfigPB& extra_config) {
+  if (!extra_config.has_ttl_column() && !extra_config.has_ttl_sec()) {
+    return Status::OK();
+  }
+  if (!extra_config.has_ttl_column() || !extra_config.has_ttl_sec()) {
+    return Status::InvalidArgument("the TTL column and the TTL must be set together");
+  }
+  if (extra_config.ttl_sec() <= 0) {
+    return Status::InvalidArgument(Substitute(
+        "TTL must be positive: $0", extra_config.ttl_sec()));
+  }
+  int col_idx = schema.find_column(extra_config.ttl_column());
+  if (col_idx == Schema::kColumnNotFound) {
+    return Status::InvalidArgument(Substitute(
+        "TTL column '$0' does not exist", extra_config.ttl_column()));
+  }
+  // Only key columns are immutable, which makes the expiry of a row
+  // independent of the replica and of the time its updates are applied.
+  if (!schema.is_key_column(col_idx) ||
+      schema.column(col_idx).type_info()->type() != UNIXTIME_MICROS) {
+    return Status::InvalidArgument(Substitute(
+        "TTL column '$0' must be a primary key column of type UNIXTIME_MICROS",
+        extra_config.ttl_column()));
+  }
+  return Status::OK();
+}
+
+// Validate the secondary index columns of a table, if it has any, against
+// the table's schema.
+Status ValidateSecondaryIndexColumns(const Schema& schema,
+                                     const TableExtraConfigPB& extra_config) {
+  set<string> names;
+  for (const string& name : extra_config.secondary_index_columns()) {
+    int col_idx = schema.find_column(name);
+    if (col_idx == Schema::kColumnNotFound) {
+      return Status::InvalidArgument(Substitute(
+          "secondary index column '$0' does not exist", name));
+    }
+    // The rows of a rowset are already sorted by the key.
+    if (schema.is_key_column(col_idx)) {
+      return Status::InvalidArgument(Substitute(
+          "secondary index column '$0' is a primary key column", name));
+    }
+    // The index is ordered by the values' key encoding.
+    if (!IsTypeAllowableInKey(schema.column(col_idx).type_info())) {
+      return Status::InvalidArgument(Substitute(
+          "secondary index column '$0' has type $1, which can't be indexed",
+          name, schema.column(col_idx).type_info()->name()));
+    }
+    if (!names.insert(name).second) {
+      return Status::InvalidArgument(Substitute(
+          "secondary index column '$0' is listed more than once", name));
+    }
+  }
+  return Status::OK();
+}
+
+// Validate the number of group-by columns of the rollup of a table, if it
+// has one, against the table's schema.
+Status ValidateRollup(const Schema& schema, const TableExtraConfigPB& extra_config) {
+  if (!extra_config.has_rollup_group_by_columns()) {
+    return Status::OK();
+  }
+  int num_group_by = extra_config.rollup_group_by_columns();
+  if (num_group_by < 0 || num_group_by > schema.num_key_columns()) {
+    return Status::InvalidArgument(Substitute(
+        "the number of rollup group-by columns must be between 0 and the number "
+        "of primary key columns ($0): $1", schema.num_key_columns(), num_group_by));
+  }
+  return Status::OK();
+}
+
 } // anonymous namespace
 
 // Create a new table.
@@ -1688,6 +1863,12 @@ Status CatalogManager::CreateTable(const CreateTableRequestPB* orig_req,
   // Verify the table's extra configuration properties.
   TableExtraConfigPB extra_config_pb;
   RETURN_NOT_OK(ExtraConfigPBFromPBMap(req.extra_configs(), &extra_config_pb));
+  RETURN_NOT_OK(SetupError(ValidateTableTtl(schema, extra_config_pb),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
+  RETURN_NOT_OK(SetupError(ValidateSecondaryIndexColumns(schema, extra_config_pb),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
+  RETURN_NOT_OK(SetupError(ValidateRollup(schema, extra_config_pb),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
 
   scoped_refptr<TableInfo> table;
   {
@@ -1940,7 +2121,7 @@ Status CatalogManager::FindLockAndAuthorizeTable(
   // Set to true if the client-provided table name and ID refer to different tables.
   bool mismatched_table = false;
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     if (table_identifier.has_table_id()) {
       table = FindPtrOrNull(table_ids_map_, table_identifier.table_id());
 
@@ -2156,6 +2337,7 @@ Status CatalogManager::DeleteTable(const DeleteTableRequestPB& req,
 
     // 5. Commit the dirty tablet state.
     lock.Commit();
+    table->InvalidateCachedLocations();
   }
 
   // 6. Commit the dirty table state.
@@ -2691,6 +2873,15 @@ Status CatalogManager::AlterTable(const AlterTableRequestPB& req,
     RETURN_NOT_OK(ExtraConfigPBFromPBMap(new_extra_configs,
                                          l.mutable_data()->pb.mutable_extra_config()));
   }
+  // The TTL column and the secondary index columns may have been renamed or
+  // dropped.
+  RETURN_NOT_OK(SetupError(ValidateTableTtl(new_schema, l.mutable_data()->pb.extra_config()),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
+  RETURN_NOT_OK(SetupError(ValidateSecondaryIndexColumns(new_schema,
+                                                         l.mutable_data()->pb.extra_config()),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
+  RETURN_NOT_OK(SetupError(ValidateRollup(new_schema, l.mutable_data()->pb.extra_config()),
+                           resp, MasterErrorPB::INVALID_SCHEMA));
 
   // Set to true if columns are altered, added or dropped.
   bool has_schema_changes = !alter_schema_steps.empty();
@@ -2932,7 +3123,7 @@ Status CatalogManager::ListTables(const ListTablesRequestPB* req,
 
   vector<scoped_refptr<TableInfo>> tables_info;
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     for (const TableInfoMap::value_type &entry : normalized_table_names_map_) {
       tables_info.emplace_back(entry.second);
     }
@@ -3029,7 +3220,7 @@ Status CatalogManager::GetTableInfo(const string& table_id, scoped_refptr<TableI
   leader_lock_.AssertAcquiredForReading();
   RETURN_NOT_OK(CheckOnline());
 
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   *table = FindPtrOrNull(table_ids_map_, table_id);
   return Status::OK();
 }
@@ -3039,7 +3230,7 @@ Status CatalogManager::GetAllTables(vector<scoped_refptr<TableInfo>>* tables) {
   RETURN_NOT_OK(CheckOnline());
 
   tables->clear();
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   AppendValuesFromMap(table_ids_map_, tables);
 
   return Status::OK();
@@ -3049,7 +3240,7 @@ Status CatalogManager::TableNameExists(const string& table_name, bool* exists) {
   leader_lock_.AssertAcquiredForReading();
   RETURN_NOT_OK(CheckOnline());
 
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   *exists = ContainsKey(normalized_table_names_map_, NormalizeTableName(table_name));
   return Status::OK();
 }
@@ -3087,7 +3278,7 @@ Status CatalogManager::GetTabletReplica(const string& tablet_id,
                                         scoped_refptr<TabletReplica>* replica) const {
   // Note: CatalogManager has only one table, 'sys_catalog', with only
   // one tablet.
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   if (!sys_catalog_) {
     return Status::ServiceUnavailable("Systable not yet initialized");
   }
@@ -3103,7 +3294,7 @@ Status CatalogManager::GetTabletReplica(const string& tablet_id,
 void CatalogManager::GetTabletReplicas(vector<scoped_refptr<TabletReplica>>* replicas) const {
   // Note: CatalogManager has only one table, 'sys_catalog', with only
   // one tablet.
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   if (!sys_catalog_) {
     return;
   }
@@ -3446,6 +3637,32 @@ class RetrySpecificTSRpcTask : public RetryingTSRpcTask {
   const string permanent_uuid_;
 };
 
+namespace {
+
+// Fills 'req' with the parameters needed to create a replica of 'tablet',
+// except for the destination UUID.
+//
+// The tablet lock must be acquired for reading before making this call.
+void BuildCreateTabletRequest(const scoped_refptr<TabletInfo>& tablet,
+                              const TabletMetadataLock& tablet_lock,
+                              tserver::CreateTabletRequestPB* req) {
+  TableMetadataLock table_lock(tablet->table().get(), LockMode::READ);
+  req->set_table_id(tablet->table()->id());
+  req->set_tablet_id(tablet->id());
+  req->mutable_partition()->CopyFrom(tablet_lock.data().pb.partition());
+  req->set_table_name(table_lock.data().pb.name());
+  req->mutable_schema()->CopyFrom(table_lock.data().pb.schema());
+  req->mutable_partition_schema()->CopyFrom(
+      table_lock.data().pb.partition_schema());
+  req->mutable_config()->CopyFrom(
+      tablet_lock.data().pb.consensus_state().committed_config());
+  req->mutable_extra_config()->CopyFrom(
+      table_lock.data().pb.extra_config());
+  req->set_dimension_label(tablet_lock.data().pb.dimension_label());
+}
+
+} // anonymous namespace
+
 // Fire off the async create tablet.
 // This requires that the new tablet info is locked for write, and the
 // consensus configuration information has been filled into the 'dirty' data.
@@ -3460,21 +3677,21 @@ class AsyncCreateReplica : public RetrySpecificTSRpcTask {
     : RetrySpecificTSRpcTask(master, permanent_uuid, tablet->table()),
       tablet_id_(tablet->id()) {
     deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
+    BuildCreateTabletRequest(tablet, tablet_lock, &req_);
+    req_.set_dest_uuid(permanent_uuid);
+  }
 
-    TableMetadataLock table_lock(tablet->table().get(), LockMode::READ);
+  // Sends the already built 'req', e.g. one which failed to be sent as part
+  // of a CreateTablets RPC.
+  AsyncCreateReplica(Master *master,
+                     const string& permanent_uuid,
+                     const scoped_refptr<TableInfo>& table,
+                     const tserver::CreateTabletRequestPB& req)
+    : RetrySpecificTSRpcTask(master, permanent_uuid, table),
+      tablet_id_(req.tablet_id()),
+      req_(req) {
+    deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
     req_.set_dest_uuid(permanent_uuid);
-    req_.set_table_id(tablet->table()->id());
-    req_.set_tablet_id(tablet->id());
-    req_.mutable_partition()->CopyFrom(tablet_lock.data().pb.partition());
-    req_.set_table_name(table_lock.data().pb.name());
-    req_.mutable_schema()->CopyFrom(table_lock.data().pb.schema());
-    req_.mutable_partition_schema()->CopyFrom(
-        table_lock.data().pb.partition_schema());
-    req_.mutable_config()->CopyFrom(
-        tablet_lock.data().pb.consensus_state().committed_config());
-    req_.mutable_extra_config()->CopyFrom(
-        table_lock.data().pb.extra_config());
-    req_.set_dimension_label(tablet_lock.data().pb.dimension_label());
   }
 
   string type_name() const override { return "CreateTablet"; }
@@ -3519,6 +3736,108 @@ class AsyncCreateReplica : public RetrySpecificTSRpcTask {
   tserver::CreateTabletResponsePB resp_;
 };
 
+// Fire off the async creation of replicas of several tablets of a table on
+// the same tablet server, with a single CreateTablets RPC. Retries only ask
+// for the replicas which failed to be created.
+//
+// Falls back to a CreateTablet RPC per replica if the tablet server doesn't
+// support CreateTablets.
+class AsyncCreateReplicas : public RetrySpecificTSRpcTask {
+ public:
+  AsyncCreateReplicas(Master *master,
+                      const string& permanent_uuid,
+                      const scoped_refptr<TableInfo>& table,
+                      unique_ptr<tserver::CreateTabletsRequestPB> req)
+    : RetrySpecificTSRpcTask(master, permanent_uuid, table),
+      first_tablet_id_(req->tablets(0).tablet_id()),
+      req_(std::move(req)) {
+    deadline_ = start_ts_ + MonoDelta::FromMilliseconds(FLAGS_tablet_creation_timeout_ms);
+    req_->set_dest_uuid(permanent_uuid);
+  }
+
+  string type_name() const override { return "CreateTablets"; }
+
+  string description() const override {
+    return Substitute("CreateTablets RPC for $0 tablets starting with $1 on TS $2",
+                      req_->tablets_size(), first_tablet_id_, permanent_uuid_);
+  }
+
+  // The task is registered under the first tablet of the request.
+  string tablet_id() const override { return first_tablet_id_; }
+
+ protected:
+  void HandleResponse(int attempt) override {
+    if (resp_.has_error()) {
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute(
+          "$0 failed: $1", description(), StatusFromPB(resp_.error().status()).ToString());
+      return;
+    }
+    if (resp_.tablet_responses_size() != req_->tablets_size()) {
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute(
+          "$0: expected $1 responses, got $2", description(),
+          req_->tablets_size(), resp_.tablet_responses_size());
+      return;
+    }
+
+    // Keep only the tablets whose replicas must be requested again.
+    google::protobuf::RepeatedPtrField<tserver::CreateTabletRequestPB> to_retry;
+    for (int i = 0; i < resp_.tablet_responses_size(); i++) {
+      const auto& tablet_resp = resp_.tablet_responses(i);
+      if (!tablet_resp.has_error()) {
+        continue;
+      }
+      const string& tablet_id = req_->tablets(i).tablet_id();
+      Status s = StatusFromPB(tablet_resp.error().status());
+      if (s.IsAlreadyPresent()) {
+        LOG(INFO) << Substitute("CreateTablets RPC for tablet $0 on TS $1 "
+            "returned already present: $2", tablet_id,
+            target_ts_desc_->ToString(), s.ToString());
+        continue;
+      }
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("CreateTablets RPC for tablet $0 on TS $1 failed: $2",
+                     tablet_id, target_ts_desc_->ToString(), s.ToString());
+      to_retry.Add()->Swap(req_->mutable_tablets(i));
+    }
+    req_->mutable_tablets()->Swap(&to_retry);
+    if (req_->tablets_size() == 0) {
+      MarkComplete();
+    }
+  }
+
+  bool SendRequest(int attempt) override {
+    VLOG(1) << Substitute("Sending $0 request to $1 (attempt $2): $3",
+                          type_name(), target_ts_desc_->ToString(), attempt,
+                          SecureDebugString(*req_));
+    ts_proxy_->CreateTabletsAsync(*req_, &resp_, &rpc_,
+                                  [this]() { this->CreateTabletsCallback(); });
+    return true;
+  }
+
+ private:
+  void CreateTabletsCallback() {
+    const auto* err = rpc_.error_response();
+    if (err && err->code() == rpc::ErrorStatusPB::ERROR_NO_SUCH_METHOD &&
+        state() == kStateRunning) {
+      LOG(INFO) << Substitute("TS $0 doesn't support CreateTablets; "
+                              "sending CreateTablet requests separately",
+                              target_ts_desc_->ToString());
+      for (const auto& tablet_req : req_->tablets()) {
+        scoped_refptr<AsyncCreateReplica> task = new AsyncCreateReplica(
+            master_, permanent_uuid_, table(), tablet_req);
+        table()->AddTask(tablet_req.tablet_id(), task);
+        WARN_NOT_OK(task->Run(), "Failed to send new tablet request");
+      }
+      MarkComplete();
+    }
+    RpcCallback();
+  }
+
+  const string first_tablet_id_;
+  unique_ptr<tserver::CreateTabletsRequestPB> req_;
+  tserver::CreateTabletsResponsePB resp_;
+};
+
 // Send a DeleteTablet() RPC request.
 class AsyncDeleteReplica : public RetrySpecificTSRpcTask {
  public:
@@ -4034,7 +4353,7 @@ Status CatalogManager::ProcessTabletReport(
     // We only need to acquire lock_ for the tablet_map_ access, but since it's
     // acquired exclusively so rarely, it's probably cheaper to acquire and
     // hold it for all tablets here than to acquire/release it for each tablet.
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     for (const ReportedTabletPB& report : full_report.updated_tablets()) {
       const string& tablet_id = report.tablet_id();
 
@@ -4331,7 +4650,11 @@ Status CatalogManager::ProcessTabletReport(
         // For the versions >= 1.11.x, the tserver reports stats. But keep in
         // mind that 'live_row_count' is not supported for the legacy replicas.
         tablet->table()->UpdateMetrics(tablet_id, tablet->GetStats(), report.stats());
+        const bool was_hot = tablet->is_hot();
         tablet->UpdateStats(report.stats());
+        if (tablet->is_hot() != was_hot) {
+          tablet->table()->UpdateHotTabletsMetric(tablet->is_hot() ? 1 : -1);
+        }
       } else {
         // For the versions < 1.11.x, the tserver doesn't report stats. Thus,
         // the metrics from the stats should be hidden, for example, when it's
@@ -4344,6 +4667,13 @@ Status CatalogManager::ProcessTabletReport(
   // 11. Unlock the tables; we no longer need to access their state.
   tables_lock.Unlock();
 
+  // The tables whose cached locations the mutations make stale.
+  unordered_set<scoped_refptr<TableInfo>, ScopedRefPtrHashFunctor<TableInfo>,
+                ScopedRefPtrEqualToFunctor<TableInfo>> mutated_tables;
+  for (const auto& tablet : mutated_tablets) {
+    mutated_tables.insert(tablet->table());
+  }
+
   // 12. Write all tablet mutations to the catalog table.
   //
   // SysCatalogTable::Write will short-circuit the case where the data has not
@@ -4378,6 +4708,9 @@ Status CatalogManager::ProcessTabletReport(
 
   // 13. Publish the in-memory tablet mutations and release the locks.
   tablets_lock.Commit();
+  for (const auto& table : mutated_tables) {
+    table->InvalidateCachedLocations();
+  }
 
   // 14. Process all tablet schema version changes.
   //
@@ -4442,7 +4775,7 @@ std::shared_ptr<RaftConsensus> CatalogManager::master_consensus() const {
   // CatalogManager::InitSysCatalogAsync takes lock_ in exclusive mode in order
   // to initialize sys_catalog_, so it's sufficient to take lock_ in shared mode
   // here to protect access to sys_catalog_.
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
   if (!sys_catalog_) {
     return nullptr;
   }
@@ -4499,7 +4832,7 @@ void CatalogManager::SendDeleteTabletRequest(const scoped_refptr<TabletInfo>& ta
 void CatalogManager::ExtractTabletsToProcess(
     vector<scoped_refptr<TabletInfo>>* tablets_to_process) {
 
-  shared_lock<LockType> l(lock_);
+  shared_lock<rw_spinlock> l(lock_.get_lock());
 
   // TODO: At the moment we loop through all the tablets
   //       we can keep a set of tablets waiting for "assignment"
@@ -4812,10 +5145,7 @@ Status CatalogManager::ProcessPendingAssignments(
     }
   }
   // Send the CreateTablet() requests to the servers. This is asynchronous / non-blocking.
-  for (const auto& tablet : deferred.needs_create_rpc) {
-    TabletMetadataLock l(tablet.get(), LockMode::READ);
-    SendCreateTabletRequest(tablet, l);
-  }
+  SendCreateTabletRequests(deferred.needs_create_rpc);
   return Status::OK();
 }
 
@@ -4890,6 +5220,48 @@ void CatalogManager::SendCreateTabletRequest(const scoped_refptr<TabletInfo>& ta
   }
 }
 
+void CatalogManager::SendCreateTabletRequests(const vector<scoped_refptr<TabletInfo>>& tablets) {
+  const int max_tablets_per_rpc = FLAGS_max_create_tablets_per_rpc;
+  if (max_tablets_per_rpc <= 1) {
+    for (const auto& tablet : tablets) {
+      TabletMetadataLock l(tablet.get(), LockMode::READ);
+      SendCreateTabletRequest(tablet, l);
+    }
+    return;
+  }
+
+  // Batch the replicas to create by tablet server and table, since the
+  // tasks sending the requests are tracked per table.
+  struct Batches {
+    scoped_refptr<TableInfo> table;
+    vector<unique_ptr<tserver::CreateTabletsRequestPB>> reqs;
+  };
+  map<pair<string, string>, Batches> batches_by_ts_and_table;
+  for (const auto& tablet : tablets) {
+    TabletMetadataLock l(tablet.get(), LockMode::READ);
+    tablet->set_last_create_tablet_time(MonoTime::Now());
+    const RaftConfigPB& config = l.data().pb.consensus_state().committed_config();
+    for (const RaftPeerPB& peer : config.peers()) {
+      auto& batches = batches_by_ts_and_table[{ peer.permanent_uuid(), tablet->table()->id() }];
+      if (batches.reqs.empty() || batches.reqs.back()->tablets_size() >= max_tablets_per_rpc) {
+        batches.table = tablet->table();
+        batches.reqs.emplace_back(new tserver::CreateTabletsRequestPB);
+      }
+      BuildCreateTabletRequest(tablet, l, batches.reqs.back()->add_tablets());
+    }
+  }
+  for (auto& e : batches_by_ts_and_table) {
+    const string& ts_uuid = e.first.first;
+    auto& batches = e.second;
+    for (auto& req : batches.reqs) {
+      scoped_refptr<AsyncCreateReplicas> task = new AsyncCreateReplicas(
+          master_, ts_uuid, batches.table, std::move(req));
+      batches.table->AddTask(task->tablet_id(), task);
+      WARN_NOT_OK(task->Run(), "Failed to send new tablets request");
+    }
+  }
+}
+
 Status CatalogManager::BuildLocationsForTablet(
     const scoped_refptr<TabletInfo>& tablet,
     ReplicaTypeFilter filter,
@@ -5003,7 +5375,7 @@ Status CatalogManager::GetTabletLocations(const string& tablet_id,
   locs_pb->mutable_interned_replicas()->Clear();
   scoped_refptr<TabletInfo> tablet_info;
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     // It's OK to return NOT_FOUND back to the client, even with authorization enabled,
     // because tablet IDs are randomly generated and don't carry user data.
     if (!FindCopy(tablet_map_, tablet_id, &tablet_info)) {
@@ -5028,7 +5400,7 @@ Status CatalogManager::ReplaceTablet(const string& tablet_id, ReplaceTabletRespo
   // Lookup the tablet-to-be-replaced and get its table.
   scoped_refptr<TabletInfo> old_tablet;
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     if (!FindCopy(tablet_map_, tablet_id, &old_tablet)) {
       return Status::NotFound(Substitute("Unknown tablet $0", tablet_id));
     }
@@ -5138,9 +5510,29 @@ Status CatalogManager::GetTableLocations(const GetTableLocationsRequestPB* req,
                                           &table, &l));
   RETURN_NOT_OK(CheckIfTableDeletedOrNotRunning(&l, resp));
 
+  // Read the versions before the tablets so that a response built from
+  // tablets changed in the meantime isn't cached as up to date.
+  const int64_t locations_version = table->locations_version();
+  const int64_t ts_epoch = master_->ts_manager()->registration_epoch();
+
   vector<scoped_refptr<TabletInfo>> tablets_in_range;
   table->GetTabletsInRange(req, &tablets_in_range);
 
+  // Requests with different partition keys falling into the same tablets get
+  // the same response, so the cached responses are keyed by the tablets.
+  string cache_key;
+  if (!tablets_in_range.empty()) {
+    cache_key = Substitute("$0:$1:$2:$3",
+                           tablets_in_range.front()->id(),
+                           tablets_in_range.size(),
+                           req->replica_type_filter(),
+                           req->intern_ts_infos_in_response());
+    if (table->GetCachedLocations(cache_key, ts_epoch, resp)) {
+      resp->set_ttl_millis(FLAGS_table_locations_ttl_ms);
+      return Status::OK();
+    }
+  }
+
   TSInfosDict infos_dict;
 
   for (const auto& tablet : tablets_in_range) {
@@ -5173,6 +5565,9 @@ Status CatalogManager::GetTableLocations(const GetTableLocationsRequestPB* req,
   for (auto& pb : infos_dict.ts_info_pbs) {
     resp->mutable_ts_infos()->AddAllocated(pb.release());
   }
+  if (!cache_key.empty() && !resp->has_error()) {
+    table->CacheLocations(std::move(cache_key), locations_version, ts_epoch, *resp);
+  }
   resp->set_ttl_millis(FLAGS_table_locations_ttl_ms);
   return Status::OK();
 }
@@ -5184,7 +5579,7 @@ void CatalogManager::DumpState(std::ostream* out) const {
   // Copy the internal state so that, if the output stream blocks,
   // we don't end up holding the lock for a long time.
   {
-    shared_lock<LockType> l(lock_);
+    shared_lock<rw_spinlock> l(lock_.get_lock());
     ids_copy = table_ids_map_;
     names_copy = normalized_table_names_map_;
     tablets_copy = tablet_map_;
@@ -5402,6 +5797,7 @@ bool CatalogManager::ScopedLeaderSharedLock::CheckIsInitializedAndIsLeaderOrResp
 
 INITTED_OR_RESPOND(ConnectToMasterResponsePB);
 INITTED_OR_RESPOND(GetMasterRegistrationResponsePB);
+INITTED_OR_RESPOND(GetTableLocationsResponsePB);
 INITTED_OR_RESPOND(TSHeartbeatResponsePB);
 INITTED_AND_LEADER_OR_RESPOND(AlterTableResponsePB);
 INITTED_AND_LEADER_OR_RESPOND(ChangeTServerStateResponsePB);
@@ -5427,7 +5823,8 @@ TabletInfo::TabletInfo(scoped_refptr<TableInfo> table, string tablet_id)
     : tablet_id_(std::move(tablet_id)),
       table_(std::move(table)),
       last_create_tablet_time_(MonoTime::Now()),
-      reported_schema_version_(NOT_YET_REPORTED) {}
+      reported_schema_version_(NOT_YET_REPORTED),
+      is_hot_(false) {}
 
 TabletInfo::~TabletInfo() {
 }
@@ -5504,8 +5901,43 @@ string TabletInfo::ToString() const {
 
 
 void TabletInfo::UpdateStats(ReportedTabletStatsPB stats) {
+  const MonoTime now = MonoTime::Now();
+  const uint64_t on_disk_size = stats.on_disk_size();
+  const uint64_t live_row_count = stats.live_row_count();
+  bool is_hot = false;
+  bool was_hot;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    const int64_t size_threshold_mb = FLAGS_hot_tablet_on_disk_size_threshold_mb;
+    if (size_threshold_mb > 0 &&
+        on_disk_size > static_cast<uint64_t>(size_threshold_mb) * 1024 * 1024) {
+      is_hot = true;
+    }
+    const int64_t growth_threshold = FLAGS_hot_tablet_live_row_count_growth_threshold;
+    if (growth_threshold > 0 && last_stats_update_time_.Initialized() &&
+        stats.has_live_row_count() && stats_.has_live_row_count()) {
+      const double elapsed_secs = (now - last_stats_update_time_).ToSeconds();
+      const double growth = static_cast<double>(live_row_count) -
+                            static_cast<double>(stats_.live_row_count());
+      if (elapsed_secs > 0 && growth / elapsed_secs > growth_threshold) {
+        is_hot = true;
+      }
+    }
+    was_hot = is_hot_;
+    is_hot_ = is_hot;
+    stats_ = std::move(stats);
+    last_stats_update_time_ = now;
+  }
+  if (is_hot != was_hot) {
+    LOG(INFO) << Substitute("Tablet $0 is $1: on-disk size $2, live row count $3",
+                            ToString(), is_hot ? "hot" : "no longer hot",
+                            HumanReadableNumBytes::ToString(on_disk_size), live_row_count);
+  }
+}
+
+bool TabletInfo::is_hot() const {
   std::lock_guard<simple_spinlock> l(lock_);
-  stats_ = std::move(stats);
+  return is_hot_;
 }
 
 ReportedTabletStatsPB TabletInfo::GetStats() const {
@@ -5522,7 +5954,9 @@ void PersistentTabletInfo::set_state(SysTabletsEntryPB::State state, const strin
 // TableInfo
 ////////////////////////////////////////////////////////////
 
-TableInfo::TableInfo(string table_id) : table_id_(std::move(table_id)) {}
+TableInfo::TableInfo(string table_id)
+    : table_id_(std::move(table_id)),
+      locations_version_(0) {}
 
 TableInfo::~TableInfo() {
 }
@@ -5546,6 +5980,9 @@ void TableInfo::AddRemoveTablets(const vector<scoped_refptr<TabletInfo>>& tablet
     DecrementSchemaVersionCountUnlocked(tablet->reported_schema_version());
     // Remove the table metrics for the deleted tablets.
     RemoveMetrics(tablet->id(), tablet->GetStats());
+    if (tablet->is_hot()) {
+      UpdateHotTabletsMetric(-1);
+    }
   }
   for (const auto& tablet : tablets_to_add) {
     TabletInfo* old = nullptr;
@@ -5568,6 +6005,52 @@ void TableInfo::AddRemoveTablets(const vector<scoped_refptr<TabletInfo>>& tablet
     DCHECK(schema_version_counts_.empty());
   }
 #endif
+  InvalidateCachedLocations();
+}
+
+void TableInfo::InvalidateCachedLocations() {
+  locations_version_++;
+  std::lock_guard<rw_spinlock> l(locations_cache_lock_);
+  locations_cache_.clear();
+}
+
+bool TableInfo::GetCachedLocations(const string& key,
+                                   int64_t ts_registration_epoch,
+                                   GetTableLocationsResponsePB* resp) const {
+  shared_ptr<const GetTableLocationsResponsePB> cached;
+  {
+    shared_lock<rw_spinlock> l(locations_cache_lock_);
+    const CachedLocations* entry = FindOrNull(locations_cache_, key);
+    if (!entry ||
+        entry->version != locations_version_.load() ||
+        entry->ts_registration_epoch != ts_registration_epoch) {
+      return false;
+    }
+    cached = entry->resp;
+  }
+  // Copy outside of the lock: the responses of large tables are big.
+  resp->CopyFrom(*cached);
+  return true;
+}
+
+void TableInfo::CacheLocations(string key,
+                               int64_t version,
+                               int64_t ts_registration_epoch,
+                               const GetTableLocationsResponsePB& resp) {
+  const int32_t max_entries = FLAGS_table_locations_cache_max_entries_per_table;
+  if (max_entries <= 0) {
+    return;
+  }
+  auto cached = std::make_shared<const GetTableLocationsResponsePB>(resp);
+  std::lock_guard<rw_spinlock> l(locations_cache_lock_);
+  // The response may have been built from tablets which have since changed.
+  if (version != locations_version_.load()) {
+    return;
+  }
+  if (locations_cache_.size() >= static_cast<size_t>(max_entries)) {
+    locations_cache_.clear();
+  }
+  locations_cache_[std::move(key)] = { version, ts_registration_epoch, std::move(cached) };
 }
 
 void TableInfo::GetTabletsInRange(const GetTableLocationsRequestPB* req,
@@ -5822,6 +6305,11 @@ void TableInfo::RemoveMetrics(const string& tablet_id,
   }
 }
 
+void TableInfo::UpdateHotTabletsMetric(int64_t delta) {
+  if (!metrics_) return;
+  metrics_->hot_tablets->IncrementBy(delta);
+}
+
 void TableInfo::UpdateMetricsAttrs(const string& new_table_name) {
   if (metric_entity_) {
     metric_entity_->SetAttribute("table_name", new_table_name);
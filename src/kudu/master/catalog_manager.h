@@ -193,9 +193,15 @@ class TabletInfo : public RefCountedThreadSafe<TabletInfo> {
   // No synchronization needed.
   std::string ToString() const;
 
-  // Update the stats.
+  // Update the stats, and whether the tablet is hot: whether the on-disk size
+  // or the growth rate of the live row count of its leader replica exceed the
+  // thresholds set by --hot_tablet_on_disk_size_threshold_mb and
+  // --hot_tablet_live_row_count_growth_threshold.
   void UpdateStats(tablet::ReportedTabletStatsPB stats);
 
+  // Whether the tablet was hot as of its last stats update.
+  bool is_hot() const;
+
   // Return the stats.
   tablet::ReportedTabletStatsPB GetStats() const;
 
@@ -223,6 +229,11 @@ class TabletInfo : public RefCountedThreadSafe<TabletInfo> {
   // Cached stats for the LEADER replica.
   tablet::ReportedTabletStatsPB stats_;
 
+  // The last time the stats were updated, and whether the tablet was hot as
+  // of that update.
+  MonoTime last_stats_update_time_;
+  bool is_hot_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletInfo);
 };
 
@@ -323,6 +334,33 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
     return tablet_map_.size();
   }
 
+  // Returns the version of the locations of the table's tablets. It changes
+  // whenever a tablet is added to or removed from the table, or the metadata
+  // of one of its tablets changes.
+  int64_t locations_version() const {
+    return locations_version_.load();
+  }
+
+  // Bumps the locations version, dropping the cached locations responses.
+  // Must be called after publishing the changes which make them stale.
+  void InvalidateCachedLocations();
+
+  // Copies into 'resp' the cached GetTableLocations response for the request
+  // identified by 'key', if there's one built at the current locations
+  // version and with the tablet server registrations of
+  // 'ts_registration_epoch'. Returns whether there was one.
+  bool GetCachedLocations(const std::string& key,
+                          int64_t ts_registration_epoch,
+                          GetTableLocationsResponsePB* resp) const;
+
+  // Caches 'resp' as the response to the request identified by 'key', built
+  // from the table's tablets at locations version 'version' and with the
+  // tablet server registrations of 'ts_registration_epoch'.
+  void CacheLocations(std::string key,
+                      int64_t version,
+                      int64_t ts_registration_epoch,
+                      const GetTableLocationsResponsePB& resp);
+
   // Register metrics for the table.
   void RegisterMetrics(MetricRegistry* metric_registry, const std::string& table_name);
 
@@ -341,6 +379,9 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
   void RemoveMetrics(const std::string& tablet_id,
                      const tablet::ReportedTabletStatsPB& old_stats);
 
+  // Add 'delta' to the number of hot tablets in the table's metrics.
+  void UpdateHotTabletsMetric(int64_t delta);
+
   // Update the attributes of the metrics.
   void UpdateMetricsAttrs(const std::string& new_table_name);
 
@@ -390,6 +431,23 @@ class TableInfo : public RefCountedThreadSafe<TableInfo> {
   scoped_refptr<MetricEntity> metric_entity_;
   std::unique_ptr<TableMetrics> metrics_;
 
+  // See locations_version().
+  std::atomic<int64_t> locations_version_;
+
+  // A GetTableLocations response, cached along with the versions of the
+  // state it was built from.
+  struct CachedLocations {
+    int64_t version;
+    int64_t ts_registration_epoch;
+    std::shared_ptr<const GetTableLocationsResponsePB> resp;
+  };
+
+  // Protects locations_cache_.
+  mutable rw_spinlock locations_cache_lock_;
+
+  // Cached GetTableLocations responses, keyed by request.
+  std::unordered_map<std::string, CachedLocations> locations_cache_;
+
   DISALLOW_COPY_AND_ASSIGN(TableInfo);
 };
 
@@ -661,6 +719,13 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
                            GetTableLocationsResponsePB* resp,
                            boost::optional<const std::string&> user);
 
+  // Returns how long ago this follower master refreshed its in-memory catalog
+  // from its replica of the system catalog, or none if it hasn't done so
+  // since it last loaded the catalog as the leader.
+  //
+  // Requires that leader_lock_ is held for reading.
+  boost::optional<MonoDelta> FollowerCatalogStaleness() const;
+
   struct TSInfosDict {
     std::vector<std::unique_ptr<TSInfoPB>> ts_info_pbs;
     google::dense_hash_map<StringPiece, int, GoodFastHash<StringPiece>> uuid_to_idx;
@@ -868,9 +933,17 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   // of authn tokens.
   Status PrepareFollowerTokenVerifier();
 
+  // Reloads the in-memory catalog of a follower master from its replica of
+  // the system catalog, so that it may serve lookups allowing stale results.
+  // Does nothing if this master is the leader.
+  Status RefreshFollowerCatalog();
+
   // Clears out the existing metadata (by-name map, table-id map, and tablet
   // map), and loads table and tablet metadata into memory.
-  Status VisitTablesAndTabletsUnlocked();
+  //
+  // If 'log_loaded' is false, the loaded tables and tablets are only logged
+  // at higher verbosity levels.
+  Status VisitTablesAndTabletsUnlocked(bool log_loaded);
   // This is called by tests only.
   Status VisitTablesAndTablets();
 
@@ -1043,6 +1116,13 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   void SendCreateTabletRequest(const scoped_refptr<TabletInfo>& tablet,
                                const TabletMetadataLock& tablet_lock);
 
+  // Send the requests to create the replicas of 'tablets', batching the
+  // replicas of each table on each tablet server into CreateTablets RPCs of
+  // up to --max_create_tablets_per_rpc replicas.
+  //
+  // This must be called after persisting the tablets' state as CREATING.
+  void SendCreateTabletRequests(const std::vector<scoped_refptr<TabletInfo>>& tablets);
+
   // Send the "alter table request" to all tablets of the specified table.
   void SendAlterTableRequest(const scoped_refptr<TableInfo>& table);
 
@@ -1078,7 +1158,12 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   // easy to make a "gettable set".
 
   // Lock protecting the various maps and sets below.
-  typedef rw_spinlock LockType;
+  //
+  // The maps are read on every tablet location lookup and tablet report, but
+  // only written by DDL operations and on leader election, so readers take
+  // the per-CPU lock of their core (shared_lock on 'lock_.get_lock()')
+  // rather than all bouncing the same cache line.
+  typedef percpu_rwlock LockType;
   mutable LockType lock_;
 
   // Table maps: table-id -> TableInfo and normalized-table-name -> TableInfo
@@ -1163,6 +1248,11 @@ class CatalogManager : public tserver::TabletReplicaLookupIf {
   // Always acquire this lock before state_lock_.
   RWMutex leader_lock_;
 
+  // The last time the in-memory catalog was refreshed by
+  // RefreshFollowerCatalog(). Uninitialized if it was last loaded by the
+  // leader. Protected by leader_lock_.
+  MonoTime follower_catalog_refresh_time_;
+
   // Cached information on master addresses. It's populated in Init() since the
   // membership of masters' Raft consensus is static (i.e. no new members are
   // added or any existing removed).
@@ -195,5 +195,33 @@ TEST_F(LocationCacheTest, ConcurrentRequests) {
   }
 }
 
+// Concurrent requests for the same key run the location mapping command once.
+TEST_F(LocationCacheTest, ConcurrentRequestsForSameKey) {
+  static constexpr auto kNumThreads = 32;
+  const string kRefLocation = "/ref_location";
+  const string cmd_path = JoinPathSegments(GetTestExecutableDirectory(),
+                                           "testdata/first_argument.sh");
+  const string location_mapping_cmd = Substitute("$0 $1",
+                                                 cmd_path, kRefLocation);
+  LocationCache cache(location_mapping_cmd, metric_entity_.get());
+
+  vector<thread> threads;
+  threads.reserve(kNumThreads);
+  for (auto idx = 0; idx < kNumThreads; ++idx) {
+    threads.emplace_back([&cache, &kRefLocation]() {
+      string location;
+      auto s = cache.GetLocation("key", &location);
+      CHECK(s.ok()) << s.ToString();
+      CHECK_EQ(kRefLocation, location);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // Only the first query ran the command, whether the others waited for it
+  // or found its result in the cache.
+  NO_FATALS(CheckMetrics(kNumThreads, kNumThreads - 1));
+}
+
 } // namespace master
 } // namespace kudu
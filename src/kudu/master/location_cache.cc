@@ -18,6 +18,7 @@
 #include "kudu/master/location_cache.h"
 
 #include <cstdio>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -48,6 +49,7 @@ METRIC_DEFINE_counter(server, location_mapping_cache_queries,
                       "Number of queries to the location mapping cache",
                       kudu::MetricLevel::kDebug);
 
+using std::shared_ptr;
 using std::string;
 using std::vector;
 using strings::Substitute;
@@ -104,19 +106,56 @@ Status LocationCache::GetLocation(const string& key, string* location) {
       return Status::OK();
     }
   }
+  // The location isn't cached yet: run the location mapping command unless
+  // it's already running for the key, in which case wait for its result.
+  shared_ptr<PendingLocation> pending;
+  bool run_cmd = false;
+  {
+    std::lock_guard<rw_spinlock> l(location_map_lock_);
+    const auto* value_ptr = FindOrNull(location_map_, key);
+    if (value_ptr) {
+      *location = *value_ptr;
+      if (PREDICT_TRUE(location_mapping_cache_hits_)) {
+        location_mapping_cache_hits_->Increment();
+      }
+      return Status::OK();
+    }
+    auto& pending_ref = pending_locations_[key];
+    if (!pending_ref) {
+      pending_ref = std::make_shared<PendingLocation>();
+      run_cmd = true;
+    }
+    pending = pending_ref;
+  }
+  if (!run_cmd) {
+    pending->done.Wait();
+    if (pending->status.ok()) {
+      *location = pending->location;
+      if (PREDICT_TRUE(location_mapping_cache_hits_)) {
+        location_mapping_cache_hits_->Increment();
+      }
+    }
+    return pending->status;
+  }
+
   string value;
   TRACE(Substitute("key $0: assigning location", key));
   Status s = GetLocationFromLocationMappingCmd(
       location_mapping_cmd_, key, &value);
   TRACE(Substitute("key $0: assigned location '$1'", key, value));
-  if (s.ok()) {
-    CHECK(!value.empty());
+  {
     std::lock_guard<rw_spinlock> l(location_map_lock_);
-    // This simple implementation doesn't protect against multiple runs of the
-    // location-mapping command for the same key.
-    // TODO(KUDU-2771): queue concurrent requests for the same key
-    InsertIfNotPresent(&location_map_, key, value);
-    *location = value;
+    if (s.ok()) {
+      CHECK(!value.empty());
+      InsertIfNotPresent(&location_map_, key, value);
+    }
+    pending_locations_.erase(key);
+  }
+  pending->status = s;
+  pending->location = value;
+  pending->done.CountDown();
+  if (s.ok()) {
+    *location = std::move(value);
   }
   return s;
 }
@@ -16,11 +16,13 @@
 // under the License.
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/status.h"
@@ -45,7 +47,8 @@ class LocationCache {
   // identifier.
   //
   // If no cached location is found, the location mapping command is run,
-  // caching the result for the lifetime of the cache.
+  // caching the result for the lifetime of the cache. Concurrent requests for
+  // the same key which isn't cached yet wait for a single run of the command.
   //
   // This method returns an error if there was an issue running the location
   // assignment command.
@@ -75,12 +78,27 @@ class LocationCache {
   // results in the location assignment command being run.
   scoped_refptr<Counter> location_mapping_cache_queries_;
 
-  // Spinlock to protect the location assignment map (location_map_).
+  // The result of a run of the location mapping command, shared by the
+  // requests for its key which arrive while it's running.
+  struct PendingLocation {
+    PendingLocation() : done(1) {}
+
+    // Counted down once 'status' and 'location' are set.
+    CountDownLatch done;
+    Status status;
+    std::string location;
+  };
+
+  // Spinlock to protect the location assignment map (location_map_) and the
+  // in-flight runs of the location mapping command (pending_locations_).
   rw_spinlock location_map_lock_;
 
   // The location assignment map: dictionary of key --> location.
   std::unordered_map<std::string, std::string> location_map_;
 
+  // The keys the location mapping command is running for.
+  std::unordered_map<std::string, std::shared_ptr<PendingLocation>> pending_locations_;
+
   DISALLOW_COPY_AND_ASSIGN(LocationCache);
 };
 
@@ -17,6 +17,8 @@
 
 #include "kudu/master/master_service.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -96,6 +98,8 @@ DEFINE_bool(master_support_authz_tokens, true,
 TAG_FLAG(master_support_authz_tokens, hidden);
 
 using boost::make_optional;
+using boost::none;
+using boost::optional;
 using google::protobuf::Message;
 using kudu::consensus::ReplicaManagementInfoPB;
 using kudu::pb_util::SecureDebugString;
@@ -320,6 +324,9 @@ void MasterServiceImpl::TSHeartbeat(const TSHeartbeatRequestPB* req,
   ts_desc->set_num_live_replicas_by_dimension(
       TabletNumByDimensionMap(req->num_live_tablets_by_dimension().begin(),
                               req->num_live_tablets_by_dimension().end()));
+  if (req->has_load()) {
+    ts_desc->set_load(req->load());
+  }
 
   // 5. Only leaders handle tablet reports.
   if (is_leader_master && req->has_tablet_report()) {
@@ -331,9 +338,11 @@ void MasterServiceImpl::TSHeartbeat(const TSHeartbeatRequestPB* req,
     }
     // If we previously needed a full tablet report for the tserver (e.g.
     // because we need to recheck replica states after exiting from maintenance
-    // mode) and have just received a full report, mark that we no longer need
-    // a full tablet report.
-    if (!req->tablet_report().is_incremental()) {
+    // mode) and have just received a full report, or the last part of a full
+    // report split into incremental ones, mark that we no longer need a full
+    // tablet report.
+    if (!req->tablet_report().is_incremental() ||
+        req->tablet_report().completes_full_report()) {
       ts_desc->UpdateNeedsFullTabletReport(false);
     }
   }
@@ -512,7 +521,20 @@ void MasterServiceImpl::GetTableLocations(const GetTableLocationsRequestPB* req,
                "requestor", rpc->requestor_string());
 
   CatalogManager::ScopedLeaderSharedLock l(server_->catalog_manager());
-  if (!l.CheckIsInitializedAndIsLeaderOrRespond(resp, rpc)) {
+  if (!l.CheckIsInitializedOrRespond(resp, rpc)) {
+    return;
+  }
+
+  // A follower master may serve the request if its catalog is recent enough
+  // for the client.
+  optional<MonoDelta> staleness;
+  if (!l.leader_status().ok() && l.owns_lock() && req->has_max_staleness_ms()) {
+    staleness = server_->catalog_manager()->FollowerCatalogStaleness();
+    if (staleness && staleness->ToMilliseconds() > req->max_staleness_ms()) {
+      staleness = none;
+    }
+  }
+  if (!staleness && !l.CheckIsInitializedAndIsLeaderOrRespond(resp, rpc)) {
     return;
   }
 
@@ -521,6 +543,12 @@ void MasterServiceImpl::GetTableLocations(const GetTableLocationsRequestPB* req,
   }
   Status s = server_->catalog_manager()->GetTableLocations(
       req, resp, make_optional<const string&>(rpc->remote_user().username()));
+  if (staleness && s.ok() && !resp->has_error()) {
+    const int64_t staleness_ms = staleness->ToMilliseconds();
+    resp->set_staleness_ms(staleness_ms);
+    resp->set_ttl_millis(std::min<int64_t>(resp->ttl_millis(),
+                                           req->max_staleness_ms() - staleness_ms));
+  }
   CheckRespErrorOrSetUnknown(s, resp);
   rpc->RespondSuccess();
 }
@@ -29,16 +29,20 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/master/master.pb.h"
 #include "kudu/master/ts_descriptor.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_double(placement_resource_load_weight);
+
 using boost::make_optional;
 using boost::none;
 using boost::optional;
@@ -1027,5 +1031,58 @@ TEST_F(PlacementPolicyTest, PlaceTabletReplicasWithNewTabletServers) {
   }
 }
 
+// Verify that the resource usage reported by the tablet servers is taken into
+// account when placing replicas on tablet servers with the same number of
+// replicas.
+TEST_F(PlacementPolicyTest, PlaceTabletReplicasByResourceLoad) {
+  const vector<LocationInfo> cluster_info = {
+    { "", { { "ts0", 10 }, { "ts1", 10 }, } },
+  };
+  const auto set_loads = [&]() {
+    TabletServerLoadPB heavy;
+    heavy.set_on_disk_data_bytes(3000);
+    heavy.set_write_rows_per_sec(300);
+    heavy.set_memory_pressure(0.6);
+    TabletServerLoadPB light;
+    light.set_on_disk_data_bytes(1000);
+    light.set_write_rows_per_sec(100);
+    light.set_memory_pressure(0.2);
+    GetDescriptors({ "ts0" }).front()->set_load(heavy);
+    GetDescriptors({ "ts1" }).front()->set_load(light);
+  };
+  const auto place_replicas = [&](int num_replicas, map<string, int>* placement_stats) {
+    PlacementPolicy policy(descriptors(), rng());
+    for (auto i = 0; i < num_replicas; ++i) {
+      TSDescriptorVector result;
+      ASSERT_OK(policy.PlaceTabletReplicas(1, none, &result));
+      ASSERT_EQ(1, result.size());
+      ++(*placement_stats)[result.front()->permanent_uuid()];
+    }
+  };
+
+  // The less loaded tablet server gets the new replicas until its number of
+  // replicas outweighs its lower resource usage.
+  {
+    ASSERT_OK(Prepare(cluster_info));
+    set_loads();
+    map<string, int> placement_stats;
+    NO_FATALS(place_replicas(5, &placement_stats));
+    ASSERT_EQ(1, placement_stats.size());
+    ASSERT_EQ(5, placement_stats["ts1"]);
+  }
+
+  // With the resource usage ignored, the replicas are evenly spread.
+  {
+    FLAGS_placement_resource_load_weight = 0;
+    ASSERT_OK(Prepare(cluster_info));
+    set_loads();
+    map<string, int> placement_stats;
+    NO_FATALS(place_replicas(10, &placement_stats));
+    ASSERT_EQ(2, placement_stats.size());
+    ASSERT_EQ(5, placement_stats["ts0"]);
+    ASSERT_EQ(5, placement_stats["ts1"]);
+  }
+}
+
 } // namespace master
 } // namespace kudu
@@ -17,6 +17,7 @@
 
 #include "kudu/master/placement_policy.h"
 
+#include <algorithm>
 #include <iterator>
 #include <limits>
 #include <map>
@@ -30,14 +31,28 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/master/master.pb.h"
 #include "kudu/master/ts_descriptor.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 
+DEFINE_double(placement_resource_load_weight, 0.5,
+              "How much the resource usage reported by the tablet servers "
+              "(on-disk size, write and scan rates, memory pressure and "
+              "maintenance backlog) weighs in the load of a tablet server when "
+              "placing new tablet replicas, between 0 and 1. At 0, the load is "
+              "only the number of replicas of the tablet server. At 1, the "
+              "number of replicas is scaled by the ratio of the tablet server's "
+              "resource usage to the average usage of the tablet servers.");
+TAG_FLAG(placement_resource_load_weight, advanced);
+TAG_FLAG(placement_resource_load_weight, runtime);
+
 using std::multimap;
 using std::numeric_limits;
 using std::set;
@@ -50,61 +65,31 @@ using strings::Substitute;
 namespace kudu {
 namespace master {
 
-namespace {
-
-double GetTSLoad(const boost::optional<string>& dimension, TSDescriptor* desc) {
-  // TODO (oclarms): get the number of times this tablet server has recently been
-  //  selected to create a tablet replica by dimension.
-  return desc->RecentReplicaCreations() + desc->num_live_replicas(dimension);
-}
-
-// Given exactly two choices in 'two_choices', pick the better tablet server on
-// which to place a tablet replica. Ties are broken using 'rng'.
-shared_ptr<TSDescriptor> PickBetterReplica(
-    const TSDescriptorVector& two_choices,
-    const boost::optional<std::string>& dimension,
-    ThreadSafeRandom* rng) {
-  CHECK_EQ(2, two_choices.size());
-
-  const auto& a = two_choices[0];
-  const auto& b = two_choices[1];
-
-  // When creating replicas, we consider two aspects of load:
-  //   (1) how many tablet replicas are already on the server (if dimension is not none, only
-  //       return the number of tablet replicas in the dimension), and
-  //   (2) how often we've chosen this server recently.
-  //
-  // The first factor will attempt to put more replicas on servers that
-  // are under-loaded (eg because they have newly joined an existing cluster, or have
-  // been reformatted and re-joined).
-  //
-  // The second factor will ensure that we take into account the recent selection
-  // decisions even if those replicas are still in the process of being created (and thus
-  // not yet reported by the server). This is important because, while creating a table,
-  // we batch the selection process before sending any creation commands to the
-  // servers themselves.
-  //
-  // TODO(wdberkeley): in the future we may want to factor in other items such
-  // as available disk space, actual request load, etc.
-  double load_a = GetTSLoad(dimension, a.get());
-  double load_b = GetTSLoad(dimension, b.get());
-  if (load_a < load_b) {
-    return a;
-  }
-  if (load_b < load_a) {
-    return b;
-  }
-  // If the load is the same, we can just pick randomly.
-  return two_choices[rng->Uniform(2)];
-}
-
-} // anonymous namespace
-
 PlacementPolicy::PlacementPolicy(TSDescriptorVector descs,
                                  ThreadSafeRandom* rng)
     : ts_num_(descs.size()),
       rng_(rng) {
   CHECK(rng_);
+  int num_loads = 0;
+  for (const auto& desc : descs) {
+    const auto load = desc->load();
+    if (!load) {
+      continue;
+    }
+    avg_load_.on_disk_data_bytes += load->on_disk_data_bytes();
+    avg_load_.write_rows_per_sec += load->write_rows_per_sec();
+    avg_load_.scan_rows_per_sec += load->scan_rows_per_sec();
+    avg_load_.memory_pressure += load->memory_pressure();
+    avg_load_.maintenance_backlog += load->maintenance_backlog();
+    num_loads++;
+  }
+  if (num_loads > 0) {
+    avg_load_.on_disk_data_bytes /= num_loads;
+    avg_load_.write_rows_per_sec /= num_loads;
+    avg_load_.scan_rows_per_sec /= num_loads;
+    avg_load_.memory_pressure /= num_loads;
+    avg_load_.maintenance_backlog /= num_loads;
+  }
   for (auto& desc : descs) {
     EmplaceOrDie(&known_ts_ids_, desc->permanent_uuid());
     string location = desc->location() ? *desc->location() : "";
@@ -281,6 +266,80 @@ Status PlacementPolicy::SelectReplicas(const TSDescriptorVector& source_ts_descs
 //
 // [1] http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf
 //
+double PlacementPolicy::GetResourceLoadRatio(TSDescriptor* desc) const {
+  const auto load = desc->load();
+  if (!load) {
+    return 1.0;
+  }
+  double sum = 0;
+  int num_ratios = 0;
+  const auto add_ratio = [&](double value, double avg) {
+    // Skip the resources which aren't used at all across the cluster.
+    if (avg > 0) {
+      sum += value / avg;
+      num_ratios++;
+    }
+  };
+  add_ratio(load->on_disk_data_bytes(), avg_load_.on_disk_data_bytes);
+  add_ratio(load->write_rows_per_sec(), avg_load_.write_rows_per_sec);
+  add_ratio(load->scan_rows_per_sec(), avg_load_.scan_rows_per_sec);
+  add_ratio(load->memory_pressure(), avg_load_.memory_pressure);
+  add_ratio(load->maintenance_backlog(), avg_load_.maintenance_backlog);
+  return num_ratios == 0 ? 1.0 : sum / num_ratios;
+}
+
+double PlacementPolicy::GetTSLoad(const boost::optional<string>& dimension,
+                                  TSDescriptor* desc) const {
+  // TODO (oclarms): get the number of times this tablet server has recently been
+  //  selected to create a tablet replica by dimension.
+  const double num_replicas = desc->RecentReplicaCreations() + desc->num_live_replicas(dimension);
+  const double weight = std::min(std::max(FLAGS_placement_resource_load_weight, 0.0), 1.0);
+  if (weight == 0) {
+    return num_replicas;
+  }
+  return num_replicas * (1 - weight + weight * GetResourceLoadRatio(desc));
+}
+
+shared_ptr<TSDescriptor> PlacementPolicy::PickBetterReplica(
+    const TSDescriptorVector& two_choices,
+    const boost::optional<string>& dimension) const {
+  CHECK_EQ(2, two_choices.size());
+
+  const auto& a = two_choices[0];
+  const auto& b = two_choices[1];
+
+  // When creating replicas, we consider three aspects of load:
+  //   (1) how many tablet replicas are already on the server (if dimension is not none, only
+  //       return the number of tablet replicas in the dimension),
+  //   (2) how often we've chosen this server recently, and
+  //   (3) how the resource usage reported by the server compares to the
+  //       average across the servers.
+  //
+  // The first factor will attempt to put more replicas on servers that
+  // are under-loaded (eg because they have newly joined an existing cluster, or have
+  // been reformatted and re-joined).
+  //
+  // The second factor will ensure that we take into account the recent selection
+  // decisions even if those replicas are still in the process of being created (and thus
+  // not yet reported by the server). This is important because, while creating a table,
+  // we batch the selection process before sending any creation commands to the
+  // servers themselves.
+  //
+  // The third factor scales the first two, so that servers with the same
+  // number of replicas but hosting bigger or busier ones are avoided. See
+  // --placement_resource_load_weight.
+  double load_a = GetTSLoad(dimension, a.get());
+  double load_b = GetTSLoad(dimension, b.get());
+  if (load_a < load_b) {
+    return a;
+  }
+  if (load_b < load_a) {
+    return b;
+  }
+  // If the load is the same, we can just pick randomly.
+  return two_choices[rng_->Uniform(2)];
+}
+
 shared_ptr<TSDescriptor> PlacementPolicy::SelectReplica(
     const TSDescriptorVector& ts_descs,
     const boost::optional<string>& dimension,
@@ -294,7 +353,7 @@ shared_ptr<TSDescriptor> PlacementPolicy::SelectReplica(
 
   if (two_choices.size() == 2) {
     // Pick the better of the two.
-    return PickBetterReplica(two_choices, dimension, rng_);
+    return PickBetterReplica(two_choices, dimension);
   }
   if (two_choices.size() == 1) {
     return two_choices.front();
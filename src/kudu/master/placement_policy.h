@@ -142,6 +142,24 @@ class PlacementPolicy {
                         const boost::optional<std::string>& dimension,
                         TSDescriptorVector* result_ts_descs) const;
 
+  // Get the ratio of the resource usage reported by the tablet server 'desc'
+  // to the average usage of the tablet servers: the average of the ratios of
+  // each of the reported resources. Returns 1.0 if 'desc' hasn't reported its
+  // resource usage.
+  double GetResourceLoadRatio(TSDescriptor* desc) const;
+
+  // Get the load of the tablet server 'desc' for placing a replica in
+  // 'dimension': its number of live and recently created replicas, weighed by
+  // its resource usage per --placement_resource_load_weight.
+  double GetTSLoad(const boost::optional<std::string>& dimension,
+                   TSDescriptor* desc) const;
+
+  // Given exactly two choices in 'two_choices', pick the better tablet server
+  // on which to place a tablet replica. Ties are broken randomly.
+  std::shared_ptr<TSDescriptor> PickBetterReplica(
+      const TSDescriptorVector& two_choices,
+      const boost::optional<std::string>& dimension) const;
+
   // Given the tablet servers in 'ts_descs', pick a tablet server to host
   // a tablet replica, excluding tablet servers in 'excluded'. If there are no
   // servers in 'ts_descs' that are not in 'existing', return nullptr.
@@ -181,6 +199,16 @@ class PlacementPolicy {
 
   // A set of known tablet server identifiers (derived from ltd_).
   std::unordered_set<std::string> known_ts_ids_;
+
+  // The average resource usage of the tablet servers which reported it.
+  struct AverageLoad {
+    double on_disk_data_bytes = 0;
+    double write_rows_per_sec = 0;
+    double scan_rows_per_sec = 0;
+    double memory_pressure = 0;
+    double maintenance_backlog = 0;
+  };
+  AverageLoad avg_load_;
 };
 
 } // namespace master
@@ -247,13 +247,18 @@ Status RangerAuthzProvider::FillTablePrivilegePB(const string& table_name,
   string tbl;
   RETURN_NOT_OK(ParseTableIdentifier(table_name, &db, &tbl));
 
-  bool authorized;
-  if (IsTrustedUser(user)) {
-    authorized = true;
-  } else {
-    RETURN_NOT_OK(client_.AuthorizeAction(user, ActionPB::ALL, db, tbl, &authorized));
+  // ALL and the table-level privileges are checked in a single request.
+  unordered_set<ActionPB, ActionHash> actions = {
+    ActionPB::ALL,
+    ActionPB::DELETE,
+    ActionPB::INSERT,
+    ActionPB::UPDATE,
+    ActionPB::SELECT
+  };
+  if (!IsTrustedUser(user)) {
+    RETURN_NOT_OK(client_.AuthorizeActions(user, db, tbl, &actions));
   }
-  if (authorized) {
+  if (ContainsKey(actions, ActionPB::ALL)) {
     pb->set_delete_privilege(true);
     pb->set_insert_privilege(true);
     pb->set_scan_privilege(true);
@@ -261,16 +266,8 @@ Status RangerAuthzProvider::FillTablePrivilegePB(const string& table_name,
     return Status::OK();
   }
 
-  unordered_set<ActionPB, ActionHash> actions = {
-    ActionPB::DELETE,
-    ActionPB::INSERT,
-    ActionPB::UPDATE,
-    ActionPB::SELECT
-  };
-
   // Check if the user has any table-level privileges. If yes, we set them. If
   // select is included, we can also return.
-  RETURN_NOT_OK(client_.AuthorizeActions(user, db, tbl, &actions));
   for (const ActionPB& action : actions) {
     switch (action) {
       case ActionPB::DELETE:
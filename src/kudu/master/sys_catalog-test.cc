@@ -17,17 +17,21 @@
 
 #include "kudu/master/sys_catalog.h"
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <gtest/gtest.h>
 
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/master/catalog_manager.h"
 #include "kudu/master/master.h"
 #include "kudu/master/master.pb.h"
@@ -38,14 +42,18 @@
 #include "kudu/security/crypto.h"
 #include "kudu/security/openssl_util.h"
 #include "kudu/util/cow_object.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/oid_generator.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int32(sys_catalog_visit_tablets_threads);
+
 using kudu::rpc::Messenger;
 using kudu::rpc::MessengerBuilder;
 using kudu::security::Cert;
@@ -55,6 +63,7 @@ using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 namespace google {
 namespace protobuf {
@@ -240,11 +249,21 @@ class TestTabletLoader : public TabletVisitor {
     TabletMetadataLock l(tablet.get(), LockMode::WRITE);
     l.mutable_data()->pb.CopyFrom(metadata);
     l.Commit();
-    tablets.emplace_back(std::move(tablet));
+
+    // The tablets may be visited concurrently and in any order: keep them
+    // sorted by ID.
+    std::lock_guard<simple_spinlock> guard(lock_);
+    auto it = std::lower_bound(
+        tablets.begin(), tablets.end(), tablet_id,
+        [](const scoped_refptr<TabletInfo>& t, const string& id) { return t->id() < id; });
+    tablets.emplace(it, std::move(tablet));
     return Status::OK();
   }
 
   vector<scoped_refptr<TabletInfo>> tablets;
+
+ private:
+  simple_spinlock lock_;
 };
 
 // Create a new TabletInfo. The object is in uncommitted
@@ -356,6 +375,39 @@ TEST_F(SysCatalogTest, TestSysCatalogTabletsOperations) {
   }
 }
 
+// Test that the concurrent scans of VisitTablets() cover all the tablets.
+TEST_F(SysCatalogTest, TestVisitTabletsConcurrently) {
+  const int kNumTablets = 100;
+  scoped_refptr<TableInfo> table(new TableInfo("abc"));
+  ObjectIdGenerator oid_generator;
+  vector<scoped_refptr<TabletInfo>> tablets;
+  for (int i = 0; i < kNumTablets; i++) {
+    tablets.emplace_back(CreateTablet(table, oid_generator.Next(),
+                                      Substitute("$0", i), Substitute("$0", i + 1)));
+  }
+  SysCatalogTable* sys_catalog = master_->catalog_manager()->sys_catalog();
+  {
+    SysCatalogTable::Actions actions;
+    actions.tablets_to_add = tablets;
+    ASSERT_OK(sys_catalog->Write(std::move(actions)));
+  }
+
+  std::sort(tablets.begin(), tablets.end(),
+            [](const scoped_refptr<TabletInfo>& a, const scoped_refptr<TabletInfo>& b) {
+              return a->id() < b->id();
+            });
+  for (int num_threads : { 1, 3, 16 }) {
+    SCOPED_TRACE(num_threads);
+    FLAGS_sys_catalog_visit_tablets_threads = num_threads;
+    TestTabletLoader loader;
+    ASSERT_OK(sys_catalog->VisitTablets(&loader));
+    ASSERT_EQ(kNumTablets, loader.tablets.size());
+    for (int i = 0; i < kNumTablets; i++) {
+      ASSERT_TRUE(MetadatasEqual(tablets[i], loader.tablets[i]));
+    }
+  }
+}
+
 // Verify that data mutations are not available from metadata() until commit.
 TEST_F(SysCatalogTest, TestTabletInfoCommit) {
   scoped_refptr<TabletInfo> tablet(new TabletInfo(nullptr, "123"));
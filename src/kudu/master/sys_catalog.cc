@@ -84,11 +84,19 @@
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_double(sys_catalog_fail_during_write, 0.0,
               "Fraction of the time when system table writes will fail");
 TAG_FLAG(sys_catalog_fail_during_write, hidden);
 
+DEFINE_int32(sys_catalog_visit_tablets_threads, 8,
+             "Number of threads concurrently scanning and deserializing the "
+             "tablet entries of the system catalog when loading them into "
+             "memory, e.g. when a master becomes the leader. At most 16 threads "
+             "are used.");
+TAG_FLAG(sys_catalog_visit_tablets_threads, advanced);
+
 DECLARE_int64(rpc_max_message_size);
 
 METRIC_DEFINE_counter(server, sys_catalog_oversized_write_requests,
@@ -674,7 +682,9 @@ Status SysCatalogTable::GetEntryFromRow(
 // with each entry found.
 template<typename T, SysCatalogTable::CatalogEntryType entry_type>
 Status SysCatalogTable::ProcessRows(
-    function<Status(const string&, const T&)> processor) const {
+    function<Status(const string&, const T&)> processor,
+    const Slice* lower_entry_id,
+    const Slice* upper_entry_id) const {
   const int type_col_idx = schema_.find_column(kSysCatalogTableColType);
   CHECK(type_col_idx != Schema::kColumnNotFound)
       << "cannot find sys catalog table column " << kSysCatalogTableColType
@@ -685,6 +695,11 @@ Status SysCatalogTable::ProcessRows(
                                         &kEntryType);
   ScanSpec spec;
   spec.AddPredicate(pred);
+  if (lower_entry_id || upper_entry_id) {
+    const int id_col_idx = schema_.find_column(kSysCatalogTableColId);
+    spec.AddPredicate(ColumnPredicate::Range(schema_.column(id_col_idx),
+                                             lower_entry_id, upper_entry_id));
+  }
 
   unique_ptr<RowwiseIterator> iter;
   RETURN_NOT_OK(tablet_replica_->tablet()->NewRowIterator(schema_, &iter));
@@ -996,7 +1011,44 @@ Status SysCatalogTable::VisitTablets(TabletVisitor* visitor) {
     metadata.clear_deprecated_end_key();
     return visitor->VisitTablet(metadata.table_id(), entry_id, metadata);
   };
-  return ProcessRows<SysTabletsEntryPB, TABLETS_ENTRY>(processor);
+  const int num_ranges = std::min(FLAGS_sys_catalog_visit_tablets_threads, 16);
+  if (num_ranges <= 1) {
+    return ProcessRows<SysTabletsEntryPB, TABLETS_ENTRY>(processor);
+  }
+
+  // Tablet IDs are hex-encoded UUIDs, so split them into ranges by their first
+  // digit. The first and the last ranges are unbounded to cover any other ID.
+  static const char* const kHexDigits = "0123456789abcdef";
+  vector<string> split_ids;
+  for (int i = 1; i < num_ranges; i++) {
+    split_ids.emplace_back(1, kHexDigits[i * 16 / num_ranges]);
+  }
+  const vector<Slice> splits(split_ids.begin(), split_ids.end());
+
+  unique_ptr<ThreadPool> pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("sys-catalog-visit")
+                .set_min_threads(0)
+                .set_max_threads(num_ranges)
+                .Build(&pool));
+  vector<Status> statuses(num_ranges);
+  for (int i = 0; i < num_ranges; i++) {
+    const Slice* lower = i == 0 ? nullptr : &splits[i - 1];
+    const Slice* upper = i == num_ranges - 1 ? nullptr : &splits[i];
+    Status s = pool->Submit([this, &processor, &statuses, i, lower, upper]() {
+      statuses[i] = ProcessRows<SysTabletsEntryPB, TABLETS_ENTRY>(processor, lower, upper);
+    });
+    if (PREDICT_FALSE(!s.ok())) {
+      statuses[i] = std::move(s);
+      break;
+    }
+  }
+  // The scans reference the locals above, so wait for all of them to finish.
+  pool->Wait();
+  pool->Shutdown();
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
 }
 
 void SysCatalogTable::InitLocalRaftPeerPB() {
@@ -41,6 +41,7 @@ class Counter;
 class FsManager;
 class MetricRegistry;
 class RowBlockRow;
+class Slice;
 
 namespace consensus {
 class ConsensusMetadataManager;
@@ -207,7 +208,9 @@ class SysCatalogTable {
   // Scan of the table-related entries.
   Status VisitTables(TableVisitor* visitor);
 
-  // Scan of the tablet-related entries.
+  // Scan of the tablet-related entries. The scan is split into concurrent
+  // scans of disjoint ranges of tablet IDs, so 'visitor' may be called
+  // concurrently from multiple threads.
   Status VisitTablets(TabletVisitor* visitor);
 
   // Scan for TSK-related entries in the system table.
@@ -293,8 +296,12 @@ class SysCatalogTable {
   Status GetEntryFromRow(const RowBlockRow& row,
                          std::string* entry_id, T* entry_data) const;
 
+  // If set, only the entries with IDs in the range ['lower_entry_id',
+  // 'upper_entry_id') are processed.
   template<typename T, CatalogEntryType entry_type>
-  Status ProcessRows(std::function<Status(const std::string&, const T&)>) const;
+  Status ProcessRows(std::function<Status(const std::string&, const T&)>,
+                     const Slice* lower_entry_id = nullptr,
+                     const Slice* upper_entry_id = nullptr) const;
 
   // Tablet related private methods.
 
@@ -36,12 +36,20 @@ METRIC_DEFINE_gauge_uint64(table, live_row_count, "Table Live Row count",
     "Pre-replication aggregated number of live rows in this table. "
     "Only accurate if all tablets in the table support live row counting.",
     kudu::MetricLevel::kInfo);
+METRIC_DEFINE_gauge_uint64(table, hot_tablets, "Hot Tablets",
+    kudu::MetricUnit::kTablets,
+    "Number of tablets in this table whose leader replica's on-disk size or "
+    "live row count growth rate exceed the thresholds set by "
+    "--hot_tablet_on_disk_size_threshold_mb and "
+    "--hot_tablet_live_row_count_growth_threshold.",
+    kudu::MetricLevel::kInfo);
 
 #define GINIT(x) x(METRIC_##x.Instantiate(entity, 0))
 #define HIDEINIT(x, v) x(METRIC_##x.InstantiateHidden(entity, v))
 TableMetrics::TableMetrics(const scoped_refptr<MetricEntity>& entity)
   : GINIT(on_disk_size),
     GINIT(live_row_count),
+    GINIT(hot_tablets),
     HIDEINIT(merged_entities_count_of_table, 1) {
 }
 #undef GINIT
@@ -32,6 +32,7 @@
 #include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/master/master.pb.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/make_shared.h"
 #include "kudu/util/monotime.h"
@@ -151,6 +152,19 @@ class TSDescriptor : public enable_make_shared<TSDescriptor> {
     return num_live_replicas_;
   }
 
+  // Set the resource usage of the tablet server, from the last heartbeat.
+  void set_load(TabletServerLoadPB load) {
+    std::lock_guard<rw_spinlock> l(lock_);
+    load_ = std::move(load);
+  }
+
+  // Return the resource usage of the tablet server from its last heartbeat,
+  // or none if the tablet server hasn't reported it.
+  boost::optional<TabletServerLoadPB> load() const {
+    shared_lock<rw_spinlock> l(lock_);
+    return load_;
+  }
+
   // Return the location of the tablet server. This returns a safe copy
   // since the location could change at any time if the tablet server
   // re-registers.
@@ -204,6 +218,9 @@ class TSDescriptor : public enable_make_shared<TSDescriptor> {
   // The number of live replicas in each dimension, from the last heartbeat.
   boost::optional<TabletNumByDimensionMap> num_live_tablets_by_dimension_;
 
+  // The resource usage of this host, from the last heartbeat.
+  boost::optional<TabletServerLoadPB> load_;
+
   // The tablet server's location, as determined by the master at registration.
   boost::optional<std::string> location_;
 
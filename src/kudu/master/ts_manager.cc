@@ -95,7 +95,8 @@ class TServerStateLoader : public TServerStateVisitor {
 TSManager::TSManager(LocationCache* location_cache,
                      const scoped_refptr<MetricEntity>& metric_entity)
     : ts_state_lock_(RWMutex::Priority::PREFER_READING),
-      location_cache_(location_cache) {
+      location_cache_(location_cache),
+      registration_epoch_(0) {
   METRIC_cluster_replica_skew.InstantiateFunctionGauge(
       metric_entity, [this]() { return this->ClusterSkew(); })
       ->AutoDetach(&metric_detacher_);
@@ -185,8 +186,10 @@ Status TSManager::RegisterTS(const NodeInstancePB& instance,
       RETURN_NOT_OK(TSDescriptor::RegisterNew(
           instance, registration, location, dns_resolver, &descriptor));
       InsertOrDie(&servers_by_id_, uuid, descriptor);
+      servers_.push_back(descriptor);
       new_tserver = true;
     }
+    registration_epoch_++;
   }
   LOG(INFO) << Substitute("$0 tserver with Master: $1",
                           new_tserver ? "Registered new" : "Re-registered known",
@@ -197,9 +200,8 @@ Status TSManager::RegisterTS(const NodeInstancePB& instance,
 }
 
 void TSManager::GetAllDescriptors(TSDescriptorVector* descs) const {
-  descs->clear();
   shared_lock<rw_spinlock> l(lock_);
-  AppendValuesFromMap(servers_by_id_, descs);
+  *descs = servers_;
 }
 
 int TSManager::GetCount() const {
@@ -210,8 +212,7 @@ int TSManager::GetCount() const {
 int TSManager::GetLiveCount() const {
   shared_lock<rw_spinlock> l(lock_);
   int live_count = 0;
-  for (const auto& entry : servers_by_id_) {
-    const shared_ptr<TSDescriptor>& ts = entry.second;
+  for (const auto& ts : servers_) {
     if (!ts->PresumedDead()) {
       live_count++;
     }
@@ -240,9 +241,8 @@ void TSManager::GetDescriptorsAvailableForPlacement(TSDescriptorVector* descs) c
   descs->clear();
   shared_lock<RWMutex> tsl(ts_state_lock_);
   shared_lock<rw_spinlock> l(lock_);
-  descs->reserve(servers_by_id_.size());
-  for (const TSDescriptorMap::value_type& entry : servers_by_id_) {
-    const shared_ptr<TSDescriptor>& ts = entry.second;
+  descs->reserve(servers_.size());
+  for (const auto& ts : servers_) {
     if (AvailableForPlacementUnlocked(*ts)) {
       descs->push_back(ts);
     }
@@ -311,8 +311,8 @@ Status TSManager::ReloadTServerStates(SysCatalogTable* sys_catalog) {
 
 void TSManager::SetAllTServersNeedFullTabletReports() {
   lock_guard<rw_spinlock> l(lock_);
-  for (auto& id_and_desc : servers_by_id_) {
-    id_and_desc.second->UpdateNeedsFullTabletReport(true);
+  for (auto& ts : servers_) {
+    ts->UpdateNeedsFullTabletReport(true);
   }
 }
 
@@ -320,8 +320,7 @@ int TSManager::ClusterSkew() const {
   int min_count = std::numeric_limits<int>::max();
   int max_count = 0;
   shared_lock<rw_spinlock> l(lock_);
-  for (const TSDescriptorMap::value_type& entry : servers_by_id_) {
-    const shared_ptr<TSDescriptor>& ts = entry.second;
+  for (const auto& ts : servers_) {
     if (ts->PresumedDead()) {
       continue;
     }
@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -85,6 +86,13 @@ class TSManager {
                     DnsResolver* dns_resolver,
                     std::shared_ptr<TSDescriptor>* desc);
 
+  // Returns a number which changes whenever a tablet server registers or
+  // re-registers, i.e. whenever the addresses or the location of a tablet
+  // server may have changed.
+  int64_t registration_epoch() const {
+    return registration_epoch_.load();
+  }
+
   // Return all of the currently registered TS descriptors into the provided
   // list.
   void GetAllDescriptors(TSDescriptorVector* descs) const;
@@ -143,7 +151,7 @@ class TSManager {
   // to recheck any ignored failures.
   void SetAllTServersNeedFullTabletReports();
 
-  // Protects 'servers_by_id_'.
+  // Protects 'servers_by_id_' and 'servers_'.
   mutable rw_spinlock lock_;
 
   // TODO(awong): add a map from HostPort to descriptor so we aren't forced to
@@ -153,6 +161,12 @@ class TSManager {
       std::string, std::shared_ptr<TSDescriptor>> TSDescriptorMap;
   TSDescriptorMap servers_by_id_;
 
+  // The descriptors of 'servers_by_id_', in registration order. Since
+  // descriptors are never removed, this only grows when a new tablet server
+  // registers, and lets the methods walking all the descriptors iterate over
+  // contiguous memory and copy them without rehashing.
+  TSDescriptorVector servers_;
+
   // Protects 'ts_state_by_uuid_'. If both 'ts_state_lock_' and 'lock_' are to
   // be taken, 'ts_state_lock_' must be taken first.
   mutable RWMutex ts_state_lock_;
@@ -164,6 +178,9 @@ class TSManager {
 
   LocationCache* location_cache_;
 
+  // See registration_epoch().
+  std::atomic<int64_t> registration_epoch_;
+
   // NOTE: it's important that this is the first member to be destructed. This
   // ensures we do not attempt to collect metrics while calling the destructor.
   FunctionGaugeDetacher metric_detacher_;
@@ -105,6 +105,9 @@ struct AuthorizedActionHash {
 class MockSubprocessServer : public SubprocessServer {
  public:
   unordered_set<AuthorizedAction, AuthorizedActionHash> next_response_;
+  // The number of messages and requests sent to the subprocess.
+  int num_messages_ = 0;
+  int num_requests_ = 0;
 
   Status Init() override {
     // don't want to start anything
@@ -120,6 +123,8 @@ class MockSubprocessServer : public SubprocessServer {
                  SubprocessResponsePB* resp) override {
     RangerRequestListPB req_list;
     CHECK(req->request().UnpackTo(&req_list));
+    num_messages_++;
+    num_requests_ += req_list.requests_size();
 
     RangerResponseListPB resp_list;
 
@@ -149,6 +154,7 @@ class RangerClientTest : public KuduTest {
   void SetUp() override {
     std::unique_ptr<MockSubprocessServer> server(new MockSubprocessServer());
     next_response_ = &server->next_response_;
+    server_ = server.get();
     client_.ReplaceServerForTests(std::move(server));
   }
 
@@ -167,9 +173,50 @@ class RangerClientTest : public KuduTest {
  protected:
   MetricRegistry metric_registry_;
   unordered_set<AuthorizedAction, AuthorizedActionHash>* next_response_;
+  MockSubprocessServer* server_;
   RangerClient client_;
 };
 
+TEST_F(RangerClientTest, TestCachedDecisions) {
+  Allow("jdoe", ActionPB::SELECT, "default", "foobar");
+  unordered_set<ActionPB, ActionHash> actions = { ActionPB::SELECT, ActionPB::INSERT };
+  ASSERT_OK(client_.AuthorizeActions("jdoe", "default", "foobar", &actions));
+  ASSERT_EQ(1, actions.size());
+  ASSERT_TRUE(ContainsKey(actions, ActionPB::SELECT));
+  ASSERT_EQ(1, server_->num_messages_);
+  ASSERT_EQ(2, server_->num_requests_);
+
+  // Both decisions are cached, including the denial.
+  bool authorized;
+  ASSERT_OK(client_.AuthorizeAction("jdoe", ActionPB::SELECT, "default", "foobar", &authorized));
+  ASSERT_TRUE(authorized);
+  ASSERT_OK(client_.AuthorizeAction("jdoe", ActionPB::INSERT, "default", "foobar", &authorized));
+  ASSERT_FALSE(authorized);
+  ASSERT_EQ(1, server_->num_messages_);
+
+  // Only the checks which aren't cached are sent, and the same check for
+  // another user or at the database scope isn't served from the cache.
+  actions = { ActionPB::SELECT, ActionPB::INSERT, ActionPB::UPDATE };
+  ASSERT_OK(client_.AuthorizeActions("jdoe", "default", "foobar", &actions));
+  ASSERT_EQ(1, actions.size());
+  ASSERT_TRUE(ContainsKey(actions, ActionPB::SELECT));
+  ASSERT_EQ(2, server_->num_messages_);
+  ASSERT_EQ(3, server_->num_requests_);
+  ASSERT_OK(client_.AuthorizeAction("alice", ActionPB::SELECT, "default", "foobar", &authorized));
+  ASSERT_FALSE(authorized);
+  ASSERT_OK(client_.AuthorizeAction("jdoe", ActionPB::SELECT, "default", "foobar", &authorized,
+                                    RangerClient::Scope::DATABASE));
+  ASSERT_FALSE(authorized);
+  ASSERT_EQ(4, server_->num_messages_);
+
+  // Policy changes are seen once the cache is reset.
+  Allow("jdoe", ActionPB::INSERT, "default", "foobar");
+  client_.ResetCache();
+  ASSERT_OK(client_.AuthorizeAction("jdoe", ActionPB::INSERT, "default", "foobar", &authorized));
+  ASSERT_TRUE(authorized);
+  ASSERT_EQ(5, server_->num_messages_);
+}
+
 TEST_F(RangerClientTest, TestAuthorizeCreateTableUnauthorized) {
   bool authorized;
   ASSERT_OK(client_.AuthorizeAction("jdoe", ActionPB::CREATE, "bar", "baz", &authorized));
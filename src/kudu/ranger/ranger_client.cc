@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -40,6 +41,7 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/path_util.h"
 #include "kudu/util/scoped_cleanup.h"
@@ -100,6 +102,21 @@ DEFINE_bool(ranger_logtostdout, false,
 TAG_FLAG(ranger_logtostdout, advanced);
 TAG_FLAG(ranger_logtostdout, evolving);
 
+DEFINE_uint32(ranger_authz_cache_capacity_mb, 16,
+              "Capacity in MiB of the cache of the authorization decisions "
+              "of the Ranger subprocess. A value of 0 means the decisions "
+              "are not cached.");
+TAG_FLAG(ranger_authz_cache_capacity_mb, advanced);
+TAG_FLAG(ranger_authz_cache_capacity_mb, evolving);
+
+DEFINE_uint32(ranger_authz_cache_ttl_secs, 10,
+              "Number of seconds for which the authorization decisions of the "
+              "Ranger subprocess are cached. Policy changes take effect after "
+              "at most this long on top of the policy polling interval of the "
+              "Ranger plugin.");
+TAG_FLAG(ranger_authz_cache_ttl_secs, advanced);
+TAG_FLAG(ranger_authz_cache_ttl_secs, evolving);
+
 DECLARE_int32(max_log_files);
 DECLARE_int32(max_log_size);
 DECLARE_string(log_dir);
@@ -171,7 +188,9 @@ namespace ranger {
 using kudu::security::GetKrb5ConfigFile;
 using kudu::subprocess::SubprocessMetrics;
 using kudu::subprocess::SubprocessServer;
+using std::make_shared;
 using std::move;
+using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::unordered_set;
@@ -362,6 +381,24 @@ Status BuildArgv(const string& fifo_path, const string& log_properties_path,
   return Status::OK();
 }
 
+// Returns the key of the decision on 'req' for 'user_name' in the cache.
+string DecisionCacheKey(const string& user_name, const RangerRequestPB& req) {
+  // The fields are separated by NUL, and the optional ones are tagged by
+  // whether they are set: DATABASE scope requests have no table.
+  string key = user_name;
+  key.push_back('\0');
+  key.append(ActionPB_Name(req.action()));
+  key.push_back('\0');
+  key.append(req.database());
+  key.push_back('\0');
+  key.push_back(req.has_table() ? 't' : '-');
+  key.append(req.table());
+  key.push_back('\0');
+  key.push_back(req.has_column() ? 'c' : '-');
+  key.append(req.column());
+  return key;
+}
+
 } // anonymous namespace
 
 #define HISTINIT(member, x) member = METRIC_##x.Instantiate(entity)
@@ -381,6 +418,64 @@ RangerSubprocessMetrics::RangerSubprocessMetrics(const scoped_refptr<MetricEntit
 RangerClient::RangerClient(Env* env, const scoped_refptr<MetricEntity>& metric_entity)
     : env_(env), metric_entity_(metric_entity) {
   DCHECK(metric_entity);
+  ResetCache();
+}
+
+void RangerClient::ResetCache() {
+  shared_ptr<DecisionCache> new_cache;
+  if (FLAGS_ranger_authz_cache_capacity_mb != 0) {
+    new_cache = make_shared<DecisionCache>(
+        FLAGS_ranger_authz_cache_capacity_mb * 1024 * 1024,
+        MonoDelta::FromSeconds(FLAGS_ranger_authz_cache_ttl_secs),
+        MonoDelta(), 0, "ranger-authz-ttl-cache");
+  }
+  std::lock_guard<rw_spinlock> l(cache_lock_);
+  cache_ = std::move(new_cache);
+}
+
+Status RangerClient::Authorize(const RangerRequestListPB& req_list,
+                               RangerResponseListPB* resp_list) {
+  // Keep a reference: the cache may be reset concurrently, and it must
+  // outlive its handles.
+  shared_ptr<DecisionCache> cache;
+  {
+    shared_lock<rw_spinlock> l(cache_lock_);
+    cache = cache_;
+  }
+  if (!cache) {
+    return subprocess_->Execute(req_list, resp_list);
+  }
+
+  resp_list->Clear();
+  RangerRequestListPB miss_list;
+  miss_list.set_user(req_list.user());
+  vector<string> miss_keys;
+  vector<int> miss_indexes;
+  for (int i = 0; i < req_list.requests_size(); i++) {
+    string key = DecisionCacheKey(req_list.user(), req_list.requests(i));
+    auto handle = cache->Get(key);
+    auto* resp = resp_list->add_responses();
+    if (handle) {
+      resp->set_allowed(handle.value());
+      continue;
+    }
+    *miss_list.add_requests() = req_list.requests(i);
+    miss_keys.emplace_back(std::move(key));
+    miss_indexes.emplace_back(i);
+  }
+  if (miss_list.requests_size() == 0) {
+    return Status::OK();
+  }
+
+  RangerResponseListPB miss_resp_list;
+  RETURN_NOT_OK(subprocess_->Execute(miss_list, &miss_resp_list));
+  CHECK_EQ(miss_list.requests_size(), miss_resp_list.responses_size());
+  for (int i = 0; i < miss_resp_list.responses_size(); i++) {
+    const bool allowed = miss_resp_list.responses(i).allowed();
+    resp_list->mutable_responses(miss_indexes[i])->set_allowed(allowed);
+    cache->Put(miss_keys[i], unique_ptr<bool>(new bool(allowed)));
+  }
+  return Status::OK();
 }
 
 Status RangerClient::Start() {
@@ -412,7 +507,7 @@ Status RangerClient::AuthorizeAction(const string& user_name, const ActionPB& ac
     req->set_table(table);
   }
 
-  RETURN_NOT_OK(subprocess_->Execute(req_list, &resp_list));
+  RETURN_NOT_OK(Authorize(req_list, &resp_list));
 
   CHECK_EQ(1, resp_list.responses_size());
   *authorized = resp_list.responses().begin()->allowed();
@@ -437,7 +532,7 @@ Status RangerClient::AuthorizeActionMultipleColumns(const string& user_name, con
     req->set_column(col);
   }
 
-  RETURN_NOT_OK(subprocess_->Execute(req_list, &resp_list));
+  RETURN_NOT_OK(Authorize(req_list, &resp_list));
 
   DCHECK_EQ(column_names->size(), resp_list.responses_size());
 
@@ -480,7 +575,7 @@ Status RangerClient::AuthorizeActionMultipleTables(const string& user_name, cons
     }
   }
 
-  RETURN_NOT_OK(subprocess_->Execute(req_list, &resp_list));
+  RETURN_NOT_OK(Authorize(req_list, &resp_list));
 
   DCHECK_EQ(orig_table_names.size(), resp_list.responses_size());
 
@@ -513,7 +608,7 @@ Status RangerClient::AuthorizeActions(const string& user_name, const string& dat
     req->set_table(table);
   }
 
-  RETURN_NOT_OK(subprocess_->Execute(req_list, &resp_list));
+  RETURN_NOT_OK(Authorize(req_list, &resp_list));
 
   DCHECK_EQ(actions->size(), resp_list.responses_size());
 
@@ -27,8 +27,10 @@
 #include "kudu/ranger/ranger.pb.h"
 #include "kudu/subprocess/server.h"
 #include "kudu/subprocess/subprocess_proxy.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/status.h"
+#include "kudu/util/ttl_cache.h"
 
 namespace kudu {
 
@@ -62,6 +64,10 @@ typedef subprocess::SubprocessProxy<RangerRequestListPB, RangerResponseListPB,
 // client and the subprocess (e.g. IOError, EndOfFile, Corruption), but they
 // never return NotAuthorized. The authz provider is responsible to return
 // NotAuthorized based on RangerClient's out parameters and return Status.
+//
+// The decisions of the subprocess are cached for --ranger_authz_cache_ttl_secs,
+// and the checks of a call which aren't cached are sent to the subprocess in a
+// single message. Calls from different threads are in flight concurrently.
 class RangerClient {
  public:
   // Similar to SentryAuthorizableScope scope which indicates the
@@ -107,6 +113,9 @@ class RangerClient {
                           const std::string& table,
                           std::unordered_set<ActionPB, ActionHash>* actions) WARN_UNUSED_RESULT;
 
+  // Drops the cached authorization decisions, e.g. after a policy change.
+  void ResetCache();
+
   // Replaces the subprocess server in the subprocess proxy.
   void ReplaceServerForTests(std::unique_ptr<subprocess::SubprocessServer> server) {
     // Creates a dummy RangerSubprocess if it is not initialized.
@@ -117,9 +126,22 @@ class RangerClient {
   }
 
  private:
+  typedef TTLCache<std::string, bool> DecisionCache;
+
+  // Authorizes the requests of 'req_list', serving them from the cache when
+  // possible and sending the others to the subprocess in a single message.
+  // Sets 'resp_list' to the responses in the order of the requests.
+  Status Authorize(const RangerRequestListPB& req_list, RangerResponseListPB* resp_list)
+      WARN_UNUSED_RESULT;
+
   Env* env_;
   std::unique_ptr<RangerSubprocess> subprocess_;
   scoped_refptr<MetricEntity> metric_entity_;
+
+  // Protects 'cache_', which is replaced by ResetCache(). The cache is null if
+  // --ranger_authz_cache_capacity_mb is 0.
+  rw_spinlock cache_lock_;
+  std::shared_ptr<DecisionCache> cache_;
 };
 
 } // namespace ranger
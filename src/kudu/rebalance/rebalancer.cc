@@ -71,7 +71,8 @@ Rebalancer::Config::Config(
     bool run_policy_fixer,
     bool run_cross_location_rebalancing,
     bool run_intra_location_rebalancing,
-    double load_imbalance_threshold)
+    double load_imbalance_threshold,
+    int64_t max_bytes_in_flight_per_server)
     : ignored_tservers(ignored_tservers_param.begin(), ignored_tservers_param.end()),
       master_addresses(std::move(master_addresses)),
       table_filters(std::move(table_filters)),
@@ -84,8 +85,10 @@ Rebalancer::Config::Config(
       run_policy_fixer(run_policy_fixer),
       run_cross_location_rebalancing(run_cross_location_rebalancing),
       run_intra_location_rebalancing(run_intra_location_rebalancing),
-      load_imbalance_threshold(load_imbalance_threshold) {
+      load_imbalance_threshold(load_imbalance_threshold),
+      max_bytes_in_flight_per_server(max_bytes_in_flight_per_server) {
   DCHECK_GE(max_moves_per_server, 0);
+  DCHECK_GE(max_bytes_in_flight_per_server, 0);
 }
 
 Rebalancer::Rebalancer(Config config)
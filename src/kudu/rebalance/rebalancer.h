@@ -66,7 +66,8 @@ class Rebalancer {
            bool run_policy_fixer = true,
            bool run_cross_location_rebalancing = true,
            bool run_intra_location_rebalancing = true,
-           double load_imbalance_threshold = kLoadImbalanceThreshold);
+           double load_imbalance_threshold = kLoadImbalanceThreshold,
+           int64_t max_bytes_in_flight_per_server = 0);
 
     // UUIDs of ignored servers. If empty, run the rebalancing on
     // all tablet servers in the cluster only when all tablet servers
@@ -132,6 +133,13 @@ class Rebalancer {
     // The per-table location load imbalance threshold for the cross-location
     // balancing algorithm.
     double load_imbalance_threshold;
+
+    // Maximum total estimated on-disk size of the replicas being moved to or
+    // from one server at once, as reported by the replicas of their tablets.
+    // A move is always allowed if its servers have no moves in progress, so
+    // that tablets larger than the limit are still moved. Zero means no limit.
+    // Applies to rebalancing within and across locations.
+    int64_t max_bytes_in_flight_per_server;
   };
 
   // Represents a concrete move of a replica from one tablet server to another.
@@ -19,9 +19,12 @@
 
 #include <netinet/in.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -30,6 +33,7 @@
 #include <boost/intrusive/detail/list_iterator.hpp>
 #include <boost/intrusive/list.hpp>
 #include <ev.h>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/map-util.h"
@@ -55,6 +59,8 @@
 #include <linux/tcp.h>
 #endif
 
+DECLARE_bool(rpc_coalesce_outbound_transfers);
+
 using std::includes;
 using std::set;
 using std::shared_ptr;
@@ -344,6 +350,11 @@ void Connection::QueueOutbound(unique_ptr<OutboundTransfer> transfer) {
   outbound_transfers_.push_back(*transfer.release());
 
   if (negotiation_complete_ && !write_io_.is_active()) {
+    // If the reactor is running a batch of tasks, hold off until they have
+    // all run, so the transfers they queue go out together.
+    if (reactor_thread_->MaybeDeferWrites(this)) {
+      return;
+    }
     // Optimistically assume that the socket is writable if we didn't already
     // have something queued.
     if (ProcessOutboundTransfers() == kMoreToSend) {
@@ -758,68 +769,119 @@ void Connection::WriteHandler(ev::io &watcher, int revents) {
   }
 }
 
+bool Connection::PrepareOutboundTransfer(OutboundTransfer* transfer) {
+  if (!transfer->is_for_outbound_call()) {
+    return true;
+  }
+  CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
+  if (!car->call) {
+    // If the call has already timed out or has already been cancelled, the 'call'
+    // field would be set to NULL. In that case, don't bother sending it.
+    transfer->Abort(Status::Aborted("already timed out or cancelled"));
+    return false;
+  }
+
+  // If this is the start of the transfer, then check if the server has the
+  // required RPC flags. We have to wait until just before the transfer in
+  // order to ensure that the negotiation has taken place, so that the flags
+  // are available.
+  const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
+  if (!includes(remote_features_.begin(), remote_features_.end(),
+                required_features.begin(), required_features.end())) {
+    Status s = Status::NotSupported("server does not support the required RPC features");
+    transfer->Abort(s);
+    Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
+    car->call->SetFailed(std::move(s), phase);
+    // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
+    MaybeInjectCancellation(car->call);
+    car->call.reset();
+    return false;
+  }
+  return true;
+}
+
+void Connection::StartOutboundTransfer(OutboundTransfer* transfer) {
+  if (!transfer->is_for_outbound_call()) {
+    return;
+  }
+  CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
+  DCHECK(car->call);
+  car->call->SetSending();
+
+  // Test cancellation when 'call_' is in 'SENDING' state.
+  MaybeInjectCancellation(car->call);
+}
+
 Connection::ProcessOutboundTransfersResult Connection::ProcessOutboundTransfers() {
   while (!outbound_transfers_.empty()) {
-    OutboundTransfer* transfer = &(outbound_transfers_.front());
-
-    if (!transfer->TransferStarted()) {
-      if (transfer->is_for_outbound_call()) {
-        CallAwaitingResponse* car = FindOrDie(awaiting_response_, transfer->call_id());
-        if (!car->call) {
-          // If the call has already timed out or has already been cancelled, the 'call'
-          // field would be set to NULL. In that case, don't bother sending it.
-          outbound_transfers_.pop_front();
-          transfer->Abort(Status::Aborted("already timed out or cancelled"));
-          delete transfer;
-          continue;
-        }
-
-        // If this is the start of the transfer, then check if the server has the
-        // required RPC flags. We have to wait until just before the transfer in
-        // order to ensure that the negotiation has taken place, so that the flags
-        // are available.
-        const set<RpcFeatureFlag>& required_features = car->call->required_rpc_features();
-        if (!includes(remote_features_.begin(), remote_features_.end(),
-                      required_features.begin(), required_features.end())) {
-          outbound_transfers_.pop_front();
-          Status s = Status::NotSupported("server does not support the required RPC features");
-          transfer->Abort(s);
-          Phase phase = negotiation_complete_ ? Phase::REMOTE_CALL : Phase::CONNECTION_NEGOTIATION;
-          car->call->SetFailed(std::move(s), phase);
-          // Test cancellation when 'call_' is in 'FINISHED_ERROR' state.
-          MaybeInjectCancellation(car->call);
-          car->call.reset();
-          delete transfer;
-          continue;
-        }
-
-        car->call->SetSending();
-
-        // Test cancellation when 'call_' is in 'SENDING' state.
-        MaybeInjectCancellation(car->call);
+    // Gather as many queued transfers as fit into a single writev() call, so
+    // that a burst of small calls or responses costs one system call rather
+    // than one per transfer.
+    struct iovec iov[IOV_MAX];
+    int n_iovecs = 0;
+    int n_transfers = 0;
+    auto it = outbound_transfers_.begin();
+    while (it != outbound_transfers_.end() && n_iovecs < IOV_MAX &&
+           (n_transfers == 0 || FLAGS_rpc_coalesce_outbound_transfers)) {
+      OutboundTransfer* transfer = &*it;
+      if (!transfer->TransferStarted() && !PrepareOutboundTransfer(transfer)) {
+        it = outbound_transfers_.erase(it);
+        delete transfer;
+        continue;
       }
+      n_iovecs += transfer->FillIovecs(&iov[n_iovecs], IOV_MAX - n_iovecs);
+      n_transfers++;
+      ++it;
+    }
+    if (n_transfers == 0) {
+      break;
     }
 
     last_activity_time_ = reactor_thread_->cur_time();
-    Status status = transfer->SendBuffer(*socket_);
+    int64_t written = 0;
+    Status status = socket_->Writev(iov, n_iovecs, &written);
     if (PREDICT_FALSE(!status.ok())) {
-      LOG(WARNING) << ToString() << " send error: " << status.ToString();
-      reactor_thread_->DestroyConnection(this, status);
-      return kConnectionDestroyed;
+      if (!Socket::IsTemporarySocketError(status.posix_code())) {
+        LOG(WARNING) << ToString() << " send error: " << status.ToString();
+        reactor_thread_->DestroyConnection(this, status);
+        return kConnectionDestroyed;
+      }
+      written = 0;
     }
 
-    if (!transfer->TransferFinished()) {
-      DVLOG(3) << ToString() << ": writeHandler: xfer not finished.";
-      return kMoreToSend;
+    // The write stops at the first byte it couldn't send, so it reached each
+    // transfer up to and including the first one left unfinished. Transfers
+    // past that one stay unstarted, and are checked again before the next
+    // write.
+    for (int i = 0; i < n_transfers; i++) {
+      OutboundTransfer* transfer = &outbound_transfers_.front();
+      if (!transfer->TransferStarted()) {
+        StartOutboundTransfer(transfer);
+      }
+      written -= transfer->AdvanceSent(written);
+      if (!transfer->TransferFinished()) {
+        DVLOG(3) << ToString() << ": writeHandler: xfer not finished.";
+        return kMoreToSend;
+      }
+      outbound_transfers_.pop_front();
+      delete transfer;
     }
-
-    outbound_transfers_.pop_front();
-    delete transfer;
+    DCHECK_EQ(0, written);
   }
 
   return kNoMoreToSend;
 }
 
+void Connection::FlushDeferredWrites() {
+  DCHECK(reactor_thread_->IsCurrentThread());
+  if (!shutdown_status_.ok() || write_io_.is_active() || outbound_transfers_.empty()) {
+    return;
+  }
+  if (ProcessOutboundTransfers() == kMoreToSend) {
+    write_io_.start();
+  }
+}
+
 std::string Connection::ToString() const {
   // This may be called from other threads, so we cannot
   // include anything in the output about the current state,
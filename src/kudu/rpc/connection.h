@@ -204,6 +204,12 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // NOTE: This may invoke DestroyConnection() on 'this'.
   ProcessOutboundTransfersResult ProcessOutboundTransfers();
 
+  // Sends the transfers queued while the reactor thread deferred writes (see
+  // ReactorThread::MaybeDeferWrites()).
+  //
+  // NOTE: This may invoke DestroyConnection() on 'this'.
+  void FlushDeferredWrites();
+
   // Safe to be called from other threads.
   std::string ToString() const;
 
@@ -319,6 +325,16 @@ class Connection : public RefCountedThreadSafe<Connection> {
   // This must be called from the reactor thread.
   void QueueOutbound(std::unique_ptr<OutboundTransfer> transfer);
 
+  // Performs the checks due before the first byte of 'transfer' is sent. If
+  // the transfer should not be sent after all, aborts it and returns false.
+  // Called each time a transfer which hasn't started yet is gathered into a
+  // write, since a gathered transfer may not be reached by that write.
+  bool PrepareOutboundTransfer(OutboundTransfer* transfer);
+
+  // Moves the call of 'transfer', if any, to the SENDING state. Called when a
+  // write first reaches 'transfer'.
+  void StartOutboundTransfer(OutboundTransfer* transfer);
+
   // Internal test function for injecting cancellation request when 'call'
   // reaches state specified in 'FLAGS_rpc_inject_cancellation_state'.
   void MaybeInjectCancellation(const std::shared_ptr<OutboundCall> &call);
@@ -50,6 +50,11 @@ void ConnectionId::set_network_plane(string network_plane) {
   network_plane_ = std::move(network_plane);
 }
 
+void ConnectionId::set_stream_index(int stream_index) {
+  DCHECK_GE(stream_index, 0);
+  stream_index_ = stream_index;
+}
+
 string ConnectionId::ToString() const {
   string remote;
   if (remote_.is_ip() && hostname_ != remote_.host()) {
@@ -63,10 +68,16 @@ string ConnectionId::ToString() const {
     network_plane = strings::Substitute(", network_plane=$0", network_plane_);
   }
 
-  return strings::Substitute("{remote=$0, user_credentials=$1$2}",
+  string stream;
+  if (stream_index_ != 0) {
+    stream = strings::Substitute(", stream=$0", stream_index_);
+  }
+
+  return strings::Substitute("{remote=$0, user_credentials=$1$2$3}",
                              remote,
                              user_credentials_.ToString(),
-                             network_plane);
+                             network_plane,
+                             stream);
 }
 
 size_t ConnectionId::HashCode() const {
@@ -75,6 +86,7 @@ size_t ConnectionId::HashCode() const {
   boost::hash_combine(seed, hostname_);
   boost::hash_combine(seed, user_credentials_.HashCode());
   boost::hash_combine(seed, network_plane_);
+  boost::hash_combine(seed, stream_index_);
   return seed;
 }
 
@@ -82,7 +94,8 @@ bool ConnectionId::Equals(const ConnectionId& other) const {
   return remote() == other.remote() &&
       hostname_ == other.hostname_ &&
       user_credentials().Equals(other.user_credentials()) &&
-      network_plane_ == other.network_plane_;
+      network_plane_ == other.network_plane_ &&
+      stream_index_ == other.stream_index_;
 }
 
 size_t ConnectionIdHash::operator() (const ConnectionId& conn_id) const {
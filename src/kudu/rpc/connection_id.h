@@ -55,6 +55,12 @@ class ConnectionId {
 
   const std::string& network_plane() const { return network_plane_; }
 
+  // The index of this connection among the parallel TCP streams opened to the
+  // same peer. See --rpc_connections_per_peer.
+  void set_stream_index(int stream_index);
+
+  int stream_index() const { return stream_index_; }
+
   // Returns a string representation of the object, not including the password field.
   std::string ToString() const;
 
@@ -74,6 +80,8 @@ class ConnectionId {
   // The name of the network plane adopted by this connection. Please see header comemnts
   // at proxy.h for details.
   std::string network_plane_;
+
+  int stream_index_ = 0;
 };
 
 class ConnectionIdHash {
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <memory>
 #include <ostream>
+#include <utility>
 
 #include <boost/container/vector.hpp>
 #include <glog/logging.h>
@@ -338,6 +339,10 @@ void InboundCall::DiscardTransfer() {
   transfer_.reset();
 }
 
+unique_ptr<InboundTransfer> InboundCall::ReleaseTransfer() {
+  return std::move(transfer_);
+}
+
 size_t InboundCall::GetTransferSize() {
   if (!transfer_) return 0;
   return transfer_->data().size();
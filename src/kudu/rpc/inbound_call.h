@@ -212,6 +212,11 @@ class InboundCall {
   // access sidecars or serialized_request() after this method is called.
   void DiscardTransfer();
 
+  // Like DiscardTransfer(), but hands the buffer to the caller instead of
+  // releasing it. Slices onto the sidecars remain valid while the returned
+  // transfer is alive.
+  std::unique_ptr<InboundTransfer> ReleaseTransfer();
+
   // Returns the size of the transfer buffer that backs this call. If the transfer does
   // not exist (e.g. GetTransferSize() is called after DiscardTransfer()), returns 0.
   size_t GetTransferSize();
@@ -68,6 +68,7 @@ MessengerBuilder::MessengerBuilder(std::string name)
       num_reactors_(4),
       min_negotiation_threads_(0),
       max_negotiation_threads_(4),
+      num_callback_threads_(0),
       coarse_timer_granularity_(MonoDelta::FromMilliseconds(100)),
       rpc_negotiation_timeout_ms_(3000),
       sasl_proto_name_("kudu"),
@@ -99,6 +100,11 @@ MessengerBuilder& MessengerBuilder::set_max_negotiation_threads(int max_negotiat
   return *this;
 }
 
+MessengerBuilder& MessengerBuilder::set_num_callback_threads(int num_callback_threads) {
+  num_callback_threads_ = num_callback_threads;
+  return *this;
+}
+
 MessengerBuilder& MessengerBuilder::set_coarse_timer_granularity(const MonoDelta &granularity) {
   coarse_timer_granularity_ = granularity;
   return *this;
@@ -294,6 +300,14 @@ void Messenger::ShutdownInternal(ShutdownMode mode) {
   for (Reactor* reactor : reactors_) {
     reactor->Shutdown(mode);
   }
+
+  // The reactors fail any outstanding calls on their way down, so wait for
+  // the resulting callbacks to run. With an async shutdown this is left to
+  // the destructor, since the last reference may be dropped from a callback.
+  if (callback_pool_ && mode == ShutdownMode::SYNC) {
+    callback_pool_->Wait();
+    callback_pool_->Shutdown();
+  }
 }
 
 Status Messenger::AddAcceptorPool(const Sockaddr &accept_addr,
@@ -359,7 +373,10 @@ Status Messenger::UnregisterService(const string& service_name) {
 }
 
 void Messenger::QueueOutboundCall(const shared_ptr<OutboundCall> &call) {
-  Reactor *reactor = RemoteToReactor(call->conn_id().remote());
+  if (callback_pool_) {
+    call->set_callback_pool(callback_pool_.get());
+  }
+  Reactor *reactor = ConnectionIdToReactor(call->conn_id());
   reactor->QueueOutboundCall(call);
 }
 
@@ -388,7 +405,7 @@ void Messenger::QueueInboundCall(unique_ptr<InboundCall> call) {
 }
 
 void Messenger::QueueCancellation(const shared_ptr<OutboundCall> &call) {
-  Reactor *reactor = RemoteToReactor(call->conn_id().remote());
+  Reactor *reactor = ConnectionIdToReactor(call->conn_id());
   reactor->QueueCancellation(call);
 }
 
@@ -422,11 +439,23 @@ Messenger::Messenger(const MessengerBuilder &bld)
       .set_min_threads(bld.min_negotiation_threads_)
       .set_max_threads(bld.max_negotiation_threads_)
       .Build(&server_negotiation_pool_));
+  if (bld.num_callback_threads_ > 0) {
+    CHECK_OK(ThreadPoolBuilder("rpc-callback")
+        .set_min_threads(bld.num_callback_threads_)
+        .set_max_threads(bld.num_callback_threads_)
+        .Build(&callback_pool_));
+  }
 }
 
 Messenger::~Messenger() {
   CHECK(closing_) << "Should have already shut down";
   STLDeleteElements(&reactors_);
+  if (callback_pool_) {
+    // This usually runs on the last reactor thread to exit.
+    ThreadRestrictions::ScopedAllowWait allow_wait;
+    callback_pool_->Wait();
+    callback_pool_->Shutdown();
+  }
 }
 
 Reactor* Messenger::RemoteToReactor(const Sockaddr &remote) {
@@ -437,6 +466,12 @@ Reactor* Messenger::RemoteToReactor(const Sockaddr &remote) {
   return reactors_[reactor_idx];
 }
 
+Reactor* Messenger::ConnectionIdToReactor(const ConnectionId& conn_id) {
+  uint32_t reactor_idx =
+      (conn_id.remote().HashCode() + conn_id.stream_index()) % reactors_.size();
+  return reactors_[reactor_idx];
+}
+
 Status Messenger::Init() {
   RETURN_NOT_OK(tls_context_->Init());
   for (Reactor* r : reactors_) {
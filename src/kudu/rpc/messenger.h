@@ -55,6 +55,7 @@ using security::RpcAuthentication;
 using security::RpcEncryption;
 
 class AcceptorPool;
+class ConnectionId;
 class DumpConnectionsRequestPB;
 class DumpConnectionsResponsePB;
 class InboundCall;
@@ -99,6 +100,13 @@ class MessengerBuilder {
   // to handle the blocking connection-negotiation step.
   MessengerBuilder &set_max_negotiation_threads(int max_negotiation_threads);
 
+  // Set the number of threads that run the callbacks of outbound calls. With
+  // the default of 0, callbacks run on the reactor threads. Otherwise, they are
+  // handed to a pool of this many threads so that slow or numerous callbacks
+  // don't hold up the reactors; callbacks of different calls may then run
+  // concurrently and in any order.
+  MessengerBuilder &set_num_callback_threads(int num_callback_threads);
+
   // Set the granularity with which connections are checked for keepalive.
   MessengerBuilder &set_coarse_timer_granularity(const MonoDelta &granularity);
 
@@ -168,6 +176,7 @@ class MessengerBuilder {
   int num_reactors_;
   int min_negotiation_threads_;
   int max_negotiation_threads_;
+  int num_callback_threads_;
   MonoDelta coarse_timer_granularity_;
   scoped_refptr<MetricEntity> metric_entity_;
   int64_t rpc_negotiation_timeout_ms_;
@@ -324,11 +333,16 @@ class Messenger {
   FRIEND_TEST(TestRpc, TestClientConnectionsMetrics);
   FRIEND_TEST(TestRpc, TestCredentialsPolicy);
   FRIEND_TEST(TestRpc, TestConnectionNetworkPlane);
+  FRIEND_TEST(TestRpc, TestConnectionsPerPeer);
   FRIEND_TEST(TestRpc, TestReopenOutboundConnections);
 
   explicit Messenger(const MessengerBuilder &bld);
 
   Reactor* RemoteToReactor(const Sockaddr &remote);
+
+  // Like RemoteToReactor(), but spreads the parallel streams to the same peer
+  // (see ConnectionId::stream_index()) across consecutive reactors.
+  Reactor* ConnectionIdToReactor(const ConnectionId& conn_id);
   Status Init();
   void RunTimeoutThread();
   void UpdateCurTime();
@@ -376,6 +390,9 @@ class Messenger {
   std::unique_ptr<ThreadPool> client_negotiation_pool_;
   std::unique_ptr<ThreadPool> server_negotiation_pool_;
 
+  // Runs the callbacks of outbound calls. Null if they run on the reactors.
+  std::unique_ptr<ThreadPool> callback_pool_;
+
   std::unique_ptr<security::TlsContext> tls_context_;
 
   // A TokenVerifier, which can verify client provided authentication tokens.
@@ -23,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -44,6 +45,8 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_int32(rpc_service_queue_shards);
+
 METRIC_DECLARE_counter(rpc_connections_accepted);
 METRIC_DECLARE_counter(rpcs_queue_overflow);
 
@@ -199,6 +202,36 @@ void IncrementBackpressureOrShutdown(const Status* status, int* backpressure, in
   }
 }
 
+// Test that calls from many clients are all served when the service queue is
+// sharded, including by service threads stealing calls queued on other shards.
+TEST_F(MultiThreadedRpcTest, TestShardedServiceQueue) {
+  FLAGS_rpc_service_queue_shards = 3;
+  n_worker_threads_ = 5;
+  Sockaddr server_addr;
+  ASSERT_OK(StartTestServer(&server_addr));
+
+  constexpr int kNumThreads = 8;
+  constexpr int kNumCalls = 100;
+  thread threads[kNumThreads];
+  Status statuses[kNumThreads];
+  for (int i = 0; i < kNumThreads; i++) {
+    auto* my_status = &statuses[i];
+    threads[i] = thread([this, server_addr, my_status]() {
+      shared_ptr<Messenger> client_messenger;
+      CHECK_OK(CreateMessenger("ClientSQ", &client_messenger));
+      Proxy p(client_messenger, server_addr, server_addr.host(),
+              GenericCalculatorService::static_service_name());
+      for (int j = 0; j < kNumCalls && my_status->ok(); j++) {
+        *my_status = DoTestSyncCall(p, GenericCalculatorService::kAddMethodName);
+      }
+    });
+  }
+  for (int i = 0; i < kNumThreads; i++) {
+    threads[i].join();
+    ASSERT_OK(statuses[i]);
+  }
+}
+
 // Test that we get a Service Unavailable error when we max out the incoming RPC service queue.
 TEST_F(MultiThreadedRpcTest, TestBlowOutServiceQueue) {
   const size_t kMaxConcurrency = 2;
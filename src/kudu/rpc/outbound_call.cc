@@ -45,6 +45,7 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/kernel_stack_watchdog.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/threadpool.h"
 
 // 100M cycles should be about 50ms on a 2Ghz box. This should be high
 // enough that involuntary context switches don't trigger it, but low enough
@@ -62,6 +63,7 @@ DEFINE_int32(rpc_inject_cancellation_state, -1,
              "will be injected. Should use values in OutboundCall::State only");
 TAG_FLAG(rpc_inject_cancellation_state, unsafe);
 
+using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -88,6 +90,7 @@ OutboundCall::OutboundCall(const ConnectionId& conn_id,
       conn_id_(conn_id),
       callback_(std::move(callback)),
       controller_(DCHECK_NOTNULL(controller)),
+      callback_pool_(nullptr),
       response_(DCHECK_NOTNULL(response_storage)),
       cancellation_requested_(false) {
   DVLOG(4) << "OutboundCall " << this << " constructed with state_: " << StateName(state_)
@@ -266,6 +269,18 @@ void OutboundCall::CallCallback() {
   // Clear references to outbound sidecars before invoking callback.
   sidecars_.clear();
 
+  if (callback_pool_) {
+    // The pool task keeps the call alive: once the reactor drops its
+    // reference, the caller may be the only other owner.
+    shared_ptr<OutboundCall> self = shared_from_this();
+    if (PREDICT_TRUE(callback_pool_->Submit([self]() { self->RunCallback(); }).ok())) {
+      return;
+    }
+  }
+  RunCallback();
+}
+
+void OutboundCall::RunCallback() {
   int64_t start_cycles = CycleClock::Now();
   {
     SCOPED_WATCH_STACK(100);
@@ -282,7 +297,8 @@ void OutboundCall::CallCallback() {
     double micros = static_cast<double>(wait_cycles) / base::CyclesPerSecond()
       * kMicrosPerSecond;
 
-    LOG(WARNING) << "RPC callback for " << ToString() << " blocked reactor thread for "
+    LOG(WARNING) << "RPC callback for " << ToString() << " blocked "
+                 << (callback_pool_ ? "callback" : "reactor") << " thread for "
                  << micros << "us";
   }
 }
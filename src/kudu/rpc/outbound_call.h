@@ -50,6 +50,9 @@ class Message;
 } // namespace google
 
 namespace kudu {
+
+class ThreadPool;
+
 namespace rpc {
 
 class CallResponse;
@@ -66,7 +69,7 @@ class RpcController;
 // then passed to the reactor thread to send on the wire. It's typically
 // kept using a shared_ptr because a call may terminate in any number
 // of different threads, making it tricky to enforce single ownership.
-class OutboundCall {
+class OutboundCall : public std::enable_shared_from_this<OutboundCall> {
  public:
 
   // Phases of an outbound RPC. Making an outbound RPC might involve establishing
@@ -112,6 +115,14 @@ class OutboundCall {
   // REQUIRES: must be called from the reactor thread.
   void Cancel();
 
+  // Run the callback on 'pool' once the call finishes instead of on the
+  // thread that finishes it, which is usually a reactor thread. If the pool
+  // no longer accepts tasks, the callback runs inline as before.
+  // Must be called before the call is handed to the reactor.
+  void set_callback_pool(ThreadPool* pool) {
+    callback_pool_ = pool;
+  }
+
   // Callback after the call has been put on the outbound connection queue.
   void SetQueued();
 
@@ -240,6 +251,10 @@ class OutboundCall {
   // hold references to outbound sidecars.
   void CallCallback();
 
+  // Invoke 'callback_' on the current thread, warning if it runs for longer
+  // than --rpc_callback_max_cycles.
+  void RunCallback();
+
   // The RPC header.
   // Parts of this (eg the call ID) are only assigned once this call has been
   // passed to the reactor thread and assigned a connection.
@@ -255,6 +270,9 @@ class OutboundCall {
   ResponseCallback callback_;
   RpcController* controller_;
 
+  // Pool on which 'callback_' is run, or null to run it inline.
+  ThreadPool* callback_pool_;
+
   // Pointer for the protobuf where the response should be written.
   google::protobuf::Message* response_;
 
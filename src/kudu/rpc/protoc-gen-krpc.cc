@@ -174,6 +174,9 @@ class MethodSubstitutions : public Substituter {
     (*map)["metric_enum_key"] = Substitute("kMetricIndex$0", method_->name());
     bool track_result = static_cast<bool>(method_->options().GetExtension(track_rpc_result));
     (*map)["track_result"] = track_result ? " true" : "false";
+    bool on_reactor = static_cast<bool>(method_->options().GetExtension(run_on_reactor));
+    (*map)["run_on_reactor"] = on_reactor ? "true" : "false";
+    (*map)["priority"] = RpcPriorityClass_Name(method_->options().GetExtension(priority));
     (*map)["authz_method"] = GetAuthzMethod(*method_).get_value_or("AuthorizeAllowAll");
   }
 
@@ -483,6 +486,8 @@ class CodeGenerator : public ::google::protobuf::compiler::CodeGenerator {
               "                           ctx);\n"
               "    };\n"
               "    mi->track_result = $track_result$;\n"
+              "    mi->run_on_reactor = $run_on_reactor$;\n"
+              "    mi->priority = kudu::rpc::$priority$;\n"
               "    mi->handler_latency_histogram =\n"
               "        METRIC_handler_latency_$rpc_full_name_plainchars$.Instantiate(entity);\n"
               "    mi->func = [this](const Message* req, Message* resp, RpcContext* ctx) {\n"
@@ -17,13 +17,17 @@
 
 #include "kudu/rpc/proxy.h"
 
+#include <cstddef>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <utility>
 
+#include <boost/functional/hash/hash.hpp>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/messenger.h"
 #include "kudu/rpc/outbound_call.h"
@@ -31,11 +35,21 @@
 #include "kudu/rpc/response_callback.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "kudu/rpc/user_credentials.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/notification.h"
 #include "kudu/util/status.h"
 #include "kudu/util/user.h"
 
+DEFINE_int32(rpc_connections_per_peer, 1,
+             "The number of TCP connections to open to each peer for each "
+             "network plane. Calls are spread across them by remote method, "
+             "so that bulk traffic such as tablet copies doesn't hold up "
+             "other methods behind it, and each connection is handled by a "
+             "different reactor thread where possible.");
+TAG_FLAG(rpc_connections_per_peer, advanced);
+TAG_FLAG(rpc_connections_per_peer, experimental);
+
 using google::protobuf::Message;
 using std::string;
 using std::shared_ptr;
@@ -78,8 +92,21 @@ void Proxy::AsyncRequest(const string& method,
   CHECK(!controller->call_) << "Controller should be reset";
   base::subtle::NoBarrier_Store(&is_started_, true);
   RemoteMethod remote_method(service_name_, method);
-  controller->call_.reset(
-      new OutboundCall(conn_id_, remote_method, response, controller, callback));
+  const int num_streams = FLAGS_rpc_connections_per_peer;
+  if (PREDICT_FALSE(num_streams > 1)) {
+    // Calls of the same method always share a stream, so they stay ordered
+    // with respect to each other.
+    size_t hash = 0;
+    boost::hash_combine(hash, service_name_);
+    boost::hash_combine(hash, method);
+    ConnectionId conn_id(conn_id_);
+    conn_id.set_stream_index(hash % num_streams);
+    controller->call_.reset(
+        new OutboundCall(conn_id, remote_method, response, controller, callback));
+  } else {
+    controller->call_.reset(
+        new OutboundCall(conn_id_, remote_method, response, controller, callback));
+  }
   controller->SetRequestParam(req);
   controller->SetMessenger(messenger_.get());
 
@@ -51,7 +51,9 @@ class UserCredentials;
 // A proxy object can optionally specify the "network plane" it uses. This allows
 // proxies of N services to be multiplexed on M TCP connections so that a higher priority
 // service (e.g. a control channel) may use a different connection than other services,
-// avoiding the chance of being blocked by traffic of other services.
+// avoiding the chance of being blocked by traffic of other services. Within a
+// network plane, --rpc_connections_per_peer can further split the calls of
+// different remote methods across several TCP connections.
 //
 // Proxy objects are thread-safe after initialization only.
 // Setters on the Proxy are not thread-safe, and calling a setter after any RPC
@@ -28,6 +28,7 @@
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <ev++.h>
@@ -54,6 +55,7 @@
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
+#include "kudu/util/numa_util.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/thread.h"
@@ -73,6 +75,7 @@ static const int kDefaultLibEvFlags = ev::AUTO;
 using std::string;
 using std::shared_ptr;
 using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
 DEFINE_bool(rpc_reopen_outbound_connections, false,
@@ -101,6 +104,14 @@ TAG_FLAG(tcp_keepalive_probe_period_s, advanced);
 TAG_FLAG(tcp_keepalive_retry_period_s, advanced);
 TAG_FLAG(tcp_keepalive_retry_count, advanced);
 
+DEFINE_bool(rpc_coalesce_outbound_transfers, true,
+            "Whether to send the calls and responses queued on a connection "
+            "together in a single system call, rather than one at a time. "
+            "Calls queued by a burst of tasks are held back until the whole "
+            "burst has been processed by the reactor.");
+TAG_FLAG(rpc_coalesce_outbound_transfers, advanced);
+TAG_FLAG(rpc_coalesce_outbound_transfers, runtime);
+
 METRIC_DEFINE_histogram(server, reactor_load_percent,
                         "Reactor Thread Load Percentage",
                         kudu::MetricUnit::kUnits,
@@ -149,13 +160,14 @@ void DoInitLibEv() {
 
 } // anonymous namespace
 
-ReactorThread::ReactorThread(Reactor* reactor, const MessengerBuilder& bld)
+ReactorThread::ReactorThread(Reactor* reactor, int numa_node, const MessengerBuilder& bld)
   : loop_(kDefaultLibEvFlags),
     cur_time_(MonoTime::Now()),
     last_unused_tcp_scan_(cur_time_),
     reactor_(reactor),
     connection_keepalive_time_(bld.connection_keepalive_time_),
     coarse_timer_granularity_(bld.coarse_timer_granularity_),
+    numa_node_(numa_node),
     total_client_conns_cnt_(0),
     total_server_conns_cnt_(0),
     rng_(GetRandomSeed32()) {
@@ -336,11 +348,30 @@ void ReactorThread::AsyncHandler(ev::async& /*watcher*/, int /*revents*/) {
   boost::intrusive::list<ReactorTask> tasks;
   reactor_->DrainTaskQueue(&tasks);
 
+  // When several tasks arrived at once, the calls and responses they queue
+  // are sent together once all of them have run.
+  deferring_writes_ = FLAGS_rpc_coalesce_outbound_transfers && tasks.size() > 1;
   while (!tasks.empty()) {
     ReactorTask& task = tasks.front();
     tasks.pop_front();
     task.Run(this);
   }
+  deferring_writes_ = false;
+
+  vector<scoped_refptr<Connection>> conns;
+  conns.swap(deferred_write_conns_);
+  for (const auto& conn : conns) {
+    conn->FlushDeferredWrites();
+  }
+}
+
+bool ReactorThread::MaybeDeferWrites(Connection* conn) {
+  DCHECK(IsCurrentThread());
+  if (!deferring_writes_) {
+    return false;
+  }
+  deferred_write_conns_.emplace_back(conn);
+  return true;
 }
 
 void ReactorThread::RegisterConnection(scoped_refptr<Connection> conn) {
@@ -499,6 +530,7 @@ bool ReactorThread::IsCurrentThread() const {
 void ReactorThread::RunThread() {
   ThreadRestrictions::SetWaitAllowed(false);
   ThreadRestrictions::SetIOAllowed(false);
+  PinCurrentThreadToNumaNode(numa_node_);
   DVLOG(6) << "Calling ReactorThread::RunThread()...";
   loop_.run(0);
   VLOG(1) << name() << " thread exiting.";
@@ -760,7 +792,7 @@ Reactor::Reactor(shared_ptr<Messenger> messenger,
     : messenger_(std::move(messenger)),
       name_(StringPrintf("%s_R%03d", messenger_->name().c_str(), index)),
       closing_(false),
-      thread_(this, bld) {
+      thread_(this, NumaNodeForThread(index), bld) {
   static std::once_flag libev_once;
   std::call_once(libev_once, DoInitLibEv);
 }
@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/list_hook.hpp>
@@ -144,7 +145,7 @@ class ReactorThread {
                                   ConnectionIdHash, ConnectionIdEqual>
       conn_multimap_t;
 
-  ReactorThread(Reactor* reactor, const MessengerBuilder& bld);
+  ReactorThread(Reactor* reactor, int numa_node, const MessengerBuilder& bld);
 
   // This may be called from another thread.
   Status Init();
@@ -198,6 +199,12 @@ class ReactorThread {
   // Must be called from the reactor thread.
   Status GetMetrics(ReactorMetrics *metrics);
 
+  // If this thread is running a batch of tasks, records that 'conn' has
+  // transfers to send once the batch is done, and returns true. Otherwise
+  // returns false, and the caller should send them right away.
+  // Must be called from the reactor thread.
+  bool MaybeDeferWrites(Connection* conn);
+
  private:
   friend class AssignOutboundCallTask;
   friend class CancellationTask;
@@ -302,6 +309,11 @@ class ReactorThread {
   // List of current connections coming into the server.
   conn_list_t server_conns_;
 
+  // Whether writes are being deferred until the current batch of tasks has
+  // run, and the connections which deferred them. See MaybeDeferWrites().
+  bool deferring_writes_ = false;
+  std::vector<scoped_refptr<Connection>> deferred_write_conns_;
+
   Reactor *reactor_;
 
   // If a connection has been idle for this much time, it is torn down.
@@ -310,6 +322,9 @@ class ReactorThread {
   // Scan for idle connections on this granularity.
   const MonoDelta coarse_timer_granularity_;
 
+  // The NUMA node the thread is pinned to, or -1.
+  const int numa_node_;
+
   // Metrics.
   scoped_refptr<Histogram> invoke_us_histogram_;
   scoped_refptr<Histogram> load_percent_histogram_;
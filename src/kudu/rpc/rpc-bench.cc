@@ -67,6 +67,10 @@ DEFINE_int32(worker_threads, 1,
 DEFINE_int32(server_reactors, 4,
              "Number of server reactor threads");
 
+DEFINE_int32(client_callback_threads, 0,
+             "Number of threads per client messenger that run RPC callbacks for "
+             "the async benchmark. If 0, callbacks run on the client reactors.");
+
 DEFINE_int32(run_seconds, 1, "Seconds to run the test");
 
 DECLARE_bool(rpc_encrypt_loopback_connections);
@@ -114,6 +118,7 @@ class RpcBench : public RpcTestBase {
     } else {
       LOG(INFO) << "Client reactors:  " << FLAGS_client_threads;
       LOG(INFO) << "Call concurrency: " << FLAGS_async_call_concurrency;
+      LOG(INFO) << "Callback threads: " << FLAGS_client_callback_threads;
     }
 
     LOG(INFO) << "Worker threads:   " << FLAGS_worker_threads;
@@ -251,6 +256,7 @@ TEST_F(RpcBench, BenchmarkCallsAsync) {
   int concurrency = FLAGS_async_call_concurrency;
 
   vector<shared_ptr<Messenger>> messengers;
+  n_callback_threads_ = FLAGS_client_callback_threads;
   for (int i = 0; i < threads; i++) {
     shared_ptr<Messenger> m;
     ASSERT_OK(CreateMessenger("Client", &m));
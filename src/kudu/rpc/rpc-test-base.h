@@ -418,6 +418,7 @@ class RpcTestBase : public KuduTest {
     : n_worker_threads_(3),
       service_queue_length_(100),
       n_server_reactor_threads_(3),
+      n_callback_threads_(0),
       keepalive_time_ms_(1000),
       metric_entity_(METRIC_ENTITY_server.Instantiate(&metric_registry_, "test.rpc_test")) {
   }
@@ -454,6 +455,7 @@ class RpcTestBase : public KuduTest {
     }
 
     bld.set_num_reactors(n_reactors);
+    bld.set_num_callback_threads(n_callback_threads_);
     bld.set_connection_keepalive_time(MonoDelta::FromMilliseconds(keepalive_time_ms_));
     if (keepalive_time_ms_ >= 0) {
       // In order for the keepalive timing to be accurate, we need to scan connections
@@ -669,6 +671,7 @@ class RpcTestBase : public KuduTest {
   int n_worker_threads_;
   int service_queue_length_;
   int n_server_reactor_threads_;
+  int n_callback_threads_;
   int keepalive_time_ms_;
 
   MetricRegistry metric_registry_;
@@ -53,6 +53,11 @@ void RpcRetrier::DelayedRetry(Rpc* rpc, const Status& why_status) {
       [this, rpc](const Status& s) { this->DelayedRetryCb(rpc, s); }, backoff);
 }
 
+void RpcRetrier::DelayedSend(Rpc* rpc, const MonoDelta& delay) {
+  messenger_->ScheduleOnReactor(
+      [this, rpc](const Status& s) { this->DelayedRetryCb(rpc, s); }, delay);
+}
+
 MonoDelta RpcRetrier::ComputeBackoff(int num_attempts) const {
   if (backoff_ == BackoffType::LINEAR) {
     return MonoDelta::FromMilliseconds(num_attempts + ((rand() % 5)));
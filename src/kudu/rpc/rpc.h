@@ -152,6 +152,13 @@ class RpcRetrier {
   // Callers should ensure that 'rpc' remains alive.
   void DelayedRetry(Rpc* rpc, const Status& why_status);
 
+  // Sends an RPC for the first time after 'delay', e.g. to honor a delay
+  // suggested by the server. As with DelayedRetry(), the callback fires with
+  // a timeout error instead if the RPC's deadline has expired by then.
+  //
+  // Callers should ensure that 'rpc' remains alive.
+  void DelayedSend(Rpc* rpc, const MonoDelta& delay);
+
   RpcController* mutable_controller() { return &controller_; }
   const RpcController& controller() const { return controller_; }
 
@@ -207,6 +214,11 @@ class Rpc {
   // Subclasses should use SendRpcCb() below as the callback function.
   virtual void SendRpc() = 0;
 
+  // Same as SendRpc(), but only sends the RPC after 'delay'.
+  void SendRpcAfter(const MonoDelta& delay) {
+    retrier_.DelayedSend(this, delay);
+  }
+
   // Returns a string representation of the RPC.
   virtual std::string ToString() const = 0;
 
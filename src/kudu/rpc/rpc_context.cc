@@ -30,6 +30,7 @@
 #include "kudu/rpc/remote_user.h"
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/rpc/transfer.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/pb_util.h"
@@ -167,6 +168,10 @@ void RpcContext::DiscardTransfer() {
   call_->DiscardTransfer();
 }
 
+unique_ptr<InboundTransfer> RpcContext::ReleaseTransfer() {
+  return call_->ReleaseTransfer();
+}
+
 const Sockaddr& RpcContext::remote_address() const {
   return call_->remote_address();
 }
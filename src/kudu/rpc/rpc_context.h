@@ -44,6 +44,7 @@ namespace rpc {
 class InboundCall;
 class RemoteUser;
 class ResultTracker;
+class InboundTransfer;
 class RpcSidecar;
 
 #define PANIC_RPC(rpc_context, message) \
@@ -187,6 +188,14 @@ class RpcContext {
   // won't be processed any further.
   void DiscardTransfer();
 
+  // Transfers ownership of the memory associated with the inbound call's payload
+  // to the caller. Sidecar slices previously obtained from GetInboundSidecar()
+  // stay valid for as long as the returned transfer is alive, so a handler can
+  // hold on to large sidecars past the end of the call without copying them.
+  // It is an error to call GetInboundSidecar() after this method. request_pb()
+  // remains valid.
+  std::unique_ptr<InboundTransfer> ReleaseTransfer();
+
   // Return the remote IP address and port which sent the current RPC call.
   const Sockaddr& remote_address() const;
 
@@ -20,6 +20,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/container/vector.hpp>
@@ -30,6 +32,7 @@
 #include "kudu/util/faststring.h"
 #include "kudu/util/status.h"
 
+using std::string;
 using std::unique_ptr;
 using std::vector;
 
@@ -52,6 +55,24 @@ class SliceSidecar : public RpcSidecar {
   const Slice slice_;
 };
 
+// Like SliceSidecar, but wraps several slices.
+class SlicesSidecar : public RpcSidecar {
+ public:
+  explicit SlicesSidecar(vector<Slice> slices) : slices_(std::move(slices)) { }
+  void AppendSlices(TransferPayload* payload) const override {
+    payload->insert(payload->end(), slices_.begin(), slices_.end());
+  }
+  size_t TotalSize() const override {
+    size_t ret = 0;
+    for (const auto& slice : slices_) {
+      ret += slice.size();
+    }
+    return ret;
+  }
+ private:
+  const vector<Slice> slices_;
+};
+
 class FaststringSidecar : public RpcSidecar {
  public:
   explicit FaststringSidecar(faststring data) {
@@ -75,6 +96,20 @@ class FaststringSidecar : public RpcSidecar {
   vector<faststring> data_;
 };
 
+// Sidecar that owns a string, so that data read into one needn't be copied.
+class StringSidecar : public RpcSidecar {
+ public:
+  explicit StringSidecar(string data) : data_(std::move(data)) { }
+  void AppendSlices(TransferPayload* payload) const override {
+    payload->push_back(Slice(data_));
+  }
+  size_t TotalSize() const override {
+    return data_.size();
+  }
+ private:
+  const string data_;
+};
+
 unique_ptr<RpcSidecar> RpcSidecar::FromFaststring(faststring data) {
   return unique_ptr<RpcSidecar>(new FaststringSidecar(std::move(data)));
 }
@@ -83,10 +118,18 @@ unique_ptr<RpcSidecar> RpcSidecar::FromFaststrings(vector<faststring> data) {
   return unique_ptr<RpcSidecar>(new FaststringSidecar(std::move(data)));
 }
 
+unique_ptr<RpcSidecar> RpcSidecar::FromString(string data) {
+  return unique_ptr<RpcSidecar>(new StringSidecar(std::move(data)));
+}
+
 unique_ptr<RpcSidecar> RpcSidecar::FromSlice(Slice slice) {
   return unique_ptr<RpcSidecar>(new SliceSidecar(slice));
 }
 
+unique_ptr<RpcSidecar> RpcSidecar::FromSlices(vector<Slice> slices) {
+  return unique_ptr<RpcSidecar>(new SlicesSidecar(std::move(slices)));
+}
+
 
 Status RpcSidecar::ParseSidecars(
     const ::google::protobuf::RepeatedField<::google::protobuf::uint32>& offsets,
@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <boost/container/small_vector.hpp>
@@ -58,7 +59,10 @@ class RpcSidecar {
  public:
   static std::unique_ptr<RpcSidecar> FromFaststring(faststring data);
   static std::unique_ptr<RpcSidecar> FromFaststrings(std::vector<faststring> data);
+  static std::unique_ptr<RpcSidecar> FromString(std::string data);
   static std::unique_ptr<RpcSidecar> FromSlice(Slice slice);
+  // Like FromSlice(), but the sidecar is the concatenation of 'slices'.
+  static std::unique_ptr<RpcSidecar> FromSlices(std::vector<Slice> slices);
 
   // Utility method to parse a series of sidecar slices into 'sidecars' from 'buffer' and
   // a set of offsets.
@@ -25,6 +25,7 @@
 #include <google/protobuf/message.h>
 
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/util/metrics.h"
 
 namespace kudu {
@@ -51,6 +52,13 @@ struct RpcMethodInfo : public RefCountedThreadSafe<RpcMethodInfo> {
   // Whether we should track this method's result, using ResultTracker.
   bool track_result;
 
+  // Whether the method's handler is cheap and never blocks, so that its calls
+  // may be handled on the reactor thread which received them.
+  bool run_on_reactor;
+
+  // The priority class of the method's calls in the service queue.
+  RpcPriorityClass priority;
+
   // The authorization function for this RPC. If this function
   // returns false, the RPC has already been handled (i.e. rejected)
   // by the authorization function.
@@ -17,6 +17,8 @@
 
 #include "kudu/rpc/service_pool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <ostream>
@@ -25,6 +27,7 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/basictypes.h"
@@ -36,13 +39,33 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/rpc/service_queue.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/numa_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/thread.h"
 #include "kudu/util/trace.h"
 
+DEFINE_int32(rpc_service_queue_shards, 1,
+             "Number of shards the queue of each RPC service is split into. "
+             "Each reactor thread queues its calls on one shard, and each "
+             "service thread prefers the calls of one shard, taking calls from "
+             "other shards only when its own is empty. Sharding reduces "
+             "contention on the queue at high RPC rates. The queue's capacity "
+             "is split between its shards, which evict calls independently when "
+             "full. Capped at the number of service threads.");
+TAG_FLAG(rpc_service_queue_shards, experimental);
+
+DEFINE_bool(rpc_run_methods_on_reactor, true,
+            "Whether calls of RPC methods marked with the run_on_reactor option, "
+            "whose handlers are cheap and never block, are handled directly on "
+            "the reactor thread which received them, rather than being queued "
+            "for a service thread.");
+TAG_FLAG(rpc_run_methods_on_reactor, advanced);
+TAG_FLAG(rpc_run_methods_on_reactor, runtime);
+
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -71,15 +94,25 @@ METRIC_DEFINE_counter(server, rpcs_queue_overflow,
 namespace kudu {
 namespace rpc {
 
+namespace {
+
+// Identifies the threads which queue calls, in the order they first queue one,
+// to spread them across the shards of service queues.
+std::atomic<int> next_producer_id(0);
+__thread int tl_producer_id = -1;
+
+} // anonymous namespace
+
 ServicePool::ServicePool(unique_ptr<ServiceIf> service,
                          const scoped_refptr<MetricEntity>& entity,
                          size_t service_queue_length)
   : service_(std::move(service)),
-    service_queue_(service_queue_length),
+    service_queue_length_(service_queue_length),
     incoming_queue_time_(METRIC_rpc_incoming_queue_time.Instantiate(entity)),
     rpcs_timed_out_in_queue_(METRIC_rpcs_timed_out_in_queue.Instantiate(entity)),
     rpcs_queue_overflow_(METRIC_rpcs_queue_overflow.Instantiate(entity)),
     closing_(false) {
+  service_queues_.emplace_back(new LifoServiceQueue(service_queue_length));
 }
 
 ServicePool::~ServicePool() {
@@ -87,17 +120,37 @@ ServicePool::~ServicePool() {
 }
 
 Status ServicePool::Init(int num_threads) {
+  // Every shard needs a thread of its own, so that calls queued on a shard are
+  // never left waiting for other shards' threads to run out of work.
+  const int num_shards = std::max(1, std::min(FLAGS_rpc_service_queue_shards, num_threads));
+  if (num_shards > 1) {
+    // No calls can have been queued before the pool is started.
+    DCHECK_EQ(1, service_queues_.size());
+    DCHECK(service_queues_[0]->empty());
+    service_queues_.clear();
+    for (int i = 0; i < num_shards; i++) {
+      service_queues_.emplace_back(new LifoServiceQueue(
+          std::max<size_t>(1, service_queue_length_ / num_shards)));
+    }
+  }
   for (int i = 0; i < num_threads; i++) {
     scoped_refptr<kudu::Thread> new_thread;
+    const int shard = i % service_queues_.size();
+    const int numa_node = NumaNodeForThread(i);
     CHECK_OK(kudu::Thread::Create("service pool", "rpc worker",
-                                  [this]() { this->RunThread(); }, &new_thread));
+                                  [this, shard, numa_node]() {
+                                    PinCurrentThreadToNumaNode(numa_node);
+                                    this->RunThread(shard);
+                                  }, &new_thread));
     threads_.push_back(new_thread);
   }
   return Status::OK();
 }
 
 void ServicePool::Shutdown() {
-  service_queue_.Shutdown();
+  for (const auto& queue : service_queues_) {
+    queue->Shutdown();
+  }
 
   MutexLock lock(shutdown_lock_);
   if (closing_) return;
@@ -110,27 +163,29 @@ void ServicePool::Shutdown() {
   // Now we must drain the service queue.
   Status status = Status::ServiceUnavailable("Service is shutting down");
   std::unique_ptr<InboundCall> incoming;
-  while (service_queue_.BlockingGet(&incoming)) {
-    incoming.release()->RespondFailure(ErrorStatusPB::FATAL_SERVER_SHUTTING_DOWN, status);
+  for (const auto& queue : service_queues_) {
+    while (queue->TryGet(&incoming)) {
+      incoming.release()->RespondFailure(ErrorStatusPB::FATAL_SERVER_SHUTTING_DOWN, status);
+    }
   }
 
   service_->Shutdown();
 }
 
-void ServicePool::RejectTooBusy(InboundCall* c) {
+void ServicePool::RejectTooBusy(InboundCall* c, const LifoServiceQueue& queue) {
   string err_msg =
       Substitute("$0 request on $1 from $2 dropped due to backpressure. "
                  "The service queue is full; it has $3 items.",
                  c->remote_method().method_name(),
                  service_->service_name(),
                  c->remote_address().ToString(),
-                 service_queue_.max_size());
+                 queue.max_size());
   rpcs_queue_overflow_->Increment();
   KLOG_EVERY_N_SECS(WARNING, 1) << err_msg << THROTTLE_MSG;
   c->RespondFailure(ErrorStatusPB::ERROR_SERVER_TOO_BUSY,
                     Status::ServiceUnavailable(err_msg));
   DLOG(INFO) << err_msg << " Contents of service queue:\n"
-             << service_queue_.ToString();
+             << queue.ToString();
 
   if (too_busy_hook_) {
     too_busy_hook_();
@@ -159,18 +214,30 @@ Status ServicePool::QueueInboundCall(unique_ptr<InboundCall> call) {
                                            ", "));
   }
 
+  // Cheap calls are handled right away, sparing them the hand-offs to and
+  // from a service thread.
+  const RpcMethodInfo* method_info = c->method_info();
+  if (method_info && method_info->run_on_reactor && FLAGS_rpc_run_methods_on_reactor) {
+    c->RecordHandlingStarted(incoming_queue_time_.get());
+    ADOPT_TRACE(c->trace());
+    TRACE_TO(c->trace(), "Handling call on reactor thread");
+    service_->Handle(c);
+    return Status::OK();
+  }
+
   TRACE_TO(c->trace(), "Inserting onto call queue");
 
   // Queue message on service queue
   boost::optional<InboundCall*> evicted;
-  auto queue_status = service_queue_.Put(c, &evicted);
+  LifoServiceQueue* queue = nullptr;
+  auto queue_status = PutCall(c, &evicted, &queue);
   if (queue_status == QUEUE_FULL) {
-    RejectTooBusy(c);
+    RejectTooBusy(c, *queue);
     return Status::OK();
   }
 
   if (PREDICT_FALSE(evicted != boost::none)) {
-    RejectTooBusy(*evicted);
+    RejectTooBusy(*evicted, *queue);
   }
 
   if (PREDICT_TRUE(queue_status == QUEUE_SUCCESS)) {
@@ -191,10 +258,44 @@ Status ServicePool::QueueInboundCall(unique_ptr<InboundCall> call) {
   return status;
 }
 
-void ServicePool::RunThread() {
+QueueStatus ServicePool::PutCall(InboundCall* c, boost::optional<InboundCall*>* evicted,
+                                 LifoServiceQueue** queue) {
+  const int num_shards = service_queues_.size();
+  int shard = 0;
+  if (num_shards > 1) {
+    if (PREDICT_FALSE(tl_producer_id < 0)) {
+      tl_producer_id = next_producer_id++;
+    }
+    shard = tl_producer_id % num_shards;
+    for (int i = 0; i < num_shards; i++) {
+      if (service_queues_[(shard + i) % num_shards]->TryHandOff(c)) {
+        return QUEUE_SUCCESS;
+      }
+    }
+  }
+  *queue = service_queues_[shard].get();
+  return (*queue)->Put(c, evicted);
+}
+
+bool ServicePool::GetCall(int shard, std::unique_ptr<InboundCall>* call) {
+  const int num_shards = service_queues_.size();
+  if (num_shards > 1) {
+    for (int i = 0; i < num_shards; i++) {
+      if (service_queues_[(shard + i) % num_shards]->TryGet(call)) {
+        return true;
+      }
+    }
+  }
+  // Calls are only queued on a shard while none of its threads is waiting,
+  // and each of them checks its shard again before waiting, so calls queued
+  // on other shards meanwhile are left to those shards' threads.
+  return service_queues_[shard]->BlockingGet(call);
+}
+
+void ServicePool::RunThread(int shard) {
   while (true) {
     std::unique_ptr<InboundCall> incoming;
-    if (!service_queue_.BlockingGet(&incoming)) {
+    if (!GetCall(shard, &incoming)) {
       VLOG(1) << "ServicePool: messenger shutting down.";
       return;
     }
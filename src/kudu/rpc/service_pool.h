@@ -91,12 +91,32 @@ class ServicePool : public RpcService {
   const std::string service_name() const;
 
  private:
-  void RunThread();
-  void RejectTooBusy(InboundCall* c);
+  // Runs a service thread, which prefers calls queued on shard 'shard' of the
+  // service queue.
+  void RunThread(int shard);
+
+  // Gets a call for a service thread of shard 'shard': one queued on that
+  // shard, else one stolen from another shard, else the next call handed to
+  // the shard, blocking until there's one. Returns false once the shard is
+  // shut down and empty.
+  bool GetCall(int shard, std::unique_ptr<InboundCall>* call);
+
+  // Queues 'c' on the shard of the calling thread, unless a service thread of
+  // any shard is waiting for work, in which case 'c' is handed to it. On
+  // failure, sets 'queue' to the shard that 'c' was queued on.
+  QueueStatus PutCall(InboundCall* c, boost::optional<InboundCall*>* evicted,
+                      LifoServiceQueue** queue);
+
+  void RejectTooBusy(InboundCall* c, const LifoServiceQueue& queue);
 
   std::unique_ptr<ServiceIf> service_;
   std::vector<scoped_refptr<kudu::Thread> > threads_;
-  LifoServiceQueue service_queue_;
+  const size_t service_queue_length_;
+
+  // The service queue, split into shards per --rpc_service_queue_shards once
+  // the thread pool is started. Each service thread prefers one shard, and each
+  // thread queueing calls puts them on one shard.
+  std::vector<std::unique_ptr<LifoServiceQueue>> service_queues_;
   scoped_refptr<Histogram> incoming_queue_time_;
   scoped_refptr<Counter> rpcs_timed_out_in_queue_;
   scoped_refptr<Counter> rpcs_queue_overflow_;
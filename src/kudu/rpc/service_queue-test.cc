@@ -30,7 +30,10 @@
 
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/inbound_call.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/service_if.h"
 #include "kudu/rpc/service_queue.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/stopwatch.h"
@@ -147,5 +150,82 @@ TEST(TestServiceQueue, LifoServiceQueuePerf) {
   LOG(INFO) << "Avg idle workers:     " << total_idle_workers / static_cast<double>(total_sample);
 }
 
+// Returns a new call of a method of priority class 'priority'.
+static InboundCall* NewCall(RpcPriorityClass priority) {
+  scoped_refptr<RpcMethodInfo> method_info(new RpcMethodInfo());
+  method_info->priority = priority;
+  InboundCall* call = new InboundCall(nullptr);
+  call->set_method_info(std::move(method_info));
+  return call;
+}
+
+// Returns the priority class of the method of 'call'.
+static RpcPriorityClass PriorityOf(const unique_ptr<InboundCall>& call) {
+  return call->method_info()->priority;
+}
+
+// Test that queued calls are dequeued in a weighted round-robin of their
+// priority classes.
+TEST(TestServiceQueue, TestPriorityClasses) {
+  LifoServiceQueue queue(100);
+  for (int i = 0; i < 8; i++) {
+    for (auto priority : { PRIORITY_LOW, PRIORITY_NORMAL, PRIORITY_HIGH }) {
+      boost::optional<InboundCall*> evicted;
+      ASSERT_EQ(QUEUE_SUCCESS, queue.Put(NewCall(priority), &evicted));
+      ASSERT_TRUE(evicted == boost::none);
+    }
+  }
+
+  // Each round takes 4 high, 2 normal and 1 low priority calls.
+  const vector<RpcPriorityClass> kRound = {
+    PRIORITY_HIGH, PRIORITY_HIGH, PRIORITY_HIGH, PRIORITY_HIGH,
+    PRIORITY_NORMAL, PRIORITY_NORMAL, PRIORITY_LOW
+  };
+  unique_ptr<InboundCall> call;
+  for (int round = 0; round < 2; round++) {
+    for (auto expected : kRound) {
+      ASSERT_TRUE(queue.TryGet(&call));
+      ASSERT_EQ(expected, PriorityOf(call));
+    }
+  }
+  // Once the high priority calls run out, the others share the queue.
+  for (auto expected : { PRIORITY_NORMAL, PRIORITY_NORMAL, PRIORITY_LOW }) {
+    ASSERT_TRUE(queue.TryGet(&call));
+    ASSERT_EQ(expected, PriorityOf(call));
+  }
+  while (queue.TryGet(&call)) {
+    ASSERT_NE(PRIORITY_HIGH, PriorityOf(call));
+  }
+  ASSERT_TRUE(queue.empty());
+}
+
+// Test that overflows evict calls of the lowest priority class first.
+TEST(TestServiceQueue, TestPriorityEviction) {
+  LifoServiceQueue queue(2);
+  boost::optional<InboundCall*> evicted;
+  ASSERT_EQ(QUEUE_SUCCESS, queue.Put(NewCall(PRIORITY_LOW), &evicted));
+  ASSERT_EQ(QUEUE_SUCCESS, queue.Put(NewCall(PRIORITY_HIGH), &evicted));
+  ASSERT_TRUE(evicted == boost::none);
+
+  // A normal priority call bumps the low priority one.
+  ASSERT_EQ(QUEUE_SUCCESS, queue.Put(NewCall(PRIORITY_NORMAL), &evicted));
+  ASSERT_TRUE(evicted != boost::none);
+  unique_ptr<InboundCall> evicted_call(evicted.get());
+  ASSERT_EQ(PRIORITY_LOW, PriorityOf(evicted_call));
+
+  // A low priority call doesn't fit anymore.
+  unique_ptr<InboundCall> rejected_call(NewCall(PRIORITY_LOW));
+  evicted = boost::none;
+  ASSERT_EQ(QUEUE_FULL, queue.Put(rejected_call.get(), &evicted));
+  ASSERT_TRUE(evicted == boost::none);
+
+  unique_ptr<InboundCall> call;
+  ASSERT_TRUE(queue.TryGet(&call));
+  ASSERT_EQ(PRIORITY_HIGH, PriorityOf(call));
+  ASSERT_TRUE(queue.TryGet(&call));
+  ASSERT_EQ(PRIORITY_NORMAL, PriorityOf(call));
+  ASSERT_FALSE(queue.TryGet(&call));
+}
+
 } // namespace rpc
 } // namespace kudu
@@ -23,23 +23,66 @@
 #include <boost/optional/optional.hpp>
 
 #include "kudu/gutil/port.h"
+#include "kudu/rpc/rpc_header.pb.h"
+#include "kudu/rpc/service_if.h"
 
 namespace kudu {
 namespace rpc {
 
+namespace {
+
+// The weights of the priority classes, indexed by RpcPriorityClass.
+const int kPriorityWeights[] = { 1, 2, 4 };
+
+} // anonymous namespace
+
 __thread LifoServiceQueue::ConsumerState* LifoServiceQueue::tl_consumer_ = nullptr;
 
 LifoServiceQueue::LifoServiceQueue(int max_size)
    : shutdown_(false),
-     max_queue_size_(max_size) {
+     max_queue_size_(max_size),
+     queue_size_(0) {
   CHECK_GT(max_queue_size_, 0);
+  static_assert(arraysize(kPriorityWeights) == kNumPriorities,
+                "every priority class needs a weight");
+  for (int p = 0; p < kNumPriorities; p++) {
+    credits_[p] = kPriorityWeights[p];
+  }
 }
 
 LifoServiceQueue::~LifoServiceQueue() {
-  DCHECK(queue_.empty())
+  DCHECK_EQ(0, queue_size_)
       << "ServiceQueue holds bare pointers at destruction time";
 }
 
+int LifoServiceQueue::PriorityOf(InboundCall* call) {
+  const RpcMethodInfo* method_info = call->method_info();
+  return method_info ? method_info->priority : PRIORITY_NORMAL;
+}
+
+InboundCall* LifoServiceQueue::PopLocked() {
+  DCHECK_GT(queue_size_, 0);
+  while (true) {
+    // Take the most urgent call of the highest priority class which has calls
+    // and credits left.
+    for (int p = kNumPriorities - 1; p >= 0; p--) {
+      auto& queue = queues_[p];
+      if (!queue.empty() && credits_[p] > 0) {
+        credits_[p]--;
+        auto it = queue.begin();
+        InboundCall* call = *it;
+        queue.erase(it);
+        queue_size_--;
+        return call;
+      }
+    }
+    // Every class with calls has used up its credits.
+    for (int p = 0; p < kNumPriorities; p++) {
+      credits_[p] = kPriorityWeights[p];
+    }
+  }
+}
+
 bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
   auto consumer = tl_consumer_;
   if (PREDICT_FALSE(!consumer)) {
@@ -51,10 +94,8 @@ bool LifoServiceQueue::BlockingGet(std::unique_ptr<InboundCall>* out) {
   while (true) {
     {
       std::lock_guard<simple_spinlock> l(lock_);
-      if (!queue_.empty()) {
-        auto it = queue_.begin();
-        out->reset(*it);
-        queue_.erase(it);
+      if (queue_size_ > 0) {
+        out->reset(PopLocked());
         return true;
       }
       if (PREDICT_FALSE(shutdown_)) {
@@ -80,10 +121,10 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
     return QUEUE_SHUTDOWN;
   }
 
-  DCHECK(!(waiting_consumers_.size() > 0 && queue_.size() > 0));
+  DCHECK(!(waiting_consumers_.size() > 0 && queue_size_ > 0));
 
   // fast path
-  if (queue_.empty() && waiting_consumers_.size() > 0) {
+  if (queue_size_ == 0 && waiting_consumers_.size() > 0) {
     auto consumer = waiting_consumers_[waiting_consumers_.size() - 1];
     waiting_consumers_.pop_back();
     // Notify condition var(and wake up consumer thread) takes time,
@@ -93,23 +134,53 @@ QueueStatus LifoServiceQueue::Put(InboundCall* call,
     return QUEUE_SUCCESS;
   }
 
-  if (PREDICT_FALSE(queue_.size() >= max_queue_size_)) {
-    // eviction
-    DCHECK_EQ(queue_.size(), max_queue_size_);
-    auto it = queue_.end();
+  const int priority = PriorityOf(call);
+  if (PREDICT_FALSE(queue_size_ >= max_queue_size_)) {
+    // eviction: the call with the latest deadline in the lowest priority
+    // class with calls goes, unless 'call' would go before it.
+    DCHECK_EQ(queue_size_, max_queue_size_);
+    int lowest = 0;
+    while (queues_[lowest].empty()) {
+      lowest++;
+    }
+    auto& queue = queues_[lowest];
+    auto it = queue.end();
     --it;
-    if (DeadlineLess(*it, call)) {
+    if (priority < lowest || (priority == lowest && DeadlineLess(*it, call))) {
       return QUEUE_FULL;
     }
 
     *evicted = *it;
-    queue_.erase(it);
+    queue.erase(it);
+    queue_size_--;
   }
 
-  queue_.insert(call);
+  queues_[priority].insert(call);
+  queue_size_++;
   return QUEUE_SUCCESS;
 }
 
+bool LifoServiceQueue::TryGet(std::unique_ptr<InboundCall>* out) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  if (queue_size_ == 0) {
+    return false;
+  }
+  out->reset(PopLocked());
+  return true;
+}
+
+bool LifoServiceQueue::TryHandOff(InboundCall* call) {
+  std::unique_lock<simple_spinlock> l(lock_);
+  if (PREDICT_FALSE(shutdown_) || waiting_consumers_.empty()) {
+    return false;
+  }
+  auto consumer = waiting_consumers_.back();
+  waiting_consumers_.pop_back();
+  l.unlock();
+  consumer->Post(call);
+  return true;
+}
+
 void LifoServiceQueue::Shutdown() {
   std::lock_guard<simple_spinlock> l(lock_);
   shutdown_ = true;
@@ -123,7 +194,7 @@ void LifoServiceQueue::Shutdown() {
 
 bool LifoServiceQueue::empty() const {
   std::lock_guard<simple_spinlock> l(lock_);
-  return queue_.empty();
+  return queue_size_ == 0;
 }
 
 int LifoServiceQueue::max_size() const {
@@ -134,9 +205,11 @@ std::string LifoServiceQueue::ToString() const {
   std::string ret;
 
   std::lock_guard<simple_spinlock> l(lock_);
-  for (const auto* t : queue_) {
-    ret.append(t->ToString());
-    ret.append("\n");
+  for (int p = kNumPriorities - 1; p >= 0; p--) {
+    for (const auto* t : queues_[p]) {
+      ret.append(t->ToString());
+      ret.append("\n");
+    }
   }
   return ret;
 }
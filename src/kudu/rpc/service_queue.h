@@ -56,6 +56,12 @@ enum QueueStatus {
 // can evict any call that does not have a deadline. This incentivizes clients to
 // provide accurate deadlines for their calls.
 //
+// Queued calls are also split by the priority class of their methods (see
+// RpcPriorityClass). Calls are dequeued from the classes in a weighted
+// round-robin, so that a flood of low priority calls slows high priority ones
+// down without starving them. Overflows evict calls of the lowest priority
+// class first.
+//
 // In order to improve concurrent throughput, this class uses a LIFO design:
 // Each consumer thread has its own lock and condition variable. If a
 // consumer arrives and there is no work available in the queue, it will not
@@ -96,6 +102,16 @@ class LifoServiceQueue {
   // call that was bumped.
   QueueStatus Put(InboundCall* call, boost::optional<InboundCall*>* evicted);
 
+  // Gets the element at the front of the queue without blocking, e.g. to
+  // steal work queued for other consumers. Doesn't bind the calling thread to
+  // this queue. Returns false if the queue is empty.
+  bool TryGet(std::unique_ptr<InboundCall>* out);
+
+  // Hands 'call' directly to a consumer waiting for work, if there's one.
+  // Returns false, leaving 'call' to the caller, if no consumer is waiting or
+  // the queue is shut down.
+  bool TryHandOff(InboundCall* call);
+
   // Shut down the queue.
   // When a blocking queue is shut down, no more elements can be added to it,
   // and Put() will return QUEUE_SHUTDOWN.
@@ -112,11 +128,7 @@ class LifoServiceQueue {
   // Return an estimate of the current queue length.
   int estimated_queue_length() const {
     ANNOTATE_IGNORE_READS_BEGIN();
-    // The C++ standard says that std::multiset::size must be constant time,
-    // so this method won't try to traverse any actual nodes of the underlying
-    // RB tree. Investigation of the libstdcxx implementation confirms that
-    // size() is a simple field access of the _Rb_tree structure.
-    int ret = queue_.size();
+    int ret = queue_size_;
     ANNOTATE_IGNORE_READS_END();
     return ret;
   }
@@ -152,6 +164,18 @@ class LifoServiceQueue {
     }
   };
 
+  // The number of priority classes, i.e. of values of RpcPriorityClass.
+  static const int kNumPriorities = 3;
+
+  // Returns the priority class of 'call'.
+  static int PriorityOf(InboundCall* call);
+
+  // Removes the next call to be handled from the queue and returns it. The
+  // queue must not be empty.
+  //
+  // Requires that 'lock_' is held.
+  InboundCall* PopLocked();
+
   // The thread-local record corresponding to a single consumer thread.
   // Threads push this record onto the waiting_consumers_ stack when
   // they are awaiting work. Producers pop the top waiting consumer and
@@ -208,9 +232,16 @@ class LifoServiceQueue {
   // Stack of consumer threads which are currently waiting for work.
   std::vector<ConsumerState*> waiting_consumers_;
 
-  // The actual queue. Work is only added to the queue when there were no
-  // consumers available for a "direct hand-off".
-  std::multiset<InboundCall*, DeadlineLessStruct> queue_;
+  // The actual queue, one set of calls per priority class. Work is only added
+  // to the queue when there were no consumers available for a "direct hand-off".
+  std::multiset<InboundCall*, DeadlineLessStruct> queues_[kNumPriorities];
+
+  // The total number of calls in 'queues_'.
+  int queue_size_;
+
+  // The number of calls which may still be dequeued from each priority class
+  // before the credits of all classes are refilled to their weights.
+  int credits_[kNumPriorities];
 
   // The total set of consumers who have ever accessed this queue.
   std::vector<std::unique_ptr<ConsumerState>> consumers_;
@@ -18,13 +18,20 @@
 #include "kudu/rpc/transfer.h"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <set>
+#include <utility>
 
 #include <boost/container/vector.hpp>
 #include <gflags/gflags.h>
@@ -34,6 +41,7 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/constants.h"
+#include "kudu/util/alignment.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/net/socket.h"
@@ -66,9 +74,25 @@ static bool ValidateMaxMessageSize(const char* flagname, int64_t value) {
 }
 DEFINE_validator(rpc_max_message_size, &ValidateMaxMessageSize);
 
+DEFINE_int64(rpc_inbound_pooled_buffer_threshold, 1024 * 1024,
+             "Inbound RPC frames of at least this many bytes are received into "
+             "page-aligned buffers recycled through a process-wide pool instead "
+             "of freshly allocated ones. Set to 0 to disable pooling.");
+TAG_FLAG(rpc_inbound_pooled_buffer_threshold, advanced);
+TAG_FLAG(rpc_inbound_pooled_buffer_threshold, runtime);
+
+DEFINE_int64(rpc_inbound_buffer_pool_capacity, 256 * 1024 * 1024,
+             "The maximum number of bytes of idle inbound RPC buffers to retain "
+             "for reuse. See --rpc_inbound_pooled_buffer_threshold.");
+TAG_FLAG(rpc_inbound_buffer_pool_capacity, advanced);
+TAG_FLAG(rpc_inbound_buffer_pool_capacity, runtime);
+
 namespace kudu {
 namespace rpc {
 
+using std::lock_guard;
+using std::multimap;
+using std::mutex;
 using std::ostringstream;
 using std::set;
 using std::string;
@@ -88,6 +112,102 @@ using strings::Substitute;
 TransferCallbacks::~TransferCallbacks()
 {}
 
+namespace {
+
+constexpr size_t kPageSize = 4096;
+
+// Pooled buffer capacities are rounded up to this granularity so that frames
+// of similar sizes can share buffers.
+constexpr size_t kPooledBufferGranularity = 1024 * 1024;
+
+class BufferPool {
+ public:
+  // Returns an idle buffer of at least 'capacity' bytes, but not more than
+  // twice that, or allocates a new one. Sets 'actual_capacity' to the size of
+  // the returned buffer.
+  uint8_t* Get(size_t capacity, size_t* actual_capacity) {
+    {
+      lock_guard<mutex> l(lock_);
+      auto it = idle_.lower_bound(capacity);
+      if (it != idle_.end() && it->first <= 2 * capacity) {
+        uint8_t* buf = it->second;
+        *actual_capacity = it->first;
+        idle_bytes_ -= it->first;
+        idle_.erase(it);
+        return buf;
+      }
+    }
+    void* buf;
+    int err = posix_memalign(&buf, kPageSize, capacity);
+    CHECK_EQ(0, err) << "failed to allocate " << capacity << " byte RPC buffer";
+    *actual_capacity = capacity;
+    return static_cast<uint8_t*>(buf);
+  }
+
+  void Put(uint8_t* buf, size_t capacity) {
+    {
+      lock_guard<mutex> l(lock_);
+      if (static_cast<int64_t>(idle_bytes_ + capacity) <=
+          FLAGS_rpc_inbound_buffer_pool_capacity) {
+        idle_.emplace(capacity, buf);
+        idle_bytes_ += capacity;
+        return;
+      }
+    }
+    free(buf);
+  }
+
+  size_t idle_bytes() const {
+    lock_guard<mutex> l(lock_);
+    return idle_bytes_;
+  }
+
+  void Clear() {
+    multimap<size_t, uint8_t*> idle;
+    {
+      lock_guard<mutex> l(lock_);
+      idle.swap(idle_);
+      idle_bytes_ = 0;
+    }
+    for (const auto& e : idle) {
+      free(e.second);
+    }
+  }
+
+ private:
+  mutable mutex lock_;
+
+  // Idle buffers, keyed by capacity.
+  multimap<size_t, uint8_t*> idle_;
+  size_t idle_bytes_ = 0;
+};
+
+BufferPool* GetBufferPool() {
+  static BufferPool* pool = new BufferPool();
+  return pool;
+}
+
+} // anonymous namespace
+
+void InboundBufferReleaser::operator()(uint8_t* buf) const {
+  GetBufferPool()->Put(buf, capacity);
+}
+
+PooledInboundBuffer InboundBufferPool::Acquire(size_t size) {
+  size_t capacity;
+  uint8_t* buf = GetBufferPool()->Get(KUDU_ALIGN_UP(size, kPooledBufferGranularity),
+                                      &capacity);
+  return PooledInboundBuffer(buf, InboundBufferReleaser{capacity});
+}
+
+size_t InboundBufferPool::idle_bytes() {
+  return GetBufferPool()->idle_bytes();
+}
+
+void InboundBufferPool::Clear() {
+  GetBufferPool()->Clear();
+}
+
 InboundTransfer::InboundTransfer()
   : total_length_(0),
     cur_offset_(0) {
@@ -138,7 +258,18 @@ Status InboundTransfer::ReceiveBuffer(Socket* socket, faststring* extra_4) {
       return Status::NetworkError(Substitute("RPC frame had invalid length of $0",
                                              total_length_));
     }
-    buf_.resize(total_length_ + kExtraReadLength);
+    const int64_t threshold = FLAGS_rpc_inbound_pooled_buffer_threshold;
+    if (threshold > 0 && total_length_ >= threshold) {
+      // Large frames are received into a recycled page-aligned buffer. Only
+      // the length prefix (and possibly a few more bytes) has been read so
+      // far, so copying it over is cheap.
+      pooled_buf_ = InboundBufferPool::Acquire(total_length_ + kExtraReadLength);
+      memcpy(pooled_buf_.get(), buf_.data(), cur_offset_);
+      buf_.clear();
+      buf_.shrink_to_fit();
+    } else {
+      buf_.resize(total_length_ + kExtraReadLength);
+    }
 
     // Fall through to receive the message body, which is likely to be already
     // available on the socket.
@@ -153,7 +284,7 @@ Status InboundTransfer::ReceiveBuffer(Socket* socket, faststring* extra_4) {
   // currently only used for unit tests.
   int32_t rem = std::min(total_length_ - cur_offset_ + kExtraReadLength,
       static_cast<uint32_t>(std::numeric_limits<int32_t>::max()));
-  Status status = socket->Recv(&buf_[cur_offset_], rem, &nread);
+  Status status = socket->Recv(mutable_frame() + cur_offset_, rem, &nread);
   RETURN_ON_ERROR_OR_SOCKET_NOT_READY(status);
   cur_offset_ += nread;
 
@@ -164,9 +295,11 @@ Status InboundTransfer::ReceiveBuffer(Socket* socket, faststring* extra_4) {
     DCHECK_LE(extra_read, kExtraReadLength);
     DCHECK_GE(extra_read, 0);
     extra_4->clear();
-    extra_4->append(&buf_[total_length_], extra_read);
+    extra_4->append(mutable_frame() + total_length_, extra_read);
     cur_offset_ = total_length_;
-    buf_.resize(total_length_);
+    if (!pooled_buf_) {
+      buf_.resize(total_length_);
+    }
   }
 
   return Status::OK();
@@ -221,41 +354,39 @@ void OutboundTransfer::Abort(const Status &status) {
   aborted_ = true;
 }
 
-Status OutboundTransfer::SendBuffer(Socket &socket) {
-  CHECK_LT(cur_slice_idx_, payload_slices_.size());
+int OutboundTransfer::FillIovecs(struct iovec* iov, int max_iovecs) {
+  DCHECK_LT(cur_slice_idx_, payload_slices_.size());
+  int n_iovecs = std::min<int>(payload_slices_.size() - cur_slice_idx_, max_iovecs);
+  int offset_in_slice = cur_offset_in_slice_;
+  for (int i = 0; i < n_iovecs; i++) {
+    Slice &slice = payload_slices_[cur_slice_idx_ + i];
+    iov[i].iov_base = slice.mutable_data() + offset_in_slice;
+    iov[i].iov_len = slice.size() - offset_in_slice;
 
-  started_ = true;
-  int n_iovecs = std::min<int>(payload_slices_.size() - cur_slice_idx_, IOV_MAX);
-  struct iovec iovec[n_iovecs];
-  {
-    int offset_in_slice = cur_offset_in_slice_;
-    for (int i = 0; i < n_iovecs; i++) {
-      Slice &slice = payload_slices_[cur_slice_idx_ + i];
-      iovec[i].iov_base = slice.mutable_data() + offset_in_slice;
-      iovec[i].iov_len = slice.size() - offset_in_slice;
-
-      offset_in_slice = 0;
-    }
+    offset_in_slice = 0;
   }
+  return n_iovecs;
+}
 
-  int64_t written;
-  Status status = socket.Writev(iovec, n_iovecs, &written);
-  RETURN_ON_ERROR_OR_SOCKET_NOT_READY(status);
-
+int64_t OutboundTransfer::AdvanceSent(int64_t written) {
+  DCHECK(!TransferFinished());
+  started_ = true;
+  int64_t rem = written;
   // Adjust our accounting of current writer position.
   for (int i = cur_slice_idx_; i < payload_slices_.size(); i++) {
     Slice &slice = payload_slices_[i];
     int rem_in_slice = slice.size() - cur_offset_in_slice_;
     DCHECK_GE(rem_in_slice, 0);
 
-    if (written >= rem_in_slice) {
+    if (rem >= rem_in_slice) {
       // Used up this entire slice, advance to the next slice.
       cur_slice_idx_++;
       cur_offset_in_slice_ = 0;
-      written -= rem_in_slice;
+      rem -= rem_in_slice;
     } else {
       // Partially used up this slice, just advance the offset within it.
-      cur_offset_in_slice_ += written;
+      cur_offset_in_slice_ += rem;
+      rem = 0;
       break;
     }
   }
@@ -268,7 +399,7 @@ Status OutboundTransfer::SendBuffer(Socket &socket) {
     DCHECK_LT(cur_offset_in_slice_, payload_slices_[cur_slice_idx_].size());
   }
 
-  return Status::OK();
+  return written - rem;
 }
 
 bool OutboundTransfer::TransferStarted() const {
@@ -16,8 +16,11 @@
 // under the License.
 #pragma once
 
+#include <algorithm>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include <boost/container/small_vector.hpp>
@@ -33,6 +36,8 @@
 
 DECLARE_int64(rpc_max_message_size);
 
+struct iovec;
+
 namespace kudu {
 
 class Socket;
@@ -57,6 +62,34 @@ class TransferLimits {
 // is worth the cost.
 typedef boost::container::small_vector<Slice, 4> TransferPayload;
 
+// Returns a buffer obtained from InboundBufferPool::Acquire() to the pool.
+struct InboundBufferReleaser {
+  size_t capacity;
+  void operator()(uint8_t* buf) const;
+};
+typedef std::unique_ptr<uint8_t, InboundBufferReleaser> PooledInboundBuffer;
+
+// A process-wide pool of page-aligned buffers used to receive large inbound
+// frames (see --rpc_inbound_pooled_buffer_threshold). Large frames are mostly
+// write batches and consensus updates carrying sidecars; recycling their
+// buffers avoids mapping and faulting in tens of megabytes of fresh memory for
+// every such call.
+//
+// This class is thread-safe.
+class InboundBufferPool {
+ public:
+  // Returns a page-aligned buffer of at least 'size' bytes.
+  static PooledInboundBuffer Acquire(size_t size);
+
+  // Returns the number of bytes held by idle buffers in the pool.
+  static size_t idle_bytes();
+
+  // Frees all idle buffers. Buffers that are in use are unaffected.
+  static void Clear();
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(InboundBufferPool);
+};
+
 // This class is used internally by the RPC layer to represent an inbound
 // transfer in progress.
 //
@@ -84,9 +117,19 @@ class InboundTransfer {
   bool TransferFinished() const;
 
   Slice data() const {
+    if (pooled_buf_) {
+      return Slice(pooled_buf_.get(), std::min(cur_offset_, total_length_));
+    }
     return Slice(buf_);
   }
 
+  // Return true if the frame is being received into a page-aligned buffer
+  // from InboundBufferPool rather than into a heap-allocated faststring.
+  // The buffer goes back to the pool when this transfer is destroyed.
+  bool uses_pooled_buffer() const {
+    return pooled_buf_ != nullptr;
+  }
+
   // Return a string indicating the status of this transfer (number of bytes received, etc)
   // suitable for logging.
   std::string StatusAsString() const;
@@ -95,8 +138,17 @@ class InboundTransfer {
 
   Status ProcessInboundHeader();
 
+  // Return a pointer to the start of the buffer the frame is received into.
+  uint8_t* mutable_frame() {
+    return pooled_buf_ ? pooled_buf_.get() : buf_.data();
+  }
+
   faststring buf_;
 
+  // If set, the frame is received into this buffer instead of 'buf_', which
+  // then only holds the bytes received before the frame length was known.
+  PooledInboundBuffer pooled_buf_;
+
   // 0 indicates not yet set
   uint32_t total_length_;
   uint32_t cur_offset_;
@@ -143,8 +195,21 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   // This triggers TransferCallbacks::NotifyTransferAborted.
   void Abort(const Status &status);
 
-  // send from our buffers into the sock
-  Status SendBuffer(Socket &socket);
+  // Fills up to 'max_iovecs' entries of 'iov' with the part of the payload
+  // which hasn't been sent yet. Returns the number of entries filled. Several
+  // transfers may be gathered into a single writev() this way.
+  int FillIovecs(struct iovec* iov, int max_iovecs);
+
+  // Accounts for the first 'written' bytes of the unsent payload having been
+  // written to the socket, triggering TransferCallbacks::NotifyTransferFinished
+  // if that completes the transfer. Returns the number of bytes consumed, which
+  // is less than 'written' if the rest belonged to subsequent transfers.
+  //
+  // Must only be called once the write has reached this transfer, i.e. once
+  // every transfer gathered before it has finished, and marks the transfer as
+  // started. 'written' may be 0 if the write stopped at this transfer's first
+  // byte, in which case the transfer has still been offered to the socket.
+  int64_t AdvanceSent(int64_t written);
 
   // Return true if any bytes have yet been sent.
   bool TransferStarted() const;
@@ -187,8 +252,8 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
   // In the case of call responses, kInvalidCallId
   int32_t call_id_;
 
-  // True if SendBuffer() has been called at least once. This can be true even if
-  // no bytes were sent successfully. This is needed as SSL_write() is stateful.
+  // True if a write has reached this transfer. This can be true even if no
+  // bytes were sent successfully. This is needed as SSL_write() is stateful.
   // Please see KUDU-2334 for details.
   bool started_;
 
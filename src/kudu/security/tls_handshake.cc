@@ -21,14 +21,26 @@
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <ostream>
 #include <string>
 
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
 #include "kudu/gutil/strings/strip.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/security/cert.h"
+#include "kudu/security/openssl_util.h"
 #include "kudu/security/tls_socket.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
 #include "kudu/util/net/socket.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
 #include "kudu/util/trace.h"
 
@@ -36,6 +48,31 @@
 #include "kudu/security/x509_check_host.h"
 #endif // OPENSSL_VERSION_NUMBER
 
+#ifdef KUDU_HAS_KTLS
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/obj_mac.h>
+#include <sys/socket.h>
+#endif // KUDU_HAS_KTLS
+
+#if defined(KUDU_HAS_KTLS) && !defined(SOL_TLS)
+#define SOL_TLS 282
+#endif
+#if defined(KUDU_HAS_KTLS) && !defined(TCP_ULP)
+#define TCP_ULP 31
+#endif
+
+DEFINE_bool(rpc_tls_kernel_offload, false,
+            "Whether to hand the traffic keys of TLS-encrypted connections to "
+            "the kernel once the TLS handshake completes, so that records are "
+            "encrypted and decrypted by the kernel rather than by OpenSSL on "
+            "the reactor threads. Only TLS 1.2 connections using AES-GCM are "
+            "offloaded; other connections, and hosts whose kernel lacks the "
+            "'tls' module, keep using OpenSSL.");
+TAG_FLAG(rpc_tls_kernel_offload, experimental);
+
 using std::string;
 using std::unique_ptr;
 using strings::Substitute;
@@ -43,6 +80,132 @@ using strings::Substitute;
 namespace kudu {
 namespace security {
 
+namespace {
+
+#ifdef KUDU_HAS_KTLS
+// The length of the implicit part of the AES-GCM nonce in TLS 1.2 (RFC 5288).
+constexpr size_t kGcmSaltLength = 4;
+
+// Installs one direction of a TLS 1.2 AES-GCM connection's keys on 'fd'.
+template<typename CryptoInfo>
+Status SetKernelTlsKey(int fd, int direction, uint16_t cipher_type,
+                       const uint8_t* key, const uint8_t* salt) {
+  static_assert(sizeof(CryptoInfo::salt) == kGcmSaltLength, "unexpected salt length");
+  CryptoInfo info;
+  memset(&info, 0, sizeof(info));
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = cipher_type;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, salt, sizeof(info.salt));
+  // The Finished message was the only record sent under the new keys in
+  // either direction, so the next record is number 1. The sequence number
+  // also serves as the explicit part of the nonce of records we send.
+  info.rec_seq[sizeof(info.rec_seq) - 1] = 1;
+  memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+  int rc = setsockopt(fd, SOL_TLS, direction, &info, sizeof(info));
+  int err = errno;
+  OPENSSL_cleanse(&info, sizeof(info));
+  if (rc != 0) {
+    return Status::NetworkError("failed to install kernel TLS keys", ErrnoToString(err), err);
+  }
+  return Status::OK();
+}
+#endif
+
+// Hands the record layer of the TLS connection 'ssl' over to the kernel TLS
+// implementation on 'fd'. Must be called right after the handshake, before any
+// application data has been exchanged.
+//
+// If this returns an error other than RuntimeError, the socket is left as it
+// was and the connection may carry on using OpenSSL.
+Status EnableKernelTls(SSL* ssl, int fd) {
+#ifndef KUDU_HAS_KTLS
+  return Status::NotSupported("kernel TLS offload is not supported on this platform");
+#else
+  SCOPED_OPENSSL_NO_PENDING_ERRORS;
+  if (SSL_version(ssl) != TLS1_2_VERSION) {
+    return Status::NotSupported("kernel TLS offload requires TLS 1.2");
+  }
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+  const int cipher_nid = SSL_CIPHER_get_cipher_nid(cipher);
+  size_t key_len;
+  if (cipher_nid == NID_aes_128_gcm) {
+    key_len = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  } else if (cipher_nid == NID_aes_256_gcm) {
+    key_len = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+  } else {
+    return Status::NotSupported("kernel TLS offload requires an AES-GCM cipher",
+                                SSL_CIPHER_get_name(cipher));
+  }
+
+  // Expand the master secret into the key block (RFC 5246, section 6.3).
+  // AEAD ciphers have no MAC keys, so the block consists of the client and
+  // server write keys followed by the client and server implicit nonces.
+  uint8_t master_key[SSL_MAX_MASTER_KEY_LENGTH];
+  size_t master_key_len = SSL_SESSION_get_master_key(
+      SSL_get_session(ssl), master_key, sizeof(master_key));
+  uint8_t seed[2 * SSL3_RANDOM_SIZE];
+  SSL_get_server_random(ssl, seed, SSL3_RANDOM_SIZE);
+  SSL_get_client_random(ssl, seed + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+  static const char kLabel[] = "key expansion";
+  uint8_t key_block[2 * TLS_CIPHER_AES_GCM_256_KEY_SIZE + 2 * kGcmSaltLength];
+  size_t key_block_len = 2 * key_len + 2 * kGcmSaltLength;
+  SCOPED_CLEANUP({
+    OPENSSL_cleanse(master_key, sizeof(master_key));
+    OPENSSL_cleanse(key_block, sizeof(key_block));
+  });
+  EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr);
+  if (!pctx) {
+    return Status::NotSupported("failed to create TLS PRF context", GetOpenSSLErrors());
+  }
+  SCOPED_CLEANUP({ EVP_PKEY_CTX_free(pctx); });
+  if (EVP_PKEY_derive_init(pctx) <= 0 ||
+      EVP_PKEY_CTX_set_tls1_prf_md(pctx, SSL_CIPHER_get_handshake_digest(cipher)) <= 0 ||
+      EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, master_key, master_key_len) <= 0 ||
+      EVP_PKEY_CTX_add1_tls1_prf_seed(
+          pctx, reinterpret_cast<const uint8_t*>(kLabel), sizeof(kLabel) - 1) <= 0 ||
+      EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed, sizeof(seed)) <= 0 ||
+      EVP_PKEY_derive(pctx, key_block, &key_block_len) <= 0) {
+    return Status::NotSupported("failed to derive TLS traffic keys", GetOpenSSLErrors());
+  }
+  const uint8_t* client_key = key_block;
+  const uint8_t* server_key = client_key + key_len;
+  const uint8_t* client_salt = server_key + key_len;
+  const uint8_t* server_salt = client_salt + kGcmSaltLength;
+  const bool is_server = SSL_is_server(ssl);
+
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+    int err = errno;
+    return Status::NotSupported("kernel TLS is unavailable", ErrnoToString(err), err);
+  }
+  // Install the receive side first: it needs a newer kernel than the send
+  // side, and until keys are installed the socket passes data through
+  // unmodified, so failing here still leaves OpenSSL in charge.
+  auto set_key = cipher_nid == NID_aes_128_gcm ?
+      &SetKernelTlsKey<tls12_crypto_info_aes_gcm_128> :
+      &SetKernelTlsKey<tls12_crypto_info_aes_gcm_256>;
+  const uint16_t cipher_type = cipher_nid == NID_aes_128_gcm ?
+      TLS_CIPHER_AES_GCM_128 : TLS_CIPHER_AES_GCM_256;
+  Status s = set_key(fd, TLS_RX, cipher_type,
+                     is_server ? client_key : server_key,
+                     is_server ? client_salt : server_salt);
+  if (!s.ok()) {
+    return Status::NotSupported("kernel TLS receive offload is unavailable", s.ToString());
+  }
+  s = set_key(fd, TLS_TX, cipher_type,
+              is_server ? server_key : client_key,
+              is_server ? server_salt : client_salt);
+  if (!s.ok()) {
+    // Incoming records are already being decrypted by the kernel, so there
+    // is no going back to OpenSSL.
+    return Status::RuntimeError("failed to enable kernel TLS offload", s.ToString());
+  }
+  return Status::OK();
+#endif
+}
+
+} // anonymous namespace
+
 void TlsHandshake::SetSSLVerify() {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
   CHECK(ssl_);
@@ -210,8 +373,22 @@ Status TlsHandshake::Finish(unique_ptr<Socket>* socket) {
     return Status::RuntimeError("TLS handshake error", GetOpenSSLErrors());
   }
 
+  bool kernel_offloaded = false;
+  if (FLAGS_rpc_tls_kernel_offload) {
+    Status s = EnableKernelTls(ssl_.get(), fd);
+    if (s.ok()) {
+      kernel_offloaded = true;
+      TRACE("Offloaded TLS to the kernel");
+    } else if (s.IsRuntimeError()) {
+      return s;
+    } else {
+      KLOG_FIRST_N(WARNING, 1) << "falling back to OpenSSL for TLS record processing: "
+                               << s.ToString();
+    }
+  }
+
   // Transfer the SSL instance to the socket.
-  socket->reset(new TlsSocket(fd, std::move(ssl_)));
+  socket->reset(new TlsSocket(fd, std::move(ssl_), kernel_offloaded));
 
   return Status::OK();
 }
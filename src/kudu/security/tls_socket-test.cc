@@ -31,12 +31,15 @@
 #include <thread>
 #include <vector>
 
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/security/tls_context.h"
 #include "kudu/security/tls_handshake.h"
+#include "kudu/security/tls_socket.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/sockaddr.h"
@@ -49,6 +52,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(rpc_tls_kernel_offload);
+
 using std::string;
 using std::thread;
 using std::unique_ptr;
@@ -372,5 +377,37 @@ TEST_F(TlsSocketTest, TestNonBlockingWritev) {
   ASSERT_OK(client_sock->Close());
 }
 
+// Test that data makes it through connections whose record layer has been
+// offloaded to the kernel. If the kernel doesn't support TLS offload, the
+// connection falls back to OpenSSL and this degenerates into a plain echo test.
+TEST_F(TlsSocketTest, TestKernelTlsOffload) {
+  FLAGS_rpc_tls_kernel_offload = true;
+  Random rng(GetRandomSeed32());
+
+  EchoServer server;
+  NO_FATALS(server.Start());
+
+  unique_ptr<Socket> client_sock;
+  NO_FATALS(ConnectClient(server.listen_addr(), &client_sock));
+  LOG(INFO) << "kernel TLS offload "
+            << (down_cast<TlsSocket*>(client_sock.get())->is_kernel_offloaded() ?
+                "enabled" : "unavailable");
+
+  unique_ptr<uint8_t[]> buf(new uint8_t[kEchoChunkSize]);
+  unique_ptr<uint8_t[]> rbuf(new uint8_t[kEchoChunkSize]);
+  for (int i = 0; i < 3; i++) {
+    RandomString(buf.get(), kEchoChunkSize, &rng);
+    size_t n;
+    ASSERT_OK(client_sock->BlockingWrite(buf.get(), kEchoChunkSize, &n,
+                                         MonoTime::Now() + kTimeout));
+    ASSERT_OK(client_sock->BlockingRecv(rbuf.get(), kEchoChunkSize, &n,
+                                        MonoTime::Now() + kTimeout));
+    ASSERT_EQ(0, memcmp(buf.get(), rbuf.get(), kEchoChunkSize));
+  }
+
+  server.Stop();
+  ASSERT_OK(client_sock->Close());
+}
+
 } // namespace security
 } // namespace kudu
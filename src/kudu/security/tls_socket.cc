@@ -20,8 +20,13 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef KUDU_HAS_KTLS
+#include <linux/tls.h>
+#endif
 
 #include <cerrno>
+#include <cstring>
 #include <functional>
 #include <string>
 #include <utility>
@@ -35,15 +40,20 @@
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/net/socket.h"
 
+#if defined(KUDU_HAS_KTLS) && !defined(SOL_TLS)
+#define SOL_TLS 282
+#endif
+
 using std::string;
 using strings::Substitute;
 
 namespace kudu {
 namespace security {
 
-TlsSocket::TlsSocket(int fd, c_unique_ptr<SSL> ssl)
+TlsSocket::TlsSocket(int fd, c_unique_ptr<SSL> ssl, bool kernel_offloaded)
     : Socket(fd),
-      ssl_(std::move(ssl)) {
+      ssl_(std::move(ssl)),
+      kernel_offloaded_(kernel_offloaded) {
   use_cork_ = true;
 
 #ifndef __APPLE__
@@ -66,6 +76,13 @@ TlsSocket::~TlsSocket() {
 
 Status TlsSocket::Write(const uint8_t *buf, int32_t amt, int32_t *nwritten) {
   CHECK(ssl_);
+  if (kernel_offloaded_) {
+    if (PREDICT_FALSE(amt == 0)) {
+      *nwritten = 0;
+      return Status::OK();
+    }
+    return Socket::Write(buf, amt, nwritten);
+  }
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
 
   *nwritten = 0;
@@ -99,6 +116,11 @@ Status TlsSocket::Write(const uint8_t *buf, int32_t amt, int32_t *nwritten) {
 Status TlsSocket::Writev(const struct ::iovec *iov, int iov_len, int64_t *nwritten) {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
   CHECK(ssl_);
+  if (kernel_offloaded_) {
+    // The kernel frames and encrypts records itself, so the whole vector can
+    // go out in a single sendmsg() without being copied through OpenSSL.
+    return Socket::Writev(iov, iov_len, nwritten);
+  }
   *nwritten = 0;
   // Allows packets to be aggresively be accumulated before sending.
   if (use_cork_) {
@@ -132,6 +154,16 @@ Status TlsSocket::Recv(uint8_t *buf, int32_t amt, int32_t *nread) {
   SCOPED_OPENSSL_NO_PENDING_ERRORS;
 
   CHECK(ssl_);
+  if (kernel_offloaded_) {
+    Status s = Socket::Recv(buf, amt, nread);
+    // The kernel only returns application data to a plain recv(). When the
+    // next record is anything else, which in practice is the peer's
+    // close_notify alert, the call fails with EIO.
+    if (PREDICT_FALSE(s.posix_code() == EIO)) {
+      return Status::NetworkError(s.message(), ErrnoToString(ESHUTDOWN), ESHUTDOWN);
+    }
+    return s;
+  }
   errno = 0;
   int32_t bytes_read = SSL_read(ssl_.get(), buf, amt);
   int save_errno = errno;
@@ -189,13 +221,20 @@ Status TlsSocket::Close() {
 
   // Start the TLS shutdown processes. We don't care about waiting for the
   // response, since the underlying socket will not be reused.
-  int32_t ret = SSL_shutdown(ssl_.get());
   Status ssl_shutdown;
-  if (ret >= 0) {
-    ssl_shutdown = Status::OK();
+  if (kernel_offloaded_) {
+    // OpenSSL no longer owns the record layer, so the alert has to be sent
+    // through the kernel instead.
+    ssl_shutdown = SendKernelCloseNotify();
   } else {
-    auto error_code = SSL_get_error(ssl_.get(), ret);
-    ssl_shutdown = Status::NetworkError("TlsSocket::Close", GetSSLErrorDescription(error_code));
+    int32_t ret = SSL_shutdown(ssl_.get());
+    if (ret >= 0) {
+      ssl_shutdown = Status::OK();
+    } else {
+      auto error_code = SSL_get_error(ssl_.get(), ret);
+      ssl_shutdown = Status::NetworkError("TlsSocket::Close",
+                                          GetSSLErrorDescription(error_code));
+    }
   }
 
   ssl_.reset();
@@ -205,5 +244,34 @@ Status TlsSocket::Close() {
   return ssl_shutdown;
 }
 
+Status TlsSocket::SendKernelCloseNotify() {
+#ifdef KUDU_HAS_KTLS
+  // The 'alert' record content type (RFC 5246, section 6.2.1).
+  constexpr uint8_t kTlsRecordTypeAlert = 21;
+  // Alert level 'warning', description 'close_notify'.
+  uint8_t alert[2] = { 1, 0 };
+  struct iovec iov;
+  iov.iov_base = alert;
+  iov.iov_len = sizeof(alert);
+  char cbuf[CMSG_SPACE(sizeof(uint8_t))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = kTlsRecordTypeAlert;
+  if (sendmsg(GetFd(), &msg, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+    int err = errno;
+    return Status::NetworkError("TlsSocket::Close", ErrnoToString(err), err);
+  }
+#endif
+  return Status::OK();
+}
+
 } // namespace security
 } // namespace kudu
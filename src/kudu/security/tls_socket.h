@@ -27,6 +27,14 @@
 #include "kudu/util/net/socket.h"
 #include "kudu/util/status.h"
 
+// Kernel TLS offload needs the Linux TLS ULP headers, and OpenSSL 1.1.1 or
+// newer to derive the negotiated traffic keys.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+#define KUDU_HAS_KTLS 1
+#endif
+#endif
+
 struct iovec;
 
 typedef struct ssl_st SSL;
@@ -49,16 +57,28 @@ class TlsSocket : public Socket {
 
   Status Close() override WARN_UNUSED_RESULT;
 
+  // Whether record encryption and decryption have been handed off to the
+  // kernel (see --rpc_tls_kernel_offload). If so, reads and writes go straight
+  // to the socket and bypass OpenSSL.
+  bool is_kernel_offloaded() const {
+    return kernel_offloaded_;
+  }
+
  private:
 
   friend class TlsHandshake;
 
-  TlsSocket(int fd, c_unique_ptr<SSL> ssl);
+  TlsSocket(int fd, c_unique_ptr<SSL> ssl, bool kernel_offloaded);
+
+  // Sends a TLS close_notify alert through the kernel TLS layer.
+  Status SendKernelCloseNotify();
 
   // Owned SSL handle.
   c_unique_ptr<SSL> ssl_;
 
   bool use_cork_;
+
+  const bool kernel_offloaded_;
 };
 
 } // namespace security
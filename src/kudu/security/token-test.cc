@@ -622,6 +622,46 @@ TEST_F(TokenTest, TestEndToEnd_Valid) {
   ASSERT_EQ(VerificationResult::VALID, verifier.VerifyTokenSignature(signed_token, &token));
 }
 
+// Test that tokens which were verified before, and are cached as such, are
+// still verified again when tampered with.
+TEST_F(TokenTest, TestVerifiedTokenCache) {
+  TokenSigner signer(kTokenValiditySeconds, kTokenValiditySeconds, 10);
+  {
+    unique_ptr<TokenSigningPrivateKey> key;
+    ASSERT_OK(signer.CheckNeedKey(&key));
+    ASSERT_NE(nullptr, key.get());
+    ASSERT_OK(signer.AddKey(std::move(key)));
+  }
+  SignedTokenPB signed_token = MakeUnsignedToken(WallTime_Now() + 600);
+  ASSERT_OK(signer.SignToken(&signed_token));
+
+  TokenVerifier verifier;
+  ASSERT_OK(verifier.ImportKeys(signer.verifier().ExportKeys()));
+  for (int i = 0; i < 2; i++) {
+    TokenPB token;
+    ASSERT_EQ(VerificationResult::VALID, verifier.VerifyTokenSignature(signed_token, &token));
+    ASSERT_EQ(signed_token.token_data(), token.SerializeAsString());
+  }
+
+  {
+    SignedTokenPB tampered = signed_token;
+    tampered.set_signature("xyz");
+    TokenPB token;
+    ASSERT_EQ(VerificationResult::INVALID_SIGNATURE,
+              verifier.VerifyTokenSignature(tampered, &token));
+  }
+  {
+    TokenPB token_pb;
+    ASSERT_TRUE(token_pb.ParseFromString(signed_token.token_data()));
+    token_pb.set_expire_unix_epoch_seconds(token_pb.expire_unix_epoch_seconds() + 600);
+    SignedTokenPB tampered = signed_token;
+    tampered.set_token_data(token_pb.SerializeAsString());
+    TokenPB token;
+    ASSERT_EQ(VerificationResult::INVALID_SIGNATURE,
+              verifier.VerifyTokenSignature(tampered, &token));
+  }
+}
+
 // Test all of the possible cases covered by token verification.
 // See VerificationResult.
 TEST_F(TokenTest, TestEndToEnd_InvalidCases) {
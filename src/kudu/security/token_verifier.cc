@@ -25,16 +25,32 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/security/token.pb.h"
 #include "kudu/security/token_signing_key.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
+DEFINE_uint32(token_verification_cache_capacity_mb, 1,
+              "Capacity of the cache of the tokens whose signature was "
+              "verified, in MiB. Tokens found in the cache are only checked "
+              "for expiration, rather than verified again. 0 disables the "
+              "cache.");
+TAG_FLAG(token_verification_cache_capacity_mb, advanced);
+
+DEFINE_uint32(token_verification_cache_ttl_sec, 300,
+              "Number of seconds after which a token is dropped from the "
+              "cache of the tokens whose signature was verified, even if it "
+              "hasn't expired yet. See --token_verification_cache_capacity_mb.");
+TAG_FLAG(token_verification_cache_ttl_sec, advanced);
+
 using std::lock_guard;
 using std::string;
 using std::transform;
@@ -44,7 +60,20 @@ using std::vector;
 namespace kudu {
 namespace security {
 
+struct TokenVerifier::VerifiedToken {
+  TokenPB token;
+  // The expiration time of the key the token was signed with.
+  int64_t signing_key_expire_unix_epoch_seconds;
+};
+
 TokenVerifier::TokenVerifier() {
+  if (FLAGS_token_verification_cache_capacity_mb > 0) {
+    verified_tokens_.reset(new VerifiedTokenCache(
+        FLAGS_token_verification_cache_capacity_mb * 1024 * 1024,
+        MonoDelta::FromSeconds(FLAGS_token_verification_cache_ttl_sec),
+        /*scrubbing_period=*/{}, /*max_scrubbed_entries_per_pass_num=*/0,
+        "token-verification-cache"));
+  }
 }
 
 TokenVerifier::~TokenVerifier() {
@@ -102,6 +131,14 @@ std::vector<TokenSigningPublicKeyPB> TokenVerifier::ExportKeys(
   return ret;
 }
 
+string TokenVerifier::VerifiedTokenKey(const SignedTokenPB& signed_token) {
+  const int64_t seq_num = signed_token.signing_key_seq_num();
+  string key(reinterpret_cast<const char*>(&seq_num), sizeof(seq_num));
+  key.append(signed_token.signature());
+  key.append(signed_token.token_data());
+  return key;
+}
+
 // Verify the signature on the given token.
 VerificationResult TokenVerifier::VerifyTokenSignature(const SignedTokenPB& signed_token,
                                                        TokenPB* token) const {
@@ -111,6 +148,26 @@ VerificationResult TokenVerifier::VerifyTokenSignature(const SignedTokenPB& sign
     return VerificationResult::INVALID_TOKEN;
   }
 
+  // The signature of a cached token was verified already: only its expiration
+  // and that of its signing key may have changed its validity since.
+  string cache_key;
+  if (verified_tokens_) {
+    cache_key = VerifiedTokenKey(signed_token);
+    auto handle = verified_tokens_->Get(cache_key);
+    if (handle) {
+      const VerifiedToken& verified = handle.value();
+      int64_t now = WallTime_Now();
+      if (verified.token.expire_unix_epoch_seconds() < now) {
+        return VerificationResult::EXPIRED_TOKEN;
+      }
+      if (verified.signing_key_expire_unix_epoch_seconds < now) {
+        return VerificationResult::EXPIRED_SIGNING_KEY;
+      }
+      *token = verified.token;
+      return VerificationResult::VALID;
+    }
+  }
+
   if (!token->ParseFromString(signed_token.token_data()) ||
       !token->has_expire_unix_epoch_seconds()) {
     return VerificationResult::INVALID_TOKEN;
@@ -129,13 +186,15 @@ VerificationResult TokenVerifier::VerifyTokenSignature(const SignedTokenPB& sign
     }
   }
 
+  int64_t signing_key_expire_unix_epoch_seconds;
   {
     shared_lock<RWMutex> l(lock_);
     auto* tsk = FindPointeeOrNull(keys_by_seq_, signed_token.signing_key_seq_num());
     if (!tsk) {
       return VerificationResult::UNKNOWN_SIGNING_KEY;
     }
-    if (tsk->pb().expire_unix_epoch_seconds() < now) {
+    signing_key_expire_unix_epoch_seconds = tsk->pb().expire_unix_epoch_seconds();
+    if (signing_key_expire_unix_epoch_seconds < now) {
       return VerificationResult::EXPIRED_SIGNING_KEY;
     }
     if (!tsk->VerifySignature(signed_token)) {
@@ -143,6 +202,13 @@ VerificationResult TokenVerifier::VerifyTokenSignature(const SignedTokenPB& sign
     }
   }
 
+  if (verified_tokens_) {
+    unique_ptr<VerifiedToken> verified(new VerifiedToken);
+    verified->token = *token;
+    verified->signing_key_expire_unix_epoch_seconds = signing_key_expire_unix_epoch_seconds;
+    const int charge = cache_key.size() + verified->token.SpaceUsedLong();
+    verified_tokens_->Put(cache_key, std::move(verified), charge);
+  }
   return VerificationResult::VALID;
 }
 
@@ -19,11 +19,13 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/rw_mutex.h"
+#include "kudu/util/ttl_cache.h"
 
 namespace kudu {
 
@@ -54,6 +56,10 @@ enum class VerificationResult;
 // and is not yet expired. Any business rules around authorization or
 // authentication are left up to callers.
 //
+// Verifying a signature is expensive, and clients present the same tokens
+// with every RPC, so the tokens whose signature was verified are cached,
+// see --token_verification_cache_capacity_mb.
+//
 // NOTE: old tokens are never removed from the underlying storage of this
 // class. The assumption is that tokens rotate so infreqeuently that this
 // slow leak is not worrisome. If this class is adopted for any use cases
@@ -91,10 +97,23 @@ class TokenVerifier {
  private:
   typedef std::map<int64_t, std::unique_ptr<TokenSigningPublicKey>> KeysMap;
 
+  // A token whose signature was verified.
+  struct VerifiedToken;
+  // Keyed by the signing key sequence number, signature and data of the
+  // tokens, so that only the very same signed tokens hit the cache.
+  typedef TTLCache<std::string, VerifiedToken> VerifiedTokenCache;
+
+  // Returns the key of 'signed_token' in 'verified_tokens_'.
+  static std::string VerifiedTokenKey(const SignedTokenPB& signed_token);
+
   // Lock protecting keys_by_seq_
   mutable RWMutex lock_;
   KeysMap keys_by_seq_;
 
+  // The tokens whose signature was verified, or null if the cache is
+  // disabled. Thread-safe.
+  std::unique_ptr<VerifiedTokenCache> verified_tokens_;
+
   DISALLOW_COPY_AND_ASSIGN(TokenVerifier);
 };
 
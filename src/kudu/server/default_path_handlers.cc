@@ -24,6 +24,7 @@
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -430,14 +431,10 @@ static vector<string> ParseArray(const Webserver::ArgumentMap& args, const strin
   return value;
 }
 
-static void WriteMetricsAsJson(const MetricRegistry* const metrics,
-                               const Webserver::WebRequest& req,
-                               Webserver::PrerenderedWebResponse* resp) {
-  MetricJsonOptions opts;
-  opts.include_raw_histograms = ParseBool(req.parsed_args, "include_raw_histograms");
-  opts.include_schema_info = ParseBool(req.parsed_args, "include_schema");
-
-  MetricFilters& filters = opts.filters;
+// Parses the filters and merge rules of a metrics request into 'opts'.
+static Status ParseMetricFiltersAndMergeRules(const Webserver::WebRequest& req,
+                                              MetricJsonOptions* opts) {
+  MetricFilters& filters = opts->filters;
   filters.entity_types = ParseArray(req.parsed_args, "types");
   filters.entity_ids = ParseArray(req.parsed_args, "ids");
   filters.entity_attrs = ParseArray(req.parsed_args, "attributes");
@@ -451,24 +448,58 @@ static void WriteMetricsAsJson(const MetricRegistry* const metrics,
       // Index 0: entity type needed to be merged.
       // Index 1: 'merge_to' field of MergeAttributes.
       // Index 2: 'attribute_to_merge_by' field of MergeAttributes.
-      EmplaceIfNotPresent(&opts.merge_rules, values[0], MergeAttributes(values[1], values[2]));
+      EmplaceIfNotPresent(&opts->merge_rules, values[0], MergeAttributes(values[1], values[2]));
     }
   }
 
-  JsonWriter::Mode json_mode = ParseBool(req.parsed_args, "compact") ?
-      JsonWriter::COMPACT : JsonWriter::PRETTY;
-
   // The number of entity_attrs should always be even because
   // each pair represents a key and a value.
   if (filters.entity_attrs.size() % 2 != 0) {
+    return Status::InvalidArgument("The parameter of 'attributes' is wrong");
+  }
+  return Status::OK();
+}
+
+static void WriteMetricsAsJson(const MetricRegistry* const metrics,
+                               const Webserver::WebRequest& req,
+                               Webserver::PrerenderedWebResponse* resp) {
+  MetricJsonOptions opts;
+  opts.include_raw_histograms = ParseBool(req.parsed_args, "include_raw_histograms");
+  opts.include_schema_info = ParseBool(req.parsed_args, "include_schema");
+
+  JsonWriter::Mode json_mode = ParseBool(req.parsed_args, "compact") ?
+      JsonWriter::COMPACT : JsonWriter::PRETTY;
+
+  Status s = ParseMetricFiltersAndMergeRules(req, &opts);
+  if (!s.ok()) {
     resp->status_code = HttpStatusCode::BadRequest;
-    WARN_NOT_OK(Status::InvalidArgument(""), "The parameter of 'attributes' is wrong");
+    WARN_NOT_OK(s, "Couldn't parse the metrics request");
   } else {
     JsonWriter writer(&resp->output, json_mode);
     WARN_NOT_OK(metrics->WriteAsJson(&writer, opts), "Couldn't write JSON metrics over HTTP");
   }
 }
 
+// Writes the metrics in the Prometheus text format, streaming them to the
+// client as they are rendered. Takes the same filters and merge rules as the
+// JSON metrics, e.g. 'merge_rules=tablet|table|table_id' to aggregate the
+// metrics of the tablets into the metrics of their tables.
+static void WriteMetricsAsPrometheus(const MetricRegistry* const metrics,
+                                     const Webserver::WebRequest& req,
+                                     Webserver::PrerenderedWebResponse* resp) {
+  MetricJsonOptions opts;
+  Status s = ParseMetricFiltersAndMergeRules(req, &opts);
+  if (!s.ok()) {
+    resp->status_code = HttpStatusCode::BadRequest;
+    WARN_NOT_OK(s, "Couldn't parse the metrics request");
+    return;
+  }
+  resp->body_writer = [metrics, opts](std::ostream* out) {
+    WARN_NOT_OK(metrics->WriteAsPrometheus(out, opts),
+                "Couldn't write Prometheus metrics over HTTP");
+  };
+}
+
 void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* const metrics) {
   auto callback = [metrics](const Webserver::WebRequest& req,
                             Webserver::PrerenderedWebResponse* resp) {
@@ -486,4 +517,15 @@ void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* cons
                                             not_styled, not_on_nav_bar);
 }
 
+void RegisterMetricsPrometheusHandler(Webserver* webserver, const MetricRegistry* const metrics) {
+  auto callback = [metrics](const Webserver::WebRequest& req,
+                            Webserver::PrerenderedWebResponse* resp) {
+    WriteMetricsAsPrometheus(metrics, req, resp);
+  };
+  bool not_styled = false;
+  bool not_on_nav_bar = false;
+  webserver->RegisterPrerenderedPathHandler("/metrics_prometheus", "Prometheus Metrics", callback,
+                                            not_styled, not_on_nav_bar);
+}
+
 } // namespace kudu
@@ -30,6 +30,9 @@ void AddDefaultPathHandlers(Webserver* webserver);
 // Adds an endpoint to get metrics in JSON format.
 void RegisterMetricsJsonHandler(Webserver* webserver, const MetricRegistry* const metrics);
 
+// Adds an endpoint to stream metrics in the Prometheus text format.
+void RegisterMetricsPrometheusHandler(Webserver* webserver, const MetricRegistry* const metrics);
+
 } // namespace kudu
 
 #endif // KUDU_SERVER_DEFAULT_PATH_HANDLERS_H
@@ -22,7 +22,9 @@
 #include <memory>
 #include <ostream>
 #include <queue>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -79,6 +81,22 @@ DEFINE_int32(diagnostics_log_stack_traces_interval_ms, 60000,
 TAG_FLAG(diagnostics_log_stack_traces_interval_ms, runtime);
 TAG_FLAG(diagnostics_log_stack_traces_interval_ms, experimental);
 
+DEFINE_int32(diagnostics_log_profile_sample_interval_ms, 1000,
+             "The interval at which the server samples the stacks of its threads for the "
+             "profile periodically written to the diagnostics log. As for "
+             "--diagnostics_log_stack_traces_interval_ms, the actual interval is random "
+             "between zero and twice the configured value. Setting this to a non-positive "
+             "value disables the profile.");
+TAG_FLAG(diagnostics_log_profile_sample_interval_ms, runtime);
+TAG_FLAG(diagnostics_log_profile_sample_interval_ms, experimental);
+
+DEFINE_int32(diagnostics_log_profile_interval_ms, 60000,
+             "The interval at which the server writes the thread stacks sampled since the "
+             "previous write to the diagnostics log, aggregated by thread category. Use "
+             "'kudu diagnose parse_profile' to turn them into folded stacks for flame graphs.");
+TAG_FLAG(diagnostics_log_profile_interval_ms, runtime);
+TAG_FLAG(diagnostics_log_profile_interval_ms, experimental);
+
 namespace kudu {
 namespace server {
 
@@ -109,6 +127,41 @@ class DiagnosticsLog::SymbolSet {
   google::dense_hash_set<void*> set_;
 };
 
+// The number of times each stack was sampled in each thread category.
+//
+// Each sample counts every thread, whether running or blocked, so this is
+// a wall-clock profile: idle threads show up in their waiting stacks.
+class DiagnosticsLog::Profile {
+ public:
+  struct StackHash {
+    size_t operator()(const StackTrace& s) const { return s.HashCode(); }
+  };
+  struct StackEqual {
+    bool operator()(const StackTrace& a, const StackTrace& b) const { return a.Equals(b); }
+  };
+  typedef std::unordered_map<StackTrace, int64_t, StackHash, StackEqual> StackCounts;
+
+  void AddSample(const string& category, const StackTrace& stack) {
+    counts_[category][stack]++;
+  }
+
+  void Clear() {
+    counts_.clear();
+    num_samples_ = 0;
+  }
+
+  // Keyed by thread category.
+  const std::unordered_map<string, StackCounts>& counts() const { return counts_; }
+
+  // The number of process-wide samples taken.
+  int64_t num_samples() const { return num_samples_; }
+  void IncrementNumSamples() { num_samples_++; }
+
+ private:
+  std::unordered_map<string, StackCounts> counts_;
+  int64_t num_samples_ = 0;
+};
+
 DiagnosticsLog::DiagnosticsLog(string log_dir,
                                string program_name,
                                MetricRegistry* metric_registry) :
@@ -117,7 +170,8 @@ DiagnosticsLog::DiagnosticsLog(string log_dir,
     metric_registry_(metric_registry),
     wake_(&lock_),
     metrics_log_interval_(MonoDelta::FromSeconds(60)),
-    symbols_(new SymbolSet()) {
+    symbols_(new SymbolSet()),
+    profile_(new Profile()) {
 }
 DiagnosticsLog::~DiagnosticsLog() {
   Stop();
@@ -184,6 +238,20 @@ MonoTime DiagnosticsLog::ComputeNextWakeup(DiagnosticsLog::WakeupType type) cons
       break;
     case WakeupType::METRICS:
       return MonoTime::Now() + metrics_log_interval_;
+    case WakeupType::PROFILE_SAMPLE:
+      if (FLAGS_diagnostics_log_profile_sample_interval_ms > 0) {
+        // Randomized for the same reason as the stack traces above.
+        Random rng(GetRandomSeed32());
+        int64_t ms = rng.Uniform(FLAGS_diagnostics_log_profile_sample_interval_ms * 2);
+        return MonoTime::Now() + MonoDelta::FromMilliseconds(ms);
+      }
+      return MonoTime::Now() + MonoDelta::FromSeconds(5);
+    case WakeupType::PROFILE:
+      if (FLAGS_diagnostics_log_profile_interval_ms > 0) {
+        return MonoTime::Now() +
+            MonoDelta::FromMilliseconds(FLAGS_diagnostics_log_profile_interval_ms);
+      }
+      return MonoTime::Now() + MonoDelta::FromSeconds(5);
   }
   __builtin_unreachable();
 }
@@ -196,6 +264,8 @@ void DiagnosticsLog::RunThread() {
   priority_queue<QueueElem, vector<QueueElem>, std::greater<QueueElem>> wakeups;
   wakeups.emplace(ComputeNextWakeup(WakeupType::METRICS), WakeupType::METRICS);
   wakeups.emplace(ComputeNextWakeup(WakeupType::STACKS), WakeupType::STACKS);
+  wakeups.emplace(ComputeNextWakeup(WakeupType::PROFILE_SAMPLE), WakeupType::PROFILE_SAMPLE);
+  wakeups.emplace(ComputeNextWakeup(WakeupType::PROFILE), WakeupType::PROFILE);
 
   while (!stop_) {
     MonoTime next_log = wakeups.top().first;
@@ -226,10 +296,56 @@ void DiagnosticsLog::RunThread() {
       WARN_NOT_OK(LogMetrics(), "Unable to collect metrics to diagnostics log");
     } else if (what == WakeupType::STACKS && FLAGS_diagnostics_log_stack_traces_interval_ms >= 0) {
       WARN_NOT_OK(LogStacks(reason), "Unable to collect stacks to diagnostics log");
+    } else if (what == WakeupType::PROFILE_SAMPLE &&
+               FLAGS_diagnostics_log_profile_sample_interval_ms > 0) {
+      WARN_NOT_OK(SampleProfile(), "Unable to sample stacks for diagnostics log profile");
+    } else if (what == WakeupType::PROFILE) {
+      WARN_NOT_OK(LogProfile(), "Unable to log profile to diagnostics log");
+    }
+  }
+
+  // Don't lose the samples taken since the last profile was logged.
+  l.Unlock();
+  SCOPED_CLEANUP({ l.Lock(); });
+  WARN_NOT_OK(LogProfile(), "Unable to log profile to diagnostics log");
+}
+
+void DiagnosticsLog::AddNewSymbols(const StackTrace& stack,
+                                   vector<pair<void*, string>>* new_symbols) {
+  for (int i = 0; i < stack.num_frames(); i++) {
+    void* addr = stack.frame(i);
+    if (symbols_->Add(addr)) {
+      char buf[1024];
+      // Subtract 1 from the address before symbolizing, because the
+      // address on the stack is actually the return address of the function
+      // call rather than the address of the call instruction itself.
+      if (google::Symbolize(static_cast<char*>(addr) - 1, buf, sizeof(buf))) {
+        new_symbols->emplace_back(addr, buf);
+      }
+      // If symbolization fails, don't bother adding it. Readers of the log
+      // will just see that it's missing from the symbol map and should handle that
+      // as an unknown symbol.
     }
   }
 }
 
+void DiagnosticsLog::AppendSymbolsRecord(const vector<pair<void*, string>>& new_symbols,
+                                         int64_t now, std::ostringstream* buf) {
+  if (new_symbols.empty()) {
+    return;
+  }
+  *buf << "I" << FormatTimestampForLog(now)
+       << " symbols " << now << " ";
+  JsonWriter jw(buf, JsonWriter::COMPACT);
+  jw.StartObject();
+  for (const auto& p : new_symbols) {
+    jw.String(StringPrintf("%p", p.first));
+    jw.String(p.second);
+  }
+  jw.EndObject();
+  *buf << "\n";
+}
+
 Status DiagnosticsLog::LogStacks(const string& reason) {
   StackTraceSnapshot snap;
   snap.set_capture_thread_names(false);
@@ -246,37 +362,11 @@ Status DiagnosticsLog::LogStacks(const string& reason) {
   // repetitions of the same address do not need to re-output the
   // symbol.
   symbols_->ResetIfLogRolled(log_->roll_count());
-  vector<std::pair<void*, string>> new_symbols;
+  vector<pair<void*, string>> new_symbols;
   snap.VisitGroups([&](ArrayView<StackTraceSnapshot::ThreadInfo> group) {
-      const StackTrace& stack = group[0].stack;
-      for (int i = 0; i < stack.num_frames(); i++) {
-        void* addr = stack.frame(i);
-        if (symbols_->Add(addr)) {
-          char buf[1024];
-          // Subtract 1 from the address before symbolizing, because the
-          // address on the stack is actually the return address of the function
-          // call rather than the address of the call instruction itself.
-          if (google::Symbolize(static_cast<char*>(addr) - 1, buf, sizeof(buf))) {
-            new_symbols.emplace_back(addr, buf);
-          }
-          // If symbolization fails, don't bother adding it. Readers of the log
-          // will just see that it's missing from the symbol map and should handle that
-          // as an unknown symbol.
-        }
-      }
+      AddNewSymbols(group[0].stack, &new_symbols);
     });
-  if (!new_symbols.empty()) {
-    buf << "I" << FormatTimestampForLog(now)
-        << " symbols " << now << " ";
-    JsonWriter jw(&buf, JsonWriter::COMPACT);
-    jw.StartObject();
-    for (auto& p : new_symbols) {
-      jw.String(StringPrintf("%p", p.first));
-      jw.String(p.second);
-    }
-    jw.EndObject();
-    buf << "\n";
-  }
+  AppendSymbolsRecord(new_symbols, now, &buf);
 
   buf << "I" << FormatTimestampForLog(now) << " stacks " << now << " ";
   JsonWriter jw(&buf, JsonWriter::COMPACT);
@@ -319,6 +409,78 @@ Status DiagnosticsLog::LogStacks(const string& reason) {
   return Status::OK();
 }
 
+Status DiagnosticsLog::SampleProfile() {
+  StackTraceSnapshot snap;
+  snap.set_capture_thread_names(false);
+  RETURN_NOT_OK(snap.SnapshotAllStacks());
+
+  std::unordered_map<int64_t, string> categories;
+  GetThreadCategories(&categories);
+  const int64_t self_tid = Thread::CurrentThreadId();
+  // Threads not started through kudu::Thread, e.g. the main thread.
+  const string kOtherCategory = "other";
+  snap.VisitGroups([&](ArrayView<StackTraceSnapshot::ThreadInfo> group) {
+      for (const auto& t : group) {
+        // Skip the threads whose stack couldn't be collected, and this one,
+        // which is always busy sampling the others.
+        if (!t.status.ok() || t.tid == self_tid) continue;
+        profile_->AddSample(FindWithDefault(categories, t.tid, kOtherCategory), t.stack);
+      }
+    });
+  profile_->IncrementNumSamples();
+  return Status::OK();
+}
+
+Status DiagnosticsLog::LogProfile() {
+  if (profile_->num_samples() == 0) {
+    return Status::OK();
+  }
+  SCOPED_CLEANUP({ profile_->Clear(); });
+
+  std::ostringstream buf;
+  MicrosecondsInt64 now = GetCurrentTimeMicros();
+
+  // Stacks reference their symbols like in LogStacks().
+  symbols_->ResetIfLogRolled(log_->roll_count());
+  vector<pair<void*, string>> new_symbols;
+  for (const auto& category : profile_->counts()) {
+    for (const auto& e : category.second) {
+      AddNewSymbols(e.first, &new_symbols);
+    }
+  }
+  AppendSymbolsRecord(new_symbols, now, &buf);
+
+  buf << "I" << FormatTimestampForLog(now) << " profile " << now << " ";
+  JsonWriter jw(&buf, JsonWriter::COMPACT);
+  jw.StartObject();
+  jw.String("samples");
+  jw.Int64(profile_->num_samples());
+  jw.String("stacks");
+  jw.StartArray();
+  for (const auto& category : profile_->counts()) {
+    for (const auto& e : category.second) {
+      jw.StartObject();
+      jw.String("category");
+      jw.String(category.first);
+      jw.String("count");
+      jw.Int64(e.second);
+      jw.String("stack");
+      jw.StartArray();
+      const StackTrace& stack = e.first;
+      for (int i = 0; i < stack.num_frames(); i++) {
+        jw.String(StringPrintf("%p", stack.frame(i)));
+      }
+      jw.EndArray();
+      jw.EndObject();
+    }
+  }
+  jw.EndArray();
+  jw.EndObject();
+  buf << "\n";
+
+  return log_->Append(buf.str());
+}
+
 Status DiagnosticsLog::LogMetrics() {
   MetricJsonOptions opts;
   opts.include_raw_histograms = true;
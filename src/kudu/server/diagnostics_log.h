@@ -17,8 +17,11 @@
 #pragma once
 
 #include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 
@@ -32,6 +35,7 @@ namespace kudu {
 
 class MetricRegistry;
 class RollingLog;
+class StackTrace;
 class Thread;
 class Status;
 
@@ -54,17 +58,37 @@ class DiagnosticsLog {
   void DumpStacksNow(std::string reason);
 
  private:
+  class Profile;
   class SymbolSet;
 
   enum class WakeupType {
     METRICS,
-    STACKS
+    STACKS,
+    PROFILE_SAMPLE,
+    PROFILE
   };
 
   void RunThread();
   Status LogMetrics();
   Status LogStacks(const std::string& reason);
 
+  // Samples the stacks of all threads into 'profile_'.
+  Status SampleProfile();
+
+  // Logs the stacks sampled into 'profile_' since the last call, if any,
+  // and resets it.
+  Status LogProfile();
+
+  // Symbolizes the addresses of 'stack' which haven't been emitted to the
+  // current log file yet, appending them to 'new_symbols'.
+  void AddNewSymbols(const StackTrace& stack,
+                     std::vector<std::pair<void*, std::string>>* new_symbols);
+
+  // Appends a 'symbols' record with 'new_symbols' to 'buf', unless empty.
+  static void AppendSymbolsRecord(
+      const std::vector<std::pair<void*, std::string>>& new_symbols,
+      int64_t now, std::ostringstream* buf);
+
   MonoTime ComputeNextWakeup(DiagnosticsLog::WakeupType type) const;
 
   const std::string log_dir_;
@@ -90,6 +114,10 @@ class DiagnosticsLog {
   // Out-of-line this internal data to keep the header smaller.
   std::unique_ptr<SymbolSet> symbols_;
 
+  // The stacks sampled since the last 'profile' record.
+  // Only accessed by the logging thread.
+  std::unique_ptr<Profile> profile_;
+
   DISALLOW_COPY_AND_ASSIGN(DiagnosticsLog);
 };
 
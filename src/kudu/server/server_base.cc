@@ -501,6 +501,12 @@ Status ServerBase::Init() {
   RETURN_NOT_OK_PREPEND(s, "Failed to load FS layout");
   RETURN_NOT_OK(report.LogAndCheckForFatalErrors());
 
+  // The code generation cache is only an optimization, so failing to set it
+  // up doesn't prevent the server from starting.
+  WARN_NOT_OK(codegen::CompilationManager::GetSingleton()->EnablePersistentCache(
+                  options_.env, fs_manager_->GetCodegenCacheDir()),
+              "Could not enable the persistent code generation cache");
+
   RETURN_NOT_OK(InitAcls());
 
   // Create the Messenger.
@@ -787,6 +793,7 @@ Status ServerBase::Start() {
     AddDefaultPathHandlers(web_server_.get());
     AddRpczPathHandlers(messenger_, web_server_.get());
     RegisterMetricsJsonHandler(web_server_.get(), metric_registry_.get());
+    RegisterMetricsPrometheusHandler(web_server_.get(), metric_registry_.get());
     TracingPathHandlers::RegisterHandlers(web_server_.get());
     web_server_->set_footer_html(FooterHtml());
     RETURN_NOT_OK(web_server_->Start());
@@ -21,6 +21,7 @@
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -44,6 +45,7 @@
 #include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -488,6 +490,68 @@ TEST_F(WebserverTest, TestConnectionReuse) {
   ASSERT_EQ(0, curl_.num_connects());
 }
 
+// Test that a response body can be streamed in chunks, across connection reuse.
+TEST_F(WebserverTest, TestStreamedResponse) {
+  const int kNumLines = 100000;
+  server_->RegisterPrerenderedPathHandler(
+      "/streamed", "Streamed",
+      [&](const Webserver::WebRequest& /*req*/, Webserver::PrerenderedWebResponse* resp) {
+        resp->body_writer = [&](std::ostream* out) {
+          for (int i = 0; i < kNumLines; i++) {
+            *out << "line " << i << "\n";
+          }
+        };
+      },
+      false /* is_styled */, false /* is_on_nav_bar */);
+
+  string expected;
+  for (int i = 0; i < kNumLines; i++) {
+    expected += Substitute("line $0\n", i);
+  }
+  ASSERT_OK(curl_.FetchURL(Substitute("$0/streamed", url_), &buf_, {"Accept-Encoding: gzip"}));
+  ASSERT_EQ(expected, buf_.ToString());
+  ASSERT_OK(curl_.FetchURL(Substitute("$0/streamed", url_), &buf_));
+  ASSERT_EQ(expected, buf_.ToString());
+  ASSERT_EQ(0, curl_.num_connects());
+
+  curl_.set_return_headers(true);
+  ASSERT_OK(curl_.FetchURL(Substitute("$0/streamed", url_), &buf_));
+  ASSERT_STR_CONTAINS(buf_.ToString(), "Transfer-Encoding: chunked");
+  ASSERT_STR_NOT_CONTAINS(buf_.ToString(), "Content-Length");
+}
+
+METRIC_DEFINE_entity(test_entity);
+METRIC_DEFINE_counter(test_entity, test_counter, "Test Counter", MetricUnit::kRequests,
+                      "Description of test counter", MetricLevel::kInfo);
+
+TEST_F(WebserverTest, TestPrometheusMetrics) {
+  MetricRegistry registry;
+  for (const auto& id : { "a", "b" }) {
+    scoped_refptr<MetricEntity> entity = METRIC_ENTITY_test_entity.Instantiate(
+        &registry, id, { { "table_id", "t" } });
+    METRIC_test_counter.Instantiate(entity)->IncrementBy(2);
+  }
+  RegisterMetricsPrometheusHandler(server_.get(), &registry);
+
+  ASSERT_OK(curl_.FetchURL(Substitute("$0/metrics_prometheus", url_), &buf_));
+  ASSERT_STR_CONTAINS(buf_.ToString(), "# TYPE kudu_test_entity_test_counter counter\n");
+  ASSERT_STR_CONTAINS(buf_.ToString(),
+                      R"(kudu_test_entity_test_counter{id="a",table_id="t"} 2)");
+  ASSERT_STR_CONTAINS(buf_.ToString(),
+                      R"(kudu_test_entity_test_counter{id="b",table_id="t"} 2)");
+
+  ASSERT_OK(curl_.FetchURL(
+      Substitute("$0/metrics_prometheus?types=test_entity&merge_rules=test_entity|table|table_id",
+                 url_), &buf_));
+  ASSERT_STR_CONTAINS(buf_.ToString(), R"(kudu_table_test_counter{id="t"} 4)");
+  ASSERT_STR_NOT_CONTAINS(buf_.ToString(), "kudu_test_entity");
+
+  // The filters are checked before the response is streamed.
+  Status s = curl_.FetchURL(Substitute("$0/metrics_prometheus?attributes=table_id", url_), &buf_);
+  ASSERT_TRUE(s.IsRemoteError()) << s.ToString();
+  ASSERT_STR_CONTAINS(s.ToString(), "400");
+}
+
 class WebserverAdvertisedAddressesTest : public KuduTest {
  public:
   void SetUp() override {
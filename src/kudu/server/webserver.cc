@@ -28,7 +28,9 @@
 #include <functional>
 #include <map>
 #include <mutex>
+#include <ostream>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -45,6 +47,7 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stl_util.h"
+#include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/split.h"
@@ -170,6 +173,100 @@ Status RunSpnegoStep(const char* authz_header,
   return is_complete ? Status::OK() : kIncomplete;
 }
 
+// Writes the status line and the headers of 'resp' to 'out', followed by
+// 'body_headers', which describe the body, and the blank line before it.
+void WriteResponseHead(const WebCallbackRegistry::PrerenderedWebResponse& resp,
+                       const string& content_type,
+                       const string& body_headers,
+                       ostringstream* out) {
+  *out << Substitute("HTTP/1.1 $0\r\n", HttpStatusCodeToString(resp.status_code));
+  *out << Substitute("Content-Type: $0\r\n", content_type);
+  *out << body_headers;
+  *out << Substitute("X-Frame-Options: $0\r\n", FLAGS_webserver_x_frame_options);
+  static const unordered_set<string> kInvalidHeaders = {
+    "Content-Length",
+    "Content-Type",
+    "Transfer-Encoding",
+    "X-Frame-Options"
+  };
+  for (const auto& entry : resp.response_headers) {
+    // It's forbidden to override the above headers.
+    if (ContainsKey(kInvalidHeaders, entry.first)) {
+      LOG(FATAL) << Substitute("Reserved header $0 was overridden by handler",
+                               entry.first);
+    }
+    *out << Substitute("$0: $1\r\n", entry.first, entry.second);
+  }
+  *out << "\r\n";
+}
+
+// A stream buffer which sends what is written to it through a connection, as
+// the chunks of a body with chunked transfer encoding.
+class ChunkedResponseBuf : public std::streambuf {
+ public:
+  explicit ChunkedResponseBuf(struct sq_connection* connection)
+      : connection_(connection),
+        failed_(false) {
+    setp(buf_, buf_ + sizeof(buf_));
+  }
+
+  // Sends the buffered data and the last chunk, which ends the body.
+  void Finish() {
+    if (SendChunk() == 0) {
+      Send("0\r\n\r\n");
+    }
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (SendChunk() != 0) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override {
+    return SendChunk();
+  }
+
+ private:
+  // Sends the buffered data as a chunk. Returns -1 once sending failed, e.g.
+  // because the client went away, after which the data is dropped.
+  int SendChunk() {
+    const size_t len = pptr() - pbase();
+    setp(buf_, buf_ + sizeof(buf_));
+    if (failed_) {
+      return -1;
+    }
+    if (len == 0) {
+      return 0;
+    }
+    // The chunk is sent in one write, see Webserver::SendResponse().
+    string chunk = StringPrintf("%zx\r\n", len);
+    chunk.append(buf_, len);
+    chunk.append("\r\n");
+    return Send(chunk);
+  }
+
+  int Send(const string& data) {
+    if (sq_write(connection_, data.data(), data.size()) != static_cast<int>(data.size())) {
+      failed_ = true;
+      return -1;
+    }
+    return 0;
+  }
+
+  struct sq_connection* const connection_;
+  bool failed_;
+  char buf_[32 * 1024];
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkedResponseBuf);
+};
+
 }  // anonymous namespace
 
 Webserver::Webserver(const WebserverOptions& opts)
@@ -582,19 +679,29 @@ sq_callback_result_t Webserver::RunPathHandler(
     }
   }
 
+  // Should we render with css styles?
+  StyleMode use_style = handler.is_styled() && !ContainsKey(req.parsed_args, "raw") ?
+                        StyleMode::STYLED : StyleMode::UNSTYLED;
+  auto run_handler = [&]() {
+    handler.callback()(req, resp);
+    // HTTP/1.0 has no chunked transfer encoding: buffer the body instead.
+    if (resp->body_writer && strcmp(request_info->http_version, "1.0") == 0) {
+      resp->body_writer(&resp->output);
+      resp->body_writer = nullptr;
+    }
+    SendResponse(connection, resp, &req, use_style);
+  };
+
   // Enable or disable redaction from the web UI based on the setting of --redact.
   // This affects operations like default value and scan predicate pretty printing.
+  // The response is sent in the same scope since a streamed body is rendered
+  // while it is sent.
   if (kudu::g_should_redact == kudu::RedactContext::ALL) {
-    handler.callback()(req, resp);
+    run_handler();
   } else {
     ScopedDisableRedaction s;
-    handler.callback()(req, resp);
+    run_handler();
   }
-
-  // Should we render with css styles?
-  StyleMode use_style = handler.is_styled() && !ContainsKey(req.parsed_args, "raw") ?
-                        StyleMode::STYLED : StyleMode::UNSTYLED;
-  SendResponse(connection, resp, &req, use_style);
   return SQ_HANDLED_OK;
 }
 
@@ -602,6 +709,20 @@ void Webserver::SendResponse(struct sq_connection* connection,
                              PrerenderedWebResponse* resp,
                              const WebRequest* req,
                              StyleMode mode) {
+  if (resp->body_writer) {
+    ostringstream head;
+    WriteResponseHead(*resp, "text/plain", "Transfer-Encoding: chunked\r\n", &head);
+    const string head_str = head.str();
+    if (sq_write(connection, head_str.c_str(), head_str.length()) <= 0) {
+      return;
+    }
+    ChunkedResponseBuf buf(connection);
+    std::ostream out(&buf);
+    resp->body_writer(&out);
+    buf.Finish();
+    return;
+  }
+
   // If styling was requested, rerender and replace the prerendered output.
   if (mode == StyleMode::STYLED) {
     DCHECK(req);
@@ -650,26 +771,10 @@ void Webserver::SendResponse(struct sq_connection* connection,
   ostringstream oss;
 
   // Write the headers to the buffer first, then write the body.
-  oss << Substitute("HTTP/1.1 $0\r\n", HttpStatusCodeToString(resp->status_code));
-  oss << Substitute("Content-Type: $0\r\n",
-                    mode == StyleMode::STYLED ? "text/html" : "text/plain");
-  oss << Substitute("Content-Length: $0\r\n", body.length());
-  if (is_compressed) oss << "Content-Encoding: gzip\r\n";
-  oss << Substitute("X-Frame-Options: $0\r\n", FLAGS_webserver_x_frame_options);
-  static const unordered_set<string> kInvalidHeaders = {
-    "Content-Length",
-    "Content-Type",
-    "X-Frame-Options"
-  };
-  for (const auto& entry : resp->response_headers) {
-    // It's forbidden to override the above headers.
-    if (ContainsKey(kInvalidHeaders, entry.first)) {
-      LOG(FATAL) << Substitute("Reserved header $0 was overridden by handler",
-                               entry.first);
-    }
-    oss << Substitute("$0: $1\r\n", entry.first, entry.second);
-  }
-  oss << "\r\n";
+  string body_headers = Substitute("Content-Length: $0\r\n", body.length());
+  if (is_compressed) body_headers += "Content-Encoding: gzip\r\n";
+  WriteResponseHead(*resp, mode == StyleMode::STYLED ? "text/html" : "text/plain",
+                    body_headers, &oss);
   oss << body;
 
   // Send the buffered response to Squeasel in one go to avoid the latency hit
@@ -724,30 +724,40 @@ struct KeyTypeWrapper {
 typedef ::testing::Types<NumTypeRowOps<KeyTypeWrapper<INT8, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT8, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT8, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT8, FOR_BITPACK>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT16, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT16, FOR_BITPACK>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT32, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT32, FOR_BITPACK>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT32, DICT_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, PLAIN_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT64, RLE>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT64, FOR_BITPACK>>,
+                         NumTypeRowOps<KeyTypeWrapper<INT64, DICT_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<INT128, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<INT128, PLAIN_ENCODING>>,
                          // TODO: Uncomment when adding 128 bit support to RLE (KUDU-2284)
                          // NumTypeRowOps<KeyTypeWrapper<INT128, RLE>>,
                          NumTypeRowOps<KeyTypeWrapper<FLOAT, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<FLOAT, PLAIN_ENCODING>>,
+                         NumTypeRowOps<KeyTypeWrapper<FLOAT, DICT_ENCODING>>,
                          NumTypeRowOps<KeyTypeWrapper<DOUBLE, BIT_SHUFFLE>>,
                          NumTypeRowOps<KeyTypeWrapper<DOUBLE, PLAIN_ENCODING>>,
+                         NumTypeRowOps<KeyTypeWrapper<DOUBLE, DICT_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, DICT_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, PLAIN_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<STRING, PREFIX_ENCODING>>,
+                         SliceTypeRowOps<KeyTypeWrapper<STRING, FSST_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<BINARY, DICT_ENCODING>>,
                          SliceTypeRowOps<KeyTypeWrapper<BINARY, PLAIN_ENCODING>>,
-                         SliceTypeRowOps<KeyTypeWrapper<BINARY, PREFIX_ENCODING>>
+                         SliceTypeRowOps<KeyTypeWrapper<BINARY, PREFIX_ENCODING>>,
+                         SliceTypeRowOps<KeyTypeWrapper<BINARY, FSST_ENCODING>>
                          > KeyTypes;
 
 TYPED_TEST_CASE(AllTypesScanCorrectnessTest, KeyTypes);
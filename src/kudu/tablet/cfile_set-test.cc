@@ -58,8 +58,10 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
+#include "kudu/util/threadpool.h"
 
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(cfile_skip_scan_max_prefixes);
 
 using std::shared_ptr;
 using std::string;
@@ -391,6 +393,42 @@ TEST_F(TestCFileSet, TestIteratePartialSchema) {
   }
 }
 
+// Ensure that reading the columns of each batch concurrently returns the same
+// rows as reading them one after another.
+TEST_F(TestCFileSet, TestReadColumnsConcurrently) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), MemTracker::GetRootTracker(),
+                           nullptr, &fileset));
+  unique_ptr<ThreadPool> pool;
+  ASSERT_OK(ThreadPoolBuilder("test").set_max_threads(3).Build(&pool));
+
+  const auto iterate = [&](ThreadPool* read_pool, const ScanSpec* spec,
+                           vector<string>* results) {
+    unique_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr, read_pool));
+    unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(std::move(cfile_iter)));
+    ScanSpec spec_copy(*spec);
+    ASSERT_OK(iter->Init(&spec_copy));
+    ASSERT_OK(IterateToStringList(iter.get(), results));
+  };
+
+  // Scan all rows, as well as a range in the middle of the rowset.
+  int32_t lower = 5000;
+  int32_t upper = 9000;
+  ScanSpec range_spec;
+  range_spec.AddPredicate(ColumnPredicate::Range(schema_.column(0), &lower, &upper));
+  for (const ScanSpec& spec : { ScanSpec(), range_spec }) {
+    vector<string> expected;
+    NO_FATALS(iterate(nullptr, &spec, &expected));
+    vector<string> results;
+    NO_FATALS(iterate(pool.get(), &spec, &results));
+    ASSERT_FALSE(results.empty());
+    ASSERT_EQ(expected, results);
+  }
+}
+
 // Add a range predicate on the key column and ensure that only the relevant small number of rows
 // are read off disk.
 TEST_F(TestCFileSet, TestRangeScan) {
@@ -562,5 +600,194 @@ TEST_F(TestCFileSet, TestBloomFilterPredicates) {
   DoTestBloomFilterScan(fileset, { bf_with_range }, ret1_contain_range);
 }
 
+TEST_F(TestCFileSet, TestSecondaryIndex) {
+  const int kNumRows = 10000;
+  const ColumnId c1_id = schema_.column_id(1);
+  {
+    DiskRowSetWriter rsw(rowset_meta_.get(), &schema_,
+                         BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+    ASSERT_OK(rsw.Open());
+    rsw.set_secondary_index_column_ids({ c1_id, schema_.column_id(2) });
+    RowBuilder rb(&schema_);
+    for (int i = 0; i < kNumRows; i++) {
+      rb.Reset();
+      rb.AddInt32(i * 2);
+      rb.AddInt32(i % 100);
+      rb.AddNull();
+      ASSERT_OK_FAST(WriteRow(rb.data(), &rsw));
+    }
+    ASSERT_OK(rsw.Finish());
+  }
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), MemTracker::GetRootTracker(),
+                           nullptr, &fileset));
+  ASSERT_TRUE(fileset->has_secondary_index_for_column_id(c1_id));
+  // The third column only has nulls, so it isn't indexed.
+  ASSERT_FALSE(fileset->has_secondary_index_for_column_id(schema_.column_id(2)));
+  ASSERT_GT(fileset->SecondaryIndexOnDiskSize(), 0);
+
+  // Look up a single value.
+  int32_t value = 42;
+  vector<rowid_t> rowids;
+  ASSERT_OK(fileset->LookupSecondaryIndex(
+      c1_id, ColumnPredicate::Equality(schema_.column(1), &value), nullptr, &rowids));
+  ASSERT_EQ(kNumRows / 100, rowids.size());
+  for (size_t i = 0; i < rowids.size(); i++) {
+    ASSERT_EQ(i * 100 + 42, rowids[i]);
+  }
+
+  // Look up a list of values, one of which isn't in the file.
+  int32_t values[] = { 3, 42, 1000 };
+  vector<const void*> value_ptrs = { &values[0], &values[1], &values[2] };
+  ASSERT_OK(fileset->LookupSecondaryIndex(
+      c1_id, ColumnPredicate::InList(schema_.column(1), &value_ptrs), nullptr, &rowids));
+  ASSERT_EQ(2 * kNumRows / 100, rowids.size());
+  ASSERT_TRUE(std::is_sorted(rowids.begin(), rowids.end()));
+
+  // Scan with an equality predicate on the indexed column and a range
+  // predicate on the key.
+  for (bool use_index : { false, true }) {
+    SCOPED_TRACE(use_index);
+    unique_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr));
+    CFileSet::Iterator* cfile_iter_raw = cfile_iter.get();
+    if (use_index) {
+      cfile_iter->set_indexed_column_ids({ c1_id });
+    }
+    unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(std::move(cfile_iter)));
+    ScanSpec spec;
+    int32_t lower = 2000;
+    int32_t upper = 4000;
+    spec.AddPredicate(ColumnPredicate::Range(schema_.column(0), &lower, &upper));
+    spec.AddPredicate(ColumnPredicate::Equality(schema_.column(1), &value));
+    Arena arena(1024);
+    AutoReleasePool pool;
+    spec.OptimizeScan(schema_, &arena, &pool, true);
+    ASSERT_OK(iter->Init(&spec));
+    if (use_index) {
+      EXPECT_EQ(1042, cfile_iter_raw->lower_bound_idx_);
+      EXPECT_EQ(1943, cfile_iter_raw->upper_bound_idx_);
+    } else {
+      EXPECT_EQ(1000, cfile_iter_raw->lower_bound_idx_);
+      EXPECT_EQ(2000, cfile_iter_raw->upper_bound_idx_);
+    }
+    vector<string> results;
+    ASSERT_OK(IterateToStringList(iter.get(), &results));
+    ASSERT_EQ(10, results.size());
+    EXPECT_EQ("(int32 c0=2084, int32 c1=42, int32 c2=NULL)", results[0]);
+  }
+
+  // A value which isn't in the file leaves no rows to scan.
+  {
+    unique_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr));
+    CFileSet::Iterator* cfile_iter_raw = cfile_iter.get();
+    cfile_iter->set_indexed_column_ids({ c1_id });
+    unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(std::move(cfile_iter)));
+    ScanSpec spec;
+    int32_t missing = 1000;
+    spec.AddPredicate(ColumnPredicate::Equality(schema_.column(1), &missing));
+    ASSERT_OK(iter->Init(&spec));
+    EXPECT_EQ(cfile_iter_raw->lower_bound_idx_, cfile_iter_raw->upper_bound_idx_);
+    ASSERT_FALSE(iter->HasNext());
+  }
+}
+
+// A rowset keyed by (host, ts), as a time series table is.
+class TestCFileSetCompositeKey : public KuduRowSetTest {
+ public:
+  TestCFileSetCompositeKey() :
+    KuduRowSetTest(Schema({ ColumnSchema("host", STRING),
+                            ColumnSchema("ts", INT64),
+                            ColumnSchema("val", INT32) }, 2))
+  {}
+
+  virtual void SetUp() OVERRIDE {
+    KuduRowSetTest::SetUp();
+    FLAGS_cfile_default_block_size = 512;
+  }
+
+  // Writes 'num_hosts' hosts with 'num_ts' timestamps each, val being ts * 10.
+  void WriteTestRowSet(int num_hosts, int num_ts) {
+    DiskRowSetWriter rsw(rowset_meta_.get(), &schema_,
+                         BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+    ASSERT_OK(rsw.Open());
+    RowBuilder rb(&schema_);
+    for (int h = 0; h < num_hosts; h++) {
+      const string host = StringPrintf("host%02d", h);
+      for (int64_t ts = 0; ts < num_ts; ts++) {
+        rb.Reset();
+        rb.AddString(Slice(host));
+        rb.AddInt64(ts);
+        rb.AddInt32(ts * 10);
+        ASSERT_OK_FAST(WriteRow(rb.data(), &rsw));
+      }
+    }
+    ASSERT_OK(rsw.Finish());
+  }
+
+  // Scans the rowset with 'pred', returning the number of skip scan ranges
+  // the iterator used and the matching rows.
+  void Scan(const shared_ptr<CFileSet>& fileset, const ColumnPredicate& pred,
+            size_t* num_ranges, vector<string>* results) {
+    unique_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_, nullptr));
+    CFileSet::Iterator* cfile_iter_raw = cfile_iter.get();
+    unique_ptr<RowwiseIterator> iter(NewMaterializingIterator(std::move(cfile_iter)));
+    ScanSpec spec;
+    spec.AddPredicate(pred);
+    Arena arena(1024);
+    AutoReleasePool pool;
+    spec.OptimizeScan(schema_, &arena, &pool, true);
+    ASSERT_OK(iter->Init(&spec));
+    *num_ranges = cfile_iter_raw->skip_scan_ranges_.size();
+    ASSERT_OK(IterateToStringList(iter.get(), results));
+  }
+};
+
+TEST_F(TestCFileSetCompositeKey, TestSkipScan) {
+  const int kNumHosts = 10;
+  const int kNumTs = 1000;
+  WriteTestRowSet(kNumHosts, kNumTs);
+
+  shared_ptr<CFileSet> fileset;
+  ASSERT_OK(CFileSet::Open(rowset_meta_, MemTracker::GetRootTracker(), MemTracker::GetRootTracker(),
+                           nullptr, &fileset));
+
+  // A range of timestamps is found for every host.
+  int64_t lower = 100;
+  int64_t upper = 110;
+  auto range_pred = ColumnPredicate::Range(schema_.column(1), &lower, &upper);
+  size_t num_ranges;
+  vector<string> results;
+  NO_FATALS(Scan(fileset, range_pred, &num_ranges, &results));
+  EXPECT_EQ(kNumHosts, num_ranges);
+  ASSERT_EQ(kNumHosts * (upper - lower), results.size());
+  EXPECT_EQ(R"((string host="host00", int64 ts=100, int32 val=1000))", results.front());
+  EXPECT_EQ(R"((string host="host09", int64 ts=109, int32 val=1090))", results.back());
+
+  // So is a single timestamp.
+  int64_t value = 500;
+  auto eq_pred = ColumnPredicate::Equality(schema_.column(1), &value);
+  NO_FATALS(Scan(fileset, eq_pred, &num_ranges, &results));
+  EXPECT_EQ(kNumHosts, num_ranges);
+  ASSERT_EQ(kNumHosts, results.size());
+  for (int h = 0; h < kNumHosts; h++) {
+    EXPECT_EQ(StringPrintf(R"((string host="host%02d", int64 ts=500, int32 val=5000))", h),
+              results[h]);
+  }
+
+  // A bound past the end of the range of every host matches nothing.
+  int64_t past_end = kNumTs;
+  auto past_end_pred = ColumnPredicate::Range(schema_.column(1), &past_end, nullptr);
+  NO_FATALS(Scan(fileset, past_end_pred, &num_ranges, &results));
+  ASSERT_TRUE(results.empty());
+
+  // With more hosts than allowed, the whole rowset is scanned, with the same
+  // results.
+  FLAGS_cfile_skip_scan_max_prefixes = kNumHosts - 1;
+  NO_FATALS(Scan(fileset, range_pred, &num_ranges, &results));
+  EXPECT_EQ(0, num_ranges);
+  ASSERT_EQ(kNumHosts * (upper - lower), results.size());
+}
+
 } // namespace tablet
 } // namespace kudu
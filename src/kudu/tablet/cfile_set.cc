@@ -17,6 +17,7 @@
 #include "kudu/tablet/cfile_set.h"
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -33,9 +34,11 @@
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/iterator_stats.h"
+#include "kudu/common/key_encoder.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/scan_spec.h"
@@ -44,22 +47,38 @@
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/dynamic_annotations.h"
+#include "kudu/gutil/endian.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
 #include "kudu/tablet/diskrowset.h"
+#include "kudu/tablet/pinned_bloom_filter.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
 
 DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence checks");
 TAG_FLAG(consult_bloom_filters, hidden);
 
+DEFINE_int32(cfile_skip_scan_max_prefixes, 256,
+             "Maximum number of distinct values of the first primary key column "
+             "a scan with a predicate on the second primary key column skips "
+             "through in a rowset, seeking to the matching rows for each value. "
+             "Rowsets with more distinct values are scanned in full. Setting "
+             "this to 0 disables skip scans.");
+TAG_FLAG(cfile_skip_scan_max_prefixes, advanced);
+TAG_FLAG(cfile_skip_scan_max_prefixes, runtime);
+
 DECLARE_bool(rowset_metadata_store_keys);
 
 namespace kudu {
@@ -76,6 +95,7 @@ using cfile::ReaderOptions;
 using cfile::DefaultColumnValueIterator;
 using fs::IOContext;
 using fs::ReadableBlock;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -131,7 +151,43 @@ Status CFileSet::Open(shared_ptr<RowSetMetadata> rowset_metadata,
   return Status::OK();
 }
 
+Status CFileSet::Reopen(const IOContext* io_context, shared_ptr<CFileSet>* cfile_set) const {
+  shared_ptr<CFileSet> cfs(new CFileSet(rowset_metadata_,
+                                        bloomfile_tracker_,
+                                        cfile_reader_tracker_));
+  RETURN_NOT_OK(cfs->OpenReaders(io_context));
+  // The keys were already loaded and verified by this set.
+  cfs->min_encoded_key_ = min_encoded_key_;
+  cfs->max_encoded_key_ = max_encoded_key_;
+  cfs->pinned_bloom_ = pinned_bloom_;
+
+  cfile_set->swap(cfs);
+  return Status::OK();
+}
+
 Status CFileSet::DoOpen(const IOContext* io_context) {
+  RETURN_NOT_OK(OpenReaders(io_context));
+
+  // If the user specified to store the min/max keys in the rowset metadata,
+  // fetch them. Otherwise, load the min and max keys from the key reader.
+  if (FLAGS_rowset_metadata_store_keys && rowset_metadata_->has_encoded_keys()) {
+    min_encoded_key_ = rowset_metadata_->min_encoded_key();
+    max_encoded_key_ = rowset_metadata_->max_encoded_key();
+  } else {
+    RETURN_NOT_OK(LoadMinMaxKeys(io_context));
+  }
+  // Verify the loaded keys are valid.
+  if (Slice(min_encoded_key_).compare(max_encoded_key_) > 0) {
+    return Status::Corruption(Substitute("Min key $0 > max key $1",
+                                         KUDU_REDACT(Slice(min_encoded_key_).ToDebugString()),
+                                         KUDU_REDACT(Slice(max_encoded_key_).ToDebugString())),
+                              ToString());
+  }
+
+  return Status::OK();
+}
+
+Status CFileSet::OpenReaders(const IOContext* io_context) {
   RETURN_NOT_OK(OpenBloomReader(io_context));
 
   // Lazily open the column data cfiles. Each one will be fully opened
@@ -161,22 +217,18 @@ Status CFileSet::DoOpen(const IOContext* io_context) {
                              &ad_hoc_idx_reader_));
   }
 
-  // If the user specified to store the min/max keys in the rowset metadata,
-  // fetch them. Otherwise, load the min and max keys from the key reader.
-  if (FLAGS_rowset_metadata_store_keys && rowset_metadata_->has_encoded_keys()) {
-    min_encoded_key_ = rowset_metadata_->min_encoded_key();
-    max_encoded_key_ = rowset_metadata_->max_encoded_key();
-  } else {
-    RETURN_NOT_OK(LoadMinMaxKeys(io_context));
-  }
-  // Verify the loaded keys are valid.
-  if (Slice(min_encoded_key_).compare(max_encoded_key_) > 0) {
-    return Status::Corruption(Substitute("Min key $0 > max key $1",
-                                         KUDU_REDACT(Slice(min_encoded_key_).ToDebugString()),
-                                         KUDU_REDACT(Slice(max_encoded_key_).ToDebugString())),
-                              ToString());
+  RowSetMetadata::ColumnIdToBlockIdMap index_map =
+      rowset_metadata_->GetSecondaryIndexBlocksById();
+  for (const RowSetMetadata::ColumnIdToBlockIdMap::value_type& e : index_map) {
+    unique_ptr<CFileReader> reader;
+    RETURN_NOT_OK(OpenReader(rowset_metadata_->fs_manager(),
+                             cfile_reader_tracker_,
+                             e.second,
+                             io_context,
+                             &reader));
+    secondary_idx_readers_by_col_id_[e.first] = std::move(reader);
   }
-
+  secondary_idx_readers_by_col_id_.shrink_to_fit();
   return Status::OK();
 }
 
@@ -233,9 +285,10 @@ Status CFileSet::NewColumnIterator(ColumnId col_id,
 
 unique_ptr<CFileSet::Iterator> CFileSet::NewIterator(
     const Schema* projection,
-    const IOContext* io_context) const {
+    const IOContext* io_context,
+    ThreadPool* read_pool) const {
   return unique_ptr<CFileSet::Iterator>(
-      new CFileSet::Iterator(shared_from_this(), projection, io_context));
+      new CFileSet::Iterator(shared_from_this(), projection, io_context, read_pool));
 }
 
 Status CFileSet::CountRows(const IOContext* io_context, rowid_t *count) const {
@@ -257,6 +310,14 @@ uint64_t CFileSet::AdhocIndexOnDiskSize() const {
   return 0;
 }
 
+uint64_t CFileSet::SecondaryIndexOnDiskSize() const {
+  uint64_t ret = 0;
+  for (const auto& e : secondary_idx_readers_by_col_id_) {
+    ret += e.second->file_size();
+  }
+  return ret;
+}
+
 uint64_t CFileSet::BloomFileOnDiskSize() const {
   return bloom_reader_->FileSize();
 }
@@ -277,7 +338,13 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe,
                          const IOContext* io_context,
                          boost::optional<rowid_t>* idx,
                          ProbeStats* stats) const {
-  if (FLAGS_consult_bloom_filters) {
+  if (FLAGS_consult_bloom_filters && pinned_bloom_) {
+    stats->blooms_consulted++;
+    if (!pinned_bloom_->MayContainKey(probe.pinned_bloom_hash())) {
+      *idx = boost::none;
+      return Status::OK();
+    }
+  } else if (FLAGS_consult_bloom_filters) {
     // Fully open the BloomFileReader if it was lazily opened earlier.
     //
     // If it's already initialized, this is a no-op.
@@ -318,6 +385,44 @@ Status CFileSet::FindRow(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+Status CFileSet::FindRowIdRange(const Slice& lower_bound_key,
+                                const Slice& upper_bound_key,
+                                const IOContext* io_context,
+                                rowid_t* first_row,
+                                rowid_t* end_row) const {
+  *first_row = 0;
+  *end_row = 0;
+  if (lower_bound_key.compare(upper_bound_key) >= 0 ||
+      lower_bound_key.compare(max_encoded_key_) > 0 ||
+      upper_bound_key.compare(min_encoded_key_) <= 0) {
+    return Status::OK();
+  }
+  rowid_t row_count;
+  RETURN_NOT_OK(CountRows(io_context, &row_count));
+  *end_row = row_count;
+
+  unique_ptr<CFileIterator> key_iter;
+  RETURN_NOT_OK(NewKeyIterator(io_context, &key_iter));
+  Arena arena(256);
+  if (lower_bound_key.compare(min_encoded_key_) > 0) {
+    unique_ptr<EncodedKey> key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(tablet_schema(), &arena,
+                                                  lower_bound_key, &key));
+    bool exact;
+    RETURN_NOT_OK(key_iter->SeekAtOrAfter(*key, &exact));
+    *first_row = key_iter->GetCurrentOrdinal();
+  }
+  if (upper_bound_key.compare(max_encoded_key_) <= 0) {
+    unique_ptr<EncodedKey> key;
+    RETURN_NOT_OK(EncodedKey::DecodeEncodedString(tablet_schema(), &arena,
+                                                  upper_bound_key, &key));
+    bool exact;
+    RETURN_NOT_OK(key_iter->SeekAtOrAfter(*key, &exact));
+    *end_row = key_iter->GetCurrentOrdinal();
+  }
+  return Status::OK();
+}
+
 Status CFileSet::CheckRowPresent(const RowSetKeyProbe& probe, const IOContext* io_context,
                                  bool* present, rowid_t* rowid, ProbeStats* stats) const {
   boost::optional<rowid_t> opt_rowid;
@@ -333,6 +438,127 @@ Status CFileSet::CheckRowPresent(const RowSetKeyProbe& probe, const IOContext* i
   return Status::OK();
 }
 
+Status CFileSet::CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                                  size_t n,
+                                  const IOContext* io_context,
+                                  bool* present,
+                                  rowid_t* rowids,
+                                  ProbeStats* const* stats) const {
+  std::fill(present, present + n, true);
+  if (FLAGS_consult_bloom_filters && pinned_bloom_) {
+    for (size_t i = 0; i < n; i++) {
+      stats[i]->blooms_consulted++;
+      present[i] = pinned_bloom_->MayContainKey(probes[i]->pinned_bloom_hash());
+    }
+  } else if (FLAGS_consult_bloom_filters) {
+    // Fully open the BloomFileReader if it was lazily opened earlier.
+    //
+    // If it's already initialized, this is a no-op.
+    RETURN_NOT_OK(bloom_reader_->Init(io_context));
+
+    vector<const BloomKeyProbe*> bloom_probes(n);
+    for (size_t i = 0; i < n; i++) {
+      bloom_probes[i] = &probes[i]->bloom_probe();
+      stats[i]->blooms_consulted++;
+    }
+    Status s = bloom_reader_->CheckKeysPresent(bloom_probes.data(), n, io_context, present);
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 1) << Substitute("Unable to query bloom in $0: $1",
+          rowset_metadata_->bloom_block().ToString(), s.ToString());
+      if (PREDICT_FALSE(s.IsDiskFailure())) {
+        // If the bloom lookup failed because of a disk failure, return early
+        // since I/O to the tablet should be stopped.
+        return s;
+      }
+      // Continue with the slow path for all the keys.
+      std::fill(present, present + n, true);
+    }
+  }
+
+  unique_ptr<CFileIterator> key_iter;
+  for (size_t i = 0; i < n; i++) {
+    if (!present[i]) {
+      continue;
+    }
+    stats[i]->keys_consulted++;
+    if (!key_iter) {
+      RETURN_NOT_OK(NewKeyIterator(io_context, &key_iter));
+    }
+    bool exact;
+    Status s = key_iter->SeekAtOrAfter(probes[i]->encoded_key(), &exact);
+    if (s.IsNotFound() || (s.ok() && !exact)) {
+      present[i] = false;
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    rowids[i] = key_iter->GetCurrentOrdinal();
+  }
+  return Status::OK();
+}
+
+Status CFileSet::LookupSecondaryIndex(ColumnId col_id,
+                                      const ColumnPredicate& pred,
+                                      const IOContext* io_context,
+                                      vector<rowid_t>* rowids) const {
+  static const size_t kEntriesPerBatch = 1024;
+  DCHECK(pred.predicate_type() == PredicateType::Equality ||
+         pred.predicate_type() == PredicateType::InList);
+  rowids->clear();
+
+  const auto& reader = FindOrDie(secondary_idx_readers_by_col_id_, col_id);
+  unique_ptr<CFileIterator> iter;
+  RETURN_NOT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK, io_context));
+
+  vector<const void*> values;
+  if (pred.predicate_type() == PredicateType::Equality) {
+    values.push_back(pred.raw_lower());
+  } else {
+    values = pred.raw_values();
+  }
+  const KeyEncoder<faststring>& encoder = GetKeyEncoder<faststring>(pred.column().type_info());
+  ScopedColumnBlock<BINARY> entries(kEntriesPerBatch, /*allow_nulls=*/false);
+  for (const void* value : values) {
+    // Each entry is the encoded value followed by the ordinal of the row. The
+    // encoding with separators is prefix-free, so the entries of the value
+    // are exactly those starting with its encoding, and follow each other.
+    faststring buf;
+    encoder.Encode(value, /*is_last=*/false, &buf);
+    const string prefix = buf.ToString();
+    // Seek by the encoded value rather than by a raw cell, as composite keys are.
+    vector<const void*> raw_keys;
+    EncodedKey key(&buf, &raw_keys, /*num_key_cols=*/2);
+    bool exact;
+    Status s = iter->SeekAtOrAfter(key, &exact);
+    if (s.IsNotFound()) {
+      continue;
+    }
+    RETURN_NOT_OK(s);
+
+    bool done = false;
+    while (!done && iter->HasNext()) {
+      entries.arena()->Reset();
+      size_t n = kEntriesPerBatch;
+      ColumnMaterializationContext ctx(0, nullptr, &entries, nullptr);
+      RETURN_NOT_OK(iter->CopyNextValues(&n, &ctx));
+      for (size_t i = 0; i < n; i++) {
+        const Slice& entry = entries[i];
+        if (!entry.starts_with(prefix)) {
+          done = true;
+          break;
+        }
+        if (PREDICT_FALSE(entry.size() != prefix.size() + sizeof(uint32_t))) {
+          return Status::Corruption("invalid secondary index entry",
+                                    KUDU_REDACT(entry.ToDebugString()));
+        }
+        rowids->push_back(BigEndian::Load32(entry.data() + prefix.size()));
+      }
+    }
+  }
+  std::sort(rowids->begin(), rowids->end());
+  rowids->erase(std::unique(rowids->begin(), rowids->end()), rowids->end());
+  return Status::OK();
+}
+
 Status CFileSet::NewKeyIterator(const IOContext* io_context,
                                 unique_ptr<CFileIterator>* key_iter) const {
   RETURN_NOT_OK(key_index_reader()->Init(io_context));
@@ -349,6 +575,8 @@ Status CFileSet::Iterator::CreateColumnIterators(const ScanSpec* spec) {
   DCHECK_EQ(0, col_iters_.size());
   vector<unique_ptr<ColumnIterator>> ret_iters;
   ret_iters.reserve(projection_->num_columns());
+  vector<CFileIterator*> cfile_iters;
+  cfile_iters.reserve(projection_->num_columns());
 
   CFileReader::CacheControl cache_blocks = CFileReader::CACHE_BLOCK;
   if (spec && !spec->cache_blocks()) {
@@ -371,16 +599,20 @@ Status CFileSet::Iterator::CreateColumnIterators(const ScanSpec* spec) {
       }
       ret_iters.emplace_back(new DefaultColumnValueIterator(col_schema.type_info(),
                                                             col_schema.read_default_value()));
+      cfile_iters.emplace_back(nullptr);
       continue;
     }
     unique_ptr<CFileIterator> iter;
     RETURN_NOT_OK_PREPEND(base_data_->NewColumnIterator(col_id, cache_blocks, io_context_, &iter),
                           Substitute("could not create iterator for column $0",
                                      projection_->column(proj_col_idx).ToString()));
+    cfile_iters.emplace_back(iter.get());
     ret_iters.emplace_back(std::move(iter));
   }
 
   col_iters_.swap(ret_iters);
+  cfile_iters_.swap(cfile_iters);
+  read_ahead_end_idx_.assign(col_iters_.size(), 0);
   prepared_iters_.reserve(col_iters_.size());
   return Status::OK();
 }
@@ -400,6 +632,24 @@ Status CFileSet::Iterator::Init(ScanSpec *spec) {
   // ordinal range.
   RETURN_NOT_OK(PushdownRangeScanPredicate(spec));
 
+  // If there are equality predicates on indexed columns, only look at the
+  // rows the indexes point to.
+  if (spec != nullptr && !indexed_col_ids_.empty()) {
+    RETURN_NOT_OK(PushdownSecondaryIndexPredicates(*spec));
+  }
+
+  // If the scan is restricted to several key ranges, skip over the rows
+  // between them.
+  if (spec != nullptr) {
+    RETURN_NOT_OK(PushdownKeyRanges(*spec));
+  }
+
+  // Otherwise, if there is a predicate on the second key column, skip over
+  // the rows which can't satisfy it.
+  if (spec != nullptr && !has_index_matches_ && skip_scan_ranges_.empty()) {
+    RETURN_NOT_OK(PushdownSkipScanPredicate(*spec));
+  }
+
   initted_ = true;
 
   // Don't actually seek -- we'll seek when we first actually read the
@@ -469,6 +719,271 @@ Status CFileSet::Iterator::PushdownRangeScanPredicate(ScanSpec *spec) {
   return Status::OK();
 }
 
+Status CFileSet::Iterator::PushdownSecondaryIndexPredicates(const ScanSpec& spec) {
+  if (lower_bound_idx_ >= upper_bound_idx_) {
+    return Status::OK();
+  }
+  vector<rowid_t> rowids;
+  for (const auto& e : spec.predicates()) {
+    const ColumnPredicate& pred = e.second;
+    if (pred.predicate_type() != PredicateType::Equality &&
+        pred.predicate_type() != PredicateType::InList) {
+      continue;
+    }
+    int proj_col_idx = projection_->find_column(pred.column().name());
+    if (proj_col_idx == Schema::kColumnNotFound) {
+      continue;
+    }
+    ColumnId col_id = projection_->column_id(proj_col_idx);
+    if (std::find(indexed_col_ids_.begin(), indexed_col_ids_.end(), col_id) ==
+            indexed_col_ids_.end() ||
+        !base_data_->has_secondary_index_for_column_id(col_id)) {
+      continue;
+    }
+    RETURN_NOT_OK(base_data_->LookupSecondaryIndex(col_id, pred, io_context_, &rowids));
+    // Only keep the rows within the bounds, and which satisfy the other
+    // indexed predicates.
+    auto begin = std::lower_bound(rowids.begin(), rowids.end(), lower_bound_idx_);
+    auto end = std::lower_bound(begin, rowids.end(), upper_bound_idx_);
+    vector<rowid_t> matches;
+    if (has_index_matches_) {
+      std::set_intersection(index_matches_.begin(), index_matches_.end(),
+                            begin, end, std::back_inserter(matches));
+    } else {
+      matches.assign(begin, end);
+    }
+    index_matches_.swap(matches);
+    has_index_matches_ = true;
+    VLOG(1) << "Looked up " << pred.ToString() << " in secondary index: "
+            << index_matches_.size() << " matching rows";
+  }
+
+  if (has_index_matches_) {
+    if (index_matches_.empty()) {
+      lower_bound_idx_ = upper_bound_idx_;
+    } else {
+      lower_bound_idx_ = index_matches_.front();
+      upper_bound_idx_ = index_matches_.back() + 1;
+    }
+  }
+  return Status::OK();
+}
+
+Status CFileSet::Iterator::SeekKeyIndex(faststring* encoded_key, rowid_t* idx) {
+  // Seek by the encoded key rather than by raw cells, as the secondary
+  // indexes do.
+  vector<const void*> raw_keys;
+  EncodedKey key(encoded_key, &raw_keys, base_data_->tablet_schema().num_key_columns());
+  bool exact;
+  Status s = key_iter_->SeekAtOrAfter(key, &exact);
+  if (s.IsNotFound()) {
+    *idx = row_count_;
+    return Status::OK();
+  }
+  RETURN_NOT_OK(s);
+  *idx = key_iter_->GetCurrentOrdinal();
+  return Status::OK();
+}
+
+Status CFileSet::Iterator::PushdownKeyRanges(const ScanSpec& spec) {
+  if (spec.key_ranges().size() <= 1 || lower_bound_idx_ >= upper_bound_idx_) {
+    return Status::OK();
+  }
+  faststring seek_key;
+  vector<pair<rowid_t, rowid_t>> ranges;
+  for (const auto& key_range : spec.key_ranges()) {
+    rowid_t start = 0;
+    if (!key_range.first.empty()) {
+      seek_key.assign_copy(key_range.first);
+      RETURN_NOT_OK(SeekKeyIndex(&seek_key, &start));
+    }
+    rowid_t end = row_count_;
+    if (!key_range.second.empty()) {
+      seek_key.assign_copy(key_range.second);
+      RETURN_NOT_OK(SeekKeyIndex(&seek_key, &end));
+    }
+    start = std::max(start, lower_bound_idx_);
+    end = std::min(end, upper_bound_idx_);
+    if (start < end) {
+      if (!ranges.empty() && ranges.back().second == start) {
+        ranges.back().second = end;
+      } else {
+        ranges.emplace_back(start, end);
+      }
+    }
+  }
+
+  if (has_index_matches_) {
+    // The matches already skip the rows between the ranges once those
+    // outside of them are dropped.
+    vector<rowid_t> matches;
+    for (const auto& range : ranges) {
+      auto begin = std::lower_bound(index_matches_.begin(), index_matches_.end(), range.first);
+      auto end = std::lower_bound(begin, index_matches_.end(), range.second);
+      matches.insert(matches.end(), begin, end);
+    }
+    index_matches_.swap(matches);
+    if (index_matches_.empty()) {
+      lower_bound_idx_ = upper_bound_idx_;
+    } else {
+      lower_bound_idx_ = index_matches_.front();
+      upper_bound_idx_ = index_matches_.back() + 1;
+    }
+    return Status::OK();
+  }
+
+  if (ranges.empty()) {
+    lower_bound_idx_ = upper_bound_idx_;
+  } else {
+    lower_bound_idx_ = ranges.front().first;
+    upper_bound_idx_ = ranges.back().second;
+    if (ranges.size() > 1) {
+      skip_scan_ranges_.swap(ranges);
+    }
+  }
+  VLOG(1) << "Scanning " << spec.key_ranges().size() << " key ranges: "
+          << skip_scan_ranges_.size() << " ranges of rows";
+  return Status::OK();
+}
+
+Status CFileSet::Iterator::PushdownSkipScanPredicate(const ScanSpec& spec) {
+  const Schema& schema = base_data_->tablet_schema();
+  if (FLAGS_cfile_skip_scan_max_prefixes <= 0 ||
+      schema.num_key_columns() < 2 ||
+      lower_bound_idx_ >= upper_bound_idx_ ||
+      ContainsKey(spec.predicates(), schema.column(0).name())) {
+    return Status::OK();
+  }
+  const ColumnPredicate* pred = FindOrNull(spec.predicates(), schema.column(1).name());
+  if (pred == nullptr ||
+      (pred->predicate_type() != PredicateType::Range &&
+       pred->predicate_type() != PredicateType::Equality)) {
+    return Status::OK();
+  }
+
+  // The key index holds the encoded keys, in which the encoded value of the
+  // first column is followed by the encoded value of the second one. So for
+  // each distinct encoded value 'prefix' of the first column, the matching
+  // rows are those from the one at or after 'prefix' + the encoded lower
+  // bound of the predicate, to the one at or after 'prefix' + the encoded
+  // upper bound.
+  const bool second_is_last = schema.num_key_columns() == 2;
+  const KeyEncoder<faststring>& first_encoder =
+      GetKeyEncoder<faststring>(schema.column(0).type_info());
+  const KeyEncoder<faststring>& second_encoder =
+      GetKeyEncoder<faststring>(schema.column(1).type_info());
+  faststring buf;
+  string lower_suffix;
+  string upper_suffix;
+  const bool has_lower = pred->raw_lower() != nullptr;
+  bool has_upper = false;
+  if (has_lower) {
+    second_encoder.Encode(pred->raw_lower(), second_is_last, &buf);
+    lower_suffix = buf.ToString();
+  }
+  if (pred->predicate_type() == PredicateType::Equality) {
+    // The rows equal to the value are those whose keys have its encoding as
+    // a prefix past the first column, or equal it if it is the last column.
+    upper_suffix = lower_suffix;
+    has_upper = true;
+  } else if (pred->raw_upper() != nullptr) {
+    buf.clear();
+    second_encoder.Encode(pred->raw_upper(), second_is_last, &buf);
+    upper_suffix = buf.ToString();
+    has_upper = true;
+  }
+
+  Arena arena(1024);
+  ScopedColumnBlock<BINARY> keys(1, /*allow_nulls=*/false);
+  faststring seek_key;
+  vector<pair<rowid_t, rowid_t>> ranges;
+  int num_prefixes = 0;
+  rowid_t cur = lower_bound_idx_;
+  while (cur < upper_bound_idx_) {
+    if (++num_prefixes > FLAGS_cfile_skip_scan_max_prefixes) {
+      VLOG(1) << "Not skip scanning: more than " << FLAGS_cfile_skip_scan_max_prefixes
+              << " distinct values of the first key column";
+      return Status::OK();
+    }
+    // Read the key of the row at 'cur' to find the encoded value of its
+    // first column.
+    RETURN_NOT_OK(key_iter_->SeekToOrdinal(cur));
+    keys.arena()->Reset();
+    size_t n = 1;
+    ColumnMaterializationContext ctx(0, nullptr, &keys, nullptr);
+    RETURN_NOT_OK(key_iter_->CopyNextValues(&n, &ctx));
+    if (PREDICT_FALSE(n != 1)) {
+      return Status::Corruption(Substitute("unable to read the key of row $0", cur));
+    }
+    arena.Reset();
+    uint8_t* first_cell = reinterpret_cast<uint8_t*>(
+        arena.AllocateBytes(schema.column(0).type_info()->size()));
+    Slice remaining = keys[0];
+    RETURN_NOT_OK_PREPEND(first_encoder.Decode(&remaining, /*is_last=*/false,
+                                               &arena, first_cell),
+                          "unable to decode key");
+    const Slice prefix(keys[0].data(), keys[0].size() - remaining.size());
+
+    rowid_t start = cur;
+    if (has_lower) {
+      seek_key.assign_copy(prefix.data(), prefix.size());
+      seek_key.append(lower_suffix);
+      RETURN_NOT_OK(SeekKeyIndex(&seek_key, &start));
+      start = std::max(start, cur);
+    }
+    rowid_t end = row_count_;
+    if (has_upper) {
+      seek_key.assign_copy(prefix.data(), prefix.size());
+      seek_key.append(upper_suffix);
+      if (pred->predicate_type() == PredicateType::Equality) {
+        if (second_is_last) {
+          seek_key.push_back('\0');
+        } else {
+          seek_key.assign_copy(PrefixSuccessor(seek_key.ToString()));
+        }
+      }
+      if (seek_key.length() > 0) {
+        RETURN_NOT_OK(SeekKeyIndex(&seek_key, &end));
+      }
+    }
+    // The first row of the next value of the first column.
+    rowid_t next;
+    const string prefix_successor = PrefixSuccessor(prefix.ToString());
+    if (prefix_successor.empty()) {
+      next = row_count_;
+    } else {
+      seek_key.assign_copy(prefix_successor);
+      RETURN_NOT_OK(SeekKeyIndex(&seek_key, &next));
+    }
+    if (!has_upper) {
+      end = next;
+    }
+    end = std::min(end, upper_bound_idx_);
+    if (start < end) {
+      if (!ranges.empty() && ranges.back().second == start) {
+        ranges.back().second = end;
+      } else {
+        ranges.emplace_back(start, end);
+      }
+    }
+    DCHECK_GT(next, cur);
+    cur = next;
+  }
+
+  if (ranges.empty()) {
+    lower_bound_idx_ = upper_bound_idx_;
+  } else {
+    lower_bound_idx_ = ranges.front().first;
+    upper_bound_idx_ = ranges.back().second;
+    if (ranges.size() > 1) {
+      skip_scan_ranges_.swap(ranges);
+    }
+  }
+  VLOG(1) << "Skip scanning " << pred->ToString() << ": "
+          << skip_scan_ranges_.size() << " ranges of rows";
+  return Status::OK();
+}
+
 void CFileSet::Iterator::Unprepare() {
   prepared_count_ = 0;
   prepared_iters_.clear();
@@ -477,17 +992,74 @@ void CFileSet::Iterator::Unprepare() {
 Status CFileSet::Iterator::PrepareBatch(size_t *nrows) {
   DCHECK_EQ(prepared_count_, 0) << "Already prepared";
 
-  size_t remaining = upper_bound_idx_ - cur_idx_;
+  size_t end_idx = upper_bound_idx_;
+  if (!skip_scan_ranges_.empty()) {
+    // Skip to the next range of rows which may match, and don't go past it.
+    while (skip_scan_range_idx_ < skip_scan_ranges_.size() &&
+           skip_scan_ranges_[skip_scan_range_idx_].second <= cur_idx_) {
+      skip_scan_range_idx_++;
+    }
+    DCHECK_LT(skip_scan_range_idx_, skip_scan_ranges_.size());
+    const auto& range = skip_scan_ranges_[skip_scan_range_idx_];
+    cur_idx_ = std::max<size_t>(cur_idx_, range.first);
+    end_idx = range.second;
+  }
+  size_t remaining = end_idx - cur_idx_;
   if (*nrows > remaining) {
     *nrows = remaining;
   }
 
   prepared_count_ = *nrows;
 
+  if (read_pool_ && prepared_count_ > 0) {
+    ReadColumnsAhead();
+  }
+
   // Lazily prepare the first column when it is materialized.
   return Status::OK();
 }
 
+void CFileSet::Iterator::ReadColumnsAhead() {
+  const int64_t end_idx = cur_idx_ + prepared_count_;
+  vector<size_t> col_idxs;
+  for (size_t i = 0; i < cfile_iters_.size(); i++) {
+    if (cfile_iters_[i] && read_ahead_end_idx_[i] < end_idx) {
+      col_idxs.push_back(i);
+    }
+  }
+  // Reading a single column on another thread wouldn't save any time.
+  if (col_idxs.size() < 2) {
+    return;
+  }
+
+  // Errors are ignored: the blocks are read again when their columns are
+  // prepared, which reports any error properly.
+  CountDownLatch latch(col_idxs.size());
+  vector<rowid_t> last_row_idxs(col_idxs.size());
+  vector<Status> statuses(col_idxs.size());
+  for (size_t i = 0; i < col_idxs.size(); i++) {
+    CFileIterator* iter = cfile_iters_[col_idxs[i]];
+    Status s = read_pool_->Submit([&, iter, i]() {
+      statuses[i] = iter->ReadBlocksIntoCache(cur_idx_, prepared_count_, &last_row_idxs[i]);
+      latch.CountDown();
+    });
+    if (!s.ok()) {
+      statuses[i] = s;
+      latch.CountDown();
+    }
+  }
+  latch.Wait();
+
+  for (size_t i = 0; i < col_idxs.size(); i++) {
+    if (statuses[i].ok()) {
+      read_ahead_end_idx_[col_idxs[i]] = static_cast<int64_t>(last_row_idxs[i]) + 1;
+    } else {
+      VLOG(1) << "Unable to read column " << col_idxs[i] << " ahead: "
+              << statuses[i].ToString();
+    }
+  }
+}
+
 Status CFileSet::Iterator::PrepareColumn(ColumnMaterializationContext *ctx) {
   ColumnIterator* col_iter = col_iters_[ctx->col_idx()].get();
   size_t n = prepared_count_;
@@ -521,7 +1093,15 @@ Status CFileSet::Iterator::PrepareColumn(ColumnMaterializationContext *ctx) {
 }
 
 Status CFileSet::Iterator::InitializeSelectionVector(SelectionVector *sel_vec) {
-  sel_vec->SetAllTrue();
+  if (!has_index_matches_) {
+    sel_vec->SetAllTrue();
+    return Status::OK();
+  }
+  sel_vec->SetAllFalse();
+  auto it = std::lower_bound(index_matches_.begin(), index_matches_.end(), cur_idx_);
+  for (; it != index_matches_.end() && *it < cur_idx_ + prepared_count_; ++it) {
+    sel_vec->SetRowSelected(*it - cur_idx_);
+  }
   return Status::OK();
 }
 
@@ -529,8 +1109,20 @@ Status CFileSet::Iterator::MaterializeColumn(ColumnMaterializationContext *ctx)
   CHECK_EQ(prepared_count_, ctx->block()->nrows());
   DCHECK_LT(ctx->col_idx(), col_iters_.size());
 
-  RETURN_NOT_OK(PrepareColumn(ctx));
   ColumnIterator* iter = col_iters_[ctx->col_idx()].get();
+  if (ctx->DecoderEvalNotDisabled()) {
+    // If the column's statistics show that no row in this batch can satisfy
+    // the predicate, there's no need to read the column's data at all.
+    bool may_match;
+    RETURN_NOT_OK(iter->MayHaveMatches(cur_idx_, prepared_count_, *ctx->pred(), &may_match));
+    if (!may_match) {
+      ctx->SetDecoderEvalSupported();
+      SelectionVectorView(ctx->sel()).ClearBits(prepared_count_);
+      return Status::OK();
+    }
+  }
+
+  RETURN_NOT_OK(PrepareColumn(ctx));
 
   RETURN_NOT_OK(iter->Scan(ctx));
 
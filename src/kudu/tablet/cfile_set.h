@@ -47,9 +47,13 @@ class optional;
 namespace kudu {
 
 class ColumnMaterializationContext;
+class ColumnPredicate;
 class MemTracker;
 class ScanSpec;
 class SelectionVector;
+class Slice;
+class ThreadPool;
+class faststring;
 struct IteratorStats;
 
 namespace cfile {
@@ -62,6 +66,7 @@ struct IOContext;
 
 namespace tablet {
 
+class PinnedBloomFilter;
 class RowSetKeyProbe;
 struct ProbeStats;
 
@@ -79,10 +84,21 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
                      const fs::IOContext* io_context,
                      std::shared_ptr<CFileSet>* cfile_set);
 
+  // Opens a new CFileSet over the same blocks as this one, whose readers are
+  // not yet initialized, so that the memory held by the readers of this one
+  // is released once it is no longer referenced. The keys and the pinned
+  // bloom filter are carried over, so no I/O is needed.
+  Status Reopen(const fs::IOContext* io_context,
+                std::shared_ptr<CFileSet>* cfile_set) const;
+
   // Create an iterator with the given projection. 'projection' must remain valid
   // for the lifetime of the returned iterator.
+  //
+  // If 'read_pool' is set, the iterator reads the data blocks of all of its
+  // columns needed by each batch concurrently, using threads of that pool.
   std::unique_ptr<Iterator> NewIterator(const Schema* projection,
-                                        const fs::IOContext* io_context) const;
+                                        const fs::IOContext* io_context,
+                                        ThreadPool* read_pool = nullptr) const;
 
   Status CountRows(const fs::IOContext* io_context, rowid_t *count) const;
 
@@ -94,6 +110,10 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
   // Returns 0 if there is no ad hoc index.
   uint64_t AdhocIndexOnDiskSize() const;
 
+  // The on-disk size, in bytes, of this cfile set's secondary indexes.
+  // Returns 0 if there are no secondary indexes.
+  uint64_t SecondaryIndexOnDiskSize() const;
+
   // The on-disk size, in bytes, of this cfile set's bloomfiles.
   // Returns 0 if there are no bloomfiles.
   uint64_t BloomFileOnDiskSize() const;
@@ -112,6 +132,15 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
                  boost::optional<rowid_t>* idx,
                  ProbeStats* stats) const;
 
+  // Determine the range of the indexes of the rows whose encoded keys are
+  // within ['lower_bound_key', 'upper_bound_key'), as [*first_row, *end_row).
+  // The range is empty if no row is.
+  Status FindRowIdRange(const Slice& lower_bound_key,
+                        const Slice& upper_bound_key,
+                        const fs::IOContext* io_context,
+                        rowid_t* first_row,
+                        rowid_t* end_row) const;
+
   std::string ToString() const {
     return std::string("CFile base data in ") + rowset_metadata_->ToString();
   }
@@ -121,6 +150,42 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
   Status CheckRowPresent(const RowSetKeyProbe& probe, const fs::IOContext* io_context,
                          bool* present, rowid_t* rowid, ProbeStats* stats) const;
 
+  // Check if each of the 'n' given rows, which must be sorted by encoded key,
+  // is present, like CheckRowPresent(). The bloom filter is probed for all
+  // the keys at once, and a single key index iterator is used to look up
+  // the possible hits.
+  Status CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                          size_t n,
+                          const fs::IOContext* io_context,
+                          bool* present,
+                          rowid_t* rowids,
+                          ProbeStats* const* stats) const;
+
+  // Check 'filter' rather than the bloom file when looking for keys. Must be
+  // called before the CFileSet is used to look for keys.
+  void set_pinned_bloom(std::shared_ptr<const PinnedBloomFilter> filter) {
+    pinned_bloom_ = std::move(filter);
+  }
+
+  const std::shared_ptr<const PinnedBloomFilter>& pinned_bloom() const {
+    return pinned_bloom_;
+  }
+
+  // Return true if there exists a secondary index for the given column ID.
+  // See DiskRowSetWriter::set_secondary_index_column_ids().
+  bool has_secondary_index_for_column_id(ColumnId col_id) const {
+    return ContainsKey(secondary_idx_readers_by_col_id_, col_id);
+  }
+
+  // Looks up the rows whose base data for the column 'col_id' satisfies
+  // 'pred', which must be an equality or IN list predicate on the column, in
+  // the secondary index of the column, setting '*rowids' to their sorted
+  // indexes. The column must have a secondary index.
+  Status LookupSecondaryIndex(ColumnId col_id,
+                              const ColumnPredicate& pred,
+                              const fs::IOContext* io_context,
+                              std::vector<rowid_t>* rowids) const;
+
   // Return true if there exists a CFile for the given column ID.
   bool has_data_for_column_id(ColumnId col_id) const {
     return ContainsKey(readers_by_col_id_, col_id);
@@ -138,6 +203,8 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
            std::shared_ptr<MemTracker> cfile_reader_tracker);
 
   Status DoOpen(const fs::IOContext* io_context);
+  // Opens the bloom, column and ad hoc index readers without initializing them.
+  Status OpenReaders(const fs::IOContext* io_context);
   Status OpenBloomReader(const fs::IOContext* io_context);
   Status LoadMinMaxKeys(const fs::IOContext* io_context);
 
@@ -172,6 +239,14 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
   // index pertains to more than one column, as in the case of composite keys.
   std::unique_ptr<cfile::CFileReader> ad_hoc_idx_reader_;
   std::unique_ptr<cfile::BloomFileReader> bloom_reader_;
+
+  // Map of column ID to the reader of the secondary index of the column.
+  ReaderMap secondary_idx_readers_by_col_id_;
+
+  // In-memory bloom filter over the keys, checked instead of 'bloom_reader_'
+  // if set. Shared with the CFileSets that replace this one after major
+  // delta compactions, which don't change the keys.
+  std::shared_ptr<const PinnedBloomFilter> pinned_bloom_;
 };
 
 
@@ -216,21 +291,34 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Collect the IO statistics for each of the underlying columns.
   virtual void GetIteratorStats(std::vector<IteratorStats> *stats) const OVERRIDE;
 
+  // Allows the iterator to select the rows satisfying the equality and IN
+  // list predicates on the columns with the given IDs using their secondary
+  // indexes. The caller must ensure that the base data holds the values of
+  // these columns visible to the iteration, i.e. that there are no updates to
+  // them to apply. Must be called before Init().
+  void set_indexed_column_ids(std::vector<ColumnId> col_ids) {
+    DCHECK(!initted_);
+    indexed_col_ids_ = std::move(col_ids);
+  }
+
   virtual ~Iterator();
  private:
   DISALLOW_COPY_AND_ASSIGN(Iterator);
   FRIEND_TEST(TestCFileSet, TestRangeScan);
+  FRIEND_TEST(TestCFileSet, TestSecondaryIndex);
   friend class CFileSet;
+  friend class TestCFileSetCompositeKey;
 
   // 'projection' must remain valid for the lifetime of this object.
   Iterator(std::shared_ptr<CFileSet const> base_data, const Schema* projection,
-           const fs::IOContext* io_context)
+           const fs::IOContext* io_context, ThreadPool* read_pool)
       : base_data_(std::move(base_data)),
         projection_(projection),
         initted_(false),
         cur_idx_(0),
         prepared_count_(0),
-        io_context_(io_context) {}
+        io_context_(io_context),
+        read_pool_(read_pool) {}
 
   // Fill in col_iters_ for each of the requested columns.
   Status CreateColumnIterators(const ScanSpec* spec);
@@ -240,11 +328,39 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // store it in member fields.
   Status PushdownRangeScanPredicate(ScanSpec *spec);
 
+  // Look up the rows satisfying the predicates of 'spec' on the columns of
+  // 'indexed_col_ids_' in their secondary indexes, narrowing the bounds of the
+  // iterator to them. The predicates are left in the spec.
+  Status PushdownSecondaryIndexPredicates(const ScanSpec& spec);
+
+  // If 'spec' has several key ranges, look up the ranges of rows they map to
+  // in the key index, so that the rows in between are skipped. If there are
+  // matches from secondary indexes, only those within the ranges are kept.
+  Status PushdownKeyRanges(const ScanSpec& spec);
+
+  // If 'spec' has a range or equality predicate on the second key column but
+  // none on the first, look up the ranges of rows which may satisfy it for
+  // each distinct value of the first key column in the key index, so that the
+  // rows in between are skipped. Gives up if the first key column has more
+  // than --cfile_skip_scan_max_prefixes distinct values within the bounds.
+  // The predicate is left in the spec.
+  Status PushdownSkipScanPredicate(const ScanSpec& spec);
+
+  // Seeks the key iterator to the first row whose encoded key is at or after
+  // 'encoded_key', setting '*idx' to its index, or to 'row_count_' if there
+  // is no such row.
+  Status SeekKeyIndex(faststring* encoded_key, rowid_t* idx);
+
   void Unprepare();
 
   // Prepare the given column. The column must not have been prepared yet.
   Status PrepareColumn(ColumnMaterializationContext *ctx);
 
+  // Reads the data blocks of the prepared batch into the block cache,
+  // reading the blocks of different columns concurrently using 'read_pool_'.
+  // Columns whose blocks for the batch were already read are skipped.
+  void ReadColumnsAhead();
+
   const std::shared_ptr<CFileSet const> base_data_;
   const Schema* projection_;
 
@@ -267,8 +383,35 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   rowid_t lower_bound_idx_;
   rowid_t upper_bound_idx_;
 
+  // The IDs of the columns whose secondary indexes may be used.
+  std::vector<ColumnId> indexed_col_ids_;
+
+  // If set, the sorted indexes of the only rows within the bounds which may
+  // satisfy the predicates, as looked up in secondary indexes.
+  bool has_index_matches_ = false;
+  std::vector<rowid_t> index_matches_;
+
+  // If not empty, the sorted, disjoint ranges [first, second) of the only
+  // rows within the bounds which may satisfy the predicates, as looked up by
+  // PushdownKeyRanges() or PushdownSkipScanPredicate(). The rows in between
+  // are skipped.
+  std::vector<std::pair<rowid_t, rowid_t>> skip_scan_ranges_;
+  // The index in 'skip_scan_ranges_' of the range being iterated.
+  size_t skip_scan_range_idx_ = 0;
+
   const fs::IOContext* io_context_;
 
+  // If set, the pool used to read columns concurrently.
+  ThreadPool* read_pool_;
+
+  // For each of 'col_iters_', the CFileIterator reading the column, or nullptr
+  // if the column has no data in this CFileSet.
+  std::vector<cfile::CFileIterator*> cfile_iters_;
+
+  // For each of 'col_iters_', the exclusive upper bound of the rows whose data
+  // blocks ReadColumnsAhead() has read.
+  std::vector<int64_t> read_ahead_end_idx_;
+
   // The underlying columns are prepared lazily, so that if a column is never
   // materialized, it doesn't need to be read off disk.
   //
@@ -0,0 +1,363 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks the maintenance operations of a tablet: flushes of the
+// MemRowSet and of the DeltaMemStores, minor and major delta compactions,
+// merge compactions of rowsets and the GC of ancient UNDO deltas.
+//
+// The tablet is built with a controlled number of rowsets, overlap of their
+// key ranges, density of updates and width of the schema. For every phase,
+// the wall and CPU time, the throughput of the block I/O and the write
+// amplification (the bytes written to blocks so far over the bytes of data
+// written to the tablet) are logged, and may be appended to a file as one
+// JSON object per line with --compaction_bench_results_file.
+
+#include <cinttypes>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/clock/hybrid_clock.h"
+#include "kudu/clock/mock_ntp.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/casts.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/walltime.h"
+#include "kudu/tablet/local_tablet_writer.h"
+#include "kudu/tablet/rowset.h"
+#include "kudu/tablet/tablet-harness.h"
+#include "kudu/tablet/tablet-test-util.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/util/jsonwriter.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DEFINE_int32(compaction_bench_num_rowsets, 10,
+             "Number of rowsets to flush");
+DEFINE_int32(compaction_bench_rows_per_rowset, 100000,
+             "Number of rows inserted into each rowset");
+DEFINE_double(compaction_bench_overlap, 0.5,
+              "Fraction of the rows of each rowset whose keys are interleaved "
+              "with the keys of all the other rowsets. The keys of the "
+              "remaining rows are in a range disjoint from the other rowsets");
+DEFINE_double(compaction_bench_update_fraction, 0.2,
+              "Fraction of the rows updated before each flush of the "
+              "DeltaMemStores");
+DEFINE_int32(compaction_bench_delta_files, 4,
+             "Number of REDO delta files flushed for each rowset");
+DEFINE_int32(compaction_bench_num_columns, 10,
+             "Number of columns of the schema, including the INT64 key column. "
+             "The other columns alternate between INT32 and STRING");
+DEFINE_string(compaction_bench_results_file, "",
+              "If set, the results are appended to this file as one JSON "
+              "object per line");
+
+DECLARE_double(tablet_delta_store_major_compact_min_ratio);
+DECLARE_int32(tablet_history_max_age_sec);
+DECLARE_string(time_source);
+
+METRIC_DECLARE_counter(block_manager_total_bytes_read);
+METRIC_DECLARE_counter(block_manager_total_bytes_written);
+
+using kudu::clock::HybridClock;
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+namespace {
+
+// Length of the values of the STRING columns.
+const int kStringLength = 16;
+
+Schema CreateBenchSchema() {
+  CHECK_GE(FLAGS_compaction_bench_num_columns, 2);
+  vector<ColumnSchema> cols = { ColumnSchema("key", INT64) };
+  for (int i = 1; i < FLAGS_compaction_bench_num_columns; i++) {
+    cols.emplace_back(Substitute("c$0", i), i % 2 == 1 ? INT32 : STRING);
+  }
+  return Schema(cols, 1);
+}
+
+// Returns the number of bytes of data of the column at 'col_idx' in the
+// bench schema.
+int64_t ColumnSize(int col_idx) {
+  if (col_idx == 0) {
+    return sizeof(int64_t);
+  }
+  return col_idx % 2 == 1 ? sizeof(int32_t) : kStringLength;
+}
+
+} // anonymous namespace
+
+class CompactionBench : public KuduTabletTest {
+ public:
+  CompactionBench()
+      : KuduTabletTest(CreateBenchSchema(), TabletHarness::Options::HYBRID_CLOCK),
+        rng_(SeedRandom()),
+        mock_time_micros_(0),
+        logical_bytes_written_(0) {
+    FLAGS_time_source = "mock";
+    // Major compact every rowset with updates, however few.
+    FLAGS_tablet_delta_store_major_compact_min_ratio = 0;
+  }
+
+  void SetUp() override {
+    NO_FATALS(KuduTabletTest::SetUp());
+    // The mock clock starts at 0, which would make the ancient history mark
+    // negative.
+    SetMockTime(GetCurrentTimeMicros());
+    bytes_written_ = METRIC_block_manager_total_bytes_written.Instantiate(
+        harness()->metric_entity());
+    bytes_read_ = METRIC_block_manager_total_bytes_read.Instantiate(
+        harness()->metric_entity());
+  }
+
+ protected:
+  // The resource usage of a phase of the benchmark.
+  struct PhaseStats {
+    PhaseStats() : sw(Stopwatch::ALL_THREADS), bytes_written(0), bytes_read(0) {}
+
+    Stopwatch sw;
+    int64_t bytes_written;
+    int64_t bytes_read;
+  };
+
+  void SetMockTime(int64_t micros) {
+    auto* hybrid_clock = down_cast<HybridClock*>(clock());
+    auto* ntp = down_cast<clock::MockNtp*>(hybrid_clock->time_service());
+    ntp->SetMockClockWallTimeForTests(micros);
+    mock_time_micros_ = micros;
+  }
+
+  // Returns the key of the 'row_idx'th row of the 'rowset_idx'th rowset.
+  //
+  // The first rows of every rowset, in proportion of --compaction_bench_overlap,
+  // have keys interleaved with those of the other rowsets; the others have
+  // keys past all the interleaved keys, in a range of their own.
+  static int64_t RowKey(int rowset_idx, int row_idx) {
+    const int64_t num_rowsets = FLAGS_compaction_bench_num_rowsets;
+    const int64_t rows_per_rowset = FLAGS_compaction_bench_rows_per_rowset;
+    const int64_t overlapping_rows = static_cast<int64_t>(
+        rows_per_rowset * FLAGS_compaction_bench_overlap);
+    if (row_idx < overlapping_rows) {
+      return row_idx * num_rowsets + rowset_idx;
+    }
+    return overlapping_rows * num_rowsets +
+        rowset_idx * (rows_per_rowset - overlapping_rows) +
+        (row_idx - overlapping_rows);
+  }
+
+  void SetColumn(int col_idx, int64_t val, KuduPartialRow* row) {
+    if (col_idx % 2 == 1) {
+      CHECK_OK(row->SetInt32(col_idx, static_cast<int32_t>(val)));
+    } else {
+      CHECK_OK(row->SetStringCopy(col_idx, StringPrintf("%016" PRIx64, val)));
+    }
+    logical_bytes_written_ += ColumnSize(col_idx);
+  }
+
+  void StartPhase(PhaseStats* stats) {
+    stats->bytes_written -= bytes_written_->value();
+    stats->bytes_read -= bytes_read_->value();
+    stats->sw.resume();
+  }
+
+  void StopPhase(PhaseStats* stats) {
+    stats->sw.stop();
+    stats->bytes_written += bytes_written_->value();
+    stats->bytes_read += bytes_read_->value();
+  }
+
+  // Inserts the rows of each rowset, flushing the MemRowSet after each.
+  void FlushRowSets() {
+    PhaseStats stats;
+    LocalTabletWriter writer(tablet().get(), &client_schema());
+    KuduPartialRow row(&client_schema());
+    for (int i = 0; i < FLAGS_compaction_bench_num_rowsets; i++) {
+      for (int j = 0; j < FLAGS_compaction_bench_rows_per_rowset; j++) {
+        ASSERT_OK(row.SetInt64(0, RowKey(i, j)));
+        logical_bytes_written_ += ColumnSize(0);
+        for (int c = 1; c < FLAGS_compaction_bench_num_columns; c++) {
+          SetColumn(c, rng_.Next64(), &row);
+        }
+        ASSERT_OK_FAST(writer.Insert(row));
+      }
+      StartPhase(&stats);
+      ASSERT_OK(tablet()->Flush());
+      StopPhase(&stats);
+    }
+    NO_FATALS(ReportPhase("flush", stats));
+  }
+
+  // Updates a random column of a random fraction of the rows before every
+  // flush of the DeltaMemStores.
+  void FlushDeltas() {
+    PhaseStats stats;
+    LocalTabletWriter writer(tablet().get(), &client_schema());
+    for (int d = 0; d < FLAGS_compaction_bench_delta_files; d++) {
+      for (int i = 0; i < FLAGS_compaction_bench_num_rowsets; i++) {
+        for (int j = 0; j < FLAGS_compaction_bench_rows_per_rowset; j++) {
+          if (rng_.NextDoubleFraction() >= FLAGS_compaction_bench_update_fraction) {
+            continue;
+          }
+          KuduPartialRow row(&client_schema());
+          ASSERT_OK(row.SetInt64(0, RowKey(i, j)));
+          logical_bytes_written_ += ColumnSize(0);
+          SetColumn(1 + rng_.Uniform(FLAGS_compaction_bench_num_columns - 1),
+                    rng_.Next64(), &row);
+          ASSERT_OK_FAST(writer.Update(row));
+        }
+      }
+      StartPhase(&stats);
+      ASSERT_OK(tablet()->FlushAllDMSForTests());
+      StopPhase(&stats);
+    }
+    NO_FATALS(ReportPhase("delta_flush", stats));
+  }
+
+  // Delta compacts the rowsets until none would benefit from it.
+  void CompactDeltas(RowSet::DeltaCompactionType type, const string& phase) {
+    PhaseStats stats;
+    StartPhase(&stats);
+    while (tablet()->GetPerfImprovementForBestDeltaCompact(type, nullptr) > 0) {
+      ASSERT_OK(tablet()->CompactWorstDeltas(type));
+    }
+    StopPhase(&stats);
+    NO_FATALS(ReportPhase(phase, stats));
+  }
+
+  void MergeCompact() {
+    PhaseStats stats;
+    StartPhase(&stats);
+    ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+    StopPhase(&stats);
+    NO_FATALS(ReportPhase("merge_compaction", stats));
+  }
+
+  // Makes all the history ancient, and deletes the UNDO deltas like the
+  // UndoDeltaBlockGCOp maintenance operation does.
+  void GcUndoDeltas() {
+    SetMockTime(mock_time_micros_ +
+                (FLAGS_tablet_history_max_age_sec + 1) * MonoTime::kMicrosecondsPerSecond);
+    PhaseStats stats;
+    StartPhase(&stats);
+    int64_t bytes_in_ancient_undos = 0;
+    ASSERT_OK(tablet()->InitAncientUndoDeltas(MonoDelta(), &bytes_in_ancient_undos));
+    int64_t blocks_deleted = 0;
+    int64_t bytes_deleted = 0;
+    ASSERT_OK(tablet()->DeleteAncientUndoDeltas(&blocks_deleted, &bytes_deleted));
+    StopPhase(&stats);
+    LOG(INFO) << Substitute("undo_gc: deleted $0 blocks ($1 bytes)",
+                            blocks_deleted, bytes_deleted);
+    NO_FATALS(ReportPhase("undo_gc", stats));
+  }
+
+  void ReportPhase(const string& phase, const PhaseStats& stats) {
+    const CpuTimes times = stats.sw.elapsed();
+    const double wall_seconds = times.wall_seconds();
+    const double write_mbps = wall_seconds > 0 ? stats.bytes_written / 1e6 / wall_seconds : 0;
+    const double read_mbps = wall_seconds > 0 ? stats.bytes_read / 1e6 / wall_seconds : 0;
+    const double write_amplification = logical_bytes_written_ > 0 ?
+        static_cast<double>(bytes_written_->value()) / logical_bytes_written_ : 0;
+    LOG(INFO) << Substitute(
+        "$0: $1, written $2 MB ($3 MB/s), read $4 MB ($5 MB/s), "
+        "write amplification $6, $7 rowsets, $8 MB on disk",
+        phase, times.ToString(),
+        StringPrintf("%.1f", stats.bytes_written / 1e6), StringPrintf("%.1f", write_mbps),
+        StringPrintf("%.1f", stats.bytes_read / 1e6), StringPrintf("%.1f", read_mbps),
+        StringPrintf("%.2f", write_amplification), tablet()->num_rowsets(),
+        StringPrintf("%.1f", tablet()->OnDiskDataSize() / 1e6));
+
+    if (FLAGS_compaction_bench_results_file.empty()) {
+      return;
+    }
+    std::ostringstream json;
+    JsonWriter jw(&json, JsonWriter::COMPACT);
+    jw.StartObject();
+    jw.String("phase");
+    jw.String(phase);
+    jw.String("num_rowsets");
+    jw.Int(FLAGS_compaction_bench_num_rowsets);
+    jw.String("rows_per_rowset");
+    jw.Int(FLAGS_compaction_bench_rows_per_rowset);
+    jw.String("overlap");
+    jw.Double(FLAGS_compaction_bench_overlap);
+    jw.String("update_fraction");
+    jw.Double(FLAGS_compaction_bench_update_fraction);
+    jw.String("delta_files");
+    jw.Int(FLAGS_compaction_bench_delta_files);
+    jw.String("num_columns");
+    jw.Int(FLAGS_compaction_bench_num_columns);
+    jw.String("wall_seconds");
+    jw.Double(wall_seconds);
+    jw.String("user_cpu_seconds");
+    jw.Double(times.user_cpu_seconds());
+    jw.String("system_cpu_seconds");
+    jw.Double(times.system_cpu_seconds());
+    jw.String("bytes_written");
+    jw.Int64(stats.bytes_written);
+    jw.String("bytes_read");
+    jw.Int64(stats.bytes_read);
+    jw.String("write_mb_per_sec");
+    jw.Double(write_mbps);
+    jw.String("read_mb_per_sec");
+    jw.Double(read_mbps);
+    jw.String("write_amplification");
+    jw.Double(write_amplification);
+    jw.EndObject();
+    std::ofstream out(FLAGS_compaction_bench_results_file, std::ios::app);
+    out << json.str() << std::endl;
+    ASSERT_TRUE(out.good()) << "unable to write to " << FLAGS_compaction_bench_results_file;
+  }
+
+  Random rng_;
+  int64_t mock_time_micros_;
+  // The bytes of data inserted into and updated in the tablet.
+  int64_t logical_bytes_written_;
+  scoped_refptr<Counter> bytes_written_;
+  scoped_refptr<Counter> bytes_read_;
+};
+
+TEST_F(CompactionBench, AllPhases) {
+  NO_FATALS(FlushRowSets());
+  NO_FATALS(FlushDeltas());
+  NO_FATALS(CompactDeltas(RowSet::MINOR_DELTA_COMPACTION, "minor_delta_compaction"));
+  NO_FATALS(CompactDeltas(RowSet::MAJOR_DELTA_COMPACTION, "major_delta_compaction"));
+  NO_FATALS(MergeCompact());
+  NO_FATALS(GcUndoDeltas());
+}
+
+} // namespace tablet
+} // namespace kudu
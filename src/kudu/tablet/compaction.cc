@@ -120,17 +120,19 @@ class MemRowSetCompactionInput : public CompactionInput {
 
     arena_.Reset();
     RowChangeListEncoder undo_encoder(&buffer_);
+    const bool columnar = iter_->is_columnar();
+    ordinals_.clear();
+    row_datas_.clear();
     int next_row_index = 0;
     for (int i = 0; i < num_in_block; ++i) {
       // TODO(todd): A copy is performed to make all CompactionInputRow have the same schema
       CompactionInputRow& input_row = block->at(next_row_index);
       input_row.row.Reset(row_block_.get(), next_row_index);
       Timestamp insertion_timestamp;
-      RETURN_NOT_OK(iter_->GetCurrentRow(&input_row.row,
-                                         static_cast<Arena*>(nullptr),
-                                         &input_row.redo_head,
-                                         &arena_,
-                                         &insertion_timestamp));
+      // The cells of the rows are copied a column at a time below.
+      RETURN_NOT_OK(iter_->GetCurrentRowMutations(&input_row.redo_head,
+                                                  &arena_,
+                                                  &insertion_timestamp));
 
       // Handle the rare case where a row was inserted and deleted in the same operation.
       // This row can never be observed and should not be compacted/flushed. This saves
@@ -155,10 +157,27 @@ class MemRowSetCompactionInput : public CompactionInput {
                                                     insertion_timestamp,
                                                     undo_encoder.as_changelist());
       undo_encoder.Reset();
+      if (columnar) {
+        ordinals_.push_back(iter_->current_row_ordinal());
+      } else {
+        row_datas_.push_back(iter_->GetCurrentRow().row_data());
+      }
       ++next_row_index;
       iter_->Next();
     }
 
+    if (columnar) {
+      RETURN_NOT_OK(iter_->ProjectColumnarRows(ordinals_.data(),
+                                               ordinals_.size(),
+                                               row_block_.get(),
+                                               static_cast<Arena*>(nullptr)));
+    } else {
+      RETURN_NOT_OK(iter_->ProjectRowwiseRows(row_datas_.data(),
+                                              row_datas_.size(),
+                                              row_block_.get(),
+                                              static_cast<Arena*>(nullptr)));
+    }
+
     if (PREDICT_FALSE(next_row_index < num_in_block)) {
       block->resize(next_row_index);
     }
@@ -188,6 +207,14 @@ class MemRowSetCompactionInput : public CompactionInput {
 
   faststring buffer_;
 
+  // The column store ordinals of the rows of the current block, if the
+  // memrowset is columnar.
+  vector<uint32_t> ordinals_;
+
+  // The data of the rows of the current block, if the memrowset isn't
+  // columnar.
+  vector<const uint8_t*> row_datas_;
+
   bool has_more_blocks_;
 };
 
@@ -1117,6 +1144,13 @@ Status FlushCompactionInput(CompactionInput* input,
       DCHECK_SCHEMA_EQ(*schema, out->schema());
       DCHECK(schema->has_column_ids());
 
+      // Expired rows are dropped along with their history, whether they're
+      // live or not. ReupdateMissedDeltas() skips them the same way.
+      if (history_gc_opts.row_expiry().IsExpired(input_row->row)) {
+        DVLOG(4) << "Dropping expired row: " << CompactionInputRowToString(*input_row);
+        continue;
+      }
+
       RowBlockRow dst_row = block.row(n);
       RETURN_NOT_OK(CopyRow(input_row->row, &dst_row, static_cast<Arena*>(nullptr)));
 
@@ -1231,6 +1265,14 @@ Status ReupdateMissedDeltas(const IOContext* io_context,
     for (const CompactionInputRow &row : rows) {
       DVLOG(4) << "Revisiting row: " << CompactionInputRowToString(row);
 
+      // Expired rows weren't written to the output rowsets, and there is no
+      // point in reupdating them.
+      if (history_gc_opts.row_expiry().IsExpired(row.row)) {
+        DVLOG(4) << "Skipping expired input row: " << schema->DebugRow(row.row)
+                 << " while reupdating missed deltas";
+        continue;
+      }
+
       bool is_garbage_collected = false;
       for (const Mutation *mut = row.redo_head;
            mut != nullptr;
@@ -76,10 +76,24 @@ class HistoryGcOpts {
     return ancient_history_mark_;
   }
 
+  // Returns a copy of these options which also garbage-collects the rows
+  // expired according to 'row_expiry', along with their history.
+  HistoryGcOpts WithRowExpiry(RowExpiry row_expiry) const {
+    return HistoryGcOpts(gc_enabled_, ancient_history_mark_, row_expiry);
+  }
+
+  // Returns the expiry of rows to garbage-collect, which may be disabled
+  // independently of the GC of history.
+  const RowExpiry& row_expiry() const {
+    return row_expiry_;
+  }
+
  private:
-  HistoryGcOpts(bool gc_enabled, Timestamp ahm)
+  HistoryGcOpts(bool gc_enabled, Timestamp ahm,
+                RowExpiry row_expiry = RowExpiry::Disabled())
       : gc_enabled_(gc_enabled),
-        ancient_history_mark_(ahm) {
+        ancient_history_mark_(ahm),
+        row_expiry_(row_expiry) {
   }
 
   // Whether historical records prior to the ancient history mark should be
@@ -89,6 +103,9 @@ class HistoryGcOpts {
   // A timestamp prior to which no history will be preserved.
   // Ignored if 'enabled' != GC_ENABLED.
   const Timestamp ancient_history_mark_;
+
+  // Rows which are expired according to this are dropped.
+  const RowExpiry row_expiry_;
 };
 
 // Interface for an input feeding into a compaction or flush.
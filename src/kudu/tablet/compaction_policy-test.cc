@@ -31,6 +31,7 @@
 #include <glog/stl_logging.h>
 #include <gtest/gtest.h>
 
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/split.h"
@@ -53,6 +54,7 @@ using std::vector;
 DECLARE_double(compaction_minimum_improvement);
 DECLARE_double(compaction_small_rowset_tradeoff);
 DECLARE_int64(budgeted_compaction_target_rowset_size);
+DECLARE_double(tiered_compaction_max_write_amplification);
 
 namespace kudu {
 namespace tablet {
@@ -635,5 +637,51 @@ TEST_F(TestCompactionPolicy, TestKUDU2704) {
   ASSERT_EQ(2, picked.size());
   ASSERT_GT(quality, 0.0);
 }
+
+// The tiered policy should merge the longest run of small rowsets which are
+// adjacent in key order, even though they don't overlap, and respect the
+// write amplification budget.
+TEST_F(TestCompactionPolicy, TestTieredSelection) {
+  constexpr uint64_t kMiB = 1024 * 1024;
+  /* NB: Zero-padding of string keys omitted to save space.
+   *
+   * [0 ---- 1] [2 - 3] [4 - 5] [6 ---- 7] [8 - 9] ... [24 - 25]
+   *   64MiB     1MiB    1MiB    64MiB      1MiB        1MiB
+   */
+  RowSetVector rowsets;
+  for (auto i = 0; i < 13; i++) {
+    const bool large = i == 0 || i == 3;
+    rowsets.emplace_back(new MockDiskRowSet(StringPrintf("%010d", i * 2),
+                                            StringPrintf("%010d", i * 2 + 1),
+                                            large ? 64 * kMiB : kMiB));
+  }
+  RowSetTree tree;
+  ASSERT_OK(tree.Reset(rowsets));
+
+  TieredCompactionPolicy policy(128);
+  CompactionSelection picked;
+  double quality = 0.0;
+  ASSERT_OK(policy.PickRowSets(tree, &picked, &quality, /*log=*/nullptr));
+  // The nine small rowsets after the second large one are merged into a
+  // single one.
+  ASSERT_EQ(9, picked.size());
+  for (auto i = 4; i < 13; i++) {
+    ASSERT_TRUE(ContainsKey(picked, rowsets[i].get()));
+  }
+  ASSERT_DOUBLE_EQ(8.0 / 13, quality);
+
+  // Once the compactions have rewritten as much as the budget allows, no
+  // rowsets are picked until more data is flushed.
+  FLAGS_tiered_compaction_max_write_amplification = 2.0;
+  policy.RecordCompaction(131 * kMiB);
+  picked.clear();
+  ASSERT_OK(policy.PickRowSets(tree, &picked, &quality, /*log=*/nullptr));
+  ASSERT_TRUE(picked.empty());
+  ASSERT_EQ(0.0, quality);
+
+  policy.RecordFlush(256 * kMiB);
+  ASSERT_OK(policy.PickRowSets(tree, &picked, &quality, /*log=*/nullptr));
+  ASSERT_EQ(9, picked.size());
+}
 } // namespace tablet
 } // namespace kudu
@@ -30,6 +30,7 @@
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_info.h"
 #include "kudu/tablet/svg_dump.h"
 #include "kudu/util/flag_tags.h"
@@ -58,6 +59,34 @@ DEFINE_double(compaction_minimum_improvement, 0.01f,
               "compaction will be considered ineligible.");
 TAG_FLAG(compaction_minimum_improvement, advanced);
 
+DEFINE_int64(tiered_compaction_target_rowset_size, 32 * 1024 * 1024,
+             "The target size in bytes for DiskRowSets produced by flushes or "
+             "compactions when the tiered compaction policy is used. Rowsets of "
+             "this size or larger are not compacted any further.");
+TAG_FLAG(tiered_compaction_target_rowset_size, advanced);
+TAG_FLAG(tiered_compaction_target_rowset_size, experimental);
+
+DEFINE_int32(tiered_compaction_fanout, 4,
+             "Ratio between the sizes of rowsets of consecutive tiers of the tiered "
+             "compaction policy. Must be at least 2.");
+TAG_FLAG(tiered_compaction_fanout, advanced);
+TAG_FLAG(tiered_compaction_fanout, experimental);
+
+DEFINE_int32(tiered_compaction_min_rowsets, 4,
+             "Minimum number of rowsets, adjacent in key order, that the tiered "
+             "compaction policy merges at once.");
+TAG_FLAG(tiered_compaction_min_rowsets, advanced);
+TAG_FLAG(tiered_compaction_min_rowsets, experimental);
+
+DEFINE_double(tiered_compaction_max_write_amplification, 10.0,
+              "Maximum write amplification of a tablet using the tiered compaction "
+              "policy: the ratio of the bytes written by flushes and compactions to "
+              "the bytes of data flushed. Compactions which would exceed it are "
+              "deferred until more data is flushed. 0 disables the limit.");
+TAG_FLAG(tiered_compaction_max_write_amplification, advanced);
+TAG_FLAG(tiered_compaction_max_write_amplification, experimental);
+TAG_FLAG(tiered_compaction_max_write_amplification, runtime);
+
 namespace kudu {
 namespace tablet {
 
@@ -513,5 +542,143 @@ Status BudgetedCompactionPolicy::PickRowSets(
   return Status::OK();
 }
 
+TieredCompactionPolicy::TieredCompactionPolicy(int size_budget_mb)
+    : size_budget_bytes_(static_cast<uint64_t>(size_budget_mb) * 1024 * 1024),
+      bytes_flushed_(0),
+      bytes_rewritten_(0) {
+  CHECK_GT(size_budget_mb, 0);
+}
+
+uint64_t TieredCompactionPolicy::target_rowset_size() const {
+  CHECK_GT(FLAGS_tiered_compaction_target_rowset_size, 0);
+  return FLAGS_tiered_compaction_target_rowset_size;
+}
+
+int TieredCompactionPolicy::Tier(uint64_t size_bytes) const {
+  if (size_bytes >= target_rowset_size()) {
+    return -1;
+  }
+  const uint64_t fanout = std::max(FLAGS_tiered_compaction_fanout, 2);
+  int tier = 0;
+  for (uint64_t bound = fanout * 1024 * 1024; size_bytes >= bound; bound *= fanout) {
+    tier++;
+  }
+  return tier;
+}
+
+Status TieredCompactionPolicy::PickRowSets(
+    const RowSetTree& tree,
+    CompactionSelection* picked,
+    double* quality,
+    std::vector<std::string>* log) {
+  DCHECK(picked);
+  DCHECK(quality);
+  *quality = 0.0;
+
+  // Rowsets which are unavailable for compaction are kept in the key order:
+  // they break the runs of rowsets which may be merged together.
+  vector<RowSetInfo> candidates;
+  RowSetInfo::Collect(tree, &candidates);
+  vector<const RowSetInfo*> infos;
+  infos.reserve(candidates.size());
+  for (const RowSetInfo& rsi : candidates) {
+    if (rsi.has_bounds()) {
+      infos.push_back(&rsi);
+    }
+  }
+  std::sort(infos.begin(), infos.end(),
+            [](const RowSetInfo* a, const RowSetInfo* b) { return a->min_key() < b->min_key(); });
+
+  uint64_t tablet_bytes = 0;
+  int max_tier = -1;
+  vector<int> tiers;
+  tiers.reserve(infos.size());
+  for (const RowSetInfo* rsi : infos) {
+    tablet_bytes += rsi->size_bytes();
+    tiers.push_back(rsi->rowset()->IsAvailableForCompaction() ? Tier(rsi->size_bytes()) : -1);
+    max_tier = std::max(max_tier, tiers.back());
+  }
+
+  // The best run found so far: infos[best_start, best_end), the number of
+  // rowsets a compaction of the run retires, and its size.
+  size_t best_start = 0;
+  size_t best_end = 0;
+  int64_t best_retired = 0;
+  uint64_t best_bytes = 0;
+  const size_t min_rowsets = std::max(FLAGS_tiered_compaction_min_rowsets, 2);
+  const uint64_t target_size = target_rowset_size();
+  for (int tier = 0; tier <= max_tier && best_end == 0; tier++) {
+    size_t start = 0;
+    uint64_t run_bytes = 0;
+    for (size_t i = 0; i <= infos.size(); i++) {
+      const bool in_run = i < infos.size() && tiers[i] >= 0 && tiers[i] <= tier;
+      if (in_run && (i == start || run_bytes + infos[i]->size_bytes() <= size_budget_bytes_)) {
+        run_bytes += infos[i]->size_bytes();
+        continue;
+      }
+      // The run [start, i) ends here.
+      if (i - start >= min_rowsets) {
+        const int64_t outputs = (run_bytes + target_size - 1) / target_size;
+        const int64_t retired = static_cast<int64_t>(i - start) - std::max<int64_t>(outputs, 1);
+        if (retired > best_retired || (retired == best_retired && run_bytes < best_bytes)) {
+          best_start = start;
+          best_end = i;
+          best_retired = retired;
+          best_bytes = run_bytes;
+        }
+      }
+      start = in_run ? i : i + 1;
+      run_bytes = in_run ? infos[i]->size_bytes() : 0;
+    }
+  }
+
+  if (best_retired <= 0) {
+    if (log) {
+      LOG_STRING(INFO, log) << "No run of small rowsets to compact";
+    }
+    return Status::OK();
+  }
+
+  const double max_write_amp = FLAGS_tiered_compaction_max_write_amplification;
+  const uint64_t bytes_flushed = std::max<uint64_t>(bytes_flushed_, tablet_bytes);
+  const uint64_t bytes_rewritten = bytes_rewritten_;
+  if (max_write_amp > 0 &&
+      bytes_flushed + bytes_rewritten + best_bytes > max_write_amp * bytes_flushed) {
+    VLOG(1) << Substitute("Compacting $0 bytes would exceed the write amplification "
+                          "budget ($1 bytes flushed, $2 bytes rewritten): not compacting.",
+                          best_bytes, bytes_flushed, bytes_rewritten);
+    if (log) {
+      LOG_STRING(INFO, log) << "Write amplification budget exhausted";
+    }
+    return Status::OK();
+  }
+
+  // The quality is the fraction of the rowsets of the tablet retired.
+  const double value = static_cast<double>(best_retired) / infos.size();
+  if (VLOG_IS_ON(1) || log != nullptr) {
+    LOG_STRING(INFO, log) << "Tiered compaction selection:";
+    for (size_t i = 0; i < infos.size(); i++) {
+      const char* checkbox = (i >= best_start && i < best_end) ? "[x]" : "[ ]";
+      LOG_STRING(INFO, log) << "  " << checkbox << " tier " << tiers[i]
+                            << " " << infos[i]->ToString();
+    }
+    LOG_STRING(INFO, log) << Substitute("Solution value: $0 ($1 bytes flushed, "
+                                        "$2 bytes rewritten)",
+                                        value, bytes_flushed, bytes_rewritten);
+  }
+  if (value <= FLAGS_compaction_minimum_improvement) {
+    VLOG(1) << Substitute("The best compaction score found ($0) is less than "
+                          "the threshold for compaction ($1): not compacting.",
+                          value, FLAGS_compaction_minimum_improvement);
+    return Status::OK();
+  }
+
+  *quality = value;
+  for (size_t i = best_start; i < best_end; i++) {
+    picked->insert(infos[i]->rowset());
+  }
+  return Status::OK();
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -17,6 +17,7 @@
 #ifndef KUDU_TABLET_COMPACTION_POLICY_H
 #define KUDU_TABLET_COMPACTION_POLICY_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -66,6 +67,14 @@ class CompactionPolicy {
   // whereas others may prefer large ones.
   virtual uint64_t target_rowset_size() const = 0;
 
+  // Record that a flush of new data into DiskRowSets wrote 'bytes' bytes.
+  // May be called concurrently with any other method.
+  virtual void RecordFlush(uint64_t /*bytes*/) {}
+
+  // Record that a compaction rewrote existing data into 'bytes' bytes.
+  // May be called concurrently with any other method.
+  virtual void RecordCompaction(uint64_t /*bytes*/) {}
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CompactionPolicy);
 };
@@ -127,6 +136,52 @@ class BudgetedCompactionPolicy : public CompactionPolicy {
   const size_t size_budget_mb_;
 };
 
+// A compaction policy suited to append-mostly workloads, where new rowsets
+// rarely overlap the existing ones and the overlap-driven budgeted policy
+// barely compacts until it has to rewrite a lot of data at once.
+//
+// Rowsets smaller than the target rowset size are grouped into tiers of
+// similar size, by powers of --tiered_compaction_fanout. Starting from the
+// tier of the smallest, i.e. most recently flushed, rowsets, the policy looks
+// for a run of at least --tiered_compaction_min_rowsets rowsets of that tier
+// or below which are adjacent in key order, and merges them within the size
+// budget of a compaction. Each rowset is thus rewritten about once per tier
+// until it reaches the target size.
+//
+// The policy also keeps track of the bytes rewritten by compactions against
+// the bytes flushed, and stops picking rowsets once another compaction would
+// take the write amplification of the tablet beyond
+// --tiered_compaction_max_write_amplification.
+class TieredCompactionPolicy : public CompactionPolicy {
+ public:
+  explicit TieredCompactionPolicy(int size_budget_mb);
+
+  Status PickRowSets(const RowSetTree& tree,
+                     CompactionSelection* picked,
+                     double* quality,
+                     std::vector<std::string>* log) override;
+
+  uint64_t target_rowset_size() const override;
+
+  void RecordFlush(uint64_t bytes) override {
+    bytes_flushed_ += bytes;
+  }
+
+  void RecordCompaction(uint64_t bytes) override {
+    bytes_rewritten_ += bytes;
+  }
+
+ private:
+  // Return the tier of a rowset of 'size_bytes' bytes, or -1 if the rowset
+  // is at least as large as the target rowset size.
+  int Tier(uint64_t size_bytes) const;
+
+  const uint64_t size_budget_bytes_;
+
+  std::atomic<uint64_t> bytes_flushed_;
+  std::atomic<uint64_t> bytes_rewritten_;
+};
+
 } // namespace tablet
 } // namespace kudu
 #endif
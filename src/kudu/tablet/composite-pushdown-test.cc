@@ -39,6 +39,7 @@
 #include "kudu/tablet/local_tablet_writer.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/tablet.h"
+#include "kudu/util/auto_release_pool.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -407,5 +408,96 @@ TEST_F(CompositePushdownTest, TestPushdownPrefixInequality) {
               results.back());
   }
 }
+
+// Test predicates on the second key column with none on the first, which the
+// flushed rowset answers by skipping through the values of the first column.
+TEST_F(CompositePushdownTest, TestPushdownSecondColumnWithoutPrefix) {
+  int8_t month_6 = 6;
+  int8_t month_8 = 8;
+  {
+    // month >= 6 && month < 8
+    auto pred_month = ColumnPredicate::Range(schema_.column(1), &month_6, &month_8);
+    ScanSpec spec;
+    spec.AddPredicate(pred_month);
+    vector<string> results;
+    NO_FATALS(ScanTablet(&spec, &results, "Second column inequality"));
+    ASSERT_EQ(11 * 2 * 28 * 3, results.size());
+    EXPECT_EQ("(int16 year=2000, int8 month=6, int8 day=1, "
+              R"(string hostname="baz", string data="2000/06/01-baz"))",
+              results.front());
+    EXPECT_EQ("(int16 year=2010, int8 month=7, int8 day=28, "
+              R"(string hostname="foobar", string data="2010/07/28-foobar"))",
+              results.back());
+  }
+
+  // Update some of the matching rows in the flushed rowset, so that their
+  // deltas are applied to the ranges of rows the scan skips to.
+  LocalTabletWriter writer(tablet().get(), &client_schema_);
+  KuduPartialRow row(&client_schema_);
+  for (int8_t day = 1; day <= 28; day++) {
+    ASSERT_OK(row.SetInt16(0, 2002));
+    ASSERT_OK(row.SetInt8(1, month_6));
+    ASSERT_OK(row.SetInt8(2, day));
+    ASSERT_OK(row.SetStringCopy(3, kTestHostnames[0]));
+    ASSERT_OK(row.SetStringCopy(4, "updated"));
+    ASSERT_OK(writer.Update(row));
+  }
+  {
+    // month = 6
+    auto pred_month = ColumnPredicate::Equality(schema_.column(1), &month_6);
+    ScanSpec spec;
+    spec.AddPredicate(pred_month);
+    vector<string> results;
+    NO_FATALS(ScanTablet(&spec, &results, "Second column equality"));
+    ASSERT_EQ(11 * 28 * 3, results.size());
+    int num_updated = 0;
+    for (const string& result : results) {
+      ASSERT_STR_CONTAINS(result, "month=6,");
+      if (result.find(R"(data="updated")") != string::npos) {
+        ASSERT_STR_CONTAINS(result, "year=2002,");
+        num_updated++;
+      }
+    }
+    ASSERT_EQ(28, num_updated);
+  }
+}
+
+TEST_F(CompositePushdownTest, TestKeyRanges) {
+  // Returns the encoded key of the first row of the given month.
+  const auto month_start = [&](int16_t year, int8_t month) {
+    KuduPartialRow row(&client_schema_);
+    CHECK_OK(row.SetInt16(0, year));
+    CHECK_OK(row.SetInt8(1, month));
+    CHECK_OK(row.SetInt8(2, 1));
+    CHECK_OK(row.SetStringCopy(3, ""));
+    string encoded;
+    CHECK_OK(row.EncodeRowKey(&encoded));
+    return encoded;
+  };
+
+  // The ranges overlap, and one of them spans the flushed rowset and the
+  // memrowset.
+  Arena arena(1024);
+  AutoReleasePool pool;
+  ScanSpec spec;
+  ASSERT_OK(spec.SetKeyRanges(schema_, &arena, &pool, {
+      { month_start(2005, 6), month_start(2005, 7) },
+      { month_start(2001, 3), month_start(2001, 5) },
+      { month_start(2002, 12), month_start(2003, 2) },
+      { month_start(2001, 4), month_start(2001, 6) } }));
+  ASSERT_EQ(3, spec.key_ranges().size());
+  vector<string> results;
+  NO_FATALS(ScanTablet(&spec, &results, "Key ranges"));
+  ASSERT_EQ((3 + 2 + 1) * 28 * 3, results.size());
+  const vector<string> months = {
+      "2001/03", "2001/04", "2001/05", "2002/12", "2003/01", "2005/06" };
+  for (const string& result : results) {
+    SCOPED_TRACE(result);
+    ASSERT_TRUE(std::any_of(months.begin(), months.end(), [&](const string& month) {
+      return result.find("data=\"" + month) != string::npos;
+    }));
+  }
+}
+
 } // namespace tablet
 } // namespace kudu
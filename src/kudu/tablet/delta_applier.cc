@@ -26,6 +26,7 @@
 #include <glog/logging.h>
 
 #include "kudu/common/column_materialization_context.h"
+#include "kudu/common/iterator_stats.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/rowset.h"
@@ -50,7 +51,8 @@ DeltaApplier::DeltaApplier(RowIteratorOptions opts,
     : opts_(std::move(opts)),
       base_iter_(std::move(base_iter)),
       delta_iter_(std::move(delta_iter)),
-      first_prepare_(true) {}
+      first_prepare_(true),
+      next_idx_(0) {}
 
 DeltaApplier::~DeltaApplier() {
 }
@@ -85,14 +87,18 @@ bool DeltaApplier::HasNext() const {
 }
 
 Status DeltaApplier::PrepareBatch(size_t *nrows) {
+  RETURN_NOT_OK(base_iter_->PrepareBatch(nrows));
   // The initial seek is deferred from Init() into the first PrepareBatch()
   // because it requires a loaded delta file, and we don't want to require
-  // that at Init() time.
-  if (first_prepare_) {
-    RETURN_NOT_OK(delta_iter_->SeekToOrdinal(base_iter_->cur_ordinal_idx()));
+  // that at Init() time. The base iterator may also skip over rows which
+  // can't match the scan, in which case the delta iterator is moved along.
+  const rowid_t base_idx = base_iter_->cur_ordinal_idx();
+  if (first_prepare_ || base_idx != next_idx_) {
+    RETURN_NOT_OK(delta_iter_->SeekToOrdinal(base_idx));
     first_prepare_ = false;
   }
-  RETURN_NOT_OK(base_iter_->PrepareBatch(nrows));
+  next_idx_ = base_idx + *nrows;
+  SCOPED_SCAN_STAGE_TIMER(ScanStage::kDeltaApply);
   int prepare_flags = DeltaIterator::PREPARE_FOR_APPLY;
   if (opts_.snap_to_exclude) {
     // See InitializeSelectionVector() below.
@@ -116,6 +122,7 @@ Status DeltaApplier::InitializeSelectionVector(SelectionVector *sel_vec) {
   //
   // See delta_relevancy.h for more details.
   if (opts_.snap_to_exclude) {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kDeltaApply);
     SelectedDeltas deltas(sel_vec->nrows());
     RETURN_NOT_OK(delta_iter_->SelectDeltas(&deltas));
     VLOG(4) << "Final deltas:\n" << deltas.ToString();
@@ -124,6 +131,7 @@ Status DeltaApplier::InitializeSelectionVector(SelectionVector *sel_vec) {
     RETURN_NOT_OK(base_iter_->InitializeSelectionVector(sel_vec));
   }
   if (!opts_.include_deleted_rows) {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kDeltaApply);
     RETURN_NOT_OK(delta_iter_->ApplyDeletes(sel_vec));
   }
   return Status::OK();
@@ -135,7 +143,11 @@ Status DeltaApplier::MaterializeColumn(ColumnMaterializationContext *ctx) {
   if (delta_iter_->MayHaveDeltas()) {
     ctx->SetDecoderEvalNotSupported();
     RETURN_NOT_OK(base_iter_->MaterializeColumn(ctx));
-    RETURN_NOT_OK(delta_iter_->ApplyUpdates(ctx->col_idx(), ctx->block(), *ctx->sel()));
+    // There's nothing to update if every row was filtered out.
+    if (ctx->sel()->AnySelected()) {
+      SCOPED_SCAN_STAGE_TIMER(ScanStage::kDeltaApply);
+      RETURN_NOT_OK(delta_iter_->ApplyUpdates(ctx->col_idx(), ctx->block(), *ctx->sel()));
+    }
   } else {
     RETURN_NOT_OK(base_iter_->MaterializeColumn(ctx));
   }
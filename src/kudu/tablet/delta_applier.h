@@ -25,6 +25,7 @@
 #include <gtest/gtest_prod.h>
 
 #include "kudu/common/iterator.h"
+#include "kudu/common/rowid.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/tablet/cfile_set.h"
@@ -90,6 +91,10 @@ class DeltaApplier : public ColumnwiseIterator {
   std::unique_ptr<DeltaIterator> delta_iter_;
 
   bool first_prepare_;
+
+  // The index of the row following the last prepared batch, where the delta
+  // iterator is positioned.
+  rowid_t next_idx_;
 };
 
 } // namespace tablet
@@ -17,13 +17,16 @@
 
 #include "kudu/tablet/delta_compaction.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/generic_iterators.h"
@@ -49,9 +52,20 @@
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset_metadata.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
+DEFINE_int32(major_delta_compaction_threads, 1,
+             "Maximum number of threads compacting the columns of a major delta "
+             "compaction. If greater than 1, the columns are split into groups "
+             "compacted in parallel, each reading the deltas and writing its "
+             "columns and UNDO deltas on its own, which shortens the compactions "
+             "of wide rowsets updated on many columns. The size of the shared "
+             "thread pool is fixed when the first such compaction runs.");
+TAG_FLAG(major_delta_compaction_threads, experimental);
+
 using kudu::fs::BlockCreationTransaction;
 using kudu::fs::BlockManager;
 using kudu::fs::CreateBlockOptions;
@@ -69,13 +83,46 @@ namespace {
 
 const size_t kRowsPerBlock = 100; // Number of rows per block of columns
 
+// The pool shared by the compactions which compact their groups of columns in
+// parallel. The thread of each compaction compacts one of the groups.
+ThreadPool* MajorDeltaCompactionPool() {
+  static ThreadPool* pool = []() {
+    unique_ptr<ThreadPool> p;
+    CHECK_OK(ThreadPoolBuilder("major-delta-compaction")
+             .set_max_threads(std::max(1, FLAGS_major_delta_compaction_threads - 1))
+             .Build(&p));
+    return p.release();
+  }();
+  return pool;
+}
+
 } // anonymous namespace
 
+struct MajorDeltaCompaction::ColumnGroup {
+  // The column ids to compact.
+  vector<ColumnId> column_ids;
+
+  // The computed partial schema which includes only the columns of the group.
+  Schema partial_schema;
+
+  // The merged view of the deltas from included_stores_.
+  unique_ptr<DeltaIterator> delta_iter;
+
+  unique_ptr<MultiColumnWriter> base_data_writer;
+
+  // The following three may not be initialized if we don't need to write a delta file.
+  unique_ptr<DeltaFileWriter> undo_delta_writer;
+  BlockId undo_delta_block;
+  unique_ptr<DeltaStats> undo_stats;
+
+  size_t undo_delta_mutations_written = 0;
+};
+
 // TODO: can you major-delta-compact a new column after an alter table in order
 // to materialize it? should write a test for this.
 MajorDeltaCompaction::MajorDeltaCompaction(
     FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
-    unique_ptr<DeltaIterator> delta_iter,
+    vector<unique_ptr<DeltaIterator>> delta_iters,
     vector<shared_ptr<DeltaStore> > included_stores,
     vector<ColumnId> col_ids,
     HistoryGcOpts history_gc_opts,
@@ -86,12 +133,12 @@ MajorDeltaCompaction::MajorDeltaCompaction(
       history_gc_opts_(std::move(history_gc_opts)),
       base_data_(base_data),
       included_stores_(std::move(included_stores)),
-      delta_iter_(std::move(delta_iter)),
+      delta_iters_(std::move(delta_iters)),
       tablet_id_(std::move(tablet_id)),
       redo_delta_mutations_written_(0),
-      undo_delta_mutations_written_(0),
       state_(kInitialized) {
   CHECK(!column_ids_.empty());
+  CHECK(!delta_iters_.empty());
 }
 
 MajorDeltaCompaction::~MajorDeltaCompaction() {
@@ -111,10 +158,12 @@ string MajorDeltaCompaction::ColumnNamesToString() const {
   return JoinStrings(col_names, ", ");
 }
 
-Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
-  CHECK_EQ(state_, kInitialized);
-
-  unique_ptr<ColumnwiseIterator> old_base_data_cwise(base_data_->NewIterator(&partial_schema_,
+Status MajorDeltaCompaction::FlushColumnGroup(ColumnGroup* group,
+                                              bool write_redos,
+                                              const IOContext* io_context) {
+  const Schema& partial_schema = group->partial_schema;
+  DeltaIterator* delta_iter = group->delta_iter.get();
+  unique_ptr<ColumnwiseIterator> old_base_data_cwise(base_data_->NewIterator(&partial_schema,
                                                                              io_context));
   unique_ptr<RowwiseIterator> old_base_data_rwise(
       NewMaterializingIterator(std::move(old_base_data_cwise)));
@@ -123,17 +172,19 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
   spec.set_cache_blocks(false);
   RETURN_NOT_OK_PREPEND(
       old_base_data_rwise->Init(&spec),
-      "Unable to open iterator for specified columns (" + partial_schema_.ToString() + ")");
+      "Unable to open iterator for specified columns (" + partial_schema.ToString() + ")");
 
-  RETURN_NOT_OK(delta_iter_->Init(&spec));
-  RETURN_NOT_OK(delta_iter_->SeekToOrdinal(0));
+  RETURN_NOT_OK(delta_iter->Init(&spec));
+  RETURN_NOT_OK(delta_iter->SeekToOrdinal(0));
 
   Arena arena(32 * 1024);
-  RowBlock block(&partial_schema_, kRowsPerBlock, &arena);
+  RowBlock block(&partial_schema, kRowsPerBlock, &arena);
 
-  DVLOG(1) << "Applying deltas and rewriting columns (" << partial_schema_.ToString() << ")";
-  unique_ptr<DeltaStats> redo_stats(new DeltaStats);
-  unique_ptr<DeltaStats> undo_stats(new DeltaStats);
+  DVLOG(1) << "Applying deltas and rewriting columns (" << partial_schema.ToString() << ")";
+  if (write_redos) {
+    redo_stats_.reset(new DeltaStats);
+  }
+  group->undo_stats.reset(new DeltaStats);
   size_t nrows = 0;
   // We know that we're reading everything from disk so we're including all transactions.
   MvccSnapshot snap = MvccSnapshot::CreateSnapshotIncludingAllTransactions();
@@ -146,8 +197,8 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
 
     // 2) Fetch all the REDO mutations.
     vector<Mutation *> redo_mutation_block(kRowsPerBlock, static_cast<Mutation *>(nullptr));
-    RETURN_NOT_OK(delta_iter_->PrepareBatch(n, DeltaIterator::PREPARE_FOR_COLLECT));
-    RETURN_NOT_OK(delta_iter_->CollectMutations(&redo_mutation_block, block.arena()));
+    RETURN_NOT_OK(delta_iter->PrepareBatch(n, DeltaIterator::PREPARE_FOR_COLLECT));
+    RETURN_NOT_OK(delta_iter->CollectMutations(&redo_mutation_block, block.arena()));
 
     // 3) Write new UNDO mutations for the current block. The REDO mutations
     //    are written out in step 6.
@@ -193,26 +244,32 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
                << RowToString(dst_row, new_undos_head, new_redos_head);
 
       // We only create a new undo delta file if we need to.
-      if (new_undos_head != nullptr && !new_undo_delta_writer_) {
-        RETURN_NOT_OK(OpenUndoDeltaFileWriter());
+      if (new_undos_head != nullptr && !group->undo_delta_writer) {
+        RETURN_NOT_OK(OpenUndoDeltaFileWriter(group));
       }
       for (const Mutation *mut = new_undos_head; mut != nullptr; mut = mut->next()) {
         DeltaKey undo_key(nrows + dst_row.row_index(), mut->timestamp());
-        RETURN_NOT_OK(new_undo_delta_writer_->AppendDelta<UNDO>(undo_key, mut->changelist()));
-        undo_stats->UpdateStats(mut->timestamp(), mut->changelist());
-        undo_delta_mutations_written_++;
+        RETURN_NOT_OK(group->undo_delta_writer->AppendDelta<UNDO>(undo_key, mut->changelist()));
+        group->undo_stats->UpdateStats(mut->timestamp(), mut->changelist());
+        group->undo_delta_mutations_written++;
       }
     }
 
     // 4) Write the new base data.
-    RETURN_NOT_OK(base_data_writer_->AppendBlock(block));
+    RETURN_NOT_OK(group->base_data_writer->AppendBlock(block));
+    nrows += n;
+
+    // The REDO deltas are written back by a single group.
+    if (!write_redos) {
+      continue;
+    }
 
     // 5) Remove the columns that we've done our major REDO delta compaction on
     //    from this delta flush, except keep all the delete and reinsert
-    //    mutations.
+    //    mutations. These are the columns of every group.
     arena.Reset();
     vector<DeltaKeyAndUpdate> out;
-    RETURN_NOT_OK(delta_iter_->FilterColumnIdsAndCollectDeltas(column_ids_, &out, &arena));
+    RETURN_NOT_OK(delta_iter->FilterColumnIdsAndCollectDeltas(column_ids_, &out, &arena));
 
     // We only create a new redo delta file if we need to.
     if (!out.empty() && !new_redo_delta_writer_) {
@@ -227,48 +284,117 @@ Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
                << key_and_update.Stringify(DeltaType::REDO, base_schema_);
       RETURN_NOT_OK_PREPEND(new_redo_delta_writer_->AppendDelta<REDO>(key_and_update.key, update),
                             "Failed to append a delta");
-      WARN_NOT_OK(redo_stats->UpdateStats(key_and_update.key.timestamp(), update),
+      WARN_NOT_OK(redo_stats_->UpdateStats(key_and_update.key.timestamp(), update),
                   "Failed to update stats");
     }
     redo_delta_mutations_written_ += out.size();
-    nrows += n;
   }
 
+  DVLOG(1) << "Applied all outstanding deltas for columns "
+           << partial_schema.ToString()
+           << ", and wrote a total of "
+           << group->undo_delta_mutations_written
+           << " UNDO delta mutations.";
+  return Status::OK();
+}
+
+Status MajorDeltaCompaction::FlushRowSetAndDeltas(const IOContext* io_context) {
+  CHECK_EQ(state_, kInitialized);
+
+  // The first group is compacted by this thread, and the others by the pool.
+  vector<Status> group_statuses(groups_.size());
+  unique_ptr<ThreadPoolToken> pool_token;
+  if (groups_.size() > 1) {
+    pool_token = MajorDeltaCompactionPool()->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
+    for (int g = 1; g < groups_.size(); g++) {
+      Status s = pool_token->Submit([this, g, io_context, &group_statuses]() {
+        group_statuses[g] = FlushColumnGroup(groups_[g].get(), false, io_context);
+      });
+      if (PREDICT_FALSE(!s.ok())) {
+        pool_token->Wait();
+        return s.CloneAndPrepend("unable to submit the compaction of columns");
+      }
+    }
+  }
+  group_statuses[0] = FlushColumnGroup(groups_[0].get(), true, io_context);
+  if (pool_token) {
+    pool_token->Wait();
+  }
+  for (const auto& s : group_statuses) {
+    RETURN_NOT_OK(s);
+  }
+
+  // All the blocks of the groups are committed together.
   BlockManager* bm = fs_manager_->block_manager();
   unique_ptr<BlockCreationTransaction> transaction = bm->NewCreationTransaction();
-  RETURN_NOT_OK(base_data_writer_->FinishAndReleaseBlocks(transaction.get()));
+  size_t undo_delta_mutations_written = 0;
+  for (const auto& group : groups_) {
+    RETURN_NOT_OK(group->base_data_writer->FinishAndReleaseBlocks(transaction.get()));
+    if (group->undo_delta_mutations_written > 0) {
+      group->undo_delta_writer->WriteDeltaStats(std::move(group->undo_stats));
+      RETURN_NOT_OK(group->undo_delta_writer->FinishAndReleaseBlock(transaction.get()));
+      undo_delta_mutations_written += group->undo_delta_mutations_written;
+    }
+  }
 
   if (redo_delta_mutations_written_ > 0) {
-    new_redo_delta_writer_->WriteDeltaStats(std::move(redo_stats));
+    new_redo_delta_writer_->WriteDeltaStats(std::move(redo_stats_));
     RETURN_NOT_OK(new_redo_delta_writer_->FinishAndReleaseBlock(transaction.get()));
   }
-
-  if (undo_delta_mutations_written_ > 0) {
-    new_undo_delta_writer_->WriteDeltaStats(std::move(undo_stats));
-    RETURN_NOT_OK(new_undo_delta_writer_->FinishAndReleaseBlock(transaction.get()));
-  }
   transaction->CommitCreatedBlocks();
 
   DVLOG(1) << "Applied all outstanding deltas for columns "
-           << partial_schema_.ToString()
+           << ColumnNamesToString()
+           << " in " << groups_.size() << " groups"
            << ", and flushed the resulting rowsets and a total of "
            << redo_delta_mutations_written_
            << " REDO delta mutations and "
-           << undo_delta_mutations_written_
+           << undo_delta_mutations_written
            << " UNDO delta mutations to disk.";
 
   state_ = kFinished;
   return Status::OK();
 }
 
-Status MajorDeltaCompaction::OpenBaseDataWriter() {
-  CHECK(!base_data_writer_);
+Status MajorDeltaCompaction::CreateColumnGroups() {
+  CHECK(groups_.empty());
+  vector<ColumnId> present_ids;
+  vector<ColumnId> deleted_ids;
+  for (ColumnId col_id : column_ids_) {
+    if (base_schema_.find_column_by_id(col_id) != Schema::kColumnNotFound) {
+      present_ids.push_back(col_id);
+    } else {
+      deleted_ids.push_back(col_id);
+    }
+  }
+
+  const size_t num_groups = std::max<size_t>(1, std::min(delta_iters_.size(),
+                                                         present_ids.size()));
+  for (size_t g = 0; g < num_groups; g++) {
+    unique_ptr<ColumnGroup> group(new ColumnGroup);
+    group->column_ids.assign(present_ids.begin() + g * present_ids.size() / num_groups,
+                             present_ids.begin() + (g + 1) * present_ids.size() / num_groups);
+    if (g == 0) {
+      group->column_ids.insert(group->column_ids.end(), deleted_ids.begin(), deleted_ids.end());
+    }
+    RETURN_NOT_OK(base_schema_.CreateProjectionByIdsIgnoreMissing(group->column_ids,
+                                                                  &group->partial_schema));
+    group->delta_iter = std::move(delta_iters_[g]);
+    groups_.emplace_back(std::move(group));
+  }
+  // The iterators of the groups which weren't needed.
+  delta_iters_.clear();
+  return Status::OK();
+}
+
+Status MajorDeltaCompaction::OpenBaseDataWriter(ColumnGroup* group) {
+  CHECK(!group->base_data_writer);
 
   unique_ptr<MultiColumnWriter> w(new MultiColumnWriter(fs_manager_,
-                                                        &partial_schema_,
+                                                        &group->partial_schema,
                                                         tablet_id_));
   RETURN_NOT_OK(w->Open());
-  base_data_writer_ = std::move(w);
+  group->base_data_writer = std::move(w);
   return Status::OK();
 }
 
@@ -282,14 +408,14 @@ Status MajorDeltaCompaction::OpenRedoDeltaFileWriter() {
   return new_redo_delta_writer_->Start();
 }
 
-Status MajorDeltaCompaction::OpenUndoDeltaFileWriter() {
+Status MajorDeltaCompaction::OpenUndoDeltaFileWriter(ColumnGroup* group) {
   unique_ptr<WritableBlock> block;
   CreateBlockOptions opts({ tablet_id_ });
   RETURN_NOT_OK_PREPEND(fs_manager_->CreateNewBlock(opts, &block),
                         "Unable to create UNDO delta output block");
-  new_undo_delta_block_ = block->id();
-  new_undo_delta_writer_.reset(new DeltaFileWriter(std::move(block)));
-  return new_undo_delta_writer_->Start();
+  group->undo_delta_block = block->id();
+  group->undo_delta_writer.reset(new DeltaFileWriter(std::move(block)));
+  return group->undo_delta_writer->Start();
 }
 
 namespace {
@@ -326,7 +452,7 @@ Status MajorDeltaCompaction::Compact(const IOContext* io_context) {
   CHECK_EQ(state_, kInitialized);
 
   VLOG(1) << "Starting major delta compaction for columns " << ColumnNamesToString();
-  RETURN_NOT_OK(base_schema_.CreateProjectionByIdsIgnoreMissing(column_ids_, &partial_schema_));
+  RETURN_NOT_OK(CreateColumnGroups());
 
   if (VLOG_IS_ON(1)) {
     for (const auto& ds : included_stores_) {
@@ -335,7 +461,9 @@ Status MajorDeltaCompaction::Compact(const IOContext* io_context) {
   }
 
   // We defer calling OpenRedoDeltaFileWriter() since we might not need to flush.
-  RETURN_NOT_OK(OpenBaseDataWriter());
+  for (const auto& group : groups_) {
+    RETURN_NOT_OK(OpenBaseDataWriter(group.get()));
+  }
   RETURN_NOT_OK(FlushRowSetAndDeltas(io_context));
 
   TRACE_COUNTER_INCREMENT("delta_blocks_compacted", included_stores_.size());
@@ -370,13 +498,16 @@ void MajorDeltaCompaction::CreateMetadataUpdate(
   update->ReplaceRedoDeltaBlocks(compacted_delta_blocks,
                                  new_delta_blocks);
 
-  if (undo_delta_mutations_written_ > 0) {
-    update->SetNewUndoBlock(new_undo_delta_block_);
-  }
-
   // Replace old column blocks with new ones
   std::map<ColumnId, BlockId> new_column_blocks;
-  base_data_writer_->GetFlushedBlocksByColumnId(&new_column_blocks);
+  for (const auto& group : groups_) {
+    if (group->undo_delta_mutations_written > 0) {
+      update->AddNewUndoBlock(group->undo_delta_block);
+    }
+    std::map<ColumnId, BlockId> group_column_blocks;
+    group->base_data_writer->GetFlushedBlocksByColumnId(&group_column_blocks);
+    new_column_blocks.insert(group_column_blocks.begin(), group_column_blocks.end());
+  }
 
   // NOTE: in the case that one of the columns being compacted is deleted,
   // we may have fewer elements in new_column_blocks compared to 'column_ids'.
@@ -428,10 +559,14 @@ Status MajorDeltaCompaction::UpdateDeltaTracker(DeltaTracker* tracker,
 
   // Create blocks for the new undo deltas.
   SharedDeltaStoreVector new_undo_stores;
-  if (undo_delta_mutations_written_ > 0) {
-    vector<DeltaBlockIdAndStats> new_undo_blocks;
-    new_undo_blocks.emplace_back(std::make_pair(new_undo_delta_block_,
-        new_undo_delta_writer_->release_delta_stats()));
+  vector<DeltaBlockIdAndStats> new_undo_blocks;
+  for (const auto& group : groups_) {
+    if (group->undo_delta_mutations_written > 0) {
+      new_undo_blocks.emplace_back(std::make_pair(group->undo_delta_block,
+          group->undo_delta_writer->release_delta_stats()));
+    }
+  }
+  if (!new_undo_blocks.empty()) {
     RETURN_NOT_OK(tracker->OpenDeltaReaders(std::move(new_undo_blocks), io_context,
                                             &new_undo_stores, UNDO));
   }
@@ -39,6 +39,7 @@ namespace tablet {
 
 class CFileSet;
 class DeltaFileWriter;
+class DeltaStats;
 class DeltaTracker;
 class MultiColumnWriter;
 class RowSetMetadataUpdate;
@@ -51,14 +52,17 @@ class MajorDeltaCompaction {
  public:
   // Creates a new major delta compaction. The given 'base_data' should already
   // be open and must remain valid for the lifetime of this object.
-  // 'delta_iter' must not be initialized.
+  // 'delta_iters' are iterators over the deltas of 'included_stores', none of
+  // them initialized: the columns are split into at most as many groups,
+  // which are compacted in parallel, each reading the deltas with its own
+  // iterator.
   // 'col_ids' determines which columns of 'base_schema' should be compacted.
   //
   // TODO: is base_schema supposed to be the same as base_data->schema()? how about
   // in an ALTER scenario?
   MajorDeltaCompaction(
       FsManager* fs_manager, const Schema& base_schema, CFileSet* base_data,
-      std::unique_ptr<DeltaIterator> delta_iter,
+      std::vector<std::unique_ptr<DeltaIterator>> delta_iters,
       std::vector<std::shared_ptr<DeltaStore> > included_stores,
       std::vector<ColumnId> col_ids,
       HistoryGcOpts history_gc_opts,
@@ -73,26 +77,40 @@ class MajorDeltaCompaction {
   // 1) swaps out the old columns for the new ones
   // 2) removes the compacted deltas
   // 3) adds the new REDO delta which contains any uncompacted deltas
+  // 4) adds the new UNDO deltas of each group of columns
   void CreateMetadataUpdate(RowSetMetadataUpdate* update);
 
   // Apply the changes to the given delta tracker.
   Status UpdateDeltaTracker(DeltaTracker* tracker, const fs::IOContext* io_context);
 
  private:
+  // The columns compacted by one thread, and the outputs of their compaction.
+  struct ColumnGroup;
+
   std::string ColumnNamesToString() const;
 
-  // Opens a writer for the base data.
-  Status OpenBaseDataWriter();
+  // Splits the columns to compact into groups, at most one per delta
+  // iterator. The deleted columns all fall in the first group.
+  Status CreateColumnGroups();
+
+  // Opens a writer for the base data of 'group'.
+  Status OpenBaseDataWriter(ColumnGroup* group);
 
   // Opens a writer for the REDO delta file, won't be called if we don't need to write
   // back REDO delta mutations.
   Status OpenRedoDeltaFileWriter();
 
-  // Opens a writer for the UNDO delta file, won't be called if we don't need to write
-  // back UNDO delta mutations.
-  Status OpenUndoDeltaFileWriter();
+  // Opens a writer for the UNDO delta file of 'group', won't be called if we
+  // don't need to write back UNDO delta mutations.
+  Status OpenUndoDeltaFileWriter(ColumnGroup* group);
+
+  // Reads the current base data of the columns of 'group', applies the deltas, and then
+  // writes the new base data and UNDO deltas of the group. If 'write_redos' is true, also
+  // writes the deltas which aren't compacted by any group back into a REDO delta file.
+  Status FlushColumnGroup(ColumnGroup* group, bool write_redos,
+                          const fs::IOContext* io_context);
 
-  // Reads the current base data, applies the deltas, and then writes the new base data.
+  // Compacts the groups of columns in parallel, and then finishes the blocks they wrote.
   // A new delta file is written if not all columns were selected for compaction and some
   // deltas need to be written back into a delta file.
   Status FlushRowSetAndDeltas(const fs::IOContext* io_context);
@@ -102,10 +120,6 @@ class MajorDeltaCompaction {
   // TODO: doc me
   const Schema base_schema_;
 
-  // The computed partial schema which includes only the columns being
-  // compacted.
-  Schema partial_schema_;
-
   // The column ids to compact.
   const std::vector<ColumnId> column_ids_;
 
@@ -120,23 +134,22 @@ class MajorDeltaCompaction {
   // The DeltaStores from which deltas are being read.
   const SharedDeltaStoreVector included_stores_;
 
-  // The merged view of the deltas from included_stores_.
-  const std::unique_ptr<DeltaIterator> delta_iter_;
+  // The merged views of the deltas from included_stores_, handed out to the
+  // groups of columns.
+  std::vector<std::unique_ptr<DeltaIterator>> delta_iters_;
 
   // The ID of the tablet being compacted.
   const std::string tablet_id_;
 
   // Outputs:
-  std::unique_ptr<MultiColumnWriter> base_data_writer_;
-  // The following two may not be initialized if we don't need to write a delta file.
+  std::vector<std::unique_ptr<ColumnGroup>> groups_;
+
+  // The following three may not be initialized if we don't need to write a delta file.
   std::unique_ptr<DeltaFileWriter> new_redo_delta_writer_;
   BlockId new_redo_delta_block_;
-
-  std::unique_ptr<DeltaFileWriter> new_undo_delta_writer_;
-  BlockId new_undo_delta_block_;
+  std::unique_ptr<DeltaStats> redo_stats_;
 
   size_t redo_delta_mutations_written_;
-  size_t undo_delta_mutations_written_;
 
   enum State {
     kInitialized = 1,
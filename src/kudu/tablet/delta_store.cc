@@ -387,17 +387,71 @@ Status DeltaPreparer<Traits>::ApplyUpdates(size_t col_to_apply, ColumnBlock* dst
   }
 
   const ColumnSchema* col_schema = &opts_.projection->column(col_to_apply);
-  for (const ColumnUpdate& cu : updates_by_col_[col_to_apply]) {
-    int32_t idx_in_block = cu.row_id - prev_prepared_idx_;
-    DCHECK_GE(idx_in_block, 0);
-    if (!filter.IsRowSelected(idx_in_block)) {
-      continue;
-    }
+  const UpdatesForColumn& updates = updates_by_col_[col_to_apply];
+  if (updates.empty()) {
+    return Status::OK();
+  }
+  if (col_schema->type_info()->physical_type() != BINARY) {
+    // The new values of fixed-size cells don't refer to any other data: scatter
+    // them straight into the block.
+    const size_t size = col_schema->type_info()->size();
+    const bool nullable = dst->is_nullable();
+    uint8_t* data = dst->data();
+    return ForEachSelectedUpdate(updates, filter, [&](size_t idx_in_block,
+                                                      const ColumnUpdate& cu) {
+      if (cu.new_val_ptr == nullptr) {
+        DCHECK(nullable);
+        dst->SetCellIsNull(idx_in_block, true);
+        return Status::OK();
+      }
+      if (nullable) {
+        dst->SetCellIsNull(idx_in_block, false);
+      }
+      memcpy(data + idx_in_block * size, cu.new_val_ptr, size);
+      return Status::OK();
+    });
+  }
+
+  return ForEachSelectedUpdate(updates, filter, [&](size_t idx_in_block,
+                                                    const ColumnUpdate& cu) {
     SimpleConstCell src(col_schema, cu.new_val_ptr);
     ColumnBlock::Cell dst_cell = dst->cell(idx_in_block);
-    RETURN_NOT_OK(CopyCell(src, &dst_cell, dst->arena()));
-  }
+    return CopyCell(src, &dst_cell, dst->arena());
+  });
+}
+
+template<class Traits>
+template<class F>
+Status DeltaPreparer<Traits>::ForEachSelectedUpdate(const UpdatesForColumn& updates,
+                                                    const SelectionVector& filter,
+                                                    const F& func) const {
+  auto it = updates.begin();
+  while (it != updates.end()) {
+    size_t idx_in_block = it->row_id - prev_prepared_idx_;
+    DCHECK_LT(idx_in_block, filter.nrows());
+    if (PREDICT_TRUE(filter.IsRowSelected(idx_in_block))) {
+      RETURN_NOT_OK(func(idx_in_block, *it));
+      ++it;
+      continue;
+    }
 
+    // The row was filtered out. Rather than visit the updates of every other
+    // filtered-out row in turn, find the next selected row in the bitmap, and
+    // seek to its updates: the updates are sorted by row.
+    size_t next_selected;
+    if (idx_in_block + 1 >= filter.nrows() ||
+        !filter.FindFirstRowSelected(idx_in_block + 1, &next_selected)) {
+      break;
+    }
+    const rowid_t next_row_id = prev_prepared_idx_ + next_selected;
+    ++it;
+    if (it != updates.end() && it->row_id < next_row_id) {
+      it = std::lower_bound(it, updates.end(), next_row_id,
+                            [](const ColumnUpdate& cu, rowid_t row_id) {
+                              return cu.row_id < row_id;
+                            });
+    }
+  }
   return Status::OK();
 }
 
@@ -569,6 +623,7 @@ void DeltaPreparer<Traits>::UpdateDeletionState(RowChangeList::ChangeType op) {
 
 // Explicit specialization for callers outside this compilation unit.
 template class DeltaPreparer<DMSPreparerTraits>;
+template class DeltaPreparer<RangeTombstonePreparerTraits>;
 template class DeltaPreparer<DeltaFilePreparerTraits<REDO>>;
 template class DeltaPreparer<DeltaFilePreparerTraits<UNDO>>;
 
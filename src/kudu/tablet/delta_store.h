@@ -215,6 +215,15 @@ class DeltaStore {
     return Initted();
   }
 
+  // Returns whether the store may hold deltas committed in 'snap_to_include'
+  // but not in 'snap_to_exclude', i.e. deltas which a diff scan between the
+  // two snapshots selects. Stores which can't tell without reading their
+  // deltas return true.
+  virtual bool MayHaveDeltasToSelect(const MvccSnapshot& /*snap_to_exclude*/,
+                                     const MvccSnapshot& /*snap_to_include*/) const {
+    return true;
+  }
+
   virtual ~DeltaStore() {}
 };
 
@@ -382,6 +391,15 @@ struct DMSPreparerTraits {
   static constexpr bool kInitializeDecodersWithSafetyChecks = false;
 };
 
+// DeltaPreparer traits suited for a RangeTombstoneIterator, which only
+// prepares the deletes of the rows covered by range tombstones.
+struct RangeTombstonePreparerTraits {
+  static constexpr DeltaType kType = REDO;
+  static constexpr bool kAllowReinserts = false;
+  static constexpr bool kAllowFilterColumnIdsAndCollectDeltas = false;
+  static constexpr bool kInitializeDecodersWithSafetyChecks = false;
+};
+
 // DeltaPreparer traits suited for a DeltaFileIterator.
 //
 // This is just a partial specialization; the DeltaFileIterator is expected to
@@ -495,6 +513,15 @@ class DeltaPreparer : public PreparedDeltas {
     uint8_t new_val_buf[16];
   };
   typedef std::deque<ColumnUpdate> UpdatesForColumn;
+
+  // Calls 'func' with the index in the block and the update of each of
+  // 'updates' which applies to a row selected by 'filter', skipping over the
+  // updates of the rows which were filtered out.
+  template<class F>
+  Status ForEachSelectedUpdate(const UpdatesForColumn& updates,
+                               const SelectionVector& filter,
+                               const F& func) const;
+
   std::vector<UpdatesForColumn> updates_by_col_;
 
   // A row whose last relevant mutation was DELETE (or REINSERT).
@@ -31,6 +31,7 @@
 
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/fs/block_id.h"
@@ -47,6 +48,7 @@
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/deltafile.h"
 #include "kudu/tablet/deltamemstore.h"
+#include "kudu/tablet/range_tombstone.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet.pb.h"
@@ -109,6 +111,11 @@ Status DeltaTracker::OpenDeltaReaders(vector<DeltaBlockIdAndStats> blocks,
   for (auto& block_and_stats : blocks) {
     const auto& block_id = block_and_stats.first;
     unique_ptr<DeltaStats> stats = std::move(block_and_stats.second);
+    if (stats) {
+      rowset_metadata_->SetDeltaTimestampRange(block_id,
+                                               stats->min_timestamp(),
+                                               stats->max_timestamp());
+    }
     unique_ptr<ReadableBlock> block;
     Status s = fs->OpenBlock(block_id, &block);
     if (!s.ok()) {
@@ -133,6 +140,13 @@ Status DeltaTracker::OpenDeltaReaders(vector<DeltaBlockIdAndStats> blocks,
                              << s.ToString();
       return s;
     }
+    Timestamp min_timestamp;
+    Timestamp max_timestamp;
+    if (!dfr->has_delta_stats() &&
+        rowset_metadata_->GetDeltaTimestampRange(block_id, &min_timestamp, &max_timestamp)) {
+      // Lets scans cull the file without reading its stats.
+      dfr->SetKnownTimestampRange(min_timestamp, max_timestamp);
+    }
 
     VLOG_WITH_PREFIX(1) << "Successfully opened " << DeltaType_Name(type)
                         << " delta file " << block_id.ToString();
@@ -165,6 +179,11 @@ Status DeltaTracker::DoOpen(const IOContext* io_context) {
                                  &undo_delta_stores_,
                                  UNDO));
 
+  const auto tombstones = rowset_metadata_->range_tombstones();
+  if (!tombstones.empty()) {
+    range_tombstones_ = std::make_shared<RangeTombstoneStore>(tombstones);
+  }
+
   open_ = true;
   return Status::OK();
 }
@@ -481,6 +500,25 @@ bool DeltaTracker::EstimateAllRedosAreAncient(Timestamp ancient_history_mark) {
       newest_redo->delta_stats().max_timestamp() < ancient_history_mark;
 }
 
+namespace {
+
+// Sets 'max_timestamp' to the highest timestamp of the deltas of the UNDO
+// delta store 'undo', from its delta stats if it has them, or else from the
+// range of timestamps recorded in the rowset metadata, without reading the
+// file. Returns false if it is unknown, i.e. the file must be initialized.
+bool GetUndoMaxTimestamp(const DeltaStore& undo, Timestamp* max_timestamp) {
+  if (undo.has_delta_stats()) {
+    *max_timestamp = undo.delta_stats().max_timestamp();
+    return true;
+  }
+  // This is always a safe downcast because UNDO deltas are always on disk.
+  Timestamp min_timestamp;
+  return down_cast<const DeltaFileReader&>(undo).GetTimestampRange(&min_timestamp,
+                                                                   max_timestamp);
+}
+
+} // anonymous namespace
+
 Status DeltaTracker::EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp ancient_history_mark,
                                                                  int64_t* bytes) {
   DCHECK_NE(Timestamp::kInvalidTimestamp, ancient_history_mark);
@@ -490,9 +528,10 @@ Status DeltaTracker::EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp ancie
 
   int64_t tmp_bytes = 0;
   for (const auto& undo : boost::adaptors::reverse(undos_newest_first)) {
-    // Short-circuit once we hit an initialized delta block with 'max_timestamp' > AHM.
-    if (undo->has_delta_stats() &&
-        undo->delta_stats().max_timestamp() >= ancient_history_mark) {
+    // Short-circuit once we hit a delta block known to have 'max_timestamp' > AHM.
+    Timestamp max_timestamp;
+    if (GetUndoMaxTimestamp(*undo, &max_timestamp) &&
+        max_timestamp >= ancient_history_mark) {
       break;
     }
     tmp_bytes += undo->EstimateSize(); // Can be called before Init().
@@ -512,19 +551,27 @@ Status DeltaTracker::InitUndoDeltas(Timestamp ancient_history_mark,
   int64_t tmp_blocks_initialized = 0;
   int64_t tmp_bytes_in_ancient_undos = 0;
 
-  // Traverse oldest-first, initializing delta stores as we go.
+  // Traverse oldest-first, initializing delta stores as we go. The delta
+  // stores whose range of timestamps is known from the rowset metadata needn't
+  // be initialized to find out whether they are ancient.
   for (auto& undo : boost::adaptors::reverse(undos_newest_first)) {
-    if (deadline.Initialized() && MonoTime::Now() >= deadline) break;
-
-    if (!undo->Initted()) {
-      RETURN_NOT_OK(undo->Init(io_context));
-      tmp_blocks_initialized++;
+    Timestamp max_timestamp;
+    const bool max_timestamp_known = ancient_history_mark != Timestamp::kInvalidTimestamp &&
+                                     GetUndoMaxTimestamp(*undo, &max_timestamp);
+    if (!max_timestamp_known) {
+      if (deadline.Initialized() && MonoTime::Now() >= deadline) break;
+
+      if (!undo->Initted()) {
+        RETURN_NOT_OK(undo->Init(io_context));
+        tmp_blocks_initialized++;
+      }
+      max_timestamp = undo->delta_stats().max_timestamp();
     }
 
     // Stop initializing delta files once we start hitting newer deltas that
     // are not GC'able.
     if (ancient_history_mark != Timestamp::kInvalidTimestamp &&
-        undo->delta_stats().max_timestamp() >= ancient_history_mark) break;
+        max_timestamp >= ancient_history_mark) break;
 
     // We only want to count the bytes in the ancient undos so this needs to
     // come after the short-circuit above.
@@ -564,10 +611,13 @@ Status DeltaTracker::DeleteAncientUndoDeltas(Timestamp ancient_history_mark,
   int64_t tmp_blocks_deleted = 0;
   int64_t tmp_bytes_deleted = 0;
 
-  // Traverse oldest-first.
+  // Traverse oldest-first. The delta files are deleted based on their delta
+  // stats or on the range of their timestamps in the rowset metadata, so the
+  // files whose range is persisted are deleted without being read.
   for (auto& undo : boost::adaptors::reverse(undos_newest_first)) {
-    if (!undo->has_delta_stats()) break;
-    if (undo->delta_stats().max_timestamp() >= ancient_history_mark) break;
+    Timestamp max_timestamp;
+    if (!GetUndoMaxTimestamp(*undo, &max_timestamp)) break;
+    if (max_timestamp >= ancient_history_mark) break;
     tmp_blocks_deleted++;
     tmp_bytes_deleted += undo->EstimateSize();
     // This is always a safe downcast because UNDO deltas are always on disk.
@@ -629,6 +679,9 @@ void DeltaTracker::CollectStores(vector<shared_ptr<DeltaStore>>* deltas,
     if (dms_exists_.Load() && !dms_->Empty()) {
       deltas->push_back(dms_);
     }
+    if (range_tombstones_) {
+      deltas->push_back(range_tombstones_);
+    }
   }
 }
 
@@ -640,6 +693,66 @@ Status DeltaTracker::NewDeltaIterator(const RowIteratorOptions& opts,
   return DeltaIteratorMerger::Create(stores, opts, out);
 }
 
+Status DeltaTracker::HasRelevantDeltas(const RowIteratorOptions& opts, bool* relevant) const {
+  std::vector<shared_ptr<DeltaStore>> stores;
+  CollectStores(&stores, UNDOS_AND_REDOS);
+  for (const auto& store : stores) {
+    // Stores return NotFound if they have no deltas relevant to the snapshots,
+    // which they can usually tell without being initialized.
+    unique_ptr<DeltaIterator> iter;
+    Status s = store->NewDeltaIterator(opts, &iter);
+    if (s.IsNotFound()) {
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    *relevant = true;
+    return Status::OK();
+  }
+  *relevant = false;
+  return Status::OK();
+}
+
+bool DeltaTracker::MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                                         const MvccSnapshot& snap_to_include) const {
+  std::vector<shared_ptr<DeltaStore>> stores;
+  CollectStores(&stores, UNDOS_AND_REDOS);
+  return std::any_of(stores.begin(), stores.end(),
+                     [&](const shared_ptr<DeltaStore>& store) {
+                       return store->MayHaveDeltasToSelect(snap_to_exclude, snap_to_include);
+                     });
+}
+
+Status DeltaTracker::MayHaveUpdatesToColumn(const RowIteratorOptions& opts,
+                                            ColumnId col_id,
+                                            bool* may_have_updates) const {
+  std::vector<shared_ptr<DeltaStore>> stores;
+  {
+    std::lock_guard<rw_spinlock> lock(component_lock_);
+    if (dms_exists_.Load() && !dms_->Empty()) {
+      *may_have_updates = true;
+      return Status::OK();
+    }
+    stores.assign(undo_delta_stores_.begin(), undo_delta_stores_.end());
+    stores.insert(stores.end(), redo_delta_stores_.begin(), redo_delta_stores_.end());
+  }
+  for (const auto& store : stores) {
+    unique_ptr<DeltaIterator> iter;
+    Status s = store->NewDeltaIterator(opts, &iter);
+    if (s.IsNotFound()) {
+      continue;
+    }
+    RETURN_NOT_OK(s);
+    RETURN_NOT_OK(store->Init(opts.io_context));
+    if (!store->has_delta_stats() ||
+        store->delta_stats().update_count_for_col_id(col_id) > 0) {
+      *may_have_updates = true;
+      return Status::OK();
+    }
+  }
+  *may_have_updates = false;
+  return Status::OK();
+}
+
 Status DeltaTracker::NewDeltaFileIterator(
     const RowIteratorOptions& opts,
     DeltaType type,
@@ -718,6 +831,14 @@ Status DeltaTracker::CheckRowDeleted(rowid_t row_idx, const IOContext* io_contex
   shared_lock<rw_spinlock> lock(component_lock_);
 
   *deleted = false;
+  // Rows covered by range tombstones aren't reinserted within the rowset.
+  if (range_tombstones_) {
+    RETURN_NOT_OK(range_tombstones_->CheckRowDeleted(row_idx, io_context, deleted));
+    if (*deleted) {
+      return Status::OK();
+    }
+  }
+
   // Check if the row has a deletion in DeltaMemStore.
   if (dms_exists_.Load()) {
     RETURN_NOT_OK(dms_->CheckRowDeleted(row_idx, io_context, deleted));
@@ -738,6 +859,75 @@ Status DeltaTracker::CheckRowDeleted(rowid_t row_idx, const IOContext* io_contex
   return Status::OK();
 }
 
+Status DeltaTracker::DeleteRowRange(Timestamp timestamp,
+                                    rowid_t first_row,
+                                    rowid_t end_row,
+                                    const IOContext* io_context,
+                                    int64_t* deleted_count) {
+  DCHECK_LT(first_row, end_row);
+  std::lock_guard<Mutex> l(compact_flush_lock_);
+  RETURN_NOT_OK(CheckWritableUnlocked());
+
+  // Find the runs of rows which are still live: the tombstones must not cover
+  // rows which already have a DELETE in another store.
+  RowIteratorOptions opts;
+  opts.projection = &rowset_metadata_->tablet_schema();
+  opts.io_context = io_context;
+  unique_ptr<DeltaIterator> iter;
+  RETURN_NOT_OK(NewDeltaIterator(opts, REDOS_ONLY, &iter));
+  RETURN_NOT_OK(iter->Init(nullptr));
+  RETURN_NOT_OK(iter->SeekToOrdinal(first_row));
+
+  constexpr size_t kBatchSize = 1024;
+  vector<RangeTombstone> new_tombstones;
+  SelectionVector live(kBatchSize);
+  rowid_t run_start = first_row;
+  for (rowid_t row = first_row; row < end_row; ) {
+    const size_t nrows = std::min<size_t>(kBatchSize, end_row - row);
+    live.Resize(nrows);
+    live.SetAllTrue();
+    RETURN_NOT_OK(iter->PrepareBatch(nrows, DeltaIterator::PREPARE_FOR_APPLY));
+    RETURN_NOT_OK(iter->ApplyDeletes(&live));
+    for (size_t i = 0; i < nrows; i++, row++) {
+      if (!live.IsRowSelected(i)) {
+        if (run_start < row) {
+          new_tombstones.push_back({ timestamp, run_start, row });
+        }
+        run_start = row + 1;
+      }
+    }
+  }
+  if (run_start < end_row) {
+    new_tombstones.push_back({ timestamp, run_start, end_row });
+  }
+
+  *deleted_count = 0;
+  if (new_tombstones.empty()) {
+    return Status::OK();
+  }
+  for (const auto& t : new_tombstones) {
+    *deleted_count += t.end_row - t.first_row;
+  }
+
+  // The tombstones aren't in any DeltaMemStore, so they must be durable before
+  // the operation is acknowledged.
+  rowset_metadata_->CommitRangeTombstones(new_tombstones);
+  Status s = rowset_metadata_->Flush();
+  if (PREDICT_FALSE(!s.ok())) {
+    CHECK(s.IsDiskFailure()) << LogPrefix() << s.ToString();
+    read_only_ = true;
+    return s;
+  }
+
+  std::lock_guard<rw_spinlock> lock(component_lock_);
+  if (range_tombstones_) {
+    const auto& tombstones = range_tombstones_->tombstones();
+    new_tombstones.insert(new_tombstones.end(), tombstones.begin(), tombstones.end());
+  }
+  range_tombstones_ = std::make_shared<RangeTombstoneStore>(std::move(new_tombstones));
+  return Status::OK();
+}
+
 Status DeltaTracker::FlushDMS(DeltaMemStore* dms,
                               const IOContext* io_context,
                               shared_ptr<DeltaFileReader>* dfr,
@@ -769,6 +959,10 @@ Status DeltaTracker::FlushDMS(DeltaMemStore* dms,
                                     bytes_written,
                                     stats->ToString());
 
+  rowset_metadata_->SetDeltaTimestampRange(block_id,
+                                           stats->min_timestamp(),
+                                           stats->max_timestamp());
+
   // Now re-open for read
   unique_ptr<ReadableBlock> readable_block;
   RETURN_NOT_OK(fs->OpenBlock(block_id, &readable_block));
@@ -868,6 +1062,11 @@ size_t DeltaTracker::DeltaMemStoreSize() const {
   return dms_exists_.Load() ? dms_->EstimateSize() : 0;
 }
 
+int64_t DeltaTracker::DeltaMemStoreDeltasScanned() const {
+  shared_lock<rw_spinlock> lock(component_lock_);
+  return dms_exists_.Load() ? dms_->deltas_scanned() : 0;
+}
+
 int64_t DeltaTracker::MinUnflushedLogIndex() const {
   shared_lock<rw_spinlock> lock(component_lock_);
   return dms_exists_.Load() ? dms_->MinLogIndex() : 0;
@@ -64,7 +64,9 @@ namespace tablet {
 
 class DeltaFileReader;
 class DeltaMemStore;
+class MvccSnapshot;
 class OperationResultPB;
+class RangeTombstoneStore;
 class RowSetMetadata;
 class RowSetMetadataUpdate;
 struct ProbeStats;
@@ -118,6 +120,35 @@ class DeltaTracker {
     return NewDeltaIterator(opts, UNDOS_AND_REDOS, out);
   }
 
+  // Sets 'relevant' to whether any of the delta stores tracked by this
+  // DeltaTracker (including the DMS and the range tombstones) may have deltas
+  // to apply to an iteration with 'opts'. If not, the rows of the base data
+  // are exactly the rows visible to the iteration.
+  //
+  // May return false positives, e.g. for delta files whose timestamp ranges
+  // are unknown, but never false negatives.
+  Status HasRelevantDeltas(const RowIteratorOptions& opts, bool* relevant) const;
+
+  // Returns whether any of the delta stores tracked by this DeltaTracker
+  // (including the DMS and the range tombstones) may have deltas committed
+  // in 'snap_to_include' but not in 'snap_to_exclude'. If not, no row of the
+  // rowset changed between the two snapshots. Doesn't read any delta file.
+  //
+  // May return false positives, but never false negatives.
+  bool MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                             const MvccSnapshot& snap_to_include) const;
+
+  // Sets 'may_have_updates' to whether any of the delta stores tracked by this
+  // DeltaTracker may change the value of the column 'col_id' of any row for an
+  // iteration with 'opts'. If not, the base data holds the values of the
+  // column visible to the iteration. Deletions, including range tombstones,
+  // don't change values and aren't considered.
+  //
+  // May initialize delta files to read their stats. May return false
+  // positives, but never false negatives.
+  Status MayHaveUpdatesToColumn(const RowIteratorOptions& opts,
+                                ColumnId col_id,
+                                bool* may_have_updates) const;
 
   // Like NewDeltaIterator() but only includes file based stores, does not include
   // the DMS.
@@ -153,6 +184,19 @@ class DeltaTracker {
   Status CheckRowDeleted(rowid_t row_idx, const fs::IOContext* io_context,
                          bool *deleted, ProbeStats* stats) const;
 
+  // Delete the rows [first_row, end_row) of the base data which are still
+  // live as of 'timestamp', with range tombstones which are persisted in the
+  // rowset metadata before returning. The deletes are seen by iterators as
+  // REDO deltas, and are materialized by the compaction of the rowset.
+  //
+  // Sets 'deleted_count' to the number of rows deleted. The caller must
+  // ensure that no other mutation of these rows is applied concurrently.
+  Status DeleteRowRange(Timestamp timestamp,
+                        rowid_t first_row,
+                        rowid_t end_row,
+                        const fs::IOContext* io_context,
+                        int64_t* deleted_count);
+
   // Compacts all REDO delta files.
   Status Compact(const fs::IOContext* io_context);
 
@@ -238,6 +282,9 @@ class DeltaTracker {
   // Get the delta MemStore's size in bytes, including pre-allocation.
   size_t DeltaMemStoreSize() const;
 
+  // Get the number of deltas walked through by scans of the delta MemStore.
+  int64_t DeltaMemStoreDeltasScanned() const;
+
   // Returns true if the DMS doesn't exist. This doesn't rely on the size.
   bool DeltaMemStoreEmpty() const {
     return !dms_exists_.Load();
@@ -358,12 +405,16 @@ class DeltaTracker {
   // The set of tracked UNDO delta stores, in decreasing timestamp order.
   SharedDeltaStoreVector undo_delta_stores_;
 
+  // The range tombstones of the rowset, if it has any.
+  std::shared_ptr<RangeTombstoneStore> range_tombstones_;
+
   // The maintenance scheduler calls DeltaMemStoreEmpty() a lot.
   // We use an atomic variable to indicate whether DMS exists or not and
   // to avoid having to take component_lock_ in order to satisfy this call.
   AtomicBool dms_exists_;
 
-  // read-write lock protecting dms_ and {redo,undo}_delta_stores_.
+  // read-write lock protecting dms_, {redo,undo}_delta_stores_ and
+  // range_tombstones_.
   // - Readers take this lock in shared mode.
   // - Mutators take this lock in exclusive mode if they need to create
   //   a new DMS, and shared mode otherwise.
@@ -361,6 +361,51 @@ TEST_F(TestDeltaFile, TestSkipsDeltasOutOfRange) {
   ASSERT_NE(nullptr, iter);
 }
 
+// Scans which don't project any updated column shouldn't read the deltas
+// unless they need more than the deltas to apply.
+TEST_F(TestDeltaFile, TestSkipsDeltasOfUnprojectedColumns) {
+  WriteTestFile();
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(test_block_, &block));
+  size_t bytes_read = 0;
+  unique_ptr<ReadableBlock> count_block(
+      new CountingReadableBlock(std::move(block), &bytes_read));
+  shared_ptr<DeltaFileReader> reader;
+  ASSERT_OK(DeltaFileReader::Open(std::move(count_block), REDO, ReaderOptions(), &reader));
+  const size_t bytes_read_after_open = bytes_read;
+
+  // A column which isn't updated by the file.
+  const Schema projection({ ColumnSchema("other", UINT32) },
+                          { ColumnId(schema_.column_id(0) + 1) }, 0);
+  ASSERT_FALSE(reader->MayChangeProjection(projection));
+  ASSERT_TRUE(reader->MayChangeProjection(schema_));
+
+  RowIteratorOptions opts;
+  opts.snap_to_include = MvccSnapshot::CreateSnapshotIncludingAllTransactions();
+  opts.projection = &projection;
+  unique_ptr<DeltaIterator> it;
+  ASSERT_OK(reader->NewDeltaIterator(opts, &it));
+  ASSERT_OK(it->Init(nullptr));
+  ASSERT_OK(it->SeekToOrdinal(0));
+
+  constexpr int kBatchSize = 100;
+  int start_row = 0;
+  for (; start_row < FLAGS_first_row_to_update + 1000; start_row += kBatchSize) {
+    ASSERT_OK(it->PrepareBatch(kBatchSize, DeltaIterator::PREPARE_FOR_APPLY));
+    ASSERT_FALSE(it->MayHaveDeltas());
+  }
+  ASSERT_EQ(bytes_read_after_open, bytes_read);
+
+  // Collecting the mutations of the rows still requires reading the deltas,
+  // from the current position.
+  vector<Mutation*> mutations(kBatchSize);
+  ASSERT_OK(it->PrepareBatch(kBatchSize, DeltaIterator::PREPARE_FOR_COLLECT));
+  ASSERT_OK(it->CollectMutations(&mutations, &arena_));
+  ASSERT_GT(bytes_read, bytes_read_after_open);
+  ASSERT_NE(nullptr, mutations[0]);
+}
+
 TEST_F(TestDeltaFile, TestLazyInit) {
   WriteTestFile();
 
@@ -394,6 +439,41 @@ TEST_F(TestDeltaFile, TestLazyInit) {
   ASSERT_EQ(bytes_read_after_init, bytes_read);
 }
 
+// A lazily opened delta file whose timestamp range is known should be culled
+// from irrelevant snapshots without reading it.
+TEST_F(TestDeltaFile, TestLazyInitWithKnownTimestamps) {
+  WriteTestFile(10, 20);
+
+  unique_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(test_block_, &block));
+  size_t bytes_read = 0;
+  unique_ptr<ReadableBlock> count_block(
+      new CountingReadableBlock(std::move(block), &bytes_read));
+  shared_ptr<DeltaFileReader> reader;
+  ASSERT_OK(DeltaFileReader::OpenNoInit(
+      std::move(count_block), REDO, ReaderOptions(), /*delta_stats*/nullptr, &reader));
+  reader->SetKnownTimestampRange(Timestamp(10), Timestamp(20));
+  ASSERT_FALSE(reader->has_delta_stats());
+
+  RowIteratorOptions opts;
+  opts.projection = &schema_;
+  opts.snap_to_include = MvccSnapshot(Timestamp(9));
+  unique_ptr<DeltaIterator> iter;
+  Status s = reader->NewDeltaIterator(opts, &iter);
+  ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+  ASSERT_EQ(nullptr, iter);
+  ASSERT_FALSE(reader->Initted());
+  ASSERT_EQ(0, bytes_read);
+
+  // Relevant snapshots still get an iterator, which initializes the file.
+  opts.snap_to_include = MvccSnapshot(Timestamp(15));
+  ASSERT_OK(reader->NewDeltaIterator(opts, &iter));
+  ASSERT_NE(nullptr, iter);
+  ASSERT_OK(iter->Init(nullptr));
+  ASSERT_TRUE(reader->Initted());
+  ASSERT_GT(bytes_read, 0);
+}
+
 // Check that, if a delta file is opened but no deltas are written,
 // Finish() will return Status::Aborted().
 TEST_F(TestDeltaFile, TestEmptyFileIsAborted) {
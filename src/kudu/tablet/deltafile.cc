@@ -254,7 +254,16 @@ DeltaFileReader::DeltaFileReader(unique_ptr<CFileReader> cf_reader,
                                  DeltaType delta_type)
     : reader_(cf_reader.release()),
       delta_stats_(std::move(delta_stats)),
-      delta_type_(delta_type) {}
+      delta_type_(delta_type),
+      has_known_timestamps_(false) {}
+
+void DeltaFileReader::SetKnownTimestampRange(Timestamp min_timestamp,
+                                             Timestamp max_timestamp) {
+  DCHECK_LE(min_timestamp.value(), max_timestamp.value());
+  has_known_timestamps_ = true;
+  known_min_timestamp_ = min_timestamp;
+  known_max_timestamp_ = max_timestamp;
+}
 
 Status DeltaFileReader::Init(const IOContext* io_context) {
   return init_once_.Init([this, io_context] { return InitOnce(io_context); });
@@ -294,10 +303,29 @@ Status DeltaFileReader::ReadDeltaStats() {
   return Status::OK();
 }
 
+bool DeltaFileReader::GetTimestampRange(Timestamp* min_timestamp,
+                                        Timestamp* max_timestamp) const {
+  if (init_once_.init_succeeded()) {
+    *min_timestamp = delta_stats_->min_timestamp();
+    *max_timestamp = delta_stats_->max_timestamp();
+    return true;
+  }
+  if (has_known_timestamps_) {
+    // The range of timestamps was persisted in the rowset metadata: the file
+    // may be culled without being opened.
+    *min_timestamp = known_min_timestamp_;
+    *max_timestamp = known_max_timestamp_;
+    return true;
+  }
+  return false;
+}
+
 bool DeltaFileReader::IsRelevantForSnapshots(
     const boost::optional<MvccSnapshot>& snap_to_exclude,
     const MvccSnapshot& snap_to_include) const {
-  if (!init_once_.init_succeeded()) {
+  Timestamp min_timestamp;
+  Timestamp max_timestamp;
+  if (!GetTimestampRange(&min_timestamp, &max_timestamp)) {
     // If we're not initted, it means we have no delta stats and must
     // assume that this file is relevant for every snapshot.
     return true;
@@ -307,19 +335,42 @@ bool DeltaFileReader::IsRelevantForSnapshots(
   // them, or both. As such, we must be conservative and assume 'both', which
   // means the file is relevant if any relevancy criteria is true.
   bool relevant = delta_type_ == REDO ?
-                  IsDeltaRelevantForApply<REDO>(snap_to_include,
-                                                delta_stats_->min_timestamp()) :
-                  IsDeltaRelevantForApply<UNDO>(snap_to_include,
-                                                delta_stats_->max_timestamp());
+                  IsDeltaRelevantForApply<REDO>(snap_to_include, min_timestamp) :
+                  IsDeltaRelevantForApply<UNDO>(snap_to_include, max_timestamp);
   if (snap_to_exclude) {
     // The select criteria is the same regardless of delta_type_.
     relevant |= IsDeltaRelevantForSelect(*snap_to_exclude, snap_to_include,
-                                         delta_stats_->min_timestamp(),
-                                         delta_stats_->max_timestamp());
+                                         min_timestamp, max_timestamp);
   }
   return relevant;
 }
 
+bool DeltaFileReader::MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                                            const MvccSnapshot& snap_to_include) const {
+  Timestamp min_timestamp;
+  Timestamp max_timestamp;
+  if (!GetTimestampRange(&min_timestamp, &max_timestamp)) {
+    return true;
+  }
+  return IsDeltaRelevantForSelect(snap_to_exclude, snap_to_include,
+                                  min_timestamp, max_timestamp);
+}
+
+bool DeltaFileReader::MayChangeProjection(const Schema& projection) const {
+  if (!init_once_.init_succeeded() || !projection.has_column_ids()) {
+    return true;
+  }
+  if (delta_stats_->delete_count() > 0 || delta_stats_->reinsert_count() > 0) {
+    return true;
+  }
+  for (size_t i = 0; i < projection.num_columns(); i++) {
+    if (delta_stats_->update_count_for_col_id(projection.column_id(i)) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Status DeltaFileReader::CloneForDebugging(FsManager* fs_manager,
                                           const shared_ptr<MemTracker>& parent_mem_tracker,
                                           shared_ptr<DeltaFileReader>* out) const {
@@ -424,6 +475,8 @@ DeltaFileIterator<Type>::DeltaFileIterator(shared_ptr<DeltaFileReader> dfr,
       prepared_(false),
       exhausted_(false),
       initted_(false),
+      unchanged_projection_(false),
+      index_seek_pending_(false),
       cache_blocks_(CFileReader::CACHE_BLOCK) {}
 
 template<DeltaType Type>
@@ -453,10 +506,29 @@ Status DeltaFileIterator<Type>::SeekToOrdinal(rowid_t idx) {
   if (!dfr_->IsRelevantForSnapshots(preparer_.opts().snap_to_exclude,
                                     preparer_.opts().snap_to_include)) {
     exhausted_ = true;
+    index_seek_pending_ = false;
     delta_blocks_.clear();
     return Status::OK();
   }
 
+  // Scans which don't project any column updated by the file only read its
+  // blocks if they need more than the deltas to apply.
+  unchanged_projection_ = !dfr_->MayChangeProjection(*preparer_.opts().projection);
+  if (unchanged_projection_) {
+    index_seek_pending_ = true;
+  } else {
+    RETURN_NOT_OK(SeekIndexToOrdinal(idx));
+  }
+
+  preparer_.Seek(idx);
+  prepared_ = false;
+  delta_blocks_.clear();
+  exhausted_ = false;
+  return Status::OK();
+}
+
+template<DeltaType Type>
+Status DeltaFileIterator<Type>::SeekIndexToOrdinal(rowid_t idx) {
   if (!index_iter_) {
     index_iter_.reset(IndexTreeIterator::Create(
         preparer_.opts().io_context,
@@ -479,10 +551,7 @@ Status DeltaFileIterator<Type>::SeekToOrdinal(rowid_t idx) {
   }
   RETURN_NOT_OK(s);
 
-  preparer_.Seek(idx);
-  prepared_ = false;
-  delta_blocks_.clear();
-  exhausted_ = false;
+  index_seek_pending_ = false;
   return Status::OK();
 }
 
@@ -552,13 +621,25 @@ string DeltaFileIterator<Type>::PreparedDeltaBlock::ToString() const {
 template<DeltaType Type>
 Status DeltaFileIterator<Type>::PrepareBatch(size_t nrows, int prepare_flags) {
   DCHECK(initted_) << "Must call Init()";
-  DCHECK(exhausted_ || index_iter_) << "Must call SeekToOrdinal()";
+  DCHECK(exhausted_ || index_iter_ || index_seek_pending_) << "Must call SeekToOrdinal()";
 
   CHECK_GT(nrows, 0);
 
   rowid_t start_row = preparer_.cur_prepared_idx();
   rowid_t stop_row = start_row + nrows - 1;
 
+  if (unchanged_projection_ && prepare_flags == PREPARE_FOR_APPLY) {
+    // None of the deltas would be applied to the batch.
+    prepared_ = true;
+    preparer_.Start(nrows, prepare_flags);
+    preparer_.Finish(nrows);
+    return Status::OK();
+  }
+  if (index_seek_pending_) {
+    delta_blocks_.clear();
+    RETURN_NOT_OK(SeekIndexToOrdinal(start_row));
+  }
+
   // Remove blocks from our list which are no longer relevant to the range
   // being prepared.
   while (!delta_blocks_.empty() &&
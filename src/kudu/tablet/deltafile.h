@@ -33,6 +33,7 @@
 #include "kudu/cfile/cfile_reader.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/common/rowid.h"
+#include "kudu/common/timestamp.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_key.h"
@@ -192,12 +193,32 @@ class DeltaFileReader : public DeltaStore,
     return strings::Substitute("$0 ($1)", reader_->ToString(), delta_stats_->ToString());
   }
 
+  // Record the range of timestamps of the deltas of this file, as persisted
+  // in the rowset metadata, so that the file may be culled from scans before
+  // having been initialized. Must be called before the reader is shared.
+  void SetKnownTimestampRange(Timestamp min_timestamp, Timestamp max_timestamp);
+
+  // Sets 'min_timestamp' and 'max_timestamp' to the range of timestamps of
+  // the deltas of this file, from its delta stats once initialized or from
+  // the range recorded in the rowset metadata. Returns false if the range is
+  // unknown.
+  bool GetTimestampRange(Timestamp* min_timestamp, Timestamp* max_timestamp) const;
+
   // Returns true if this delta file may include any deltas which need to be
   // applied when scanning the given snapshots, or if the file has not yet
-  // been fully initialized.
+  // been fully initialized and the range of its timestamps is unknown.
   bool IsRelevantForSnapshots(const boost::optional<MvccSnapshot>& snap_to_exclude,
                               const MvccSnapshot& snap_to_include) const;
 
+  bool MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                             const MvccSnapshot& snap_to_include) const override;
+
+  // Returns true if applying the deltas of this file may change the rows of
+  // 'projection', or if the file has not yet been fully initialized. A file
+  // which neither deletes nor reinserts rows, and which doesn't update any of
+  // the columns of 'projection', leaves them unchanged.
+  bool MayChangeProjection(const Schema& projection) const;
+
   // Clone this DeltaFileReader for testing and validation purposes (such as
   // while in DEBUG mode). The resulting object will not be Initted().
   Status CloneForDebugging(FsManager* fs_manager,
@@ -233,6 +254,12 @@ class DeltaFileReader : public DeltaStore,
   // The type of this delta, i.e. UNDO or REDO.
   const DeltaType delta_type_;
 
+  // The range of timestamps of the deltas of this file, if known without
+  // reading the file. Only used until the file is initialized.
+  bool has_known_timestamps_;
+  Timestamp known_min_timestamp_;
+  Timestamp known_max_timestamp_;
+
   KuduOnceLambda init_once_;
 };
 
@@ -321,6 +348,10 @@ class DeltaFileIterator : public DeltaIterator {
   static Status GetLastRowIndexInDecodedBlock(
     const cfile::BinaryPlainBlockDecoder &dec, rowid_t *idx);
 
+  // Position 'index_iter_' at the delta block which may contain the first
+  // delta for row 'idx'.
+  Status SeekIndexToOrdinal(rowid_t idx);
+
   // Read the current block of data from the current position in the file
   // onto the end of the delta_blocks_ queue.
   Status ReadCurrentBlockOntoQueue();
@@ -341,6 +372,15 @@ class DeltaFileIterator : public DeltaIterator {
   bool exhausted_;
   bool initted_;
 
+  // Whether the deltas of the file can't change the rows of the projection,
+  // in which case batches prepared only for ApplyUpdates() and ApplyDeletes()
+  // are prepared without reading any delta block.
+  bool unchanged_projection_;
+
+  // Whether the seek of 'index_iter_' was deferred by SeekToOrdinal() until a
+  // batch needs to read the delta blocks.
+  bool index_seek_pending_;
+
   // After PrepareBatch(), the set of delta blocks in the delta file
   // which correspond to prepared_block_.
   std::deque<std::unique_ptr<PreparedDeltaBlock>> delta_blocks_;
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <ostream>
 #include <string>
 #include <unordered_set>
@@ -125,10 +126,13 @@ class TestDeltaMemStore : public KuduTest {
     }
   }
 
+  // Applies the updates of the rows starting at 'row_idx' to 'cb'. If
+  // 'sel' is set, only the updates of the rows it selects are applied.
   void ApplyUpdates(const MvccSnapshot &snapshot,
                     uint32_t row_idx,
                     size_t col_idx,
-                    ColumnBlock *cb) {
+                    ColumnBlock *cb,
+                    const SelectionVector* sel = nullptr) {
     ColumnSchema col_schema(schema_.column(col_idx));
     Schema single_col_projection({ col_schema },
                                  { schema_.column_id(col_idx) },
@@ -146,7 +150,11 @@ class TestDeltaMemStore : public KuduTest {
     ASSERT_OK(iter->SeekToOrdinal(row_idx));
     ASSERT_OK(iter->PrepareBatch(cb->nrows(), DeltaIterator::PREPARE_FOR_APPLY));
     SelectionVector filter(cb->nrows());
-    filter.SetAllTrue();
+    if (sel) {
+      sel->CopyTo(&filter, 0, 0, cb->nrows());
+    } else {
+      filter.SetAllTrue();
+    }
     ASSERT_OK(iter->ApplyDeletes(&filter));
     ASSERT_OK(iter->ApplyUpdates(0, cb, filter));
   }
@@ -251,6 +259,55 @@ TEST_F(TestDeltaMemStore, TestDMSSparseUpdates) {
   }
 }
 
+// Only the updates of the rows which weren't filtered out should be applied.
+TEST_F(TestDeltaMemStore, TestApplyUpdatesToSelectedRows) {
+  const int kNumRows = 1000;
+  vector<uint32_t> indexes_to_update(kNumRows);
+  std::iota(indexes_to_update.begin(), indexes_to_update.end(), 0);
+  UpdateIntsAtIndexes(indexes_to_update);
+
+  // Select a few scattered rows and a run of rows, as a selective predicate
+  // would.
+  SelectionVector sel(kNumRows);
+  sel.SetAllFalse();
+  for (int i = 0; i < kNumRows; i += 97) {
+    sel.SetRowSelected(i);
+  }
+  for (int i = 500; i < 520; i++) {
+    sel.SetRowSelected(i);
+  }
+
+  ScopedColumnBlock<UINT32> read_back(kNumRows);
+  for (int i = 0; i < kNumRows; i++) {
+    read_back[i] = 0xDEADBEEF;
+  }
+  MvccSnapshot snap(mvcc_);
+  NO_FATALS(ApplyUpdates(snap, 0, kIntColumn, &read_back, &sel));
+  for (int i = 0; i < kNumRows; i++) {
+    SCOPED_TRACE(i);
+    if (sel.IsRowSelected(i)) {
+      ASSERT_EQ(i * 10, read_back[i]);
+    } else {
+      ASSERT_EQ(0xDEADBEEF, read_back[i]);
+    }
+  }
+}
+
+// Scanning a DMS should count the deltas which were walked through.
+TEST_F(TestDeltaMemStore, TestDeltasScanned) {
+  unordered_set<uint32_t> indexes_to_update;
+  GenerateRandomIndexes(1000, 100, &indexes_to_update);
+  UpdateIntsAtIndexes(indexes_to_update);
+  ASSERT_EQ(0, dms_->deltas_scanned());
+
+  ScopedColumnBlock<UINT32> read_back(1000);
+  MvccSnapshot snap(mvcc_);
+  NO_FATALS(ApplyUpdates(snap, 0, kIntColumn, &read_back));
+  ASSERT_EQ(100, dms_->deltas_scanned());
+  NO_FATALS(ApplyUpdates(snap, 0, kIntColumn, &read_back));
+  ASSERT_EQ(200, dms_->deltas_scanned());
+}
+
 // Performance test for KUDU-749: zipfian workloads can cause a lot
 // of updates to a single row. This benchmark updates a single row many
 // times and times how long it takes to apply those updates during
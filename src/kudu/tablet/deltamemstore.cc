@@ -22,6 +22,7 @@
 #include <ostream>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/row_changelist.h"
@@ -30,14 +31,22 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_key.h"
+#include "kudu/tablet/delta_relevancy.h"
 #include "kudu/tablet/deltafile.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/memcmpable_varint.h"
 #include "kudu/util/memory/memory.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
+DEFINE_bool(dms_arena_huge_pages, false,
+            "Whether the arenas of newly created delta memstores grow in chunks "
+            "of one huge page backed by huge pages. See also --arena_hugetlb and "
+            "--arena_huge_pages_numa_local.");
+TAG_FLAG(dms_arena_huge_pages, experimental);
+
 namespace kudu {
 namespace tablet {
 
@@ -55,6 +64,15 @@ using strings::Substitute;
 
 static const int kInitialArenaSize = 16;
 
+// Returns the allocator the arena of a new delta memstore allocates its
+// chunks from.
+static BufferAllocator* ArenaBufferAllocator() {
+  if (FLAGS_dms_arena_huge_pages) {
+    return HugePageBufferAllocator::Get();
+  }
+  return HeapBufferAllocator::Get();
+}
+
 Status DeltaMemStore::Create(int64_t id,
                              int64_t rs_id,
                              LogAnchorRegistry* log_anchor_registry,
@@ -74,15 +92,20 @@ DeltaMemStore::DeltaMemStore(int64_t id,
                              shared_ptr<MemTracker> parent_tracker)
   : id_(id),
     rs_id_(rs_id),
+    lowest_timestamp_(Timestamp::kMax),
     highest_timestamp_(Timestamp::kMin),
     allocator_(new MemoryTrackingBufferAllocator(
-        HeapBufferAllocator::Get(), std::move(parent_tracker))),
+        ArenaBufferAllocator(), std::move(parent_tracker))),
     arena_(new ThreadSafeMemoryTrackingArena(kInitialArenaSize, allocator_)),
     tree_(arena_),
     anchorer_(log_anchor_registry,
               Substitute("Rowset-$0/DeltaMemStore-$1", rs_id_, id_)),
     disambiguator_sequence_number_(0),
-    deleted_row_count_(0) {
+    deleted_row_count_(0),
+    deltas_scanned_(0) {
+  if (FLAGS_dms_arena_huge_pages) {
+    arena_->SetMaxBufferSize(HugePageBufferAllocator::kHugePageSize);
+  }
 }
 
 Status DeltaMemStore::Init(const IOContext* /*io_context*/) {
@@ -125,10 +148,21 @@ Status DeltaMemStore::Update(Timestamp timestamp,
   }
 
   std::lock_guard<simple_spinlock> l(ts_lock_);
+  lowest_timestamp_ = std::min(lowest_timestamp_, timestamp);
   highest_timestamp_ = std::max(highest_timestamp_, timestamp);
   return Status::OK();
 }
 
+bool DeltaMemStore::MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                                          const MvccSnapshot& snap_to_include) const {
+  // Updates are applied before they're committed, so any update committed in
+  // 'snap_to_include' is accounted for in the range of timestamps.
+  std::lock_guard<simple_spinlock> l(ts_lock_);
+  return highest_timestamp_ != Timestamp::kMin &&
+         IsDeltaRelevantForSelect(snap_to_exclude, snap_to_include,
+                                  lowest_timestamp_, highest_timestamp_);
+}
+
 Status DeltaMemStore::FlushToFile(DeltaFileWriter *dfw) {
   unique_ptr<DeltaStats> stats(new DeltaStats());
 
@@ -242,9 +276,11 @@ Status DMSIterator::PrepareBatch(size_t nrows, int prepare_flags) {
 
   preparer_.Start(nrows, prepare_flags);
   bool finished_row = false;
+  int64_t deltas_scanned = 0;
   while (iter_->IsValid()) {
     Slice key_slice, val;
     iter_->GetCurrentEntry(&key_slice, &val);
+    deltas_scanned++;
     DeltaKey key;
     RETURN_NOT_OK(key.DecodeFrom(&key_slice));
     rowid_t cur_row = key.row_idx();
@@ -277,6 +313,9 @@ Status DMSIterator::PrepareBatch(size_t nrows, int prepare_flags) {
     RETURN_NOT_OK(preparer_.AddDelta(key, val, &finished_row));
     iter_->Next();
   }
+  if (deltas_scanned > 0) {
+    dms_->deltas_scanned_.IncrementBy(deltas_scanned);
+  }
   preparer_.Finish(nrows);
   return Status::OK();
 }
@@ -150,6 +150,15 @@ class DeltaMemStore : public DeltaStore,
   // Returns the number of deleted rows in this DMS.
   int64_t deleted_row_count() const;
 
+  // Returns the number of deltas which iterators walked through while
+  // preparing batches of rows, a measure of how costly this DMS is to scans.
+  int64_t deltas_scanned() const {
+    return deltas_scanned_.Load();
+  }
+
+  bool MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                             const MvccSnapshot& snap_to_include) const OVERRIDE;
+
   // Returns the highest timestamp of any updates applied to this DMS. Returns
   // 'none' if no updates have been applied.
   boost::optional<Timestamp> highest_timestamp() const {
@@ -174,6 +183,7 @@ class DeltaMemStore : public DeltaStore,
   const int64_t rs_id_; // Rowset ID.
 
   mutable simple_spinlock ts_lock_;
+  Timestamp lowest_timestamp_;
   Timestamp highest_timestamp_;
 
   std::shared_ptr<MemoryTrackingBufferAllocator> allocator_;
@@ -198,6 +208,9 @@ class DeltaMemStore : public DeltaStore,
   // Number of deleted rows in this DMS.
   AtomicInt<int64_t> deleted_row_count_;
 
+  // Number of deltas walked through by iterators. See deltas_scanned().
+  mutable AtomicInt<int64_t> deltas_scanned_;
+
   DISALLOW_COPY_AND_ASSIGN(DeltaMemStore);
 };
 
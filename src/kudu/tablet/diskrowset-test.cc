@@ -37,6 +37,7 @@
 #include "kudu/common/iterator.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
@@ -55,7 +56,9 @@
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/deltamemstore.h"
 #include "kudu/tablet/diskrowset-test-base.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/tablet/pinned_bloom_filter.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
@@ -64,6 +67,8 @@
 #include "kudu/tablet/tablet_mem_trackers.h"
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/random.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -75,6 +80,10 @@ DEFINE_double(update_fraction, 0.1f, "fraction of rows to update");
 DECLARE_bool(cfile_lazy_open);
 DECLARE_bool(crash_on_eio);
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(multi_column_writer_buffer_rows);
+DECLARE_int32(multi_column_writer_threads);
+DECLARE_bool(rowset_pinned_bloom_filters);
+DECLARE_int32(rowset_rollup_max_groups);
 DECLARE_double(env_inject_eio);
 DECLARE_double(tablet_delta_store_major_compact_min_ratio);
 DECLARE_int32(tablet_delta_store_minor_compact_max);
@@ -176,7 +185,81 @@ TEST_F(TestRowSet, TestRowSetRoundTrip) {
   }
 }
 
+// Test round-trip writing and reading back a rowset whose columns are
+// written in parallel.
+TEST_F(TestRowSet, TestRowSetRoundTripParallelColumnWrites) {
+  FLAGS_multi_column_writer_threads = 2;
+  // Not a divisor of the number of rows, so that the last buffer is partial.
+  FLAGS_multi_column_writer_buffer_rows = 777;
+  WriteTestRowSet();
+
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  IterateProjection(*rs, schema_, n_rows_);
+  NO_FATALS(VerifyUpdatesWithRowIter(*rs, {}));
+
+  char buf[256];
+  FormatKey(n_rows_ - 1, buf, sizeof(buf));
+  NO_FATALS(VerifyRandomRead(*rs, buf,
+                             Substitute(R"((string key="$0", uint32 val=$1))",
+                                        buf, n_rows_ - 1)));
+}
+
 // Test writing a rowset, and then updating some rows in it.
+// Test that rowsets look keys up through the in-memory bloom filter built by
+// their writer, and find the same keys as through their bloom file.
+TEST_F(TestRowSet, TestPinnedBloomFilter) {
+  FLAGS_rowset_pinned_bloom_filters = true;
+  DiskRowSetWriter drsw(rowset_meta_.get(), &schema_,
+                        BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+  DoWriteTestRowSet(0, &drsw);
+  unique_ptr<PinnedBloomFilter> filter = drsw.ReleasePinnedBloomFilter();
+  ASSERT_TRUE(filter);
+  ASSERT_GT(filter->memory_footprint(), 0);
+
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  rs->PinBloomFilter(std::move(filter));
+
+  // Probe the even rows, which are present, and keys right after them, which
+  // aren't, in order.
+  Schema pk = schema_.CreateKeyProjection();
+  vector<string> keys;
+  for (int i = 0; i < n_rows_; i += 2) {
+    char buf[256];
+    FormatKey(i, buf, sizeof(buf));
+    keys.emplace_back(buf);
+    keys.emplace_back(string(buf) + "x");
+  }
+  vector<unique_ptr<RowBuilder>> rows;
+  vector<unique_ptr<RowSetKeyProbe>> probes;
+  vector<const RowSetKeyProbe*> probe_ptrs;
+  vector<ProbeStats> stats(keys.size());
+  vector<ProbeStats*> stats_ptrs;
+  for (int i = 0; i < keys.size(); i++) {
+    rows.emplace_back(new RowBuilder(&pk));
+    rows.back()->AddString(Slice(keys[i]));
+    probes.emplace_back(new RowSetKeyProbe(rows.back()->row()));
+    probe_ptrs.push_back(probes.back().get());
+    stats_ptrs.push_back(&stats[i]);
+  }
+  unique_ptr<bool[]> present(new bool[keys.size()]);
+  ASSERT_OK(rs->CheckRowsPresent(probe_ptrs.data(), probe_ptrs.size(), nullptr,
+                                 present.get(), stats_ptrs.data()));
+  int keys_consulted = 0;
+  for (int i = 0; i < keys.size(); i++) {
+    ASSERT_EQ(i % 2 == 0, present[i]) << keys[i];
+    bool single_present;
+    ProbeStats single_stats;
+    ASSERT_OK(rs->CheckRowPresent(*probes[i], nullptr, &single_present, &single_stats));
+    ASSERT_EQ(present[i], single_present) << keys[i];
+    ASSERT_EQ(1, stats[i].blooms_consulted);
+    keys_consulted += stats[i].keys_consulted;
+  }
+  // The absent keys are mostly filtered out by the bloom filter.
+  ASSERT_LT(keys_consulted, keys.size() * 3 / 4);
+}
+
 TEST_F(TestRowSet, TestRowSetUpdate) {
   WriteTestRowSet();
 
@@ -272,6 +355,39 @@ TEST_F(TestRowSet, TestRandomRead) {
   NO_FATALS(VerifyRandomRead(*rs, "hello 000000000000101", ""));
 }
 
+// Test that the readers of a rowset are released only if it wasn't accessed
+// since the previous attempt, and are reinitialized on the next access.
+TEST_F(TestRowSet, TestEvictIdleReaders) {
+  WriteTestRowSet(100);
+  TabletMemTrackers mem_trackers("test_tablet", MemTracker::GetRootTracker());
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(DiskRowSet::Open(rowset_meta_, log_anchor_registry_.get(),
+                             mem_trackers, nullptr, &rs));
+
+  NO_FATALS(VerifyRandomRead(*rs, "hello 000000000000050",
+                             R"((string key="hello 000000000000050", uint32 val=50))"));
+  int64_t initialized_consumption = mem_trackers.cfile_reader_tracker->consumption();
+
+  // The rowset was just read, so its readers are kept.
+  bool evicted;
+  ASSERT_OK(rs->EvictReadersIfIdle(nullptr, &evicted));
+  ASSERT_FALSE(evicted);
+  ASSERT_EQ(initialized_consumption, mem_trackers.cfile_reader_tracker->consumption());
+
+  // It wasn't accessed since, so they are released.
+  ASSERT_OK(rs->EvictReadersIfIdle(nullptr, &evicted));
+  ASSERT_TRUE(evicted);
+  int64_t evicted_consumption = mem_trackers.cfile_reader_tracker->consumption();
+  ASSERT_LT(evicted_consumption, initialized_consumption);
+
+  // The readers are initialized again when the rowset is accessed.
+  NO_FATALS(VerifyRandomRead(*rs, "hello 000000000000050",
+                             R"((string key="hello 000000000000050", uint32 val=50))"));
+  ASSERT_GT(mem_trackers.cfile_reader_tracker->consumption(), evicted_consumption);
+  ASSERT_OK(rs->EvictReadersIfIdle(nullptr, &evicted));
+  ASSERT_FALSE(evicted);
+}
+
 // Test Delete() support within a DiskRowSet.
 TEST_F(TestRowSet, TestDelete) {
   // Write and open a DiskRowSet with 2 rows.
@@ -332,6 +448,180 @@ TEST_F(TestRowSet, TestDelete) {
 }
 
 
+// Test that scans with an empty projection count the rows of a rowset from
+// its metadata when none of its deltas apply, and still account for deletes
+// when they do.
+TEST_F(TestRowSet, TestCountWithEmptyProjection) {
+  WriteTestRowSet(10);
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  const Schema empty_projection;
+
+  auto count_rows = [&](const MvccSnapshot& snap, int* count, string* iter_str) {
+    RowIteratorOptions opts;
+    opts.projection = &empty_projection;
+    opts.snap_to_include = snap;
+    unique_ptr<RowwiseIterator> iter;
+    ASSERT_OK(rs->NewRowIterator(opts, &iter));
+    ASSERT_OK(iter->Init(nullptr));
+    *iter_str = iter->ToString();
+    Arena arena(1024);
+    RowBlock block(&empty_projection, 4, &arena);
+    *count = 0;
+    while (iter->HasNext()) {
+      ASSERT_OK(iter->NextBlock(&block));
+      *count += block.selection_vector()->CountSelected();
+    }
+  };
+
+  int count;
+  string iter_str;
+  MvccSnapshot snap_before_delete(mvcc_);
+  NO_FATALS(count_rows(snap_before_delete, &count, &iter_str));
+  ASSERT_EQ(10, count);
+  ASSERT_EQ("CountOnlyIterator", iter_str);
+
+  OperationResultPB result;
+  ASSERT_OK(DeleteRow(rs.get(), 0, &result));
+  MvccSnapshot snap_after_delete(mvcc_);
+  NO_FATALS(count_rows(snap_after_delete, &count, &iter_str));
+  ASSERT_EQ(9, count);
+  ASSERT_NE("CountOnlyIterator", iter_str);
+  NO_FATALS(count_rows(snap_before_delete, &count, &iter_str));
+  ASSERT_EQ(10, count);
+}
+
+// Test that diff scans skip the rowsets whose delta stores have no deltas in
+// the time range of the scan.
+TEST_F(TestRowSet, TestDiffScanSkipsUnchangedRowSet) {
+  WriteTestRowSet(10);
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+
+  auto diff_scan = [&](const MvccSnapshot& snap_to_exclude,
+                       const MvccSnapshot& snap_to_include,
+                       vector<string>* rows,
+                       string* iter_str) {
+    RowIteratorOptions opts;
+    opts.projection = &schema_;
+    opts.include_deleted_rows = true;
+    opts.snap_to_exclude = snap_to_exclude;
+    opts.snap_to_include = snap_to_include;
+    unique_ptr<RowwiseIterator> iter;
+    ASSERT_OK(rs->NewRowIterator(opts, &iter));
+    ASSERT_OK(iter->Init(nullptr));
+    *iter_str = iter->ToString();
+    rows->clear();
+    ASSERT_OK(IterateToStringList(iter.get(), rows));
+  };
+
+  // Update a row, flush the update to a delta file, and update another row,
+  // which stays in the DMS.
+  MvccSnapshot snap0(mvcc_);
+  OperationResultPB result;
+  ASSERT_OK(UpdateRow(rs.get(), 3, 100, &result));
+  MvccSnapshot snap1(mvcc_);
+  ASSERT_OK(rs->FlushDeltas(nullptr));
+  ASSERT_OK(UpdateRow(rs.get(), 5, 100, &result));
+  MvccSnapshot snap2(mvcc_);
+
+  vector<string> rows;
+  string iter_str;
+  NO_FATALS(diff_scan(snap0, snap1, &rows, &iter_str));
+  ASSERT_EQ(1, rows.size());
+  ASSERT_NE("UnchangedRowSetIterator", iter_str);
+  NO_FATALS(diff_scan(snap1, snap2, &rows, &iter_str));
+  ASSERT_EQ(1, rows.size());
+  ASSERT_NE("UnchangedRowSetIterator", iter_str);
+
+  // Nothing changed after the last update.
+  MvccSnapshot snap3(mvcc_);
+  NO_FATALS(diff_scan(snap2, snap3, &rows, &iter_str));
+  ASSERT_TRUE(rows.empty());
+  ASSERT_EQ("UnchangedRowSetIterator", iter_str);
+}
+
+TEST_F(TestRowSet, TestRollup) {
+  DiskRowSetWriter drsw(rowset_meta_.get(), &schema_,
+                        BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+  drsw.set_rollup_group_by_columns(0);
+  DoWriteTestRowSet(10, &drsw);
+
+  // All the rows are in the single group of the rollup.
+  shared_ptr<const RowSetRollupPB> rollup = rowset_meta_->rollup();
+  ASSERT_TRUE(rollup);
+  const ColumnId val_id = schema_.column_id(1);
+  ASSERT_EQ(1, rollup->column_ids_size());
+  ASSERT_EQ(val_id, rollup->column_ids(0));
+  ASSERT_EQ(1, rollup->groups_size());
+  const RowSetRollupPB::GroupPB& group = rollup->groups(0);
+  ASSERT_EQ("", group.encoded_group_key());
+  ASSERT_EQ(10, group.row_count());
+  ASSERT_EQ(10, group.columns(0).non_null_count());
+  uint32_t min_val = 0;
+  uint32_t max_val = 9;
+  ASSERT_EQ(string(reinterpret_cast<const char*>(&min_val), sizeof(min_val)),
+            group.columns(0).min_value());
+  ASSERT_EQ(string(reinterpret_cast<const char*>(&max_val), sizeof(max_val)),
+            group.columns(0).max_value());
+
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+  Schema projection = CreateProjection(schema_, { "val" });
+  RowSetRollupSink sink(0, { val_id });
+  auto scan = [&](const MvccSnapshot& snap, int* num_rows, string* iter_str) {
+    RowIteratorOptions opts;
+    opts.projection = &projection;
+    opts.snap_to_include = snap;
+    opts.rollup_sink = &sink;
+    unique_ptr<RowwiseIterator> iter;
+    ASSERT_OK(rs->NewRowIterator(opts, &iter));
+    ASSERT_OK(iter->Init(nullptr));
+    *iter_str = iter->ToString();
+    *num_rows = 0;
+    Arena arena(1024);
+    RowBlock block(&projection, 4, &arena);
+    while (iter->HasNext()) {
+      ASSERT_OK(iter->NextBlock(&block));
+      *num_rows += block.selection_vector()->CountSelected();
+    }
+  };
+
+  // Without deltas, the rollup stands in for the rows.
+  int num_rows;
+  string iter_str;
+  vector<shared_ptr<const RowSetRollupPB>> rollups;
+  MvccSnapshot snap_before_delete(mvcc_);
+  NO_FATALS(scan(snap_before_delete, &num_rows, &iter_str));
+  ASSERT_EQ(0, num_rows);
+  ASSERT_EQ("RollupIterator", iter_str);
+  sink.Take(&rollups);
+  ASSERT_EQ(1, rollups.size());
+
+  // Once a row is deleted, the rows are read instead.
+  OperationResultPB result;
+  ASSERT_OK(DeleteRow(rs.get(), 0, &result));
+  NO_FATALS(scan(MvccSnapshot(mvcc_), &num_rows, &iter_str));
+  ASSERT_EQ(9, num_rows);
+  ASSERT_NE("RollupIterator", iter_str);
+  sink.Take(&rollups);
+  ASSERT_TRUE(rollups.empty());
+
+  // A rollup grouping the rows differently can't stand in for them either.
+  RowSetRollupSink other_sink(1, {});
+  ASSERT_FALSE(other_sink.CanUse(*rollup));
+}
+
+TEST_F(TestRowSet, TestRollupWithTooManyGroups) {
+  FLAGS_rowset_rollup_max_groups = 5;
+  DiskRowSetWriter drsw(rowset_meta_.get(), &schema_,
+                        BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+  // Every row is its own group.
+  drsw.set_rollup_group_by_columns(1);
+  DoWriteTestRowSet(10, &drsw);
+  ASSERT_FALSE(rowset_meta_->rollup());
+}
+
 TEST_F(TestRowSet, TestDMSFlush) {
   WriteTestRowSet();
 
@@ -735,7 +1025,7 @@ INSTANTIATE_TEST_CASE_P(RowIteratorOptionsPermutations, DiffScanRowSetTest,
 // of rows, but we randomly flush/compact between each update operation so that
 // the test operates on a variety of different on-disk and in-memory layouts.
 TEST_P(DiffScanRowSetTest, TestFuzz) {
-  fs::IOContext test_context;
+  fs::IOContext test_context({ "test_tablet" });
   scoped_refptr<log::LogAnchorRegistry> log_anchor_registry(new log::LogAnchorRegistry());
 
   // Create and open a DRS with four rows.
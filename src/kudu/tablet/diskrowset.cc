@@ -18,7 +18,10 @@
 #include "kudu/tablet/diskrowset.h"
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <vector>
 
@@ -30,19 +33,25 @@
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/common/columnblock.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/iterator_stats.h"
+#include "kudu/common/key_encoder.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/common/types.h"
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/endian.h"
 #include "kudu/gutil/port.h"
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/tablet/compaction.h"
 #include "kudu/tablet/delta_compaction.h"
+#include "kudu/tablet/delta_iterator_merger.h"
 #include "kudu/tablet/delta_stats.h"
 #include "kudu/tablet/delta_store.h"
 #include "kudu/tablet/deltafile.h"
@@ -55,10 +64,12 @@
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
+#include "kudu/util/trace.h"
 
 DEFINE_int32(tablet_delta_store_minor_compact_max, 1000,
              "How many delta stores are required before forcing a minor delta compaction "
@@ -79,6 +90,14 @@ DEFINE_bool(rowset_metadata_store_keys, false,
             "metadata. If false, keys will be read from the data blocks.");
 TAG_FLAG(rowset_metadata_store_keys, experimental);
 
+DEFINE_int32(rowset_rollup_max_groups, 1024,
+             "The maximum number of groups of the rollup of the rows of a DiskRowSet. "
+             "A DiskRowSet whose rows have more groups is written without a rollup.");
+TAG_FLAG(rowset_rollup_max_groups, experimental);
+TAG_FLAG(rowset_rollup_max_groups, runtime);
+
+DECLARE_int32(major_delta_compaction_threads);
+
 namespace kudu {
 
 class Mutex;
@@ -111,8 +130,14 @@ DiskRowSetWriter::DiskRowSetWriter(RowSetMetadata* rowset_metadata,
       schema_(schema),
       bloom_sizing_(bloom_sizing),
       finished_(false),
-      written_count_(0) {
+      written_count_(0),
+      build_pinned_bloom_(PinnedBloomFilter::enabled()) {
   CHECK(schema->has_column_ids());
+  for (size_t i = 0; i < schema_->num_key_columns(); i++) {
+    if (schema_->column(i).type_info()->type() == UNIXTIME_MICROS) {
+      unixtime_key_max_.emplace_back(i, std::numeric_limits<int64_t>::min());
+    }
+  }
 }
 
 Status DiskRowSetWriter::Open() {
@@ -182,6 +207,162 @@ Status DiskRowSetWriter::InitAdHocIndexWriter() {
 
 }
 
+void DiskRowSetWriter::set_secondary_index_column_ids(const vector<ColumnId>& col_ids) {
+  CHECK_EQ(0, written_count_);
+  secondary_indexes_.clear();
+  for (const ColumnId& col_id : col_ids) {
+    int col_idx = schema_->find_column_by_id(col_id);
+    if (col_idx == Schema::kColumnNotFound) {
+      continue;
+    }
+    SecondaryIndex index;
+    index.col_idx = col_idx;
+    secondary_indexes_.emplace_back(std::move(index));
+  }
+}
+
+void DiskRowSetWriter::set_rollup_group_by_columns(int num_group_by_columns) {
+  CHECK_EQ(0, written_count_);
+  rollup_.reset();
+  rollup_col_idxs_.clear();
+  if (num_group_by_columns < 0 || num_group_by_columns > schema_->num_key_columns()) {
+    return;
+  }
+  rollup_.reset(new RowSetRollupPB());
+  rollup_->set_num_group_by_columns(num_group_by_columns);
+  for (size_t i = num_group_by_columns; i < schema_->num_columns(); i++) {
+    rollup_col_idxs_.push_back(i);
+    rollup_->add_column_ids(schema_->column_id(i));
+  }
+}
+
+namespace {
+
+// Adds 'a' and 'b', wrapping around on overflow rather than invoking
+// undefined behavior.
+int64_t WrappingAdd(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+// Adds 'cell' to the aggregates of its column in a group of a rollup.
+void AccumulateRollupCell(const ColumnBlockCell& cell, RowSetRollupPB::ColumnPB* column) {
+  if (cell.is_nullable() && cell.is_null()) {
+    return;
+  }
+  const TypeInfo* type_info = cell.typeinfo();
+  const bool is_first = column->non_null_count() == 0;
+  column->set_non_null_count(column->non_null_count() + 1);
+  switch (type_info->type()) {
+    case INT8:
+      column->set_int_sum(WrappingAdd(column->int_sum(),
+                                      *reinterpret_cast<const int8_t*>(cell.ptr())));
+      break;
+    case INT16:
+      column->set_int_sum(WrappingAdd(column->int_sum(),
+                                      *reinterpret_cast<const int16_t*>(cell.ptr())));
+      break;
+    case INT32:
+      column->set_int_sum(WrappingAdd(column->int_sum(),
+                                      *reinterpret_cast<const int32_t*>(cell.ptr())));
+      break;
+    case INT64:
+      column->set_int_sum(WrappingAdd(column->int_sum(),
+                                      *reinterpret_cast<const int64_t*>(cell.ptr())));
+      break;
+    case FLOAT:
+      column->set_double_sum(column->double_sum() + *reinterpret_cast<const float*>(cell.ptr()));
+      break;
+    case DOUBLE:
+      column->set_double_sum(column->double_sum() + *reinterpret_cast<const double*>(cell.ptr()));
+      break;
+    default:
+      break;
+  }
+
+  // The minimum and maximum are kept like the MIN and MAX aggregates of scans:
+  // the cell's data for fixed-length types, or the value's bytes for
+  // variable-length types.
+  if (type_info->physical_type() == BINARY) {
+    const Slice* value = reinterpret_cast<const Slice*>(cell.ptr());
+    if (is_first || value->compare(Slice(column->min_value())) < 0) {
+      column->set_min_value(value->data(), value->size());
+    }
+    if (is_first || value->compare(Slice(column->max_value())) > 0) {
+      column->set_max_value(value->data(), value->size());
+    }
+    return;
+  }
+  // Copy the current values into aligned buffers before comparing, since the
+  // strings' buffers may not be suitably aligned for INT128.
+  alignas(16) uint8_t current[16];
+  DCHECK_LE(type_info->size(), sizeof(current));
+  memcpy(current, column->min_value().data(), column->min_value().size());
+  if (is_first || type_info->Compare(cell.ptr(), current) < 0) {
+    column->set_min_value(cell.ptr(), type_info->size());
+  }
+  memcpy(current, column->max_value().data(), column->max_value().size());
+  if (is_first || type_info->Compare(cell.ptr(), current) > 0) {
+    column->set_max_value(cell.ptr(), type_info->size());
+  }
+}
+
+} // anonymous namespace
+
+void DiskRowSetWriter::AppendRollupRows(const RowBlock& block) {
+  const int num_group_by = rollup_->num_group_by_columns();
+  RowSetRollupPB::GroupPB* group = rollup_->groups_size() > 0 ?
+      rollup_->mutable_groups(rollup_->groups_size() - 1) : nullptr;
+  for (size_t i = 0; i < block.nrows(); i++) {
+    RowBlockRow row = block.row(i);
+
+    // The group key is encoded like that of the aggregates of scans, so that
+    // scans can merge the rollup's groups with their own.
+    rollup_group_key_.clear();
+    for (int j = 0; j < num_group_by; j++) {
+      GetKeyEncoder<faststring>(schema_->column(j).type_info()).Encode(
+          row.cell_ptr(j), j == num_group_by - 1, &rollup_group_key_);
+    }
+    if (!group || Slice(group->encoded_group_key()) != Slice(rollup_group_key_)) {
+      if (rollup_->groups_size() >= FLAGS_rowset_rollup_max_groups) {
+        VLOG(1) << "Abandoning the rollup of rowset " << rowset_metadata_->id()
+                << ": it has more than " << FLAGS_rowset_rollup_max_groups << " groups";
+        rollup_.reset();
+        return;
+      }
+      group = rollup_->add_groups();
+      group->set_encoded_group_key(rollup_group_key_.data(), rollup_group_key_.size());
+      for (size_t k = 0; k < rollup_col_idxs_.size(); k++) {
+        group->add_columns();
+      }
+    }
+
+    group->set_row_count(group->row_count() + 1);
+    for (size_t k = 0; k < rollup_col_idxs_.size(); k++) {
+      AccumulateRollupCell(row.cell(rollup_col_idxs_[k]), group->mutable_columns(k));
+    }
+  }
+}
+
+void DiskRowSetWriter::AppendSecondaryIndexEntries(const RowBlock& block) {
+  faststring buf;
+  for (auto& index : secondary_indexes_) {
+    const ColumnSchema& col = schema_->column(index.col_idx);
+    const KeyEncoder<faststring>& encoder = GetKeyEncoder<faststring>(col.type_info());
+    ColumnBlock column = block.column_block(index.col_idx);
+    for (size_t i = 0; i < block.nrows(); i++) {
+      if (col.is_nullable() && column.is_null(i)) {
+        continue;
+      }
+      buf.clear();
+      encoder.Encode(column.cell_ptr(i), /*is_last=*/false, &buf);
+      uint8_t ordinal[sizeof(uint32_t)];
+      BigEndian::Store32(ordinal, written_count_ + i);
+      buf.append(ordinal, sizeof(ordinal));
+      index.entries.emplace_back(buf.ToString());
+    }
+  }
+}
+
 Status DiskRowSetWriter::AppendBlock(const RowBlock &block, int live_row_count) {
   DCHECK_EQ(block.schema()->num_columns(), schema_->num_columns());
   CHECK(!finished_);
@@ -200,37 +381,50 @@ Status DiskRowSetWriter::AppendBlock(const RowBlock &block, int live_row_count)
   // Write the batch to each of the columns
   RETURN_NOT_OK(col_writer_->AppendBlock(block));
 
-  // Increase the live row count if necessary.
-  rowset_metadata_->IncrementLiveRows(live_row_count);
+  if (!secondary_indexes_.empty()) {
+    AppendSecondaryIndexEntries(block);
+  }
 
-#ifndef NDEBUG
-    faststring prev_key;
-#endif
+  if (rollup_) {
+    AppendRollupRows(block);
+  }
 
-  // Write the batch to the bloom and optionally the ad-hoc index
-  for (size_t i = 0; i < block.nrows(); i++) {
-#ifndef NDEBUG
-    prev_key.assign_copy(last_encoded_key_.data(), last_encoded_key_.size());
-#endif
+  for (auto& key_max : unixtime_key_max_) {
+    ColumnBlock column = block.column_block(key_max.first);
+    for (size_t i = 0; i < block.nrows(); i++) {
+      key_max.second = std::max(key_max.second,
+                                UnalignedLoad<int64_t>(column.cell_ptr(i)));
+    }
+  }
 
-    // TODO: performance might be better if we actually batch this -
-    // encode a bunch of key slices, then pass them all in one go.
-    RowBlockRow row = block.row(i);
-    // Insert the encoded key into the bloom.
-    Slice enc_key = schema_->EncodeComparableKey(row, &last_encoded_key_);
-    RETURN_NOT_OK(bloom_writer_->AppendKeys(&enc_key, 1));
+  // Increase the live row count if necessary.
+  rowset_metadata_->IncrementLiveRows(live_row_count);
 
-    // Write the batch to the ad hoc index if we're using one
-    if (ad_hoc_index_writer_ != nullptr) {
-      RETURN_NOT_OK(ad_hoc_index_writer_->AppendEntries(&enc_key, 1));
+  // Encode the keys of the batch, then write them all at once to the bloom
+  // and optionally the ad-hoc index.
+  schema_->EncodeComparableKeys(block, &encoded_keys_buf_, &encoded_keys_);
+  for (size_t i = 0; i < encoded_keys_.size(); i++) {
+    const Slice& enc_key = encoded_keys_[i];
+    if (build_pinned_bloom_) {
+      key_hashes_.push_back(PinnedBloomFilter::HashKey(enc_key));
     }
-
 #ifndef NDEBUG
-    CHECK(prev_key.size() == 0 || Slice(prev_key).compare(enc_key) < 0)
+    Slice prev_key = i > 0 ? encoded_keys_[i - 1] : Slice(last_encoded_key_);
+    CHECK(prev_key.size() == 0 || prev_key.compare(enc_key) < 0)
       << KUDU_REDACT(enc_key.ToDebugString()) << " appended to file not > previous key "
-      << KUDU_REDACT(Slice(prev_key).ToDebugString());
+      << KUDU_REDACT(prev_key.ToDebugString());
 #endif
   }
+  if (!encoded_keys_.empty()) {
+    const Slice& last_key = encoded_keys_.back();
+    last_encoded_key_.assign_copy(last_key.data(), last_key.size());
+  }
+
+  RETURN_NOT_OK(bloom_writer_->AppendKeys(encoded_keys_.data(), encoded_keys_.size()));
+  if (ad_hoc_index_writer_ != nullptr) {
+    RETURN_NOT_OK(ad_hoc_index_writer_->AppendEntries(encoded_keys_.data(),
+                                                      encoded_keys_.size()));
+  }
 
   written_count_ += block.nrows();
 
@@ -276,6 +470,10 @@ Status DiskRowSetWriter::FinishAndReleaseBlocks(BlockCreationTransaction* transa
   col_writer_->GetFlushedBlocksByColumnId(&flushed_blocks);
   rowset_metadata_->SetColumnDataBlocks(flushed_blocks);
 
+  for (const auto& key_max : unixtime_key_max_) {
+    rowset_metadata_->set_unixtime_key_max(schema_->column_id(key_max.first), key_max.second);
+  }
+
   if (ad_hoc_index_writer_ != nullptr) {
     Status s = ad_hoc_index_writer_->FinishAndReleaseBlock(transaction);
     if (!s.ok()) {
@@ -284,17 +482,67 @@ Status DiskRowSetWriter::FinishAndReleaseBlocks(BlockCreationTransaction* transa
     }
   }
 
+  RETURN_NOT_OK(FinishSecondaryIndexes(transaction));
+
+  if (rollup_) {
+    rowset_metadata_->set_rollup(std::shared_ptr<const RowSetRollupPB>(std::move(rollup_)));
+  }
+
   // Finish bloom.
   Status s = bloom_writer_->FinishAndReleaseBlock(transaction);
   if (!s.ok()) {
     LOG(WARNING) << "Unable to Finish bloom filter writer: " << s.ToString();
     return s;
   }
+  if (build_pinned_bloom_) {
+    RETURN_NOT_OK(PinnedBloomFilter::Build(key_hashes_, &pinned_bloom_));
+    vector<uint32_t>().swap(key_hashes_);
+  }
 
   finished_ = true;
   return Status::OK();
 }
 
+Status DiskRowSetWriter::FinishSecondaryIndexes(BlockCreationTransaction* transaction) {
+  if (secondary_indexes_.empty()) {
+    return Status::OK();
+  }
+  TRACE_EVENT0("tablet", "DiskRowSetWriter::FinishSecondaryIndexes");
+  FsManager* fs = rowset_metadata_->fs_manager();
+  const string& tablet_id = rowset_metadata_->tablet_metadata()->tablet_id();
+  std::map<ColumnId, BlockId> index_blocks;
+  for (auto& index : secondary_indexes_) {
+    // A column without any non-null value needs no index: it has no rows to
+    // point equality predicates at.
+    if (index.entries.empty()) {
+      continue;
+    }
+    std::sort(index.entries.begin(), index.entries.end());
+    vector<Slice> entries(index.entries.begin(), index.entries.end());
+
+    unique_ptr<WritableBlock> block;
+    RETURN_NOT_OK_PREPEND(fs->CreateNewBlock(CreateBlockOptions({ tablet_id }), &block),
+                          "Couldn't allocate a block for secondary index");
+    BlockId block_id = block->id();
+
+    cfile::WriterOptions opts;
+    opts.write_validx = true;
+    opts.write_posidx = false;
+    opts.storage_attributes.encoding = PREFIX_ENCODING;
+    opts.storage_attributes.compression = LZ4;
+    opts.storage_attributes.cfile_block_size = FLAGS_default_composite_key_index_block_size_bytes;
+    cfile::CFileWriter writer(std::move(opts), GetTypeInfo(BINARY), false, std::move(block));
+    RETURN_NOT_OK(writer.Start());
+    RETURN_NOT_OK(writer.AppendEntries(entries.data(), entries.size()));
+    RETURN_NOT_OK_PREPEND(writer.FinishAndReleaseBlock(transaction),
+                          "Unable to finish secondary index writer");
+    index_blocks.emplace(schema_->column_id(index.col_idx), block_id);
+    vector<string>().swap(index.entries);
+  }
+  rowset_metadata_->SetSecondaryIndexBlocks(index_blocks);
+  return Status::OK();
+}
+
 cfile::CFileWriter *DiskRowSetWriter::key_index_writer() {
   return ad_hoc_index_writer_ ? ad_hoc_index_writer_.get() : col_writer_->writer_for_col_idx(0);
 }
@@ -328,6 +576,7 @@ RollingDiskRowSetWriter::RollingDiskRowSetWriter(
       schema_(schema),
       bloom_sizing_(bloom_sizing),
       target_rowset_size_(target_rowset_size),
+      rollup_group_by_columns_(-1),
       row_idx_in_cur_drs_(0),
       can_roll_(false),
       written_count_(0),
@@ -354,6 +603,10 @@ Status RollingDiskRowSetWriter::RollWriter() {
   RETURN_NOT_OK(tablet_metadata_->CreateRowSet(&cur_drs_metadata_));
 
   cur_writer_.reset(new DiskRowSetWriter(cur_drs_metadata_.get(), &schema_, bloom_sizing_));
+  cur_writer_->set_secondary_index_column_ids(secondary_index_col_ids_);
+  if (rollup_group_by_columns_ >= 0) {
+    cur_writer_->set_rollup_group_by_columns(rollup_group_by_columns_);
+  }
   RETURN_NOT_OK(cur_writer_->Open());
 
   FsManager* fs = tablet_metadata_->fs_manager();
@@ -449,6 +702,12 @@ Status RollingDiskRowSetWriter::FinishCurrentWriter() {
     RETURN_NOT_OK(writer_status);
     CHECK_GT(cur_writer_->written_count(), 0);
 
+    // Keep the timestamp ranges of the deltas, which are persisted in the
+    // rowset metadata so that scans may cull the delta files unopened.
+    const Timestamp undo_min_ts = cur_undo_delta_stats_->min_timestamp();
+    const Timestamp undo_max_ts = cur_undo_delta_stats_->max_timestamp();
+    const Timestamp redo_min_ts = cur_redo_delta_stats_->min_timestamp();
+    const Timestamp redo_max_ts = cur_redo_delta_stats_->max_timestamp();
     cur_undo_writer_->WriteDeltaStats(std::move(cur_undo_delta_stats_));
     cur_redo_writer_->WriteDeltaStats(std::move(cur_redo_delta_stats_));
 
@@ -458,6 +717,7 @@ Status RollingDiskRowSetWriter::FinishCurrentWriter() {
     if (!s.IsAborted()) {
       RETURN_NOT_OK(s);
       cur_drs_metadata_->CommitUndoDeltaDataBlock(cur_undo_ds_block_id_);
+      cur_drs_metadata_->SetDeltaTimestampRange(cur_undo_ds_block_id_, undo_min_ts, undo_max_ts);
     }
 
     // Same for the REDO block.
@@ -465,10 +725,12 @@ Status RollingDiskRowSetWriter::FinishCurrentWriter() {
     if (!s.IsAborted()) {
       RETURN_NOT_OK(s);
       cur_drs_metadata_->CommitRedoDeltaDataBlock(0, 0, cur_redo_ds_block_id_);
+      cur_drs_metadata_->SetDeltaTimestampRange(cur_redo_ds_block_id_, redo_min_ts, redo_max_ts);
     }
 
     written_size_ += cur_writer_->written_size();
     written_drs_metas_.push_back(cur_drs_metadata_);
+    written_pinned_blooms_.emplace_back(cur_writer_->ReleasePinnedBloomFilter());
   }
 
   cur_writer_.reset(nullptr);
@@ -495,6 +757,13 @@ void RollingDiskRowSetWriter::GetWrittenRowSetMetadata(RowSetMetadataVector* met
   metas->assign(written_drs_metas_.begin(), written_drs_metas_.end());
 }
 
+void RollingDiskRowSetWriter::ReleasePinnedBloomFilters(
+    vector<unique_ptr<PinnedBloomFilter>>* filters) {
+  CHECK_EQ(state_, kFinished);
+  *filters = std::move(written_pinned_blooms_);
+  written_pinned_blooms_.clear();
+}
+
 RollingDiskRowSetWriter::~RollingDiskRowSetWriter() {
 }
 
@@ -525,7 +794,8 @@ DiskRowSet::DiskRowSet(shared_ptr<RowSetMetadata> rowset_metadata,
       log_anchor_registry_(log_anchor_registry),
       mem_trackers_(std::move(mem_trackers)),
       num_rows_(-1),
-      has_been_compacted_(false) {}
+      has_been_compacted_(false),
+      accessed_(true) {}
 
 Status DiskRowSet::Open(const IOContext* io_context) {
   TRACE_EVENT0("tablet", "DiskRowSet::Open");
@@ -607,6 +877,8 @@ Status DiskRowSet::MajorCompactDeltaStoresWithColumnIds(const vector<ColumnId>&
                                mem_trackers_.cfile_reader_tracker,
                                io_context,
                                &new_base));
+  // The keys haven't changed.
+  new_base->set_pinned_bloom(base_data_->pinned_bloom());
   {
     // Update the delta tracker and the base data with the changes.
     std::lock_guard<rw_spinlock> lock(component_lock_);
@@ -625,6 +897,35 @@ Status DiskRowSet::MajorCompactDeltaStoresWithColumnIds(const vector<ColumnId>&
   return rowset_metadata_->Flush();
 }
 
+Status DiskRowSet::EvictReadersIfIdle(const IOContext* io_context, bool* evicted) {
+  DCHECK(open_);
+  *evicted = false;
+  // Only release the readers if the rowset hasn't been accessed since the
+  // previous call, in the manner of the CLOCK replacement algorithm.
+  if (accessed_.exchange(false, std::memory_order_relaxed)) {
+    return Status::OK();
+  }
+  shared_ptr<CFileSet> old_base;
+  {
+    shared_lock<rw_spinlock> l(component_lock_);
+    old_base = base_data_;
+  }
+  shared_ptr<CFileSet> new_base;
+  RETURN_NOT_OK(old_base->Reopen(io_context, &new_base));
+  {
+    std::lock_guard<rw_spinlock> l(component_lock_);
+    if (base_data_ != old_base) {
+      // The base data was replaced concurrently. Keep the newer one.
+      return Status::OK();
+    }
+    base_data_.swap(new_base);
+  }
+  // The readers of the old base data are destroyed, and their memory
+  // released, once the iterators still using them are done.
+  *evicted = true;
+  return Status::OK();
+}
+
 Status DiskRowSet::NewMajorDeltaCompaction(const vector<ColumnId>& col_ids,
                                            HistoryGcOpts history_gc_opts,
                                            const IOContext* io_context,
@@ -642,10 +943,21 @@ Status DiskRowSet::NewMajorDeltaCompaction(const vector<ColumnId>& col_ids,
   RETURN_NOT_OK(delta_tracker_->NewDeltaFileIterator(
       opts, REDO, &included_stores, &delta_iter));
 
+  // One iterator over the same stores for each group of columns compacted in
+  // parallel.
+  const int num_groups = std::max(1, std::min<int>(FLAGS_major_delta_compaction_threads,
+                                                   col_ids.size()));
+  vector<unique_ptr<DeltaIterator>> delta_iters;
+  delta_iters.emplace_back(std::move(delta_iter));
+  for (int i = 1; i < num_groups; i++) {
+    RETURN_NOT_OK(DeltaIteratorMerger::Create(included_stores, opts, &delta_iter));
+    delta_iters.emplace_back(std::move(delta_iter));
+  }
+
   out->reset(new MajorDeltaCompaction(rowset_metadata_->fs_manager(),
                                       *schema,
                                       base_data_.get(),
-                                      std::move(delta_iter),
+                                      std::move(delta_iters),
                                       std::move(included_stores),
                                       col_ids,
                                       std::move(history_gc_opts),
@@ -653,17 +965,251 @@ Status DiskRowSet::NewMajorDeltaCompaction(const vector<ColumnId>& col_ids,
   return Status::OK();
 }
 
+namespace {
+
+// Iterator over the rows of a rowset for scans with an empty projection,
+// e.g. COUNT(*), when none of the rowset's deltas apply to the scan: every row
+// of the base data is then visible to the scan, and the rows are counted
+// without reading any data.
+//
+// If the scan has predicates or key bounds, the rows to count depend on the
+// data, and the iteration is delegated to 'fallback'.
+class CountOnlyIterator : public RowwiseIterator {
+ public:
+  CountOnlyIterator(const Schema* projection, rowid_t num_rows,
+                    unique_ptr<RowwiseIterator> fallback)
+      : projection_(projection),
+        num_rows_(num_rows),
+        cur_idx_(0),
+        fallback_(std::move(fallback)),
+        use_fallback_(false) {
+    DCHECK_EQ(0, projection_->num_columns());
+  }
+
+  Status Init(ScanSpec* spec) override {
+    if (spec && (spec->CanShortCircuit() ||
+                 !spec->predicates().empty() ||
+                 spec->lower_bound_key() ||
+                 spec->exclusive_upper_bound_key())) {
+      use_fallback_ = true;
+      return fallback_->Init(spec);
+    }
+    TRACE_COUNTER_INCREMENT("rowsets_counted_from_metadata", 1);
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return use_fallback_ ? fallback_->HasNext() : cur_idx_ < num_rows_;
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    if (use_fallback_) {
+      return fallback_->NextBlock(dst);
+    }
+    size_t n = std::min<size_t>(dst->row_capacity(), num_rows_ - cur_idx_);
+    if (dst->arena()) {
+      dst->arena()->Reset();
+    }
+    dst->Resize(n);
+    dst->selection_vector()->SetAllTrue();
+    cur_idx_ += n;
+    return Status::OK();
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    if (use_fallback_) {
+      fallback_->GetIteratorStats(stats);
+    } else {
+      stats->clear();
+    }
+  }
+
+  string ToString() const override {
+    return use_fallback_ ? fallback_->ToString() : "CountOnlyIterator";
+  }
+
+  const Schema& schema() const override {
+    return *projection_;
+  }
+
+ private:
+  const Schema* projection_;
+  const rowid_t num_rows_;
+  rowid_t cur_idx_;
+  unique_ptr<RowwiseIterator> fallback_;
+  bool use_fallback_;
+};
+
+// Iterator over the rows of a rowset for aggregating scans which can use the
+// rowset's rollup instead of its rows, when none of the rowset's deltas apply
+// to the scan: the rollup is then added to the scan's rollup sink, and no rows
+// are returned.
+//
+// Like CountOnlyIterator, if the scan has predicates or key bounds, the rows
+// to aggregate depend on the data, and the iteration is delegated to
+// 'fallback'.
+class RollupIterator : public RowwiseIterator {
+ public:
+  RollupIterator(const Schema* projection,
+                 shared_ptr<const RowSetRollupPB> rollup,
+                 RowSetRollupSink* sink,
+                 unique_ptr<RowwiseIterator> fallback)
+      : projection_(projection),
+        rollup_(std::move(rollup)),
+        sink_(sink),
+        fallback_(std::move(fallback)),
+        use_fallback_(false) {
+  }
+
+  Status Init(ScanSpec* spec) override {
+    if (spec && (spec->CanShortCircuit() ||
+                 !spec->predicates().empty() ||
+                 spec->lower_bound_key() ||
+                 spec->exclusive_upper_bound_key())) {
+      use_fallback_ = true;
+      return fallback_->Init(spec);
+    }
+    sink_->Add(std::move(rollup_));
+    TRACE_COUNTER_INCREMENT("rowsets_aggregated_from_rollups", 1);
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return use_fallback_ && fallback_->HasNext();
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    DCHECK(use_fallback_);
+    return fallback_->NextBlock(dst);
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    if (use_fallback_) {
+      fallback_->GetIteratorStats(stats);
+    } else {
+      stats->assign(projection_->num_columns(), IteratorStats());
+    }
+  }
+
+  string ToString() const override {
+    return use_fallback_ ? fallback_->ToString() : "RollupIterator";
+  }
+
+  const Schema& schema() const override {
+    return *projection_;
+  }
+
+ private:
+  const Schema* projection_;
+  shared_ptr<const RowSetRollupPB> rollup_;
+  RowSetRollupSink* sink_;
+  unique_ptr<RowwiseIterator> fallback_;
+  bool use_fallback_;
+};
+
+// Iterator over the rows of a rowset for diff scans when none of the
+// rowset's delta stores has deltas in the scan's time range: no row of the
+// rowset changed in the range, so no row is returned and no data is read.
+class UnchangedRowSetIterator : public RowwiseIterator {
+ public:
+  explicit UnchangedRowSetIterator(const Schema* projection)
+      : projection_(projection) {
+  }
+
+  Status Init(ScanSpec* /*spec*/) override {
+    TRACE_COUNTER_INCREMENT("rowsets_skipped_by_diff_scan", 1);
+    return Status::OK();
+  }
+
+  bool HasNext() const override {
+    return false;
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    dst->Resize(0);
+    return Status::OK();
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    stats->assign(projection_->num_columns(), IteratorStats());
+  }
+
+  string ToString() const override {
+    return "UnchangedRowSetIterator";
+  }
+
+  const Schema& schema() const override {
+    return *projection_;
+  }
+
+ private:
+  const Schema* projection_;
+};
+
+} // anonymous namespace
+
 Status DiskRowSet::NewRowIterator(const RowIteratorOptions& opts,
                                   unique_ptr<RowwiseIterator>* out) const {
   DCHECK(open_);
   shared_lock<rw_spinlock> l(component_lock_);
+  accessed_.store(true, std::memory_order_relaxed);
+
+  // A diff scan only returns the rows with deltas in its time range, which
+  // the timestamp ranges of the delta stores may rule out altogether.
+  if (opts.snap_to_exclude &&
+      !delta_tracker_->MayHaveDeltasToSelect(*opts.snap_to_exclude, opts.snap_to_include)) {
+    out->reset(new UnchangedRowSetIterator(opts.projection));
+    return Status::OK();
+  }
 
   shared_ptr<CFileSet::Iterator> base_iter(base_data_->NewIterator(opts.projection,
-                                                                   opts.io_context));
+                                                                   opts.io_context,
+                                                                   opts.column_read_pool));
+  // The secondary index of a column can only be used to select rows if the
+  // values of the column visible to the scan are those of the base data.
+  // Diff scans return the rows with deltas, which the indexes don't know of.
+  if (!opts.snap_to_exclude) {
+    vector<ColumnId> indexed_col_ids;
+    for (size_t i = 0; i < opts.projection->num_columns(); i++) {
+      ColumnId col_id = opts.projection->column_id(i);
+      if (!base_data_->has_secondary_index_for_column_id(col_id)) {
+        continue;
+      }
+      bool may_have_updates;
+      RETURN_NOT_OK(delta_tracker_->MayHaveUpdatesToColumn(opts, col_id, &may_have_updates));
+      if (!may_have_updates) {
+        indexed_col_ids.push_back(col_id);
+      }
+    }
+    base_iter->set_indexed_column_ids(std::move(indexed_col_ids));
+  }
   unique_ptr<ColumnwiseIterator> col_iter;
   RETURN_NOT_OK(delta_tracker_->WrapIterator(base_iter, opts, &col_iter));
+  unique_ptr<RowwiseIterator> iter = NewMaterializingIterator(std::move(col_iter));
+
+  // Diff scans only return the rows which have deltas in their range, so they
+  // can't be counted from the base data alone.
+  if (opts.projection->num_columns() == 0 && !opts.snap_to_exclude) {
+    bool relevant_deltas;
+    RETURN_NOT_OK(delta_tracker_->HasRelevantDeltas(opts, &relevant_deltas));
+    if (!relevant_deltas) {
+      rowid_t num_rows;
+      RETURN_NOT_OK(base_data_->CountRows(opts.io_context, &num_rows));
+      iter.reset(new CountOnlyIterator(opts.projection, num_rows, std::move(iter)));
+    }
+  } else if (opts.rollup_sink && !opts.snap_to_exclude && !opts.include_deleted_rows) {
+    shared_ptr<const RowSetRollupPB> rollup = rowset_metadata_->rollup();
+    if (rollup && opts.rollup_sink->CanUse(*rollup)) {
+      bool relevant_deltas;
+      RETURN_NOT_OK(delta_tracker_->HasRelevantDeltas(opts, &relevant_deltas));
+      if (!relevant_deltas) {
+        iter.reset(new RollupIterator(opts.projection, std::move(rollup),
+                                      opts.rollup_sink, std::move(iter)));
+      }
+    }
+  }
 
-  *out = NewMaterializingIterator(std::move(col_iter));
+  *out = std::move(iter);
   return Status::OK();
 }
 
@@ -687,6 +1233,7 @@ Status DiskRowSet::MutateRow(Timestamp timestamp,
   RETURN_NOT_OK(CountRows(io_context, &num_rows));
 #endif
   shared_lock<rw_spinlock> l(component_lock_);
+  accessed_.store(true, std::memory_order_relaxed);
 
   boost::optional<rowid_t> row_idx;
   RETURN_NOT_OK(base_data_->FindRow(probe, io_context, &row_idx, stats));
@@ -710,6 +1257,30 @@ Status DiskRowSet::MutateRow(Timestamp timestamp,
   return Status::OK();
 }
 
+Status DiskRowSet::DeleteRange(Timestamp timestamp,
+                               const Slice& lower_bound_key,
+                               const Slice& upper_bound_key,
+                               const consensus::OpId& /*op_id*/,
+                               const IOContext* io_context,
+                               OperationResultPB* /*result*/) {
+  DCHECK(open_);
+  shared_lock<rw_spinlock> l(component_lock_);
+  accessed_.store(true, std::memory_order_relaxed);
+
+  rowid_t first_row;
+  rowid_t end_row;
+  RETURN_NOT_OK(base_data_->FindRowIdRange(lower_bound_key, upper_bound_key, io_context,
+                                           &first_row, &end_row));
+  if (first_row >= end_row) {
+    return Status::OK();
+  }
+  int64_t deleted_count;
+  RETURN_NOT_OK(delta_tracker_->DeleteRowRange(timestamp, first_row, end_row, io_context,
+                                               &deleted_count));
+  VLOG_WITH_PREFIX(1) << "Deleted " << deleted_count << " rows with range tombstones";
+  return Status::OK();
+}
+
 Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
                                    const IOContext* io_context,
                                    bool* present,
@@ -720,6 +1291,7 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   RETURN_NOT_OK(CountRows(io_context, &num_rows));
 #endif
   shared_lock<rw_spinlock> l(component_lock_);
+  accessed_.store(true, std::memory_order_relaxed);
 
   rowid_t row_idx;
   RETURN_NOT_OK(base_data_->CheckRowPresent(probe, io_context, present, &row_idx, stats));
@@ -738,6 +1310,44 @@ Status DiskRowSet::CheckRowPresent(const RowSetKeyProbe &probe,
   return Status::OK();
 }
 
+void DiskRowSet::PinBloomFilter(unique_ptr<PinnedBloomFilter> filter) {
+  std::lock_guard<rw_spinlock> l(component_lock_);
+  base_data_->set_pinned_bloom(std::move(filter));
+}
+
+Status DiskRowSet::CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                                    size_t n,
+                                    const IOContext* io_context,
+                                    bool* present,
+                                    ProbeStats* const* stats) const {
+  DCHECK(open_);
+#ifndef NDEBUG
+  rowid_t num_rows;
+  RETURN_NOT_OK(CountRows(io_context, &num_rows));
+#endif
+  shared_lock<rw_spinlock> l(component_lock_);
+  accessed_.store(true, std::memory_order_relaxed);
+
+  vector<rowid_t> row_idxs(n);
+  RETURN_NOT_OK(base_data_->CheckRowsPresent(probes, n, io_context, present,
+                                             row_idxs.data(), stats));
+  for (size_t i = 0; i < n; i++) {
+    if (!present[i]) {
+      // If it wasn't in the base data, then it's definitely not in the rowset.
+      continue;
+    }
+#ifndef NDEBUG
+    CHECK_LT(row_idxs[i], num_rows);
+#endif
+
+    // Otherwise it might be in the base data but deleted.
+    bool deleted = false;
+    RETURN_NOT_OK(delta_tracker_->CheckRowDeleted(row_idxs[i], io_context, &deleted, stats[i]));
+    present[i] = !deleted;
+  }
+  return Status::OK();
+}
+
 Status DiskRowSet::CountRows(const IOContext* io_context, rowid_t *count) const {
   DCHECK(open_);
   rowid_t num_rows = num_rows_.load();
@@ -770,6 +1380,7 @@ void DiskRowSet::GetDiskRowSetSpaceUsage(DiskRowSetSpace* drss) const {
   drss->base_data_size = base_data_->OnDiskDataSize();
   drss->bloom_size = base_data_->BloomFileOnDiskSize();
   drss->ad_hoc_index_size = base_data_->AdhocIndexOnDiskSize();
+  drss->secondary_index_size = base_data_->SecondaryIndexOnDiskSize();
   drss->redo_deltas_size = delta_tracker_->RedoDeltaOnDiskSize();
   drss->undo_deltas_size = delta_tracker_->UndoDeltaOnDiskSize();
 }
@@ -811,6 +1422,11 @@ bool DiskRowSet::DeltaMemStoreEmpty() const {
   return delta_tracker_->DeltaMemStoreEmpty();
 }
 
+int64_t DiskRowSet::DeltaMemStoreDeltasScanned() const {
+  DCHECK(open_);
+  return delta_tracker_->DeltaMemStoreDeltasScanned();
+}
+
 int64_t DiskRowSet::MinUnflushedLogIndex() const {
   DCHECK(open_);
   return delta_tracker_->MinUnflushedLogIndex();
@@ -885,6 +1501,14 @@ Status DiskRowSet::IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
   return Status::OK();
 }
 
+Status DiskRowSet::IsFullyExpired(const RowExpiry& row_expiry, bool* expired) {
+  DCHECK(row_expiry.enabled());
+  int64_t max_micros;
+  *expired = rowset_metadata_->GetUnixtimeKeyMax(row_expiry.col_id(), &max_micros) &&
+             max_micros < row_expiry.expiry_micros();
+  return Status::OK();
+}
+
 Status DiskRowSet::InitUndoDeltas(Timestamp ancient_history_mark,
                                   MonoTime deadline,
                                   const IOContext* io_context,
@@ -26,6 +26,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -39,6 +40,7 @@
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/delta_key.h"
 #include "kudu/tablet/delta_tracker.h"
+#include "kudu/tablet/pinned_bloom_filter.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet_mem_trackers.h"
@@ -46,6 +48,7 @@
 #include "kudu/util/bloom_filter.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/locks.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -85,6 +88,7 @@ class MultiColumnWriter;
 class Mutation;
 class MvccSnapshot;
 class OperationResultPB;
+class RowSetRollupPB;
 
 class DiskRowSetWriter {
  public:
@@ -96,6 +100,27 @@ class DiskRowSetWriter {
 
   Status Open();
 
+  // Builds a secondary index over each of the columns with the given IDs.
+  // The index of a column is a CFile whose value index maps each non-null
+  // value of the column, key-encoded, followed by the big-endian 32-bit
+  // ordinal of its row, to nothing: the rows holding a value are found by
+  // seeking to the value and reading the ordinals of the entries which have
+  // it as their prefix. Columns which aren't in the schema are ignored.
+  //
+  // Must be called before the first call to AppendBlock().
+  void set_secondary_index_column_ids(const std::vector<ColumnId>& col_ids);
+
+  // Pre-aggregates the written rows by their values of the first
+  // 'num_group_by_columns' primary key columns into a rollup stored in the
+  // rowset's metadata: the number of rows of each group and, for each of the
+  // other columns, its number of non-null values, the sum of its values if
+  // it's an integer or floating point column, and its minimum and maximum.
+  // Since rows are appended in key order, the rows of a group are consecutive.
+  //
+  // No rollup is stored if the rows have more than --rowset_rollup_max_groups
+  // groups. Must be called before the first call to AppendBlock().
+  void set_rollup_group_by_columns(int num_group_by_columns);
+
   // The block is written to all column writers as well as the bloom filter,
   // if configured.
   // Rows must be appended in ascending order.
@@ -126,6 +151,12 @@ class DiskRowSetWriter {
 
   const Schema& schema() const { return *schema_; }
 
+  // Release the in-memory bloom filter built over the written keys, or null
+  // if none was built. See PinnedBloomFilter.
+  std::unique_ptr<PinnedBloomFilter> ReleasePinnedBloomFilter() {
+    return std::move(pinned_bloom_);
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(DiskRowSetWriter);
 
@@ -139,6 +170,16 @@ class DiskRowSetWriter {
   // (the ad-hoc writer for composite keys, otherwise the key column writer)
   cfile::CFileWriter *key_index_writer();
 
+  // Adds the entries of the rows of 'block' to the secondary indexes.
+  void AppendSecondaryIndexEntries(const RowBlock& block);
+
+  // Writes the secondary indexes, releasing their blocks to 'transaction'.
+  Status FinishSecondaryIndexes(fs::BlockCreationTransaction* transaction);
+
+  // Adds the rows of 'block' to the rollup, abandoning the rollup if they
+  // have too many groups.
+  void AppendRollupRows(const RowBlock& block);
+
   RowSetMetadata* rowset_metadata_;
   const Schema* const schema_;
 
@@ -150,8 +191,37 @@ class DiskRowSetWriter {
   std::unique_ptr<cfile::BloomFileWriter> bloom_writer_;
   std::unique_ptr<cfile::CFileWriter> ad_hoc_index_writer_;
 
+  // The hashes of the written keys, from which 'pinned_bloom_' is built when
+  // the writer finishes. Only collected if pinned bloom filters are enabled.
+  bool build_pinned_bloom_;
+  std::vector<uint32_t> key_hashes_;
+  std::unique_ptr<PinnedBloomFilter> pinned_bloom_;
+
   // The last encoded key written.
   faststring last_encoded_key_;
+
+  // The encoded keys of the block being appended, and the buffer holding them.
+  std::vector<Slice> encoded_keys_;
+  faststring encoded_keys_buf_;
+
+  // The indexes of the UNIXTIME_MICROS key columns and their maximum values
+  // among the written rows.
+  std::vector<std::pair<size_t, int64_t>> unixtime_key_max_;
+
+  // The entries of the secondary index of a column, which are sorted and
+  // written when the writer finishes.
+  struct SecondaryIndex {
+    size_t col_idx;
+    std::vector<std::string> entries;
+  };
+  std::vector<SecondaryIndex> secondary_indexes_;
+
+  // The rollup of the rows appended so far, or null if none is built, the
+  // indexes of the columns it aggregates, and a scratch buffer for the group
+  // key of each row.
+  std::unique_ptr<RowSetRollupPB> rollup_;
+  std::vector<size_t> rollup_col_idxs_;
+  faststring rollup_group_key_;
 };
 
 
@@ -172,6 +242,25 @@ class RollingDiskRowSetWriter {
 
   Status Open();
 
+  // Builds secondary indexes over the columns with the given IDs in each
+  // written rowset. See DiskRowSetWriter::set_secondary_index_column_ids().
+  //
+  // Must be called before Open().
+  void set_secondary_index_column_ids(std::vector<ColumnId> col_ids) {
+    DCHECK_EQ(state_, kInitialized);
+    secondary_index_col_ids_ = std::move(col_ids);
+  }
+
+  // Pre-aggregates the rows of each written rowset by their first
+  // 'num_group_by_columns' key columns. See
+  // DiskRowSetWriter::set_rollup_group_by_columns().
+  //
+  // Must be called before Open().
+  void set_rollup_group_by_columns(int num_group_by_columns) {
+    DCHECK_EQ(state_, kInitialized);
+    rollup_group_by_columns_ = num_group_by_columns;
+  }
+
   // The block is written to all column writers as well as the bloom filter,
   // if configured.
   // Rows must be appended in ascending order.
@@ -216,6 +305,12 @@ class RollingDiskRowSetWriter {
   // This must only be called after Finish() returns an OK result.
   void GetWrittenRowSetMetadata(RowSetMetadataVector* metas) const;
 
+  // Release the in-memory bloom filters of the written rowsets, in the order
+  // of GetWrittenRowSetMetadata(). The filters of rowsets for which none was
+  // built are null. This must only be called after Finish() returns an OK
+  // result.
+  void ReleasePinnedBloomFilters(std::vector<std::unique_ptr<PinnedBloomFilter>>* filters);
+
   uint64_t written_size() const { return written_size_; }
 
   int64_t drs_written_count() const { return written_drs_metas_.size(); }
@@ -246,6 +341,9 @@ class RollingDiskRowSetWriter {
   std::shared_ptr<RowSetMetadata> cur_drs_metadata_;
   const BloomFilterSizing bloom_sizing_;
   const size_t target_rowset_size_;
+  std::vector<ColumnId> secondary_index_col_ids_;
+  // The number of group-by columns of the rollups, or -1 if no rollups are built.
+  int rollup_group_by_columns_;
 
   std::unique_ptr<DiskRowSetWriter> cur_writer_;
 
@@ -267,6 +365,7 @@ class RollingDiskRowSetWriter {
   // RowSetMetadata objects for diskrowsets which have been successfully
   // written out.
   RowSetMetadataVector written_drs_metas_;
+  std::vector<std::unique_ptr<PinnedBloomFilter>> written_pinned_blooms_;
 
   int64_t written_count_;
   uint64_t written_size_;
@@ -291,12 +390,13 @@ struct DiskRowSetSpace {
   uint64_t base_data_size;
   uint64_t bloom_size;
   uint64_t ad_hoc_index_size;
+  uint64_t secondary_index_size;
   uint64_t redo_deltas_size;
   uint64_t undo_deltas_size;
 
   // Helper method to compute the size of the diskrowset's underlying cfile set.
   uint64_t CFileSetOnDiskSize() {
-    return base_data_size + bloom_size + ad_hoc_index_size;
+    return base_data_size + bloom_size + ad_hoc_index_size + secondary_index_size;
   }
 };
 
@@ -350,9 +450,31 @@ class DiskRowSet : public RowSet {
                    ProbeStats* stats,
                    OperationResultPB* result) override;
 
+  // Deletes the live rows of the range with range tombstones, which are
+  // persisted in the rowset metadata rather than in the DeltaMemStore.
+  Status DeleteRange(Timestamp timestamp,
+                     const Slice& lower_bound_key,
+                     const Slice& upper_bound_key,
+                     const consensus::OpId& op_id,
+                     const fs::IOContext* io_context,
+                     OperationResultPB* result) override;
+
   Status CheckRowPresent(const RowSetKeyProbe &probe, const fs::IOContext* io_context,
                          bool *present, ProbeStats* stats) const override;
 
+  // Check 'filter', built over the keys of this rowset when it was written,
+  // instead of the bloom file when looking for keys. Must be called before
+  // the rowset is made visible to other threads.
+  void PinBloomFilter(std::unique_ptr<PinnedBloomFilter> filter);
+
+  // Probes the bloom filter for all the keys first, then consults the key
+  // index only for the possible hits.
+  Status CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                          size_t n,
+                          const fs::IOContext* io_context,
+                          bool* present,
+                          ProbeStats* const* stats) const override;
+
   ////////////////////
   // Read functions.
   ////////////////////
@@ -389,6 +511,8 @@ class DiskRowSet : public RowSet {
 
   bool DeltaMemStoreEmpty() const override;
 
+  int64_t DeltaMemStoreDeltasScanned() const override;
+
   int64_t MinUnflushedLogIndex() const override;
 
   size_t CountDeltaStores() const;
@@ -401,6 +525,8 @@ class DiskRowSet : public RowSet {
   Status IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
                                   bool* deleted_and_ancient) override;
 
+  Status IsFullyExpired(const RowExpiry& row_expiry, bool* expired) override;
+
   Status InitUndoDeltas(Timestamp ancient_history_mark,
                         MonoTime deadline,
                         const fs::IOContext* io_context,
@@ -410,6 +536,16 @@ class DiskRowSet : public RowSet {
   Status DeleteAncientUndoDeltas(Timestamp ancient_history_mark, const fs::IOContext* io_context,
                                  int64_t* blocks_deleted, int64_t* bytes_deleted) override;
 
+  // Replaces the base data with a copy whose readers aren't initialized, so
+  // that the memory used by the indexes and metadata of the cfiles is released,
+  // unless the rowset was accessed since the previous call. Sets 'evicted' to
+  // whether the base data was replaced. The readers are initialized again when
+  // the rowset is next accessed.
+  //
+  // Must be called with the rowset's compact_flush_lock held, so that it
+  // doesn't race with major delta compactions.
+  Status EvictReadersIfIdle(const fs::IOContext* io_context, bool* evicted);
+
   // Major compacts all the delta files for all the columns.
   Status MajorCompactDeltaStores(const fs::IOContext* io_context, HistoryGcOpts history_gc_opts);
 
@@ -497,6 +633,9 @@ class DiskRowSet : public RowSet {
   // and thus should not be scheduled for further compactions.
   std::atomic<bool> has_been_compacted_;
 
+  // Set when the base data is accessed, and cleared by EvictReadersIfIdle().
+  mutable std::atomic<bool> accessed_;
+
   DISALLOW_COPY_AND_ASSIGN(DiskRowSet);
 };
 
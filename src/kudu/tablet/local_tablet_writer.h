@@ -81,6 +81,16 @@ class LocalTabletWriter {
     return Write(RowOperationsPB::UPDATE, row);
   }
 
+  // Delete the rows whose keys are within ['lower_bound', 'upper_bound'),
+  // which only need their key columns set.
+  Status DeleteRange(const KuduPartialRow& lower_bound,
+                     const KuduPartialRow& upper_bound) {
+    std::vector<Op> ops;
+    ops.emplace_back(RowOperationsPB::DELETE_RANGE, &lower_bound);
+    ops.emplace_back(RowOperationsPB::DELETE_RANGE_UPPER_BOUND, &upper_bound);
+    return WriteBatch(ops);
+  }
+
   // Perform a write against the local tablet.
   // Returns a bad Status if the applied operation had a per-row error.
   Status Write(RowOperationsPB::Type type,
@@ -117,6 +117,33 @@ TEST_F(LockManagerTest, TestMoveLock) {
   ASSERT_FALSE(row_lock.acquired()); // NOLINT(bugprone-use-after-move)
 }
 
+TEST_F(LockManagerTest, TestAcquireBatch) {
+  Slice key_a("a"), key_b("b"), key_c("c");
+  {
+    vector<ScopedRowLock> locks;
+    lock_manager_.AcquireBatch(kFakeTransaction, LockManager::LOCK_EXCLUSIVE,
+                               { key_c, key_a, key_b, key_a }, &locks);
+    ASSERT_EQ(4, locks.size());
+    for (const auto& l : locks) {
+      ASSERT_TRUE(l.acquired());
+    }
+    VerifyAlreadyLocked(key_a);
+    VerifyAlreadyLocked(key_b);
+    VerifyAlreadyLocked(key_c);
+
+    // Releasing one of the duplicates keeps the row locked.
+    locks[3].Release();
+    VerifyAlreadyLocked(key_a);
+  }
+
+  // All the locks are released along with their holders.
+  ScopedRowLock l(&lock_manager_, kFakeTransaction, key_a, LockManager::LOCK_EXCLUSIVE);
+  vector<ScopedRowLock> locks;
+  lock_manager_.AcquireBatch(kFakeTransaction, LockManager::LOCK_EXCLUSIVE,
+                             { key_b, key_c }, &locks);
+  ASSERT_EQ(2, locks.size());
+}
+
 class LmTestResource {
  public:
   explicit LmTestResource(const Slice* id)
@@ -154,11 +181,20 @@ class LmTestResource {
   bool is_owned_;
 };
 
+// How an LmTestThread locks its rows.
+enum class LmLockMode {
+  // One ScopedRowLock per row.
+  PER_ROW,
+  // All the rows with a single LockManager::AcquireBatch() call.
+  BATCH,
+};
+
 class LmTestThread {
  public:
   LmTestThread(LockManager* manager, vector<const Slice*> keys,
-               const vector<LmTestResource*> resources)
-      : manager_(manager), keys_(std::move(keys)), resources_(resources) {}
+               const vector<LmTestResource*> resources,
+               LmLockMode mode = LmLockMode::PER_ROW)
+      : manager_(manager), keys_(std::move(keys)), resources_(resources), mode_(mode) {}
 
   void Start() {
     thread_ = thread([this]() { this->Run(); });
@@ -168,10 +204,13 @@ class LmTestThread {
     tid_ = Env::Default()->gettid();
     const TransactionState* my_txn = reinterpret_cast<TransactionState*>(tid_);
 
+    if (mode_ == LmLockMode::BATCH) {
+      RunBatch(my_txn);
+      return;
+    }
     std::sort(keys_.begin(), keys_.end());
     for (int i = 0; i < FLAGS_num_iterations; i++) {
       std::vector<shared_ptr<ScopedRowLock> > locks;
-      // TODO: We don't have an API for multi-row
       for (const Slice* key : keys_) {
         locks.push_back(std::make_shared<ScopedRowLock>(
             manager_, my_txn, *key, LockManager::LOCK_EXCLUSIVE));
@@ -186,6 +225,26 @@ class LmTestThread {
     }
   }
 
+  void RunBatch(const TransactionState* my_txn) {
+    // The keys are deliberately left unsorted: AcquireBatch() must
+    // lock them in an order which can't deadlock.
+    vector<Slice> keys;
+    for (const Slice* key : keys_) {
+      keys.push_back(*key);
+    }
+    for (int i = 0; i < FLAGS_num_iterations; i++) {
+      vector<ScopedRowLock> locks;
+      manager_->AcquireBatch(my_txn, LockManager::LOCK_EXCLUSIVE, keys, &locks);
+
+      for (LmTestResource* r : resources_) {
+        r->acquire(tid_);
+      }
+      for (LmTestResource* r : resources_) {
+        r->release(tid_);
+      }
+    }
+  }
+
   void Join() {
     thread_.join();
   }
@@ -195,6 +254,7 @@ class LmTestThread {
   LockManager* manager_;
   vector<const Slice*> keys_;
   const vector<LmTestResource*> resources_;
+  const LmLockMode mode_;
   uint64_t tid_;
   thread thread_;
 };
@@ -230,9 +290,10 @@ static void runPerformanceTest(const char *test_type,
     << sys_cpu_micros_per_cycle << "us";
 }
 
-// Test running a bunch of threads at once that want an overlapping set of
-// resources.
-TEST_F(LockManagerTest, TestContention) {
+// Runs a bunch of threads at once that want an overlapping set of resources,
+// locking their rows as per 'mode'.
+static void RunContentionTest(const char* test_type, LockManager* lock_manager,
+                              LmLockMode mode) {
   Slice slice_a("a");
   LmTestResource resource_a(&slice_a);
   Slice slice_b("b");
@@ -258,9 +319,20 @@ TEST_F(LockManagerTest, TestContention) {
       keys.push_back((*r)->id());
     }
     threads.push_back(std::make_shared<LmTestThread>(
-        &lock_manager_, keys, resources));
+        lock_manager, keys, resources, mode));
   }
-  runPerformanceTest("Contended", &threads);
+  runPerformanceTest(test_type, &threads);
+}
+
+// Test running a bunch of threads at once that want an overlapping set of
+// resources.
+TEST_F(LockManagerTest, TestContention) {
+  RunContentionTest("Contended", &lock_manager_, LmLockMode::PER_ROW);
+}
+
+// Same as above, but each thread locks its rows with a single batch call.
+TEST_F(LockManagerTest, TestContentionBatch) {
+  RunContentionTest("Contended batch", &lock_manager_, LmLockMode::BATCH);
 }
 
 // Test running a bunch of threads at once that want different
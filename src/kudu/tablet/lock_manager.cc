@@ -17,11 +17,15 @@
 
 #include "kudu/tablet/lock_manager.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -40,6 +44,7 @@
 using base::subtle::NoBarrier_Load;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -104,11 +109,16 @@ class LockEntry {
 
 class LockTable {
  private:
+  // Buckets are padded to the size of a cache line, so that threads locking
+  // rows of neighbouring buckets don't contend on the same line.
   struct Bucket {
     simple_spinlock lock;
     // First entry chained from this bucket, or NULL if the bucket is empty.
     LockEntry *chain_head;
     Bucket() : chain_head(nullptr) {}
+   private:
+    char padding_[CACHELINE_SIZE - (sizeof(simple_spinlock) + sizeof(LockEntry*)) %
+                  CACHELINE_SIZE];
   };
 
  public:
@@ -127,9 +137,23 @@ class LockTable {
   }
 
   LockEntry *GetLockEntry(const Slice &key);
+
+  // Same as GetLockEntry(), for each of the 'n' keys, with a single lookup of
+  // the table.
+  void GetLockEntries(const Slice* keys, size_t n, LockEntry** entries);
+
   void ReleaseLockEntry(LockEntry *entry);
 
  private:
+  // Find the entry matching 'new_entry' in the table, and reference it, or
+  // insert 'new_entry' if there is none. Returns the entry found, or nullptr
+  // if 'new_entry' was inserted. Requires the table lock to be held in
+  // shared mode.
+  LockEntry* FindOrInsertUnlocked(LockEntry* new_entry);
+
+  // Resize the table if it holds more entries than buckets.
+  void MaybeResize();
+
   Bucket *FindBucket(uint64_t hash) const {
     return &(buckets_[hash & mask_]);
   }
@@ -172,25 +196,39 @@ class LockTable {
   base::subtle::Atomic64 item_count_;
 };
 
+LockEntry* LockTable::FindOrInsertUnlocked(LockEntry* new_entry) {
+  Bucket *bucket = FindBucket(new_entry->key_hash_);
+  std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
+  LockEntry **node = FindSlot(bucket, new_entry->key_, new_entry->key_hash_);
+  LockEntry* old_entry = *node;
+  if (old_entry != nullptr) {
+    old_entry->refs_++;
+  } else {
+    new_entry->ht_next_ = nullptr;
+    new_entry->CopyKey();
+    *node = new_entry;
+  }
+  return old_entry;
+}
+
+void LockTable::MaybeResize() {
+  if (base::subtle::NoBarrier_Load(&item_count_) > size_) {
+    std::unique_lock<percpu_rwlock> table_wrlock(lock_, std::try_to_lock);
+    // if we can't take the lock, means that someone else is resizing.
+    // (The percpu_rwlock try_lock waits for readers to complete)
+    if (table_wrlock.owns_lock()) {
+      Resize();
+    }
+  }
+}
+
 LockEntry *LockTable::GetLockEntry(const Slice& key) {
   auto new_entry = new LockEntry(key);
   LockEntry *old_entry;
 
   {
     shared_lock<rw_spinlock> l(lock_.get_lock());
-    Bucket *bucket = FindBucket(new_entry->key_hash_);
-    {
-      std::lock_guard<simple_spinlock> bucket_lock(bucket->lock);
-      LockEntry **node = FindSlot(bucket, new_entry->key_, new_entry->key_hash_);
-      old_entry = *node;
-      if (old_entry != nullptr) {
-        old_entry->refs_++;
-      } else {
-        new_entry->ht_next_ = nullptr;
-        new_entry->CopyKey();
-        *node = new_entry;
-      }
-    }
+    old_entry = FindOrInsertUnlocked(new_entry);
   }
 
   if (old_entry != nullptr) {
@@ -198,16 +236,32 @@ LockEntry *LockTable::GetLockEntry(const Slice& key) {
     return old_entry;
   }
 
-  if (base::subtle::NoBarrier_AtomicIncrement(&item_count_, 1) > size_) {
-    std::unique_lock<percpu_rwlock> table_wrlock(lock_, std::try_to_lock);
-    // if we can't take the lock, means that someone else is resizing.
-    // (The percpu_rwlock try_lock waits for readers to complete)
-    if (table_wrlock.owns_lock()) {
-      Resize();
+  base::subtle::NoBarrier_AtomicIncrement(&item_count_, 1);
+  MaybeResize();
+  return new_entry;
+}
+
+void LockTable::GetLockEntries(const Slice* keys, size_t n, LockEntry** entries) {
+  int64_t num_inserted = 0;
+  {
+    shared_lock<rw_spinlock> l(lock_.get_lock());
+    for (size_t i = 0; i < n; i++) {
+      auto new_entry = new LockEntry(keys[i]);
+      LockEntry* old_entry = FindOrInsertUnlocked(new_entry);
+      if (old_entry != nullptr) {
+        delete new_entry;
+        entries[i] = old_entry;
+      } else {
+        entries[i] = new_entry;
+        num_inserted++;
+      }
     }
   }
 
-  return new_entry;
+  if (num_inserted > 0) {
+    base::subtle::NoBarrier_AtomicIncrement(&item_count_, num_inserted);
+    MaybeResize();
+  }
 }
 
 void LockTable::ReleaseLockEntry(LockEntry *entry) {
@@ -339,11 +393,44 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
                                           LockManager::LockMode mode,
                                           LockEntry** entry) {
   *entry = locks_->GetLockEntry(key);
+  AcquireEntry(key, tx, *entry);
+  return LOCK_ACQUIRED;
+}
+
+void LockManager::AcquireBatch(const TransactionState* tx,
+                               LockManager::LockMode mode,
+                               const vector<Slice>& keys,
+                               vector<ScopedRowLock>* locks) {
+  const size_t n = keys.size();
+  vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return keys[a].compare(keys[b]) < 0;
+  });
+  vector<Slice> sorted_keys;
+  sorted_keys.reserve(n);
+  for (size_t i : order) {
+    sorted_keys.push_back(keys[i]);
+  }
 
+  vector<LockEntry*> entries(n);
+  locks_->GetLockEntries(sorted_keys.data(), n, entries.data());
+
+  locks->clear();
+  locks->resize(n);
+  for (size_t i = 0; i < n; i++) {
+    AcquireEntry(sorted_keys[i], tx, entries[i]);
+    (*locks)[order[i]] = ScopedRowLock(this, entries[i], LOCK_ACQUIRED);
+  }
+}
+
+void LockManager::AcquireEntry(const Slice& key,
+                               const TransactionState* tx,
+                               LockEntry* entry) {
   // We expect low contention, so just try to try_lock first. This is faster
   // than a timed_lock, since we don't have to do a syscall to get the current
   // time.
-  if (!(*entry)->sem.TryAcquire()) {
+  if (!entry->sem.TryAcquire()) {
     // If the current holder of this lock is the same transaction just return
     // a LOCK_ALREADY_ACQUIRED status without actually acquiring the mutex.
     //
@@ -353,9 +440,9 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     // obtained and released at the same time). If at any time in the future
     // we opt to perform more fine grained locking, possibly letting transactions
     // release a portion of the locks they no longer need, this no longer is OK.
-    if (ANNOTATE_UNPROTECTED_READ((*entry)->holder_) == tx) {
-      (*entry)->recursion_++;
-      return LOCK_ACQUIRED;
+    if (ANNOTATE_UNPROTECTED_READ(entry->holder_) == tx) {
+      entry->recursion_++;
+      return;
     }
 
     // If we couldn't immediately acquire the lock, do a timed lock so we can
@@ -365,8 +452,8 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     TRACE_COUNTER_INCREMENT("row_lock_wait_count", 1);
     MicrosecondsInt64 start_wait_us = GetMonoTimeMicros();
     int waited_seconds = 0;
-    while (!(*entry)->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
-      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ((*entry)->holder_);
+    while (!entry->sem.TimedAcquire(MonoDelta::FromSeconds(1))) {
+      const TransactionState* cur_holder = ANNOTATE_UNPROTECTED_READ(entry->holder_);
       LOG(WARNING) << "Waited " << (++waited_seconds) << " seconds to obtain row lock on key "
                    << KUDU_REDACT(key.ToDebugString()) << " cur holder: " << cur_holder;
       // TODO(unknown): would be nice to also include some info about the blocking transaction,
@@ -380,8 +467,7 @@ LockManager::LockStatus LockManager::Lock(const Slice& key,
     }
   }
 
-  (*entry)->holder_ = tx;
-  return LOCK_ACQUIRED;
+  entry->holder_ = tx;
 }
 
 LockManager::LockStatus LockManager::TryLock(const Slice& key,
@@ -18,6 +18,7 @@
 #define KUDU_TABLET_LOCK_MANAGER_H
 
 #include <cstddef>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/util/slice.h"
@@ -26,6 +27,7 @@ namespace kudu { namespace tablet {
 
 class LockTable;
 class LockEntry;
+class ScopedRowLock;
 class TransactionState;
 
 // Super-simple lock manager implementation. This only supports exclusive
@@ -49,6 +51,19 @@ class LockManager {
     LOCK_EXCLUSIVE
   };
 
+  // Lock all of the rows with the given keys on behalf of 'tx', waiting for
+  // them as needed. Sets 'locks' to the holders of the locks, in the order of
+  // 'keys', which may contain duplicates. The keys must remain valid and
+  // unchanged for the lifetime of the holders.
+  //
+  // The rows are locked in the order of their keys, so that concurrent
+  // batches can't deadlock, and the lock table is looked up once for the
+  // whole batch.
+  void AcquireBatch(const TransactionState* tx,
+                    LockMode mode,
+                    const std::vector<Slice>& keys,
+                    std::vector<ScopedRowLock>* locks);
+
  private:
   friend class ScopedRowLock;
   friend class LockManagerTest;
@@ -59,6 +74,9 @@ class LockManager {
                      LockMode mode, LockEntry **entry);
   void Release(LockEntry *lock, LockStatus ls);
 
+  // Acquire the lock of 'entry', whose key is 'key', on behalf of 'tx'.
+  void AcquireEntry(const Slice& key, const TransactionState* tx, LockEntry* entry);
+
   LockTable *locks_;
 
   DISALLOW_COPY_AND_ASSIGN(LockManager);
@@ -116,6 +134,16 @@ class ScopedRowLock {
   ~ScopedRowLock();
 
  private:
+  friend class LockManager;
+
+  // Take ownership of 'entry', locked with status 'ls'.
+  ScopedRowLock(LockManager* manager, LockEntry* entry, LockManager::LockStatus ls)
+    : manager_(manager),
+      acquired_(ls == LockManager::LOCK_ACQUIRED),
+      entry_(entry),
+      ls_(ls) {
+  }
+
   void TakeState(ScopedRowLock* other);
 
   LockManager *manager_;
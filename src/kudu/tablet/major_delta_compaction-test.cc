@@ -37,12 +37,15 @@
 #include "kudu/tablet/local_tablet_writer.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
+#include "kudu/tablet/rowset_metadata.h"
 #include "kudu/tablet/tablet-test-util.h"
 #include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 
 DECLARE_double(cfile_inject_corruption);
+DECLARE_int32(major_delta_compaction_threads);
 
 using std::shared_ptr;
 using std::string;
@@ -252,6 +255,46 @@ TEST_F(TestMajorDeltaCompaction, TestCompact) {
   }
 }
 
+// Tests a major delta compaction whose columns are compacted in parallel,
+// each group of columns writing its own UNDO file.
+TEST_F(TestMajorDeltaCompaction, TestCompactColumnGroupsInParallel) {
+  FLAGS_major_delta_compaction_threads = 3;
+  const int kNumRows = 100;
+  NO_FATALS(WriteTestTablet(kNumRows));
+  ASSERT_OK(tablet()->Flush());
+
+  vector<shared_ptr<RowSet> > all_rowsets;
+  tablet()->GetRowSetsForTests(&all_rowsets);
+  shared_ptr<RowSet> rs = all_rowsets.front();
+  const auto& rowset_meta = tablet()->metadata()->rowsets().front();
+  ASSERT_EQ(1, rowset_meta->undo_delta_blocks().size());
+
+  MvccSnapshot snap(*tablet()->mvcc_manager());
+  vector<ExpectedRow> old_state(expected_state_);
+
+  NO_FATALS(UpdateRows(kNumRows, false));
+  NO_FATALS(UpdateRows(kNumRows, true));
+  ASSERT_OK(tablet()->FlushBiggestDMS());
+
+  // Each of the three updated columns is compacted by a group of its own.
+  vector<ColumnId> col_ids_to_compact = { schema_.column_id(1),
+                                          schema_.column_id(3),
+                                          schema_.column_id(4) };
+  ASSERT_OK(tablet()->DoMajorDeltaCompaction(col_ids_to_compact, rs));
+  ASSERT_EQ(4, rowset_meta->undo_delta_blocks().size());
+  ASSERT_EQ(0, rowset_meta->redo_delta_blocks().size());
+  NO_FATALS(VerifyData());
+  NO_FATALS(VerifyDataWithMvccAndExpectedState(snap, old_state));
+
+  // Compacting fewer columns than threads keeps the uncompacted deltas.
+  NO_FATALS(UpdateRows(kNumRows, false));
+  ASSERT_OK(tablet()->FlushBiggestDMS());
+  ASSERT_OK(tablet()->DoMajorDeltaCompaction({ schema_.column_id(1), schema_.column_id(4) }, rs));
+  ASSERT_EQ(1, rowset_meta->redo_delta_blocks().size());
+  NO_FATALS(VerifyData());
+  NO_FATALS(VerifyDataWithMvccAndExpectedState(snap, old_state));
+}
+
 // Verify that we do issue UNDO files and that we can read them.
 TEST_F(TestMajorDeltaCompaction, TestUndos) {
   const int kNumRows = 100;
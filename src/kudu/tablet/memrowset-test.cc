@@ -44,6 +44,8 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/strcat.h"
+#include "kudu/tablet/compaction.h"
+#include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet-test-util.h"
@@ -67,6 +69,8 @@ DEFINE_double(update_ratio, 0.2,
 DEFINE_int32(times_to_update, 5000,
              "Number of updates for each row for the update performance test");
 
+DECLARE_bool(mrs_columnar_layout);
+
 namespace kudu {
 namespace tablet {
 
@@ -626,6 +630,36 @@ TEST_F(TestMemRowSet, TestUpdateMVCC) {
   }
 }
 
+// Test that mutations are created in the room allocated after the previous
+// mutation of the row as long as they fit, and chain up correctly.
+TEST_F(TestMemRowSet, TestMutationsInRoomAfter) {
+  Arena arena(1024);
+  faststring buf;
+  RowChangeListEncoder enc(&buf);
+  uint32_t val = 1;
+  enc.AddColumnUpdate(schema_.column(1), schema_.column_id(1), &val);
+  RowChangeList update(buf);
+  const size_t size = Mutation::AllocationSize(update);
+
+  Mutation* head = Mutation::CreateInArena(&arena, Timestamp(0), update, 2 * size);
+  Mutation* tail = head;
+  for (int i = 1; i <= 2; i++) {
+    Mutation* mut = tail->CreateInRoomAfter(Timestamp(i), update);
+    ASSERT_NE(nullptr, mut);
+    ASSERT_EQ(reinterpret_cast<uint8_t*>(tail) + size, reinterpret_cast<uint8_t*>(mut));
+    mut->AppendToListAtomic(&head, &tail);
+  }
+  // The room is used up.
+  ASSERT_EQ(nullptr, tail->CreateInRoomAfter(Timestamp(3), update));
+
+  int i = 0;
+  for (const Mutation* mut = head; mut != nullptr; mut = mut->acquire_next(), i++) {
+    ASSERT_EQ(Timestamp(i), mut->timestamp());
+    ASSERT_EQ(update.slice(), mut->changelist().slice());
+  }
+  ASSERT_EQ(3, i);
+}
+
 class ParameterizedTestMemRowSet : public TestMemRowSet,
                                    public ::testing::WithParamInterface<std::tuple<bool, bool>> {
 };
@@ -779,6 +813,79 @@ TEST_F(TestMemRowSet, TestScanVirtualColumnIsDeleted) {
   }
 }
 
+// Test that a columnar memrowset returns the same rows as a row-oriented one,
+// when scanned with various projections and when flushed.
+TEST_F(TestMemRowSet, TestColumnarLayout) {
+  shared_ptr<MemRowSet> row_mrs;
+  ASSERT_OK(MemRowSet::Create(0, schema_, log_anchor_registry_.get(),
+                              MemTracker::GetRootTracker(), &row_mrs));
+  FLAGS_mrs_columnar_layout = true;
+  shared_ptr<MemRowSet> col_mrs;
+  ASSERT_OK(MemRowSet::Create(1, schema_, log_anchor_registry_.get(),
+                              MemTracker::GetRootTracker(), &col_mrs));
+  ASSERT_FALSE(row_mrs->is_columnar());
+  ASSERT_TRUE(col_mrs->is_columnar());
+
+  // Insert rows out of key order, so that the column store ordinals of
+  // consecutive rows aren't consecutive, and across several chunks.
+  for (MemRowSet* mrs : { row_mrs.get(), col_mrs.get() }) {
+    ASSERT_OK(GenerateTestData(mrs));
+    for (int i = 999; i >= 0; i--) {
+      ASSERT_OK(InsertRow(mrs, StringPrintf("key %03d", i), i));
+    }
+    OperationResultPB result;
+    ASSERT_OK(UpdateRow(mrs, "key 123", 12345, &result));
+  }
+
+  SchemaBuilder sb;
+  ASSERT_OK(sb.AddKeyColumn("key", STRING));
+  ASSERT_OK(sb.AddColumn("val", UINT32));
+  const uint32_t kDefault = 42;
+  ASSERT_OK(sb.AddColumn("added", UINT32, /*is_nullable=*/false,
+                         &kDefault, &kDefault));
+  const bool kFalse = false;
+  ASSERT_OK(sb.AddColumn("deleted", IS_DELETED,
+                         /*is_nullable=*/false,
+                         &kFalse, /*write_default=*/nullptr));
+  const Schema projection = sb.Build();
+
+  for (const Schema* proj : { &schema_, &projection }) {
+    for (bool include_deleted_rows : { false, true }) {
+      RowIteratorOptions opts;
+      opts.projection = proj;
+      opts.snap_to_include = MvccSnapshot::CreateSnapshotIncludingAllTransactions();
+      opts.include_deleted_rows = include_deleted_rows;
+      vector<string> row_rows;
+      vector<string> col_rows;
+      ASSERT_OK(DumpRowSet(*row_mrs, opts, &row_rows));
+      ASSERT_OK(DumpRowSet(*col_mrs, opts, &col_rows));
+      ASSERT_EQ(include_deleted_rows ? 1007 : 1004, col_rows.size());
+      ASSERT_EQ(row_rows, col_rows);
+    }
+  }
+  CheckValue(col_mrs, "key 123", R"((string key="key 123", uint32 val=12345))");
+
+  vector<string> row_dump;
+  vector<string> col_dump;
+  ASSERT_OK(row_mrs->DebugDump(&row_dump));
+  ASSERT_OK(col_mrs->DebugDump(&col_dump));
+  ASSERT_EQ(row_dump, col_dump);
+
+  MvccSnapshot snap = MvccSnapshot::CreateSnapshotIncludingAllTransactions();
+  for (const Schema* proj : { &schema_, &projection }) {
+    unique_ptr<CompactionInput> row_input;
+    unique_ptr<CompactionInput> col_input;
+    ASSERT_OK(row_mrs->NewCompactionInput(proj, snap, nullptr, &row_input));
+    ASSERT_OK(col_mrs->NewCompactionInput(proj, snap, nullptr, &col_input));
+    vector<string> row_rows;
+    vector<string> col_rows;
+    ASSERT_OK(DebugDumpCompactionInput(row_input.get(), &row_rows));
+    ASSERT_OK(DebugDumpCompactionInput(col_input.get(), &col_rows));
+    ASSERT_EQ(1007, col_rows.size());
+    ASSERT_EQ(row_rows, col_rows);
+  }
+}
+
 // Test for update performance.
 // Can simulates zipfian distribution of updates by setting --update_ratio to a small value
 // and --times_to_update to a high value.
@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/memrowset.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -31,6 +32,7 @@
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
+#include "kudu/common/row_transposer.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/consensus/log_anchor_registry.h"
@@ -39,6 +41,7 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/compaction.h"
+#include "kudu/tablet/mrs_column_store.h"
 #include "kudu/tablet/mutation.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/tablet.pb.h"
@@ -50,6 +53,27 @@ DEFINE_bool(mrs_use_codegen, true, "whether the memrowset should use code "
             "generation for iteration");
 TAG_FLAG(mrs_use_codegen, hidden);
 
+DEFINE_bool(mrs_columnar_layout, false,
+            "Whether newly created memrowsets should store the cells of their rows "
+            "in columns rather than in rows. This speeds up flushes and scans of "
+            "recently inserted data, which copy the cells of a batch of rows a "
+            "column at a time.");
+TAG_FLAG(mrs_columnar_layout, experimental);
+
+DEFINE_bool(mrs_arena_huge_pages, false,
+            "Whether the arenas of newly created memrowsets grow in chunks of "
+            "one huge page backed by huge pages. This reduces the TLB misses "
+            "of inserts into and scans of large memrowsets. See also "
+            "--arena_hugetlb and --arena_huge_pages_numa_local.");
+TAG_FLAG(mrs_arena_huge_pages, experimental);
+
+DEFINE_int32(mrs_mutation_run_length, 4,
+             "When a row of a memrowset is mutated for the second time, room is "
+             "reserved for this many mutations of the same size, so that the "
+             "mutations of frequently updated rows are laid out next to each other "
+             "rather than scattered across the arena. 1 disables the reservation.");
+TAG_FLAG(mrs_mutation_run_length, experimental);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -64,6 +88,14 @@ using strings::Substitute;
 
 static const int kInitialArenaSize = 16;
 
+// Returns the allocator the arena of a new memrowset allocates its chunks from.
+static BufferAllocator* ArenaBufferAllocator() {
+  if (FLAGS_mrs_arena_huge_pages) {
+    return HugePageBufferAllocator::Get();
+  }
+  return HeapBufferAllocator::Get();
+}
+
 bool MRSRow::IsGhost() const {
   const Mutation *mut_tail = header_->redo_tail;
   if (mut_tail == nullptr) {
@@ -108,16 +140,21 @@ MemRowSet::MemRowSet(int64_t id,
   : id_(id),
     schema_(schema),
     allocator_(new MemoryTrackingBufferAllocator(
-        HeapBufferAllocator::Get(),
+        ArenaBufferAllocator(),
         CreateMemTrackerForMemRowSet(id, std::move(parent_tracker)))),
     arena_(new ThreadSafeMemoryTrackingArena(kInitialArenaSize, allocator_)),
     tree_(arena_),
+    column_store_(FLAGS_mrs_columnar_layout ? new MRSColumnStore(&schema_, arena_.get())
+                                            : nullptr),
     debug_insert_count_(0),
     debug_update_count_(0),
     anchorer_(log_anchor_registry, Substitute("MemRowSet-$0", id_)),
     has_been_compacted_(false),
     live_row_count_(0) {
   CHECK(schema.has_column_ids());
+  if (FLAGS_mrs_arena_huge_pages) {
+    arena_->SetMaxBufferSize(HugePageBufferAllocator::kHugePageSize);
+  }
   ANNOTATE_BENIGN_RACE(&debug_insert_count_, "insert count isnt accurate");
   ANNOTATE_BENIGN_RACE(&debug_update_count_, "update count isnt accurate");
 }
@@ -132,7 +169,8 @@ Status MemRowSet::DebugDump(vector<string> *lines) {
     MRSRow row = iter->GetCurrentRow();
     LOG_STRING(INFO, lines)
       << "@" << row.insertion_timestamp() << ": row "
-      << schema_.DebugRow(row)
+      << (column_store_ ? schema_.DebugRow(iter->MaterializeColumnarRow())
+                        : schema_.DebugRow(row))
       << " mutations=" << Mutation::StringifyMutationList(schema_, row.header_->redo_head)
       << std::endl;
     iter->Next();
@@ -173,17 +211,35 @@ Status MemRowSet::Insert(Timestamp timestamp,
       return Reinsert(timestamp, row, &ms_row);
     }
 
-    // Copy the non-encoded key onto the stack since we need
-    // to mutate it when we relocate its Slices into our arena.
-    DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
-    mrsrow.header_->insertion_timestamp = timestamp;
-    mrsrow.header_->redo_head = nullptr;
-    mrsrow.header_->redo_tail = nullptr;
-    RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
-
-    CHECK(mutation.Insert(mrsrow_slice))
-    << "Expected to be able to insert, since the prepared mutation "
-    << "succeeded!";
+    if (column_store_) {
+      // The value only holds the header and the ordinal of the cells of the
+      // row in the column store.
+      uint8_t value_buf[sizeof(MRSRow::Header) + sizeof(uint32_t)];
+      Slice value(value_buf, sizeof(value_buf));
+      MRSRow mrsrow(this, value);
+      mrsrow.header_->insertion_timestamp = timestamp;
+      mrsrow.header_->redo_head = nullptr;
+      mrsrow.header_->redo_tail = nullptr;
+      uint32_t ordinal;
+      RETURN_NOT_OK(column_store_->AppendRow(row, &ordinal));
+      UnalignedStore(value_buf + sizeof(MRSRow::Header), ordinal);
+
+      CHECK(mutation.Insert(value))
+      << "Expected to be able to insert, since the prepared mutation "
+      << "succeeded!";
+    } else {
+      // Copy the non-encoded key onto the stack since we need
+      // to mutate it when we relocate its Slices into our arena.
+      DEFINE_MRSROW_ON_STACK(this, mrsrow, mrsrow_slice);
+      mrsrow.header_->insertion_timestamp = timestamp;
+      mrsrow.header_->redo_head = nullptr;
+      mrsrow.header_->redo_tail = nullptr;
+      RETURN_NOT_OK(mrsrow.CopyRow(row, arena_.get()));
+
+      CHECK(mutation.Insert(mrsrow_slice))
+      << "Expected to be able to insert, since the prepared mutation "
+      << "succeeded!";
+    }
   }
 
   anchorer_.AnchorIfMinimum(op_id.index());
@@ -193,6 +249,22 @@ Status MemRowSet::Insert(Timestamp timestamp,
   return Status::OK();
 }
 
+Mutation* MemRowSet::NewMutation(const MRSRow& row,
+                                 Timestamp timestamp,
+                                 const RowChangeList& rcl) {
+  Mutation* tail = row.header_->redo_tail;
+  if (tail == nullptr) {
+    return Mutation::CreateInArena(arena_.get(), timestamp, rcl);
+  }
+  Mutation* mut = tail->CreateInRoomAfter(timestamp, rcl);
+  if (mut != nullptr) {
+    return mut;
+  }
+  // A row mutated more than once is likely to be mutated again.
+  size_t room = (std::max(FLAGS_mrs_mutation_run_length, 1) - 1) * Mutation::AllocationSize(rcl);
+  return Mutation::CreateInArena(arena_.get(), timestamp, rcl, room);
+}
+
 Status MemRowSet::Reinsert(Timestamp timestamp, const ConstContiguousRow& row, MRSRow *ms_row) {
   DCHECK_SCHEMA_EQ(schema_, *row.schema());
 
@@ -202,7 +274,7 @@ Status MemRowSet::Reinsert(Timestamp timestamp, const ConstContiguousRow& row, M
   encoder.SetToReinsert(row);
 
   // Move the REINSERT mutation itself into our Arena.
-  Mutation *mut = Mutation::CreateInArena(arena_.get(), timestamp, encoder.as_changelist());
+  Mutation *mut = NewMutation(*ms_row, timestamp, encoder.as_changelist());
 
   // Append the mutation into the row's mutation list.
   // This function has "release" semantics which ensures that the memory writes
@@ -239,7 +311,7 @@ Status MemRowSet::MutateRow(Timestamp timestamp,
     }
 
     // Append to the linked list of mutations for this row.
-    Mutation *mut = Mutation::CreateInArena(arena_.get(), timestamp, delta);
+    Mutation *mut = NewMutation(row, timestamp, delta);
 
     // This function has "release" semantics which ensures that the memory writes
     // for the mutation are fully published before any concurrent reader sees
@@ -260,6 +332,55 @@ Status MemRowSet::MutateRow(Timestamp timestamp,
   return Status::OK();
 }
 
+Status MemRowSet::DeleteRange(Timestamp timestamp,
+                              const Slice& lower_bound_key,
+                              const Slice& upper_bound_key,
+                              const consensus::OpId& op_id,
+                              const IOContext* /*io_context*/,
+                              OperationResultPB* result) {
+  // Collect the keys of the range first, since the tree can't be mutated
+  // while it's being iterated.
+  vector<string> keys;
+  {
+    unique_ptr<MSBTIter> iter(tree_.NewIterator());
+    bool exact;
+    if (iter->SeekAtOrAfter(lower_bound_key, &exact)) {
+      do {
+        Slice key = iter->GetCurrentKey();
+        if (key.compare(upper_bound_key) >= 0) {
+          break;
+        }
+        keys.emplace_back(key.ToString());
+      } while (iter->Next());
+    }
+  }
+
+  const RowChangeList delete_changelist = RowChangeList::CreateDelete();
+  int64_t deleted_count = 0;
+  for (const string& key : keys) {
+    btree::PreparedMutation<MSBTreeTraits> mutation(key);
+    mutation.Prepare(&tree_);
+    DCHECK(mutation.exists());
+    MRSRow row(this, mutation.current_mutable_value());
+    if (row.IsGhost()) {
+      continue;
+    }
+    Mutation *mut = NewMutation(row, timestamp, delete_changelist);
+    mut->AppendToListAtomic(&row.header_->redo_head, &row.header_->redo_tail);
+    deleted_count++;
+  }
+  if (deleted_count == 0) {
+    return Status::OK();
+  }
+
+  MemStoreTargetPB* target = result->add_mutated_stores();
+  target->set_mrs_id(id_);
+  anchorer_.AnchorIfMinimum(op_id.index());
+  debug_update_count_ += deleted_count;
+  live_row_count_.IncrementBy(-deleted_count);
+  return Status::OK();
+}
+
 Status MemRowSet::CheckRowPresent(const RowSetKeyProbe &probe, const IOContext* /*io_context*/,
                                   bool* present, ProbeStats* stats) const {
   // Use a PreparedMutation here even though we don't plan to mutate. Even though
@@ -331,6 +452,7 @@ class MemRowSet::Iterator::MRSRowProjector {
                                    RowBlockRow* dst_row,
                                    Arena* arena) = 0;
   virtual const vector<ProjectionIdxMapping>& base_cols_mapping() const = 0;
+  virtual const vector<size_t>& projection_defaults() const = 0;
   virtual Status Init() = 0;
 };
 
@@ -360,6 +482,10 @@ class MRSRowProjectorImpl : public MRSRowProjector {
     return actual_->base_cols_mapping();
   }
 
+  const vector<size_t>& projection_defaults() const override {
+    return actual_->projection_defaults();
+  }
+
  private:
   unique_ptr<ActualProjector> actual_;
 };
@@ -411,6 +537,10 @@ Status MemRowSet::Iterator::Init(ScanSpec *spec) {
 
   RETURN_NOT_OK(projector_->Init());
   RETURN_NOT_OK(delta_projector_.Init());
+  if (!memrowset_->is_columnar()) {
+    transposer_.reset(new RowTransposer(&memrowset_->schema_nonvirtual(), opts_.projection,
+                                        projector_->base_cols_mapping()));
+  }
 
   if (spec && spec->lower_bound_key()) {
     bool exact;
@@ -428,6 +558,10 @@ Status MemRowSet::Iterator::Init(ScanSpec *spec) {
     exclusive_upper_bound_.reset(upper_bound);
   }
 
+  if (spec && spec->key_ranges().size() > 1) {
+    key_ranges_ = &spec->key_ranges();
+  }
+
   state_ = kScanning;
   return Status::OK();
 }
@@ -478,7 +612,11 @@ Status MemRowSet::Iterator::NextBlock(RowBlock *dst) {
   // Fill
   dst->selection_vector()->SetAllTrue();
   size_t fetched;
-  RETURN_NOT_OK(FetchRows(dst, &fetched));
+  if (memrowset_->is_columnar()) {
+    RETURN_NOT_OK(FetchColumnarRows(dst, &fetched));
+  } else {
+    RETURN_NOT_OK(FetchRows(dst, &fetched));
+  }
   DCHECK_LE(0, fetched);
   DCHECK_LE(fetched, dst->nrows());
 
@@ -497,6 +635,10 @@ Status MemRowSet::Iterator::FetchRows(RowBlock* dst, size_t* fetched) {
     // and relocating slices.
     // TODO(todd): can we share some code here with CopyRowToArena() from row.h
     // or otherwise put this elsewhere?
+    if (key_ranges_ && !SeekToKeyRange()) {
+      state_ = kFinished;
+      break;
+    }
     Slice v = iter_->GetCurrentValue();
     MRSRow row(memrowset_.get(), v);
 
@@ -520,43 +662,162 @@ Status MemRowSet::Iterator::FetchRows(RowBlock* dst, size_t* fetched) {
     // time range, so we must still project the row and walk its mutation list.
     bool insert_excluded = opts_.snap_to_exclude &&
                            opts_.snap_to_exclude->IsCommitted(row.insertion_timestamp());
-    bool unset_in_sel_vector;
-    ApplyStatus apply_status;
-    if (insert_excluded || opts_.snap_to_include.IsCommitted(row.insertion_timestamp())) {
+    bool visible = insert_excluded ||
+                   opts_.snap_to_include.IsCommitted(row.insertion_timestamp());
+    if (visible) {
       RETURN_NOT_OK(projector_->ProjectRowForRead(row, &dst_row, dst->arena()));
-
-      // Roll-forward MVCC for committed updates.
-      Mutation* redo_head = reinterpret_cast<Mutation*>(
-          base::subtle::Acquire_Load(reinterpret_cast<AtomicWord*>(&row.header_->redo_head)));
-      RETURN_NOT_OK(ApplyMutationsToProjectedRow(
-          redo_head, &dst_row, dst->arena(), insert_excluded, &apply_status));
-      unset_in_sel_vector = (apply_status == APPLIED_AND_DELETED && !opts_.include_deleted_rows) ||
-                            (apply_status == NONE_APPLIED && insert_excluded) ||
-                            (apply_status == APPLIED_AND_UNOBSERVABLE);
-    } else {
-      // The insertion is too new; the entire row should be omitted.
-      unset_in_sel_vector = true;
     }
 
-    if (unset_in_sel_vector) {
-      dst->selection_vector()->SetRowUnselected(*fetched);
+    // Roll-forward MVCC for committed updates.
+    RETURN_NOT_OK(ApplyMutationsAndSelect(visible, insert_excluded, row.acquire_redo_head(),
+                                          dst, *fetched));
 
-      // In debug mode, fill the row data for easy debugging
-      #ifndef NDEBUG
-      if (state_ != kFinished) {
-        dst_row.OverwriteWithPattern("MVCCMVCCMVCCMVCCMVCCMVCC"
-                                     "MVCCMVCCMVCCMVCCMVCCMVCC"
-                                     "MVCCMVCCMVCCMVCCMVCCMVCC");
+    ++*fetched;
+  } while (iter_->Next() && *fetched < dst->nrows());
+
+  return Status::OK();
+}
+
+Status MemRowSet::Iterator::FetchColumnarRows(RowBlock* dst, size_t* fetched) {
+  const size_t nrows = dst->nrows();
+  batch_ordinals_.resize(nrows);
+  batch_insertion_timestamps_.resize(nrows);
+  batch_redo_heads_.resize(nrows);
+
+  // Collect the rows of the batch from the tree first, so that their cells
+  // can be projected one column at a time.
+  size_t n = 0;
+  do {
+    if (key_ranges_ && !SeekToKeyRange()) {
+      state_ = kFinished;
+      break;
+    }
+    // Short-circuit if we've exceeded the iteration's upper bound.
+    if (has_upper_bound() && out_of_bounds(iter_->GetCurrentKey())) {
+      state_ = kFinished;
+      break;
+    }
+    MRSRow row(memrowset_.get(), iter_->GetCurrentValue());
+    batch_ordinals_[n] = MemRowSet::column_store_ordinal(row);
+    batch_insertion_timestamps_[n] = row.insertion_timestamp();
+    batch_redo_heads_[n] = row.acquire_redo_head();
+    n++;
+  } while (iter_->Next() && n < nrows);
+
+  // Rows whose insertion isn't visible are projected too, and unselected
+  // below.
+  RETURN_NOT_OK(ProjectColumnarRows(batch_ordinals_.data(), n, dst, dst->arena()));
+
+  for (size_t i = 0; i < n; i++) {
+    // See FetchRows() for the handling of the iterator's time range.
+    bool insert_excluded = opts_.snap_to_exclude &&
+                           opts_.snap_to_exclude->IsCommitted(batch_insertion_timestamps_[i]);
+    bool visible = insert_excluded ||
+                   opts_.snap_to_include.IsCommitted(batch_insertion_timestamps_[i]);
+    RETURN_NOT_OK(ApplyMutationsAndSelect(visible, insert_excluded, batch_redo_heads_[i],
+                                          dst, i));
+  }
+  *fetched = n;
+  return Status::OK();
+}
+
+bool MemRowSet::Iterator::SeekToKeyRange() {
+  while (key_range_idx_ < key_ranges_->size()) {
+    const auto& range = (*key_ranges_)[key_range_idx_];
+    Slice key = iter_->GetCurrentKey();
+    if (!range.second.empty() && key.compare(range.second) >= 0) {
+      key_range_idx_++;
+      continue;
+    }
+    if (key.compare(range.first) < 0) {
+      bool exact;
+      if (!iter_->SeekAtOrAfter(Slice(range.first), &exact)) {
+        return false;
       }
-      #endif
-    } else if (projection_vc_is_deleted_idx_ != Schema::kColumnNotFound) {
-      UnalignedStore(dst_row.mutable_cell_ptr(projection_vc_is_deleted_idx_),
-                     apply_status == APPLIED_AND_DELETED);
+      continue;
     }
+    return true;
+  }
+  return false;
+}
 
-    ++*fetched;
-  } while (iter_->Next() && *fetched < dst->nrows());
+Status MemRowSet::Iterator::ProjectColumnarRows(const uint32_t* ordinals,
+                                                size_t nrows,
+                                                RowBlock* dst,
+                                                Arena* arena) {
+  DCHECK(memrowset_->is_columnar());
+  const MRSColumnStore* store = memrowset_->column_store_.get();
+  for (const auto& mapping : projector_->base_cols_mapping()) {
+    ColumnBlock dst_col = dst->column_block(mapping.first);
+    RETURN_NOT_OK(store->CopyColumn(mapping.second, ordinals, nrows, 0, &dst_col, arena));
+  }
+  return FillDefaults(nrows, dst, arena);
+}
 
+Status MemRowSet::Iterator::ProjectRowwiseRows(const uint8_t* const* row_datas,
+                                               size_t nrows,
+                                               RowBlock* dst,
+                                               Arena* arena) {
+  DCHECK(!memrowset_->is_columnar());
+  RETURN_NOT_OK(transposer_->Transpose(row_datas, nrows, dst, arena));
+  return FillDefaults(nrows, dst, arena);
+}
+
+Status MemRowSet::Iterator::FillDefaults(size_t nrows, RowBlock* dst, Arena* arena) {
+  for (auto proj_idx : projector_->projection_defaults()) {
+    const ColumnSchema& col_proj = opts_.projection->column(proj_idx);
+    SimpleConstCell src_cell(&col_proj, col_proj.read_default_value());
+    ColumnBlock dst_col = dst->column_block(proj_idx);
+    for (size_t i = 0; i < nrows; i++) {
+      ColumnBlockCell dst_cell = dst_col.cell(i);
+      RETURN_NOT_OK(CopyCell(src_cell, &dst_cell, arena));
+    }
+  }
+  return Status::OK();
+}
+
+ConstContiguousRow MemRowSet::Iterator::MaterializeColumnarRow() {
+  const Schema& schema = memrowset_->schema_nonvirtual();
+  row_buf_.resize(ContiguousRowHelper::row_size(schema));
+  ContiguousRow row(&schema, row_buf_.data());
+  memrowset_->column_store_->CopyRow(current_row_ordinal(), &row);
+  return ConstContiguousRow(row);
+}
+
+Status MemRowSet::Iterator::ApplyMutationsAndSelect(bool visible,
+                                                    bool insert_excluded,
+                                                    const Mutation* redo_head,
+                                                    RowBlock* dst,
+                                                    size_t row_idx) {
+  RowBlockRow dst_row = dst->row(row_idx);
+  bool unset_in_sel_vector;
+  ApplyStatus apply_status;
+  if (visible) {
+    RETURN_NOT_OK(ApplyMutationsToProjectedRow(
+        redo_head, &dst_row, dst->arena(), insert_excluded, &apply_status));
+    unset_in_sel_vector = (apply_status == APPLIED_AND_DELETED && !opts_.include_deleted_rows) ||
+                          (apply_status == NONE_APPLIED && insert_excluded) ||
+                          (apply_status == APPLIED_AND_UNOBSERVABLE);
+  } else {
+    // The insertion is too new; the entire row should be omitted.
+    unset_in_sel_vector = true;
+  }
+
+  if (unset_in_sel_vector) {
+    dst->selection_vector()->SetRowUnselected(row_idx);
+
+    // In debug mode, fill the row data for easy debugging
+    #ifndef NDEBUG
+    if (state_ != kFinished) {
+      dst_row.OverwriteWithPattern("MVCCMVCCMVCCMVCCMVCCMVCC"
+                                   "MVCCMVCCMVCCMVCCMVCCMVCC"
+                                   "MVCCMVCCMVCCMVCCMVCCMVCC");
+    }
+    #endif
+  } else if (projection_vc_is_deleted_idx_ != Schema::kColumnNotFound) {
+    UnalignedStore(dst_row.mutable_cell_ptr(projection_vc_is_deleted_idx_),
+                   apply_status == APPLIED_AND_DELETED);
+  }
   return Status::OK();
 }
 
@@ -666,6 +927,18 @@ Status MemRowSet::Iterator::GetCurrentRow(RowBlockRow* dst_row,
                                           Arena* mutation_arena,
                                           Timestamp* insertion_timestamp) {
 
+  RETURN_NOT_OK(GetCurrentRowMutations(redo_head, mutation_arena, insertion_timestamp));
+
+  // Project the Row
+  if (memrowset_->is_columnar()) {
+    return projector_->ProjectRowForRead(MaterializeColumnarRow(), dst_row, row_arena);
+  }
+  return projector_->ProjectRowForRead(GetCurrentRow(), dst_row, row_arena);
+}
+
+Status MemRowSet::Iterator::GetCurrentRowMutations(Mutation** redo_head,
+                                                   Arena* mutation_arena,
+                                                   Timestamp* insertion_timestamp) {
   DCHECK(redo_head != nullptr);
 
   // Get the row from the MemRowSet. It may have a different schema from the iterator projection.
@@ -704,9 +977,7 @@ Status MemRowSet::Iterator::GetCurrentRow(RowBlockRow* dst_row,
       prev_redo = mutation;
     }
   }
-
-  // Project the Row
-  return projector_->ProjectRowForRead(src_row, dst_row, row_arena);
+  return Status::OK();
 }
 
 } // namespace tablet
@@ -23,6 +23,7 @@
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -37,6 +38,7 @@
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
 #include "kudu/tablet/concurrent_btree.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
@@ -54,6 +56,7 @@ class MemoryTrackingBufferAllocator;
 class RowBlock;
 class RowBlockRow;
 class RowChangeList;
+class RowTransposer;
 class ScanSpec;
 
 namespace fs {
@@ -85,6 +88,7 @@ namespace tablet {
 // thread-safe arena, and then freed in bulk when the MemRowSet is destructed.
 
 class CompactionInput;
+class MRSColumnStore;
 class MemRowSet;
 class Mutation;
 class OperationResultPB;
@@ -198,10 +202,14 @@ struct MSBTreeTraits : public btree::BTreeTraits {
 
 
 // In-memory storage for data currently being written to the tablet.
-// This is a holding area for inserts, currently held in row form
-// (i.e not columnar)
+// This is a holding area for inserts, held in row form by default.
 //
 // The data is kept sorted.
+//
+// If --mrs_columnar_layout is set, the cells of inserted rows are instead
+// appended to per-column arrays (see MRSColumnStore), and the CBTree only
+// maps each key to the row's header and its ordinal in those arrays. Scans
+// and flushes then copy the cells of a batch of rows one column at a time.
 class MemRowSet : public RowSet,
                   public std::enable_shared_from_this<MemRowSet> {
  public:
@@ -241,6 +249,14 @@ class MemRowSet : public RowSet,
                            ProbeStats* stats,
                            OperationResultPB *result) override;
 
+  // Delete each live row of the range as MutateRow() would.
+  Status DeleteRange(Timestamp timestamp,
+                     const Slice& lower_bound_key,
+                     const Slice& upper_bound_key,
+                     const consensus::OpId& op_id,
+                     const fs::IOContext* io_context,
+                     OperationResultPB* result) override;
+
   // Return the number of entries in the memrowset.
   // NOTE: this requires iterating all data, and is thus
   // not very fast.
@@ -300,6 +316,11 @@ class MemRowSet : public RowSet,
     return tree_.empty();
   }
 
+  // Return true if the cells of the rows are stored in columns.
+  bool is_columnar() const {
+    return column_store_ != nullptr;
+  }
+
   // TODO(todd): unit test me
   Status CheckRowPresent(const RowSetKeyProbe &probe, const fs::IOContext* io_context,
                          bool *present, ProbeStats* stats) const override;
@@ -377,6 +398,8 @@ class MemRowSet : public RowSet,
 
   bool DeltaMemStoreEmpty() const override { return true; }
 
+  int64_t DeltaMemStoreDeltasScanned() const override { return 0; }
+
   int64_t MinUnflushedLogIndex() const override {
     return anchorer_.minimum_log_index();
   }
@@ -400,6 +423,12 @@ class MemRowSet : public RowSet,
     return Status::OK();
   }
 
+  Status IsFullyExpired(const RowExpiry& /*row_expiry*/, bool* expired) override {
+    DCHECK(expired);
+    *expired = false;
+    return Status::OK();
+  }
+
   Status InitUndoDeltas(Timestamp /*ancient_history_mark*/,
                         MonoTime /*deadline*/,
                         const fs::IOContext* /*io_context*/,
@@ -431,12 +460,26 @@ class MemRowSet : public RowSet,
             log::LogAnchorRegistry* log_anchor_registry,
             std::shared_ptr<MemTracker> parent_tracker);
 
+  // Creates the mutation to append to the mutations of 'row', in the room
+  // left after the row's last mutation if there's enough of it. Otherwise,
+  // if the row has been mutated before, room for the next mutations of the
+  // row is allocated along with the new one (see --mrs_mutation_run_length).
+  //
+  // Callers must hold the row's lock.
+  Mutation* NewMutation(const MRSRow& row, Timestamp timestamp, const RowChangeList& rcl);
+
   // Perform a "Reinsert" -- handle an insertion into a row which was previously
   // inserted and deleted, but still has an entry in the MemRowSet.
   Status Reinsert(Timestamp timestamp,
                   const ConstContiguousRow& row,
                   MRSRow *ms_row);
 
+  // Return the ordinal in 'column_store_' of the cells of the given row.
+  // Only valid if the memrowset is columnar.
+  static uint32_t column_store_ordinal(const MRSRow& row) {
+    return UnalignedLoad<uint32_t>(row.row_data());
+  }
+
   typedef btree::CBTree<MSBTreeTraits> MSBTree;
 
   int64_t id_;
@@ -449,6 +492,10 @@ class MemRowSet : public RowSet,
 
   MSBTree tree_;
 
+  // The cells of the rows, if the memrowset is columnar. Otherwise, the cells
+  // are stored in the values of 'tree_'.
+  std::unique_ptr<MRSColumnStore> column_store_;
+
   // Approximate counts of mutations. This variable is updated non-atomically,
   // so it cannot be relied upon to be in any way accurate. It's only used
   // as a sanity check during flush.
@@ -526,6 +573,43 @@ class MemRowSet::Iterator : public RowwiseIterator {
                        Arena* mutation_arena,
                        Timestamp* insertion_timestamp);
 
+  // Like GetCurrentRow(), but only returns the mutations and insertion
+  // timestamp of the current row, projected with the iterator projection
+  // schema. The cells of the row may be copied with the cells of other rows
+  // using ProjectColumnarRows().
+  Status GetCurrentRowMutations(Mutation** redo_head,
+                                Arena* mutation_arena,
+                                Timestamp* insertion_timestamp);
+
+  // Return true if the iterated memrowset is columnar.
+  bool is_columnar() const {
+    return memrowset_->is_columnar();
+  }
+
+  // Return the ordinal of the cells of the current row in the column store.
+  // Only valid if the memrowset is columnar.
+  uint32_t current_row_ordinal() const {
+    DCHECK(is_columnar());
+    return MemRowSet::column_store_ordinal(GetCurrentRow());
+  }
+
+  // Copy the cells of the 'nrows' rows with the given column store ordinals
+  // into the first rows of 'dst', one column at a time, using the iterator
+  // projection schema. Indirect data is copied into 'arena' unless it is
+  // null. Only valid if the memrowset is columnar.
+  Status ProjectColumnarRows(const uint32_t* ordinals,
+                             size_t nrows,
+                             RowBlock* dst,
+                             Arena* arena);
+
+  // Like ProjectColumnarRows(), but for the rows with the given data in a
+  // memrowset which isn't columnar (see MRSRow::row_data()), which are
+  // transposed into the columns of 'dst' with a RowTransposer.
+  Status ProjectRowwiseRows(const uint8_t* const* row_datas,
+                            size_t nrows,
+                            RowBlock* dst,
+                            Arena* arena);
+
   bool Next() {
     DCHECK_NE(state_, kUninitialized) << "not initted";
     return iter_->Next();
@@ -569,6 +653,32 @@ class MemRowSet::Iterator : public RowwiseIterator {
   // Writes the number of rows retrieved to 'fetched'.
   Status FetchRows(RowBlock* dst, size_t* fetched);
 
+  // Same as FetchRows(), for columnar memrowsets.
+  Status FetchColumnarRows(RowBlock* dst, size_t* fetched);
+
+  // Advances the tree iterator to the first row at or after its current row
+  // which falls in one of the scan's key ranges, seeking over the gaps
+  // between them. Returns false if no such row exists.
+  bool SeekToKeyRange();
+
+  // Materialize the cells of the current row of a columnar memrowset into
+  // 'row_buf_', and return the row.
+  ConstContiguousRow MaterializeColumnarRow();
+
+  // Fills the first 'nrows' rows of the projected columns of 'dst' which
+  // aren't in the memrowset's schema with their default values.
+  Status FillDefaults(size_t nrows, RowBlock* dst, Arena* arena);
+
+  // Finish the row with index 'row_idx' of 'dst', whose cells have been
+  // projected if the row is 'visible': an invisible row was inserted after
+  // the end of the iterator's time range. Applies the mutations starting at
+  // 'redo_head' to the row, and unselects it if it should not be returned.
+  Status ApplyMutationsAndSelect(bool visible,
+                                 bool insert_excluded,
+                                 const Mutation* redo_head,
+                                 RowBlock* dst,
+                                 size_t row_idx);
+
   // Walks the mutations in 'mutation_head', applying relevant ones to 'dst_row'
   // (performing any allocations out of 'dst_arena'). 'insert_excluded' is true
   // if the row's original insertion took place outside the iterator's time range.
@@ -620,6 +730,18 @@ class MemRowSet::Iterator : public RowwiseIterator {
   // seek target.
   faststring tmp_buf;
 
+  // Transposes batches of rows into the projection, if the memrowset isn't
+  // columnar. Set up by Init().
+  std::unique_ptr<RowTransposer> transposer_;
+
+  // For columnar memrowsets: a buffer holding a single row in the memrowset
+  // schema, and the column store ordinals, insertion timestamps and
+  // mutations of the rows of the batch being fetched.
+  faststring row_buf_;
+  std::vector<uint32_t> batch_ordinals_;
+  std::vector<Timestamp> batch_insertion_timestamps_;
+  std::vector<const Mutation*> batch_redo_heads_;
+
   // State of the scanner: indicates whether we should keep scanning/fetching,
   // whether we've scanned the last batch, or whether we've reached the upper bounds
   // or will never reach the lower bounds (no more rows can be returned)
@@ -627,6 +749,11 @@ class MemRowSet::Iterator : public RowwiseIterator {
 
   // Pushed down encoded upper bound key, if any
   boost::optional<const Slice &> exclusive_upper_bound_;
+
+  // The scan's sorted disjoint key ranges, if it has several, and the index
+  // of the range the tree iterator is in or before.
+  const std::vector<std::pair<std::string, std::string>>* key_ranges_ = nullptr;
+  size_t key_range_idx_ = 0;
 };
 
 inline const Schema* MRSRow::schema() const {
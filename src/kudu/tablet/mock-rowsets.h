@@ -53,6 +53,15 @@ class MockRowSet : public RowSet {
     LOG(FATAL) << "Unimplemented";
     return Status::OK();
   }
+  virtual Status DeleteRange(Timestamp /*timestamp*/,
+                             const Slice& /*lower_bound_key*/,
+                             const Slice& /*upper_bound_key*/,
+                             const consensus::OpId& /*op_id_*/,
+                             const fs::IOContext* /*io_context*/,
+                             OperationResultPB* /*result*/) override {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
   virtual Status NewRowIterator(const RowIteratorOptions& /*opts*/,
                                 std::unique_ptr<RowwiseIterator>* /*out*/) const override {
     LOG(FATAL) << "Unimplemented";
@@ -126,6 +135,11 @@ class MockRowSet : public RowSet {
     return 0;
   }
 
+  virtual int64_t DeltaMemStoreDeltasScanned() const override {
+    LOG(FATAL) << "Unimplemented";
+    return 0;
+  }
+
   virtual int64_t MinUnflushedLogIndex() const override {
     LOG(FATAL) << "Unimplemented";
     return -1;
@@ -153,6 +167,12 @@ class MockRowSet : public RowSet {
     return Status::OK();
   }
 
+  virtual Status IsFullyExpired(const RowExpiry& /*row_expiry*/,
+                                bool* /*expired*/) override {
+    LOG(FATAL) << "Unimplemented";
+    return Status::OK();
+  }
+
   virtual Status EstimateBytesInPotentiallyAncientUndoDeltas(Timestamp /*ancient_history_mark*/,
                                                              int64_t* /*bytes*/) override {
     LOG(FATAL) << "Unimplemented";
@@ -0,0 +1,227 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/mrs_column_store.h"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <glog/logging.h>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/row.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/port.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+namespace tablet {
+
+namespace {
+
+// The alignment of the cells of each column within a chunk.
+constexpr size_t kCellAlignment = 16;
+
+size_t AlignUp(size_t size) {
+  return (size + kCellAlignment - 1) & ~(kCellAlignment - 1);
+}
+
+} // anonymous namespace
+
+MRSColumnStore::MRSColumnStore(const Schema* schema, ThreadSafeMemoryTrackingArena* arena)
+    : schema_(schema),
+      arena_(arena),
+      chunk_size_(0),
+      next_ordinal_(0) {
+  for (size_t i = 0; i < schema_->num_columns(); i++) {
+    const ColumnSchema& col = schema_->column(i);
+    cell_offsets_.push_back(chunk_size_);
+    chunk_size_ += AlignUp(kRowsPerChunk * col.type_info()->size());
+    if (col.is_nullable()) {
+      null_offsets_.push_back(chunk_size_);
+      chunk_size_ += AlignUp(kRowsPerChunk);
+    } else {
+      null_offsets_.push_back(0);
+    }
+  }
+  for (auto& group : groups_) {
+    group.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+const uint8_t* MRSColumnStore::chunk(uint32_t ordinal) const {
+  const ChunkPtr* group = groups_[ordinal >> (kRowsPerChunkShift + kChunksPerGroupShift)].load(
+      std::memory_order_acquire);
+  DCHECK(group != nullptr);
+  const uint8_t* c = group[(ordinal >> kRowsPerChunkShift) & (kChunksPerGroup - 1)].load(
+      std::memory_order_acquire);
+  DCHECK(c != nullptr);
+  return c;
+}
+
+uint8_t* MRSColumnStore::GetOrAllocateChunk(uint32_t ordinal) {
+  std::atomic<ChunkPtr*>* group_ptr =
+      &groups_[ordinal >> (kRowsPerChunkShift + kChunksPerGroupShift)];
+  ChunkPtr* group = group_ptr->load(std::memory_order_acquire);
+  ChunkPtr* chunk_ptr = nullptr;
+  uint8_t* c = nullptr;
+  if (PREDICT_TRUE(group != nullptr)) {
+    chunk_ptr = &group[(ordinal >> kRowsPerChunkShift) & (kChunksPerGroup - 1)];
+    c = chunk_ptr->load(std::memory_order_acquire);
+    if (PREDICT_TRUE(c != nullptr)) {
+      return c;
+    }
+  }
+
+  // Rows of the same chunk may be appended concurrently: only one of the
+  // appending threads allocates it.
+  std::lock_guard<simple_spinlock> l(alloc_lock_);
+  group = group_ptr->load(std::memory_order_relaxed);
+  if (group == nullptr) {
+    void* mem = arena_->AllocateBytesAligned(kChunksPerGroup * sizeof(ChunkPtr),
+                                             alignof(ChunkPtr));
+    if (PREDICT_FALSE(mem == nullptr)) {
+      return nullptr;
+    }
+    group = static_cast<ChunkPtr*>(mem);
+    for (size_t i = 0; i < kChunksPerGroup; i++) {
+      new (&group[i]) ChunkPtr(nullptr);
+    }
+    group_ptr->store(group, std::memory_order_release);
+  }
+  chunk_ptr = &group[(ordinal >> kRowsPerChunkShift) & (kChunksPerGroup - 1)];
+  c = chunk_ptr->load(std::memory_order_relaxed);
+  if (c == nullptr) {
+    c = static_cast<uint8_t*>(arena_->AllocateBytesAligned(chunk_size_, kCellAlignment));
+    if (PREDICT_FALSE(c == nullptr)) {
+      return nullptr;
+    }
+    chunk_ptr->store(c, std::memory_order_release);
+  }
+  return c;
+}
+
+Status MRSColumnStore::AppendRow(const ConstContiguousRow& row, uint32_t* ordinal) {
+  DCHECK_SCHEMA_EQ(*schema_, *row.schema());
+  uint32_t ord = next_ordinal_.fetch_add(1, std::memory_order_relaxed);
+  if (PREDICT_FALSE(ord >= kMaxRows)) {
+    return Status::ServiceUnavailable("memrowset holds the maximum number of rows");
+  }
+  uint8_t* c = GetOrAllocateChunk(ord);
+  if (PREDICT_FALSE(c == nullptr)) {
+    return Status::IOError("out of memory copying row into memrowset");
+  }
+
+  const size_t idx = idx_in_chunk(ord);
+  for (size_t i = 0; i < schema_->num_columns(); i++) {
+    const ColumnSchema& col = schema_->column(i);
+    const size_t size = col.type_info()->size();
+    if (col.is_nullable()) {
+      bool is_null = row.is_null(i);
+      c[null_offsets_[i] + idx] = is_null;
+      if (is_null) {
+        continue;
+      }
+    }
+    uint8_t* dst = c + cell_offsets_[i] + idx * size;
+    memcpy(dst, row.cell_ptr(i), size);
+    if (col.type_info()->physical_type() == BINARY) {
+      Slice* slice = reinterpret_cast<Slice*>(dst);
+      if (PREDICT_FALSE(!arena_->RelocateSlice(*slice, slice))) {
+        return Status::IOError("out of memory copying row into memrowset");
+      }
+    }
+  }
+  *ordinal = ord;
+  return Status::OK();
+}
+
+Status MRSColumnStore::CopyColumn(size_t col_idx,
+                                  const uint32_t* ordinals,
+                                  size_t nrows,
+                                  size_t dst_idx,
+                                  ColumnBlock* dst,
+                                  Arena* dst_arena) const {
+  const ColumnSchema& col = schema_->column(col_idx);
+  const size_t size = col.type_info()->size();
+  DCHECK_EQ(size, dst->stride());
+  DCHECK_LE(dst_idx + nrows, dst->nrows());
+  const size_t cell_offset = cell_offsets_[col_idx];
+  const size_t null_offset = null_offsets_[col_idx];
+  const bool is_nullable = col.is_nullable();
+  const bool relocate = dst_arena != nullptr && col.type_info()->physical_type() == BINARY;
+  uint8_t* dst_cell = dst->data() + dst_idx * size;
+
+  // Runs of consecutive ordinals, which are common when rows were inserted
+  // in key order, are copied with a single memcpy.
+  size_t i = 0;
+  while (i < nrows) {
+    const uint32_t first = ordinals[i];
+    const uint8_t* c = chunk(first);
+    size_t run = 1;
+    while (i + run < nrows && ordinals[i + run] == first + run &&
+           idx_in_chunk(first + run) != 0) {
+      run++;
+    }
+    memcpy(dst_cell, c + cell_offset + idx_in_chunk(first) * size, run * size);
+    if (is_nullable) {
+      const uint8_t* null_flags = c + null_offset + idx_in_chunk(first);
+      for (size_t j = 0; j < run; j++) {
+        dst->SetCellIsNull(dst_idx + i + j, null_flags[j]);
+      }
+    }
+    if (relocate) {
+      Slice* slices = reinterpret_cast<Slice*>(dst_cell);
+      for (size_t j = 0; j < run; j++) {
+        if (is_nullable && dst->is_null(dst_idx + i + j)) {
+          continue;
+        }
+        if (PREDICT_FALSE(!dst_arena->RelocateSlice(slices[j], &slices[j]))) {
+          return Status::IOError("out of memory copying slice");
+        }
+      }
+    }
+    dst_cell += run * size;
+    i += run;
+  }
+  return Status::OK();
+}
+
+void MRSColumnStore::CopyRow(uint32_t ordinal, ContiguousRow* dst) const {
+  DCHECK_SCHEMA_EQ(*schema_, *dst->schema());
+  const uint8_t* c = chunk(ordinal);
+  const size_t idx = idx_in_chunk(ordinal);
+  for (size_t i = 0; i < schema_->num_columns(); i++) {
+    const ColumnSchema& col = schema_->column(i);
+    if (col.is_nullable()) {
+      bool is_null = c[null_offsets_[i] + idx];
+      dst->set_null(i, is_null);
+      if (is_null) {
+        continue;
+      }
+    }
+    const size_t size = col.type_info()->size();
+    memcpy(dst->mutable_cell_ptr(i), c + cell_offsets_[i] + idx * size, size);
+  }
+}
+
+} // namespace tablet
+} // namespace kudu
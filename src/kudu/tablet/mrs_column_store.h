@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Arena;
+class ColumnBlock;
+class ConstContiguousRow;
+class ContiguousRow;
+class Schema;
+class ThreadSafeMemoryTrackingArena;
+
+namespace tablet {
+
+// Columnar storage for the cells of the rows inserted into a MemRowSet.
+//
+// Rows are identified by an ordinal assigned in insertion order. The cells
+// of each column are stored in arrays of kRowsPerChunk cells, allocated out
+// of the MemRowSet's arena, so that a batch of rows can be copied out one
+// column at a time rather than one cell at a time.
+//
+// Rows may be appended concurrently with each other and with readers. A
+// reader may only access a row once its ordinal has been published to it
+// with release/acquire semantics, e.g. through the MemRowSet's CBTree.
+class MRSColumnStore {
+ public:
+  // 'schema' and 'arena' must outlive the store.
+  MRSColumnStore(const Schema* schema, ThreadSafeMemoryTrackingArena* arena);
+
+  // Copy the cells of 'row', which must have the schema of the store, and any
+  // data they refer to into the store. Sets 'ordinal' to the ordinal of the
+  // newly appended row.
+  Status AppendRow(const ConstContiguousRow& row, uint32_t* ordinal);
+
+  // Copy the cells of column 'col_idx' of the 'nrows' rows with the given
+  // ordinals into rows ['dst_idx', 'dst_idx' + 'nrows') of 'dst'. The data
+  // referred to by BINARY cells is copied into 'dst_arena' unless it is
+  // null, in which case the cells point into the store's arena.
+  Status CopyColumn(size_t col_idx,
+                    const uint32_t* ordinals,
+                    size_t nrows,
+                    size_t dst_idx,
+                    ColumnBlock* dst,
+                    Arena* dst_arena) const;
+
+  // Copy the cells of the row with the given ordinal into 'dst', which must
+  // have the schema of the store. The data referred to by BINARY cells is not
+  // copied.
+  void CopyRow(uint32_t ordinal, ContiguousRow* dst) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MRSColumnStore);
+
+  static constexpr int kRowsPerChunkShift = 8;
+  static constexpr size_t kRowsPerChunk = 1 << kRowsPerChunkShift;
+  static constexpr int kChunksPerGroupShift = 11;
+  static constexpr size_t kChunksPerGroup = 1 << kChunksPerGroupShift;
+  static constexpr size_t kMaxGroups = 512;
+  static constexpr uint64_t kMaxRows =
+      static_cast<uint64_t>(kMaxGroups) * kChunksPerGroup * kRowsPerChunk;
+
+  typedef std::atomic<uint8_t*> ChunkPtr;
+
+  // Return the chunk holding the row with the given ordinal, which must
+  // have been published.
+  const uint8_t* chunk(uint32_t ordinal) const;
+
+  // Return the chunk holding the row with the given ordinal, allocating it
+  // if needed. Returns null if the allocation fails.
+  uint8_t* GetOrAllocateChunk(uint32_t ordinal);
+
+  static size_t idx_in_chunk(uint32_t ordinal) {
+    return ordinal & (kRowsPerChunk - 1);
+  }
+
+  const Schema* const schema_;
+  ThreadSafeMemoryTrackingArena* const arena_;
+
+  // Offsets within a chunk of the cells of each column, and of the flags
+  // telling whether each cell of a nullable column is null. Nulls are stored
+  // as one byte per cell rather than as a bitmap, so that concurrent appends
+  // never write to the same byte.
+  std::vector<size_t> cell_offsets_;
+  std::vector<size_t> null_offsets_;
+  size_t chunk_size_;
+
+  std::atomic<uint32_t> next_ordinal_;
+
+  // Protects the allocation of groups and chunks.
+  simple_spinlock alloc_lock_;
+
+  // Groups of pointers to chunks, allocated as needed.
+  std::atomic<ChunkPtr*> groups_[kMaxGroups];
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -17,21 +17,49 @@
 
 #include "kudu/tablet/multi_column_writer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
 
+#include <gflags/gflags.h>
+
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/common.pb.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/types.h"
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/block_manager.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/bitmap.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/threadpool.h"
+
+DECLARE_bool(cfile_write_zone_maps);
+
+DEFINE_int32(multi_column_writer_threads, 1,
+             "Maximum number of threads writing the columns of the rowsets "
+             "written by flushes and compactions. If greater than 1, the columns "
+             "of each rowset are split into groups written in parallel, which "
+             "shortens flushes and compactions of wide tables on hosts with idle "
+             "cores. The size of the shared thread pool is fixed when the first "
+             "such writer is opened.");
+TAG_FLAG(multi_column_writer_threads, experimental);
+
+DEFINE_int32(multi_column_writer_buffer_rows, 4096,
+             "Number of rows buffered before being written in parallel, when "
+             "--multi_column_writer_threads is greater than 1. Two such buffers "
+             "are held by each writer.");
+TAG_FLAG(multi_column_writer_buffer_rows, experimental);
 
 namespace kudu {
 namespace tablet {
@@ -42,16 +70,51 @@ using fs::CreateBlockOptions;
 using fs::WritableBlock;
 using std::unique_ptr;
 
+namespace {
+
+// The pool shared by all the writers which write their columns in parallel.
+ThreadPool* ColumnWriterPool() {
+  static ThreadPool* pool = []() {
+    unique_ptr<ThreadPool> p;
+    CHECK_OK(ThreadPoolBuilder("column-writer")
+             .set_max_threads(FLAGS_multi_column_writer_threads)
+             .Build(&p));
+    return p.release();
+  }();
+  return pool;
+}
+
+} // anonymous namespace
+
+// Rows buffered to be written in parallel. The data referred to by BINARY
+// cells is copied into 'arena'.
+struct MultiColumnWriter::RowBuffer {
+  RowBuffer(const Schema* schema, size_t capacity)
+      : arena(32 * 1024),
+        block(schema, capacity, &arena),
+        nrows(0) {
+  }
+
+  Arena arena;
+  RowBlock block;
+  size_t nrows;
+};
+
 MultiColumnWriter::MultiColumnWriter(FsManager* fs,
                                      const Schema* schema,
                                      std::string tablet_id)
   : fs_(fs),
     schema_(schema),
     finished_(false),
-    tablet_id_(std::move(tablet_id)) {
+    tablet_id_(std::move(tablet_id)),
+    num_column_groups_(0) {
 }
 
 MultiColumnWriter::~MultiColumnWriter() {
+  if (pool_token_) {
+    // The writers may still be in use by the thread pool.
+    pool_token_->Wait();
+  }
   STLDeleteElements(&cfile_writers_);
 }
 
@@ -68,6 +131,7 @@ Status MultiColumnWriter::Open() {
     // Index all columns by ordinal position, so we can match up
     // the corresponding rows.
     opts.write_posidx = true;
+    opts.write_zone_maps = FLAGS_cfile_write_zone_maps;
 
     /// Set the column storage attributes.
     opts.storage_attributes = col.attributes();
@@ -98,25 +162,134 @@ Status MultiColumnWriter::Open() {
   VLOG(1) << strings::Substitute("Opened CFile writers for $0 column(s)",
                                  cfile_writers_.size());
 
+  const int num_columns = schema_->num_columns();
+  if (FLAGS_multi_column_writer_threads > 1 && num_columns > 1) {
+    pool_token_ = ColumnWriterPool()->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
+    num_column_groups_ = std::min(FLAGS_multi_column_writer_threads, num_columns);
+    const size_t capacity = std::max(FLAGS_multi_column_writer_buffer_rows, 1);
+    filling_buffer_.reset(new RowBuffer(schema_, capacity));
+    writing_buffer_.reset(new RowBuffer(schema_, capacity));
+    group_statuses_.resize(num_column_groups_);
+    written_sizes_.reset(new std::atomic<size_t>[num_columns]);
+    for (int i = 0; i < num_columns; i++) {
+      written_sizes_[i].store(cfile_writers_[i]->written_size(), std::memory_order_relaxed);
+    }
+  }
+
   return Status::OK();
 }
 
 Status MultiColumnWriter::AppendBlock(const RowBlock& block) {
+  if (pool_token_) {
+    size_t appended = 0;
+    while (appended < block.nrows()) {
+      size_t n = std::min(block.nrows() - appended,
+                          filling_buffer_->block.nrows() - filling_buffer_->nrows);
+      RETURN_NOT_OK(CopyToBuffer(block, appended, n));
+      appended += n;
+      if (filling_buffer_->nrows == filling_buffer_->block.nrows()) {
+        RETURN_NOT_OK(SubmitBuffer());
+      }
+    }
+    return Status::OK();
+  }
+
+  for (int i = 0; i < schema_->num_columns(); i++) {
+    RETURN_NOT_OK(AppendColumn(i, block.column_block(i)));
+  }
+  return Status::OK();
+}
+
+Status MultiColumnWriter::AppendColumn(int col_idx, const ColumnBlock& column) {
+  if (column.is_nullable()) {
+    return cfile_writers_[col_idx]->AppendNullableEntries(column.non_null_bitmap(),
+        column.data(), column.nrows());
+  }
+  return cfile_writers_[col_idx]->AppendEntries(column.data(), column.nrows());
+}
+
+Status MultiColumnWriter::CopyToBuffer(const RowBlock& block, size_t src_idx, size_t nrows) {
+  RowBuffer* buf = filling_buffer_.get();
+  const size_t dst_idx = buf->nrows;
   for (int i = 0; i < schema_->num_columns(); i++) {
-    ColumnBlock column = block.column_block(i);
-    if (column.is_nullable()) {
-      RETURN_NOT_OK(cfile_writers_[i]->AppendNullableEntries(column.non_null_bitmap(),
-          column.data(), column.nrows()));
-    } else {
-      RETURN_NOT_OK(cfile_writers_[i]->AppendEntries(column.data(), column.nrows()));
+    ColumnBlock src = block.column_block(i);
+    ColumnBlock dst = buf->block.column_block(i);
+    memcpy(dst.data() + dst_idx * dst.stride(),
+           src.data() + src_idx * src.stride(),
+           nrows * src.stride());
+    if (src.is_nullable()) {
+      BitmapCopy(dst.non_null_bitmap(), dst_idx, src.non_null_bitmap(), src_idx, nrows);
+    }
+    if (src.type_info()->physical_type() == BINARY) {
+      Slice* slices = reinterpret_cast<Slice*>(dst.data()) + dst_idx;
+      for (size_t j = 0; j < nrows; j++) {
+        if (src.is_nullable() && src.is_null(src_idx + j)) {
+          continue;
+        }
+        if (PREDICT_FALSE(!buf->arena.RelocateSlice(slices[j], &slices[j]))) {
+          return Status::IOError("out of memory buffering rows");
+        }
+      }
+    }
+  }
+  buf->nrows += nrows;
+  return Status::OK();
+}
+
+Status MultiColumnWriter::SubmitBuffer() {
+  // The rows of the other buffer must have been written before it's reused.
+  RETURN_NOT_OK(WaitForPendingWrites());
+  filling_buffer_.swap(writing_buffer_);
+  filling_buffer_->nrows = 0;
+  filling_buffer_->arena.Reset();
+
+  const RowBuffer* buf = writing_buffer_.get();
+  for (int g = 0; g < num_column_groups_; g++) {
+    Status s = pool_token_->Submit([this, g, buf]() {
+      group_statuses_[g] = WriteColumnGroup(g, *buf);
+    });
+    if (PREDICT_FALSE(!s.ok())) {
+      pool_token_->Wait();
+      return s.CloneAndPrepend("unable to submit column writes");
     }
   }
   return Status::OK();
 }
 
+Status MultiColumnWriter::WriteColumnGroup(int group_idx, const RowBuffer& buffer) {
+  RETURN_NOT_OK(group_statuses_[group_idx]);
+  for (int i = group_idx; i < schema_->num_columns(); i += num_column_groups_) {
+    RETURN_NOT_OK(AppendColumn(i, buffer.block.column_block(i, buffer.nrows)));
+    written_sizes_[i].store(cfile_writers_[i]->written_size(), std::memory_order_relaxed);
+  }
+  return Status::OK();
+}
+
+Status MultiColumnWriter::WaitForPendingWrites() {
+  pool_token_->Wait();
+  for (const auto& s : group_statuses_) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
+}
+
+CFileWriter* MultiColumnWriter::writer_for_col_idx(int i) {
+  DCHECK_LT(i, cfile_writers_.size());
+  if (pool_token_) {
+    pool_token_->Wait();
+  }
+  return cfile_writers_[i];
+}
+
 Status MultiColumnWriter::FinishAndReleaseBlocks(
     BlockCreationTransaction* transaction) {
   CHECK(!finished_);
+  if (pool_token_) {
+    if (filling_buffer_->nrows > 0) {
+      RETURN_NOT_OK(SubmitBuffer());
+    }
+    RETURN_NOT_OK(WaitForPendingWrites());
+  }
   for (int i = 0; i < schema_->num_columns(); i++) {
     CFileWriter *writer = cfile_writers_[i];
     Status s = writer->FinishAndReleaseBlock(transaction);
@@ -140,6 +313,12 @@ void MultiColumnWriter::GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>*
 
 size_t MultiColumnWriter::written_size() const {
   size_t size = 0;
+  if (pool_token_) {
+    for (int i = 0; i < cfile_writers_.size(); i++) {
+      size += written_sizes_[i].load(std::memory_order_relaxed);
+    }
+    return size;
+  }
   for (const CFileWriter *writer : cfile_writers_) {
     size += writer->written_size();
   }
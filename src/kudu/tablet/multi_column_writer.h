@@ -17,8 +17,10 @@
 #ifndef KUDU_TABLET_MULTI_COLUMN_WRITER_H
 #define KUDU_TABLET_MULTI_COLUMN_WRITER_H
 
+#include <atomic>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,9 +32,11 @@
 
 namespace kudu {
 
+class ColumnBlock;
 class FsManager;
 class RowBlock;
 class Schema;
+class ThreadPoolToken;
 struct ColumnId;
 
 namespace cfile {
@@ -47,6 +51,10 @@ namespace tablet {
 
 // Wrapper which writes several columns in parallel corresponding to some
 // Schema. Written blocks will fall in the tablet_id's data dir group.
+//
+// If --multi_column_writer_threads is greater than 1, the appended rows are
+// buffered, and each buffer is written by several threads of a shared pool,
+// each writing a group of columns, while the next buffer is being filled.
 class MultiColumnWriter {
  public:
   MultiColumnWriter(FsManager* fs,
@@ -67,13 +75,14 @@ class MultiColumnWriter {
   // blocks and releasing them to 'transaction'.
   Status FinishAndReleaseBlocks(fs::BlockCreationTransaction* transaction);
 
-  // Return the number of bytes written so far.
+  // Return the number of bytes written so far. If the columns are written in
+  // parallel, this doesn't account for the rows which are being written.
   size_t written_size() const;
 
-  cfile::CFileWriter* writer_for_col_idx(int i) {
-    DCHECK_LT(i, cfile_writers_.size());
-    return cfile_writers_[i];
-  }
+  // Return the writer of the given column. If the columns are written in
+  // parallel, waits for the rows being written first; the returned writer
+  // must not be appended to.
+  cfile::CFileWriter* writer_for_col_idx(int i);
 
   // Return the block IDs of the written columns, keyed by column ID.
   //
@@ -81,6 +90,26 @@ class MultiColumnWriter {
   void GetFlushedBlocksByColumnId(std::map<ColumnId, BlockId>* ret) const;
 
  private:
+  struct RowBuffer;
+
+  // Append the cells of 'column' to the writer of column 'col_idx'.
+  Status AppendColumn(int col_idx, const ColumnBlock& column);
+
+  // Copy rows ['src_idx', 'src_idx' + 'nrows') of 'block' to the end of
+  // the buffer being filled.
+  Status CopyToBuffer(const RowBlock& block, size_t src_idx, size_t nrows);
+
+  // Submit the writes of the rows of the buffer being filled, and switch to
+  // the other buffer once its rows have been written.
+  Status SubmitBuffer();
+
+  // Write the columns of group 'group_idx' of the rows of 'buffer'.
+  Status WriteColumnGroup(int group_idx, const RowBuffer& buffer);
+
+  // Wait for the rows being written by the thread pool, and return the first
+  // error which occurred writing rows so far.
+  Status WaitForPendingWrites();
+
   FsManager* const fs_;
   const Schema* const schema_;
 
@@ -91,6 +120,25 @@ class MultiColumnWriter {
   std::vector<cfile::CFileWriter *> cfile_writers_;
   std::vector<BlockId> block_ids_;
 
+  // The following are only set if the columns are written in parallel.
+  //
+  // The token of the writes of this writer, and the number of groups of
+  // columns written in parallel.
+  std::unique_ptr<ThreadPoolToken> pool_token_;
+  int num_column_groups_;
+
+  // The buffer being filled, and the buffer whose rows are being written.
+  std::unique_ptr<RowBuffer> filling_buffer_;
+  std::unique_ptr<RowBuffer> writing_buffer_;
+
+  // The result of the writes of each group of columns. Only accessed by the
+  // thread pool between SubmitBuffer() and WaitForPendingWrites().
+  std::vector<Status> group_statuses_;
+
+  // The number of bytes written to each column, updated once each buffer has
+  // been written.
+  std::unique_ptr<std::atomic<size_t>[]> written_sizes_;
+
   DISALLOW_COPY_AND_ASSIGN(MultiColumnWriter);
 };
 
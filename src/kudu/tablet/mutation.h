@@ -31,6 +31,7 @@
 #include "kudu/gutil/atomicops.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
+#include "kudu/util/alignment.h"
 #include "kudu/util/slice.h"
 
 namespace kudu {
@@ -49,10 +50,28 @@ class Mutation {
   Mutation() { }
 
   // Create a new Mutation object with a copy of the given changelist.
-  // The object is allocated from the provided Arena.
+  // The object is allocated from the provided Arena, along with
+  // 'room_after' more bytes in which later mutations of the same row may be
+  // created by CreateInRoomAfter().
   template<class ArenaType>
   static Mutation *CreateInArena(
-    ArenaType *arena, Timestamp timestamp, const RowChangeList &rcl);
+    ArenaType *arena, Timestamp timestamp, const RowChangeList &rcl,
+    size_t room_after = 0);
+
+  // Creates a new Mutation object with a copy of the given changelist right
+  // after this one, in the room allocated with it, handing the rest of the
+  // room over to the new mutation. Returns NULL if there isn't enough room
+  // left.
+  //
+  // Callers must be externally synchronized on a per-row basis, as with
+  // AppendToListAtomic().
+  Mutation* CreateInRoomAfter(Timestamp timestamp, const RowChangeList& rcl);
+
+  // Returns the number of bytes that a Mutation object with the given
+  // changelist takes, padded so that a Mutation may directly follow it.
+  static size_t AllocationSize(const RowChangeList& rcl) {
+    return AllocationSize(rcl.slice().size());
+  }
 
   RowChangeList changelist() const {
     return RowChangeList(Slice(changelist_data_, changelist_size_));
@@ -101,6 +120,19 @@ class Mutation {
   friend class MSRow;
   friend class MemRowSet;
 
+  static size_t AllocationSize(size_t changelist_size) {
+    return KUDU_ALIGN_UP(sizeof(Mutation) + changelist_size, BASE_PORT_H_ALIGN_OF(Mutation));
+  }
+
+  // Initializes this mutation with a copy of the given changelist.
+  void Init(Timestamp timestamp, const RowChangeList& rcl, size_t room_after) {
+    timestamp_ = timestamp;
+    next_ = nullptr;
+    changelist_size_ = rcl.slice().size();
+    room_after_ = room_after;
+    memcpy(changelist_data_, rcl.slice().data(), rcl.slice().size());
+  }
+
   // The transaction ID which made this mutation. If this transaction is not
   // committed in the snapshot of the reader, this mutation should be ignored.
   Timestamp timestamp_;
@@ -110,6 +142,10 @@ class Mutation {
 
   uint32_t changelist_size_;
 
+  // The number of bytes allocated directly after this mutation, in which the
+  // next mutation of the row may be created. Only used by writers.
+  uint32_t room_after_;
+
   // The actual encoded RowChangeList
   char changelist_data_[0];
 
@@ -118,17 +154,29 @@ class Mutation {
 
 template<class ArenaType>
 inline Mutation *Mutation::CreateInArena(
-  ArenaType *arena, Timestamp timestamp, const RowChangeList &rcl) {
+  ArenaType *arena, Timestamp timestamp, const RowChangeList &rcl, size_t room_after) {
   DCHECK(!rcl.is_null());
 
-  size_t size = sizeof(Mutation) + rcl.slice().size();
+  size_t size = room_after == 0 ? sizeof(Mutation) + rcl.slice().size()
+                                : AllocationSize(rcl) + room_after;
   void *storage = arena->AllocateBytesAligned(size, BASE_PORT_H_ALIGN_OF(Mutation));
   CHECK(storage) << "failed to allocate storage from arena";
   auto ret = new (storage) Mutation();
-  ret->timestamp_ = timestamp;
-  ret->next_ = NULL;
-  ret->changelist_size_ = rcl.slice().size();
-  memcpy(ret->changelist_data_, rcl.slice().data(), rcl.slice().size());
+  ret->Init(timestamp, rcl, room_after);
+  return ret;
+}
+
+inline Mutation* Mutation::CreateInRoomAfter(Timestamp timestamp, const RowChangeList& rcl) {
+  DCHECK(!rcl.is_null());
+
+  size_t size = AllocationSize(rcl);
+  if (size > room_after_) {
+    return nullptr;
+  }
+  uint8_t* storage = reinterpret_cast<uint8_t*>(this) + AllocationSize(changelist_size_);
+  auto ret = new (storage) Mutation();
+  ret->Init(timestamp, rcl, room_after_ - size);
+  room_after_ = 0;
   return ret;
 }
 
@@ -200,6 +200,7 @@ TEST_F(MvccTest, TestOutOfOrderTxns) {
   // Commit the original txn
   first_txn.StartApplying();
   first_txn.Commit();
+  EXPECT_GT(mgr.GetCommittedUpperBound(), first_ts);
 
   // Start a new txn
   Timestamp second_ts = hybrid_clock.Now();
@@ -222,6 +223,10 @@ TEST_F(MvccTest, TestOutOfOrderTxns) {
   // A new snapshot at this point should still think that normal_txn_2 is uncommitted
   MvccSnapshot snap_with_all_committed(mgr);
   EXPECT_FALSE(snap_with_all_committed.IsCommitted(second_ts));
+
+  // A snapshot at the committed upper bound includes the commit-wait txn too.
+  EXPECT_GT(mgr.GetCommittedUpperBound(), cw_ts);
+  EXPECT_TRUE(MvccSnapshot(mgr.GetCommittedUpperBound()).IsCommitted(cw_ts));
 }
 
 // Tests starting transaction at a point-in-time in the past and committing them while
@@ -785,5 +790,40 @@ TEST_F(MvccTest, TestCorrectInitWithNoTxns) {
   EXPECT_EQ(snap2.committed_timestamps_.size(), 0);
 }
 
+// Snapshots taken without locking, while the current snapshot is clean, must
+// be the same as the current snapshot.
+TEST_F(MvccTest, TestPublishedSnapshotMatchesCurrentState) {
+  MvccManager mgr;
+  auto verify_snapshot = [&] {
+    MvccSnapshot snap(mgr);
+    ASSERT_TRUE(snap.Equals(mgr.cur_snap_))
+        << snap.ToString() << " vs " << mgr.cur_snap_.ToString();
+    ASSERT_EQ(mgr.cur_snap_.all_committed_before_, mgr.GetCleanTimestamp());
+  };
+  NO_FATALS(verify_snapshot());
+
+  Timestamp ts1 = clock_.Now();
+  Timestamp ts2 = clock_.Now();
+  ScopedTransaction txn1(&mgr, ts1);
+  ScopedTransaction txn2(&mgr, ts2);
+  mgr.AdjustNewTransactionLowerBound(ts2);
+  NO_FATALS(verify_snapshot());
+
+  // Committing out of order makes the snapshot unclean.
+  txn2.StartApplying();
+  txn2.Commit();
+  ASSERT_FALSE(mgr.cur_snap_.is_clean());
+  NO_FATALS(verify_snapshot());
+
+  // Committing the earliest transaction makes it clean again.
+  txn1.StartApplying();
+  txn1.Commit();
+  ASSERT_TRUE(mgr.cur_snap_.is_clean());
+  NO_FATALS(verify_snapshot());
+  MvccSnapshot snap;
+  ASSERT_OK(mgr.WaitForSnapshotWithAllCommitted(ts1, &snap, MonoTime::Max()));
+  ASSERT_TRUE(snap.IsCommitted(ts1));
+}
+
 } // namespace tablet
 } // namespace kudu
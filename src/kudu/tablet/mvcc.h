@@ -121,6 +121,7 @@ class MvccSnapshot {
   FRIEND_TEST(MvccTest, TestMayHaveUncommittedTransactionsBefore);
   FRIEND_TEST(MvccTest, TestWaitUntilAllCommitted_SnapAtTimestampWithInFlights);
   FRIEND_TEST(MvccTest, TestCorrectInitWithNoTxns);
+  FRIEND_TEST(MvccTest, TestPublishedSnapshotMatchesCurrentState);
 
   bool IsCommittedFallback(const Timestamp& timestamp) const;
 
@@ -231,6 +232,11 @@ class MvccManager {
   // All timestamps before this one are guaranteed to be committed.
   Timestamp GetCleanTimestamp() const;
 
+  // Returns the earliest timestamp at or after which no transaction has
+  // committed. A snapshot at this timestamp includes every transaction which
+  // has committed so far.
+  Timestamp GetCommittedUpperBound() const;
+
   // Return the timestamps of all transactions which are currently 'APPLYING'
   // (i.e. those which have started to apply their operations to in-memory data
   // structures). Other transactions may have reserved their timestamps via
@@ -263,6 +269,7 @@ class MvccManager {
   friend class ScopedTransaction;
   FRIEND_TEST(MvccTest, TestAutomaticCleanTimeMoveToSafeTimeOnCommit);
   FRIEND_TEST(MvccTest, TestIllegalStateTransitionsCrash);
+  FRIEND_TEST(MvccTest, TestPublishedSnapshotMatchesCurrentState);
   FRIEND_TEST(MvccTest, TestTxnAbort);
 
   enum TxnState {
@@ -367,11 +374,24 @@ class MvccManager {
   // commits or aborts.
   void AdvanceEarliestInFlightTimestamp();
 
+  // Publishes the clean time and, if it is clean, the current snapshot, for
+  // readers which don't take 'lock_'. Must be called with lock_ held, whenever
+  // 'cur_snap_' changes.
+  void PublishSnapshotUnlocked();
+
   typedef simple_spinlock LockType;
   mutable LockType lock_;
 
   MvccSnapshot cur_snap_;
 
+  // The clean time of 'cur_snap_', and the timestamp which determines
+  // 'cur_snap_' if it is clean or kInvalidTimestamp if it isn't. Snapshots
+  // are usually clean, which lets TakeSnapshot() and GetCleanTimestamp()
+  // avoid contending on 'lock_' with the write path. Updated with
+  // PublishSnapshotUnlocked().
+  std::atomic<Timestamp::val_type> published_clean_time_;
+  std::atomic<Timestamp::val_type> published_clean_snapshot_;
+
   // The set of timestamps corresponding to currently in-flight transactions.
   typedef std::unordered_map<Timestamp::val_type, TxnState> InFlightMap;
   InFlightMap timestamps_in_flight_;
@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/pinned_bloom_filter.h"
+
+#include <string>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hash.pb.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
+
+DEFINE_bool(rowset_pinned_bloom_filters, false,
+            "Whether to build an in-memory block bloom filter over the keys of "
+            "each rowset written by flushes and compactions, and to check it "
+            "instead of the rowset's bloom file when looking for keys. The "
+            "filters are never evicted, which keeps the latency of inserts "
+            "predictable when scans churn the block cache.");
+TAG_FLAG(rowset_pinned_bloom_filters, advanced);
+TAG_FLAG(rowset_pinned_bloom_filters, experimental);
+TAG_FLAG(rowset_pinned_bloom_filters, runtime);
+
+DEFINE_double(rowset_pinned_bloom_filter_fp_rate, 0.01,
+              "Target false-positive rate (between 0 and 1) to size the "
+              "in-memory bloom filters of rowsets. Lower rates use more memory.");
+TAG_FLAG(rowset_pinned_bloom_filter_fp_rate, advanced);
+TAG_FLAG(rowset_pinned_bloom_filter_fp_rate, experimental);
+
+DEFINE_int64(rowset_pinned_bloom_filter_memory_limit_mb, 512,
+             "Maximum amount of memory used by the in-memory bloom filters of "
+             "all the rowsets of the process. Rowsets for which a filter would "
+             "exceed the limit rely on their bloom files.");
+TAG_FLAG(rowset_pinned_bloom_filter_memory_limit_mb, advanced);
+TAG_FLAG(rowset_pinned_bloom_filter_memory_limit_mb, experimental);
+
+using std::shared_ptr;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace tablet {
+
+namespace {
+
+shared_ptr<MemTracker> FiltersMemTracker() {
+  static shared_ptr<MemTracker> tracker = MemTracker::FindOrCreateGlobalTracker(
+      FLAGS_rowset_pinned_bloom_filter_memory_limit_mb * 1024 * 1024,
+      "pinned_bloom_filters");
+  return tracker;
+}
+
+} // anonymous namespace
+
+bool PinnedBloomFilter::enabled() {
+  return FLAGS_rowset_pinned_bloom_filters;
+}
+
+Status PinnedBloomFilter::Build(const vector<uint32_t>& key_hashes,
+                                unique_ptr<PinnedBloomFilter>* filter) {
+  filter->reset();
+  const int log_space_bytes = BlockBloomFilter::MinLogSpace(
+      key_hashes.size(), FLAGS_rowset_pinned_bloom_filter_fp_rate);
+  const int64_t bytes = sizeof(PinnedBloomFilter) + (1LL << log_space_bytes);
+  shared_ptr<MemTracker> tracker = FiltersMemTracker();
+  if (!tracker->TryConsume(bytes)) {
+    KLOG_EVERY_N_SECS(INFO, 60) << "Not pinning a bloom filter of " << bytes
+                                << " bytes: memory limit of the pinned bloom filters reached";
+    return Status::OK();
+  }
+  unique_ptr<PinnedBloomFilter> f(new PinnedBloomFilter(std::move(tracker), bytes));
+  RETURN_NOT_OK(f->filter_.Init(log_space_bytes, FAST_HASH, 0));
+  for (uint32_t h : key_hashes) {
+    f->filter_.Insert(h);
+  }
+  *filter = std::move(f);
+  return Status::OK();
+}
+
+PinnedBloomFilter::PinnedBloomFilter(shared_ptr<MemTracker> tracker, int64_t consumption)
+    : filter_(DefaultBlockBloomFilterBufferAllocator::GetSingleton()),
+      tracker_(std::move(tracker)),
+      consumption_(consumption) {
+}
+
+PinnedBloomFilter::~PinnedBloomFilter() {
+  filter_.Close();
+  tracker_->Release(consumption_);
+}
+
+} // namespace tablet
+} // namespace kudu
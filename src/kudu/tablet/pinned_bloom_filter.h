@@ -0,0 +1,85 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class MemTracker;
+
+namespace tablet {
+
+// An in-memory bloom filter over the keys of a DiskRowSet, built when the
+// rowset is written by a flush or a compaction.
+//
+// Unlike the rowset's BloomFile, whose blocks go through the block cache and
+// may be evicted by scans, the filter stays in memory for the lifetime of the
+// rowset, so that presence checks never need to read it from disk. The
+// memory of all the filters is tracked by, and limited to the budget of, a
+// process-wide MemTracker.
+class PinnedBloomFilter {
+ public:
+  // Return whether filters should be built for new rowsets.
+  static bool enabled();
+
+  // Return the hash of 'encoded_key' that filters are built from and probed
+  // with.
+  static uint32_t HashKey(const Slice& encoded_key) {
+    return HashUtil::FastHash32(encoded_key.data(), encoded_key.size(), 0);
+  }
+
+  // Build a filter over the keys with the given hashes. Sets 'filter' to null
+  // if it wouldn't fit within the memory budget of the filters.
+  static Status Build(const std::vector<uint32_t>& key_hashes,
+                      std::unique_ptr<PinnedBloomFilter>* filter);
+
+  ~PinnedBloomFilter();
+
+  // Return false if the key with the given hash is definitely not in the
+  // rowset, true if it may be.
+  bool MayContainKey(uint32_t key_hash) const {
+    return filter_.Find(key_hash);
+  }
+
+  // Return the number of bytes of memory used by the filter.
+  int64_t memory_footprint() const {
+    return consumption_;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PinnedBloomFilter);
+
+  PinnedBloomFilter(std::shared_ptr<MemTracker> tracker, int64_t consumption);
+
+  BlockBloomFilter filter_;
+
+  std::shared_ptr<MemTracker> tracker_;
+  const int64_t consumption_;
+};
+
+} // namespace tablet
+} // namespace kudu
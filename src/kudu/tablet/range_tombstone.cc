@@ -0,0 +1,205 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/range_tombstone.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <boost/optional/optional.hpp>
+#include <glog/logging.h>
+
+#include "kudu/common/row_changelist.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/delta_key.h"
+#include "kudu/tablet/delta_relevancy.h"
+#include "kudu/tablet/metadata.pb.h"
+#include "kudu/tablet/rowset.h"
+
+namespace kudu {
+namespace tablet {
+
+using fs::IOContext;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+RangeTombstone RangeTombstone::FromPB(const RangeTombstonePB& pb) {
+  return { Timestamp(pb.timestamp()), pb.first_row(), pb.end_row() };
+}
+
+void RangeTombstone::ToPB(RangeTombstonePB* pb) const {
+  pb->set_first_row(first_row);
+  pb->set_end_row(end_row);
+  pb->set_timestamp(timestamp.value());
+}
+
+////////////////////////////////////////////////////////////
+// RangeTombstoneStore implementation
+////////////////////////////////////////////////////////////
+
+namespace {
+
+bool FirstRowLessThan(const RangeTombstone& a, const RangeTombstone& b) {
+  return a.first_row < b.first_row;
+}
+
+vector<RangeTombstone> SortByFirstRow(vector<RangeTombstone> tombstones) {
+  std::sort(tombstones.begin(), tombstones.end(), FirstRowLessThan);
+  return tombstones;
+}
+
+} // anonymous namespace
+
+RangeTombstoneStore::RangeTombstoneStore(vector<RangeTombstone> tombstones)
+    : tombstones_(SortByFirstRow(std::move(tombstones))),
+      min_timestamp_(Timestamp::kMax),
+      max_timestamp_(Timestamp::kMin) {
+  for (const auto& t : tombstones_) {
+    DCHECK_LT(t.first_row, t.end_row);
+    min_timestamp_ = std::min(min_timestamp_, t.timestamp);
+    max_timestamp_ = std::max(max_timestamp_, t.timestamp);
+  }
+}
+
+Status RangeTombstoneStore::NewDeltaIterator(const RowIteratorOptions& opts,
+                                             unique_ptr<DeltaIterator>* iterator) const {
+  bool relevant = !tombstones_.empty() &&
+                  IsDeltaRelevantForApply<REDO>(opts.snap_to_include, min_timestamp_);
+  if (opts.snap_to_exclude) {
+    relevant |= !tombstones_.empty() &&
+                IsDeltaRelevantForSelect(*opts.snap_to_exclude, opts.snap_to_include,
+                                         min_timestamp_, max_timestamp_);
+  }
+  if (!relevant) {
+    return Status::NotFound("range tombstones irrelevant to snapshots");
+  }
+  iterator->reset(new RangeTombstoneIterator(shared_from_this(), opts));
+  return Status::OK();
+}
+
+bool RangeTombstoneStore::MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                                                const MvccSnapshot& snap_to_include) const {
+  return !tombstones_.empty() &&
+         IsDeltaRelevantForSelect(snap_to_exclude, snap_to_include,
+                                  min_timestamp_, max_timestamp_);
+}
+
+Status RangeTombstoneStore::CheckRowDeleted(rowid_t row_idx,
+                                            const IOContext* /*io_context*/,
+                                            bool* deleted) const {
+  // Find the last tombstone starting at or before the row.
+  auto it = std::upper_bound(tombstones_.begin(), tombstones_.end(),
+                             RangeTombstone{ Timestamp::kMin, row_idx, row_idx },
+                             FirstRowLessThan);
+  *deleted = it != tombstones_.begin() && std::prev(it)->Contains(row_idx);
+  return Status::OK();
+}
+
+string RangeTombstoneStore::ToString() const {
+  return Substitute("RangeTombstoneStore($0 tombstones)", tombstones_.size());
+}
+
+////////////////////////////////////////////////////////////
+// RangeTombstoneIterator implementation
+////////////////////////////////////////////////////////////
+
+RangeTombstoneIterator::RangeTombstoneIterator(shared_ptr<const RangeTombstoneStore> store,
+                                               RowIteratorOptions opts)
+    : store_(std::move(store)),
+      preparer_(std::move(opts)),
+      seeked_(false) {}
+
+Status RangeTombstoneIterator::Init(ScanSpec* /*spec*/) {
+  return Status::OK();
+}
+
+Status RangeTombstoneIterator::SeekToOrdinal(rowid_t row_idx) {
+  preparer_.Seek(row_idx);
+  seeked_ = true;
+  return Status::OK();
+}
+
+Status RangeTombstoneIterator::PrepareBatch(size_t nrows, int prepare_flags) {
+  CHECK(seeked_);
+  const rowid_t start_row = preparer_.cur_prepared_idx();
+  const rowid_t end_row = start_row + nrows;
+
+  preparer_.Start(nrows, prepare_flags);
+
+  // The tombstones are disjoint: skip those ending before the batch.
+  const auto& tombstones = store_->tombstones();
+  auto it = std::upper_bound(tombstones.begin(), tombstones.end(), start_row,
+                             [](rowid_t row, const RangeTombstone& t) {
+                               return row < t.end_row;
+                             });
+  const Slice delete_changelist = RowChangeList::CreateDelete().slice();
+  for (; it != tombstones.end() && it->first_row < end_row; ++it) {
+    const rowid_t last = std::min(it->end_row, end_row);
+    for (rowid_t row = std::max(it->first_row, start_row); row < last; row++) {
+      bool finished_row;
+      RETURN_NOT_OK(preparer_.AddDelta(DeltaKey(row, it->timestamp), delete_changelist,
+                                       &finished_row));
+    }
+  }
+
+  preparer_.Finish(nrows);
+  return Status::OK();
+}
+
+Status RangeTombstoneIterator::ApplyUpdates(size_t col_to_apply, ColumnBlock* dst,
+                                            const SelectionVector& filter) {
+  return preparer_.ApplyUpdates(col_to_apply, dst, filter);
+}
+
+Status RangeTombstoneIterator::ApplyDeletes(SelectionVector* sel_vec) {
+  return preparer_.ApplyDeletes(sel_vec);
+}
+
+Status RangeTombstoneIterator::SelectDeltas(SelectedDeltas* deltas) {
+  return preparer_.SelectDeltas(deltas);
+}
+
+Status RangeTombstoneIterator::CollectMutations(vector<Mutation*>* dst, Arena* arena) {
+  return preparer_.CollectMutations(dst, arena);
+}
+
+Status RangeTombstoneIterator::FilterColumnIdsAndCollectDeltas(
+    const vector<ColumnId>& col_ids,
+    vector<DeltaKeyAndUpdate>* out,
+    Arena* arena) {
+  return preparer_.FilterColumnIdsAndCollectDeltas(col_ids, out, arena);
+}
+
+bool RangeTombstoneIterator::HasNext() {
+  const auto& tombstones = store_->tombstones();
+  return !tombstones.empty() && tombstones.back().end_row > preparer_.cur_prepared_idx();
+}
+
+bool RangeTombstoneIterator::MayHaveDeltas() const {
+  return preparer_.MayHaveDeltas();
+}
+
+string RangeTombstoneIterator::ToString() const {
+  return "RangeTombstoneIterator";
+}
+
+} // namespace tablet
+} // namespace kudu
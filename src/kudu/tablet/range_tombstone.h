@@ -0,0 +1,168 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/common/rowid.h"
+#include "kudu/common/timestamp.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/tablet/delta_stats.h"
+#include "kudu/tablet/delta_store.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Arena;
+class ColumnBlock;
+class ScanSpec;
+class SelectionVector;
+struct ColumnId;
+
+namespace fs {
+struct IOContext;
+} // namespace fs
+
+namespace tablet {
+
+class Mutation;
+class RangeTombstonePB;
+struct RowIteratorOptions;
+
+// The rows [first_row, end_row) of the base data of a DiskRowSet, deleted by
+// a DELETE_RANGE operation as of 'timestamp'.
+struct RangeTombstone {
+  Timestamp timestamp;
+  rowid_t first_row;
+  rowid_t end_row;
+
+  bool Contains(rowid_t row_idx) const {
+    return first_row <= row_idx && row_idx < end_row;
+  }
+
+  static RangeTombstone FromPB(const RangeTombstonePB& pb);
+  void ToPB(RangeTombstonePB* pb) const;
+};
+
+// The range tombstones of a DiskRowSet.
+//
+// The store presents them as REDO deltas: each covered row has a DELETE at
+// the timestamp of its tombstone. Scans thus filter out the tombstoned rows
+// like any other deleted rows, and compactions materialize the tombstones as
+// per-row deletes, after which they're gone. Tombstones only cover rows which
+// were live when they were added, so each row has at most one DELETE across
+// the delta stores of the rowset.
+//
+// The store is immutable: adding tombstones to a rowset replaces its store.
+class RangeTombstoneStore : public DeltaStore,
+                            public std::enable_shared_from_this<RangeTombstoneStore> {
+ public:
+  explicit RangeTombstoneStore(std::vector<RangeTombstone> tombstones);
+
+  Status Init(const fs::IOContext* /*io_context*/) override {
+    return Status::OK();
+  }
+
+  bool Initted() const override {
+    return true;
+  }
+
+  // Returns Status::NotFound if none of the tombstones is relevant to the
+  // snapshots of 'opts'.
+  Status NewDeltaIterator(const RowIteratorOptions& opts,
+                          std::unique_ptr<DeltaIterator>* iterator) const override;
+
+  Status CheckRowDeleted(rowid_t row_idx, const fs::IOContext* io_context,
+                         bool* deleted) const override;
+
+  bool MayHaveDeltasToSelect(const MvccSnapshot& snap_to_exclude,
+                             const MvccSnapshot& snap_to_include) const override;
+
+  uint64_t EstimateSize() const override {
+    return tombstones_.size() * sizeof(RangeTombstone);
+  }
+
+  std::string ToString() const override;
+
+  const DeltaStats& delta_stats() const override {
+    return delta_stats_;
+  }
+
+  // The tombstones, sorted by first row.
+  const std::vector<RangeTombstone>& tombstones() const {
+    return tombstones_;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RangeTombstoneStore);
+
+  const std::vector<RangeTombstone> tombstones_;
+
+  Timestamp min_timestamp_;
+  Timestamp max_timestamp_;
+
+  const DeltaStats delta_stats_;
+};
+
+// Iterator over the deletes of the rows covered by a RangeTombstoneStore.
+class RangeTombstoneIterator : public DeltaIterator {
+ public:
+  RangeTombstoneIterator(std::shared_ptr<const RangeTombstoneStore> store,
+                         RowIteratorOptions opts);
+
+  Status Init(ScanSpec* spec) override;
+
+  Status SeekToOrdinal(rowid_t row_idx) override;
+
+  Status PrepareBatch(size_t nrows, int prepare_flags) override;
+
+  Status ApplyUpdates(size_t col_to_apply, ColumnBlock* dst,
+                      const SelectionVector& filter) override;
+
+  Status ApplyDeletes(SelectionVector* sel_vec) override;
+
+  Status SelectDeltas(SelectedDeltas* deltas) override;
+
+  Status CollectMutations(std::vector<Mutation*>* dst, Arena* arena) override;
+
+  Status FilterColumnIdsAndCollectDeltas(const std::vector<ColumnId>& col_ids,
+                                         std::vector<DeltaKeyAndUpdate>* out,
+                                         Arena* arena) override;
+
+  std::string ToString() const override;
+
+  bool HasNext() override;
+
+  bool MayHaveDeltas() const override;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RangeTombstoneIterator);
+
+  const std::shared_ptr<const RangeTombstoneStore> store_;
+
+  DeltaPreparer<RangeTombstonePreparerTraits> preparer_;
+
+  // True if SeekToOrdinal() been called at least once.
+  bool seeked_;
+};
+
+} // namespace tablet
+} // namespace kudu
@@ -0,0 +1,165 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/row_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/common/iterator.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/common/scan_spec.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/local_tablet_writer.h"
+#include "kudu/tablet/tablet-test-util.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/util/auto_release_pool.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/test_macros.h"
+
+DECLARE_int64(row_cache_capacity_mb);
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+class RowCacheTest : public KuduTabletTest {
+ public:
+  RowCacheTest()
+    : KuduTabletTest(Schema({ ColumnSchema("key", INT32),
+                              ColumnSchema("int_val", INT32),
+                              ColumnSchema("string_val", STRING) }, 1)) {
+  }
+
+  void SetUp() override {
+    // The row cache is created with the first tablet.
+    FLAGS_row_cache_capacity_mb = 16;
+    KuduTabletTest::SetUp();
+    ASSERT_NE(nullptr, tablet()->row_cache());
+
+    LocalTabletWriter writer(tablet().get(), &client_schema_);
+    for (int32_t i = 0; i < 10; i++) {
+      ASSERT_OK(WriteRow(&writer, RowOperationsPB::INSERT, i, i * 10));
+    }
+    ASSERT_OK(tablet()->Flush());
+  }
+
+  Status WriteRow(LocalTabletWriter* writer, RowOperationsPB::Type type,
+                  int32_t key, int32_t val) {
+    KuduPartialRow row(&client_schema_);
+    RETURN_NOT_OK(row.SetInt32(0, key));
+    if (type != RowOperationsPB::DELETE) {
+      RETURN_NOT_OK(row.SetInt32(1, val));
+      RETURN_NOT_OK(row.SetStringCopy(2, Substitute("val $0", val)));
+    }
+    return writer->Write(type, row);
+  }
+
+  // Scans the row with key 'key' with 'projection', as the tablet server does
+  // for an equality predicate on the key.
+  void LookupRow(int32_t key, const Schema& projection, vector<string>* rows) {
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Equality(schema_.column(0), &key));
+    Arena arena(128);
+    AutoReleasePool pool;
+    spec.OptimizeScan(schema_, &arena, &pool, true);
+
+    unique_ptr<RowwiseIterator> iter;
+    ASSERT_OK(tablet()->NewRowIterator(projection, &iter));
+    ASSERT_OK(iter->Init(&spec));
+    rows->clear();
+    ASSERT_OK(IterateToStringList(iter.get(), rows));
+  }
+};
+
+TEST_F(RowCacheTest, TestLookupHitsAfterMiss) {
+  TabletRowCache* row_cache = tablet()->row_cache();
+  vector<string> rows;
+  NO_FATALS(LookupRow(5, client_schema_, &rows));
+  ASSERT_EQ(vector<string>{ R"((int32 key=5, int32 int_val=50, string string_val="val 50"))" },
+            rows);
+  ASSERT_EQ(0, row_cache->hits());
+  ASSERT_EQ(1, row_cache->misses());
+
+  NO_FATALS(LookupRow(5, client_schema_, &rows));
+  ASSERT_EQ(vector<string>{ R"((int32 key=5, int32 int_val=50, string string_val="val 50"))" },
+            rows);
+  ASSERT_EQ(1, row_cache->hits());
+
+  // The cached row serves any projection.
+  const Schema projection({ ColumnSchema("string_val", STRING) }, 0);
+  NO_FATALS(LookupRow(5, projection, &rows));
+  ASSERT_EQ(vector<string>{ R"((string string_val="val 50"))" }, rows);
+  ASSERT_EQ(2, row_cache->hits());
+
+  // The absence of a row isn't cached.
+  NO_FATALS(LookupRow(100, client_schema_, &rows));
+  ASSERT_TRUE(rows.empty());
+  NO_FATALS(LookupRow(100, client_schema_, &rows));
+  ASSERT_TRUE(rows.empty());
+  ASSERT_EQ(2, row_cache->hits());
+  ASSERT_EQ(3, row_cache->misses());
+}
+
+TEST_F(RowCacheTest, TestWritesInvalidateRows) {
+  TabletRowCache* row_cache = tablet()->row_cache();
+  LocalTabletWriter writer(tablet().get(), &client_schema_);
+  vector<string> rows;
+  NO_FATALS(LookupRow(3, client_schema_, &rows));
+  NO_FATALS(LookupRow(3, client_schema_, &rows));
+  ASSERT_EQ(1, row_cache->hits());
+
+  ASSERT_OK(WriteRow(&writer, RowOperationsPB::UPDATE, 3, 1000));
+  NO_FATALS(LookupRow(3, client_schema_, &rows));
+  ASSERT_EQ(vector<string>{
+      R"((int32 key=3, int32 int_val=1000, string string_val="val 1000"))" }, rows);
+  ASSERT_EQ(1, row_cache->hits());
+  NO_FATALS(LookupRow(3, client_schema_, &rows));
+  ASSERT_EQ(2, row_cache->hits());
+
+  ASSERT_OK(WriteRow(&writer, RowOperationsPB::DELETE, 3, 0));
+  NO_FATALS(LookupRow(3, client_schema_, &rows));
+  ASSERT_TRUE(rows.empty());
+
+  // A range deletion invalidates the rows it doesn't lock.
+  NO_FATALS(LookupRow(7, client_schema_, &rows));
+  NO_FATALS(LookupRow(7, client_schema_, &rows));
+  ASSERT_EQ(3, row_cache->hits());
+  KuduPartialRow lower(&client_schema_);
+  KuduPartialRow upper(&client_schema_);
+  ASSERT_OK(lower.SetInt32(0, 6));
+  ASSERT_OK(upper.SetInt32(0, 8));
+  ASSERT_OK(writer.DeleteRange(lower, upper));
+  NO_FATALS(LookupRow(7, client_schema_, &rows));
+  ASSERT_TRUE(rows.empty());
+  ASSERT_EQ(3, row_cache->hits());
+}
+
+} // namespace tablet
+} // namespace kudu
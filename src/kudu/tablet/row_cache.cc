@@ -0,0 +1,314 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tablet/row_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/common/row.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/mvcc.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
+#include "kudu/util/status.h"
+
+DEFINE_int64(row_cache_capacity_mb, 0,
+             "Capacity in MB of the row cache, which keeps the rows read by the "
+             "scans which look up a single row by its primary key, so that "
+             "repeated lookups of the same rows skip the rowsets. 0 disables "
+             "the row cache.");
+TAG_FLAG(row_cache_capacity_mb, advanced);
+TAG_FLAG(row_cache_capacity_mb, experimental);
+
+using std::string;
+using std::unique_ptr;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+namespace {
+
+// The header of a cached row, followed by the row and its indirect data.
+struct EntryHeader {
+  // The highest timestamp of the writes which ended before the row was read.
+  uint64_t last_write;
+  // The version of the writes of every row when the row was read.
+  uint64_t all_rows_version;
+  uint32_t schema_version;
+};
+
+constexpr size_t kHeaderSize = (sizeof(EntryHeader) + 7) & ~7;
+
+// Hands out the bytes of a buffer to CopyRow(), to keep the indirect data of
+// a row right after the row.
+class BufferAllocator {
+ public:
+  BufferAllocator(uint8_t* buf, size_t size)
+      : pos_(buf),
+        end_(buf + size) {
+  }
+
+  bool RelocateSlice(const Slice& src, Slice* dst) {
+    if (PREDICT_FALSE(pos_ + src.size() > end_)) {
+      return false;
+    }
+    memcpy(pos_, src.data(), src.size());
+    *dst = Slice(pos_, src.size());
+    pos_ += src.size();
+    return true;
+  }
+
+ private:
+  uint8_t* pos_;
+  uint8_t* const end_;
+};
+
+// Returns the size of the indirect data of 'row'.
+size_t IndirectDataSize(const Schema& schema, const RowBlockRow& row) {
+  size_t size = 0;
+  for (size_t i = 0; i < schema.num_columns(); i++) {
+    const ColumnSchema& col = schema.column(i);
+    if (col.type_info()->physical_type() != BINARY ||
+        (col.is_nullable() && row.is_null(i))) {
+      continue;
+    }
+    size += reinterpret_cast<const Slice*>(row.cell_ptr(i))->size();
+  }
+  return size;
+}
+
+// Copies 'row' into 'buf', which must have room for it and its indirect data.
+void CopyRowToBuffer(const Schema& schema, const RowBlockRow& row,
+                     uint8_t* buf, size_t size) {
+  ContiguousRow dst(&schema, buf);
+  BufferAllocator allocator(buf + schema.byte_size(), size - schema.byte_size());
+  CHECK_OK(CopyRow(row, &dst, &allocator));
+}
+
+} // anonymous namespace
+
+RowCache::RowCache() {
+  if (FLAGS_row_cache_capacity_mb > 0) {
+    cache_.reset(NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::DRAM>(
+        FLAGS_row_cache_capacity_mb * 1024 * 1024, "row_cache"));
+  }
+}
+
+struct TabletRowCache::Stripe {
+  // The number of the writes of the rows of the stripe which began and didn't
+  // end.
+  std::atomic<int64_t> writes_in_flight { 0 };
+  // Incremented when a write of a row of the stripe begins or ends.
+  std::atomic<uint64_t> version { 0 };
+  // The highest timestamp of the writes of the rows of the stripe which ended.
+  std::atomic<uint64_t> last_write { Timestamp::kMin.ToUint64() };
+};
+
+TabletRowCache::ScopedWrite::ScopedWrite(TabletRowCache* cache, Stripe* stripe, string key)
+    : cache_(cache),
+      stripe_(stripe),
+      key_(std::move(key)) {
+}
+
+TabletRowCache::ScopedWrite::ScopedWrite(ScopedWrite&& other) noexcept
+    : cache_(other.cache_),
+      stripe_(other.stripe_),
+      key_(std::move(other.key_)) {
+  other.cache_ = nullptr;
+  other.stripe_ = nullptr;
+}
+
+TabletRowCache::ScopedWrite& TabletRowCache::ScopedWrite::operator=(
+    ScopedWrite&& other) noexcept {
+  Release();
+  cache_ = other.cache_;
+  stripe_ = other.stripe_;
+  key_ = std::move(other.key_);
+  other.cache_ = nullptr;
+  other.stripe_ = nullptr;
+  return *this;
+}
+
+TabletRowCache::ScopedWrite::~ScopedWrite() {
+  Release();
+}
+
+void TabletRowCache::ScopedWrite::Release(boost::optional<Timestamp> timestamp) {
+  if (cache_ == nullptr) {
+    return;
+  }
+  cache_->EndWrite(stripe_, key_, timestamp);
+  cache_ = nullptr;
+  stripe_ = nullptr;
+}
+
+unique_ptr<TabletRowCache> TabletRowCache::Create(const string& tablet_id, Timestamp now) {
+  Cache* cache = RowCache::GetSingleton()->cache();
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  // The tablets opened again under the same ID must not share cached rows.
+  static std::atomic<uint64_t> next_instance { 0 };
+  return unique_ptr<TabletRowCache>(new TabletRowCache(
+      cache, Substitute("$0:$1:", tablet_id, next_instance++), now));
+}
+
+TabletRowCache::TabletRowCache(Cache* cache, string key_prefix, Timestamp now)
+    : cache_(cache),
+      key_prefix_(std::move(key_prefix)),
+      stripes_(new Stripe[kNumStripes]),
+      all_rows_stripe_(new Stripe),
+      hits_(0),
+      misses_(0) {
+  all_rows_stripe_->last_write = now.ToUint64();
+}
+
+// The cached rows of the tablet are left to be evicted.
+TabletRowCache::~TabletRowCache() {}
+
+string TabletRowCache::CacheKey(const Slice& key) const {
+  string cache_key;
+  cache_key.reserve(key_prefix_.size() + key.size());
+  cache_key.append(key_prefix_);
+  cache_key.append(reinterpret_cast<const char*>(key.data()), key.size());
+  return cache_key;
+}
+
+TabletRowCache::Stripe* TabletRowCache::StripeForKey(const Slice& key) {
+  return &stripes_[HashUtil::FastHash64(key.data(), key.size(), 0) % kNumStripes];
+}
+
+bool TabletRowCache::Lookup(const Slice& key, uint32_t schema_version,
+                            const MvccSnapshot& snap, CachedRow* row, ReadState* state) {
+  Stripe* stripe = StripeForKey(key);
+  state->stripe = stripe;
+  state->all_rows_version = all_rows_stripe_->version;
+  state->stripe_version = stripe->version;
+  state->last_write = Timestamp(std::max<uint64_t>(stripe->last_write,
+                                                   all_rows_stripe_->last_write));
+  // The state is captured before the lookup, so the write which erases an
+  // entry after it was looked up also fails its Insert().
+  state->cacheable = stripe->writes_in_flight == 0 &&
+                     all_rows_stripe_->writes_in_flight == 0 &&
+                     !snap.MayHaveUncommittedTransactionsAtOrBefore(state->last_write);
+
+  const string cache_key = CacheKey(key);
+  Cache::UniqueHandle handle(cache_->Lookup(cache_key, Cache::EXPECT_IN_CACHE));
+  if (!handle) {
+    misses_++;
+    return false;
+  }
+  Slice value = cache_->Value(handle);
+  EntryHeader header;
+  memcpy(&header, value.data(), sizeof(header));
+  // The writes are checked once the entry is held, as the writes which begin
+  // after this point aren't committed in 'snap'.
+  if (header.schema_version != schema_version ||
+      header.all_rows_version != state->all_rows_version ||
+      stripe->writes_in_flight != 0 ||
+      all_rows_stripe_->writes_in_flight != 0 ||
+      snap.MayHaveUncommittedTransactionsAtOrBefore(Timestamp(header.last_write))) {
+    misses_++;
+    return false;
+  }
+  row->row_data_ = value.data() + kHeaderSize;
+  row->handle_ = std::move(handle);
+  hits_++;
+  return true;
+}
+
+void TabletRowCache::Insert(const Slice& key, uint32_t schema_version,
+                            const MvccSnapshot& snap, const ReadState& state,
+                            const Schema& schema, const RowBlockRow& row,
+                            CachedRow* cached) {
+  DCHECK_EQ(state.stripe, StripeForKey(key));
+  const size_t row_size = schema.byte_size() + IndirectDataSize(schema, row);
+  const string cache_key = CacheKey(key);
+  if (state.cacheable) {
+    Cache::UniquePendingHandle pending(cache_->Allocate(cache_key, kHeaderSize + row_size));
+    if (pending) {
+      uint8_t* value = cache_->MutableValue(&pending);
+      EntryHeader header;
+      header.last_write = state.last_write.ToUint64();
+      header.all_rows_version = state.all_rows_version;
+      header.schema_version = schema_version;
+      memcpy(value, &header, sizeof(header));
+      CopyRowToBuffer(schema, row, value + kHeaderSize, row_size);
+
+      Cache::UniqueHandle handle(cache_->Insert(std::move(pending), nullptr));
+      cached->row_data_ = cache_->Value(handle).data() + kHeaderSize;
+      cached->handle_ = std::move(handle);
+
+      // A write of the row which began or ended during the read may have
+      // missed the entry, so it is erased: the row read is still the one
+      // visible to 'snap'.
+      if (state.stripe->writes_in_flight != 0 ||
+          all_rows_stripe_->writes_in_flight != 0 ||
+          state.stripe->version != state.stripe_version ||
+          all_rows_stripe_->version != state.all_rows_version) {
+        cache_->Erase(cache_key);
+      }
+      return;
+    }
+  }
+  cached->buf_.reset(new uint8_t[row_size]);
+  CopyRowToBuffer(schema, row, cached->buf_.get(), row_size);
+  cached->row_data_ = cached->buf_.get();
+}
+
+TabletRowCache::ScopedWrite TabletRowCache::BeginWrite(const Slice& key) {
+  Stripe* stripe = StripeForKey(key);
+  stripe->writes_in_flight++;
+  stripe->version++;
+  string cache_key = CacheKey(key);
+  cache_->Erase(cache_key);
+  return ScopedWrite(this, stripe, std::move(cache_key));
+}
+
+TabletRowCache::ScopedWrite TabletRowCache::BeginWriteAll() {
+  all_rows_stripe_->writes_in_flight++;
+  all_rows_stripe_->version++;
+  return ScopedWrite(this, all_rows_stripe_.get(), "");
+}
+
+void TabletRowCache::EndWrite(Stripe* stripe, const string& key,
+                              boost::optional<Timestamp> timestamp) {
+  if (timestamp) {
+    uint64_t last_write = stripe->last_write;
+    while (last_write < timestamp->ToUint64() &&
+           !stripe->last_write.compare_exchange_weak(last_write, timestamp->ToUint64())) {
+    }
+  }
+  if (!key.empty()) {
+    cache_->Erase(key);
+  }
+  stripe->version++;
+  stripe->writes_in_flight--;
+}
+
+} // namespace tablet
+} // namespace kudu
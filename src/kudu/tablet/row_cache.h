@@ -0,0 +1,213 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/optional/optional.hpp>
+
+#include "kudu/common/timestamp.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/singleton.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+
+class RowBlockRow;
+class Schema;
+
+namespace tablet {
+
+class MvccSnapshot;
+
+// A cache of fully materialized rows of the tablets of the server, keyed by
+// tablet and encoded primary key, for the scans which look up a single row.
+// Disabled unless --row_cache_capacity_mb is positive.
+//
+// This class is thread-safe.
+class RowCache {
+ public:
+  static RowCache* GetSingleton() {
+    return Singleton<RowCache>::get();
+  }
+
+  // Returns the cache, or nullptr if the row cache is disabled.
+  Cache* cache() const {
+    return cache_.get();
+  }
+
+ private:
+  friend class Singleton<RowCache>;
+
+  RowCache();
+
+  std::unique_ptr<Cache> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowCache);
+};
+
+// The rows of one tablet in the row cache.
+//
+// A cached row must be the row visible to any snapshot it is served to. So
+// each write of a row is tracked from the time its row lock is acquired until
+// the lock is released, after the write is committed: while a write to a row
+// may be in flight, the row isn't served from the cache, and the cached row is
+// erased both when the write begins and when it ends. A row is only cached if
+// no write to it began or ended while it was read, and it is only served to
+// the snapshots in which every write which ended before it was read is
+// committed.
+//
+// The writes are tracked in stripes of keys, so a write to a row also holds
+// back the other rows of its stripe. Writes without a row lock, i.e. range
+// deletions, hold back every row and invalidate every cached row.
+//
+// This class is thread-safe.
+class TabletRowCache {
+ private:
+  struct Stripe;
+
+ public:
+  // Tracks a write of a row, or of every row for range deletions, from its
+  // construction to Release(), which is called by the destructor if needed.
+  class ScopedWrite {
+   public:
+    ScopedWrite() : cache_(nullptr), stripe_(nullptr) {}
+    ScopedWrite(ScopedWrite&& other) noexcept;
+    ScopedWrite& operator=(ScopedWrite&& other) noexcept;
+    ~ScopedWrite();
+
+    // Ends the write. 'timestamp' is the timestamp of the write if it was
+    // assigned one. Idempotent.
+    void Release(boost::optional<Timestamp> timestamp = boost::none);
+
+   private:
+    friend class TabletRowCache;
+
+    ScopedWrite(TabletRowCache* cache, Stripe* stripe, std::string key);
+
+    TabletRowCache* cache_;
+    // The stripe of the row, or the stripe of every row.
+    Stripe* stripe_;
+    // The key of the row in the cache, or empty for a write of every row.
+    std::string key_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedWrite);
+  };
+
+  // The writes of a row before it was read, set by a missed Lookup() and
+  // passed to Insert() once the row was read.
+  struct ReadState {
+    Stripe* stripe = nullptr;
+    uint64_t stripe_version = 0;
+    uint64_t all_rows_version = 0;
+    // The highest timestamp of the writes which ended before the read.
+    Timestamp last_write = Timestamp::kMin;
+    // Whether the row may be cached once read.
+    bool cacheable = false;
+  };
+
+  // A row looked up in, or read for, the cache.
+  class CachedRow {
+   public:
+    CachedRow() : handle_(nullptr, Cache::HandleDeleter(nullptr)) {}
+
+    // The row, with the schema it was cached with.
+    const uint8_t* row_data() const {
+      return row_data_;
+    }
+
+   private:
+    friend class TabletRowCache;
+
+    // Set if the row is held by the cache.
+    Cache::UniqueHandle handle_;
+    // Set if it isn't, e.g. if it didn't fit.
+    std::unique_ptr<uint8_t[]> buf_;
+    const uint8_t* row_data_ = nullptr;
+  };
+
+  // Creates the cache of the rows of the tablet 'tablet_id' in the row cache,
+  // or returns nullptr if the row cache is disabled. The writes with
+  // timestamps before 'now' aren't tracked, so the rows aren't served to the
+  // snapshots before it.
+  static std::unique_ptr<TabletRowCache> Create(const std::string& tablet_id, Timestamp now);
+
+  ~TabletRowCache();
+
+  // Looks up the row with encoded primary key 'key', as of 'snap', with
+  // schema version 'schema_version', and sets 'row' to it. Returns false on a
+  // miss, or if the cached row may not be the one visible to 'snap', in which
+  // case 'state' is set for the Insert() of the row once it is read.
+  bool Lookup(const Slice& key, uint32_t schema_version, const MvccSnapshot& snap,
+              CachedRow* row, ReadState* state);
+
+  // Caches 'row', whose encoded primary key is 'key', as read at 'snap' with
+  // the schema 'schema' of version 'schema_version' after a Lookup() which
+  // set 'state', unless writes to the row may have raced with the read. In
+  // any case, sets 'cached' to a copy of the row.
+  void Insert(const Slice& key, uint32_t schema_version, const MvccSnapshot& snap,
+              const ReadState& state, const Schema& schema, const RowBlockRow& row,
+              CachedRow* cached);
+
+  // Begins a write of the row with encoded primary key 'key'.
+  ScopedWrite BeginWrite(const Slice& key);
+
+  // Begins a write which may change any row.
+  ScopedWrite BeginWriteAll();
+
+  int64_t hits() const {
+    return hits_;
+  }
+
+  int64_t misses() const {
+    return misses_;
+  }
+
+ private:
+  TabletRowCache(Cache* cache, std::string key_prefix, Timestamp now);
+
+  // Returns the key of the row with encoded primary key 'key' in the cache.
+  std::string CacheKey(const Slice& key) const;
+
+  Stripe* StripeForKey(const Slice& key);
+
+  void EndWrite(Stripe* stripe, const std::string& key, boost::optional<Timestamp> timestamp);
+
+  Cache* const cache_;
+
+  // Identifies the tablet instance: a tablet copied again under the same ID
+  // doesn't see the rows cached for the previous copy.
+  const std::string key_prefix_;
+
+  static constexpr size_t kNumStripes = 64;
+  std::unique_ptr<Stripe[]> stripes_;
+  // The stripe of the writes of every row.
+  std::unique_ptr<Stripe> all_rows_stripe_;
+
+  std::atomic<int64_t> hits_;
+  std::atomic<int64_t> misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(TabletRowCache);
+};
+
+} // namespace tablet
+} // namespace kudu
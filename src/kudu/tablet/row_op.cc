@@ -25,6 +25,7 @@
 
 #include "kudu/common/wire_protocol.h"
 #include "kudu/tablet/tablet.pb.h"
+#include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status.h"
 
@@ -54,6 +55,17 @@ void RowOp::SetInsertSucceeded(int mrs_id) {
   result->add_mutated_stores()->set_mrs_id(mrs_id);
 }
 
+void RowOp::SetBulkInsertSucceeded(int64_t rs_id) {
+  DCHECK(!result) << SecureDebugString(*result);
+  result.reset(new OperationResultPB());
+  // The row was written to the base data of the DiskRowSet, which was made
+  // durable before the operation committed. It was never in a DMS, so the
+  // operation never needs to be replayed.
+  MemStoreTargetPB* target = result->add_mutated_stores();
+  target->set_rs_id(rs_id);
+  target->set_dms_id(kNoDurableMemStore);
+}
+
 void RowOp::SetErrorIgnored() {
   DCHECK(!result) << SecureDebugString(*result);
   result.reset(new OperationResultPB());
@@ -16,11 +16,13 @@
 // under the License.
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include "kudu/common/row_operations.h"
 #include "kudu/tablet/lock_manager.h"
+#include "kudu/tablet/row_cache.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet.pb.h"
 
@@ -38,9 +40,10 @@ struct RowOp {
   ~RowOp() = default;
 
   // Functions to set the result of the mutation.
-  // Only one of the following four functions must be called, at most once.
+  // Only one of the following five functions must be called, at most once.
   void SetFailed(const Status& s);
   void SetInsertSucceeded(int mrs_id);
+  void SetBulkInsertSucceeded(int64_t rs_id);
   void SetErrorIgnored();
   void SetMutateSucceeded(std::unique_ptr<OperationResultPB> result);
   // Sets the result of a skipped operation on bootstrap.
@@ -79,10 +82,19 @@ struct RowOp {
   // the "prepare" phase.
   std::unique_ptr<RowSetKeyProbe> key_probe;
 
+  // For a DELETE_RANGE operation, the probe of the exclusive upper bound of
+  // the range, whose inclusive lower bound is 'key_probe'. Range deletes
+  // don't take row locks.
+  std::unique_ptr<RowSetKeyProbe> range_upper_bound_probe;
+
   // The row lock which has been acquired for this row. Set during the "prepare"
   // phase.
   ScopedRowLock row_lock;
 
+  // The write of the row, or of the range for a DELETE_RANGE operation, as
+  // tracked by the row cache. Set with 'row_lock' if the row cache is enabled.
+  TabletRowCache::ScopedWrite row_cache_write;
+
   // Flag whether this op has already been validated as valid.
   bool valid = false;
 
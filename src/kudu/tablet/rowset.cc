@@ -17,8 +17,10 @@
 
 #include "kudu/tablet/rowset.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -29,6 +31,7 @@
 #include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/rowset_metadata.h"
 
 using std::shared_ptr;
@@ -47,7 +50,41 @@ RowIteratorOptions::RowIteratorOptions()
     : projection(nullptr),
       snap_to_include(MvccSnapshot::CreateSnapshotIncludingAllTransactions()),
       order(OrderMode::UNORDERED),
-      include_deleted_rows(false) {}
+      include_deleted_rows(false),
+      scan_pool(nullptr),
+      max_parallelism(1),
+      column_read_pool(nullptr),
+      rollup_sink(nullptr) {}
+
+RowSetRollupSink::RowSetRollupSink(int num_group_by_columns, vector<ColumnId> col_ids)
+    : num_group_by_columns_(num_group_by_columns),
+      col_ids_(std::move(col_ids)) {
+}
+
+bool RowSetRollupSink::CanUse(const RowSetRollupPB& rollup) const {
+  if (rollup.num_group_by_columns() != num_group_by_columns_) {
+    return false;
+  }
+  for (const ColumnId& col_id : col_ids_) {
+    if (std::find(rollup.column_ids().begin(), rollup.column_ids().end(),
+                  static_cast<int32_t>(col_id)) ==
+        rollup.column_ids().end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RowSetRollupSink::Add(shared_ptr<const RowSetRollupPB> rollup) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  rollups_.emplace_back(std::move(rollup));
+}
+
+void RowSetRollupSink::Take(vector<shared_ptr<const RowSetRollupPB>>* rollups) {
+  std::lock_guard<simple_spinlock> l(lock_);
+  rollups->clear();
+  rollups->swap(rollups_);
+}
 
 Status RowSet::NewRowIteratorWithBounds(const RowIteratorOptions& opts,
                                         IterWithBounds* out) const {
@@ -69,10 +106,23 @@ Status RowSet::NewRowIteratorWithBounds(const RowIteratorOptions& opts,
   return Status::OK();
 }
 
+Status RowSet::CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                                size_t n,
+                                const IOContext* io_context,
+                                bool* present,
+                                ProbeStats* const* stats) const {
+  for (size_t i = 0; i < n; i++) {
+    RETURN_NOT_OK(CheckRowPresent(*probes[i], io_context, &present[i], stats[i]));
+  }
+  return Status::OK();
+}
+
 DuplicatingRowSet::DuplicatingRowSet(RowSetVector old_rowsets,
-                                     RowSetVector new_rowsets)
+                                     RowSetVector new_rowsets,
+                                     RowExpiry row_expiry)
     : old_rowsets_(std::move(old_rowsets)),
-      new_rowsets_(std::move(new_rowsets)) {
+      new_rowsets_(std::move(new_rowsets)),
+      row_expiry_(row_expiry) {
   CHECK_GT(old_rowsets_.size(), 0);
   CHECK_GT(new_rowsets_.size(), 0);
 }
@@ -197,12 +247,40 @@ Status DuplicatingRowSet::MutateRow(Timestamp timestamp,
     }
     // IsNotFound is OK - it might be in a different one.
   }
+  if (mirrored_count == 0 && row_expiry_.IsExpired(probe.row_key())) {
+    // The row expired, so it wasn't written to the new rowsets.
+    return Status::OK();
+  }
   CHECK_EQ(mirrored_count, 1)
     << "Updated row in compaction input, but didn't mirror in exactly 1 new rowset: "
     << probe.schema()->CreateKeyProjection().DebugRow(probe.row_key());
   return Status::OK();
 }
 
+Status DuplicatingRowSet::DeleteRange(Timestamp timestamp,
+                                      const Slice& lower_bound_key,
+                                      const Slice& upper_bound_key,
+                                      const consensus::OpId& op_id,
+                                      const IOContext* io_context,
+                                      OperationResultPB* result) {
+  // As with MutateRow(), delete from the input rowsets first. The output
+  // rowsets only hold the rows which were live in the inputs when they were
+  // written, so the range is deleted from all of them.
+  for (const shared_ptr<RowSet>& rowset : old_rowsets_) {
+    RETURN_NOT_OK_PREPEND(rowset->DeleteRange(timestamp, lower_bound_key, upper_bound_key,
+                                              op_id, io_context, result),
+                          Substitute("Unable to delete range from rowset $0",
+                                     rowset->ToString()));
+  }
+  for (const shared_ptr<RowSet>& new_rowset : new_rowsets_) {
+    RETURN_NOT_OK_PREPEND(new_rowset->DeleteRange(timestamp, lower_bound_key, upper_bound_key,
+                                                  op_id, io_context, result),
+                          Substitute("Unable to mirror range delete to rowset $0",
+                                     new_rowset->ToString()));
+  }
+  return Status::OK();
+}
+
 Status DuplicatingRowSet::CheckRowPresent(const RowSetKeyProbe &probe, const IOContext* io_context,
                                           bool *present, ProbeStats* stats) const {
   *present = false;
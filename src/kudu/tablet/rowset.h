@@ -31,11 +31,14 @@
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowid.h"
+#include "kudu/common/schema.h"
 #include "kudu/common/timestamp.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/tablet/mvcc.h"
+#include "kudu/tablet/pinned_bloom_filter.h"
 #include "kudu/util/bloom_filter.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/status.h"
 // IWYU pragma: no_include "kudu/util/monotime.h"
 
@@ -46,7 +49,7 @@ class RowChangeList;
 class RowwiseIterator;
 class Schema;
 class Slice;
-struct ColumnId;
+class ThreadPool;
 struct IterWithBounds;
 
 namespace consensus {
@@ -63,8 +66,45 @@ class CompactionInput;
 class OperationResultPB;
 class RowSetKeyProbe;
 class RowSetMetadata;
+class RowSetRollupPB;
 struct ProbeStats;
 
+// Collects the rollups of the rowsets which an aggregating scan reads instead
+// of their rows. A rollup can stand in for the rows of a rowset if it groups
+// them by the scan's group-by columns and aggregates all the columns whose
+// aggregates the scan computes.
+//
+// This class is thread-safe: rowsets may be read concurrently.
+class RowSetRollupSink {
+ public:
+  // 'col_ids' are the IDs of the columns of the scan's aggregates which have
+  // one, in the order of the aggregates. None may be one of the scan's
+  // 'num_group_by_columns' group-by columns.
+  RowSetRollupSink(int num_group_by_columns, std::vector<ColumnId> col_ids);
+
+  // Returns true if 'rollup' can stand in for the rows of its rowset.
+  bool CanUse(const RowSetRollupPB& rollup) const;
+
+  // Adds the rollup of a rowset whose rows are skipped by the scan.
+  void Add(std::shared_ptr<const RowSetRollupPB> rollup);
+
+  // Moves the rollups added since the last call into 'rollups'.
+  void Take(std::vector<std::shared_ptr<const RowSetRollupPB>>* rollups);
+
+  const std::vector<ColumnId>& col_ids() const {
+    return col_ids_;
+  }
+
+ private:
+  const int num_group_by_columns_;
+  const std::vector<ColumnId> col_ids_;
+
+  simple_spinlock lock_;
+  std::vector<std::shared_ptr<const RowSetRollupPB>> rollups_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowSetRollupSink);
+};
+
 // Encapsulates all options passed to row-based Iterators.
 struct RowIteratorOptions {
   RowIteratorOptions();
@@ -101,6 +141,77 @@ struct RowIteratorOptions {
   //
   // Defaults to false.
   bool include_deleted_rows;
+
+  // If set, UNORDERED iteration over a tablet reads from up to
+  // 'max_parallelism' rowsets concurrently using threads of this pool.
+  //
+  // Defaults to nullptr.
+  ThreadPool* scan_pool;
+
+  // The maximum number of rowsets read concurrently using 'scan_pool'.
+  //
+  // Defaults to 1.
+  int max_parallelism;
+
+  // If set, the data blocks of all columns needed by each batch read from a
+  // rowset's base data are read concurrently using threads of this pool,
+  // rather than one column after another.
+  //
+  // Defaults to nullptr.
+  ThreadPool* column_read_pool;
+
+  // If set, the scan computes aggregates, and the rollups of the DiskRowSets
+  // which can stand in for their rows are added to this sink instead of the
+  // rows being returned.
+  //
+  // Defaults to nullptr.
+  RowSetRollupSink* rollup_sink;
+};
+
+// The expiry of rows according to the TTL of their table: a row is expired
+// if its value of a UNIXTIME_MICROS primary key column is older than a given
+// time.
+//
+// Since key columns precede the other columns of a schema, the key column has
+// the same index in full rows as in keys, and either may be checked.
+class RowExpiry {
+ public:
+  static RowExpiry Disabled() {
+    return RowExpiry(-1, ColumnId(-1), 0);
+  }
+
+  // Rows whose cell 'col_idx' (the column with ID 'col_id') is lower than
+  // 'expiry_micros' are expired.
+  RowExpiry(int col_idx, ColumnId col_id, int64_t expiry_micros)
+      : col_idx_(col_idx),
+        col_id_(col_id),
+        expiry_micros_(expiry_micros) {
+  }
+
+  bool enabled() const {
+    return col_idx_ >= 0;
+  }
+
+  // Returns true if 'row' is expired. If expiry is disabled, always returns
+  // false.
+  template<class RowType>
+  bool IsExpired(const RowType& row) const {
+    return enabled() &&
+        UnalignedLoad<int64_t>(row.cell_ptr(col_idx_)) < expiry_micros_;
+  }
+
+  ColumnId col_id() const {
+    return col_id_;
+  }
+
+  int64_t expiry_micros() const {
+    return expiry_micros_;
+  }
+
+ private:
+  int col_idx_;
+  ColumnId col_id_;
+  int64_t expiry_micros_;
 };
 
 class RowSet {
@@ -120,6 +231,18 @@ class RowSet {
   virtual Status CheckRowPresent(const RowSetKeyProbe &probe, const fs::IOContext* io_context,
                                  bool *present, ProbeStats* stats) const = 0;
 
+  // Check if each of the 'n' given row keys, which must be sorted by encoded
+  // key, is present in this rowset, like CheckRowPresent(). Sets
+  // 'present[i]' for 'probes[i]', and accounts for it in 'stats[i]'.
+  //
+  // The default implementation checks the keys one at a time; rowsets which
+  // can share work between the keys override it.
+  virtual Status CheckRowsPresent(const RowSetKeyProbe* const* probes,
+                                  size_t n,
+                                  const fs::IOContext* io_context,
+                                  bool* present,
+                                  ProbeStats* const* stats) const;
+
   // Update/delete a row in this rowset.
   // The 'update_schema' is the client schema used to encode the 'update' RowChangeList.
   //
@@ -133,6 +256,19 @@ class RowSet {
                            ProbeStats* stats,
                            OperationResultPB* result) = 0;
 
+  // Delete the rows of this rowset whose encoded keys are within
+  // ['lower_bound_key', 'upper_bound_key') as of 'timestamp'. Rows which
+  // were already deleted are left untouched.
+  //
+  // The caller must ensure that no other write is applied to the range
+  // concurrently: unlike MutateRow() no row locks are held.
+  virtual Status DeleteRange(Timestamp timestamp,
+                             const Slice& lower_bound_key,
+                             const Slice& upper_bound_key,
+                             const consensus::OpId& op_id,
+                             const fs::IOContext* io_context,
+                             OperationResultPB* result) = 0;
+
   // Return a new iterator for this rowset, with the given options.
   //
   // Pointers in 'opts' must remain valid for the lifetime of the iterator.
@@ -206,6 +342,9 @@ class RowSet {
 
   virtual bool DeltaMemStoreEmpty() const = 0;
 
+  // Get the number of deltas scans walked through in the delta's MemStore.
+  virtual int64_t DeltaMemStoreDeltasScanned() const = 0;
+
   // Get the minimum log index corresponding to unflushed data in this row set.
   virtual int64_t MinUnflushedLogIndex() const = 0;
 
@@ -226,6 +365,12 @@ class RowSet {
   virtual Status IsDeletedAndFullyAncient(Timestamp ancient_history_mark,
                                           bool* deleted_and_ancient) = 0;
 
+  // Returns whether all of the rows of the rowset are expired according to
+  // 'row_expiry', which must be enabled.
+  //
+  // This may return false negatives, but should not return false positives.
+  virtual Status IsFullyExpired(const RowExpiry& row_expiry, bool* expired) = 0;
+
   // Estimate the number of bytes in ancient undo delta stores. This may be an
   // overestimate. The argument 'ancient_history_mark' must be valid (it may
   // not be equal to Timestamp::kInvalidTimestamp).
@@ -320,6 +465,7 @@ class RowSetKeyProbe {
       : row_key_(row_key) {
     encoded_key_ = EncodedKey::FromContiguousRow(row_key_);
     bloom_probe_ = BloomKeyProbe(encoded_key_slice());
+    pinned_bloom_hash_ = PinnedBloomFilter::HashKey(encoded_key_slice());
   }
 
   // RowSetKeyProbes are usually allocated on the stack, which means that we
@@ -331,6 +477,7 @@ class RowSetKeyProbe {
   : row_key_(probe.row_key_) {
     encoded_key_ = EncodedKey::FromContiguousRow(row_key_);
     bloom_probe_ = BloomKeyProbe(encoded_key_slice());
+    pinned_bloom_hash_ = PinnedBloomFilter::HashKey(encoded_key_slice());
   }
 
   const ConstContiguousRow& row_key() const { return row_key_; }
@@ -342,6 +489,9 @@ class RowSetKeyProbe {
   // Return the cached structure used to query bloom filters.
   const BloomKeyProbe &bloom_probe() const { return bloom_probe_; }
 
+  // Return the cached hash used to query pinned bloom filters.
+  uint32_t pinned_bloom_hash() const { return pinned_bloom_hash_; }
+
   // The schema containing the key.
   const Schema* schema() const { return row_key_.schema(); }
 
@@ -353,6 +503,7 @@ class RowSetKeyProbe {
   const ConstContiguousRow row_key_;
   std::unique_ptr<EncodedKey> encoded_key_;
   BloomKeyProbe bloom_probe_;
+  uint32_t pinned_bloom_hash_;
 };
 
 // Statistics collected during row operations, counting how many times
@@ -391,7 +542,10 @@ struct ProbeStats {
 // See compaction.txt for a little more detail on how this is used.
 class DuplicatingRowSet : public RowSet {
  public:
-  DuplicatingRowSet(RowSetVector old_rowsets, RowSetVector new_rowsets);
+  // 'row_expiry' is the expiry of rows used to write 'new_rowsets': expired
+  // rows of 'old_rowsets' are missing from them.
+  DuplicatingRowSet(RowSetVector old_rowsets, RowSetVector new_rowsets,
+                    RowExpiry row_expiry);
 
   virtual Status MutateRow(Timestamp timestamp,
                            const RowSetKeyProbe &probe,
@@ -401,6 +555,13 @@ class DuplicatingRowSet : public RowSet {
                            ProbeStats* stats,
                            OperationResultPB* result) OVERRIDE;
 
+  Status DeleteRange(Timestamp timestamp,
+                     const Slice& lower_bound_key,
+                     const Slice& upper_bound_key,
+                     const consensus::OpId& op_id,
+                     const fs::IOContext* io_context,
+                     OperationResultPB* result) OVERRIDE;
+
   Status CheckRowPresent(const RowSetKeyProbe &probe, const fs::IOContext* io_context,
                          bool *present, ProbeStats* stats) const OVERRIDE;
 
@@ -461,6 +622,8 @@ class DuplicatingRowSet : public RowSet {
 
   bool DeltaMemStoreEmpty() const OVERRIDE { return true; }
 
+  int64_t DeltaMemStoreDeltasScanned() const OVERRIDE { return 0; }
+
   double DeltaStoresCompactionPerfImprovementScore(DeltaCompactionType type) const OVERRIDE {
     return 0;
   }
@@ -488,6 +651,12 @@ class DuplicatingRowSet : public RowSet {
     return Status::OK();
   }
 
+  Status IsFullyExpired(const RowExpiry& /*row_expiry*/, bool* expired) override {
+    DCHECK(expired);
+    *expired = false;
+    return Status::OK();
+  }
+
   Status InitUndoDeltas(Timestamp /*ancient_history_mark*/,
                         MonoTime /*deadline*/,
                         const fs::IOContext* /*io_context*/,
@@ -516,6 +685,7 @@ class DuplicatingRowSet : public RowSet {
 
   RowSetVector old_rowsets_;
   RowSetVector new_rowsets_;
+  const RowExpiry row_expiry_;
 };
 
 
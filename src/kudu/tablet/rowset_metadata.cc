@@ -18,6 +18,7 @@
 #include "kudu/tablet/rowset_metadata.h"
 
 #include <algorithm>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
@@ -105,10 +106,25 @@ void RowSetMetadata::LoadFromPB(const RowSetDataPB& pb) {
     blocks_by_col_id_[col_id] = BlockId::FromPB(col_pb.block());
   }
 
+  // Load Secondary Index Files.
+  secondary_index_blocks_by_col_id_.clear();
+  for (const SecondaryIndexDataPB& index_pb : pb.secondary_indexes()) {
+    ColumnId col_id = ColumnId(index_pb.column_id());
+    secondary_index_blocks_by_col_id_[col_id] = BlockId::FromPB(index_pb.block());
+  }
+
+  // Load the rollup.
+  rollup_.reset();
+  if (pb.has_rollup()) {
+    rollup_ = std::make_shared<const RowSetRollupPB>(pb.rollup());
+  }
+
   // Load redo delta files.
   redo_delta_blocks_.clear();
+  delta_timestamp_ranges_.clear();
   for (const DeltaDataPB& redo_delta_pb : pb.redo_deltas()) {
     redo_delta_blocks_.push_back(BlockId::FromPB(redo_delta_pb.block()));
+    LoadDeltaTimestampRangeUnlocked(redo_delta_pb);
   }
 
   last_durable_redo_dms_id_ = pb.last_durable_dms_id();
@@ -117,6 +133,19 @@ void RowSetMetadata::LoadFromPB(const RowSetDataPB& pb) {
   undo_delta_blocks_.clear();
   for (const DeltaDataPB& undo_delta_pb : pb.undo_deltas()) {
     undo_delta_blocks_.push_back(BlockId::FromPB(undo_delta_pb.block()));
+    LoadDeltaTimestampRangeUnlocked(undo_delta_pb);
+  }
+
+  // Load range tombstones.
+  range_tombstones_.clear();
+  for (const RangeTombstonePB& tombstone_pb : pb.range_tombstones()) {
+    range_tombstones_.emplace_back(RangeTombstone::FromPB(tombstone_pb));
+  }
+
+  // Load the maximum values of timestamp key columns.
+  unixtime_key_max_.clear();
+  for (const UnixtimeKeyMaxPB& key_max_pb : pb.unixtime_key_max()) {
+    unixtime_key_max_[ColumnId(key_max_pb.column_id())] = key_max_pb.max_micros();
   }
 
   // Load live row count.
@@ -140,17 +169,31 @@ void RowSetMetadata::ToProtobuf(RowSetDataPB *pb) {
     col_data->set_column_id(col_id);
   }
 
+  // Write Secondary Index Files
+  for (const ColumnIdToBlockIdMap::value_type& e : secondary_index_blocks_by_col_id_) {
+    SecondaryIndexDataPB* index_data = pb->add_secondary_indexes();
+    e.second.CopyToPB(index_data->mutable_block());
+    index_data->set_column_id(e.first);
+  }
+
+  // Write the rollup.
+  if (rollup_) {
+    *pb->mutable_rollup() = *rollup_;
+  }
+
   // Write Delta Files
   pb->set_last_durable_dms_id(last_durable_redo_dms_id_);
 
   for (const BlockId& redo_delta_block : redo_delta_blocks_) {
     DeltaDataPB *redo_delta_pb = pb->add_redo_deltas();
     redo_delta_block.CopyToPB(redo_delta_pb->mutable_block());
+    DeltaTimestampRangeToPBUnlocked(redo_delta_block, redo_delta_pb);
   }
 
   for (const BlockId& undo_delta_block : undo_delta_blocks_) {
     DeltaDataPB *undo_delta_pb = pb->add_undo_deltas();
     undo_delta_block.CopyToPB(undo_delta_pb->mutable_block());
+    DeltaTimestampRangeToPBUnlocked(undo_delta_block, undo_delta_pb);
   }
 
   // Write Bloom File
@@ -169,6 +212,18 @@ void RowSetMetadata::ToProtobuf(RowSetDataPB *pb) {
     pb->set_max_encoded_key(*max_encoded_key_);
   }
 
+  // Write the range tombstones.
+  for (const RangeTombstone& tombstone : range_tombstones_) {
+    tombstone.ToPB(pb->add_range_tombstones());
+  }
+
+  // Write the maximum values of timestamp key columns.
+  for (const auto& e : unixtime_key_max_) {
+    UnixtimeKeyMaxPB* key_max_pb = pb->add_unixtime_key_max();
+    key_max_pb->set_column_id(e.first);
+    key_max_pb->set_max_micros(e.second);
+  }
+
   // Write the live row count.
   if (tablet_metadata_->supports_live_row_count()) {
     pb->set_live_row_count(live_row_count_);
@@ -186,6 +241,14 @@ void RowSetMetadata::SetColumnDataBlocks(const std::map<ColumnId, BlockId>& bloc
   blocks_by_col_id_ = std::move(new_map);
 }
 
+void RowSetMetadata::SetSecondaryIndexBlocks(
+    const std::map<ColumnId, BlockId>& blocks_by_col_id) {
+  ColumnIdToBlockIdMap new_map(blocks_by_col_id.begin(), blocks_by_col_id.end());
+  new_map.shrink_to_fit();
+  std::lock_guard<LockType> l(lock_);
+  secondary_index_blocks_by_col_id_ = std::move(new_map);
+}
+
 Status RowSetMetadata::CommitRedoDeltaDataBlock(int64_t dms_id,
                                                 int64_t num_deleted_rows,
                                                 const BlockId& block_id) {
@@ -202,6 +265,66 @@ Status RowSetMetadata::CommitUndoDeltaDataBlock(const BlockId& block_id) {
   return Status::OK();
 }
 
+void RowSetMetadata::SetDeltaTimestampRange(const BlockId& block_id,
+                                            Timestamp min_timestamp,
+                                            Timestamp max_timestamp) {
+  if (min_timestamp > max_timestamp) {
+    // The stats of a delta file without any deltas: nothing to record.
+    return;
+  }
+  std::lock_guard<LockType> l(lock_);
+  delta_timestamp_ranges_[block_id] = { min_timestamp, max_timestamp };
+}
+
+bool RowSetMetadata::GetDeltaTimestampRange(const BlockId& block_id,
+                                            Timestamp* min_timestamp,
+                                            Timestamp* max_timestamp) const {
+  std::lock_guard<LockType> l(lock_);
+  const auto* range = FindOrNull(delta_timestamp_ranges_, block_id);
+  if (!range) {
+    return false;
+  }
+  *min_timestamp = range->first;
+  *max_timestamp = range->second;
+  return true;
+}
+
+bool RowSetMetadata::GetUnixtimeKeyMax(ColumnId col_id, int64_t* max_micros) const {
+  std::lock_guard<LockType> l(lock_);
+  const int64_t* key_max = FindOrNull(unixtime_key_max_, col_id);
+  if (!key_max) {
+    return false;
+  }
+  *max_micros = *key_max;
+  return true;
+}
+
+void RowSetMetadata::CommitRangeTombstones(const vector<RangeTombstone>& tombstones) {
+  std::lock_guard<LockType> l(lock_);
+  int64_t num_deleted_rows = 0;
+  for (const RangeTombstone& tombstone : tombstones) {
+    range_tombstones_.push_back(tombstone);
+    num_deleted_rows += tombstone.end_row - tombstone.first_row;
+  }
+  IncrementLiveRowsUnlocked(-num_deleted_rows);
+}
+
+void RowSetMetadata::LoadDeltaTimestampRangeUnlocked(const DeltaDataPB& pb) {
+  if (pb.has_min_timestamp() && pb.has_max_timestamp()) {
+    delta_timestamp_ranges_[BlockId::FromPB(pb.block())] = {
+        Timestamp(pb.min_timestamp()), Timestamp(pb.max_timestamp()) };
+  }
+}
+
+void RowSetMetadata::DeltaTimestampRangeToPBUnlocked(const BlockId& block_id,
+                                                     DeltaDataPB* pb) const {
+  const auto* range = FindOrNull(delta_timestamp_ranges_, block_id);
+  if (range) {
+    pb->set_min_timestamp(range->first.ToUint64());
+    pb->set_max_timestamp(range->second.ToUint64());
+  }
+}
+
 void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
                                   BlockIdContainer* removed) {
   removed->clear();
@@ -255,9 +378,14 @@ void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
         << vector<BlockId>(undos_to_remove.begin(), undos_to_remove.end())
         << " }";
 
-    if (!update.new_undo_block_.IsNull()) {
-      // Front-loading to keep the UNDO files in their natural order.
-      undo_delta_blocks_.insert(undo_delta_blocks_.begin(), update.new_undo_block_);
+    // Front-loading to keep the UNDO files in their natural order.
+    undo_delta_blocks_.insert(undo_delta_blocks_.begin(),
+                              update.new_undo_blocks_.begin(),
+                              update.new_undo_blocks_.end());
+
+    // The rollup doesn't reflect base data rewritten with the deltas.
+    if (!update.cols_to_replace_.empty() || !update.col_ids_to_remove_.empty()) {
+      rollup_.reset();
     }
 
     for (const ColumnIdToBlockIdMap::value_type& e : update.cols_to_replace_) {
@@ -268,12 +396,26 @@ void RowSetMetadata::CommitUpdate(const RowSetMetadataUpdate& update,
       if (UpdateReturnCopy(&blocks_by_col_id_, e.first, e.second, &old_block_id)) {
         removed->push_back(old_block_id);
       }
+      // The secondary index of the column, if any, doesn't reflect the new
+      // base data, so drop it.
+      if (FindCopy(secondary_index_blocks_by_col_id_, e.first, &old_block_id)) {
+        secondary_index_blocks_by_col_id_.erase(e.first);
+        removed->push_back(old_block_id);
+      }
     }
 
     for (const ColumnId& col_id : update.col_ids_to_remove_) {
       BlockId old = FindOrDie(blocks_by_col_id_, col_id);
       CHECK_EQ(1, blocks_by_col_id_.erase(col_id));
       removed->push_back(old);
+      if (FindCopy(secondary_index_blocks_by_col_id_, col_id, &old)) {
+        secondary_index_blocks_by_col_id_.erase(col_id);
+        removed->push_back(old);
+      }
+    }
+
+    for (const BlockId& b : *removed) {
+      delta_timestamp_ranges_.erase(b);
     }
   }
 
@@ -308,6 +450,7 @@ BlockIdContainer RowSetMetadata::GetAllBlocks() {
     blocks.push_back(bloom_block_);
   }
   AppendValuesFromMap(blocks_by_col_id_, &blocks);
+  AppendValuesFromMap(secondary_index_blocks_by_col_id_, &blocks);
 
   blocks.insert(blocks.end(),
                 undo_delta_blocks_.begin(), undo_delta_blocks_.end());
@@ -348,8 +491,8 @@ RowSetMetadataUpdate& RowSetMetadataUpdate::RemoveUndoDeltaBlocks(
   return *this;
 }
 
-RowSetMetadataUpdate& RowSetMetadataUpdate::SetNewUndoBlock(const BlockId& undo_block) {
-  new_undo_block_ = undo_block;
+RowSetMetadataUpdate& RowSetMetadataUpdate::AddNewUndoBlock(const BlockId& undo_block) {
+  new_undo_blocks_.push_back(undo_block);
   return *this;
 }
 
@@ -22,6 +22,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,10 +32,12 @@
 #include <glog/logging.h>
 
 #include "kudu/common/schema.h"
+#include "kudu/common/timestamp.h"
 #include "kudu/fs/block_id.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/tablet/range_tombstone.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/status.h"
@@ -43,7 +46,9 @@ namespace kudu {
 
 namespace tablet {
 
+class DeltaDataPB;
 class RowSetDataPB;
+class RowSetRollupPB;
 class RowSetMetadataUpdate;
 
 // Keeps track of the RowSet data blocks.
@@ -117,6 +122,16 @@ class RowSetMetadata {
 
   void SetColumnDataBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id);
 
+  // Sets the blocks of the secondary indexes of the rowset, keyed by the ID
+  // of the indexed column.
+  void SetSecondaryIndexBlocks(const std::map<ColumnId, BlockId>& blocks_by_col_id);
+
+  // Sets the pre-aggregated rollup of the rows of the rowset's base data.
+  void set_rollup(std::shared_ptr<const RowSetRollupPB> rollup) {
+    std::lock_guard<LockType> l(lock_);
+    rollup_ = std::move(rollup);
+  }
+
   // Atomically commit the new redo delta block to RowSetMetadata.
   // This atomic operation includes updates to last_durable_redo_dms_id_ and live_row_count_.
   Status CommitRedoDeltaDataBlock(int64_t dms_id,
@@ -125,6 +140,41 @@ class RowSetMetadata {
 
   Status CommitUndoDeltaDataBlock(const BlockId& block_id);
 
+  // Record that the deltas of the delta block 'block_id' have timestamps
+  // within [min_timestamp, max_timestamp].
+  void SetDeltaTimestampRange(const BlockId& block_id,
+                              Timestamp min_timestamp,
+                              Timestamp max_timestamp);
+
+  // Returns the range of the timestamps of the deltas of the delta block
+  // 'block_id' in 'min_timestamp' and 'max_timestamp', or false if it isn't
+  // known.
+  bool GetDeltaTimestampRange(const BlockId& block_id,
+                              Timestamp* min_timestamp,
+                              Timestamp* max_timestamp) const;
+
+  // Atomically record the range tombstones of rows of the base data in
+  // 'tombstones', which must only cover live rows, and decrement
+  // live_row_count_ by the number of rows they cover.
+  void CommitRangeTombstones(const std::vector<RangeTombstone>& tombstones);
+
+  // Returns the range tombstones recorded with CommitRangeTombstones().
+  std::vector<RangeTombstone> range_tombstones() const {
+    std::lock_guard<LockType> l(lock_);
+    return range_tombstones_;
+  }
+
+  // Record 'max_micros' as the maximum value of the UNIXTIME_MICROS key
+  // column 'col_id' among the rows of the base data.
+  void set_unixtime_key_max(ColumnId col_id, int64_t max_micros) {
+    std::lock_guard<LockType> l(lock_);
+    unixtime_key_max_[col_id] = max_micros;
+  }
+
+  // Returns false if the maximum value of the key column 'col_id' isn't
+  // known, e.g. because the rowset was written before they were recorded.
+  bool GetUnixtimeKeyMax(ColumnId col_id, int64_t* max_micros) const;
+
   bool has_encoded_keys_unlocked() const {
     return min_encoded_key_ != boost::none && max_encoded_key_ != boost::none;
   }
@@ -181,6 +231,17 @@ class RowSetMetadata {
     return blocks_by_col_id_;
   }
 
+  ColumnIdToBlockIdMap GetSecondaryIndexBlocksById() const {
+    std::lock_guard<LockType> l(lock_);
+    return secondary_index_blocks_by_col_id_;
+  }
+
+  // Returns the rollup of the rowset's base data, or null if it has none.
+  std::shared_ptr<const RowSetRollupPB> rollup() const {
+    std::lock_guard<LockType> l(lock_);
+    return rollup_;
+  }
+
   std::vector<BlockId> redo_delta_blocks() const {
     std::lock_guard<LockType> l(lock_);
     return redo_delta_blocks_;
@@ -262,6 +323,13 @@ class RowSetMetadata {
 
   void IncrementLiveRowsUnlocked(int64_t row_count);
 
+  // Load the range of the timestamps of the delta block of 'pb', if any.
+  void LoadDeltaTimestampRangeUnlocked(const DeltaDataPB& pb);
+
+  // Store the range of the timestamps of the delta block 'block_id', if
+  // known, into 'pb'.
+  void DeltaTimestampRangeToPBUnlocked(const BlockId& block_id, DeltaDataPB* pb) const;
+
   TabletMetadata* const tablet_metadata_;
   bool initted_;
   int64_t id_;
@@ -278,9 +346,25 @@ class RowSetMetadata {
 
   // Map of column ID to block ID.
   ColumnIdToBlockIdMap blocks_by_col_id_;
+  // Map of column ID to the block ID of the secondary index of the column.
+  ColumnIdToBlockIdMap secondary_index_blocks_by_col_id_;
+  // The rollup of the rows of the base data, if it was computed when the
+  // rowset was written. It's immutable and is replaced as a whole.
+  std::shared_ptr<const RowSetRollupPB> rollup_;
   std::vector<BlockId> redo_delta_blocks_;
   std::vector<BlockId> undo_delta_blocks_;
 
+  // The ranges of the timestamps of the deltas of the delta blocks, when
+  // known. Delta blocks written before they were recorded have none.
+  std::unordered_map<BlockId, std::pair<Timestamp, Timestamp>,
+                     BlockIdHash, BlockIdEqual> delta_timestamp_ranges_;
+
+  // The tombstones of ranges of rows deleted since the base data was written.
+  std::vector<RangeTombstone> range_tombstones_;
+
+  // The maximum values of the UNIXTIME_MICROS key columns, by column ID.
+  std::map<ColumnId, int64_t> unixtime_key_max_;
+
   int64_t last_durable_redo_dms_id_;
 
   // Number of live rows on disk, excluding those in [MRS/DMS].
@@ -314,9 +398,10 @@ class RowSetMetadataUpdate {
   // Remove the CFile for the given column ID.
   RowSetMetadataUpdate& RemoveColumnId(ColumnId col_id);
 
-  // Add a new UNDO delta block to the list of UNDO files.
+  // Add a new UNDO delta block to the list of UNDO files. May be called
+  // several times, e.g. once per group of columns of a major delta compaction.
   // We'll need to replace them instead when we start GCing.
-  RowSetMetadataUpdate& SetNewUndoBlock(const BlockId& undo_block);
+  RowSetMetadataUpdate& AddNewUndoBlock(const BlockId& undo_block);
 
  private:
   friend class RowSetMetadata;
@@ -331,7 +416,7 @@ class RowSetMetadataUpdate {
   std::vector<ReplaceDeltaBlocks> replace_redo_blocks_;
 
   std::vector<BlockId> remove_undo_blocks_;
-  BlockId new_undo_block_;
+  std::vector<BlockId> new_undo_blocks_;
 
   DISALLOW_COPY_AND_ASSIGN(RowSetMetadataUpdate);
 };
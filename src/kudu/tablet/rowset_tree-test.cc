@@ -29,6 +29,7 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -42,6 +43,8 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int32(rowset_tree_flat_index_max_entries);
+
 using std::shared_ptr;
 using std::string;
 using std::unordered_set;
@@ -275,6 +278,72 @@ TEST_F(TestRowSetTree, TestTreeRandomized) {
   }
 }
 
+// Test that lookups through the flat index find the same rowsets as lookups
+// through the interval tree, including for keys at the bounds of rowsets.
+TEST_F(TestRowSetTree, TestFlatIndexMatchesIntervalTree) {
+  SeedRandom();
+  RowSetVector vec;
+  for (int i = 0; i < 200; i++) {
+    int min = rand() % 1000;
+    int max = min + rand() % 50;
+    // Some keys are longer than the 8-byte prefixes of the flat index.
+    const char* fmt = i % 2 ? "%04d" : "prefix%04d";
+    vec.emplace_back(new MockDiskRowSet(StringPrintf(fmt, min), StringPrintf(fmt, max)));
+  }
+  vec.emplace_back(new MockMemRowSet());
+
+  RowSetTree flat_tree;
+  ASSERT_OK(flat_tree.Reset(vec));
+  ASSERT_TRUE(flat_tree.has_flat_index());
+  FLAGS_rowset_tree_flat_index_max_entries = 0;
+  RowSetTree interval_tree;
+  ASSERT_OK(interval_tree.Reset(vec));
+  ASSERT_FALSE(interval_tree.has_flat_index());
+
+  // Including duplicate keys.
+  vector<string> queries;
+  for (int i = 0; i < 1000; i++) {
+    queries.emplace_back(StringPrintf(rand() % 2 ? "%04d" : "prefix%04d", rand() % 1100));
+  }
+  queries.emplace_back("");
+  std::sort(queries.begin(), queries.end());
+  vector<Slice> query_slices(queries.begin(), queries.end());
+
+  vector<RowSet*> flat_out;
+  vector<RowSet*> interval_out;
+  for (const auto& q : queries) {
+    flat_out.clear();
+    interval_out.clear();
+    flat_tree.FindRowSetsWithKeyInRange(q, &flat_out);
+    interval_tree.FindRowSetsWithKeyInRange(q, &interval_out);
+    std::sort(flat_out.begin(), flat_out.end());
+    std::sort(interval_out.begin(), interval_out.end());
+    ASSERT_EQ(interval_out, flat_out) << q;
+  }
+
+  // The batched lookups make a single group of calls per rowset.
+  vector<std::pair<RowSet*, int>> flat_matches;
+  vector<std::pair<RowSet*, int>> interval_matches;
+  flat_tree.ForEachRowSetContainingKeys(query_slices, [&](RowSet* rs, int i) {
+    if (!flat_matches.empty() && flat_matches.back().first == rs) {
+      ASSERT_LT(flat_matches.back().second, i);
+    }
+    flat_matches.emplace_back(rs, i);
+  });
+  unordered_set<RowSet*> seen;
+  for (int i = 0; i < flat_matches.size(); i++) {
+    if (i == 0 || flat_matches[i - 1].first != flat_matches[i].first) {
+      ASSERT_TRUE(seen.insert(flat_matches[i].first).second);
+    }
+  }
+  interval_tree.ForEachRowSetContainingKeys(query_slices, [&](RowSet* rs, int i) {
+    interval_matches.emplace_back(rs, i);
+  });
+  std::sort(flat_matches.begin(), flat_matches.end());
+  std::sort(interval_matches.begin(), interval_matches.end());
+  ASSERT_EQ(interval_matches, flat_matches);
+}
+
 class TestRowSetTreePerformance : public TestRowSetTree,
                                   public testing::WithParamInterface<std::tuple<int, int>> {
 };
@@ -19,21 +19,37 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
-#include <ostream>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "kudu/gutil/endian.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/tablet/rowset.h"
 #include "kudu/tablet/rowset_metadata.h"
 #include "kudu/util/interval_tree.h"
 #include "kudu/util/interval_tree-inl.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/slice.h"
 
+DEFINE_int32(rowset_tree_flat_index_max_entries, 1 << 20,
+             "The maximum number of (region, rowset) entries of the flat index "
+             "used to find the rowsets which may contain a key. The number of "
+             "entries grows with the number of rowsets and with how much they "
+             "overlap; beyond this number, lookups go through an interval tree "
+             "instead. 0 disables the flat index.");
+TAG_FLAG(rowset_tree_flat_index_max_entries, advanced);
+TAG_FLAG(rowset_tree_flat_index_max_entries, experimental);
+TAG_FLAG(rowset_tree_flat_index_max_entries, runtime);
+
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -63,6 +79,33 @@ struct QueryStruct {
   int idx;
 };
 
+// Return the first 8 bytes of 'key', zero-padded, as a big-endian integer.
+// Comparing the prefixes of two keys is consistent with comparing the keys:
+// if the prefix of 'a' is less than the prefix of 'b', 'a' is less than 'b'.
+uint64_t KeyPrefix(const Slice& key) {
+  uint8_t buf[sizeof(uint64_t)] = {};
+  memcpy(buf, key.data(), std::min(key.size(), sizeof(buf)));
+  return BigEndian::Load64(buf);
+}
+
+// Return the index of the first of the 'n' sorted values at 'vals' which is
+// not less than 'val' (if 'or_equal' is false) or greater than 'val' (if it is
+// true). The search is branch-free, so that its cost doesn't depend on how
+// predictable the comparisons are.
+template<bool or_equal>
+size_t FlatSearch(const uint64_t* vals, size_t n, uint64_t val) {
+  if (n == 0) {
+    return 0;
+  }
+  const uint64_t* base = vals;
+  while (n > 1) {
+    size_t half = n / 2;
+    base += (or_equal ? base[half - 1] <= val : base[half - 1] < val) ? half : 0;
+    n -= half;
+  }
+  return (base - vals) + (or_equal ? *base <= val : *base < val);
+}
+
 } // anonymous namespace
 
 // Entry for use in the interval tree.
@@ -179,6 +222,7 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
   tree_.reset(new IntervalTree<RowSetIntervalTraits>(entries_));
   key_endpoints_.swap(endpoints);
   all_rowsets_.assign(rowsets.begin(), rowsets.end());
+  BuildFlatIndex();
 
   // Build the mapping from DRS ID to DRS.
   drs_by_id_.clear();
@@ -193,6 +237,99 @@ Status RowSetTree::Reset(const RowSetVector &rowsets) {
   return Status::OK();
 }
 
+void RowSetTree::BuildFlatIndex() {
+  const int64_t max_entries = FLAGS_rowset_tree_flat_index_max_entries;
+  if (max_entries <= 0 || entries_.empty()) {
+    return;
+  }
+
+  vector<Slice> bounds;
+  bounds.reserve(entries_.size() * 2);
+  for (const RowSetWithBounds* e : entries_) {
+    bounds.emplace_back(e->min_key);
+    bounds.emplace_back(e->max_key);
+  }
+  std::sort(bounds.begin(), bounds.end(), Slice::Comparator());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+  // The bound with index 'j' is region 2j + 1, so a rowset overlaps the
+  // regions from the one of its min key to the one of its max key. Count the
+  // rowsets starting and ending at each region first.
+  const auto BoundIndex = [&](const string& key) {
+    return std::lower_bound(bounds.begin(), bounds.end(), Slice(key),
+                            Slice::Comparator()) - bounds.begin();
+  };
+  const size_t num_regions = bounds.size() * 2 + 1;
+  vector<int64_t> deltas(num_regions + 1, 0);
+  vector<std::pair<size_t, size_t>> entry_regions;
+  entry_regions.reserve(entries_.size());
+  int64_t num_entries = 0;
+  for (const RowSetWithBounds* e : entries_) {
+    size_t first = BoundIndex(e->min_key) * 2 + 1;
+    size_t last = BoundIndex(e->max_key) * 2 + 1;
+    num_entries += last - first + 1;
+    if (num_entries > max_entries) {
+      VLOG(1) << "Not building a flat rowset index: more than " << max_entries
+              << " entries needed for " << entries_.size() << " rowsets";
+      return;
+    }
+    deltas[first]++;
+    deltas[last + 1]--;
+    entry_regions.emplace_back(first, last);
+  }
+
+  vector<uint32_t> offsets(num_regions + 1);
+  offsets[0] = 0;
+  int64_t num_overlapping = 0;
+  for (size_t r = 0; r < num_regions; r++) {
+    num_overlapping += deltas[r];
+    offsets[r + 1] = offsets[r] + num_overlapping;
+  }
+  DCHECK_EQ(num_entries, offsets[num_regions]);
+
+  // Fill in the regions in the order of the rowsets, so that the rowsets of
+  // each region are sorted.
+  vector<uint32_t> flat_entries(num_entries);
+  vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < entry_regions.size(); i++) {
+    for (size_t r = entry_regions[i].first; r <= entry_regions[i].second; r++) {
+      flat_entries[cursors[r]++] = i;
+    }
+  }
+
+  flat_prefixes_.clear();
+  flat_prefixes_.reserve(bounds.size());
+  for (const Slice& b : bounds) {
+    flat_prefixes_.push_back(KeyPrefix(b));
+  }
+  flat_bounds_.swap(bounds);
+  flat_offsets_.swap(offsets);
+  flat_entries_.swap(flat_entries);
+}
+
+size_t RowSetTree::FindFlatRegion(const Slice& encoded_key, size_t* start) const {
+  DCHECK(has_flat_index());
+  const size_t num_bounds = flat_bounds_.size();
+  DCHECK_LE(*start, num_bounds);
+
+  // Narrow the search down to the bounds sharing the prefix of the key, and
+  // compare whole keys only among those.
+  const uint64_t prefix = KeyPrefix(encoded_key);
+  const uint64_t* prefixes = flat_prefixes_.data();
+  size_t lo = *start + FlatSearch<false>(prefixes + *start, num_bounds - *start, prefix);
+  size_t hi = lo + FlatSearch<true>(prefixes + lo, num_bounds - lo, prefix);
+  size_t idx = std::upper_bound(flat_bounds_.begin() + lo, flat_bounds_.begin() + hi,
+                                encoded_key, Slice::Comparator()) - flat_bounds_.begin();
+  *start = idx;
+
+  // 'idx' is the index of the first bound greater than the key: the key
+  // either is the previous bound or lies between the two.
+  if (idx > 0 && flat_bounds_[idx - 1] == encoded_key) {
+    return idx * 2 - 1;
+  }
+  return idx * 2;
+}
+
 void RowSetTree::FindRowSetsIntersectingInterval(const boost::optional<Slice>& lower_bound,
                                                  const boost::optional<Slice>& upper_bound,
                                                  vector<RowSet*>* rowsets) const {
@@ -221,6 +358,16 @@ void RowSetTree::FindRowSetsWithKeyInRange(const Slice &encoded_key,
     rowsets->push_back(rs.get());
   }
 
+  if (has_flat_index()) {
+    size_t start = 0;
+    size_t region = FindFlatRegion(encoded_key, &start);
+    rowsets->reserve(rowsets->size() + flat_offsets_[region + 1] - flat_offsets_[region]);
+    for (uint32_t i = flat_offsets_[region]; i < flat_offsets_[region + 1]; i++) {
+      rowsets->push_back(entries_[flat_entries_[i]]->rowset);
+    }
+    return;
+  }
+
   // Query the interval tree to efficiently find rowsets with known bounds
   // whose ranges overlap the probe key.
   vector<RowSetWithBounds *> from_tree;
@@ -245,6 +392,24 @@ void RowSetTree::ForEachRowSetContainingKeys(
     }
   }
 
+  if (has_flat_index()) {
+    // Look the sorted keys up one after the other, each search starting at
+    // the region of the previous key, then group the matches by rowset.
+    vector<uint64_t> matches;
+    size_t start = 0;
+    for (int i = 0; i < encoded_keys.size(); i++) {
+      size_t region = FindFlatRegion(encoded_keys[i], &start);
+      for (uint32_t j = flat_offsets_[region]; j < flat_offsets_[region + 1]; j++) {
+        matches.push_back(static_cast<uint64_t>(flat_entries_[j]) << 32 | i);
+      }
+    }
+    std::sort(matches.begin(), matches.end());
+    for (uint64_t m : matches) {
+      cb(entries_[m >> 32]->rowset, static_cast<int>(m & 0xffffffff));
+    }
+    return;
+  }
+
   // The interval tree batch query callback would naturally just give us back
   // the matching Slices, but that won't allow us to easily tell the caller
   // which specific operation _index_ matched the RowSet. So, we make a vector
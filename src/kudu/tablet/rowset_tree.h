@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -79,8 +80,9 @@ class RowSetTree {
   // Call 'cb(rowset, index)' for each (rowset, index) pair such that
   // 'encoded_keys[index]' may be within the bounds of 'rowset'.
   //
-  // See IntervalTree::ForEachIntervalContainingPoints for additional
-  // information on the particular order in which the callback will be called.
+  // The calls for a given rowset are made in groups of increasing indexes.
+  // When the flat index is built, there is a single group per rowset; see
+  // IntervalTree::ForEachIntervalContainingPoints for the order otherwise.
   //
   // REQUIRES: 'encoded_keys' must be in sorted order.
   void ForEachRowSetContainingKeys(const std::vector<Slice>& encoded_keys,
@@ -108,7 +110,21 @@ class RowSetTree {
   // its stop slice, equivalent to its GetBounds() values.
   const std::vector<RSEndpoint>& key_endpoints() const { return key_endpoints_; }
 
+  // Whether point lookups are served by the flat index rather than by the
+  // interval tree. Exposed for tests.
+  bool has_flat_index() const { return !flat_offsets_.empty(); }
+
  private:
+  // Build the flat index over 'entries_', unless it would hold more than
+  // --rowset_tree_flat_index_max_entries entries.
+  void BuildFlatIndex();
+
+  // Return the index in the flat index of the region holding 'encoded_key',
+  // which must be at or after the bound at index 'start'. Sets 'start' to
+  // the index of the first bound greater than 'encoded_key', which may be
+  // used as the 'start' of the lookup of a greater key.
+  size_t FindFlatRegion(const Slice& encoded_key, size_t* start) const;
+
   // Interval tree of the rowsets. Used to efficiently find rowsets which might contain
   // a probe row.
   std::unique_ptr<IntervalTree<RowSetIntervalTraits>> tree_;
@@ -123,6 +139,22 @@ class RowSetTree {
   // all the entry structs and free them in the destructor.
   std::vector<RowSetWithBounds *> entries_;
 
+  // Flat index of the rowsets with known bounds, used for point lookups.
+  //
+  // The distinct bounds of the rowsets, sorted, split the key space into
+  // regions: each bound on its own, and the open intervals in between and
+  // around them. The region holding a key is found by binary search over
+  // the first 8 bytes of the bounds, packed as big-endian integers in
+  // 'flat_prefixes_', followed by a comparison of the whole keys among the
+  // bounds sharing the prefix of the key. The indexes in 'entries_' of the
+  // rowsets overlapping region 'r' are then found at
+  // [flat_offsets_[r], flat_offsets_[r + 1]) of 'flat_entries_', in
+  // increasing order.
+  std::vector<uint64_t> flat_prefixes_;
+  std::vector<Slice> flat_bounds_;
+  std::vector<uint32_t> flat_offsets_;
+  std::vector<uint32_t> flat_entries_;
+
   // All of the rowsets which were put in this RowSetTree.
   RowSetVector all_rowsets_;
 
@@ -83,8 +83,14 @@ class TabletHarness {
   Status Create(bool first_time) {
     std::pair<PartitionSchema, Partition> partition(CreateDefaultPartition(schema_));
 
+    metrics_registry_.reset(new MetricRegistry);
+    metric_entity_ = METRIC_ENTITY_server.Instantiate(metrics_registry_.get(),
+                                                      "tablet-harness");
+
     // Build the Tablet
-    fs_manager_.reset(new FsManager(options_.env, FsManagerOpts(options_.root_dir)));
+    FsManagerOpts fs_opts(options_.root_dir);
+    fs_opts.metric_entity = metric_entity_;
+    fs_manager_.reset(new FsManager(options_.env, fs_opts));
     if (first_time) {
       RETURN_NOT_OK(fs_manager_->CreateInitialFileSystemLayout());
     }
@@ -103,9 +109,6 @@ class TabletHarness {
                                                /*extra_config=*/ boost::none,
                                                /*dimension_label=*/ boost::none,
                                                &metadata));
-    metrics_registry_.reset(new MetricRegistry);
-    metric_entity_ = METRIC_ENTITY_server.Instantiate(metrics_registry_.get(),
-                                                      "tablet-harness");
 
     switch (options_.clock_type) {
       case Options::HYBRID_CLOCK:
@@ -150,6 +153,10 @@ class TabletHarness {
     return metrics_registry_.get();
   }
 
+  const scoped_refptr<MetricEntity>& metric_entity() const {
+    return metric_entity_;
+  }
+
  private:
   Options options_;
 
@@ -70,6 +70,8 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_int32(tablet_bulk_insert_min_rows);
+
 DEFINE_int32(testflush_num_inserts, 1000,
              "Number of rows inserted in TestFlush");
 DEFINE_int32(testiterator_num_inserts, 1000,
@@ -411,6 +413,78 @@ TYPED_TEST(TestTablet, TestDeleteWithFlushAndCompact) {
 }
 
 // Test flushes dealing with REINSERT mutations in the MemRowSet.
+// Test that DELETE_RANGE deletes the live rows of the range from both the
+// MemRowSet and the DiskRowSets, and that the range tombstones of the latter
+// are materialized by compactions.
+TYPED_TEST(TestTablet, TestDeleteRange) {
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  // Rows 0-4 are in a DiskRowSet, rows 5-9 in the MemRowSet.
+  this->InsertTestRows(0, 5, 0);
+  ASSERT_OK(this->tablet()->Flush());
+  this->InsertTestRows(5, 5, 0);
+  // Row 4 is already deleted by the time of the range delete.
+  ASSERT_OK(this->DeleteTestRow(&writer, 4));
+
+  vector<MvccSnapshot> snaps;
+  snaps.emplace_back(*this->tablet()->mvcc_manager());
+
+  KuduPartialRow lower_bound(&this->client_schema_);
+  this->setup_.BuildRowKey(&lower_bound, 2);
+  KuduPartialRow upper_bound(&this->client_schema_);
+  this->setup_.BuildRowKey(&upper_bound, 7);
+  ASSERT_OK(writer.DeleteRange(lower_bound, upper_bound));
+  snaps.emplace_back(*this->tablet()->mvcc_manager());
+
+  // Only the MemRowSet holds the deletes: those of the DiskRowSet are durable
+  // range tombstones.
+  ASSERT_EQ(1, writer.last_op_result().mutated_stores_size());
+  ASSERT_EQ(1L, writer.last_op_result().mutated_stores(0).mrs_id());
+
+  vector<string> rows;
+  ASSERT_OK(this->IterateToStringList(&rows));
+  ASSERT_EQ(5, rows.size());
+  std::sort(rows.begin(), rows.end());
+  EXPECT_EQ(this->setup_.FormatDebugRow(1, 0, false), rows[1]);
+  EXPECT_EQ(this->setup_.FormatDebugRow(7, 0, false), rows[2]);
+  NO_FATALS(this->CheckLiveRowsCount(5));
+
+  // Rows deleted by the range can be inserted again.
+  ASSERT_OK(this->InsertTestRow(&writer, 3, 1));
+  ASSERT_OK(this->InsertTestRow(&writer, 5, 1));
+  snaps.emplace_back(*this->tablet()->mvcc_manager());
+
+  vector<vector<string>*> expected_rows;
+  CollectRowsForSnapshots(this->tablet().get(), this->client_schema_,
+                          snaps, &expected_rows);
+  ASSERT_EQ(9, expected_rows[0]->size());
+  ASSERT_EQ(5, expected_rows[1]->size());
+  ASSERT_EQ(7, expected_rows[2]->size());
+
+  // Flushing and compacting everything materializes the tombstones without
+  // changing the results of any snapshot.
+  ASSERT_OK(this->tablet()->Flush());
+  VerifySnapshotsHaveSameResult(this->tablet().get(), this->client_schema_,
+                                snaps, expected_rows);
+  ASSERT_OK(this->tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  VerifySnapshotsHaveSameResult(this->tablet().get(), this->client_schema_,
+                                snaps, expected_rows);
+  NO_FATALS(this->CheckLiveRowsCount(7));
+
+  // Deleting a range which holds no live rows is a no-op.
+  KuduPartialRow deleted_row(&this->client_schema_);
+  this->setup_.BuildRowKey(&deleted_row, 4);
+  KuduPartialRow reinserted_row(&this->client_schema_);
+  this->setup_.BuildRowKey(&reinserted_row, 5);
+  ASSERT_OK(writer.DeleteRange(deleted_row, reinserted_row));
+  ASSERT_OK(this->IterateToStringList(&rows));
+  ASSERT_EQ(7, rows.size());
+
+  // Empty ranges are invalid.
+  Status s = writer.DeleteRange(reinserted_row, deleted_row);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  STLDeleteElements(&expected_rows);
+}
+
 TYPED_TEST(TestTablet, TestFlushWithReinsert) {
   LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
   // Insert, delete, and re-insert a row in the MRS.
@@ -621,6 +695,46 @@ TYPED_TEST(TestTablet, TestRowIteratorOrdered) {
   }
 }
 
+TYPED_TEST(TestTablet, TestRowIteratorOrderedDisjointRowSets) {
+  // Flush each batch of consecutive keys into its own rowset, so that the
+  // rowsets' key ranges don't overlap. The keys all have two digits so that
+  // string keys sort the same way as integer keys.
+  const int kFirstKey = 10;
+  const int kRowsPerBatch = 8;
+  const int kNumBatches = 4;
+  LocalTabletWriter writer(this->tablet().get(), &this->client_schema_);
+  for (int i = kNumBatches - 1; i >= 0; i--) {
+    for (int j = 0; j < kRowsPerBatch; j++) {
+      ASSERT_OK(this->InsertTestRow(&writer, kFirstKey + i * kRowsPerBatch + j, 0));
+    }
+    ASSERT_OK(this->tablet()->Flush());
+  }
+
+  RowIteratorOptions opts;
+  opts.projection = &this->client_schema_;
+  opts.order = ORDERED;
+  unique_ptr<RowwiseIterator> iter;
+  ASSERT_OK(this->tablet()->NewRowIterator(std::move(opts), &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  ASSERT_STR_CONTAINS(iter->ToString(), "Union(");
+
+  vector<string> rows;
+  ASSERT_OK(IterateToStringList(iter.get(), &rows));
+  ASSERT_EQ(kRowsPerBatch * kNumBatches, rows.size());
+  for (int i = 0; i < rows.size(); i++) {
+    ASSERT_EQ(this->setup_.FormatDebugRow(kFirstKey + i, 0, false), rows[i]);
+  }
+
+  // Once the memrowset has rows, the rowsets must be merged with it.
+  ASSERT_OK(this->InsertTestRow(&writer, kFirstKey + kRowsPerBatch * kNumBatches, 0));
+  RowIteratorOptions merge_opts;
+  merge_opts.projection = &this->client_schema_;
+  merge_opts.order = ORDERED;
+  ASSERT_OK(this->tablet()->NewRowIterator(std::move(merge_opts), &iter));
+  ASSERT_OK(iter->Init(nullptr));
+  ASSERT_STR_CONTAINS(iter->ToString(), "Merge(");
+}
+
 template<class SETUP>
 bool TestSetupExpectsNulls(int32_t /*key_idx*/) {
   return false;
@@ -1494,6 +1608,61 @@ TEST_F(TestTabletStringKey, TestSplitKeyRangeWithMinimumValueRowSet) {
   }
 }
 
+// Test that large sorted batches of insertions which don't overlap any rowset
+// are written straight into new rowsets, and that other batches aren't.
+TEST_F(TestTabletStringKey, TestBulkInsertSortedRows) {
+  FLAGS_tablet_bulk_insert_min_rows = 100;
+  LocalTabletWriter writer(tablet().get(), &client_schema_);
+  // Keys of the same length, so that they sort like their indexes.
+  const auto WriteRows = [&](int first, int count) {
+    vector<unique_ptr<KuduPartialRow>> rows;
+    vector<LocalTabletWriter::Op> ops;
+    for (int i = first; i < first + count; i++) {
+      rows.emplace_back(new KuduPartialRow(&client_schema_));
+      setup_.BuildRow(rows.back().get(), i);
+      ops.emplace_back(RowOperationsPB::INSERT, rows.back().get());
+    }
+    return writer.WriteBatch(ops);
+  };
+
+  ASSERT_OK(WriteRows(1000, 500));
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_TRUE(tablet()->MemRowSetEmpty());
+  ASSERT_EQ(500, TabletCount());
+
+  // Batches overlapping a rowset go through the MemRowSet, which finds the
+  // duplicate keys. The other rows of the batch are inserted.
+  Status s = WriteRows(1400, 200);
+  ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_FALSE(tablet()->MemRowSetEmpty());
+  ASSERT_EQ(600, TabletCount());
+
+  // So do batches which are too small...
+  ASSERT_OK(WriteRows(2000, 99));
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_EQ(699, TabletCount());
+
+  // ... or which overlap rows of the MemRowSet.
+  s = WriteRows(2098, 100);
+  ASSERT_TRUE(s.IsAlreadyPresent()) << s.ToString();
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_EQ(798, TabletCount());
+
+  // Batches which don't overlap the MemRowSet's rows bypass it even if it
+  // isn't empty.
+  ASSERT_OK(WriteRows(3000, 100));
+  ASSERT_EQ(2, tablet()->num_rowsets());
+  ASSERT_EQ(898, TabletCount());
+
+  // The new rowsets are compacted like flushed ones.
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_EQ(898, TabletCount());
+  NO_FATALS(CheckLiveRowsCount(898));
+}
+
 TYPED_TEST(TestTablet, TestDiffScanUnobservableOperations) {
   LocalTabletWriter writer(this->tablet().get(), &this->client_schema());
   vector<LocalTabletWriter::Op> ops;
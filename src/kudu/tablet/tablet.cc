@@ -18,8 +18,10 @@
 #include "kudu/tablet/tablet.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -28,6 +30,7 @@
 #include <utility>
 #include <vector>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -42,6 +45,7 @@
 #include "kudu/common/row.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/row_operations.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/rowid.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
@@ -49,6 +53,7 @@
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/opid.pb.h"
+#include "kudu/fs/data_dirs.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/fs/io_context.h"
 #include "kudu/gutil/casts.h"
@@ -61,6 +66,9 @@
 #include "kudu/tablet/delta_tracker.h"
 #include "kudu/tablet/diskrowset.h"
 #include "kudu/tablet/memrowset.h"
+#include "kudu/tablet/mutation.h"
+#include "kudu/tablet/pinned_bloom_filter.h"
+#include "kudu/tablet/row_cache.h"
 #include "kudu/tablet/row_op.h"
 #include "kudu/tablet/rowset_info.h"
 #include "kudu/tablet/rowset_metadata.h"
@@ -74,18 +82,23 @@
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/bloom_filter.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/maintenance_manager.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/process_memory.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status_callback.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/throttler.h"
 #include "kudu/util/trace.h"
 #include "kudu/util/url-coding.h"
@@ -94,6 +107,23 @@ DEFINE_int32(tablet_compaction_budget_mb, 128,
              "Budget for a single compaction");
 TAG_FLAG(tablet_compaction_budget_mb, experimental);
 
+DEFINE_string(tablet_compaction_policy, "budgeted",
+              "The policy picking the rowsets of a tablet to compact. 'budgeted' "
+              "minimizes the overlap of the rowsets, within the compaction budget. "
+              "'tiered' merges runs of small rowsets of similar size, adjacent in key "
+              "order, within a write amplification budget, which suits tables whose "
+              "rows are mostly appended in key order.");
+TAG_FLAG(tablet_compaction_policy, experimental);
+DEFINE_validator(tablet_compaction_policy, [](const char* flag_name, const std::string& value) {
+  if (boost::iequals(value, "budgeted") || boost::iequals(value, "tiered")) {
+    return true;
+  }
+  LOG(ERROR) << strings::Substitute("unknown value for --$0 flag: '$1' "
+                                    "(expected one of 'budgeted' or 'tiered')",
+                                    flag_name, value);
+  return false;
+});
+
 DEFINE_int32(tablet_bloom_block_size, 4096,
              "Block size of the bloom filters used for tablet keys.");
 TAG_FLAG(tablet_bloom_block_size, advanced);
@@ -114,6 +144,14 @@ DEFINE_double(fault_crash_before_flush_tablet_meta_after_flush_mrs, 0.0,
               "Fraction of the time, while flushing an MRS, to crash before flushing metadata");
 TAG_FLAG(fault_crash_before_flush_tablet_meta_after_flush_mrs, unsafe);
 
+DEFINE_int32(tablet_bulk_insert_min_rows, 0,
+             "Minimum number of rows of a write made only of insertions sorted by "
+             "primary key, whose keys don't overlap any on-disk rowset, for the rows "
+             "to be written straight into a new DiskRowSet instead of the MemRowSet. "
+             "This skips the presence checks of the rows and their later flush. "
+             "0 disables this.");
+TAG_FLAG(tablet_bulk_insert_min_rows, experimental);
+
 DEFINE_int64(tablet_throttler_rpc_per_sec, 0,
              "Maximum write RPC rate (op/s) allowed for a tablet, write RPC exceeding this "
              "limit will be throttled. 0 means no limit.");
@@ -138,6 +176,29 @@ DEFINE_int32(tablet_history_max_age_sec, 60 * 60 * 24 * 7,
 TAG_FLAG(tablet_history_max_age_sec, advanced);
 TAG_FLAG(tablet_history_max_age_sec, stable);
 
+DEFINE_int32(tablet_cold_after_inactive_sec, 0,
+             "Number of seconds after which a tablet that hasn't been read or "
+             "written is considered cold, and its rowsets are rewritten into "
+             "the directories in --fs_cold_data_dirs. Since tablets don't "
+             "record when they were last accessed across restarts, tablets "
+             "count as accessed when the server starts. 0 disables this.");
+TAG_FLAG(tablet_cold_after_inactive_sec, experimental);
+TAG_FLAG(tablet_cold_after_inactive_sec, runtime);
+
+DEFINE_int32(tablet_apply_parallel_min_ops, 0,
+             "Minimum number of row operations a write must have for them to "
+             "be applied by several threads of the apply pool at once, split "
+             "into chunks of rows with disjoint keys. 0 disables this.");
+TAG_FLAG(tablet_apply_parallel_min_ops, experimental);
+TAG_FLAG(tablet_apply_parallel_min_ops, runtime);
+
+DEFINE_int32(tablet_apply_parallel_num_chunks, 4,
+             "Number of chunks the row operations of a write are split into "
+             "when they're applied in parallel. See "
+             "--tablet_apply_parallel_min_ops.");
+TAG_FLAG(tablet_apply_parallel_num_chunks, experimental);
+TAG_FLAG(tablet_apply_parallel_num_chunks, runtime);
+
 // Large encoded keys cause problems because we store the min/max encoded key in the
 // CFile footer for the composite key column. The footer has a max length of 64K, so
 // the default here comfortably fits two of them with room for other metadata.
@@ -149,6 +210,8 @@ DEFINE_int32(max_encoded_key_size_bytes, 16 * 1024,
              "result in an error.");
 TAG_FLAG(max_encoded_key_size_bytes, unsafe);
 
+DECLARE_int64(flush_threshold_dms_scanned_deltas);
+
 METRIC_DEFINE_entity(tablet);
 METRIC_DEFINE_gauge_size(tablet, memrowset_size, "MemRowSet Memory Usage",
                          kudu::MetricUnit::kBytes,
@@ -162,6 +225,12 @@ METRIC_DEFINE_gauge_size(tablet, num_rowsets_on_disk, "Tablet Number of Rowsets
                          kudu::MetricUnit::kUnits,
                          "Number of diskrowsets in this tablet",
                          kudu::MetricLevel::kInfo);
+METRIC_DEFINE_gauge_size(tablet, rowset_reader_memory_per_rowset,
+                         "Reader Memory Usage per Rowset",
+                         kudu::MetricUnit::kBytes,
+                         "Average memory used by the cfile and bloom file readers of each "
+                         "diskrowset of this tablet",
+                         kudu::MetricLevel::kDebug);
 METRIC_DEFINE_gauge_uint64(tablet, last_read_elapsed_time, "Seconds Since Last Read",
                            kudu::MetricUnit::kSeconds,
                            "The elapsed time, in seconds, since the last read operation on this "
@@ -197,9 +266,47 @@ struct IteratorStats;
 namespace tablet {
 
 static CompactionPolicy *CreateCompactionPolicy() {
+  if (boost::iequals(FLAGS_tablet_compaction_policy, "tiered")) {
+    return new TieredCompactionPolicy(FLAGS_tablet_compaction_budget_mb);
+  }
   return new BudgetedCompactionPolicy(FLAGS_tablet_compaction_budget_mb);
 }
 
+static bool HasDeleteRangeOps(const vector<DecodedRowOperation>& ops) {
+  return std::any_of(ops.begin(), ops.end(), [](const DecodedRowOperation& op) {
+    return op.type == RowOperationsPB::DELETE_RANGE;
+  });
+}
+
+static bool HasDeleteRangeOps(const vector<RowOp*>& ops) {
+  return std::any_of(ops.begin(), ops.end(), [](const RowOp* op) {
+    return op->decoded_op.type == RowOperationsPB::DELETE_RANGE;
+  });
+}
+
+// Sorts 'iters' by their lower bounds. Returns true if every iterator has
+// bounds and no two of them overlap, in which case reading the iterators one
+// after the other yields their rows in key order.
+static bool SortByBoundsIfDisjoint(vector<IterWithBounds>* iters) {
+  for (const auto& i : *iters) {
+    if (!i.encoded_bounds) {
+      return false;
+    }
+  }
+  std::sort(iters->begin(), iters->end(),
+            [](const IterWithBounds& a, const IterWithBounds& b) {
+              return Slice(a.encoded_bounds->first).compare(b.encoded_bounds->first) < 0;
+            });
+  for (size_t i = 1; i < iters->size(); i++) {
+    // Both bounds are inclusive.
+    if (Slice((*iters)[i - 1].encoded_bounds->second).compare(
+            (*iters)[i].encoded_bounds->first) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 ////////////////////////////////////////////////////////////
 // TabletComponents
 ////////////////////////////////////////////////////////////
@@ -223,11 +330,17 @@ Tablet::Tablet(scoped_refptr<TabletMetadata> metadata,
     mem_trackers_(tablet_id(), std::move(parent_mem_tracker)),
     next_mrs_id_(0),
     clock_(clock),
+    compaction_stats_generation_(0),
+    compaction_stats_cached_generation_(-1),
+    compaction_stats_cached_quality_(0),
+    compaction_stats_cached_io_bytes_(0),
     rowsets_flush_sem_(1),
     state_(kInitialized),
     last_write_time_(MonoTime::Now()),
-    last_read_time_(MonoTime::Now()) {
+    last_read_time_(MonoTime::Now()),
+    in_cold_dirs_(false) {
       CHECK(schema()->has_column_ids());
+  row_cache_ = TabletRowCache::Create(tablet_id(), clock_->Now());
   compaction_policy_.reset(CreateCompactionPolicy());
 
   if (metric_registry) {
@@ -247,6 +360,9 @@ Tablet::Tablet(scoped_refptr<TabletMetadata> metadata,
     METRIC_num_rowsets_on_disk.InstantiateFunctionGauge(
         metric_entity_, [this]() { return this->num_rowsets(); })
         ->AutoDetach(&metric_detacher_);
+    METRIC_rowset_reader_memory_per_rowset.InstantiateFunctionGauge(
+        metric_entity_, [this]() { return this->RowSetReaderMemoryPerRowSet(); })
+        ->AutoDetach(&metric_detacher_);
     METRIC_last_read_elapsed_time.InstantiateFunctionGauge(
         metric_entity_, [this]() { return this->LastReadElapsedSeconds(); },
         MergeType::kMin)
@@ -449,15 +565,34 @@ Status Tablet::DecodeWriteOperations(const Schema* client_schema,
 
   // The Schema needs to be held constant while any transactions are between
   // PREPARE and APPLY stages
-  TRACE("Decoding operations");
   vector<DecodedRowOperation> ops;
 
-  // Decode the ops
-  RowOperationsPBDecoder dec(&tx_state->request()->row_operations(),
-                             client_schema,
-                             schema(),
-                             tx_state->arena());
-  RETURN_NOT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops));
+  // Decode the ops, unless they were already decoded against the same schema.
+  if (tx_state->TakePredecodedOps(schema(), &ops)) {
+    TRACE("Using predecoded operations");
+  } else {
+    TRACE("Decoding operations");
+    RowOperationsPBDecoder dec(&tx_state->request()->row_operations(),
+                               client_schema,
+                               schema(),
+                               tx_state->arena());
+    RETURN_NOT_OK(dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops));
+  }
+
+  // Range deletes delete the rows present when they're applied. For that to
+  // be the same on all replicas, they must be serialized with all other
+  // writes: take the schema lock exclusively instead, and decode again in
+  // case the schema changed in between.
+  if (HasDeleteRangeOps(ops)) {
+    tx_state->ReleaseSchemaLock();
+    tx_state->AcquireSchemaLockExclusive(&schema_lock_);
+    ops.clear();
+    RowOperationsPBDecoder exclusive_dec(&tx_state->request()->row_operations(),
+                                         client_schema,
+                                         schema(),
+                                         tx_state->arena());
+    RETURN_NOT_OK(exclusive_dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops));
+  }
   TRACE_COUNTER_INCREMENT("num_ops", ops.size());
 
   // Important to set the schema before the ops -- we need the
@@ -468,13 +603,53 @@ Status Tablet::DecodeWriteOperations(const Schema* client_schema,
   return Status::OK();
 }
 
+void Tablet::PredecodeWriteOperations(const Schema* client_schema,
+                                      WriteTransactionState* tx_state) {
+  TRACE_EVENT0("tablet", "Tablet::PredecodeWriteOperations");
+  // The schema lock isn't taken: DecodeWriteOperations() only uses the
+  // operations if the schema is still the same once the lock is held. Old
+  // schemas are kept alive by the metadata, so 'tablet_schema' stays valid.
+  const Schema* tablet_schema = schema();
+  vector<DecodedRowOperation> ops;
+  RowOperationsPBDecoder dec(&tx_state->request()->row_operations(),
+                             client_schema,
+                             tablet_schema,
+                             tx_state->arena());
+  if (dec.DecodeOperations<DecoderMode::WRITE_OPS>(&ops).ok()) {
+    tx_state->SetPredecodedOps(tablet_schema, std::move(ops));
+  }
+}
+
 Status Tablet::AcquireRowLocks(WriteTransactionState* tx_state) {
   TRACE_EVENT1("tablet", "Tablet::AcquireRowLocks",
                "num_locks", tx_state->row_ops().size());
   TRACE("Acquiring locks for $0 operations", tx_state->row_ops().size());
+  vector<RowOp*> ops_to_lock;
+  vector<Slice> keys;
+  ops_to_lock.reserve(tx_state->row_ops().size());
+  keys.reserve(tx_state->row_ops().size());
   for (RowOp* op : tx_state->row_ops()) {
     if (op->has_result()) continue;
-    RETURN_NOT_OK(AcquireLockForOp(tx_state, op));
+    RETURN_NOT_OK(PrepareKeyForOp(op));
+    if (op->has_result()) continue;
+    if (op->decoded_op.type == RowOperationsPB::DELETE_RANGE) {
+      if (row_cache_) {
+        op->row_cache_write = row_cache_->BeginWriteAll();
+      }
+      continue;
+    }
+    ops_to_lock.push_back(op);
+    keys.push_back(op->key_probe->encoded_key_slice());
+  }
+
+  // Locking all the rows at once is cheaper than locking them one by one.
+  vector<ScopedRowLock> locks;
+  lock_manager_.AcquireBatch(tx_state, LockManager::LOCK_EXCLUSIVE, keys, &locks);
+  for (size_t i = 0; i < ops_to_lock.size(); i++) {
+    ops_to_lock[i]->row_lock = std::move(locks[i]);
+    if (row_cache_) {
+      ops_to_lock[i]->row_cache_write = row_cache_->BeginWrite(keys[i]);
+    }
   }
   TRACE("Locks acquired");
   return Status::OK();
@@ -496,18 +671,44 @@ Status Tablet::CheckRowInTablet(const ConstContiguousRow& row) const {
   return Status::OK();
 }
 
-Status Tablet::AcquireLockForOp(WriteTransactionState* tx_state, RowOp* op) {
+Status Tablet::PrepareKeyForOp(RowOp* op) {
   ConstContiguousRow row_key(&key_schema_, op->decoded_op.row_data);
   op->key_probe.reset(new tablet::RowSetKeyProbe(row_key));
+  const bool is_delete_range = op->decoded_op.type == RowOperationsPB::DELETE_RANGE;
+  if (is_delete_range) {
+    ConstContiguousRow upper_bound_key(&key_schema_, op->decoded_op.range_upper_bound_row_data);
+    op->range_upper_bound_probe.reset(new tablet::RowSetKeyProbe(upper_bound_key));
+  }
   if (PREDICT_FALSE(!ValidateOpOrMarkFailed(op))) {
     return Status::OK();
   }
-  RETURN_NOT_OK(CheckRowInTablet(row_key));
+  // A range may extend beyond the partition: only the rows within it are
+  // deleted.
+  if (is_delete_range) {
+    return Status::OK();
+  }
+  return CheckRowInTablet(row_key);
+}
+
+Status Tablet::AcquireLockForOp(WriteTransactionState* tx_state, RowOp* op) {
+  RETURN_NOT_OK(PrepareKeyForOp(op));
+  if (op->has_result()) {
+    return Status::OK();
+  }
+  if (op->decoded_op.type == RowOperationsPB::DELETE_RANGE) {
+    if (row_cache_) {
+      op->row_cache_write = row_cache_->BeginWriteAll();
+    }
+    return Status::OK();
+  }
 
   op->row_lock = ScopedRowLock(&lock_manager_,
                                tx_state,
                                op->key_probe->encoded_key_slice(),
                                LockManager::LOCK_EXCLUSIVE);
+  if (row_cache_) {
+    op->row_cache_write = row_cache_->BeginWrite(op->key_probe->encoded_key_slice());
+  }
   return Status::OK();
 }
 
@@ -565,6 +766,9 @@ Status Tablet::ValidateOp(const RowOp& op) {
     case RowOperationsPB::DELETE:
       return ValidateMutateUnlocked(op);
 
+    case RowOperationsPB::DELETE_RANGE:
+      return ValidateDeleteRangeUnlocked(op);
+
     default:
       LOG(FATAL) << RowOperationsPB::Type_Name(op.decoded_op.type);
   }
@@ -602,6 +806,14 @@ Status Tablet::ValidateMutateUnlocked(const RowOp& op) {
   return Status::OK();
 }
 
+Status Tablet::ValidateDeleteRangeUnlocked(const RowOp& op) {
+  if (PREDICT_FALSE(op.key_probe->encoded_key_slice().compare(
+          op.range_upper_bound_probe->encoded_key_slice()) >= 0)) {
+    return Status::InvalidArgument("DELETE_RANGE lower bound must be less than its upper bound");
+  }
+  return Status::OK();
+}
+
 Status Tablet::InsertOrUpsertUnlocked(const IOContext* io_context,
                                       WriteTransactionState *tx_state,
                                       RowOp* op,
@@ -791,6 +1003,30 @@ Status Tablet::MutateRowUnlocked(const IOContext* io_context,
   return s;
 }
 
+Status Tablet::DeleteRangeUnlocked(const IOContext* io_context,
+                                   WriteTransactionState* tx_state,
+                                   RowOp* op) {
+  DCHECK(op->valid);
+  DCHECK(delete_range_lock_.is_write_locked());
+
+  unique_ptr<OperationResultPB> result(new OperationResultPB());
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+  const Slice lower_bound_key = op->key_probe->encoded_key_slice();
+  const Slice upper_bound_key = op->range_upper_bound_probe->encoded_key_slice();
+  vector<RowSet*> rowsets;
+  comps->rowsets->FindRowSetsIntersectingInterval(lower_bound_key, upper_bound_key, &rowsets);
+  for (RowSet* rowset : rowsets) {
+    Status s = rowset->DeleteRange(tx_state->timestamp(), lower_bound_key, upper_bound_key,
+                                   tx_state->op_id(), io_context, result.get());
+    if (PREDICT_FALSE(!s.ok())) {
+      op->SetFailed(s);
+      return s;
+    }
+  }
+  op->SetMutateSucceeded(std::move(result));
+  return Status::OK();
+}
+
 void Tablet::StartApplying(WriteTransactionState* tx_state) {
   shared_lock<rw_spinlock> l(component_lock_);
   tx_state->StartApplying();
@@ -862,6 +1098,9 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteTransactionSt
   // 'pending_group' and then calls 'ProcessPendingGroup' when the next group
   // begins.
   vector<pair<RowSet*, int>> pending_group;
+  vector<RowOp*> group_ops;
+  vector<const RowSetKeyProbe*> group_probes;
+  vector<ProbeStats*> group_stats;
   Status s;
   const auto& ProcessPendingGroup = [&]() {
     if (pending_group.empty() || !s.ok()) return;
@@ -875,6 +1114,9 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteTransactionSt
                             return s_a.compare(s_b) < 0;
                           }));
     RowSet* rs = pending_group[0].first;
+    group_ops.clear();
+    group_probes.clear();
+    group_stats.clear();
     for (auto it = pending_group.begin();
          it != pending_group.end();
          ++it) {
@@ -885,20 +1127,30 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteTransactionSt
         // Already found this op present somewhere.
         continue;
       }
+      group_ops.push_back(op);
+      group_probes.push_back(op->key_probe.get());
+      group_stats.push_back(tx_state->mutable_op_stats(op_idx));
+    }
+    pending_group.clear();
+    if (group_ops.empty()) {
+      return;
+    }
 
-      bool present = false;
-      s = rs->CheckRowPresent(*op->key_probe, io_context,
-                              &present, tx_state->mutable_op_stats(op_idx));
-      if (PREDICT_FALSE(!s.ok())) {
-        LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for op $1: $2",
-            tablet_id(), op->ToString(key_schema_), s.ToString());
-        return;
-      }
-      if (present) {
-        op->present_in_rowset = rs;
+    // Check the keys of the whole group at once, which lets the rowset share
+    // the work of probing its bloom filter and key index between them.
+    unique_ptr<bool[]> present(new bool[group_ops.size()]);
+    s = rs->CheckRowsPresent(group_probes.data(), group_probes.size(), io_context,
+                             present.get(), group_stats.data());
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG(WARNING) << Substitute("Tablet $0 failed to check row presence for $1 ops: $2",
+          tablet_id(), group_ops.size(), s.ToString());
+      return;
+    }
+    for (int i = 0; i < group_ops.size(); i++) {
+      if (present[i]) {
+        group_ops[i]->present_in_rowset = rs;
       }
     }
-    pending_group.clear();
   };
 
   const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
@@ -923,6 +1175,151 @@ Status Tablet::BulkCheckPresence(const IOContext* io_context, WriteTransactionSt
   return Status::OK();
 }
 
+Status Tablet::MaybeBulkInsertSortedRows(const IOContext* io_context,
+                                         WriteTransactionState* tx_state,
+                                         bool* bulk_inserted) {
+  *bulk_inserted = false;
+  const vector<RowOp*>& row_ops = tx_state->row_ops();
+  const int num_ops = row_ops.size();
+  if (FLAGS_tablet_bulk_insert_min_rows <= 0 ||
+      num_ops < FLAGS_tablet_bulk_insert_min_rows) {
+    return Status::OK();
+  }
+
+  // Only batches of plain insertions with strictly increasing keys qualify.
+  // Ops replayed from the log with their original result are applied to the
+  // stores the result refers to.
+  for (int i = 0; i < num_ops; i++) {
+    const RowOp* op = row_ops[i];
+    if (op->decoded_op.type != RowOperationsPB::INSERT ||
+        op->has_result() ||
+        op->orig_result_from_log) {
+      return Status::OK();
+    }
+    if (i > 0 && row_ops[i - 1]->key_probe->encoded_key_slice().compare(
+            op->key_probe->encoded_key_slice()) >= 0) {
+      return Status::OK();
+    }
+  }
+  for (RowOp* op : row_ops) {
+    if (!ValidateOpOrMarkFailed(op)) {
+      return Status::OK();
+    }
+  }
+  {
+    std::lock_guard<simple_spinlock> l(state_lock_);
+    RETURN_NOT_OK_PREPEND(CheckHasNotBeenStoppedUnlocked(),
+        Substitute("Apply of $0 exited early", tx_state->ToString()));
+  }
+
+  // The keys must not fall within the bounds of any on-disk rowset. The
+  // MemRowSet has no bounds, so the keys are looked up in it instead, which
+  // is cheap.
+  const TabletComponents* comps = DCHECK_NOTNULL(tx_state->tablet_components());
+  const Slice first_key = row_ops.front()->key_probe->encoded_key_slice();
+  faststring upper_bound;
+  upper_bound.assign_copy(row_ops.back()->key_probe->encoded_key_slice().data(),
+                          row_ops.back()->key_probe->encoded_key_slice().size());
+  upper_bound.push_back('\0');
+  vector<RowSet*> overlapping;
+  comps->rowsets->FindRowSetsIntersectingInterval(first_key, Slice(upper_bound),
+                                                  &overlapping);
+  for (RowSet* rs : overlapping) {
+    if (rs != comps->memrowset.get()) {
+      return Status::OK();
+    }
+  }
+  if (!comps->memrowset->empty()) {
+    for (int i = 0; i < num_ops; i++) {
+      bool present;
+      RETURN_NOT_OK(comps->memrowset->CheckRowPresent(*row_ops[i]->key_probe, io_context,
+                                                      &present,
+                                                      tx_state->mutable_op_stats(i)));
+      if (present) {
+        return Status::OK();
+      }
+    }
+  }
+
+  // Write the rows into a single DiskRowSet. Like the rows flushed from a
+  // MemRowSet, each row has an UNDO deleting it as of the insertion, so that
+  // it isn't visible to snapshots which don't include this transaction.
+  RollingDiskRowSetWriter drsw(metadata_.get(), *schema(), DefaultBloomSizing(),
+                               std::numeric_limits<size_t>::max());
+  drsw.set_secondary_index_column_ids(GetSecondaryIndexColumnIds());
+  drsw.set_rollup_group_by_columns(GetRollupGroupByColumns());
+  Arena arena(256);
+  faststring undo_buf;
+  RowChangeListEncoder undo_encoder(&undo_buf);
+  undo_encoder.SetToDelete();
+  Mutation* undo = Mutation::CreateInArena(&arena, tx_state->timestamp(),
+                                           undo_encoder.as_changelist());
+  const auto& WriteRows = [&]() -> Status {
+    RETURN_NOT_OK(drsw.Open());
+    static constexpr int kBlockRows = 1000;
+    RowBlock block(schema(), std::min(num_ops, kBlockRows), nullptr);
+    int n = 0;
+    for (int i = 0; i < num_ops; i++) {
+      RowBlockRow dst_row = block.row(n);
+      ConstContiguousRow row(schema(), row_ops[i]->decoded_op.row_data);
+      RETURN_NOT_OK(CopyRow(row, &dst_row, static_cast<Arena*>(nullptr)));
+      rowid_t row_idx_in_drs;
+      RETURN_NOT_OK(drsw.AppendUndoDeltas(n, undo, &row_idx_in_drs));
+      if (++n == block.nrows() || i == num_ops - 1) {
+        block.Resize(n);
+        RETURN_NOT_OK(drsw.AppendBlock(block, n));
+        block.Resize(block.row_capacity());
+        n = 0;
+      }
+    }
+    return drsw.Finish();
+  };
+  Status s = WriteRows();
+  RowSetMetadataVector new_drs_metas;
+  shared_ptr<DiskRowSet> new_rowset;
+  if (s.ok()) {
+    drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+    CHECK_EQ(1, new_drs_metas.size());
+    s = DiskRowSet::Open(new_drs_metas[0], log_anchor_registry_.get(), mem_trackers_,
+                         io_context, &new_rowset);
+  }
+  if (s.ok()) {
+    vector<unique_ptr<PinnedBloomFilter>> pinned_blooms;
+    drsw.ReleasePinnedBloomFilters(&pinned_blooms);
+    if (pinned_blooms[0]) {
+      new_rowset->PinBloomFilter(std::move(pinned_blooms[0]));
+    }
+  }
+  if (!s.ok()) {
+    // Nothing refers to the new rowset yet: fall back to applying the rows
+    // one by one.
+    LOG_WITH_PREFIX(WARNING) << "Unable to bulk insert " << num_ops << " rows: "
+                             << s.ToString();
+    return Status::OK();
+  }
+
+  // Make the new rowset durable before the transaction commits, and only then
+  // visible. The row locks held by the transaction prevent the keys from being
+  // inserted concurrently into another rowset.
+  RETURN_NOT_OK_PREPEND(FlushMetadata({}, new_drs_metas, TabletMetadata::kNoMrsFlushed),
+                        "Failed to flush new tablet metadata");
+  AtomicSwapRowSets({}, { new_rowset });
+  UpdateAverageRowsetHeight();
+
+  for (RowOp* op : row_ops) {
+    op->checked_present = true;
+    op->SetBulkInsertSucceeded(new_drs_metas[0]->id());
+  }
+  compaction_policy_->RecordFlush(drsw.written_size());
+  if (metrics_) {
+    metrics_->bytes_flushed->IncrementBy(drsw.written_size());
+  }
+  VLOG_WITH_PREFIX(1) << Substitute("Bulk inserted $0 rows into rowset $1",
+                                    num_ops, new_drs_metas[0]->id());
+  *bulk_inserted = true;
+  return Status::OK();
+}
+
 bool Tablet::HasBeenStopped() const {
   std::lock_guard<simple_spinlock> l(state_lock_);
   return state_ == kStopped || state_ == kShutdown;
@@ -936,27 +1333,66 @@ Status Tablet::CheckHasNotBeenStoppedUnlocked() const {
   return Status::OK();
 }
 
-Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
+Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state,
+                                  ThreadPool* apply_pool) {
   int num_ops = tx_state->row_ops().size();
 
+  // Range deletes are taken into account by any flush or compaction which
+  // swaps in its DuplicatingRowSet after they're applied. They must not be
+  // applied while one is copying missed deltas into its outputs. That must
+  // happen before the transaction starts applying, since flushes and
+  // compactions wait for applying transactions after their swap.
+  const bool has_delete_range_ops = HasDeleteRangeOps(tx_state->row_ops());
+  std::unique_lock<rw_semaphore> delete_range_lock;
+  if (PREDICT_FALSE(has_delete_range_ops)) {
+    delete_range_lock = std::unique_lock<rw_semaphore>(delete_range_lock_);
+  }
+
   StartApplying(tx_state);
 
   IOContext io_context({ tablet_id() });
-  RETURN_NOT_OK(BulkCheckPresence(&io_context, tx_state));
+  TransactionMetrics* tx_metrics = tx_state->mutable_metrics();
+  bool bulk_inserted = false;
+  if (PREDICT_TRUE(!has_delete_range_ops)) {
+    ScopedAddTransactionStageTime insert_time(&tx_metrics->apply_insert_nanos);
+    RETURN_NOT_OK(MaybeBulkInsertSortedRows(&io_context, tx_state, &bulk_inserted));
+  }
+  if (!bulk_inserted) {
+    // The presence of the rows the ops following a range delete apply to
+    // can't be checked up front: they're checked one at a time instead.
+    if (PREDICT_TRUE(!has_delete_range_ops)) {
+      ScopedAddTransactionStageTime presence_check_time(
+          &tx_metrics->apply_presence_check_nanos);
+      RETURN_NOT_OK(BulkCheckPresence(&io_context, tx_state));
+    }
 
-  // Actually apply the ops.
-  for (int op_idx = 0; op_idx < num_ops; op_idx++) {
-    RowOp* row_op = tx_state->row_ops()[op_idx];
-    if (row_op->has_result()) continue;
-    RETURN_NOT_OK(ApplyRowOperation(&io_context, tx_state, row_op,
-                                    tx_state->mutable_op_stats(op_idx)));
-    DCHECK(row_op->has_result());
+    // Actually apply the ops. Range deletes apply to rows whose keys can't
+    // be hashed into a chunk, so the writes containing them are applied
+    // serially.
+    const int min_parallel_ops = FLAGS_tablet_apply_parallel_min_ops;
+    if (apply_pool && PREDICT_TRUE(!has_delete_range_ops) &&
+        min_parallel_ops > 0 && num_ops >= min_parallel_ops &&
+        FLAGS_tablet_apply_parallel_num_chunks > 1) {
+      RETURN_NOT_OK(ApplyRowOperationsInParallel(&io_context, tx_state, apply_pool));
+    } else {
+      for (int op_idx = 0; op_idx < num_ops; op_idx++) {
+        RowOp* row_op = tx_state->row_ops()[op_idx];
+        if (row_op->has_result()) continue;
+        RETURN_NOT_OK(ApplyRowOperation(&io_context, tx_state, row_op,
+                                        tx_state->mutable_op_stats(op_idx)));
+        DCHECK(row_op->has_result());
+      }
+    }
   }
 
   {
     std::lock_guard<rw_spinlock> l(last_rw_time_lock_);
     last_write_time_ = MonoTime::Now();
   }
+  // Data written from now on is fresh, so it belongs in the fast directories.
+  if (PREDICT_FALSE(in_cold_dirs_)) {
+    LeaveColdDirs();
+  }
 
   if (metrics_ && num_ops > 0) {
     metrics_->AddProbeStats(tx_state->mutable_op_stats(0), num_ops, tx_state->arena());
@@ -964,10 +1400,104 @@ Status Tablet::ApplyRowOperations(WriteTransactionState* tx_state) {
   return Status::OK();
 }
 
+Status Tablet::ApplyRowOperationsInParallel(const IOContext* io_context,
+                                            WriteTransactionState* tx_state,
+                                            ThreadPool* apply_pool) {
+  // The state is shared with the tasks submitted to 'apply_pool', some of
+  // which may only run once this has returned: those find no chunk left to
+  // claim, and never touch 'tx_state'.
+  struct ParallelApply {
+    explicit ParallelApply(int num_chunks)
+        : chunks(num_chunks),
+          chunk_metrics(num_chunks),
+          chunk_status(num_chunks),
+          next_chunk(0),
+          failed(false),
+          chunks_left(num_chunks) {
+    }
+    vector<vector<int>> chunks;
+    vector<TransactionMetrics> chunk_metrics;
+    vector<Status> chunk_status;
+    std::function<void(int)> apply_chunk;
+    std::atomic<int> next_chunk;
+    std::atomic<bool> failed;
+    CountDownLatch chunks_left;
+  };
+  const int num_chunks = FLAGS_tablet_apply_parallel_num_chunks;
+  auto state = std::make_shared<ParallelApply>(num_chunks);
+
+  // The ops on a same row must be applied in order: hashing them by key puts
+  // them in the same chunk.
+  const vector<RowOp*>& row_ops = tx_state->row_ops();
+  for (int op_idx = 0; op_idx < row_ops.size(); op_idx++) {
+    const RowOp* row_op = row_ops[op_idx];
+    if (row_op->has_result()) continue;
+    const Slice key = row_op->key_probe->encoded_key_slice();
+    uint64_t hash = HashUtil::FastHash64(key.data(), key.size(), 0);
+    state->chunks[hash % num_chunks].push_back(op_idx);
+  }
+
+  ParallelApply* s = state.get();
+  s->apply_chunk = [this, s, io_context, tx_state](int chunk_idx) {
+    for (int op_idx : s->chunks[chunk_idx]) {
+      if (PREDICT_FALSE(s->failed.load(std::memory_order_relaxed))) {
+        return;
+      }
+      RowOp* row_op = tx_state->row_ops()[op_idx];
+      Status st = ApplyRowOperation(io_context, tx_state, row_op,
+                                    tx_state->mutable_op_stats(op_idx),
+                                    &s->chunk_metrics[chunk_idx]);
+      if (PREDICT_FALSE(!st.ok())) {
+        s->chunk_status[chunk_idx] = std::move(st);
+        s->failed = true;
+        return;
+      }
+      DCHECK(row_op->has_result());
+    }
+  };
+  // Each thread keeps claiming chunks until none is left, so the calling
+  // thread only ever waits for the chunks other threads are applying, even if
+  // the pool is too busy to run the tasks submitted to it.
+  auto apply_chunks = [state]() {
+    int chunk_idx;
+    while ((chunk_idx = state->next_chunk++) < static_cast<int>(state->chunks.size())) {
+      state->apply_chunk(chunk_idx);
+      state->chunks_left.CountDown();
+    }
+  };
+  for (int i = 1; i < num_chunks; i++) {
+    if (!apply_pool->Submit(apply_chunks).ok()) {
+      break;
+    }
+  }
+  apply_chunks();
+  state->chunks_left.Wait();
+
+  TransactionMetrics* tx_metrics = tx_state->mutable_metrics();
+  for (const auto& m : state->chunk_metrics) {
+    tx_metrics->apply_insert_nanos += m.apply_insert_nanos;
+    tx_metrics->apply_mutate_nanos += m.apply_mutate_nanos;
+    tx_metrics->apply_presence_check_nanos += m.apply_presence_check_nanos;
+  }
+  for (const auto& st : state->chunk_status) {
+    RETURN_NOT_OK(st);
+  }
+  return Status::OK();
+}
+
 Status Tablet::ApplyRowOperation(const IOContext* io_context,
                                  WriteTransactionState* tx_state,
                                  RowOp* row_op,
                                  ProbeStats* stats) {
+  return ApplyRowOperation(io_context, tx_state, row_op, stats,
+                           tx_state->mutable_metrics());
+}
+
+Status Tablet::ApplyRowOperation(const IOContext* io_context,
+                                 WriteTransactionState* tx_state,
+                                 RowOp* row_op,
+                                 ProbeStats* stats,
+                                 TransactionMetrics* tx_metrics) {
   if (!ValidateOpOrMarkFailed(row_op)) {
     return Status::OK();
   }
@@ -978,6 +1508,10 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
         Substitute("Apply of $0 exited early", tx_state->ToString()));
     CHECK(state_ == kOpen || state_ == kBootstrapping);
   }
+  if (row_op->decoded_op.type == RowOperationsPB::DELETE_RANGE) {
+    ScopedAddTransactionStageTime mutate_time(&tx_metrics->apply_mutate_nanos);
+    return DeleteRangeUnlocked(io_context, tx_state, row_op);
+  }
   DCHECK(row_op->has_row_lock()) << "RowOp must hold the row lock.";
   DCHECK(tx_state != nullptr) << "must have a WriteTransactionState";
   DCHECK(tx_state->op_id().IsInitialized()) << "TransactionState OpId needed for anchoring";
@@ -986,6 +1520,7 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
   // If we were unable to check rowset presence in batch (e.g. because we are processing
   // a batch which contains some duplicate keys) we need to do so now.
   if (PREDICT_FALSE(!row_op->checked_present)) {
+    ScopedAddTransactionStageTime presence_check_time(&tx_metrics->apply_presence_check_nanos);
     vector<RowSet *> to_check = FindRowSetsToCheck(row_op, tx_state->tablet_components());
     for (RowSet *rowset : to_check) {
       bool present = false;
@@ -1001,11 +1536,13 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
   }
 
   Status s;
+  const MonoTime start = MonoTime::Now();
   switch (row_op->decoded_op.type) {
     case RowOperationsPB::INSERT:
     case RowOperationsPB::INSERT_IGNORE:
     case RowOperationsPB::UPSERT:
       s = InsertOrUpsertUnlocked(io_context, tx_state, row_op, stats);
+      tx_metrics->apply_insert_nanos += (MonoTime::Now() - start).ToNanoseconds();
       if (s.IsAlreadyPresent()) {
         return Status::OK();
       }
@@ -1014,6 +1551,7 @@ Status Tablet::ApplyRowOperation(const IOContext* io_context,
     case RowOperationsPB::UPDATE:
     case RowOperationsPB::DELETE:
       s = MutateRowUnlocked(io_context, tx_state, row_op, stats);
+      tx_metrics->apply_mutate_nanos += (MonoTime::Now() - start).ToNanoseconds();
       if (s.IsNotFound()) {
         return Status::OK();
       }
@@ -1076,6 +1614,7 @@ void Tablet::AtomicSwapRowSetsUnlocked(const RowSetVector &to_remove,
                    to_remove, to_add, new_tree.get());
 
   components_ = new TabletComponents(components_->memrowset, new_tree);
+  InvalidateCompactionStats();
 }
 
 Status Tablet::DoMajorDeltaCompaction(const vector<ColumnId>& col_ids,
@@ -1084,6 +1623,7 @@ Status Tablet::DoMajorDeltaCompaction(const vector<ColumnId>& col_ids,
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   Status s = down_cast<DiskRowSet*>(input_rs.get())
       ->MajorCompactDeltaStoresWithColumnIds(col_ids, io_context, GetHistoryGcOpts());
+  InvalidateCompactionStats();
   return s;
 }
 
@@ -1117,9 +1657,58 @@ bool Tablet::GetTabletAncientHistoryMark(Timestamp* ancient_history_mark) const
 HistoryGcOpts Tablet::GetHistoryGcOpts() const {
   Timestamp ancient_history_mark;
   if (GetTabletAncientHistoryMark(&ancient_history_mark)) {
-    return HistoryGcOpts::Enabled(ancient_history_mark);
+    return HistoryGcOpts::Enabled(ancient_history_mark).WithRowExpiry(GetRowExpiry());
+  }
+  return HistoryGcOpts::Disabled().WithRowExpiry(GetRowExpiry());
+}
+
+RowExpiry Tablet::GetRowExpiry() const {
+  const auto& extra_config = metadata_->extra_config();
+  if (!extra_config || !extra_config->has_ttl_column() || !extra_config->has_ttl_sec() ||
+      extra_config->ttl_sec() <= 0) {
+    return RowExpiry::Disabled();
+  }
+  // The age of a row can only be compared to its TTL with a physical clock.
+  if (!clock_->HasPhysicalComponent()) {
+    return RowExpiry::Disabled();
   }
-  return HistoryGcOpts::Disabled();
+  const Schema* s = schema();
+  int col_idx = s->find_column(extra_config->ttl_column());
+  if (col_idx == Schema::kColumnNotFound || !s->is_key_column(col_idx) ||
+      s->column(col_idx).type_info()->type() != UNIXTIME_MICROS) {
+    KLOG_EVERY_N_SECS(WARNING, 60) << LogPrefix() << "Ignoring TTL of the table: column '"
+                                   << extra_config->ttl_column()
+                                   << "' is not a UNIXTIME_MICROS key column";
+    return RowExpiry::Disabled();
+  }
+  int64_t now_micros = HybridClock::GetPhysicalValueMicros(clock_->Now());
+  int64_t ttl_micros = extra_config->ttl_sec() * 1000000LL;
+  return RowExpiry(col_idx, s->column_id(col_idx), now_micros - ttl_micros);
+}
+
+vector<ColumnId> Tablet::GetSecondaryIndexColumnIds() const {
+  vector<ColumnId> col_ids;
+  const auto& extra_config = metadata_->extra_config();
+  if (!extra_config) {
+    return col_ids;
+  }
+  const Schema* s = schema();
+  for (const string& name : extra_config->secondary_index_columns()) {
+    int col_idx = s->find_column(name);
+    if (col_idx == Schema::kColumnNotFound || s->is_key_column(col_idx)) {
+      continue;
+    }
+    col_ids.push_back(s->column_id(col_idx));
+  }
+  return col_ids;
+}
+
+int Tablet::GetRollupGroupByColumns() const {
+  const auto& extra_config = metadata_->extra_config();
+  if (!extra_config || !extra_config->has_rollup_group_by_columns()) {
+    return -1;
+  }
+  return extra_config->rollup_group_by_columns();
 }
 
 Status Tablet::Flush() {
@@ -1416,6 +2005,8 @@ Status Tablet::PickRowSetsToCompact(RowSetsInCompaction *picked,
     // Push the lock on our scoped list, so we unlock when done.
     picked->AddRowSet(rs, std::move(lock));
   }
+  // The picked rowsets aren't available to other compactions anymore.
+  InvalidateCompactionStats();
 
   // When we iterated through the current rowsets, we should have found all of
   // the rowsets that we picked. If we didn't, that implies that some other
@@ -1476,6 +2067,10 @@ void Tablet::RegisterMaintenanceOps(MaintenanceManager* maint_mgr) {
   maint_mgr->RegisterOp(undo_delta_block_gc_op.get());
   maintenance_ops.push_back(undo_delta_block_gc_op.release());
 
+  unique_ptr<MaintenanceOp> cold_data_migration_op(new ColdDataMigrationOp(this));
+  maint_mgr->RegisterOp(cold_data_migration_op.get());
+  maintenance_ops.push_back(cold_data_migration_op.release());
+
   // The deleted rowset GC operation relies on live rowset counting. If this
   // tablet doesn't support such counting, do not register the op.
   if (metadata_->supports_live_row_count()) {
@@ -1539,7 +2134,7 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
                "tablet_id", tablet_id(),
                "op", op_name);
 
-  const IOContext io_context({ tablet_id() });
+  const IOContext io_context({ tablet_id(), /*is_background=*/true });
 
   MvccSnapshot flush_snap(mvcc_);
   VLOG_WITH_PREFIX(1) << Substitute("$0: entering phase 1 (flushing snapshot). "
@@ -1556,6 +2151,8 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
 
   RollingDiskRowSetWriter drsw(metadata_.get(), merge->schema(), DefaultBloomSizing(),
                                compaction_policy_->target_rowset_size());
+  drsw.set_secondary_index_column_ids(GetSecondaryIndexColumnIds());
+  drsw.set_rollup_group_by_columns(GetRollupGroupByColumns());
   RETURN_NOT_OK_PREPEND(drsw.Open(), "Failed to open DiskRowSet for flush");
 
   HistoryGcOpts history_gc_opts = GetHistoryGcOpts();
@@ -1582,12 +2179,21 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
   vector<shared_ptr<RowSet> > new_disk_rowsets;
   RowSetMetadataVector new_drs_metas;
   drsw.GetWrittenRowSetMetadata(&new_drs_metas);
+  vector<unique_ptr<PinnedBloomFilter>> pinned_blooms;
+  drsw.ReleasePinnedBloomFilters(&pinned_blooms);
+  DCHECK_EQ(new_drs_metas.size(), pinned_blooms.size());
 
+  if (mrs_being_flushed == TabletMetadata::kNoMrsFlushed) {
+    compaction_policy_->RecordCompaction(drsw.written_size());
+  } else {
+    compaction_policy_->RecordFlush(drsw.written_size());
+  }
   if (metrics_.get()) metrics_->bytes_flushed->IncrementBy(drsw.written_size());
   CHECK(!new_drs_metas.empty());
   {
     TRACE_EVENT0("tablet", "Opening compaction results");
-    for (const shared_ptr<RowSetMetadata>& meta : new_drs_metas) {
+    for (int i = 0; i < new_drs_metas.size(); i++) {
+      const shared_ptr<RowSetMetadata>& meta = new_drs_metas[i];
       // TODO(awong): it'd be nice to plumb delta stats from the rowset writer
       // into the new deltafile readers opened here.
       shared_ptr<DiskRowSet> new_rowset;
@@ -1601,6 +2207,9 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
                                  << meta->ToString() << ": " << s.ToString();
         return s;
       }
+      if (pinned_blooms[i]) {
+        new_rowset->PinBloomFilter(std::move(pinned_blooms[i]));
+      }
       new_disk_rowsets.push_back(new_rowset);
     }
   }
@@ -1635,7 +2244,12 @@ Status Tablet::DoMergeCompactionOrFlush(const RowSetsInCompaction &input,
                                     "duplicate updates in new rowsets)",
                                     op_name);
   shared_ptr<DuplicatingRowSet> inprogress_rowset(
-    new DuplicatingRowSet(input.rowsets(), new_disk_rowsets));
+    new DuplicatingRowSet(input.rowsets(), new_disk_rowsets,
+                          history_gc_opts.row_expiry()));
+
+  // Range deletes applied from now on are mirrored into the output rowsets,
+  // which requires the deltas they missed to have been copied over first.
+  shared_lock<rw_semaphore> delete_range_lock(delete_range_lock_);
 
   // The next step is to swap in the DuplicatingRowSet, and at the same time, determine an
   // MVCC snapshot which includes all of the transactions that saw a pre-DuplicatingRowSet
@@ -1793,6 +2407,9 @@ void Tablet::UpdateAverageRowsetHeight() {
 Status Tablet::Compact(CompactFlags flags) {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
 
+  // Whatever the outcome, the input rowsets are available for compaction
+  // again once 'input' goes out of scope.
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   RowSetsInCompaction input;
   // Step 1. Capture the rowsets to be merged
   RETURN_NOT_OK_PREPEND(PickRowSetsToCompact(&input, flags),
@@ -1827,24 +2444,47 @@ void Tablet::UpdateCompactionStats(MaintenanceOpStats* stats) {
   // been in the last 5 minutes, and somehow scale the compaction quality
   // based on that, so we favor hot tablets.
   double quality = 0;
-  unordered_set<const RowSet*> picked_set_ignored;
-
-  shared_ptr<RowSetTree> rowsets_copy;
-  {
-    shared_lock<rw_spinlock> l(component_lock_);
-    rowsets_copy = components_->rowsets;
-  }
+  int64_t io_bytes = 0;
+  unordered_set<const RowSet*> picked_set;
 
   {
     std::lock_guard<std::mutex> compact_lock(compact_select_lock_);
-    WARN_NOT_OK(compaction_policy_->PickRowSets(*rowsets_copy, &picked_set_ignored, &quality, NULL),
-                Substitute("Couldn't determine compaction quality for $0", tablet_id()));
+    // The selection only depends on the rowsets, their sizes and their
+    // availability for compaction: unless one of them changed since the last
+    // call, reuse the quality computed then rather than running the policy
+    // over all the rowsets on every poll of the maintenance manager. The
+    // generation is read before the rowsets, so that a concurrent change
+    // invalidates the quality computed here.
+    const int64_t generation = compaction_stats_generation_;
+    if (generation == compaction_stats_cached_generation_) {
+      quality = compaction_stats_cached_quality_;
+      io_bytes = compaction_stats_cached_io_bytes_;
+    } else {
+      shared_ptr<RowSetTree> rowsets_copy;
+      {
+        shared_lock<rw_spinlock> l(component_lock_);
+        rowsets_copy = components_->rowsets;
+      }
+      Status s = compaction_policy_->PickRowSets(*rowsets_copy, &picked_set,
+                                                 &quality, NULL);
+      WARN_NOT_OK(s, Substitute("Couldn't determine compaction quality for $0", tablet_id()));
+      if (s.ok()) {
+        // The compaction reads the picked rowsets and writes about as much.
+        for (const auto* rs : picked_set) {
+          io_bytes += 2 * rs->OnDiskSize();
+        }
+        compaction_stats_cached_generation_ = generation;
+        compaction_stats_cached_quality_ = quality;
+        compaction_stats_cached_io_bytes_ = io_bytes;
+      }
+    }
   }
 
   VLOG_WITH_PREFIX(1) << "Best compaction for " << tablet_id() << ": " << quality;
 
   stats->set_runnable(quality >= 0);
   stats->set_perf_improvement(quality);
+  stats->set_io_bytes(io_bytes);
 }
 
 
@@ -1879,11 +2519,21 @@ Status Tablet::CaptureConsistentIterators(
 
 
   // Grab the memrowset iterator.
+  //
+  // An ordered scan leaves out an empty memrowset: since the memrowset has no
+  // bounds, its iterator would keep the scan from concatenating the rowsets
+  // when they don't overlap. Rows inserted after this point are outside the
+  // scan's snapshot, so the memrowset can't yield any rows to the scan anyway.
+  // There must be at least one iterator though, so it's then added at the end
+  // if no rowset is scanned.
   unique_ptr<RowwiseIterator> ms_iter;
   RETURN_NOT_OK(components_->memrowset->NewRowIterator(opts, &ms_iter));
   IterWithBounds mrs_iwb;
   mrs_iwb.iter = std::move(ms_iter);
-  ret.emplace_back(std::move(mrs_iwb));
+  const bool skip_mrs = opts.order == ORDERED && components_->memrowset->empty();
+  if (!skip_mrs) {
+    ret.emplace_back(std::move(mrs_iwb));
+  }
 
 
   // Cull row-sets in the case of key-range queries.
@@ -1893,7 +2543,34 @@ Status Tablet::CaptureConsistentIterators(
     boost::optional<Slice> upper_bound = spec->exclusive_upper_bound_key() ? \
         boost::optional<Slice>(spec->exclusive_upper_bound_key()->encoded_key()) : boost::none;
     vector<RowSet*> interval_sets;
-    components_->rowsets->FindRowSetsIntersectingInterval(lower_bound, upper_bound, &interval_sets);
+    if (spec->key_ranges().size() > 1) {
+      // Leave out the rowsets that fall in the gaps between the key ranges.
+      unordered_set<RowSet*> seen;
+      for (const auto& range : spec->key_ranges()) {
+        boost::optional<Slice> range_lower = lower_bound;
+        if (!range.first.empty() && (!lower_bound || lower_bound->compare(range.first) < 0)) {
+          range_lower = Slice(range.first);
+        }
+        boost::optional<Slice> range_upper = upper_bound;
+        if (!range.second.empty() && (!upper_bound || upper_bound->compare(range.second) > 0)) {
+          range_upper = Slice(range.second);
+        }
+        if (range_lower && range_upper && range_lower->compare(*range_upper) >= 0) {
+          continue;
+        }
+        vector<RowSet*> range_sets;
+        components_->rowsets->FindRowSetsIntersectingInterval(range_lower, range_upper,
+                                                              &range_sets);
+        for (auto* rs : range_sets) {
+          if (seen.insert(rs).second) {
+            interval_sets.push_back(rs);
+          }
+        }
+      }
+    } else {
+      components_->rowsets->FindRowSetsIntersectingInterval(lower_bound, upper_bound,
+                                                            &interval_sets);
+    }
     for (const auto* rs : interval_sets) {
       IterWithBounds iwb;
       RETURN_NOT_OK_PREPEND(rs->NewRowIteratorWithBounds(opts, &iwb),
@@ -1901,6 +2578,9 @@ Status Tablet::CaptureConsistentIterators(
                                        rs->ToString()));
       ret.emplace_back(std::move(iwb));
     }
+    if (ret.empty()) {
+      ret.emplace_back(std::move(mrs_iwb));
+    }
     *iters = std::move(ret);
     return Status::OK();
   }
@@ -1914,6 +2594,9 @@ Status Tablet::CaptureConsistentIterators(
                                      rs->ToString()));
     ret.emplace_back(std::move(iwb));
   }
+  if (ret.empty()) {
+    ret.emplace_back(std::move(mrs_iwb));
+  }
 
   // Swap results into the parameters.
   *iters = std::move(ret);
@@ -2027,6 +2710,34 @@ uint64_t Tablet::LastWriteElapsedSeconds() const {
   return static_cast<uint64_t>((MonoTime::Now() - last_write_time_).ToSeconds());
 }
 
+bool Tablet::IsCold() const {
+  const int32_t cold_after_sec = FLAGS_tablet_cold_after_inactive_sec;
+  if (cold_after_sec <= 0) {
+    return false;
+  }
+  shared_lock<rw_spinlock> l(last_rw_time_lock_);
+  const MonoTime now = MonoTime::Now();
+  const MonoDelta cold_after = MonoDelta::FromSeconds(cold_after_sec);
+  return now - last_read_time_ >= cold_after && now - last_write_time_ >= cold_after;
+}
+
+Status Tablet::MoveToColdDirs() {
+  in_cold_dirs_ = true;
+  metadata_->fs_manager()->dd_manager()->SetTabletCold(tablet_id(), true);
+  LOG_WITH_PREFIX(INFO) << "Moving data of cold tablet to cold data directories";
+  Status s = Compact(FORCE_COMPACT_ALL);
+  if (PREDICT_FALSE(!s.ok())) {
+    LeaveColdDirs();
+  }
+  return s;
+}
+
+void Tablet::LeaveColdDirs() {
+  if (in_cold_dirs_.exchange(false)) {
+    metadata_->fs_manager()->dd_manager()->SetTabletCold(tablet_id(), false);
+  }
+}
+
 size_t Tablet::DeltaMemStoresSize() const {
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
@@ -2053,16 +2764,19 @@ bool Tablet::DeltaMemRowSetEmpty() const {
 }
 
 void Tablet::GetInfoForBestDMSToFlush(const ReplaySizeMap& replay_size_map,
-                                      int64_t* mem_size, int64_t* replay_size) const {
+                                      int64_t* mem_size, int64_t* replay_size,
+                                      int64_t* deltas_scanned) const {
   shared_ptr<RowSet> rowset = FindBestDMSToFlush(replay_size_map);
 
   if (rowset) {
     *replay_size = GetReplaySizeForIndex(rowset->MinUnflushedLogIndex(),
                                          replay_size_map);
     *mem_size = rowset->DeltaMemStoreSize();
+    *deltas_scanned = rowset->DeltaMemStoreDeltasScanned();
   } else {
     *replay_size = 0;
     *mem_size = 0;
+    *deltas_scanned = 0;
   }
 }
 
@@ -2070,7 +2784,8 @@ Status Tablet::FlushBestDMS(const ReplaySizeMap &replay_size_map) const {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
   shared_ptr<RowSet> rowset = FindBestDMSToFlush(replay_size_map);
   if (rowset) {
-    IOContext io_context({ tablet_id() });
+    SCOPED_CLEANUP({ InvalidateCompactionStats(); });
+    IOContext io_context({ tablet_id(), /*is_background=*/true });
     return rowset->FlushDeltas(&io_context);
   }
   return Status::OK();
@@ -2095,7 +2810,15 @@ shared_ptr<RowSet> Tablet::FindBestDMSToFlush(const ReplaySizeMap& replay_size_m
     int64_t size = GetReplaySizeForIndex(rowset->MinUnflushedLogIndex(),
                                          replay_size_map);
     int64_t mem = rowset->DeltaMemStoreSize();
-    double score = mem * mem_weight + size * (100 - mem_weight);
+    // Account for the cost of the DMS to scans like for its retention: every
+    // multiple of --flush_threshold_dms_scanned_deltas counts as much as 1MB
+    // of WAL to replay.
+    double scan_cost = 0;
+    if (FLAGS_flush_threshold_dms_scanned_deltas > 0) {
+      scan_cost = static_cast<double>(rowset->DeltaMemStoreDeltasScanned()) * 1024 * 1024 /
+                  FLAGS_flush_threshold_dms_scanned_deltas;
+    }
+    double score = mem * mem_weight + (size + scan_cost) * (100 - mem_weight);
 
     if ((score > max_score) ||
         (score > max_score - 1 && mem > mem_size)) {
@@ -2136,11 +2859,16 @@ Status Tablet::FlushBiggestDMS() {
       biggest_drs = rowset;
     }
   }
-  return max_size > 0 ? biggest_drs->FlushDeltas(nullptr) : Status::OK();
+  if (max_size <= 0) {
+    return Status::OK();
+  }
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
+  return biggest_drs->FlushDeltas(nullptr);
 }
 
 Status Tablet::FlushAllDMSForTests() {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
   for (const auto& rowset : comps->rowsets->all_rowsets()) {
@@ -2152,6 +2880,7 @@ Status Tablet::FlushAllDMSForTests() {
 Status Tablet::MajorCompactAllDeltaStoresForTests() {
   LOG_WITH_PREFIX(INFO) << "Major compacting all delta stores, for tests";
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   scoped_refptr<TabletComponents> comps;
   GetComponents(&comps);
   IOContext io_context({ tablet_id() });
@@ -2165,8 +2894,36 @@ Status Tablet::MajorCompactAllDeltaStoresForTests() {
   return Status::OK();
 }
 
+Status Tablet::EvictIdleRowSetReaders(int64_t* num_evicted) {
+  RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  *num_evicted = 0;
+  scoped_refptr<TabletComponents> comps;
+  GetComponents(&comps);
+  IOContext io_context({ tablet_id(), /*is_background=*/true });
+  for (const auto& rs : comps->rowsets->all_rowsets()) {
+    // Hold the rowset's compact_flush_lock so that the base data isn't
+    // replaced by a major delta compaction at the same time.
+    std::unique_lock<std::mutex> lock;
+    {
+      std::lock_guard<std::mutex> compact_lock(compact_select_lock_);
+      if (!rs->IsAvailableForCompaction()) continue;
+      lock = std::unique_lock<std::mutex>(*rs->compact_flush_lock(), std::try_to_lock);
+      CHECK(lock.owns_lock());
+    }
+    bool evicted;
+    RETURN_NOT_OK_PREPEND(
+        down_cast<DiskRowSet*>(rs.get())->EvictReadersIfIdle(&io_context, &evicted),
+        "Failed to release the readers of " + rs->ToString());
+    if (evicted) {
+      (*num_evicted)++;
+    }
+  }
+  return Status::OK();
+}
+
 Status Tablet::CompactWorstDeltas(RowSet::DeltaCompactionType type) {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   shared_ptr<RowSet> rs;
 
   // We're required to grab the rowset's compact_flush_lock under the compact_select_lock_.
@@ -2188,7 +2945,7 @@ Status Tablet::CompactWorstDeltas(RowSet::DeltaCompactionType type) {
   // We just released compact_select_lock_ so other compactions can select and run, but the
   // rowset is ours.
   DCHECK(perf_improv != 0);
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), /*is_background=*/true });
   if (type == RowSet::MINOR_DELTA_COMPACTION) {
     RETURN_NOT_OK_PREPEND(rs->MinorCompactDeltaStores(&io_context),
                           "Failed minor delta compaction on " + rs->ToString());
@@ -2259,7 +3016,7 @@ Status Tablet::EstimateBytesInPotentiallyAncientUndoDeltas(int64_t* bytes) {
 Status Tablet::InitAncientUndoDeltas(MonoDelta time_budget, int64_t* bytes_in_ancient_undos) {
   MonoTime tablet_init_start = MonoTime::Now();
 
-  IOContext io_context({ tablet_id() });
+  IOContext io_context({ tablet_id(), /*is_background=*/true });
   Timestamp ancient_history_mark;
   if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
     VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
@@ -2320,7 +3077,9 @@ Status Tablet::InitAncientUndoDeltas(MonoDelta time_budget, int64_t* bytes_in_an
 
 Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted_rowsets) {
   Timestamp ancient_history_mark;
-  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
+  bool has_ahm = Tablet::GetTabletAncientHistoryMark(&ancient_history_mark);
+  RowExpiry row_expiry = GetRowExpiry();
+  if (!has_ahm && !row_expiry.enabled()) {
     VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
                            "The clock is likely not a hybrid clock";
     *bytes_in_ancient_deleted_rowsets = 0;
@@ -2337,8 +3096,15 @@ Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted
         continue;
       }
       bool deleted_and_ancient = false;
-      RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deleted_and_ancient));
-      if (deleted_and_ancient) {
+      if (has_ahm) {
+        RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark,
+                                                       &deleted_and_ancient));
+      }
+      bool expired = false;
+      if (!deleted_and_ancient && row_expiry.enabled()) {
+        RETURN_NOT_OK(rowset->IsFullyExpired(row_expiry, &expired));
+      }
+      if (deleted_and_ancient || expired) {
         bytes += rowset->OnDiskSize();
       }
     }
@@ -2350,9 +3116,12 @@ Status Tablet::GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted
 
 Status Tablet::DeleteAncientDeletedRowsets() {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   const MonoTime start_time = MonoTime::Now();
   Timestamp ancient_history_mark;
-  if (!Tablet::GetTabletAncientHistoryMark(&ancient_history_mark)) {
+  bool has_ahm = Tablet::GetTabletAncientHistoryMark(&ancient_history_mark);
+  RowExpiry row_expiry = GetRowExpiry();
+  if (!has_ahm && !row_expiry.enabled()) {
     VLOG_WITH_PREFIX(1) << "Cannot get ancient history mark. "
                            "The clock is likely not a hybrid clock";
     return Status::OK();
@@ -2367,6 +3136,7 @@ Status Tablet::DeleteAncientDeletedRowsets() {
   int num_unavailable_for_delete = 0;
   vector<std::unique_lock<std::mutex>> rowset_locks;
   int64_t bytes_deleted = 0;
+  int64_t num_expired = 0;
   {
     std::lock_guard<std::mutex> csl(compact_select_lock_);
     for (const auto& rowset : comps->rowsets->all_rowsets()) {
@@ -2377,8 +3147,17 @@ Status Tablet::DeleteAncientDeletedRowsets() {
         continue;
       }
       bool deleted_and_empty = false;
-      RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deleted_and_empty));
-      if (deleted_and_empty) {
+      if (has_ahm) {
+        RETURN_NOT_OK(rowset->IsDeletedAndFullyAncient(ancient_history_mark, &deleted_and_empty));
+      }
+      // Rowsets whose rows have all expired are deleted regardless of their
+      // history, as a metadata-only operation.
+      bool expired = false;
+      if (!deleted_and_empty && row_expiry.enabled()) {
+        RETURN_NOT_OK(rowset->IsFullyExpired(row_expiry, &expired));
+        if (expired) num_expired++;
+      }
+      if (deleted_and_empty || expired) {
         // If we intend on deleting the rowset, take its lock so concurrent
         // compactions don't try to select it for compactions.
         std::unique_lock<std::mutex> l(*rowset->compact_flush_lock(), std::try_to_lock);
@@ -2395,12 +3174,14 @@ Status Tablet::DeleteAncientDeletedRowsets() {
   RETURN_NOT_OK(HandleEmptyCompactionOrFlush(
       to_delete, TabletMetadata::kNoMrsFlushed));
   metrics_->deleted_rowset_gc_bytes_deleted->IncrementBy(bytes_deleted);
+  metrics_->expired_rowsets_deleted->IncrementBy(num_expired);
   metrics_->deleted_rowset_gc_duration->Increment((MonoTime::Now() - start_time).ToMilliseconds());
   return Status::OK();
 }
 
 Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_deleted) {
   RETURN_IF_STOPPED_OR_CHECK_STATE(kOpen);
+  SCOPED_CLEANUP({ InvalidateCompactionStats(); });
   MonoTime tablet_delete_start = MonoTime::Now();
 
   Timestamp ancient_history_mark;
@@ -2429,7 +3210,7 @@ Status Tablet::DeleteAncientUndoDeltas(int64_t* blocks_deleted, int64_t* bytes_d
 
   int64_t tablet_blocks_deleted = 0;
   int64_t tablet_bytes_deleted = 0;
-  fs::IOContext io_context({ tablet_id() });
+  fs::IOContext io_context({ tablet_id(), /*is_background=*/true });
   for (const auto& rowset : rowsets_to_gc_undos) {
     int64_t rowset_blocks_deleted;
     int64_t rowset_bytes_deleted;
@@ -2485,6 +3266,15 @@ size_t Tablet::num_rowsets() const {
   return components_ ? components_->rowsets->all_rowsets().size() : 0;
 }
 
+size_t Tablet::RowSetReaderMemoryPerRowSet() const {
+  size_t rowsets = num_rowsets();
+  if (rowsets == 0) {
+    return 0;
+  }
+  return (mem_trackers_.cfile_reader_tracker->consumption() +
+          mem_trackers_.bloomfile_tracker->consumption()) / rowsets;
+}
+
 void Tablet::PrintRSLayout(ostream* o) {
   DCHECK(o);
   auto& out = *o;
@@ -2607,6 +3397,65 @@ string Tablet::LogPrefix() const {
 // Tablet::Iterator
 ////////////////////////////////////////////////////////////
 
+namespace {
+
+// Yields the row of a scan served from the row cache, if it exists.
+class CachedRowIterator : public RowwiseIterator {
+ public:
+  // 'row' is the row with the schema 'tablet_schema', or nullptr if the scan
+  // found no row.
+  CachedRowIterator(const Schema* tablet_schema,
+                    const Schema* projection,
+                    unique_ptr<TabletRowCache::CachedRow> row)
+      : tablet_schema_(tablet_schema),
+        projection_(projection),
+        projector_(tablet_schema, projection),
+        row_(std::move(row)) {
+  }
+
+  Status Init(ScanSpec* /*spec*/) override {
+    return projector_.Init();
+  }
+
+  bool HasNext() const override {
+    return row_ != nullptr;
+  }
+
+  Status NextBlock(RowBlock* dst) override {
+    DCHECK(HasNext());
+    dst->Resize(1);
+    if (dst->arena()) {
+      dst->arena()->Reset();
+    }
+    dst->selection_vector()->SetAllTrue();
+    RowBlockRow dst_row = dst->row(0);
+    RETURN_NOT_OK(projector_.ProjectRowForRead(
+        ConstContiguousRow(tablet_schema_, row_->row_data()), &dst_row, dst->arena()));
+    row_.reset();
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    return "CachedRowIterator";
+  }
+
+  const Schema& schema() const override {
+    return *projection_;
+  }
+
+  void GetIteratorStats(vector<IteratorStats>* stats) const override {
+    stats->assign(projection_->num_columns(), IteratorStats());
+  }
+
+ private:
+  const Schema* tablet_schema_;
+  const Schema* projection_;
+  RowProjector projector_;
+  unique_ptr<TabletRowCache::CachedRow> row_;
+};
+
+} // anonymous namespace
+
 Tablet::Iterator::Iterator(const Tablet* tablet,
                            RowIteratorOptions opts)
     : tablet_(tablet),
@@ -2625,17 +3474,37 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
 
   RETURN_NOT_OK(tablet_->GetMappedReadProjection(projection_, &projection_));
 
+  bool served;
+  RETURN_NOT_OK(InitFromRowCache(spec, &served));
+  if (served) {
+    return Status::OK();
+  }
+
   vector<IterWithBounds> iters;
   RETURN_NOT_OK(tablet_->CaptureConsistentIterators(opts_, spec, &iters));
   TRACE_COUNTER_INCREMENT("rowset_iterators", iters.size());
 
   switch (opts_.order) {
     case ORDERED:
-      iter_ = NewMergeIterator(MergeIteratorOptions(opts_.include_deleted_rows), std::move(iters));
+      // When the rowsets' key ranges don't overlap (e.g. after they've been
+      // compacted), reading them in key order is enough to order the rows
+      // without the cost of merging them.
+      if (SortByBoundsIfDisjoint(&iters)) {
+        TRACE_COUNTER_INCREMENT("ordered_scans_concatenated", 1);
+        iter_ = NewUnionIterator(std::move(iters));
+      } else {
+        iter_ = NewMergeIterator(MergeIteratorOptions(opts_.include_deleted_rows),
+                                 std::move(iters));
+      }
       break;
     case UNORDERED:
     default:
-      iter_ = NewUnionIterator(std::move(iters));
+      if (opts_.scan_pool && opts_.max_parallelism > 1 && iters.size() > 1) {
+        iter_ = NewParallelUnionIterator(std::move(iters), opts_.scan_pool,
+                                         opts_.max_parallelism);
+      } else {
+        iter_ = NewUnionIterator(std::move(iters));
+      }
       break;
   }
 
@@ -2643,6 +3512,79 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
   return Status::OK();
 }
 
+Status Tablet::Iterator::InitFromRowCache(ScanSpec* spec, bool* served) {
+  *served = false;
+  TabletRowCache* row_cache = tablet_->row_cache_.get();
+  if (!row_cache || !spec ||
+      !spec->lower_bound_key() || !spec->exclusive_upper_bound_key() ||
+      !spec->predicates().empty() || !spec->key_ranges().empty() ||
+      opts_.snap_to_exclude || opts_.include_deleted_rows || opts_.rollup_sink ||
+      projection_.first_is_deleted_virtual_column_idx() != Schema::kColumnNotFound) {
+    return Status::OK();
+  }
+  // The schema is read between two reads of its version so that they match.
+  const uint32_t schema_version = tablet_->metadata()->schema_version();
+  const Schema* schema = tablet_->schema();
+  if (tablet_->metadata()->schema_version() != schema_version) {
+    return Status::OK();
+  }
+
+  // The scan looks up a single row if its upper bound is the successor of
+  // its lower bound.
+  const Slice key = spec->lower_bound_key()->encoded_key();
+  {
+    Arena arena(256);
+    unique_ptr<EncodedKey> successor;
+    if (!EncodedKey::DecodeEncodedString(*schema, &arena, key, &successor).ok() ||
+        !EncodedKey::IncrementEncodedKey(*schema, &successor, &arena).ok() ||
+        successor->encoded_key() != spec->exclusive_upper_bound_key()->encoded_key()) {
+      return Status::OK();
+    }
+  }
+
+  unique_ptr<TabletRowCache::CachedRow> row(new TabletRowCache::CachedRow);
+  TabletRowCache::ReadState state;
+  if (row_cache->Lookup(key, schema_version, opts_.snap_to_include, row.get(), &state)) {
+    TRACE_COUNTER_INCREMENT("row_cache_hits", 1);
+  } else {
+    TRACE_COUNTER_INCREMENT("row_cache_misses", 1);
+    // Read the whole row, so it serves any projection once cached.
+    RowIteratorOptions opts = opts_;
+    opts.projection = schema;
+    opts.order = UNORDERED;
+    opts.max_parallelism = 1;
+    vector<IterWithBounds> iters;
+    RETURN_NOT_OK(tablet_->CaptureConsistentIterators(opts, spec, &iters));
+    TRACE_COUNTER_INCREMENT("rowset_iterators", iters.size());
+    unique_ptr<RowwiseIterator> iter = NewUnionIterator(std::move(iters));
+    RETURN_NOT_OK(iter->Init(spec));
+
+    Arena arena(1024);
+    RowBlock block(schema, 100, &arena);
+    bool found = false;
+    while (!found && iter->HasNext()) {
+      RETURN_NOT_OK(iter->NextBlock(&block));
+      for (size_t i = 0; i < block.nrows(); i++) {
+        if (block.selection_vector()->IsRowSelected(i)) {
+          row_cache->Insert(key, schema_version, opts_.snap_to_include, state, *schema,
+                            block.row(i), row.get());
+          found = true;
+          break;
+        }
+      }
+    }
+    // The absence of a row isn't cached.
+    if (!found) {
+      row.reset();
+    }
+  }
+
+  iter_.reset(new CachedRowIterator(schema, &projection_, std::move(row)));
+  RETURN_NOT_OK(iter_->Init(spec));
+  *served = true;
+  return Status::OK();
+}
+
 bool Tablet::Iterator::HasNext() const {
   DCHECK(iter_.get() != nullptr) << "Not initialized!";
   return iter_->HasNext();
@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
@@ -61,6 +62,7 @@ class MaintenanceOpStats;
 class MemTracker;
 class RowBlock;
 class ScanSpec;
+class ThreadPool;
 class Throttler;
 class Timestamp;
 struct IterWithBounds;
@@ -85,7 +87,9 @@ class RowSetsInCompaction;
 class WriteTransactionState;
 struct RowOp;
 struct TabletComponents;
+class TabletRowCache;
 struct TabletMetrics;
+struct TransactionMetrics;
 
 class Tablet {
  public:
@@ -142,6 +146,13 @@ class Tablet {
   Status DecodeWriteOperations(const Schema* client_schema,
                                WriteTransactionState* tx_state);
 
+  // Decodes the Write operations of a user's request against the current
+  // schema without taking the schema lock, so that it can be done ahead of
+  // DecodeWriteOperations(), which reuses them if the schema didn't change.
+  // Nothing is stored if decoding fails.
+  void PredecodeWriteOperations(const Schema* client_schema,
+                                WriteTransactionState* tx_state);
+
   // Acquire locks for each of the operations in the given txn.
   //
   // Note that, if this fails, it's still possible that the transaction
@@ -182,7 +193,13 @@ class Tablet {
   void StartApplying(WriteTransactionState* tx_state);
 
   // Apply all of the row operations associated with this transaction.
-  Status ApplyRowOperations(WriteTransactionState* tx_state) WARN_UNUSED_RESULT;
+  //
+  // If 'apply_pool' is set, --tablet_apply_parallel_min_ops is nonzero, and
+  // the transaction has at least that many operations, they're split into
+  // chunks of disjoint keys which threads of 'apply_pool' help the calling
+  // thread apply.
+  Status ApplyRowOperations(WriteTransactionState* tx_state,
+                            ThreadPool* apply_pool = nullptr) WARN_UNUSED_RESULT;
 
   // Apply a single row operation, which must already be prepared.
   // The result is set back into row_op->result.
@@ -286,10 +303,11 @@ class Tablet {
   // Same as MemRowSetEmpty(), but for the DMS.
   bool DeltaMemRowSetEmpty() const;
 
-  // Fills in the in-memory size and replay size in bytes for the DMS with the
-  // highest retention.
+  // Fills in the in-memory size and replay size in bytes, as well as the
+  // number of deltas scans walked through, for the best DMS to flush.
   void GetInfoForBestDMSToFlush(const ReplaySizeMap& replay_size_map,
-                                int64_t* mem_size, int64_t* replay_size) const;
+                                int64_t* mem_size, int64_t* replay_size,
+                                int64_t* deltas_scanned) const;
 
   // Flushes the DMS with the highest retention.
   Status FlushBestDMS(const ReplaySizeMap &replay_size_map) const;
@@ -304,6 +322,13 @@ class Tablet {
   // redo delta stores. Only used for tests.
   Status MajorCompactAllDeltaStoresForTests();
 
+  // Releases the memory held by the cfile readers of the disk rowsets which
+  // weren't accessed since the previous call, keeping them open so that their
+  // readers are initialized again on demand. Rowsets being compacted are
+  // skipped. Sets 'num_evicted' to the number of rowsets whose readers were
+  // released.
+  Status EvictIdleRowSetReaders(int64_t* num_evicted);
+
   // Finds the RowSet which has the most separate delta files and
   // issues a delta compaction.
   Status CompactWorstDeltas(RowSet::DeltaCompactionType type);
@@ -340,7 +365,8 @@ class Tablet {
                                  int64_t* bytes_deleted = nullptr);
 
   // Returns the number of bytes potentially used by rowsets that have no live
-  // rows and are entirely ancient.
+  // rows and are entirely ancient, or whose rows have all expired according to
+  // the TTL of the table.
   //
   // These checks may not touch on-disk block data if we can determine from the
   // live row count that the rowsets aren't fully deleted, or from the DMS that
@@ -351,12 +377,29 @@ class Tablet {
   Status GetBytesInAncientDeletedRowsets(int64_t* bytes_in_ancient_deleted_rowsets);
 
   // Finds and GCs all fully deleted rowsets that have a maximum op timestamp
-  // prior to the current ancient history mark.
+  // prior to the current ancient history mark, and all rowsets whose rows
+  // have all expired.
   //
   // Returns an error if the metadata update fails. Upon failure, no in-memory
   // state is change.
   Status DeleteAncientDeletedRowsets();
 
+  // Returns whether the tablet hasn't been read or written for at least
+  // --tablet_cold_after_inactive_sec seconds.
+  bool IsCold() const;
+
+  // Whether new blocks of the tablet are placed in cold data directories
+  // (see --fs_cold_data_dirs).
+  bool in_cold_dirs() const { return in_cold_dirs_; }
+
+  // Moves the tablet's data into cold data directories by compacting all of
+  // its rowsets, placing the output there.
+  Status MoveToColdDirs();
+
+  // Places new blocks of the tablet in the directories other than the cold
+  // ones again. The blocks already in cold directories stay there.
+  void LeaveColdDirs();
+
   // Counts the number of deltas in the tablet. Only used for tests.
   int64_t CountUndoDeltasForTests() const;
   int64_t CountRedoDeltasForTests() const;
@@ -364,6 +407,10 @@ class Tablet {
   // Return the current number of rowsets in the tablet.
   size_t num_rowsets() const;
 
+  // Return the average memory, in bytes, used by the cfile and bloom file
+  // readers of each rowset of the tablet.
+  size_t RowSetReaderMemoryPerRowSet() const;
+
   // Attempt to count the total number of rows in the tablet.
   // This is not super-efficient since it must iterate over the
   // memrowset in the current implementation.
@@ -391,6 +438,10 @@ class Tablet {
   // Return the Lock Manager for this tablet
   LockManager* lock_manager() { return &lock_manager_; }
 
+  // Return the rows of this tablet in the row cache, or nullptr if the row
+  // cache is disabled.
+  TabletRowCache* row_cache() const { return row_cache_.get(); }
+
   const TabletMetadata *metadata() const { return metadata_.get(); }
   TabletMetadata *metadata() { return metadata_.get(); }
   scoped_refptr<TabletMetadata> shared_metadata() const { return metadata_; }
@@ -418,9 +469,25 @@ class Tablet {
   // Otherwise, returns false.
   bool GetTabletAncientHistoryMark(Timestamp* ancient_history_mark) const WARN_UNUSED_RESULT;
 
-  // Calculates history GC options based on properties of the Clock implementation.
+  // Calculates history GC options based on properties of the Clock
+  // implementation and on the TTL of the table.
   HistoryGcOpts GetHistoryGcOpts() const;
 
+  // Returns the expiry of rows according to the TTL of the table as of now.
+  // Disabled if the table has no TTL, if its TTL column isn't a UNIXTIME_MICROS
+  // key column, or if the clock has no physical component.
+  RowExpiry GetRowExpiry() const;
+
+  // Returns the IDs of the columns of the table which have secondary indexes
+  // in its DiskRowSets, as listed in its extra config. Columns which don't
+  // exist or are key columns are skipped.
+  std::vector<ColumnId> GetSecondaryIndexColumnIds() const;
+
+  // Returns the number of group-by columns of the rollups of the rows of the
+  // table's DiskRowSets, as set in its extra config, or -1 if the table has no
+  // rollups.
+  int GetRollupGroupByColumns() const;
+
   // Method used by tests to retrieve all rowsets of this table. This
   // will be removed once code for selecting the appropriate RowSet is
   // finished and delta files is finished is part of Tablet class.
@@ -565,6 +632,9 @@ class Tablet {
   // Validate the given update/delete operation.
   static Status ValidateMutateUnlocked(const RowOp& op);
 
+  // Validate the given range delete operation.
+  static Status ValidateDeleteRangeUnlocked(const RowOp& op);
+
   // Perform an INSERT, INSERT_IGNORE, or UPSERT operation, assuming that the transaction is
   // already in a prepared state. This state ensures that:
   // - the row lock is acquired
@@ -581,6 +651,12 @@ class Tablet {
                            RowOp* mutate,
                            ProbeStats* stats);
 
+  // Same as above, but for DELETE_RANGE, which is applied to every rowset
+  // intersecting the range and requires no row lock.
+  Status DeleteRangeUnlocked(const fs::IOContext* io_context,
+                             WriteTransactionState* tx_state,
+                             RowOp* op);
+
   // In the case of an UPSERT against a duplicate row, converts the UPSERT
   // into an internal UPDATE operation and performs it.
   Status ApplyUpsertAsUpdate(const fs::IOContext* io_context,
@@ -594,12 +670,37 @@ class Tablet {
   static std::vector<RowSet*> FindRowSetsToCheck(const RowOp* op,
                                                  const TabletComponents* comps);
 
+  // If 'tx_state' is made of at least --tablet_bulk_insert_min_rows valid
+  // insertions with strictly increasing keys, none of which may be present in
+  // the tablet, writes the rows straight into a new DiskRowSet rather than
+  // into the MemRowSet, and sets 'bulk_inserted' to true. Otherwise, leaves
+  // the operations to be applied one by one.
+  Status MaybeBulkInsertSortedRows(const fs::IOContext* io_context,
+                                   WriteTransactionState* tx_state,
+                                   bool* bulk_inserted) WARN_UNUSED_RESULT;
+
   // For each of the operations in 'tx_state', check for the presence of their
   // row keys in the RowSets in the current RowSetTree (as determined by the transaction's
   // captured TabletComponents).
   Status BulkCheckPresence(const fs::IOContext* io_context,
                            WriteTransactionState* tx_state) WARN_UNUSED_RESULT;
 
+  // Like ApplyRowOperation(), but accounts the time spent into 'tx_metrics'
+  // rather than into the metrics of 'tx_state'.
+  Status ApplyRowOperation(const fs::IOContext* io_context,
+                           WriteTransactionState* tx_state,
+                           RowOp* row_op,
+                           ProbeStats* stats,
+                           TransactionMetrics* tx_metrics) WARN_UNUSED_RESULT;
+
+  // Applies the operations of 'tx_state' which don't have a result yet,
+  // hashing them by key into chunks which are applied by the calling thread
+  // and by threads of 'apply_pool' concurrently. The operations on a same
+  // row are in a same chunk, so they're still applied in order.
+  Status ApplyRowOperationsInParallel(const fs::IOContext* io_context,
+                                      WriteTransactionState* tx_state,
+                                      ThreadPool* apply_pool) WARN_UNUSED_RESULT;
+
   // Capture a set of iterators which, together, reflect all of the data in the tablet.
   //
   // These iterators are not true snapshot iterators, but they are safe against
@@ -649,6 +750,13 @@ class Tablet {
   void AtomicSwapRowSetsUnlocked(const RowSetVector &to_remove,
                                  const RowSetVector &to_add);
 
+  // Record that the rowsets of the tablet, their sizes or their availability
+  // for compaction may have changed, so that the next call to
+  // UpdateCompactionStats() runs the compaction policy again.
+  void InvalidateCompactionStats() const {
+    compaction_stats_generation_++;
+  }
+
   void GetComponents(scoped_refptr<TabletComponents>* comps) const {
     shared_lock<rw_spinlock> l(component_lock_);
     *comps = CHECK_NOTNULL(components_.get());
@@ -678,7 +786,13 @@ class Tablet {
 
   Status CheckRowInTablet(const ConstContiguousRow& row) const;
 
-  // Helper method to find the rowset that has the DMS with the highest retention.
+  // Sets the RowSetKeyProbe of the given operation and validates it, marking
+  // it failed if it's invalid. Returns an error if the row doesn't belong to
+  // this tablet.
+  Status PrepareKeyForOp(RowOp* op);
+
+  // Helper method to find the rowset that has the DMS with the highest retention,
+  // or which is the most costly to scans.
   std::shared_ptr<RowSet> FindBestDMSToFlush(const ReplaySizeMap& replay_size_map) const;
 
   // Helper method to find how many bytes need to be replayed to restore in-memory
@@ -754,6 +868,9 @@ class Tablet {
   MvccManager mvcc_;
   LockManager lock_manager_;
 
+  // The rows of the tablet in the row cache, or nullptr if it is disabled.
+  std::unique_ptr<TabletRowCache> row_cache_;
+
   std::unique_ptr<CompactionPolicy> compaction_policy_;
 
   // Lock protecting the selection of rowsets for compaction.
@@ -761,11 +878,28 @@ class Tablet {
   // so that they don't both try to select the same rowset.
   mutable std::mutex compact_select_lock_;
 
+  // Incremented by InvalidateCompactionStats().
+  mutable std::atomic<int64_t> compaction_stats_generation_;
+
+  // The compaction quality and the IO bytes of the picked rowsets last computed
+  // by UpdateCompactionStats(), and the value of 'compaction_stats_generation_'
+  // they were computed at. Protected by 'compact_select_lock_'.
+  int64_t compaction_stats_cached_generation_;
+  double compaction_stats_cached_quality_;
+  int64_t compaction_stats_cached_io_bytes_;
+
   // We take this lock when flushing the tablet's rowsets in Tablet::Flush.  We
   // don't want to have two flushes in progress at once, in case the one which
   // started earlier completes after the one started later.
   mutable Semaphore rowsets_flush_sem_;
 
+  // Taken in shared mode by flushes and compactions once they're about to
+  // swap in their DuplicatingRowSet, until they complete. Taken in exclusive
+  // mode while applying DELETE_RANGE operations, whose range tombstones can't
+  // be mirrored into output rowsets which are missing deltas (see
+  // ReupdateMissedDeltas()).
+  mutable rw_semaphore delete_range_lock_;
+
   // Lock protecting access to 'state_' and 'maintenance_ops_'.
   // If taken with any other locks, this must be taken last, i.e. no locks can
   // be acquired while holding this this.
@@ -790,6 +924,9 @@ class Tablet {
   MonoTime last_write_time_;
   mutable MonoTime last_read_time_;
 
+  // See in_cold_dirs().
+  std::atomic<bool> in_cold_dirs_;
+
   // NOTE: it's important that this is the first member to be destructed. This
   // ensures we do not attempt to collect metrics while calling the destructor.
   FunctionGaugeDetacher metric_detacher_;
@@ -857,6 +994,11 @@ class Tablet::Iterator : public RowwiseIterator {
   Iterator(const Tablet* tablet,
            RowIteratorOptions opts);
 
+  // Serves a scan which looks up a single row by its primary key, with no
+  // other predicates, from the row cache, reading the row into the cache on a
+  // miss. Sets 'served' if it did, in which case 'iter_' is initialized.
+  Status InitFromRowCache(ScanSpec* spec, bool* served);
+
   const Tablet* tablet_;
   fs::IOContext io_context_;
   Schema projection_;
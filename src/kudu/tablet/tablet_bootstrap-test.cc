@@ -26,6 +26,7 @@
 #include <vector>
 
 #include <boost/optional/optional.hpp>
+#include <gflags/gflags_declare.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -93,6 +94,8 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+DECLARE_int64(tablet_bootstrap_read_ahead_bytes);
+
 namespace kudu {
 namespace tablet {
 
@@ -193,6 +196,29 @@ class BootstrapTest : public LogTestBase {
     return Status::OK();
   }
 
+  // Writes a few segments of entries, bootstraps the tablet, and checks that
+  // all of the entries were replayed.
+  void BootstrapMultipleSegments() {
+    const int kNumSegments = 3;
+    const int kEntriesPerSegment = 10;
+    ASSERT_OK(BuildLog());
+    for (int i = 0; i < kNumSegments; i++) {
+      ASSERT_OK(AppendReplicateBatchAndCommitEntryPairsToLog(kEntriesPerSegment));
+      ASSERT_OK(RollLog());
+    }
+
+    shared_ptr<Tablet> tablet;
+    ConsensusBootstrapInfo boot_info;
+    ASSERT_OK(BootstrapTestTablet(-1, -1, &tablet, &boot_info));
+    OpId last_opid = MakeOpId(1, current_index_ - 1);
+    ASSERT_OPID_EQ(last_opid, boot_info.last_id);
+    ASSERT_OPID_EQ(last_opid, boot_info.last_committed_id);
+
+    vector<string> results;
+    IterateTabletRows(tablet.get(), &results);
+    ASSERT_EQ(kNumSegments * kEntriesPerSegment, results.size());
+  }
+
   void IterateTabletRows(const Tablet* tablet,
                          vector<string>* results) {
     unique_ptr<RowwiseIterator> iter;
@@ -260,6 +286,19 @@ TEST_F(BootstrapTest, TestBootstrapHighOpIdIndex) {
   ASSERT_OPID_EQ(last_opid, boot_info.last_committed_id);
 }
 
+// Test replaying several segments with so little read-ahead that the reader
+// blocks after every entry.
+TEST_F(BootstrapTest, TestReadAhead) {
+  FLAGS_tablet_bootstrap_read_ahead_bytes = 1;
+  NO_FATALS(BootstrapMultipleSegments());
+}
+
+// Test replaying several segments without reading ahead.
+TEST_F(BootstrapTest, TestNoReadAhead) {
+  FLAGS_tablet_bootstrap_read_ahead_bytes = 0;
+  NO_FATALS(BootstrapMultipleSegments());
+}
+
 // Tests attempting a local bootstrap of a tablet that was in the middle of a
 // tablet copy before "crashing".
 TEST_F(BootstrapTest, TestIncompleteTabletCopy) {
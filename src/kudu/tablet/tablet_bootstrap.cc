@@ -17,6 +17,7 @@
 
 #include "kudu/tablet/tablet_bootstrap.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <iterator>
@@ -77,6 +78,7 @@
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.pb.h"
+#include "kudu/util/blocking_queue.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -89,6 +91,7 @@
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/thread.h"
 
 DECLARE_int32(group_commit_queue_size_bytes);
 
@@ -98,6 +101,12 @@ DEFINE_double(fault_crash_during_log_replay, 0.0,
               "(For testing only!)");
 TAG_FLAG(fault_crash_during_log_replay, unsafe);
 
+DEFINE_int64(tablet_bootstrap_read_ahead_bytes, 32 * 1024 * 1024,
+             "Number of bytes of WAL segments to read and decode ahead of the replay "
+             "of their entries during tablet bootstrap, on a separate thread. If 0, "
+             "the entries are read on the replaying thread as they're replayed.");
+TAG_FLAG(tablet_bootstrap_read_ahead_bytes, advanced);
+
 DECLARE_int32(max_clock_sync_error_usec);
 
 using kudu::clock::Clock;
@@ -175,6 +184,69 @@ class FlushedStoresSnapshot {
   DISALLOW_COPY_AND_ASSIGN(FlushedStoresSnapshot);
 };
 
+// Reads the entries of a sequence of log segments in order, optionally ahead
+// of the caller on a separate thread, so that reading and decoding the log
+// overlaps with replaying its entries.
+class LogEntryPrefetcher {
+ public:
+  struct Entry {
+    // The entry, if one was read successfully.
+    unique_ptr<LogEntryPB> entry;
+
+    // The result of reading the entry. EndOfFile marks the end of a segment.
+    Status status;
+
+    // The index of the segment the entry was read from.
+    size_t segment_idx;
+
+    // The offset in the segment after reading the entry, and the offset at
+    // which reading the segment stops.
+    int64_t offset;
+    int64_t read_up_to_offset;
+
+    // The number of bytes of the segment read to produce this entry.
+    int64_t size;
+  };
+
+  // 'read_ahead_bytes' limits the number of bytes of the segments read ahead
+  // of the caller. If 0, the entries are read by the caller in Next().
+  LogEntryPrefetcher(log::SegmentSequence segments, int64_t read_ahead_bytes);
+  ~LogEntryPrefetcher();
+
+  // Starts reading ahead, if enabled.
+  Status Start();
+
+  // Returns the next entry in 'entry', followed by an EndOfFile entry after
+  // the last entry of each segment. Returns false after the last segment or
+  // after an entry which failed to be read.
+  bool Next(unique_ptr<Entry>* entry);
+
+ private:
+  struct EntryLogicalSize {
+    static size_t logical_size(const Entry* entry) {
+      return entry->size;
+    }
+  };
+
+  // Reads the next entry on the calling thread.
+  bool ReadNext(unique_ptr<Entry>* entry);
+
+  // The body of the read-ahead thread.
+  void ReadAheadThread();
+
+  const log::SegmentSequence segments_;
+  const int64_t read_ahead_bytes_;
+
+  // The index of the segment being read, and its reader.
+  size_t segment_idx_;
+  unique_ptr<log::LogEntryReader> reader_;
+
+  BlockingQueue<Entry*, EntryLogicalSize> queue_;
+  scoped_refptr<Thread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogEntryPrefetcher);
+};
+
 // Bootstraps an existing tablet by opening the metadata from disk, and rebuilding soft
 // state by playing log segments. A bootstrapped tablet can then be added to an existing
 // consensus configuration as a LEARNER, which will bring its state up to date with the
@@ -1183,60 +1255,55 @@ Status TabletBootstrap::PlaySegments(const IOContext* io_context,
 
   auto last_status_update = MonoTime::Now();
   const auto kStatusUpdateInterval = MonoDelta::FromSeconds(5);
-  int segment_count = 0;
-
-  for (const scoped_refptr<ReadableLogSegment>& segment : segments) {
-    log::LogEntryReader reader(segment.get());
-
-    int entry_count = 0;
-    while (true) {
-      {
-        unique_ptr<LogEntryPB> entry;
-        Status s = reader.ReadNextEntry(&entry);
-        if (PREDICT_FALSE(!s.ok())) {
-          if (s.IsEndOfFile()) {
-            break;
-          }
-          return Status::Corruption(
-              Substitute("Error reading Log Segment of tablet $0: $1 "
-                         "(Read up to entry $2 of segment $3, in path $4)",
-                         tablet_->tablet_id(),
-                         s.ToString(),
-                         entry_count,
-                         segment->header().sequence_number(),
-                         segment->path()));
-        }
-        entry_count++;
-
-        string entry_debug_info;
-        s = HandleEntry(io_context, &state, std::move(entry), &entry_debug_info);
-        if (!s.ok()) {
-          DumpReplayStateToLog(state);
-          RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
-                                             segment->header().sequence_number(),
-                                             entry_count, segment->path(),
-                                             entry_debug_info));
-        }
-      }
 
-      const auto now = MonoTime::Now();
-      if (now - last_status_update > kStatusUpdateInterval) {
-        SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
-                                    "($2/$3 this segment, stats: $4)",
-                                    segment_count + 1, log_reader_->num_segments(),
-                                    HumanReadableNumBytes::ToString(reader.offset()),
-                                    HumanReadableNumBytes::ToString(reader.read_up_to_offset()),
-                                    stats_.ToString()));
-        last_status_update = now;
+  LogEntryPrefetcher prefetcher(segments, FLAGS_tablet_bootstrap_read_ahead_bytes);
+  RETURN_NOT_OK_PREPEND(prefetcher.Start(), "Failed to start reading log segments");
+
+  int entry_count = 0;
+  unique_ptr<LogEntryPrefetcher::Entry> read;
+  while (prefetcher.Next(&read)) {
+    const scoped_refptr<ReadableLogSegment>& segment = segments[read->segment_idx];
+    if (PREDICT_FALSE(!read->status.ok())) {
+      if (read->status.IsEndOfFile()) {
+        SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
+                                    "Stats: $2. Pending: $3 replicates",
+                                    read->segment_idx + 1, log_reader_->num_segments(),
+                                    stats_.ToString(),
+                                    state.pending_replicates.size()));
+        entry_count = 0;
+        continue;
       }
+      return Status::Corruption(
+          Substitute("Error reading Log Segment of tablet $0: $1 "
+                     "(Read up to entry $2 of segment $3, in path $4)",
+                     tablet_->tablet_id(),
+                     read->status.ToString(),
+                     entry_count,
+                     segment->header().sequence_number(),
+                     segment->path()));
+    }
+    entry_count++;
+
+    string entry_debug_info;
+    Status s = HandleEntry(io_context, &state, std::move(read->entry), &entry_debug_info);
+    if (!s.ok()) {
+      DumpReplayStateToLog(state);
+      RETURN_NOT_OK_PREPEND(s, DebugInfo(tablet_->tablet_id(),
+                                         segment->header().sequence_number(),
+                                         entry_count, segment->path(),
+                                         entry_debug_info));
     }
 
-    SetStatusMessage(Substitute("Bootstrap replayed $0/$1 log segments. "
-                                "Stats: $2. Pending: $3 replicates",
-                                segment_count + 1, log_reader_->num_segments(),
-                                stats_.ToString(),
-                                state.pending_replicates.size()));
-    segment_count++;
+    const auto now = MonoTime::Now();
+    if (now - last_status_update > kStatusUpdateInterval) {
+      SetStatusMessage(Substitute("Bootstrap replaying log segment $0/$1 "
+                                  "($2/$3 this segment, stats: $4)",
+                                  read->segment_idx + 1, log_reader_->num_segments(),
+                                  HumanReadableNumBytes::ToString(read->offset),
+                                  HumanReadableNumBytes::ToString(read->read_up_to_offset),
+                                  stats_.ToString()));
+      last_status_update = now;
+    }
   }
 
   // If we have non-applied commits they all must belong to pending operations and
@@ -1564,7 +1631,8 @@ Status TabletBootstrap::ApplyOperations(const IOContext* io_context,
         break;
       }
       case RowOperationsPB::UPDATE:
-      case RowOperationsPB::DELETE: {
+      case RowOperationsPB::DELETE:
+      case RowOperationsPB::DELETE_RANGE: {
         stats_.mutations_seen++;
         if (op->has_result()) {
           stats_.mutations_ignored++;
@@ -1688,6 +1756,78 @@ Status FlushedStoresSnapshot::InitFrom(const TabletMetadata& tablet_meta) {
   return Status::OK();
 }
 
+LogEntryPrefetcher::LogEntryPrefetcher(log::SegmentSequence segments,
+                                       int64_t read_ahead_bytes)
+    : segments_(std::move(segments)),
+      read_ahead_bytes_(read_ahead_bytes),
+      segment_idx_(0),
+      queue_(std::max<int64_t>(read_ahead_bytes, 0)) {
+}
+
+LogEntryPrefetcher::~LogEntryPrefetcher() {
+  if (thread_) {
+    // Unblock and stop the read-ahead thread, then free whatever it read that
+    // wasn't consumed.
+    queue_.Shutdown();
+    thread_->Join();
+    unique_ptr<Entry> entry;
+    while (queue_.BlockingGet(&entry).ok()) {
+    }
+  }
+}
+
+Status LogEntryPrefetcher::Start() {
+  if (read_ahead_bytes_ <= 0 || segments_.empty()) {
+    return Status::OK();
+  }
+  return Thread::Create("tablet", "bootstrap-read-ahead",
+                        [this]() { this->ReadAheadThread(); }, &thread_);
+}
+
+bool LogEntryPrefetcher::Next(unique_ptr<Entry>* entry) {
+  if (thread_) {
+    return queue_.BlockingGet(entry).ok();
+  }
+  return ReadNext(entry);
+}
+
+bool LogEntryPrefetcher::ReadNext(unique_ptr<Entry>* entry) {
+  if (segment_idx_ >= segments_.size()) {
+    return false;
+  }
+  if (!reader_) {
+    reader_.reset(new log::LogEntryReader(segments_[segment_idx_].get()));
+  }
+  unique_ptr<Entry> e(new Entry);
+  const int64_t start_offset = reader_->offset();
+  e->status = reader_->ReadNextEntry(&e->entry);
+  e->segment_idx = segment_idx_;
+  e->offset = reader_->offset();
+  e->read_up_to_offset = reader_->read_up_to_offset();
+  e->size = e->offset - start_offset;
+  if (e->status.IsEndOfFile()) {
+    reader_.reset();
+    segment_idx_++;
+  } else if (!e->status.ok()) {
+    // Nothing after a bad entry is read.
+    reader_.reset();
+    segment_idx_ = segments_.size();
+  }
+  *entry = std::move(e);
+  return true;
+}
+
+void LogEntryPrefetcher::ReadAheadThread() {
+  unique_ptr<Entry> entry;
+  while (ReadNext(&entry)) {
+    if (!queue_.BlockingPut(&entry).ok()) {
+      // The queue was shut down by the destructor.
+      return;
+    }
+  }
+  queue_.Shutdown();
+}
+
 bool FlushedStoresSnapshot::IsMemStoreActive(const MemStoreTargetPB& target) const {
   if (target.has_mrs_id()) {
     DCHECK(!target.has_rs_id());
@@ -632,13 +632,14 @@ TEST_F(TabletHistoryGcNoMaintMgrTest, TestUndoDeltaBlockGc) {
   const int expected_undo_blocks = (kNumMutationsPerRow + 1) * kNumRowsets;
   ASSERT_EQ(expected_undo_blocks, tablet()->CountUndoDeltasForTests());
 
-  // There will be uninitialized undos so we will estimate that there may be
-  // undos to GC.
+  // The ranges of the timestamps of the undos are known from the rowset
+  // metadata, even though they aren't initialized, so we know that there are
+  // no undos to GC.
   int64_t bytes;
   ASSERT_OK(tablet()->EstimateBytesInPotentiallyAncientUndoDeltas(&bytes));
-  ASSERT_GT(bytes, 0);
+  ASSERT_EQ(0, bytes);
 
-  // Now initialize the undos. Our estimates should be back to 0.
+  // Initializing the undos doesn't change our estimates.
   int64_t bytes_in_ancient_undos = 0;
   const MonoDelta kNoTimeLimit = MonoDelta();
   ASSERT_OK(tablet()->InitAncientUndoDeltas(kNoTimeLimit, &bytes_in_ancient_undos));
@@ -673,6 +674,36 @@ TEST_F(TabletHistoryGcNoMaintMgrTest, TestUndoDeltaBlockGc) {
   ASSERT_EQ(1, tablet()->metrics()->undo_delta_block_gc_delete_duration->TotalCount());
 }
 
+// Test that ancient undo delta blocks are deleted based on the ranges of their
+// timestamps in the rowset metadata, without initializing them first.
+TEST_F(TabletHistoryGcNoMaintMgrTest, TestUndoDeltaBlockGcWithoutInit) {
+  FLAGS_tablet_history_max_age_sec = 1000;
+
+  NO_FATALS(InsertOriginalRows(kNumRowsets, rows_per_rowset_));
+  NO_FATALS(AddTimeToHybridClock(MonoDelta::FromSeconds(1)));
+  NO_FATALS(UpdateOriginalRows(kNumRowsets, rows_per_rowset_, 0));
+  ASSERT_OK(tablet()->MajorCompactAllDeltaStoresForTests());
+  const int expected_undo_blocks = 2 * kNumRowsets;
+  ASSERT_EQ(expected_undo_blocks, tablet()->CountUndoDeltasForTests());
+  const uint64_t now = HybridClock::GetPhysicalValueMicros(clock()->Now());
+
+  // Reopen the tablet so that none of the delta files are initialized, and
+  // move the clock so all deltas are ancient.
+  NO_FATALS(TabletReOpen());
+  SetMockTime(now + (FLAGS_tablet_history_max_age_sec + 1) * 1000000L);
+
+  int64_t bytes;
+  ASSERT_OK(tablet()->EstimateBytesInPotentiallyAncientUndoDeltas(&bytes));
+  ASSERT_GT(bytes, 0);
+
+  int64_t blocks_deleted;
+  int64_t bytes_deleted;
+  ASSERT_OK(tablet()->DeleteAncientUndoDeltas(&blocks_deleted, &bytes_deleted));
+  ASSERT_EQ(expected_undo_blocks, blocks_deleted);
+  ASSERT_EQ(bytes, bytes_deleted);
+  ASSERT_EQ(0, tablet()->CountUndoDeltasForTests());
+}
+
 TEST_F(TabletHistoryGcNoMaintMgrTest, TestGCDeletedRowsetsWithRedoFiles) {
   FLAGS_tablet_history_max_age_sec = 1000;
   NO_FATALS(InsertOriginalRows(kNumRowsets, rows_per_rowset_));
@@ -745,5 +776,107 @@ TEST_F(TabletHistoryGcNoMaintMgrTest, TestGCDeletedRowsetsAfterMajorCompaction)
   NO_FATALS(TryRunningDeletedRowsetGC());
 }
 
+// Test of the expiry of rows according to the TTL of their table.
+class TabletTtlTest : public KuduTabletTest {
+ public:
+  TabletTtlTest()
+      : KuduTabletTest(Schema({ ColumnSchema("ts", UNIXTIME_MICROS),
+                                ColumnSchema("val", INT32) }, 1),
+                       TabletHarness::Options::HYBRID_CLOCK) {
+    FLAGS_time_source = "mock";
+    FLAGS_enable_maintenance_manager = false;
+  }
+
+  void SetUp() override {
+    NO_FATALS(KuduTabletTest::SetUp());
+    now_micros_ = GetCurrentTimeMicros();
+    auto* hybrid_clock = down_cast<HybridClock*>(clock());
+    auto* ntp = down_cast<clock::MockNtp*>(hybrid_clock->time_service());
+    ntp->SetMockClockWallTimeForTests(now_micros_);
+  }
+
+ protected:
+  // Rows expire as of this, and are dropped by the flushes and compactions
+  // that follow.
+  void EnableTtl() {
+    TableExtraConfigPB extra_config;
+    extra_config.set_ttl_column("ts");
+    extra_config.set_ttl_sec(kTtlSec);
+    tablet()->metadata()->SetExtraConfig(std::move(extra_config));
+  }
+
+  // Inserts 'count' rows whose timestamps are 'age_sec' seconds in the past.
+  void InsertRows(int64_t age_sec, int count) {
+    LocalTabletWriter writer(tablet().get(), &client_schema());
+    KuduPartialRow row(&client_schema());
+    for (int i = 0; i < count; i++) {
+      ASSERT_OK(row.SetUnixTimeMicros(0, now_micros_ - age_sec * 1000000 + i));
+      ASSERT_OK(row.SetInt32(1, i));
+      ASSERT_OK(writer.Insert(row));
+    }
+  }
+
+  void AssertRowCount(uint64_t expected) {
+    uint64_t count = 0;
+    ASSERT_OK(tablet()->CountRows(&count));
+    ASSERT_EQ(expected, count);
+  }
+
+  const int kTtlSec = 3600;
+  const int kNumRows = 100;
+  int64_t now_micros_;
+};
+
+// Test that rowsets whose rows have all expired are deleted without being
+// compacted.
+TEST_F(TabletTtlTest, TestDeleteExpiredRowsets) {
+  NO_FATALS(InsertRows(2 * kTtlSec, kNumRows));
+  ASSERT_OK(tablet()->Flush());
+  NO_FATALS(InsertRows(kTtlSec / 2, kNumRows));
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_EQ(2, tablet()->num_rowsets());
+
+  // Without a TTL, nothing is garbage-collected.
+  ASSERT_OK(tablet()->DeleteAncientDeletedRowsets());
+  ASSERT_EQ(2, tablet()->num_rowsets());
+
+  NO_FATALS(EnableTtl());
+  int64_t bytes = 0;
+  ASSERT_OK(tablet()->GetBytesInAncientDeletedRowsets(&bytes));
+  ASSERT_GT(bytes, 0);
+  ASSERT_OK(tablet()->DeleteAncientDeletedRowsets());
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  ASSERT_EQ(1, tablet()->metrics()->expired_rowsets_deleted->value());
+  NO_FATALS(AssertRowCount(kNumRows));
+
+  // Nothing else has expired.
+  ASSERT_OK(tablet()->GetBytesInAncientDeletedRowsets(&bytes));
+  ASSERT_EQ(0, bytes);
+}
+
+// Test that expired rows are dropped by flushes and by the compaction of
+// partially expired rowsets.
+TEST_F(TabletTtlTest, TestFlushAndCompactionDropExpiredRows) {
+  // The first rowset has a live row, so it isn't fully expired.
+  NO_FATALS(InsertRows(2 * kTtlSec, kNumRows));
+  NO_FATALS(InsertRows(0, 1));
+  ASSERT_OK(tablet()->Flush());
+  NO_FATALS(InsertRows(3 * kTtlSec, kNumRows));
+  ASSERT_OK(tablet()->Flush());
+  ASSERT_EQ(2, tablet()->num_rowsets());
+  NO_FATALS(AssertRowCount(2 * kNumRows + 1));
+
+  NO_FATALS(EnableTtl());
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  ASSERT_EQ(1, tablet()->num_rowsets());
+  NO_FATALS(AssertRowCount(1));
+
+  // Expired rows are dropped as the MRS is flushed.
+  NO_FATALS(InsertRows(4 * kTtlSec, kNumRows));
+  NO_FATALS(AssertRowCount(kNumRows + 1));
+  ASSERT_OK(tablet()->Flush());
+  NO_FATALS(AssertRowCount(1));
+}
+
 } // namespace tablet
 } // namespace kudu
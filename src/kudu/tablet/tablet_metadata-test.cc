@@ -46,6 +46,8 @@
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 
+DECLARE_bool(tablet_metadata_incremental_flush);
+
 DEFINE_int64(test_row_set_count, 1000, "");
 DEFINE_int64(test_block_count_per_rs, 1000, "");
 
@@ -195,6 +197,59 @@ TEST_F(TestTabletMetadata, TestOnDiskSize) {
   ASSERT_GE(final_size, superblock_pb.ByteSize());
 }
 
+// Test that superblocks flushed incrementally, with rowsets added, changed and
+// removed, are loaded back as they were flushed.
+TEST_F(TestTabletMetadata, TestIncrementalFlush) {
+  FLAGS_tablet_metadata_incremental_flush = true;
+  TabletMetadata* meta = harness_->tablet()->metadata();
+  // The first flush with the flag set rewrites the superblock.
+  ASSERT_OK(meta->Flush());
+  int64_t full_size = meta->on_disk_size();
+
+  // Each of these flushes only appends the new rowset.
+  unique_ptr<KuduPartialRow> row;
+  for (int i = 0; i < 3; i++) {
+    BuildPartialRow(i, i, "foo", &row);
+    ASSERT_OK(writer_->Insert(*row));
+    ASSERT_OK(harness_->tablet()->Flush());
+  }
+  ASSERT_GT(meta->on_disk_size(), full_size);
+
+  // Update a rowset, then replace all of them.
+  BuildPartialRow(0, 10, "bar", &row);
+  ASSERT_OK(writer_->Update(*row));
+  ASSERT_OK(harness_->tablet()->FlushBiggestDMS());
+  ASSERT_OK(harness_->tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  BuildPartialRow(3, 3, "baz", &row);
+  ASSERT_OK(writer_->Insert(*row));
+  ASSERT_OK(harness_->tablet()->Flush());
+  harness_->tablet()->Shutdown();
+
+  TabletSuperBlockPB superblock_pb_1;
+  ASSERT_OK(meta->ToSuperBlock(&superblock_pb_1));
+  ASSERT_EQ(2, superblock_pb_1.rowsets_size());
+
+  scoped_refptr<TabletMetadata> new_meta;
+  ASSERT_OK(TabletMetadata::Load(harness_->fs_manager(),
+                                 harness_->tablet()->tablet_id(),
+                                 &new_meta));
+  TabletSuperBlockPB superblock_pb_2;
+  ASSERT_OK(new_meta->ToSuperBlock(&superblock_pb_2));
+  ASSERT_EQ(superblock_pb_1.SerializeAsString(),
+            superblock_pb_2.SerializeAsString())
+                << pb_util::SecureDebugString(superblock_pb_1)
+                << pb_util::SecureDebugString(superblock_pb_2);
+
+  // The superblock read directly from disk matches too.
+  TabletSuperBlockPB superblock_pb_3;
+  ASSERT_OK(new_meta->ReadSuperBlockFromDisk(&superblock_pb_3));
+  ASSERT_EQ(superblock_pb_1.rowsets_size(), superblock_pb_3.rowsets_size());
+  for (int i = 0; i < superblock_pb_1.rowsets_size(); i++) {
+    ASSERT_EQ(superblock_pb_1.rowsets(i).SerializeAsString(),
+              superblock_pb_3.rowsets(i).SerializeAsString());
+  }
+}
+
 TEST_F(TestTabletMetadata, BenchmarkCollectBlockIds) {
   auto tablet_meta = harness_->tablet()->metadata();
   RowSetMetadataVector rs_metas;
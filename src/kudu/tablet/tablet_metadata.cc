@@ -22,9 +22,13 @@
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
+#include <google/protobuf/repeated_field.h>
 
 #include "kudu/common/common.pb.h"
 #include "kudu/common/schema.h"
@@ -45,6 +49,7 @@
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/hash_util.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/scoped_cleanup.h"
@@ -58,17 +63,32 @@ TAG_FLAG(enable_tablet_orphaned_block_deletion, advanced);
 TAG_FLAG(enable_tablet_orphaned_block_deletion, hidden);
 TAG_FLAG(enable_tablet_orphaned_block_deletion, runtime);
 
+DEFINE_bool(tablet_metadata_incremental_flush, false,
+            "Whether to flush the tablet metadata by appending the rowsets "
+            "added, changed and removed since the previous flush to the "
+            "superblock file instead of rewriting the whole superblock. The "
+            "superblock is rewritten once the appended changes outgrow it. "
+            "Superblocks written this way can't be read by versions of Kudu "
+            "without support for it.");
+TAG_FLAG(tablet_metadata_incremental_flush, experimental);
+TAG_FLAG(tablet_metadata_incremental_flush, runtime);
+
 using base::subtle::Barrier_AtomicIncrement;
 using kudu::consensus::MinimumOpId;
 using kudu::consensus::OpId;
 using kudu::fs::BlockManager;
 using kudu::fs::BlockDeletionTransaction;
+using google::protobuf::RepeatedPtrField;
+using kudu::pb_util::ReadablePBContainerFile;
 using kudu::pb_util::SecureDebugString;
 using kudu::pb_util::SecureShortDebugString;
+using kudu::pb_util::WritablePBContainerFile;
 using std::memory_order_relaxed;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
+using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 using strings::Substitute;
 
@@ -77,6 +97,52 @@ namespace tablet {
 
 const int64_t kNoDurableMemStore = -1;
 
+namespace {
+
+uint64_t RowSetFingerprint(const RowSetDataPB& pb) {
+  string serialized;
+  CHECK(pb.SerializeToString(&serialized));
+  return HashUtil::FastHash64(serialized.data(), serialized.size(), 0);
+}
+
+// Applies to 'superblock' the incremental 'update' appended to it by
+// TabletMetadata::AppendSuperBlockUpdateUnlocked(). 'update' is consumed.
+void ApplySuperBlockUpdate(TabletSuperBlockPB* update, TabletSuperBlockPB* superblock) {
+  unordered_set<int64_t> removed(update->removed_rowset_ids().begin(),
+                                 update->removed_rowset_ids().end());
+  unordered_map<int64_t, RowSetDataPB*> updated;
+  for (RowSetDataPB& rowset : *update->mutable_rowsets()) {
+    updated[rowset.id()] = &rowset;
+  }
+
+  // Keep the rowsets in their order, appending the new ones.
+  RepeatedPtrField<RowSetDataPB> rowsets;
+  for (RowSetDataPB& rowset : *superblock->mutable_rowsets()) {
+    if (ContainsKey(removed, rowset.id())) {
+      continue;
+    }
+    RowSetDataPB* updated_rowset = FindPtrOrNull(updated, rowset.id());
+    if (updated_rowset) {
+      rowsets.Add()->Swap(updated_rowset);
+      updated.erase(rowset.id());
+    } else {
+      rowsets.Add()->Swap(&rowset);
+    }
+  }
+  for (RowSetDataPB& rowset : *update->mutable_rowsets()) {
+    if (ContainsKey(updated, rowset.id())) {
+      rowsets.Add()->Swap(&rowset);
+    }
+  }
+
+  update->clear_rowsets();
+  update->clear_removed_rowset_ids();
+  superblock->Swap(update);
+  superblock->mutable_rowsets()->Swap(&rowsets);
+}
+
+} // anonymous namespace
+
 // ============================================================================
 //  Tablet Metadata
 // ============================================================================
@@ -184,6 +250,9 @@ vector<BlockIdPB> TabletMetadata::CollectBlockIdPBs(const TabletSuperBlockPB& su
     if (rowset.has_adhoc_index_block()) {
       block_ids.push_back(rowset.adhoc_index_block());
     }
+    for (const SecondaryIndexDataPB& index : rowset.secondary_indexes()) {
+      block_ids.push_back(index.block());
+    }
   }
   return block_ids;
 }
@@ -301,6 +370,9 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id,
       needs_flush_(false),
       flush_count_for_tests_(0),
       pre_flush_callback_(&DoNothingStatusClosure),
+      can_append_superblock_(false),
+      full_superblock_size_(0),
+      appended_superblock_size_(0),
       supports_live_row_count_(supports_live_row_count) {
   CHECK(schema_->has_column_ids());
   CHECK_GT(schema_->num_key_columns(), 0);
@@ -321,6 +393,9 @@ TabletMetadata::TabletMetadata(FsManager* fs_manager, string tablet_id)
       needs_flush_(false),
       flush_count_for_tests_(0),
       pre_flush_callback_(&DoNothingStatusClosure),
+      can_append_superblock_(false),
+      full_superblock_size_(0),
+      appended_superblock_size_(0),
       supports_live_row_count_(false) {}
 
 Status TabletMetadata::LoadFromDisk() {
@@ -581,7 +656,11 @@ Status TabletMetadata::Flush() {
     orphaned.assign(orphaned_blocks_.begin(), orphaned_blocks_.end());
   }
   pre_flush_callback_();
-  RETURN_NOT_OK(ReplaceSuperBlockUnlocked(pb));
+  bool appended;
+  RETURN_NOT_OK(AppendSuperBlockUpdateUnlocked(&pb, &appended));
+  if (!appended) {
+    RETURN_NOT_OK(ReplaceSuperBlockUnlocked(pb));
+  }
   TRACE("Metadata flushed");
   l_flush.Unlock();
 
@@ -649,6 +728,78 @@ Status TabletMetadata::ReplaceSuperBlockUnlocked(const TabletSuperBlockPB &pb) {
   flush_count_for_tests_++;
   RETURN_NOT_OK(UpdateOnDiskSize());
 
+  // Track the flushed rowsets so that the next flushes can append only
+  // their changes.
+  flushed_rowset_fingerprints_.clear();
+  can_append_superblock_ = FLAGS_tablet_metadata_incremental_flush;
+  if (can_append_superblock_) {
+    for (const RowSetDataPB& rowset : pb.rowsets()) {
+      flushed_rowset_fingerprints_.emplace(rowset.id(), RowSetFingerprint(rowset));
+    }
+  }
+  full_superblock_size_ = on_disk_size_.load(memory_order_relaxed);
+  appended_superblock_size_ = 0;
+
+  return Status::OK();
+}
+
+Status TabletMetadata::AppendSuperBlockUpdateUnlocked(TabletSuperBlockPB* pb, bool* appended) {
+  flush_lock_.AssertAcquired();
+  *appended = false;
+  if (!FLAGS_tablet_metadata_incremental_flush ||
+      !can_append_superblock_ ||
+      appended_superblock_size_ >= full_superblock_size_) {
+    return Status::OK();
+  }
+
+  // Copy all the fields but the rowsets, which are added only if they changed.
+  TabletSuperBlockPB update;
+  {
+    RepeatedPtrField<RowSetDataPB> rowsets;
+    rowsets.Swap(pb->mutable_rowsets());
+    update = *pb;
+    pb->mutable_rowsets()->Swap(&rowsets);
+  }
+  unordered_map<int64_t, uint64_t> fingerprints;
+  fingerprints.reserve(pb->rowsets_size());
+  for (const RowSetDataPB& rowset : pb->rowsets()) {
+    uint64_t fingerprint = RowSetFingerprint(rowset);
+    fingerprints.emplace(rowset.id(), fingerprint);
+    const uint64_t* flushed = FindOrNull(flushed_rowset_fingerprints_, rowset.id());
+    if (!flushed || *flushed != fingerprint) {
+      *update.add_rowsets() = rowset;
+    }
+  }
+  for (const auto& e : flushed_rowset_fingerprints_) {
+    if (!ContainsKey(fingerprints, e.first)) {
+      update.add_removed_rowset_ids(e.first);
+    }
+  }
+
+  // If the append fails midway, the file may end with a partial update after
+  // which nothing can be appended, so the superblock must be fully replaced.
+  can_append_superblock_ = false;
+  string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
+  RWFileOptions opts;
+  opts.mode = Env::MUST_EXIST;
+  unique_ptr<RWFile> file;
+  RETURN_NOT_OK_PREPEND(fs_manager_->env()->NewRWFile(opts, path, &file),
+                        Substitute("Failed to open tablet metadata $0", tablet_id_));
+  WritablePBContainerFile container(std::move(file));
+  RETURN_NOT_OK_PREPEND(container.OpenExisting(),
+                        Substitute("Failed to open tablet metadata $0", tablet_id_));
+  RETURN_NOT_OK_PREPEND(container.Append(update),
+                        Substitute("Failed to write tablet metadata $0", tablet_id_));
+  RETURN_NOT_OK_PREPEND(container.Sync(),
+                        Substitute("Failed to write tablet metadata $0", tablet_id_));
+  RETURN_NOT_OK(container.Close());
+  can_append_superblock_ = true;
+
+  flush_count_for_tests_++;
+  RETURN_NOT_OK(UpdateOnDiskSize());
+  flushed_rowset_fingerprints_.swap(fingerprints);
+  appended_superblock_size_ = on_disk_size_.load(memory_order_relaxed) - full_superblock_size_;
+  *appended = true;
   return Status::OK();
 }
 
@@ -664,10 +815,31 @@ boost::optional<consensus::OpId> TabletMetadata::tombstone_last_logged_opid() co
 
 Status TabletMetadata::ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const {
   string path = fs_manager_->GetTabletMetadataPath(tablet_id_);
-  RETURN_NOT_OK_PREPEND(
-      pb_util::ReadPBContainerFromPath(fs_manager_->env(), path, superblock),
-      Substitute("Could not load tablet metadata from $0", path));
-  return Status::OK();
+  const string error_msg = Substitute("Could not load tablet metadata from $0", path);
+  unique_ptr<RandomAccessFile> file;
+  RETURN_NOT_OK_PREPEND(fs_manager_->env()->NewRandomAccessFile(path, &file), error_msg);
+  ReadablePBContainerFile container(std::move(file));
+  RETURN_NOT_OK_PREPEND(container.Open(), error_msg);
+  RETURN_NOT_OK_PREPEND(container.ReadNextPB(superblock), error_msg);
+
+  // Apply the incremental updates appended to the superblock, if any.
+  while (true) {
+    TabletSuperBlockPB update;
+    Status s = container.ReadNextPB(&update);
+    if (s.IsEndOfFile()) {
+      break;
+    }
+    if (s.IsIncomplete()) {
+      // The server crashed while appending this update, so its flush never
+      // completed.
+      LOG_WITH_PREFIX(WARNING) << "Ignoring partially written update at the end of "
+                               << path << ": " << s.ToString();
+      break;
+    }
+    RETURN_NOT_OK_PREPEND(s, error_msg);
+    ApplySuperBlockUpdate(&update, superblock);
+  }
+  return container.Close();
 }
 
 Status TabletMetadata::ToSuperBlock(TabletSuperBlockPB* super_block) const {
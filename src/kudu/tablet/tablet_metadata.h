@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -245,7 +246,8 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Returns the table's dimension label.
   boost::optional<std::string> dimension_label() const;
 
-  // Loads the currently-flushed superblock from disk into the given protobuf.
+  // Loads the currently-flushed superblock from disk into the given protobuf,
+  // applying the incremental updates appended to it.
   Status ReadSuperBlockFromDisk(TabletSuperBlockPB* superblock) const;
 
   // Sets *super_block to the serialized form of the current metadata.
@@ -320,6 +322,14 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // Requires 'flush_lock_'.
   Status ReplaceSuperBlockUnlocked(const TabletSuperBlockPB &pb);
 
+  // Appends to the superblock file the changes between the last flushed
+  // superblock and 'pb', if --tablet_metadata_incremental_flush is set and
+  // the appended changes don't outgrow the full superblock. Sets 'appended'
+  // to false if the superblock must be fully replaced instead. 'pb' is left
+  // unchanged.
+  // Requires 'flush_lock_'.
+  Status AppendSuperBlockUpdateUnlocked(TabletSuperBlockPB* pb, bool* appended);
+
   // Requires 'data_lock_'.
   Status UpdateUnlocked(const RowSetMetadataIds& to_remove,
                         const RowSetMetadataVector& to_add,
@@ -418,6 +428,22 @@ class TabletMetadata : public RefCountedThreadSafe<TabletMetadata> {
   // call to Flush() or LoadFromDisk().
   std::atomic<int64_t> on_disk_size_;
 
+  // Fingerprints of the rowsets of the last flushed superblock, keyed by
+  // rowset ID, used to determine which rowsets an incremental flush must
+  // write. Only valid if 'can_append_superblock_' is set.
+  // Protected by 'flush_lock_'.
+  std::unordered_map<int64_t, uint64_t> flushed_rowset_fingerprints_;
+
+  // Whether incremental updates may be appended to the superblock file, i.e.
+  // whether it was last fully written by this object and no append failed
+  // since. Protected by 'flush_lock_'.
+  bool can_append_superblock_;
+
+  // The size of the last fully written superblock, and the number of bytes
+  // of incremental updates appended to it since. Protected by 'flush_lock_'.
+  int64_t full_superblock_size_;
+  int64_t appended_superblock_size_;
+
   // The tablet supports live row counting if true.
   bool supports_live_row_count_;
 
@@ -157,6 +157,13 @@ METRIC_DEFINE_counter(tablet, deleted_rowset_gc_bytes_deleted,
                       "Number of bytes deleted by garbage-collecting deleted rowsets.",
                       kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_counter(tablet, expired_rowsets_deleted,
+                      "Expired Rowsets Deleted",
+                      kudu::MetricUnit::kUnits,
+                      "Number of rowsets whose rows had all expired according to the "
+                      "table's TTL, deleted by garbage-collecting deleted rowsets.",
+                      kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_histogram(tablet, bloom_lookups_per_op, "Bloom Lookups per Operation",
                         kudu::MetricUnit::kProbes,
                         "Tracks the number of bloom filter lookups performed by each "
@@ -198,6 +205,84 @@ METRIC_DEFINE_histogram(tablet, write_op_duration_commit_wait_consistency,
   kudu::MetricLevel::kDebug,
   60000000LU, 2);
 
+METRIC_DEFINE_histogram(tablet, write_prepare_queue_duration,
+  "Write Prepare Queue Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time writes to this tablet spent waiting in the queue of the prepare thread pool.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_decode_duration,
+  "Write Decode Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent decoding the row operations of writes to this tablet.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_row_lock_wait_duration,
+  "Write Row Lock Wait Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent acquiring the row locks of writes to this tablet, including waiting "
+  "for other writes to the same rows to release them.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_replicate_duration,
+  "Write Replication Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent replicating writes to this tablet to a majority of its replicas, "
+  "including appending them to the local WAL, whose time is tracked by "
+  "raft_local_append_latency and log_sync_latency.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_apply_queue_duration,
+  "Write Apply Queue Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time replicated writes to this tablet spent waiting in the queue of the apply "
+  "thread pool.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_apply_duration,
+  "Write Apply Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent applying writes to this tablet.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_apply_presence_check_duration,
+  "Write Presence Check Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent applying writes to this tablet checking which rowsets hold the rows "
+  "of their operations, e.g. by probing the bloom filters of the rowsets.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_apply_insert_duration,
+  "Write Insert Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent applying writes to this tablet inserting rows into the MemRowSet, "
+  "or into new rowsets for bulk inserts of sorted rows.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_apply_mutate_duration,
+  "Write Mutation Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time spent applying writes to this tablet updating and deleting rows, e.g. in "
+  "the DeltaMemStores.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
+METRIC_DEFINE_histogram(tablet, write_response_duration,
+  "Write Response Time",
+  kudu::MetricUnit::kMicroseconds,
+  "Time from writes to this tablet being applied to their responses being sent, "
+  "including committing them and any commit wait.",
+  kudu::MetricLevel::kDebug,
+  60000000LU, 2);
+
 METRIC_DEFINE_histogram(tablet, commit_wait_duration,
   "Commit-Wait Duration",
   kudu::MetricUnit::kMicroseconds,
@@ -261,6 +346,13 @@ METRIC_DEFINE_gauge_uint32(tablet, deleted_rowset_gc_running,
   "Number of deleted rowset GC operations currently running.",
   kudu::MetricLevel::kDebug);
 
+METRIC_DEFINE_gauge_uint32(tablet, cold_data_migration_running,
+  "Cold Data Migration Running",
+  kudu::MetricUnit::kMaintenanceOperations,
+  "Number of operations moving the tablet's data to cold data directories "
+  "currently running.",
+  kudu::MetricLevel::kDebug);
+
 METRIC_DEFINE_gauge_int64(tablet, deleted_rowset_estimated_retained_bytes,
   "Estimated Deletable Bytes Retained in Deleted Rowsets",
   kudu::MetricUnit::kBytes,
@@ -330,6 +422,14 @@ METRIC_DEFINE_histogram(tablet, deleted_rowset_gc_duration,
   kudu::MetricLevel::kInfo,
   60000LU, 1);
 
+METRIC_DEFINE_histogram(tablet, cold_data_migration_duration,
+  "Cold Data Migration Duration",
+  kudu::MetricUnit::kMilliseconds,
+  "Time spent running the maintenance operation to move the tablet's data "
+  "to cold data directories.",
+  kudu::MetricLevel::kInfo,
+  60000LU, 1);
+
 METRIC_DEFINE_counter(tablet, leader_memory_pressure_rejections,
   "Leader Memory Pressure Rejections",
   kudu::MetricUnit::kRequests,
@@ -373,6 +473,7 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(mrs_lookups),
     MINIT(bytes_flushed),
     MINIT(deleted_rowset_gc_bytes_deleted),
+    MINIT(expired_rowsets_deleted),
     MINIT(undo_delta_block_gc_bytes_deleted),
     MINIT(bloom_lookups_per_op),
     MINIT(key_file_lookups_per_op),
@@ -381,11 +482,22 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(snapshot_read_inflight_wait_duration),
     MINIT(write_op_duration_client_propagated_consistency),
     MINIT(write_op_duration_commit_wait_consistency),
+    MINIT(write_prepare_queue_duration),
+    MINIT(write_decode_duration),
+    MINIT(write_row_lock_wait_duration),
+    MINIT(write_replicate_duration),
+    MINIT(write_apply_queue_duration),
+    MINIT(write_apply_duration),
+    MINIT(write_apply_presence_check_duration),
+    MINIT(write_apply_insert_duration),
+    MINIT(write_apply_mutate_duration),
+    MINIT(write_response_duration),
     GINIT(flush_dms_running),
     GINIT(flush_mrs_running),
     GINIT(compact_rs_running),
     GINIT(deleted_rowset_estimated_retained_bytes),
     GINIT(deleted_rowset_gc_running),
+    GINIT(cold_data_migration_running),
     GINIT(delta_minor_compact_rs_running),
     GINIT(delta_major_compact_rs_running),
     GINIT(undo_delta_block_gc_running),
@@ -394,6 +506,7 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(flush_mrs_duration),
     MINIT(compact_rs_duration),
     MINIT(deleted_rowset_gc_duration),
+    MINIT(cold_data_migration_duration),
     MINIT(delta_minor_compact_rs_duration),
     MINIT(delta_major_compact_rs_duration),
     MINIT(undo_delta_block_gc_init_duration),
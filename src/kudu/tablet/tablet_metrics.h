@@ -71,6 +71,7 @@ struct TabletMetrics {
   // Operation stats.
   scoped_refptr<Counter> bytes_flushed;
   scoped_refptr<Counter> deleted_rowset_gc_bytes_deleted;
+  scoped_refptr<Counter> expired_rowsets_deleted;
   scoped_refptr<Counter> undo_delta_block_gc_bytes_deleted;
 
   scoped_refptr<Histogram> bloom_lookups_per_op;
@@ -82,11 +83,24 @@ struct TabletMetrics {
   scoped_refptr<Histogram> write_op_duration_client_propagated_consistency;
   scoped_refptr<Histogram> write_op_duration_commit_wait_consistency;
 
+  // The time writes spend in each of their stages.
+  scoped_refptr<Histogram> write_prepare_queue_duration;
+  scoped_refptr<Histogram> write_decode_duration;
+  scoped_refptr<Histogram> write_row_lock_wait_duration;
+  scoped_refptr<Histogram> write_replicate_duration;
+  scoped_refptr<Histogram> write_apply_queue_duration;
+  scoped_refptr<Histogram> write_apply_duration;
+  scoped_refptr<Histogram> write_apply_presence_check_duration;
+  scoped_refptr<Histogram> write_apply_insert_duration;
+  scoped_refptr<Histogram> write_apply_mutate_duration;
+  scoped_refptr<Histogram> write_response_duration;
+
   scoped_refptr<AtomicGauge<uint32_t> > flush_dms_running;
   scoped_refptr<AtomicGauge<uint32_t> > flush_mrs_running;
   scoped_refptr<AtomicGauge<uint32_t> > compact_rs_running;
   scoped_refptr<AtomicGauge<int64_t> > deleted_rowset_estimated_retained_bytes;
   scoped_refptr<AtomicGauge<uint32_t> > deleted_rowset_gc_running;
+  scoped_refptr<AtomicGauge<uint32_t> > cold_data_migration_running;
   scoped_refptr<AtomicGauge<uint32_t> > delta_minor_compact_rs_running;
   scoped_refptr<AtomicGauge<uint32_t> > delta_major_compact_rs_running;
   scoped_refptr<AtomicGauge<uint32_t> > undo_delta_block_gc_running;
@@ -96,6 +110,7 @@ struct TabletMetrics {
   scoped_refptr<Histogram> flush_mrs_duration;
   scoped_refptr<Histogram> compact_rs_duration;
   scoped_refptr<Histogram> deleted_rowset_gc_duration;
+  scoped_refptr<Histogram> cold_data_migration_duration;
   scoped_refptr<Histogram> delta_minor_compact_rs_duration;
   scoped_refptr<Histogram> delta_major_compact_rs_duration;
   scoped_refptr<Histogram> undo_delta_block_gc_init_duration;
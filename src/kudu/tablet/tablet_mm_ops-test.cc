@@ -125,5 +125,30 @@ TEST_F(KuduTabletMmOpsTest, TestMajorDeltaCompactionOpCacheStats) {
                                        tablet()->metrics()->delta_minor_compact_rs_duration,
                                        tablet()->metrics()->delta_major_compact_rs_duration }));
 }
+
+// The compaction quality computed by the tablet is cached, but must follow the
+// changes of its rowsets.
+TEST_F(KuduTabletMmOpsTest, TestCompactionStatsFollowRowSetChanges) {
+  // Two overlapping rowsets.
+  NO_FATALS(InsertTestRows(0, 50, 0));
+  NO_FATALS(InsertTestRows(100, 50, 0));
+  ASSERT_OK(tablet()->Flush());
+  NO_FATALS(InsertTestRows(50, 50, 0));
+  ASSERT_OK(tablet()->Flush());
+
+  MaintenanceOpStats stats;
+  tablet()->UpdateCompactionStats(&stats);
+  const double quality = stats.perf_improvement();
+  ASSERT_GT(quality, 0);
+  stats.Clear();
+  tablet()->UpdateCompactionStats(&stats);
+  ASSERT_EQ(quality, stats.perf_improvement());
+
+  // Once they're compacted into a single rowset, there's nothing to compact.
+  ASSERT_OK(tablet()->Compact(Tablet::FORCE_COMPACT_ALL));
+  stats.Clear();
+  tablet()->UpdateCompactionStats(&stats);
+  ASSERT_EQ(0, stats.perf_improvement());
+}
 } // namespace tablet
 } // namespace kudu
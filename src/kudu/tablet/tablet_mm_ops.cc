@@ -20,12 +20,16 @@
 #include <mutex>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/common.pb.h"
+#include "kudu/fs/data_dirs.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/tablet/rowset.h"
@@ -83,12 +87,19 @@ DEFINE_bool(enable_deleted_rowset_gc, true,
     "considered ancient history (see --tablet_history_max_age_sec) are deleted.");
 TAG_FLAG(enable_deleted_rowset_gc, runtime);
 
+DECLARE_string(fs_cold_data_dirs);
+
 using std::string;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
 namespace tablet {
 
+// Small enough that moving cold data waits for the ops which improve the
+// performance of the tablets in use.
+static const double kColdDataMigrationPerfImprovement = 0.001;
+
 TabletOpBase::TabletOpBase(string name, IOUsage io_usage, Tablet* tablet)
     : MaintenanceOp(std::move(name), io_usage),
       tablet_(tablet) {
@@ -98,6 +109,13 @@ string TabletOpBase::LogPrefix() const {
   return tablet_->LogPrefix();
 }
 
+void TabletOpBase::GetDataDirs(vector<string>* dirs) const {
+  // Leaves 'dirs' empty if the tablet has no data dir group, e.g. if it's
+  // being deleted, in which case the op isn't counted against any directory.
+  ignore_result(tablet_->metadata()->fs_manager()->dd_manager()->FindDataDirsByTabletId(
+      tablet_->tablet_id(), dirs));
+}
+
 int32_t TabletOpBase::priority() const {
   int32_t priority = 0;
   const auto& extra_config = tablet_->metadata()->extra_config();
@@ -435,5 +453,47 @@ std::string DeletedRowsetGCOp::LogPrefix() const {
   return tablet_->LogPrefix();
 }
 
+////////////////////////////////////////////////////////////
+// ColdDataMigrationOp
+////////////////////////////////////////////////////////////
+
+ColdDataMigrationOp::ColdDataMigrationOp(Tablet* tablet)
+    : TabletOpBase(Substitute("ColdDataMigrationOp($0)", tablet->tablet_id()),
+                   MaintenanceOp::HIGH_IO_USAGE, tablet),
+      running_(false) {
+}
+
+void ColdDataMigrationOp::UpdateStats(MaintenanceOpStats* stats) {
+  stats->set_runnable(false);
+  if (FLAGS_fs_cold_data_dirs.empty() || running_.load()) {
+    return;
+  }
+  const bool cold = tablet_->IsCold();
+  if (tablet_->in_cold_dirs()) {
+    if (!cold) {
+      tablet_->LeaveColdDirs();
+    }
+    return;
+  }
+  if (cold) {
+    stats->set_runnable(true);
+    stats->set_perf_improvement(kColdDataMigrationPerfImprovement);
+  }
+}
+
+void ColdDataMigrationOp::Perform() {
+  WARN_NOT_OK(tablet_->MoveToColdDirs(),
+              Substitute("$0Moving data to cold data directories failed", LogPrefix()));
+  running_.store(false);
+}
+
+scoped_refptr<Histogram> ColdDataMigrationOp::DurationHistogram() const {
+  return tablet_->metrics()->cold_data_migration_duration;
+}
+
+scoped_refptr<AtomicGauge<uint32_t>> ColdDataMigrationOp::RunningGauge() const {
+  return tablet_->metrics()->cold_data_migration_running;
+}
+
 } // namespace tablet
 } // namespace kudu
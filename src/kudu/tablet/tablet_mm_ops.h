@@ -19,6 +19,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
@@ -40,6 +41,8 @@ class TabletOpBase : public MaintenanceOp {
   TabletOpBase(std::string name, IOUsage io_usage, Tablet* tablet);
   std::string LogPrefix() const;
 
+  void GetDataDirs(std::vector<std::string>* dirs) const override;
+
  protected:
   int32_t priority() const override;
 
@@ -135,6 +138,8 @@ class UndoDeltaBlockGCOp : public TabletOpBase {
  public:
   explicit UndoDeltaBlockGCOp(Tablet* tablet);
 
+  OpClass op_class() const override { return GC_OP; }
+
   // Estimates the number of bytes that may potentially be in ancient delta
   // undo blocks. Over time, as Perform() is invoked, this estimate gets more
   // accurate.
@@ -164,6 +169,8 @@ class DeletedRowsetGCOp : public TabletOpBase {
  public:
   explicit DeletedRowsetGCOp(Tablet* tablet);
 
+  OpClass op_class() const override { return GC_OP; }
+
   // Estimate the number of bytes from rowsets that have been fully deleted and
   // exist entirely before the AHM (i.e. their most recent update happened
   // before the AHM).
@@ -191,6 +198,37 @@ class DeletedRowsetGCOp : public TabletOpBase {
   DISALLOW_COPY_AND_ASSIGN(DeletedRowsetGCOp);
 };
 
+// MaintenanceOp to move the data of a tablet which hasn't been read or written
+// for a while into cold data directories (see --fs_cold_data_dirs), keeping
+// the faster directories for recently accessed tablets.
+class ColdDataMigrationOp : public TabletOpBase {
+ public:
+  explicit ColdDataMigrationOp(Tablet* tablet);
+
+  // Reports the op as runnable, with a small performance improvement so it
+  // yields to the other ops, if the tablet has turned cold. Also places new
+  // blocks of a tablet whose data was moved in the faster directories again
+  // once it's accessed.
+  void UpdateStats(MaintenanceOpStats* stats) override;
+
+  // If this op is already running, we shouldn't run it again.
+  bool Prepare() override {
+    bool false_ref = false;
+    return running_.compare_exchange_strong(false_ref, true);
+  }
+
+  // Rewrites the tablet's rowsets into cold data directories.
+  void Perform() override;
+
+  scoped_refptr<Histogram> DurationHistogram() const override;
+  scoped_refptr<AtomicGauge<uint32_t> > RunningGauge() const override;
+
+ private:
+  std::atomic<bool> running_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColdDataMigrationOp);
+};
+
 } // namespace tablet
 } // namespace kudu
 
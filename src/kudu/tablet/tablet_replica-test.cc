@@ -77,7 +77,9 @@
 #include "kudu/util/threadpool.h"
 
 DECLARE_bool(enable_maintenance_manager);
+DECLARE_int32(flush_checkpoint_interval_secs);
 DECLARE_int32(flush_threshold_mb);
+DECLARE_int32(tablet_apply_parallel_min_ops);
 DECLARE_int32(tablet_history_max_age_sec);
 
 METRIC_DECLARE_entity(tablet);
@@ -699,6 +701,40 @@ TEST_F(TabletReplicaTest, TestFlushOpsPerfImprovements) {
   stats.Clear();
 }
 
+TEST_F(TabletReplicaTest, TestFlushOpsCheckpointInterval) {
+  FLAGS_flush_threshold_mb = 64;
+  FLAGS_flush_checkpoint_interval_secs = 10 * 60;
+
+  MaintenanceOpStats stats;
+
+  // Below the threshold and not due for a checkpoint yet.
+  stats.set_ram_anchored(1024 * 1024);
+  stats.set_logs_retained_bytes(32 * 1024 * 1024);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 5 * 60 * 1000);
+  ASSERT_GT(1.0, stats.perf_improvement());
+  stats.Clear();
+
+  // Due for a checkpoint: the improvement is the retained MB of WAL.
+  stats.set_ram_anchored(1024 * 1024);
+  stats.set_logs_retained_bytes(32 * 1024 * 1024);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 11 * 60 * 1000);
+  ASSERT_NEAR(32, stats.perf_improvement(), 0.01);
+  stats.Clear();
+
+  // Due for a checkpoint but retaining little WAL: the improvement is still 1.
+  stats.set_ram_anchored(1024 * 1024);
+  stats.set_logs_retained_bytes(1024);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 11 * 60 * 1000);
+  ASSERT_EQ(1.0, stats.perf_improvement());
+  stats.Clear();
+
+  // Nothing to checkpoint if no WAL is retained.
+  stats.set_ram_anchored(1024 * 1024);
+  FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(&stats, 11 * 60 * 1000);
+  ASSERT_GT(1.0, stats.perf_improvement());
+  stats.Clear();
+}
+
 // Test that the schema of a tablet will be rolled forward upon replaying an
 // alter schema request.
 TEST_F(TabletReplicaTest, TestRollLogSegmentSchemaOnAlter) {
@@ -799,6 +835,51 @@ TEST_F(TabletReplicaTest, TestLiveRowCountMetric) {
   ASSERT_EQ(kNumInsert - kNumDelete, live_row_count->value());
 }
 
+// Ensure the operations of a large write applied in parallel chunks are still
+// applied in order on each row.
+TEST_F(TabletReplicaTest, TestParallelApplyKeepsPerRowOrder) {
+  FLAGS_tablet_apply_parallel_min_ops = 10;
+  ConsensusBootstrapInfo info;
+  ASSERT_OK(StartReplicaAndWaitUntilLeader(info));
+
+  // Insert rows, delete the odd ones and insert every other deleted one back,
+  // all in one write.
+  const int kNumRows = 200;
+  Schema schema(GetTestSchema());
+  WriteRequestPB req;
+  req.set_tablet_id(tablet()->tablet_id());
+  ASSERT_OK(SchemaToPB(schema, req.mutable_schema()));
+  RowOperationsPBEncoder enc(req.mutable_row_operations());
+  KuduPartialRow row(&schema);
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_OK(row.SetInt32("key", i));
+    enc.Add(RowOperationsPB::INSERT, row);
+  }
+  for (int i = 1; i < kNumRows; i += 2) {
+    ASSERT_OK(row.SetInt32("key", i));
+    enc.Add(RowOperationsPB::DELETE, row);
+  }
+  for (int i = 1; i < kNumRows; i += 4) {
+    ASSERT_OK(row.SetInt32("key", i));
+    enc.Add(RowOperationsPB::INSERT, row);
+  }
+
+  WriteResponsePB resp;
+  unique_ptr<WriteTransactionState> tx_state(
+      new WriteTransactionState(tablet_replica_.get(), &req, nullptr, &resp));
+  CountDownLatch rpc_latch(1);
+  tx_state->set_completion_callback(unique_ptr<TransactionCompletionCallback>(
+      new LatchTransactionCompletionCallback<WriteResponsePB>(&rpc_latch, &resp)));
+  ASSERT_OK(tablet_replica_->SubmitWrite(std::move(tx_state)));
+  rpc_latch.Wait();
+  ASSERT_FALSE(resp.has_error()) << SecureDebugString(resp);
+  ASSERT_EQ(0, resp.per_row_errors_size()) << SecureDebugString(resp);
+
+  uint64_t live_rows;
+  ASSERT_OK(tablet()->CountLiveRows(&live_rows));
+  ASSERT_EQ(kNumRows / 2 + kNumRows / 4, live_rows);
+}
+
 TEST_F(TabletReplicaTest, TestRestartAfterGCDeletedRowsets) {
   FLAGS_enable_maintenance_manager = false;
   FLAGS_tablet_history_max_age_sec = 1;
@@ -201,6 +201,7 @@ Status TabletReplica::Start(const ConsensusBootstrapInfo& bootstrap_info,
               METRIC_op_prepare_queue_time.Instantiate(metric_entity),
               METRIC_op_prepare_run_time.Instantiate(metric_entity)
           });
+      pre_prepare_pool_token_ = prepare_pool->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
 
       if (tablet_->metrics() != nullptr) {
         TRACE("Starting instrumentation");
@@ -297,6 +298,9 @@ void TabletReplica::Stop() {
   if (prepare_pool_token_) {
     prepare_pool_token_->Shutdown();
   }
+  if (pre_prepare_pool_token_) {
+    pre_prepare_pool_token_->Shutdown();
+  }
 
   if (log_) {
     WARN_NOT_OK(log_->Close(), "Error closing the Log.");
@@ -706,6 +710,7 @@ Status TabletReplica::NewLeaderTransactionDriver(unique_ptr<Transaction> transac
     consensus_.get(),
     log_.get(),
     prepare_pool_token_.get(),
+    pre_prepare_pool_token_.get(),
     apply_pool_,
     &txn_order_verifier_);
   RETURN_NOT_OK(tx_driver->Init(std::move(transaction), consensus::LEADER));
@@ -721,6 +726,7 @@ Status TabletReplica::NewReplicaTransactionDriver(unique_ptr<Transaction> transa
     consensus_.get(),
     log_.get(),
     prepare_pool_token_.get(),
+    pre_prepare_pool_token_.get(),
     apply_pool_,
     &txn_order_verifier_);
   RETURN_NOT_OK(tx_driver->Init(std::move(transaction), consensus::REPLICA));
@@ -281,6 +281,9 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
   // Return pointer to the transaction tracker for this peer.
   const TransactionTracker* transaction_tracker() const { return &txn_tracker_; }
 
+  // Return the pool the transactions of this replica are applied on.
+  ThreadPool* apply_pool() const { return apply_pool_; }
+
   const scoped_refptr<TabletMetadata>& tablet_metadata() const {
     return meta_;
   }
@@ -375,6 +378,10 @@ class TabletReplica : public RefCountedThreadSafe<TabletReplica>,
   // Token for serial task submission to the server-wide transaction prepare pool.
   std::unique_ptr<ThreadPoolToken> prepare_pool_token_;
 
+  // Token for concurrent task submission to the same pool, used to do the
+  // part of the prepare phase which doesn't need to run in order.
+  std::unique_ptr<ThreadPoolToken> pre_prepare_pool_token_;
+
   clock::Clock* clock_;
 
   // List of maintenance operations for the tablet that need information that only the peer
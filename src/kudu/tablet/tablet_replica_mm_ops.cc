@@ -17,17 +17,22 @@
 
 #include "kudu/tablet/tablet_replica_mm_ops.h"
 
+#include <algorithm>
 #include <map>
 #include <mutex>
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/common/common.pb.h"
+#include "kudu/fs/data_dirs.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/basictypes.h"
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -75,6 +80,26 @@ DEFINE_int32(flush_threshold_secs, 2 * 60,
 TAG_FLAG(flush_threshold_secs, experimental);
 TAG_FLAG(flush_threshold_secs, runtime);
 
+DEFINE_int32(flush_checkpoint_interval_secs, 0,
+             "Number of seconds after which a MemRowSet or DeltaMemStore which "
+             "anchors WAL segments is flushed in preference to compactions, no "
+             "matter how small it is. Flushing it checkpoints its contents, so "
+             "that its WAL segments no longer need to be retained and replayed "
+             "at startup. Useful for tablets which are written to often but "
+             "which rarely reach the other flush thresholds. A value of 0 "
+             "disables this.");
+TAG_FLAG(flush_checkpoint_interval_secs, experimental);
+TAG_FLAG(flush_checkpoint_interval_secs, runtime);
+
+DEFINE_int64(flush_threshold_dms_scanned_deltas, 1000 * 1000,
+             "Number of deltas which scans may walk through in a DeltaMemStore before "
+             "flushing it is considered to improve performance, regardless of its size. "
+             "Applying deltas from a DeltaMemStore is much slower than applying them "
+             "from a delta file, which is what makes small but frequently scanned "
+             "DeltaMemStores worth flushing. A value of 0 disables this.");
+TAG_FLAG(flush_threshold_dms_scanned_deltas, experimental);
+TAG_FLAG(flush_threshold_dms_scanned_deltas, runtime);
+
 
 METRIC_DEFINE_gauge_uint32(tablet, log_gc_running,
                            "Log GCs Running",
@@ -127,6 +152,17 @@ void FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(MaintenanceOpStats
     }
     stats->set_perf_improvement(perf);
   }
+
+  // Checkpoint stores which have anchored WAL segments for too long: consider
+  // the perf improvement to be 1 for every MB of WAL they retain, but at least 1,
+  // so that the flush is preferred over most compactions.
+  const int32_t checkpoint_secs = FLAGS_flush_checkpoint_interval_secs;
+  if (checkpoint_secs > 0 && elapsed_ms > checkpoint_secs * 1000.0 &&
+      stats->logs_retained_bytes() > 0) {
+    double retained_mb = static_cast<double>(stats->logs_retained_bytes()) / (1024 * 1024);
+    stats->set_perf_improvement(std::max(stats->perf_improvement(),
+                                         std::max(retained_mb, 1.0)));
+  }
 }
 
 //
@@ -139,6 +175,12 @@ TabletReplicaOpBase::TabletReplicaOpBase(std::string name,
       tablet_replica_(tablet_replica) {
 }
 
+void TabletReplicaOpBase::GetDataDirs(std::vector<std::string>* dirs) const {
+  const auto& meta = tablet_replica_->tablet_metadata();
+  ignore_result(meta->fs_manager()->dd_manager()->FindDataDirsByTabletId(
+      meta->tablet_id(), dirs));
+}
+
 int32_t TabletReplicaOpBase::priority() const {
   int32_t priority = 0;
   const auto& extra_config = tablet_replica_->tablet_metadata()->extra_config();
@@ -174,7 +216,9 @@ void FlushMRSOp::UpdateStats(MaintenanceOpStats* stats) {
     stats->set_runnable(lock.try_lock());
   }
 
-  stats->set_ram_anchored(tablet_replica_->tablet()->MemRowSetSize());
+  const size_t mrs_size = tablet_replica_->tablet()->MemRowSetSize();
+  stats->set_ram_anchored(mrs_size);
+  stats->set_io_bytes(mrs_size);
   stats->set_logs_retained_bytes(
       tablet_replica_->tablet()->MemRowSetLogReplaySize(replay_size_map));
 
@@ -236,21 +280,34 @@ void FlushDeltaMemStoresOp::UpdateStats(MaintenanceOpStats* stats) {
   std::lock_guard<simple_spinlock> l(lock_);
   int64_t dms_size;
   int64_t retention_size;
+  int64_t deltas_scanned;
   map<int64_t, int64_t> max_idx_to_replay_size;
   if (tablet_replica_->tablet()->DeltaMemRowSetEmpty() ||
       !tablet_replica_->GetReplaySizeMap(&max_idx_to_replay_size).ok()) {
     return;
   }
   tablet_replica_->tablet()->GetInfoForBestDMSToFlush(max_idx_to_replay_size,
-                                                   &dms_size, &retention_size);
+                                                   &dms_size, &retention_size,
+                                                   &deltas_scanned);
 
   stats->set_ram_anchored(dms_size);
+  stats->set_io_bytes(dms_size);
   stats->set_runnable(true);
   stats->set_logs_retained_bytes(retention_size);
 
   FlushOpPerfImprovementPolicy::SetPerfImprovementForFlush(
       stats,
       time_since_flush_.elapsed().wall_millis());
+
+  // A DMS which scans keep walking through is worth flushing even if it's
+  // small: consider the perf improvement to be 1 for every multiple of the
+  // threshold.
+  const int64_t scanned_threshold = FLAGS_flush_threshold_dms_scanned_deltas;
+  if (scanned_threshold > 0 && deltas_scanned >= scanned_threshold) {
+    stats->set_perf_improvement(std::max(
+        stats->perf_improvement(),
+        static_cast<double>(deltas_scanned) / scanned_threshold));
+  }
 }
 
 void FlushDeltaMemStoresOp::Perform() {
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stringprintf.h"
@@ -39,7 +40,10 @@ class FlushOpPerfImprovementPolicy {
   ~FlushOpPerfImprovementPolicy() {}
 
   // Sets the performance improvement based on the anchored ram if it's over the threshold,
-  // else it will set it based on how long it has been since the last flush.
+  // else it will set it based on how long it has been since the last flush. A
+  // store which hasn't been flushed for longer than the checkpoint interval gets
+  // a high improvement based on the WAL it retains. 'stats' must already have
+  // the anchored ram and the retained logs set.
   static void SetPerfImprovementForFlush(MaintenanceOpStats* stats, double elapsed_ms);
 
  private:
@@ -50,6 +54,8 @@ class TabletReplicaOpBase : public MaintenanceOp {
  public:
   explicit TabletReplicaOpBase(std::string name, IOUsage io_usage, TabletReplica* tablet_replica);
 
+  void GetDataDirs(std::vector<std::string>* dirs) const override;
+
  protected:
   int32_t priority() const override;
 
@@ -67,6 +73,8 @@ class FlushMRSOp : public TabletReplicaOpBase {
     time_since_flush_.start();
   }
 
+  OpClass op_class() const override { return FLUSH_OP; }
+
   void UpdateStats(MaintenanceOpStats* stats) override;
 
   bool Prepare() override;
@@ -95,6 +103,8 @@ class FlushDeltaMemStoresOp : public TabletReplicaOpBase {
     time_since_flush_.start();
   }
 
+  OpClass op_class() const override { return FLUSH_OP; }
+
   void UpdateStats(MaintenanceOpStats* stats) override;
 
   bool Prepare() override {
@@ -121,6 +131,11 @@ class LogGCOp : public TabletReplicaOpBase {
  public:
   explicit LogGCOp(TabletReplica* tablet_replica);
 
+  OpClass op_class() const override { return GC_OP; }
+
+  // Log GC only touches the WAL directory, not the tablet's data dirs.
+  void GetDataDirs(std::vector<std::string>* /*dirs*/) const override {}
+
   void UpdateStats(MaintenanceOpStats* stats) override;
 
   bool Prepare() override;
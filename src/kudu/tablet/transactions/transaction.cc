@@ -76,7 +76,16 @@ TransactionMetrics::TransactionMetrics()
     successful_upserts(0),
     successful_updates(0),
     successful_deletes(0),
-    commit_wait_duration_usec(0) {
+    commit_wait_duration_usec(0),
+    prepare_queue_nanos(0),
+    decode_nanos(0),
+    row_lock_wait_nanos(0),
+    replicate_nanos(0),
+    apply_queue_nanos(0),
+    apply_nanos(0),
+    apply_presence_check_nanos(0),
+    apply_insert_nanos(0),
+    apply_mutate_nanos(0) {
 }
 
 void TransactionMetrics::Reset() {
@@ -86,6 +95,15 @@ void TransactionMetrics::Reset() {
   successful_updates = 0;
   successful_deletes = 0;
   commit_wait_duration_usec = 0;
+  prepare_queue_nanos = 0;
+  decode_nanos = 0;
+  row_lock_wait_nanos = 0;
+  replicate_nanos = 0;
+  apply_queue_nanos = 0;
+  apply_nanos = 0;
+  apply_presence_check_nanos = 0;
+  apply_insert_nanos = 0;
+  apply_mutate_nanos = 0;
 }
 
 
@@ -40,6 +40,7 @@
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/memory/arena.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 
 namespace google {
@@ -64,6 +65,48 @@ struct TransactionMetrics {
   int successful_updates;
   int successful_deletes;
   uint64_t commit_wait_duration_usec;
+
+  // The time spent in each stage of the transaction, in nanoseconds.
+  //
+  // Waiting in the queue of the prepare pool.
+  int64_t prepare_queue_nanos;
+  // Decoding the row operations of a write.
+  int64_t decode_nanos;
+  // Acquiring the row locks of a write.
+  int64_t row_lock_wait_nanos;
+  // Replicating the transaction to a majority of the replicas.
+  int64_t replicate_nanos;
+  // Waiting in the queue of the apply pool.
+  int64_t apply_queue_nanos;
+  // Applying the transaction, of which the following are parts for writes.
+  int64_t apply_nanos;
+  // Checking which rowsets hold the rows of the operations, e.g. probing
+  // their bloom filters.
+  int64_t apply_presence_check_nanos;
+  // Inserting rows, usually into the MemRowSet.
+  int64_t apply_insert_nanos;
+  // Updating and deleting rows, e.g. in the DeltaMemStores.
+  int64_t apply_mutate_nanos;
+};
+
+// Adds the time spent in its scope to one of the stage times of
+// TransactionMetrics, e.g. &metrics->decode_nanos.
+class ScopedAddTransactionStageTime {
+ public:
+  explicit ScopedAddTransactionStageTime(int64_t* nanos)
+      : nanos_(nanos),
+        start_(MonoTime::Now()) {
+  }
+
+  ~ScopedAddTransactionStageTime() {
+    *nanos_ += (MonoTime::Now() - start_).ToNanoseconds();
+  }
+
+ private:
+  int64_t* const nanos_;
+  const MonoTime start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedAddTransactionStageTime);
 };
 
 // Base class for transactions.
@@ -104,6 +147,14 @@ class Transaction {
   // Builds the ReplicateMsg for this transaction.
   virtual void NewReplicateMsg(std::unique_ptr<consensus::ReplicateMsg>* replicate_msg) = 0;
 
+  // Does the part of the prepare phase which doesn't depend on the
+  // transactions prepared before this one, e.g. decoding the request, so that
+  // Prepare() has less to do. Unlike Prepare(), which runs in the order the
+  // transactions were submitted, this may run concurrently with the Prepare()
+  // of other transactions of the tablet. It's called at most once, before
+  // Prepare(); errors are left for Prepare() to report.
+  virtual void PrePrepare() {}
+
   // Executes the prepare phase of this transaction, the actual actions
   // of this phase depend on the transaction type, but usually are limited
   // to what can be done without actually changing data structures and without
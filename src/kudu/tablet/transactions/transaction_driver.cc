@@ -23,6 +23,7 @@
 #include <ostream>
 #include <utility>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
@@ -40,16 +41,26 @@
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/tablet/mvcc.h"
 #include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tablet/transaction_order_verifier.h"
 #include "kudu/tablet/transactions/transaction_tracker.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status_callback.h"
 #include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
+DEFINE_bool(concurrent_pre_prepare, true,
+            "Whether to decode write requests concurrently, ahead of preparing "
+            "them in order, so that a single tablet's writes can use more than "
+            "one core to prepare. Requests are decoded again while prepared if "
+            "the schema changed in between.");
+TAG_FLAG(concurrent_pre_prepare, advanced);
+TAG_FLAG(concurrent_pre_prepare, runtime);
+
 using kudu::consensus::CommitMsg;
 using kudu::consensus::DriverType;
 using kudu::consensus::RaftConsensus;
@@ -105,18 +116,22 @@ TransactionDriver::TransactionDriver(TransactionTracker *txn_tracker,
                                      RaftConsensus* consensus,
                                      Log* log,
                                      ThreadPoolToken* prepare_pool_token,
+                                     ThreadPoolToken* pre_prepare_pool_token,
                                      ThreadPool* apply_pool,
                                      TransactionOrderVerifier* order_verifier)
     : txn_tracker_(txn_tracker),
       consensus_(consensus),
       log_(log),
       prepare_pool_token_(prepare_pool_token),
+      pre_prepare_pool_token_(pre_prepare_pool_token),
       apply_pool_(apply_pool),
       order_verifier_(order_verifier),
       trace_(new Trace()),
       start_time_(MonoTime::Now()),
       replication_state_(NOT_REPLICATING),
-      prepare_state_(NOT_PREPARED) {
+      prepare_state_(NOT_PREPARED),
+      pre_prepare_started_(false),
+      pre_prepared_(1) {
   if (Trace::CurrentTrace()) {
     Trace::CurrentTrace()->AddChildTrace("txn", trace_.get());
   }
@@ -222,10 +237,23 @@ Status TransactionDriver::ExecuteAsync() {
   }
 
   if (s.ok()) {
+    prepare_submit_time_ = MonoTime::Now();
+    if (pre_prepare_pool_token_ && FLAGS_concurrent_pre_prepare) {
+      // The task holds a reference since it may outlive the transaction, if
+      // PrepareTask() ran PrePrepare() itself. If it can't be submitted,
+      // PrepareTask() runs PrePrepare() instead.
+      scoped_refptr<TransactionDriver> self(this);
+      WARN_NOT_OK(pre_prepare_pool_token_->Submit([self]() { self->PrePrepare(false); }),
+                  "Failed to submit pre-prepare task");
+    }
     s = prepare_pool_token_->Submit([this]() { this->PrepareTask(); });
   }
 
   if (!s.ok()) {
+    // Keep a pending pre-prepare task from running on the failed transaction.
+    if (pre_prepare_started_.exchange(true)) {
+      pre_prepared_.Wait();
+    }
     HandleFailure(s);
   }
 
@@ -233,8 +261,25 @@ Status TransactionDriver::ExecuteAsync() {
   return Status::OK();
 }
 
+void TransactionDriver::PrePrepare(bool wait) {
+  if (pre_prepare_started_.exchange(true)) {
+    if (wait) {
+      pre_prepared_.Wait();
+    }
+    return;
+  }
+  ADOPT_TRACE(trace());
+  transaction_->PrePrepare();
+  pre_prepared_.CountDown();
+}
+
 void TransactionDriver::PrepareTask() {
   TRACE_EVENT_FLOW_END0("txn", "PrepareTask", this);
+  mutable_state()->mutable_metrics()->prepare_queue_nanos =
+      (MonoTime::Now() - prepare_submit_time_).ToNanoseconds();
+  // Unless already done concurrently, do the transaction's pre-prepare work
+  // here. Waiting for it is safe since it's then running on another thread.
+  PrePrepare(true);
   Status prepare_status = Prepare();
   if (PREDICT_FALSE(!prepare_status.ok())) {
     HandleFailure(prepare_status);
@@ -430,6 +475,7 @@ void TransactionDriver::ReplicationFinished(const Status& status) {
   }
 
   TRACE_COUNTER_INCREMENT("replication_time_us", replication_duration.ToMicroseconds());
+  mutable_state()->mutable_metrics()->replicate_nanos = replication_duration.ToNanoseconds();
   TRACE("REPLICATION: Finished.");
 
   // If we have prepared and replicated, we're ready
@@ -488,12 +534,15 @@ Status TransactionDriver::ApplyAsync() {
   }
 
   TRACE_EVENT_FLOW_BEGIN0("txn", "ApplyTask", this);
+  apply_submit_time_ = MonoTime::Now();
   return apply_pool_->Submit([this]() { this->ApplyTask(); });
 }
 
 void TransactionDriver::ApplyTask() {
   TRACE_EVENT_FLOW_END0("txn", "ApplyTask", this);
   ADOPT_TRACE(trace());
+  mutable_state()->mutable_metrics()->apply_queue_nanos =
+      (MonoTime::Now() - apply_submit_time_).ToNanoseconds();
   Tablet* tablet = state()->tablet_replica()->tablet();
   if (tablet->HasBeenStopped()) {
     HandleFailure(Status::IllegalState("Not Applying transaction; the tablet is stopped"));
@@ -519,6 +568,7 @@ void TransactionDriver::ApplyTask() {
       HandleFailure(s);
       return;
     }
+    apply_finish_time_ = MonoTime::Now();
     commit_msg->mutable_commited_op_id()->CopyFrom(op_id_copy_);
     SetResponseTimestamp(transaction_->state(), transaction_->state()->timestamp());
 
@@ -575,6 +625,14 @@ void TransactionDriver::Finalize() {
   std::lock_guard<simple_spinlock> lock(lock_);
   transaction_->Finish(Transaction::COMMITTED);
   mutable_state()->completion_callback()->TransactionCompleted();
+  if (transaction_->tx_type() == Transaction::WRITE_TXN &&
+      transaction_->type() == consensus::LEADER) {
+    TabletMetrics* metrics = state()->tablet_replica()->tablet()->metrics();
+    if (metrics) {
+      metrics->write_response_duration->Increment(
+          (MonoTime::Now() - apply_finish_time_).ToMicroseconds());
+    }
+  }
   txn_tracker_->Release(this);
 }
 
@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -27,6 +28,7 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/tablet/transactions/transaction.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
@@ -224,10 +226,15 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
  public:
   // Construct TransactionDriver. TransactionDriver does not take ownership
   // of any of the objects pointed to in the constructor's arguments.
+  //
+  // Transactions are prepared in the order they're submitted using the serial
+  // 'prepare_pool_token'. If set, the concurrent 'pre_prepare_pool_token' is
+  // used to run Transaction::PrePrepare() ahead of that.
   TransactionDriver(TransactionTracker* txn_tracker,
                     consensus::RaftConsensus* consensus,
                     log::Log* log,
                     ThreadPoolToken* prepare_pool_token,
+                    ThreadPoolToken* pre_prepare_pool_token,
                     ThreadPool* apply_pool,
                     TransactionOrderVerifier* order_verifier);
 
@@ -307,6 +314,10 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
   // calls HandleFailure.
   void PrepareTask();
 
+  // Runs Transaction::PrePrepare() unless it was already started by another
+  // thread, in which case, if 'wait' is set, waits for it to finish.
+  void PrePrepare(bool wait);
+
   // Actually prepare.
   Status Prepare();
 
@@ -353,6 +364,7 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
   consensus::RaftConsensus* const consensus_;
   log::Log* const log_;
   ThreadPoolToken* const prepare_pool_token_;
+  ThreadPoolToken* const pre_prepare_pool_token_;
   ThreadPool* const apply_pool_;
   TransactionOrderVerifier* const order_verifier_;
 
@@ -381,10 +393,20 @@ class TransactionDriver : public RefCountedThreadSafe<TransactionDriver> {
 
   const MonoTime start_time_;
   MonoTime replication_start_time_;
+  // When the transaction was submitted to the prepare and apply pools, and
+  // when it finished applying. Used to measure the stages of the transaction.
+  MonoTime prepare_submit_time_;
+  MonoTime apply_submit_time_;
+  MonoTime apply_finish_time_;
 
   ReplicationState replication_state_;
   PrepareState prepare_state_;
 
+  // Set by the first thread to start Transaction::PrePrepare().
+  std::atomic<bool> pre_prepare_started_;
+  // Counted down once Transaction::PrePrepare() has finished.
+  CountDownLatch pre_prepared_;
+
   // The system monotonic time when the operation was prepared.
   // This is used for debugging only, not any actual operation ordering.
   MicrosecondsInt64 prepare_physical_timestamp_;
@@ -116,6 +116,7 @@ class TransactionTrackerTest : public KuduTest,
                                 nullptr,
                                 nullptr,
                                 nullptr,
+                                nullptr,
                                 nullptr));
       unique_ptr<NoOpTransaction> tx(new NoOpTransaction(new NoOpTransactionState));
       RETURN_NOT_OK(driver->Init(std::move(tx), consensus::LEADER));
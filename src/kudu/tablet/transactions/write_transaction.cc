@@ -109,6 +109,7 @@ void AddWritePrivilegesForRowOperations(const RowOperationsPB::Type& op_type,
       InsertIfNotPresent(privileges, WritePrivilegeType::UPDATE);
       break;
     case RowOperationsPB::DELETE:
+    case RowOperationsPB::DELETE_RANGE:
       InsertIfNotPresent(privileges, WritePrivilegeType::DELETE);
       break;
     default:
@@ -146,24 +147,43 @@ void WriteTransaction::NewReplicateMsg(unique_ptr<ReplicateMsg>* replicate_msg)
   }
 }
 
+void WriteTransaction::PrePrepare() {
+  TRACE_EVENT0("txn", "WriteTransaction::PrePrepare");
+  // Errors are ignored here: Prepare() decodes again and reports them.
+  if (!SchemaFromPB(state_->request()->schema(), &client_schema_).ok() ||
+      client_schema_.has_column_ids()) {
+    return;
+  }
+  client_schema_decoded_ = true;
+
+  ScopedAddTransactionStageTime decode_time(&state()->mutable_metrics()->decode_nanos);
+  state()->tablet_replica()->tablet()->PredecodeWriteOperations(&client_schema_, state());
+}
+
 Status WriteTransaction::Prepare() {
   TRACE_EVENT0("txn", "WriteTransaction::Prepare");
   TRACE("PREPARE: Starting.");
   // Decode everything first so that we give up if something major is wrong.
-  Schema client_schema;
-  RETURN_NOT_OK_PREPEND(SchemaFromPB(state_->request()->schema(), &client_schema),
-                        "Cannot decode client schema");
-  if (client_schema.has_column_ids()) {
-    // TODO(unknown): we have this kind of code a lot - add a new SchemaFromPB variant which
-    // does this check inline.
-    Status s = Status::InvalidArgument("User requests should not have Column IDs");
-    state_->completion_callback()->set_error(s, TabletServerErrorPB::INVALID_SCHEMA);
-    return s;
+  if (!client_schema_decoded_) {
+    RETURN_NOT_OK_PREPEND(SchemaFromPB(state_->request()->schema(), &client_schema_),
+                          "Cannot decode client schema");
+    if (client_schema_.has_column_ids()) {
+      // TODO(unknown): we have this kind of code a lot - add a new SchemaFromPB variant which
+      // does this check inline.
+      Status s = Status::InvalidArgument("User requests should not have Column IDs");
+      state_->completion_callback()->set_error(s, TabletServerErrorPB::INVALID_SCHEMA);
+      return s;
+    }
   }
 
   Tablet* tablet = state()->tablet_replica()->tablet();
+  TransactionMetrics* tx_metrics = state()->mutable_metrics();
 
-  Status s = tablet->DecodeWriteOperations(&client_schema, state());
+  Status s;
+  {
+    ScopedAddTransactionStageTime decode_time(&tx_metrics->decode_nanos);
+    s = tablet->DecodeWriteOperations(&client_schema_, state());
+  }
   if (!s.ok()) {
     // TODO(unknown): is MISMATCHED_SCHEMA always right here? probably not.
     state()->completion_callback()->set_error(s, TabletServerErrorPB::MISMATCHED_SCHEMA);
@@ -181,7 +201,10 @@ Status WriteTransaction::Prepare() {
   }
 
   // Now acquire row locks and prepare everything for apply
-  RETURN_NOT_OK(tablet->AcquireRowLocks(state()));
+  {
+    ScopedAddTransactionStageTime row_lock_time(&tx_metrics->row_lock_wait_nanos);
+    RETURN_NOT_OK(tablet->AcquireRowLocks(state()));
+  }
 
   TRACE("PREPARE: Finished.");
   return Status::OK();
@@ -231,8 +254,12 @@ Status WriteTransaction::Apply(unique_ptr<CommitMsg>* commit_msg) {
     SleepFor(MonoDelta::FromMilliseconds(FLAGS_tablet_inject_latency_on_apply_write_txn_ms));
   }
 
-  Tablet* tablet = state()->tablet_replica()->tablet();
-  RETURN_NOT_OK(tablet->ApplyRowOperations(state()));
+  TabletReplica* replica = state()->tablet_replica();
+  Tablet* tablet = replica->tablet();
+  {
+    ScopedAddTransactionStageTime apply_time(&state()->mutable_metrics()->apply_nanos);
+    RETURN_NOT_OK(tablet->ApplyRowOperations(state(), replica->apply_pool()));
+  }
   TRACE("APPLY: Finished.");
 
   UpdatePerRowErrors();
@@ -285,6 +312,21 @@ void WriteTransaction::Finish(TransactionResult result) {
         case UNKNOWN_EXTERNAL_CONSISTENCY_MODE:
           break;
       }
+
+      const TransactionMetrics& tx_metrics = state_->metrics();
+      const auto record = [](const scoped_refptr<Histogram>& histogram, int64_t nanos) {
+        histogram->Increment(nanos / MonoTime::kNanosecondsPerMicrosecond);
+      };
+      record(metrics->write_prepare_queue_duration, tx_metrics.prepare_queue_nanos);
+      record(metrics->write_decode_duration, tx_metrics.decode_nanos);
+      record(metrics->write_row_lock_wait_duration, tx_metrics.row_lock_wait_nanos);
+      record(metrics->write_replicate_duration, tx_metrics.replicate_nanos);
+      record(metrics->write_apply_queue_duration, tx_metrics.apply_queue_nanos);
+      record(metrics->write_apply_duration, tx_metrics.apply_nanos);
+      record(metrics->write_apply_presence_check_duration,
+             tx_metrics.apply_presence_check_nanos);
+      record(metrics->write_apply_insert_duration, tx_metrics.apply_insert_nanos);
+      record(metrics->write_apply_mutate_duration, tx_metrics.apply_mutate_nanos);
     }
   }
 }
@@ -338,9 +380,18 @@ void WriteTransactionState::AcquireSchemaLock(rw_semaphore* schema_lock) {
   TRACE("Acquired schema lock");
 }
 
+void WriteTransactionState::AcquireSchemaLockExclusive(rw_semaphore* schema_lock) {
+  TRACE("Acquiring schema lock in exclusive mode");
+  exclusive_schema_lock_ = std::unique_lock<rw_semaphore>(*schema_lock);
+  TRACE("Acquired schema lock");
+}
+
 void WriteTransactionState::ReleaseSchemaLock() {
   shared_lock<rw_semaphore> temp;
   schema_lock_.swap(temp);
+  if (exclusive_schema_lock_.owns_lock()) {
+    exclusive_schema_lock_.unlock();
+  }
   TRACE("Released schema lock");
 }
 
@@ -369,6 +420,25 @@ void WriteTransactionState::SetRowOps(vector<DecodedRowOperation> decoded_ops) {
   }
 }
 
+void WriteTransactionState::SetPredecodedOps(const Schema* schema,
+                                             vector<DecodedRowOperation> decoded_ops) {
+  std::lock_guard<simple_spinlock> l(txn_state_lock_);
+  predecode_schema_ = schema;
+  predecoded_ops_ = std::move(decoded_ops);
+}
+
+bool WriteTransactionState::TakePredecodedOps(const Schema* schema,
+                                              vector<DecodedRowOperation>* decoded_ops) {
+  std::lock_guard<simple_spinlock> l(txn_state_lock_);
+  if (predecode_schema_ == nullptr || predecode_schema_ != schema) {
+    return false;
+  }
+  *decoded_ops = std::move(predecoded_ops_);
+  predecoded_ops_.clear();
+  predecode_schema_ = nullptr;
+  return true;
+}
+
 void WriteTransactionState::StartApplying() {
   CHECK_NOTNULL(mvcc_tx_.get())->StartApplying();
 }
@@ -431,6 +501,7 @@ void WriteTransactionState::UpdateMetricsForOp(const RowOp& op) {
       tx_metrics_.successful_updates++;
       break;
     case RowOperationsPB::DELETE:
+    case RowOperationsPB::DELETE_RANGE:
       tx_metrics_.successful_deletes++;
       break;
     case RowOperationsPB::UNKNOWN:
@@ -439,6 +510,7 @@ void WriteTransactionState::UpdateMetricsForOp(const RowOp& op) {
     case RowOperationsPB::RANGE_UPPER_BOUND:
     case RowOperationsPB::INCLUSIVE_RANGE_UPPER_BOUND:
     case RowOperationsPB::EXCLUSIVE_RANGE_LOWER_BOUND:
+    case RowOperationsPB::DELETE_RANGE_UPPER_BOUND:
       break;
   }
 }
@@ -447,6 +519,10 @@ void WriteTransactionState::ReleaseRowLocks() {
   // free the row locks
   for (RowOp* op : row_ops_) {
     op->row_lock.Release();
+    // The write is committed or aborted by now, so the row cache may cache
+    // the row again.
+    op->row_cache_write.Release(has_timestamp() ? boost::make_optional(timestamp())
+                                                : boost::optional<Timestamp>());
   }
 }
 
@@ -27,6 +27,7 @@
 #include <glog/logging.h>
 
 #include "kudu/common/row_operations.h"
+#include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/consensus/consensus.pb.h"
 #include "kudu/gutil/macros.h"
@@ -162,6 +163,11 @@ class WriteTransactionState : public TransactionState {
   // the writes.
   void AcquireSchemaLock(rw_semaphore* schema_lock);
 
+  // Take an exclusive lock on the given schema lock, which must not be held
+  // already. Transactions with DELETE_RANGE operations take it so that they
+  // are serialized with all other writes.
+  void AcquireSchemaLockExclusive(rw_semaphore* schema_lock);
+
   // Release the already-acquired schema lock.
   void ReleaseSchemaLock();
 
@@ -214,6 +220,14 @@ class WriteTransactionState : public TransactionState {
   // Set the 'row_ops' member based on the given decoded operations.
   void SetRowOps(std::vector<DecodedRowOperation> decoded_ops);
 
+  // Stores operations decoded against the tablet schema 'schema' before the
+  // schema lock was taken, see Tablet::PredecodeWriteOperations().
+  void SetPredecodedOps(const Schema* schema, std::vector<DecodedRowOperation> decoded_ops);
+
+  // If operations were predecoded against the tablet schema 'schema', moves
+  // them to 'decoded_ops' and returns true. Otherwise returns false.
+  bool TakePredecodedOps(const Schema* schema, std::vector<DecodedRowOperation>* decoded_ops);
+
   void UpdateMetricsForOp(const RowOp& op);
 
   // Resets this TransactionState, releasing all locks, destroying all prepared
@@ -262,6 +276,7 @@ class WriteTransactionState : public TransactionState {
   // A lock held on the tablet's schema. Prevents concurrent schema change
   // from racing with a write.
   shared_lock<rw_semaphore> schema_lock_;
+  std::unique_lock<rw_semaphore> exclusive_schema_lock_;
 
   // The Schema of the tablet when the transaction was first decoded.
   // This is verified at APPLY time to ensure we don't have races against
@@ -269,6 +284,11 @@ class WriteTransactionState : public TransactionState {
   // Protected by superclass's txn_state_lock_.
   const Schema* schema_at_decode_time_;
 
+  // The operations decoded before the schema lock was taken, and the tablet
+  // schema they were decoded against.
+  const Schema* predecode_schema_ = nullptr;
+  std::vector<DecodedRowOperation> predecoded_ops_;
+
   DISALLOW_COPY_AND_ASSIGN(WriteTransactionState);
 };
 
@@ -292,6 +312,10 @@ class WriteTransaction : public Transaction {
   // or isn't authorized.
   Status Prepare() override;
 
+  // Decodes the client schema and the operations in the request, so that
+  // Prepare() only has to decode them if the tablet schema changed since.
+  void PrePrepare() override;
+
   void AbortPrepare() override;
 
   // Actually starts the Mvcc transaction and assigns a timestamp to this transaction.
@@ -329,6 +353,10 @@ class WriteTransaction : public Transaction {
   // this transaction's start time
   MonoTime start_time_;
 
+  // The client schema of the request, if decoded by PrePrepare().
+  Schema client_schema_;
+  bool client_schema_decoded_ = false;
+
   std::unique_ptr<WriteTransactionState> state_;
 
  private:
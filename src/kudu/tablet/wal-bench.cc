@@ -0,0 +1,444 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks the write-ahead log: appends write operations to the logs of
+// several tablets at once through the real Log, then replays each of the
+// logs with the tablet bootstrap.
+//
+// Unlike wal_hiccup, which measures the latency of the fsyncs of a synthetic
+// writer, this goes through the group commit of the Log, so the logs are
+// written with the same batching, compression (see --log_compression_codec)
+// and segment rolls as in a tablet server. For the appends, the throughput,
+// the number of batches committed per group and the distribution of the
+// fsync latencies are logged; for the bootstrap, the replay throughput.
+// The results may also be appended to a file as one JSON object per line
+// with --wal_bench_results_file.
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/partition.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/wire_protocol-test-util.h"
+#include "kudu/common/wire_protocol.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus_meta.h"
+#include "kudu/consensus/consensus_meta_manager.h"
+#include "kudu/consensus/log-test-base.h"
+#include "kudu/consensus/log.h"
+#include "kudu/consensus/log_anchor_registry.h"
+#include "kudu/consensus/metadata.pb.h"
+#include "kudu/consensus/opid_util.h"
+#include "kudu/consensus/raft_consensus.h"
+#include "kudu/consensus/ref_counted_replicate.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/rpc/result_tracker.h"
+#include "kudu/tablet/metadata.pb.h"
+#include "kudu/tablet/tablet-harness.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_bootstrap.h"
+#include "kudu/tablet/tablet_metadata.h"
+#include "kudu/tablet/tablet_replica.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/jsonwriter.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_macros.h"
+
+DEFINE_int32(wal_bench_num_tablets, 4,
+             "Number of tablets whose logs are appended to concurrently");
+DEFINE_int32(wal_bench_batches_per_tablet, 2000,
+             "Number of batches of operations appended to the log of each tablet");
+DEFINE_int32(wal_bench_ops_per_batch, 8,
+             "Number of write operations in each batch appended to a log");
+DEFINE_int32(wal_bench_rows_per_op, 10,
+             "Number of rows inserted by each write operation");
+DEFINE_int32(wal_bench_value_size, 100,
+             "Size in bytes of the string value of each row");
+DEFINE_bool(wal_bench_fsync, true,
+            "Whether to fsync the logs on every group commit, as with "
+            "--log_force_fsync_all");
+DEFINE_string(wal_bench_results_file, "",
+              "If set, the results are appended to this file as one JSON "
+              "object per line");
+
+DECLARE_bool(log_force_fsync_all);
+DECLARE_string(log_compression_codec);
+
+METRIC_DECLARE_counter(log_bytes_logged);
+METRIC_DECLARE_histogram(log_entry_batches_per_group);
+METRIC_DECLARE_histogram(log_group_commit_latency);
+METRIC_DECLARE_histogram(log_sync_latency);
+
+using kudu::consensus::CommitMsg;
+using kudu::consensus::ConsensusBootstrapInfo;
+using kudu::consensus::ConsensusMetadata;
+using kudu::consensus::ConsensusMetadataManager;
+using kudu::consensus::MakeOpId;
+using kudu::consensus::ReplicateRefPtr;
+using kudu::consensus::kMinimumTerm;
+using kudu::consensus::make_scoped_refptr_replicate;
+using kudu::log::Log;
+using kudu::log::LogAnchorRegistry;
+using kudu::log::LogTestBase;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tablet {
+
+class WalBench : public LogTestBase {
+ public:
+  WalBench() {
+    FLAGS_log_force_fsync_all = FLAGS_wal_bench_fsync;
+  }
+
+  void SetUp() override {
+    NO_FATALS(LogTestBase::SetUp());
+    cmeta_manager_.reset(new ConsensusMetadataManager(fs_manager_.get()));
+    for (int i = 0; i < FLAGS_wal_bench_num_tablets; i++) {
+      tablet_ids_.emplace_back(Substitute("wal-bench-tablet-$0", i));
+    }
+  }
+
+ protected:
+  // The operations appended to the log of one tablet.
+  struct TabletOps {
+    vector<vector<ReplicateRefPtr>> replicate_batches;
+    vector<unique_ptr<CommitMsg>> commits;
+  };
+
+  Status CreateTablet(const string& tablet_id) {
+    const Schema schema = SchemaBuilder(schema_).Build();
+    const auto partition = CreateDefaultPartition(schema);
+    scoped_refptr<TabletMetadata> meta;
+    RETURN_NOT_OK(TabletMetadata::LoadOrCreate(fs_manager_.get(),
+                                               tablet_id,
+                                               log::kTestTable,
+                                               log::kTestTableId,
+                                               schema,
+                                               partition.first,
+                                               partition.second,
+                                               TABLET_DATA_READY,
+                                               /*tombstone_last_logged_opid=*/ boost::none,
+                                               /*extra_config=*/ boost::none,
+                                               /*dimension_label=*/ boost::none,
+                                               &meta));
+    consensus::RaftConfigPB config;
+    config.set_opid_index(consensus::kInvalidOpIdIndex);
+    consensus::RaftPeerPB* peer = config.add_peers();
+    peer->set_permanent_uuid(fs_manager_->uuid());
+    peer->set_member_type(consensus::RaftPeerPB::VOTER);
+    return cmeta_manager_->Create(tablet_id, config, kMinimumTerm);
+  }
+
+  // Builds the operations appended to the log of 'tablet_id' ahead of time,
+  // so that building them isn't measured.
+  Status GenerateOps(const string& tablet_id, TabletOps* ops) {
+    const string value(FLAGS_wal_bench_value_size, 'x');
+    int64_t index = kStartIndex;
+    int32_t key = 0;
+    for (int b = 0; b < FLAGS_wal_bench_batches_per_tablet; b++) {
+      vector<ReplicateRefPtr> batch;
+      for (int o = 0; o < FLAGS_wal_bench_ops_per_batch; o++) {
+        const consensus::OpId opid = MakeOpId(1, index++);
+        ReplicateRefPtr replicate = make_scoped_refptr_replicate(new consensus::ReplicateMsg);
+        replicate->get()->set_op_type(consensus::WRITE_OP);
+        replicate->get()->mutable_id()->CopyFrom(opid);
+        replicate->get()->set_timestamp(clock_->Now().ToUint64());
+        tserver::WriteRequestPB* req = replicate->get()->mutable_write_request();
+        RETURN_NOT_OK(SchemaToPB(schema_, req->mutable_schema()));
+        req->set_tablet_id(tablet_id);
+
+        unique_ptr<CommitMsg> commit(new CommitMsg);
+        commit->set_op_type(consensus::WRITE_OP);
+        commit->mutable_commited_op_id()->CopyFrom(opid);
+        for (int r = 0; r < FLAGS_wal_bench_rows_per_op; r++) {
+          AddTestRowToPB(RowOperationsPB::INSERT, schema_, key++, r, value,
+                         req->mutable_row_operations());
+          // Target an unflushed MemRowSet so that the bootstrap replays the row.
+          commit->mutable_result()->add_ops()->add_mutated_stores()->set_mrs_id(1);
+        }
+        batch.emplace_back(std::move(replicate));
+        ops->commits.emplace_back(std::move(commit));
+      }
+      ops->replicate_batches.emplace_back(std::move(batch));
+    }
+    return Status::OK();
+  }
+
+  // Appends 'ops' to 'log' without waiting for the appends to complete
+  // before issuing the next ones, so that they get grouped.
+  static void AppendOps(Log* log, TabletOps* ops, Status* status) {
+    const int64_t num_appends = ops->replicate_batches.size() + ops->commits.size();
+    CountDownLatch latch(num_appends);
+    Status first_error;
+    std::mutex error_lock;
+    auto cb = [&](const Status& s) {
+      if (!s.ok()) {
+        std::lock_guard<std::mutex> l(error_lock);
+        if (first_error.ok()) first_error = s;
+      }
+      latch.CountDown();
+    };
+    const int ops_per_batch = FLAGS_wal_bench_ops_per_batch;
+    int64_t num_issued = 0;
+    Status s;
+    for (int b = 0; s.ok() && b < ops->replicate_batches.size(); b++) {
+      s = log->AsyncAppendReplicates(ops->replicate_batches[b], cb);
+      for (int o = 0; s.ok() && o < ops_per_batch; o++) {
+        num_issued++;
+        s = log->AsyncAppendCommit(std::move(ops->commits[b * ops_per_batch + o]), cb);
+      }
+      if (s.ok()) {
+        num_issued++;
+      }
+    }
+    // The appends which weren't issued have no callback to count down.
+    for (; num_issued < num_appends; num_issued++) {
+      latch.CountDown();
+    }
+    latch.Wait();
+    *status = s.ok() ? first_error : s;
+  }
+
+  // Returns the merge of the histograms of 'proto' of all the tablets.
+  unique_ptr<HdrHistogram> MergeHistograms(HistogramPrototype* proto) {
+    unique_ptr<HdrHistogram> merged;
+    for (const auto& entity : entities_) {
+      const HdrHistogram* hist = proto->Instantiate(entity)->histogram();
+      if (!merged) {
+        merged.reset(new HdrHistogram(*hist));
+      } else {
+        merged->MergeFrom(*hist);
+      }
+    }
+    return merged;
+  }
+
+  void ReportAppend(const CpuTimes& times, int64_t bytes_logged) {
+    const int64_t num_ops = static_cast<int64_t>(FLAGS_wal_bench_num_tablets) *
+        FLAGS_wal_bench_batches_per_tablet * FLAGS_wal_bench_ops_per_batch;
+    const double ops_per_sec = num_ops / times.wall_seconds();
+    const double mb_per_sec = bytes_logged / 1e6 / times.wall_seconds();
+    const auto batches_per_group_hist = MergeHistograms(&METRIC_log_entry_batches_per_group);
+    const auto group_commit_us_hist = MergeHistograms(&METRIC_log_group_commit_latency);
+    const auto sync_us_hist = MergeHistograms(&METRIC_log_sync_latency);
+    const HdrHistogram& batches_per_group = *batches_per_group_hist;
+    const HdrHistogram& group_commit_us = *group_commit_us_hist;
+    const HdrHistogram& sync_us = *sync_us_hist;
+    LOG(INFO) << Substitute(
+        "append: $0, $1 ops/s, $2 MB/s, $3 batches/group, $4 ops/fsync, "
+        "group commit p99 $5 us, fsync p50 $6 us, p99 $7 us, p99.9 $8 us, max $9 us",
+        times.ToString(), StringPrintf("%.0f", ops_per_sec), StringPrintf("%.1f", mb_per_sec),
+        StringPrintf("%.2f", batches_per_group.MeanValue()),
+        StringPrintf("%.1f", sync_us.TotalCount() > 0 ?
+                     static_cast<double>(num_ops) / sync_us.TotalCount() : 0),
+        group_commit_us.ValueAtPercentile(99), sync_us.ValueAtPercentile(50),
+        sync_us.ValueAtPercentile(99), sync_us.ValueAtPercentile(99.9), sync_us.MaxValue());
+
+    NO_FATALS(WriteResult("append", [&](JsonWriter* jw) {
+      jw->String("wall_seconds");
+      jw->Double(times.wall_seconds());
+      jw->String("user_cpu_seconds");
+      jw->Double(times.user_cpu_seconds());
+      jw->String("system_cpu_seconds");
+      jw->Double(times.system_cpu_seconds());
+      jw->String("bytes_logged");
+      jw->Int64(bytes_logged);
+      jw->String("ops_per_sec");
+      jw->Double(ops_per_sec);
+      jw->String("mb_per_sec");
+      jw->Double(mb_per_sec);
+      jw->String("mean_batches_per_group");
+      jw->Double(batches_per_group.MeanValue());
+      jw->String("num_fsyncs");
+      jw->Int64(sync_us.TotalCount());
+      jw->String("group_commit_p99_us");
+      jw->Int64(group_commit_us.ValueAtPercentile(99));
+      jw->String("fsync_p50_us");
+      jw->Int64(sync_us.ValueAtPercentile(50));
+      jw->String("fsync_p99_us");
+      jw->Int64(sync_us.ValueAtPercentile(99));
+      jw->String("fsync_p999_us");
+      jw->Int64(sync_us.ValueAtPercentile(99.9));
+      jw->String("fsync_max_us");
+      jw->Int64(sync_us.MaxValue());
+    }));
+  }
+
+  void ReportBootstrap(const CpuTimes& times, int64_t bytes_logged, int64_t rows_replayed) {
+    const double rows_per_sec = rows_replayed / times.wall_seconds();
+    const double mb_per_sec = bytes_logged / 1e6 / times.wall_seconds();
+    LOG(INFO) << Substitute("bootstrap: $0, $1 rows/s, $2 MB/s of log",
+                            times.ToString(), StringPrintf("%.0f", rows_per_sec),
+                            StringPrintf("%.1f", mb_per_sec));
+
+    NO_FATALS(WriteResult("bootstrap", [&](JsonWriter* jw) {
+      jw->String("wall_seconds");
+      jw->Double(times.wall_seconds());
+      jw->String("user_cpu_seconds");
+      jw->Double(times.user_cpu_seconds());
+      jw->String("system_cpu_seconds");
+      jw->Double(times.system_cpu_seconds());
+      jw->String("rows_replayed");
+      jw->Int64(rows_replayed);
+      jw->String("rows_per_sec");
+      jw->Double(rows_per_sec);
+      jw->String("mb_per_sec");
+      jw->Double(mb_per_sec);
+    }));
+  }
+
+  // Appends an object with the parameters of the benchmark and the results
+  // written by 'write_results' to --wal_bench_results_file.
+  void WriteResult(const string& phase, const std::function<void(JsonWriter*)>& write_results) {
+    if (FLAGS_wal_bench_results_file.empty()) {
+      return;
+    }
+    std::ostringstream json;
+    JsonWriter jw(&json, JsonWriter::COMPACT);
+    jw.StartObject();
+    jw.String("phase");
+    jw.String(phase);
+    jw.String("num_tablets");
+    jw.Int(FLAGS_wal_bench_num_tablets);
+    jw.String("batches_per_tablet");
+    jw.Int(FLAGS_wal_bench_batches_per_tablet);
+    jw.String("ops_per_batch");
+    jw.Int(FLAGS_wal_bench_ops_per_batch);
+    jw.String("rows_per_op");
+    jw.Int(FLAGS_wal_bench_rows_per_op);
+    jw.String("value_size");
+    jw.Int(FLAGS_wal_bench_value_size);
+    jw.String("fsync");
+    jw.Bool(FLAGS_wal_bench_fsync);
+    jw.String("compression_codec");
+    jw.String(FLAGS_log_compression_codec);
+    write_results(&jw);
+    jw.EndObject();
+    std::ofstream out(FLAGS_wal_bench_results_file, std::ios::app);
+    out << json.str() << std::endl;
+    ASSERT_TRUE(out.good()) << "unable to write to " << FLAGS_wal_bench_results_file;
+  }
+
+  scoped_refptr<ConsensusMetadataManager> cmeta_manager_;
+  vector<string> tablet_ids_;
+  vector<scoped_refptr<MetricEntity>> entities_;
+};
+
+TEST_F(WalBench, AppendAndBootstrap) {
+  const Schema schema_with_ids = SchemaBuilder(schema_).Build();
+  vector<scoped_refptr<Log>> logs;
+  vector<TabletOps> ops(tablet_ids_.size());
+  for (int i = 0; i < tablet_ids_.size(); i++) {
+    ASSERT_OK(CreateTablet(tablet_ids_[i]));
+    entities_.emplace_back(METRIC_ENTITY_tablet.Instantiate(metric_registry_.get(),
+                                                            tablet_ids_[i]));
+    scoped_refptr<Log> log;
+    ASSERT_OK(Log::Open(options_, fs_manager_.get(), file_cache_.get(), tablet_ids_[i],
+                        schema_with_ids, 0, entities_.back(), &log));
+    logs.emplace_back(std::move(log));
+    ASSERT_OK(GenerateOps(tablet_ids_[i], &ops[i]));
+  }
+
+  // Append to the logs of all the tablets at once, one thread per tablet.
+  vector<Status> statuses(tablet_ids_.size());
+  vector<std::thread> threads;
+  Stopwatch append_sw(Stopwatch::ALL_THREADS);
+  append_sw.start();
+  for (int i = 0; i < tablet_ids_.size(); i++) {
+    threads.emplace_back(&WalBench::AppendOps, logs[i].get(), &ops[i], &statuses[i]);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  append_sw.stop();
+  for (const auto& s : statuses) {
+    ASSERT_OK(s);
+  }
+  int64_t bytes_logged = 0;
+  for (const auto& entity : entities_) {
+    bytes_logged += METRIC_log_bytes_logged.Instantiate(entity)->value();
+  }
+  for (auto& log : logs) {
+    ASSERT_OK(log->Close());
+  }
+  logs.clear();
+  ops.clear();
+  NO_FATALS(ReportAppend(append_sw.elapsed(), bytes_logged));
+
+  // Replay the logs one tablet after the other.
+  Stopwatch bootstrap_sw(Stopwatch::ALL_THREADS);
+  int64_t rows_replayed = 0;
+  for (const auto& tablet_id : tablet_ids_) {
+    scoped_refptr<TabletMetadata> meta;
+    ASSERT_OK(TabletMetadata::Load(fs_manager_.get(), tablet_id, &meta));
+    scoped_refptr<ConsensusMetadata> cmeta;
+    ASSERT_OK(cmeta_manager_->Load(tablet_id, &cmeta));
+    shared_ptr<Tablet> tablet;
+    scoped_refptr<Log> log;
+    ConsensusBootstrapInfo boot_info;
+    bootstrap_sw.resume();
+    ASSERT_OK(BootstrapTablet(meta,
+                              cmeta->CommittedConfig(),
+                              clock_.get(),
+                              /*mem_tracker*/nullptr,
+                              /*result_tracker*/nullptr,
+                              metric_registry_.get(),
+                              file_cache_.get(),
+                              /*tablet_replica*/nullptr,
+                              make_scoped_refptr(new LogAnchorRegistry),
+                              &tablet,
+                              &log,
+                              &boot_info));
+    bootstrap_sw.stop();
+    ASSERT_TRUE(boot_info.orphaned_replicates.empty());
+    uint64_t num_rows;
+    ASSERT_OK(tablet->CountRows(&num_rows));
+    rows_replayed += num_rows;
+    ASSERT_OK(log->Close());
+  }
+  ASSERT_EQ(static_cast<int64_t>(FLAGS_wal_bench_num_tablets) *
+            FLAGS_wal_bench_batches_per_tablet * FLAGS_wal_bench_ops_per_batch *
+            FLAGS_wal_bench_rows_per_op, rows_replayed);
+  NO_FATALS(ReportBootstrap(bootstrap_sw.elapsed(), bytes_logged, rows_replayed));
+}
+
+} // namespace tablet
+} // namespace kudu
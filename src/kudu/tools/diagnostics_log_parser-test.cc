@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -81,6 +82,10 @@ TEST(DiagLogParserTest, TestParseLine) {
     ASSERT_OK(pl.Parse(line));
     ASSERT_EQ(RecordType::kSymbols, pl.type());
 
+    line = "I0220 17:38:09.950546 profile 1519177089950546 {\"foo\" : \"bar\"}";
+    ASSERT_OK(pl.Parse(line));
+    ASSERT_EQ(RecordType::kProfile, pl.type());
+
     line = "I0220 17:38:09.950546 metrics 1519177089950546 {\"foo\" : \"bar\"}";
     ASSERT_OK(pl.Parse(line));
     ASSERT_EQ(RecordType::kUnknown, pl.type());
@@ -121,6 +126,7 @@ class TestSymbolsLogVisitor : public LogVisitor {
   }
 
   void VisitStacksRecord(const StacksRecord& /*sr*/) override {}
+  void VisitProfileRecord(const ProfileRecord& /*pr*/) override {}
 
   string addr_;
   string symbol_;
@@ -150,6 +156,7 @@ class NoopLogVisitor : public LogVisitor {
  public:
   void VisitSymbol(const string& /*addr*/, const string& /*symbol*/) override {}
   void VisitStacksRecord(const StacksRecord& /*sr*/) override {}
+  void VisitProfileRecord(const ProfileRecord& /*pr*/) override {}
 };
 
 // For parsing stacks, we'll check for success or error only. The parse_stacks
@@ -232,5 +239,73 @@ TEST(DiagLogParserTest, TestParseStacks) {
   ASSERT_OK(lp.ParseLine(line));
 }
 
+TEST(DiagLogParserTest, TestParseProfile) {
+  NoopLogVisitor lv;
+  LogParser lp(&lv);
+
+  // The "samples" field must be present and an integer.
+  string line = "I0220 17:38:09.950546 profile 1519177089950546 {\"stacks\" : []}";
+  Status s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "expected an integer 'samples' field");
+
+  // The "stacks" field must be present and an array.
+  line = "I0220 17:38:09.950546 profile 1519177089950546 {\"samples\" : 1}";
+  s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "no 'stacks' field in profile object");
+
+  line = "I0220 17:38:09.950546 profile 1519177089950546 "
+         "{\"samples\" : 1, \"stacks\" : {}}";
+  s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "'stacks' field should be an array");
+
+  // A stack must have a category, a count and frames.
+  line = "I0220 17:38:09.950546 profile 1519177089950546 "
+         "{\"samples\" : 1, \"stacks\" : [{\"category\" : \"reactor\", \"stack\" : []}]}";
+  s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "expected profile stacks to have category, count and frames");
+
+  line = "I0220 17:38:09.950546 profile 1519177089950546 "
+         "{\"samples\" : 1, \"stacks\" : [{\"category\" : \"reactor\", "
+         "\"count\" : \"2\", \"stack\" : []}]}";
+  s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "expected 'count' to be an integer");
+
+  line = "I0220 17:38:09.950546 profile 1519177089950546 "
+         "{\"samples\" : 1, \"stacks\" : [{\"category\" : \"reactor\", "
+         "\"count\" : 2, \"stack\" : [5]}]}";
+  s = lp.ParseLine(line);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_STR_CONTAINS(s.ToString(), "expected 'stack' elements to be strings");
+
+  line = "I0220 17:38:09.950546 profile 1519177089950546 "
+         "{\"samples\" : 1, \"stacks\" : [{\"category\" : \"reactor\", "
+         "\"count\" : 2, \"stack\" : [\"0x1\"]}]}";
+  ASSERT_OK(lp.ParseLine(line));
+}
+
+TEST(DiagLogParserTest, TestFoldedStacks) {
+  stringstream out;
+  FoldedStacksLogVisitor lv(&out);
+  LogParser lp(&lv);
+
+  ASSERT_OK(lp.ParseLine("I0220 17:38:09.950546 symbols 1519177089950546 "
+                         "{\"0x1\" : \"epoll_wait\", \"0x2\" : \"RunThread()\"}"));
+  ASSERT_OK(lp.ParseLine("I0220 17:38:09.950546 profile 1519177089950546 "
+                         "{\"samples\" : 3, \"stacks\" : ["
+                         "{\"category\" : \"reactor\", \"count\" : 3, "
+                         "\"stack\" : [\"0x1\", \"0x2\"]},"
+                         "{\"category\" : \"apply\", \"count\" : 1, "
+                         "\"stack\" : [\"0x3\", \"0x2\"]}]}"));
+  // Frames are output outermost first, and unknown symbols as their address.
+  ASSERT_EQ("reactor;RunThread();epoll_wait 3\n"
+            "apply;RunThread();0x3 1\n",
+            out.str());
+}
+
 } // namespace tools
 } // namespace kudu
@@ -52,6 +52,7 @@ const char* RecordTypeToString(RecordType r) {
   switch (r) {
     case RecordType::kStacks: return "stacks"; break;
     case RecordType::kSymbols: return "symbols"; break;
+    case RecordType::kProfile: return "profile"; break;
     case RecordType::kUnknown: return "<unknown>"; break;
   }
   return "<unreachable>";
@@ -85,6 +86,22 @@ void StackDumpingLogVisitor::VisitStacksRecord(const StacksRecord& sr) {
   }
 }
 
+void FoldedStacksLogVisitor::VisitSymbol(const string& addr, const string& symbol) {
+  InsertIfNotPresent(&symbols_, addr, symbol);
+}
+
+void FoldedStacksLogVisitor::VisitProfileRecord(const ProfileRecord& pr) {
+  for (const auto& stack : pr.stacks) {
+    *out_ << stack.category;
+    // Folded stacks list the outermost frame first.
+    for (auto it = stack.frame_addrs.rbegin(); it != stack.frame_addrs.rend(); ++it) {
+      // Unknown symbols are output as their address.
+      *out_ << ";" << FindWithDefault(symbols_, *it, *it);
+    }
+    *out_ << " " << stack.count << endl;
+  }
+}
+
 Status ParsedLine::Parse(string line) {
   // Take ownership of the line to avoid copying substrings.
   line_ = std::move(line);
@@ -120,6 +137,8 @@ Status ParsedLine::Parse(string line) {
     type_ = RecordType::kSymbols;
   } else if (fields[2] == "stacks") {
     type_ = RecordType::kStacks;
+  } else if (fields[2] == "profile") {
+    type_ = RecordType::kProfile;
   } else {
     type_ = RecordType::kUnknown;
   }
@@ -145,6 +164,9 @@ Status LogParser::ParseLine(string line) {
       RETURN_NOT_OK(ParseStacks(pl));
       break;
     }
+    case RecordType::kProfile:
+      RETURN_NOT_OK(ParseProfile(pl));
+      break;
     default:
       break;
   }
@@ -248,6 +270,77 @@ Status LogParser::ParseStacks(const ParsedLine& pl) {
   return Status::OK();
 }
 
+Status LogParser::ParseProfileStack(const rapidjson::Value& stack_json,
+                                    ProfileRecord::Stack* stack) {
+  DCHECK(stack);
+  ProfileRecord::Stack ret;
+  if (PREDICT_FALSE(!stack_json.IsObject())) {
+    return Status::InvalidArgument("expected profile stacks to be JSON objects");
+  }
+  if (!stack_json.HasMember("category") || !stack_json.HasMember("count") ||
+      !stack_json.HasMember("stack")) {
+    return Status::InvalidArgument("expected profile stacks to have category, count and frames");
+  }
+
+  const auto& category = stack_json["category"];
+  if (PREDICT_FALSE(!category.IsString())) {
+    return Status::InvalidArgument("expected 'category' to be a string");
+  }
+  ret.category = category.GetString();
+
+  const auto& count = stack_json["count"];
+  if (PREDICT_FALSE(!count.IsInt64())) {
+    return Status::InvalidArgument("expected 'count' to be an integer");
+  }
+  ret.count = count.GetInt64();
+
+  const auto& frames = stack_json["stack"];
+  if (PREDICT_FALSE(!frames.IsArray())) {
+    return Status::InvalidArgument("expected 'stack' to be an array");
+  }
+  for (const auto* frame = frames.Begin();
+       frame != frames.End();
+       ++frame) {
+    if (PREDICT_FALSE(!frame->IsString())) {
+      return Status::InvalidArgument("expected 'stack' elements to be strings");
+    }
+    ret.frame_addrs.emplace_back(frame->GetString());
+  }
+  *stack = std::move(ret);
+  return Status::OK();
+}
+
+Status LogParser::ParseProfile(const ParsedLine& pl) {
+  ProfileRecord pr;
+  pr.date_time = pl.date_time();
+
+  const rapidjson::Value& json = *pl.json();
+  if (!json.IsObject()) {
+    return Status::InvalidArgument("expected profile data to be a JSON object");
+  }
+  if (PREDICT_FALSE(!json.HasMember("samples") || !json["samples"].IsInt64())) {
+    return Status::InvalidArgument("expected an integer 'samples' field in profile object");
+  }
+  pr.num_samples = json["samples"].GetInt64();
+
+  if (PREDICT_FALSE(!json.HasMember("stacks"))) {
+    return Status::InvalidArgument("no 'stacks' field in profile object");
+  }
+  const auto& stacks = json["stacks"];
+  if (!stacks.IsArray()) {
+    return Status::InvalidArgument("'stacks' field should be an array");
+  }
+  for (const rapidjson::Value* stack = stacks.Begin();
+       stack != stacks.End();
+       ++stack) {
+    ProfileRecord::Stack s;
+    RETURN_NOT_OK(ParseProfileStack(*stack, &s));
+    pr.stacks.emplace_back(std::move(s));
+  }
+  visitor_->VisitProfileRecord(std::move(pr));
+  return Status::OK();
+}
+
 } // namespace tools
 } // namespace kudu
 
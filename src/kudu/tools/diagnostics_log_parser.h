@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -38,6 +39,7 @@ namespace tools {
 enum class RecordType {
   kSymbols,
   kStacks,
+  kProfile,
   kUnknown
 };
 
@@ -65,12 +67,33 @@ struct StacksRecord {
   std::vector<Group> groups;
 };
 
+// A profile from the log: the stacks sampled over an interval, aggregated
+// by thread category.
+struct ProfileRecord {
+  // A stack trace and the number of times it was sampled in a category.
+  struct Stack {
+    std::string category;
+    int64_t count;
+    // The non-symbolized addresses forming the stack trace, innermost first.
+    std::vector<std::string> frame_addrs;
+  };
+
+  // The time the profile was logged.
+  std::string date_time;
+
+  // The number of process-wide samples aggregated in the profile.
+  int64_t num_samples;
+
+  std::vector<Stack> stacks;
+};
+
 // Interface for consuming the parsed records from a diagnostics log.
 class LogVisitor {
  public:
   virtual ~LogVisitor() {}
   virtual void VisitSymbol(const std::string& addr, const std::string& symbol) = 0;
   virtual void VisitStacksRecord(const StacksRecord& sr) = 0;
+  virtual void VisitProfileRecord(const ProfileRecord& pr) = 0;
 };
 
 // LogVisitor implementation which dumps the parsed stack records to cout.
@@ -80,6 +103,8 @@ class StackDumpingLogVisitor : public LogVisitor {
 
   void VisitStacksRecord(const StacksRecord& sr) override;
 
+  void VisitProfileRecord(const ProfileRecord& /*pr*/) override {}
+
  private:
   // True when we have not yet output any data.
   bool first_ = true;
@@ -89,6 +114,32 @@ class StackDumpingLogVisitor : public LogVisitor {
   const std::string kUnknownSymbol = "<unknown>";
 };
 
+// LogVisitor implementation which writes the stacks of the parsed profile
+// records to an output stream as folded stacks, the input format of flame
+// graph tools, e.g.:
+//
+//   reactor;kudu::rpc::ReactorThread::RunThread();epoll_wait 42
+//
+// The first element of each stack is the thread category. The same stack
+// may be output once per record; flame graph tools sum the duplicates.
+class FoldedStacksLogVisitor : public LogVisitor {
+ public:
+  explicit FoldedStacksLogVisitor(std::ostream* out)
+      : out_(out) {
+  }
+
+  void VisitSymbol(const std::string& addr, const std::string& symbol) override;
+
+  void VisitStacksRecord(const StacksRecord& /*sr*/) override {}
+
+  void VisitProfileRecord(const ProfileRecord& pr) override;
+
+ private:
+  std::ostream* out_;
+  // Map from symbols to name.
+  std::unordered_map<std::string, std::string> symbols_;
+};
+
 // A parsed line from the diagnostics log.
 //
 // Each line contains a timestamp, a record type, and some JSON data.
@@ -141,6 +192,11 @@ class LogParser {
 
   Status ParseStacks(const ParsedLine& lf);
 
+  static Status ParseProfileStack(const rapidjson::Value& stack_json,
+                                  ProfileRecord::Stack* stack);
+
+  Status ParseProfile(const ParsedLine& pl);
+
   LogVisitor* visitor_;
 };
 
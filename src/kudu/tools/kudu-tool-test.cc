@@ -487,6 +487,7 @@ class ToolTest : public KuduTest {
     int64_t max_value;
     string columns;
     TableCopyMode mode;
+    bool columnar;
   };
 
   void RunCopyTableCheck(const RunCopyTableCheckArgs& args) {
@@ -536,14 +537,15 @@ class ToolTest : public KuduTest {
     string stdout;
     NO_FATALS(RunActionStdoutString(
                 Substitute("table copy $0 $1 $2 -dst_table=$3 -predicates=$4 -write_type=$5 "
-                           "-create_table=$6",
+                           "-create_table=$6 -columnar=$7",
                            cluster_->master()->bound_rpc_addr().ToString(),
                            args.src_table_name,
                            cluster_->master()->bound_rpc_addr().ToString(),
                            kDstTableName,
                            args.predicates_json,
                            write_type,
-                           create_table),
+                           create_table,
+                           args.columnar),
                 &stdout));
 
     // Check total count.
@@ -670,7 +672,8 @@ enum RunCopyTableCheckArgsType {
   kTestCopyTableUpsert,
   kTestCopyTableSchemaOnly,
   kTestCopyTableComplexSchema,
-  kTestCopyTablePredicates
+  kTestCopyTablePredicates,
+  kTestCopyTableColumnar
 };
 // Subclass of ToolTest that allows running individual test cases with different parameters to run
 // 'kudu table copy' CLI tool.
@@ -689,7 +692,7 @@ class ToolTestCopyTableParameterized :
     ww.set_write_pattern(TestWorkload::INSERT_SEQUENTIAL_ROWS);
     ww.set_num_write_threads(1);
     // Create a complex schema if needed, or use a default simple schema.
-    if (test_case_ == kTestCopyTableComplexSchema) {
+    if (test_case_ == kTestCopyTableComplexSchema || test_case_ == kTestCopyTableColumnar) {
       KuduSchema schema;
       ASSERT_OK(CreateComplexSchema(&schema));
       ww.set_schema(schema);
@@ -714,7 +717,8 @@ class ToolTestCopyTableParameterized :
                                    1,
                                    total_rows_,
                                    kSimpleSchemaColumns,
-                                   TableCopyMode::INSERT_TO_EXIST_TABLE };
+                                   TableCopyMode::INSERT_TO_EXIST_TABLE,
+                                   false };
     switch (test_case_) {
       case kTestCopyTableDstTableExist:
         return { args };
@@ -731,6 +735,11 @@ class ToolTestCopyTableParameterized :
         args.columns = kComplexSchemaColumns;
         args.mode = TableCopyMode::INSERT_TO_NOT_EXIST_TABLE;
         return { args };
+      case kTestCopyTableColumnar:
+        args.columns = kComplexSchemaColumns;
+        args.mode = TableCopyMode::INSERT_TO_NOT_EXIST_TABLE;
+        args.columnar = true;
+        return { args };
       case kTestCopyTablePredicates: {
         auto mid = total_rows_ / 2;
         vector<RunCopyTableCheckArgs> multi_args;
@@ -904,7 +913,8 @@ INSTANTIATE_TEST_CASE_P(CopyTableParameterized,
                                           kTestCopyTableUpsert,
                                           kTestCopyTableSchemaOnly,
                                           kTestCopyTableComplexSchema,
-                                          kTestCopyTablePredicates));
+                                          kTestCopyTablePredicates,
+                                          kTestCopyTableColumnar));
 
 void ToolTest::StartExternalMiniCluster(ExternalMiniClusterOptions opts) {
   cluster_.reset(new ExternalMiniCluster(std::move(opts)));
@@ -1063,6 +1073,7 @@ TEST_F(ToolTest, TestModeHelp) {
   }
   {
     const vector<string> kDiagnoseModeRegexes = {
+        "parse_profile.*Parse the sampled profiles",
         "parse_stacks.*Parse sampled stack traces",
     };
     NO_FATALS(RunTestHelp("diagnose", kDiagnoseModeRegexes));
@@ -1094,8 +1105,10 @@ TEST_F(ToolTest, TestModeHelp) {
   {
     const vector<string> kPerfRegexes = {
         "loadgen.*Run load generation with optional scan afterwards",
+        "replay.*Replay a captured workload against a table",
         "table_scan.*Show row count and scanning time cost of tablets in a table",
-        "tablet_scan.*Show row count of a local tablet"
+        "tablet_scan.*Show row count of a local tablet",
+        "ycsb.*Run a YCSB workload"
     };
     NO_FATALS(RunTestHelp("perf", kPerfRegexes));
   }
@@ -2454,6 +2467,69 @@ TEST_F(ToolTest, TestPerfTableScan) {
   NO_FATALS(RunScanTableCheck(kTableName, "", 1, 2000, {}, "perf table_scan"));
 }
 
+TEST_F(ToolTest, TestPerfReplay) {
+  const string& kTableName = "perf.replay";
+  NO_FATALS(RunLoadgen(1, {}, kTableName));
+
+  const string workload_file = GetTestPath("workload");
+  ASSERT_OK(WriteStringToFile(env_,
+      "# offset_ms operation argument\n"
+      "0 GET {\"key\": 1}\n"
+      "5 UPDATE {\"key\": 1, \"int32_val\": 42}\n"
+      "10 SCAN [\"AND\", [\">=\", \"key\", 10], [\"<\", \"key\", 20]]\n"
+      "15 DELETE {\"key\": 2}\n"
+      "20 DELETE {\"key\": 2}\n",
+      workload_file));
+  string stdout;
+  NO_FATALS(RunActionStdoutString(
+      Substitute("perf replay $0 $1 $2 --num_threads=1",
+                 cluster_->master()->bound_rpc_addr().ToString(),
+                 kTableName, workload_file), &stdout));
+  ASSERT_STR_CONTAINS(stdout, "Replayed 5 operations");
+  ASSERT_STR_MATCHES(stdout, "GET +1 +0 +1 ");
+  ASSERT_STR_MATCHES(stdout, "UPDATE +1 +0 +0 ");
+  ASSERT_STR_MATCHES(stdout, "SCAN +1 +0 +10 ");
+  // Deleting the row a second time fails.
+  ASSERT_STR_MATCHES(stdout, "DELETE +2 +1 +0 ");
+
+  // A malformed workload is rejected before anything is replayed.
+  ASSERT_OK(WriteStringToFile(env_, "0 MERGE {\"key\": 1}\n", workload_file));
+  string stderr;
+  Status s = RunActionStderrString(
+      Substitute("perf replay $0 $1 $2",
+                 cluster_->master()->bound_rpc_addr().ToString(),
+                 kTableName, workload_file), &stderr);
+  ASSERT_TRUE(s.IsRuntimeError());
+  ASSERT_STR_CONTAINS(stderr, "unknown operation");
+}
+
+TEST_F(ToolTest, TestPerfYcsb) {
+  NO_FATALS(StartExternalMiniCluster());
+  const string master_addr = cluster_->master()->bound_rpc_addr().ToString();
+  const string kTableName = "perf.ycsb";
+  // Load the records with the first workload, then run the others against
+  // the same records.
+  const vector<string> kWorkloads = { "a", "b", "c", "d", "e", "f" };
+  for (const auto& workload : kWorkloads) {
+    SCOPED_TRACE(workload);
+    const bool load = workload == "a";
+    string stdout;
+    NO_FATALS(RunActionStdoutString(Substitute(
+        "perf ycsb $0 --table_name=$1 --ycsb_workload=$2 --ycsb_load=$3 "
+        "--ycsb_record_count=200 --ycsb_operation_count=100 "
+        "--ycsb_field_count=2 --ycsb_field_length=8 --num_threads=2",
+        master_addr, kTableName, workload, load), &stdout));
+    if (load) {
+      ASSERT_STR_CONTAINS(stdout, "Loaded 200 records");
+    } else {
+      ASSERT_STR_NOT_CONTAINS(stdout, "Loaded");
+    }
+    ASSERT_STR_CONTAINS(stdout, "Ran 100 operations of workload " + workload);
+    // None of the reads and scans fail.
+    ASSERT_STR_MATCHES(stdout, "(READ|SCAN) +[0-9]+ +0 ");
+  }
+}
+
 TEST_F(ToolTest, TestPerfTabletScan) {
   // Create a table.
   const string& kTableName = "perf.tablet_scan";
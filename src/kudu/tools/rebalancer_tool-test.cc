@@ -584,6 +584,62 @@ TEST_P(RebalanceParamTest, Rebalance) {
   NO_FATALS(ClusterVerifier(cluster_.get()).CheckCluster());
 }
 
+// Make sure the rebalancer balances the cluster when the size of the replicas
+// in flight is capped so tightly that every tablet server moves one replica
+// at a time.
+class RebalanceBytesInFlightTest : public AdminCliTest {
+};
+TEST_F(RebalanceBytesInFlightTest, OneReplicaAtATime) {
+  if (!AllowSlowTests()) {
+    LOG(WARNING) << "test is skipped; set KUDU_ALLOW_SLOW_TESTS=1 to run";
+    return;
+  }
+
+  constexpr auto kRepFactor = 3;
+  constexpr auto kNumTservers = 5;
+  constexpr auto kNumTables = 2;
+  constexpr auto kTserverUnresponsiveMs = 3000;
+  const vector<string> kMasterFlags = {
+    Substitute("--tserver_unresponsive_timeout_ms=$0", kTserverUnresponsiveMs),
+  };
+
+  FLAGS_num_tablet_servers = kNumTservers;
+  FLAGS_num_replicas = kRepFactor;
+  NO_FATALS(BuildAndStart({}, kMasterFlags));
+
+  ASSERT_OK(CreateUnbalancedTables(
+      cluster_.get(), client_.get(), schema_, "bytes_in_flight_table_$0",
+      kNumTables, kRepFactor, kRepFactor, kNumTservers, kTserverUnresponsiveMs));
+
+  const vector<string> tool_args = {
+    "cluster",
+    "rebalance",
+    cluster_->master()->bound_rpc_addr().ToString(),
+    "--max_bytes_in_flight_per_server=1",
+  };
+  {
+    string out;
+    string err;
+    const Status s = RunKuduTool(tool_args, &out, &err);
+    ASSERT_TRUE(s.ok()) << ToolRunInfo(s, out, err);
+    ASSERT_STR_CONTAINS(out, "rebalancing is complete: cluster is balanced")
+        << "stderr: " << err;
+    ASSERT_STR_NOT_CONTAINS(out, "(moved 0 replicas)");
+  }
+  {
+    string out;
+    string err;
+    const Status s = RunKuduTool(tool_args, &out, &err);
+    ASSERT_TRUE(s.ok()) << ToolRunInfo(s, out, err);
+    ASSERT_STR_CONTAINS(out,
+        "rebalancing is complete: cluster is balanced (moved 0 replicas)")
+        << "stderr: " << err;
+  }
+
+  NO_FATALS(cluster_->AssertNoCrashes());
+  NO_FATALS(ClusterVerifier(cluster_.get()).CheckCluster());
+}
+
 // Working around limitations of older libstdc++.
 static const unordered_set<string> kEmptySet = unordered_set<string>();
 
@@ -944,6 +944,16 @@ Status RebalancerTool::AlgoBasedRunner::GetNextMovesImpl(
   unordered_map<string, TabletExtraInfo> extra_info_by_tablet_id;
   BuildTabletExtraInfoMap(raw_info, &extra_info_by_tablet_id);
 
+  tablet_sizes_.clear();
+  for (const auto& tablet : raw_info.tablet_summaries) {
+    for (const auto& replica : tablet.replicas) {
+      if (replica.status_pb && replica.status_pb->has_estimated_on_disk_size()) {
+        auto& size = tablet_sizes_[tablet.id];
+        size = std::max(size, replica.status_pb->estimated_on_disk_size());
+      }
+    }
+  }
+
   // The number of operations to output by the algorithm. Those will be
   // translated into concrete tablet replica movement operations, the output of
   // this method.
@@ -989,7 +999,49 @@ Status RebalancerTool::AlgoBasedRunner::GetNextMovesImpl(
   return Status::OK();
 }
 
+int64_t RebalancerTool::AlgoBasedRunner::TabletSize(const string& tablet_id) const {
+  return FindWithDefault(tablet_sizes_, tablet_id, 0);
+}
+
+bool RebalancerTool::AlgoBasedRunner::FitsBytesInFlightLimit(
+    size_t idx,
+    const unordered_map<string, int64_t>& bytes_in_flight) const {
+  const int64_t limit = rebalancer_->config_.max_bytes_in_flight_per_server;
+  if (limit == 0) {
+    return true;
+  }
+  const auto& move = replica_moves_[idx];
+  const int64_t size = TabletSize(move.tablet_uuid);
+  for (const auto* ts_uuid : { &move.ts_uuid_from, &move.ts_uuid_to }) {
+    const int64_t in_flight = FindWithDefault(bytes_in_flight, *ts_uuid, 0);
+    if (in_flight > 0 && in_flight + size > limit) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool RebalancerTool::AlgoBasedRunner::FindNextMove(size_t* op_idx) {
+  // The size of the replicas being moved to or from each server.
+  unordered_map<string, int64_t> bytes_in_flight;
+  if (rebalancer_->config_.max_bytes_in_flight_per_server > 0) {
+    for (const auto& elem : scheduled_moves_) {
+      const int64_t size = TabletSize(elem.first);
+      bytes_in_flight[elem.second.ts_uuid_from] += size;
+      bytes_in_flight[elem.second.ts_uuid_to] += size;
+    }
+  }
+  // Keeps only the moves which fit the limit on the bytes in flight. The
+  // algorithm outputs the moves which reduce the skew the most first, and
+  // the indices are kept sorted, so the first remaining move is the best.
+  const auto filter_by_bytes_in_flight = [&](vector<size_t>* indices) {
+    indices->erase(std::remove_if(indices->begin(), indices->end(),
+                                  [&](size_t idx) {
+                                    return !FitsBytesInFlightLimit(idx, bytes_in_flight);
+                                  }),
+                   indices->end());
+  };
+
   vector<size_t> op_indices;
   for (auto it = ts_per_op_count_.begin(); op_indices.empty() &&
        it != ts_per_op_count_.end() && it->first < max_moves_per_server_; ++it) {
@@ -1011,6 +1063,7 @@ bool RebalancerTool::AlgoBasedRunner::FindNextMove(size_t* op_idx) {
           set_intersection(it_src->second.begin(), it_src->second.end(),
                            it_dst->second.begin(), it_dst->second.end(),
                            back_inserter(op_indices));
+          filter_by_bytes_in_flight(&op_indices);
         }
       }
       // It's enough to find just one move.
@@ -1025,6 +1078,7 @@ bool RebalancerTool::AlgoBasedRunner::FindNextMove(size_t* op_idx) {
           set_intersection(it_src->second.begin(), it_src->second.end(),
                            it_dst->second.begin(), it_dst->second.end(),
                            back_inserter(op_indices));
+          filter_by_bytes_in_flight(&op_indices);
         }
       }
     }
@@ -174,6 +174,17 @@ class RebalancerTool : public rebalance::Rebalancer {
     // and output the index into the 'op_idx' parameter.
     bool FindNextMove(size_t* op_idx);
 
+    // Returns true if scheduling the move with index 'idx' keeps the size of
+    // the replicas being moved to or from each of its servers within
+    // Config::max_bytes_in_flight_per_server. 'bytes_in_flight' is the size
+    // of the replicas being moved per server.
+    bool FitsBytesInFlightLimit(
+        size_t idx,
+        const std::unordered_map<std::string, int64_t>& bytes_in_flight) const;
+
+    // Returns the estimated on-disk size of the tablet, or 0 if unknown.
+    int64_t TabletSize(const std::string& tablet_id) const;
+
     // Update the helper containers once a move operation has been scheduled.
     void UpdateOnMoveScheduled(size_t idx,
                                const std::string& tablet_uuid,
@@ -203,6 +214,10 @@ class RebalancerTool : public rebalance::Rebalancer {
     // appropriate.
     std::random_device random_device_;
     std::mt19937 random_generator_;
+
+    // Mapping 'tablet UUID' --> 'the largest estimated on-disk size reported
+    // by the tablet's replicas'. Refreshed along with the moves to schedule.
+    std::unordered_map<std::string, int64_t> tablet_sizes_;
   }; // class AlgoBasedRunner
 
   class IntraLocationRunner : public AlgoBasedRunner {
@@ -34,6 +34,7 @@
 #include <rapidjson/document.h>
 
 #include "kudu/client/client.h"
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/scan_batch.h"
 #include "kudu/client/scan_predicate.h"
 #include "kudu/client/schema.h"
@@ -44,6 +45,7 @@
 #include "kudu/common/partition.h"
 #include "kudu/common/row.h"
 #include "kudu/common/schema.h"
+#include "kudu/common/types.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/stl_util.h"
@@ -59,6 +61,8 @@
 #include "kudu/util/string_case.h"
 
 using kudu::client::KuduClient;
+using kudu::client::KuduColumnarScanBatch;
+using kudu::client::KuduColumnarWriteBatch;
 using kudu::client::KuduColumnSchema;
 using kudu::client::KuduError;
 using kudu::client::KuduPredicate;
@@ -82,6 +86,15 @@ using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
+DEFINE_bool(columnar, false,
+            "Whether to scan the data in columnar layout. When copying, the "
+            "scanned batches are also written to the destination table as a "
+            "whole, by as many writer threads as there are scanning threads. "
+            "Not supported when showing the values of the scanned rows.");
+DEFINE_int32(columnar_copy_max_queued_batches, 64,
+             "When copying with --columnar, the maximum number of scanned "
+             "batches waiting to be written to the destination table. "
+             "Scanning is paused while this many batches are queued.");
 DEFINE_bool(create_table, true,
             "Whether to create the destination table if it doesn't exist.");
 DECLARE_string(columns);
@@ -249,7 +262,7 @@ Status AddPredicate(const client::sp::shared_ptr<KuduTable>& table,
                     const string& column_name,
                     const boost::optional<const rapidjson::Value*>& value,
                     const JsonReader& reader,
-                    KuduScanTokenBuilder& builder) {
+                    vector<unique_ptr<KuduPredicate>>* predicates) {
   if (predicate_type.empty() || column_name.empty()) {
     return Status::OK();
   }
@@ -282,7 +295,7 @@ Status AddPredicate(const client::sp::shared_ptr<KuduTable>& table,
       return Status::NotSupported(Substitute("not support predicate_type $0", predicate_type));
   }
   CHECK(predicate);
-  RETURN_NOT_OK(builder.AddConjunctPredicate(predicate));
+  predicates->emplace_back(predicate);
 
   return Status::OK();
 }
@@ -292,13 +305,24 @@ Status AddPredicates(const client::sp::shared_ptr<KuduTable>& table,
   if (FLAGS_predicates.empty()) {
     return Status::OK();
   }
-  JsonReader reader(FLAGS_predicates);
+  vector<unique_ptr<KuduPredicate>> predicates;
+  RETURN_NOT_OK(ParsePredicates(table, FLAGS_predicates, &predicates));
+  for (auto& predicate : predicates) {
+    RETURN_NOT_OK(builder.AddConjunctPredicate(predicate.release()));
+  }
+
+  return Status::OK();
+}
+
+Status ParsePredicates(const client::sp::shared_ptr<KuduTable>& table,
+                       const string& predicates_json,
+                       vector<unique_ptr<KuduPredicate>>* predicates) {
+  JsonReader reader(predicates_json);
   RETURN_NOT_OK(reader.Init());
   vector<const rapidjson::Value*> predicate_objects;
   RETURN_NOT_OK(reader.ExtractObjectArray(reader.root(),
                                           nullptr,
                                           &predicate_objects));
-  vector<unique_ptr<KuduPredicate>> predicates;
   for (int i = 0; i < predicate_objects.size(); ++i) {
     if (i == 0) {
       CHECK(predicate_objects[i]->IsString());
@@ -322,7 +346,7 @@ Status AddPredicates(const client::sp::shared_ptr<KuduTable>& table,
           elements.size() == 2 ?
             boost::none : boost::optional<const rapidjson::Value*>(elements[2]),
           reader,
-          builder));
+          predicates));
     } else {
       return Status::InvalidArgument(
           Substitute("invalid predicate elements count $0", elements.size()));
@@ -461,6 +485,42 @@ Status TableScanner::AddRow(const client::sp::shared_ptr<KuduTable>& table,
   return session->Apply(write_op.release());
 }
 
+Status ApplyColumnarBatch(const client::sp::shared_ptr<KuduTable>& table,
+                          const Schema& table_schema,
+                          const KuduColumnarScanBatch& src_batch,
+                          const client::sp::shared_ptr<KuduSession>& session) {
+  KuduWriteOperation::Type type;
+  if (FLAGS_write_type == "insert") {
+    type = KuduWriteOperation::INSERT;
+  } else if (FLAGS_write_type == "upsert") {
+    type = KuduWriteOperation::UPSERT;
+  } else {
+    LOG(FATAL) << Substitute("invalid write_type: $0", FLAGS_write_type);
+  }
+
+  // The cells are copied out of the scanned batch when the batch is applied,
+  // so it doesn't need to outlive this call.
+  KuduColumnarWriteBatch dst_batch(table, type, src_batch.NumRows());
+  for (int i = 0; i < table_schema.num_columns(); ++i) {
+    const ColumnSchema& col = table_schema.column(i);
+    Slice non_null_bitmap;
+    if (col.is_nullable()) {
+      RETURN_NOT_OK(src_batch.GetNonNullBitmapForColumn(i, &non_null_bitmap));
+    }
+    if (col.type_info()->physical_type() == BINARY) {
+      Slice offsets;
+      Slice data;
+      RETURN_NOT_OK(src_batch.GetVariableLengthColumn(i, &offsets, &data));
+      RETURN_NOT_OK(dst_batch.SetVariableLengthColumn(i, offsets, data, non_null_bitmap));
+    } else {
+      Slice data;
+      RETURN_NOT_OK(src_batch.GetFixedLengthColumn(i, &data));
+      RETURN_NOT_OK(dst_batch.SetFixedLengthColumn(i, data, non_null_bitmap));
+    }
+  }
+  return session->ApplyColumnar(dst_batch);
+}
+
 Status TableScanner::ScanData(const std::vector<kudu::client::KuduScanToken*>& tokens,
                               const std::function<void(const KuduScanBatch& batch)>& cb) {
 
@@ -495,7 +555,47 @@ Status TableScanner::ScanData(const std::vector<kudu::client::KuduScanToken*>& t
 
 }
 
+Status TableScanner::ScanColumnarData(
+    const vector<KuduScanToken*>& tokens,
+    const std::function<Status(unique_ptr<KuduColumnarScanBatch> batch)>& cb) {
+  for (auto token : tokens) {
+    Stopwatch sw(Stopwatch::THIS_THREAD);
+    sw.start();
+
+    KuduScanner* scanner_ptr;
+    RETURN_NOT_OK(token->IntoKuduScanner(&scanner_ptr));
+
+    unique_ptr<KuduScanner> scanner(scanner_ptr);
+    RETURN_NOT_OK(scanner->SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+    RETURN_NOT_OK(scanner->Open());
+
+    uint64_t count = 0;
+    while (scanner->HasMoreRows()) {
+      unique_ptr<KuduColumnarScanBatch> batch(new KuduColumnarScanBatch);
+      RETURN_NOT_OK(scanner->NextBatch(batch.get()));
+      count += batch->NumRows();
+      total_count_.IncrementBy(batch->NumRows());
+      RETURN_NOT_OK(cb(std::move(batch)));
+    }
+
+    sw.stop();
+    if (out_) {
+      MutexLock l(output_lock_);
+      *out_ << "T " << token->tablet().id() << " scanned count " << count
+           << " cost " << sw.elapsed().wall_seconds() << " seconds" << endl;
+    }
+  }
+
+  return Status::OK();
+}
+
 void TableScanner::ScanTask(const vector<KuduScanToken *>& tokens, Status* thread_status) {
+  if (FLAGS_columnar) {
+    *thread_status = ScanColumnarData(tokens, [](unique_ptr<KuduColumnarScanBatch> /*batch*/) {
+      return Status::OK();
+    });
+    return;
+  }
   *thread_status = ScanData(tokens, [&](const KuduScanBatch& batch) {
     if (out_ && FLAGS_show_values) {
       MutexLock l(output_lock_);
@@ -529,6 +629,53 @@ void TableScanner::CopyTask(const vector<KuduScanToken*>& tokens, Status* thread
   });
 }
 
+void TableScanner::ColumnarReadTask(const vector<KuduScanToken*>& tokens,
+                                    Status* thread_status) {
+  *thread_status = ScanColumnarData(tokens, [&](unique_ptr<KuduColumnarScanBatch> batch)
+                                                 -> Status {
+    if (batch->NumRows() == 0) {
+      return Status::OK();
+    }
+    return batch_queue_->BlockingPut(&batch);
+  });
+  // The queue is only shut down early if a write task failed, and that
+  // failure is the one to report.
+  if (thread_status->IsAborted()) {
+    *thread_status = Status::OK();
+  }
+  if (num_running_readers_.IncrementBy(-1) == 0) {
+    batch_queue_->Shutdown();
+  }
+}
+
+void TableScanner::ColumnarWriteTask(Status* thread_status) {
+  client::sp::shared_ptr<KuduTable> dst_table;
+  CHECK_OK(dst_client_.get()->OpenTable(*dst_table_name_, &dst_table));
+  const Schema dst_table_schema = KuduSchema::ToSchema(dst_table->schema());
+
+  // One session per thread.
+  client::sp::shared_ptr<KuduSession> session(dst_client_.get()->NewSession());
+  CHECK_OK(session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND));
+  CHECK_OK(session->SetErrorBufferSpace(1024));
+  session->SetTimeoutMillis(30000);
+
+  Status s;
+  unique_ptr<KuduColumnarScanBatch> batch;
+  while (batch_queue_->BlockingGet(&batch).ok()) {
+    s = ApplyColumnarBatch(dst_table, dst_table_schema, *batch, session);
+    if (!s.ok()) {
+      // Unblock the read tasks.
+      batch_queue_->Shutdown();
+      break;
+    }
+    CheckPendingErrors(session);
+  }
+  if (s.ok()) {
+    s = session->Flush();
+  }
+  CheckPendingErrors(session);
+  *thread_status = s;
+}
 
 void TableScanner::SetOutput(ostream* out) {
   out_ = out;
@@ -542,6 +689,10 @@ Status TableScanner::StartWork(WorkType type) {
   client::sp::shared_ptr<KuduTable> src_table;
   RETURN_NOT_OK(client_->OpenTable(table_name_, &src_table));
 
+  if (FLAGS_columnar && FLAGS_show_values) {
+    return Status::InvalidArgument("--columnar is not supported with --show_values");
+  }
+
   // Create destination table if needed.
   if (type == WorkType::kCopy) {
     RETURN_NOT_OK(CreateDstTableIfNeeded(src_table, *dst_client_, *dst_table_name_));
@@ -585,11 +736,19 @@ Status TableScanner::StartWork(WorkType type) {
     }
   }
 
-  // Initialize statuses for each thread.
-  vector<Status> thread_statuses(FLAGS_num_threads);
+  // Initialize statuses for each thread, and for each writer thread of the
+  // columnar copy.
+  const bool columnar_copy = type == WorkType::kCopy && FLAGS_columnar;
+  const int num_threads = columnar_copy ? 2 * FLAGS_num_threads : FLAGS_num_threads;
+  vector<Status> thread_statuses(num_threads);
+  if (columnar_copy) {
+    batch_queue_.reset(new BlockingQueue<KuduColumnarScanBatch*>(
+        FLAGS_columnar_copy_max_queued_batches));
+    num_running_readers_.Store(FLAGS_num_threads);
+  }
 
   RETURN_NOT_OK(ThreadPoolBuilder("table_scan_pool")
-                  .set_max_threads(FLAGS_num_threads)
+                  .set_max_threads(num_threads)
                   .set_idle_timeout(MonoDelta::FromMilliseconds(1))
                   .Build(&thread_pool_));
 
@@ -602,6 +761,12 @@ Status TableScanner::StartWork(WorkType type) {
     if (type == WorkType::kScan) {
       RETURN_NOT_OK(thread_pool_->Submit([this, t_tokens, t_status]()
                                          { this->ScanTask(*t_tokens, t_status); }));
+    } else if (columnar_copy) {
+      auto* w_status = &thread_statuses[FLAGS_num_threads + i];
+      RETURN_NOT_OK(thread_pool_->Submit([this, t_tokens, t_status]()
+                                         { this->ColumnarReadTask(*t_tokens, t_status); }));
+      RETURN_NOT_OK(thread_pool_->Submit([this, w_status]()
+                                         { this->ColumnarWriteTask(w_status); }));
     } else {
       CHECK(type == WorkType::kCopy);
       RETURN_NOT_OK(thread_pool_->Submit([this, t_tokens, t_status]()
@@ -612,6 +777,12 @@ Status TableScanner::StartWork(WorkType type) {
     LOG(INFO) << "Scanned count: " << total_count_.Load();
   }
   thread_pool_->Shutdown();
+  if (columnar_copy) {
+    // Release the batches left over by failed write tasks.
+    unique_ptr<KuduColumnarScanBatch> batch;
+    while (batch_queue_->BlockingGet(&batch).ok()) {
+    }
+  }
 
   sw.stop();
   if (out_) {
@@ -619,7 +790,7 @@ Status TableScanner::StartWork(WorkType type) {
         << " cost " << sw.elapsed().wall_seconds() << " seconds" << endl;
   }
 
-  for (i = 0; i < FLAGS_num_threads; ++i) {
+  for (i = 0; i < num_threads; ++i) {
     if (!thread_statuses[i].ok()) {
       if (out_) *out_ << "Scanning failed " << thread_statuses[i].ToString() << endl;
       if (end_status.ok()) end_status = thread_statuses[i];
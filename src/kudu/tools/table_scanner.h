@@ -31,18 +31,28 @@
 #include "kudu/client/scan_batch.h"
 #include "kudu/client/shared_ptr.h" // IWYU pragma: keep
 #include "kudu/util/atomic.h"
+#include "kudu/util/blocking_queue.h"
 #include "kudu/util/mutex.h"
 #include "kudu/util/status.h"
 #include "kudu/util/threadpool.h"
 
 namespace kudu {
 namespace client {
+class KuduColumnarScanBatch;
+class KuduPredicate;
 class KuduSchema;
 }  // namespace client
 }  // namespace kudu
 
 namespace kudu {
 namespace tools {
+
+// Parses 'predicates_json', written in the syntax of the --predicates flag,
+// into conjunctive predicates on the columns of 'table'.
+Status ParsePredicates(const client::sp::shared_ptr<client::KuduTable>& table,
+                       const std::string& predicates_json,
+                       std::vector<std::unique_ptr<client::KuduPredicate>>* predicates);
+
 // This class is not thread-safe.
 class TableScanner {
  public:
@@ -56,6 +66,7 @@ class TableScanner {
     table_name_(std::move(table_name)),
     dst_client_(std::move(dst_client)),
     dst_table_name_(std::move(dst_table_name)),
+    num_running_readers_(0),
     out_(nullptr) {
   }
 
@@ -82,9 +93,21 @@ class TableScanner {
   Status StartWork(WorkType type);
   Status ScanData(const std::vector<kudu::client::KuduScanToken*>& tokens,
                   const std::function<void(const kudu::client::KuduScanBatch& batch)>& cb);
+  // Like ScanData(), but fetches the batches in columnar layout and hands
+  // each of them over to 'cb'. Stops at the first error returned by 'cb'.
+  Status ScanColumnarData(
+      const std::vector<kudu::client::KuduScanToken*>& tokens,
+      const std::function<Status(std::unique_ptr<kudu::client::KuduColumnarScanBatch> batch)>& cb);
   void ScanTask(const std::vector<kudu::client::KuduScanToken*>& tokens, Status* thread_status);
   void CopyTask(const std::vector<kudu::client::KuduScanToken*>& tokens, Status* thread_status);
 
+  // With --columnar, the copy is a pipeline: the read tasks scan their
+  // tablets into 'batch_queue_', from which the write tasks apply the
+  // batches to the destination table, each with its own session.
+  void ColumnarReadTask(const std::vector<kudu::client::KuduScanToken*>& tokens,
+                        Status* thread_status);
+  void ColumnarWriteTask(Status* thread_status);
+
   Status AddRow(const client::sp::shared_ptr<kudu::client::KuduTable>& table,
                 const kudu::client::KuduSchema& table_schema,
                 const kudu::client::KuduScanBatch::RowPtr& src_row,
@@ -98,6 +121,11 @@ class TableScanner {
   boost::optional<std::string> dst_table_name_;
   std::unique_ptr<ThreadPool> thread_pool_;
 
+  // Only used by the columnar copy. The queue is shut down once the last
+  // read task is done, or as soon as a write task fails.
+  std::unique_ptr<BlockingQueue<kudu::client::KuduColumnarScanBatch*>> batch_queue_;
+  AtomicInt<int32_t> num_running_readers_;
+
   // Protects output to 'out_' so that rows don't get interleaved.
   Mutex output_lock_;
   std::ostream* out_;
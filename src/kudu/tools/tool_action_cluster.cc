@@ -80,6 +80,13 @@ DEFINE_uint32(max_moves_per_server, 5,
               "tablet server: 'move from' and 'move to' are counted "
               "as separate move operations.");
 
+DEFINE_int64(max_bytes_in_flight_per_server, 0,
+             "Maximum total size, in bytes, of the tablet replicas to move "
+             "concurrently to or from one tablet server, as estimated from the "
+             "on-disk sizes the replicas of the tablets report. A move is "
+             "scheduled regardless if its servers have no other moves in "
+             "progress. Specifying 0 means not imposing any such limit.");
+
 DEFINE_uint32(max_staleness_interval_sec, 300,
               "Maximum duration of the 'staleness' interval, when the "
               "rebalancer cannot make any progress in scheduling new moves and "
@@ -319,7 +326,8 @@ Status RunRebalance(const RunnerContext& context) {
       !FLAGS_disable_policy_fixer,
       !FLAGS_disable_cross_location_rebalancing,
       !FLAGS_disable_intra_location_rebalancing,
-      FLAGS_load_imbalance_threshold));
+      FLAGS_load_imbalance_threshold,
+      FLAGS_max_bytes_in_flight_per_server));
 
   // Print info on pre-rebalance distribution of replicas.
   RETURN_NOT_OK(rebalancer.PrintStats(cout));
@@ -415,6 +423,7 @@ unique_ptr<Mode> BuildClusterMode() {
         .AddOptionalParameter("fetch_info_concurrency")
         .AddOptionalParameter("ignored_tservers")
         .AddOptionalParameter("load_imbalance_threshold")
+        .AddOptionalParameter("max_bytes_in_flight_per_server")
         .AddOptionalParameter("max_moves_per_server")
         .AddOptionalParameter("max_run_time_sec")
         .AddOptionalParameter("max_staleness_interval_sec")
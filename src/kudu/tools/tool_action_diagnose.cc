@@ -19,6 +19,7 @@
 #include <cerrno>
 #include <fstream> // IWYU pragma: keep
 #include <functional>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -50,14 +51,13 @@ const char* kLogPathArg = "path";
 
 namespace {
 
-Status ParseStacksFromPath(const string& path) {
+Status ParseLogFromPath(const string& path, LogVisitor* visitor) {
   errno = 0;
   ifstream in(path);
   if (!in.is_open()) {
     return Status::IOError(ErrnoToString(errno));
   }
-  StackDumpingLogVisitor dlv;
-  LogParser lp(&dlv);
+  LogParser lp(visitor);
   string line;
   int line_number = 0;
   while (std::getline(in, line)) {
@@ -69,18 +69,28 @@ Status ParseStacksFromPath(const string& path) {
   return Status::OK();
 }
 
-Status ParseStacks(const RunnerContext& context) {
-  vector<string> paths = context.variadic_args;
+// Parses the logs at 'paths' in chronological order with 'visitor'.
+Status ParseLogsFromPaths(vector<string> paths, const string& what, LogVisitor* visitor) {
   // The file names are such that lexicographic sorting reflects
   // timestamp-based sorting.
   std::sort(paths.begin(), paths.end());
   for (const auto& path : paths) {
-    RETURN_NOT_OK_PREPEND(ParseStacksFromPath(path),
-                          Substitute("failed to parse stacks from $0", path));
+    RETURN_NOT_OK_PREPEND(ParseLogFromPath(path, visitor),
+                          Substitute("failed to parse $0 from $1", what, path));
   }
   return Status::OK();
 }
 
+Status ParseStacks(const RunnerContext& context) {
+  StackDumpingLogVisitor dlv;
+  return ParseLogsFromPaths(context.variadic_args, "stacks", &dlv);
+}
+
+Status ParseProfile(const RunnerContext& context) {
+  FoldedStacksLogVisitor flv(&std::cout);
+  return ParseLogsFromPaths(context.variadic_args, "profile", &flv);
+}
+
 } // anonymous namespace
 
 unique_ptr<Mode> BuildDiagnoseMode() {
@@ -90,8 +100,18 @@ unique_ptr<Mode> BuildDiagnoseMode() {
       .AddRequiredVariadicParameter({ kLogPathArg, "path to log file(s) to parse" })
       .Build();
 
+  unique_ptr<Action> parse_profile =
+      ActionBuilder("parse_profile", &ParseProfile)
+      .Description("Parse the sampled profiles out of a diagnostics log into folded stacks")
+      .ExtraDescription("Each output line is a stack prefixed by its thread category, "
+                        "followed by the number of times it was sampled. This is the "
+                        "input format of flame graph tools such as flamegraph.pl.")
+      .AddRequiredVariadicParameter({ kLogPathArg, "path to log file(s) to parse" })
+      .Build();
+
   return ModeBuilder("diagnose")
       .Description("Diagnostic tools for Kudu servers and clusters")
+      .AddAction(std::move(parse_profile))
       .AddAction(std::move(parse_stacks))
       .Build();
 }
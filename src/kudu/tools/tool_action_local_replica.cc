@@ -715,8 +715,7 @@ Status DumpRowSet(const RunnerContext& context) {
     return Status::OK();
   }
 
-  IOContext ctx;
-  ctx.tablet_id = meta->tablet_id();
+  IOContext ctx({ meta->tablet_id() });
   int64_t rows_left = FLAGS_nrows;
 
   // If rowset index is provided, only dump that rowset.
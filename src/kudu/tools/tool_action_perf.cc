@@ -214,6 +214,8 @@
 #include "kudu/tools/table_scanner.h"
 #include "kudu/tools/tool_action.h"
 #include "kudu/tools/tool_action_common.h"
+#include "kudu/tools/workload_replayer.h"
+#include "kudu/tools/ycsb_workload.h"
 #include "kudu/util/decimal_util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/flag_validators.h"
@@ -297,6 +299,10 @@ DEFINE_int64(num_rows_per_thread, 1000,
 DECLARE_int32(num_threads);
 DEFINE_bool(ordered_scan, false,
             "Whether to run an ordered or unordered scan.");
+DEFINE_double(replay_speed, 1.0,
+              "Speed at which to replay a workload, relative to the rate at "
+              "which it was captured. If 0, the operations are replayed as "
+              "fast as possible.");
 DEFINE_bool(run_scan, false,
             "Whether to run post-insertion scan to verify that the count of "
             "the inserted rows matches the expected number. If enabled, "
@@ -353,12 +359,15 @@ DEFINE_bool(use_random, false,
             "Whether to use random numbers instead of sequential ones. "
             "In case of using random numbers collisions are possible over "
             "the data for columns with unique constraint (e.g. primary key).");
+DECLARE_bool(ycsb_load);
 
 namespace kudu {
 namespace tools {
 
 namespace {
 
+const char* const kWorkloadFileArg = "workload_file";
+
 bool ValidatePartitionFlags() {
   int num_tablets = FLAGS_table_num_hash_partitions * FLAGS_table_num_range_partitions;
   if (num_tablets < 1) {
@@ -793,6 +802,56 @@ Status TableScan(const RunnerContext& context) {
   return scanner.StartScan();
 }
 
+Status ReplayWorkload(const RunnerContext& context) {
+  if (FLAGS_replay_speed < 0) {
+    return Status::InvalidArgument("--replay_speed must not be negative");
+  }
+  client::sp::shared_ptr<KuduClient> client;
+  RETURN_NOT_OK(CreateKuduClient(context, &client));
+
+  const string& table_name = FindOrDie(context.required_args, kTableNameArg);
+  const string& workload_file = FindOrDie(context.required_args, kWorkloadFileArg);
+  WorkloadReplayer replayer(client, table_name);
+  RETURN_NOT_OK(replayer.Load(workload_file));
+  RETURN_NOT_OK(replayer.Run(FLAGS_num_threads, FLAGS_replay_speed));
+  replayer.PrintReport(&cout);
+  return Status::OK();
+}
+
+Status RunYcsb(const RunnerContext& context) {
+  client::sp::shared_ptr<KuduClient> client;
+  RETURN_NOT_OK(CreateKuduClient(context, &client));
+
+  string table_name;
+  bool is_auto_table = false;
+  if (!FLAGS_table_name.empty()) {
+    table_name = FLAGS_table_name;
+  } else {
+    is_auto_table = true;
+    ObjectIdGenerator oid_generator;
+    table_name = Substitute("$0ycsb_auto_$1",
+        FLAGS_auto_database.empty() ? "" : FLAGS_auto_database + ".",
+        oid_generator.Next());
+  }
+  YcsbWorkload ycsb(client, table_name);
+  RETURN_NOT_OK(ycsb.Init());
+  RETURN_NOT_OK(ycsb.CreateTableIfNeeded(FLAGS_table_num_hash_partitions,
+                                         FLAGS_table_num_replicas));
+  cout << "Using " << (is_auto_table ? "auto-created " : "")
+       << "table '" << table_name << "'" << endl;
+  if (is_auto_table || FLAGS_ycsb_load) {
+    RETURN_NOT_OK(ycsb.Load());
+  }
+  RETURN_NOT_OK(ycsb.Run());
+  ycsb.PrintReport(&cout);
+
+  if (is_auto_table && !FLAGS_keep_auto_table) {
+    cout << "Dropping auto-created table '" << table_name << "'" << endl;
+    RETURN_NOT_OK(client->DeleteTable(table_name));
+  }
+  return Status::OK();
+}
+
 Status TabletScan(const RunnerContext& context) {
   const string& tablet_id = FindOrDie(context.required_args, kTabletIdArg);
 
@@ -913,6 +972,7 @@ unique_ptr<Mode> BuildPerfMode() {
           "or whether there is a long latency tail when scanning different tables.")
       .AddRequiredParameter({ kMasterAddressesArg, kMasterAddressesArgDesc })
       .AddRequiredParameter({ kTableNameArg, "Name of the table to scan"})
+      .AddOptionalParameter("columnar")
       .AddOptionalParameter("columns")
       .AddOptionalParameter("fill_cache")
       .AddOptionalParameter("num_threads")
@@ -920,6 +980,24 @@ unique_ptr<Mode> BuildPerfMode() {
       .AddOptionalParameter("tablets")
       .Build();
 
+  unique_ptr<Action> replay =
+      ActionBuilder("replay", &ReplayWorkload)
+      .Description("Replay a captured workload against a table")
+      .ExtraDescription(
+          "Replay the operations of a workload file against a table, with "
+          "the given concurrency and at the given rate, and report the "
+          "latency percentiles of each type of operation. Each line of the "
+          "file holds '<offset in ms> <operation> <JSON argument>', where the "
+          "operation is INSERT, UPSERT, UPDATE or DELETE with an object of "
+          "column values, GET with an object of key column values, or SCAN "
+          "with predicates in the syntax of the --predicates flag.")
+      .AddRequiredParameter({ kMasterAddressesArg, kMasterAddressesArgDesc })
+      .AddRequiredParameter({ kTableNameArg, "Name of the table to replay the workload against"})
+      .AddRequiredParameter({ kWorkloadFileArg, "Path of the workload file to replay"})
+      .AddOptionalParameter("num_threads")
+      .AddOptionalParameter("replay_speed")
+      .Build();
+
   unique_ptr<Action> tablet_scan =
       ActionBuilder("tablet_scan", &TabletScan)
       .Description("Show row count of a local tablet")
@@ -930,11 +1008,46 @@ unique_ptr<Mode> BuildPerfMode() {
       .AddOptionalParameter("num_iters")
       .AddOptionalParameter("ordered_scan")
       .Build();
+  unique_ptr<Action> ycsb =
+      ActionBuilder("ycsb", &RunYcsb)
+      .Description("Run a YCSB workload")
+      .ExtraDescription(
+          "Run one of the core YCSB workloads A to F: load records into an "
+          "existing or auto-created table, then run a mix of reads, updates, "
+          "inserts, short scans and read-modify-writes whose keys follow a "
+          "uniform, zipfian or latest distribution, and report the throughput "
+          "and latency percentiles of each type of operation. The table must "
+          "have a STRING primary key column named 'key' and STRING columns "
+          "named 'field0', 'field1', etc.")
+      .AddRequiredParameter({ kMasterAddressesArg, kMasterAddressesArgDesc })
+      .AddOptionalParameter("auto_database")
+      .AddOptionalParameter("keep_auto_table")
+      .AddOptionalParameter("num_threads")
+      .AddOptionalParameter("table_name", boost::none, string(
+          "Name of the table to run the workload against. It is created with "
+          "the schema of the workload if it doesn't exist. If left empty, "
+          "the workload runs against an auto-created table, which is dropped "
+          "upon completion unless '--keep_auto_table' is set."))
+      .AddOptionalParameter("table_num_hash_partitions")
+      .AddOptionalParameter("table_num_replicas")
+      .AddOptionalParameter("ycsb_field_count")
+      .AddOptionalParameter("ycsb_field_length")
+      .AddOptionalParameter("ycsb_load")
+      .AddOptionalParameter("ycsb_max_scan_length")
+      .AddOptionalParameter("ycsb_operation_count")
+      .AddOptionalParameter("ycsb_record_count")
+      .AddOptionalParameter("ycsb_request_distribution")
+      .AddOptionalParameter("ycsb_workload")
+      .AddOptionalParameter("ycsb_zipfian_constant")
+      .Build();
+
   return ModeBuilder("perf")
       .Description("Measure the performance of a Kudu cluster")
       .AddAction(std::move(loadgen))
+      .AddAction(std::move(replay))
       .AddAction(std::move(table_scan))
       .AddAction(std::move(tablet_scan))
+      .AddAction(std::move(ycsb))
       .Build();
 }
 
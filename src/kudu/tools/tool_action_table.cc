@@ -945,6 +945,12 @@ Status ToClientEncodingType(
     case ColumnPB::BIT_SHUFFLE :
       *type = KuduColumnStorageAttributes::BIT_SHUFFLE;
       break;
+    case ColumnPB::FOR_BITPACK :
+      *type = KuduColumnStorageAttributes::FOR_BITPACK;
+      break;
+    case ColumnPB::FSST_ENCODING :
+      *type = KuduColumnStorageAttributes::FSST_ENCODING;
+      break;
     default :
       s = Status::InvalidArgument(Substitute("Unexpected encoding type: $0", type_pb));
   }
@@ -1254,6 +1260,8 @@ unique_ptr<Mode> BuildTableMode() {
       .AddRequiredParameter({ kMasterAddressesArg, kMasterAddressesArgDesc })
       .AddRequiredParameter({ kTableNameArg, "Name of the source table" })
       .AddRequiredParameter({ kDestMasterAddressesArg, kDestMasterAddressesArgDesc })
+      .AddOptionalParameter("columnar")
+      .AddOptionalParameter("columnar_copy_max_queued_batches")
       .AddOptionalParameter("create_table")
       .AddOptionalParameter("dst_table")
       .AddOptionalParameter("num_threads")
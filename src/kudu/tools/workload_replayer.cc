@@ -0,0 +1,434 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tools/workload_replayer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+#include <glog/logging.h>
+#include <rapidjson/document.h>
+
+#include "kudu/client/scan_batch.h"
+#include "kudu/client/scan_predicate.h"
+#include "kudu/client/schema.h"
+#include "kudu/client/value.h"
+#include "kudu/client/write_op.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/stl_util.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/strip.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/tools/table_scanner.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/int128.h"
+#include "kudu/util/jsonreader.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/string_case.h"
+
+using kudu::client::KuduColumnSchema;
+using kudu::client::KuduError;
+using kudu::client::KuduPredicate;
+using kudu::client::KuduScanBatch;
+using kudu::client::KuduScanner;
+using kudu::client::KuduSchema;
+using kudu::client::KuduSession;
+using kudu::client::KuduValue;
+using kudu::client::KuduWriteOperation;
+using std::endl;
+using std::ifstream;
+using std::ostream;
+using std::string;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tools {
+
+namespace {
+
+// Latencies above a minute are recorded as a minute.
+const uint64_t kMaxLatencyUs = 60 * 1000 * 1000;
+
+Status CheckJsonType(bool matches, const KuduColumnSchema& col) {
+  if (PREDICT_FALSE(!matches)) {
+    return Status::InvalidArgument(Substitute("invalid value for column $0 of type $1",
+        col.name(), KuduColumnSchema::DataTypeToString(col.type())));
+  }
+  return Status::OK();
+}
+
+// Sets the cell of column 'col_idx' of 'row' to 'value'.
+Status SetCell(const KuduColumnSchema& col, int col_idx, const rapidjson::Value& value,
+               KuduPartialRow* row) {
+  if (value.IsNull()) {
+    return row->SetNull(col_idx);
+  }
+  switch (col.type()) {
+    case KuduColumnSchema::INT8:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetInt8(col_idx, static_cast<int8_t>(value.GetInt64()));
+    case KuduColumnSchema::INT16:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetInt16(col_idx, static_cast<int16_t>(value.GetInt64()));
+    case KuduColumnSchema::INT32:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetInt32(col_idx, static_cast<int32_t>(value.GetInt64()));
+    case KuduColumnSchema::INT64:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetInt64(col_idx, value.GetInt64());
+    case KuduColumnSchema::UNIXTIME_MICROS:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetUnixTimeMicros(col_idx, value.GetInt64());
+    case KuduColumnSchema::DATE:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetDate(col_idx, static_cast<int32_t>(value.GetInt64()));
+    case KuduColumnSchema::DECIMAL:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      return row->SetUnscaledDecimal(col_idx, value.GetInt64());
+    case KuduColumnSchema::STRING:
+      RETURN_NOT_OK(CheckJsonType(value.IsString(), col));
+      return row->SetStringCopy(col_idx, Slice(value.GetString(), value.GetStringLength()));
+    case KuduColumnSchema::VARCHAR:
+      RETURN_NOT_OK(CheckJsonType(value.IsString(), col));
+      return row->SetVarchar(col_idx, Slice(value.GetString(), value.GetStringLength()));
+    case KuduColumnSchema::BINARY:
+      RETURN_NOT_OK(CheckJsonType(value.IsString(), col));
+      return row->SetBinaryCopy(col_idx, Slice(value.GetString(), value.GetStringLength()));
+    case KuduColumnSchema::BOOL:
+      RETURN_NOT_OK(CheckJsonType(value.IsBool(), col));
+      return row->SetBool(col_idx, value.GetBool());
+    case KuduColumnSchema::FLOAT:
+      RETURN_NOT_OK(CheckJsonType(value.IsNumber(), col));
+      return row->SetFloat(col_idx, static_cast<float>(value.GetDouble()));
+    case KuduColumnSchema::DOUBLE:
+      RETURN_NOT_OK(CheckJsonType(value.IsNumber(), col));
+      return row->SetDouble(col_idx, value.GetDouble());
+    default:
+      return Status::NotSupported(Substitute("unsupported type of column $0", col.name()));
+  }
+}
+
+// Returns a new value of the type of 'col' holding 'value'.
+Status NewValue(const KuduColumnSchema& col, const rapidjson::Value& value,
+                unique_ptr<KuduValue>* kudu_value) {
+  switch (col.type()) {
+    case KuduColumnSchema::INT8:
+    case KuduColumnSchema::INT16:
+    case KuduColumnSchema::INT32:
+    case KuduColumnSchema::INT64:
+    case KuduColumnSchema::UNIXTIME_MICROS:
+    case KuduColumnSchema::DATE:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      kudu_value->reset(KuduValue::FromInt(value.GetInt64()));
+      break;
+    case KuduColumnSchema::DECIMAL:
+      RETURN_NOT_OK(CheckJsonType(value.IsInt64(), col));
+      kudu_value->reset(KuduValue::FromDecimal(value.GetInt64(),
+                                               col.type_attributes().scale()));
+      break;
+    case KuduColumnSchema::STRING:
+    case KuduColumnSchema::VARCHAR:
+    case KuduColumnSchema::BINARY:
+      RETURN_NOT_OK(CheckJsonType(value.IsString(), col));
+      kudu_value->reset(KuduValue::CopyString(
+          Slice(value.GetString(), value.GetStringLength())));
+      break;
+    case KuduColumnSchema::BOOL:
+      RETURN_NOT_OK(CheckJsonType(value.IsBool(), col));
+      kudu_value->reset(KuduValue::FromBool(value.GetBool()));
+      break;
+    case KuduColumnSchema::FLOAT:
+      RETURN_NOT_OK(CheckJsonType(value.IsNumber(), col));
+      kudu_value->reset(KuduValue::FromFloat(static_cast<float>(value.GetDouble())));
+      break;
+    case KuduColumnSchema::DOUBLE:
+      RETURN_NOT_OK(CheckJsonType(value.IsNumber(), col));
+      kudu_value->reset(KuduValue::FromDouble(value.GetDouble()));
+      break;
+    default:
+      return Status::NotSupported(Substitute("unsupported type of column $0", col.name()));
+  }
+  return Status::OK();
+}
+
+} // anonymous namespace
+
+WorkloadReplayer::OpStats::OpStats()
+    : latency_us(new HdrHistogram(kMaxLatencyUs, 2)),
+      errors(0),
+      rows_scanned(0) {
+}
+
+WorkloadReplayer::WorkloadReplayer(client::sp::shared_ptr<client::KuduClient> client,
+                                   string table_name)
+    : client_(std::move(client)),
+      table_name_(std::move(table_name)),
+      next_op_(0),
+      total_stats_(kNumOpTypes) {
+}
+
+WorkloadReplayer::~WorkloadReplayer() {
+}
+
+const char* WorkloadReplayer::OpTypeToString(OpType type) {
+  switch (type) {
+    case kInsert: return "INSERT";
+    case kUpsert: return "UPSERT";
+    case kUpdate: return "UPDATE";
+    case kDelete: return "DELETE";
+    case kGet: return "GET";
+    case kScan: return "SCAN";
+    default: LOG(FATAL) << "unknown op type " << type;
+  }
+  return nullptr;
+}
+
+Status WorkloadReplayer::Load(const string& path) {
+  RETURN_NOT_OK(client_->OpenTable(table_name_, &table_));
+  const Schema schema = KuduSchema::ToSchema(table_->schema());
+  for (int i = 0; i < schema.num_columns(); i++) {
+    column_indexes_[schema.column(i).name()] = i;
+  }
+  ifstream in(path);
+  if (!in) {
+    return Status::IOError("unable to open workload file", path, errno);
+  }
+  string line;
+  int line_num = 0;
+  while (std::getline(in, line)) {
+    line_num++;
+    StripWhiteSpace(&line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    Op op;
+    RETURN_NOT_OK_PREPEND(ParseLine(line, &op),
+                          Substitute("$0:$1: invalid operation", path, line_num));
+    ops_.emplace_back(std::move(op));
+  }
+  if (in.bad()) {
+    return Status::IOError("unable to read workload file", path);
+  }
+  return Status::OK();
+}
+
+Status WorkloadReplayer::ParseLine(const string& line, Op* op) const {
+  size_t type_start = line.find_first_of(" \t");
+  size_t type_end = type_start == string::npos ?
+      string::npos : line.find_first_of(" \t", line.find_first_not_of(" \t", type_start));
+  if (type_end == string::npos) {
+    return Status::InvalidArgument("expected '<offset in ms> <operation> <JSON argument>'");
+  }
+  int64_t offset_ms;
+  if (!safe_strto64(line.substr(0, type_start), &offset_ms) || offset_ms < 0) {
+    return Status::InvalidArgument("invalid offset", line.substr(0, type_start));
+  }
+  op->offset = MonoDelta::FromMilliseconds(offset_ms);
+
+  string type;
+  ToUpperCase(line.substr(type_start, type_end - type_start), &type);
+  StripWhiteSpace(&type);
+  const string arg = line.substr(type_end);
+  if (type == "SCAN") {
+    op->type = kScan;
+    return ParsePredicates(table_, arg, &op->predicates);
+  }
+
+  if (type == "INSERT") {
+    op->type = kInsert;
+    op->write.reset(table_->NewInsert());
+  } else if (type == "UPSERT") {
+    op->type = kUpsert;
+    op->write.reset(table_->NewUpsert());
+  } else if (type == "UPDATE") {
+    op->type = kUpdate;
+    op->write.reset(table_->NewUpdate());
+  } else if (type == "DELETE") {
+    op->type = kDelete;
+    op->write.reset(table_->NewDelete());
+  } else if (type == "GET") {
+    op->type = kGet;
+  } else {
+    return Status::InvalidArgument("unknown operation", type);
+  }
+
+  JsonReader reader(arg);
+  RETURN_NOT_OK(reader.Init());
+  const rapidjson::Value* cells = reader.root();
+  if (!cells->IsObject()) {
+    return Status::InvalidArgument("expected an object of column values", arg);
+  }
+  for (auto it = cells->MemberBegin(); it != cells->MemberEnd(); ++it) {
+    const string name = it->name.GetString();
+    const int* col_idx = FindOrNull(column_indexes_, name);
+    if (col_idx == nullptr) {
+      return Status::NotFound("no such column", name);
+    }
+    const KuduColumnSchema col = table_->schema().Column(*col_idx);
+    if (op->type == kGet) {
+      unique_ptr<KuduValue> value;
+      RETURN_NOT_OK(NewValue(col, it->value, &value));
+      op->predicates.emplace_back(table_->NewComparisonPredicate(
+          name, KuduPredicate::EQUAL, value.release()));
+    } else {
+      RETURN_NOT_OK(SetCell(col, *col_idx, it->value, op->write->mutable_row()));
+    }
+  }
+  return Status::OK();
+}
+
+Status WorkloadReplayer::Run(int num_threads, double speed) {
+  CHECK_GT(num_threads, 0);
+  CHECK_GE(speed, 0);
+  next_op_.Store(0);
+  vector<ThreadStats> stats;
+  stats.reserve(num_threads);
+  vector<Status> statuses(num_threads);
+  vector<thread> threads;
+  const MonoTime start = MonoTime::Now();
+  for (int i = 0; i < num_threads; i++) {
+    stats.emplace_back(kNumOpTypes);
+    threads.emplace_back(&WorkloadReplayer::ReplayThread, this, start, speed,
+                         &stats.back(), &statuses[i]);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  elapsed_ = MonoTime::Now() - start;
+
+  for (const auto& thread_stats : stats) {
+    for (int i = 0; i < kNumOpTypes; i++) {
+      total_stats_[i].latency_us->MergeFrom(*thread_stats[i].latency_us);
+      total_stats_[i].errors += thread_stats[i].errors;
+      total_stats_[i].rows_scanned += thread_stats[i].rows_scanned;
+    }
+  }
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
+}
+
+void WorkloadReplayer::ReplayThread(MonoTime start, double speed, ThreadStats* stats,
+                                    Status* status) {
+  client::sp::shared_ptr<KuduSession> session(client_->NewSession());
+  *status = session->SetFlushMode(KuduSession::AUTO_FLUSH_SYNC);
+  if (!status->ok()) {
+    return;
+  }
+  while (true) {
+    int64_t idx = next_op_.IncrementBy(1) - 1;
+    if (idx >= static_cast<int64_t>(ops_.size())) {
+      break;
+    }
+    Op* op = &ops_[idx];
+    if (speed > 0) {
+      const MonoTime deadline = start + MonoDelta::FromNanoseconds(
+          static_cast<int64_t>(op->offset.ToNanoseconds() / speed));
+      const MonoTime now = MonoTime::Now();
+      if (deadline > now) {
+        SleepFor(deadline - now);
+      }
+    }
+
+    OpStats* op_stats = &(*stats)[op->type];
+    bool op_error = false;
+    const MonoTime op_start = MonoTime::Now();
+    *status = Execute(op, session.get(), &op_stats->rows_scanned, &op_error);
+    if (!status->ok()) {
+      return;
+    }
+    const MonoDelta latency = MonoTime::Now() - op_start;
+    op_stats->latency_us->Increment(
+        std::min<int64_t>(latency.ToMicroseconds(), kMaxLatencyUs));
+    if (op_error) {
+      op_stats->errors++;
+    }
+  }
+}
+
+Status WorkloadReplayer::Execute(Op* op, KuduSession* session, uint64_t* rows_scanned,
+                                 bool* op_error) {
+  if (op->write) {
+    if (!session->Apply(op->write.release()).ok()) {
+      *op_error = true;
+      vector<KuduError*> errors;
+      ElementDeleter d(&errors);
+      session->GetPendingErrors(&errors, nullptr);
+    }
+    return Status::OK();
+  }
+
+  KuduScanner scanner(table_.get());
+  for (auto& predicate : op->predicates) {
+    RETURN_NOT_OK(scanner.AddConjunctPredicate(predicate.release()));
+  }
+  Status s = scanner.Open();
+  KuduScanBatch batch;
+  while (s.ok() && scanner.HasMoreRows()) {
+    s = scanner.NextBatch(&batch);
+    *rows_scanned += batch.NumRows();
+  }
+  *op_error = !s.ok();
+  return Status::OK();
+}
+
+void WorkloadReplayer::PrintReport(ostream* out) const {
+  uint64_t total_ops = 0;
+  for (const auto& op_stats : total_stats_) {
+    total_ops += op_stats.latency_us->TotalCount();
+  }
+  *out << "Replayed " << total_ops << " operations in "
+       << elapsed_.ToSeconds() << " s ("
+       << (elapsed_.ToSeconds() > 0 ? total_ops / elapsed_.ToSeconds() : 0)
+       << " ops/s)" << endl;
+  *out << std::left << std::setw(8) << "op" << std::right
+       << std::setw(10) << "count" << std::setw(8) << "errors"
+       << std::setw(12) << "rows" << std::setw(10) << "mean_us"
+       << std::setw(10) << "p50_us" << std::setw(10) << "p95_us"
+       << std::setw(10) << "p99_us" << std::setw(10) << "p999_us"
+       << std::setw(10) << "max_us" << endl;
+  for (int i = 0; i < kNumOpTypes; i++) {
+    const OpStats& op_stats = total_stats_[i];
+    const HdrHistogram& h = *op_stats.latency_us;
+    if (h.TotalCount() == 0) {
+      continue;
+    }
+    *out << std::left << std::setw(8) << OpTypeToString(static_cast<OpType>(i)) << std::right
+         << std::setw(10) << h.TotalCount() << std::setw(8) << op_stats.errors
+         << std::setw(12) << op_stats.rows_scanned
+         << std::setw(10) << static_cast<uint64_t>(h.MeanValue())
+         << std::setw(10) << h.ValueAtPercentile(50)
+         << std::setw(10) << h.ValueAtPercentile(95)
+         << std::setw(10) << h.ValueAtPercentile(99)
+         << std::setw(10) << h.ValueAtPercentile(99.9)
+         << std::setw(10) << h.MaxValue() << endl;
+  }
+}
+
+} // namespace tools
+} // namespace kudu
@@ -0,0 +1,147 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/util/atomic.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class HdrHistogram;
+
+namespace client {
+class KuduPredicate;
+class KuduWriteOperation;
+}  // namespace client
+
+namespace tools {
+
+// Replays a captured workload against a table, measuring the latency of each
+// operation.
+//
+// A workload file holds one operation per line, in the form
+//
+//   <offset in ms> <operation> <JSON argument>
+//
+// where the offset is the time at which the operation was issued relative
+// to the start of the workload, and the operation is one of:
+//
+//   INSERT, UPSERT, UPDATE, DELETE: the argument is an object mapping the
+//       names of the columns of the row to their values, e.g.
+//       {"key": 1, "val": "a"}.
+//   GET: a point lookup, whose argument is an object mapping the names of
+//       the key columns to their values.
+//   SCAN: the argument is a conjunction of predicates, in the syntax of the
+//       --predicates flag of 'kudu table scan', e.g. ["AND", [">=", "key", 10]].
+//
+// Empty lines and lines starting with '#' are ignored.
+//
+// All operations are parsed when the workload is loaded so that the measured
+// latencies don't include any parsing.
+//
+// This class is not thread-safe.
+class WorkloadReplayer {
+ public:
+  WorkloadReplayer(client::sp::shared_ptr<client::KuduClient> client,
+                   std::string table_name);
+  ~WorkloadReplayer();
+
+  // Loads the operations of the workload file at 'path'.
+  Status Load(const std::string& path);
+
+  // Replays the loaded operations with 'num_threads' concurrent sessions.
+  //
+  // The operations are dispatched in the order of the file, each one no
+  // earlier than its offset divided by 'speed', or as fast as possible if
+  // 'speed' is 0. Errors of individual operations are counted, not returned.
+  Status Run(int num_threads, double speed);
+
+  // Writes the count, error count and latency percentiles of each type of
+  // operation replayed by Run() to 'out'.
+  void PrintReport(std::ostream* out) const;
+
+ private:
+  enum OpType {
+    kInsert,
+    kUpsert,
+    kUpdate,
+    kDelete,
+    kGet,
+    kScan,
+    kNumOpTypes
+  };
+
+  struct Op {
+    MonoDelta offset;
+    OpType type;
+    // Set for INSERT, UPSERT, UPDATE and DELETE.
+    std::unique_ptr<client::KuduWriteOperation> write;
+    // Set for GET and SCAN.
+    std::vector<std::unique_ptr<client::KuduPredicate>> predicates;
+  };
+
+  // Latencies and counters of the operations of one type.
+  struct OpStats {
+    OpStats();
+
+    std::unique_ptr<HdrHistogram> latency_us;
+    uint64_t errors;
+    uint64_t rows_scanned;
+  };
+  typedef std::vector<OpStats> ThreadStats;
+
+  Status ParseLine(const std::string& line, Op* op) const;
+
+  // Runs the operations dispatched to a thread with its own session,
+  // accumulating their stats into 'stats'.
+  void ReplayThread(MonoTime start, double speed, ThreadStats* stats, Status* status);
+
+  // Executes 'op' in 'session'. Returns a bad status only if the replay
+  // can't continue, and sets 'op_error' if the operation itself failed.
+  Status Execute(Op* op, client::KuduSession* session, uint64_t* rows_scanned,
+                 bool* op_error);
+
+  static const char* OpTypeToString(OpType type);
+
+  const client::sp::shared_ptr<client::KuduClient> client_;
+  const std::string table_name_;
+  client::sp::shared_ptr<client::KuduTable> table_;
+  std::unordered_map<std::string, int> column_indexes_;
+
+  std::vector<Op> ops_;
+
+  // Index of the next operation to dispatch.
+  AtomicInt<int64_t> next_op_;
+
+  ThreadStats total_stats_;
+  MonoDelta elapsed_;
+};
+
+} // namespace tools
+} // namespace kudu
@@ -0,0 +1,525 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tools/ycsb_workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/client/scan_batch.h"
+#include "kudu/client/scan_predicate.h"
+#include "kudu/client/schema.h"
+#include "kudu/client/value.h"
+#include "kudu/client/write_op.h"
+#include "kudu/common/partial_row.h"
+#include "kudu/gutil/stl_util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/hdr_histogram.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/random.h"
+#include "kudu/util/random_util.h"
+
+DEFINE_string(ycsb_workload, "a",
+              "The core YCSB workload to run: 'a' (50% reads, 50% updates), "
+              "'b' (95% reads, 5% updates), 'c' (reads only), 'd' (95% reads "
+              "of the latest records, 5% inserts), 'e' (95% short scans, 5% "
+              "inserts) or 'f' (50% reads, 50% read-modify-writes).");
+DEFINE_int64(ycsb_record_count, 10000,
+             "Number of records the YCSB workload operates on.");
+DEFINE_int64(ycsb_operation_count, 10000,
+             "Number of operations to run in the YCSB workload, across all threads.");
+DEFINE_string(ycsb_request_distribution, "",
+              "Distribution of the keys accessed by the YCSB workload: "
+              "'uniform', 'zipfian' or 'latest'. If empty, the distribution "
+              "of the core workload is used.");
+DEFINE_double(ycsb_zipfian_constant, 0.99,
+              "Skew of the zipfian and latest key distributions, in (0, 1).");
+DEFINE_int32(ycsb_field_count, 10,
+             "Number of string fields of the records of the YCSB workload.");
+DEFINE_int32(ycsb_field_length, 100,
+             "Length of the string fields of the records of the YCSB workload.");
+DEFINE_int32(ycsb_max_scan_length, 100,
+             "Maximum number of records read by a scan of the YCSB workload. "
+             "The length of each scan is uniformly distributed.");
+DEFINE_bool(ycsb_load, true,
+            "Whether to insert the records of the YCSB workload before running "
+            "it. May be disabled to rerun a workload against a table loaded "
+            "by a previous run.");
+
+DECLARE_int32(num_threads);
+
+using kudu::client::KuduColumnSchema;
+using kudu::client::KuduError;
+using kudu::client::KuduInsert;
+using kudu::client::KuduPredicate;
+using kudu::client::KuduScanBatch;
+using kudu::client::KuduScanner;
+using kudu::client::KuduSchema;
+using kudu::client::KuduSchemaBuilder;
+using kudu::client::KuduSession;
+using kudu::client::KuduTable;
+using kudu::client::KuduTableCreator;
+using kudu::client::KuduUpdate;
+using kudu::client::KuduValue;
+using std::endl;
+using std::ostream;
+using std::string;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace tools {
+
+namespace {
+
+const char* const kKeyColumnName = "key";
+
+// Latencies above a minute are recorded as a minute.
+const uint64_t kMaxLatencyUs = 60 * 1000 * 1000;
+
+string FieldName(int i) {
+  return Substitute("field$0", i);
+}
+
+// Returns a field value of printable characters.
+string RandomFieldValue(Random* rng) {
+  string value(FLAGS_ycsb_field_length, ' ');
+  for (auto& c : value) {
+    c = static_cast<char>(' ' + rng->Uniform('~' - ' ' + 1));
+  }
+  return value;
+}
+
+// The 64-bit FNV-1a hash of the bytes of 'val', as used by YCSB.
+uint64_t FnvHash64(uint64_t val) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; i++) {
+    hash ^= val & 0xff;
+    hash *= 0x100000001b3ULL;
+    val >>= 8;
+  }
+  return hash;
+}
+
+// Reads the rows whose key is at least 'key', up to 'limit' of them, or
+// only the row with key 'key' if 'limit' is 0.
+Status ReadRows(KuduTable* table, const string& key, int64_t limit) {
+  KuduScanner scanner(table);
+  if (limit == 0) {
+    RETURN_NOT_OK(scanner.AddConjunctPredicate(table->NewComparisonPredicate(
+        kKeyColumnName, KuduPredicate::EQUAL, KuduValue::CopyString(key))));
+  } else {
+    RETURN_NOT_OK(scanner.AddConjunctPredicate(table->NewComparisonPredicate(
+        kKeyColumnName, KuduPredicate::GREATER_EQUAL, KuduValue::CopyString(key))));
+    RETURN_NOT_OK(scanner.SetLimit(limit));
+  }
+  RETURN_NOT_OK(scanner.Open());
+  KuduScanBatch batch;
+  while (scanner.HasMoreRows()) {
+    RETURN_NOT_OK(scanner.NextBatch(&batch));
+  }
+  return Status::OK();
+}
+
+// Applies 'op' in 'session', which must be in AUTO_FLUSH_SYNC mode.
+Status ApplySync(KuduSession* session, client::KuduWriteOperation* op) {
+  Status s = session->Apply(op);
+  if (!s.ok()) {
+    vector<KuduError*> errors;
+    ElementDeleter d(&errors);
+    session->GetPendingErrors(&errors, nullptr);
+    if (!errors.empty()) {
+      return errors.front()->status();
+    }
+  }
+  return s;
+}
+
+} // anonymous namespace
+
+ZipfianGenerator::ZipfianGenerator(uint64_t num_items, double theta)
+    : num_items_(num_items),
+      theta_(theta) {
+  CHECK_GT(num_items, 0);
+  CHECK(theta > 0 && theta < 1) << theta;
+  zetan_ = 0;
+  for (uint64_t i = 1; i <= num_items; i++) {
+    zetan_ += 1 / std::pow(static_cast<double>(i), theta);
+  }
+  const double zeta2 = 1 + 1 / std::pow(2.0, theta);
+  alpha_ = 1 / (1 - theta);
+  eta_ = (1 - std::pow(2.0 / num_items, 1 - theta)) / (1 - zeta2 / zetan_);
+}
+
+uint64_t ZipfianGenerator::Next(Random* rng) const {
+  const double u = rng->NextDoubleFraction();
+  const double uz = u * zetan_;
+  if (uz < 1) {
+    return 0;
+  }
+  if (uz < 1 + std::pow(0.5, theta_)) {
+    return std::min<uint64_t>(1, num_items_ - 1);
+  }
+  const auto rank = static_cast<uint64_t>(
+      num_items_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+  return std::min(rank, num_items_ - 1);
+}
+
+YcsbWorkload::OpStats::OpStats()
+    : latency_us(new HdrHistogram(kMaxLatencyUs, 2)),
+      errors(0) {
+}
+
+YcsbWorkload::YcsbWorkload(client::sp::shared_ptr<client::KuduClient> client,
+                           string table_name)
+    : client_(std::move(client)),
+      table_name_(std::move(table_name)),
+      next_keynum_(0),
+      load_errors_(0),
+      total_stats_(kNumOpTypes) {
+}
+
+YcsbWorkload::~YcsbWorkload() {
+}
+
+Status YcsbWorkload::Init() {
+  //                           read  update insert scan  rmw
+  static const WorkloadSpec kWorkloadA = {{ 0.5,  0.5,   0,     0,    0   }, kZipfian };
+  static const WorkloadSpec kWorkloadB = {{ 0.95, 0.05,  0,     0,    0   }, kZipfian };
+  static const WorkloadSpec kWorkloadC = {{ 1,    0,     0,     0,    0   }, kZipfian };
+  static const WorkloadSpec kWorkloadD = {{ 0.95, 0,     0.05,  0,    0   }, kLatest };
+  static const WorkloadSpec kWorkloadE = {{ 0,    0,     0.05,  0.95, 0   }, kZipfian };
+  static const WorkloadSpec kWorkloadF = {{ 0.5,  0,     0,     0,    0.5 }, kZipfian };
+  const string& workload = FLAGS_ycsb_workload;
+  if (workload == "a") {
+    spec_ = kWorkloadA;
+  } else if (workload == "b") {
+    spec_ = kWorkloadB;
+  } else if (workload == "c") {
+    spec_ = kWorkloadC;
+  } else if (workload == "d") {
+    spec_ = kWorkloadD;
+  } else if (workload == "e") {
+    spec_ = kWorkloadE;
+  } else if (workload == "f") {
+    spec_ = kWorkloadF;
+  } else {
+    return Status::InvalidArgument("unknown YCSB workload", workload);
+  }
+
+  const string& distribution = FLAGS_ycsb_request_distribution;
+  if (distribution == "uniform") {
+    spec_.distribution = kUniform;
+  } else if (distribution == "zipfian") {
+    spec_.distribution = kZipfian;
+  } else if (distribution == "latest") {
+    spec_.distribution = kLatest;
+  } else if (!distribution.empty()) {
+    return Status::InvalidArgument("unknown request distribution", distribution);
+  }
+
+  if (FLAGS_ycsb_record_count <= 0) {
+    return Status::InvalidArgument("--ycsb_record_count must be positive");
+  }
+  if (FLAGS_ycsb_operation_count < 0) {
+    return Status::InvalidArgument("--ycsb_operation_count must not be negative");
+  }
+  if (FLAGS_ycsb_field_count <= 0 || FLAGS_ycsb_field_length < 0) {
+    return Status::InvalidArgument("invalid --ycsb_field_count or --ycsb_field_length");
+  }
+  if (FLAGS_ycsb_max_scan_length <= 0) {
+    return Status::InvalidArgument("--ycsb_max_scan_length must be positive");
+  }
+  if (FLAGS_ycsb_zipfian_constant <= 0 || FLAGS_ycsb_zipfian_constant >= 1) {
+    return Status::InvalidArgument("--ycsb_zipfian_constant must be in (0, 1)");
+  }
+  if (spec_.distribution != kUniform) {
+    zipfian_.reset(new ZipfianGenerator(FLAGS_ycsb_record_count,
+                                        FLAGS_ycsb_zipfian_constant));
+  }
+  // The records are assumed to have been loaded by Load() or a previous run.
+  next_keynum_.Store(FLAGS_ycsb_record_count);
+  return Status::OK();
+}
+
+Status YcsbWorkload::CreateTableIfNeeded(int num_hash_partitions, int num_replicas) {
+  bool exists;
+  RETURN_NOT_OK(client_->TableExists(table_name_, &exists));
+  if (!exists) {
+    KuduSchema schema;
+    KuduSchemaBuilder b;
+    b.AddColumn(kKeyColumnName)->Type(KuduColumnSchema::STRING)->NotNull()->PrimaryKey();
+    for (int i = 0; i < FLAGS_ycsb_field_count; i++) {
+      b.AddColumn(FieldName(i))->Type(KuduColumnSchema::STRING);
+    }
+    RETURN_NOT_OK(b.Build(&schema));
+
+    unique_ptr<KuduTableCreator> table_creator(client_->NewTableCreator());
+    table_creator->table_name(table_name_)
+        .schema(&schema)
+        .set_range_partition_columns({});
+    if (num_hash_partitions > 1) {
+      table_creator->add_hash_partitions({ kKeyColumnName }, num_hash_partitions);
+    }
+    if (num_replicas > 0) {
+      table_creator->num_replicas(num_replicas);
+    }
+    RETURN_NOT_OK(table_creator->Create());
+  }
+  return client_->OpenTable(table_name_, &table_);
+}
+
+string YcsbWorkload::KeyName(uint64_t keynum) {
+  return Substitute("user$0", FnvHash64(keynum));
+}
+
+const char* YcsbWorkload::OpTypeToString(OpType type) {
+  switch (type) {
+    case kRead: return "READ";
+    case kUpdate: return "UPDATE";
+    case kInsert: return "INSERT";
+    case kScan: return "SCAN";
+    case kReadModifyWrite: return "RMW";
+    default: LOG(FATAL) << "unknown op type " << type;
+  }
+  return nullptr;
+}
+
+uint64_t YcsbWorkload::NextKeynum(uint64_t num_records, Random* rng) const {
+  switch (spec_.distribution) {
+    case kUniform:
+      return rng->Uniform64(num_records);
+    case kZipfian:
+      // Scramble the ranks so that the popular records aren't clustered at
+      // the beginning of the keyspace.
+      return FnvHash64(zipfian_->Next(rng)) % num_records;
+    case kLatest:
+      return num_records - 1 - std::min(zipfian_->Next(rng), num_records - 1);
+  }
+  LOG(FATAL) << "unknown distribution";
+  return 0;
+}
+
+Status YcsbWorkload::Load() {
+  CHECK(table_);
+  AtomicInt<int64_t> next_keynum(0);
+  vector<Status> statuses(FLAGS_num_threads);
+  vector<thread> threads;
+  const MonoTime start = MonoTime::Now();
+  for (int i = 0; i < FLAGS_num_threads; i++) {
+    threads.emplace_back([&, i]() {
+      client::sp::shared_ptr<KuduSession> session(client_->NewSession());
+      Status* status = &statuses[i];
+      *status = session->SetFlushMode(KuduSession::AUTO_FLUSH_BACKGROUND);
+      if (!status->ok()) {
+        return;
+      }
+      Random rng(GetRandomSeed32() + i);
+      int64_t keynum;
+      while ((keynum = next_keynum.IncrementBy(1) - 1) < FLAGS_ycsb_record_count) {
+        unique_ptr<KuduInsert> insert(table_->NewInsert());
+        KuduPartialRow* row = insert->mutable_row();
+        CHECK_OK(row->SetStringCopy(kKeyColumnName, KeyName(keynum)));
+        for (int f = 0; f < FLAGS_ycsb_field_count; f++) {
+          CHECK_OK(row->SetStringCopy(FieldName(f), RandomFieldValue(&rng)));
+        }
+        *status = session->Apply(insert.release());
+        if (!status->ok()) {
+          return;
+        }
+      }
+      *status = session->Flush();
+      vector<KuduError*> errors;
+      ElementDeleter d(&errors);
+      session->GetPendingErrors(&errors, nullptr);
+      load_errors_.IncrementBy(errors.size());
+      if (!errors.empty()) {
+        *status = Status::OK();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  load_elapsed_ = MonoTime::Now() - start;
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK_PREPEND(s, "unable to load the YCSB records");
+  }
+  return Status::OK();
+}
+
+Status YcsbWorkload::Run() {
+  CHECK(table_);
+  vector<ThreadStats> stats;
+  stats.reserve(FLAGS_num_threads);
+  vector<Status> statuses(FLAGS_num_threads);
+  vector<thread> threads;
+  const MonoTime start = MonoTime::Now();
+  for (int i = 0; i < FLAGS_num_threads; i++) {
+    stats.emplace_back(kNumOpTypes);
+    threads.emplace_back(&YcsbWorkload::RunThread, this, i, &stats.back(), &statuses[i]);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  run_elapsed_ = MonoTime::Now() - start;
+  MergeStats(stats);
+  for (const auto& s : statuses) {
+    RETURN_NOT_OK(s);
+  }
+  return Status::OK();
+}
+
+void YcsbWorkload::RunThread(int thread_idx, ThreadStats* stats, Status* status) {
+  client::sp::shared_ptr<KuduSession> session(client_->NewSession());
+  *status = session->SetFlushMode(KuduSession::AUTO_FLUSH_SYNC);
+  if (!status->ok()) {
+    return;
+  }
+  Random rng(GetRandomSeed32() + thread_idx);
+  // Spread the operations evenly across the threads.
+  const int64_t num_ops = FLAGS_ycsb_operation_count / FLAGS_num_threads +
+      (thread_idx < FLAGS_ycsb_operation_count % FLAGS_num_threads ? 1 : 0);
+
+  auto update = [&](const string& key) {
+    unique_ptr<KuduUpdate> update(table_->NewUpdate());
+    KuduPartialRow* row = update->mutable_row();
+    CHECK_OK(row->SetStringCopy(kKeyColumnName, key));
+    CHECK_OK(row->SetStringCopy(FieldName(rng.Uniform(FLAGS_ycsb_field_count)),
+                                RandomFieldValue(&rng)));
+    return ApplySync(session.get(), update.release());
+  };
+
+  for (int64_t i = 0; i < num_ops; i++) {
+    // Pick the type of the operation according to the proportions.
+    double p = rng.NextDoubleFraction();
+    int type = 0;
+    while (type < kNumOpTypes - 1 && p >= spec_.proportions[type]) {
+      p -= spec_.proportions[type];
+      type++;
+    }
+    while (spec_.proportions[type] == 0) {
+      type--;
+    }
+
+    // Generate the operation before starting the clock.
+    const uint64_t num_records = next_keynum_.Load();
+    string key;
+    unique_ptr<KuduInsert> insert;
+    int64_t scan_length = 0;
+    if (type == kInsert) {
+      insert.reset(table_->NewInsert());
+      KuduPartialRow* row = insert->mutable_row();
+      CHECK_OK(row->SetStringCopy(kKeyColumnName, KeyName(next_keynum_.IncrementBy(1) - 1)));
+      for (int f = 0; f < FLAGS_ycsb_field_count; f++) {
+        CHECK_OK(row->SetStringCopy(FieldName(f), RandomFieldValue(&rng)));
+      }
+    } else {
+      key = KeyName(NextKeynum(num_records, &rng));
+      scan_length = 1 + rng.Uniform(FLAGS_ycsb_max_scan_length);
+    }
+
+    const MonoTime op_start = MonoTime::Now();
+    Status s;
+    switch (type) {
+      case kRead:
+        s = ReadRows(table_.get(), key, 0);
+        break;
+      case kUpdate:
+        s = update(key);
+        break;
+      case kInsert:
+        s = ApplySync(session.get(), insert.release());
+        break;
+      case kScan:
+        s = ReadRows(table_.get(), key, scan_length);
+        break;
+      case kReadModifyWrite:
+        s = ReadRows(table_.get(), key, 0);
+        if (s.ok()) {
+          s = update(key);
+        }
+        break;
+    }
+    const MonoDelta latency = MonoTime::Now() - op_start;
+    OpStats* op_stats = &(*stats)[type];
+    op_stats->latency_us->Increment(
+        std::min<int64_t>(latency.ToMicroseconds(), kMaxLatencyUs));
+    if (!s.ok()) {
+      KLOG_EVERY_N_SECS(WARNING, 10) << OpTypeToString(static_cast<OpType>(type))
+                                     << " failed: " << s.ToString();
+      op_stats->errors++;
+    }
+  }
+}
+
+void YcsbWorkload::MergeStats(const vector<ThreadStats>& stats) {
+  for (const auto& thread_stats : stats) {
+    for (int i = 0; i < kNumOpTypes; i++) {
+      total_stats_[i].latency_us->MergeFrom(*thread_stats[i].latency_us);
+      total_stats_[i].errors += thread_stats[i].errors;
+    }
+  }
+}
+
+void YcsbWorkload::PrintReport(ostream* out) const {
+  if (load_elapsed_.Initialized()) {
+    const double secs = load_elapsed_.ToSeconds();
+    *out << "Loaded " << FLAGS_ycsb_record_count << " records in " << secs << " s ("
+         << (secs > 0 ? FLAGS_ycsb_record_count / secs : 0) << " records/s, "
+         << load_errors_.Load() << " errors)" << endl;
+  }
+  uint64_t total_ops = 0;
+  for (const auto& op_stats : total_stats_) {
+    total_ops += op_stats.latency_us->TotalCount();
+  }
+  const double secs = run_elapsed_.ToSeconds();
+  *out << "Ran " << total_ops << " operations of workload " << FLAGS_ycsb_workload
+       << " in " << secs << " s (" << (secs > 0 ? total_ops / secs : 0) << " ops/s)" << endl;
+  *out << std::left << std::setw(8) << "op" << std::right
+       << std::setw(10) << "count" << std::setw(8) << "errors"
+       << std::setw(12) << "ops/s" << std::setw(10) << "mean_us"
+       << std::setw(10) << "p50_us" << std::setw(10) << "p99_us"
+       << std::setw(10) << "p999_us" << std::setw(10) << "max_us" << endl;
+  for (int i = 0; i < kNumOpTypes; i++) {
+    const OpStats& op_stats = total_stats_[i];
+    const HdrHistogram& h = *op_stats.latency_us;
+    if (h.TotalCount() == 0) {
+      continue;
+    }
+    *out << std::left << std::setw(8) << OpTypeToString(static_cast<OpType>(i)) << std::right
+         << std::setw(10) << h.TotalCount() << std::setw(8) << op_stats.errors
+         << std::setw(12) << static_cast<uint64_t>(secs > 0 ? h.TotalCount() / secs : 0)
+         << std::setw(10) << static_cast<uint64_t>(h.MeanValue())
+         << std::setw(10) << h.ValueAtPercentile(50)
+         << std::setw(10) << h.ValueAtPercentile(99)
+         << std::setw(10) << h.ValueAtPercentile(99.9)
+         << std::setw(10) << h.MaxValue() << endl;
+  }
+}
+
+} // namespace tools
+} // namespace kudu
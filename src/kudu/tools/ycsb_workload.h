@@ -0,0 +1,157 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/client/client.h"
+#include "kudu/client/shared_ptr.h" // IWYU pragma: keep
+#include "kudu/util/atomic.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class HdrHistogram;
+class Random;
+
+namespace tools {
+
+// Generates the ranks of items following a Zipfian distribution, rank 0
+// being the most popular, using the algorithm of Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases", as YCSB does.
+//
+// This class is thread-safe.
+class ZipfianGenerator {
+ public:
+  // Generates ranks in [0, 'num_items') with skew 'theta', which must be in
+  // (0, 1). Takes time linear in 'num_items'.
+  ZipfianGenerator(uint64_t num_items, double theta);
+
+  uint64_t Next(Random* rng) const;
+
+ private:
+  const uint64_t num_items_;
+  const double theta_;
+  double alpha_;
+  double zetan_;
+  double eta_;
+};
+
+// Runs the core YCSB workloads against a table whose schema is a STRING key
+// column named "key" and string columns named "field0", "field1", etc.
+//
+// The workload, the number of records and operations and the distribution
+// of the keys are configured with the --ycsb_* flags, and the concurrency
+// with --num_threads.
+//
+// This class is not thread-safe.
+class YcsbWorkload {
+ public:
+  YcsbWorkload(client::sp::shared_ptr<client::KuduClient> client,
+               std::string table_name);
+  ~YcsbWorkload();
+
+  // Validates the flags of the workload.
+  Status Init();
+
+  // Creates the table with 'num_hash_partitions' hash partitions and
+  // 'num_replicas' replicas, unless it already exists. The replication
+  // factor of the cluster is used if 'num_replicas' is 0.
+  Status CreateTableIfNeeded(int num_hash_partitions, int num_replicas);
+
+  // Inserts the records of the workload.
+  Status Load();
+
+  // Runs the operations of the workload against the loaded records.
+  Status Run();
+
+  // Writes the throughput and the latency percentiles of each type of
+  // operation executed by Load() and Run() to 'out'.
+  void PrintReport(std::ostream* out) const;
+
+ private:
+  enum OpType {
+    kRead,
+    kUpdate,
+    kInsert,
+    kScan,
+    kReadModifyWrite,
+    kNumOpTypes
+  };
+
+  enum Distribution {
+    kUniform,
+    kZipfian,
+    kLatest
+  };
+
+  // The proportions of the types of operations of a workload, and the
+  // distribution of the keys they access.
+  struct WorkloadSpec {
+    double proportions[kNumOpTypes];
+    Distribution distribution;
+  };
+
+  // Latencies and counters of the operations of one type.
+  struct OpStats {
+    OpStats();
+
+    std::unique_ptr<HdrHistogram> latency_us;
+    uint64_t errors;
+  };
+  typedef std::vector<OpStats> ThreadStats;
+
+  // Returns the key of the 'keynum'th record. Hashing the record numbers
+  // spreads the keys of consecutive records across the key space.
+  static std::string KeyName(uint64_t keynum);
+
+  static const char* OpTypeToString(OpType type);
+
+  // Picks the record number of a key to access among the 'num_records'
+  // inserted records.
+  uint64_t NextKeynum(uint64_t num_records, Random* rng) const;
+
+  void RunThread(int thread_idx, ThreadStats* stats, Status* status);
+
+  // Merges 'stats' into 'total_stats_'.
+  void MergeStats(const std::vector<ThreadStats>& stats);
+
+  const client::sp::shared_ptr<client::KuduClient> client_;
+  const std::string table_name_;
+  client::sp::shared_ptr<client::KuduTable> table_;
+
+  WorkloadSpec spec_;
+  std::unique_ptr<ZipfianGenerator> zipfian_;
+
+  // The number of the next record to insert.
+  AtomicInt<int64_t> next_keynum_;
+  // The number of load errors.
+  AtomicInt<int64_t> load_errors_;
+
+  MonoDelta load_elapsed_;
+  MonoDelta run_elapsed_;
+  ThreadStats total_stats_;
+};
+
+} // namespace tools
+} // namespace kudu
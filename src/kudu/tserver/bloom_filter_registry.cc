@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/bloom_filter_registry.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/map-util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/block_bloom_filter.pb.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_int32(bloom_filter_registry_max_ttl_ms, 60 * 60 * 1000,
+             "Maximum amount of time, in milliseconds, for which a bloom filter "
+             "registered with the tablet server is kept, regardless of the "
+             "time to live requested when registering it.");
+TAG_FLAG(bloom_filter_registry_max_ttl_ms, experimental);
+
+using std::shared_ptr;
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+namespace tserver {
+
+BloomFilterRegistry::BloomFilterRegistry(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes),
+      total_bytes_(0) {
+}
+
+BloomFilterRegistry::~BloomFilterRegistry() {}
+
+string BloomFilterRegistry::MakeKey(const string& user, const string& filter_id) {
+  // Usernames can't contain NUL characters, so the key is unambiguous.
+  string key;
+  key.reserve(user.size() + 1 + filter_id.size());
+  key.append(user);
+  key.push_back('\0');
+  key.append(filter_id);
+  return key;
+}
+
+Status BloomFilterRegistry::Register(const string& user,
+                                     const string& filter_id,
+                                     const BlockBloomFilterPB& filter_pb,
+                                     MonoDelta ttl) {
+  if (!ttl.Initialized() || ttl.ToNanoseconds() <= 0) {
+    return Status::InvalidArgument("bloom filter time to live must be positive");
+  }
+  ttl = std::min(ttl, MonoDelta::FromMilliseconds(FLAGS_bloom_filter_registry_max_ttl_ms));
+
+  // Decode the filter before taking the lock: the filter may be large.
+  shared_ptr<BlockBloomFilter> filter = std::make_shared<BlockBloomFilter>(
+      DefaultBlockBloomFilterBufferAllocator::GetSingleton());
+  RETURN_NOT_OK_PREPEND(filter->InitFromPB(filter_pb),
+                        Substitute("invalid bloom filter $0", filter_id));
+  const size_t size_bytes = filter_id.size() + filter_pb.bloom_data().size();
+
+  const MonoTime now = MonoTime::Now();
+  string key = MakeKey(user, filter_id);
+  std::lock_guard<simple_spinlock> l(lock_);
+  RemoveExpiredUnlocked(now);
+  const Entry* old_entry = FindOrNull(filters_, key);
+  const size_t old_bytes = old_entry ? old_entry->size_bytes : 0;
+  if (total_bytes_ - old_bytes + size_bytes > capacity_bytes_) {
+    return Status::ServiceUnavailable(
+        Substitute("not enough capacity left to register bloom filter $0 of $1 bytes",
+                   filter_id, size_bytes));
+  }
+  total_bytes_ = total_bytes_ - old_bytes + size_bytes;
+  filters_[std::move(key)] = { std::move(filter), size_bytes, now + ttl };
+  return Status::OK();
+}
+
+Status BloomFilterRegistry::Lookup(const string& user,
+                                   const string& filter_id,
+                                   shared_ptr<BlockBloomFilter>* filter) const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  const Entry* entry = FindOrNull(filters_, MakeKey(user, filter_id));
+  if (!entry || entry->expiration < MonoTime::Now()) {
+    return Status::NotFound(Substitute("bloom filter $0 is not registered", filter_id));
+  }
+  *filter = entry->filter;
+  return Status::OK();
+}
+
+size_t BloomFilterRegistry::num_filters() const {
+  std::lock_guard<simple_spinlock> l(lock_);
+  return filters_.size();
+}
+
+void BloomFilterRegistry::RemoveExpiredUnlocked(MonoTime now) {
+  DCHECK(lock_.is_locked());
+  for (auto it = filters_.begin(); it != filters_.end();) {
+    if (it->second.expiration < now) {
+      total_bytes_ -= it->second.size_bytes;
+      it = filters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+} // namespace tserver
+} // namespace kudu
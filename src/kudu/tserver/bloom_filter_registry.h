@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class BlockBloomFilter;
+class BlockBloomFilterPB;
+
+namespace tserver {
+
+// Bloom filters registered with the tablet server for a limited time, so that
+// the scans of a query can refer to them by ID instead of each carrying its
+// own copy of a potentially large filter.
+//
+// A filter is registered by a user under an ID of their choosing, and only
+// that user's scans can refer to it. Each filter is decoded once, when it's
+// registered, and shared by the scans which refer to it; a scan keeps the
+// filters it uses alive even if they expire meanwhile.
+//
+// This class is thread-safe.
+class BloomFilterRegistry {
+ public:
+  explicit BloomFilterRegistry(size_t capacity_bytes);
+  ~BloomFilterRegistry();
+
+  // Registers 'filter_pb' under 'filter_id' for 'user', replacing any filter
+  // the user already registered under that ID. The filter expires once 'ttl'
+  // elapses, or the maximum time to live allowed, whichever is shorter.
+  //
+  // Returns ServiceUnavailable if registering the filter would exceed the
+  // capacity of the registry.
+  Status Register(const std::string& user,
+                  const std::string& filter_id,
+                  const BlockBloomFilterPB& filter_pb,
+                  MonoDelta ttl);
+
+  // Looks up the filter registered under 'filter_id' by 'user'. Returns
+  // NotFound if there is no such filter, or if it expired.
+  Status Lookup(const std::string& user,
+                const std::string& filter_id,
+                std::shared_ptr<BlockBloomFilter>* filter) const;
+
+  // Returns the number of filters which are registered, including those which
+  // expired but haven't been removed yet.
+  size_t num_filters() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<BlockBloomFilter> filter;
+    size_t size_bytes;
+    MonoTime expiration;
+  };
+
+  static std::string MakeKey(const std::string& user, const std::string& filter_id);
+
+  // Removes the filters which expired before 'now'.
+  void RemoveExpiredUnlocked(MonoTime now);
+
+  const size_t capacity_bytes_;
+
+  mutable simple_spinlock lock_;
+
+  // The registered filters, keyed by user and filter ID.
+  std::unordered_map<std::string, Entry> filters_;
+
+  // The total size of the registered filters.
+  size_t total_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(BloomFilterRegistry);
+};
+
+} // namespace tserver
+} // namespace kudu
@@ -53,18 +53,24 @@
 #include "kudu/security/token_verifier.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/server/webserver.h"
+#include "kudu/tablet/tablet.h"
+#include "kudu/tablet/tablet_metrics.h"
+#include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/util/condition_variable.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/locks.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/maintenance_manager.h"
+#include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/mutex.h"
 #include "kudu/util/net/dns_resolver.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/pb_util.h"
+#include "kudu/util/process_memory.h"
 #include "kudu/util/status.h"
 #include "kudu/util/thread.h"
 #include "kudu/util/trace.h"
@@ -84,6 +90,16 @@ DEFINE_int32(heartbeat_max_failures_before_backoff, 3,
              "rather than retrying.");
 TAG_FLAG(heartbeat_max_failures_before_backoff, advanced);
 
+DEFINE_int32(heartbeat_max_tablets_per_report, 1000,
+             "Maximum number of tablets to include in a single tablet report. "
+             "A full tablet report of a tablet server hosting more tablets is "
+             "sent as a series of incremental reports over consecutive "
+             "heartbeats, so that a newly elected leader master isn't flooded "
+             "by the full reports of every tablet server at once. If 0 or "
+             "negative, there's no limit.");
+TAG_FLAG(heartbeat_max_tablets_per_report, advanced);
+TAG_FLAG(heartbeat_max_tablets_per_report, runtime);
+
 DEFINE_int32(heartbeat_inject_latency_before_heartbeat_ms, 0,
              "How much latency (in ms) to inject when a tablet copy session is initialized. "
              "(For testing only!)");
@@ -112,6 +128,7 @@ using kudu::master::TabletReportPB;
 using kudu::pb_util::SecureDebugString;
 using kudu::rpc::ErrorStatusPB;
 using kudu::rpc::RpcController;
+using std::pair;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -134,8 +151,21 @@ class Heartbeater::Thread {
   void TriggerASAP();
   void MarkTabletsDirty(const vector<string>& tablet_ids, const string& reason);
   void GenerateIncrementalTabletReport(TabletReportPB* report);
+
+  // Generates a full tablet report or, if the server hosts more than
+  // --heartbeat_max_tablets_per_report tablets, marks all of them dirty and
+  // generates the first of the incremental reports the full report is split
+  // into. The last of them is flagged with 'completes_full_report'.
   void GenerateFullTabletReport(TabletReportPB* report);
 
+  // Fills in 'load' with the current resource usage of the server. The row
+  // rates are computed since the previous call.
+  void GenerateLoad(master::TabletServerLoadPB* load);
+
+  // Whether a full tablet report split into incremental reports hasn't been
+  // entirely acknowledged yet.
+  bool chunked_full_report_in_progress() const;
+
   // Mark that the master successfully received and processed the given
   // tablet report. This uses the report sequence number to "un-dirty" any
   // tablets which have not changed since the acknowledged report.
@@ -190,7 +220,11 @@ class Heartbeater::Thread {
   // reported to the master, an entry is added to this map.
   DirtyMap dirty_tablets_;
 
-  // Lock protecting 'dirty_tablets_'.
+  // Whether the tablets in 'dirty_tablets_' include all the tablets of a
+  // full tablet report which is being sent in chunks.
+  bool chunked_full_report_in_progress_;
+
+  // Lock protecting 'dirty_tablets_' and 'chunked_full_report_in_progress_'.
   //
   // Should not be held at the same time as mutex_.
   mutable simple_spinlock dirty_tablets_lock_;
@@ -211,6 +245,13 @@ class Heartbeater::Thread {
   // the thread detects that the master has been elected leader.
   bool send_full_tablet_report_;
 
+  // The total numbers of rows written and scanned across the hosted tablets
+  // as of the last call to GenerateLoad(), and the time of that call. Only
+  // accessed by the heartbeater thread.
+  int64_t last_rows_written_;
+  int64_t last_rows_scanned_;
+  MonoTime last_load_time_;
+
   DISALLOW_COPY_AND_ASSIGN(Thread);
 };
 
@@ -305,11 +346,14 @@ Heartbeater::Thread::Thread(HostPort master_address, TabletServer* server)
   : master_address_(std::move(master_address)),
     server_(server),
     consecutive_failed_heartbeats_(0),
+    chunked_full_report_in_progress_(false),
     next_report_seq_(0),
     cond_(&mutex_),
     should_run_(false),
     heartbeat_asap_(true),
-    send_full_tablet_report_(false) {
+    send_full_tablet_report_(false),
+    last_rows_written_(0),
+    last_rows_scanned_(0) {
 }
 
 Status Heartbeater::Thread::ConnectToMaster() {
@@ -376,7 +420,8 @@ int Heartbeater::Thread::GetMillisUntilNextHeartbeat() const {
   // If the master needs something from us, we should immediately
   // send another heartbeat with that info, rather than waiting for the interval.
   if (last_hb_response_.needs_reregister() ||
-      last_hb_response_.needs_full_tablet_report()) {
+      last_hb_response_.needs_full_tablet_report() ||
+      chunked_full_report_in_progress()) {
     return GetMinimumHeartbeatMillis();
   }
 
@@ -461,7 +506,8 @@ Status Heartbeater::Thread::DoHeartbeat(MasterErrorPB* error,
     // Should the heartbeat fail, we'd want the next heartbeat to resend this
     // full tablet report. As such, send_full_tablet_report_ is only reset
     // after all error checking is complete.
-  } else if (last_hb_response_.needs_full_tablet_report()) {
+  } else if (last_hb_response_.needs_full_tablet_report() &&
+             !chunked_full_report_in_progress()) {
     LOG(INFO) << Substitute(
         "Master $0 requested a full tablet report, sending...",
         master_address_.ToString());
@@ -476,6 +522,7 @@ Status Heartbeater::Thread::DoHeartbeat(MasterErrorPB* error,
   auto num_live_tablets_by_dimension = server_->tablet_manager()->GetNumLiveTabletsByDimension();
   req.mutable_num_live_tablets_by_dimension()->insert(num_live_tablets_by_dimension.begin(),
                                                       num_live_tablets_by_dimension.end());
+  GenerateLoad(req.mutable_load());
 
   VLOG(2) << "Sending heartbeat:\n" << SecureDebugString(req);
   master::TSHeartbeatResponsePB resp;
@@ -631,20 +678,45 @@ void Heartbeater::Thread::MarkTabletReportAcknowledged(const TabletReportPB& rep
   int32_t acked_seq = report.sequence_number();
   CHECK_LT(acked_seq, next_report_seq_.load());
 
+  if (!report.is_incremental() || report.completes_full_report()) {
+    chunked_full_report_in_progress_ = false;
+  }
+
   // Clear the "dirty" state for any tablets which have not changed since
   // this report.
-  auto it = dirty_tablets_.begin();
-  while (it != dirty_tablets_.end()) {
-    const TabletReportState& state = it->second;
-    if (state.change_seq <= acked_seq) {
+  const auto clear_if_unchanged = [&](const string& tablet_id) {
+    const TabletReportState* state = FindOrNull(dirty_tablets_, tablet_id);
+    if (state != nullptr && state->change_seq <= acked_seq) {
       // This entry has not changed since this tablet report, we no longer need
       // to track it as dirty. If it becomes dirty again, it will be re-added
       // with a higher sequence number.
-      it = dirty_tablets_.erase(it);
-    } else {
-      ++it;
+      dirty_tablets_.erase(tablet_id);
     }
+  };
+  if (!report.is_incremental()) {
+    // A full report covers every tablet, including the removed ones.
+    auto it = dirty_tablets_.begin();
+    while (it != dirty_tablets_.end()) {
+      if (it->second.change_seq <= acked_seq) {
+        it = dirty_tablets_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return;
+  }
+  // An incremental report may only cover some of the dirty tablets.
+  for (const auto& reported_tablet : report.updated_tablets()) {
+    clear_if_unchanged(reported_tablet.tablet_id());
   }
+  for (const auto& tablet_id : report.removed_tablet_ids()) {
+    clear_if_unchanged(tablet_id);
+  }
+}
+
+bool Heartbeater::Thread::chunked_full_report_in_progress() const {
+  std::lock_guard<simple_spinlock> l(dirty_tablets_lock_);
+  return chunked_full_report_in_progress_;
 }
 
 Status Heartbeater::Thread::Start() {
@@ -711,19 +783,105 @@ void Heartbeater::Thread::GenerateIncrementalTabletReport(TabletReportPB* report
   vector<string> dirty_tablet_ids;
   {
     std::lock_guard<simple_spinlock> l(dirty_tablets_lock_);
-    AppendKeysFromMap(dirty_tablets_, &dirty_tablet_ids);
+    const int max_tablets = FLAGS_heartbeat_max_tablets_per_report;
+    if (max_tablets <= 0 || dirty_tablets_.size() <= max_tablets) {
+      AppendKeysFromMap(dirty_tablets_, &dirty_tablet_ids);
+      if (chunked_full_report_in_progress_) {
+        report->set_completes_full_report(true);
+      }
+    } else {
+      // Report the tablets which have been dirty for the longest first, so
+      // that every tablet is eventually reported.
+      vector<pair<int32_t, const string*>> by_change_seq;
+      by_change_seq.reserve(dirty_tablets_.size());
+      for (const auto& e : dirty_tablets_) {
+        by_change_seq.emplace_back(e.second.change_seq, &e.first);
+      }
+      std::nth_element(by_change_seq.begin(), by_change_seq.begin() + max_tablets,
+                       by_change_seq.end());
+      dirty_tablet_ids.reserve(max_tablets);
+      for (int i = 0; i < max_tablets; i++) {
+        dirty_tablet_ids.emplace_back(*by_change_seq[i].second);
+      }
+    }
   }
   server_->tablet_manager()->PopulateIncrementalTabletReport(
       report, dirty_tablet_ids);
 }
 
 void Heartbeater::Thread::GenerateFullTabletReport(TabletReportPB* report) {
+  const int max_tablets = FLAGS_heartbeat_max_tablets_per_report;
+  if (max_tablets > 0) {
+    vector<scoped_refptr<tablet::TabletReplica>> replicas;
+    server_->tablet_manager()->GetTabletReplicas(&replicas);
+    if (replicas.size() > max_tablets) {
+      vector<string> tablet_ids;
+      tablet_ids.reserve(replicas.size());
+      for (const auto& replica : replicas) {
+        tablet_ids.emplace_back(replica->tablet_id());
+      }
+      MarkTabletsDirty(tablet_ids, "full tablet report");
+      {
+        std::lock_guard<simple_spinlock> l(dirty_tablets_lock_);
+        chunked_full_report_in_progress_ = true;
+      }
+      VLOG(1) << Substitute("Splitting the full tablet report of $0 tablets to master $1 "
+                            "into reports of at most $2 tablets",
+                            replicas.size(), master_address_.ToString(), max_tablets);
+      GenerateIncrementalTabletReport(report);
+      return;
+    }
+  }
   report->Clear();
   report->set_sequence_number(next_report_seq_.fetch_add(1));
   report->set_is_incremental(false);
   server_->tablet_manager()->PopulateFullTabletReport(report);
 }
 
+void Heartbeater::Thread::GenerateLoad(master::TabletServerLoadPB* load) {
+  vector<scoped_refptr<tablet::TabletReplica>> replicas;
+  server_->tablet_manager()->GetTabletReplicas(&replicas);
+  int64_t on_disk_data_bytes = 0;
+  int64_t rows_written = 0;
+  int64_t rows_scanned = 0;
+  for (const auto& replica : replicas) {
+    on_disk_data_bytes += replica->OnDiskSize();
+    const auto tablet = replica->shared_tablet();
+    tablet::TabletMetrics* metrics = tablet ? tablet->metrics() : nullptr;
+    if (metrics) {
+      rows_written += metrics->rows_inserted->value() + metrics->rows_upserted->value() +
+                      metrics->rows_updated->value() + metrics->rows_deleted->value();
+      rows_scanned += metrics->scanner_rows_scanned->value();
+    }
+  }
+  load->set_on_disk_data_bytes(on_disk_data_bytes);
+
+  // Replicas may have been deleted since the previous heartbeat, so the totals
+  // may go down: clamp the rates at zero.
+  const MonoTime now = MonoTime::Now();
+  if (last_load_time_.Initialized()) {
+    const double elapsed_secs = (now - last_load_time_).ToSeconds();
+    if (elapsed_secs > 0) {
+      load->set_write_rows_per_sec(
+          std::max<double>(0, rows_written - last_rows_written_) / elapsed_secs);
+      load->set_scan_rows_per_sec(
+          std::max<double>(0, rows_scanned - last_rows_scanned_) / elapsed_secs);
+    }
+  }
+  last_rows_written_ = rows_written;
+  last_rows_scanned_ = rows_scanned;
+  last_load_time_ = now;
+
+  const int64_t hard_limit = process_memory::HardLimit();
+  if (hard_limit > 0) {
+    load->set_memory_pressure(
+        static_cast<double>(process_memory::CurrentConsumption()) / hard_limit);
+  }
+  if (server_->maintenance_manager()) {
+    load->set_maintenance_backlog(server_->maintenance_manager()->NumPendingOps());
+  }
+}
+
 Status Heartbeater::Thread::MasterServiceProxyForHostPort(
     unique_ptr<MasterServiceProxy>* proxy) {
   vector<Sockaddr> addrs;
@@ -0,0 +1,156 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/tserver/scan_result_cache.h"
+
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/port.h"
+#include "kudu/rpc/rpc_context.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/tserver/tserver.pb.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace kudu {
+namespace tserver {
+
+namespace {
+
+// A cached response and the contents of its sidecars. The cache stores
+// pointers to these.
+struct CachedScanResult {
+  ScanResponsePB resp;
+  vector<faststring> sidecars;
+};
+
+CachedScanResult* CacheValueToResult(Slice val) {
+  CachedScanResult* result;
+  DCHECK_EQ(val.size(), sizeof(result));
+  memcpy(&result, val.data(), sizeof(result));
+  return result;
+}
+
+} // anonymous namespace
+
+// Frees the cached results which are evicted from the cache.
+class ScanResultCache::EvictionCallback : public Cache::EvictionCallback {
+ public:
+  EvictionCallback() {}
+  void EvictedEntry(Slice /* key */, Slice value) override {
+    delete CacheValueToResult(value);
+  }
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EvictionCallback);
+};
+
+ScanResultCache::ScanResultCache(size_t capacity_bytes)
+    : eviction_callback_(new EvictionCallback),
+      cache_(NewCache(capacity_bytes, "scan_result_cache")) {
+}
+
+ScanResultCache::~ScanResultCache() {
+  // Destroy the cache first, since it calls the eviction callback for the
+  // entries it still holds.
+  cache_.reset();
+}
+
+bool ScanResultCache::IsCacheable(const NewScanRequestPB& scan_pb) {
+  if (scan_pb.read_mode() != READ_AT_SNAPSHOT || !scan_pb.has_snap_timestamp()) {
+    return false;
+  }
+  // A different filter may be registered under the same ID later on, so the
+  // request doesn't identify the results of such scans.
+  for (const auto& pred_pb : scan_pb.column_predicates()) {
+    if (pred_pb.has_in_bloom_filter() &&
+        pred_pb.in_bloom_filter().registered_filter_ids_size() > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+string ScanResultCache::MakeKey(const NewScanRequestPB& scan_pb,
+                                uint32_t schema_version,
+                                size_t batch_size_bytes) {
+  // The authz token differs between otherwise identical requests, and has
+  // already been checked by the time the cache is consulted.
+  NewScanRequestPB key_pb(scan_pb);
+  key_pb.clear_authz_token();
+
+  faststring key;
+  PutFixed32(&key, schema_version);
+  PutFixed64(&key, batch_size_bytes);
+  const size_t prefix_size = key.size();
+  key.resize(prefix_size + key_pb.ByteSizeLong());
+  key_pb.SerializeWithCachedSizesToArray(key.data() + prefix_size);
+  return key.ToString();
+}
+
+bool ScanResultCache::Lookup(const string& key,
+                             rpc::RpcContext* context,
+                             ScanResponsePB* resp) {
+  auto handle(cache_->Lookup(key, Cache::EXPECT_IN_CACHE));
+  if (!handle) {
+    return false;
+  }
+  // The handle keeps the entry from being freed while it's copied.
+  const CachedScanResult* result = CacheValueToResult(cache_->Value(handle));
+  resp->CopyFrom(result->resp);
+  for (const auto& sidecar : result->sidecars) {
+    int idx;
+    CHECK_OK(context->AddOutboundSidecar(rpc::RpcSidecar::FromFaststring(faststring(sidecar)),
+                                         &idx));
+  }
+  return true;
+}
+
+void ScanResultCache::Insert(const string& key,
+                             const ScanResponsePB& resp,
+                             vector<faststring> sidecars) {
+  unique_ptr<CachedScanResult> result(new CachedScanResult);
+  result->resp.CopyFrom(resp);
+  result->sidecars = std::move(sidecars);
+  size_t charge = key.size() + result->resp.SpaceUsedLong();
+  for (const auto& sidecar : result->sidecars) {
+    charge += sidecar.capacity();
+  }
+  if (PREDICT_FALSE(charge > std::numeric_limits<int>::max())) {
+    return;
+  }
+
+  auto pending(cache_->Allocate(key, sizeof(CachedScanResult*), static_cast<int>(charge)));
+  CHECK(pending);
+  CachedScanResult* val = result.release();
+  memcpy(cache_->MutableValue(&pending), &val, sizeof(val));
+  // The returned handle is released right away; the entry remains cached.
+  cache_->Insert(std::move(pending), eviction_callback_.get());
+}
+
+} // namespace tserver
+} // namespace kudu
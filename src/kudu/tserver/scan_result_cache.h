@@ -0,0 +1,86 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+
+namespace kudu {
+
+class Cache;
+
+namespace rpc {
+class RpcContext;
+} // namespace rpc
+
+namespace tserver {
+
+class NewScanRequestPB;
+class ScanResponsePB;
+
+// Caches the responses of scans which are read at a snapshot timestamp chosen
+// by the client and which return all of their results in a single batch, so
+// that repeating such a scan doesn't read or decode any data.
+//
+// A snapshot read always returns the same rows, no matter what's written to
+// the tablet or how its rowsets are flushed and compacted afterwards, so the
+// cached responses don't need to be invalidated. The only exception is a
+// change to the tablet's schema, which may change how the same request is
+// interpreted; the schema version is part of the key for that reason.
+//
+// This class is thread-safe.
+class ScanResultCache {
+ public:
+  explicit ScanResultCache(size_t capacity_bytes);
+  ~ScanResultCache();
+
+  // Returns whether the results of the given scan may be cached.
+  static bool IsCacheable(const NewScanRequestPB& scan_pb);
+
+  // Returns the key under which the results of the given scan of a tablet
+  // with the given schema version are cached. 'batch_size_bytes' is the
+  // size of the first batch the client asked for.
+  static std::string MakeKey(const NewScanRequestPB& scan_pb,
+                             uint32_t schema_version,
+                             size_t batch_size_bytes);
+
+  // Looks up the response cached under 'key'. If there is one, copies it into
+  // 'resp', adds its sidecars to 'context', and returns true.
+  bool Lookup(const std::string& key, rpc::RpcContext* context, ScanResponsePB* resp);
+
+  // Caches 'resp', along with the contents of its sidecars, under 'key'.
+  void Insert(const std::string& key,
+              const ScanResponsePB& resp,
+              std::vector<faststring> sidecars);
+
+ private:
+  class EvictionCallback;
+
+  std::unique_ptr<EvictionCallback> eviction_callback_;
+  std::unique_ptr<Cache> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultCache);
+};
+
+} // namespace tserver
+} // namespace kudu
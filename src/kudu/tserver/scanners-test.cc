@@ -98,5 +98,36 @@ TEST(ScannerTest, TestExpire) {
   ASSERT_EQ(s2->id(), active_scanners[0]->id());
 }
 
+// Expired scanners are removed from every stripe of the scanner map, but a
+// scanner that is in use is kept even though it was last accessed before the
+// TTL.
+TEST(ScannerTest, TestExpireAcrossStripes) {
+  scoped_refptr<TabletReplica> null_replica(nullptr);
+  FLAGS_scanner_ttl_ms = 100;
+  ScannerManager mgr(nullptr);
+  RemoteUser user;
+  user.SetUnauthenticated(kUsername);
+  constexpr int kNumScanners = 200;
+  vector<SharedScanner> scanners(kNumScanners);
+  for (auto& s : scanners) {
+    mgr.NewScanner(null_replica, user, RowFormatFlags::NO_FLAGS, &s);
+  }
+  SleepFor(MonoDelta::FromMilliseconds(200));
+  {
+    auto access = scanners[0]->LockForAccess();
+    mgr.RemoveExpiredScanners();
+  }
+  ASSERT_EQ(1, mgr.CountActiveScanners());
+
+  SharedScanner result;
+  TabletServerErrorPB::Code error_code;
+  ASSERT_OK(mgr.LookupScanner(scanners[0]->id(), kUsername, &error_code, &result));
+  for (int i = 1; i < kNumScanners; i++) {
+    ASSERT_TRUE(mgr.LookupScanner(scanners[i]->id(), kUsername,
+                                  &error_code, &result).IsNotFound());
+    ASSERT_EQ(TabletServerErrorPB::SCANNER_EXPIRED, error_code);
+  }
+}
+
 } // namespace tserver
 } // namespace kudu
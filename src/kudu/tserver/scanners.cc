@@ -264,32 +264,60 @@ void ScannerManager::RemoveExpiredScanners() {
   const MonoTime now = MonoTime::Now();
 
   vector<ScanDescriptor> descriptors;
+  vector<SharedScanner> candidates;
+  vector<SharedScanner> expired;
   for (ScannerMapStripe* stripe : scanner_maps_) {
-    std::lock_guard<RWMutex> l(stripe->lock_);
-    for (auto it = stripe->scanners_by_id_.begin(); it != stripe->scanners_by_id_.end();) {
-      const SharedScanner& scanner = it->second;
-      MonoDelta idle_time = scanner->TimeSinceLastAccess(now);
-      if (idle_time <= scanner_ttl) {
-        ++it;
-        continue;
+    // Find the expired scanners of the stripe under the shared lock, so that
+    // lookups of the stripe's scanners aren't blocked while the whole stripe
+    // is walked. Most stripes have no expired scanner at all.
+    candidates.clear();
+    {
+      shared_lock<RWMutex> l(stripe->lock_);
+      for (const auto& se : stripe->scanners_by_id_) {
+        if (se.second->TimeSinceLastAccess(now) > scanner_ttl) {
+          candidates.push_back(se.second);
+        }
       }
+    }
+    if (candidates.empty()) {
+      continue;
+    }
+
+    // Only take the exclusive lock to erase the candidates. A candidate may
+    // have been accessed or unregistered since it was found, so it's checked
+    // again.
+    {
+      std::lock_guard<RWMutex> l(stripe->lock_);
+      for (SharedScanner& scanner : candidates) {
+        auto it = stripe->scanners_by_id_.find(scanner->id());
+        if (it == stripe->scanners_by_id_.end() ||
+            it->second != scanner ||
+            scanner->TimeSinceLastAccess(now) <= scanner_ttl) {
+          continue;
+        }
+        stripe->scanners_by_id_.erase(it);
+        expired.emplace_back(std::move(scanner));
+      }
+    }
 
+    // The expired scanners are logged and destroyed outside of the lock.
+    for (const SharedScanner& scanner : expired) {
       // The scanner has expired because of inactivity.
       LOG(INFO) << Substitute(
           "Expiring scanner id: $0, of tablet $1, "
           "after $2 ms of inactivity, which is > TTL ($3 ms).",
-          it->first,
+          scanner->id(),
           scanner->tablet_id(),
-          idle_time.ToMilliseconds(),
+          scanner->TimeSinceLastAccess(now).ToMilliseconds(),
           scanner_ttl.ToMilliseconds());
       if (scanner->is_initted()) {
         descriptors.emplace_back(scanner->Descriptor());
       }
-      it = stripe->scanners_by_id_.erase(it);
       if (metrics_) {
         metrics_->scanners_expired->Increment();
       }
     }
+    expired.clear();
   }
 
   std::lock_guard<RWMutex> l(completed_scans_lock_);
@@ -354,6 +382,11 @@ void Scanner::AddTimings(const CpuTimes& elapsed) {
   cpu_times_.Add(elapsed);
 }
 
+void Scanner::AddStageTimes(const ScanStageTimes& times) {
+  std::unique_lock<RWMutex> l(cpu_times_lock_);
+  stage_times_ += times;
+}
+
 void Scanner::Init(unique_ptr<RowwiseIterator> iter,
                    unique_ptr<ScanSpec> spec,
                    unique_ptr<Schema> client_projection) {
@@ -429,6 +462,7 @@ ScanDescriptor Scanner::Descriptor() const {
   descriptor.last_call_seq_id = ANNOTATE_UNPROTECTED_READ(call_seq_id_);
   descriptor.last_access_time = last_access_time_.load(std::memory_order_relaxed);
   descriptor.cpu_times = cpu_times();
+  descriptor.stage_times = stage_times();
 
   return descriptor;
 }
@@ -438,5 +472,10 @@ CpuTimes Scanner::cpu_times() const {
   return cpu_times_;
 }
 
+ScanStageTimes Scanner::stage_times() const {
+  shared_lock<RWMutex> l(cpu_times_lock_);
+  return stage_times_;
+}
+
 } // namespace tserver
 } // namespace kudu
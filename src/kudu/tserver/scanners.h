@@ -35,9 +35,11 @@
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/rpc/remote_user.h"
+#include "kudu/tablet/rowset.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/util/auto_release_pool.h"
+#include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/condition_variable.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
@@ -191,6 +193,13 @@ class ScopedUnregisterScanner {
   bool cancelled_;
 };
 
+// Scan results which were read ahead of a client's next continuation request.
+// The tablet service, which reads and returns them, defines their contents.
+class PrefetchedScanBatch {
+ public:
+  virtual ~PrefetchedScanBatch() = default;
+};
+
 // An open scanner on the server side.
 //
 // NOTE: unless otherwise specified, all methods of this class require that the
@@ -277,6 +286,9 @@ class Scanner {
   // Add the timings in 'elapsed' to the total timings for this scanner.
   void AddTimings(const CpuTimes& elapsed);
 
+  // Add the stage times in 'times' to the total stage times for this scanner.
+  void AddStageTimes(const ScanStageTimes& times);
+
   // Return the auto-release pool which will be freed when this scanner
   // closes. This can be used as a storage area for the ScanSpec and any
   // associated data (eg storage for its predicates).
@@ -346,6 +358,91 @@ class Scanner {
     return row_format_flags_;
   }
 
+  // Set the aggregation the client requested for this scan. Must be called
+  // before the scanner's ID is returned to the client.
+  void set_aggregation(const AggregationPB& aggregation) {
+    lock_.AssertAcquired();
+    DCHECK(!aggregation_);
+    aggregation_.reset(new AggregationPB(aggregation));
+  }
+
+  // Returns the aggregation requested for this scan, or nullptr if the scan
+  // returns rows. Does not require the AccessLock, since the aggregation
+  // doesn't change once the scanner is visible to clients.
+  const AggregationPB* aggregation() const {
+    return aggregation_.get();
+  }
+
+  // Set the sink collecting the rollups of the rowsets which the scan's
+  // aggregation reads instead of their rows. Must be called before the
+  // scanner's ID is returned to the client.
+  void set_rollup_sink(std::unique_ptr<tablet::RowSetRollupSink> sink) {
+    lock_.AssertAcquired();
+    DCHECK(!rollup_sink_);
+    rollup_sink_ = std::move(sink);
+  }
+
+  // Returns the sink of the rollups read by the scan, or nullptr if the scan
+  // reads no rollups. Like aggregation(), does not require the AccessLock.
+  tablet::RowSetRollupSink* rollup_sink() const {
+    return rollup_sink_.get();
+  }
+
+  // Set the codec with which to compress the columnar results of this scan.
+  // Must be called before the scanner's ID is returned to the client.
+  void set_columnar_compression(CompressionType compression) {
+    lock_.AssertAcquired();
+    columnar_compression_ = compression;
+  }
+
+  CompressionType columnar_compression() const {
+    lock_.AssertAcquired();
+    return columnar_compression_;
+  }
+
+  // Stashes a batch of results which was read ahead of the client's next
+  // continuation request. There must not already be one.
+  void set_prefetched_batch(std::unique_ptr<PrefetchedScanBatch> batch) {
+    lock_.AssertAcquired();
+    DCHECK(!prefetched_batch_);
+    prefetched_batch_ = std::move(batch);
+  }
+
+  bool has_prefetched_batch() const {
+    lock_.AssertAcquired();
+    return prefetched_batch_ != nullptr;
+  }
+
+  // Returns the batch stashed by set_prefetched_batch(), if any, leaving none.
+  std::unique_ptr<PrefetchedScanBatch> release_prefetched_batch() {
+    lock_.AssertAcquired();
+    return std::move(prefetched_batch_);
+  }
+
+  // Returns the size of the batches of a scan which is sized adaptively, or 0
+  // if the scan isn't sized adaptively or hasn't returned a batch yet.
+  size_t adaptive_batch_size_bytes() const {
+    lock_.AssertAcquired();
+    return adaptive_batch_size_bytes_;
+  }
+
+  void set_adaptive_batch_size_bytes(size_t batch_size_bytes) {
+    lock_.AssertAcquired();
+    adaptive_batch_size_bytes_ = batch_size_bytes;
+  }
+
+  // Returns how long it took to read the last batch of an adaptively sized
+  // scan.
+  const MonoDelta& last_batch_read_time() const {
+    lock_.AssertAcquired();
+    return last_batch_read_time_;
+  }
+
+  void set_last_batch_read_time(const MonoDelta& read_time) {
+    lock_.AssertAcquired();
+    last_batch_read_time_ = read_time;
+  }
+
   void add_num_rows_returned(int64_t num_rows_added) {
     lock_.AssertAcquired();
     num_rows_returned_ += num_rows_added;
@@ -372,6 +469,10 @@ class Scanner {
   // Does not require the AccessLock.
   CpuTimes cpu_times() const;
 
+  // Returns the time spent in each stage of this scan.
+  // Does not require the AccessLock.
+  ScanStageTimes stage_times() const;
+
  private:
   friend class ScannerManager;
 
@@ -400,6 +501,16 @@ class Scanner {
   // The row format flags the client passed, if any.
   const uint64_t row_format_flags_;
 
+  // The aggregation the client passed, if any.
+  std::unique_ptr<AggregationPB> aggregation_;
+
+  // The sink of the rollups read by the scan's aggregation, if any. It must
+  // outlive 'iter_', whose rowset iterators add rollups to it.
+  std::unique_ptr<tablet::RowSetRollupSink> rollup_sink_;
+
+  // The codec the client asked columnar results to be compressed with.
+  CompressionType columnar_compression_ = NO_COMPRESSION;
+
   // (Optional) scanner metrics struct, for recording scanner's duration.
   ScannerMetrics* metrics_;
 
@@ -427,6 +538,9 @@ class Scanner {
   // Assumed to be set once initted_ is true.
   std::unique_ptr<Schema> client_projection_schema_;
 
+  // Results read ahead of the client's next continuation request, if any.
+  std::unique_ptr<PrefetchedScanBatch> prefetched_batch_;
+
   // The last time that the scanner was accessed.
   // Only modified under lock_ but can be read outside.
   std::atomic<MonoTime> last_access_time_;
@@ -445,10 +559,18 @@ class Scanner {
   // this scanner.
   int64_t num_rows_returned_;
 
+  // The batch size of an adaptively sized scan, and how long its last batch
+  // took to read. Protected by lock_.
+  size_t adaptive_batch_size_bytes_ = 0;
+  MonoDelta last_batch_read_time_;
+
   // The cumulative amounts of wall, user cpu, and system cpu time spent on
   // this scanner, in seconds.
   mutable RWMutex cpu_times_lock_;
   CpuTimes cpu_times_;
+  // The cumulative time spent in each stage of this scan. Protected by
+  // cpu_times_lock_.
+  ScanStageTimes stage_times_;
 
   DISALLOW_COPY_AND_ASSIGN(Scanner);
 };
@@ -494,9 +616,15 @@ struct ScanDescriptor {
   // The cumulative amounts of wall, user cpu, and system cpu time spent on
   // this scanner, in seconds.
   CpuTimes cpu_times;
+
+  // The cumulative time spent in each stage of the scan.
+  ScanStageTimes stage_times;
 };
 
 // RAII wrapper to update a scanner with timing information upon scope exit.
+//
+// The scan stage times accumulated in the current trace while in scope are
+// added to the scanner's stage times.
 class ScopedAddScannerTiming {
  public:
   // 'scanner' must outlive the scoped object.
@@ -505,7 +633,8 @@ class ScopedAddScannerTiming {
   explicit ScopedAddScannerTiming(Scanner* scanner, CpuTimes* cpu_times)
       : stopped_(false),
         scanner_(scanner),
-        cpu_times_(cpu_times) {
+        cpu_times_(cpu_times),
+        start_stage_times_(ScanStageTimes::FromCurrentTrace()) {
     sw_.start();
   }
 
@@ -521,12 +650,16 @@ class ScopedAddScannerTiming {
     sw_.stop();
     scanner_->AddTimings(sw_.elapsed());
     *cpu_times_ = scanner_->cpu_times();
+    ScanStageTimes stage_times = ScanStageTimes::FromCurrentTrace();
+    stage_times -= start_stage_times_;
+    scanner_->AddStageTimes(stage_times);
   }
 
   bool stopped_;
   Scanner* scanner_;
   CpuTimes* cpu_times_;
   Stopwatch sw_;
+  const ScanStageTimes start_stage_times_;
 
   DISALLOW_COPY_AND_ASSIGN(ScopedAddScannerTiming);
 };
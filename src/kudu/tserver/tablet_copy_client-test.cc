@@ -53,8 +53,10 @@
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/tserver/mini_tablet_server.h"
 #include "kudu/tserver/tablet_copy-test-base.h"
 #include "kudu/tserver/tablet_copy.pb.h"
+#include "kudu/tserver/tablet_server.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -77,6 +79,12 @@ using std::vector;
 DECLARE_double(env_inject_eio);
 DECLARE_string(block_manager);
 DECLARE_string(env_inject_eio_globs);
+DECLARE_bool(tablet_copy_fetch_data_in_sidecars);
+DECLARE_int32(tablet_copy_download_threads_per_session);
+DECLARE_int32(tablet_copy_fetch_pipeline_depth);
+DECLARE_int64(tablet_copy_max_inflight_bytes_per_session);
+DECLARE_int64(tablet_copy_source_readahead_bytes);
+DECLARE_int32(tablet_copy_transfer_chunk_size_bytes);
 
 METRIC_DECLARE_counter(block_manager_total_disk_sync);
 
@@ -311,6 +319,42 @@ TEST_F(TabletCopyClientTest, TestDownloadWalSegment) {
   ASSERT_OK(CompareFileContents(path, server_path));
 }
 
+// Download a WAL segment in many small chunks with requests pipelined ahead of
+// the chunk being written, and make sure it arrives intact.
+TEST_F(TabletCopyClientTest, TestPipelinedDownload) {
+  FLAGS_tablet_copy_transfer_chunk_size_bytes = 64;
+  FLAGS_tablet_copy_fetch_pipeline_depth = 8;
+  ASSERT_OK(StartCopy());
+  ASSERT_OK(env_util::CreateDirIfMissing(
+      env_, fs_manager_->GetTabletWalDir(GetTabletId())));
+
+  uint64_t seqno = client_->wal_seqnos_[0];
+  string path = fs_manager_->GetWalSegmentFileName(GetTabletId(), seqno);
+  ASSERT_OK(client_->DownloadWAL(seqno));
+
+  log::SegmentSequence local_segments;
+  tablet_replica_->log()->reader()->GetSegmentsSnapshot(&local_segments);
+  ASSERT_OK(CompareFileContents(path, local_segments[0]->path()));
+}
+
+// Download a WAL segment with its data in the response protobufs, as from a
+// source which doesn't send sidecars, and make sure it arrives intact.
+TEST_F(TabletCopyClientTest, TestDownloadWithoutSidecars) {
+  FLAGS_tablet_copy_fetch_data_in_sidecars = false;
+  FLAGS_tablet_copy_transfer_chunk_size_bytes = 64;
+  ASSERT_OK(StartCopy());
+  ASSERT_OK(env_util::CreateDirIfMissing(
+      env_, fs_manager_->GetTabletWalDir(GetTabletId())));
+
+  uint64_t seqno = client_->wal_seqnos_[0];
+  string path = fs_manager_->GetWalSegmentFileName(GetTabletId(), seqno);
+  ASSERT_OK(client_->DownloadWAL(seqno));
+
+  log::SegmentSequence local_segments;
+  tablet_replica_->log()->reader()->GetSegmentsSnapshot(&local_segments);
+  ASSERT_OK(CompareFileContents(path, local_segments[0]->path()));
+}
+
 // Ensure that we detect data corruption at the per-transfer level.
 TEST_F(TabletCopyClientTest, TestVerifyData) {
   ASSERT_OK(StartCopy());
@@ -328,13 +372,13 @@ TEST_F(TabletCopyClientTest, TestVerifyData) {
   valid_chunk.set_total_data_length(kDataTotalLen);
 
   // Make sure we work on the happy case.
-  ASSERT_OK(client_->VerifyData(kGoodOffset, valid_chunk));
+  ASSERT_OK(client_->VerifyData(kGoodOffset, valid_chunk, valid_chunk.data()));
 
   // Test unexpected offset.
   DataChunkPB bad_offset = valid_chunk;
   bad_offset.set_offset(kBadOffset);
   Status s;
-  s = client_->VerifyData(kGoodOffset, bad_offset);
+  s = client_->VerifyData(kGoodOffset, bad_offset, bad_offset.data());
   ASSERT_TRUE(s.IsInvalidArgument()) << "Bad offset expected: " << s.ToString();
   ASSERT_STR_CONTAINS(s.ToString(), "Offset did not match");
   LOG(INFO) << "Expected error returned: " << s.ToString();
@@ -342,13 +386,16 @@ TEST_F(TabletCopyClientTest, TestVerifyData) {
   // Test bad checksum.
   DataChunkPB bad_checksum = valid_chunk;
   bad_checksum.set_data(bad);
-  s = client_->VerifyData(kGoodOffset, bad_checksum);
+  s = client_->VerifyData(kGoodOffset, bad_checksum, bad_checksum.data());
   ASSERT_TRUE(s.IsCorruption()) << "Invalid checksum expected: " << s.ToString();
   ASSERT_STR_CONTAINS(s.ToString(), "CRC32 does not match");
   LOG(INFO) << "Expected error returned: " << s.ToString();
 }
 
 TEST_F(TabletCopyClientTest, TestDownloadAllBlocks) {
+  // The disk synchronization counts below assume the blocks are written one
+  // after another.
+  FLAGS_tablet_copy_download_threads_per_session = 1;
   ASSERT_OK(StartCopy());
   // Download and commit all the blocks.
   ASSERT_OK(client_->DownloadBlocks());
@@ -380,6 +427,45 @@ TEST_F(TabletCopyClientTest, TestDownloadAllBlocks) {
   }
 }
 
+// Download the blocks several at a time, in small pipelined chunks read ahead
+// by the source, and make sure they all arrive intact.
+TEST_F(TabletCopyClientTest, TestDownloadBlocksConcurrently) {
+  FLAGS_tablet_copy_download_threads_per_session = 4;
+  FLAGS_tablet_copy_transfer_chunk_size_bytes = 64;
+  FLAGS_tablet_copy_fetch_pipeline_depth = 4;
+  FLAGS_tablet_copy_source_readahead_bytes = 1024;
+  ASSERT_EQ(4, TabletCopyClient::NumConcurrentBlockDownloads(100));
+
+  // The in-flight byte budget bounds the concurrency, but never below one
+  // download at a time.
+  FLAGS_tablet_copy_max_inflight_bytes_per_session = 2 * 5 * 64;
+  ASSERT_EQ(2, TabletCopyClient::NumConcurrentBlockDownloads(100));
+  FLAGS_tablet_copy_max_inflight_bytes_per_session = 0;
+  ASSERT_EQ(1, TabletCopyClient::NumConcurrentBlockDownloads(100));
+  FLAGS_tablet_copy_max_inflight_bytes_per_session = 4 * 5 * 64;
+
+  ASSERT_OK(StartCopy());
+  ASSERT_OK(client_->DownloadBlocks());
+  ASSERT_OK(client_->transaction_->CommitCreatedBlocks());
+
+  // The new superblock references the downloaded blocks in the order of the
+  // remote superblock.
+  vector<BlockId> old_data_blocks = ListBlocks(*client_->remote_superblock_);
+  vector<BlockId> new_data_blocks = ListBlocks(*client_->superblock_);
+  ASSERT_EQ(old_data_blocks.size(), new_data_blocks.size());
+  for (size_t i = 0; i < old_data_blocks.size(); i++) {
+    faststring old_scratch;
+    faststring new_scratch;
+    Slice old_data;
+    Slice new_data;
+    ASSERT_OK(ReadLocalBlockFile(mini_server_->server()->fs_manager(), old_data_blocks[i],
+                                 &old_scratch, &old_data));
+    ASSERT_OK(ReadLocalBlockFile(fs_manager_.get(), new_data_blocks[i],
+                                 &new_scratch, &new_data));
+    ASSERT_EQ(0, old_data.compare(new_data)) << "block " << old_data_blocks[i].ToString();
+  }
+}
+
 // Test that failing a disk outside fo the tablet copy client will eventually
 // stop the copy client and cause it to fail.
 TEST_F(TabletCopyClientTest, TestFailedDiskStopsClient) {
@@ -17,10 +17,15 @@
 
 #include "kudu/tserver/tablet_copy_client.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 #include <gflags/gflags.h>
@@ -53,6 +58,7 @@
 #include "kudu/tserver/tablet_copy.pb.h"
 #include "kudu/tserver/tablet_copy.proxy.h"
 #include "kudu/tserver/ts_tablet_manager.h"
+#include "kudu/util/countdown_latch.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/env.h"
 #include "kudu/util/env_util.h"
@@ -68,6 +74,7 @@
 #include "kudu/util/random_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 
 DEFINE_int32(tablet_copy_begin_session_timeout_ms, 30000,
@@ -100,6 +107,37 @@ DEFINE_double(tablet_copy_fault_crash_before_write_cmeta, 0.0,
 TAG_FLAG(tablet_copy_fault_crash_before_write_cmeta, unsafe);
 TAG_FLAG(tablet_copy_fault_crash_before_write_cmeta, runtime);
 
+DEFINE_int32(tablet_copy_fetch_pipeline_depth, 4,
+             "The number of data chunks a tablet copy client requests from the "
+             "source ahead of the one it is writing. Pipelining the requests "
+             "keeps copies over high-latency links from being bound by the "
+             "round trip time. Set to 0 to fetch one chunk at a time.");
+TAG_FLAG(tablet_copy_fetch_pipeline_depth, advanced);
+TAG_FLAG(tablet_copy_fetch_pipeline_depth, runtime);
+
+DEFINE_bool(tablet_copy_fetch_data_in_sidecars, true,
+             "Whether a tablet copy client asks the source to send the data it "
+             "fetches in RPC sidecars rather than in the response protobufs, "
+             "sparing the copies into and out of the protobufs.");
+TAG_FLAG(tablet_copy_fetch_data_in_sidecars, advanced);
+TAG_FLAG(tablet_copy_fetch_data_in_sidecars, runtime);
+
+DEFINE_int32(tablet_copy_download_threads_per_session, 4,
+             "The maximum number of blocks a tablet copy client downloads "
+             "concurrently within one session.");
+TAG_FLAG(tablet_copy_download_threads_per_session, advanced);
+TAG_FLAG(tablet_copy_download_threads_per_session, runtime);
+
+DEFINE_int64(tablet_copy_max_inflight_bytes_per_session, 128 * 1024 * 1024,
+             "The maximum number of bytes a tablet copy client may have requested "
+             "from the source and not yet written, across the blocks it downloads "
+             "concurrently within one session. Each block download accounts for "
+             "--tablet_copy_fetch_pipeline_depth plus one chunks of "
+             "--tablet_copy_transfer_chunk_size_bytes. At least one block is "
+             "always downloaded at a time.");
+TAG_FLAG(tablet_copy_max_inflight_bytes_per_session, advanced);
+TAG_FLAG(tablet_copy_max_inflight_bytes_per_session, runtime);
+
 DECLARE_int32(tablet_copy_transfer_chunk_size_bytes);
 
 METRIC_DEFINE_counter(server, tablet_copy_bytes_fetched,
@@ -138,6 +176,7 @@ using strings::Substitute;
 using tablet::ColumnDataPB;
 using tablet::DeltaDataPB;
 using tablet::RowSetDataPB;
+using tablet::SecondaryIndexDataPB;
 using tablet::TabletDataState;
 using tablet::TabletDataState_Name;
 using tablet::TabletMetadata;
@@ -396,7 +435,7 @@ Status TabletCopyClient::FetchAll(const scoped_refptr<TabletReplica>& tablet_rep
 
   tablet_replica_ = tablet_replica;
 
-  // Download all the files (serially, for now, but in parallel in the future).
+  // Download all the blocks, several at a time, then the WAL segments.
   RETURN_NOT_OK(DownloadBlocks());
   RETURN_NOT_OK(DownloadWALs());
 
@@ -564,20 +603,107 @@ int TabletCopyClient::CountRemoteBlocks() const {
     if (rowset.has_adhoc_index_block()) {
       num_blocks++;
     }
+    num_blocks += rowset.secondary_indexes_size();
   }
   return num_blocks;
 }
 
+int TabletCopyClient::NumConcurrentBlockDownloads(int num_blocks) {
+  // Each block download has up to --tablet_copy_fetch_pipeline_depth chunks
+  // requested ahead of the one it is writing.
+  const int64_t bytes_per_download =
+      static_cast<int64_t>(std::max(FLAGS_tablet_copy_fetch_pipeline_depth, 0) + 1) *
+      FLAGS_tablet_copy_transfer_chunk_size_bytes;
+  const int64_t max_downloads = std::min<int64_t>(
+      FLAGS_tablet_copy_download_threads_per_session,
+      FLAGS_tablet_copy_max_inflight_bytes_per_session / bytes_per_download);
+  return static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(max_downloads, num_blocks)));
+}
+
 Status TabletCopyClient::DownloadBlocks() {
   CHECK_EQ(kStarted, state_);
 
-  // Count up the total number of blocks to download.
-  int num_remote_blocks = CountRemoteBlocks();
+  // Calls 'f' with each remote block in the order of the superblock.
+  const auto for_each_remote_block = [&](const std::function<void(const BlockIdPB&)>& f) {
+    for (const RowSetDataPB& src_rowset : remote_superblock_->rowsets()) {
+      for (const ColumnDataPB& src_col : src_rowset.columns()) {
+        f(src_col.block());
+      }
+      for (const DeltaDataPB& src_redo : src_rowset.redo_deltas()) {
+        f(src_redo.block());
+      }
+      for (const DeltaDataPB& src_undo : src_rowset.undo_deltas()) {
+        f(src_undo.block());
+      }
+      if (src_rowset.has_bloom_block()) {
+        f(src_rowset.bloom_block());
+      }
+      if (src_rowset.has_adhoc_index_block()) {
+        f(src_rowset.adhoc_index_block());
+      }
+      for (const SecondaryIndexDataPB& src_index : src_rowset.secondary_indexes()) {
+        f(src_index.block());
+      }
+    }
+  };
+  vector<const BlockIdPB*> src_block_ids;
+  for_each_remote_block([&](const BlockIdPB& block_id) {
+    src_block_ids.push_back(&block_id);
+  });
+  const int num_remote_blocks = src_block_ids.size();
+  DCHECK_EQ(CountRemoteBlocks(), num_remote_blocks);
+
+  // Download the blocks on a pool of threads, each block streaming into its
+  // own WritableBlock. Once a download fails, the downloads which haven't
+  // started yet are skipped.
+  const int num_threads = NumConcurrentBlockDownloads(num_remote_blocks);
+  LOG_WITH_PREFIX(INFO) << "Starting download of " << num_remote_blocks
+                        << " data blocks with " << num_threads << " threads...";
+  vector<BlockIdPB> new_block_ids(num_remote_blocks);
+  AtomicInt<int32_t> block_count(0);
+  Status first_error;
+  simple_spinlock first_error_lock;
+  const auto record_error = [&](const Status& s) {
+    std::lock_guard<simple_spinlock> l(first_error_lock);
+    if (first_error.ok()) {
+      first_error = s;
+    }
+  };
+  unique_ptr<ThreadPool> pool;
+  RETURN_NOT_OK(ThreadPoolBuilder("tablet-copy-blocks")
+                .set_min_threads(0)
+                .set_max_threads(num_threads)
+                .Build(&pool));
+  for (int i = 0; i < num_remote_blocks; i++) {
+    Status s = pool->Submit([&, i]() {
+      {
+        std::lock_guard<simple_spinlock> l(first_error_lock);
+        if (!first_error.ok()) {
+          return;
+        }
+      }
+      Status download_status = DownloadAndRewriteBlock(*src_block_ids[i], num_remote_blocks,
+                                                       &block_count, &new_block_ids[i]);
+      if (!download_status.ok()) {
+        record_error(download_status);
+      }
+    });
+    if (!s.ok()) {
+      record_error(s);
+      break;
+    }
+  }
+  pool->Wait();
+  pool->Shutdown();
 
-  // Download each block, writing the new block IDs into the new superblock
-  // as each block downloads.
-  int block_count = 0;
-  LOG_WITH_PREFIX(INFO) << "Starting download of " << num_remote_blocks << " data blocks...";
+  // Write the new block IDs into the new superblock. If a download failed,
+  // only the blocks which were downloaded are referenced, so that they are
+  // deleted if the copy is aborted.
+  //
+  // We can't leave superblock_ unserializable with unset required field
+  // values in child elements, so a block is only referenced in its rowset
+  // once it's downloaded.
+  int idx = 0;
   for (const RowSetDataPB& src_rowset : remote_superblock_->rowsets()) {
     // Create rowset.
     RowSetDataPB* dst_rowset = superblock_->add_rowsets();
@@ -591,49 +717,56 @@ Status TabletCopyClient::DownloadBlocks() {
     dst_rowset->clear_undo_deltas();
     dst_rowset->clear_bloom_block();
     dst_rowset->clear_adhoc_index_block();
+    dst_rowset->clear_secondary_indexes();
 
-    // We can't leave superblock_ unserializable with unset required field
-    // values in child elements, so we must download and rewrite each block
-    // before referencing it in the rowset.
     for (const ColumnDataPB& src_col : src_rowset.columns()) {
-      BlockIdPB new_block_id;
-      RETURN_NOT_OK(DownloadAndRewriteBlock(src_col.block(), num_remote_blocks,
-                                            &block_count, &new_block_id));
-      ColumnDataPB* dst_col = dst_rowset->add_columns();
-      *dst_col = src_col;
-      *dst_col->mutable_block() = new_block_id;
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        ColumnDataPB* dst_col = dst_rowset->add_columns();
+        *dst_col = src_col;
+        *dst_col->mutable_block() = new_block_id;
+      }
     }
     for (const DeltaDataPB& src_redo : src_rowset.redo_deltas()) {
-      BlockIdPB new_block_id;
-      RETURN_NOT_OK(DownloadAndRewriteBlock(src_redo.block(), num_remote_blocks,
-                                            &block_count, &new_block_id));
-      DeltaDataPB* dst_redo = dst_rowset->add_redo_deltas();
-      *dst_redo = src_redo;
-      *dst_redo->mutable_block() = new_block_id;
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        DeltaDataPB* dst_redo = dst_rowset->add_redo_deltas();
+        *dst_redo = src_redo;
+        *dst_redo->mutable_block() = new_block_id;
+      }
     }
     for (const DeltaDataPB& src_undo : src_rowset.undo_deltas()) {
-      BlockIdPB new_block_id;
-      RETURN_NOT_OK(DownloadAndRewriteBlock(src_undo.block(), num_remote_blocks,
-                                            &block_count, &new_block_id));
-      DeltaDataPB* dst_undo = dst_rowset->add_undo_deltas();
-      *dst_undo = src_undo;
-      *dst_undo->mutable_block() = new_block_id;
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        DeltaDataPB* dst_undo = dst_rowset->add_undo_deltas();
+        *dst_undo = src_undo;
+        *dst_undo->mutable_block() = new_block_id;
+      }
     }
     if (src_rowset.has_bloom_block()) {
-      BlockIdPB new_block_id;
-      RETURN_NOT_OK(DownloadAndRewriteBlock(src_rowset.bloom_block(), num_remote_blocks,
-                                            &block_count, &new_block_id));
-      *dst_rowset->mutable_bloom_block() = new_block_id;
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        *dst_rowset->mutable_bloom_block() = new_block_id;
+      }
     }
     if (src_rowset.has_adhoc_index_block()) {
-      BlockIdPB new_block_id;
-      RETURN_NOT_OK(DownloadAndRewriteBlock(src_rowset.adhoc_index_block(), num_remote_blocks,
-                                            &block_count, &new_block_id));
-      *dst_rowset->mutable_adhoc_index_block() = new_block_id;
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        *dst_rowset->mutable_adhoc_index_block() = new_block_id;
+      }
+    }
+    for (const SecondaryIndexDataPB& src_index : src_rowset.secondary_indexes()) {
+      const BlockIdPB& new_block_id = new_block_ids[idx++];
+      if (new_block_id.has_id()) {
+        SecondaryIndexDataPB* dst_index = dst_rowset->add_secondary_indexes();
+        *dst_index = src_index;
+        *dst_index->mutable_block() = new_block_id;
+      }
     }
   }
+  DCHECK_EQ(num_remote_blocks, idx);
 
-  return Status::OK();
+  return first_error;
 }
 
 Status TabletCopyClient::DownloadWAL(uint64_t wal_segment_seqno) {
@@ -684,18 +817,18 @@ Status TabletCopyClient::WriteConsensusMetadata() {
 
 Status TabletCopyClient::DownloadAndRewriteBlock(const BlockIdPB& src_block_id,
                                                  int num_blocks,
-                                                 int* block_count,
+                                                 AtomicInt<int32_t>* block_count,
                                                  BlockIdPB* dest_block_id) {
   BlockId old_block_id(BlockId::FromPB(src_block_id));
   SetStatusMessage(Substitute("Downloading block $0 ($1/$2)",
                               old_block_id.ToString(),
-                              *block_count + 1, num_blocks));
+                              block_count->Load() + 1, num_blocks));
   BlockId new_block_id;
   RETURN_NOT_OK_PREPEND(DownloadBlock(old_block_id, &new_block_id),
       "Unable to download block with id " + old_block_id.ToString());
 
   new_block_id.CopyToPB(dest_block_id);
-  (*block_count)++;
+  block_count->Increment();
   return Status::OK();
 }
 
@@ -717,6 +850,7 @@ Status TabletCopyClient::DownloadBlock(const BlockId& old_block_id,
 
   *new_block_id = block->id();
   RETURN_NOT_OK_PREPEND(block->Finalize(), "Unable to finalize block");
+  std::lock_guard<simple_spinlock> l(transaction_lock_);
   transaction_->AddCreatedBlock(std::move(block));
   return Status::OK();
 }
@@ -731,24 +865,84 @@ Status TabletCopyClient::DownloadFile(const DataIdPB& data_id,
   req.set_session_id(session_id_);
   req.mutable_data_id()->CopyFrom(data_id);
   req.set_max_length(FLAGS_tablet_copy_transfer_chunk_size_bytes);
+  req.set_data_in_sidecar(FLAGS_tablet_copy_fetch_data_in_sidecars);
+
+  // Once the first chunk has told us the size of the file and the size of
+  // the chunks the source hands out, up to --tablet_copy_fetch_pipeline_depth
+  // further chunks are requested ahead of the one being written, so that the
+  // download isn't bound by the round trip time to the source.
+  struct PendingFetch {
+    PendingFetch() : done(1) {}
+    FetchDataRequestPB req;
+    FetchDataResponsePB resp;
+    rpc::RpcController controller;
+    CountDownLatch done;
+  };
+  std::deque<unique_ptr<PendingFetch>> pending;
+  SCOPED_CLEANUP({
+    // The outstanding calls reference the pending fetches.
+    for (const auto& f : pending) {
+      f->done.Wait();
+    }
+  });
+  const int pipeline_depth = FLAGS_tablet_copy_fetch_pipeline_depth;
+  bool pipelining = pipeline_depth > 0;
+  uint64_t total_length = 0;
+  uint64_t stride = 0;
+  uint64_t next_offset = 0;
 
   bool done = false;
   while (!done) {
-    req.set_offset(offset);
+    while (pipelining && stride > 0 && static_cast<int>(pending.size()) < pipeline_depth &&
+           next_offset < total_length) {
+      unique_ptr<PendingFetch> f(new PendingFetch);
+      f->req = req;
+      f->req.set_offset(next_offset);
+      f->controller.set_timeout(MonoDelta::FromMilliseconds(session_idle_timeout_millis_));
+      PendingFetch* f_ptr = f.get();
+      proxy_->FetchDataAsync(f->req, &f->resp, &f->controller,
+                             [f_ptr]() { f_ptr->done.CountDown(); });
+      pending.emplace_back(std::move(f));
+      next_offset += stride;
+    }
 
-    // Request the next data chunk.
-    FetchDataResponsePB resp;
-    RETURN_NOT_OK_PREPEND(SendRpcWithRetry(&controller, [&] {
-          return proxy_->FetchData(req, &resp, &controller);
-    }), "unable to fetch data from remote");
+    // Take the next chunk from the pipeline if it's there and arrived intact.
+    // Otherwise, fetch it synchronously, retrying as needed.
+    //
+    // The data of the chunk may be in a sidecar of the call, so the
+    // controller of the call is kept until the data is written.
+    unique_ptr<PendingFetch> fetched;
+    FetchDataResponsePB sync_resp;
+    const FetchDataResponsePB* resp = &sync_resp;
+    const rpc::RpcController* resp_controller = &controller;
+    if (!pending.empty()) {
+      unique_ptr<PendingFetch> f(std::move(pending.front()));
+      pending.pop_front();
+      f->done.Wait();
+      if (f->controller.status().ok() && f->req.offset() == offset) {
+        fetched = std::move(f);
+        resp = &fetched->resp;
+        resp_controller = &fetched->controller;
+      }
+    }
+    if (!fetched) {
+      req.set_offset(offset);
+      RETURN_NOT_OK_PREPEND(SendRpcWithRetry(&controller, [&] {
+            return proxy_->FetchData(req, &sync_resp, &controller);
+      }), "unable to fetch data from remote");
+    }
+    Slice data;
+    RETURN_NOT_OK_PREPEND(GetChunkData(*resp, *resp_controller, &data),
+                          Substitute("Error getting data item $0",
+                                     pb_util::SecureShortDebugString(data_id)));
 
     // Sanity-check for corruption.
-    RETURN_NOT_OK_PREPEND(VerifyData(offset, resp.chunk()),
+    RETURN_NOT_OK_PREPEND(VerifyData(offset, resp->chunk(), data),
                           Substitute("Error validating data item $0",
                                      pb_util::SecureShortDebugString(data_id)));
 
     // Write the data.
-    RETURN_NOT_OK(appendable->Append(resp.chunk().data()));
+    RETURN_NOT_OK(appendable->Append(data));
 
     if (PREDICT_FALSE(FLAGS_tablet_copy_download_file_inject_latency_ms > 0)) {
       LOG_WITH_PREFIX(INFO) << "Injecting latency into file download: " <<
@@ -756,18 +950,41 @@ Status TabletCopyClient::DownloadFile(const DataIdPB& data_id,
       SleepFor(MonoDelta::FromMilliseconds(FLAGS_tablet_copy_download_file_inject_latency_ms));
     }
 
-    auto chunk_size = resp.chunk().data().size();
-    done = offset + chunk_size == resp.chunk().total_data_length();
+    auto chunk_size = data.size();
+    done = offset + chunk_size == resp->chunk().total_data_length();
     offset += chunk_size;
     if (tablet_copy_metrics_) {
       tablet_copy_metrics_->bytes_fetched->IncrementBy(chunk_size);
     }
+
+    if (pipelining && stride == 0 && !done && chunk_size > 0) {
+      total_length = resp->chunk().total_data_length();
+      stride = chunk_size;
+      next_offset = offset;
+    } else if (!done && stride > 0 && chunk_size != stride) {
+      // The source handed out a short chunk in the middle of the file, so the
+      // offsets requested ahead no longer line up. Finish the file without
+      // pipelining; the chunks in flight are waited for and ignored.
+      pipelining = false;
+    }
   }
 
   return Status::OK();
 }
 
-Status TabletCopyClient::VerifyData(uint64_t offset, const DataChunkPB& chunk) {
+Status TabletCopyClient::GetChunkData(const FetchDataResponsePB& resp,
+                                      const rpc::RpcController& controller,
+                                      Slice* data) {
+  const DataChunkPB& chunk = resp.chunk();
+  if (!chunk.has_data_sidecar_idx()) {
+    *data = chunk.data();
+    return Status::OK();
+  }
+  return controller.GetInboundSidecar(chunk.data_sidecar_idx(), data);
+}
+
+Status TabletCopyClient::VerifyData(uint64_t offset, const DataChunkPB& chunk,
+                                    const Slice& data) {
   // Verify the offset is what we expected.
   if (offset != chunk.offset()) {
     return Status::InvalidArgument("Offset did not match what was asked for",
@@ -775,17 +992,17 @@ Status TabletCopyClient::VerifyData(uint64_t offset, const DataChunkPB& chunk) {
   }
 
   // Verify that the chunk does not overflow the total data length.
-  if (offset + chunk.data().length() > chunk.total_data_length()) {
+  if (offset + data.size() > chunk.total_data_length()) {
     return Status::InvalidArgument("Chunk exceeds total block data length",
-        Substitute("$0 vs $1", offset + chunk.data().length(), chunk.total_data_length()));
+        Substitute("$0 vs $1", offset + data.size(), chunk.total_data_length()));
   }
 
   // Verify the checksum.
-  uint32_t crc32 = crc::Crc32c(chunk.data().data(), chunk.data().length());
+  uint32_t crc32 = crc::Crc32c(data.data(), data.size());
   if (PREDICT_FALSE(crc32 != chunk.crc32())) {
     return Status::Corruption(
         Substitute("CRC32 does not match at offset $0 size $1: $2 vs $3",
-          offset, chunk.data().size(), crc32, chunk.crc32()));
+          offset, data.size(), crc32, chunk.crc32()));
   }
   return Status::OK();
 }
@@ -25,6 +25,8 @@
 
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/util/atomic.h"
+#include "kudu/util/locks.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/random.h"
 #include "kudu/util/status.h"
@@ -35,6 +37,7 @@ class BlockId;
 class BlockIdPB;
 class FsManager;
 class HostPort;
+class Slice;
 
 namespace consensus {
 class ConsensusMetadata;
@@ -60,6 +63,7 @@ class TabletSuperBlockPB;
 namespace tserver {
 class DataIdPB;
 class DataChunkPB;
+class FetchDataResponsePB;
 class TabletCopyServiceProxy;
 
 // Server-wide tablet copy metrics.
@@ -74,7 +78,7 @@ struct TabletCopyClientMetrics {
 // This class is not thread-safe.
 //
 // TODO:
-// * Parallelize download of blocks and WAL segments.
+// * Parallelize download of WAL segments.
 //
 class TabletCopyClient {
  public:
@@ -193,13 +197,20 @@ class TabletCopyClient {
   // Count the number of blocks on the remote (from 'remote_superblock_').
   int CountRemoteBlocks() const;
 
-  // Download all blocks belonging to a tablet sequentially. Add all
+  // Download all blocks belonging to a tablet, up to
+  // --tablet_copy_download_threads_per_session of them at a time. Add all
   // downloaded blocks to the tablet copy's transaction.
   //
   // Blocks are given new IDs upon creation. On success, 'superblock_'
-  // is populated to reflect the new block IDs.
+  // is populated to reflect the new block IDs. On failure, it references
+  // the blocks which were downloaded, so that Abort() deletes them.
   Status DownloadBlocks();
 
+  // Returns the number of blocks to download concurrently out of
+  // 'num_blocks', as bounded by the number of download threads and by the
+  // budget of bytes in flight per session.
+  static int NumConcurrentBlockDownloads(int num_blocks);
+
   // Download the remote block specified by 'src_block_id'. 'num_blocks' should
   // be given as the total number of blocks there are to download (for logging
   // purposes). Add the block to the tablet copy's transaction, to close blocks
@@ -208,9 +219,11 @@ class TabletCopyClient {
   // On success:
   // - 'dest_block_id' is set to the new ID of the downloaded block.
   // - 'block_count' is incremented by 1.
+  //
+  // This method is thread-safe.
   Status DownloadAndRewriteBlock(const BlockIdPB& src_block_id,
                                  int num_blocks,
-                                 int* block_count,
+                                 AtomicInt<int32_t>* block_count,
                                  BlockIdPB* dest_block_id);
 
   // Download a single block.
@@ -218,6 +231,8 @@ class TabletCopyClient {
   // and added to the tablet copy's transaction.
   //
   // On success, 'new_block_id' is set to the new ID of the downloaded block.
+  //
+  // This method is thread-safe.
   Status DownloadBlock(const BlockId& old_block_id,
                        BlockId* new_block_id);
 
@@ -231,7 +246,15 @@ class TabletCopyClient {
   template<class Appendable>
   Status DownloadFile(const DataIdPB& data_id, Appendable* appendable);
 
-  Status VerifyData(uint64_t offset, const DataChunkPB& resp);
+  // Points 'data' at the data of the chunk in 'resp', which is either in the
+  // chunk itself or in a sidecar of the call made with 'controller'.
+  static Status GetChunkData(const FetchDataResponsePB& resp,
+                             const rpc::RpcController& controller,
+                             Slice* data);
+
+  // Verifies that 'data', the data of 'chunk', is the intact data expected
+  // at 'offset'.
+  Status VerifyData(uint64_t offset, const DataChunkPB& chunk, const Slice& data);
 
   // Runs the provided functor, which must send an RPC and return the result
   // status, until it succeeds, times out, or fails with a non-retriable error.
@@ -271,13 +294,17 @@ class TabletCopyClient {
   std::vector<uint64_t> wal_seqnos_;
   int64_t start_time_micros_;
 
-  Random rng_;
+  // Used by the concurrent block downloads to jitter their retries.
+  ThreadSafeRandom rng_;
 
   TabletCopyClientMetrics* tablet_copy_metrics_;
 
   // Block transaction for the tablet copy.
   std::unique_ptr<fs::BlockCreationTransaction> transaction_;
 
+  // Protects 'transaction_' while blocks are downloaded concurrently.
+  simple_spinlock transaction_lock_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletCopyClient);
 };
 
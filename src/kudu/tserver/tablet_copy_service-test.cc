@@ -49,6 +49,7 @@
 #include "kudu/tserver/tablet_copy.pb.h"
 #include "kudu/tserver/tablet_copy.proxy.h"
 #include "kudu/tserver/tablet_server.h"
+#include "kudu/util/crc.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/monotime.h"
@@ -420,6 +421,38 @@ TEST_F(TabletCopyServiceTest, TestFetchBlockAtOnce) {
   AssertDataEqual(local_data.data(), local_data.size(), resp.chunk());
 }
 
+// Test that a block's data is sent in a sidecar when the client asks for it.
+TEST_F(TabletCopyServiceTest, TestFetchBlockInSidecar) {
+  string session_id;
+  tablet::TabletSuperBlockPB superblock;
+  ASSERT_OK(DoBeginValidTabletCopySession(&session_id, &superblock));
+
+  // Local.
+  BlockId block_id = FirstColumnBlockId(superblock);
+  Slice local_data;
+  faststring scratch;
+  ASSERT_OK(ReadLocalBlockFile(mini_server_->server()->fs_manager(), block_id,
+                               &scratch, &local_data));
+
+  // Remote.
+  FetchDataRequestPB req;
+  req.set_session_id(session_id);
+  *req.mutable_data_id() = AsDataTypeId(block_id);
+  req.set_data_in_sidecar(true);
+  FetchDataResponsePB resp;
+  RpcController controller;
+  controller.set_timeout(MonoDelta::FromSeconds(1.0));
+  ASSERT_OK(UnwindRemoteError(tablet_copy_proxy_->FetchData(req, &resp, &controller),
+                              &controller));
+
+  ASSERT_TRUE(resp.chunk().has_data_sidecar_idx());
+  ASSERT_TRUE(resp.chunk().data().empty());
+  Slice remote_data;
+  ASSERT_OK(controller.GetInboundSidecar(resp.chunk().data_sidecar_idx(), &remote_data));
+  ASSERT_EQ(local_data, remote_data);
+  ASSERT_EQ(crc::Crc32c(local_data.data(), local_data.size()), resp.chunk().crc32());
+}
+
 // Test that we are able to incrementally fetch blocks.
 TEST_F(TabletCopyServiceTest, TestFetchBlockIncrementally) {
   string session_id;
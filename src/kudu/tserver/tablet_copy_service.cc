@@ -36,6 +36,7 @@
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/rpc_context.h"
+#include "kudu/rpc/rpc_sidecar.h"
 #include "kudu/server/server_base.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_replica.h"
@@ -289,31 +290,45 @@ void TabletCopyServiceImpl::FetchData(const FetchDataRequestPB* req,
                     error_code, "Invalid DataId", context);
 
   DataChunkPB* data_chunk = resp->mutable_chunk();
-  string* data = data_chunk->mutable_data();
+  string data;
   int64_t total_data_length = 0;
   if (data_id.type() == DataIdPB::BLOCK) {
     // Fetching a data block chunk.
     const BlockId& block_id = BlockId::FromPB(data_id.block_id());
     RPC_RETURN_NOT_OK(session->GetBlockPiece(block_id, offset, client_maxlen,
-                                             data, &total_data_length, &error_code),
+                                             &data, &total_data_length, &error_code),
                       error_code, "Unable to get piece of data block", context);
   } else {
     // Fetching a log segment chunk.
     uint64_t segment_seqno = data_id.wal_segment_seqno();
     RPC_RETURN_NOT_OK(session->GetLogSegmentPiece(segment_seqno, offset, client_maxlen,
-                                                  data, &total_data_length, &error_code),
+                                                  &data, &total_data_length, &error_code),
                       error_code, "Unable to get piece of log segment", context);
   }
 
   data_chunk->set_total_data_length(total_data_length);
   data_chunk->set_offset(offset);
 
-  tablet_copy_metrics_.bytes_sent->IncrementBy(resp->chunk().data().size());
+  tablet_copy_metrics_.bytes_sent->IncrementBy(data.size());
 
   // Calculate checksum.
-  uint32_t crc32 = Crc32c(data->data(), data->length());
+  uint32_t crc32 = Crc32c(data.data(), data.length());
   data_chunk->set_crc32(crc32);
 
+  // Hand the buffer the data was read into over to the response, as a
+  // sidecar if the client can take one, so that it's written to the socket
+  // without going through the protobuf.
+  if (req->data_in_sidecar()) {
+    int sidecar_idx;
+    RPC_RETURN_NOT_OK(context->AddOutboundSidecar(
+                          rpc::RpcSidecar::FromString(std::move(data)), &sidecar_idx),
+                      TabletCopyErrorPB::UNKNOWN_ERROR, "Unable to add data sidecar", context);
+    data_chunk->set_data("");
+    data_chunk->set_data_sidecar_idx(sidecar_idx);
+  } else {
+    data_chunk->mutable_data()->swap(data);
+  }
+
   context->RespondSuccess();
 }
 
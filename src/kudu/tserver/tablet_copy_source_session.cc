@@ -44,8 +44,10 @@
 #include "kudu/rpc/transfer.h"
 #include "kudu/tablet/tablet_metadata.h"
 #include "kudu/tablet/tablet_replica.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/monotime.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/stopwatch.h"
@@ -56,6 +58,13 @@ DEFINE_int32(tablet_copy_transfer_chunk_size_bytes, 4 * 1024 * 1024,
              "tablet servers.");
 TAG_FLAG(tablet_copy_transfer_chunk_size_bytes, hidden);
 
+DEFINE_int64(tablet_copy_source_readahead_bytes, 16 * 1024 * 1024,
+             "The number of bytes of a block a tablet copy source reads at once "
+             "and buffers to serve the following chunk requests of the block. "
+             "Reads no larger than this are served without read-ahead.");
+TAG_FLAG(tablet_copy_source_readahead_bytes, advanced);
+TAG_FLAG(tablet_copy_source_readahead_bytes, runtime);
+
 METRIC_DEFINE_counter(server, tablet_copy_bytes_sent,
                       "Bytes Sent For Tablet Copy",
                       kudu::MetricUnit::kBytes,
@@ -256,6 +265,36 @@ static Status GetResponseDataSize(int64_t total_size,
   return Status::OK();
 }
 
+Status ImmutableReadableBlockInfo::Read(uint64_t offset, Slice data) const {
+  const int64_t readahead_bytes = FLAGS_tablet_copy_source_readahead_bytes;
+  if (readahead_bytes <= static_cast<int64_t>(data.size())) {
+    return readable->Read(offset, data);
+  }
+
+  MutexLock l(readahead_lock);
+  if (offset < readahead_offset ||
+      offset + data.size() > readahead_offset + readahead_buf.size()) {
+    // Refill the buffer from 'offset'. Concurrent out-of-order requests may
+    // discard a buffer before it's consumed, which only costs another read.
+    const uint64_t len = std::max<uint64_t>(
+        data.size(), std::min<uint64_t>(readahead_bytes, size - offset));
+    readahead_buf.resize(len);
+    Status s = readable->Read(offset, Slice(readahead_buf.data(), len));
+    if (PREDICT_FALSE(!s.ok())) {
+      readahead_buf.clear();
+      return s;
+    }
+    readahead_offset = offset;
+  }
+  memcpy(const_cast<uint8_t*>(data.data()),
+         readahead_buf.data() + (offset - readahead_offset), data.size());
+  if (offset + data.size() == readahead_offset + readahead_buf.size()) {
+    readahead_buf.clear();
+    readahead_buf.shrink_to_fit();
+  }
+  return Status::OK();
+}
+
 // Read a chunk of a file into a buffer.
 // data_name provides a string for the block/log to be used in error messages.
 template <class Info>
@@ -36,7 +36,9 @@
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tserver/tablet_copy.pb.h"
 #include "kudu/util/env.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/mutex.h"
 #include "kudu/util/once.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -83,12 +85,25 @@ struct ImmutableReadableBlockInfo {
   ImmutableReadableBlockInfo(fs::ReadableBlock* readable,
                              int64_t size)
   : readable(readable),
-    size(size) {
+    size(size),
+    readahead_offset(0) {
   }
 
-  Status Read(uint64_t offset, Slice data) const {
-    return readable->Read(offset, data);
-  }
+  // Reads 'data.size()' bytes at 'offset' into 'data'.
+  //
+  // The block is read --tablet_copy_source_readahead_bytes at a time into a
+  // read-ahead buffer, from which the following reads are served, so that the
+  // consecutive chunks a client requests of a block take one larger read.
+  // The buffer is released once its last byte has been read.
+  //
+  // This method is thread-safe.
+  Status Read(uint64_t offset, Slice data) const;
+
+  // Protects the read-ahead buffer.
+  mutable Mutex readahead_lock;
+  // The bytes of the block read ahead, starting at 'readahead_offset'.
+  mutable faststring readahead_buf;
+  mutable uint64_t readahead_offset;
 };
 
 // A potential Learner must establish a TabletCopySourceSession with the leader in order
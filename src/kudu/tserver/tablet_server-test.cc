@@ -54,6 +54,8 @@
 #include "kudu/common/wire_protocol-test-util.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus.proxy.h"
 #include "kudu/consensus/log-test-base.h"
 #include "kudu/consensus/log.h"
 #include "kudu/consensus/metadata.pb.h"
@@ -84,6 +86,7 @@
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet.h"
 #include "kudu/tablet/tablet_metadata.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/heartbeater.h"
 #include "kudu/tserver/mini_tablet_server.h"
@@ -98,11 +101,15 @@
 #include "kudu/tserver/tserver_service.pb.h"
 #include "kudu/tserver/tserver_service.proxy.h"
 #include "kudu/util/array_view.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/curl_util.h"
 #include "kudu/util/env.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/hash.pb.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/logging_test_util.h"
@@ -166,6 +173,9 @@ DECLARE_bool(enable_maintenance_manager);
 DECLARE_bool(enable_rowset_compaction);
 DECLARE_bool(fail_dns_resolution);
 DECLARE_bool(rowset_metadata_store_keys);
+DECLARE_bool(scan_stage_timing);
+DECLARE_bool(scanner_adaptive_batch_size);
+DECLARE_bool(scanner_prefetch);
 DECLARE_bool(scanner_unregister_on_invalid_seq_id);
 DECLARE_double(cfile_inject_corruption);
 DECLARE_double(env_inject_eio);
@@ -179,8 +189,12 @@ DECLARE_int32(maintenance_manager_polling_interval_ms);
 DECLARE_int32(memory_pressure_percentage);
 DECLARE_int32(metrics_retirement_age_ms);
 DECLARE_int32(scanner_batch_size_rows);
+DECLARE_int64(scan_result_cache_capacity_mb);
 DECLARE_int32(scanner_gc_check_interval_us);
+DECLARE_int32(scanner_max_batch_size_bytes);
+DECLARE_int32(scanner_min_adaptive_batch_size_bytes);
 DECLARE_int32(scanner_ttl_ms);
+DECLARE_int32(write_backpressure_max_delay_ms);
 DECLARE_string(block_manager);
 DECLARE_string(env_inject_eio_globs);
 DECLARE_string(env_inject_full_globs);
@@ -198,6 +212,15 @@ METRIC_DECLARE_gauge_size(active_scanners);
 METRIC_DECLARE_gauge_size(tablet_active_scanners);
 METRIC_DECLARE_gauge_size(num_rowsets_on_disk);
 METRIC_DECLARE_histogram(flush_dms_duration);
+METRIC_DECLARE_histogram(write_apply_duration);
+METRIC_DECLARE_histogram(write_apply_insert_duration);
+METRIC_DECLARE_histogram(write_apply_mutate_duration);
+METRIC_DECLARE_histogram(write_apply_queue_duration);
+METRIC_DECLARE_histogram(write_decode_duration);
+METRIC_DECLARE_histogram(write_prepare_queue_duration);
+METRIC_DECLARE_histogram(write_replicate_duration);
+METRIC_DECLARE_histogram(write_response_duration);
+METRIC_DECLARE_histogram(write_row_lock_wait_duration);
 
 namespace kudu {
 
@@ -1007,6 +1030,43 @@ TEST_F(TabletServerMaintenanceMemoryPressureTest, TestCompactWhileUnderMemoryPre
   });
 }
 
+// Test that once a tablet's MemRowSet outgrows the flush threshold, writes to
+// it are answered with a suggested delay which grows with the MemRowSet.
+TEST_F(TabletServerTest, TestWriteBackpressure) {
+  FLAGS_flush_threshold_mb = 1;
+  FLAGS_write_backpressure_max_delay_ms = 1000;
+
+  int32_t next_key = 0;
+  auto write_row = [&](WriteResponsePB* resp) {
+    WriteRequestPB req;
+    req.set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToPB(schema_, req.mutable_schema()));
+    AddTestRowToPB(RowOperationsPB::INSERT, schema_, next_key++, 1, "row",
+                   req.mutable_row_operations());
+    RpcController controller;
+    ASSERT_OK(proxy_->Write(req, resp, &controller));
+    ASSERT_FALSE(resp->has_error()) << SecureShortDebugString(*resp);
+  };
+
+  {
+    WriteResponsePB resp;
+    NO_FATALS(write_row(&resp));
+    ASSERT_FALSE(resp.has_suggested_delay_ms());
+  }
+
+  // Grow the MemRowSet to twice the threshold, at which point writes should
+  // be delayed by the maximum.
+  while (tablet_replica_->tablet()->MemRowSetSize() < 2 * 1024 * 1024) {
+    NO_FATALS(InsertTestRowsDirect(next_key, 1000));
+    next_key += 1000;
+  }
+  {
+    WriteResponsePB resp;
+    NO_FATALS(write_row(&resp));
+    ASSERT_EQ(1000, resp.suggested_delay_ms());
+  }
+}
+
 TEST_F(TabletServerTest, TestInsert) {
   WriteRequestPB req;
 
@@ -1113,6 +1173,44 @@ TEST_F(TabletServerTest, TestInsert) {
   ASSERT_GE(now_after.value(), now_before.value());
 }
 
+// Test that a MultiWrite RPC reports the error of each write in its own
+// response, and lists only the writes rejected before they were submitted as
+// unsubmitted.
+TEST_F(TabletServerTest, TestMultiWrite) {
+  MultiWriteRequestPB req;
+  // A write which succeeds.
+  WriteRequestPB* write = req.add_requests();
+  write->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToPB(schema_, write->mutable_schema()));
+  AddTestRowToPB(RowOperationsPB::INSERT, schema_, 1, 1, "one", write->mutable_row_operations());
+  // A write to a tablet which doesn't exist, which is rejected before it's
+  // submitted.
+  write = req.add_requests();
+  write->set_tablet_id("does-not-exist");
+  ASSERT_OK(SchemaToPB(schema_, write->mutable_schema()));
+  AddTestRowToPB(RowOperationsPB::INSERT, schema_, 2, 2, "two", write->mutable_row_operations());
+  // A write without a schema, which fails once it's submitted.
+  write = req.add_requests();
+  write->set_tablet_id(kTabletId);
+  AddTestRowToPB(RowOperationsPB::INSERT, schema_, 3, 3, "three",
+                 write->mutable_row_operations());
+
+  MultiWriteResponsePB resp;
+  RpcController controller;
+  ASSERT_OK(proxy_->MultiWrite(req, &resp, &controller));
+  SCOPED_TRACE(SecureDebugString(resp));
+  ASSERT_EQ(3, resp.responses_size());
+  ASSERT_FALSE(resp.responses(0).has_error());
+  ASSERT_TRUE(resp.responses(1).has_error());
+  ASSERT_EQ(TabletServerErrorPB::TABLET_NOT_FOUND, resp.responses(1).error().code());
+  ASSERT_TRUE(resp.responses(2).has_error());
+  ASSERT_EQ(TabletServerErrorPB::MISMATCHED_SCHEMA, resp.responses(2).error().code());
+  ASSERT_EQ(1, resp.unsubmitted_writes_size());
+  ASSERT_EQ(1, resp.unsubmitted_writes(0));
+
+  NO_FATALS(VerifyRows(schema_, { KeyValue(1, 1) }));
+}
+
 TEST_F(TabletServerTest, TestExternalConsistencyModes_ClientPropagated) {
   WriteRequestPB req;
   req.set_tablet_id(kTabletId);
@@ -1402,6 +1500,31 @@ TEST_F(TabletServerTest, TestInsertAndMutate) {
   ASSERT_GE(now_after.value(), now_before.value());
 }
 
+// Test that the latency of each stage of a write is recorded in the stage
+// histograms of the tablet.
+TEST_F(TabletServerTest, TestWriteStageHistograms) {
+  NO_FATALS(InsertTestRowsRemote(0, 10));
+  NO_FATALS(UpdateTestRowRemote(1, 100));
+
+  const auto& entity = tablet_replica_->tablet()->GetMetricEntity();
+  for (const auto* proto : { &METRIC_write_prepare_queue_duration,
+                             &METRIC_write_decode_duration,
+                             &METRIC_write_row_lock_wait_duration,
+                             &METRIC_write_replicate_duration,
+                             &METRIC_write_apply_queue_duration,
+                             &METRIC_write_apply_duration,
+                             &METRIC_write_apply_insert_duration,
+                             &METRIC_write_apply_mutate_duration,
+                             &METRIC_write_response_duration }) {
+    SCOPED_TRACE(proto->name());
+    // One sample per write transaction: the ten inserts and the update. The
+    // samples are recorded after the responses are sent.
+    ASSERT_EVENTUALLY([&] {
+      ASSERT_EQ(11, proto->Instantiate(entity)->TotalCount());
+    });
+  }
+}
+
 // Try sending write requests that do not contain write operations. Make sure
 // we get an error that makes sense.
 TEST_F(TabletServerTest, TestInvalidWriteRequest_WrongOpType) {
@@ -2217,6 +2340,107 @@ TEST_F(TabletServerTest, TestSnapshotScan_WithoutSnapshotTimestamp) {
   ASSERT_GT(resp.propagated_timestamp(), resp.snap_timestamp());
 }
 
+// Tests that repeating a snapshot scan returns the cached results of the
+// first one, even once the tablet has been written to.
+TEST_F(TabletServerTest, TestSnapshotScanResultCache) {
+  FLAGS_scan_result_cache_capacity_mb = 1;
+  ASSERT_OK(ShutdownAndRebuildTablet());
+  vector<uint64_t> write_timestamps_collector;
+  InsertTestRowsRemote(0, 10, 1, nullptr, kTabletId, &write_timestamps_collector);
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  scan->set_read_mode(READ_AT_SNAPSHOT);
+  scan->set_snap_timestamp(write_timestamps_collector[0]);
+
+  const auto scan_and_stringify = [&](vector<string>* results) {
+    ScanResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+    ASSERT_FALSE(resp.has_more_results());
+    ASSERT_EQ(write_timestamps_collector[0], resp.snap_timestamp());
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, results));
+  };
+  vector<string> results;
+  NO_FATALS(scan_and_stringify(&results));
+  ASSERT_EQ(10, results.size());
+
+  // Writes after the snapshot don't change the results, so they stay cached.
+  InsertTestRowsRemote(10, 10);
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+  const auto* metrics = tablet_replica_->tablet()->metrics();
+  const int64_t scans_started = metrics->scans_started->value();
+  vector<string> cached_results;
+  NO_FATALS(scan_and_stringify(&cached_results));
+  ASSERT_EQ(results, cached_results);
+  ASSERT_EQ(scans_started, metrics->scans_started->value());
+
+  // A different projection isn't served from the cache.
+  scan->mutable_projected_columns()->RemoveLast();
+  ScanResponsePB resp;
+  RpcController rpc;
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  ASSERT_EQ(scans_started + 1, metrics->scans_started->value());
+}
+
+// Scans may refer to bloom filters which were registered beforehand by ID.
+TEST_F(TabletServerTest, TestScanWithRegisteredBloomFilter) {
+  InsertTestRowsRemote(0, 100);
+
+  // Register a filter holding the even keys.
+  BlockBloomFilter filter(DefaultBlockBloomFilterBufferAllocator::GetSingleton());
+  ASSERT_OK(filter.Init(BlockBloomFilter::MinLogSpace(50, 0.01), FAST_HASH, 0));
+  for (int32_t key = 0; key < 100; key += 2) {
+    filter.Insert(Slice(reinterpret_cast<const uint8_t*>(&key), sizeof(key)));
+  }
+  {
+    RegisterBloomFilterRequestPB req;
+    RegisterBloomFilterResponsePB resp;
+    RpcController rpc;
+    req.set_filter_id("even-keys");
+    filter.CopyToPB(req.mutable_bloom_filter());
+    req.set_ttl_ms(60 * 1000);
+    ASSERT_OK(proxy_->RegisterBloomFilter(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  }
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  ColumnPredicatePB* pred = scan->add_column_predicates();
+  pred->set_column(schema_.column(0).name());
+  pred->mutable_in_bloom_filter()->add_registered_filter_ids("even-keys");
+  req.set_call_seq_id(0);
+  {
+    ScanResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+    ASSERT_FALSE(resp.has_more_results());
+    vector<string> results;
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+    // The even keys pass the filter, along with few if any false positives.
+    ASSERT_GE(results.size(), 50);
+    ASSERT_LE(results.size(), 60);
+  }
+
+  // A scan which refers to a filter that wasn't registered fails.
+  pred->mutable_in_bloom_filter()->set_registered_filter_ids(0, "odd-keys");
+  {
+    ScanResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+    ASSERT_STR_CONTAINS(resp.error().status().message(), "odd-keys is not registered");
+  }
+}
+
 // Tests that a snapshot in the future (beyond the current time plus maximum
 // synchronization error) fails as an invalid snapshot.
 TEST_F(TabletServerTest, TestSnapshotScan_SnapshotInTheFutureFails) {
@@ -2693,6 +2917,85 @@ TEST_F(TabletServerTest, TestColumnarScan) {
 }
 
 
+TEST_F(TabletServerTest, TestCompressedColumnarScan) {
+  const int kNumRows = 1000;
+  InsertTestRowsDirect(0, kNumRows);
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  scan->set_columnar_compression(LZ4);
+
+  // Compression is only supported with the columnar layout.
+  {
+    ScanResponsePB resp;
+    RpcController rpc;
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_TRUE(resp.has_error());
+    ASSERT_EQ(TabletServerErrorPB::INVALID_SCAN_SPEC, resp.error().code());
+    ASSERT_STR_CONTAINS(resp.error().status().message(), "columnar layout");
+  }
+
+  scan->set_row_format_flags(RowFormatFlags::COLUMNAR_LAYOUT);
+  ScanResponsePB resp;
+  RpcController rpc;
+  rpc.RequireServerFeature(TabletServerFeatures::COLUMNAR_COMPRESSION_FEATURE);
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  SCOPED_TRACE(SecureDebugString(resp));
+  ASSERT_FALSE(resp.has_error());
+  const ColumnarRowBlockPB& data = resp.columnar_data();
+  ASSERT_EQ(kNumRows, data.num_rows());
+  ASSERT_EQ(LZ4, data.compression());
+  const CompressionCodec* codec;
+  ASSERT_OK(GetCompressionCodec(LZ4, &codec));
+
+  auto decompress = [&](int sidecar_idx, int64_t uncompressed_size, faststring* out) {
+    Slice compressed;
+    ASSERT_OK(rpc.GetInboundSidecar(sidecar_idx, &compressed));
+    ASSERT_LT(compressed.size(), static_cast<size_t>(uncompressed_size));
+    out->resize(uncompressed_size);
+    ASSERT_OK(codec->Uncompress(compressed, out->data(), uncompressed_size));
+  };
+
+  // The ascending int32 keys compress well.
+  {
+    const auto& col = data.columns(0);
+    ASSERT_TRUE(col.has_data_uncompressed_size());
+    faststring col_data;
+    NO_FATALS(decompress(col.data_sidecar(), col.data_uncompressed_size(), &col_data));
+    ASSERT_EQ(kNumRows * sizeof(int32_t), col_data.size());
+    ArrayView<const int32_t> cells(reinterpret_cast<const int32_t*>(col_data.data()), kNumRows);
+    for (int i = 0; i < kNumRows; i++) {
+      EXPECT_EQ(i, cells[i]);
+    }
+  }
+
+  // So do the "hello <n>" strings.
+  {
+    const auto& col = data.columns(2);
+    ASSERT_TRUE(col.has_varlen_data_uncompressed_size());
+    faststring varlen_data;
+    NO_FATALS(decompress(col.varlen_data_sidecar(), col.varlen_data_uncompressed_size(),
+                         &varlen_data));
+    faststring offsets_data;
+    if (col.has_data_uncompressed_size()) {
+      NO_FATALS(decompress(col.data_sidecar(), col.data_uncompressed_size(), &offsets_data));
+    } else {
+      Slice raw;
+      ASSERT_OK(rpc.GetInboundSidecar(col.data_sidecar(), &raw));
+      offsets_data.assign_copy(raw.data(), raw.size());
+    }
+    ASSERT_EQ((kNumRows + 1) * sizeof(uint32_t), offsets_data.size());
+    ArrayView<const uint32_t> offsets(reinterpret_cast<const uint32_t*>(offsets_data.data()),
+                                      kNumRows + 1);
+    for (int i = 0; i < kNumRows; i++) {
+      Slice real_str(varlen_data.data() + offsets[i], offsets[i + 1] - offsets[i]);
+      ASSERT_EQ(Substitute("hello $0", i), real_str);
+    }
+  }
+}
+
 TEST_F(TabletServerTest, TestNonPositiveLimitsShortCircuit) {
   InsertTestRowsDirect(0, 10);
   for (int limit : { -1, 0 }) {
@@ -2722,6 +3025,119 @@ TEST_F(TabletServerTest, TestNonPositiveLimitsShortCircuit) {
 }
 
 // Randomized test that runs a few scans with varying limits.
+TEST_F(TabletServerTest, TestAggregateScan) {
+  const int kNumRows = 100;
+  InsertTestRowsDirect(0, kNumRows);
+
+  // COUNT(*), SUM(int_val), MIN(string_val), MAX(key) over the whole tablet.
+  {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    rpc.RequireServerFeature(TabletServerFeatures::AGGREGATION_FEATURE);
+    AggregationPB* aggregation = scan->mutable_aggregation();
+    for (const auto& type_and_idx : vector<pair<AggregatePB::Type, int>>{
+        { AggregatePB::COUNT, -1 },
+        { AggregatePB::SUM, 1 },
+        { AggregatePB::MIN, 2 },
+        { AggregatePB::MAX, 0 } }) {
+      AggregatePB* aggregate = aggregation->add_aggregates();
+      aggregate->set_type(type_and_idx.first);
+      if (type_and_idx.second >= 0) {
+        aggregate->set_projection_idx(type_and_idx.second);
+      }
+    }
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_FALSE(resp.has_more_results());
+    ASSERT_FALSE(resp.has_data());
+
+    ASSERT_EQ(1, resp.aggregate_groups_size());
+    const AggregateGroupPB& group = resp.aggregate_groups(0);
+    ASSERT_EQ("", group.encoded_group_key());
+    ASSERT_EQ(4, group.values_size());
+    EXPECT_EQ(kNumRows, group.values(0).int_value());
+    EXPECT_EQ(kNumRows * (kNumRows - 1), group.values(1).int_value());
+    EXPECT_EQ("hello 0", group.values(2).cell_value());
+    int32_t max_key = kNumRows - 1;
+    EXPECT_EQ(string(reinterpret_cast<const char*>(&max_key), sizeof(max_key)),
+              group.values(3).cell_value());
+  }
+
+  // COUNT(int_val) grouped by the key: every row is its own group.
+  {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    AggregationPB* aggregation = scan->mutable_aggregation();
+    aggregation->set_num_group_by_columns(1);
+    AggregatePB* aggregate = aggregation->add_aggregates();
+    aggregate->set_type(AggregatePB::COUNT);
+    aggregate->set_projection_idx(1);
+
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_FALSE(resp.has_more_results());
+
+    ASSERT_EQ(kNumRows, resp.aggregate_groups_size());
+    string prev_key;
+    for (const auto& group : resp.aggregate_groups()) {
+      ASSERT_LT(prev_key, group.encoded_group_key());
+      prev_key = group.encoded_group_key();
+      ASSERT_EQ(1, group.values_size());
+      EXPECT_EQ(1, group.values(0).int_value());
+    }
+  }
+}
+
+TEST_F(TabletServerTest, TestInvalidAggregateScan) {
+  NO_FATALS(InsertTestRowsDirect(0, 10));
+
+  ScanRequestPB req;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  req.set_call_seq_id(0);
+
+  // Group by a column which isn't a prefix of the primary key.
+  ColumnSchemaToPB(schema_.column(1), scan->add_projected_columns());
+  AggregationPB* aggregation = scan->mutable_aggregation();
+  aggregation->set_num_group_by_columns(1);
+  AggregatePB* aggregate = aggregation->add_aggregates();
+  aggregate->set_type(AggregatePB::COUNT);
+  NO_FATALS(VerifyScanRequestFailure(req,
+                                     TabletServerErrorPB::INVALID_SCAN_SPEC,
+                                     "Group-by column int_val is not a prefix of the primary key"));
+
+  // Sum a string column.
+  ColumnSchemaToPB(schema_.column(2), scan->add_projected_columns());
+  aggregation->set_num_group_by_columns(0);
+  aggregate->set_type(AggregatePB::SUM);
+  aggregate->set_projection_idx(1);
+  NO_FATALS(VerifyScanRequestFailure(req,
+                                     TabletServerErrorPB::INVALID_SCAN_SPEC,
+                                     "Cannot compute SUM of column string_val"));
+
+  // Aggregations can't be combined with a limit.
+  aggregate->set_projection_idx(0);
+  scan->set_limit(1);
+  NO_FATALS(VerifyScanRequestFailure(req,
+                                     TabletServerErrorPB::INVALID_SCAN_SPEC,
+                                     "Cannot specify a limit for a scan with an aggregation"));
+}
+
 TEST_F(TabletServerTest, TestRandomizedScanLimits) {
   // Set a relatively small batch size...
   const int kBatchSizeRows = rand() % 1000;
@@ -2802,6 +3218,214 @@ TEST_F(TabletServerTest, TestScanWithPredicates) {
   ASSERT_EQ(50, results.size());
 }
 
+// Test that a scan which reads batches ahead of the client's requests returns
+// every row exactly once, in order.
+TEST_F(TabletServerTest, TestScanWithPrefetch) {
+  FLAGS_scanner_prefetch = true;
+  FLAGS_scanner_batch_size_rows = 10;
+  int num_rows = AllowSlowTests() ? 10000 : 1000;
+  InsertTestRowsDirect(0, num_rows);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  scan->set_order_mode(ORDERED);
+  req.set_batch_size_bytes(1000);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_TRUE(resp.has_more_results());
+  }
+  vector<string> results;
+  NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+  NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &results,
+                                  proxy_.get(), /*call_seq_id=*/1));
+
+  ASSERT_EQ(num_rows, results.size());
+  for (int i = 0; i < num_rows; i++) {
+    ASSERT_EQ(Substitute("(int32 key=$0, int32 int_val=$1, string string_val=\"hello $0\")",
+                         i, i * 2),
+              results[i]);
+  }
+}
+
+// Test that a continuation request asking for a larger batch than the one
+// read ahead of it gets a batch of the size it asked for, and that the scan
+// still returns every row exactly once, in order, when the batch size changes.
+TEST_F(TabletServerTest, TestScanWithPrefetchAndChangedBatchSize) {
+  FLAGS_scanner_prefetch = true;
+  FLAGS_scanner_batch_size_rows = 10;
+  constexpr int kNumRows = 1000;
+  InsertTestRowsDirect(0, kNumRows);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  scan->set_order_mode(ORDERED);
+  req.set_batch_size_bytes(1000);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  ASSERT_TRUE(resp.has_more_results());
+  const string scanner_id = resp.scanner_id();
+  vector<string> results;
+  NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+  const int first_batch_rows = results.size();
+
+  // Waits for the batch following the last response to be read ahead.
+  auto wait_for_prefetch = [&]() {
+    ASSERT_EVENTUALLY([&] {
+      SharedScanner scanner;
+      TabletServerErrorPB::Code error_code;
+      ASSERT_OK(mini_server_->server()->scanner_manager()->LookupScanner(
+          scanner_id, proxy_->user_credentials().real_user(), &error_code, &scanner));
+      auto scanner_lock = scanner->LockForAccess();
+      ASSERT_TRUE(scanner->has_prefetched_batch());
+    });
+  };
+  // Continues the scan with the given batch size, returning the number of
+  // rows in the response.
+  uint32_t call_seq_id = 1;
+  auto continue_scan = [&](int batch_size_bytes, int* num_rows) {
+    ScanRequestPB cont_req;
+    ScanResponsePB cont_resp;
+    RpcController cont_rpc;
+    cont_req.set_scanner_id(scanner_id);
+    cont_req.set_call_seq_id(call_seq_id++);
+    cont_req.set_batch_size_bytes(batch_size_bytes);
+    ASSERT_OK(proxy_->Scan(cont_req, &cont_resp, &cont_rpc));
+    ASSERT_FALSE(cont_resp.has_error()) << SecureShortDebugString(cont_resp);
+    ASSERT_TRUE(cont_resp.has_more_results());
+    const int prev_size = results.size();
+    NO_FATALS(StringifyRowsFromResponse(schema_, cont_rpc, &cont_resp, &results));
+    *num_rows = results.size() - prev_size;
+  };
+
+  // A larger batch than the one read ahead is topped up to the new size.
+  NO_FATALS(wait_for_prefetch());
+  int num_rows;
+  NO_FATALS(continue_scan(10000, &num_rows));
+  ASSERT_GT(num_rows, 2 * first_batch_rows);
+
+  // A smaller batch than the one read ahead still returns the whole batch,
+  // since its rows have been consumed from the iterator.
+  NO_FATALS(wait_for_prefetch());
+  NO_FATALS(continue_scan(100, &num_rows));
+  ASSERT_GT(num_rows, first_batch_rows);
+
+  NO_FATALS(DrainScannerToStrings(scanner_id, schema_, &results,
+                                  proxy_.get(), call_seq_id));
+  ASSERT_EQ(kNumRows, results.size());
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_EQ(Substitute("(int32 key=$0, int32 int_val=$1, string string_val=\"hello $0\")",
+                         i, i * 2),
+              results[i]);
+  }
+}
+
+// Test that the time a scan spends in each of its stages is returned to the
+// client and accumulated in the scan's descriptor.
+TEST_F(TabletServerTest, TestScanStageTimes) {
+  // Two flushed rowsets with overlapping key ranges, so that an ordered scan
+  // decodes and merges them.
+  InsertTestRowsDirect(0, 500);
+  InsertTestRowsDirect(1500, 500);
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+  InsertTestRowsDirect(500, 1000);
+  ASSERT_OK(tablet_replica_->tablet()->Flush());
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  scan->set_read_mode(READ_AT_SNAPSHOT);
+  scan->set_order_mode(ORDERED);
+  req.set_batch_size_bytes(1024 * 1024);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  ASSERT_FALSE(resp.has_more_results());
+
+  const ResourceMetricsPB& metrics = resp.resource_metrics();
+  EXPECT_GT(metrics.decode_nanos(), 0);
+  EXPECT_GT(metrics.merge_nanos(), 0);
+  EXPECT_GT(metrics.serialize_nanos(), 0);
+  EXPECT_TRUE(metrics.has_decompress_nanos());
+  EXPECT_TRUE(metrics.has_predicate_eval_nanos());
+  EXPECT_TRUE(metrics.has_delta_apply_nanos());
+  EXPECT_TRUE(metrics.has_cache_miss_wait_nanos());
+
+  // The completed scan's descriptor holds the stage times of the scanner.
+  vector<ScanDescriptor> scans = mini_server_->server()->scanner_manager()->ListScans();
+  ASSERT_EQ(1, scans.size());
+  EXPECT_GT(scans[0].stage_times.nanos(ScanStage::kDecode), 0);
+  EXPECT_GT(scans[0].stage_times.nanos(ScanStage::kMerge), 0);
+
+  // Without stage timing, no stage times are returned.
+  FLAGS_scan_stage_timing = false;
+  rpc.Reset();
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  EXPECT_TRUE(resp.has_resource_metrics());
+  EXPECT_FALSE(resp.resource_metrics().has_decode_nanos());
+  EXPECT_FALSE(resp.resource_metrics().has_merge_nanos());
+}
+
+// Test that scans which don't request a batch size are sized adaptively, and
+// that the chosen size is reported to the client.
+TEST_F(TabletServerTest, TestScanWithAdaptiveBatchSize) {
+  FLAGS_scanner_adaptive_batch_size = true;
+  FLAGS_scanner_min_adaptive_batch_size_bytes = 1024;
+  FLAGS_scanner_max_batch_size_bytes = 16 * 1024;
+  FLAGS_scanner_batch_size_rows = 10;
+  int num_rows = AllowSlowTests() ? 10000 : 1000;
+  InsertTestRowsDirect(0, num_rows);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  ASSERT_TRUE(resp.has_more_results());
+  ASSERT_TRUE(resp.has_batch_size_bytes());
+
+  vector<string> results;
+  NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+  ScanRequestPB continue_req;
+  continue_req.set_scanner_id(resp.scanner_id());
+  for (int call_seq_id = 1; resp.has_more_results(); call_seq_id++) {
+    rpc.Reset();
+    continue_req.set_call_seq_id(call_seq_id);
+    ASSERT_OK(proxy_->Scan(continue_req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+    ASSERT_TRUE(resp.has_batch_size_bytes());
+    ASSERT_GE(resp.batch_size_bytes(), FLAGS_scanner_min_adaptive_batch_size_bytes);
+    ASSERT_LE(resp.batch_size_bytes(), FLAGS_scanner_max_batch_size_bytes);
+    NO_FATALS(StringifyRowsFromResponse(schema_, rpc, &resp, &results));
+  }
+  ASSERT_EQ(num_rows, results.size());
+
+  // Scans which request a batch size aren't sized adaptively.
+  rpc.Reset();
+  req.set_batch_size_bytes(1000);
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << SecureShortDebugString(resp);
+  ASSERT_FALSE(resp.has_batch_size_bytes());
+}
+
 TEST_F(TabletServerTest, TestScanWithEncodedPredicates) {
   InsertTestRowsDirect(0, 100);
 
@@ -3574,6 +4198,38 @@ TEST_F(TabletServerTest, TestCreateTablet_TabletExists) {
   }
 }
 
+TEST_F(TabletServerTest, TestCreateTablets) {
+  CreateTabletsRequestPB req;
+  CreateTabletsResponsePB resp;
+  RpcController rpc;
+
+  req.set_dest_uuid(mini_server_->server()->fs_manager()->uuid());
+  Schema schema = SchemaBuilder(schema_).Build();
+  for (const string& tablet_id : { string(kTabletId), string("new-tablet") }) {
+    CreateTabletRequestPB* tablet_req = req.add_tablets();
+    tablet_req->set_table_id("testtb");
+    tablet_req->set_tablet_id(tablet_id);
+    tablet_req->set_table_name("testtb");
+    tablet_req->mutable_config()->CopyFrom(mini_server_->CreateLocalConfig());
+    ASSERT_OK(SchemaToPB(schema, tablet_req->mutable_schema()));
+  }
+
+  // The first tablet already exists, the second one is created.
+  {
+    SCOPED_TRACE(SecureDebugString(req));
+    ASSERT_OK(admin_proxy_->CreateTablets(req, &resp, &rpc));
+    SCOPED_TRACE(SecureDebugString(resp));
+    ASSERT_FALSE(resp.has_error());
+    ASSERT_EQ(2, resp.tablet_responses_size());
+    ASSERT_TRUE(resp.tablet_responses(0).has_error());
+    ASSERT_EQ(TabletServerErrorPB::TABLET_ALREADY_EXISTS,
+              resp.tablet_responses(0).error().code());
+    ASSERT_FALSE(resp.tablet_responses(1).has_error());
+  }
+  scoped_refptr<TabletReplica> replica;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet("new-tablet", &replica));
+}
+
 TEST_F(TabletServerTest, TestDeleteTablet) {
   scoped_refptr<TabletReplica> tablet;
 
@@ -3666,6 +4322,32 @@ TEST_F(TabletServerTest, TestDeleteTablet_TabletNotCreated) {
   }
 }
 
+// Test that a batch of consensus updates reports the errors of each request
+// in that request's response.
+TEST_F(TabletServerTest, TestBatchUpdateConsensusErrors) {
+  consensus::BatchConsensusRequestPB req;
+  consensus::BatchConsensusResponsePB resp;
+  RpcController rpc;
+
+  auto* not_found_req = req.add_requests();
+  not_found_req->set_dest_uuid(mini_server_->uuid());
+  not_found_req->set_tablet_id("NotPresentTabletId");
+  not_found_req->set_caller_uuid("caller");
+  not_found_req->set_caller_term(1);
+  auto* wrong_uuid_req = req.add_requests();
+  wrong_uuid_req->set_dest_uuid("NotThisServer");
+  wrong_uuid_req->set_tablet_id(kTabletId);
+  wrong_uuid_req->set_caller_uuid("caller");
+  wrong_uuid_req->set_caller_term(1);
+
+  SCOPED_TRACE(SecureDebugString(req));
+  ASSERT_OK(consensus_proxy_->BatchUpdateConsensus(req, &resp, &rpc));
+  SCOPED_TRACE(SecureDebugString(resp));
+  ASSERT_EQ(2, resp.responses_size());
+  ASSERT_EQ(TabletServerErrorPB::TABLET_NOT_FOUND, resp.responses(0).error().code());
+  ASSERT_EQ(TabletServerErrorPB::WRONG_SERVER_UUID, resp.responses(1).error().code());
+}
+
 TEST_F(TabletServerTest, TestDeleteTabletBenchmark) {
   // Collect some related metrics.
   scoped_refptr<AtomicGauge<uint64_t>> block_count =
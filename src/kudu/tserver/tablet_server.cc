@@ -23,24 +23,69 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/fs/block_manager.h"
 #include "kudu/fs/error_manager.h"
 #include "kudu/fs/fs_manager.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/rpc/service_if.h"
 #include "kudu/server/rpc_server.h"
 #include "kudu/tserver/heartbeater.h"
+#include "kudu/tserver/bloom_filter_registry.h"
+#include "kudu/tserver/scan_result_cache.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_copy_service.h"
 #include "kudu/tserver/tablet_service.h"
 #include "kudu/tserver/ts_tablet_manager.h"
 #include "kudu/tserver/tserver_path_handlers.h"
+#include "kudu/util/env.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/maintenance_manager.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/monotime.h"
 #include "kudu/util/net/dns_resolver.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/status.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_string(block_cache_save_path, "",
+              "If set, the path of a file to which the tablet server saves the "
+              "contents of the block cache when it shuts down, and from which it "
+              "loads them back when it restarts, so that scans don't have to warm "
+              "the block cache up again. The blocks of CFiles which no longer "
+              "exist are skipped when loading. The file should be on a fast local "
+              "disk with room for the whole block cache.");
+TAG_FLAG(block_cache_save_path, experimental);
+
+DEFINE_int64(scanner_prefetch_memory_limit_mb, 256,
+             "Maximum amount of memory, in megabytes, used by scan batches which "
+             "were read ahead of clients' requests. See --scanner_prefetch.");
+TAG_FLAG(scanner_prefetch_memory_limit_mb, experimental);
+
+DEFINE_int64(scan_result_cache_capacity_mb, 0,
+             "Capacity, in megabytes, of the cache of the results of scans at "
+             "a snapshot timestamp chosen by the client which return all of "
+             "their rows in a single batch. Repeating such a scan returns the "
+             "cached results. If 0, no results are cached.");
+TAG_FLAG(scan_result_cache_capacity_mb, experimental);
+
+DEFINE_int64(bloom_filter_registry_capacity_mb, 256,
+             "Maximum amount of memory, in megabytes, used by the bloom filters "
+             "registered with the tablet server for scans to refer to by ID.");
+TAG_FLAG(bloom_filter_registry_capacity_mb, experimental);
+
+DEFINE_int32(scanner_column_read_threads, 0,
+             "Number of threads used by scans to read the data blocks of all "
+             "projected columns needed by a batch concurrently, rather than "
+             "one column after another. Only scans which fill the block cache "
+             "are affected. If 0, columns are not read concurrently.");
+TAG_FLAG(scanner_column_read_threads, experimental);
 
 using kudu::fs::ErrorHandlerType;
 using kudu::rpc::ServiceIf;
@@ -100,10 +145,38 @@ Status TabletServer::Init() {
   }
 
   maintenance_manager_ = std::make_shared<MaintenanceManager>(
-      MaintenanceManager::kDefaultOptions, fs_manager_->uuid());
+      MaintenanceManager::kDefaultOptions, fs_manager_->uuid(), metric_entity());
 
   heartbeater_.reset(new Heartbeater(std::move(master_addrs), this));
 
+  RETURN_NOT_OK(ThreadPoolBuilder("scan")
+                .set_min_threads(0)
+                .set_max_threads(base::NumCPUs())
+                .Build(&scan_pool_));
+  RETURN_NOT_OK(ThreadPoolBuilder("scan-prefetch")
+                .set_min_threads(0)
+                .set_max_threads(base::NumCPUs())
+                .Build(&scan_prefetch_pool_));
+  if (FLAGS_scanner_column_read_threads > 0) {
+    RETURN_NOT_OK(ThreadPoolBuilder("scan-column-read")
+                  .set_min_threads(0)
+                  .set_max_threads(FLAGS_scanner_column_read_threads)
+                  .Build(&column_read_pool_));
+  }
+  scan_prefetch_mem_tracker_ = MemTracker::CreateTracker(
+      FLAGS_scanner_prefetch_memory_limit_mb * 1024 * 1024, "scanner-prefetch", mem_tracker());
+  if (FLAGS_scan_result_cache_capacity_mb > 0) {
+    scan_result_cache_.reset(
+        new ScanResultCache(FLAGS_scan_result_cache_capacity_mb * 1024 * 1024));
+  }
+  bloom_filter_registry_.reset(
+      new BloomFilterRegistry(FLAGS_bloom_filter_registry_capacity_mb * 1024 * 1024));
+
+  // Warm the block cache up before the tablets start serving scans.
+  if (!FLAGS_block_cache_save_path.empty()) {
+    WARN_NOT_OK(LoadBlockCache(), "Unable to load the saved block cache");
+  }
+
   RETURN_NOT_OK_PREPEND(tablet_manager_->Init(),
                         "Could not init Tablet Manager");
 
@@ -156,8 +229,9 @@ void TabletServer::ShutdownImpl() {
     const string name = rpc_server_->ToString();
     LOG(INFO) << "TabletServer@" << name << " shutting down...";
 
-    // 1. Stop accepting new RPCs.
+    // 1. Stop accepting new RPCs, and stop reading ahead for existing scans.
     UnregisterAllServices();
+    scan_prefetch_pool_->Shutdown();
 
     // 2. Shut down the tserver's subsystems.
     maintenance_manager_->Shutdown();
@@ -165,6 +239,9 @@ void TabletServer::ShutdownImpl() {
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::DISK_ERROR);
     fs_manager_->UnsetErrorNotificationCb(ErrorHandlerType::CFILE_CORRUPTION);
     tablet_manager_->Shutdown();
+    if (!FLAGS_block_cache_save_path.empty()) {
+      WARN_NOT_OK(SaveBlockCache(), "Unable to save the block cache");
+    }
 
     // 3. Shut down generic subsystems.
     KuduServer::Shutdown();
@@ -173,5 +250,39 @@ void TabletServer::ShutdownImpl() {
   state_ = kStopped;
 }
 
+Status TabletServer::LoadBlockCache() {
+  const string& path = FLAGS_block_cache_save_path;
+  Env* env = fs_manager_->env();
+  if (!env->FileExists(path)) {
+    return Status::OK();
+  }
+  vector<BlockId> block_ids;
+  RETURN_NOT_OK(fs_manager_->block_manager()->GetAllBlockIds(&block_ids));
+  const BlockIdSet live_blocks(block_ids.begin(), block_ids.end());
+  int64_t num_loaded;
+  MonoTime start = MonoTime::Now();
+  Status s = cfile::BlockCache::GetSingleton()->LoadFromFile(
+      env, path,
+      [&live_blocks](const BlockId& id) { return ContainsKey(live_blocks, id); },
+      &num_loaded);
+  // The saved blocks were loaded once; don't load them again after a crash.
+  WARN_NOT_OK(env->DeleteFile(path), "Unable to delete the saved block cache");
+  RETURN_NOT_OK(s);
+  LOG(INFO) << strings::Substitute("Loaded $0 blocks into the block cache from $1 in $2",
+                          num_loaded, path, (MonoTime::Now() - start).ToString());
+  return Status::OK();
+}
+
+Status TabletServer::SaveBlockCache() {
+  const string& path = FLAGS_block_cache_save_path;
+  int64_t num_saved;
+  MonoTime start = MonoTime::Now();
+  RETURN_NOT_OK(cfile::BlockCache::GetSingleton()->SaveToFile(
+      fs_manager_->env(), path, &num_saved));
+  LOG(INFO) << strings::Substitute("Saved $0 blocks of the block cache to $1 in $2",
+                          num_saved, path, (MonoTime::Now() - start).ToString());
+  return Status::OK();
+}
+
 } // namespace tserver
 } // namespace kudu
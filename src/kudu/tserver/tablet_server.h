@@ -30,10 +30,14 @@
 namespace kudu {
 
 class MaintenanceManager;
+class MemTracker;
+class ThreadPool;
 
 namespace tserver {
 
+class BloomFilterRegistry;
 class Heartbeater;
+class ScanResultCache;
 class ScannerManager;
 class TSTabletManager;
 class TabletServerPathHandlers;
@@ -70,6 +74,27 @@ class TabletServer : public kserver::KuduServer {
 
   ScannerManager* scanner_manager() { return scanner_manager_.get(); }
 
+  // Pool of threads used by scans which read several rowsets in parallel.
+  ThreadPool* scan_pool() { return scan_pool_.get(); }
+
+  // Pool of threads used to read scan batches ahead of clients' requests.
+  ThreadPool* scan_prefetch_pool() { return scan_prefetch_pool_.get(); }
+
+  // Pool of threads used to read the columns of scan batches concurrently,
+  // or nullptr if they're read one after another.
+  ThreadPool* column_read_pool() { return column_read_pool_.get(); }
+
+  // Tracks the memory of scan batches read ahead of clients' requests.
+  const std::shared_ptr<MemTracker>& scan_prefetch_mem_tracker() const {
+    return scan_prefetch_mem_tracker_;
+  }
+
+  // Cache of the results of repeated snapshot scans, or nullptr if disabled.
+  ScanResultCache* scan_result_cache() { return scan_result_cache_.get(); }
+
+  // Bloom filters registered for scans to refer to by ID.
+  BloomFilterRegistry* bloom_filter_registry() { return bloom_filter_registry_.get(); }
+
   Heartbeater* heartbeater() { return heartbeater_.get(); }
 
   void set_fail_heartbeats_for_tests(bool fail_heartbeats_for_tests) {
@@ -106,6 +131,13 @@ class TabletServer : public kserver::KuduServer {
   // safe in a particular case.
   void ShutdownImpl();
 
+  // Loads the blocks saved to --block_cache_save_path into the block cache,
+  // if the file exists, and deletes the file.
+  Status LoadBlockCache();
+
+  // Saves the blocks of the block cache to --block_cache_save_path.
+  Status SaveBlockCache();
+
   TabletServerState state_;
 
   std::atomic<bool> quiescing_;
@@ -119,6 +151,28 @@ class TabletServer : public kserver::KuduServer {
   // Manager for tablets which are available on this server.
   std::unique_ptr<TSTabletManager> tablet_manager_;
 
+  // Thread pool for parallel scans. Declared before 'scanner_manager_' so that
+  // it is destroyed after any scanners whose iterators still use it.
+  std::unique_ptr<ThreadPool> scan_pool_;
+
+  // Thread pool for reading scan batches ahead of clients' requests. This is
+  // separate from 'scan_pool_' since prefetching tasks may wait on it.
+  std::unique_ptr<ThreadPool> scan_prefetch_pool_;
+
+  // Thread pool for reading the columns of scan batches concurrently. Its
+  // tasks never wait on other tasks, so it may be used from any of the above.
+  std::unique_ptr<ThreadPool> column_read_pool_;
+
+  // Memory budget for scan batches read ahead of clients' requests.
+  std::shared_ptr<MemTracker> scan_prefetch_mem_tracker_;
+
+  // Cache of the results of snapshot scans. Null unless
+  // --scan_result_cache_capacity_mb is positive.
+  std::unique_ptr<ScanResultCache> scan_result_cache_;
+
+  // Bloom filters registered for scans to refer to by ID.
+  std::unique_ptr<BloomFilterRegistry> bloom_filter_registry_;
+
   // Manager for open scanners from clients.
   // This is always non-NULL. It is scoped only to minimize header
   // dependencies.
@@ -22,11 +22,14 @@
 #include <cstdint>
 #include <cstring>
 #include <functional>
+#include <initializer_list>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <string>
 #include <type_traits>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <boost/optional/optional.hpp>
@@ -41,8 +44,10 @@
 #include "kudu/common/encoded_key.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/iterator_stats.h"
+#include "kudu/common/key_encoder.h"
 #include "kudu/common/key_range.h"
 #include "kudu/common/partition.h"
+#include "kudu/common/partition_pruner.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/schema.h"
@@ -51,6 +56,7 @@
 #include "kudu/common/wire_protocol.h"
 #include "kudu/common/wire_protocol.pb.h"
 #include "kudu/consensus/consensus.pb.h"
+#include "kudu/consensus/consensus_peers.h"
 #include "kudu/consensus/opid.pb.h"
 #include "kudu/consensus/raft_consensus.h"
 #include "kudu/consensus/replica_management.pb.h"
@@ -83,6 +89,8 @@
 #include "kudu/tablet/transactions/alter_schema_transaction.h"
 #include "kudu/tablet/transactions/transaction.h"
 #include "kudu/tablet/transactions/write_transaction.h"
+#include "kudu/tserver/bloom_filter_registry.h"
+#include "kudu/tserver/scan_result_cache.h"
 #include "kudu/tserver/scanners.h"
 #include "kudu/tserver/tablet_replica_lookup.h"
 #include "kudu/tserver/tablet_server.h"
@@ -92,12 +100,16 @@
 #include "kudu/tserver/tserver_service.pb.h"
 #include "kudu/util/auto_release_pool.h"
 #include "kudu/util/bitset.h"
+#include "kudu/util/block_bloom_filter.h"
+#include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/compression/compression_codec.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
 #include "kudu/util/memory/arena.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/monotime.h"
@@ -106,6 +118,7 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
+#include "kudu/util/threadpool.h"
 #include "kudu/util/trace.h"
 #include "kudu/util/trace_metrics.h"
 
@@ -131,6 +144,14 @@ DEFINE_bool(scanner_allow_snapshot_scans_with_logical_timestamps, false,
             "If set, the server will support snapshot scans with logical timestamps.");
 TAG_FLAG(scanner_allow_snapshot_scans_with_logical_timestamps, unsafe);
 
+DEFINE_bool(scanner_leader_snapshot_at_latest_committed, false,
+            "Whether a leader picks the latest timestamp at which all acknowledged "
+            "writes are visible, rather than the current time, as the timestamp of "
+            "READ_AT_SNAPSHOT scans which don't specify one. Such scans then don't "
+            "wait for the writes which are still in flight to commit.");
+TAG_FLAG(scanner_leader_snapshot_at_latest_committed, experimental);
+TAG_FLAG(scanner_leader_snapshot_at_latest_committed, runtime);
+
 DEFINE_int32(scanner_max_wait_ms, 1000,
              "The maximum amount of time (in milliseconds) we'll hang a scanner thread waiting for "
              "safe time to advance or transactions to commit, even if its deadline allows waiting "
@@ -149,6 +170,43 @@ DEFINE_bool(scanner_inject_service_unavailable_on_continue_scan, false,
            "any Scan continuation RPC call. Used for tests.");
 TAG_FLAG(scanner_inject_service_unavailable_on_continue_scan, unsafe);
 
+DEFINE_int32(scanner_max_parallelism, 1,
+             "The maximum number of rowsets an UNORDERED scan reads concurrently, "
+             "using a pool of threads shared by all scans. If 1, each scan is served "
+             "by the thread handling its RPCs.");
+TAG_FLAG(scanner_max_parallelism, experimental);
+TAG_FLAG(scanner_max_parallelism, runtime);
+
+DEFINE_bool(scanner_adaptive_batch_size, false,
+            "Whether to adjust the batch size of each scan whose client doesn't request "
+            "one, according to how fast the client consumes batches compared to how "
+            "fast the tablet server produces them. Batches start at "
+            "--scanner_default_batch_size_bytes and are kept between "
+            "--scanner_min_adaptive_batch_size_bytes and --scanner_max_batch_size_bytes.");
+TAG_FLAG(scanner_adaptive_batch_size, experimental);
+TAG_FLAG(scanner_adaptive_batch_size, runtime);
+
+DEFINE_int32(scanner_min_adaptive_batch_size_bytes, 64 * 1024,
+             "The minimum batch size of scans sized adaptively. See "
+             "--scanner_adaptive_batch_size.");
+TAG_FLAG(scanner_min_adaptive_batch_size_bytes, experimental);
+TAG_FLAG(scanner_min_adaptive_batch_size_bytes, runtime);
+
+DEFINE_bool(scanner_prefetch, false,
+            "Whether to read the next batch of a scan in the background once a "
+            "batch has been returned, so that the next batch is ready when the client "
+            "asks for it. The memory used by such batches is limited by "
+            "--scanner_prefetch_memory_limit_mb.");
+TAG_FLAG(scanner_prefetch, experimental);
+TAG_FLAG(scanner_prefetch, runtime);
+
+DEFINE_bool(scanner_use_rowset_rollups, true,
+            "Whether scans with an aggregation read the rollups of the DiskRowSets "
+            "of tables with rollups instead of their rows, when the rollups can "
+            "stand in for the rows.");
+TAG_FLAG(scanner_use_rowset_rollups, experimental);
+TAG_FLAG(scanner_use_rowset_rollups, runtime);
+
 DEFINE_bool(scanner_unregister_on_invalid_seq_id, true,
             "If set, an invalid sequence ID will cause a scanner to get unregistered. "
             "Used for tests.");
@@ -164,11 +222,24 @@ DEFINE_double(tserver_inject_invalid_authz_token_ratio, 0.0,
               "Fraction of the time that authz token validation will fail. Used for tests.");
 TAG_FLAG(tserver_inject_invalid_authz_token_ratio, hidden);
 
+DEFINE_int32(write_backpressure_max_delay_ms, 0,
+             "If positive, rather than probabilistically rejecting writes past the "
+             "soft memory limit, the tablet server asks clients to delay their writes "
+             "by up to this many milliseconds, in proportion to the memory pressure and "
+             "to how far the tablet's MemRowSet has grown past --flush_threshold_mb. "
+             "Writes are then only rejected past the hard memory limit.");
+TAG_FLAG(write_backpressure_max_delay_ms, experimental);
+TAG_FLAG(write_backpressure_max_delay_ms, runtime);
+
 DECLARE_bool(raft_prepare_replacement_before_eviction);
+DECLARE_bool(scan_stage_timing);
+DECLARE_int32(flush_threshold_mb);
 DECLARE_int32(memory_limit_warn_threshold_percentage);
 DECLARE_int32(tablet_history_max_age_sec);
 
 using google::protobuf::RepeatedPtrField;
+using kudu::consensus::BatchConsensusRequestPB;
+using kudu::consensus::BatchConsensusResponsePB;
 using kudu::consensus::BulkChangeConfigRequestPB;
 using kudu::consensus::ChangeConfigRequestPB;
 using kudu::consensus::ChangeConfigResponsePB;
@@ -213,6 +284,7 @@ using kudu::tablet::WriteAuthorizationContext;
 using kudu::tablet::WritePrivileges;
 using kudu::tablet::WritePrivilegeType;
 using kudu::tablet::WriteTransactionState;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -260,24 +332,34 @@ bool LookupTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
-template<class RespClass>
-void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+// Returns the error to report for 'replica' not being RUNNING, setting
+// 'error_code' to the matching code.
+Status TabletNotRunningError(const scoped_refptr<TabletReplica>& replica,
                              tablet::TabletStatePB tablet_state,
-                             RespClass* resp,
-                             rpc::RpcContext* context) {
+                             TabletServerErrorPB::Code* error_code) {
   Status s = Status::IllegalState("Tablet not RUNNING",
                                   tablet::TabletStatePB_Name(tablet_state));
-  auto error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+  *error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
   if (replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_TOMBSTONED ||
       replica->tablet_metadata()->tablet_data_state() == TABLET_DATA_DELETED) {
     // Treat tombstoned tablets as if they don't exist for most purposes.
     // This takes precedence over failed, since we don't reset the failed
     // status of a TabletReplica when deleting it. Only tablet copy does that.
-    error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
+    *error_code = TabletServerErrorPB::TABLET_NOT_FOUND;
   } else if (tablet_state == tablet::FAILED) {
     s = s.CloneAndAppend(replica->error().ToString());
-    error_code = TabletServerErrorPB::TABLET_FAILED;
+    *error_code = TabletServerErrorPB::TABLET_FAILED;
   }
+  return s;
+}
+
+template<class RespClass>
+void RespondTabletNotRunning(const scoped_refptr<TabletReplica>& replica,
+                             tablet::TabletStatePB tablet_state,
+                             RespClass* resp,
+                             rpc::RpcContext* context) {
+  TabletServerErrorPB::Code error_code;
+  Status s = TabletNotRunningError(replica, tablet_state, &error_code);
   SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
 }
 
@@ -315,6 +397,25 @@ bool LookupRunningTabletReplicaOrRespond(TabletReplicaLookupIf* tablet_manager,
   return true;
 }
 
+// Like LookupRunningTabletReplicaOrRespond(), but returns the failure and
+// sets 'error_code' to the matching code instead of responding.
+Status LookupRunningTabletReplica(TabletReplicaLookupIf* tablet_manager,
+                                  const string& tablet_id,
+                                  scoped_refptr<TabletReplica>* replica,
+                                  TabletServerErrorPB::Code* error_code) {
+  Status s = tablet_manager->GetTabletReplica(tablet_id, replica);
+  if (PREDICT_FALSE(!s.ok())) {
+    *error_code = s.IsServiceUnavailable() ? TabletServerErrorPB::UNKNOWN_ERROR
+                                           : TabletServerErrorPB::TABLET_NOT_FOUND;
+    return s;
+  }
+  tablet::TabletStatePB state = (*replica)->state();
+  if (PREDICT_FALSE(state != tablet::RUNNING)) {
+    return TabletNotRunningError(*replica, state, error_code);
+  }
+  return Status::OK();
+}
+
 template<class ReqClass, class RespClass>
 bool CheckUuidMatchOrRespond(TabletReplicaLookupIf* tablet_manager,
                              const char* method_name,
@@ -404,6 +505,33 @@ void HandleResponse(const ReqType* req, RespType* resp,
   context->RespondSuccess();
 }
 
+// Returns true if the process has exceeded its hard memory limit, writing the
+// percentage of the limit consumed to 'current_capacity_pct' if so.
+bool HardLimitExceeded(double* current_capacity_pct) {
+  int64_t consumption = process_memory::CurrentConsumption();
+  int64_t hard_limit = process_memory::HardLimit();
+  if (consumption <= hard_limit) {
+    return false;
+  }
+  *current_capacity_pct = static_cast<double>(consumption) / hard_limit * 100;
+  return true;
+}
+
+// Returns how long clients should wait before writing to 'tablet' again: up
+// to 'max_delay_ms', in proportion to the process memory pressure or to how
+// far the tablet's MemRowSet has grown past the flush threshold, whichever is
+// greater. The delay is at its maximum once the MemRowSet is twice the
+// threshold, i.e. when flushes clearly can't keep up with the writes.
+uint32_t WriteBackpressureDelayMs(const Tablet& tablet, int32_t max_delay_ms) {
+  double pressure = process_memory::MemoryPressureRatio();
+  const double threshold_bytes = static_cast<double>(FLAGS_flush_threshold_mb) * 1024 * 1024;
+  if (threshold_bytes > 0) {
+    double backlog = (tablet.MemRowSetSize() - threshold_bytes) / threshold_bytes;
+    pressure = std::max(pressure, std::min(backlog, 1.0));
+  }
+  return pressure > 0 ? static_cast<uint32_t>(pressure * max_delay_ms) : 0;
+}
+
 } // namespace
 
 typedef ListTabletsResponsePB::StatusAndSchemaPB StatusAndSchemaPB;
@@ -476,7 +604,8 @@ static bool GetScanPrivilegesOrRespond(const NewScanRequestPB& scan_pb, const Sc
   if (scan_pb.order_mode() == ORDERED ||
       scan_pb.has_start_primary_key() ||
       scan_pb.has_stop_primary_key() ||
-      scan_pb.has_last_primary_key()) {
+      scan_pb.has_last_primary_key() ||
+      scan_pb.key_ranges_size() > 0) {
     const auto& key_cols = schema.get_key_column_ids();
     required_privileges.insert(key_cols.begin(), key_cols.end());
   }
@@ -575,44 +704,95 @@ static bool CheckMayHaveScanPrivilegesOrRespond(const security::TablePrivilegePB
   return false;
 }
 
-// Verifies the authorization token's correctness. Returns false and sends an
-// appropriate response if the request's authz token is invalid.
+// Verifies the authorization token's correctness for a request from
+// 'username'. Returns an error and sets 'error' to the RPC error code to
+// respond with if the request's authz token is invalid.
 template <class AuthorizableRequest>
-static bool VerifyAuthzTokenOrRespond(const TokenVerifier& token_verifier,
-                                      const AuthorizableRequest& req,
-                                      rpc::RpcContext* context,
-                                      TokenPB* token) {
+static Status VerifyAuthzToken(const TokenVerifier& token_verifier,
+                               const AuthorizableRequest& req,
+                               const string& username,
+                               TokenPB* token,
+                               ErrorStatusPB::RpcErrorCodePB* error) {
   DCHECK(token);
+  *error = ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN;
   if (!req.has_authz_token()) {
-    context->RespondRpcFailure(rpc::ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN,
-        Status::NotAuthorized("no authorization token presented"));
-    return false;
+    return Status::NotAuthorized("no authorization token presented");
   }
   TokenPB token_pb;
   const auto result = token_verifier.VerifyTokenSignature(req.authz_token(), &token_pb);
-  ErrorStatusPB::RpcErrorCodePB error;
   Status s = ParseVerificationResult(result,
-      ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN, &error);
+      ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN, error);
   if (!s.ok()) {
-    context->RespondRpcFailure(error, s.CloneAndPrepend("authz token verification failure"));
-    return false;
+    return s.CloneAndPrepend("authz token verification failure");
   }
   if (!token_pb.has_authz() ||
       !token_pb.authz().has_table_privilege() ||
-      token_pb.authz().username() != context->remote_user().username()) {
-    context->RespondRpcFailure(ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN,
-        Status::NotAuthorized("invalid authorization token presented"));
-    return false;
+      token_pb.authz().username() != username) {
+    return Status::NotAuthorized("invalid authorization token presented");
   }
   if (MaybeTrue(FLAGS_tserver_inject_invalid_authz_token_ratio)) {
-    context->RespondRpcFailure(ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN,
-        Status::NotAuthorized("INJECTED FAILURE"));
-    return false;
+    return Status::NotAuthorized("INJECTED FAILURE");
   }
   *token = std::move(token_pb);
+  return Status::OK();
+}
+
+// Verifies the authorization token's correctness. Returns false and sends an
+// appropriate response if the request's authz token is invalid.
+template <class AuthorizableRequest>
+static bool VerifyAuthzTokenOrRespond(const TokenVerifier& token_verifier,
+                                      const AuthorizableRequest& req,
+                                      rpc::RpcContext* context,
+                                      TokenPB* token) {
+  ErrorStatusPB::RpcErrorCodePB error;
+  Status s = VerifyAuthzToken(token_verifier, req, context->remote_user().username(),
+                              token, &error);
+  if (!s.ok()) {
+    context->RespondRpcFailure(error, s);
+    return false;
+  }
   return true;
 }
 
+// Verifies the authorization token of a write from 'username' to the table
+// with ID 'table_id', and returns the write privileges it grants in
+// 'authz_context'. Returns an error and sets 'error' to the RPC error code to
+// respond with if the write isn't authorized.
+static Status VerifyWriteAuthz(const TokenVerifier& token_verifier,
+                               const WriteRequestPB& req,
+                               const string& table_id,
+                               const string& username,
+                               boost::optional<WriteAuthorizationContext>* authz_context,
+                               ErrorStatusPB::RpcErrorCodePB* error) {
+  TokenPB token;
+  RETURN_NOT_OK(VerifyAuthzToken(token_verifier, req, username, &token, error));
+  const auto& privilege = token.authz().table_privilege();
+  if (privilege.table_id() != table_id) {
+    *error = ErrorStatusPB::ERROR_INVALID_AUTHORIZATION_TOKEN;
+    return Status::NotAuthorized("authorization token is for the wrong table ID");
+  }
+  WritePrivileges privileges;
+  if (privilege.insert_privilege()) {
+    InsertOrDie(&privileges, WritePrivilegeType::INSERT);
+  }
+  if (privilege.update_privilege()) {
+    InsertOrDie(&privileges, WritePrivilegeType::UPDATE);
+  }
+  if (privilege.delete_privilege()) {
+    InsertOrDie(&privileges, WritePrivilegeType::DELETE);
+  }
+  if (privileges.empty()) {
+    // If we know there are no write-related privileges outright, we can
+    // short-circuit further checking and reject the request immediately.
+    // Otherwise, we'll defer the checking to the prepare phase of the
+    // transaction after decoding the operations.
+    *error = ErrorStatusPB::FATAL_UNAUTHORIZED;
+    return Status::NotAuthorized("not authorized to write");
+  }
+  *authz_context = WriteAuthorizationContext{ privileges, /*requested_op_types=*/{} };
+  return Status::OK();
+}
+
 static void SetupErrorAndRespond(TabletServerErrorPB* error,
                                  const Status& s,
                                  TabletServerErrorPB::Code code,
@@ -678,19 +858,75 @@ class RpcTransactionCompletionCallback : public TransactionCompletionCallback {
   tablet::TransactionState* state_;
 };
 
+// Keeps track of the writes of a MultiWrite RPC which are yet to complete,
+// responding to the RPC once all of them have.
+class MultiWriteTracker {
+ public:
+  MultiWriteTracker(rpc::RpcContext* context, int num_writes)
+      : context_(context),
+        num_remaining_(num_writes) {
+  }
+
+  void WriteCompleted() {
+    if (num_remaining_.fetch_sub(1) == 1) {
+      context_->RespondSuccess();
+    }
+  }
+
+ private:
+  rpc::RpcContext* context_;
+  std::atomic<int> num_remaining_;
+};
+
+// A transaction completion callback for one of the writes of a MultiWrite
+// RPC. Records the error of the write, if any, in its own response rather
+// than failing the whole RPC.
+class MultiWriteCompletionCallback : public TransactionCompletionCallback {
+ public:
+  MultiWriteCompletionCallback(shared_ptr<MultiWriteTracker> tracker,
+                               WriteResponsePB* response)
+      : tracker_(std::move(tracker)),
+        response_(response) {}
+
+  void TransactionCompleted() override {
+    if (!status_.ok()) {
+      StatusToPB(status_, response_->mutable_error()->mutable_status());
+      response_->mutable_error()->set_code(code_);
+    }
+    tracker_->WriteCompleted();
+  }
+
+ private:
+  const shared_ptr<MultiWriteTracker> tracker_;
+  WriteResponsePB* response_;
+};
+
+class ScanResultCopier;
+
 // Generic interface to handle scan results.
 class ScanResultCollector {
  public:
   virtual void HandleRowBlock(Scanner* scanner,
                               const RowBlock& row_block) = 0;
 
+  // Handles the rollup of a rowset which the scan read instead of its rows.
+  // 'col_ids' are the IDs of the columns of the aggregates which have one,
+  // and 'projection' is the schema of the scan's rows. Only scans with an
+  // aggregation read rollups.
+  virtual void HandleRollup(const Schema& /* projection */,
+                            const vector<ColumnId>& /* col_ids */,
+                            const tablet::RowSetRollupPB& /* rollup */) {
+    LOG(DFATAL) << "unexpected rowset rollup";
+  }
+
   // Returns number of bytes which will be returned in the response.
   virtual int64_t ResponseSize() const = 0;
 
   // Return the number of rows actually returned to the client.
   virtual int64_t NumRowsReturned() const = 0;
 
-  // Initialize the serializer with the given row format flags.
+  // Initialize the serializer with the given row format flags and the codec
+  // with which to compress columnar results.
   //
   // This is a separate function instead of a constructor argument passed to specific
   // collector implementations because, currently, the collector is built before the
@@ -698,17 +934,35 @@ class ScanResultCollector {
   //
   // Does nothing by default.
   virtual Status InitSerializer(uint64_t /* row_format_flags */,
+                                CompressionType /* columnar_compression */,
                                 const Schema& /* scanner_schema */,
                                 const Schema& /* client_schema */) {
     return Status::OK();
   }
 
+  // Takes over the results of 'prefetched', which were read ahead of the
+  // current request. Returns false if this collector can't return such results.
+  virtual bool TakePrefetchedResults(ScanResultCopier* /* prefetched */) {
+    return false;
+  }
+
   CpuTimes* cpu_times() {
     return &cpu_times_;
   }
 
+  // The batch size the tablet server chose for the results of a scan which is
+  // sized adaptively, or 0 if the scan isn't sized adaptively.
+  size_t adaptive_batch_size_bytes() const {
+    return adaptive_batch_size_bytes_;
+  }
+
+  void set_adaptive_batch_size_bytes(size_t batch_size_bytes) {
+    adaptive_batch_size_bytes_ = batch_size_bytes;
+  }
+
  private:
   CpuTimes cpu_times_;
+  size_t adaptive_batch_size_bytes_ = 0;
 };
 
 namespace {
@@ -746,59 +1000,120 @@ class ResultSerializer {
 
   // Serialize the pending rows into the response protobuf.
   // Must be called at most once.
-  virtual void SetupResponse(rpc::RpcContext* context, ScanResponsePB* resp) = 0;
+  //
+  // If 'sidecar_copies' isn't null, a copy of the contents of each sidecar
+  // added to 'context' is appended to it.
+  virtual void SetupResponse(rpc::RpcContext* context,
+                             ScanResponsePB* resp,
+                             vector<faststring>* sidecar_copies) = 0;
+
+ protected:
+  // Appends the concatenated contents of 'chain' to 'copies', if it isn't null.
+  static void MaybeCopySidecar(const vector<faststring>& chain, vector<faststring>* copies) {
+    if (!copies) {
+      return;
+    }
+    faststring copy;
+    for (const auto& buf : chain) {
+      copy.append(buf.data(), buf.size());
+    }
+    copies->emplace_back(std::move(copy));
+  }
 };
 
 class RowwiseResultSerializer : public ResultSerializer {
  public:
   RowwiseResultSerializer(int batch_size_bytes, uint64_t flags)
-      : rows_data_(batch_size_bytes * 11 / 10),
-        indirect_data_(batch_size_bytes * 11 / 10),
+      : chunk_size_(std::min<size_t>(batch_size_bytes * 11 / 10, kMaxChunkSize)),
+        rows_data_size_(0),
+        indirect_data_size_(0),
+        last_rows_data_added_(0),
+        last_indirect_data_added_(0),
         pad_unixtime_micros_to_16_bytes_(flags & RowFormatFlags::PAD_UNIX_TIME_MICROS_TO_16_BYTES) {
-    // TODO(todd): use a chain of faststrings instead of a single one to avoid
-    // allocating this large buffer. Large buffer allocations are slow and
-    // potentially wasteful.
   }
 
   int SerializeRowBlock(const RowBlock& row_block,
                         const Schema* client_projection_schema) override {
+    // Serialize into the last buffers of the chains, unless they're unlikely
+    // to have room for this block, judging by the size of the previous one.
+    faststring* rows_data = ChunkWithRoom(&rows_data_, last_rows_data_added_, chunk_size_);
+    faststring* indirect_data = ChunkWithRoom(&indirect_data_, last_indirect_data_added_,
+                                              last_indirect_data_added_ > 0 ? chunk_size_ : 0);
+    size_t rows_data_before = rows_data->size();
+    size_t indirect_data_before = indirect_data->size();
+    size_t indirect_data_offset = indirect_data_size_ - indirect_data_before;
+
     // TODO(todd) create some kind of serializer object that caches the projection
     // information to avoid recalculating it on every SerializeRowBlock call.
     int num_selected = kudu::SerializeRowBlock(
         row_block, client_projection_schema,
-        &rows_data_, &indirect_data_, pad_unixtime_micros_to_16_bytes_);
+        rows_data, indirect_data, pad_unixtime_micros_to_16_bytes_, indirect_data_offset);
     rowblock_pb_.set_num_rows(rowblock_pb_.num_rows() + num_selected);
+
+    last_rows_data_added_ = rows_data->size() - rows_data_before;
+    last_indirect_data_added_ = indirect_data->size() - indirect_data_before;
+    rows_data_size_ += last_rows_data_added_;
+    indirect_data_size_ += last_indirect_data_added_;
     return num_selected;
   }
 
   size_t ResponseSize() const override {
-    return rows_data_.size() + indirect_data_.size();
+    return rows_data_size_ + indirect_data_size_;
   }
 
-  void SetupResponse(rpc::RpcContext* context, ScanResponsePB* resp) override {
+  void SetupResponse(rpc::RpcContext* context,
+                     ScanResponsePB* resp,
+                     vector<faststring>* sidecar_copies) override {
     CHECK(!done_);
     done_ = true;
 
     *resp->mutable_data() = std::move(rowblock_pb_);
-    // Add sidecar data to context and record the returned indices.
+    // Add sidecar data to context and record the returned indices. Each chain
+    // of buffers is sent back to back as a single sidecar.
+    MaybeCopySidecar(rows_data_, sidecar_copies);
     int rows_idx;
     CHECK_OK(context->AddOutboundSidecar(
-        RpcSidecar::FromFaststring((std::move(rows_data_))), &rows_idx));
+        RpcSidecar::FromFaststrings(std::move(rows_data_)), &rows_idx));
     resp->mutable_data()->set_rows_sidecar(rows_idx);
 
     // Add indirect data as a sidecar, if applicable.
-    if (indirect_data_.size() > 0) {
+    if (indirect_data_size_ > 0) {
+      MaybeCopySidecar(indirect_data_, sidecar_copies);
       int indirect_idx;
       CHECK_OK(context->AddOutboundSidecar(
-          RpcSidecar::FromFaststring(std::move(indirect_data_)), &indirect_idx));
+          RpcSidecar::FromFaststrings(std::move(indirect_data_)), &indirect_idx));
       resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
     }
   }
 
  private:
+  // The maximum size of each buffer allocated up front. Batches larger than
+  // this are serialized into a chain of buffers, rather than into one large
+  // allocation which would have to be copied whenever it's grown.
+  static constexpr size_t kMaxChunkSize = 1024 * 1024;
+
+  // Returns the last buffer of 'chain' if it has room for 'expected_size' more
+  // bytes, or else appends and returns a new buffer with at least
+  // 'min_capacity' bytes of room.
+  static faststring* ChunkWithRoom(vector<faststring>* chain,
+                                   size_t expected_size,
+                                   size_t min_capacity) {
+    if (chain->empty() ||
+        chain->back().capacity() - chain->back().size() < expected_size) {
+      chain->emplace_back();
+      chain->back().reserve(std::max(min_capacity, expected_size));
+    }
+    return &chain->back();
+  }
+
+  const size_t chunk_size_;
   RowwiseRowBlockPB rowblock_pb_;
-  faststring rows_data_;
-  faststring indirect_data_;
+  vector<faststring> rows_data_;
+  vector<faststring> indirect_data_;
+  size_t rows_data_size_;
+  size_t indirect_data_size_;
+  size_t last_rows_data_added_;
+  size_t last_indirect_data_added_;
   bool pad_unixtime_micros_to_16_bytes_;
   bool done_ = false;
 };
@@ -806,15 +1121,21 @@ class RowwiseResultSerializer : public ResultSerializer {
 class ColumnarResultSerializer : public ResultSerializer {
  public:
   static Status Create(uint64_t flags,
+                       CompressionType compression,
                        int batch_size_bytes,
                        const Schema& scanner_schema,
                        const Schema& client_schema,
                        unique_ptr<ResultSerializer>* serializer) {
-    if (flags & ~RowFormatFlags::COLUMNAR_LAYOUT) {
+    if (flags & ~(RowFormatFlags::COLUMNAR_LAYOUT | RowFormatFlags::ARROW_LAYOUT)) {
       return Status::InvalidArgument("Row format flags not supported with columnar layout");
     }
+    const CompressionCodec* codec;
+    RETURN_NOT_OK_PREPEND(GetCompressionCodec(compression, &codec),
+                          Substitute("unsupported columnar compression $0",
+                                     CompressionType_Name(compression)));
     serializer->reset(new ColumnarResultSerializer(
-        scanner_schema, client_schema, batch_size_bytes));
+        scanner_schema, client_schema, batch_size_bytes, codec,
+        flags & RowFormatFlags::ARROW_LAYOUT));
     return Status::OK();
   }
 
@@ -832,9 +1153,7 @@ class ColumnarResultSerializer : public ResultSerializer {
     int total = 0;
     for (const auto& col : results_.columns()) {
       total += col.data.size();
-      if (col.varlen_data) {
-        total += col.varlen_data->size();
-      }
+      total += col.varlen_data_size();
       if (col.non_null_bitmap) {
         total += col.non_null_bitmap->size();
       }
@@ -842,28 +1161,41 @@ class ColumnarResultSerializer : public ResultSerializer {
     return total;
   }
 
-  void SetupResponse(rpc::RpcContext* context, ScanResponsePB* resp) override {
+  void SetupResponse(rpc::RpcContext* context,
+                     ScanResponsePB* resp,
+                     vector<faststring>* sidecar_copies) override {
     CHECK(!done_);
     done_ = true;
     ColumnarRowBlockPB* data = resp->mutable_columnar_data();
+    if (codec_) {
+      data->set_compression(codec_->type());
+    }
     auto cols = std::move(results_).TakeColumns();
     for (auto& col : cols) {
       auto* col_pb = data->add_columns();
-      int sidecar_idx;
-      CHECK_OK(context->AddOutboundSidecar(
-          RpcSidecar::FromFaststring((std::move(col.data))), &sidecar_idx));
-      col_pb->set_data_sidecar(sidecar_idx);
+      int64_t uncompressed_size;
+      col_pb->set_data_sidecar(
+          AddSidecar(context, std::move(col.data), sidecar_copies, &uncompressed_size));
+      if (uncompressed_size >= 0) {
+        col_pb->set_data_uncompressed_size(uncompressed_size);
+      }
 
       if (col.varlen_data) {
-        CHECK_OK(context->AddOutboundSidecar(
-            RpcSidecar::FromFaststring((std::move(*col.varlen_data))), &sidecar_idx));
-        col_pb->set_varlen_data_sidecar(sidecar_idx);
+        col_pb->set_varlen_data_sidecar(
+            AddSidecar(context, std::move(*col.varlen_data), sidecar_copies,
+                       &uncompressed_size));
+        if (uncompressed_size >= 0) {
+          col_pb->set_varlen_data_uncompressed_size(uncompressed_size);
+        }
       }
 
       if (col.non_null_bitmap) {
-        CHECK_OK(context->AddOutboundSidecar(
-            RpcSidecar::FromFaststring((std::move(*col.non_null_bitmap))), &sidecar_idx));
-        col_pb->set_non_null_bitmap_sidecar(sidecar_idx);
+        col_pb->set_non_null_bitmap_sidecar(
+            AddSidecar(context, std::move(*col.non_null_bitmap), sidecar_copies,
+                       &uncompressed_size));
+        if (uncompressed_size >= 0) {
+          col_pb->set_non_null_bitmap_uncompressed_size(uncompressed_size);
+        }
       }
     }
     data->set_num_rows(num_rows_);
@@ -872,12 +1204,66 @@ class ColumnarResultSerializer : public ResultSerializer {
  private:
   ColumnarResultSerializer(const Schema& scanner_schema,
                            const Schema& client_schema,
-                           int batch_size_bytes)
-      : results_(scanner_schema, client_schema, batch_size_bytes) {
+                           int batch_size_bytes,
+                           const CompressionCodec* codec,
+                           bool arrow_layout)
+      : results_(scanner_schema, client_schema, batch_size_bytes, arrow_layout),
+        codec_(codec) {
+  }
+
+  int AddSidecar(rpc::RpcContext* context,
+                 faststring data,
+                 vector<faststring>* sidecar_copies,
+                 int64_t* uncompressed_size) const {
+    vector<faststring> chain;
+    chain.emplace_back(std::move(data));
+    return AddSidecar(context, std::move(chain), sidecar_copies, uncompressed_size);
+  }
+
+  // Adds the buffers in 'chain' to the response as a single sidecar and
+  // returns its index. If there's a codec and compressing the buffers makes
+  // them smaller, the sidecar holds the compressed data and 'uncompressed_size'
+  // is set to the total size of 'chain'. Otherwise it's set to -1. A copy of
+  // the sidecar is appended to 'sidecar_copies', if it isn't null.
+  int AddSidecar(rpc::RpcContext* context,
+                 vector<faststring> chain,
+                 vector<faststring>* sidecar_copies,
+                 int64_t* uncompressed_size) const {
+    *uncompressed_size = -1;
+    size_t total_size = 0;
+    vector<Slice> slices;
+    slices.reserve(chain.size());
+    for (const auto& buf : chain) {
+      total_size += buf.size();
+      slices.emplace_back(buf);
+    }
+    if (codec_ && total_size > 0) {
+      faststring compressed;
+      compressed.resize(codec_->MaxCompressedLength(total_size));
+      size_t compressed_size;
+      Status s = codec_->Compress(slices, compressed.data(), &compressed_size);
+      if (PREDICT_TRUE(s.ok()) && compressed_size < total_size) {
+        compressed.resize(compressed_size);
+        chain.clear();
+        chain.emplace_back(std::move(compressed));
+        *uncompressed_size = total_size;
+      } else if (PREDICT_FALSE(!s.ok())) {
+        KLOG_EVERY_N_SECS(WARNING, 60) << "Unable to compress columnar scan results: "
+                                       << s.ToString() << THROTTLE_MSG;
+      }
+    }
+    MaybeCopySidecar(chain, sidecar_copies);
+    int sidecar_idx;
+    CHECK_OK(context->AddOutboundSidecar(
+        RpcSidecar::FromFaststrings(std::move(chain)), &sidecar_idx));
+    return sidecar_idx;
   }
 
   int64_t num_rows_ = 0;
   ColumnarSerializedBatch results_;
+
+  // The codec to compress the sidecars with, or nullptr if they're sent as is.
+  const CompressionCodec* const codec_;
   bool done_ = false;
 };
 
@@ -899,6 +1285,7 @@ class ScanResultCopier : public ScanResultCollector {
   }
 
   void HandleRowBlock(Scanner* scanner, const RowBlock& row_block) override {
+    SCOPED_SCAN_STAGE_TIMER(ScanStage::kSerialize);
     int num_selected = serializer_->SerializeRowBlock(
         row_block, scanner->client_projection_schema());
 
@@ -919,6 +1306,7 @@ class ScanResultCopier : public ScanResultCollector {
   }
 
   Status InitSerializer(uint64_t row_format_flags,
+                        CompressionType columnar_compression,
                         const Schema& scanner_schema,
                         const Schema& client_schema) override {
     if (serializer_) {
@@ -928,15 +1316,33 @@ class ScanResultCopier : public ScanResultCollector {
     }
     if (row_format_flags & COLUMNAR_LAYOUT) {
       return ColumnarResultSerializer::Create(
-          row_format_flags, batch_size_bytes_, scanner_schema, client_schema, &serializer_);
+          row_format_flags, columnar_compression, batch_size_bytes_,
+          scanner_schema, client_schema, &serializer_);
+    }
+    if (columnar_compression != NO_COMPRESSION) {
+      return Status::InvalidArgument("compression is only supported with columnar layout");
+    }
+    if (row_format_flags & ARROW_LAYOUT) {
+      return Status::InvalidArgument("Arrow layout is only supported with columnar layout");
     }
     serializer_.reset(new RowwiseResultSerializer(batch_size_bytes_, row_format_flags));
     return Status::OK();
   }
 
-  void SetupResponse(rpc::RpcContext* context, ScanResponsePB* resp) {
+  bool TakePrefetchedResults(ScanResultCopier* prefetched) override {
+    serializer_ = std::move(prefetched->serializer_);
+    num_rows_returned_ = prefetched->num_rows_returned_;
+    last_primary_key_ = std::move(prefetched->last_primary_key_);
+    return true;
+  }
+
+  // See ResultSerializer::SetupResponse() for 'sidecar_copies'.
+  void SetupResponse(rpc::RpcContext* context,
+                     ScanResponsePB* resp,
+                     vector<faststring>* sidecar_copies = nullptr) {
     if (serializer_) {
-      serializer_->SetupResponse(context, resp);
+      SCOPED_SCAN_STAGE_TIMER(ScanStage::kSerialize);
+      serializer_->SetupResponse(context, resp, sidecar_copies);
     }
 
     // Set the last row found by the collector.
@@ -957,6 +1363,61 @@ class ScanResultCopier : public ScanResultCollector {
   DISALLOW_COPY_AND_ASSIGN(ScanResultCopier);
 };
 
+// A batch of rows read ahead of a client's next continuation request, or the
+// error hit while reading it.
+class PrefetchedScanResults : public PrefetchedScanBatch {
+ public:
+  // 'mem_bytes' must already have been consumed from 'mem_tracker', and is
+  // released when the batch is destroyed.
+  PrefetchedScanResults(int batch_size_bytes,
+                        shared_ptr<MemTracker> mem_tracker,
+                        int64_t mem_bytes)
+      : copier_(batch_size_bytes),
+        batch_size_bytes_(batch_size_bytes),
+        mem_tracker_(std::move(mem_tracker)),
+        mem_bytes_(mem_bytes),
+        error_code_(TabletServerErrorPB::UNKNOWN_ERROR) {
+  }
+
+  ~PrefetchedScanResults() override {
+    mem_tracker_->Release(mem_bytes_);
+  }
+
+  ScanResultCopier* copier() {
+    return &copier_;
+  }
+
+  // The batch size the batch was read with.
+  int batch_size_bytes() const {
+    return batch_size_bytes_;
+  }
+
+  // Records the error hit while reading the batch, which is returned to the
+  // client instead of the batch.
+  void set_error(const Status& status, TabletServerErrorPB::Code error_code) {
+    status_ = status;
+    error_code_ = error_code;
+  }
+
+  const Status& status() const {
+    return status_;
+  }
+
+  TabletServerErrorPB::Code error_code() const {
+    return error_code_;
+  }
+
+ private:
+  ScanResultCopier copier_;
+  const int batch_size_bytes_;
+  const shared_ptr<MemTracker> mem_tracker_;
+  const int64_t mem_bytes_;
+  Status status_;
+  TabletServerErrorPB::Code error_code_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchedScanResults);
+};
+
 // Checksums the scan result.
 class ScanResultChecksummer : public ScanResultCollector {
  public:
@@ -974,13 +1435,18 @@ class ScanResultChecksummer : public ScanResultCollector {
       client_projection_schema = row_block.schema();
     }
 
+    selected_rows_.clear();
     size_t nrows = row_block.nrows();
     for (size_t i = 0; i < nrows; i++) {
-      if (!row_block.selection_vector()->IsRowSelected(i)) continue;
-      uint32_t row_crc = CalcRowCrc32(*client_projection_schema, row_block.row(i));
-      agg_checksum_ += row_crc;
-      rows_checksummed_++;
+      if (row_block.selection_vector()->IsRowSelected(i)) {
+        selected_rows_.push_back(i);
+      }
+    }
+    CalcRowCrc32s(*client_projection_schema, row_block);
+    for (uint64_t row_crc : row_crcs_) {
+      agg_checksum_ += static_cast<uint32_t>(row_crc); // CRC32 only uses the lower 32 bits.
     }
+    rows_checksummed_ += selected_rows_.size();
     // Find the last selected row and save its encoded key.
     SetLastRow(row_block, &encoded_last_row_);
   }
@@ -1001,34 +1467,58 @@ class ScanResultChecksummer : public ScanResultCollector {
   uint64_t agg_checksum() const { return agg_checksum_; }
 
  private:
-  // Calculates a CRC32C for the given row.
-  uint32_t CalcRowCrc32(const Schema& projection, const RowBlockRow& row) {
-    tmp_buf_.clear();
+  // Calculates the CRC32C of each selected row of 'row_block' into
+  // 'row_crcs_'. The CRC of a row covers, for each column, the column's index,
+  // whether the cell is null if the column is nullable, and the cell's data.
+  //
+  // The CRCs are computed a column at a time, extending the CRC of each row
+  // with its cell of the column: a CRC32C can be resumed from the CRC of the
+  // preceding data, so this gives the same CRCs as encoding each row whole,
+  // while reading the buffer of each column sequentially and without copying
+  // the cells of the rows together.
+  void CalcRowCrc32s(const Schema& projection, const RowBlock& row_block) {
+    row_crcs_.assign(selected_rows_.size(), 0);
+    // The column index, the null flag, and the data of a fixed-length cell.
+    uint8_t buf[sizeof(uint32_t) + 1 + 16];
 
     for (size_t j = 0; j < projection.num_columns(); j++) {
       uint32_t col_index = static_cast<uint32_t>(j);  // For the CRC.
-      tmp_buf_.append(&col_index, sizeof(col_index));
-      ColumnBlockCell cell = row.cell(j);
-      if (cell.is_nullable()) {
-        uint8_t is_defined = cell.is_null() ? 0 : 1;
-        tmp_buf_.append(&is_defined, sizeof(is_defined));
-        if (!is_defined) continue;
-      }
-      if (cell.typeinfo()->physical_type() == BINARY) {
-        const Slice* data = reinterpret_cast<const Slice *>(cell.ptr());
-        tmp_buf_.append(data->data(), data->size());
-      } else {
-        tmp_buf_.append(cell.ptr(), cell.size());
+      memcpy(buf, &col_index, sizeof(col_index));
+      ColumnBlock column = row_block.column_block(j);
+      const bool is_nullable = column.is_nullable();
+      const bool is_binary = column.type_info()->physical_type() == BINARY;
+      const size_t cell_size = column.type_info()->size();
+      DCHECK(is_binary || cell_size <= 16);
+
+      for (size_t k = 0; k < selected_rows_.size(); k++) {
+        size_t row_idx = selected_rows_[k];
+        uint64_t* row_crc = &row_crcs_[k];
+        size_t len = sizeof(col_index);
+        if (is_nullable) {
+          uint8_t is_defined = column.is_null(row_idx) ? 0 : 1;
+          buf[len++] = is_defined;
+          if (!is_defined) {
+            crc_->Compute(buf, len, row_crc, nullptr);
+            continue;
+          }
+        }
+        const uint8_t* cell = column.cell_ptr(row_idx);
+        if (is_binary) {
+          crc_->Compute(buf, len, row_crc, nullptr);
+          const Slice* data = reinterpret_cast<const Slice*>(cell);
+          crc_->Compute(data->data(), data->size(), row_crc, nullptr);
+        } else {
+          memcpy(buf + len, cell, cell_size);
+          crc_->Compute(buf, len + cell_size, row_crc, nullptr);
+        }
       }
     }
-
-    uint64_t row_crc = 0;
-    crc_->Compute(tmp_buf_.data(), tmp_buf_.size(), &row_crc, nullptr);
-    return static_cast<uint32_t>(row_crc); // CRC32 only uses the lower 32 bits.
   }
 
-
-  faststring tmp_buf_;
+  // The indexes of the selected rows of the block being checksummed, and
+  // their CRCs.
+  vector<size_t> selected_rows_;
+  vector<uint64_t> row_crcs_;
   crc::Crc* const crc_;
   uint64_t agg_checksum_;
   int64_t rows_checksummed_;
@@ -1037,6 +1527,280 @@ class ScanResultChecksummer : public ScanResultCollector {
   DISALLOW_COPY_AND_ASSIGN(ScanResultChecksummer);
 };
 
+// Computes the aggregates of an AggregationPB over the scan result.
+//
+// The aggregates are partial: they cover only the rows scanned while serving
+// the current request, and it's up to the client to merge them. Since the
+// group-by columns are a prefix of the primary key, consecutive rows of a
+// rowset usually belong to the same group, so the last group is cached to
+// avoid a map lookup per row.
+class ScanResultAggregator : public ScanResultCollector {
+ public:
+  explicit ScanResultAggregator(const AggregationPB& aggregation)
+      : aggregation_(aggregation),
+        last_group_(nullptr),
+        response_size_(0) {
+  }
+
+  void HandleRowBlock(Scanner* /* scanner */, const RowBlock& row_block) override {
+    const Schema* schema = row_block.schema();
+    const int num_group_by = aggregation_.num_group_by_columns();
+    size_t nrows = row_block.nrows();
+    for (size_t i = 0; i < nrows; i++) {
+      if (!row_block.selection_vector()->IsRowSelected(i)) continue;
+      RowBlockRow row = row_block.row(i);
+
+      group_key_.clear();
+      for (int j = 0; j < num_group_by; j++) {
+        GetKeyEncoder<faststring>(schema->column(j).type_info()).Encode(
+            row.cell_ptr(j), j == num_group_by - 1, &group_key_);
+      }
+      if (!last_group_ || Slice(last_group_->first) != Slice(group_key_)) {
+        auto it = groups_.find(group_key_.ToString());
+        if (it == groups_.end()) {
+          it = groups_.emplace(group_key_.ToString(),
+                               vector<AggregateState>(aggregation_.aggregates_size())).first;
+          response_size_ += group_key_.size() +
+              aggregation_.aggregates_size() * sizeof(int64_t);
+        }
+        last_group_ = &*it;
+      }
+
+      vector<AggregateState>* states = &last_group_->second;
+      for (int j = 0; j < aggregation_.aggregates_size(); j++) {
+        Accumulate(aggregation_.aggregates(j), row, &(*states)[j]);
+      }
+    }
+  }
+
+  void HandleRollup(const Schema& projection,
+                    const vector<ColumnId>& col_ids,
+                    const tablet::RowSetRollupPB& rollup) override {
+    // The indexes in the rollup's columns of the columns of the aggregates
+    // which have one.
+    vector<int> rollup_col_idxs;
+    for (const ColumnId& col_id : col_ids) {
+      auto it = std::find(rollup.column_ids().begin(), rollup.column_ids().end(),
+                          static_cast<int32_t>(col_id));
+      DCHECK(it != rollup.column_ids().end());
+      rollup_col_idxs.push_back(it - rollup.column_ids().begin());
+    }
+
+    for (const auto& group : rollup.groups()) {
+      auto it = groups_.find(group.encoded_group_key());
+      if (it == groups_.end()) {
+        it = groups_.emplace(group.encoded_group_key(),
+                             vector<AggregateState>(aggregation_.aggregates_size())).first;
+        response_size_ += group.encoded_group_key().size() +
+            aggregation_.aggregates_size() * sizeof(int64_t);
+      }
+      vector<AggregateState>* states = &it->second;
+      int col_idx = 0;
+      for (int j = 0; j < aggregation_.aggregates_size(); j++) {
+        const AggregatePB& aggregate = aggregation_.aggregates(j);
+        if (!aggregate.has_projection_idx()) {
+          DCHECK_EQ(AggregatePB::COUNT, aggregate.type());
+          (*states)[j].int_value += group.row_count();
+          continue;
+        }
+        Merge(aggregate, projection.column(aggregate.projection_idx()).type_info(),
+              group.columns(rollup_col_idxs[col_idx++]), &(*states)[j]);
+      }
+    }
+  }
+
+  int64_t ResponseSize() const override {
+    return response_size_;
+  }
+
+  // Every group is returned to the client as a single row.
+  int64_t NumRowsReturned() const override {
+    return groups_.size();
+  }
+
+  void SetupResponse(ScanResponsePB* resp) const {
+    for (const auto& group : groups_) {
+      AggregateGroupPB* group_pb = resp->add_aggregate_groups();
+      group_pb->set_encoded_group_key(group.first);
+      for (int j = 0; j < aggregation_.aggregates_size(); j++) {
+        const AggregateState& state = group.second[j];
+        AggregateValuePB* value_pb = group_pb->add_values();
+        switch (aggregation_.aggregates(j).type()) {
+          case AggregatePB::COUNT:
+            value_pb->set_int_value(state.int_value);
+            break;
+          case AggregatePB::SUM:
+            if (!state.has_value) break;
+            if (state.is_floating_point) {
+              value_pb->set_double_value(state.double_value);
+            } else {
+              value_pb->set_int_value(state.int_value);
+            }
+            break;
+          case AggregatePB::MIN:
+          case AggregatePB::MAX:
+            if (state.has_value) {
+              value_pb->set_cell_value(state.cell_value);
+            }
+            break;
+          default:
+            LOG(DFATAL) << "unexpected aggregate type";
+        }
+      }
+    }
+  }
+
+ private:
+  struct AggregateState {
+    int64_t int_value = 0;
+    double double_value = 0;
+    // The current MIN or MAX: the cell's data for fixed-length types, or the
+    // value's bytes for variable-length types.
+    string cell_value;
+    bool has_value = false;
+    bool is_floating_point = false;
+  };
+
+  static void Accumulate(const AggregatePB& aggregate,
+                         const RowBlockRow& row,
+                         AggregateState* state) {
+    if (aggregate.type() == AggregatePB::COUNT && !aggregate.has_projection_idx()) {
+      state->int_value++;
+      return;
+    }
+    ColumnBlockCell cell = row.cell(aggregate.projection_idx());
+    if (cell.is_nullable() && cell.is_null()) return;
+
+    const TypeInfo* type_info = cell.typeinfo();
+    switch (aggregate.type()) {
+      case AggregatePB::COUNT:
+        state->int_value++;
+        break;
+      case AggregatePB::SUM:
+        state->has_value = true;
+        switch (type_info->type()) {
+          case INT8:
+            state->int_value += *reinterpret_cast<const int8_t*>(cell.ptr());
+            break;
+          case INT16:
+            state->int_value += *reinterpret_cast<const int16_t*>(cell.ptr());
+            break;
+          case INT32:
+            state->int_value += *reinterpret_cast<const int32_t*>(cell.ptr());
+            break;
+          case INT64:
+            // Wrap around on overflow rather than invoking undefined behavior.
+            state->int_value = static_cast<int64_t>(
+                static_cast<uint64_t>(state->int_value) +
+                static_cast<uint64_t>(*reinterpret_cast<const int64_t*>(cell.ptr())));
+            break;
+          case FLOAT:
+            state->is_floating_point = true;
+            state->double_value += *reinterpret_cast<const float*>(cell.ptr());
+            break;
+          case DOUBLE:
+            state->is_floating_point = true;
+            state->double_value += *reinterpret_cast<const double*>(cell.ptr());
+            break;
+          default:
+            LOG(DFATAL) << "unexpected type for SUM: " << type_info->name();
+        }
+        break;
+      case AggregatePB::MIN:
+      case AggregatePB::MAX: {
+        int sign = aggregate.type() == AggregatePB::MIN ? 1 : -1;
+        if (type_info->physical_type() == BINARY) {
+          const Slice* value = reinterpret_cast<const Slice*>(cell.ptr());
+          if (!state->has_value || sign * Slice(state->cell_value).compare(*value) > 0) {
+            state->cell_value.assign(reinterpret_cast<const char*>(value->data()),
+                                     value->size());
+          }
+        } else {
+          // Copy the current value into an aligned buffer before comparing,
+          // since the string's buffer may not be suitably aligned for INT128.
+          alignas(16) uint8_t current[16];
+          DCHECK_LE(type_info->size(), sizeof(current));
+          memcpy(current, state->cell_value.data(), state->cell_value.size());
+          if (!state->has_value || sign * type_info->Compare(current, cell.ptr()) > 0) {
+            state->cell_value.assign(reinterpret_cast<const char*>(cell.ptr()),
+                                     type_info->size());
+          }
+        }
+        state->has_value = true;
+        break;
+      }
+      default:
+        LOG(DFATAL) << "unexpected aggregate type: " << aggregate.type();
+    }
+  }
+
+  // Merges the aggregates of a column in a group of a rowset's rollup into
+  // 'state'.
+  static void Merge(const AggregatePB& aggregate,
+                    const TypeInfo* type_info,
+                    const tablet::RowSetRollupPB::ColumnPB& column,
+                    AggregateState* state) {
+    if (column.non_null_count() == 0) return;
+
+    switch (aggregate.type()) {
+      case AggregatePB::COUNT:
+        state->int_value += column.non_null_count();
+        break;
+      case AggregatePB::SUM:
+        state->has_value = true;
+        if (type_info->type() == FLOAT || type_info->type() == DOUBLE) {
+          state->is_floating_point = true;
+          state->double_value += column.double_sum();
+        } else {
+          state->int_value = static_cast<int64_t>(
+              static_cast<uint64_t>(state->int_value) +
+              static_cast<uint64_t>(column.int_sum()));
+        }
+        break;
+      case AggregatePB::MIN:
+      case AggregatePB::MAX: {
+        int sign = aggregate.type() == AggregatePB::MIN ? 1 : -1;
+        const string& value = aggregate.type() == AggregatePB::MIN ?
+            column.min_value() : column.max_value();
+        if (type_info->physical_type() == BINARY) {
+          if (!state->has_value || sign * Slice(state->cell_value).compare(Slice(value)) > 0) {
+            state->cell_value = value;
+          }
+        } else {
+          alignas(16) uint8_t current[16];
+          alignas(16) uint8_t candidate[16];
+          DCHECK_LE(type_info->size(), sizeof(current));
+          DCHECK_EQ(type_info->size(), value.size());
+          memcpy(current, state->cell_value.data(), state->cell_value.size());
+          memcpy(candidate, value.data(), value.size());
+          if (!state->has_value || sign * type_info->Compare(current, candidate) > 0) {
+            state->cell_value = value;
+          }
+        }
+        state->has_value = true;
+        break;
+      }
+      default:
+        LOG(DFATAL) << "unexpected aggregate type: " << aggregate.type();
+    }
+  }
+
+  const AggregationPB aggregation_;
+
+  // Partial aggregates keyed by encoded group key, ordered by key.
+  std::map<string, vector<AggregateState>> groups_;
+
+  // The group of the most recently aggregated row, if any.
+  std::pair<const string, vector<AggregateState>>* last_group_;
+
+  // Scratch buffer for encoding the group key of each row.
+  faststring group_key_;
+
+  int64_t response_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultAggregator);
+};
+
 // Return the batch size to use for a given request, after clamping
 // the user-requested request within the server-side allowable range.
 // This is only a hint, really more of a threshold since returned bytes
@@ -1050,6 +1814,30 @@ static size_t GetMaxBatchSizeBytesHint(const ScanRequestPB* req) {
                   implicit_cast<uint32_t>(FLAGS_scanner_max_batch_size_bytes));
 }
 
+// Returns the size of the next batch of an adaptively sized scan, given the
+// size of the previous batch, how long the tablet server took to read it, and
+// how long the client took to ask for the next batch after receiving it.
+//
+// Like a TCP window, the size doubles while the client keeps up and halves
+// once it falls far behind. A client which asks for more before the server
+// could have read another batch spends its time waiting on round trips, which
+// larger batches amortize. A client which takes much longer than the server
+// is the bottleneck, and smaller batches limit the memory spent on results
+// which would only wait for it.
+static size_t AdaptBatchSizeBytes(size_t last_batch_size_bytes,
+                                  const MonoDelta& read_time,
+                                  const MonoDelta& client_gap) {
+  static constexpr int kShrinkRatio = 4;
+  size_t batch_size_bytes = last_batch_size_bytes;
+  if (client_gap <= read_time) {
+    batch_size_bytes *= 2;
+  } else if (client_gap.ToNanoseconds() > read_time.ToNanoseconds() * kShrinkRatio) {
+    batch_size_bytes /= 2;
+  }
+  batch_size_bytes = std::min<size_t>(batch_size_bytes, FLAGS_scanner_max_batch_size_bytes);
+  return std::max<size_t>(batch_size_bytes, FLAGS_scanner_min_adaptive_batch_size_bytes);
+}
+
 TabletServiceImpl::TabletServiceImpl(TabletServer* server)
   : TabletServerServiceIf(server->metric_entity(), server->result_tracker()),
     server_(server) {
@@ -1208,56 +1996,78 @@ void TabletServiceAdminImpl::CreateTablet(const CreateTabletRequestPB* req,
   TRACE_EVENT1("tserver", "CreateTablet",
                "tablet_id", req->tablet_id());
 
+  TabletServerErrorPB::Code code;
+  Status s = DoCreateTablet(*req, &code);
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s, code, context);
+    return;
+  }
+  context->RespondSuccess();
+}
+
+void TabletServiceAdminImpl::CreateTablets(const CreateTabletsRequestPB* req,
+                                           CreateTabletsResponsePB* resp,
+                                           rpc::RpcContext* context) {
+  if (!CheckUuidMatchOrRespond(server_->tablet_manager(), "CreateTablets", req, resp, context)) {
+    return;
+  }
+  TRACE_EVENT1("tserver", "CreateTablets",
+               "num_tablets", req->tablets_size());
+
+  for (const auto& tablet_req : req->tablets()) {
+    CreateTabletResponsePB* tablet_resp = resp->add_tablet_responses();
+    TabletServerErrorPB::Code code;
+    Status s = DoCreateTablet(tablet_req, &code);
+    if (PREDICT_FALSE(!s.ok())) {
+      StatusToPB(s, tablet_resp->mutable_error()->mutable_status());
+      tablet_resp->mutable_error()->set_code(code);
+    }
+  }
+  context->RespondSuccess();
+}
+
+Status TabletServiceAdminImpl::DoCreateTablet(const CreateTabletRequestPB& req,
+                                              TabletServerErrorPB::Code* error_code) {
   Schema schema;
-  Status s = SchemaFromPB(req->schema(), &schema);
+  Status s = SchemaFromPB(req.schema(), &schema);
   DCHECK(schema.has_column_ids());
   if (!s.ok()) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::InvalidArgument("Invalid Schema."),
-                         TabletServerErrorPB::INVALID_SCHEMA, context);
-    return;
+    *error_code = TabletServerErrorPB::INVALID_SCHEMA;
+    return Status::InvalidArgument("Invalid Schema.");
   }
 
   PartitionSchema partition_schema;
-  s = PartitionSchema::FromPB(req->partition_schema(), schema, &partition_schema);
+  s = PartitionSchema::FromPB(req.partition_schema(), schema, &partition_schema);
   if (!s.ok()) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::InvalidArgument("Invalid PartitionSchema."),
-                         TabletServerErrorPB::INVALID_SCHEMA, context);
-    return;
+    *error_code = TabletServerErrorPB::INVALID_SCHEMA;
+    return Status::InvalidArgument("Invalid PartitionSchema.");
   }
 
   Partition partition;
-  Partition::FromPB(req->partition(), &partition);
+  Partition::FromPB(req.partition(), &partition);
 
-  LOG(INFO) << "Processing CreateTablet for tablet " << req->tablet_id()
-            << " (table=" << req->table_name()
-            << " [id=" << req->table_id() << "]), partition="
+  LOG(INFO) << "Processing CreateTablet for tablet " << req.tablet_id()
+            << " (table=" << req.table_name()
+            << " [id=" << req.table_id() << "]), partition="
             << partition_schema.PartitionDebugString(partition, schema);
-  VLOG(1) << "Full request: " << SecureDebugString(*req);
+  VLOG(1) << "Full request: " << SecureDebugString(req);
 
   s = server_->tablet_manager()->CreateNewTablet(
-      req->table_id(),
-      req->tablet_id(),
+      req.table_id(),
+      req.tablet_id(),
       partition,
-      req->table_name(),
+      req.table_name(),
       schema,
       partition_schema,
-      req->config(),
-      req->has_extra_config() ? boost::make_optional(req->extra_config()) : boost::none,
-      req->has_dimension_label() ? boost::make_optional(req->dimension_label()) : boost::none,
+      req.config(),
+      req.has_extra_config() ? boost::make_optional(req.extra_config()) : boost::none,
+      req.has_dimension_label() ? boost::make_optional(req.dimension_label()) : boost::none,
       nullptr);
   if (PREDICT_FALSE(!s.ok())) {
-    TabletServerErrorPB::Code code;
-    if (s.IsAlreadyPresent()) {
-      code = TabletServerErrorPB::TABLET_ALREADY_EXISTS;
-    } else {
-      code = TabletServerErrorPB::UNKNOWN_ERROR;
-    }
-    SetupErrorAndRespond(resp->mutable_error(), s, code, context);
-    return;
+    *error_code = s.IsAlreadyPresent() ? TabletServerErrorPB::TABLET_ALREADY_EXISTS
+                                       : TabletServerErrorPB::UNKNOWN_ERROR;
   }
-  context->RespondSuccess();
+  return s;
 }
 
 void TabletServiceAdminImpl::DeleteTablet(const DeleteTabletRequestPB* req,
@@ -1311,61 +2121,119 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
   }
   boost::optional<WriteAuthorizationContext> authz_context;
   if (FLAGS_tserver_enforce_access_control) {
-    TokenPB token;
-    if (!VerifyAuthzTokenOrRespond(server_->token_verifier(), *req, context, &token)) {
+    ErrorStatusPB::RpcErrorCodePB error;
+    Status s = VerifyWriteAuthz(server_->token_verifier(), *req,
+                                replica->tablet_metadata()->table_id(),
+                                context->remote_user().username(),
+                                &authz_context, &error);
+    if (PREDICT_FALSE(!s.ok())) {
+      LOG(WARNING) << Substitute("rejecting Write request from $0: $1",
+                                 context->requestor_string(), s.ToString());
+      context->RespondRpcFailure(error, s);
       return;
     }
-    const auto& privilege = token.authz().table_privilege();
-    if (!CheckMatchingTableIdOrRespond(privilege, replica->tablet_metadata()->table_id(),
-                                       "Write", context)) {
-      return;
-    }
-    WritePrivileges privileges;
-    if (privilege.insert_privilege()) {
-      InsertOrDie(&privileges, WritePrivilegeType::INSERT);
-    }
-    if (privilege.update_privilege()) {
-      InsertOrDie(&privileges, WritePrivilegeType::UPDATE);
-    }
-    if (privilege.delete_privilege()) {
-      InsertOrDie(&privileges, WritePrivilegeType::DELETE);
-    }
-    if (privileges.empty()) {
-      // If we know there are no write-related privileges outright, we can
-      // short-circuit further checking and reject the request immediately.
-      // Otherwise, we'll defer the checking to the prepare phase of the
-      // transaction after decoding the operations.
-      LOG(WARNING) << Substitute("rejecting Write request from $0: no write privileges",
-                                 context->requestor_string());
-      context->RespondRpcFailure(rpc::ErrorStatusPB::FATAL_UNAUTHORIZED,
-          Status::NotAuthorized("not authorized to write"));
-      return;
-    }
-    authz_context = { privileges, /*requested_op_types=*/{} };
   }
 
-  shared_ptr<Tablet> tablet;
   TabletServerErrorPB::Code error_code;
-  Status s = GetTabletRef(replica, &tablet, &error_code);
+  Status s = SubmitWrite(replica, req, resp,
+                         context->AreResultsTracked() ? context->request_id() : nullptr,
+                         std::move(authz_context),
+                         unique_ptr<TransactionCompletionCallback>(
+                             new RpcTransactionCompletionCallback<WriteResponsePB>(context,
+                                                                                   resp)),
+                         &error_code);
   if (PREDICT_FALSE(!s.ok())) {
     SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
+  }
+}
+
+void TabletServiceImpl::MultiWrite(const MultiWriteRequestPB* req,
+                                   MultiWriteResponsePB* resp,
+                                   rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::MultiWrite",
+               "num_writes", req->requests_size());
+  const int num_writes = req->requests_size();
+  if (num_writes == 0) {
+    context->RespondSuccess();
     return;
   }
+  // Add all of the responses up front: once the writes are submitted, they
+  // fill in their responses concurrently.
+  for (int i = 0; i < num_writes; i++) {
+    resp->add_responses();
+  }
+  shared_ptr<MultiWriteTracker> tracker(new MultiWriteTracker(context, num_writes));
+  for (int i = 0; i < num_writes; i++) {
+    const WriteRequestPB* write_req = &req->requests(i);
+    WriteResponsePB* write_resp = resp->mutable_responses(i);
+    DVLOG(3) << "Received Write as part of MultiWrite RPC: " << SecureDebugString(*write_req);
+    TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+    scoped_refptr<TabletReplica> replica;
+    Status s = LookupRunningTabletReplica(server_->tablet_manager(), write_req->tablet_id(),
+                                          &replica, &error_code);
+    boost::optional<WriteAuthorizationContext> authz_context;
+    if (s.ok() && FLAGS_tserver_enforce_access_control) {
+      ErrorStatusPB::RpcErrorCodePB unused_error;
+      s = VerifyWriteAuthz(server_->token_verifier(), *write_req,
+                           replica->tablet_metadata()->table_id(),
+                           context->remote_user().username(),
+                           &authz_context, &unused_error);
+      if (PREDICT_FALSE(!s.ok())) {
+        LOG(WARNING) << Substitute("rejecting Write to tablet $0 in MultiWrite request from $1: $2",
+                                   write_req->tablet_id(), context->requestor_string(),
+                                   s.ToString());
+        error_code = TabletServerErrorPB::NOT_AUTHORIZED;
+      }
+    }
+    if (s.ok()) {
+      s = SubmitWrite(replica, write_req, write_resp, /*request_id=*/nullptr,
+                      std::move(authz_context),
+                      unique_ptr<TransactionCompletionCallback>(
+                          new MultiWriteCompletionCallback(tracker, write_resp)),
+                      &error_code);
+    }
+    if (PREDICT_FALSE(!s.ok())) {
+      // The write was not submitted, so its completion callback won't run.
+      // Only this thread touches 'unsubmitted_writes', and the RPC can't be
+      // responded to before this write is marked completed below.
+      StatusToPB(s, write_resp->mutable_error()->mutable_status());
+      write_resp->mutable_error()->set_code(error_code);
+      resp->add_unsubmitted_writes(i);
+      tracker->WriteCompleted();
+    }
+  }
+}
+
+Status TabletServiceImpl::SubmitWrite(const scoped_refptr<TabletReplica>& replica,
+                                      const WriteRequestPB* req,
+                                      WriteResponsePB* resp,
+                                      const rpc::RequestIdPB* request_id,
+                                      boost::optional<WriteAuthorizationContext> authz_context,
+                                      unique_ptr<TransactionCompletionCallback> callback,
+                                      TabletServerErrorPB::Code* error_code) {
+  *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+  shared_ptr<Tablet> tablet;
+  RETURN_NOT_OK(GetTabletRef(replica, &tablet, error_code));
 
   uint64_t bytes = req->row_operations().rows().size() +
       req->row_operations().indirect_data().size();
   if (!tablet->ShouldThrottleAllow(bytes)) {
-    SetupErrorAndRespond(resp->mutable_error(),
-                         Status::ServiceUnavailable("Rejecting Write request: throttled"),
-                         TabletServerErrorPB::THROTTLED,
-                         context);
-    return;
+    *error_code = TabletServerErrorPB::THROTTLED;
+    return Status::ServiceUnavailable("Rejecting Write request: throttled");
   }
 
   // Check for memory pressure; don't bother doing any additional work if we've
   // exceeded the limit.
   double capacity_pct;
-  if (process_memory::SoftLimitExceeded(&capacity_pct)) {
+  const int32_t max_delay_ms = FLAGS_write_backpressure_max_delay_ms;
+  if (max_delay_ms > 0) {
+    uint32_t delay_ms = WriteBackpressureDelayMs(*tablet, max_delay_ms);
+    if (delay_ms > 0) {
+      resp->set_suggested_delay_ms(delay_ms);
+    }
+  }
+  if (max_delay_ms > 0 ? HardLimitExceeded(&capacity_pct)
+                       : process_memory::SoftLimitExceeded(&capacity_pct)) {
     tablet->metrics()->leader_memory_pressure_rejections->Increment();
     string msg = StringPrintf("Soft memory limit exceeded (at %.2f%% of capacity)", capacity_pct);
     if (capacity_pct >= FLAGS_memory_limit_warn_threshold_percentage) {
@@ -1373,25 +2241,18 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
     } else {
       KLOG_EVERY_N_SECS(INFO, 1) << "Rejecting Write request: " << msg << THROTTLE_MSG;
     }
-    SetupErrorAndRespond(resp->mutable_error(), Status::ServiceUnavailable(msg),
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
+    return Status::ServiceUnavailable(msg);
   }
 
   if (!server_->clock()->SupportsExternalConsistencyMode(req->external_consistency_mode())) {
-    Status s = Status::NotSupported("The configured clock does not support the"
+    return Status::NotSupported("The configured clock does not support the"
         " required consistency mode.");
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
   }
 
   unique_ptr<WriteTransactionState> tx_state(new WriteTransactionState(
       replica.get(),
       req,
-      context->AreResultsTracked() ? context->request_id() : nullptr,
+      request_id,
       resp,
       std::move(authz_context)));
 
@@ -1399,28 +2260,13 @@ void TabletServiceImpl::Write(const WriteRequestPB* req,
   // timestamps are greater than the passed timestamp.
   if (req->has_propagated_timestamp()) {
     Timestamp ts(req->propagated_timestamp());
-    s = server_->clock()->Update(ts);
-  }
-  if (PREDICT_FALSE(!s.ok())) {
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-    return;
+    RETURN_NOT_OK(server_->clock()->Update(ts));
   }
 
-  tx_state->set_completion_callback(unique_ptr<TransactionCompletionCallback>(
-      new RpcTransactionCompletionCallback<WriteResponsePB>(context,
-                                                            resp)));
+  tx_state->set_completion_callback(std::move(callback));
 
   // Submit the write. The RPC will be responded to asynchronously.
-  s = replica->SubmitWrite(std::move(tx_state));
-
-  // Check that we could submit the write
-  if (PREDICT_FALSE(!s.ok())) {
-    SetupErrorAndRespond(resp->mutable_error(), s,
-                         TabletServerErrorPB::UNKNOWN_ERROR,
-                         context);
-  }
+  return replica->SubmitWrite(std::move(tx_state));
 }
 
 ConsensusServiceImpl::ConsensusServiceImpl(ServerBase* server,
@@ -1455,6 +2301,22 @@ void ConsensusServiceImpl::UpdateConsensus(const ConsensusRequestPB* req,
   // Submit the update directly to the TabletReplica's RaftConsensus instance.
   shared_ptr<RaftConsensus> consensus;
   if (!GetConsensusOrRespond(replica, resp, context, &consensus)) return;
+  if (req->has_ops_sidecar_idx()) {
+    // RaftConsensus expects the ops in the request, and takes ownership of
+    // them from there.
+    Slice sidecar;
+    Status s = context->GetInboundSidecar(req->ops_sidecar_idx(), &sidecar);
+    if (s.ok()) {
+      s = consensus::ParseOpsFromSidecar(
+          sidecar, const_cast<ConsensusRequestPB*>(req)->mutable_ops());
+    }
+    if (PREDICT_FALSE(!s.ok())) {
+      SetupErrorAndRespond(resp->mutable_error(), s,
+                           TabletServerErrorPB::UNKNOWN_ERROR,
+                           context);
+      return;
+    }
+  }
   Status s = consensus->Update(req, resp);
   if (PREDICT_FALSE(!s.ok())) {
     // Clear the response first, since a partially-filled response could
@@ -1467,6 +2329,76 @@ void ConsensusServiceImpl::UpdateConsensus(const ConsensusRequestPB* req,
                          context);
     return;
   }
+  resp->set_ops_sidecar_supported(true);
+  context->RespondSuccess();
+}
+
+namespace {
+
+// Applies one of the requests of a BatchUpdateConsensus RPC. Unlike
+// UpdateConsensus(), failures are reported in 'resp' only, since the RPC
+// itself is responded to once all of its requests are applied.
+void UpdateConsensusInBatch(TabletReplicaLookupIf* tablet_manager,
+                            const ConsensusRequestPB& req,
+                            ConsensusResponsePB* resp) {
+  const auto set_error = [resp](const Status& s, TabletServerErrorPB::Code code) {
+    resp->Clear();
+    StatusToPB(s, resp->mutable_error()->mutable_status());
+    resp->mutable_error()->set_code(code);
+  };
+  const string& local_uuid = tablet_manager->NodeInstance().permanent_uuid();
+  if (PREDICT_FALSE(req.dest_uuid() != local_uuid)) {
+    set_error(Status::InvalidArgument(Substitute("BatchUpdateConsensus: Wrong destination "
+                                                 "UUID requested. Local UUID: $0. "
+                                                 "Requested UUID: $1",
+                                                 local_uuid, req.dest_uuid())),
+              TabletServerErrorPB::WRONG_SERVER_UUID);
+    return;
+  }
+  scoped_refptr<TabletReplica> replica;
+  Status s = tablet_manager->GetTabletReplica(req.tablet_id(), &replica);
+  if (PREDICT_FALSE(!s.ok())) {
+    set_error(s, s.IsServiceUnavailable() ? TabletServerErrorPB::UNKNOWN_ERROR
+                                          : TabletServerErrorPB::TABLET_NOT_FOUND);
+    return;
+  }
+  tablet::TabletStatePB state = replica->state();
+  if (PREDICT_FALSE(state != tablet::RUNNING)) {
+    TabletServerErrorPB::Code error_code;
+    s = TabletNotRunningError(replica, state, &error_code);
+    set_error(s, error_code);
+    return;
+  }
+  shared_ptr<RaftConsensus> consensus = replica->shared_consensus();
+  if (PREDICT_FALSE(!consensus)) {
+    set_error(Status::ServiceUnavailable("Raft Consensus unavailable",
+                                         "Tablet replica not initialized"),
+              TabletServerErrorPB::TABLET_NOT_RUNNING);
+    return;
+  }
+  if (PREDICT_FALSE(req.has_ops_sidecar_idx())) {
+    // The sidecars of a batch aren't associated with any of its requests.
+    set_error(Status::InvalidArgument("ops can't be sent in sidecars in a batch"),
+              TabletServerErrorPB::UNKNOWN_ERROR);
+    return;
+  }
+  s = consensus->Update(&req, resp);
+  if (PREDICT_FALSE(!s.ok())) {
+    set_error(s, TabletServerErrorPB::UNKNOWN_ERROR);
+    return;
+  }
+  resp->set_ops_sidecar_supported(true);
+}
+
+} // anonymous namespace
+
+void ConsensusServiceImpl::BatchUpdateConsensus(const BatchConsensusRequestPB* req,
+                                                BatchConsensusResponsePB* resp,
+                                                rpc::RpcContext* context) {
+  DVLOG(3) << "Received Consensus BatchUpdate RPC: " << SecureDebugString(*req);
+  for (const auto& update_req : req->requests()) {
+    UpdateConsensusInBatch(tablet_manager_, update_req, resp->add_responses());
+  }
   context->RespondSuccess();
 }
 
@@ -1851,9 +2783,190 @@ void SetResourceMetrics(const rpc::RpcContext* context,
   metrics->set_total_duration_nanos(timing.TotalDuration().ToNanoseconds());
   metrics->set_cpu_system_nanos(cpu_times->system);
   metrics->set_cpu_user_nanos(cpu_times->user);
+
+  if (FLAGS_scan_stage_timing) {
+    const ScanStageTimes stage_times = ScanStageTimes::FromTraceMetrics(
+        *context->trace()->metrics());
+    metrics->set_decode_nanos(stage_times.nanos(ScanStage::kDecode));
+    metrics->set_decompress_nanos(stage_times.nanos(ScanStage::kDecompress));
+    metrics->set_predicate_eval_nanos(stage_times.nanos(ScanStage::kPredicateEval));
+    metrics->set_delta_apply_nanos(stage_times.nanos(ScanStage::kDeltaApply));
+    metrics->set_merge_nanos(stage_times.nanos(ScanStage::kMerge));
+    metrics->set_serialize_nanos(stage_times.nanos(ScanStage::kSerialize));
+    metrics->set_cache_miss_wait_nanos(stage_times.nanos(ScanStage::kCacheMissWait));
+  }
 }
 } // anonymous namespace
 
+namespace {
+
+// Looks up the rows of 'tablet' with the primary keys in 'req' as of 'snap',
+// serializing the found rows' 'projection' columns into 'rows_data' and
+// 'indirect_data', and the indexes of the keys they match into 'key_indexes'.
+// Returns the number of rows found in 'num_rows'.
+//
+// Each key is read with its own iterator, bounded to the key's row: the
+// rowsets whose key ranges can't contain the key are culled and the others
+// seek to the row with their key index, so no scanner state is needed.
+Status LookupRows(Tablet* tablet,
+                  const Schema& tablet_schema,
+                  const Schema& projection,
+                  const MvccSnapshot& snap,
+                  const LookupRequestPB& req,
+                  faststring* rows_data,
+                  faststring* indirect_data,
+                  google::protobuf::RepeatedField<int32_t>* key_indexes,
+                  int* num_rows,
+                  TabletServerErrorPB::Code* error_code) {
+  // The key columns are read along with the projection, for the predicates.
+  SchemaBuilder projection_builder;
+  projection_builder.Reset(projection);
+  for (int i = 0; i < tablet_schema.num_key_columns(); i++) {
+    // Key columns already in the projection are ignored.
+    ignore_result(projection_builder.AddColumn(tablet_schema.column(i), /*is_key=*/false));
+  }
+  const Schema iter_projection = projection_builder.BuildWithoutIds();
+
+  Arena arena(4 * 1024);
+  RowBlock block(&iter_projection, 1, &arena);
+  *num_rows = 0;
+  for (int key_idx = 0; key_idx < req.encoded_keys_size(); key_idx++) {
+    AutoReleasePool pool;
+    arena.Reset();
+    unique_ptr<EncodedKey> key;
+    Status s = EncodedKey::DecodeEncodedString(tablet_schema, &arena,
+                                               req.encoded_keys(key_idx), &key);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return s.CloneAndPrepend(Substitute("invalid key at index $0", key_idx));
+    }
+    // Equality predicates on all the key columns turn into the key bounds of
+    // the row once the spec is optimized.
+    ScanSpec spec;
+    for (int i = 0; i < tablet_schema.num_key_columns(); i++) {
+      spec.AddPredicate(ColumnPredicate::Equality(tablet_schema.column(i), key->raw_keys()[i]));
+    }
+    spec.OptimizeScan(tablet_schema, &arena, &pool, /*remove_pushed_predicates=*/true);
+
+    tablet::RowIteratorOptions opts;
+    opts.projection = &iter_projection;
+    opts.snap_to_include = snap;
+    unique_ptr<RowwiseIterator> iter;
+    RETURN_NOT_OK(tablet->NewRowIterator(std::move(opts), &iter));
+    s = iter->Init(&spec);
+    if (PREDICT_FALSE(s.IsInvalidArgument())) {
+      *error_code = TabletServerErrorPB::MISMATCHED_SCHEMA;
+    }
+    RETURN_NOT_OK(s);
+    while (iter->HasNext()) {
+      RETURN_NOT_OK(iter->NextBlock(&block));
+      if (block.nrows() == 0 || !block.selection_vector()->AnySelected()) {
+        continue;
+      }
+      // A key matches at most a single row.
+      *num_rows += SerializeRowBlock(block, &projection, rows_data, indirect_data);
+      key_indexes->Add(key_idx);
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+} // anonymous namespace
+
+void TabletServiceImpl::Lookup(const LookupRequestPB* req,
+                               LookupResponsePB* resp,
+                               rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::Lookup",
+               "tablet_id", req->tablet_id());
+  scoped_refptr<TabletReplica> replica;
+  if (!LookupRunningTabletReplicaOrRespond(server_->tablet_manager(), req->tablet_id(), resp,
+                                           context, &replica)) {
+    return;
+  }
+  const Schema& tablet_schema = replica->tablet_metadata()->schema();
+
+  // A lookup requires the privileges of an ordered scan of its projection:
+  // the projected columns and the primary key columns.
+  if (FLAGS_tserver_enforce_access_control) {
+    TokenPB token;
+    if (!VerifyAuthzTokenOrRespond(server_->token_verifier(), *req, context, &token)) {
+      return;
+    }
+    const auto& privilege = token.authz().table_privilege();
+    if (!CheckMatchingTableIdOrRespond(privilege, replica->tablet_metadata()->table_id(),
+                                       "Lookup", context)) {
+      return;
+    }
+    unordered_set<ColumnId> authorized_column_ids;
+    if (!CheckMayHaveScanPrivilegesOrRespond(privilege, "Lookup", &authorized_column_ids,
+                                             context)) {
+      return;
+    }
+    if (!privilege.scan_privilege()) {
+      NewScanRequestPB scan_pb;
+      *scan_pb.mutable_projected_columns() = req->projected_columns();
+      scan_pb.set_order_mode(ORDERED);
+      if (!CheckScanPrivilegesOrRespond(scan_pb, tablet_schema, authorized_column_ids,
+                                        "Lookup", context)) {
+        return;
+      }
+    }
+  }
+
+  Schema projection;
+  Status s = ColumnPBsToSchema(req->projected_columns(), &projection);
+  if (PREDICT_TRUE(s.ok()) && projection.has_column_ids()) {
+    s = Status::InvalidArgument("User requests should not have Column IDs");
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s, TabletServerErrorPB::INVALID_SCHEMA, context);
+    return;
+  }
+
+  TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+  shared_ptr<Tablet> tablet;
+  s = GetTabletRef(replica, &tablet, &error_code);
+  if (PREDICT_TRUE(s.ok())) {
+    s = tablet->mvcc_manager()->CheckIsCleanTimeInitialized();
+    if (PREDICT_FALSE(!s.ok())) {
+      error_code = TabletServerErrorPB::TABLET_NOT_RUNNING;
+    }
+  }
+  faststring rows_data;
+  faststring indirect_data;
+  int num_rows = 0;
+  if (PREDICT_TRUE(s.ok())) {
+    s = LookupRows(tablet.get(), tablet_schema, projection,
+                   MvccSnapshot(*tablet->mvcc_manager()), *req,
+                   &rows_data, &indirect_data, resp->mutable_key_indexes(), &num_rows,
+                   &error_code);
+  }
+  if (PREDICT_FALSE(!s.ok())) {
+    if (tablet && tablet->HasBeenStopped()) {
+      error_code = TabletServerErrorPB::TABLET_FAILED;
+    }
+    resp->clear_key_indexes();
+    SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
+    return;
+  }
+
+  RowwiseRowBlockPB* data = resp->mutable_data();
+  data->set_num_rows(num_rows);
+  int rows_idx;
+  CHECK_OK(context->AddOutboundSidecar(RpcSidecar::FromFaststring(std::move(rows_data)),
+                                       &rows_idx));
+  data->set_rows_sidecar(rows_idx);
+  if (indirect_data.size() > 0) {
+    int indirect_idx;
+    CHECK_OK(context->AddOutboundSidecar(RpcSidecar::FromFaststring(std::move(indirect_data)),
+                                         &indirect_idx));
+    data->set_indirect_data_sidecar(indirect_idx);
+  }
+  resp->set_propagated_timestamp(server_->clock()->Now().ToUint64());
+  context->RespondSuccess();
+}
+
 void TabletServiceImpl::Scan(const ScanRequestPB* req,
                              ScanResponsePB* resp,
                              rpc::RpcContext* context) {
@@ -1902,10 +3015,33 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   }
 
   size_t batch_size_bytes = GetMaxBatchSizeBytesHint(req);
-  ScanResultCopier collector(batch_size_bytes);
+  ScanResultCopier copier(batch_size_bytes);
+
+  // Scans with an aggregation return partial aggregates instead of rows. If
+  // the scanner can't be found, the error is reported when continuing the scan.
+  unique_ptr<ScanResultAggregator> aggregator;
+  if (req->has_new_scan_request()) {
+    if (req->new_scan_request().has_aggregation()) {
+      aggregator.reset(new ScanResultAggregator(req->new_scan_request().aggregation()));
+    }
+  } else if (req->has_scanner_id()) {
+    SharedScanner scanner;
+    TabletServerErrorPB::Code unused_code;
+    if (server_->scanner_manager()->LookupScanner(req->scanner_id(),
+                                                  context->remote_user().username(),
+                                                  &unused_code,
+                                                  &scanner).ok() &&
+        scanner->aggregation()) {
+      aggregator.reset(new ScanResultAggregator(*scanner->aggregation()));
+    }
+  }
+  ScanResultCollector* collector = aggregator ?
+      static_cast<ScanResultCollector*>(aggregator.get()) : &copier;
 
   bool has_more_results = false;
   TabletServerErrorPB::Code error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+  // The key under which the results are cached, if they may be.
+  string cache_key;
   if (req->has_new_scan_request()) {
     if (!CheckTabletServerNotQuiescingOrRespond(server_, resp, context)) {
       return;
@@ -1916,10 +3052,22 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
                                              context, &replica)) {
       return;
     }
+
+    ScanResultCache* cache = server_->scan_result_cache();
+    if (cache && ScanResultCache::IsCacheable(scan_pb)) {
+      cache_key = ScanResultCache::MakeKey(
+          scan_pb, replica->tablet_metadata()->schema_version(), batch_size_bytes);
+      if (cache->Lookup(cache_key, context, resp)) {
+        TRACE("Returning cached scan results");
+        resp->set_propagated_timestamp(server_->clock()->Now().ToUint64());
+        context->RespondSuccess();
+        return;
+      }
+    }
     string scanner_id;
     Timestamp scan_timestamp;
     Status s = HandleNewScanRequest(replica.get(), req, context,
-                                    &collector, &scanner_id, &scan_timestamp, &has_more_results,
+                                    collector, &scanner_id, &scan_timestamp, &has_more_results,
                                     &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
@@ -1934,7 +3082,7 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
       resp->set_snap_timestamp(scan_timestamp.ToUint64());
     }
   } else if (req->has_scanner_id()) {
-    Status s = HandleContinueScanRequest(req, context, &collector, &has_more_results, &error_code);
+    Status s = HandleContinueScanRequest(req, context, collector, &has_more_results, &error_code);
     if (PREDICT_FALSE(!s.ok())) {
       SetupErrorAndRespond(resp->mutable_error(), s, error_code, context);
       return;
@@ -1945,12 +3093,38 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
     return;
   }
 
-  collector.SetupResponse(context, resp);
+  // Only scans which return all of their results at once are cached.
+  const bool cache_results = !cache_key.empty() && !has_more_results;
+  vector<faststring> sidecar_copies;
+  if (aggregator) {
+    aggregator->SetupResponse(resp);
+  } else {
+    copier.SetupResponse(context, resp, cache_results ? &sidecar_copies : nullptr);
+  }
+  if (collector->adaptive_batch_size_bytes() > 0) {
+    resp->set_batch_size_bytes(collector->adaptive_batch_size_bytes());
+  }
   resp->set_has_more_results(has_more_results);
+  if (cache_results) {
+    server_->scan_result_cache()->Insert(cache_key, *resp, std::move(sidecar_copies));
+  }
   resp->set_propagated_timestamp(server_->clock()->Now().ToUint64());
 
-  SetResourceMetrics(context, collector.cpu_times(), resp->mutable_resource_metrics());
+  SetResourceMetrics(context, collector->cpu_times(), resp->mutable_resource_metrics());
+
+  // Start reading the next batch while the client processes this one. The
+  // request and response are gone once the RPC is responded to.
+  const bool prefetch = FLAGS_scanner_prefetch && has_more_results && !aggregator;
+  string scanner_id;
+  string username;
+  if (prefetch) {
+    scanner_id = resp->has_scanner_id() ? resp->scanner_id() : req->scanner_id();
+    username = context->remote_user().username();
+  }
   context->RespondSuccess();
+  if (prefetch) {
+    PrefetchScanBatch(scanner_id, username, batch_size_bytes);
+  }
 }
 
 void TabletServiceImpl::ListTablets(const ListTabletsRequestPB* req,
@@ -2246,6 +3420,21 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
   context->RespondSuccess();
 }
 
+void TabletServiceImpl::RegisterBloomFilter(const RegisterBloomFilterRequestPB* req,
+                                            RegisterBloomFilterResponsePB* resp,
+                                            rpc::RpcContext* context) {
+  TRACE_EVENT1("tserver", "TabletServiceImpl::RegisterBloomFilter",
+               "filter_id", req->filter_id());
+  Status s = server_->bloom_filter_registry()->Register(
+      context->remote_user().username(), req->filter_id(), req->bloom_filter(),
+      MonoDelta::FromMilliseconds(req->ttl_ms()));
+  if (PREDICT_FALSE(!s.ok())) {
+    SetupErrorAndRespond(resp->mutable_error(), s, TabletServerErrorPB::UNKNOWN_ERROR, context);
+    return;
+  }
+  context->RespondSuccess();
+}
+
 bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
   switch (feature) {
     case TabletServerFeatures::COLUMN_PREDICATES:
@@ -2253,6 +3442,12 @@ bool TabletServiceImpl::SupportsFeature(uint32_t feature) const {
     case TabletServerFeatures::QUIESCING:
     case TabletServerFeatures::BLOOM_FILTER_PREDICATE:
     case TabletServerFeatures::COLUMNAR_LAYOUT_FEATURE:
+    case TabletServerFeatures::AGGREGATION_FEATURE:
+    case TabletServerFeatures::COLUMNAR_COMPRESSION_FEATURE:
+    case TabletServerFeatures::REGISTERED_BLOOM_FILTER_FEATURE:
+    case TabletServerFeatures::MULTI_WRITE_FEATURE:
+    case TabletServerFeatures::LOOKUP_FEATURE:
+    case TabletServerFeatures::ARROW_LAYOUT_FEATURE:
       return true;
     default:
       return false;
@@ -2336,19 +3531,152 @@ static Status DecodeEncodedKeyRange(const NewScanRequestPB& scan_pb,
     scanner->autorelease_pool()->Add(stop.release());
   }
 
+  if (scan_pb.key_ranges_size() > 0) {
+    vector<pair<string, string>> ranges;
+    ranges.reserve(scan_pb.key_ranges_size());
+    for (const auto& range_pb : scan_pb.key_ranges()) {
+      ranges.emplace_back(range_pb.start_primary_key(), range_pb.stop_primary_key());
+    }
+    RETURN_NOT_OK(spec->SetKeyRanges(tablet_schema, scanner->arena(),
+                                     scanner->autorelease_pool(), std::move(ranges)));
+  }
+
+  return Status::OK();
+}
+
+// Validates the aggregation of 'scan_pb' against the client's projection
+// 'projection' of a tablet with schema 'tablet_schema'.
+static Status ValidateAggregation(const NewScanRequestPB& scan_pb,
+                                  const Schema& tablet_schema,
+                                  const Schema& projection) {
+  if (scan_pb.has_limit()) {
+    return Status::InvalidArgument("Cannot specify a limit for a scan with an aggregation");
+  }
+  if (scan_pb.order_mode() == ORDERED) {
+    return Status::InvalidArgument("Cannot do an ordered scan with an aggregation");
+  }
+  const AggregationPB& aggregation = scan_pb.aggregation();
+  int num_group_by = aggregation.num_group_by_columns();
+  if (num_group_by < 0 ||
+      num_group_by > projection.num_columns() ||
+      num_group_by > tablet_schema.num_key_columns()) {
+    return Status::InvalidArgument(
+        Substitute("Invalid number of group-by columns: $0", num_group_by));
+  }
+  for (int i = 0; i < num_group_by; i++) {
+    if (projection.column(i).name() != tablet_schema.column(i).name()) {
+      return Status::InvalidArgument(
+          Substitute("Group-by column $0 is not a prefix of the primary key",
+                     projection.column(i).name()));
+    }
+  }
+  if (aggregation.aggregates_size() == 0) {
+    return Status::InvalidArgument("An aggregation must specify at least one aggregate");
+  }
+  for (const auto& aggregate : aggregation.aggregates()) {
+    if (aggregate.has_projection_idx() &&
+        (aggregate.projection_idx() < 0 ||
+         aggregate.projection_idx() >= projection.num_columns())) {
+      return Status::InvalidArgument(
+          Substitute("Invalid aggregate column index: $0", aggregate.projection_idx()));
+    }
+    switch (aggregate.type()) {
+      case AggregatePB::COUNT:
+        break;
+      case AggregatePB::SUM:
+      case AggregatePB::MIN:
+      case AggregatePB::MAX: {
+        if (!aggregate.has_projection_idx()) {
+          return Status::InvalidArgument(
+              Substitute("$0 requires a column", AggregatePB::Type_Name(aggregate.type())));
+        }
+        const ColumnSchema& col = projection.column(aggregate.projection_idx());
+        if (col.type_info()->type() == IS_DELETED) {
+          return Status::InvalidArgument(
+              Substitute("Cannot aggregate virtual column $0", col.name()));
+        }
+        if (aggregate.type() == AggregatePB::SUM) {
+          switch (col.type_info()->type()) {
+            case INT8:
+            case INT16:
+            case INT32:
+            case INT64:
+            case FLOAT:
+            case DOUBLE:
+              break;
+            default:
+              return Status::InvalidArgument(
+                  Substitute("Cannot compute SUM of column $0 of type $1",
+                             col.name(), col.type_info()->name()));
+          }
+        }
+        break;
+      }
+      default:
+        return Status::InvalidArgument("Unknown aggregate type specified");
+    }
+  }
   return Status::OK();
 }
 
+// Passes the rollups added to 'sink' since they were last taken to
+// 'result_collector', for a scan whose rows have the schema 'projection'.
+static void HandleRollups(const Schema& projection,
+                          tablet::RowSetRollupSink* sink,
+                          ScanResultCollector* result_collector) {
+  vector<shared_ptr<const tablet::RowSetRollupPB>> rollups;
+  sink->Take(&rollups);
+  for (const auto& rollup : rollups) {
+    result_collector->HandleRollup(projection, sink->col_ids(), *rollup);
+  }
+}
+
+// Returns the sink of the rollups which the rowsets of the tablet may provide
+// instead of their rows to the given aggregation, or null if the aggregation
+// can't use rollups. The columns of the aggregates are looked up by name in
+// the tablet's schema, since the scan's projection has no column IDs.
+static unique_ptr<tablet::RowSetRollupSink> NewRollupSink(const AggregationPB& aggregation,
+                                                          const Schema& tablet_schema,
+                                                          const Schema& projection) {
+  vector<ColumnId> col_ids;
+  for (const auto& aggregate : aggregation.aggregates()) {
+    if (!aggregate.has_projection_idx()) {
+      continue;
+    }
+    // Rollups don't aggregate the values of their group-by columns.
+    int col_idx = tablet_schema.find_column(projection.column(aggregate.projection_idx()).name());
+    if (col_idx == Schema::kColumnNotFound || col_idx < aggregation.num_group_by_columns()) {
+      return nullptr;
+    }
+    col_ids.push_back(tablet_schema.column_id(col_idx));
+  }
+  return unique_ptr<tablet::RowSetRollupSink>(
+      new tablet::RowSetRollupSink(aggregation.num_group_by_columns(), std::move(col_ids)));
+}
+
 static Status SetupScanSpec(const NewScanRequestPB& scan_pb,
                             const Schema& tablet_schema,
+                            const BloomFilterRegistry& bloom_filter_registry,
                             const SharedScanner& scanner,
                             ScanSpec* spec) {
   spec->set_cache_blocks(scan_pb.cache_blocks());
 
   // First the column predicates.
   for (const ColumnPredicatePB& pred_pb : scan_pb.column_predicates()) {
+    vector<BlockBloomFilter*> registered_bloom_filters;
+    if (pred_pb.has_in_bloom_filter()) {
+      for (const auto& filter_id : pred_pb.in_bloom_filter().registered_filter_ids()) {
+        shared_ptr<BlockBloomFilter> filter;
+        RETURN_NOT_OK(bloom_filter_registry.Lookup(scanner->remote_user().username(),
+                                                   filter_id, &filter));
+        registered_bloom_filters.emplace_back(filter.get());
+        // The scanner keeps the filter alive even if it expires meanwhile.
+        scanner->autorelease_pool()->Add(new shared_ptr<BlockBloomFilter>(std::move(filter)));
+      }
+    }
     boost::optional<ColumnPredicate> predicate;
-    RETURN_NOT_OK(ColumnPredicateFromPB(tablet_schema, scanner->arena(), pred_pb, &predicate));
+    RETURN_NOT_OK(ColumnPredicateFromPB(tablet_schema, scanner->arena(), pred_pb, &predicate,
+                                        registered_bloom_filters));
     spec->AddPredicate(std::move(*predicate));
   }
 
@@ -2502,11 +3830,17 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   const Schema& tablet_schema = replica->tablet_metadata()->schema();
 
   ScanSpec spec;
-  s = SetupScanSpec(scan_pb, tablet_schema, scanner, &spec);
+  s = SetupScanSpec(scan_pb, tablet_schema, *server_->bloom_filter_registry(), scanner, &spec);
   if (PREDICT_FALSE(!s.ok())) {
     *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
     return s;
   }
+  // Only the values of IN-lists on hash columns which hash to this tablet can
+  // match any of its rows. Newer clients send only those already.
+  PartitionPruner::TrimInListPredicates(tablet_schema,
+                                        replica->tablet_metadata()->partition_schema(),
+                                        replica->tablet_metadata()->partition(),
+                                        &spec);
 
   VLOG(3) << "Before optimizing scan spec: " << spec.ToString(tablet_schema);
   spec.OptimizeScan(tablet_schema, scanner->arena(), scanner->autorelease_pool(), true);
@@ -2565,13 +3899,28 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   projection = projection_builder.BuildWithoutIds();
   VLOG(3) << "Scan projection: " << projection.ToString(Schema::BASE_INFO);
 
+  if (scan_pb.has_aggregation()) {
+    s = ValidateAggregation(scan_pb, tablet_schema, *client_projection);
+    if (PREDICT_FALSE(!s.ok())) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return s;
+    }
+    scanner->set_aggregation(scan_pb.aggregation());
+    if (FLAGS_scanner_use_rowset_rollups) {
+      scanner->set_rollup_sink(
+          NewRollupSink(scan_pb.aggregation(), tablet_schema, *client_projection));
+    }
+  }
+
   s = result_collector->InitSerializer(scan_pb.row_format_flags(),
+                                       scan_pb.columnar_compression(),
                                        projection,
                                        *client_projection);
   if (!s.ok()) {
     *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
     return s;
   }
+  scanner->set_columnar_compression(scan_pb.columnar_compression());
 
   if (spec.CanShortCircuit()) {
     VLOG(1) << "short-circuiting without creating a server-side scanner.";
@@ -2613,14 +3962,21 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
           return Status::InvalidArgument("scan start timestamp is only supported "
                                          "in READ_AT_SNAPSHOT read mode");
         }
-        s = tablet->NewRowIterator(projection, &iter);
+        tablet::RowIteratorOptions opts;
+        opts.projection = &projection;
+        opts.snap_to_include = MvccSnapshot(*tablet->mvcc_manager());
+        opts.scan_pool = server_->scan_pool();
+        opts.max_parallelism = FLAGS_scanner_max_parallelism;
+        opts.column_read_pool = server_->column_read_pool();
+        opts.rollup_sink = scanner->rollup_sink();
+        s = tablet->NewRowIterator(std::move(opts), &iter);
         break;
       }
       case READ_YOUR_WRITES: // Fallthrough intended
       case READ_AT_SNAPSHOT: {
         s = HandleScanAtSnapshot(
             scan_pb, rpc_context, projection, tablet.get(), replica->time_manager(),
-            &iter, &snap_start_timestamp, snap_timestamp, error_code);
+            scanner->rollup_sink(), &iter, &snap_start_timestamp, snap_timestamp, error_code);
         break;
       }
     }
@@ -2690,6 +4046,11 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   *has_more_results = iter->HasNext() && !scanner->has_fulfilled_limit();
   TRACE("has_more: $0", *has_more_results);
   if (!*has_more_results) {
+    // The rollups of the rowsets read instead of their rows, if any, make up
+    // the rest of the result.
+    if (scanner->rollup_sink()) {
+      HandleRollups(iter->schema(), scanner->rollup_sink(), result_collector);
+    }
     // If there are no more rows, we can short circuit some work and respond immediately.
     VLOG(1) << "No more rows, short-circuiting out without creating a server-side scanner.";
     return Status::OK();
@@ -2725,76 +4086,21 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletReplica* replica,
   return Status::OK();
 }
 
-// Continue an existing scan request.
-Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
-                                                    const RpcContext* rpc_context,
-                                                    ScanResultCollector* result_collector,
-                                                    bool* has_more_results,
-                                                    TabletServerErrorPB::Code* error_code) {
-  DCHECK(req->has_scanner_id());
-  TRACE_EVENT1("tserver", "TabletServiceImpl::HandleContinueScanRequest",
-               "scanner_id", req->scanner_id());
-
-  size_t batch_size_bytes = GetMaxBatchSizeBytesHint(req);
-
-  SharedScanner scanner;
-  TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
-  Status s = server_->scanner_manager()->LookupScanner(req->scanner_id(),
-                                                       rpc_context->remote_user().username(),
-                                                       &code,
-                                                       &scanner);
-  if (!s.ok()) {
-    if (s.IsNotFound() && batch_size_bytes == 0 && req->close_scanner()) {
-      // Silently ignore any request to close a non-existent scanner.
-      return Status::OK();
-    }
-    LOG(INFO) << Substitute("Scan: $0: call sequence id=$1, remote=$2",
-                            s.ToString(), req->call_seq_id(), rpc_context->requestor_string());
-    *error_code = code;
-    return s;
-  }
-  // TODO(todd) consider TryLockForAccess and return ServiceUnavailable in the case that
-  // another thread is already using the scanner? This should be rare in real
-  // circumstances -- only relevant when a client performs some retries on timeout.
-  auto scanner_lock = scanner->LockForAccess();
-
-  if (PREDICT_FALSE(FLAGS_scanner_inject_service_unavailable_on_continue_scan)) {
-    return Status::ServiceUnavailable("Injecting service unavailable status on Scan due to "
-                                      "--scanner_inject_service_unavailable_on_continue_scan");
-  }
-
-  // If we early-exit out of this function, automatically unregister the scanner.
-  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner->id());
-  ScopedAddScannerTiming scanner_timer(scanner.get(), result_collector->cpu_times());
-
-  VLOG(2) << "Found existing scanner " << scanner->id() << " for request: "
-          << SecureShortDebugString(*req);
-  TRACE("Found scanner $0 for tablet $1", scanner->id(), scanner->tablet_id());
-
-  if (batch_size_bytes == 0 && req->close_scanner()) {
-    *has_more_results = false;
-    return Status::OK();
-  }
-
-  if (req->call_seq_id() != scanner->call_seq_id()) {
-    *error_code = TabletServerErrorPB::INVALID_SCAN_CALL_SEQ_ID;
-    if (!FLAGS_scanner_unregister_on_invalid_seq_id) {
-      unreg_scanner.Cancel();
-    }
-    return Status::InvalidArgument("Invalid call sequence ID in scan request");
-  }
-  scanner->IncrementCallSeqId();
+namespace {
 
+// Reads rows from 'scanner' into 'result_collector' until the collector holds
+// 'batch_size_bytes' of results, the time budget is used up, or the scan is
+// complete, and updates the tablet's scan metrics accordingly. The collector
+// may already hold results, which don't count towards the metrics again.
+//
+// Requires the scanner's AccessLock.
+Status ReadScanBatch(Scanner* scanner,
+                     size_t batch_size_bytes,
+                     ScanResultCollector* result_collector,
+                     TabletServerErrorPB::Code* error_code) {
   RowwiseIterator* iter = scanner->iter();
-
-  // Set the row format flags on the ScanResultCollector.
-  s = result_collector->InitSerializer(scanner->row_format_flags(),
-                                       iter->schema(),
-                                       *scanner->client_projection_schema());
-  if (!s.ok()) {
-    *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
-    return s;
-  }
+  const int64_t prev_rows_returned = result_collector->NumRowsReturned();
+  const int64_t prev_response_size = result_collector->ResponseSize();
 
   // TODO(todd): could size the RowBlock based on the user's requested batch size?
   // If people had really large indirect objects, we would currently overshoot
@@ -2816,8 +4122,7 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
 
     Status s = iter->NextBlock(&block);
     if (PREDICT_FALSE(!s.ok())) {
-      LOG(WARNING) << "Copying rows from internal iterator for request "
-                   << SecureShortDebugString(*req);
+      LOG(WARNING) << "Copying rows from internal iterator for scanner " << scanner->id();
       *error_code = TabletServerErrorPB::UNKNOWN_ERROR;
       return s;
     }
@@ -2832,7 +4137,7 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
         DCHECK_GT(rows_left, 0);  // Guaranteed by has_fulfilled_limit()
         block.selection_vector()->ClearToSelectAtMost(static_cast<size_t>(rows_left));
       }
-      result_collector->HandleRowBlock(scanner.get(), block);
+      result_collector->HandleRowBlock(scanner, block);
     }
 
     int64_t response_size = result_collector->ResponseSize();
@@ -2853,10 +4158,14 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     }
   }
 
+  if (scanner->rollup_sink()) {
+    HandleRollups(iter->schema(), scanner->rollup_sink(), result_collector);
+  }
+
   scoped_refptr<TabletReplica> replica = scanner->tablet_replica();
   shared_ptr<Tablet> tablet;
   TabletServerErrorPB::Code tablet_ref_error_code;
-  s = GetTabletRef(replica, &tablet, &tablet_ref_error_code);
+  Status s = GetTabletRef(replica, &tablet, &tablet_ref_error_code);
   // If the tablet is not running, but the scan operation in progress
   // has reached this point, the tablet server has the necessary data to
   // send in response for the scan continuation request.
@@ -2873,13 +4182,12 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   // Update metrics based on this scan request.
   if (tablet) {
     // The number of rows/cells/bytes actually returned to the user.
-    tablet->metrics()->scanner_rows_returned->IncrementBy(
-        result_collector->NumRowsReturned());
+    const int64_t rows_returned = result_collector->NumRowsReturned() - prev_rows_returned;
+    tablet->metrics()->scanner_rows_returned->IncrementBy(rows_returned);
     tablet->metrics()->scanner_cells_returned->IncrementBy(
-        result_collector->NumRowsReturned() *
-            scanner->client_projection_schema()->num_columns());
+        rows_returned * scanner->client_projection_schema()->num_columns());
     tablet->metrics()->scanner_bytes_returned->IncrementBy(
-        result_collector->ResponseSize());
+        result_collector->ResponseSize() - prev_response_size);
 
     // The number of rows/cells/bytes actually processed.
     tablet->metrics()->scanner_rows_scanned->IncrementBy(rows_scanned);
@@ -2890,6 +4198,201 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     tablet->UpdateLastReadTime();
   }
 
+  return Status::OK();
+}
+
+// Reads the next batch of the given scanner ahead of the client's request for
+// it, and stashes it in the scanner. Does nothing if the scan has completed,
+// a batch is already stashed, or there's no memory budget left.
+void ReadAheadScanBatch(TabletServer* server,
+                        const string& scanner_id,
+                        const string& username,
+                        size_t batch_size_bytes) {
+  SharedScanner scanner;
+  TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
+  if (!server->scanner_manager()->LookupScanner(scanner_id, username, &code, &scanner).ok()) {
+    // The scan was closed or expired in the meantime.
+    return;
+  }
+  auto scanner_lock = scanner->LockForAccess();
+  if (scanner->has_prefetched_batch() ||
+      !scanner->iter()->HasNext() ||
+      scanner->has_fulfilled_limit()) {
+    return;
+  }
+  // Read ahead as much as the next request is likely to ask for.
+  const bool adaptive_batch_size = scanner->adaptive_batch_size_bytes() > 0;
+  if (adaptive_batch_size) {
+    batch_size_bytes = scanner->adaptive_batch_size_bytes();
+  }
+  const shared_ptr<MemTracker>& mem_tracker = server->scan_prefetch_mem_tracker();
+  if (!mem_tracker->TryConsume(batch_size_bytes)) {
+    VLOG(2) << "Not enough memory to read ahead for scanner " << scanner_id;
+    return;
+  }
+  unique_ptr<PrefetchedScanResults> batch(
+      new PrefetchedScanResults(batch_size_bytes, mem_tracker, batch_size_bytes));
+  ScanResultCopier* copier = batch->copier();
+  {
+    // Collects the stage times of the batch for the scanner.
+    scoped_refptr<Trace> trace(new Trace());
+    ADOPT_TRACE(trace.get());
+    ScopedAddScannerTiming scanner_timer(scanner.get(), copier->cpu_times());
+    Status s = copier->InitSerializer(scanner->row_format_flags(),
+                                      scanner->columnar_compression(),
+                                      scanner->iter()->schema(),
+                                      *scanner->client_projection_schema());
+    TabletServerErrorPB::Code error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+    if (s.ok()) {
+      error_code = TabletServerErrorPB::UNKNOWN_ERROR;
+      MonoTime read_start = MonoTime::Now();
+      s = ReadScanBatch(scanner.get(), batch_size_bytes, copier, &error_code);
+      if (adaptive_batch_size) {
+        scanner->set_last_batch_read_time(MonoTime::Now() - read_start);
+      }
+    }
+    // Rows may have been consumed from the iterator, so the error can't be
+    // retried; report it on the client's next request instead.
+    if (PREDICT_FALSE(!s.ok())) {
+      batch->set_error(s, error_code);
+    }
+  }
+  scanner->set_prefetched_batch(std::move(batch));
+}
+
+} // anonymous namespace
+
+void TabletServiceImpl::PrefetchScanBatch(const string& scanner_id,
+                                          const string& username,
+                                          size_t batch_size_bytes) {
+  TabletServer* server = server_;
+  Status s = server_->scan_prefetch_pool()->Submit(
+      [server, scanner_id, username, batch_size_bytes]() {
+        ReadAheadScanBatch(server, scanner_id, username, batch_size_bytes);
+      });
+  if (PREDICT_FALSE(!s.ok())) {
+    VLOG(1) << "Could not read ahead for scanner " << scanner_id << ": " << s.ToString();
+  }
+}
+
+// Continue an existing scan request.
+Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
+                                                    const RpcContext* rpc_context,
+                                                    ScanResultCollector* result_collector,
+                                                    bool* has_more_results,
+                                                    TabletServerErrorPB::Code* error_code) {
+  DCHECK(req->has_scanner_id());
+  TRACE_EVENT1("tserver", "TabletServiceImpl::HandleContinueScanRequest",
+               "scanner_id", req->scanner_id());
+
+  size_t batch_size_bytes = GetMaxBatchSizeBytesHint(req);
+
+  SharedScanner scanner;
+  TabletServerErrorPB::Code code = TabletServerErrorPB::UNKNOWN_ERROR;
+  Status s = server_->scanner_manager()->LookupScanner(req->scanner_id(),
+                                                       rpc_context->remote_user().username(),
+                                                       &code,
+                                                       &scanner);
+  if (!s.ok()) {
+    if (s.IsNotFound() && batch_size_bytes == 0 && req->close_scanner()) {
+      // Silently ignore any request to close a non-existent scanner.
+      return Status::OK();
+    }
+    LOG(INFO) << Substitute("Scan: $0: call sequence id=$1, remote=$2",
+                            s.ToString(), req->call_seq_id(), rpc_context->requestor_string());
+    *error_code = code;
+    return s;
+  }
+  // The time the client took to come back since the previous request.
+  MonoDelta client_gap = scanner->TimeSinceLastAccess(MonoTime::Now());
+
+  // TODO(todd) consider TryLockForAccess and return ServiceUnavailable in the case that
+  // another thread is already using the scanner? This should be rare in real
+  // circumstances -- only relevant when a client performs some retries on timeout.
+  auto scanner_lock = scanner->LockForAccess();
+
+  if (PREDICT_FALSE(FLAGS_scanner_inject_service_unavailable_on_continue_scan)) {
+    return Status::ServiceUnavailable("Injecting service unavailable status on Scan due to "
+                                      "--scanner_inject_service_unavailable_on_continue_scan");
+  }
+
+  // If we early-exit out of this function, automatically unregister the scanner.
+  ScopedUnregisterScanner unreg_scanner(server_->scanner_manager(), scanner->id());
+  ScopedAddScannerTiming scanner_timer(scanner.get(), result_collector->cpu_times());
+
+  VLOG(2) << "Found existing scanner " << scanner->id() << " for request: "
+          << SecureShortDebugString(*req);
+  TRACE("Found scanner $0 for tablet $1", scanner->id(), scanner->tablet_id());
+
+  if (batch_size_bytes == 0 && req->close_scanner()) {
+    *has_more_results = false;
+    return Status::OK();
+  }
+
+  if (req->call_seq_id() != scanner->call_seq_id()) {
+    *error_code = TabletServerErrorPB::INVALID_SCAN_CALL_SEQ_ID;
+    if (!FLAGS_scanner_unregister_on_invalid_seq_id) {
+      unreg_scanner.Cancel();
+    }
+    return Status::InvalidArgument("Invalid call sequence ID in scan request");
+  }
+  scanner->IncrementCallSeqId();
+
+  RowwiseIterator* iter = scanner->iter();
+
+  // Size the batch according to how fast the client consumed the previous
+  // ones, unless the client asked for a specific size.
+  const bool adaptive_batch_size = FLAGS_scanner_adaptive_batch_size &&
+      !req->has_batch_size_bytes();
+  if (adaptive_batch_size) {
+    if (scanner->adaptive_batch_size_bytes() > 0) {
+      batch_size_bytes = AdaptBatchSizeBytes(scanner->adaptive_batch_size_bytes(),
+                                             scanner->last_batch_read_time(),
+                                             client_gap);
+    }
+    scanner->set_adaptive_batch_size_bytes(batch_size_bytes);
+    result_collector->set_adaptive_batch_size_bytes(batch_size_bytes);
+  }
+
+  // Return the batch which was read ahead of this request, if there's one.
+  unique_ptr<PrefetchedScanBatch> prefetched = scanner->release_prefetched_batch();
+  if (prefetched) {
+    auto* batch = down_cast<PrefetchedScanResults*>(prefetched.get());
+    if (PREDICT_FALSE(!batch->status().ok())) {
+      *error_code = batch->error_code();
+      return batch->status();
+    }
+    if (PREDICT_FALSE(!result_collector->TakePrefetchedResults(batch->copier()))) {
+      return Status::IllegalState("scan results were read ahead for a different kind of request");
+    }
+    TRACE("Returning prefetched batch");
+    // The batch was sized by the previous request. If this one asks for more,
+    // top the batch up. If it asks for less, the batch is still returned
+    // whole: its rows have already been consumed from the iterator.
+    if (batch_size_bytes > static_cast<size_t>(batch->batch_size_bytes()) &&
+        iter->HasNext() && !scanner->has_fulfilled_limit()) {
+      TRACE("Topping up prefetched batch of $0 bytes to $1 bytes",
+            batch->batch_size_bytes(), batch_size_bytes);
+      RETURN_NOT_OK(ReadScanBatch(scanner.get(), batch_size_bytes, result_collector,
+                                  error_code));
+    }
+  } else {
+    // Set the row format flags on the ScanResultCollector.
+    s = result_collector->InitSerializer(scanner->row_format_flags(),
+                                         scanner->columnar_compression(),
+                                         iter->schema(),
+                                         *scanner->client_projection_schema());
+    if (!s.ok()) {
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return s;
+    }
+    MonoTime read_start = MonoTime::Now();
+    RETURN_NOT_OK(ReadScanBatch(scanner.get(), batch_size_bytes, result_collector, error_code));
+    if (adaptive_batch_size) {
+      scanner->set_last_batch_read_time(MonoTime::Now() - read_start);
+    }
+  }
+
   *has_more_results = !req->close_scanner() && iter->HasNext() &&
       !scanner->has_fulfilled_limit();
   if (*has_more_results) {
@@ -2919,6 +4422,7 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
                                                const Schema& projection,
                                                Tablet* tablet,
                                                TimeManager* time_manager,
+                                               tablet::RowSetRollupSink* rollup_sink,
                                                unique_ptr<RowwiseIterator>* iter,
                                                boost::optional<Timestamp>* snap_start_timestamp,
                                                Timestamp* snap_timestamp,
@@ -2933,7 +4437,7 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
 
   // Based on the read mode, pick a timestamp and verify it.
   Timestamp tmp_snap_timestamp;
-  Status s = PickAndVerifyTimestamp(scan_pb, tablet, &tmp_snap_timestamp);
+  Status s = PickAndVerifyTimestamp(scan_pb, tablet, time_manager, &tmp_snap_timestamp);
   if (PREDICT_FALSE(!s.ok())) {
     *error_code = TabletServerErrorPB::INVALID_SNAPSHOT;
     return s.CloneAndPrepend("cannot verify timestamp");
@@ -2985,6 +4489,10 @@ Status TabletServiceImpl::HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
   opts.projection = &projection;
   opts.snap_to_include = snap;
   opts.order = scan_pb.order_mode();
+  opts.scan_pool = server_->scan_pool();
+  opts.max_parallelism = FLAGS_scanner_max_parallelism;
+  opts.column_read_pool = server_->column_read_pool();
+  opts.rollup_sink = rollup_sink;
 
   boost::optional<Timestamp> tmp_snap_start_timestamp;
   if (scan_pb.has_snap_start_timestamp()) {
@@ -3050,6 +4558,7 @@ Status TabletServiceImpl::ValidateTimestamp(const Timestamp& snap_timestamp) {
 
 Status TabletServiceImpl::PickAndVerifyTimestamp(const NewScanRequestPB& scan_pb,
                                                  Tablet* tablet,
+                                                 TimeManager* time_manager,
                                                  Timestamp* snap_timestamp) {
   // If the client sent a timestamp update our clock with it.
   if (scan_pb.has_propagated_timestamp()) {
@@ -3072,7 +4581,22 @@ Status TabletServiceImpl::PickAndVerifyTimestamp(const NewScanRequestPB& scan_pb
     //      clock time as the snapshot timestamp.
     //   2) else we use the client provided one, but make sure it is not too
     //      far in the future as to be invalid.
-    if (!scan_pb.has_snap_timestamp()) {
+    Timestamp leader_start_timestamp;
+    if (!scan_pb.has_snap_timestamp() &&
+        FLAGS_scanner_leader_snapshot_at_latest_committed &&
+        time_manager->GetLeaderModeStartTimestamp(&leader_start_timestamp)) {
+      // A leader has committed every write it acknowledged, and the writes
+      // acknowledged by previous leaders have lower timestamps than the time
+      // it became leader. A snapshot at the latest of those timestamps thus
+      // reflects all acknowledged writes, without waiting for the newer
+      // in-flight ones to commit like a snapshot at the current time would.
+      uint64_t propagated_timestamp = scan_pb.has_propagated_timestamp() ?
+                                      scan_pb.propagated_timestamp() : Timestamp::kMin.ToUint64();
+      tmp_snap_timestamp = Timestamp(std::max({
+          propagated_timestamp + 1,
+          mvcc_manager->GetCommittedUpperBound().ToUint64(),
+          leader_start_timestamp.ToUint64() }));
+    } else if (!scan_pb.has_snap_timestamp()) {
       tmp_snap_timestamp = server_->clock()->Now();
     } else {
       tmp_snap_timestamp.FromUint64(scan_pb.snap_timestamp());
@@ -16,12 +16,14 @@
 // under the License.
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
 
 #include "kudu/consensus/consensus.service.h"
 #include "kudu/gutil/port.h"
+#include "kudu/gutil/ref_counted.h"
 #include "kudu/tserver/tserver.pb.h"
 #include "kudu/tserver/tserver_admin.service.h"
 #include "kudu/tserver/tserver_service.service.h"
@@ -48,6 +50,8 @@ class ServerBase;
 } // namespace server
 
 namespace consensus {
+class BatchConsensusRequestPB;
+class BatchConsensusResponsePB;
 class BulkChangeConfigRequestPB;
 class ChangeConfigRequestPB;
 class ChangeConfigResponsePB;
@@ -73,12 +77,16 @@ class VoteResponsePB;
 } // namespace consensus
 
 namespace rpc {
+class RequestIdPB;
 class RpcContext;
 } // namespace rpc
 
 namespace tablet {
+class RowSetRollupSink;
 class Tablet;
 class TabletReplica;
+class TransactionCompletionCallback;
+struct WriteAuthorizationContext;
 } // namespace tablet
 
 namespace tserver {
@@ -89,8 +97,14 @@ class ChecksumRequestPB;
 class ChecksumResponsePB;
 class CreateTabletRequestPB;
 class CreateTabletResponsePB;
+class CreateTabletsRequestPB;
+class CreateTabletsResponsePB;
 class DeleteTabletRequestPB;
 class DeleteTabletResponsePB;
+class LookupRequestPB;
+class LookupResponsePB;
+class MultiWriteRequestPB;
+class MultiWriteResponsePB;
 class QuiesceTabletServerRequestPB;
 class QuiesceTabletServerResponsePB;
 class ScanResultCollector;
@@ -125,6 +139,13 @@ class TabletServiceImpl : public TabletServerServiceIf {
   void Write(const WriteRequestPB* req, WriteResponsePB* resp,
              rpc::RpcContext* context) override;
 
+  void MultiWrite(const MultiWriteRequestPB* req, MultiWriteResponsePB* resp,
+                  rpc::RpcContext* context) override;
+
+  void Lookup(const LookupRequestPB* req,
+              LookupResponsePB* resp,
+              rpc::RpcContext* context) override;
+
   void Scan(const ScanRequestPB* req,
             ScanResponsePB* resp,
             rpc::RpcContext* context) override;
@@ -145,11 +166,26 @@ class TabletServiceImpl : public TabletServerServiceIf {
                 ChecksumResponsePB* resp,
                 rpc::RpcContext* context) override;
 
+  void RegisterBloomFilter(const RegisterBloomFilterRequestPB* req,
+                           RegisterBloomFilterResponsePB* resp,
+                           rpc::RpcContext* context) override;
+
   bool SupportsFeature(uint32_t feature) const override;
 
   virtual void Shutdown() OVERRIDE;
 
  private:
+  // Submits the given write to the replica, running 'callback' once the
+  // write completes. If the write can't be submitted, returns an error and
+  // sets 'error_code'; in that case 'callback' is never run.
+  Status SubmitWrite(const scoped_refptr<tablet::TabletReplica>& replica,
+                     const WriteRequestPB* req,
+                     WriteResponsePB* resp,
+                     const rpc::RequestIdPB* request_id,
+                     boost::optional<tablet::WriteAuthorizationContext> authz_context,
+                     std::unique_ptr<tablet::TransactionCompletionCallback> callback,
+                     TabletServerErrorPB::Code* error_code);
+
   Status HandleNewScanRequest(tablet::TabletReplica* tablet_replica,
                               const ScanRequestPB* req,
                               const rpc::RpcContext* rpc_context,
@@ -165,7 +201,14 @@ class TabletServiceImpl : public TabletServerServiceIf {
                                    bool* has_more_results,
                                    TabletServerErrorPB::Code* error_code);
 
-  // Handle READ_AT_SNAPSHOT and READ_YOUR_WRITES scans.
+  // Reads the next batch of the given scanner in the background, so that it's
+  // ready by the time the client asks for it.
+  void PrefetchScanBatch(const std::string& scanner_id,
+                         const std::string& username,
+                         size_t batch_size_bytes);
+
+  // Handle READ_AT_SNAPSHOT and READ_YOUR_WRITES scans. If set, the rollups
+  // of the rowsets read by the scan's aggregation are added to 'rollup_sink'.
   // Returns the opened row iterator, the start timestamp of a snapshot scan,
   // if applicable, and the ending timestamp of a scan.
   Status HandleScanAtSnapshot(const NewScanRequestPB& scan_pb,
@@ -173,6 +216,7 @@ class TabletServiceImpl : public TabletServerServiceIf {
                               const Schema& projection,
                               tablet::Tablet* tablet,
                               consensus::TimeManager* time_manager,
+                              tablet::RowSetRollupSink* rollup_sink,
                               std::unique_ptr<RowwiseIterator>* iter,
                               boost::optional<Timestamp>* snap_start_timestamp,
                               Timestamp* snap_timestamp,
@@ -187,6 +231,7 @@ class TabletServiceImpl : public TabletServerServiceIf {
   // timestamp is after the tablet's ancient history mark.
   Status PickAndVerifyTimestamp(const NewScanRequestPB& scan_pb,
                                 tablet::Tablet* tablet,
+                                consensus::TimeManager* time_manager,
                                 Timestamp* snap_timestamp);
 
   TabletServer* server_;
@@ -204,6 +249,10 @@ class TabletServiceAdminImpl : public TabletServerAdminServiceIf {
                     CreateTabletResponsePB* resp,
                     rpc::RpcContext* context) override;
 
+  void CreateTablets(const CreateTabletsRequestPB* req,
+                     CreateTabletsResponsePB* resp,
+                     rpc::RpcContext* context) override;
+
   void DeleteTablet(const DeleteTabletRequestPB* req,
                     DeleteTabletResponsePB* resp,
                     rpc::RpcContext* context) override;
@@ -219,6 +268,11 @@ class TabletServiceAdminImpl : public TabletServerAdminServiceIf {
   bool SupportsFeature(uint32_t feature) const override;
 
  private:
+  // Creates the tablet described by 'req'. On error, sets 'error_code' to
+  // the code to respond with.
+  Status DoCreateTablet(const CreateTabletRequestPB& req,
+                        TabletServerErrorPB::Code* error_code);
+
   TabletServer* server_;
 };
 
@@ -237,6 +291,10 @@ class ConsensusServiceImpl : public consensus::ConsensusServiceIf {
                                consensus::ConsensusResponsePB* resp,
                                rpc::RpcContext* context) OVERRIDE;
 
+  virtual void BatchUpdateConsensus(const consensus::BatchConsensusRequestPB* req,
+                                    consensus::BatchConsensusResponsePB* resp,
+                                    rpc::RpcContext* context) OVERRIDE;
+
   virtual void RequestConsensusVote(const consensus::VoteRequestPB* req,
                                     consensus::VoteResponsePB* resp,
                                     rpc::RpcContext* context) OVERRIDE;
@@ -21,6 +21,7 @@
 #include <functional>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,11 +35,14 @@
 #include "kudu/common/partial_row.h"
 #include "kudu/common/partition.h"
 #include "kudu/common/schema.h"
+#include "kudu/consensus/consensus_meta.h"
+#include "kudu/consensus/consensus_meta_manager.h"
 #include "kudu/consensus/metadata.pb.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/consensus/raft_consensus.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/master/master.pb.h"
 #include "kudu/tablet/local_tablet_writer.h"
 #include "kudu/tablet/metadata.pb.h"
@@ -48,14 +52,20 @@
 #include "kudu/tablet/tablet_replica.h"
 #include "kudu/tserver/heartbeater.h"
 #include "kudu/tserver/mini_tablet_server.h"
+#include "kudu/fs/fs_manager.h"
 #include "kudu/tserver/tablet_server.h"
+#include "kudu/util/env.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/pb_util.h"
 #include "kudu/util/status.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(open_cold_tablets_lazily);
+DECLARE_int32(cold_tablet_min_idle_secs);
+DECLARE_int32(heartbeat_max_tablets_per_report);
 DECLARE_int32(update_tablet_metrics_interval_ms);
 
 #define ASSERT_REPORT_HAS_UPDATED_TABLET(report, tablet_id) \
@@ -64,6 +74,7 @@ DECLARE_int32(update_tablet_metrics_interval_ms);
 #define ASSERT_MONOTONIC_REPORT_SEQNO(report_seqno, tablet_report) \
   NO_FATALS(AssertMonotonicReportSeqno(report_seqno, tablet_report))
 
+using kudu::consensus::ConsensusMetadata;
 using kudu::consensus::kInvalidOpIdIndex;
 using kudu::consensus::RaftConfigPB;
 using kudu::master::ReportedTabletPB;
@@ -71,15 +82,16 @@ using kudu::master::TabletReportPB;
 using kudu::pb_util::SecureShortDebugString;
 using kudu::tablet::LocalTabletWriter;
 using kudu::tablet::Tablet;
+using kudu::tablet::TabletMetadata;
 using kudu::tablet::TabletReplica;
+using std::set;
 using std::string;
 using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 namespace kudu {
 
-class FsManager;
-
 namespace tserver {
 
 class TsTabletManagerTest : public KuduTest {
@@ -325,6 +337,47 @@ TEST_F(TsTabletManagerTest, TestTabletReports) {
   ASSERT_MONOTONIC_REPORT_SEQNO(&seqno, report);
 }
 
+// Test that a full report of more tablets than fit in a report is split into
+// incremental reports, the last of which completes the full report.
+TEST_F(TsTabletManagerTest, TestChunkedFullTabletReport) {
+  constexpr int kNumTablets = 5;
+  FLAGS_heartbeat_max_tablets_per_report = 2;
+  for (int i = 0; i < kNumTablets; i++) {
+    ASSERT_OK(CreateNewTablet(Substitute("tablet-$0", i), schema_,
+                              boost::none, boost::none, nullptr));
+  }
+
+  TabletReportPB report;
+  int64_t seqno = -1;
+  NO_FATALS(GenerateFullTabletReport(&report));
+  ASSERT_TRUE(report.is_incremental());
+  ASSERT_FALSE(report.completes_full_report());
+  ASSERT_EQ(2, report.updated_tablets().size());
+  ASSERT_MONOTONIC_REPORT_SEQNO(&seqno, report);
+
+  set<string> reported_tablet_ids;
+  while (true) {
+    for (const auto& reported_tablet : report.updated_tablets()) {
+      reported_tablet_ids.insert(reported_tablet.tablet_id());
+    }
+    MarkTabletReportAcknowledged(report);
+    if (report.completes_full_report()) {
+      break;
+    }
+    NO_FATALS(GenerateIncrementalTabletReport(&report));
+    ASSERT_TRUE(report.is_incremental());
+    ASSERT_LE(report.updated_tablets().size(), 2);
+    ASSERT_MONOTONIC_REPORT_SEQNO(&seqno, report);
+    // Tablets may get dirty again while being reported, but not forever.
+    ASSERT_LT(seqno, 100);
+  }
+  ASSERT_EQ(kNumTablets, reported_tablet_ids.size());
+
+  // Once the full report is complete, reports are regular incremental ones.
+  NO_FATALS(GenerateIncrementalTabletReport(&report));
+  ASSERT_FALSE(report.completes_full_report());
+}
+
 TEST_F(TsTabletManagerTest, TestTabletStatsReports) {
   TabletReportPB report;
   int64_t seqno = -1;
@@ -398,5 +451,75 @@ TEST_F(TsTabletManagerTest, TestTabletStatsReports) {
   MarkTabletReportAcknowledged(report);
 }
 
+// Test that tablets are opened on startup likely leaders first, then the other
+// replicas, each by increasing WAL size.
+TEST_F(TsTabletManagerTest, TestSortTabletsToOpen) {
+  scoped_refptr<TabletReplica> big_leader;
+  scoped_refptr<TabletReplica> small_leader;
+  scoped_refptr<TabletReplica> follower;
+  ASSERT_OK(CreateNewTablet("big-leader", schema_, boost::none, boost::none, &big_leader));
+  ASSERT_OK(CreateNewTablet("small-leader", schema_, boost::none, boost::none, &small_leader));
+  ASSERT_OK(CreateNewTablet("follower", schema_, boost::none, boost::none, &follower));
+
+  // Grow the WAL of one leader past the others.
+  ASSERT_OK(WriteStringToFile(
+      fs_manager_->env(), string(1024 * 1024, 'x'),
+      JoinPathSegments(fs_manager_->GetTabletWalDir("big-leader"),
+                       Substitute("$0-padding", FsManager::kWalFileNamePrefix))));
+
+  // Make the replica which has the smallest WAL look like it voted for
+  // another replica in its latest term.
+  scoped_refptr<ConsensusMetadata> cmeta;
+  ASSERT_OK(tablet_manager_->cmeta_manager_->Load("follower", &cmeta));
+  cmeta->set_voted_for("other-uuid");
+
+  vector<scoped_refptr<TabletMetadata>> metas = {
+    follower->tablet_metadata(),
+    big_leader->tablet_metadata(),
+    small_leader->tablet_metadata(),
+  };
+  tablet_manager_->SortTabletsToOpen(&metas);
+  ASSERT_EQ(3, metas.size());
+  ASSERT_EQ("small-leader", metas[0]->tablet_id());
+  ASSERT_EQ("big-leader", metas[1]->tablet_id());
+  ASSERT_EQ("follower", metas[2]->tablet_id());
+}
+
+// Test that cold tablets are left dormant on startup and opened on their first
+// lookup by the tablet server's services.
+TEST_F(TsTabletManagerTest, TestDormantTablets) {
+  FLAGS_open_cold_tablets_lazily = true;
+  FLAGS_cold_tablet_min_idle_secs = 0;
+  const string kTabletId = "dormant";
+  ASSERT_OK(CreateNewTablet(kTabletId, schema_, boost::none, boost::none, nullptr));
+
+  // Make the replica look like a follower, then restart the tablet server.
+  {
+    scoped_refptr<ConsensusMetadata> cmeta;
+    ASSERT_OK(tablet_manager_->cmeta_manager_->Load(kTabletId, &cmeta));
+    cmeta->set_voted_for("other-uuid");
+    ASSERT_OK(cmeta->Flush());
+  }
+  mini_server_->Shutdown();
+  mini_server_.reset(new MiniTabletServer(GetTestPath("TsTabletManagerTest-fsroot"),
+                                          HostPort("127.0.0.1", 0)));
+  ASSERT_OK(mini_server_->Start());
+  ASSERT_OK(mini_server_->WaitStarted());
+  tablet_manager_ = mini_server_->server()->tablet_manager();
+
+  // The tablet is registered, but not opened.
+  scoped_refptr<TabletReplica> replica;
+  ASSERT_TRUE(tablet_manager_->LookupTablet(kTabletId, &replica));
+  ASSERT_EQ(tablet::NOT_INITIALIZED, replica->state());
+  ASSERT_EQ(nullptr, replica->tablet());
+
+  // Its first access opens it.
+  ASSERT_OK(tablet_manager_->GetTabletReplica(kTabletId, &replica));
+  ASSERT_EVENTUALLY([&] {
+    ASSERT_EQ(tablet::RUNNING, replica->state());
+  });
+  ASSERT_OK(replica->consensus()->WaitUntilLeaderForTests(MonoDelta::FromSeconds(10)));
+}
+
 } // namespace tserver
 } // namespace kudu
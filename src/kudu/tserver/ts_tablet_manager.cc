@@ -17,6 +17,7 @@
 
 #include "kudu/tserver/ts_tablet_manager.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -48,6 +49,8 @@
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/strings/util.h"
+#include "kudu/gutil/walltime.h"
 #include "kudu/master/master.pb.h"
 #include "kudu/rpc/result_tracker.h"
 #include "kudu/tablet/metadata.pb.h"
@@ -58,6 +61,7 @@
 #include "kudu/tserver/heartbeater.h"
 #include "kudu/tserver/tablet_server.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/env.h"
 #include "kudu/util/fault_injection.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/flag_validators.h"
@@ -65,6 +69,7 @@
 #include "kudu/util/monotime.h"
 #include "kudu/util/net/net_util.h"
 #include "kudu/util/net/sockaddr.h"
+#include "kudu/util/path_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/threadpool.h"
@@ -82,6 +87,31 @@ DEFINE_int32(num_tablets_to_open_simultaneously, 0,
              "may make sense to manually tune this.");
 TAG_FLAG(num_tablets_to_open_simultaneously, advanced);
 
+DEFINE_bool(prioritize_tablets_to_open, true,
+            "Whether to open tablets on startup in order of priority rather than "
+            "in the order they are found: first the replicas which likely were "
+            "leaders, then the other voters, then the non-voters, and within each "
+            "of these, the replicas with less WAL to replay first. This lets write "
+            "availability recover before every tablet has bootstrapped.");
+TAG_FLAG(prioritize_tablets_to_open, advanced);
+
+DEFINE_bool(open_cold_tablets_lazily, false,
+            "Whether to leave cold tablets dormant on startup rather than opening "
+            "them, opening each on its first scan, write or consensus request "
+            "instead. A tablet is cold if this replica didn't vote for itself in "
+            "its latest term and its WAL hasn't been written for "
+            "--cold_tablet_min_idle_secs. Dormant tablets cost neither startup "
+            "time nor memory, but can't vote or be scanned until opened.");
+TAG_FLAG(open_cold_tablets_lazily, advanced);
+TAG_FLAG(open_cold_tablets_lazily, experimental);
+
+DEFINE_int32(cold_tablet_min_idle_secs, 24 * 60 * 60,
+             "The number of seconds since its WAL was last written after which a "
+             "follower tablet replica is considered cold. See "
+             "--open_cold_tablets_lazily.");
+TAG_FLAG(cold_tablet_min_idle_secs, advanced);
+TAG_FLAG(cold_tablet_min_idle_secs, experimental);
+
 DEFINE_int32(num_tablets_to_delete_simultaneously, 0,
              "Number of threads available to delete tablets. If this is set to 0 (the "
              "default), then the number of delete threads will be set based on the number "
@@ -133,6 +163,14 @@ DEFINE_int32(update_tablet_stats_interval_ms, 5000,
              "Should be greater than 'heartbeat_interval_ms'");
 TAG_FLAG(update_tablet_stats_interval_ms, advanced);
 
+DEFINE_int32(rowset_reader_eviction_interval_secs, 600,
+             "Interval at which the memory held by the cfile readers of the "
+             "rowsets which weren't accessed since the previous interval is "
+             "released. The readers are reinitialized the next time the "
+             "rowsets are accessed. 0 disables this.");
+TAG_FLAG(rowset_reader_eviction_interval_secs, advanced);
+TAG_FLAG(rowset_reader_eviction_interval_secs, runtime);
+
 DEFINE_int32(tablet_bootstrap_inject_latency_ms, 0,
              "Injects latency into the tablet bootstrapping. "
              "For use in tests only.");
@@ -256,6 +294,8 @@ TSTabletManager::TSTabletManager(TabletServer* server)
   // A heartbeat msg without statistics will be considered to be from an old
   // version, thus it's necessary to trigger updating stats as soon as possible.
   next_update_time_ = MonoTime::Now();
+  next_reader_eviction_time_ = MonoTime::Now() +
+      MonoDelta::FromSeconds(FLAGS_rowset_reader_eviction_interval_secs);
 
   METRIC_tablets_num_not_initialized.InstantiateFunctionGauge(
       server->metric_entity(), [this]() {
@@ -399,11 +439,29 @@ Status TSTabletManager::Init() {
   LOG(INFO) << Substitute("Loaded tablet metadata ($0 total tablets, $1 live tablets)",
                           loaded_count, metas.size());
 
-  // Now submit the "Open" task for each.
+  // The tablets are opened in the order their tasks are submitted.
+  if (FLAGS_prioritize_tablets_to_open) {
+    SortTabletsToOpen(&metas);
+  }
+
+  // Now submit the "Open" task for each, unless it's left dormant.
   int registered_count = 0;
+  int dormant_count = 0;
   for (const auto& meta : metas) {
     KLOG_EVERY_N_SECS(INFO, 1) << Substitute("Registering tablets ($0/$1 complete)",
                                              registered_count, metas.size());
+    if (FLAGS_open_cold_tablets_lazily && IsColdTablet(meta->tablet_id())) {
+      scoped_refptr<TabletReplica> replica;
+      RETURN_NOT_OK(CreateAndRegisterTabletReplica(meta, NEW_REPLICA, &replica));
+      replica->SetStatusMessage("Dormant: will be opened on first access");
+      {
+        std::lock_guard<RWMutex> lock(lock_);
+        InsertOrDie(&dormant_tablet_ids_, meta->tablet_id());
+      }
+      registered_count++;
+      dormant_count++;
+      continue;
+    }
     scoped_refptr<TransitionInProgressDeleter> deleter;
     {
       std::lock_guard<RWMutex> lock(lock_);
@@ -417,7 +475,7 @@ Status TSTabletManager::Init() {
         }));
     registered_count++;
   }
-  LOG(INFO) << Substitute("Registered $0 tablets", registered_count);
+  LOG(INFO) << Substitute("Registered $0 tablets ($1 dormant)", registered_count, dormant_count);
 
   {
     std::lock_guard<RWMutex> lock(lock_);
@@ -427,6 +485,130 @@ Status TSTabletManager::Init() {
   return Status::OK();
 }
 
+void TSTabletManager::SortTabletsToOpen(vector<scoped_refptr<TabletMetadata>>* metas) {
+  enum OpenTier {
+    kLikelyLeader,
+    kVoter,
+    kNonVoter,
+  };
+  struct TabletToOpen {
+    scoped_refptr<TabletMetadata> meta;
+    OpenTier tier;
+    uint64_t wal_bytes;
+  };
+  const string& uuid = fs_manager_->uuid();
+  Env* env = fs_manager_->env();
+  int tier_counts[kNonVoter + 1] = { 0, 0, 0 };
+  vector<TabletToOpen> tablets;
+  tablets.reserve(metas->size());
+  for (auto& meta : *metas) {
+    const string& tablet_id = meta->tablet_id();
+
+    // A replica which voted for itself in its latest term most likely won
+    // that election. The consensus metadata is cached by 'cmeta_manager_', so
+    // opening the tablet doesn't read it again; if it can't be loaded,
+    // opening the tablet reports the error.
+    OpenTier tier = kVoter;
+    scoped_refptr<ConsensusMetadata> cmeta;
+    if (cmeta_manager_->Load(tablet_id, &cmeta).ok()) {
+      if (!cmeta->IsVoterInConfig(uuid, consensus::COMMITTED_CONFIG)) {
+        tier = kNonVoter;
+      } else if (cmeta->has_voted_for() && cmeta->voted_for() == uuid) {
+        tier = kLikelyLeader;
+      }
+    }
+    tier_counts[tier]++;
+
+    // The size of the WAL segments approximates the bootstrap time.
+    uint64_t wal_bytes = 0;
+    const string wal_dir = fs_manager_->GetTabletWalDir(tablet_id);
+    vector<string> children;
+    if (env->GetChildren(wal_dir, &children).ok()) {
+      for (const string& child : children) {
+        uint64_t size;
+        if (HasPrefixString(child, FsManager::kWalFileNamePrefix) &&
+            env->GetFileSize(JoinPathSegments(wal_dir, child), &size).ok()) {
+          wal_bytes += size;
+        }
+      }
+    }
+    tablets.push_back({ std::move(meta), tier, wal_bytes });
+  }
+
+  std::stable_sort(tablets.begin(), tablets.end(),
+                   [](const TabletToOpen& a, const TabletToOpen& b) {
+                     if (a.tier != b.tier) {
+                       return a.tier < b.tier;
+                     }
+                     return a.wal_bytes < b.wal_bytes;
+                   });
+  for (size_t i = 0; i < tablets.size(); i++) {
+    (*metas)[i] = std::move(tablets[i].meta);
+  }
+  LOG(INFO) << Substitute("Opening $0 likely leader replicas, then $1 other voters, "
+                          "then $2 non-voters, each by increasing WAL size",
+                          tier_counts[kLikelyLeader], tier_counts[kVoter],
+                          tier_counts[kNonVoter]);
+}
+
+bool TSTabletManager::IsColdTablet(const string& tablet_id) {
+  scoped_refptr<ConsensusMetadata> cmeta;
+  if (!cmeta_manager_->Load(tablet_id, &cmeta).ok() ||
+      (cmeta->has_voted_for() && cmeta->voted_for() == fs_manager_->uuid())) {
+    return false;
+  }
+
+  Env* env = fs_manager_->env();
+  const string wal_dir = fs_manager_->GetTabletWalDir(tablet_id);
+  vector<string> children;
+  if (!env->GetChildren(wal_dir, &children).ok()) {
+    return false;
+  }
+  const int64_t min_idle_micros =
+      static_cast<int64_t>(FLAGS_cold_tablet_min_idle_secs) * 1000000;
+  const int64_t now_micros = GetCurrentTimeMicros();
+  for (const string& child : children) {
+    if (!HasPrefixString(child, FsManager::kWalFileNamePrefix)) {
+      continue;
+    }
+    int64_t mtime_micros;
+    if (!env->GetFileModifiedTime(JoinPathSegments(wal_dir, child), &mtime_micros).ok() ||
+        now_micros - mtime_micros < min_idle_micros) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TSTabletManager::OpenDormantTablet(const scoped_refptr<TabletReplica>& replica) {
+  const string& tablet_id = replica->tablet_id();
+  scoped_refptr<TransitionInProgressDeleter> deleter;
+  {
+    std::lock_guard<RWMutex> lock(lock_);
+    if (dormant_tablet_ids_.erase(tablet_id) == 0) {
+      // Another lookup got here first.
+      return;
+    }
+    // If another transition, such as a deletion, is under way, it decides
+    // what becomes of the replica.
+    if (!StartTabletStateTransitionUnlocked(tablet_id, "opening dormant tablet",
+                                            &deleter).ok()) {
+      return;
+    }
+  }
+  if (replica->state() != tablet::NOT_INITIALIZED ||
+      replica->tablet_metadata()->tablet_data_state() != TABLET_DATA_READY) {
+    return;
+  }
+  LOG(INFO) << LogPrefix(tablet_id) << "Opening dormant tablet on first access";
+  Status s = open_tablet_pool_->Submit([this, replica, deleter]() {
+      this->OpenTablet(replica, deleter);
+    });
+  if (PREDICT_FALSE(!s.ok())) {
+    LOG(WARNING) << LogPrefix(tablet_id) << "Unable to open dormant tablet: " << s.ToString();
+  }
+}
+
 Status TSTabletManager::WaitForAllBootstrapsToFinish() {
   CHECK_EQ(state(), MANAGER_RUNNING);
 
@@ -831,7 +1013,7 @@ Status TSTabletManager::CreateAndRegisterTabletReplica(
       new TabletReplica(std::move(meta),
                         cmeta_manager_,
                         local_peer_pb_,
-                        server_->tablet_apply_pool(),
+                        server_->TabletApplyPool(tablet_id),
                         [this, tablet_id](const string& reason) {
                           this->MarkTabletDirty(tablet_id, reason);
                         }));
@@ -1273,8 +1455,18 @@ bool TSTabletManager::LookupTabletUnlocked(const string& tablet_id,
 
 Status TSTabletManager::GetTabletReplica(const string& tablet_id,
                                          scoped_refptr<tablet::TabletReplica>* replica) const {
-  if (!LookupTablet(tablet_id, replica)) {
-    return Status::NotFound("Tablet not found", tablet_id);
+  bool dormant;
+  {
+    shared_lock<RWMutex> l(lock_);
+    if (!LookupTabletUnlocked(tablet_id, replica)) {
+      return Status::NotFound("Tablet not found", tablet_id);
+    }
+    dormant = ContainsKey(dormant_tablet_ids_, tablet_id);
+  }
+  if (PREDICT_FALSE(dormant)) {
+    // Opening a dormant tablet doesn't change which tablets are hosted, but
+    // it does start a state transition, which isn't const.
+    const_cast<TSTabletManager*>(this)->OpenDormantTablet(*replica);
   }
   return Status::OK();
 }
@@ -1628,6 +1820,13 @@ void TSTabletManager::UpdateTabletStatsIfNecessary() {
   }
   next_update_time_ = MonoTime::Now() +
       MonoDelta::FromMilliseconds(FLAGS_update_tablet_stats_interval_ms);
+  bool evict_readers = false;
+  if (FLAGS_rowset_reader_eviction_interval_secs > 0 &&
+      MonoTime::Now() >= next_reader_eviction_time_) {
+    evict_readers = true;
+    next_reader_eviction_time_ = MonoTime::Now() +
+        MonoDelta::FromSeconds(FLAGS_rowset_reader_eviction_interval_secs);
+  }
   try_lock.unlock();
 
   // Update the tablet stats and collect the dirty tablets.
@@ -1638,6 +1837,25 @@ void TSTabletManager::UpdateTabletStatsIfNecessary() {
     replica->UpdateTabletStats(&dirty_tablets);
   }
 
+  // Release the readers of the rowsets which weren't accessed recently.
+  if (evict_readers) {
+    for (const auto& replica : replicas) {
+      auto tablet = replica->shared_tablet();
+      if (replica->state() != tablet::RUNNING || !tablet) {
+        continue;
+      }
+      int64_t num_evicted;
+      Status s = tablet->EvictIdleRowSetReaders(&num_evicted);
+      if (!s.ok()) {
+        LOG(WARNING) << Substitute("T $0: failed to release idle rowset readers: $1",
+                                   replica->tablet_id(), s.ToString());
+      } else if (num_evicted > 0) {
+        VLOG(1) << Substitute("T $0: released the readers of $1 idle rowsets",
+                              replica->tablet_id(), num_evicted);
+      }
+    }
+  }
+
   if (!dirty_tablets.empty()) {
     MarkTabletsDirty(dirty_tablets, "The tablet statistics have been changed");
   }
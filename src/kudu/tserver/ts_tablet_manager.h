@@ -158,6 +158,9 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   bool LookupTabletUnlocked(const std::string& tablet_id,
                             scoped_refptr<tablet::TabletReplica>* replica) const;
 
+  // Like LookupTablet(), but returns NotFound if the tablet isn't found.
+  // Looking up a dormant tablet this way starts opening it, since this is
+  // how the tablet server's services access tablets.
   virtual Status GetTabletReplica(const std::string& tablet_id,
                                   scoped_refptr<tablet::TabletReplica>* replica) const
                                   override;
@@ -242,6 +245,8 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   FRIEND_TEST(LeadershipChangeReportingTest, TestReportStatsDuringLeadershipChange);
   FRIEND_TEST(TsTabletManagerTest, TestPersistBlocks);
   FRIEND_TEST(TsTabletManagerTest, TestTabletStatsReports);
+  FRIEND_TEST(TsTabletManagerTest, TestSortTabletsToOpen);
+  FRIEND_TEST(TsTabletManagerTest, TestDormantTablets);
   FRIEND_TEST(TsTabletManagerITest, TestTableStats);
 
   // Flag specified when registering a TabletReplica.
@@ -325,6 +330,22 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   void CreateReportedTabletPB(const scoped_refptr<tablet::TabletReplica>& replica,
                               master::ReportedTabletPB* reported_tablet) const;
 
+  // Sorts 'metas' into the order in which to open their tablets on startup,
+  // so that write availability recovers first: the replicas which likely were
+  // leaders, having voted for themselves in their latest term, then the other
+  // voters, then the non-voters, which no majority waits on. Within each of
+  // these, the replicas with less WAL to replay come first.
+  void SortTabletsToOpen(std::vector<scoped_refptr<tablet::TabletMetadata>>* metas);
+
+  // Returns whether the tablet with the given ID is cold: this replica didn't
+  // vote for itself in its latest term, and its WAL hasn't been written for
+  // --cold_tablet_min_idle_secs.
+  bool IsColdTablet(const std::string& tablet_id);
+
+  // Opens 'replica' if it's dormant, i.e. if it was registered on startup but
+  // left unopened, and nothing else is transitioning it.
+  void OpenDormantTablet(const scoped_refptr<tablet::TabletReplica>& replica);
+
   // Handle the case on startup where we find a tablet that is not in
   // TABLET_DATA_READY state. Generally, we tombstone the replica.
   Status HandleNonReadyTabletOnStartup(const scoped_refptr<tablet::TabletMetadata>& meta);
@@ -360,7 +381,7 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   typedef std::unordered_map<std::string, scoped_refptr<tablet::TabletReplica> > TabletMap;
 
   // Lock protecting tablet_map_, dirty_tablets_, state_,
-  // transition_in_progress_, perm_deleted_tablet_ids_,
+  // transition_in_progress_, perm_deleted_tablet_ids_, dormant_tablet_ids_,
   // tablet_state_counts_, and last_walked_.
   mutable RWMutex lock_;
 
@@ -372,6 +393,11 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // restart).
   std::unordered_set<std::string> perm_deleted_tablet_ids_;
 
+  // The ids of the tablets registered on startup but not opened, because
+  // they were cold and --open_cold_tablets_lazily is set. Each is opened on
+  // its first lookup through GetTabletReplica().
+  std::unordered_set<std::string> dormant_tablet_ids_;
+
   // Map of tablet ids -> reason strings where the keys are tablets whose
   // bootstrap, creation, or deletion is in-progress
   TransitionInProgressMap transition_in_progress_;
@@ -401,6 +427,9 @@ class TSTabletManager : public tserver::TabletReplicaLookupIf {
   // Ensures that we only update stats from a single thread at a time.
   mutable rw_spinlock lock_update_;
   MonoTime next_update_time_;
+  // The next time the readers of idle rowsets are released, also protected
+  // by 'lock_update_'.
+  MonoTime next_reader_eviction_time_;
 
   // NOTE: it's important that this is the first member to be destructed. This
   // ensures we do not attempt to collect metrics while calling the destructor.
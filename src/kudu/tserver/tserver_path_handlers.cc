@@ -542,6 +542,18 @@ void IteratorStatsToJson(const ScanDescriptor& scan, EasyJson* json) {
   fill_stats(total_row, "total", total_stats);
 }
 
+void StageTimesToJson(const ScanDescriptor& scan, EasyJson* json) {
+  for (int i = 0; i < kNumScanStages; i++) {
+    const ScanStage stage = static_cast<ScanStage>(i);
+    const int64_t nanos = scan.stage_times.nanos(stage);
+    EasyJson row = json->PushBack(EasyJson::kObject);
+    row["stage"] = ScanStageToString(stage);
+    row["time"] = HumanReadableElapsedTime::ToShortString(
+        static_cast<double>(nanos) / MonoTime::kNanosecondsPerSecond);
+    row["time_title"] = nanos;
+  }
+}
+
 void ScanToJson(const ScanDescriptor& scan, EasyJson* json) {
   MonoTime now = MonoTime::Now();
   MonoDelta duration;
@@ -576,6 +588,9 @@ void ScanToJson(const ScanDescriptor& scan, EasyJson* json) {
 
   EasyJson stats_json = json->Set("stats", EasyJson::kArray);
   IteratorStatsToJson(scan, &stats_json);
+
+  EasyJson stage_times_json = json->Set("stage_times", EasyJson::kArray);
+  StageTimesToJson(scan, &stage_times_json);
 }
 } // anonymous namespace
 
@@ -125,6 +125,13 @@ class BlockBloomFilter {
     return Find(HashUtil::ComputeHash32(key, hash_algorithm_, hash_seed_));
   }
 
+  // Prefetches the bucket that Find() checks for 'hash'. Prefetching the
+  // buckets of several hashes before finding them overlaps their cache misses.
+  void Prefetch(uint32_t hash) const noexcept {
+    prefetch(reinterpret_cast<const char*>(&directory_[Rehash32to32(hash) & directory_mask_]),
+             PREFETCH_HINT_T0);
+  }
+
   // As more distinct items are inserted into a BloomFilter, the false positive rate
   // rises. MaxNdv() returns the NDV (number of distinct values) at which a BloomFilter
   // constructed with (1 << log_space_bytes) bytes of space hits false positive
@@ -51,6 +51,19 @@ METRIC_DEFINE_counter(server, block_cache_hits_caching,
                       "Use this number instead of cache_hits when trying to determine how "
                       "efficient the cache is",
                       kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_probationary_segment_hits,
+                      "Block Cache Probationary Segment Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found a block in the probationary segment "
+                      "of the block cache, i.e. a block looked up for the first time "
+                      "since it was inserted or demoted. Only maintained with the SLRU "
+                      "eviction policy.",
+                      kudu::MetricLevel::kDebug);
+METRIC_DEFINE_counter(server, block_cache_protected_segment_hits,
+                      "Block Cache Protected Segment Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups that found a block in the protected segment "
+                      "of the block cache, i.e. a block looked up repeatedly. Only "
+                      "maintained with the SLRU eviction policy.",
+                      kudu::MetricLevel::kDebug);
 
 METRIC_DEFINE_gauge_uint64(server, block_cache_usage, "Block Cache Memory Usage",
                            kudu::MetricUnit::kBytes,
@@ -69,6 +82,8 @@ BlockCacheMetrics::BlockCacheMetrics(const scoped_refptr<MetricEntity>& entity)
   MINIT(cache_hits_caching, block_cache_hits_caching);
   MINIT(cache_misses, block_cache_misses);
   MINIT(cache_misses_caching, block_cache_misses_caching);
+  MINIT(probationary_segment_hits, block_cache_probationary_segment_hits);
+  MINIT(protected_segment_hits, block_cache_protected_segment_hits);
   GINIT(cache_usage, block_cache_usage);
 }
 #undef MINIT
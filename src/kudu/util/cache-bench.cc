@@ -68,6 +68,8 @@ struct BenchSetup {
   };
   Pattern pattern;
 
+  Cache::EvictionPolicy eviction_policy;
+
   // The ratio between the size of the dataset and the cache.
   //
   // A value smaller than 1 will ensure that the whole dataset fits
@@ -80,6 +82,11 @@ struct BenchSetup {
       case Pattern::ZIPFIAN: ret += "ZIPFIAN"; break;
       case Pattern::UNIFORM: ret += "UNIFORM"; break;
     }
+    switch (eviction_policy) {
+      case Cache::EvictionPolicy::FIFO: ret += " FIFO"; break;
+      case Cache::EvictionPolicy::LRU: ret += " LRU"; break;
+      case Cache::EvictionPolicy::SLRU: ret += " SLRU"; break;
+    }
     ret += StringPrintf(" ratio=%.2fx n_unique=%d", dataset_cache_ratio, max_key());
     return ret;
   }
@@ -95,7 +102,20 @@ class CacheBench : public KuduTest,
  public:
   void SetUp() override {
     KuduTest::SetUp();
-    cache_.reset(NewCache(kCacheCapacity, "test-cache"));
+    switch (GetParam().eviction_policy) {
+      case Cache::EvictionPolicy::FIFO:
+        cache_.reset(NewCache<Cache::EvictionPolicy::FIFO, Cache::MemoryType::DRAM>(
+            kCacheCapacity, "test-cache"));
+        break;
+      case Cache::EvictionPolicy::LRU:
+        cache_.reset(NewCache<Cache::EvictionPolicy::LRU, Cache::MemoryType::DRAM>(
+            kCacheCapacity, "test-cache"));
+        break;
+      case Cache::EvictionPolicy::SLRU:
+        cache_.reset(NewCache<Cache::EvictionPolicy::SLRU, Cache::MemoryType::DRAM>(
+            kCacheCapacity, "test-cache"));
+        break;
+    }
   }
 
   // Run queries against the cache until '*done' becomes true.
@@ -155,12 +175,18 @@ class CacheBench : public KuduTest,
 };
 
 // Test both distributions, and for each, test both the case where the data
-// fits in the cache and where it is a bit larger.
+// fits in the cache and where it is a bit larger. The hit-heavy cases show
+// the throughput of the concurrent lookup path, which doesn't take the shards'
+// locks exclusively; run with a higher --num_threads to measure its scaling.
 INSTANTIATE_TEST_CASE_P(Patterns, CacheBench, testing::ValuesIn(std::vector<BenchSetup>{
-      {BenchSetup::Pattern::ZIPFIAN, 1.0},
-      {BenchSetup::Pattern::ZIPFIAN, 3.0},
-      {BenchSetup::Pattern::UNIFORM, 1.0},
-      {BenchSetup::Pattern::UNIFORM, 3.0}
+      {BenchSetup::Pattern::ZIPFIAN, Cache::EvictionPolicy::LRU, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN, Cache::EvictionPolicy::LRU, 3.0},
+      {BenchSetup::Pattern::UNIFORM, Cache::EvictionPolicy::LRU, 1.0},
+      {BenchSetup::Pattern::UNIFORM, Cache::EvictionPolicy::LRU, 3.0},
+      {BenchSetup::Pattern::ZIPFIAN, Cache::EvictionPolicy::SLRU, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN, Cache::EvictionPolicy::SLRU, 3.0},
+      {BenchSetup::Pattern::UNIFORM, Cache::EvictionPolicy::SLRU, 1.0},
+      {BenchSetup::Pattern::UNIFORM, Cache::EvictionPolicy::SLRU, 3.0}
     }));
 
 TEST_P(CacheBench, RunBench) {
@@ -8,6 +8,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -36,6 +37,7 @@ DECLARE_string(nvm_cache_path);
 DECLARE_double(cache_memtracker_approximation_ratio);
 
 using std::make_tuple;
+using std::thread;
 using std::tuple;
 using std::shared_ptr;
 using std::unique_ptr;
@@ -145,6 +147,15 @@ class CacheBaseTest : public KuduTest,
         }
         MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
         break;
+      case Cache::EvictionPolicy::SLRU:
+        if (mem_type != Cache::MemoryType::DRAM) {
+          FAIL() << "SLRU cache can only be of DRAM type";
+        }
+        cache_.reset(NewCache<Cache::EvictionPolicy::SLRU,
+                              Cache::MemoryType::DRAM>(cache_size(),
+                                                       "cache_test"));
+        MemTracker::FindTracker("cache_test-sharded_slru_cache", &mem_tracker_);
+        break;
       default:
         FAIL() << "unrecognized cache eviction policy";
         break;
@@ -207,6 +218,12 @@ INSTANTIATE_TEST_CASE_P(
         make_tuple(Cache::MemoryType::DRAM,
                    Cache::EvictionPolicy::LRU,
                    ShardingPolicy::SingleShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::SLRU,
+                   ShardingPolicy::MultiShard),
+        make_tuple(Cache::MemoryType::DRAM,
+                   Cache::EvictionPolicy::SLRU,
+                   ShardingPolicy::SingleShard),
         make_tuple(Cache::MemoryType::NVM,
                    Cache::EvictionPolicy::LRU,
                    ShardingPolicy::MultiShard),
@@ -423,6 +440,39 @@ TEST_P(CacheTest, InvalidateOddKeyEntries) {
   }
 }
 
+// Lookups don't take the shards' locks exclusively: make sure they're safe
+// while other threads insert entries and evict the ones being looked up.
+TEST_P(CacheTest, ConcurrentLookupsAndInserts) {
+  RETURN_IF_NO_NVM_CACHE(std::get<0>(GetParam()));
+  constexpr const int kNumThreads = 8;
+  constexpr const int kNumKeys = 1024;
+  // Only about half of the keys fit into the cache.
+  const int charge = cache_size() / (kNumKeys / 2);
+
+  vector<thread> threads;
+  for (auto t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (auto i = 0; i < 10 * kNumKeys; ++i) {
+        const int key = (i * (t + 1)) % kNumKeys;
+        const std::string key_str = EncodeInt(key);
+        auto handle(cache_->Lookup(key_str, Cache::EXPECT_IN_CACHE));
+        if (handle) {
+          CHECK_EQ(key, DecodeInt(cache_->Value(handle)));
+          continue;
+        }
+        // The eviction callback isn't thread-safe, so don't pass it here.
+        auto pending(cache_->Allocate(key_str, key_str.size(), charge));
+        CHECK(pending);
+        memcpy(cache_->MutableValue(&pending), key_str.data(), key_str.size());
+        cache_->Insert(std::move(pending), nullptr);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
 // This class is dedicated for scenarios specific for FIFOCache.
 // The scenarios use a single-shard cache for simpler logic.
 class FIFOCacheTest : public CacheBaseTest {
@@ -532,4 +582,48 @@ TEST_P(LRUCacheTest, EvictionPolicy) {
   ASSERT_EQ(-1, Lookup(200));
 }
 
+// This class is dedicated for scenarios specific for SLRU cache.
+// The scenarios use a single-shard cache for simpler logic.
+class SLRUCacheTest : public CacheBaseTest {
+ public:
+  SLRUCacheTest()
+      : CacheBaseTest(10 * 1024) {
+  }
+
+  void SetUp() override {
+    SetupWithParameters(Cache::MemoryType::DRAM,
+                        Cache::EvictionPolicy::SLRU,
+                        ShardingPolicy::SingleShard);
+  }
+};
+
+// Verify that a scan of entries looked up at most once doesn't evict
+// the entries which are looked up repeatedly, unlike with an LRU cache.
+TEST_F(SLRUCacheTest, ScanResistance) {
+  static constexpr int kNumElems = 20;
+  static constexpr int kNumHotElems = kNumElems / 4;
+  const int size_per_elem = cache_size() / kNumElems;
+
+  // Insert the hot entries and look them up again, promoting them
+  // to the protected segment.
+  for (int i = 0; i < kNumHotElems; ++i) {
+    Insert(i, i, size_per_elem);
+    ASSERT_EQ(i, Lookup(i));
+  }
+
+  // Scan through many more entries than the cache can hold, without looking
+  // any of them up again, as a block cache does when scanning a large table.
+  for (int i = 0; i < 10 * kNumElems; ++i) {
+    Insert(1000 + i, 1000 + i, size_per_elem);
+  }
+  ASSERT_FALSE(evicted_keys_.empty());
+
+  // The entries of the scan are evicted, but not the hot ones.
+  for (int i = 0; i < kNumHotElems; ++i) {
+    SCOPED_TRACE(Substitute("hot element: index $0", i));
+    ASSERT_EQ(i, Lookup(i));
+  }
+  ASSERT_EQ(-1, Lookup(1000));
+}
+
 }  // namespace kudu
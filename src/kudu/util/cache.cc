@@ -7,6 +7,7 @@
 #include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <initializer_list>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -45,6 +46,12 @@ DEFINE_double(cache_memtracker_approximation_ratio, 0.01,
               "this ratio to improve performance. For tests.");
 TAG_FLAG(cache_memtracker_approximation_ratio, hidden);
 
+DEFINE_double(cache_slru_protected_ratio, 0.8,
+              "The fraction of the capacity of a segmented LRU cache which is "
+              "reserved for the protected segment, i.e. the items looked up "
+              "again after they were inserted.");
+TAG_FLAG(cache_slru_protected_ratio, advanced);
+
 using std::atomic;
 using std::shared_ptr;
 using std::string;
@@ -83,6 +90,10 @@ struct RLHandle {
   uint32_t val_length;
   std::atomic<int32_t> refs;
   uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  bool in_protected_segment;  // Only used by the SLRU policy
+  // Set by lookups, which only hold the shard's lock in shared mode, instead
+  // of reordering the recency list; consumed when choosing the entry to evict.
+  std::atomic<bool> referenced;
 
   // The storage for the key/value pair itself. The data is stored as:
   //   [key bytes ...] [padding up to 8-byte boundary] [value bytes ...]
@@ -198,6 +209,8 @@ string ToString(Cache::EvictionPolicy p) {
       return "fifo";
     case Cache::EvictionPolicy::LRU:
       return "lru";
+    case Cache::EvictionPolicy::SLRU:
+      return "slru";
     default:
       LOG(FATAL) << "unexpected cache eviction policy: " << static_cast<int>(p);
       break;
@@ -215,6 +228,7 @@ class CacheShard {
   // Separate from constructor so caller can easily make an array of CacheShard
   void SetCapacity(size_t capacity) {
     capacity_ = capacity;
+    protected_capacity_ = capacity * FLAGS_cache_slru_protected_ratio;
     max_deferred_consumption_ = capacity * FLAGS_cache_memtracker_approximation_ratio;
   }
 
@@ -230,8 +244,20 @@ class CacheShard {
  private:
   void RL_Remove(RLHandle* e);
   void RL_Append(RLHandle* e);
-  // Update the recency list after a lookup operation.
-  void RL_UpdateAfterLookup(RLHandle* e);
+  // Make 'e' the newest entry of the protected segment (SLRU policy only).
+  void RL_AppendProtected(RLHandle* e);
+  // Record a lookup of 'e'. Called with 'mutex_' held in shared mode only,
+  // so it mustn't change the recency list.
+  void RL_MarkReferenced(RLHandle* e);
+  // Return the entry to evict next, or nullptr if the cache is empty. An entry
+  // which was looked up since it was last considered gets a second chance:
+  // it's moved to the newest position (or promoted to the protected segment
+  // with the SLRU policy) instead of being evicted.
+  RLHandle* RL_NextToEvict();
+  // Demote the oldest entries of the protected segment to the probationary
+  // segment until the protected segment fits its capacity, never demoting
+  // 'promoted' (SLRU policy only).
+  void RL_ShrinkProtected(const RLHandle* promoted);
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(RLHandle* e);
@@ -264,15 +290,22 @@ class CacheShard {
 
   // Initialized before use.
   size_t capacity_;
+  size_t protected_capacity_;
 
-  // mutex_ protects the following state.
-  simple_spinlock mutex_;
+  // mutex_ protects the following state. Lookups only take it in shared mode.
+  rw_spinlock mutex_;
   size_t usage_;
 
   // Dummy head of recency list.
   // rl.prev is newest entry, rl.next is oldest entry.
+  // With the SLRU policy, this is the probationary segment.
   RLHandle rl_;
 
+  // Dummy head of the recency list of the protected segment, and the total
+  // charge of its entries. Empty unless the policy is SLRU.
+  RLHandle protected_rl_;
+  size_t protected_usage_;
+
   HandleTable table_;
 
   MemTracker* mem_tracker_;
@@ -288,23 +321,28 @@ class CacheShard {
 template<Cache::EvictionPolicy policy>
 CacheShard<policy>::CacheShard(MemTracker* tracker)
     : usage_(0),
+      protected_usage_(0),
       mem_tracker_(tracker),
       metrics_(nullptr) {
-  // Make empty circular linked list.
+  // Make empty circular linked lists.
   rl_.next = &rl_;
   rl_.prev = &rl_;
+  protected_rl_.next = &protected_rl_;
+  protected_rl_.prev = &protected_rl_;
 }
 
 template<Cache::EvictionPolicy policy>
 CacheShard<policy>::~CacheShard() {
-  for (RLHandle* e = rl_.next; e != &rl_; ) {
-    RLHandle* next = e->next;
-    DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
-        << "caller has an unreleased handle";
-    if (Unref(e)) {
-      FreeEntry(e);
+  for (RLHandle* head : { &rl_, &protected_rl_ }) {
+    for (RLHandle* e = head->next; e != head; ) {
+      RLHandle* next = e->next;
+      DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
+          << "caller has an unreleased handle";
+      if (Unref(e)) {
+        FreeEntry(e);
+      }
+      e = next;
     }
-    e = next;
   }
   mem_tracker_->Consume(deferred_consumption_);
 }
@@ -367,6 +405,11 @@ void CacheShard<policy>::RL_Remove(RLHandle* e) {
   e->prev->next = e->next;
   DCHECK_GE(usage_, e->charge);
   usage_ -= e->charge;
+  if (e->in_protected_segment) {
+    DCHECK_GE(protected_usage_, e->charge);
+    protected_usage_ -= e->charge;
+    e->in_protected_segment = false;
+  }
 }
 
 template<Cache::EvictionPolicy policy>
@@ -379,14 +422,83 @@ void CacheShard<policy>::RL_Append(RLHandle* e) {
   usage_ += e->charge;
 }
 
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::RL_AppendProtected(RLHandle* e) {
+  e->next = &protected_rl_;
+  e->prev = protected_rl_.prev;
+  e->prev->next = e;
+  e->next->prev = e;
+  usage_ += e->charge;
+  protected_usage_ += e->charge;
+  e->in_protected_segment = true;
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::RL_MarkReferenced(RLHandle* e) {
+  // Avoid dirtying the cache line of an entry which is already marked.
+  if (!e->referenced.load(std::memory_order_relaxed)) {
+    e->referenced.store(true, std::memory_order_relaxed);
+  }
+}
+
 template<>
-void CacheShard<Cache::EvictionPolicy::FIFO>::RL_UpdateAfterLookup(RLHandle* /* e */) {
+void CacheShard<Cache::EvictionPolicy::FIFO>::RL_MarkReferenced(RLHandle* /* e */) {
+}
+
+template<Cache::EvictionPolicy policy>
+void CacheShard<policy>::RL_ShrinkProtected(const RLHandle* promoted) {
+  while (protected_usage_ > protected_capacity_ && protected_rl_.next != promoted) {
+    RLHandle* old = protected_rl_.next;
+    RL_Remove(old);
+    if (old->referenced.exchange(false, std::memory_order_relaxed)) {
+      RL_AppendProtected(old);
+    } else {
+      RL_Append(old);
+    }
+  }
 }
 
 template<>
-void CacheShard<Cache::EvictionPolicy::LRU>::RL_UpdateAfterLookup(RLHandle* e) {
-  RL_Remove(e);
-  RL_Append(e);
+RLHandle* CacheShard<Cache::EvictionPolicy::FIFO>::RL_NextToEvict() {
+  return rl_.next != &rl_ ? rl_.next : nullptr;
+}
+
+template<>
+RLHandle* CacheShard<Cache::EvictionPolicy::LRU>::RL_NextToEvict() {
+  // Lookups can't set the 'referenced' bits while 'mutex_' is held
+  // exclusively, so this loop moves every entry at most once.
+  while (rl_.next != &rl_) {
+    RLHandle* e = rl_.next;
+    if (!e->referenced.exchange(false, std::memory_order_relaxed)) {
+      return e;
+    }
+    RL_Remove(e);
+    RL_Append(e);
+  }
+  return nullptr;
+}
+
+template<>
+RLHandle* CacheShard<Cache::EvictionPolicy::SLRU>::RL_NextToEvict() {
+  while (rl_.next != &rl_) {
+    RLHandle* e = rl_.next;
+    if (!e->referenced.exchange(false, std::memory_order_relaxed)) {
+      return e;
+    }
+    RL_Remove(e);
+    RL_AppendProtected(e);
+    RL_ShrinkProtected(e);
+  }
+  // Only protected entries are left.
+  while (protected_rl_.next != &protected_rl_) {
+    RLHandle* e = protected_rl_.next;
+    if (!e->referenced.exchange(false, std::memory_order_relaxed)) {
+      return e;
+    }
+    RL_Remove(e);
+    RL_AppendProtected(e);
+  }
+  return nullptr;
 }
 
 template<Cache::EvictionPolicy policy>
@@ -394,17 +506,26 @@ Cache::Handle* CacheShard<policy>::Lookup(const Slice& key,
                                           uint32_t hash,
                                           bool caching) {
   RLHandle* e;
+  bool protected_hit = false;
   {
-    std::lock_guard<decltype(mutex_)> l(mutex_);
+    shared_lock<decltype(mutex_)> l(mutex_);
     e = table_.Lookup(key, hash);
     if (e != nullptr) {
       e->refs.fetch_add(1, std::memory_order_relaxed);
-      RL_UpdateAfterLookup(e);
+      protected_hit = e->in_protected_segment;
+      RL_MarkReferenced(e);
     }
   }
 
   // Do the metrics outside of the lock.
   UpdateMetricsLookup(e != nullptr, caching);
+  if (policy == Cache::EvictionPolicy::SLRU && e != nullptr && PREDICT_TRUE(metrics_)) {
+    const auto& segment_hits = protected_hit ? metrics_->protected_segment_hits
+                                             : metrics_->probationary_segment_hits;
+    if (segment_hits) {
+      segment_hits->Increment();
+    }
+  }
 
   return reinterpret_cast<Cache::Handle*>(e);
 }
@@ -425,6 +546,8 @@ Cache::Handle* CacheShard<policy>::Insert(
   // Set the remaining RLHandle members which were not already allocated during
   // Allocate().
   handle->eviction_callback = eviction_callback;
+  handle->in_protected_segment = false;
+  handle->referenced.store(false, std::memory_order_relaxed);
   // Two refs for the handle: one from CacheShard, one for the returned handle.
   handle->refs.store(2, std::memory_order_relaxed);
   UpdateMemTracker(handle->charge);
@@ -448,8 +571,11 @@ Cache::Handle* CacheShard<policy>::Insert(
       }
     }
 
-    while (usage_ > capacity_ && rl_.next != &rl_) {
-      RLHandle* old = rl_.next;
+    while (usage_ > capacity_) {
+      RLHandle* old = RL_NextToEvict();
+      if (old == nullptr) {
+        break;
+      }
       RL_Remove(old);
       table_.Remove(old->key(), old->hash);
       if (Unref(old)) {
@@ -499,27 +625,31 @@ size_t CacheShard<policy>::Invalidate(const Cache::InvalidationControl& ctl) {
     std::lock_guard<decltype(mutex_)> l(mutex_);
 
     // rl_.next is the oldest (a.k.a. least relevant) entry in the recency list.
-    RLHandle* h = rl_.next;
-    while (h != nullptr && h != &rl_ &&
-           ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
-      if (ctl.validity_func(h->key(), h->value())) {
-        // Continue iterating over the list.
+    // With the SLRU policy, the probationary segment's entries are less
+    // relevant than the protected segment's ones.
+    for (RLHandle* head : { &rl_, &protected_rl_ }) {
+      RLHandle* h = head->next;
+      while (h != nullptr && h != head &&
+             ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
+        if (ctl.validity_func(h->key(), h->value())) {
+          // Continue iterating over the list.
+          h = h->next;
+          ++valid_entry_count;
+          continue;
+        }
+        // Copy the handle slated for removal.
+        RLHandle* h_to_remove = h;
+        // Prepare for next iteration of the cycle.
         h = h->next;
-        ++valid_entry_count;
-        continue;
-      }
-      // Copy the handle slated for removal.
-      RLHandle* h_to_remove = h;
-      // Prepare for next iteration of the cycle.
-      h = h->next;
-
-      RL_Remove(h_to_remove);
-      table_.Remove(h_to_remove->key(), h_to_remove->hash);
-      if (Unref(h_to_remove)) {
-        h_to_remove->next = to_remove_head;
-        to_remove_head = h_to_remove;
+
+        RL_Remove(h_to_remove);
+        table_.Remove(h_to_remove->key(), h_to_remove->hash);
+        if (Unref(h_to_remove)) {
+          h_to_remove->next = to_remove_head;
+          to_remove_head = h_to_remove;
+        }
+        ++invalid_entry_count;
       }
-      ++invalid_entry_count;
     }
   }
   // Once removed from the lookup table and the recency list, the entries
@@ -693,6 +823,12 @@ Cache* NewCache<Cache::EvictionPolicy::LRU,
   return new ShardedCache<Cache::EvictionPolicy::LRU>(capacity, id);
 }
 
+template<>
+Cache* NewCache<Cache::EvictionPolicy::SLRU,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id) {
+  return new ShardedCache<Cache::EvictionPolicy::SLRU>(capacity, id);
+}
+
 std::ostream& operator<<(std::ostream& os, Cache::MemoryType mem_type) {
   switch (mem_type) {
     case Cache::MemoryType::DRAM:
@@ -47,8 +47,17 @@ class Cache {
     // The earliest added items are evicted (a.k.a. queue).
     FIFO,
 
-    // The least-recently-used items are evicted.
+    // The least-recently-used items are evicted. The DRAM implementation
+    // approximates the recency order with CLOCK-style reference bits, so
+    // lookups don't need exclusive access to the cache.
     LRU,
+
+    // Segmented LRU: newly inserted items enter a probationary segment and
+    // are promoted to a protected segment when looked up again. The
+    // least-recently-used items of the probationary segment are evicted
+    // first, so a burst of items looked up only once (e.g., a scan) doesn't
+    // evict the items which are looked up repeatedly.
+    SLRU,
   };
 
   // Callback interface which is called when an entry is evicted from the
@@ -357,6 +366,13 @@ template<>
 Cache* NewCache<Cache::EvictionPolicy::LRU,
                 Cache::MemoryType::DRAM>(size_t capacity, const std::string& id);
 
+// Create a new segmented LRU cache with a fixed size capacity. This
+// implementation of Cache uses the segmented least-recently-used eviction
+// policy and stored in DRAM.
+template<>
+Cache* NewCache<Cache::EvictionPolicy::SLRU,
+                Cache::MemoryType::DRAM>(size_t capacity, const std::string& id);
+
 // A helper method to output cache memory type into ostream.
 std::ostream& operator<<(std::ostream& os, Cache::MemoryType mem_type);
 
@@ -35,6 +35,11 @@ struct CacheMetrics {
   scoped_refptr<Counter> cache_misses;
   scoped_refptr<Counter> cache_misses_caching;
 
+  // Hits in the probationary and protected segments of a segmented LRU
+  // cache. May be null.
+  scoped_refptr<Counter> probationary_segment_hits;
+  scoped_refptr<Counter> protected_segment_hits;
+
   scoped_refptr<AtomicGauge<uint64_t>> cache_usage;
 };
 
@@ -30,9 +30,11 @@
 
 #include "kudu/util/compression/compression.pb.h"
 #include "kudu/util/compression/compression_codec.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -153,6 +155,107 @@ TEST_F(TestCompression, TestSnappyCompressionCodec) {
   }
 }
 
+// Compress data resembling the training samples with a trained dictionary,
+// and check that it round-trips and compresses better than without.
+static void TestCompressionCodecWithDictionary(CompressionType compression) {
+  const CompressionCodec* codec;
+  ASSERT_OK(GetCompressionCodec(compression, &codec));
+  ASSERT_TRUE(codec->SupportsDictionary());
+
+  // Samples and input share a vocabulary, but the input is too short to
+  // compress well on its own.
+  Random random(SeedRandom());
+  vector<string> words;
+  for (int i = 0; i < 64; i++) {
+    words.emplace_back(RandomString(24, &random));
+  }
+  string sample;
+  for (int i = 0; i < 4096; i++) {
+    sample.append(words[random.Uniform(words.size())]);
+  }
+  string input;
+  for (const string& word : words) {
+    input.append(word);
+  }
+
+  faststring dict;
+  TrainCompressionDictionary({ Slice(sample) }, 4096, &dict);
+  ASSERT_GT(dict.size(), 0);
+  ASSERT_LE(dict.size(), 4096);
+
+  size_t max_compressed = codec->MaxCompressedLength(input.size());
+  unique_ptr<uint8_t[]> cbuffer(new uint8_t[max_compressed]);
+  string ubuffer(input.size(), '\0');
+  size_t compressed;
+  size_t compressed_with_dict;
+
+  // Split the input to exercise multiple slices.
+  vector<Slice> islices = { Slice(input.data(), 100),
+                            Slice(input.data() + 100, input.size() - 100) };
+  ASSERT_OK(codec->Compress(islices, cbuffer.get(), &compressed));
+  ASSERT_OK(codec->CompressWithDictionary(islices, Slice(dict), cbuffer.get(),
+                                          &compressed_with_dict));
+  ASSERT_LE(compressed_with_dict, max_compressed);
+  ASSERT_OK(codec->UncompressWithDictionary(Slice(cbuffer.get(), compressed_with_dict),
+                                            Slice(dict),
+                                            reinterpret_cast<uint8_t*>(&ubuffer[0]),
+                                            ubuffer.size()));
+  ASSERT_EQ(input, ubuffer);
+  LOG(INFO) << CompressionType_Name(compression) << ": " << input.size() << " bytes compressed to "
+            << compressed << " bytes, " << compressed_with_dict << " bytes with a dictionary";
+  ASSERT_LT(compressed_with_dict, compressed);
+
+  // Uncompressing with the wrong dictionary must not produce the input.
+  ubuffer.assign(input.size(), '\0');
+  Status s = codec->UncompressWithDictionary(Slice(cbuffer.get(), compressed_with_dict),
+                                             Slice(sample.data(), dict.size()),
+                                             reinterpret_cast<uint8_t*>(&ubuffer[0]),
+                                             ubuffer.size());
+  ASSERT_TRUE(!s.ok() || input != ubuffer);
+}
+
+TEST_F(TestCompression, TestCompressionWithDictionary) {
+  for (auto type : { LZ4, ZLIB }) {
+    NO_FATALS(TestCompressionCodecWithDictionary(type));
+  }
+
+  const CompressionCodec* codec;
+  ASSERT_OK(GetCompressionCodec(SNAPPY, &codec));
+  ASSERT_FALSE(codec->SupportsDictionary());
+  uint8_t buf[64];
+  size_t compressed;
+  Status s = codec->CompressWithDictionary({ Slice("abc") }, Slice("abc"), buf, &compressed);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+}
+
+TEST_F(TestCompression, TestTrainCompressionDictionary) {
+  faststring dict;
+
+  // Nothing to learn from data without repetitions.
+  string unique_data;
+  for (int i = 0; i < 256; i++) {
+    unique_data.push_back(static_cast<char>(i));
+  }
+  TrainCompressionDictionary({ Slice(unique_data) }, 1024, &dict);
+  ASSERT_EQ(0, dict.size());
+
+  // A repeated phrase is stored once, however many times it occurs.
+  const string kPhrase = "the quick brown fox jumps over the lazy dog!";
+  string repeated;
+  for (int i = 0; i < 100; i++) {
+    repeated.append(kPhrase);
+    repeated.append(unique_data.substr(i, 8));
+  }
+  TrainCompressionDictionary({ Slice(repeated) }, 1024, &dict);
+  ASSERT_GT(dict.size(), 0);
+  ASSERT_LT(dict.size(), 2 * kPhrase.size());
+  ASSERT_NE(string::npos, dict.ToString().find(kPhrase.substr(0, 32)));
+
+  // The dictionary is truncated to the maximum size.
+  TrainCompressionDictionary({ Slice(repeated) }, 20, &dict);
+  ASSERT_EQ(20, dict.size());
+}
+
 TEST_F(TestCompression, TestSimpleBenchmark) {
   Random r(SeedRandom());
   for (auto type : { SNAPPY, LZ4, ZLIB }) {
@@ -17,8 +17,12 @@
 
 #include "kudu/util/compression/compression_codec.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
@@ -31,11 +35,15 @@
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/util/faststring.h"
+#include "kudu/util/hash_util.h"
 #include "kudu/util/logging.h"
+#include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/string_case.h"
 
 namespace kudu {
 
+using std::unique_ptr;
+using std::unordered_map;
 using std::vector;
 
 CompressionCodec::CompressionCodec() {
@@ -43,6 +51,22 @@ CompressionCodec::CompressionCodec() {
 CompressionCodec::~CompressionCodec() {
 }
 
+Status CompressionCodec::CompressWithDictionary(const vector<Slice>& /*input_slices*/,
+                                                const Slice& /*dict*/,
+                                                uint8_t* /*compressed*/,
+                                                size_t* /*compressed_length*/) const {
+  return Status::NotSupported("compression codec does not support dictionaries",
+                              CompressionType_Name(type()));
+}
+
+Status CompressionCodec::UncompressWithDictionary(const Slice& /*compressed*/,
+                                                  const Slice& /*dict*/,
+                                                  uint8_t* /*uncompressed*/,
+                                                  size_t /*uncompressed_length*/) const {
+  return Status::NotSupported("compression codec does not support dictionaries",
+                              CompressionType_Name(type()));
+}
+
 class SlicesSource : public snappy::Source {
  public:
   explicit SlicesSource(const std::vector<Slice>& slices)
@@ -195,6 +219,61 @@ class Lz4Codec : public CompressionCodec {
   CompressionType type() const override {
     return LZ4;
   }
+
+  bool SupportsDictionary() const override {
+    return true;
+  }
+
+  Status CompressWithDictionary(const vector<Slice>& input_slices,
+                                const Slice& dict,
+                                uint8_t* compressed,
+                                size_t* compressed_length) const override {
+    faststring buffer;
+    Slice input;
+    if (input_slices.size() == 1) {
+      input = input_slices[0];
+    } else {
+      SlicesSource source(input_slices);
+      source.Dump(&buffer);
+      input = Slice(buffer.data(), buffer.size());
+    }
+
+    unique_ptr<LZ4_stream_t, int(*)(LZ4_stream_t*)> stream(LZ4_createStream(),
+                                                            &LZ4_freeStream);
+    if (PREDICT_FALSE(!stream)) {
+      return Status::RuntimeError("unable to allocate an LZ4 stream");
+    }
+    // LZ4 only makes use of the last 64KB of the dictionary.
+    LZ4_loadDict(stream.get(), reinterpret_cast<const char*>(dict.data()), dict.size());
+    int n = LZ4_compress_fast_continue(stream.get(),
+                                       reinterpret_cast<const char*>(input.data()),
+                                       reinterpret_cast<char*>(compressed),
+                                       input.size(),
+                                       MaxCompressedLength(input.size()),
+                                       1 /* acceleration */);
+    if (PREDICT_FALSE(n <= 0)) {
+      return Status::IOError("unable to compress the buffer");
+    }
+    *compressed_length = n;
+    return Status::OK();
+  }
+
+  Status UncompressWithDictionary(const Slice& compressed,
+                                  const Slice& dict,
+                                  uint8_t* uncompressed,
+                                  size_t uncompressed_length) const override {
+    int n = LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(compressed.data()),
+                                          reinterpret_cast<char*>(uncompressed),
+                                          compressed.size(), uncompressed_length,
+                                          reinterpret_cast<const char*>(dict.data()),
+                                          dict.size());
+    if (n != uncompressed_length) {
+      return Status::Corruption(
+        StringPrintf("unable to uncompress the buffer. error near %d, buffer", -n),
+                     KUDU_REDACT(compressed.ToDebugString(100)));
+    }
+    return Status::OK();
+  }
 };
 
 /**
@@ -242,6 +321,85 @@ class ZlibCodec : public CompressionCodec {
   CompressionType type() const override {
     return ZLIB;
   }
+
+  bool SupportsDictionary() const override {
+    return true;
+  }
+
+  // Blocks compressed with a dictionary are written as raw deflate streams:
+  // the zlib wrapper would only add the dictionary id and a checksum, which
+  // are redundant with the CFile block checksums.
+  Status CompressWithDictionary(const vector<Slice>& input_slices,
+                                const Slice& dict,
+                                uint8_t* compressed,
+                                size_t* compressed_length) const override {
+    size_t input_size = 0;
+    for (const Slice& input : input_slices) {
+      input_size += input.size();
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // Same parameters as ::compress(), except for the negative window bits
+    // which select a raw deflate stream.
+    int err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                           8 /* memLevel */, Z_DEFAULT_STRATEGY);
+    if (PREDICT_FALSE(err != Z_OK)) {
+      return Status::IOError("unable to initialize the compression stream");
+    }
+    SCOPED_CLEANUP({ deflateEnd(&stream); });
+
+    err = deflateSetDictionary(&stream, dict.data(), dict.size());
+    if (PREDICT_FALSE(err != Z_OK)) {
+      return Status::IOError("unable to set the compression dictionary");
+    }
+
+    stream.next_out = compressed;
+    stream.avail_out = MaxCompressedLength(input_size);
+    for (const Slice& input : input_slices) {
+      stream.next_in = const_cast<uint8_t*>(input.data());
+      stream.avail_in = input.size();
+      err = deflate(&stream, Z_NO_FLUSH);
+      if (PREDICT_FALSE(err != Z_OK || stream.avail_in != 0)) {
+        return Status::IOError("unable to compress the buffer");
+      }
+    }
+    err = deflate(&stream, Z_FINISH);
+    if (PREDICT_FALSE(err != Z_STREAM_END)) {
+      return Status::IOError("unable to compress the buffer");
+    }
+    *compressed_length = stream.total_out;
+    return Status::OK();
+  }
+
+  Status UncompressWithDictionary(const Slice& compressed,
+                                  const Slice& dict,
+                                  uint8_t* uncompressed,
+                                  size_t uncompressed_length) const override {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    int err = inflateInit2(&stream, -MAX_WBITS);
+    if (PREDICT_FALSE(err != Z_OK)) {
+      return Status::RuntimeError("unable to initialize the decompression stream");
+    }
+    SCOPED_CLEANUP({ inflateEnd(&stream); });
+
+    // A raw inflate stream takes its dictionary before any input is processed.
+    err = inflateSetDictionary(&stream, dict.data(), dict.size());
+    if (PREDICT_FALSE(err != Z_OK)) {
+      return Status::Corruption("unable to set the decompression dictionary");
+    }
+
+    stream.next_in = const_cast<uint8_t*>(compressed.data());
+    stream.avail_in = compressed.size();
+    stream.next_out = uncompressed;
+    stream.avail_out = uncompressed_length;
+    err = inflate(&stream, Z_FINISH);
+    if (PREDICT_FALSE(err != Z_STREAM_END || stream.total_out != uncompressed_length)) {
+      return Status::Corruption("unable to uncompress the buffer");
+    }
+    return Status::OK();
+  }
 };
 
 Status GetCompressionCodec(CompressionType compression,
@@ -283,4 +441,124 @@ CompressionType GetCompressionCodecType(const std::string& name) {
   return NO_COMPRESSION;
 }
 
+namespace {
+
+// Length of the byte sequences counted by TrainCompressionDictionary(), and
+// the distance between the starts of two consecutive sequences of a sample.
+constexpr size_t kDictSegmentLength = 16;
+constexpr size_t kDictSegmentStride = 4;
+
+// The first occurrence of a segment and its number of occurrences.
+struct DictSegment {
+  size_t sample_idx;
+  size_t offset;
+  int count;
+};
+
+} // anonymous namespace
+
+void TrainCompressionDictionary(const vector<Slice>& samples,
+                                size_t max_size,
+                                faststring* dict) {
+  dict->clear();
+  if (max_size == 0) {
+    return;
+  }
+
+  // Count the occurrences of every segment of the samples.
+  unordered_map<uint64_t, DictSegment> segments;
+  for (size_t i = 0; i < samples.size(); i++) {
+    const Slice& sample = samples[i];
+    for (size_t off = 0; off + kDictSegmentLength <= sample.size(); off += kDictSegmentStride) {
+      const uint8_t* seg = sample.data() + off;
+      uint64_t hash = HashUtil::FastHash64(seg, kDictSegmentLength, 0);
+      auto ins = segments.emplace(hash, DictSegment{ i, off, 1 });
+      if (ins.second) {
+        continue;
+      }
+      // Segments with colliding hashes are rare enough that only the first
+      // one seen is tracked.
+      DictSegment* first = &ins.first->second;
+      if (memcmp(samples[first->sample_idx].data() + first->offset, seg,
+                 kDictSegmentLength) == 0) {
+        first->count++;
+      }
+    }
+  }
+
+  vector<DictSegment> candidates;
+  for (const auto& e : segments) {
+    if (e.second.count > 1) {
+      candidates.push_back(e.second);
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const DictSegment& a, const DictSegment& b) {
+              if (a.count != b.count) return a.count > b.count;
+              if (a.sample_idx != b.sample_idx) return a.sample_idx < b.sample_idx;
+              return a.offset < b.offset;
+            });
+
+  // Select the most frequent segments until the dictionary is full. Every
+  // byte of a sample is scored with the count of the most frequent selected
+  // segment covering it, so that overlapping segments are only stored once.
+  vector<vector<int>> scores(samples.size());
+  size_t selected_bytes = 0;
+  for (const DictSegment& c : candidates) {
+    if (selected_bytes >= max_size) {
+      break;
+    }
+    vector<int>& score = scores[c.sample_idx];
+    if (score.empty()) {
+      score.resize(samples[c.sample_idx].size());
+    }
+    for (size_t j = c.offset; j < c.offset + kDictSegmentLength; j++) {
+      if (score[j] == 0) {
+        score[j] = c.count;
+        selected_bytes++;
+      }
+    }
+  }
+
+  // Gather the contiguous runs of selected bytes.
+  struct Run {
+    const uint8_t* data;
+    size_t len;
+    int score;
+  };
+  vector<Run> runs;
+  for (size_t i = 0; i < samples.size(); i++) {
+    const vector<int>& score = scores[i];
+    size_t j = 0;
+    while (j < score.size()) {
+      if (score[j] == 0) {
+        j++;
+        continue;
+      }
+      size_t start = j;
+      int best = 0;
+      for (; j < score.size() && score[j] != 0; j++) {
+        best = std::max(best, score[j]);
+      }
+      runs.push_back({ samples[i].data() + start, j - start, best });
+    }
+  }
+
+  // Put the least frequent runs first: the codecs reference the end of the
+  // dictionary most cheaply, and the excess over 'max_size' is dropped from
+  // the front.
+  std::stable_sort(runs.begin(), runs.end(),
+                   [](const Run& a, const Run& b) { return a.score < b.score; });
+  size_t excess = selected_bytes > max_size ? selected_bytes - max_size : 0;
+  dict->reserve(selected_bytes - excess);
+  for (const Run& r : runs) {
+    size_t skip = std::min(excess, r.len);
+    excess -= skip;
+    dict->append(r.data + skip, r.len - skip);
+  }
+}
+
 } // namespace kudu
@@ -25,6 +25,7 @@
 #include <snappy-stubs-public.h>
 
 #include "kudu/util/compression/compression.pb.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
@@ -61,6 +62,30 @@ class CompressionCodec {
 
   // Return the type of compression implemented by this codec.
   virtual CompressionType type() const = 0;
+
+  // Returns true if the codec supports compressing with a preset dictionary,
+  // i.e. implements CompressWithDictionary() and UncompressWithDictionary().
+  virtual bool SupportsDictionary() const {
+    return false;
+  }
+
+  // Same as Compress(), but primes the codec with 'dict', which must also be
+  // passed to UncompressWithDictionary() to uncompress the result. The output
+  // is bounded by MaxCompressedLength() as well.
+  //
+  // Returns NotSupported if the codec does not support dictionaries.
+  virtual Status CompressWithDictionary(const std::vector<Slice>& input_slices,
+                                        const Slice& dict,
+                                        uint8_t* compressed,
+                                        size_t* compressed_length) const;
+
+  // Uncompresses data generated by CompressWithDictionary() with the same 'dict'.
+  //
+  // Returns NotSupported if the codec does not support dictionaries.
+  virtual Status UncompressWithDictionary(const Slice& compressed,
+                                          const Slice& dict,
+                                          uint8_t* uncompressed,
+                                          size_t uncompressed_length) const;
  private:
   DISALLOW_COPY_AND_ASSIGN(CompressionCodec);
 };
@@ -74,5 +99,16 @@ Status GetCompressionCodec(CompressionType compression,
 // Returns the compression codec type given the name
 CompressionType GetCompressionCodecType(const std::string& name);
 
+// Builds a dictionary of at most 'max_size' bytes out of the given samples,
+// suitable for CompressionCodec::CompressWithDictionary().
+//
+// The dictionary is made of the byte sequences which occur most frequently
+// across the samples, with the most frequent ones placed at the end, where
+// the LZ77-style codecs can reference them most cheaply. 'dict' is left
+// empty if the samples have no repeated content.
+void TrainCompressionDictionary(const std::vector<Slice>& samples,
+                                size_t max_size,
+                                faststring* dict);
+
 } // namespace kudu
 #endif
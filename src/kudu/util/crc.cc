@@ -31,8 +31,11 @@ static Crc* crc32c_instance = nullptr;
 
 static void InitCrc32cInstance() {
   ScopedLeakCheckDisabler disabler; // CRC instance is never freed.
-  // TODO: Is initial = 0 and roll window = 4 appropriate for all cases?
-  crc32c_instance = crcutil_interface::CRC::CreateCrc32c(true, 0, 4, nullptr);
+  // Use the SSE4.2 CRC32 instruction when the CPU supports it. crcutil
+  // interleaves several streams of it over large buffers.
+  crc32c_instance = crcutil_interface::CRC::CreateCrc32c(
+      /*backward_compatible=*/true, /*roll_window_bytes=*/0, /*use_sse4_2=*/true,
+      /*allocated_memory=*/nullptr);
 }
 
 Crc* GetCrc32cInstance() {
@@ -968,6 +968,39 @@ TEST_F(TestEnv, TestRWFile) {
   ASSERT_EQ(kTestData.length(), sz);
 }
 
+// Direct reads at offsets and lengths which aren't aligned should return the
+// same data as buffered reads, whether or not the filesystem supports them.
+TEST_F(TestEnv, TestRWFileReadVDirect) {
+  unique_ptr<RWFile> file;
+  ASSERT_OK(env_->NewRWFile(GetTestPath("foo"), &file));
+  const size_t kFileSize = 3 * 4096 + 123;
+  string data(kFileSize, '\0');
+  for (size_t i = 0; i < kFileSize; i++) {
+    data[i] = static_cast<char>(i % 251);
+  }
+  ASSERT_OK(file->Write(0, data));
+  ASSERT_OK(file->Sync());
+
+  for (const auto& range : vector<pair<size_t, size_t>>{
+      { 0, 1 }, { 1, 4096 }, { 4095, 2 }, { 4096, 4096 },
+      { 5000, 6000 }, { kFileSize - 10, 10 }, { 0, kFileSize } }) {
+    SCOPED_TRACE(Substitute("offset $0, length $1", range.first, range.second));
+    const size_t size1 = range.second / 2;
+    const size_t size2 = range.second - size1;
+    unique_ptr<uint8_t[]> scratch(new uint8_t[range.second]);
+    vector<Slice> results = { Slice(scratch.get(), size1),
+                              Slice(scratch.get() + size1, size2) };
+    ASSERT_OK(file->ReadVDirect(range.first, results));
+    ASSERT_EQ(data.substr(range.first, range.second),
+              Slice(scratch.get(), range.second).ToString());
+  }
+
+  // Reading past the end of the file fails.
+  uint8_t scratch[10];
+  Slice result(scratch, sizeof(scratch));
+  ASSERT_TRUE(file->ReadVDirect(kFileSize - 5, ArrayView<Slice>(&result, 1)).IsEndOfFile());
+}
+
 TEST_F(TestEnv, TestCanonicalize) {
   vector<string> synonyms = { GetTestPath("."), GetTestPath("./."), GetTestPath(".//./") };
   for (const string& synonym : synonyms) {
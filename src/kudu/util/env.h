@@ -599,12 +599,30 @@ class RWFile : public File {
   // Safe for concurrent use by multiple threads.
   virtual Status ReadV(uint64_t offset, ArrayView<Slice> results) const = 0;
 
+  // Like ReadV(), but bypasses the operating system's page cache, so that
+  // data which the caller caches itself isn't cached twice. The offset and
+  // lengths needn't be aligned. Falls back to ReadV() if the platform or the
+  // filesystem doesn't support direct I/O.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadVDirect(uint64_t offset, ArrayView<Slice> results) const = 0;
+
+  // Hints that 'length' bytes of the file beginning at 'offset' will be read
+  // soon, so that the operating system can read them into its page cache in
+  // the background. Does nothing on platforms without such hints.
+  virtual Status ReadAhead(uint64_t offset, size_t length) const = 0;
+
   // Writes 'data' to the file position given by 'offset'.
   virtual Status Write(uint64_t offset, const Slice& data) = 0;
 
   // Writes the 'data' slices to the file position given by 'offset'.
   virtual Status WriteV(uint64_t offset, ArrayView<const Slice> data) = 0;
 
+  // Like WriteV(), but also makes the written data durable before returning,
+  // with the same system call where the platform supports it. Unlike Sync(),
+  // data written by earlier calls isn't necessarily made durable.
+  virtual Status WriteVAndSync(uint64_t offset, ArrayView<const Slice> data) = 0;
+
   // Preallocates 'length' bytes for the file in the underlying filesystem
   // beginning at 'offset'. It is safe to preallocate the same range
   // repeatedly; this is an idempotent operation.
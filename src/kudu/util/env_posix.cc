@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <climits>
 #include <cstddef>
@@ -48,6 +49,7 @@
 #include "kudu/gutil/strings/split.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/strings/util.h"
+#include "kudu/util/alignment.h"
 #include "kudu/util/array_view.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
@@ -455,7 +457,68 @@ Status DoReadV(int fd, const string& filename, uint64_t offset,
   return Status::OK();
 }
 
-Status DoWriteV(int fd, const string& filename, uint64_t offset, ArrayView<const Slice> data) {
+#if defined(__linux__)
+// The alignment of the offsets, lengths and buffers of direct reads. This is
+// a multiple of the logical block size of any device we expect to run on.
+const uint64_t kDirectIOAlignment = 4096;
+
+// Like DoReadV(), but for a file opened with O_DIRECT. The aligned range
+// enclosing the requested bytes is read into a bounce buffer, and the
+// requested bytes are copied out of it.
+Status DoReadVDirect(int fd, const string& filename, uint64_t offset,
+                     ArrayView<Slice> results) {
+  MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
+  ThreadRestrictions::AssertIOAllowed();
+
+  size_t bytes_req = 0;
+  for (const auto& result : results) {
+    bytes_req += result.size();
+  }
+  if (bytes_req == 0) {
+    return Status::OK();
+  }
+  const uint64_t start = KUDU_ALIGN_DOWN(offset, kDirectIOAlignment);
+  const uint64_t end = KUDU_ALIGN_UP(offset + bytes_req, kDirectIOAlignment);
+  const size_t buf_len = end - start;
+  void* buf_ptr;
+  int err = posix_memalign(&buf_ptr, kDirectIOAlignment, buf_len);
+  if (PREDICT_FALSE(err != 0)) {
+    return IOError(filename, err);
+  }
+  unique_ptr<uint8_t, FreeDeleter> buf(static_cast<uint8_t*>(buf_ptr));
+
+  // Only the bytes up to the end of the requested range are needed; the rest
+  // of the last aligned block may lie past the end of the file.
+  const size_t needed = offset + bytes_req - start;
+  size_t done = 0;
+  while (done < needed) {
+    ssize_t r;
+    RETRY_ON_EINTR(r, pread(fd, buf.get() + done, buf_len - done, start + done));
+    if (PREDICT_FALSE(r < 0)) {
+      return IOError(filename, errno);
+    }
+    // A short read that isn't aligned only happens at the end of the file.
+    if (PREDICT_FALSE(r == 0 ||
+                      (r % kDirectIOAlignment != 0 && done + r < needed))) {
+      return Status::EndOfFile(
+          Substitute("EOF trying to read $0 bytes at offset $1", bytes_req, offset));
+    }
+    done += r;
+  }
+
+  const uint8_t* src = buf.get() + (offset - start);
+  for (auto& result : results) {
+    memcpy(result.mutable_data(), src, result.size());
+    src += result.size();
+  }
+  return Status::OK();
+}
+#endif
+
+// Writes 'data' at 'offset'. If 'flags' is non-zero, they're passed to
+// pwritev2(); returns NotSupported if they aren't supported.
+Status DoWriteV(int fd, const string& filename, uint64_t offset, ArrayView<const Slice> data,
+                int flags = 0) {
   MAYBE_RETURN_EIO(filename, IOError(Env::kInjectedFailureStatusMsg, EIO));
   ThreadRestrictions::AssertIOAllowed();
 
@@ -477,7 +540,19 @@ Status DoWriteV(int fd, const string& filename, uint64_t offset, ArrayView<const
     // Never request more than IOV_MAX in one request.
     size_t iov_count = std::min(iov_size - completed_iov, static_cast<size_t>(IOV_MAX));
     ssize_t w;
+#if defined(RWF_DSYNC)
+    if (flags != 0) {
+      RETRY_ON_EINTR(w, pwritev2(fd, iov + completed_iov, iov_count, cur_offset, flags));
+      if (PREDICT_FALSE(w < 0 && (errno == EOPNOTSUPP || errno == ENOSYS))) {
+        return Status::NotSupported("pwritev2 flags not supported", filename);
+      }
+    } else {
+      RETRY_ON_EINTR(w, pwritev(fd, iov + completed_iov, iov_count, cur_offset));
+    }
+#else
+    DCHECK_EQ(0, flags);
     RETRY_ON_EINTR(w, pwritev(fd, iov + completed_iov, iov_count, cur_offset));
+#endif
 
     // Fake a short write for testing.
     if (PREDICT_FALSE(FLAGS_env_inject_short_write_bytes > 0 && rem == bytes_req)) {
@@ -518,6 +593,29 @@ Status DoWriteV(int fd, const string& filename, uint64_t offset, ArrayView<const
   return Status::OK();
 }
 
+// Like DoWriteV() followed by DoSync(), but writes and syncs the data with a
+// single system call where the platform supports it. Unlike DoSync(), this
+// only makes the data written by this call durable.
+Status DoWriteVAndSync(int fd, const string& filename, uint64_t offset,
+                       ArrayView<const Slice> data) {
+#if defined(RWF_DSYNC)
+  // Whether the kernel supports per-write sync flags; assumed until proven
+  // otherwise.
+  static std::atomic<bool> sync_flags_supported(true);
+  if (!FLAGS_never_fsync && sync_flags_supported.load(std::memory_order_relaxed)) {
+    TRACE_COUNTER_INCREMENT("sync_writes", 1);
+    Status s = DoWriteV(fd, filename, offset, data,
+                        FLAGS_env_use_fsync ? RWF_SYNC : RWF_DSYNC);
+    if (!s.IsNotSupported()) {
+      return s;
+    }
+    sync_flags_supported.store(false, std::memory_order_relaxed);
+  }
+#endif
+  RETURN_NOT_OK(DoWriteV(fd, filename, offset, data));
+  return DoSync(fd, filename);
+}
+
 Status DoIsOnXfsFilesystem(const string& path, bool* result) {
 #ifdef __APPLE__
   *result = false;
@@ -856,6 +954,7 @@ class PosixRWFile : public RWFile {
         fd_(fd),
         sync_on_close_(sync_on_close),
         is_on_xfs_(false),
+        direct_fd_(-1),
         closed_(false) {}
 
   ~PosixRWFile() {
@@ -870,6 +969,33 @@ class PosixRWFile : public RWFile {
     return DoReadV(fd_, filename_, offset, results);
   }
 
+  virtual Status ReadVDirect(uint64_t offset, ArrayView<Slice> results) const OVERRIDE {
+#if defined(__linux__)
+    // The direct descriptor is opened on first use, so that files which are
+    // never read this way don't hold a second descriptor.
+    //
+    // Note: see PunchHole() for why 'this' is cast to void*.
+    direct_fd_once_.Init(&InitDirectFd,
+                         reinterpret_cast<void*>(const_cast<PosixRWFile*>(this)));
+    if (direct_fd_ >= 0) {
+      return DoReadVDirect(direct_fd_, filename_, offset, results);
+    }
+#endif
+    return DoReadV(fd_, filename_, offset, results);
+  }
+
+  virtual Status ReadAhead(uint64_t offset, size_t length) const OVERRIDE {
+#if defined(__linux__)
+    TRACE_EVENT1("io", "PosixRWFile::ReadAhead", "path", filename_);
+    MAYBE_RETURN_EIO(filename_, IOError(Env::kInjectedFailureStatusMsg, EIO));
+    int err = posix_fadvise(fd_, offset, length, POSIX_FADV_WILLNEED);
+    if (PREDICT_FALSE(err != 0)) {
+      return IOError(filename_, err);
+    }
+#endif
+    return Status::OK();
+  }
+
   virtual Status Write(uint64_t offset, const Slice& data) OVERRIDE {
     return WriteV(offset, ArrayView<const Slice>(&data, 1));
   }
@@ -878,6 +1004,14 @@ class PosixRWFile : public RWFile {
     return DoWriteV(fd_, filename_, offset, data);
   }
 
+  virtual Status WriteVAndSync(uint64_t offset, ArrayView<const Slice> data) OVERRIDE {
+    TRACE_EVENT1("io", "PosixRWFile::WriteVAndSync", "path", filename_);
+    LOG_SLOW_EXECUTION(WARNING, 1000, Substitute("sync write call for $0", filename())) {
+      RETURN_NOT_OK(DoWriteVAndSync(fd_, filename_, offset, data));
+    }
+    return Status::OK();
+  }
+
   virtual Status PreAllocate(uint64_t offset,
                              size_t length,
                              PreAllocateMode mode) OVERRIDE {
@@ -1008,6 +1142,9 @@ class PosixRWFile : public RWFile {
         s = IOError(filename_, errno);
       }
     }
+    if (direct_fd_ >= 0) {
+      DoClose(direct_fd_);
+    }
 
     closed_ = true;
     return s;
@@ -1101,12 +1238,33 @@ class PosixRWFile : public RWFile {
     }
   }
 
+#if defined(__linux__)
+  static void InitDirectFd(void* arg) {
+    PosixRWFile* rwf = reinterpret_cast<PosixRWFile*>(arg);
+    int fd;
+    Status s = DoOpen(rwf->filename_, O_RDONLY | O_DIRECT, "direct reads", &fd);
+    if (s.ok()) {
+      rwf->direct_fd_ = fd;
+    } else {
+      KLOG_EVERY_N_SECS(WARNING, 1) <<
+          Substitute("Could not open file for direct reads, reading through the page cache: $0",
+                     s.ToString());
+    }
+  }
+#endif
+
   const string filename_;
   const int fd_;
   const bool sync_on_close_;
 
   GoogleOnceDynamic once_;
   bool is_on_xfs_;
+
+  // A read-only descriptor opened with O_DIRECT, or -1 if it hasn't been
+  // opened or the filesystem doesn't support direct I/O.
+  mutable GoogleOnceDynamic direct_fd_once_;
+  mutable int direct_fd_;
+
   bool closed_;
 };
 
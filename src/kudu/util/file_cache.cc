@@ -251,6 +251,18 @@ class Descriptor<RWFile> : public RWFile {
     return opened.file()->ReadV(offset, results);
   }
 
+  Status ReadVDirect(uint64_t offset, ArrayView<Slice> results) const override {
+    ScopedOpenedDescriptor<RWFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
+    return opened.file()->ReadVDirect(offset, results);
+  }
+
+  Status ReadAhead(uint64_t offset, size_t length) const override {
+    ScopedOpenedDescriptor<RWFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
+    return opened.file()->ReadAhead(offset, length);
+  }
+
   Status Write(uint64_t offset, const Slice& data) override {
     ScopedOpenedDescriptor<RWFile> opened(&base_);
     RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
@@ -263,6 +275,12 @@ class Descriptor<RWFile> : public RWFile {
     return opened.file()->WriteV(offset, data);
   }
 
+  Status WriteVAndSync(uint64_t offset, ArrayView<const Slice> data) override {
+    ScopedOpenedDescriptor<RWFile> opened(&base_);
+    RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
+    return opened.file()->WriteVAndSync(offset, data);
+  }
+
   Status PreAllocate(uint64_t offset, size_t length, PreAllocateMode mode) override {
     ScopedOpenedDescriptor<RWFile> opened(&base_);
     RETURN_NOT_OK(ReopenFileIfNecessary<Env::MUST_EXIST>(&opened));
@@ -141,4 +141,35 @@ TEST_F(HdrHistogramTest, MergeTest) {
   ASSERT_NEAR(hist.ValueAtPercentile(50.0), 250 * 50.0 / 100, 1e3);
 }
 
+TEST_F(HdrHistogramTest, DrainTest) {
+  uint64_t highest_val = 10000LU;
+
+  HdrHistogram hist(highest_val, kSigDigits);
+  HdrHistogram shard(highest_val, kSigDigits);
+
+  PopulateHistogram(&hist, 1, 100);
+  PopulateHistogram(&shard, 101, 250);
+  HdrHistogram old(hist);
+  HdrHistogram old_shard(shard);
+  shard.DrainInto(&hist);
+
+  ASSERT_EQ(hist.TotalCount(), old.TotalCount() + old_shard.TotalCount());
+  ASSERT_EQ(hist.TotalSum(), old.TotalSum() + old_shard.TotalSum());
+  ASSERT_EQ(hist.MinValue(), 1);
+  ASSERT_EQ(hist.MaxValue(), 250);
+  ASSERT_EQ(hist.ValueAtPercentile(100.0), 250);
+  ASSERT_EQ(0, shard.TotalCount());
+  ASSERT_EQ(0, shard.TotalSum());
+  ASSERT_EQ(0, shard.CountInBucketForValue(200));
+
+  // Draining an empty histogram changes nothing, and values recorded after a
+  // drain are moved by the next one.
+  shard.DrainInto(&hist);
+  ASSERT_EQ(hist.TotalCount(), old.TotalCount() + old_shard.TotalCount());
+  shard.Increment(5000);
+  shard.DrainInto(&hist);
+  ASSERT_EQ(hist.TotalCount(), old.TotalCount() + old_shard.TotalCount() + 1);
+  ASSERT_EQ(hist.MaxValue(), 5000);
+}
+
 } // namespace kudu
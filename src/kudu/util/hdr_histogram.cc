@@ -36,6 +36,7 @@
 #include "kudu/util/status.h"
 
 using base::subtle::Atomic64;
+using base::subtle::NoBarrier_AtomicExchange;
 using base::subtle::NoBarrier_AtomicIncrement;
 using base::subtle::NoBarrier_Store;
 using base::subtle::NoBarrier_Load;
@@ -153,10 +154,14 @@ void HdrHistogram::Increment(int64_t value) {
 }
 
 void HdrHistogram::UpdateMinMax(int64_t min, int64_t max) {
+  // The fields are read directly rather than via MinValue() and MaxValue(), to
+  // save a load of 'total_count_' on every recorded value: an empty histogram
+  // has a min greater than, and a max lower than, any value.
+
   // Update min, if needed.
   {
     Atomic64 min_val;
-    while (PREDICT_FALSE(min < (min_val = MinValue()))) {
+    while (PREDICT_FALSE(min < (min_val = NoBarrier_Load(&min_value_)))) {
       Atomic64 old_val = NoBarrier_CompareAndSwap(&min_value_, min_val, min);
       if (PREDICT_TRUE(old_val == min_val)) break; // CAS success.
     }
@@ -165,7 +170,7 @@ void HdrHistogram::UpdateMinMax(int64_t min, int64_t max) {
   // Update max, if needed.
   {
     Atomic64 max_val;
-    while (PREDICT_FALSE(max > (max_val = MaxValue()))) {
+    while (PREDICT_FALSE(max > (max_val = NoBarrier_Load(&max_value_)))) {
       Atomic64 old_val = NoBarrier_CompareAndSwap(&max_value_, max_val, max);
       if (PREDICT_TRUE(old_val == max_val)) break; // CAS success.
     }
@@ -367,6 +372,32 @@ void HdrHistogram::MergeFrom(const HdrHistogram& other) {
   }
 }
 
+void HdrHistogram::DrainInto(HdrHistogram* dst) {
+  DCHECK_EQ(highest_trackable_value_, dst->highest_trackable_value());
+  DCHECK_EQ(num_significant_digits_, dst->num_significant_digits());
+  DCHECK_EQ(counts_array_length_, dst->counts_array_length_);
+
+  // Values are recorded into their bucket before the total count. Taking the
+  // total first and adding it to 'dst' last means 'dst' has at least as many
+  // values in its buckets as in its total, like a histogram being recorded to.
+  const Atomic64 total_count = NoBarrier_AtomicExchange(&total_count_, 0);
+  if (total_count == 0) {
+    return;
+  }
+  for (int i = 0; i < counts_array_length_; i++) {
+    if (NoBarrier_Load(&counts_[i]) == 0) {
+      continue;
+    }
+    Atomic64 count = NoBarrier_AtomicExchange(&counts_[i], 0);
+    if (count > 0) {
+      NoBarrier_AtomicIncrement(&dst->counts_[i], count);
+    }
+  }
+  NoBarrier_AtomicIncrement(&dst->total_sum_, NoBarrier_AtomicExchange(&total_sum_, 0));
+  dst->UpdateMinMax(NoBarrier_Load(&min_value_), NoBarrier_Load(&max_value_));
+  NoBarrier_AtomicIncrement(&dst->total_count_, total_count);
+}
+
 ///////////////////////////////////////////////////////////////////////
 // AbstractHistogramIterator
 ///////////////////////////////////////////////////////////////////////
@@ -176,6 +176,12 @@ class HdrHistogram {
   // 'total_count_' and 'total_sum_' will be updated if needed.
   void MergeFrom(const HdrHistogram& other);
 
+  // Moves the values recorded in this HdrHistogram into 'dst', which must have
+  // the same configuration, leaving this one empty except for its min and max.
+  // Values recorded concurrently are either moved or left for the next call.
+  // 'dst' never sees more values in its total count than in its buckets.
+  void DrainInto(HdrHistogram* dst);
+
  private:
   friend class AbstractHistogramIterator;
 
@@ -29,6 +29,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <gflags/gflags_declare.h>
 #include <glog/logging.h>
@@ -48,6 +49,7 @@ using std::list;
 using std::shared_ptr;
 using std::string;
 using std::thread;
+using std::vector;
 using strings::Substitute;
 
 METRIC_DEFINE_entity(test);
@@ -63,8 +65,11 @@ METRIC_DEFINE_histogram(test, maintenance_op_duration,
                         60000000LU, 2);
 
 DECLARE_bool(enable_maintenance_manager);
+DECLARE_bool(maintenance_manager_cost_based_scoring);
 DECLARE_int64(log_target_replay_size_mb);
 DECLARE_double(maintenance_op_multiplier);
+DECLARE_int32(maintenance_manager_max_running_compaction_ops);
+DECLARE_int32(maintenance_manager_max_running_ops_per_data_dir);
 DECLARE_int32(max_priority_range);
 
 namespace kudu {
@@ -118,13 +123,15 @@ class TestMaintenanceOp : public MaintenanceOp {
       ram_anchored_(500),
       logs_retained_bytes_(0),
       perf_improvement_(0),
+      io_bytes_(0),
       metric_entity_(METRIC_ENTITY_test.Instantiate(&metric_registry_, "test")),
       maintenance_op_duration_(METRIC_maintenance_op_duration.Instantiate(metric_entity_)),
       maintenance_ops_running_(METRIC_maintenance_ops_running.Instantiate(metric_entity_, 0)),
       remaining_runs_(1),
       prepared_runs_(0),
       sleep_time_(MonoDelta::FromSeconds(0)),
-      priority_(priority) {
+      priority_(priority),
+      op_class_(COMPACTION_OP) {
   }
 
   ~TestMaintenanceOp() override = default;
@@ -160,6 +167,7 @@ class TestMaintenanceOp : public MaintenanceOp {
     stats->set_ram_anchored(ram_anchored_);
     stats->set_logs_retained_bytes(logs_retained_bytes_);
     stats->set_perf_improvement(perf_improvement_);
+    stats->set_io_bytes(io_bytes_);
   }
 
   void set_remaining_runs(int runs) {
@@ -187,6 +195,11 @@ class TestMaintenanceOp : public MaintenanceOp {
     perf_improvement_ = perf_improvement;
   }
 
+  void set_io_bytes(int64_t io_bytes) {
+    std::lock_guard<Mutex> guard(lock_);
+    io_bytes_ = io_bytes;
+  }
+
   scoped_refptr<Histogram> DurationHistogram() const override {
     return maintenance_op_duration_;
   }
@@ -199,6 +212,26 @@ class TestMaintenanceOp : public MaintenanceOp {
     return priority_;
   }
 
+  OpClass op_class() const override {
+    std::lock_guard<Mutex> guard(lock_);
+    return op_class_;
+  }
+
+  void GetDataDirs(vector<string>* dirs) const override {
+    std::lock_guard<Mutex> guard(lock_);
+    *dirs = data_dirs_;
+  }
+
+  void set_op_class(OpClass op_class) {
+    std::lock_guard<Mutex> guard(lock_);
+    op_class_ = op_class;
+  }
+
+  void set_data_dirs(vector<string> data_dirs) {
+    std::lock_guard<Mutex> guard(lock_);
+    data_dirs_ = std::move(data_dirs);
+  }
+
   int remaining_runs() const {
     std::lock_guard<Mutex> guard(lock_);
     return remaining_runs_;
@@ -210,6 +243,7 @@ class TestMaintenanceOp : public MaintenanceOp {
   uint64_t ram_anchored_;
   uint64_t logs_retained_bytes_;
   uint64_t perf_improvement_;
+  int64_t io_bytes_;
   MetricRegistry metric_registry_;
   scoped_refptr<MetricEntity> metric_entity_;
   scoped_refptr<Histogram> maintenance_op_duration_;
@@ -226,6 +260,9 @@ class TestMaintenanceOp : public MaintenanceOp {
 
   // Maintenance priority.
   int32_t priority_;
+
+  OpClass op_class_;
+  vector<string> data_dirs_;
 };
 
 // Create an op and wait for it to start running.  Unregister it while it is
@@ -596,4 +633,101 @@ TEST_F(MaintenanceManagerTest, TestPriorityOpLaunch) {
   }
 }
 
+// Test that the limits on the running ops of each class and of each data dir
+// are honored, and that the threads left free by them run other ops.
+TEST_F(MaintenanceManagerTest, TestOpClassAndDataDirLimits) {
+  // A long compaction which would occupy both threads if it weren't limited.
+  FLAGS_maintenance_manager_max_running_compaction_ops = 1;
+  TestMaintenanceOp compaction("compaction", MaintenanceOp::HIGH_IO_USAGE);
+  compaction.set_perf_improvement(10);
+  compaction.set_remaining_runs(1000);
+  compaction.set_sleep_time(MonoDelta::FromMilliseconds(200));
+  TestMaintenanceOp flush("flush", MaintenanceOp::HIGH_IO_USAGE);
+  flush.set_op_class(MaintenanceOp::FLUSH_OP);
+  flush.set_perf_improvement(1);
+  manager_->RegisterOp(&compaction);
+  manager_->RegisterOp(&flush);
+
+  // The flush runs alongside the compaction despite its lower score.
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, flush.DurationHistogram()->TotalCount());
+  });
+  ASSERT_LE(compaction.RunningGauge()->value(), 1);
+  compaction.set_remaining_runs(0);
+  manager_->UnregisterOp(&compaction);
+  manager_->UnregisterOp(&flush);
+  FLAGS_maintenance_manager_max_running_compaction_ops = 0;
+
+  // Two IO-heavy ops on the same data dir don't run at the same time, leaving
+  // a thread for the op on the other data dir.
+  FLAGS_maintenance_manager_max_running_ops_per_data_dir = 1;
+  TestMaintenanceOp op_a("op_a", MaintenanceOp::HIGH_IO_USAGE);
+  op_a.set_data_dirs({ "/data/a" });
+  op_a.set_perf_improvement(10);
+  op_a.set_remaining_runs(1000);
+  op_a.set_sleep_time(MonoDelta::FromMilliseconds(200));
+  TestMaintenanceOp op_b("op_b", MaintenanceOp::HIGH_IO_USAGE);
+  op_b.set_data_dirs({ "/data/b" });
+  op_b.set_perf_improvement(1);
+  manager_->RegisterOp(&op_a);
+  manager_->RegisterOp(&op_b);
+  ASSERT_EVENTUALLY([&]() {
+    ASSERT_EQ(1, op_b.DurationHistogram()->TotalCount());
+  });
+  ASSERT_LE(op_a.RunningGauge()->value(), 1);
+  op_a.set_remaining_runs(0);
+  manager_->UnregisterOp(&op_a);
+  manager_->UnregisterOp(&op_b);
+  FLAGS_maintenance_manager_max_running_ops_per_data_dir = 0;
+}
+
+// Test that with cost-based scoring, ops are ranked by their perf improvement
+// per second of run time predicted from the history of completed ops.
+TEST_F(MaintenanceManagerTest, TestCostBasedScoring) {
+  const int64_t kMB = 1024 * 1024;
+
+  StopManager();
+
+  // 100MB of IO took 10 seconds, and an op which doesn't report its IO took 4
+  // seconds on average.
+  vector<OpInstance> completed_ops(kHistorySize);
+  completed_ops[0].name = "compaction";
+  completed_ops[0].duration = MonoDelta::FromSeconds(10);
+  completed_ops[0].io_bytes = 100 * kMB;
+  completed_ops[1].name = "no_io";
+  completed_ops[1].duration = MonoDelta::FromSeconds(3);
+  completed_ops[2].name = "no_io";
+  completed_ops[2].duration = MonoDelta::FromSeconds(5);
+  {
+    MaintenanceManager::CostModel model(completed_ops);
+    ASSERT_DOUBLE_EQ(30, model.PredictedSeconds("other", 300 * kMB));
+    ASSERT_DOUBLE_EQ(4, model.PredictedSeconds("no_io", 0));
+    ASSERT_DOUBLE_EQ(0, model.PredictedSeconds("other", 0));
+  }
+  ASSERT_DOUBLE_EQ(2, MaintenanceManager::PerfImprovementPerSecond(20, 10));
+  ASSERT_DOUBLE_EQ(20, MaintenanceManager::PerfImprovementPerSecond(20, 0.5));
+
+  // A huge compaction has the best perf improvement, but a flush gets more
+  // done per second.
+  TestMaintenanceOp compaction("compaction", MaintenanceOp::HIGH_IO_USAGE);
+  compaction.set_ram_anchored(0);
+  compaction.set_perf_improvement(10);
+  compaction.set_io_bytes(10000 * kMB);
+  TestMaintenanceOp flush("flush", MaintenanceOp::HIGH_IO_USAGE);
+  flush.set_perf_improvement(5);
+  flush.set_io_bytes(10 * kMB);
+  manager_->RegisterOp(&compaction);
+  manager_->RegisterOp(&flush);
+  manager_->completed_ops_ = completed_ops;
+
+  ASSERT_EQ(&compaction, manager_->FindBestOp().first);
+  FLAGS_maintenance_manager_cost_based_scoring = true;
+  auto op_and_why = manager_->FindBestOp();
+  ASSERT_EQ(&flush, op_and_why.first);
+  EXPECT_EQ("perf score=5.000000, per predicted second=5.000000", op_and_why.second);
+
+  manager_->UnregisterOp(&compaction);
+  manager_->UnregisterOp(&flush);
+}
+
 } // namespace kudu
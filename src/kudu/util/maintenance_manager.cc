@@ -110,6 +110,74 @@ TAG_FLAG(max_priority_range, advanced);
 TAG_FLAG(max_priority_range, experimental);
 TAG_FLAG(max_priority_range, runtime);
 
+DEFINE_int32(maintenance_manager_max_running_flush_ops, 0,
+             "Maximum number of flush operations (e.g. MRS and DMS flushes) the "
+             "maintenance manager runs at once. 0 means no limit other than "
+             "--maintenance_manager_num_threads.");
+TAG_FLAG(maintenance_manager_max_running_flush_ops, advanced);
+TAG_FLAG(maintenance_manager_max_running_flush_ops, experimental);
+TAG_FLAG(maintenance_manager_max_running_flush_ops, runtime);
+
+DEFINE_int32(maintenance_manager_max_running_compaction_ops, 0,
+             "Maximum number of compaction operations the maintenance manager "
+             "runs at once. Setting this below --maintenance_manager_num_threads "
+             "keeps threads available for flushes and garbage collection, so that "
+             "they aren't starved by long-running compactions. 0 means no limit "
+             "other than --maintenance_manager_num_threads.");
+TAG_FLAG(maintenance_manager_max_running_compaction_ops, advanced);
+TAG_FLAG(maintenance_manager_max_running_compaction_ops, experimental);
+TAG_FLAG(maintenance_manager_max_running_compaction_ops, runtime);
+
+DEFINE_int32(maintenance_manager_max_running_gc_ops, 0,
+             "Maximum number of garbage collection operations (e.g. log GC and "
+             "ancient data GC) the maintenance manager runs at once. 0 means no "
+             "limit other than --maintenance_manager_num_threads.");
+TAG_FLAG(maintenance_manager_max_running_gc_ops, advanced);
+TAG_FLAG(maintenance_manager_max_running_gc_ops, experimental);
+TAG_FLAG(maintenance_manager_max_running_gc_ops, runtime);
+
+DEFINE_int32(maintenance_manager_max_running_ops_per_data_dir, 0,
+             "Maximum number of IO-intensive maintenance operations running at "
+             "once on each data directory. Setting this to 1 with as many "
+             "maintenance threads as data directories spreads the background "
+             "work over all the disks rather than queueing it on the disk of the "
+             "best-scoring operations. 0 means no limit.");
+TAG_FLAG(maintenance_manager_max_running_ops_per_data_dir, advanced);
+TAG_FLAG(maintenance_manager_max_running_ops_per_data_dir, experimental);
+TAG_FLAG(maintenance_manager_max_running_ops_per_data_dir, runtime);
+
+DEFINE_bool(maintenance_manager_cost_based_scoring, false,
+            "Whether to rank the performance-improving maintenance operations by "
+            "their improvement per second of predicted run time, rather than by "
+            "their improvement alone. Run times are predicted from the IO the ops "
+            "estimate they'd do and the throughput and durations of the last "
+            "--maintenance_manager_history_size completed ops. This keeps huge "
+            "compactions from being scheduled ahead of cheaper ops of similar "
+            "value, e.g. flushes.");
+TAG_FLAG(maintenance_manager_cost_based_scoring, advanced);
+TAG_FLAG(maintenance_manager_cost_based_scoring, experimental);
+TAG_FLAG(maintenance_manager_cost_based_scoring, runtime);
+
+METRIC_DEFINE_gauge_uint32(server, maintenance_manager_queued_flush_ops,
+                           "Queued Flush Maintenance Operations",
+                           kudu::MetricUnit::kMaintenanceOperations,
+                           "Number of runnable flush operations which weren't "
+                           "running as of the last maintenance manager scheduling pass.",
+                           kudu::MetricLevel::kInfo);
+METRIC_DEFINE_gauge_uint32(server, maintenance_manager_queued_compaction_ops,
+                           "Queued Compaction Maintenance Operations",
+                           kudu::MetricUnit::kMaintenanceOperations,
+                           "Number of runnable compaction operations which weren't "
+                           "running as of the last maintenance manager scheduling pass.",
+                           kudu::MetricLevel::kInfo);
+METRIC_DEFINE_gauge_uint32(server, maintenance_manager_queued_gc_ops,
+                           "Queued GC Maintenance Operations",
+                           kudu::MetricUnit::kMaintenanceOperations,
+                           "Number of runnable garbage collection operations which "
+                           "weren't running as of the last maintenance manager "
+                           "scheduling pass.",
+                           kudu::MetricLevel::kInfo);
+
 namespace kudu {
 
 MaintenanceOpStats::MaintenanceOpStats() {
@@ -123,6 +191,7 @@ void MaintenanceOpStats::Clear() {
   logs_retained_bytes_ = 0;
   data_retained_bytes_ = 0;
   perf_improvement_ = 0;
+  io_bytes_ = 0;
   last_modified_ = MonoTime();
 }
 
@@ -162,7 +231,8 @@ const MaintenanceManager::Options MaintenanceManager::kDefaultOptions = {
 };
 
 MaintenanceManager::MaintenanceManager(const Options& options,
-                                       string server_uuid)
+                                       string server_uuid,
+                                       const scoped_refptr<MetricEntity>& metric_entity)
   : server_uuid_(std::move(server_uuid)),
     num_threads_(options.num_threads <= 0 ?
                  FLAGS_maintenance_manager_num_threads : options.num_threads),
@@ -183,6 +253,15 @@ MaintenanceManager::MaintenanceManager(const Options& options,
                           FLAGS_maintenance_manager_history_size :
                           options.history_size;
   completed_ops_.resize(history_size);
+  std::fill(running_ops_per_class_, running_ops_per_class_ + MaintenanceOp::kNumOpClasses, 0);
+  if (metric_entity) {
+    queued_ops_[MaintenanceOp::FLUSH_OP] =
+        METRIC_maintenance_manager_queued_flush_ops.Instantiate(metric_entity, 0);
+    queued_ops_[MaintenanceOp::COMPACTION_OP] =
+        METRIC_maintenance_manager_queued_compaction_ops.Instantiate(metric_entity, 0);
+    queued_ops_[MaintenanceOp::GC_OP] =
+        METRIC_maintenance_manager_queued_gc_ops.Instantiate(metric_entity, 0);
+  }
 }
 
 MaintenanceManager::~MaintenanceManager() {
@@ -311,14 +390,17 @@ bool MaintenanceManager::FindAndLaunchOp(std::unique_lock<Mutex>* guard) {
   }
 
   // Prepare the maintenance operation.
-  IncreaseOpCount(op);
+  vector<string> data_dirs;
+  op->GetDataDirs(&data_dirs);
+  const int64_t io_bytes = FindOrDie(ops_, op).io_bytes();
+  IncreaseOpCount(op, data_dirs);
   guard->unlock();
   bool ready = op->Prepare();
   guard->lock();
   if (!ready) {
     LOG_WITH_PREFIX(INFO) << "Prepare failed for " << op->name()
                           << ". Re-running scheduler.";
-    DecreaseOpCount(op);
+    DecreaseOpCount(op, data_dirs);
     op->cond_->Signal();
     return true;
   }
@@ -326,7 +408,9 @@ bool MaintenanceManager::FindAndLaunchOp(std::unique_lock<Mutex>* guard) {
   LOG_AND_TRACE_WITH_PREFIX("maintenance", INFO)
       << Substitute("Scheduling $0: $1", op->name(), note);
   // Run the maintenance operation.
-  CHECK_OK(thread_pool_->Submit([this, op]() { this->LaunchOp(op); }));
+  CHECK_OK(thread_pool_->Submit([this, op, data_dirs, io_bytes]() {
+    this->LaunchOp(op, data_dirs, io_bytes);
+  }));
   return true;
 }
 
@@ -342,7 +426,12 @@ bool MaintenanceManager::FindAndLaunchOp(std::unique_lock<Mutex>* guard) {
 // - If there are Ops that we can run that free disk space, run whichever frees
 //   the most space (e.g. GCing ancient deltas).
 // - Finally, if there's nothing else that we really need to do, we run the Op
-//   that will improve performance the most.
+//   that will improve performance the most. With
+//   --maintenance_manager_cost_based_scoring, that's the Op that improves
+//   performance the most per second of its predicted run time.
+//
+// Ops which would exceed the limit on the running ops of their class, or on
+// the running ops of one of their data directories, are not considered.
 //
 // In general, we want to prioritize limiting the amount of expensive resources
 // we hold onto. Low IO ops that free WAL disk space are preferred, followed by
@@ -367,6 +456,22 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
 
   double best_perf_improvement = 0;
   MaintenanceOp* best_perf_improvement_op = nullptr;
+  double best_perf_improvement_score = 0;
+
+  const bool cost_based_scoring = FLAGS_maintenance_manager_cost_based_scoring;
+  std::unique_ptr<CostModel> cost_model;
+  if (cost_based_scoring) {
+    cost_model.reset(new CostModel(completed_ops_));
+  }
+
+  uint32_t queued_ops[MaintenanceOp::kNumOpClasses] = {};
+  SCOPED_CLEANUP({
+    for (int i = 0; i < MaintenanceOp::kNumOpClasses; i++) {
+      if (queued_ops_[i]) {
+        queued_ops_[i]->set_value(queued_ops[i]);
+      }
+    }
+  });
   for (auto& val : ops_) {
     MaintenanceOp* op(val.first);
     MaintenanceOpStats& stats(val.second);
@@ -377,6 +482,14 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
     if (op->cancelled() || !stats.valid() || !stats.runnable()) {
       continue;
     }
+    if (op->running() == 0) {
+      queued_ops[op->op_class()]++;
+    }
+    if (!WithinOpLimits(op)) {
+      VLOG_WITH_PREFIX(3) << "Not considering MM op " << op->name()
+                          << ": too many ops of its class or on its data dirs are running";
+      continue;
+    }
 
     const auto logs_retained_bytes = stats.logs_retained_bytes();
     if (op->io_usage() == MaintenanceOp::LOW_IO_USAGE &&
@@ -409,10 +522,16 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
     }
 
     const auto perf_improvement = PerfImprovement(stats.perf_improvement(), op->priority());
+    auto perf_improvement_score = perf_improvement;
+    if (cost_based_scoring) {
+      perf_improvement_score = PerfImprovementPerSecond(
+          perf_improvement, cost_model->PredictedSeconds(op->name(), stats.io_bytes()));
+    }
     if ((!best_perf_improvement_op) ||
-        (perf_improvement > best_perf_improvement)) {
+        (perf_improvement_score > best_perf_improvement_score)) {
       best_perf_improvement_op = op;
       best_perf_improvement = perf_improvement;
+      best_perf_improvement_score = perf_improvement_score;
     }
   }
 
@@ -466,7 +585,10 @@ pair<MaintenanceOp*, string> MaintenanceManager::FindBestOp() {
 
   // Look at ops that can improve read/write performance most.
   if (best_perf_improvement_op && best_perf_improvement > 0) {
-    string note = StringPrintf("perf score=%.6f", best_perf_improvement);
+    string note = cost_based_scoring ?
+        StringPrintf("perf score=%.6f, per predicted second=%.6f",
+                     best_perf_improvement, best_perf_improvement_score) :
+        StringPrintf("perf score=%.6f", best_perf_improvement);
     return {best_perf_improvement_op, std::move(note)};
   }
   return {nullptr, "no ops with positive improvement"};
@@ -482,12 +604,56 @@ double MaintenanceManager::PerfImprovement(double perf_improvement, int32_t prio
   return perf_improvement * std::pow(FLAGS_maintenance_op_multiplier, priority);
 }
 
-void MaintenanceManager::LaunchOp(MaintenanceOp* op) {
+double MaintenanceManager::PerfImprovementPerSecond(double perf_improvement,
+                                                    double predicted_secs) {
+  // Ops predicted to take less than a second, or with no prediction at all,
+  // are scored on their improvement alone.
+  return perf_improvement / std::max(predicted_secs, 1.0);
+}
+
+MaintenanceManager::CostModel::CostModel(const vector<OpInstance>& completed_ops)
+    : io_bytes_per_sec_(0) {
+  int64_t total_io_bytes = 0;
+  double total_io_secs = 0;
+  for (const auto& completed_op : completed_ops) {
+    // Skip the slots of the history which haven't been filled in yet.
+    if (completed_op.name.empty()) {
+      continue;
+    }
+    const double secs = completed_op.duration.ToSeconds();
+    auto& duration = durations_by_name_[completed_op.name];
+    duration.first += secs;
+    duration.second++;
+    if (completed_op.io_bytes > 0) {
+      total_io_bytes += completed_op.io_bytes;
+      total_io_secs += secs;
+    }
+  }
+  if (total_io_secs > 0) {
+    io_bytes_per_sec_ = total_io_bytes / total_io_secs;
+  }
+}
+
+double MaintenanceManager::CostModel::PredictedSeconds(const string& op_name,
+                                                       int64_t io_bytes) const {
+  if (io_bytes > 0 && io_bytes_per_sec_ > 0) {
+    return io_bytes / io_bytes_per_sec_;
+  }
+  const auto* duration = FindOrNull(durations_by_name_, op_name);
+  if (duration) {
+    return duration->first / duration->second;
+  }
+  return 0;
+}
+
+void MaintenanceManager::LaunchOp(MaintenanceOp* op, const vector<string>& data_dirs,
+                                  int64_t io_bytes) {
   int64_t thread_id = Thread::CurrentThreadId();
   OpInstance op_instance;
   op_instance.thread_id = thread_id;
   op_instance.name = op->name();
   op_instance.start_mono_time = MonoTime::Now();
+  op_instance.io_bytes = io_bytes;
   op->RunningGauge()->Increment();
   {
     std::lock_guard<Mutex> lock(running_instances_lock_);
@@ -507,7 +673,7 @@ void MaintenanceManager::LaunchOp(MaintenanceOp* op) {
     completed_ops_count_++;
 
     op->DurationHistogram()->Increment(op_instance.duration.ToMilliseconds());
-    DecreaseOpCount(op);
+    DecreaseOpCount(op, data_dirs);
     op->cond_->Signal();
     cond_.Signal(); // Wake up scheduler.
   });
@@ -569,6 +735,18 @@ void MaintenanceManager::GetMaintenanceManagerStatusDump(MaintenanceManagerStatu
   }
 }
 
+int32_t MaintenanceManager::NumPendingOps() {
+  std::lock_guard<Mutex> guard(lock_);
+  int32_t num_pending = 0;
+  for (const auto& val : ops_) {
+    const MaintenanceOpStats& stats(val.second);
+    if (stats.valid() && stats.runnable() && val.first->running() == 0) {
+      num_pending++;
+    }
+  }
+  return num_pending;
+}
+
 string MaintenanceManager::LogPrefix() const {
   return Substitute("P $0: ", server_uuid_);
 }
@@ -577,18 +755,66 @@ bool MaintenanceManager::HasFreeThreads() {
   return num_threads_ - running_ops_ > 0;
 }
 
+bool MaintenanceManager::WithinOpLimits(const MaintenanceOp* op) {
+  int32_t max_running_ops_of_class = 0;
+  switch (op->op_class()) {
+    case MaintenanceOp::FLUSH_OP:
+      max_running_ops_of_class = FLAGS_maintenance_manager_max_running_flush_ops;
+      break;
+    case MaintenanceOp::COMPACTION_OP:
+      max_running_ops_of_class = FLAGS_maintenance_manager_max_running_compaction_ops;
+      break;
+    case MaintenanceOp::GC_OP:
+      max_running_ops_of_class = FLAGS_maintenance_manager_max_running_gc_ops;
+      break;
+  }
+  if (max_running_ops_of_class > 0 &&
+      running_ops_per_class_[op->op_class()] >= max_running_ops_of_class) {
+    return false;
+  }
+
+  const int32_t max_running_ops_per_dir =
+      FLAGS_maintenance_manager_max_running_ops_per_data_dir;
+  if (max_running_ops_per_dir > 0 && op->io_usage() == MaintenanceOp::HIGH_IO_USAGE) {
+    vector<string> data_dirs;
+    op->GetDataDirs(&data_dirs);
+    for (const auto& dir : data_dirs) {
+      if (FindWithDefault(running_ops_per_data_dir_, dir, 0) >= max_running_ops_per_dir) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool MaintenanceManager::CouldNotLaunchNewOp(bool prev_iter_found_no_work) {
   return (!HasFreeThreads() || prev_iter_found_no_work || disabled_for_tests()) && !shutdown_;
 }
 
-void MaintenanceManager::IncreaseOpCount(MaintenanceOp *op) {
+void MaintenanceManager::IncreaseOpCount(MaintenanceOp *op, const vector<string>& data_dirs) {
   op->running_++;
   running_ops_++;
+  running_ops_per_class_[op->op_class()]++;
+  if (op->io_usage() == MaintenanceOp::HIGH_IO_USAGE) {
+    for (const auto& dir : data_dirs) {
+      running_ops_per_data_dir_[dir]++;
+    }
+  }
 }
 
-void MaintenanceManager::DecreaseOpCount(MaintenanceOp *op) {
+void MaintenanceManager::DecreaseOpCount(MaintenanceOp *op, const vector<string>& data_dirs) {
   op->running_--;
   running_ops_--;
+  running_ops_per_class_[op->op_class()]--;
+  if (op->io_usage() == MaintenanceOp::HIGH_IO_USAGE) {
+    for (const auto& dir : data_dirs) {
+      auto it = running_ops_per_data_dir_.find(dir);
+      DCHECK(it != running_ops_per_data_dir_.end());
+      if (--it->second == 0) {
+        running_ops_per_data_dir_.erase(it);
+      }
+    }
+  }
 }
 
 } // namespace kudu
@@ -46,6 +46,7 @@ class Histogram;
 class MaintenanceManager;
 class MaintenanceManagerStatusPB;
 class MaintenanceManagerStatusPB_OpInstancePB;
+class MetricEntity;
 class Thread;
 class ThreadPool;
 
@@ -106,6 +107,16 @@ class MaintenanceOpStats {
     perf_improvement_ = perf_improvement;
   }
 
+  int64_t io_bytes() const {
+    DCHECK(valid_);
+    return io_bytes_;
+  }
+
+  void set_io_bytes(int64_t io_bytes) {
+    UpdateLastModified();
+    io_bytes_ = io_bytes;
+  }
+
   const MonoTime& last_modified() const {
     DCHECK(valid_);
     return last_modified_;
@@ -146,6 +157,10 @@ class MaintenanceOpStats {
   // absolute scale (yet TBD).
   double perf_improvement_;
 
+  // Approximate number of bytes this operation would read and write if it
+  // ran. Used to predict how long it would take. May be 0 if unknown.
+  int64_t io_bytes_;
+
   // The last time that the stats were modified.
   MonoTime last_modified_;
 };
@@ -160,6 +175,9 @@ struct OpInstance {
   MonoDelta duration;
   // The time at which the operation was launched.
   MonoTime start_mono_time;
+  // The estimated number of bytes the operation read and wrote, as of when it
+  // was scheduled. 0 if unknown.
+  int64_t io_bytes = 0;
 
   MaintenanceManagerStatusPB_OpInstancePB DumpToPB() const;
 };
@@ -179,6 +197,15 @@ class MaintenanceOp {
     HIGH_IO_USAGE // Everything else.
   };
 
+  // The class of work an op does. The number of running ops of each class can
+  // be bounded, so that e.g. long compactions don't starve flushes.
+  enum OpClass {
+    FLUSH_OP,       // Writes in-memory data to disk, e.g. MRS or DMS flushes.
+    COMPACTION_OP,  // Rewrites on-disk data to improve performance.
+    GC_OP,          // Deletes data or logs which are no longer needed.
+  };
+  static constexpr int kNumOpClasses = 3;
+
   explicit MaintenanceOp(std::string name, IOUsage io_usage);
   virtual ~MaintenanceOp();
 
@@ -208,6 +235,13 @@ class MaintenanceOp {
   // Returns the gauge for this op that tracks when this op is running. Cannot be NULL.
   virtual scoped_refptr<AtomicGauge<uint32_t>> RunningGauge() const = 0;
 
+  // Returns the class of work this op does.
+  virtual OpClass op_class() const { return COMPACTION_OP; }
+
+  // Appends to 'dirs' the data directories this op reads from and writes to,
+  // if they're known. This will be run under the MaintenanceManager lock.
+  virtual void GetDataDirs(std::vector<std::string>* /*dirs*/) const {}
+
   uint32_t running() { return running_; }
 
   const std::string& name() const { return name_; }
@@ -278,7 +312,10 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
     uint32_t history_size;
   };
 
-  MaintenanceManager(const Options& options, std::string server_uuid);
+  // If 'metric_entity' is set, the manager's metrics are registered with it.
+  MaintenanceManager(const Options& options,
+                     std::string server_uuid,
+                     const scoped_refptr<MetricEntity>& metric_entity = nullptr);
   ~MaintenanceManager();
 
   // Start running the maintenance manager.
@@ -296,6 +333,10 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
 
   void GetMaintenanceManagerStatusDump(MaintenanceManagerStatusPB* out_pb);
 
+  // Returns the number of registered ops which are runnable but aren't
+  // currently running, as of their most recently updated stats.
+  int32_t NumPendingOps();
+
   void set_memory_pressure_func_for_tests(std::function<bool(double*)> f) {
     std::lock_guard<Mutex> guard(lock_);
     memory_pressure_func_ = std::move(f);
@@ -307,10 +348,31 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   FRIEND_TEST(MaintenanceManagerTest, TestLogRetentionPrioritization);
   FRIEND_TEST(MaintenanceManagerTest, TestPrioritizeLogRetentionUnderMemoryPressure);
   FRIEND_TEST(MaintenanceManagerTest, TestOpFactors);
+  FRIEND_TEST(MaintenanceManagerTest, TestCostBasedScoring);
 
   typedef std::map<MaintenanceOp*, MaintenanceOpStats,
           MaintenanceOpComparator> OpMapTy;
 
+  // Predicts how long ops take to run, based on the recently completed ops.
+  class CostModel {
+   public:
+    explicit CostModel(const std::vector<OpInstance>& completed_ops);
+
+    // Returns the predicted run time of 'op' in seconds, given its stats.
+    // If 'io_bytes' is known, the prediction is based on the IO throughput of
+    // the recently completed ops; otherwise, it's the average duration of the
+    // recently completed instances of 'op'. Returns 0 if neither is known.
+    double PredictedSeconds(const std::string& op_name, int64_t io_bytes) const;
+
+   private:
+    // Bytes per second read and written by the completed ops which reported
+    // their IO, or 0 if none did.
+    double io_bytes_per_sec_;
+    // Sum of the durations in seconds and number of completed instances of
+    // each op.
+    std::unordered_map<std::string, std::pair<double, int>> durations_by_name_;
+  };
+
   // Return true if tests have currently disabled the maintenance
   // manager by way of changing the gflags at runtime.
   bool disabled_for_tests() const;
@@ -327,16 +389,25 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
 
   double PerfImprovement(double perf_improvement, int32_t priority) const;
 
-  void LaunchOp(MaintenanceOp* op);
+  // Returns the perf improvement per second of predicted run time, when the
+  // cost-based scoring is enabled.
+  static double PerfImprovementPerSecond(double perf_improvement, double predicted_secs);
+
+  void LaunchOp(MaintenanceOp* op, const std::vector<std::string>& data_dirs,
+                int64_t io_bytes);
 
   std::string LogPrefix() const;
 
   bool HasFreeThreads();
 
+  // Returns true if running 'op' wouldn't exceed the limits on the number of
+  // running ops of its class or on each of its data directories.
+  bool WithinOpLimits(const MaintenanceOp* op);
+
   bool CouldNotLaunchNewOp(bool prev_iter_found_no_work);
 
-  void IncreaseOpCount(MaintenanceOp *op);
-  void DecreaseOpCount(MaintenanceOp *op);
+  void IncreaseOpCount(MaintenanceOp *op, const std::vector<std::string>& data_dirs);
+  void DecreaseOpCount(MaintenanceOp *op, const std::vector<std::string>& data_dirs);
 
   const std::string server_uuid_;
   const int32_t num_threads_;
@@ -348,6 +419,13 @@ class MaintenanceManager : public std::enable_shared_from_this<MaintenanceManage
   bool shutdown_;
   int32_t polling_interval_ms_;
   int32_t running_ops_;
+  // Number of running ops of each class.
+  int32_t running_ops_per_class_[MaintenanceOp::kNumOpClasses];
+  // Number of running HIGH_IO_USAGE ops which touch each data directory.
+  std::unordered_map<std::string, int32_t> running_ops_per_data_dir_;
+  // Number of runnable ops of each class which aren't running, as of the last
+  // scheduling pass. Null if the manager has no metric entity.
+  scoped_refptr<AtomicGauge<uint32_t>> queued_ops_[MaintenanceOp::kNumOpClasses];
   // Vector used as a circular buffer for recently completed ops. Elements need to be added at
   // the completed_ops_count_ % the vector's size and then the count needs to be incremented.
   std::vector<OpInstance> completed_ops_;
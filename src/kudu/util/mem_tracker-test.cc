@@ -28,16 +28,20 @@
 #include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/mem_tracker.pb.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_int64(mem_tracker_consumption_slack_bytes);
+
 namespace kudu {
 
 using std::equal_to;
@@ -121,6 +125,48 @@ TEST(MemTrackerTest, TrackerHierarchy) {
   c2->Release(60);
 }
 
+TEST(MemTrackerTest, BatchedConsumption) {
+  gflags::FlagSaver saver;
+  const int64_t kMaxBatchBytes = 1000;
+  const int64_t kSlack = kMaxBatchBytes * (base::MaxCPUIndex() + 1);
+  FLAGS_mem_tracker_consumption_slack_bytes = kSlack;
+  shared_ptr<MemTracker> p = MemTracker::CreateTracker(-1, "p");
+  shared_ptr<MemTracker> c = MemTracker::CreateTracker(-1, "c", p);
+  // The consumption of trackers with limits, and of their descendants, isn't
+  // batched.
+  shared_ptr<MemTracker> l = MemTracker::CreateTracker(100, "l", p);
+  shared_ptr<MemTracker> lc = MemTracker::CreateTracker(-1, "lc", l);
+
+  // The consumption is applied to 'c' and 'p' in batches, and lags behind by
+  // less than the slack.
+  c->Consume(10);
+  EXPECT_EQ(0, c->consumption());
+  for (int i = 0; i < 999; i++) {
+    c->Consume(10);
+  }
+  EXPECT_LE(c->consumption(), 10000);
+  EXPECT_GT(c->consumption(), 10000 - kSlack);
+  EXPECT_EQ(c->consumption(), p->consumption());
+
+  lc->Consume(60);
+  EXPECT_EQ(60, lc->consumption());
+  EXPECT_EQ(60, l->consumption());
+  EXPECT_FALSE(l->LimitExceeded());
+  lc->Consume(60);
+  EXPECT_TRUE(l->LimitExceeded());
+  EXPECT_TRUE(lc->AnyLimitExceeded());
+
+  c->FlushBatchedConsumption();
+  EXPECT_EQ(10000, c->consumption());
+  EXPECT_EQ(10120, p->consumption());
+
+  c->Release(10000);
+  lc->Release(120);
+  c->FlushBatchedConsumption();
+  EXPECT_EQ(0, c->consumption());
+  EXPECT_EQ(0, p->consumption());
+}
+
 TEST(MemTrackerTest, TestToPb) {
   shared_ptr<MemTracker> p0 = MemTracker::CreateTracker(100, "p0");
   shared_ptr<MemTracker> c00 = MemTracker::CreateTracker(80, "c00", p0);
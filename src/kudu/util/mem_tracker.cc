@@ -17,23 +17,42 @@
 
 #include "kudu/util/mem_tracker.h"
 
+#include <sched.h>
+
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdlib>
 #include <deque>
 #include <limits>
 #include <list>
 #include <memory>
+#include <new>
 #include <ostream>
 #include <stack>
 #include <type_traits>
 
+#include <gflags/gflags.h>
+
 #include "kudu/gutil/once.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/mem_tracker.pb.h"
 #include "kudu/util/mutex.h"
 #include "kudu/util/process_memory.h"
 
+DEFINE_int64(mem_tracker_consumption_slack_bytes, 0,
+             "Number of bytes by which the consumption of a memory tracker with no limit "
+             "and no ancestors with limits may lag behind the memory it actually tracks. "
+             "If positive, the consumption of such trackers is batched per CPU, and only "
+             "applied to them and their ancestors once the batch of a CPU reaches this "
+             "number of bytes divided by the number of CPUs. This avoids contention on "
+             "trackers updated by many threads at once, such as those of the MemRowSets. "
+             "Only applies to the trackers created after it's set.");
+TAG_FLAG(mem_tracker_consumption_slack_bytes, experimental);
+
 namespace kudu {
 
 // NOTE: this class has been adapted from Impala, so the code style varies
@@ -79,12 +98,17 @@ MemTracker::MemTracker(int64_t byte_limit, const string& id, shared_ptr<MemTrack
       id_(id),
       descr_(Substitute("memory consumption for $0", id)),
       parent_(std::move(parent)),
-      consumption_(0) {
+      consumption_(0),
+      batched_consumption_(nullptr),
+      num_batches_(0),
+      max_batch_bytes_(0) {
   VLOG(1) << "Creating tracker " << ToString();
 }
 
 MemTracker::~MemTracker() {
   VLOG(1) << "Destroying tracker " << ToString();
+  FlushBatchedConsumption();
+  free(batched_consumption_);
   if (parent_) {
     DCHECK(consumption() == 0) << "Memory tracker " << ToString()
         << " has unreleased consumption " << consumption();
@@ -230,6 +254,10 @@ void MemTracker::Consume(int64_t bytes) {
   if (bytes == 0) {
     return;
   }
+  if (batched_consumption_) {
+    BatchConsumption(bytes);
+    return;
+  }
   for (auto& tracker : all_trackers_) {
     tracker->consumption_.IncrementBy(bytes);
   }
@@ -240,6 +268,11 @@ bool MemTracker::TryConsume(int64_t bytes) {
     Release(-bytes);
     return true;
   }
+  if (batched_consumption_) {
+    // There are no limits to enforce.
+    BatchConsumption(bytes);
+    return true;
+  }
 
   int i = 0;
   // Walk the tracker tree top-down, consuming memory from each in turn.
@@ -285,6 +318,10 @@ void MemTracker::Release(int64_t bytes) {
   if (bytes == 0) {
     return;
   }
+  if (batched_consumption_) {
+    BatchConsumption(-bytes);
+    return;
+  }
 
   for (auto& tracker : all_trackers_) {
     tracker->consumption_.IncrementBy(-bytes);
@@ -292,6 +329,46 @@ void MemTracker::Release(int64_t bytes) {
   process_memory::MaybeGCAfterRelease(bytes);
 }
 
+void MemTracker::FlushBatchedConsumption() {
+  if (!batched_consumption_) {
+    return;
+  }
+  int64_t bytes = 0;
+  for (int i = 0; i < num_batches_; i++) {
+    bytes += batched_consumption_[i].value_.exchange(0, std::memory_order_relaxed);
+  }
+  if (bytes != 0) {
+    ApplyConsumption(bytes);
+  }
+}
+
+void MemTracker::BatchConsumption(int64_t bytes) {
+#if defined(__APPLE__)
+  int cpu = 0;
+#else
+  int cpu = sched_getcpu();
+  if (PREDICT_FALSE(cpu < 0)) {
+    cpu = 0;
+  }
+#endif
+  auto& batch = batched_consumption_[cpu % num_batches_].value_;
+  int64_t batched = batch.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  if (PREDICT_FALSE(batched >= max_batch_bytes_ || batched <= -max_batch_bytes_)) {
+    // The thread may have moved to another CPU in the meantime, or another
+    // thread may have updated the batch: apply whatever it holds now.
+    ApplyConsumption(batch.exchange(0, std::memory_order_relaxed));
+  }
+}
+
+void MemTracker::ApplyConsumption(int64_t bytes) {
+  for (auto& tracker : all_trackers_) {
+    tracker->consumption_.IncrementBy(bytes);
+  }
+  if (bytes < 0) {
+    process_memory::MaybeGCAfterRelease(-bytes);
+  }
+}
+
 bool MemTracker::AnyLimitExceeded() {
   for (const auto& tracker : limit_trackers_) {
     if (tracker->LimitExceeded()) {
@@ -321,6 +398,20 @@ void MemTracker::Init() {
   }
   DCHECK_GT(all_trackers_.size(), 0);
   DCHECK_EQ(all_trackers_[0], this);
+
+  // Only batch the consumption of trackers whose limit checks can't be
+  // affected by it.
+  if (FLAGS_mem_tracker_consumption_slack_bytes > 0 && limit_trackers_.empty()) {
+    num_batches_ = base::MaxCPUIndex() + 1;
+    max_batch_bytes_ = FLAGS_mem_tracker_consumption_slack_bytes / num_batches_;
+    if (max_batch_bytes_ > 0) {
+      void* buf;
+      int err = posix_memalign(&buf, CACHELINE_SIZE,
+                               sizeof(striped64::internal::Cell) * num_batches_);
+      CHECK_EQ(0, err) << "error calling posix_memalign";
+      batched_consumption_ = new (buf) striped64::internal::Cell[num_batches_];
+    }
+  }
 }
 
 void MemTracker::AddChildTracker(const shared_ptr<MemTracker>& tracker) {
@@ -28,6 +28,7 @@
 
 #include "kudu/util/high_water_mark.h"
 #include "kudu/util/mutex.h"
+#include "kudu/util/striped64.h"
 
 namespace kudu {
 
@@ -56,6 +57,15 @@ class MemTrackerPB;
 // Memory consumption is tracked via calls to Consume()/Release(), either to
 // the tracker itself or to one of its descendants.
 //
+// If --mem_tracker_consumption_slack_bytes is positive, the consumption of
+// the trackers which have no limit and no ancestors with limits is batched
+// per CPU: it's only applied to them and their ancestors once the batch of a
+// CPU is large enough, so that the trackers updated by many threads at once
+// aren't contended. The consumption of such a tracker may then lag behind by
+// up to the slack, plus the slack of each of its batching descendants. The
+// consumption of trackers with limits, and thus their limit checks, is always
+// exact.
+//
 // This class is thread-safe.
 class MemTracker : public std::enable_shared_from_this<MemTracker> {
  public:
@@ -123,6 +133,10 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   // to ensure that memory is released to the OS.
   void Release(int64_t bytes);
 
+  // Applies the consumption batched on all CPUs to this tracker and its
+  // ancestors. A no-op if the consumption of this tracker isn't batched.
+  void FlushBatchedConsumption();
+
   // Returns true if a valid limit of this tracker or one of its ancestors is
   // exceeded.
   bool AnyLimitExceeded();
@@ -166,6 +180,13 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   // Further initializes the tracker.
   void Init();
 
+  // Adds 'bytes' to the consumption batched on the current CPU, applying the
+  // batch to the trackers once it's large enough.
+  void BatchConsumption(int64_t bytes);
+
+  // Adds 'bytes' to the consumption of this tracker and its ancestors.
+  void ApplyConsumption(int64_t bytes);
+
   // Adds tracker to child_trackers_.
   void AddChildTracker(const std::shared_ptr<MemTracker>& tracker);
 
@@ -190,6 +211,13 @@ class MemTracker : public std::enable_shared_from_this<MemTracker> {
   // all_trackers_ with valid limits
   std::vector<MemTracker*> limit_trackers_;
 
+  // The consumption batched on each CPU (modulo 'num_batches_') that hasn't
+  // been applied yet, or null if the consumption of this tracker isn't batched.
+  striped64::internal::Cell* batched_consumption_;
+  int num_batches_;
+  // A batch is applied once its absolute value reaches this many bytes.
+  int64_t max_batch_bytes_;
+
   // All the child trackers of this tracker. Used for error reporting and
   // listing only (i.e. updating the consumption of a parent tracker does not
   // update that of its children).
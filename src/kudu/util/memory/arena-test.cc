@@ -273,4 +273,35 @@ TEST(TestArena, TestSTLAllocator) {
   }
 }
 
+TEST(TestArena, TestHugePageAllocator) {
+  const size_t kHugePageSize = HugePageBufferAllocator::kHugePageSize;
+  shared_ptr<MemTracker> mem_tracker = MemTracker::CreateTracker(-1, "arena-test-tracker");
+  shared_ptr<MemoryTrackingBufferAllocator> allocator(
+      new MemoryTrackingBufferAllocator(HugePageBufferAllocator::Get(), mem_tracker));
+  ThreadSafeMemoryTrackingArena arena(256, allocator);
+  arena.SetMaxBufferSize(kHugePageSize);
+
+  // Fill more than a few huge pages, and check that the chunks of a huge page
+  // are aligned on the huge page size.
+  vector<uint8_t*> allocs;
+  for (int i = 0; i < 4 * 1024; i++) {
+    auto* p = static_cast<uint8_t*>(arena.AllocateBytes(4096));
+    ASSERT_TRUE(p);
+    memset(p, i & 0xff, 4096);
+    allocs.push_back(p);
+  }
+  ASSERT_GE(arena.memory_footprint(), 4 * 1024 * 4096);
+  int num_aligned = 0;
+  for (auto* p : allocs) {
+    if (reinterpret_cast<uintptr_t>(p) % kHugePageSize == 0) {
+      num_aligned++;
+    }
+  }
+  ASSERT_GE(num_aligned, 4);
+  for (int i = 0; i < static_cast<int>(allocs.size()); i++) {
+    ASSERT_EQ(i & 0xff, allocs[i][0]);
+    ASSERT_EQ(i & 0xff, allocs[i][4095]);
+  }
+}
+
 } // namespace kudu
@@ -116,6 +116,9 @@ class ArenaBase {
   //
   // Overall, if you aren't sure, just leave it at the default.
   //
+  // Sizes above the default are only allowed for the huge page size, for
+  // arenas which allocate from a HugePageBufferAllocator.
+  //
   // NOTE: this method is not thread-safe, even in the thread-safe variant.
   // It is expected to call this only immediately after constructing the
   // Arena instance, but before making any allocations.
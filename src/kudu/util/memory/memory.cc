@@ -21,15 +21,24 @@
 #include "kudu/util/memory/memory.h"
 
 #include <mm_malloc.h>
+#include <sys/mman.h>
+#if !defined(__APPLE__)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
 
 #include <gflags/gflags.h>
 
 #include "kudu/util/alignment.h"
+#include "kudu/util/errno.h"
 #include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
 #include "kudu/util/memory/overwrite.h"
 #include "kudu/util/mem_tracker.h"
 
@@ -44,11 +53,87 @@ DEFINE_bool(allocator_aligned_mode, false,
             "unless explicitly specified otherwise - to boost SIMD");
 TAG_FLAG(allocator_aligned_mode, hidden);
 
+DEFINE_bool(arena_hugetlb, false,
+            "Whether arenas backed by huge pages first try to map pages from the "
+            "kernel's hugetlbfs pool (see /proc/sys/vm/nr_hugepages) rather than "
+            "transparent huge pages. Falls back to transparent huge pages when the "
+            "pool is exhausted.");
+TAG_FLAG(arena_hugetlb, advanced);
+TAG_FLAG(arena_hugetlb, experimental);
+
+DEFINE_bool(arena_huge_pages_numa_local, false,
+            "Whether the memory of arenas backed by huge pages is bound to the "
+            "NUMA node of the thread which allocates it.");
+TAG_FLAG(arena_huge_pages_numa_local, advanced);
+TAG_FLAG(arena_huge_pages_numa_local, experimental);
+
 namespace kudu {
 
 namespace {
 static char dummy_buffer[0] = {};
+
+#if !defined(__APPLE__)
+// Sets the memory policy of the 'size' bytes at 'data' to prefer the NUMA node
+// of the current thread. Must be called before the memory is first touched.
+void BindToLocalNumaNode(void* data, size_t size) {
+  constexpr int kMaxNodes = 1024;
+  constexpr int kBitsPerLong = 8 * sizeof(unsigned long);
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= kMaxNodes) {
+    return;
+  }
+  unsigned long nodemask[kMaxNodes / kBitsPerLong] = {};
+  nodemask[node / kBitsPerLong] |= 1UL << (node % kBitsPerLong);
+  // The kernel reads 'maxnode - 1' bits of the mask.
+  if (syscall(SYS_mbind, data, size, MPOL_PREFERRED, nodemask, kMaxNodes + 1, 0) != 0) {
+    int err = errno;
+    KLOG_FIRST_N(WARNING, 1) << "Could not bind arena memory to NUMA node " << node
+                             << ": " << ErrnoToString(err);
+  }
+}
+#endif
+
+// Maps 'size' bytes, a multiple of the huge page size, aligned on the huge
+// page size and backed by huge pages. Returns nullptr on failure.
+void* MapHugePages(size_t size) {
+  constexpr size_t kAlign = HugePageBufferAllocator::kHugePageSize;
+  void* data = MAP_FAILED;
+#if !defined(__APPLE__)
+  if (FLAGS_arena_hugetlb) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+#endif
+  if (data == MAP_FAILED) {
+    // Map one more huge page than needed, and trim the mapping down to the
+    // aligned range.
+    void* raw = mmap(nullptr, size + kAlign, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+      return nullptr;
+    }
+    char* start = static_cast<char*>(raw);
+    char* aligned = reinterpret_cast<char*>(
+        KUDU_ALIGN_UP(reinterpret_cast<uintptr_t>(start), kAlign));
+    if (aligned > start) {
+      munmap(start, aligned - start);
+    }
+    munmap(aligned + size, start + kAlign - aligned);
+    data = aligned;
+#if defined(MADV_HUGEPAGE)
+    // Failures only cost the TLB benefit, e.g. if transparent huge pages are disabled.
+    madvise(data, size, MADV_HUGEPAGE);
+#endif
+  }
+#if !defined(__APPLE__)
+  if (FLAGS_arena_huge_pages_numa_local) {
+    BindToLocalNumaNode(data, size);
+  }
+#endif
+  return data;
 }
+} // anonymous namespace
 
 Buffer::~Buffer() {
 #if !defined(NDEBUG) && !defined(ADDRESS_SANITIZER)
@@ -168,6 +253,76 @@ void* HeapBufferAllocator::Realloc(void* previous_data, size_t previous_size,
   }
 }
 
+const size_t HugePageBufferAllocator::kHugePageSize;
+
+Buffer* HugePageBufferAllocator::AllocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    BufferAllocator* const originator) {
+  DCHECK_LE(minimal, requested);
+  void* data;
+  size_t attempted = requested;
+  while (true) {
+    data = (attempted == 0) ? &dummy_buffer[0] : Allocate(attempted);
+    if (data != nullptr) {
+      return CreateBuffer(data, attempted, originator);
+    }
+    if (attempted == minimal) return nullptr;
+    attempted = minimal + (attempted - minimal - 1) / 2;
+  }
+}
+
+bool HugePageBufferAllocator::ReallocateInternal(
+    const size_t requested,
+    const size_t minimal,
+    Buffer* const buffer,
+    BufferAllocator* const originator) {
+  DCHECK_LE(minimal, requested);
+  void* data;
+  size_t attempted = requested;
+  while (true) {
+    if (buffer->size() > 0 && buffer->size() < kHugePageSize &&
+        attempted > 0 && attempted < kHugePageSize) {
+      // Both the old and the new buffers live on the heap.
+      data = realloc(buffer->data(), attempted);
+    } else {
+      data = (attempted == 0) ? &dummy_buffer[0] : Allocate(attempted);
+      if (data != nullptr) {
+        memcpy(data, buffer->data(), min(buffer->size(), attempted));
+        Free(buffer->data(), buffer->size());
+      }
+    }
+    if (data != nullptr) {
+      UpdateBuffer(data, attempted, buffer);
+      return true;
+    }
+    if (attempted == minimal) return false;
+    attempted = minimal + (attempted - minimal - 1) / 2;
+  }
+}
+
+void HugePageBufferAllocator::FreeInternal(Buffer* buffer) {
+  Free(buffer->data(), buffer->size());
+}
+
+void* HugePageBufferAllocator::Allocate(size_t size) {
+  if (size < kHugePageSize) {
+    return malloc(size);
+  }
+  return MapHugePages(KUDU_ALIGN_UP(size, kHugePageSize));
+}
+
+void HugePageBufferAllocator::Free(void* data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  if (size < kHugePageSize) {
+    free(data);
+  } else {
+    munmap(data, KUDU_ALIGN_UP(size, kHugePageSize));
+  }
+}
+
 Buffer* ClearingBufferAllocator::AllocateInternal(size_t requested,
                                                   size_t minimal,
                                                   BufferAllocator* originator) {
@@ -282,6 +282,55 @@ class HeapBufferAllocator : public BufferAllocator {
   DISALLOW_COPY_AND_ASSIGN(HeapBufferAllocator);
 };
 
+// Allocates buffers of at least kHugePageSize bytes as anonymous memory
+// mappings aligned on kHugePageSize and backed by huge pages, and smaller
+// buffers on the heap like HeapBufferAllocator. Meant for arenas which grow
+// to gigabytes and are accessed randomly, where 4KB pages incur many TLB misses.
+//
+// The huge pages are transparent huge pages (madvise(MADV_HUGEPAGE)), unless
+// --arena_hugetlb is set, in which case pages of the kernel's hugetlbfs pool
+// are tried first. If --arena_huge_pages_numa_local is set, the mappings are
+// bound to the NUMA node of the allocating thread.
+class HugePageBufferAllocator : public BufferAllocator {
+ public:
+  static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+  virtual ~HugePageBufferAllocator() {}
+
+  // Returns a singleton instance of the huge page allocator.
+  static HugePageBufferAllocator* Get() {
+    return Singleton<HugePageBufferAllocator>::get();
+  }
+
+  virtual size_t Available() const OVERRIDE {
+    return std::numeric_limits<size_t>::max();
+  }
+
+ private:
+  friend class Singleton<HugePageBufferAllocator>;
+
+  HugePageBufferAllocator() {}
+
+  // Always allocates 'requested'-sized buffer, or returns NULL on OOM.
+  virtual Buffer* AllocateInternal(size_t requested,
+                                   size_t minimal,
+                                   BufferAllocator* originator) OVERRIDE;
+
+  virtual bool ReallocateInternal(size_t requested,
+                                  size_t minimal,
+                                  Buffer* buffer,
+                                  BufferAllocator* originator) OVERRIDE;
+
+  virtual void FreeInternal(Buffer* buffer) OVERRIDE;
+
+  // Allocates and frees 'size' bytes, mapping huge pages if 'size' is at
+  // least kHugePageSize.
+  static void* Allocate(size_t size);
+  static void Free(void* data, size_t size);
+
+  DISALLOW_COPY_AND_ASSIGN(HugePageBufferAllocator);
+};
+
 // Wrapper around the delegate allocator, that clears all newly allocated
 // (and reallocated) memory.
 class ClearingBufferAllocator : public BufferAllocator {
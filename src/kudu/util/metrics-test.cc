@@ -23,6 +23,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -36,6 +37,7 @@
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/jsonreader.h"
 #include "kudu/util/jsonwriter.h"
@@ -51,6 +53,7 @@ using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 
+DECLARE_int32(metrics_histogram_shards);
 DECLARE_int32(metrics_retirement_age_ms);
 
 DECLARE_string(metrics_default_level);
@@ -488,6 +491,40 @@ TEST_F(MetricsTest, SimpleHistogramMergeTest) {
   ASSERT_EQ(18, hist_for_merge->histogram()->TotalSum());
 }
 
+// Test that the values recorded into the shards of a sharded histogram from
+// many threads are all merged when the histogram is read.
+TEST_F(MetricsTest, ShardedHistogramTest) {
+  FLAGS_metrics_histogram_shards = 4;
+  scoped_refptr<Histogram> hist = METRIC_test_hist.Instantiate(entity_);
+  constexpr int kNumThreads = 8;
+  constexpr int kNumValuesPerThread = 1000;
+  vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 1; i <= kNumValuesPerThread; i++) {
+        hist->Increment(i);
+        if (i % 100 == 0) {
+          // Reads merge the shards while values are being recorded.
+          ASSERT_GT(hist->TotalCount(), 0);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(kNumThreads * kNumValuesPerThread, hist->TotalCount());
+  ASSERT_EQ(kNumThreads * kNumValuesPerThread * (kNumValuesPerThread + 1) / 2,
+            hist->histogram()->TotalSum());
+  ASSERT_EQ(1, hist->MinValueForTests());
+  ASSERT_EQ(kNumValuesPerThread, hist->MaxValueForTests());
+  ASSERT_EQ(kNumThreads, hist->CountInBucketForValueForTests(kNumValuesPerThread));
+
+  // Snapshots include the values of the shards too.
+  scoped_refptr<Histogram> snapshot(down_cast<Histogram*>(hist->snapshot().get()));
+  ASSERT_EQ(kNumThreads * kNumValuesPerThread, snapshot->TotalCount());
+}
+
 TEST_F(MetricsTest, JsonPrintTest) {
   scoped_refptr<Counter> test_counter = METRIC_test_counter.Instantiate(entity_);
   test_counter->Increment();
@@ -693,6 +730,67 @@ TEST_F(MetricsTest, CollectTest) {
 }
 
 // Test that metrics are retired when they are no longer referenced.
+TEST_F(MetricsTest, PrometheusTest) {
+  scoped_refptr<Counter> test_counter = METRIC_test_counter.Instantiate(entity_);
+  test_counter->Increment();
+  METRIC_test_counter.Instantiate(entity_same_attr_)->IncrementBy(10);
+  METRIC_test_counter.Instantiate(entity_diff_attr_)->IncrementBy(100);
+  scoped_refptr<AtomicGauge<uint64_t>> test_gauge = METRIC_test_gauge.Instantiate(entity_, 0);
+  test_gauge->IncrementBy(2);
+  scoped_refptr<MeanGauge> test_mean_gauge = METRIC_test_mean_gauge.InstantiateMeanGauge(entity_);
+  test_mean_gauge->set_value(5, 2);
+  scoped_refptr<Histogram> hist = METRIC_test_hist.Instantiate(entity_);
+  hist->IncrementBy(10, 3);
+  entity_->SetAttribute("test \"attr\"", "attr\\val");
+
+  {
+    std::ostringstream out;
+    ASSERT_OK(registry_.WriteAsPrometheus(&out, MetricJsonOptions()));
+    const string output = out.str();
+    const string labels =
+        R"(id="my-test-same-attr1",attr_for_merge="same_attr",test__attr_="attr\\val")";
+    ASSERT_STR_CONTAINS(output, "# HELP kudu_test_entity_test_counter "
+                                "Description of test counter\n"
+                                "# TYPE kudu_test_entity_test_counter counter\n");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_counter{" + labels + "} 1\n");
+    ASSERT_STR_CONTAINS(output, "# TYPE kudu_test_entity_test_gauge gauge\n");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_gauge{" + labels + "} 2\n");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_mean_gauge{" + labels + "} 2.5\n");
+    ASSERT_STR_CONTAINS(output, "# TYPE kudu_test_entity_test_hist summary\n");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_hist{" + labels + R"(,quantile="0.99"} 10)");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_hist_sum{" + labels + "} 30\n");
+    ASSERT_STR_CONTAINS(output, "kudu_test_entity_test_hist_count{" + labels + "} 3\n");
+
+    // The HELP and TYPE lines of a metric are written once for all entities.
+    vector<string> parts = strings::Split(output, "# TYPE kudu_test_entity_test_counter ");
+    ASSERT_EQ(2, parts.size());
+    ASSERT_STR_CONTAINS(output, R"(kudu_test_entity_test_counter{id="my-test-diff-attr",)"
+                                R"(attr_for_merge="diff_attr"} 100)");
+  }
+
+  // The entities can be filtered, and merged.
+  {
+    MetricJsonOptions opts;
+    opts.filters.entity_metrics.emplace_back("test_counter");
+    opts.merge_rules.emplace("test_entity", MergeAttributes("merged_entity", "attr_for_merge"));
+    std::ostringstream out;
+    ASSERT_OK(registry_.WriteAsPrometheus(&out, opts));
+    const string output = out.str();
+    ASSERT_STR_CONTAINS(output, R"(kudu_merged_entity_test_counter{id="same_attr"} 11)");
+    ASSERT_STR_CONTAINS(output, R"(kudu_merged_entity_test_counter{id="diff_attr"} 100)");
+    ASSERT_STR_NOT_CONTAINS(output, "test_gauge");
+    ASSERT_STR_NOT_CONTAINS(output, "kudu_test_entity");
+  }
+
+  // String gauges aren't written.
+  {
+    scoped_refptr<StringGauge> state = new StringGauge(&METRIC_test_string_gauge, "Healthy");
+    std::ostringstream out;
+    state->WriteAsPrometheus(&out, "kudu_test_entity_test_string_gauge", "", true);
+    ASSERT_TRUE(out.str().empty());
+  }
+}
+
 TEST_F(MetricsTest, RetirementTest) {
   FLAGS_metrics_retirement_age_ms = 100;
 
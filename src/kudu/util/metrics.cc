@@ -16,7 +16,13 @@
 // under the License.
 #include "kudu/util/metrics.h"
 
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <map>
 #include <utility>
 
 #include <gflags/gflags.h>
@@ -24,8 +30,11 @@
 
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/singleton.h"
+#include "kudu/gutil/strings/ascii_ctype.h"
 #include "kudu/gutil/strings/join.h"
+#include "kudu/gutil/strings/numbers.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/sysinfo.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/hdr_histogram.h"
 #include "kudu/util/histogram.pb.h"
@@ -38,6 +47,18 @@ DEFINE_int32(metrics_retirement_age_ms, 120 * 1000,
 TAG_FLAG(metrics_retirement_age_ms, runtime);
 TAG_FLAG(metrics_retirement_age_ms, advanced);
 
+DEFINE_int32(metrics_histogram_shards, 0,
+             "The number of shards which histogram metrics record values into, "
+             "each shard being used by the CPUs with the same index modulo the "
+             "number of shards. Sharding avoids contention on the histograms "
+             "recorded to by many threads at once, e.g. operation latencies, "
+             "at the cost of merging the shards when the metrics are read and "
+             "of the memory of up to this many extra copies of each histogram. "
+             "Values of 0 or 1 disable sharding. Only affects the histograms "
+             "created after the flag is set.");
+TAG_FLAG(metrics_histogram_shards, advanced);
+TAG_FLAG(metrics_histogram_shards, experimental);
+
 // Process/server-wide metrics should go into the 'server' entity.
 // More complex applications will define other entities.
 METRIC_DEFINE_entity(server);
@@ -45,10 +66,71 @@ METRIC_DEFINE_entity(server);
 namespace kudu {
 
 using std::string;
+using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 using strings::Substitute;
 
+namespace {
+
+// Returns 'name' with the characters not allowed in the names of Prometheus
+// metrics and labels replaced by underscores.
+string PrometheusName(const string& name) {
+  string result = name;
+  for (int i = 0; i < result.size(); i++) {
+    if (!(ascii_isalnum(result[i]) || result[i] == '_') ||
+        (i == 0 && ascii_isdigit(result[i]))) {
+      result[i] = '_';
+    }
+  }
+  return result;
+}
+
+// Returns 'str' escaped for the HELP line of a Prometheus metric family or,
+// if 'escape_quotes' is true, for the value of a Prometheus label.
+string PrometheusEscape(const string& str, bool escape_quotes) {
+  string result;
+  result.reserve(str.size());
+  for (char c : str) {
+    if (c == '\\') {
+      result.append("\\\\");
+    } else if (c == '\n') {
+      result.append("\\n");
+    } else if (c == '"' && escape_quotes) {
+      result.append("\\\"");
+    } else {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+string PrometheusLabel(const string& name, const string& value) {
+  return Substitute("$0=\"$1\"", PrometheusName(name), PrometheusEscape(value, true));
+}
+
+// Returns the label set of a sample with the labels 'labels', and 'extra_label'
+// if not empty.
+string PrometheusLabelSet(const string& labels, const string& extra_label = "") {
+  if (labels.empty() && extra_label.empty()) {
+    return "";
+  }
+  if (labels.empty() || extra_label.empty()) {
+    return Substitute("{$0$1}", labels, extra_label);
+  }
+  return Substitute("{$0,$1}", labels, extra_label);
+}
+
+void WritePrometheusHeader(std::ostream* out,
+                           const string& name,
+                           const MetricPrototype* prototype,
+                           const char* type) {
+  *out << "# HELP " << name << ' ' << PrometheusEscape(prototype->description(), false) << '\n';
+  *out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+} // anonymous namespace
+
 template<typename Collection>
 void WriteMetricsToJson(JsonWriter* writer,
                         const Collection& metrics,
@@ -68,6 +150,24 @@ void WriteMetricsToJson(JsonWriter* writer,
   writer->EndArray();
 }
 
+template<typename Collection>
+void WriteMetricsAsPrometheus(std::ostream* out,
+                              const string& entity_type,
+                              const string& labels,
+                              const Collection& metrics,
+                              const MetricJsonOptions& opts,
+                              unordered_set<string>* families) {
+  for (const auto& val : metrics) {
+    const auto& m = val.second;
+    if (!m->ModifiedInOrAfterEpoch(opts.only_modified_in_or_after_epoch) ||
+        (!opts.include_untouched_metrics && m->IsUntouched())) {
+      continue;
+    }
+    const string name = PrometheusName(Substitute("kudu_$0_$1", entity_type, val.first->name()));
+    m->WriteAsPrometheus(out, name, labels, families->insert(name).second);
+  }
+}
+
 void WriteToJson(JsonWriter* writer,
                  const MergedEntityMetrics &merged_entity_metrics,
                  const MetricJsonOptions &opts) {
@@ -392,6 +492,30 @@ Status MetricEntity::WriteAsJson(JsonWriter* writer, const MetricJsonOptions& op
   return Status::OK();
 }
 
+Status MetricEntity::WriteAsPrometheus(std::ostream* out,
+                                      const MetricJsonOptions& opts,
+                                      unordered_set<string>* families) const {
+  MetricMap metrics;
+  AttributeMap attrs;
+  Status s = GetMetricsAndAttrs(opts.filters, &metrics, &attrs);
+  if (s.IsNotFound()) {
+    // Status::NotFound is returned when this entity has been filtered, treat it
+    // as OK, and skip printing it.
+    return Status::OK();
+  }
+
+  string labels = PrometheusLabel("id", id_);
+  if (opts.include_entity_attributes) {
+    // Sorted so that the labels of an entity are written in the same order.
+    for (const auto& attr : std::map<string, string>(attrs.begin(), attrs.end())) {
+      labels += ",";
+      labels += PrometheusLabel(attr.first, attr.second);
+    }
+  }
+  WriteMetricsAsPrometheus(out, prototype_->name(), labels, metrics, opts, families);
+  return Status::OK();
+}
+
 Status MetricEntity::CollectTo(MergedEntityMetrics* collections,
                                const MetricFilters& filters,
                                const MetricMergeRules& merge_rules) const {
@@ -540,6 +664,51 @@ Status MetricRegistry::WriteAsJson(JsonWriter* writer, const MetricJsonOptions&
   return Status::OK();
 }
 
+Status MetricRegistry::WriteAsPrometheus(std::ostream* out,
+                                        const MetricJsonOptions& opts) const {
+  EntityMap entities;
+  {
+    std::lock_guard<simple_spinlock> l(lock_);
+    entities = entities_;
+  }
+
+  // Each entity is written to 'out' as soon as it's rendered, so a failure
+  // to write stops the rendering of the rest.
+  unordered_set<string> families;
+  if (opts.merge_rules.empty()) {
+    for (const auto& e : entities) {
+      WARN_NOT_OK(e.second->WriteAsPrometheus(out, opts, &families),
+                  Substitute("Failed to write entity $0 as Prometheus", e.second->id()));
+      if (!out->good()) {
+        break;
+      }
+    }
+  } else {
+    MergedEntityMetrics collections;
+    for (const auto& e : entities) {
+      WARN_NOT_OK(e.second->CollectTo(&collections, opts.filters, opts.merge_rules),
+                  Substitute("Failed to collect entity $0", e.second->id()));
+    }
+    for (const auto& entity_metrics : collections) {
+      WriteMetricsAsPrometheus(out, entity_metrics.first.type_,
+                               PrometheusLabel("id", entity_metrics.first.id_),
+                               entity_metrics.second, opts, &families);
+      if (!out->good()) {
+        break;
+      }
+    }
+  }
+  const bool write_failed = !out->good();
+
+  // See WriteAsJson().
+  entities.clear();
+  const_cast<MetricRegistry*>(this)->RetireOldMetrics();
+  if (write_failed) {
+    return Status::IOError("failed to write metrics in the Prometheus format");
+  }
+  return Status::OK();
+}
+
 void MetricRegistry::RetireOldMetrics() {
   std::lock_guard<simple_spinlock> l(lock_);
   for (auto it = entities_.begin(); it != entities_.end();) {
@@ -722,6 +891,30 @@ Status Gauge::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+void Gauge::WriteAsPrometheus(std::ostream* out,
+                              const string& name,
+                              const string& labels,
+                              bool write_header) const {
+  if (write_header) {
+    // Gauges may be exposed as counters, see EXPOSE_AS_COUNTER.
+    WritePrometheusHeader(out, name, prototype_,
+                          prototype_->type() == MetricType::kCounter ? "counter" : "gauge");
+  }
+  *out << name << PrometheusLabelSet(labels) << ' ';
+  WritePrometheusValue(out);
+  *out << '\n';
+}
+
+void WritePrometheusSampleValue(std::ostream* out, double value) {
+  if (std::isnan(value)) {
+    *out << "NaN";
+  } else if (std::isinf(value)) {
+    *out << (value > 0 ? "+Inf" : "-Inf");
+  } else {
+    *out << SimpleDtoa(value);
+  }
+}
+
 //
 // StringGauge
 //
@@ -853,6 +1046,10 @@ void MeanGauge::WriteValue(JsonWriter* writer) const {
   writer->Double(total_count());
 }
 
+void MeanGauge::WritePrometheusValue(std::ostream* out) const {
+  WritePrometheusSampleValue(out, value());
+}
+
 //
 // Counter
 //
@@ -891,6 +1088,16 @@ Status Counter::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+void Counter::WriteAsPrometheus(std::ostream* out,
+                                const string& name,
+                                const string& labels,
+                                bool write_header) const {
+  if (write_header) {
+    WritePrometheusHeader(out, name, prototype_, "counter");
+  }
+  *out << name << PrometheusLabelSet(labels) << ' ' << value() << '\n';
+}
+
 /////////////////////////////////////////////////
 // HistogramPrototype
 /////////////////////////////////////////////////
@@ -918,24 +1125,81 @@ scoped_refptr<Histogram> HistogramPrototype::Instantiate(
 // Histogram
 /////////////////////////////////////////////////
 
+namespace {
+
+int NumHistogramShards() {
+#if defined(__APPLE__)
+  return 0;
+#else
+  const int num_shards = std::min(FLAGS_metrics_histogram_shards, base::MaxCPUIndex() + 1);
+  return num_shards > 1 ? num_shards : 0;
+#endif
+}
+
+} // anonymous namespace
+
 Histogram::Histogram(const HistogramPrototype* proto)
   : Metric(proto),
-    histogram_(new HdrHistogram(proto->max_trackable_value(), proto->num_sig_digits())) {
+    histogram_(new HdrHistogram(proto->max_trackable_value(), proto->num_sig_digits())),
+    num_shards_(NumHistogramShards()),
+    shards_(num_shards_ > 0 ? new std::atomic<HdrHistogram*>[num_shards_]() : nullptr) {
 }
 
 Histogram::Histogram(const HistogramPrototype* proto, const HdrHistogram& hdr_hist)
   : Metric(proto),
-    histogram_(new HdrHistogram(hdr_hist)) {
+    histogram_(new HdrHistogram(hdr_hist)),
+    num_shards_(0) {
+}
+
+Histogram::~Histogram() {
+  for (int i = 0; i < num_shards_; i++) {
+    delete shards_[i].load(std::memory_order_relaxed);
+  }
+}
+
+HdrHistogram* Histogram::RecordingHistogram() {
+  if (num_shards_ == 0) {
+    return histogram_.get();
+  }
+#if defined(__APPLE__)
+  int cpu = 0;
+#else
+  int cpu = sched_getcpu();
+  if (PREDICT_FALSE(cpu < 0)) {
+    cpu = 0;
+  }
+#endif
+  auto& shard = shards_[cpu % num_shards_];
+  HdrHistogram* hist = shard.load(std::memory_order_acquire);
+  if (PREDICT_FALSE(hist == nullptr)) {
+    std::unique_ptr<HdrHistogram> new_hist(
+        new HdrHistogram(histogram_->highest_trackable_value(),
+                         histogram_->num_significant_digits()));
+    if (shard.compare_exchange_strong(hist, new_hist.get(), std::memory_order_acq_rel)) {
+      hist = new_hist.release();
+    }
+    // Otherwise, 'hist' was set to the shard another thread installed.
+  }
+  return hist;
+}
+
+void Histogram::MergeShards() const {
+  for (int i = 0; i < num_shards_; i++) {
+    HdrHistogram* shard = shards_[i].load(std::memory_order_acquire);
+    if (shard) {
+      shard->DrainInto(histogram_.get());
+    }
+  }
 }
 
 void Histogram::Increment(int64_t value) {
   UpdateModificationEpoch();
-  histogram_->Increment(value);
+  RecordingHistogram()->Increment(value);
 }
 
 void Histogram::IncrementBy(int64_t value, int64_t amount) {
   UpdateModificationEpoch();
-  histogram_->IncrementBy(value, amount);
+  RecordingHistogram()->IncrementBy(value, amount);
 }
 
 Status Histogram::WriteAsJson(JsonWriter* writer,
@@ -947,21 +1211,60 @@ Status Histogram::WriteAsJson(JsonWriter* writer,
   return Status::OK();
 }
 
+void Histogram::WriteAsPrometheus(std::ostream* out,
+                                  const string& name,
+                                  const string& labels,
+                                  bool write_header) const {
+  if (write_header) {
+    WritePrometheusHeader(out, name, prototype_, "summary");
+  }
+  // As in GetHistogramSnapshotPB(), empty histograms aren't copied.
+  const HdrHistogram* hist = histogram();
+  unique_ptr<HdrHistogram> snapshot;
+  if (hist->TotalCount() > 0) {
+    snapshot.reset(new HdrHistogram(*hist));
+  }
+  auto write_quantile = [&](const char* quantile, uint64_t value) {
+    *out << name << PrometheusLabelSet(labels, Substitute("quantile=\"$0\"", quantile))
+         << ' ' << value << '\n';
+  };
+  static const struct {
+    const char* quantile;
+    double percentile;
+  } kQuantiles[] = {
+    { "0.75", 75 },
+    { "0.95", 95 },
+    { "0.99", 99 },
+    { "0.999", 99.9 },
+    { "0.9999", 99.99 },
+  };
+  write_quantile("0", snapshot ? snapshot->MinValue() : 0);
+  for (const auto& q : kQuantiles) {
+    write_quantile(q.quantile, snapshot ? snapshot->ValueAtPercentile(q.percentile) : 0);
+  }
+  write_quantile("1", snapshot ? snapshot->MaxValue() : 0);
+  *out << name << "_sum" << PrometheusLabelSet(labels) << ' '
+       << (snapshot ? snapshot->TotalSum() : 0) << '\n';
+  *out << name << "_count" << PrometheusLabelSet(labels) << ' '
+       << (snapshot ? snapshot->TotalCount() : 0) << '\n';
+}
+
 Status Histogram::GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
                                          const MetricJsonOptions& opts) const {
+  const HdrHistogram* hist = histogram();
   snapshot_pb->set_name(prototype_->name());
   if (opts.include_schema_info) {
     snapshot_pb->set_type(MetricType::Name(prototype_->type()));
     snapshot_pb->set_label(prototype_->label());
     snapshot_pb->set_unit(MetricUnit::Name(prototype_->unit()));
     snapshot_pb->set_description(prototype_->description());
-    snapshot_pb->set_max_trackable_value(histogram_->highest_trackable_value());
-    snapshot_pb->set_num_significant_digits(histogram_->num_significant_digits());
+    snapshot_pb->set_max_trackable_value(hist->highest_trackable_value());
+    snapshot_pb->set_num_significant_digits(hist->num_significant_digits());
   }
   // Fast-path for a reasonably common case of an empty histogram. This occurs
   // when a histogram is tracking some information about a feature not in
   // use, for example.
-  if (histogram_->TotalCount() == 0) {
+  if (hist->TotalCount() == 0) {
     snapshot_pb->set_total_count(0);
     snapshot_pb->set_total_sum(0);
     snapshot_pb->set_min(0);
@@ -973,7 +1276,7 @@ Status Histogram::GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
     snapshot_pb->set_percentile_99_99(0);
     snapshot_pb->set_max(0);
   } else {
-    HdrHistogram snapshot(*histogram_);
+    HdrHistogram snapshot(*hist);
     snapshot_pb->set_total_count(snapshot.TotalCount());
     snapshot_pb->set_total_sum(snapshot.TotalSum());
     snapshot_pb->set_min(snapshot.MinValue());
@@ -999,22 +1302,22 @@ Status Histogram::GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
 }
 
 uint64_t Histogram::CountInBucketForValueForTests(uint64_t value) const {
-  return histogram_->CountInBucketForValue(value);
+  return histogram()->CountInBucketForValue(value);
 }
 
 uint64_t Histogram::TotalCount() const {
-  return histogram_->TotalCount();
+  return histogram()->TotalCount();
 }
 
 uint64_t Histogram::MinValueForTests() const {
-  return histogram_->MinValue();
+  return histogram()->MinValue();
 }
 
 uint64_t Histogram::MaxValueForTests() const {
-  return histogram_->MaxValue();
+  return histogram()->MaxValue();
 }
 double Histogram::MeanValueForTests() const {
-  return histogram_->MeanValue();
+  return histogram()->MeanValue();
 }
 
 ScopedLatencyMetric::ScopedLatencyMetric(Histogram* latency_hist)
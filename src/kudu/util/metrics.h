@@ -236,6 +236,7 @@
 #include <mutex>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -665,6 +666,11 @@ class MetricEntity : public RefCountedThreadSafe<MetricEntity> {
   // See MetricRegistry::WriteAsJson()
   Status WriteAsJson(JsonWriter* writer, const MetricJsonOptions& opts) const;
 
+  // See MetricRegistry::WriteAsPrometheus(). 'families' holds the names of the
+  // metric families whose HELP and TYPE lines were already written.
+  Status WriteAsPrometheus(std::ostream* out, const MetricJsonOptions& opts,
+                           std::unordered_set<std::string>* families) const;
+
   // Collect metrics of this entity to 'collections'. Metrics will be filtered by 'filters',
   // and will be merged under the rule of 'merge_rules'.
   Status CollectTo(MergedEntityMetrics* collections,
@@ -757,6 +763,15 @@ class Metric : public RefCountedThreadSafe<Metric> {
   virtual Status WriteAsJson(JsonWriter* writer,
                              const MetricJsonOptions& opts) const = 0;
 
+  // Writes the samples of this metric in the Prometheus text exposition
+  // format, named 'name' and labeled with 'labels', a comma-separated list of
+  // label pairs which may be empty. The HELP and TYPE lines of the metric
+  // family are written first if 'write_header' is true.
+  virtual void WriteAsPrometheus(std::ostream* out,
+                                 const std::string& name,
+                                 const std::string& labels,
+                                 bool write_header) const = 0;
+
   const MetricPrototype* prototype() const { return prototype_; }
 
   // Return true if this metric has never been touched.
@@ -877,6 +892,20 @@ class MetricRegistry {
   // output of this function.
   Status WriteAsJson(JsonWriter* writer, const MetricJsonOptions& opts) const;
 
+  // Writes metrics in this registry to 'out' in the Prometheus text exposition
+  // format, entity by entity as they are rendered.
+  //
+  // A metric is named 'kudu_<entity type>_<metric name>' and labeled with the
+  // ID of its entity, and with the attributes of the entity if
+  // 'opts.include_entity_attributes' is set. Histograms are written as
+  // summaries, and string gauges aren't written. The filters, merge rules and
+  // the options which skip metrics apply as in WriteAsJson(), e.g. to write
+  // the metrics of tablets merged into the metrics of their tables.
+  //
+  // Returns an error if writing to 'out' failed, e.g. because the client went
+  // away, in which case the remaining entities aren't rendered.
+  Status WriteAsPrometheus(std::ostream* out, const MetricJsonOptions& opts) const;
+
   // For each registered entity, retires orphaned metrics. If an entity has no more
   // metrics and there are no external references, entities are removed as well.
   //
@@ -1005,6 +1034,18 @@ class GaugePrototype : public MetricPrototype {
   DISALLOW_COPY_AND_ASSIGN(GaugePrototype);
 };
 
+// Writes 'value' as the value of a Prometheus sample.
+void WritePrometheusSampleValue(std::ostream* out, double value);
+inline void WritePrometheusSampleValue(std::ostream* out, float value) {
+  WritePrometheusSampleValue(out, static_cast<double>(value));
+}
+template<typename T>
+void WritePrometheusSampleValue(std::ostream* out, T value) {
+  static_assert(std::is_integral<T>::value, "gauge values must be numeric");
+  // Promoted so that byte-sized values aren't written as characters.
+  *out << +value;
+}
+
 // Abstract base class to provide point-in-time metric values.
 class Gauge : public Metric {
  public:
@@ -1014,9 +1055,15 @@ class Gauge : public Metric {
   virtual ~Gauge() {}
   virtual Status WriteAsJson(JsonWriter* w,
                              const MetricJsonOptions& opts) const OVERRIDE;
+  void WriteAsPrometheus(std::ostream* out,
+                         const std::string& name,
+                         const std::string& labels,
+                         bool write_header) const override;
 
  protected:
   virtual void WriteValue(JsonWriter* writer) const = 0;
+  // Writes the value of the gauge as the value of a Prometheus sample.
+  virtual void WritePrometheusValue(std::ostream* out) const = 0;
  private:
   DISALLOW_COPY_AND_ASSIGN(Gauge);
 };
@@ -1035,10 +1082,18 @@ class StringGauge : public Gauge {
     return false;
   }
   void MergeFrom(const scoped_refptr<Metric>& other) OVERRIDE;
+  // String gauges have no Prometheus representation, so this writes nothing.
+  void WriteAsPrometheus(std::ostream* out,
+                         const std::string& name,
+                         const std::string& labels,
+                         bool write_header) const override {
+  }
 
  protected:
   FRIEND_TEST(MetricsTest, SimpleStringGaugeForMergeTest);
   virtual void WriteValue(JsonWriter* writer) const OVERRIDE;
+  void WritePrometheusValue(std::ostream* out) const override {
+  }
   void FillUniqueValuesUnlocked();
   std::unordered_set<std::string> unique_values();
  private:
@@ -1068,6 +1123,7 @@ class MeanGauge : public Gauge {
 
  protected:
   virtual void WriteValue(JsonWriter* writer) const override;
+  void WritePrometheusValue(std::ostream* out) const override;
  private:
   double total_sum_;
   double total_count_;
@@ -1143,6 +1199,9 @@ class AtomicGauge : public Gauge {
   virtual void WriteValue(JsonWriter* writer) const OVERRIDE {
     writer->Value(value());
   }
+  void WritePrometheusValue(std::ostream* out) const override {
+    WritePrometheusSampleValue(out, value());
+  }
  private:
   AtomicInt<int64_t> value_;
   MergeType type_;
@@ -1235,6 +1294,10 @@ class FunctionGauge : public Gauge {
     writer->Value(value());
   }
 
+  void WritePrometheusValue(std::ostream* out) const override {
+    WritePrometheusSampleValue(out, value());
+  }
+
   // Reset this FunctionGauge to return a specific value.
   // This should be used during destruction. If you want a settable
   // Gauge, use a normal Gauge instead of a FunctionGauge.
@@ -1355,6 +1418,10 @@ class Counter : public Metric {
   void IncrementBy(int64_t amount);
   virtual Status WriteAsJson(JsonWriter* w,
                              const MetricJsonOptions& opts) const OVERRIDE;
+  void WriteAsPrometheus(std::ostream* out,
+                         const std::string& name,
+                         const std::string& labels,
+                         bool write_header) const override;
 
   virtual bool IsUntouched() const override {
     return value() == 0;
@@ -1400,10 +1467,15 @@ class HistogramPrototype : public MetricPrototype {
   DISALLOW_COPY_AND_ASSIGN(HistogramPrototype);
 };
 
+// Histograms may be sharded by CPU (see --metrics_histogram_shards), in which
+// case values are recorded into the shard of the current CPU, and the shards
+// are merged into the main HdrHistogram only when the histogram is read.
 class Histogram : public Metric {
  public:
+  ~Histogram() override;
+
   scoped_refptr<Metric> snapshot() const override {
-    auto p = new Histogram(down_cast<const HistogramPrototype*>(prototype_), *histogram_);
+    auto p = new Histogram(down_cast<const HistogramPrototype*>(prototype_), *histogram());
     p->m_epoch_.store(m_epoch_);
     p->invalid_for_merge_ = invalid_for_merge_;
     p->retire_time_ = retire_time_;
@@ -1425,13 +1497,25 @@ class Histogram : public Metric {
   virtual Status WriteAsJson(JsonWriter* w,
                              const MetricJsonOptions& opts) const OVERRIDE;
 
+  // Writes the histogram as a Prometheus summary, with the quantiles written
+  // to JSON, and the minimum and maximum as the 0 and 1 quantiles.
+  void WriteAsPrometheus(std::ostream* out,
+                         const std::string& name,
+                         const std::string& labels,
+                         bool write_header) const override;
+
   // Returns a snapshot of this histogram including the bucketed values and counts.
   Status GetHistogramSnapshotPB(HistogramSnapshotPB* snapshot_pb,
                                 const MetricJsonOptions& opts) const;
 
-  // Returns a pointer to the underlying histogram. The implementation of HdrHistogram
-  // is thread safe.
-  const HdrHistogram* histogram() const { return histogram_.get(); }
+  // Returns a pointer to the underlying histogram, after merging the shards
+  // into it. The implementation of HdrHistogram is thread safe.
+  const HdrHistogram* histogram() const {
+    if (num_shards_ > 0) {
+      MergeShards();
+    }
+    return histogram_.get();
+  }
 
   uint64_t CountInBucketForValueForTests(uint64_t value) const;
   uint64_t MinValueForTests() const;
@@ -1460,7 +1544,21 @@ class Histogram : public Metric {
   explicit Histogram(const HistogramPrototype* proto);
   Histogram(const HistogramPrototype* proto, const HdrHistogram& hdr_hist);
 
+  // Returns the HdrHistogram to record values into: the shard of the current
+  // CPU, allocated on first use, or the main one if the histogram isn't sharded.
+  HdrHistogram* RecordingHistogram();
+
+  // Drains the values recorded into the shards into 'histogram_'.
+  void MergeShards() const;
+
   const std::unique_ptr<HdrHistogram> histogram_;
+
+  // The number of shards, or 0 if values are recorded into 'histogram_'
+  // directly. Shards are allocated when a value is first recorded on one of
+  // their CPUs, so that idle histograms stay small.
+  const int num_shards_;
+  const std::unique_ptr<std::atomic<HdrHistogram*>[]> shards_;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
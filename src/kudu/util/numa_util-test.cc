@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/util/numa_util.h"
+
+#include <string>
+#include <vector>
+
+#include <gflags/gflags_declare.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/status.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(numa_pin_threads);
+
+using std::vector;
+
+namespace kudu {
+
+class NumaUtilTest : public KuduTest {};
+
+TEST_F(NumaUtilTest, TestParseCpuList) {
+  vector<int> cpus;
+  ASSERT_OK(ParseCpuList("0-3,8,10-11", &cpus));
+  ASSERT_EQ(vector<int>({ 0, 1, 2, 3, 8, 10, 11 }), cpus);
+  ASSERT_OK(ParseCpuList("", &cpus));
+  ASSERT_TRUE(cpus.empty());
+  ASSERT_TRUE(ParseCpuList("3-1", &cpus).IsCorruption());
+  ASSERT_TRUE(ParseCpuList("1-2-3", &cpus).IsCorruption());
+  ASSERT_TRUE(ParseCpuList("a", &cpus).IsCorruption());
+}
+
+TEST_F(NumaUtilTest, TestPlacement) {
+  ASSERT_GE(NumNumaNodes(), 1);
+  FLAGS_numa_pin_threads = false;
+  ASSERT_EQ(-1, NumaNodeForThread(0));
+  ASSERT_EQ(-1, NumaNodeForTablet("tablet"));
+
+  FLAGS_numa_pin_threads = true;
+  if (NumNumaNodes() == 1) {
+    ASSERT_EQ(-1, NumaNodeForThread(0));
+    return;
+  }
+  for (int i = 0; i < 2 * NumNumaNodes(); i++) {
+    ASSERT_EQ(i % NumNumaNodes(), NumaNodeForThread(i));
+  }
+  const int node = NumaNodeForTablet("tablet");
+  ASSERT_GE(node, 0);
+  ASSERT_LT(node, NumNumaNodes());
+  ASSERT_EQ(node, NumaNodeForTablet("tablet"));
+  PinCurrentThreadToNumaNode(node);
+}
+
+} // namespace kudu
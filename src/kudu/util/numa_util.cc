@@ -0,0 +1,151 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "kudu/util/numa_util.h"
+
+#if !defined(__APPLE__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/strip.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/logging.h"
+
+DEFINE_bool(numa_pin_threads, false,
+            "Whether to pin the RPC reactor threads, the RPC service threads and "
+            "the apply threads to NUMA nodes, spreading them over the nodes, and "
+            "to give each tablet a home node whose apply threads apply its writes. "
+            "Combined with --arena_huge_pages_numa_local, the memrowsets and delta "
+            "memstores of a tablet are allocated on its home node. Has no effect "
+            "on machines with a single NUMA node.");
+TAG_FLAG(numa_pin_threads, advanced);
+TAG_FLAG(numa_pin_threads, experimental);
+
+using std::string;
+using std::vector;
+using strings::Split;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// Returns the CPUs of each NUMA node with CPUs.
+const vector<vector<int>>& NumaNodeCpus() {
+  static const vector<vector<int>>* const kNodes = []() {
+    auto* nodes = new vector<vector<int>>();
+#if !defined(__APPLE__)
+    for (int node = 0;; node++) {
+      faststring buf;
+      if (!ReadFileToString(Env::Default(),
+                            Substitute("/sys/devices/system/node/node$0/cpulist", node),
+                            &buf).ok()) {
+        break;
+      }
+      string str = buf.ToString();
+      StripWhiteSpace(&str);
+      vector<int> cpus;
+      Status s = ParseCpuList(str, &cpus);
+      if (!s.ok()) {
+        LOG(WARNING) << "Could not read the CPUs of NUMA node " << node << ": " << s.ToString();
+        nodes->clear();
+        break;
+      }
+      // Nodes with memory only don't run threads.
+      if (!cpus.empty()) {
+        nodes->emplace_back(std::move(cpus));
+      }
+    }
+#endif
+    return nodes;
+  }();
+  return *kNodes;
+}
+
+} // anonymous namespace
+
+Status ParseCpuList(const string& str, vector<int>* cpus) {
+  cpus->clear();
+  for (const auto& range : Split(str, ",", strings::SkipEmpty())) {
+    vector<string> bounds = Split(range, "-");
+    int32_t first;
+    int32_t last;
+    if (bounds.size() > 2 ||
+        !safe_strto32(bounds[0], &first) ||
+        !safe_strto32(bounds.back(), &last) ||
+        first < 0 || last < first) {
+      return Status::Corruption("invalid CPU list", str);
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus->push_back(cpu);
+    }
+  }
+  return Status::OK();
+}
+
+int NumNumaNodes() {
+  return std::max<int>(1, NumaNodeCpus().size());
+}
+
+int NumaNodeForThread(int index) {
+  if (!FLAGS_numa_pin_threads || NumNumaNodes() == 1) {
+    return -1;
+  }
+  return index % NumNumaNodes();
+}
+
+int NumaNodeForTablet(const string& tablet_id) {
+  return NumaNodeForThread(std::hash<string>()(tablet_id) % NumNumaNodes());
+}
+
+void PinCurrentThreadToNumaNode(int node) {
+  if (node < 0) {
+    return;
+  }
+#if !defined(__APPLE__)
+  DCHECK_LT(node, NumNumaNodes());
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (int cpu : NumaNodeCpus()[node]) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpus);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    int err = errno;
+    KLOG_FIRST_N(WARNING, 1) << "Could not pin thread to NUMA node " << node
+                             << ": " << ErrnoToString(err);
+  }
+#endif
+}
+
+} // namespace kudu
@@ -0,0 +1,49 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+// Parses a list of CPUs in the format of the kernel, e.g. "0-3,8,10-11", into
+// 'cpus'.
+Status ParseCpuList(const std::string& str, std::vector<int>* cpus);
+
+// Returns the number of NUMA nodes of the machine, or 1 if the topology can't
+// be read, e.g. on macOS.
+int NumNumaNodes();
+
+// Returns the node to pin the 'index'-th thread of a group of threads to, so
+// that the group is spread over the NUMA nodes, or -1 if the threads aren't
+// pinned: unless --numa_pin_threads is set, or if the machine has a single
+// node.
+int NumaNodeForThread(int index);
+
+// Returns the home NUMA node of the tablet 'tablet_id', whose apply threads,
+// and thus memrowset and delta memstore memory, are on the node, or -1 if the
+// threads aren't pinned.
+int NumaNodeForTablet(const std::string& tablet_id);
+
+// Restricts the calling thread to the CPUs of NUMA node 'node'. Does nothing
+// if 'node' is -1. Failures are logged: they only cost the locality.
+void PinCurrentThreadToNumaNode(int node);
+
+} // namespace kudu
@@ -58,7 +58,10 @@ namespace pb_util {
 
 enum SyncMode {
   SYNC,
-  NO_SYNC
+  NO_SYNC,
+  // Like SYNC, but the parent directory of the file isn't synced: the caller
+  // must make the rename of the file durable.
+  SYNC_FILE_ONLY
 };
 
 enum CreateMode {
@@ -97,6 +100,7 @@ Status ReadPBFromPath(Env* env, const std::string& path, google::protobuf::Messa
 // Serialize a protobuf to the given path.
 //
 // If SyncMode SYNC is provided, ensures the changes are made durable.
+// If SYNC_FILE_ONLY is provided, only the file is synced.
 Status WritePBToPath(Env* env, const std::string& path,
                      const google::protobuf::MessageLite& msg, SyncMode sync);
 
@@ -470,6 +474,7 @@ Status ReadPBContainerFromPath(Env* env, const std::string& path,
 //
 // If create == NO_OVERWRITE and 'path' already exists, the function will fail.
 // If sync == SYNC, the newly created file will be fsynced before returning.
+// If sync == SYNC_FILE_ONLY, the file is fsynced but its directory isn't.
 Status WritePBContainerToPath(Env* env, const std::string& path,
                               const google::protobuf::Message& msg,
                               CreateMode create,
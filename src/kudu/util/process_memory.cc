@@ -273,6 +273,19 @@ bool SoftLimitExceeded(double* current_capacity_pct) {
   return false;
 }
 
+double MemoryPressureRatio() {
+  InitLimits();
+  int64_t consumption = CurrentConsumption();
+  if (consumption <= g_pressure_threshold) {
+    return 0;
+  }
+  if (consumption >= g_hard_limit) {
+    return 1;
+  }
+  return static_cast<double>(consumption - g_pressure_threshold) /
+      (g_hard_limit - g_pressure_threshold);
+}
+
 void MaybeGCAfterRelease(int64_t released_bytes) {
 #ifdef TCMALLOC_ENABLED
   int64_t now_released = base::subtle::NoBarrier_AtomicIncrement(
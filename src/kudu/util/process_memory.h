@@ -34,6 +34,11 @@ bool SoftLimitExceeded(double* current_capacity_pct);
 // the percentage of the hard limit consumed is written to it.
 bool UnderMemoryPressure(double* current_capacity_pct);
 
+// Returns how far the process is between the memory pressure threshold and
+// the hard limit: 0 at or under the threshold, growing linearly to 1 at or
+// over the hard limit.
+double MemoryPressureRatio();
+
 // Potentially trigger a call to release tcmalloc memory back to the
 // OS, after the given amount of memory was released.
 void MaybeGCAfterRelease(int64_t released_bytes);
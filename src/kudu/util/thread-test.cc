@@ -19,15 +19,19 @@
 
 #include <unistd.h>
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
 #include "kudu/gutil/basictypes.h"
+#include "kudu/gutil/map-util.h"
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/util/countdown_latch.h"
 #include "kudu/util/env.h"
@@ -36,8 +40,11 @@
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 #include "kudu/util/thread_restrictions.h"
+#include "kudu/util/threadpool.h"
 
 using std::string;
+using std::unique_ptr;
+using std::unordered_map;
 
 namespace kudu {
 
@@ -98,6 +105,29 @@ TEST_F(ThreadTest, TestDoubleJoinIsNoOp) {
   ASSERT_OK(joiner.Join());
 }
 
+TEST_F(ThreadTest, TestGetThreadCategories) {
+  CountDownLatch latch(1);
+  scoped_refptr<Thread> holder;
+  ASSERT_OK(Thread::Create("test", "waiter thread",
+                           [&latch]() { latch.Wait(); }, &holder));
+  unique_ptr<ThreadPool> pool;
+  ASSERT_OK(ThreadPoolBuilder("categories-test")
+            .set_min_threads(1)
+            .Build(&pool));
+  int64_t pool_tid = -1;
+  ASSERT_OK(pool->Submit([&pool_tid]() { pool_tid = Thread::CurrentThreadId(); }));
+  pool->Wait();
+
+  unordered_map<int64_t, string> categories;
+  GetThreadCategories(&categories);
+  ASSERT_EQ("test", FindWithDefault(categories, holder->tid(), ""));
+  // Pool threads are reported under the name of their pool.
+  ASSERT_EQ("categories-test", FindWithDefault(categories, pool_tid, ""));
+
+  latch.CountDown();
+  holder->Join();
+}
+
 TEST_F(ThreadTest, ThreadStartBenchmark) {
   std::vector<scoped_refptr<Thread>> threads(1000);
   LOG_TIMING(INFO, "starting threads") {
@@ -186,6 +186,9 @@ class ThreadMgr {
   // Metric callback for number of threads running. Also used for error messages.
   uint64_t ReadThreadsRunning() const;
 
+  // See GetThreadCategories().
+  void GetCategories(unordered_map<int64_t, string>* categories) const;
+
  private:
   // Container class for any details we want to capture about a thread
   // TODO: Add start-time.
@@ -324,6 +327,23 @@ uint64_t ThreadMgr::ReadThreadsRunning() const {
   return threads_running_metric_;
 }
 
+void ThreadMgr::GetCategories(unordered_map<int64_t, string>* categories) const {
+  categories->clear();
+  shared_lock<decltype(lock_)> l(lock_);
+  for (const auto& category : thread_categories_) {
+    for (const auto& elem : category.second) {
+      const ThreadDescriptor& desc = elem.second;
+      if (category.first == "thread pool") {
+        // ThreadPool names its threads "<pool name> [worker]-<tid>".
+        const string& name = desc.name();
+        (*categories)[desc.thread_id()] = name.substr(0, name.find(" [worker]"));
+      } else {
+        (*categories)[desc.thread_id()] = category.first;
+      }
+    }
+  }
+}
+
 void ThreadMgr::AddThread(const pthread_t& pthread_id, const string& name,
     const string& category, int64_t tid) {
   // These annotations cause TSAN to ignore the synchronization on lock_
@@ -475,6 +495,11 @@ Status StartThreadInstrumentation(const scoped_refptr<MetricEntity>& server_metr
   return thread_manager->StartInstrumentation(server_metrics, web);
 }
 
+void GetThreadCategories(unordered_map<int64_t, string>* categories) {
+  GoogleOnceInit(&once, &InitThreading);
+  thread_manager->GetCategories(categories);
+}
+
 ThreadJoiner::ThreadJoiner(Thread* thr)
   : thread_(CHECK_NOTNULL(thr)),
     warn_after_ms_(kDefaultWarnAfterMs),
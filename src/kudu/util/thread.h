@@ -27,6 +27,7 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "kudu/gutil/atomicops.h"
@@ -310,4 +311,9 @@ class Thread : public RefCountedThreadSafe<Thread> {
 // the given entity. If 'web' is NULL, does not register the path handler.
 Status StartThreadInstrumentation(const scoped_refptr<MetricEntity>& server_metrics,
                                   WebCallbackRegistry* web);
+
+// Fills 'categories' with the category of each live Thread, keyed by TID.
+// The worker threads of a ThreadPool are reported under the name of their
+// pool rather than under the shared "thread pool" category.
+void GetThreadCategories(std::unordered_map<int64_t, std::string>* categories);
 } // namespace kudu
@@ -184,7 +184,7 @@ TEST_F(ThreadPoolTest, TestThreadPoolWithNoMinimum) {
   // Finish all work
   latch.CountDown();
   pool_->Wait();
-  ASSERT_EQ(0, pool_->active_threads_);
+  ASSERT_EQ(0, pool_->shards_[0]->active_threads);
   pool_->Shutdown();
   ASSERT_EQ(0, pool_->num_threads());
 }
@@ -274,7 +274,7 @@ TEST_F(ThreadPoolTest, TestVariableSizeThreadPool) {
   // Finish all work
   latch.CountDown();
   pool_->Wait();
-  ASSERT_EQ(0, pool_->active_threads_);
+  ASSERT_EQ(0, pool_->shards_[0]->active_threads);
   pool_->Shutdown();
   ASSERT_EQ(0, pool_->num_threads());
 }
@@ -922,4 +922,63 @@ TEST_F(ThreadPoolTest, TestLIFOThreadWakeUps) {
   NO_PENDING_FATALS();
 }
 
+TEST_F(ThreadPoolTest, TestWorkStealing) {
+  // One thread per queue.
+  ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                   .set_min_threads(2)
+                                   .set_max_threads(2)
+                                   .set_num_queues(2)));
+  unique_ptr<ThreadPoolToken> t = pool_->NewToken(ThreadPool::ExecutionMode::CONCURRENT);
+
+  // Block the only thread of the token's queue.
+  CountDownLatch blocker(1);
+  SCOPED_CLEANUP({
+    blocker.CountDown();
+  });
+  ASSERT_OK(t->Submit([&blocker]() { blocker.Wait(); }));
+
+  // The next task of the token can only be run by the thread of the other queue.
+  CountDownLatch stolen(1);
+  ASSERT_OK(t->Submit([&stolen]() { stolen.CountDown(); }));
+  ASSERT_TRUE(stolen.WaitFor(MonoDelta::FromSeconds(10)));
+
+  blocker.CountDown();
+  pool_->Wait();
+  t->Shutdown();
+}
+
+TEST_F(ThreadPoolTest, TestWorkStealingSerialTokens) {
+  const int kNumTokens = 8;
+  const int kNumSubmissions = 100;
+  ASSERT_OK(RebuildPoolWithBuilder(ThreadPoolBuilder(kDefaultPoolName)
+                                   .set_max_threads(4)
+                                   .set_num_queues(4)));
+
+  // Tasks of the same SERIAL token must run one at a time and in submission
+  // order, even when they're stolen by the threads of other queues.
+  vector<unique_ptr<ThreadPoolToken>> tokens;
+  vector<vector<int>> results(kNumTokens);
+  for (int i = 0; i < kNumTokens; i++) {
+    tokens.emplace_back(pool_->NewToken(ThreadPool::ExecutionMode::SERIAL));
+  }
+  for (int j = 0; j < kNumSubmissions; j++) {
+    for (int i = 0; i < kNumTokens; i++) {
+      vector<int>* result = &results[i];
+      ASSERT_OK(tokens[i]->Submit([result, j]() { result->push_back(j); }));
+    }
+  }
+  pool_->Wait();
+  for (int i = 0; i < kNumTokens; i++) {
+    ASSERT_EQ(kNumSubmissions, static_cast<int>(results[i].size()));
+    for (int j = 0; j < kNumSubmissions; j++) {
+      ASSERT_EQ(j, results[i][j]);
+    }
+  }
+
+  pool_->Shutdown();
+  for (int i = 0; i < kNumTokens; i++) {
+    ASSERT_TRUE(tokens[i]->Submit([](){}).IsServiceUnavailable());
+  }
+}
+
 } // namespace kudu
@@ -17,6 +17,8 @@
 
 #include "kudu/util/threadpool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -25,6 +27,7 @@
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -34,6 +37,7 @@
 #include "kudu/gutil/sysinfo.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/numa_util.h"
 #include "kudu/util/scoped_cleanup.h"
 #include "kudu/util/thread.h"
 #include "kudu/util/trace.h"
@@ -47,6 +51,21 @@ using std::string;
 using std::unique_ptr;
 using strings::Substitute;
 
+namespace {
+
+// The pool the current thread is a worker of, if any, and the index of the
+// worker's shard in that pool.
+__thread const ThreadPool* g_current_pool = nullptr;
+__thread int g_current_shard_index = -1;
+
+// Returns the share of 'total' of the shard at 'index' out of 'num_shards',
+// spreading the remainder over the first shards.
+int ShardShare(int total, int index, int num_shards) {
+  return total / num_shards + (index < total % num_shards ? 1 : 0);
+}
+
+} // anonymous namespace
+
 ////////////////////////////////////////////////////////
 // ThreadPoolBuilder
 ////////////////////////////////////////////////////////
@@ -56,7 +75,9 @@ ThreadPoolBuilder::ThreadPoolBuilder(string name)
       min_threads_(0),
       max_threads_(base::NumCPUs()),
       max_queue_size_(std::numeric_limits<int>::max()),
-      idle_timeout_(MonoDelta::FromMilliseconds(500)) {}
+      idle_timeout_(MonoDelta::FromMilliseconds(500)),
+      num_queues_(1),
+      numa_node_(-1) {}
 
 ThreadPoolBuilder& ThreadPoolBuilder::set_trace_metric_prefix(const string& prefix) {
   trace_metric_prefix_ = prefix;
@@ -90,6 +111,18 @@ ThreadPoolBuilder& ThreadPoolBuilder::set_metrics(ThreadPoolMetrics metrics) {
   return *this;
 }
 
+ThreadPoolBuilder& ThreadPoolBuilder::set_num_queues(int num_queues) {
+  CHECK_GT(num_queues, 0);
+  num_queues_ = num_queues;
+  return *this;
+}
+
+ThreadPoolBuilder& ThreadPoolBuilder::set_numa_node(int numa_node) {
+  CHECK_GE(numa_node, -1);
+  numa_node_ = numa_node;
+  return *this;
+}
+
 Status ThreadPoolBuilder::Build(unique_ptr<ThreadPool>* pool) const {
   pool->reset(new ThreadPool(*this));
   return (*pool)->Init();
@@ -100,13 +133,15 @@ Status ThreadPoolBuilder::Build(unique_ptr<ThreadPool>* pool) const {
 ////////////////////////////////////////////////////////
 
 ThreadPoolToken::ThreadPoolToken(ThreadPool* pool,
+                                 ThreadPool::Shard* shard,
                                  ThreadPool::ExecutionMode mode,
                                  ThreadPoolMetrics metrics)
     : mode_(mode),
       metrics_(std::move(metrics)),
       pool_(pool),
+      shard_(shard),
       state_(State::IDLE),
-      not_running_cond_(&pool->lock_),
+      not_running_cond_(&shard->lock),
       active_threads_(0) {
 }
 
@@ -120,7 +155,7 @@ Status ThreadPoolToken::Submit(std::function<void()> f) {
 }
 
 void ThreadPoolToken::Shutdown() {
-  MutexLock unique_lock(pool_->lock_);
+  MutexLock unique_lock(shard_->lock);
   pool_->CheckNotPoolThreadUnlocked();
 
   // Clear the queue under the lock, but defer the releasing of the tasks
@@ -128,7 +163,7 @@ void ThreadPoolToken::Shutdown() {
   // the ThreadPool. The task's destructors may acquire locks, etc, so this
   // also prevents lock inversions.
   std::deque<ThreadPool::Task> to_release = std::move(entries_);
-  pool_->total_queued_tasks_ -= to_release.size();
+  shard_->total_queued_tasks -= to_release.size();
 
   switch (state()) {
     case State::IDLE:
@@ -145,9 +180,10 @@ void ThreadPoolToken::Shutdown() {
       // Plus doing it this way (rather than switching to QUIESCING and waiting
       // for a worker thread to process the queue entry) helps retain state
       // transition symmetry with ThreadPool::Shutdown.
-      for (auto it = pool_->queue_.begin(); it != pool_->queue_.end();) {
+      for (auto it = shard_->queue.begin(); it != shard_->queue.end();) {
         if (*it == this) {
-          it = pool_->queue_.erase(it);
+          it = shard_->queue.erase(it);
+          pool_->num_queued_tokens_--;
         } else {
           it++;
         }
@@ -180,7 +216,7 @@ void ThreadPoolToken::Shutdown() {
 }
 
 void ThreadPoolToken::Wait() {
-  MutexLock unique_lock(pool_->lock_);
+  MutexLock unique_lock(shard_->lock);
   pool_->CheckNotPoolThreadUnlocked();
   while (IsActive()) {
     not_running_cond_.Wait();
@@ -188,7 +224,7 @@ void ThreadPoolToken::Wait() {
 }
 
 bool ThreadPoolToken::WaitUntil(const MonoTime& until) {
-  MutexLock unique_lock(pool_->lock_);
+  MutexLock unique_lock(shard_->lock);
   pool_->CheckNotPoolThreadUnlocked();
   while (IsActive()) {
     if (!not_running_cond_.WaitUntil(until)) {
@@ -265,21 +301,39 @@ const char* ThreadPoolToken::StateToString(State s) {
 // ThreadPool
 ////////////////////////////////////////////////////////
 
+ThreadPool::Shard::Shard(int index, int min_threads, int max_threads, int max_queue_size)
+    : index(index),
+      min_threads(min_threads),
+      max_threads(max_threads),
+      max_queue_size(max_queue_size),
+      status(Status::Uninitialized("The pool was not initialized.")),
+      idle_cond(&lock),
+      no_threads_cond(&lock),
+      num_threads(0),
+      num_threads_pending_start(0),
+      active_threads(0),
+      total_queued_tasks(0) {
+}
+
 ThreadPool::ThreadPool(const ThreadPoolBuilder& builder)
   : name_(builder.name_),
-    min_threads_(builder.min_threads_),
-    max_threads_(builder.max_threads_),
-    max_queue_size_(builder.max_queue_size_),
     idle_timeout_(builder.idle_timeout_),
-    pool_status_(Status::Uninitialized("The pool was not initialized.")),
-    idle_cond_(&lock_),
-    no_threads_cond_(&lock_),
-    num_threads_(0),
-    num_threads_pending_start_(0),
-    active_threads_(0),
-    total_queued_tasks_(0),
-    tokenless_(NewToken(ExecutionMode::CONCURRENT)),
+    numa_node_(builder.numa_node_),
+    next_shard_(0),
+    num_queued_tokens_(0),
     metrics_(builder.metrics_) {
+  // Every shard needs at least one thread to run its tasks.
+  const int num_shards = std::min(builder.num_queues_, builder.max_threads_);
+  shards_.reserve(num_shards);
+  for (int i = 0; i < num_shards; i++) {
+    shards_.emplace_back(new Shard(i,
+                                   ShardShare(builder.min_threads_, i, num_shards),
+                                   ShardShare(builder.max_threads_, i, num_shards),
+                                   ShardShare(builder.max_queue_size_, i, num_shards)));
+    Shard* shard = shards_.back().get();
+    shard->tokenless = NewTokenInShard(ExecutionMode::CONCURRENT, {}, shard);
+  }
+
   string prefix = !builder.trace_metric_prefix_.empty() ?
       builder.trace_metric_prefix_ : builder.name_;
 
@@ -292,88 +346,109 @@ ThreadPool::ThreadPool(const ThreadPoolBuilder& builder)
 }
 
 ThreadPool::~ThreadPool() {
-  // There should only be one live token: the one used in tokenless submission.
-  CHECK_EQ(1, tokens_.size()) << Substitute(
-      "Threadpool $0 destroyed with $1 allocated tokens",
-      name_, tokens_.size());
+  // There should only be one live token per shard: the one used in tokenless
+  // submission.
+  for (const auto& shard : shards_) {
+    CHECK_EQ(1, shard->tokens.size()) << Substitute(
+        "Threadpool $0 destroyed with $1 allocated tokens",
+        name_, shard->tokens.size());
+  }
   Shutdown();
 }
 
 Status ThreadPool::Init() {
-  if (!pool_status_.IsUninitialized()) {
+  if (!shards_[0]->status.IsUninitialized()) {
     return Status::NotSupported("The thread pool is already initialized");
   }
-  pool_status_ = Status::OK();
-  num_threads_pending_start_ = min_threads_;
-  for (int i = 0; i < min_threads_; i++) {
-    Status status = CreateThread();
-    if (!status.ok()) {
-      Shutdown();
-      return status;
+  for (auto& shard : shards_) {
+    shard->status = Status::OK();
+  }
+  for (auto& shard : shards_) {
+    shard->num_threads_pending_start = shard->min_threads;
+    for (int i = 0; i < shard->min_threads; i++) {
+      Status status = CreateThread(shard.get());
+      if (!status.ok()) {
+        Shutdown();
+        return status;
+      }
     }
   }
   return Status::OK();
 }
 
 void ThreadPool::Shutdown() {
-  MutexLock unique_lock(lock_);
   CheckNotPoolThreadUnlocked();
 
-  // Note: this is the same error seen at submission if the pool is at
-  // capacity, so clients can't tell them apart. This isn't really a practical
-  // concern though because shutting down a pool typically requires clients to
-  // be quiesced first, so there's no danger of a client getting confused.
-  pool_status_ = Status::ServiceUnavailable("The pool has been shut down.");
-
-  // Clear the various queues under the lock, but defer the releasing
-  // of the tasks outside the lock, in case there are concurrent threads
+  // Clear the various queues under the locks, but defer the releasing
+  // of the tasks outside the locks, in case there are concurrent threads
   // wanting to access the ThreadPool. The task's destructors may acquire
   // locks, etc, so this also prevents lock inversions.
-  queue_.clear();
   std::deque<std::deque<Task>> to_release;
-  for (auto* t : tokens_) {
-    if (!t->entries_.empty()) {
-      to_release.emplace_back(std::move(t->entries_));
+
+  // Shut down every shard before waiting for any thread to exit: a thread of
+  // one shard may be running a task stolen from another shard.
+  for (auto& shard : shards_) {
+    MutexLock unique_lock(shard->lock);
+
+    // Note: this is the same error seen at submission if the pool is at
+    // capacity, so clients can't tell them apart. This isn't really a practical
+    // concern though because shutting down a pool typically requires clients to
+    // be quiesced first, so there's no danger of a client getting confused.
+    shard->status = Status::ServiceUnavailable("The pool has been shut down.");
+
+    num_queued_tokens_ -= shard->queue.size();
+    shard->queue.clear();
+    for (auto* t : shard->tokens) {
+      if (!t->entries_.empty()) {
+        to_release.emplace_back(std::move(t->entries_));
+      }
+      switch (t->state()) {
+        case ThreadPoolToken::State::IDLE:
+          // The token is idle; we can quiesce it immediately.
+          t->Transition(ThreadPoolToken::State::QUIESCED);
+          break;
+        case ThreadPoolToken::State::RUNNING:
+          // The token has tasks associated with it. If they're merely queued
+          // (i.e. there are no active threads), the tasks will have been removed
+          // above and we can quiesce immediately. Otherwise, we need to wait for
+          // the threads to finish.
+          t->Transition(t->active_threads_ > 0 ?
+              ThreadPoolToken::State::QUIESCING :
+              ThreadPoolToken::State::QUIESCED);
+          break;
+        default:
+          break;
+      }
     }
-    switch (t->state()) {
-      case ThreadPoolToken::State::IDLE:
-        // The token is idle; we can quiesce it immediately.
-        t->Transition(ThreadPoolToken::State::QUIESCED);
-        break;
-      case ThreadPoolToken::State::RUNNING:
-        // The token has tasks associated with it. If they're merely queued
-        // (i.e. there are no active threads), the tasks will have been removed
-        // above and we can quiesce immediately. Otherwise, we need to wait for
-        // the threads to finish.
-        t->Transition(t->active_threads_ > 0 ?
-            ThreadPoolToken::State::QUIESCING :
-            ThreadPoolToken::State::QUIESCED);
-        break;
-      default:
-        break;
+
+    // The queues are empty. Wake any sleeping worker threads. Some worker
+    // threads will exit immediately upon waking, while others will exit after
+    // they finish executing an outstanding task.
+    shard->total_queued_tasks = 0;
+    while (!shard->idle_threads.empty()) {
+      shard->idle_threads.front().not_empty.Signal();
+      shard->idle_threads.pop_front();
     }
   }
 
-  // The queues are empty. Wake any sleeping worker threads and wait for all
-  // of them to exit. Some worker threads will exit immediately upon waking,
-  // while others will exit after they finish executing an outstanding task.
-  total_queued_tasks_ = 0;
-  while (!idle_threads_.empty()) {
-    idle_threads_.front().not_empty.Signal();
-    idle_threads_.pop_front();
-  }
-  while (num_threads_ + num_threads_pending_start_ > 0) {
-    no_threads_cond_.Wait();
+  // Wait for all the worker threads to exit.
+  for (auto& shard : shards_) {
+    MutexLock unique_lock(shard->lock);
+    while (shard->num_threads + shard->num_threads_pending_start > 0) {
+      shard->no_threads_cond.Wait();
+    }
   }
 
   // All the threads have exited. Check the state of each token.
-  for (auto* t : tokens_) {
-    DCHECK(t->state() == ThreadPoolToken::State::IDLE ||
-           t->state() == ThreadPoolToken::State::QUIESCED);
+  for (auto& shard : shards_) {
+    MutexLock unique_lock(shard->lock);
+    for (auto* t : shard->tokens) {
+      DCHECK(t->state() == ThreadPoolToken::State::IDLE ||
+             t->state() == ThreadPoolToken::State::QUIESCED);
+    }
   }
 
-  // Finally release the queued tasks, outside the lock.
-  unique_lock.Unlock();
+  // Finally release the queued tasks, outside the locks.
   for (auto& token : to_release) {
     for (auto& t : token) {
       if (t.trace) {
@@ -383,38 +458,65 @@ void ThreadPool::Shutdown() {
   }
 }
 
+int ThreadPool::num_threads() const {
+  int num_threads = 0;
+  for (const auto& shard : shards_) {
+    MutexLock l(shard->lock);
+    num_threads += shard->num_threads + shard->num_threads_pending_start;
+  }
+  return num_threads;
+}
+
 unique_ptr<ThreadPoolToken> ThreadPool::NewToken(ExecutionMode mode) {
   return NewTokenWithMetrics(mode, {});
 }
 
 unique_ptr<ThreadPoolToken> ThreadPool::NewTokenWithMetrics(
     ExecutionMode mode, ThreadPoolMetrics metrics) {
-  MutexLock guard(lock_);
+  return NewTokenInShard(mode, std::move(metrics), NextShard());
+}
+
+unique_ptr<ThreadPoolToken> ThreadPool::NewTokenInShard(
+    ExecutionMode mode, ThreadPoolMetrics metrics, Shard* shard) {
+  MutexLock guard(shard->lock);
   unique_ptr<ThreadPoolToken> t(new ThreadPoolToken(this,
+                                                    shard,
                                                     mode,
                                                     std::move(metrics)));
-  InsertOrDie(&tokens_, t.get());
+  InsertOrDie(&shard->tokens, t.get());
   return t;
 }
 
+ThreadPool::Shard* ThreadPool::NextShard() {
+  if (shards_.size() == 1) {
+    return shards_[0].get();
+  }
+  return shards_[next_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size()].get();
+}
+
 void ThreadPool::ReleaseToken(ThreadPoolToken* t) {
-  MutexLock guard(lock_);
+  MutexLock guard(t->shard_->lock);
   CHECK(!t->IsActive()) << Substitute("Token with state $0 may not be released",
                                       ThreadPoolToken::StateToString(t->state()));
-  CHECK_EQ(1, tokens_.erase(t));
+  CHECK_EQ(1, t->shard_->tokens.erase(t));
 }
 
 Status ThreadPool::Submit(std::function<void()> f) {
-  return DoSubmit(std::move(f), tokenless_.get());
+  // Tasks submitted by a worker thread go to the worker's own shard, so that
+  // the worker is likely to run them while they're still hot in its cache.
+  Shard* shard = g_current_pool == this ? shards_[g_current_shard_index].get()
+                                        : NextShard();
+  return DoSubmit(std::move(f), shard->tokenless.get());
 }
 
 Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   DCHECK(token);
   MonoTime submit_time = MonoTime::Now();
+  Shard* shard = token->shard_;
 
-  MutexLock guard(lock_);
-  if (PREDICT_FALSE(!pool_status_.ok())) {
-    return pool_status_;
+  MutexLock guard(shard->lock);
+  if (PREDICT_FALSE(!shard->status.ok())) {
+    return shard->status;
   }
 
   if (PREDICT_FALSE(!token->MaySubmitNewTasks())) {
@@ -422,13 +524,14 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   }
 
   // Size limit check.
-  int64_t capacity_remaining = static_cast<int64_t>(max_threads_) - active_threads_ +
-                               static_cast<int64_t>(max_queue_size_) - total_queued_tasks_;
+  int64_t capacity_remaining =
+      static_cast<int64_t>(shard->max_threads) - shard->active_threads +
+      static_cast<int64_t>(shard->max_queue_size) - shard->total_queued_tasks;
   if (capacity_remaining < 1) {
     return Status::ServiceUnavailable(
         Substitute("Thread pool is at capacity ($0/$1 tasks running, $2/$3 tasks queued)",
-                   num_threads_ + num_threads_pending_start_, max_threads_,
-                   total_queued_tasks_, max_queue_size_));
+                   shard->num_threads + shard->num_threads_pending_start, shard->max_threads,
+                   shard->total_queued_tasks, shard->max_queue_size));
   }
 
   // Should we create another thread?
@@ -446,17 +549,19 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   // created a thread we didn't really need. However, this race is unavoidable
   // and harmless.
   //
-  // Of course, we never create more than max_threads_ threads no matter what.
+  // Of course, we never create more than max_threads threads no matter what.
   int threads_from_this_submit =
       token->IsActive() && token->mode() == ExecutionMode::SERIAL ? 0 : 1;
-  int inactive_threads = num_threads_ + num_threads_pending_start_ - active_threads_;
-  int additional_threads = static_cast<int>(queue_.size())
+  int inactive_threads =
+      shard->num_threads + shard->num_threads_pending_start - shard->active_threads;
+  int additional_threads = static_cast<int>(shard->queue.size())
                          + threads_from_this_submit
                          - inactive_threads;
   bool need_a_thread = false;
-  if (additional_threads > 0 && num_threads_ + num_threads_pending_start_ < max_threads_) {
+  if (additional_threads > 0 &&
+      shard->num_threads + shard->num_threads_pending_start < shard->max_threads) {
     need_a_thread = true;
-    num_threads_pending_start_++;
+    shard->num_threads_pending_start++;
   }
 
   Task task;
@@ -474,27 +579,38 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   DCHECK(state == ThreadPoolToken::State::IDLE ||
          state == ThreadPoolToken::State::RUNNING);
   token->entries_.emplace_back(std::move(task));
+  bool token_queued = false;
   if (state == ThreadPoolToken::State::IDLE ||
       token->mode() == ExecutionMode::CONCURRENT) {
-    queue_.emplace_back(token);
+    shard->queue.emplace_back(token);
+    num_queued_tokens_++;
+    token_queued = true;
     if (state == ThreadPoolToken::State::IDLE) {
       token->Transition(ThreadPoolToken::State::RUNNING);
     }
   }
-  int length_at_submit = total_queued_tasks_++;
+  int length_at_submit = shard->total_queued_tasks++;
 
   // Wake up an idle thread for this task. Choosing the thread at the front of
   // the list ensures LIFO semantics as idling threads are also added to the front.
   //
   // If there are no idle threads, the new task remains on the queue and is
   // processed by an active thread (or a thread we're about to create) at some
-  // point in the future.
-  if (!idle_threads_.empty()) {
-    idle_threads_.front().not_empty.Signal();
-    idle_threads_.pop_front();
+  // point in the future. If all of the shard's threads are busy, an idle
+  // thread of another shard is woken up to steal the task.
+  bool wake_other_shard = false;
+  if (!shard->idle_threads.empty()) {
+    shard->idle_threads.front().not_empty.Signal();
+    shard->idle_threads.pop_front();
+  } else {
+    wake_other_shard = token_queued && additional_threads > 0 && !need_a_thread;
   }
   guard.Unlock();
 
+  if (wake_other_shard && shards_.size() > 1) {
+    WakeIdleThreadOfOtherShard(shard);
+  }
+
   if (metrics_.queue_length_histogram) {
     metrics_.queue_length_histogram->Increment(length_at_submit);
   }
@@ -503,11 +619,11 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   }
 
   if (need_a_thread) {
-    Status status = CreateThread();
+    Status status = CreateThread(shard);
     if (!status.ok()) {
       guard.Lock();
-      num_threads_pending_start_--;
-      if (num_threads_ + num_threads_pending_start_ == 0) {
+      shard->num_threads_pending_start--;
+      if (shard->num_threads + shard->num_threads_pending_start == 0) {
         // If we have no threads, we can't do any work.
         return status;
       }
@@ -522,20 +638,45 @@ Status ThreadPool::DoSubmit(std::function<void()> f, ThreadPoolToken* token) {
   return Status::OK();
 }
 
+ThreadPool::Shard* ThreadPool::FindBusyShard() {
+  // Check all the shards at once (locking them in index order) since a task
+  // running in one shard may submit tasks to another one.
+  for (auto& shard : shards_) {
+    shard->lock.Acquire();
+  }
+  Shard* busy = nullptr;
+  for (auto& shard : shards_) {
+    if (shard->total_queued_tasks > 0 || shard->active_threads > 0) {
+      busy = shard.get();
+      break;
+    }
+  }
+  for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+    (*it)->lock.Release();
+  }
+  return busy;
+}
+
 void ThreadPool::Wait() {
-  MutexLock unique_lock(lock_);
   CheckNotPoolThreadUnlocked();
-  while (total_queued_tasks_ > 0 || active_threads_ > 0) {
-    idle_cond_.Wait();
+  Shard* shard;
+  while ((shard = FindBusyShard()) != nullptr) {
+    MutexLock unique_lock(shard->lock);
+    while (shard->total_queued_tasks > 0 || shard->active_threads > 0) {
+      shard->idle_cond.Wait();
+    }
   }
 }
 
 bool ThreadPool::WaitUntil(const MonoTime& until) {
-  MutexLock unique_lock(lock_);
   CheckNotPoolThreadUnlocked();
-  while (total_queued_tasks_ > 0 || active_threads_ > 0) {
-    if (!idle_cond_.WaitUntil(until)) {
-      return false;
+  Shard* shard;
+  while ((shard = FindBusyShard()) != nullptr) {
+    MutexLock unique_lock(shard->lock);
+    while (shard->total_queued_tasks > 0 || shard->active_threads > 0) {
+      if (!shard->idle_cond.WaitUntil(until)) {
+        return false;
+      }
     }
   }
   return true;
@@ -545,39 +686,59 @@ bool ThreadPool::WaitFor(const MonoDelta& delta) {
   return WaitUntil(MonoTime::Now() + delta);
 }
 
-void ThreadPool::DispatchThread() {
-  MutexLock unique_lock(lock_);
-  InsertOrDie(&threads_, Thread::current_thread());
-  DCHECK_GT(num_threads_pending_start_, 0);
-  num_threads_++;
-  num_threads_pending_start_--;
-  // If we are one of the first 'min_threads_' to start, we must be
+void ThreadPool::DispatchThread(Shard* shard) {
+  g_current_pool = this;
+  g_current_shard_index = shard->index;
+  PinCurrentThreadToNumaNode(numa_node_);
+
+  MutexLock unique_lock(shard->lock);
+  DCHECK_GT(shard->num_threads_pending_start, 0);
+  shard->num_threads++;
+  shard->num_threads_pending_start--;
+  // If we are one of the first 'min_threads' of the shard to start, we must be
   // a "permanent" thread.
-  bool permanent = num_threads_ <= min_threads_;
+  bool permanent = shard->num_threads <= shard->min_threads;
 
-  // Owned by this worker thread and added/removed from idle_threads_ as needed.
-  IdleThread me(&lock_);
+  // Owned by this worker thread and added/removed from idle_threads as needed.
+  IdleThread me(&shard->lock);
 
   while (true) {
     // Note: Status::Aborted() is used to indicate normal shutdown.
-    if (!pool_status_.ok()) {
-      VLOG(2) << "DispatchThread exiting: " << pool_status_.ToString();
+    if (!shard->status.ok()) {
+      VLOG(2) << "DispatchThread exiting: " << shard->status.ToString();
       break;
     }
 
-    if (queue_.empty()) {
+    if (shard->queue.empty() && shards_.size() > 1) {
+      // Before going idle, try to help the other shards with their tasks.
+      unique_lock.Unlock();
+      bool stole = StealAndRunTask(shard);
+      unique_lock.Lock();
+      if (stole) {
+        continue;
+      }
+    }
+
+    if (shard->queue.empty()) {
       // There's no work to do, let's go idle.
       //
       // Note: if FIFO behavior is desired, it's as simple as changing this to push_back().
-      idle_threads_.push_front(me);
+      shard->idle_threads.push_front(me);
       SCOPED_CLEANUP({
         // For some wake ups (i.e. Shutdown or DoSubmit) this thread is
         // guaranteed to be unlinked after being awakened. In others (i.e.
         // spurious wake-up or Wait timeout), it'll still be linked.
         if (me.is_linked()) {
-          idle_threads_.erase(idle_threads_.iterator_to(me));
+          shard->idle_threads.erase(shard->idle_threads.iterator_to(me));
         }
       });
+      // A task may have been queued to another shard since this thread last
+      // looked. Its submitter only wakes up threads which are already idle,
+      // so look again now that this thread is. This shard's queue is empty,
+      // so any queued token belongs to another shard.
+      if (shards_.size() > 1 && num_queued_tokens_ > 0) {
+        continue;
+      }
       if (permanent) {
         me.not_empty.Wait();
       } else {
@@ -588,7 +749,7 @@ void ThreadPool::DispatchThread() {
           // brief period during which another thread may actually grab the internal mutex
           // protecting the state, signal, and release again before we get the mutex. So,
           // we'll recheck the empty queue case regardless.
-          if (queue_.empty()) {
+          if (shard->queue.empty()) {
             VLOG(3) << "Releasing worker thread from pool " << name_ << " after "
                     << idle_timeout_.ToMilliseconds() << "ms of idle time.";
             break;
@@ -598,114 +759,156 @@ void ThreadPool::DispatchThread() {
       continue;
     }
 
-    // Get the next token and task to execute.
-    ThreadPoolToken* token = queue_.front();
-    queue_.pop_front();
-    DCHECK_EQ(ThreadPoolToken::State::RUNNING, token->state());
-    DCHECK(!token->entries_.empty());
-    Task task = std::move(token->entries_.front());
-    token->entries_.pop_front();
-    token->active_threads_++;
-    --total_queued_tasks_;
-    ++active_threads_;
-
-    unique_lock.Unlock();
-
-    // Release the reference which was held by the queued item.
-    ADOPT_TRACE(task.trace);
-    if (task.trace) {
-      task.trace->Release();
-    }
+    RunNextTask(shard, &unique_lock);
+  }
 
-    // Update metrics
-    MonoTime now(MonoTime::Now());
-    int64_t queue_time_us = (now - task.submit_time).ToMicroseconds();
-    TRACE_COUNTER_INCREMENT(queue_time_trace_metric_name_, queue_time_us);
-    if (metrics_.queue_time_us_histogram) {
-      metrics_.queue_time_us_histogram->Increment(queue_time_us);
-    }
-    if (token->metrics_.queue_time_us_histogram) {
-      token->metrics_.queue_time_us_histogram->Increment(queue_time_us);
-    }
+  // It's important that we hold the lock between exiting the loop and dropping
+  // num_threads. Otherwise it's possible someone else could come along here
+  // and add a new task just as the last running thread is about to exit.
+  CHECK(unique_lock.OwnsLock());
+
+  g_current_pool = nullptr;
+  g_current_shard_index = -1;
+  shard->num_threads--;
+  if (shard->num_threads + shard->num_threads_pending_start == 0) {
+    shard->no_threads_cond.Broadcast();
+
+    // Sanity check: if we're the last thread exiting, the queue ought to be
+    // empty. Otherwise it will never get processed.
+    CHECK(shard->queue.empty());
+    DCHECK_EQ(0, shard->total_queued_tasks);
+  }
+}
 
-    // Execute the task
-    {
-      MicrosecondsInt64 start_wall_us = GetMonoTimeMicros();
-      MicrosecondsInt64 start_cpu_us = GetThreadCpuTimeMicros();
+void ThreadPool::RunNextTask(Shard* shard, MutexLock* l) {
+  DCHECK(l->OwnsLock());
 
-      task.func();
+  // Get the next token and task to execute.
+  ThreadPoolToken* token = shard->queue.front();
+  shard->queue.pop_front();
+  num_queued_tokens_--;
+  DCHECK_EQ(ThreadPoolToken::State::RUNNING, token->state());
+  DCHECK(!token->entries_.empty());
+  Task task = std::move(token->entries_.front());
+  token->entries_.pop_front();
+  token->active_threads_++;
+  --shard->total_queued_tasks;
+  ++shard->active_threads;
 
-      int64_t wall_us = GetMonoTimeMicros() - start_wall_us;
-      int64_t cpu_us = GetThreadCpuTimeMicros() - start_cpu_us;
+  l->Unlock();
 
-      if (metrics_.run_time_us_histogram) {
-        metrics_.run_time_us_histogram->Increment(wall_us);
-      }
-      if (token->metrics_.run_time_us_histogram) {
-        token->metrics_.run_time_us_histogram->Increment(wall_us);
-      }
-      TRACE_COUNTER_INCREMENT(run_wall_time_trace_metric_name_, wall_us);
-      TRACE_COUNTER_INCREMENT(run_cpu_time_trace_metric_name_, cpu_us);
+  // Release the reference which was held by the queued item.
+  ADOPT_TRACE(task.trace);
+  if (task.trace) {
+    task.trace->Release();
+  }
+
+  // Update metrics
+  MonoTime now(MonoTime::Now());
+  int64_t queue_time_us = (now - task.submit_time).ToMicroseconds();
+  TRACE_COUNTER_INCREMENT(queue_time_trace_metric_name_, queue_time_us);
+  if (metrics_.queue_time_us_histogram) {
+    metrics_.queue_time_us_histogram->Increment(queue_time_us);
+  }
+  if (token->metrics_.queue_time_us_histogram) {
+    token->metrics_.queue_time_us_histogram->Increment(queue_time_us);
+  }
+
+  // Execute the task
+  {
+    MicrosecondsInt64 start_wall_us = GetMonoTimeMicros();
+    MicrosecondsInt64 start_cpu_us = GetThreadCpuTimeMicros();
+
+    task.func();
+
+    int64_t wall_us = GetMonoTimeMicros() - start_wall_us;
+    int64_t cpu_us = GetThreadCpuTimeMicros() - start_cpu_us;
+
+    if (metrics_.run_time_us_histogram) {
+      metrics_.run_time_us_histogram->Increment(wall_us);
     }
-    // Destruct the task while we do not hold the lock.
-    //
-    // The task's destructor may be expensive if it has a lot of bound
-    // objects, and we don't want to block submission of the threadpool.
-    // In the worst case, the destructor might even try to do something
-    // with this threadpool, and produce a deadlock.
-    task.func = nullptr;
-    unique_lock.Lock();
-
-    // Possible states:
-    // 1. The token was shut down while we ran its task. Transition to QUIESCED.
-    // 2. The token has no more queued tasks. Transition back to IDLE.
-    // 3. The token has more tasks. Requeue it and transition back to RUNNABLE.
-    ThreadPoolToken::State state = token->state();
-    DCHECK(state == ThreadPoolToken::State::RUNNING ||
-           state == ThreadPoolToken::State::QUIESCING);
-    if (--token->active_threads_ == 0) {
-      if (state == ThreadPoolToken::State::QUIESCING) {
-        DCHECK(token->entries_.empty());
-        token->Transition(ThreadPoolToken::State::QUIESCED);
-      } else if (token->entries_.empty()) {
-        token->Transition(ThreadPoolToken::State::IDLE);
-      } else if (token->mode() == ExecutionMode::SERIAL) {
-        queue_.emplace_back(token);
-      }
+    if (token->metrics_.run_time_us_histogram) {
+      token->metrics_.run_time_us_histogram->Increment(wall_us);
     }
-    if (--active_threads_ == 0) {
-      idle_cond_.Broadcast();
+    TRACE_COUNTER_INCREMENT(run_wall_time_trace_metric_name_, wall_us);
+    TRACE_COUNTER_INCREMENT(run_cpu_time_trace_metric_name_, cpu_us);
+  }
+  // Destruct the task while we do not hold the lock.
+  //
+  // The task's destructor may be expensive if it has a lot of bound
+  // objects, and we don't want to block submission of the threadpool.
+  // In the worst case, the destructor might even try to do something
+  // with this threadpool, and produce a deadlock.
+  task.func = nullptr;
+  l->Lock();
+
+  // Possible states:
+  // 1. The token was shut down while we ran its task. Transition to QUIESCED.
+  // 2. The token has no more queued tasks. Transition back to IDLE.
+  // 3. The token has more tasks. Requeue it and transition back to RUNNABLE.
+  ThreadPoolToken::State state = token->state();
+  DCHECK(state == ThreadPoolToken::State::RUNNING ||
+         state == ThreadPoolToken::State::QUIESCING);
+  if (--token->active_threads_ == 0) {
+    if (state == ThreadPoolToken::State::QUIESCING) {
+      DCHECK(token->entries_.empty());
+      token->Transition(ThreadPoolToken::State::QUIESCED);
+    } else if (token->entries_.empty()) {
+      token->Transition(ThreadPoolToken::State::IDLE);
+    } else if (token->mode() == ExecutionMode::SERIAL) {
+      shard->queue.emplace_back(token);
+      num_queued_tokens_++;
     }
   }
+  if (--shard->active_threads == 0) {
+    shard->idle_cond.Broadcast();
+  }
+}
 
-  // It's important that we hold the lock between exiting the loop and dropping
-  // num_threads_. Otherwise it's possible someone else could come along here
-  // and add a new task just as the last running thread is about to exit.
-  CHECK(unique_lock.OwnsLock());
-
-  CHECK_EQ(threads_.erase(Thread::current_thread()), 1);
-  num_threads_--;
-  if (num_threads_ + num_threads_pending_start_ == 0) {
-    no_threads_cond_.Broadcast();
-
-    // Sanity check: if we're the last thread exiting, the queue ought to be
-    // empty. Otherwise it will never get processed.
-    CHECK(queue_.empty());
-    DCHECK_EQ(0, total_queued_tasks_);
+bool ThreadPool::StealAndRunTask(Shard* shard) {
+  // Only one shard's lock is held at a time. A SERIAL token is only queued
+  // while none of its tasks is running, so stealing it keeps its tasks
+  // serialized and in order.
+  for (size_t i = 1; i < shards_.size(); i++) {
+    Shard* victim = shards_[(shard->index + i) % shards_.size()].get();
+    MutexLock l(victim->lock);
+    if (victim->status.ok() && !victim->queue.empty()) {
+      RunNextTask(victim, &l);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WakeIdleThreadOfOtherShard(Shard* shard) {
+  for (size_t i = 1; i < shards_.size(); i++) {
+    Shard* other = shards_[(shard->index + i) % shards_.size()].get();
+    // Wait for the lock even if the shard is busy: one of its threads may be
+    // about to go idle.
+    other->lock.Acquire();
+    bool woken = false;
+    if (!other->idle_threads.empty()) {
+      other->idle_threads.front().not_empty.Signal();
+      other->idle_threads.pop_front();
+      woken = true;
+    }
+    other->lock.Release();
+    if (woken) {
+      return;
+    }
   }
 }
 
-Status ThreadPool::CreateThread() {
+Status ThreadPool::CreateThread(Shard* shard) {
   return kudu::Thread::Create("thread pool", strings::Substitute("$0 [worker]", name_),
-                              [this]() { this->DispatchThread(); }, nullptr);
+                              [this, shard]() { this->DispatchThread(shard); }, nullptr);
 }
 
 void ThreadPool::CheckNotPoolThreadUnlocked() {
-  Thread* current = Thread::current_thread();
-  if (ContainsKey(threads_, current)) {
+  if (g_current_pool == this) {
     LOG(FATAL) << Substitute("Thread belonging to thread pool '$0' with "
         "name '$1' called pool function that would result in deadlock",
-        name_, current->name());
+        name_, Thread::current_thread()->name());
   }
 }
 
@@ -16,12 +16,15 @@
 // under the License.
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <iosfwd>
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/list_hook.hpp>
@@ -38,7 +41,6 @@
 
 namespace kudu {
 
-class Thread;
 class ThreadPool;
 class ThreadPoolToken;
 class Trace;
@@ -101,6 +103,16 @@ struct ThreadPoolMetrics {
 // metrics: Histograms, counters, etc. to update on various threadpool events.
 //    Default: not set.
 //
+// num_queues: Number of queues the pool's tasks are spread over. Each queue
+//    has its own lock and its own share of the pool's threads (and of
+//    min_threads and max_queue_size), and each token is assigned to one
+//    queue. A worker thread whose queue is empty steals runnable tasks from
+//    the other queues before going idle. Using several queues reduces the
+//    contention on the pool's lock when many threads submit short tasks, at
+//    the price of a less strict FIFO order between the tasks of different
+//    tokens. Capped at max_threads.
+//    Default: 1.
+//
 class ThreadPoolBuilder {
  public:
   explicit ThreadPoolBuilder(std::string name);
@@ -113,6 +125,10 @@ class ThreadPoolBuilder {
   ThreadPoolBuilder& set_max_queue_size(int max_queue_size);
   ThreadPoolBuilder& set_idle_timeout(const MonoDelta& idle_timeout);
   ThreadPoolBuilder& set_metrics(ThreadPoolMetrics metrics);
+  ThreadPoolBuilder& set_num_queues(int num_queues);
+  // Pins the threads of the pool to NUMA node 'numa_node' (see numa_util.h),
+  // unless it is -1, the default.
+  ThreadPoolBuilder& set_numa_node(int numa_node);
 
   // Instantiate a new ThreadPool with the existing builder arguments.
   Status Build(std::unique_ptr<ThreadPool>* pool) const;
@@ -126,6 +142,8 @@ class ThreadPoolBuilder {
   int max_queue_size_;
   MonoDelta idle_timeout_;
   ThreadPoolMetrics metrics_;
+  int num_queues_;
+  int numa_node_;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadPoolBuilder);
 };
@@ -151,6 +169,10 @@ class ThreadPoolBuilder {
 // from starving one another. However, tokenless (and CONCURRENT token-based)
 // tasks can starve SERIAL token-based tasks.
 //
+// With several queues (see ThreadPoolBuilder::set_num_queues()), the FIFO
+// order only holds within each queue. Tasks of a SERIAL token are still run
+// one at a time in submission order, since they all go to the token's queue.
+//
 // Usage Example:
 //    static void Func(int n) { ... }
 //
@@ -210,10 +232,7 @@ class ThreadPool {
 
   // Return the number of threads currently running (or in the process of starting up)
   // for this thread pool.
-  int num_threads() const {
-    MutexLock l(lock_);
-    return num_threads_ + num_threads_pending_start_;
-  }
+  int num_threads() const;
 
  private:
   FRIEND_TEST(ThreadPoolTest, TestThreadPoolWithNoMinimum);
@@ -231,24 +250,145 @@ class ThreadPool {
     MonoTime submit_time;
   };
 
+  // A worker thread waiting for work.
+  struct IdleThread : public boost::intrusive::list_base_hook<> {
+    explicit IdleThread(Mutex* m)
+        : not_empty(m) {}
+
+    // Condition variable for "queue is not empty". Waiters wake up when a new
+    // task is queued.
+    ConditionVariable not_empty;
+
+    DISALLOW_COPY_AND_ASSIGN(IdleThread);
+  };
+
+  // One of the pool's queues, with its own lock, worker threads and tokens.
+  // The state and the queued tasks of a token are protected by the lock of
+  // the token's shard.
+  struct Shard {
+    Shard(int index, int min_threads, int max_threads, int max_queue_size);
+
+    const int index;
+    const int min_threads;
+    const int max_threads;
+    const int max_queue_size;
+
+    // Overall status of the shard. Set to an error when the pool is shut down.
+    //
+    // Protected by 'lock'.
+    Status status;
+
+    // Synchronizes the members of the shard, the state of its tokens, and
+    // all of its condition variables.
+    mutable Mutex lock;
+
+    // Condition variable for "shard is idling". Waiters wake up when
+    // active_threads reaches zero.
+    ConditionVariable idle_cond;
+
+    // Condition variable for "shard has no threads". Waiters wake up when
+    // num_threads and num_threads_pending_start are both 0.
+    ConditionVariable no_threads_cond;
+
+    // Number of the shard's threads currently running.
+    //
+    // Protected by 'lock'.
+    int num_threads;
+
+    // Number of the shard's threads which are in the process of starting.
+    // When these threads start, they will decrement this counter and
+    // accordingly increment 'num_threads'.
+    //
+    // Protected by 'lock'.
+    int num_threads_pending_start;
+
+    // Number of threads currently executing the shard's tasks, including the
+    // threads of other shards running stolen tasks.
+    //
+    // Protected by 'lock'.
+    int active_threads;
+
+    // Total number of client tasks queued to the shard's tokens.
+    //
+    // Protected by 'lock'.
+    int total_queued_tasks;
+
+    // All allocated tokens of the shard.
+    //
+    // Protected by 'lock'.
+    std::unordered_set<ThreadPoolToken*> tokens;
+
+    // FIFO of tokens from which tasks should be executed. Does not own the
+    // tokens; they are owned by clients and are removed from the FIFO on shutdown.
+    //
+    // Protected by 'lock'.
+    std::deque<ThreadPoolToken*> queue;
+
+    // List of the shard's threads currently waiting for work.
+    //
+    // A thread is added to the front of the list when it goes idle and is
+    // removed from the front and signaled when new work arrives. This produces a
+    // LIFO usage pattern that is more efficient than idling on a single
+    // ConditionVariable (which yields FIFO semantics).
+    //
+    // Protected by 'lock'.
+    boost::intrusive::list<IdleThread> idle_threads; // NOLINT(build/include_what_you_use)
+
+    // ExecutionMode::CONCURRENT token used for tokenless submission.
+    std::unique_ptr<ThreadPoolToken> tokenless;
+
+    DISALLOW_COPY_AND_ASSIGN(Shard);
+  };
+
   // Creates a new thread pool using a builder.
   explicit ThreadPool(const ThreadPoolBuilder& builder);
 
   // Initializes the thread pool by starting the minimum number of threads.
   Status Init();
 
-  // Dispatcher responsible for dequeueing and executing the tasks
-  void DispatchThread();
+  // Dispatcher responsible for dequeueing and executing the tasks of 'shard',
+  // or of the other shards when 'shard' has none.
+  void DispatchThread(Shard* shard);
+
+  // Dequeues and executes the next task of the first runnable token of
+  // 'shard'. 'l' must hold the shard's lock, and the shard's queue must not
+  // be empty. The lock is released while the task runs.
+  void RunNextTask(Shard* shard, MutexLock* l);
+
+  // Executes a task of another shard than 'shard', if any is runnable.
+  // Returns true if a task was executed. No shard's lock may be held.
+  bool StealAndRunTask(Shard* shard);
 
-  // Create new thread.
+  // Wakes up an idle thread of another shard than 'shard', if any, so that
+  // it steals the tasks of 'shard'. No shard's lock may be held.
   //
-  // REQUIRES: caller has incremented 'num_threads_pending_start_' ahead of this call.
-  // NOTE: For performance reasons, lock_ should not be held.
-  Status CreateThread();
+  // A thread going idle checks 'num_queued_tokens_' after it has joined its
+  // shard's idle threads, so it either sees a token queued before this call
+  // or is found idle by it.
+  void WakeIdleThreadOfOtherShard(Shard* shard);
+
+  // Create new thread for 'shard'.
+  //
+  // REQUIRES: caller has incremented 'num_threads_pending_start' of 'shard'
+  // ahead of this call.
+  // NOTE: For performance reasons, the shard's lock should not be held.
+  Status CreateThread(Shard* shard);
 
   // Aborts if the current thread is a member of this thread pool.
   void CheckNotPoolThreadUnlocked();
 
+  // Returns the next shard in round-robin order.
+  Shard* NextShard();
+
+  // Returns a shard with queued or running tasks, or nullptr if the whole pool
+  // is idle. No shard's lock may be held.
+  Shard* FindBusyShard();
+
+  // Creates a new token belonging to 'shard'.
+  std::unique_ptr<ThreadPoolToken> NewTokenInShard(ExecutionMode mode,
+                                                   ThreadPoolMetrics metrics,
+                                                   Shard* shard);
+
   // Submits a task to be run via token.
   Status DoSubmit(std::function<void()> f, ThreadPoolToken* token);
 
@@ -256,90 +396,20 @@ class ThreadPool {
   void ReleaseToken(ThreadPoolToken* t);
 
   const std::string name_;
-  const int min_threads_;
-  const int max_threads_;
-  const int max_queue_size_;
   const MonoDelta idle_timeout_;
+  // The NUMA node the threads are pinned to, or -1.
+  const int numa_node_;
 
-  // Overall status of the pool. Set to an error when the pool is shut down.
-  //
-  // Protected by 'lock_'.
-  Status pool_status_;
-
-  // Synchronizes many of the members of the pool and all of its
-  // condition variables.
-  mutable Mutex lock_;
+  std::vector<std::unique_ptr<Shard>> shards_;
 
-  // Condition variable for "pool is idling". Waiters wake up when
-  // active_threads_ reaches zero.
-  ConditionVariable idle_cond_;
+  // Index of the next shard to assign in round-robin order.
+  std::atomic<uint32_t> next_shard_;
 
-  // Condition variable for "pool has no threads". Waiters wake up when
-  // num_threads_ and num_pending_threads_ are both 0.
-  ConditionVariable no_threads_cond_;
-
-  // Number of threads currently running.
-  //
-  // Protected by lock_.
-  int num_threads_;
-
-  // Number of threads which are in the process of starting.
-  // When these threads start, they will decrement this counter and
-  // accordingly increment 'num_threads_'.
-  //
-  // Protected by lock_.
-  int num_threads_pending_start_;
-
-  // Number of threads currently running and executing client tasks.
-  //
-  // Protected by lock_.
-  int active_threads_;
-
-  // Total number of client tasks queued, either directly (queue_) or
-  // indirectly (tokens_).
-  //
-  // Protected by lock_.
-  int total_queued_tasks_;
-
-  // All allocated tokens.
-  //
-  // Protected by lock_.
-  std::unordered_set<ThreadPoolToken*> tokens_;
-
-  // FIFO of tokens from which tasks should be executed. Does not own the
-  // tokens; they are owned by clients and are removed from the FIFO on shutdown.
-  //
-  // Protected by lock_.
-  std::deque<ThreadPoolToken*> queue_;
-
-  // Pointers to all running threads. Raw pointers are safe because a Thread
-  // may only go out of scope after being removed from threads_.
-  //
-  // Protected by lock_.
-  std::unordered_set<Thread*> threads_;
-
-  // List of all threads currently waiting for work.
-  //
-  // A thread is added to the front of the list when it goes idle and is
-  // removed from the front and signaled when new work arrives. This produces a
-  // LIFO usage pattern that is more efficient than idling on a single
-  // ConditionVariable (which yields FIFO semantics).
-  //
-  // Protected by lock_.
-  struct IdleThread : public boost::intrusive::list_base_hook<> {
-    explicit IdleThread(Mutex* m)
-        : not_empty(m) {}
-
-    // Condition variable for "queue is not empty". Waiters wake up when a new
-    // task is queued.
-    ConditionVariable not_empty;
-
-    DISALLOW_COPY_AND_ASSIGN(IdleThread);
-  };
-  boost::intrusive::list<IdleThread> idle_threads_; // NOLINT(build/include_what_you_use)
-
-  // ExecutionMode::CONCURRENT token used by the pool for tokenless submission.
-  std::unique_ptr<ThreadPoolToken> tokenless_;
+  // Number of tokens in the queues of all of the shards, i.e. of runnable
+  // tokens which an idle thread could steal from. Changed under the lock of
+  // the shard whose queue changes, and read by a thread about to go idle
+  // under the lock of its own shard.
+  std::atomic<int64_t> num_queued_tokens_;
 
   // Metrics for the entire thread pool.
   const ThreadPoolMetrics metrics_;
@@ -354,8 +424,8 @@ class ThreadPool {
 // Entry point for token-based task submission and blocking for a particular
 // thread pool. Tokens can only be created via ThreadPool::NewToken().
 //
-// All functions are thread-safe. Mutable members are protected via the
-// ThreadPool's lock.
+// All functions are thread-safe. Mutable members are protected via the lock
+// of the token's shard of the ThreadPool.
 class ThreadPoolToken {
  public:
   // Destroys the token.
@@ -422,10 +492,11 @@ class ThreadPoolToken {
   // Returns a textual representation of 's' suitable for debugging.
   static const char* StateToString(State s);
 
-  // Constructs a new token.
+  // Constructs a new token belonging to 'shard' of 'pool'.
   //
   // The token may not outlive its thread pool ('pool').
   ThreadPoolToken(ThreadPool* pool,
+                  ThreadPool::Shard* shard,
                   ThreadPool::ExecutionMode mode,
                   ThreadPoolMetrics metrics);
 
@@ -457,6 +528,9 @@ class ThreadPoolToken {
   // Pointer to the token's thread pool.
   ThreadPool* pool_;
 
+  // The shard of 'pool_' the token's tasks are queued to.
+  ThreadPool::Shard* const shard_;
+
   // Token state machine.
   State state_;
 
@@ -35,6 +35,7 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/port.h"
 #include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/gutil/walltime.h"
 #include "kudu/util/atomic.h"
 #include "kudu/util/countdown_latch.h"
@@ -872,6 +873,39 @@ TEST_F(TraceTest, TestTraceMetrics) {
   EXPECT_GE(m["test_scope_us"], 80 * 1000);
 }
 
+// Test more distinct counters than fit in the lock-free slots of
+// TraceMetrics, incremented concurrently.
+TEST_F(TraceTest, TestTraceMetricsManyCountersConcurrently) {
+  const int kNumCounters = 100;
+  const int kNumThreads = 4;
+  const int kNumIncrements = 1000;
+  vector<string> names;
+  for (int i = 0; i < kNumCounters; i++) {
+    names.emplace_back(strings::Substitute("counter_$0", i));
+  }
+  scoped_refptr<Trace> trace(new Trace);
+  vector<thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kNumIncrements; i++) {
+        for (const auto& name : names) {
+          trace->metrics()->Increment(name.c_str(), 1);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto m = trace->metrics()->Get();
+  ASSERT_EQ(kNumCounters, static_cast<int>(m.size()));
+  for (const auto& name : names) {
+    ASSERT_EQ(kNumThreads * kNumIncrements, m[name.c_str()]);
+    ASSERT_EQ(kNumThreads * kNumIncrements, trace->metrics()->GetMetric(name.c_str()));
+  }
+  ASSERT_EQ(0, trace->metrics()->GetMetric("not_a_counter"));
+}
+
 // Regression test for KUDU-2075: using tracing from vanilla threads
 // should work fine, even if some pthread_self identifiers have been
 // reused.
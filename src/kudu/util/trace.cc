@@ -17,6 +17,7 @@
 
 #include "kudu/util/trace.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <iomanip>
@@ -46,8 +47,7 @@ __thread Trace* Trace::threadlocal_trace_;
 
 Trace::Trace()
     : arena_(new ThreadSafeArena(1024)),
-      entries_head_(nullptr),
-      entries_tail_(nullptr) {
+      entries_head_(nullptr) {
   // We expect small allocations from our Arena so no need to have
   // a large arena component. Small allocations are more likely to
   // come out of thread cache and be fast.
@@ -117,33 +117,27 @@ TraceEntry* Trace::NewEntry(int msg_len, const char* file_path, int line_number)
 }
 
 void Trace::AddEntry(TraceEntry* entry) {
-  std::lock_guard<simple_spinlock> l(lock_);
-  entry->next = nullptr;
-
-  if (entries_tail_ != nullptr) {
-    entries_tail_->next = entry;
-  } else {
-    DCHECK(entries_head_ == nullptr);
-    entries_head_ = entry;
+  entry->next = entries_head_.load(std::memory_order_relaxed);
+  while (!entries_head_.compare_exchange_weak(entry->next, entry,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
   }
-  entries_tail_ = entry;
 }
 
 void Trace::Dump(std::ostream* out, int flags) const {
-  // Gather a copy of the list of entries under the lock. This is fast
-  // enough that we aren't worried about stalling concurrent tracers
-  // (whereas doing the logging itself while holding the lock might be
-  // too slow, if the output stream is a file, for example).
+  // Gather a copy of the list of entries, in order of addition. Entries
+  // added concurrently are not part of the dump.
   vector<TraceEntry*> entries;
+  for (TraceEntry* cur = entries_head_.load(std::memory_order_acquire);
+       cur != nullptr;
+       cur = cur->next) {
+    entries.push_back(cur);
+  }
+  std::reverse(entries.begin(), entries.end());
+
   vector<pair<StringPiece, scoped_refptr<Trace>>> child_traces;
   {
     std::lock_guard<simple_spinlock> l(lock_);
-    for (TraceEntry* cur = entries_head_;
-         cur != nullptr;
-         cur = cur->next) {
-      entries.push_back(cur);
-    }
-
     child_traces = child_traces_;
   }
 
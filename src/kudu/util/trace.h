@@ -16,6 +16,7 @@
 // under the License.
 #pragma once
 
+#include <atomic>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -218,20 +219,20 @@ class Trace : public RefCountedThreadSafe<Trace> {
   // message of length 'len'.
   TraceEntry* NewEntry(int len, const char* file_path, int line_number);
 
-  // Add the entry to the linked list of entries.
+  // Add the entry to the linked list of entries. Lock-free.
   void AddEntry(TraceEntry* entry);
 
   void MetricsToJSON(JsonWriter* jw) const;
 
   std::unique_ptr<ThreadSafeArena> arena_;
 
-  // Lock protecting the entries linked list.
-  mutable simple_spinlock lock_;
-  // The head of the linked list of entries (allocated inside arena_)
-  TraceEntry* entries_head_;
-  // The tail of the linked list of entries (allocated inside arena_)
-  TraceEntry* entries_tail_;
+  // The head of the linked list of entries (allocated inside arena_), in
+  // reverse order of addition. Entries are pushed with a compare-and-swap so
+  // that concurrent tracers don't contend on a lock.
+  std::atomic<TraceEntry*> entries_head_;
 
+  // Lock protecting the child traces.
+  mutable simple_spinlock lock_;
   std::vector<std::pair<StringPiece, scoped_refptr<Trace>>> child_traces_;
 
   TraceMetrics metrics_;
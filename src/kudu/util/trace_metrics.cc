@@ -46,6 +46,54 @@ static InternMap* g_intern_map;
 
 } // anonymous namespace
 
+TraceMetrics::TraceMetrics() {
+  for (auto& slot : slots_) {
+    slot.name.store(nullptr, std::memory_order_relaxed);
+    slot.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+const TraceMetrics::Slot* TraceMetrics::FindSlot(const char* name) const {
+  const int first = FirstSlot(name);
+  for (int i = 0; i < kNumSlots; i++) {
+    const Slot* slot = &slots_[(first + i) & (kNumSlots - 1)];
+    const char* cur = slot->name.load(std::memory_order_acquire);
+    if (cur == name) {
+      return slot;
+    }
+    // Slots are claimed in probing order and never freed, so the counter
+    // can't be further away than the first free slot.
+    if (cur == nullptr) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+std::map<const char*, int64_t> TraceMetrics::Get() const {
+  std::map<const char*, int64_t> counters;
+  for (const auto& slot : slots_) {
+    const char* name = slot.name.load(std::memory_order_acquire);
+    if (name != nullptr) {
+      counters[name] = slot.value.load(std::memory_order_relaxed);
+    }
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  for (const auto& e : overflow_) {
+    counters[e.first] += e.second;
+  }
+  return counters;
+}
+
+int64_t TraceMetrics::GetMetric(const char* name) const {
+  const Slot* slot = FindSlot(name);
+  if (slot != nullptr) {
+    return slot->value.load(std::memory_order_relaxed);
+  }
+  std::lock_guard<simple_spinlock> l(lock_);
+  return FindWithDefault(overflow_, name, 0);
+}
+
 const char* TraceMetrics::InternName(const string& name) {
   DCHECK(std::all_of(name.begin(), name.end(), [] (char c) { return isprint(c); } ))
       << "not printable: " << name;
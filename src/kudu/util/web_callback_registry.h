@@ -17,6 +17,7 @@
 #pragma once
 
 #include <functional>
+#include <ostream>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -87,6 +88,11 @@ class WebCallbackRegistry {
 
     // The fully-rendered HTML response body.
     std::ostringstream output;
+
+    // If set, writes the response body in place of 'output'. The body is sent
+    // in chunks as it is written rather than buffered, so it is neither styled
+    // nor compressed. Meant for large responses to machines, e.g. metrics.
+    std::function<void (std::ostream* out)> body_writer;
   };
 
   // A function that handles an HTTP request where the response body will be rendered
@@ -571,13 +571,19 @@ build_bitshuffle() {
   # This library has significant optimizations when built with -mavx2. However,
   # we still need to support non-AVX2-capable hardware. So, we build it twice,
   # once with the flag and once without, and use some linker tricks to
-  # suffix the AVX2 symbols with '_avx2'. OSX doesn't have objcopy, so we only
-  # do this trick on Linux.
+  # suffix the AVX2 symbols with '_avx2'. If the compiler supports it, a third
+  # build targets AVX-512, with symbols suffixed with '_avx512'. OSX doesn't
+  # have objcopy, so we only do this trick on Linux.
   if [ -n "$OS_LINUX" ]; then
     AVX2_SUPPORT=$(echo | ${CC:-gcc} -mavx2 -dM -E - | awk '$2 == "__AVX2__" { print $3 }')
+    AVX512_SUPPORT=$(echo | ${CC:-gcc} -mavx512f -mavx512bw -dM -E - 2>/dev/null | \
+      awk '$2 == "__AVX512BW__" { print $3 }')
   fi
   if [ -n "$AVX2_SUPPORT" ]; then
     arches="default avx2"
+    if [ -n "$AVX512_SUPPORT" ]; then
+      arches="$arches avx512"
+    fi
   else
     arches="default"
   fi
@@ -586,6 +592,8 @@ build_bitshuffle() {
     arch_flag=""
     if [ "$arch" == "avx2" ]; then
       arch_flag="-mavx2"
+    elif [ "$arch" == "avx512" ]; then
+      arch_flag="-mavx512f -mavx512bw"
     fi
     tmp_obj=bitshuffle_${arch}_tmp.o
     dst_obj=bitshuffle_${arch}.o
@@ -595,8 +603,8 @@ build_bitshuffle() {
       "$BITSHUFFLE_SOURCE/src/iochain.c"
     # Merge the object files together to produce a combined .o file.
     ld -r -o $tmp_obj bitshuffle_core.o bitshuffle.o iochain.o
-    # For the AVX2 symbols, suffix them.
-    if [ "$arch" == "avx2" ]; then
+    # For the AVX2 and AVX-512 symbols, suffix them.
+    if [ "$arch" != "default" ]; then
       # Create a mapping file with '<old_sym> <suffixed_sym>' on each line.
       nm --defined-only --extern-only $tmp_obj | while read addr type sym ; do
         echo ${sym} ${sym}_${arch}